@@ -17,6 +17,7 @@
 #ifndef ADMITTANCE_CONTROLLER__ADMITTANCE_CONTROLLER_HPP_
 #define ADMITTANCE_CONTROLLER__ADMITTANCE_CONTROLLER_HPP_
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <string>
@@ -26,7 +27,9 @@
 #include "admittance_controller_parameters.hpp"
 
 #include "admittance_controller/admittance_rule.hpp"
+#include "admittance_controller/reference_interpolator.hpp"
 #include "admittance_controller/visibility_control.h"
+#include "admittance_state_exchange/admittance_state_exchange.hpp"
 #include "control_msgs/msg/admittance_controller_state.hpp"
 #include "controller_interface/chainable_controller_interface.hpp"
 #include "geometry_msgs/msg/pose_stamped.hpp"
@@ -41,8 +44,12 @@
 #include "realtime_tools/realtime_buffer.h"
 #include "realtime_tools/realtime_publisher.h"
 #include "semantic_components/force_torque_sensor.hpp"
+#include "std_srvs/srv/trigger.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
 
 #include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "update_time_statistics/cycle_budget.hpp"
+#include "update_time_statistics/update_time_statistics.hpp"
 
 namespace admittance_controller
 {
@@ -119,6 +126,9 @@ protected:
   bool has_velocity_command_interface_ = false;
   bool has_acceleration_command_interface_ = false;
   bool has_effort_command_interface_ = false;
+  // the external joint torques are read instead of the force torque sensors, see
+  // 'admittance.joint_space.enable'
+  bool joint_space_ = false;
 
   // To reduce number of variables and to make the code shorter the interfaces are ordered in types
   // as the following constants
@@ -131,6 +141,10 @@ protected:
     hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY};
   std::vector<std::reference_wrapper<double>> position_reference_;
   std::vector<std::reference_wrapper<double>> velocity_reference_;
+  // the mass, stiffness and damping references start at this index of 'reference_interfaces_', if
+  // 'admittance.gain_reference_interfaces' is set
+  bool has_gain_references_ = false;
+  size_t gain_references_index_ = 0;
 
   // Admittance rule and dependent variables;
   std::unique_ptr<admittance_controller::AdmittanceRule> admittance_;
@@ -138,6 +152,21 @@ protected:
   // force torque sensor
   std::unique_ptr<semantic_components::ForceTorqueSensor> force_torque_sensor_;
 
+  /// Additional end effector of the 'end_effectors' parameter, updated after 'admittance_'
+  struct EndEffector
+  {
+    std::string name;
+    std::unique_ptr<admittance_controller::AdmittanceRule> admittance;
+    std::unique_ptr<semantic_components::ForceTorqueSensor> force_torque_sensor;
+    geometry_msgs::msg::Wrench ft_values;
+    // reference of all joints with the admittance offset of this end effector
+    trajectory_msgs::msg::JointTrajectoryPoint reference_admittance;
+    rclcpp::Publisher<ControllerStateMsg>::SharedPtr s_publisher;
+    std::unique_ptr<realtime_tools::RealtimePublisher<ControllerStateMsg>> state_publisher;
+    std::shared_ptr<admittance_state_exchange::AdmittanceStateSlot> state_slot;
+  };
+  std::vector<EndEffector> end_effectors_;
+
   // ROS subscribers
   rclcpp::Subscription<trajectory_msgs::msg::JointTrajectoryPoint>::SharedPtr
     input_joint_command_subscriber_;
@@ -146,13 +175,13 @@ protected:
   // admittance parameters
   std::shared_ptr<admittance_controller::ParamListener> parameter_handler_;
 
-  // ROS messages
-  std::shared_ptr<trajectory_msgs::msg::JointTrajectoryPoint> joint_command_msg_;
-
-  // real-time buffer
-  realtime_tools::RealtimeBuffer<std::shared_ptr<trajectory_msgs::msg::JointTrajectoryPoint>>
-    input_joint_command_;
+  // real-time buffer of the last valid joint reference, copied by value so that the realtime loop
+  // does not share ownership of messages. Positions and velocities are empty or have 'num_joints_'
+  // values, as checked by the subscriber callback.
+  realtime_tools::RealtimeBuffer<trajectory_msgs::msg::JointTrajectoryPoint> input_joint_command_;
   std::unique_ptr<realtime_tools::RealtimePublisher<ControllerStateMsg>> state_publisher_;
+  // rate of publishing the state with the telemetry rate policy of the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> state_publish_rate_;
 
   trajectory_msgs::msg::JointTrajectoryPoint last_commanded_;
   trajectory_msgs::msg::JointTrajectoryPoint last_reference_;
@@ -167,7 +196,7 @@ protected:
 
   /**
    * @brief Read values from hardware interfaces and set corresponding fields of state_current and
-   * ft_values
+   * ft_values, and the ft_values of 'end_effectors_'
    */
   void read_state_from_hardware(
     trajectory_msgs::msg::JointTrajectoryPoint & state_current,
@@ -179,10 +208,29 @@ protected:
    */
   void read_state_reference_interfaces(trajectory_msgs::msg::JointTrajectoryPoint & state);
 
+  /// Touch the buffers and msgs used by the update, so its first cycles don't page fault
+  void prefault_rt_buffers();
+
   /**
    * @brief Write values from state_command to claimed hardware interfaces
    */
   void write_state_to_hardware(const trajectory_msgs::msg::JointTrajectoryPoint & state_command);
+
+  /// Update times published on the statistics topic, nullptr if 'update_statistics.enable' is off
+  std::unique_ptr<update_time_statistics::UpdateTimeStatistics> update_time_statistics_;
+  /// Decimates the state publishing under load, nullptr if 'cycle_budget.enable' is off
+  std::unique_ptr<update_time_statistics::CycleBudget> cycle_budget_;
+  /// Smooths the references of a preceding controller at a lower rate, nullptr if
+  /// 'reference_interpolation.mode' is none
+  std::unique_ptr<ReferenceInterpolator> reference_interpolator_;
+
+  // requests the identification of the payloads in the next update
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr payload_identification_service_;
+  std::atomic<bool> payload_identification_requested_{false};
+
+  // state shared with the other controllers of the process, if export_state is set
+  std::shared_ptr<admittance_state_exchange::AdmittanceStateSlot> admittance_state_slot_;
+  admittance_state_exchange::AdmittanceExchangeState exchange_state_;
 };
 
 }  // namespace admittance_controller
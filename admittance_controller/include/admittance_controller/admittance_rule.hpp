@@ -24,6 +24,9 @@
 #include <string>
 #include <vector>
 
+#include "admittance_controller/kinematics_cache.hpp"
+#include "admittance_controller/payload_estimator.hpp"
+#include "admittance_state_exchange/admittance_state_exchange.hpp"
 #include "control_msgs/msg/admittance_controller_state.hpp"
 #include "control_toolbox/filters.hpp"
 #include "controller_interface/controller_interface.hpp"
@@ -36,6 +39,7 @@
 #include "tf2_ros/buffer.h"
 #include "tf2_ros/transform_listener.h"
 #include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+#include "wrench_filter_chain/wrench_filter_chain.hpp"
 
 namespace admittance_controller
 {
@@ -65,6 +69,7 @@ struct AdmittanceState
   {
     admittance_velocity.setZero();
     admittance_acceleration.setZero();
+    admittance_displacement.setZero();
     damping.setZero();
     mass.setOnes();
     mass_inv.setZero();
@@ -74,12 +79,24 @@ struct AdmittanceState
     joint_pos = Eigen::VectorXd::Zero(num_joints);
     joint_vel = Eigen::VectorXd::Zero(num_joints);
     joint_acc = Eigen::VectorXd::Zero(num_joints);
+    joint_torque = Eigen::VectorXd::Zero(num_joints);
+    joint_mass_inv = Eigen::VectorXd::Zero(num_joints);
+    joint_damping = Eigen::VectorXd::Zero(num_joints);
+    joint_stiffness = Eigen::VectorXd::Zero(num_joints);
+    admittance_position.setIdentity();
+    rot_base_control.setIdentity();
+    ref_trans_base_ft.setIdentity();
   }
 
   Eigen::VectorXd current_joint_pos;
   Eigen::VectorXd joint_pos;
   Eigen::VectorXd joint_vel;
   Eigen::VectorXd joint_acc;
+  // external joint torques and the joint gains of the joint-space admittance
+  Eigen::VectorXd joint_torque;
+  Eigen::VectorXd joint_mass_inv;
+  Eigen::VectorXd joint_damping;
+  Eigen::VectorXd joint_stiffness;
   Eigen::Matrix<double, 6, 1> damping;
   Eigen::Matrix<double, 6, 1> mass;
   Eigen::Matrix<double, 6, 1> mass_inv;
@@ -88,31 +105,56 @@ struct AdmittanceState
   Eigen::Matrix<double, 6, 1> wrench_base;
   Eigen::Matrix<double, 6, 1> admittance_acceleration;
   Eigen::Matrix<double, 6, 1> admittance_velocity;
+  // offset of the sensor frame from its reference pose: translation and rotation vector
+  Eigen::Matrix<double, 6, 1> admittance_displacement;
   Eigen::Isometry3d admittance_position;
   Eigen::Matrix<double, 3, 3> rot_base_control;
   Eigen::Isometry3d ref_trans_base_ft;
   std::string ft_sensor_frame;
 };
 
+/// State of the identification of the payload, see AdmittanceRule::start_payload_identification()
+enum class PayloadIdentification
+{
+  NONE,
+  RUNNING,
+  SUCCEEDED,
+  FAILED
+};
+
 class AdmittanceRule
 {
 public:
+  /**
+   * \param[in] end_effector name of the end effector in the 'end_effectors' parameter, which
+   * overrides the chain, sensor and frames of the parameters. If empty, they are used as they are.
+   * \throws std::invalid_argument if a joint of the kinematics is not in the 'joints' parameter
+   */
   explicit AdmittanceRule(
-    const std::shared_ptr<admittance_controller::ParamListener> & parameter_handler)
+    const std::shared_ptr<admittance_controller::ParamListener> & parameter_handler,
+    const std::string & end_effector = "")
+  : end_effector_(end_effector)
   {
     parameter_handler_ = parameter_handler;
     parameters_ = parameter_handler_->get_params();
-    num_joints_ = parameters_.joints.size();
+    apply_end_effector_parameters();
+    set_kinematics_joints();
     admittance_state_ = AdmittanceState(num_joints_);
-    reset(num_joints_);
+    reset();
   }
 
-  /// Configure admittance rule memory using number of joints.
+  /// Configure admittance rule memory for the joints of the kinematics and load the plugin.
   controller_interface::return_type configure(
-    const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node, const size_t num_joint);
+    const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node);
 
   /// Reset all values back to default
-  controller_interface::return_type reset(const size_t num_joints);
+  controller_interface::return_type reset();
+
+  /// Touch the storage of the update, so its first cycles don't page fault, not realtime-safe
+  /**
+   * \returns the number of touched bytes
+   */
+  size_t prefault();
 
   /**
    * Calculate all transforms needed for admittance control using the loader kinematics plugin. If
@@ -132,10 +174,29 @@ public:
    */
   void apply_parameters_update();
 
+  /// Number of values of set_gain_references(): mass, stiffness and damping of the six axes
+  static constexpr size_t NUM_GAIN_REFERENCES = 18;
+
+  /**
+   * Override the admittance gains of the parameters, e.g., by a gain schedule of a preceding
+   * controller, realtime-safe. The gains are only recalculated if \p gain_references changed.
+   *
+   * \param[in] gain_references NUM_GAIN_REFERENCES values: the mass, stiffness and damping of x, y,
+   * z, rx, ry, and rz in the control frame. A NaN value, a mass that is not positive, or a negative
+   * stiffness or damping keeps the gain of the parameters. Without a damping reference, the damping
+   * follows from the damping ratio of the parameters and the mass and stiffness in use.
+   */
+  void set_gain_references(const double * gain_references);
+
   /**
    * Calculate 'desired joint states' based on the 'measured force', 'reference joint state', and
    * 'current_joint_state'.
    *
+   * The joint states are the states of all 'joints', the joints which are not part of the
+   * kinematics keep their reference. With 'admittance.joint_space.enable', the external joint
+   * torques in the efforts of \p current_joint_state are applied instead of \p measured_wrench,
+   * without kinematics.
+   *
    * \param[in] current_joint_state current joint state of the robot
    * \param[in] measured_wrench most recent measured wrench from force torque sensor
    * \param[in] reference_joint_state input joint state reference
@@ -151,12 +212,41 @@ public:
     trajectory_msgs::msg::JointTrajectoryPoint & desired_joint_states);
 
   /**
-   * Set fields of `state_message` from current admittance controller state.
+   * Allocate the fields of `state_message` and set its joint names and frames, not realtime-safe.
+   *
+   * \param[out] state_message message to be filled by get_controller_state()
+   */
+  void init_controller_state(control_msgs::msg::AdmittanceControllerState & state_message) const;
+
+  /**
+   * Set fields of `state_message` from current admittance controller state. The message has to be
+   * initialized by init_controller_state(), then no memory is allocated.
    *
    * \param[out] state_message message containing target position/vel/accel, wrench, and actual
    * robot state, among other things
    */
-  const control_msgs::msg::AdmittanceControllerState & get_controller_state();
+  void get_controller_state(control_msgs::msg::AdmittanceControllerState & state_message) const;
+
+  /**
+   * Set the wrench, displacement and velocity of \p exchange_state from the current admittance
+   * state, realtime-safe. The stamp is not changed.
+   */
+  void get_exchange_state(
+    admittance_state_exchange::AdmittanceExchangeState & exchange_state) const;
+
+  /**
+   * Identify the payload of the force torque sensor from the wrenches of the next \p num_samples
+   * updates, realtime-safe. Meanwhile, the measured wrench is not applied, and the end effector
+   * has to be moved by the reference through different orientations without contact. On success,
+   * the identified weight, center of gravity in the sensor frame and sensor offsets replace the
+   * gravity compensation parameters until configure() is called again.
+   */
+  void start_payload_identification(const size_t num_samples);
+
+  PayloadIdentification get_payload_identification() const { return payload_identification_; }
+
+  /// Payload of the last successful identification
+  const Payload & get_identified_payload() const { return identified_payload_; }
 
 public:
   // admittance config parameters
@@ -173,6 +263,27 @@ protected:
    */
   bool calculate_admittance_rule(AdmittanceState & admittance_state, double dt);
 
+  /**
+   * Calculates the joint-space admittance rule, tau = M*q_ddot + D*q_dot + K*q for each joint,
+   * from the external joint torques in the efforts of \p current_joint_state. The joint offsets
+   * of \p admittance_state are integrated without any kinematics.
+   */
+  void calculate_joint_space_admittance_rule(
+    const trajectory_msgs::msg::JointTrajectoryPoint & current_joint_state,
+    AdmittanceState & admittance_state, double dt);
+
+  /// Sets \p desired_joint_state to \p reference_joint_state with the joint offsets added
+  void apply_joint_offsets(
+    const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state,
+    trajectory_msgs::msg::JointTrajectoryPoint & desired_joint_state) const;
+
+  /**
+   * Updates `stiffness_base_` and `damping_base_`, the stiffness and damping matrices in the base
+   * frame, if the stiffness, damping or rotation of the control frame in `admittance_state`
+   * changed since they were calculated last.
+   */
+  void update_base_stiffness_and_damping(const AdmittanceState & admittance_state);
+
   /**
    * Updates internal estimate of wrench in world frame `wrench_world_` given the new measurement
    * `measured_wrench`, the sensor to base frame rotation `sensor_world_rot`, and the center of
@@ -186,16 +297,57 @@ protected:
     const Eigen::Matrix<double, 3, 3> & sensor_world_rot,
     const Eigen::Matrix<double, 3, 3> & cog_world_rot);
 
+  /**
+   * Configures `wrench_filter_chain_` from the parameters. On failure, an error is logged and the
+   * previous configuration is kept.
+   */
+  bool configure_wrench_filter_chain();
+
+  /// Sets the mass, stiffness and damping of 'admittance_state_' from the parameters and the
+  /// gain references
+  void update_gains();
+
+  /// Overrides the chain, sensor and frames of 'parameters_' with those of 'end_effector_'
+  void apply_end_effector_parameters();
+
+  /// Sets the joints of the kinematics from the parameters, see kinematics.joints, or all
+  /// 'joints' in joint space
+  void set_kinematics_joints();
+
+  /**
+   * Returns the joint positions of the kinematics in \p joint_state, copied to
+   * \p kinematics_joint_state if the kinematics only uses a subset of the joints.
+   */
+  const trajectory_msgs::msg::JointTrajectoryPoint & get_kinematics_joint_state(
+    const trajectory_msgs::msg::JointTrajectoryPoint & joint_state,
+    trajectory_msgs::msg::JointTrajectoryPoint & kinematics_joint_state) const;
+
   template <typename T1, typename T2>
   void vec_to_eigen(const std::vector<T1> & data, T2 & matrix);
 
-  // number of robot joint
+  // name of the end effector in 'end_effectors', empty if the parameters are used as they are
+  std::string end_effector_;
+
+  // number of joints of the kinematics
   size_t num_joints_;
+  // names of the joints of the kinematics and their indices in 'joints'
+  std::vector<std::string> joint_names_;
+  std::vector<size_t> joint_indices_;
+  // true if the kinematics uses all 'joints' in their order
+  bool uses_all_joints_ = true;
+  // joint positions of the kinematics if it only uses a subset of the joints
+  trajectory_msgs::msg::JointTrajectoryPoint kinematics_current_joint_state_;
+  trajectory_msgs::msg::JointTrajectoryPoint kinematics_reference_joint_state_;
 
   // Kinematics interface plugin loader
   std::shared_ptr<pluginlib::ClassLoader<kinematics_interface::KinematicsInterface>>
     kinematics_loader_;
   std::unique_ptr<kinematics_interface::KinematicsInterface> kinematics_;
+  // results of 'kinematics_' within one update
+  KinematicsCache kinematics_cache_;
+
+  // filters applied to the measured wrench in sensor frame
+  wrench_filter_chain::WrenchFilterChain wrench_filter_chain_;
 
   // filtered wrench in world frame
   Eigen::Matrix<double, 6, 1> wrench_world_;
@@ -206,14 +358,29 @@ protected:
   // transforms needed for admittance update
   AdmittanceTransforms admittance_transforms_;
 
+  // stiffness and damping matrices in base frame, calculated from the cached values below
+  Eigen::Matrix<double, 6, 6> stiffness_base_;
+  Eigen::Matrix<double, 6, 6> damping_base_;
+  Eigen::Matrix<double, 3, 3> cached_rot_base_control_;
+  Eigen::Matrix<double, 6, 1> cached_stiffness_;
+  Eigen::Matrix<double, 6, 1> cached_damping_;
+  bool base_stiffness_and_damping_valid_ = false;
+
+  // gains overriding those of the parameters, see set_gain_references()
+  Eigen::Matrix<double, NUM_GAIN_REFERENCES, 1> gain_references_;
+
   // position of center of gravity in cog_frame
   Eigen::Vector3d cog_pos_;
 
+  // identification of the payload, which is used for gravity compensation once identified
+  PayloadEstimator payload_estimator_;
+  PayloadIdentification payload_identification_ = PayloadIdentification::NONE;
+  size_t remaining_payload_samples_ = 0;
+  bool has_identified_payload_ = false;
+  Payload identified_payload_;
+
   // force applied to sensor due to weight of end effector
   Eigen::Vector3d end_effector_weight_;
-
-  // ROS
-  control_msgs::msg::AdmittanceControllerState state_message_;
 };
 
 }  // namespace admittance_controller
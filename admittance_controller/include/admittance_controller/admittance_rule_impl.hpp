@@ -19,9 +19,16 @@
 
 #include "admittance_controller/admittance_rule.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "controller_tracetools/tracetools.hpp"
 #include "rclcpp/duration.hpp"
 #include "rclcpp/utilities.hpp"
 #include "tf2_ros/transform_listener.h"
@@ -30,15 +37,46 @@ namespace admittance_controller
 {
 
 constexpr auto NUM_CARTESIAN_DOF = 6;  // (3 translation + 3 rotation)
+// links and joint positions solved in one update, see get_all_transforms()
+constexpr size_t KINEMATICS_CACHE_CAPACITY = 16;
 
-/// Configure admittance rule memory for num joints and load kinematics interface
+/// Configure admittance rule memory for the joints of the kinematics and load kinematics interface
 controller_interface::return_type AdmittanceRule::configure(
-  const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node, const size_t num_joints)
+  const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node)
 {
-  num_joints_ = num_joints;
+  // names the handle of the tracepoints of the updates
+  CONTROLLER_TRACEPOINT(controller_init, this, node->get_name());
 
   // initialize memory and values to zero  (non-realtime function)
-  reset(num_joints);
+  has_identified_payload_ = false;
+  payload_identification_ = PayloadIdentification::NONE;
+  remaining_payload_samples_ = 0;
+  reset();
+  kinematics_current_joint_state_.positions.assign(num_joints_, 0.0);
+  kinematics_reference_joint_state_.positions.assign(num_joints_, 0.0);
+
+  if (!configure_wrench_filter_chain())
+  {
+    return controller_interface::return_type::ERROR;
+  }
+
+  // the joint-space admittance doesn't need any kinematics
+  const auto & joint_space = parameters_.admittance.joint_space;
+  if (joint_space.enable)
+  {
+    if (
+      joint_space.mass.size() != num_joints_ || joint_space.damping.size() != num_joints_ ||
+      joint_space.stiffness.size() != num_joints_)
+    {
+      RCLCPP_ERROR(
+        rclcpp::get_logger("AdmittanceRule"),
+        "'admittance.joint_space.mass', 'damping' and 'stiffness' need a value for each of the "
+        "%zu joints.",
+        num_joints_);
+      return controller_interface::return_type::ERROR;
+    }
+    return controller_interface::return_type::OK;
+  }
 
   // Load the differential IK plugin
   if (!parameters_.kinematics.plugin_name.empty())
@@ -55,6 +93,16 @@ controller_interface::return_type AdmittanceRule::configure(
       {
         return controller_interface::return_type::ERROR;
       }
+      JacobianInverseOptions inverse_options;
+      inverse_options.damped_least_squares =
+        parameters_.kinematics.solver == "damped_least_squares";
+      inverse_options.alpha = parameters_.kinematics.alpha;
+      inverse_options.manipulability_threshold =
+        parameters_.kinematics.singularity.manipulability_threshold;
+      inverse_options.max_damping = parameters_.kinematics.singularity.max_damping;
+      kinematics_cache_.reset(
+        kinematics_.get(), num_joints_, KINEMATICS_CACHE_CAPACITY,
+        static_cast<size_t>(parameters_.kinematics.refresh_cycles), inverse_options);
     }
     catch (pluginlib::PluginlibException & ex)
     {
@@ -75,36 +123,20 @@ controller_interface::return_type AdmittanceRule::configure(
   return controller_interface::return_type::OK;
 }
 
-controller_interface::return_type AdmittanceRule::reset(const size_t num_joints)
+controller_interface::return_type AdmittanceRule::reset()
 {
-  // reset state message fields
-  state_message_.joint_state.name.assign(num_joints, "");
-  state_message_.joint_state.position.assign(num_joints, 0);
-  state_message_.joint_state.velocity.assign(num_joints, 0);
-  state_message_.joint_state.effort.assign(num_joints, 0);
-  for (size_t i = 0; i < parameters_.joints.size(); ++i)
-  {
-    state_message_.joint_state.name = parameters_.joints;
-  }
-  state_message_.mass.data.resize(NUM_CARTESIAN_DOF, 0.0);
-  state_message_.selected_axes.data.resize(NUM_CARTESIAN_DOF, 0);
-  state_message_.damping.data.resize(NUM_CARTESIAN_DOF, 0);
-  state_message_.stiffness.data.resize(NUM_CARTESIAN_DOF, 0);
-  state_message_.wrench_base.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_velocity.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_acceleration.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_position.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_position.child_frame_id = "admittance_offset";
-
   // reset admittance state
-  admittance_state_ = AdmittanceState(num_joints);
+  admittance_state_ = AdmittanceState(num_joints_);
 
   // reset transforms and rotations
   admittance_transforms_ = AdmittanceTransforms();
+  base_stiffness_and_damping_valid_ = false;
 
   // reset forces
+  wrench_filter_chain_.reset();
   wrench_world_.setZero();
   end_effector_weight_.setZero();
+  gain_references_.setConstant(std::numeric_limits<double>::quiet_NaN());
 
   // load/initialize Eigen types from parameters
   apply_parameters_update();
@@ -112,48 +144,199 @@ controller_interface::return_type AdmittanceRule::reset(const size_t num_joints)
   return controller_interface::return_type::OK;
 }
 
+size_t AdmittanceRule::prefault()
+{
+  size_t bytes = memory_prefault::prefault(joint_indices_) + kinematics_cache_.prefault() +
+                 prefault_eigen(admittance_state_.current_joint_pos) +
+                 prefault_eigen(admittance_state_.joint_pos) +
+                 prefault_eigen(admittance_state_.joint_vel) +
+                 prefault_eigen(admittance_state_.joint_acc) +
+                 prefault_eigen(admittance_state_.joint_torque) +
+                 prefault_eigen(admittance_state_.joint_mass_inv) +
+                 prefault_eigen(admittance_state_.joint_damping) +
+                 prefault_eigen(admittance_state_.joint_stiffness);
+  for (auto * joint_state : {&kinematics_current_joint_state_, &kinematics_reference_joint_state_})
+  {
+    bytes += memory_prefault::prefault(
+      joint_state->positions, joint_state->velocities, joint_state->accelerations,
+      joint_state->effort);
+  }
+  return bytes;
+}
+
 void AdmittanceRule::apply_parameters_update()
 {
   if (parameter_handler_->is_old(parameters_))
   {
     parameters_ = parameter_handler_->get_params();
+    apply_end_effector_parameters();
+    configure_wrench_filter_chain();
+  }
+  // update param values, the identified payload is in the sensor frame
+  if (has_identified_payload_)
+  {
+    end_effector_weight_[2] = -identified_payload_.weight;
+    cog_pos_ = identified_payload_.cog;
+  }
+  else
+  {
+    end_effector_weight_[2] = -parameters_.gravity_compensation.CoG.force;
+    vec_to_eigen(parameters_.gravity_compensation.CoG.pos, cog_pos_);
   }
-  // update param values
-  end_effector_weight_[2] = -parameters_.gravity_compensation.CoG.force;
-  vec_to_eigen(parameters_.gravity_compensation.CoG.pos, cog_pos_);
-  vec_to_eigen(parameters_.admittance.mass, admittance_state_.mass);
-  vec_to_eigen(parameters_.admittance.stiffness, admittance_state_.stiffness);
   vec_to_eigen(parameters_.admittance.selected_axes, admittance_state_.selected_axes);
+  update_gains();
+}
 
+void AdmittanceRule::set_gain_references(const double * gain_references)
+{
+  bool changed = false;
+  for (size_t i = 0; i < NUM_GAIN_REFERENCES; ++i)
+  {
+    const double reference = gain_references[i];
+    // NaN != NaN, so unset references are compared by their NaN-ness
+    if (
+      reference != gain_references_[i] &&
+      !(std::isnan(reference) && std::isnan(gain_references_[i])))
+    {
+      gain_references_[i] = reference;
+      changed = true;
+    }
+  }
+  if (changed)
+  {
+    update_gains();
+  }
+}
+
+void AdmittanceRule::update_gains()
+{
+  const auto & admittance = parameters_.admittance;
   for (size_t i = 0; i < NUM_CARTESIAN_DOF; ++i)
   {
-    admittance_state_.mass_inv[i] = 1.0 / parameters_.admittance.mass[i];
-    admittance_state_.damping[i] = parameters_.admittance.damping_ratio[i] * 2 *
-                                   sqrt(admittance_state_.mass[i] * admittance_state_.stiffness[i]);
+    const double mass_reference = gain_references_[i];
+    const double stiffness_reference = gain_references_[NUM_CARTESIAN_DOF + i];
+    const double damping_reference = gain_references_[2 * NUM_CARTESIAN_DOF + i];
+    // comparisons with NaN are false, so NaN references keep the parameters
+    admittance_state_.mass[i] = mass_reference > 0.0 ? mass_reference : admittance.mass[i];
+    admittance_state_.stiffness[i] =
+      stiffness_reference >= 0.0 ? stiffness_reference : admittance.stiffness[i];
+    admittance_state_.mass_inv[i] = 1.0 / admittance_state_.mass[i];
+    admittance_state_.damping[i] =
+      damping_reference >= 0.0
+        ? damping_reference
+        : admittance.damping_ratio[i] * 2 *
+            std::sqrt(admittance_state_.mass[i] * admittance_state_.stiffness[i]);
+  }
+
+  // the joint gains are kept if updated parameters don't have a value for each joint
+  const auto & joint_space = admittance.joint_space;
+  if (
+    joint_space.mass.size() == num_joints_ && joint_space.damping.size() == num_joints_ &&
+    joint_space.stiffness.size() == num_joints_)
+  {
+    for (size_t i = 0; i < num_joints_; ++i)
+    {
+      admittance_state_.joint_mass_inv[i] = 1.0 / joint_space.mass[i];
+      admittance_state_.joint_damping[i] = joint_space.damping[i];
+      admittance_state_.joint_stiffness[i] = joint_space.stiffness[i];
+    }
+  }
+}
+
+void AdmittanceRule::apply_end_effector_parameters()
+{
+  if (end_effector_.empty())
+  {
+    return;
+  }
+  const auto & end_effector = parameters_.end_effector.end_effectors_map.at(end_effector_);
+  parameters_.kinematics.joints = end_effector.joints;
+  parameters_.kinematics.tip = end_effector.kinematics_tip;
+  parameters_.ft_sensor.name = end_effector.ft_sensor_name;
+  parameters_.ft_sensor.frame.id = end_effector.ft_sensor_frame_id;
+  parameters_.control.frame.id = end_effector.control_frame_id;
+  parameters_.gravity_compensation.frame.id = end_effector.gravity_compensation_frame_id;
+}
+
+void AdmittanceRule::set_kinematics_joints()
+{
+  joint_names_ = parameters_.kinematics.joints.empty() || parameters_.admittance.joint_space.enable
+                   ? parameters_.joints
+                   : parameters_.kinematics.joints;
+  num_joints_ = joint_names_.size();
+  joint_indices_.clear();
+  uses_all_joints_ = num_joints_ == parameters_.joints.size();
+  for (size_t i = 0; i < num_joints_; ++i)
+  {
+    const auto it =
+      std::find(parameters_.joints.begin(), parameters_.joints.end(), joint_names_[i]);
+    if (it == parameters_.joints.end())
+    {
+      throw std::invalid_argument(
+        "Joint '" + joint_names_[i] + "' of the kinematics is not in the 'joints' parameter.");
+    }
+    joint_indices_.push_back(static_cast<size_t>(std::distance(parameters_.joints.begin(), it)));
+    uses_all_joints_ &= joint_indices_.back() == i;
   }
 }
 
+const trajectory_msgs::msg::JointTrajectoryPoint & AdmittanceRule::get_kinematics_joint_state(
+  const trajectory_msgs::msg::JointTrajectoryPoint & joint_state,
+  trajectory_msgs::msg::JointTrajectoryPoint & kinematics_joint_state) const
+{
+  if (uses_all_joints_)
+  {
+    return joint_state;
+  }
+  for (size_t i = 0; i < num_joints_; ++i)
+  {
+    kinematics_joint_state.positions[i] = joint_state.positions[joint_indices_[i]];
+  }
+  return kinematics_joint_state;
+}
+
+bool AdmittanceRule::configure_wrench_filter_chain()
+{
+  const auto & filter_chain = parameters_.ft_sensor.filter_chain;
+  std::string error;
+  if (!wrench_filter_chain_.configure(
+        filter_chain.types, filter_chain.frequencies, filter_chain.notch_quality_factor,
+        static_cast<size_t>(filter_chain.median_window_size), filter_chain.sampling_frequency,
+        error))
+  {
+    RCLCPP_ERROR(
+      rclcpp::get_logger("AdmittanceRule"), "Invalid 'ft_sensor.filter_chain' parameters: %s",
+      error.c_str());
+    return false;
+  }
+  return true;
+}
+
 bool AdmittanceRule::get_all_transforms(
   const trajectory_msgs::msg::JointTrajectoryPoint & current_joint_state,
   const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state)
 {
   // get reference transforms
-  bool success = kinematics_->calculate_link_transform(
+  bool success = kinematics_cache_.calculate_link_transform(
     reference_joint_state.positions, parameters_.ft_sensor.frame.id,
     admittance_transforms_.ref_base_ft_);
 
   // get transforms at current configuration
-  success &= kinematics_->calculate_link_transform(
+  success &= kinematics_cache_.calculate_link_transform(
     current_joint_state.positions, parameters_.ft_sensor.frame.id, admittance_transforms_.base_ft_);
-  success &= kinematics_->calculate_link_transform(
+  success &= kinematics_cache_.calculate_link_transform(
     current_joint_state.positions, parameters_.kinematics.tip, admittance_transforms_.base_tip_);
-  success &= kinematics_->calculate_link_transform(
+  success &= kinematics_cache_.calculate_link_transform(
     current_joint_state.positions, parameters_.fixed_world_frame.frame.id,
     admittance_transforms_.world_base_);
-  success &= kinematics_->calculate_link_transform(
-    current_joint_state.positions, parameters_.gravity_compensation.frame.id,
-    admittance_transforms_.base_cog_);
-  success &= kinematics_->calculate_link_transform(
+  // the center of gravity of an identified payload is in the sensor frame
+  if (!has_identified_payload_)
+  {
+    success &= kinematics_cache_.calculate_link_transform(
+      current_joint_state.positions, parameters_.gravity_compensation.frame.id,
+      admittance_transforms_.base_cog_);
+  }
+  success &= kinematics_cache_.calculate_link_transform(
     current_joint_state.positions, parameters_.control.frame.id,
     admittance_transforms_.base_control_);
 
@@ -174,13 +357,35 @@ controller_interface::return_type AdmittanceRule::update(
     apply_parameters_update();
   }
 
-  bool success = get_all_transforms(current_joint_state, reference_joint_state);
+  if (parameters_.admittance.joint_space.enable)
+  {
+    CONTROLLER_TRACEPOINT(stage_begin, this, "solve");
+    calculate_joint_space_admittance_rule(current_joint_state, admittance_state_, dt);
+    CONTROLLER_TRACEPOINT(stage_end, this, "solve");
+    apply_joint_offsets(reference_joint_state, desired_joint_state);
+    return controller_interface::return_type::OK;
+  }
+
+  // the joint positions change in every update
+  kinematics_cache_.start_cycle();
+  const auto & kinematics_current_joint_state =
+    get_kinematics_joint_state(current_joint_state, kinematics_current_joint_state_);
+  const auto & kinematics_reference_joint_state =
+    get_kinematics_joint_state(reference_joint_state, kinematics_reference_joint_state_);
+  CONTROLLER_TRACEPOINT(stage_begin, this, "forward_kinematics");
+  bool success =
+    get_all_transforms(kinematics_current_joint_state, kinematics_reference_joint_state);
+  CONTROLLER_TRACEPOINT(stage_end, this, "forward_kinematics");
 
   // apply filter and update wrench_world_ vector
   Eigen::Matrix<double, 3, 3> rot_world_sensor =
     admittance_transforms_.world_base_.rotation() * admittance_transforms_.base_ft_.rotation();
   Eigen::Matrix<double, 3, 3> rot_world_cog =
-    admittance_transforms_.world_base_.rotation() * admittance_transforms_.base_cog_.rotation();
+    has_identified_payload_
+      ? rot_world_sensor
+      : Eigen::Matrix<double, 3, 3>(
+          admittance_transforms_.world_base_.rotation() *
+          admittance_transforms_.base_cog_.rotation());
   process_wrench_measurements(measured_wrench, rot_world_sensor, rot_world_cog);
 
   // transform wrench_world_ into base frame
@@ -190,11 +395,13 @@ controller_interface::return_type AdmittanceRule::update(
     admittance_transforms_.world_base_.rotation().transpose() * wrench_world_.block<3, 1>(3, 0);
 
   // Compute admittance control law
-  vec_to_eigen(current_joint_state.positions, admittance_state_.current_joint_pos);
+  vec_to_eigen(kinematics_current_joint_state.positions, admittance_state_.current_joint_pos);
   admittance_state_.rot_base_control = admittance_transforms_.base_control_.rotation();
   admittance_state_.ref_trans_base_ft = admittance_transforms_.ref_base_ft_;
   admittance_state_.ft_sensor_frame = parameters_.ft_sensor.frame.id;
+  CONTROLLER_TRACEPOINT(stage_begin, this, "solve");
   success &= calculate_admittance_rule(admittance_state_, dt);
+  CONTROLLER_TRACEPOINT(stage_end, this, "solve");
 
   // if a failure occurred during any kinematics interface calls, return an error and don't
   // modify the desired reference
@@ -204,53 +411,62 @@ controller_interface::return_type AdmittanceRule::update(
     return controller_interface::return_type::ERROR;
   }
 
-  // update joint desired joint state
+  apply_joint_offsets(reference_joint_state, desired_joint_state);
+  return controller_interface::return_type::OK;
+}
+
+void AdmittanceRule::apply_joint_offsets(
+  const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state,
+  trajectory_msgs::msg::JointTrajectoryPoint & desired_joint_state) const
+{
+  // update joint desired joint state, the other joints keep their reference
+  if (!uses_all_joints_)
+  {
+    desired_joint_state = reference_joint_state;
+  }
+  for (size_t i = 0; i < num_joints_; ++i)
+  {
+    const auto j = joint_indices_[i];
+    desired_joint_state.positions[j] =
+      reference_joint_state.positions[j] + admittance_state_.joint_pos[i];
+    desired_joint_state.velocities[j] =
+      reference_joint_state.velocities[j] + admittance_state_.joint_vel[i];
+    desired_joint_state.accelerations[j] =
+      reference_joint_state.accelerations[j] + admittance_state_.joint_acc[i];
+  }
+}
+
+void AdmittanceRule::calculate_joint_space_admittance_rule(
+  const trajectory_msgs::msg::JointTrajectoryPoint & current_joint_state,
+  AdmittanceState & admittance_state, double dt)
+{
   for (size_t i = 0; i < num_joints_; ++i)
   {
-    desired_joint_state.positions[i] =
-      reference_joint_state.positions[i] + admittance_state_.joint_pos[i];
-    desired_joint_state.velocities[i] =
-      reference_joint_state.velocities[i] + admittance_state_.joint_vel[i];
-    desired_joint_state.accelerations[i] =
-      reference_joint_state.accelerations[i] + admittance_state_.joint_acc[i];
+    admittance_state.joint_torque[i] = current_joint_state.effort[joint_indices_[i]];
   }
 
-  return controller_interface::return_type::OK;
+  // Compute admittance control law of each joint: tau = M*q_ddot + D*q_dot + K*q, the
+  // coefficient-wise expressions are evaluated in one vectorized pass without temporaries
+  admittance_state.joint_acc = admittance_state.joint_mass_inv.cwiseProduct(
+    admittance_state.joint_torque -
+    admittance_state.joint_damping.cwiseProduct(admittance_state.joint_vel) -
+    admittance_state.joint_stiffness.cwiseProduct(admittance_state.joint_pos));
+
+  // integrate motion in joint space
+  admittance_state.joint_vel += admittance_state.joint_acc * dt;
+  admittance_state.joint_pos += admittance_state.joint_vel * dt;
 }
 
 bool AdmittanceRule::calculate_admittance_rule(AdmittanceState & admittance_state, double dt)
 {
-  // Create stiffness matrix in base frame. The user-provided values of admittance_state.stiffness
-  // correspond to the six diagonal elements of the stiffness matrix expressed in the control frame
-  auto rot_base_control = admittance_state.rot_base_control;
-  Eigen::Matrix<double, 6, 6> K = Eigen::Matrix<double, 6, 6>::Zero();
-  Eigen::Matrix<double, 3, 3> K_pos = Eigen::Matrix<double, 3, 3>::Zero();
-  Eigen::Matrix<double, 3, 3> K_rot = Eigen::Matrix<double, 3, 3>::Zero();
-  K_pos.diagonal() = admittance_state.stiffness.block<3, 1>(0, 0);
-  K_rot.diagonal() = admittance_state.stiffness.block<3, 1>(3, 0);
-  // Transform to the control frame
-  // A reference is here:  https://users.wpi.edu/~jfu2/rbe502/files/force_control.pdf
-  // Force Control by Luigi Villani and Joris De Schutter
-  // Page 200
-  K_pos = rot_base_control * K_pos * rot_base_control.transpose();
-  K_rot = rot_base_control * K_rot * rot_base_control.transpose();
-  K.block<3, 3>(0, 0) = K_pos;
-  K.block<3, 3>(3, 3) = K_rot;
-
-  // The same for damping
-  Eigen::Matrix<double, 6, 6> D = Eigen::Matrix<double, 6, 6>::Zero();
-  Eigen::Matrix<double, 3, 3> D_pos = Eigen::Matrix<double, 3, 3>::Zero();
-  Eigen::Matrix<double, 3, 3> D_rot = Eigen::Matrix<double, 3, 3>::Zero();
-  D_pos.diagonal() = admittance_state.damping.block<3, 1>(0, 0);
-  D_rot.diagonal() = admittance_state.damping.block<3, 1>(3, 0);
-  D_pos = rot_base_control * D_pos * rot_base_control.transpose();
-  D_rot = rot_base_control * D_rot * rot_base_control.transpose();
-  D.block<3, 3>(0, 0) = D_pos;
-  D.block<3, 3>(3, 3) = D_rot;
+  const auto & rot_base_control = admittance_state.rot_base_control;
+  update_base_stiffness_and_damping(admittance_state);
+  const auto & K = stiffness_base_;
+  const auto & D = damping_base_;
 
   // calculate admittance relative offset in base frame
   Eigen::Isometry3d desired_trans_base_ft;
-  kinematics_->calculate_link_transform(
+  kinematics_cache_.calculate_link_transform(
     admittance_state.current_joint_pos, admittance_state.ft_sensor_frame, desired_trans_base_ft);
   Eigen::Matrix<double, 6, 1> X;
   X.block<3, 1>(0, 0) =
@@ -260,6 +476,7 @@ bool AdmittanceRule::calculate_admittance_rule(AdmittanceState & admittance_stat
   auto R = R_desired * R_ref.transpose();
   auto angle_axis = Eigen::AngleAxisd(R);
   X.block<3, 1>(3, 0) = angle_axis.angle() * angle_axis.axis();
+  admittance_state.admittance_displacement = X;
 
   // get admittance relative velocity
   auto X_dot = Eigen::Matrix<double, 6, 1>(admittance_state.admittance_velocity.data());
@@ -278,37 +495,74 @@ bool AdmittanceRule::calculate_admittance_rule(AdmittanceState & admittance_stat
   // Compute admittance control law in the base frame: F = M*x_ddot + D*x_dot + K*x
   Eigen::Matrix<double, 6, 1> X_ddot =
     admittance_state.mass_inv.cwiseProduct(F_base - D * X_dot - K * X);
-  bool success = kinematics_->convert_cartesian_deltas_to_joint_deltas(
+  bool success = kinematics_cache_.convert_cartesian_deltas_to_joint_deltas(
     admittance_state.current_joint_pos, X_ddot, admittance_state.ft_sensor_frame,
     admittance_state.joint_acc);
 
   // add damping if cartesian velocity falls below threshold
-  for (int64_t i = 0; i < admittance_state.joint_acc.size(); ++i)
-  {
-    admittance_state.joint_acc[i] -=
-      parameters_.admittance.joint_damping * admittance_state.joint_vel[i];
-  }
+  admittance_state.joint_acc -= parameters_.admittance.joint_damping * admittance_state.joint_vel;
 
   // integrate motion in joint space
   admittance_state.joint_vel += (admittance_state.joint_acc) * dt;
   admittance_state.joint_pos += admittance_state.joint_vel * dt;
 
   // calculate admittance velocity corresponding to joint velocity ("base_link" frame)
-  success &= kinematics_->convert_joint_deltas_to_cartesian_deltas(
+  success &= kinematics_cache_.convert_joint_deltas_to_cartesian_deltas(
     admittance_state.current_joint_pos, admittance_state.joint_vel,
     admittance_state.ft_sensor_frame, admittance_state.admittance_velocity);
-  success &= kinematics_->convert_joint_deltas_to_cartesian_deltas(
+  success &= kinematics_cache_.convert_joint_deltas_to_cartesian_deltas(
     admittance_state.current_joint_pos, admittance_state.joint_acc,
     admittance_state.ft_sensor_frame, admittance_state.admittance_acceleration);
 
   return success;
 }
 
+void AdmittanceRule::update_base_stiffness_and_damping(const AdmittanceState & admittance_state)
+{
+  // the control frame usually only moves with the robot, so the matrices are cached
+  if (
+    base_stiffness_and_damping_valid_ &&
+    cached_rot_base_control_ == admittance_state.rot_base_control &&
+    cached_stiffness_ == admittance_state.stiffness && cached_damping_ == admittance_state.damping)
+  {
+    return;
+  }
+  const auto & rot_base_control = admittance_state.rot_base_control;
+
+  // Create stiffness matrix in base frame. The user-provided values of admittance_state.stiffness
+  // correspond to the six diagonal elements of the stiffness matrix expressed in the control frame
+  // A reference is here:  https://users.wpi.edu/~jfu2/rbe502/files/force_control.pdf
+  // Force Control by Luigi Villani and Joris De Schutter
+  // Page 200
+  stiffness_base_.setZero();
+  stiffness_base_.block<3, 3>(0, 0) = rot_base_control *
+                                      admittance_state.stiffness.head<3>().asDiagonal() *
+                                      rot_base_control.transpose();
+  stiffness_base_.block<3, 3>(3, 3) = rot_base_control *
+                                      admittance_state.stiffness.tail<3>().asDiagonal() *
+                                      rot_base_control.transpose();
+
+  // The same for damping
+  damping_base_.setZero();
+  damping_base_.block<3, 3>(0, 0) = rot_base_control *
+                                    admittance_state.damping.head<3>().asDiagonal() *
+                                    rot_base_control.transpose();
+  damping_base_.block<3, 3>(3, 3) = rot_base_control *
+                                    admittance_state.damping.tail<3>().asDiagonal() *
+                                    rot_base_control.transpose();
+
+  cached_rot_base_control_ = rot_base_control;
+  cached_stiffness_ = admittance_state.stiffness;
+  cached_damping_ = admittance_state.damping;
+  base_stiffness_and_damping_valid_ = true;
+}
+
 void AdmittanceRule::process_wrench_measurements(
   const geometry_msgs::msg::Wrench & measured_wrench,
   const Eigen::Matrix<double, 3, 3> & sensor_world_rot,
   const Eigen::Matrix<double, 3, 3> & cog_world_rot)
 {
+  // [force, torque] in sensor frame, as given to the filter chain
   Eigen::Matrix<double, 3, 2, Eigen::ColMajor> new_wrench;
   new_wrench(0, 0) = measured_wrench.force.x;
   new_wrench(1, 0) = measured_wrench.force.y;
@@ -316,6 +570,41 @@ void AdmittanceRule::process_wrench_measurements(
   new_wrench(0, 1) = measured_wrench.torque.x;
   new_wrench(1, 1) = measured_wrench.torque.y;
   new_wrench(2, 1) = measured_wrench.torque.z;
+  if (wrench_filter_chain_.size() > 0)
+  {
+    Eigen::Map<wrench_filter_chain::WrenchFilterChain::Vector6d> wrench(new_wrench.data());
+    wrench_filter_chain::WrenchFilterChain::Vector6d filtered_wrench = wrench;
+    wrench_filter_chain_.update(filtered_wrench);
+    wrench = filtered_wrench;
+  }
+
+  if (payload_identification_ == PayloadIdentification::RUNNING)
+  {
+    // the whole measurement is caused by the payload, so it is not applied
+    payload_estimator_.add_sample(
+      sensor_world_rot, Eigen::Map<const PayloadEstimator::Vector6d>(new_wrench.data()));
+    if (--remaining_payload_samples_ == 0)
+    {
+      if (payload_estimator_.estimate(identified_payload_))
+      {
+        has_identified_payload_ = true;
+        payload_identification_ = PayloadIdentification::SUCCEEDED;
+        end_effector_weight_[2] = -identified_payload_.weight;
+        cog_pos_ = identified_payload_.cog;
+      }
+      else
+      {
+        payload_identification_ = PayloadIdentification::FAILED;
+      }
+    }
+    wrench_world_.setZero();
+    return;
+  }
+  if (has_identified_payload_)
+  {
+    new_wrench.col(0) -= identified_payload_.force_offset;
+    new_wrench.col(1) -= identified_payload_.torque_offset;
+  }
 
   // transform to world frame
   Eigen::Matrix<double, 3, 2> new_wrench_base = sensor_world_rot * new_wrench;
@@ -332,67 +621,108 @@ void AdmittanceRule::process_wrench_measurements(
   }
 }
 
-const control_msgs::msg::AdmittanceControllerState & AdmittanceRule::get_controller_state()
+void AdmittanceRule::start_payload_identification(const size_t num_samples)
+{
+  payload_estimator_.reset();
+  remaining_payload_samples_ = num_samples;
+  payload_identification_ =
+    num_samples > 0 ? PayloadIdentification::RUNNING : PayloadIdentification::FAILED;
+}
+
+void AdmittanceRule::init_controller_state(
+  control_msgs::msg::AdmittanceControllerState & state_message) const
+{
+  state_message.joint_state.name = joint_names_;
+  state_message.joint_state.position.assign(num_joints_, 0);
+  state_message.joint_state.velocity.assign(num_joints_, 0);
+  state_message.joint_state.effort.assign(num_joints_, 0);
+  state_message.mass.data.assign(NUM_CARTESIAN_DOF, 0.0);
+  state_message.selected_axes.data.assign(NUM_CARTESIAN_DOF, 0);
+  state_message.damping.data.assign(NUM_CARTESIAN_DOF, 0);
+  state_message.stiffness.data.assign(NUM_CARTESIAN_DOF, 0);
+  state_message.wrench_base.header.frame_id = parameters_.kinematics.base;
+  state_message.admittance_velocity.header.frame_id = parameters_.kinematics.base;
+  state_message.admittance_acceleration.header.frame_id = parameters_.kinematics.base;
+  state_message.admittance_position.header.frame_id = parameters_.kinematics.base;
+  state_message.admittance_position.child_frame_id = "admittance_offset";
+  state_message.ref_trans_base_ft.header.frame_id = parameters_.kinematics.base;
+  state_message.ref_trans_base_ft.child_frame_id = "ft_reference";
+  state_message.ft_sensor_frame.data = parameters_.ft_sensor.frame.id;
+}
+
+void AdmittanceRule::get_exchange_state(
+  admittance_state_exchange::AdmittanceExchangeState & exchange_state) const
 {
   for (size_t i = 0; i < NUM_CARTESIAN_DOF; ++i)
   {
-    state_message_.stiffness.data[i] = admittance_state_.stiffness[i];
-    state_message_.damping.data[i] = admittance_state_.damping[i];
-    state_message_.selected_axes.data[i] = static_cast<bool>(admittance_state_.selected_axes[i]);
-    state_message_.mass.data[i] = admittance_state_.mass[i];
+    exchange_state.wrench_base[i] = admittance_state_.wrench_base[i];
+    exchange_state.displacement[i] = admittance_state_.admittance_displacement[i];
+    exchange_state.velocity[i] = admittance_state_.admittance_velocity[i];
   }
+}
 
-  for (size_t i = 0; i < parameters_.joints.size(); ++i)
+void AdmittanceRule::get_controller_state(
+  control_msgs::msg::AdmittanceControllerState & state_message) const
+{
+  for (size_t i = 0; i < NUM_CARTESIAN_DOF; ++i)
   {
-    state_message_.joint_state.name[i] = parameters_.joints[i];
-    state_message_.joint_state.position[i] = admittance_state_.joint_pos[i];
-    state_message_.joint_state.velocity[i] = admittance_state_.joint_vel[i];
-    state_message_.joint_state.effort[i] = admittance_state_.joint_acc[i];
+    state_message.stiffness.data[i] = admittance_state_.stiffness[i];
+    state_message.damping.data[i] = admittance_state_.damping[i];
+    state_message.selected_axes.data[i] = static_cast<bool>(admittance_state_.selected_axes[i]);
+    state_message.mass.data[i] = admittance_state_.mass[i];
   }
 
-  state_message_.wrench_base.wrench.force.x = admittance_state_.wrench_base[0];
-  state_message_.wrench_base.wrench.force.y = admittance_state_.wrench_base[1];
-  state_message_.wrench_base.wrench.force.z = admittance_state_.wrench_base[2];
-  state_message_.wrench_base.wrench.torque.x = admittance_state_.wrench_base[3];
-  state_message_.wrench_base.wrench.torque.y = admittance_state_.wrench_base[4];
-  state_message_.wrench_base.wrench.torque.z = admittance_state_.wrench_base[5];
-
-  state_message_.admittance_velocity.twist.linear.x = admittance_state_.admittance_velocity[0];
-  state_message_.admittance_velocity.twist.linear.y = admittance_state_.admittance_velocity[1];
-  state_message_.admittance_velocity.twist.linear.z = admittance_state_.admittance_velocity[2];
-  state_message_.admittance_velocity.twist.angular.x = admittance_state_.admittance_velocity[3];
-  state_message_.admittance_velocity.twist.angular.y = admittance_state_.admittance_velocity[4];
-  state_message_.admittance_velocity.twist.angular.z = admittance_state_.admittance_velocity[5];
+  for (size_t i = 0; i < num_joints_; ++i)
+  {
+    state_message.joint_state.position[i] = admittance_state_.joint_pos[i];
+    state_message.joint_state.velocity[i] = admittance_state_.joint_vel[i];
+    state_message.joint_state.effort[i] = admittance_state_.joint_acc[i];
+  }
 
-  state_message_.admittance_acceleration.twist.linear.x =
+  state_message.wrench_base.wrench.force.x = admittance_state_.wrench_base[0];
+  state_message.wrench_base.wrench.force.y = admittance_state_.wrench_base[1];
+  state_message.wrench_base.wrench.force.z = admittance_state_.wrench_base[2];
+  state_message.wrench_base.wrench.torque.x = admittance_state_.wrench_base[3];
+  state_message.wrench_base.wrench.torque.y = admittance_state_.wrench_base[4];
+  state_message.wrench_base.wrench.torque.z = admittance_state_.wrench_base[5];
+
+  state_message.admittance_velocity.twist.linear.x = admittance_state_.admittance_velocity[0];
+  state_message.admittance_velocity.twist.linear.y = admittance_state_.admittance_velocity[1];
+  state_message.admittance_velocity.twist.linear.z = admittance_state_.admittance_velocity[2];
+  state_message.admittance_velocity.twist.angular.x = admittance_state_.admittance_velocity[3];
+  state_message.admittance_velocity.twist.angular.y = admittance_state_.admittance_velocity[4];
+  state_message.admittance_velocity.twist.angular.z = admittance_state_.admittance_velocity[5];
+
+  state_message.admittance_acceleration.twist.linear.x =
     admittance_state_.admittance_acceleration[0];
-  state_message_.admittance_acceleration.twist.linear.y =
+  state_message.admittance_acceleration.twist.linear.y =
     admittance_state_.admittance_acceleration[1];
-  state_message_.admittance_acceleration.twist.linear.z =
+  state_message.admittance_acceleration.twist.linear.z =
     admittance_state_.admittance_acceleration[2];
-  state_message_.admittance_acceleration.twist.angular.x =
+  state_message.admittance_acceleration.twist.angular.x =
     admittance_state_.admittance_acceleration[3];
-  state_message_.admittance_acceleration.twist.angular.y =
+  state_message.admittance_acceleration.twist.angular.y =
     admittance_state_.admittance_acceleration[4];
-  state_message_.admittance_acceleration.twist.angular.z =
+  state_message.admittance_acceleration.twist.angular.z =
     admittance_state_.admittance_acceleration[5];
 
-  state_message_.admittance_position = tf2::eigenToTransform(admittance_state_.admittance_position);
-
-  state_message_.ref_trans_base_ft.header.frame_id = parameters_.kinematics.base;
-  state_message_.ref_trans_base_ft.header.frame_id = "ft_reference";
-  state_message_.ref_trans_base_ft = tf2::eigenToTransform(admittance_state_.ref_trans_base_ft);
+  // only the transforms are set, the frames are set by init_controller_state()
+  state_message.admittance_position.transform =
+    tf2::eigenToTransform(admittance_state_.admittance_position).transform;
+  state_message.ref_trans_base_ft.transform =
+    tf2::eigenToTransform(admittance_state_.ref_trans_base_ft).transform;
 
   Eigen::Quaterniond quat(admittance_state_.rot_base_control);
-  state_message_.rot_base_control.w = quat.w();
-  state_message_.rot_base_control.x = quat.x();
-  state_message_.rot_base_control.y = quat.y();
-  state_message_.rot_base_control.z = quat.z();
-
-  state_message_.ft_sensor_frame.data =
-    admittance_state_.ft_sensor_frame;  // TODO(anyone) remove dynamic allocation here
+  state_message.rot_base_control.w = quat.w();
+  state_message.rot_base_control.x = quat.x();
+  state_message.rot_base_control.y = quat.y();
+  state_message.rot_base_control.z = quat.z();
 
-  return state_message_;
+  // the frame only changes with the parameters, so it is usually not copied
+  if (state_message.ft_sensor_frame.data != admittance_state_.ft_sensor_frame)
+  {
+    state_message.ft_sensor_frame.data = admittance_state_.ft_sensor_frame;
+  }
 }
 
 template <typename T1, typename T2>
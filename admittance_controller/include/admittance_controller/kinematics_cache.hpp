@@ -0,0 +1,377 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ADMITTANCE_CONTROLLER__KINEMATICS_CACHE_HPP_
+#define ADMITTANCE_CONTROLLER__KINEMATICS_CACHE_HPP_
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "kinematics_interface/kinematics_interface.hpp"
+#include "memory_prefault/memory_prefault.hpp"
+
+namespace admittance_controller
+{
+/// Damped least-squares inverse of the Jacobians, see KinematicsCache
+struct JacobianInverseOptions
+{
+  /// Invert the cached Jacobians in every cycle, instead of the pseudo-inverse of the plugin
+  bool damped_least_squares = false;
+  /// Constant damping
+  double alpha = 0.0;
+  /// Manipulability below which the damping is increased, no increase if zero
+  double manipulability_threshold = 0.0;
+  /// Damping added at zero manipulability
+  double max_damping = 0.0;
+};
+
+/// Touch the coefficients of the Eigen matrix \p matrix, see memory_prefault::prefault()
+template <typename MatrixT>
+size_t prefault_eigen(MatrixT & matrix)
+{
+  return memory_prefault::prefault_span(matrix.data(), static_cast<size_t>(matrix.size()));
+}
+
+/**
+ * \brief Cache of link transforms and Jacobians in front of a kinematics plugin.
+ *
+ * Within one control cycle, the same joint positions are solved for the same links several
+ * times. The results are stored per link and joint positions until start_cycle() starts the next
+ * refresh. The entries are preallocated by reset(), if more different requests are made between
+ * two refreshes, they are passed to the plugin without caching.
+ *
+ * If the kinematics are refreshed only every few cycles, the cycles in between use the results of
+ * the last refresh for the closest joint positions: link transforms are extrapolated to first
+ * order with the Jacobian of the link, the Jacobians are reused as they are. Cartesian deltas are
+ * then converted to joint deltas with the damped least-squares inverse of the Jacobian, see
+ * convert_cartesian_deltas_to_joint_deltas(). With JacobianInverseOptions::damped_least_squares,
+ * this inverse is also used in the cycles refreshing the kinematics, so one Jacobian per cycle is
+ * calculated by the plugin and used for all conversions.
+ */
+class KinematicsCache
+{
+public:
+  /**
+   * Use \p kinematics for \p num_joints joints and cache up to \p capacity results of each type.
+   *
+   * \param[in] refresh_cycles number of cycles between two refreshes, 1 to refresh in every cycle
+   * \param[in] inverse_options damped least-squares inverse of the Jacobians, used if
+   * \p refresh_cycles is above 1 or with JacobianInverseOptions::damped_least_squares
+   */
+  void reset(
+    kinematics_interface::KinematicsInterface * kinematics, const size_t num_joints,
+    const size_t capacity, const size_t refresh_cycles = 1,
+    const JacobianInverseOptions & inverse_options = JacobianInverseOptions())
+  {
+    kinematics_ = kinematics;
+    refresh_cycles_ = std::max<size_t>(refresh_cycles, 1);
+    inverse_options_ = inverse_options;
+    joint_pos_ = Eigen::VectorXd::Zero(static_cast<Eigen::Index>(num_joints));
+    delta_joint_pos_ = joint_pos_;
+    solved_jacobian_ = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, joint_pos_.size());
+    transforms_.assign(capacity, TransformEntry());
+    jacobians_.assign(capacity, JacobianEntry());
+    for (auto & entry : transforms_)
+    {
+      entry.joint_pos = joint_pos_;
+    }
+    for (auto & entry : jacobians_)
+    {
+      entry.joint_pos = joint_pos_;
+      entry.jacobian = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, joint_pos_.size());
+      entry.jacobian_inverse = Eigen::Matrix<double, Eigen::Dynamic, 6>::Zero(joint_pos_.size(), 6);
+    }
+    clear();
+    // the first cycle refreshes
+    cycles_since_refresh_ = refresh_cycles_ - 1;
+  }
+
+  /// Touch the storage of the results, so the first updates don't page fault, not realtime-safe
+  size_t prefault()
+  {
+    size_t bytes = prefault_eigen(solved_jacobian_) + prefault_eigen(joint_pos_) +
+                   prefault_eigen(delta_joint_pos_) +
+                   memory_prefault::prefault(transforms_, jacobians_);
+    for (auto & entry : transforms_)
+    {
+      bytes += memory_prefault::prefault(entry.link_name) + prefault_eigen(entry.joint_pos);
+    }
+    for (auto & entry : jacobians_)
+    {
+      bytes += memory_prefault::prefault(entry.link_name) + prefault_eigen(entry.joint_pos) +
+               prefault_eigen(entry.jacobian) + prefault_eigen(entry.jacobian_inverse);
+    }
+    return bytes;
+  }
+
+  /// Drop all cached results
+  void clear()
+  {
+    num_transforms_ = 0;
+    num_jacobians_ = 0;
+  }
+
+  /// To be called when a new cycle starts, drops the cached results if they have to be refreshed
+  void start_cycle()
+  {
+    if (++cycles_since_refresh_ >= refresh_cycles_)
+    {
+      cycles_since_refresh_ = 0;
+      clear();
+    }
+  }
+
+  bool calculate_link_transform(
+    const std::vector<double> & joint_pos, const std::string & link_name,
+    Eigen::Isometry3d & transform)
+  {
+    joint_pos_ = Eigen::Map<const Eigen::VectorXd>(
+      joint_pos.data(), static_cast<Eigen::Index>(joint_pos.size()));
+    return calculate_link_transform(joint_pos_, link_name, transform);
+  }
+
+  bool calculate_link_transform(
+    const Eigen::VectorXd & joint_pos, const std::string & link_name,
+    Eigen::Isometry3d & transform)
+  {
+    const TransformEntry * cached = find_entry(transforms_, num_transforms_, joint_pos, link_name);
+    if (cached != nullptr && cached->joint_pos == joint_pos)
+    {
+      transform = cached->transform;
+      return true;
+    }
+    if (cached != nullptr && is_between_refreshes())
+    {
+      // the Jacobian is cached together with the transform when refreshing
+      const JacobianEntry * jacobian = find_entry(jacobians_, num_jacobians_, joint_pos, link_name);
+      if (jacobian != nullptr && jacobian->joint_pos == cached->joint_pos)
+      {
+        extrapolate(*cached, jacobian->jacobian, joint_pos, transform);
+        return true;
+      }
+    }
+
+    if (!kinematics_->calculate_link_transform(joint_pos, link_name, transform))
+    {
+      return false;
+    }
+    if (num_transforms_ < transforms_.size())
+    {
+      auto & entry = transforms_[num_transforms_++];
+      entry.link_name = link_name;
+      entry.joint_pos = joint_pos;
+      entry.transform = transform;
+      if (refresh_cycles_ > 1)
+      {
+        // needed for the extrapolation until the next refresh
+        get_jacobian(joint_pos, link_name);
+      }
+    }
+    return true;
+  }
+
+  /// Uses the cached Jacobian of \p link_name, \f$ \Delta x = J \Delta \theta \f$
+  bool convert_joint_deltas_to_cartesian_deltas(
+    const Eigen::VectorXd & joint_pos, const Eigen::VectorXd & delta_theta,
+    const std::string & link_name, Eigen::Matrix<double, 6, 1> & delta_x)
+  {
+    const JacobianEntry * entry = get_jacobian(joint_pos, link_name);
+    if (entry == nullptr)
+    {
+      return kinematics_->convert_joint_deltas_to_cartesian_deltas(
+        joint_pos, delta_theta, link_name, delta_x);
+    }
+    delta_x.noalias() = entry->jacobian * delta_theta;
+    return true;
+  }
+
+  /**
+   * Passed to the plugin, which defines the pseudo-inverse of the Jacobian, if the kinematics are
+   * refreshed in every cycle without JacobianInverseOptions::damped_least_squares. Otherwise, the
+   * damped least-squares inverse \f$ J^T (J J^T + \lambda I)^{-1} \f$ of the cached Jacobian is
+   * used. The damping \f$ \lambda \f$ is \f$ \alpha \f$, plus
+   * \f$ \lambda_{max} (1 - w / w_0)^2 \f$ if the manipulability \f$ w = \sqrt{\det(J J^T)} \f$ is
+   * below the threshold \f$ w_0 \f$, so the joint deltas stay bounded close to singularities.
+   */
+  bool convert_cartesian_deltas_to_joint_deltas(
+    const Eigen::VectorXd & joint_pos, const Eigen::Matrix<double, 6, 1> & delta_x,
+    const std::string & link_name, Eigen::VectorXd & delta_theta)
+  {
+    const JacobianEntry * entry =
+      uses_jacobian_inverse() ? get_jacobian(joint_pos, link_name) : nullptr;
+    if (entry == nullptr)
+    {
+      return kinematics_->convert_cartesian_deltas_to_joint_deltas(
+        joint_pos, delta_x, link_name, delta_theta);
+    }
+    delta_theta.noalias() = entry->jacobian_inverse * delta_x;
+    return true;
+  }
+
+private:
+  struct TransformEntry
+  {
+    std::string link_name;
+    Eigen::VectorXd joint_pos;
+    Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+  };
+
+  struct JacobianEntry
+  {
+    std::string link_name;
+    Eigen::VectorXd joint_pos;
+    Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian;
+    // only calculated if uses_jacobian_inverse()
+    Eigen::Matrix<double, Eigen::Dynamic, 6> jacobian_inverse;
+  };
+
+  /// True if the cached results are from an earlier cycle
+  bool is_between_refreshes() const { return cycles_since_refresh_ != 0; }
+
+  /// True if Cartesian deltas are converted with the inverse of the cached Jacobians
+  bool uses_jacobian_inverse() const
+  {
+    return refresh_cycles_ > 1 || inverse_options_.damped_least_squares;
+  }
+
+  /**
+   * Entry of \p link_name with the same joint positions. Between refreshes, the entry with the
+   * closest joint positions is returned if there is no exact match. nullptr if there is none.
+   */
+  template <typename Entry>
+  const Entry * find_entry(
+    const std::vector<Entry> & entries, const size_t num_entries,
+    const Eigen::VectorXd & joint_pos, const std::string & link_name) const
+  {
+    const Entry * closest = nullptr;
+    double closest_distance = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < num_entries; ++i)
+    {
+      const auto & entry = entries[i];
+      if (entry.link_name != link_name)
+      {
+        continue;
+      }
+      if (entry.joint_pos == joint_pos)
+      {
+        return &entry;
+      }
+      const double distance = (entry.joint_pos - joint_pos).squaredNorm();
+      if (is_between_refreshes() && distance < closest_distance)
+      {
+        closest = &entry;
+        closest_distance = distance;
+      }
+    }
+    return closest;
+  }
+
+  /// Cached Jacobian, calculated if missing. nullptr if it failed or the cache is full.
+  const JacobianEntry * get_jacobian(
+    const Eigen::VectorXd & joint_pos, const std::string & link_name)
+  {
+    const JacobianEntry * cached = find_entry(jacobians_, num_jacobians_, joint_pos, link_name);
+    if (cached != nullptr)
+    {
+      return cached;
+    }
+    if (num_jacobians_ >= jacobians_.size())
+    {
+      return nullptr;
+    }
+    auto & entry = jacobians_[num_jacobians_];
+    if (!kinematics_->calculate_jacobian(joint_pos, link_name, entry.jacobian))
+    {
+      return nullptr;
+    }
+    entry.link_name = link_name;
+    entry.joint_pos = joint_pos;
+    if (uses_jacobian_inverse())
+    {
+      calculate_jacobian_inverse(entry);
+    }
+    ++num_jacobians_;
+    return &entry;
+  }
+
+  /// Damped least-squares inverse of the Jacobian of \p entry, without allocations
+  void calculate_jacobian_inverse(JacobianEntry & entry)
+  {
+    // equal to (J^T J + lambda I)^-1 J^T, but only the 6x6 matrix has to be factorized
+    Eigen::Matrix<double, 6, 6> jacobian_square;
+    jacobian_square.noalias() = entry.jacobian * entry.jacobian.transpose();
+    double damping = inverse_options_.alpha;
+    if (inverse_options_.manipulability_threshold > 0.0)
+    {
+      // the determinant is the product of the diagonal of the factorization
+      ldlt_.compute(jacobian_square);
+      const double manipulability = std::sqrt(std::max(0.0, ldlt_.vectorD().prod()));
+      if (manipulability < inverse_options_.manipulability_threshold)
+      {
+        const double ratio = 1.0 - manipulability / inverse_options_.manipulability_threshold;
+        damping += inverse_options_.max_damping * ratio * ratio;
+      }
+    }
+    jacobian_square.diagonal().array() += damping;
+    ldlt_.compute(jacobian_square);
+    // the damped J J^T is symmetric, so the inverse is the transpose of (J J^T + lambda I)^-1 J
+    solved_jacobian_ = ldlt_.solve(entry.jacobian);
+    entry.jacobian_inverse = solved_jacobian_.transpose();
+  }
+
+  /// First order extrapolation of the transform in \p entry to \p joint_pos
+  void extrapolate(
+    const TransformEntry & entry, const Eigen::Matrix<double, 6, Eigen::Dynamic> & jacobian,
+    const Eigen::VectorXd & joint_pos, Eigen::Isometry3d & transform)
+  {
+    delta_joint_pos_ = joint_pos - entry.joint_pos;
+    Eigen::Matrix<double, 6, 1> delta_x;
+    delta_x.noalias() = jacobian * delta_joint_pos_;
+
+    transform = entry.transform;
+    transform.translation() += delta_x.head<3>();
+    const double angle = delta_x.tail<3>().norm();
+    if (angle > std::numeric_limits<double>::epsilon())
+    {
+      // the angular part of the Jacobian is expressed in the base frame
+      transform.linear() =
+        Eigen::AngleAxisd(angle, delta_x.tail<3>() / angle).toRotationMatrix() *
+        entry.transform.linear();
+    }
+  }
+
+  kinematics_interface::KinematicsInterface * kinematics_ = nullptr;
+  size_t refresh_cycles_ = 1;
+  size_t cycles_since_refresh_ = 0;
+  JacobianInverseOptions inverse_options_;
+  Eigen::LDLT<Eigen::Matrix<double, 6, 6>> ldlt_;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> solved_jacobian_;
+  // storage for joint positions given as std::vector, and their deltas
+  Eigen::VectorXd joint_pos_;
+  Eigen::VectorXd delta_joint_pos_;
+  std::vector<TransformEntry> transforms_;
+  size_t num_transforms_ = 0;
+  std::vector<JacobianEntry> jacobians_;
+  size_t num_jacobians_ = 0;
+};
+
+}  // namespace admittance_controller
+
+#endif  // ADMITTANCE_CONTROLLER__KINEMATICS_CACHE_HPP_
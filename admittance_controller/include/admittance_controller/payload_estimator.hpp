@@ -0,0 +1,145 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ADMITTANCE_CONTROLLER__PAYLOAD_ESTIMATOR_HPP_
+#define ADMITTANCE_CONTROLLER__PAYLOAD_ESTIMATOR_HPP_
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <cmath>
+#include <cstddef>
+
+namespace admittance_controller
+{
+/// Payload of a force torque sensor, in the sensor frame
+struct Payload
+{
+  // weight, e.g. mass * 9.81
+  double weight = 0.0;
+  // center of gravity
+  Eigen::Vector3d cog = Eigen::Vector3d::Zero();
+  // wrench measured without any payload
+  Eigen::Vector3d force_offset = Eigen::Vector3d::Zero();
+  Eigen::Vector3d torque_offset = Eigen::Vector3d::Zero();
+};
+
+/**
+ * \brief Least squares estimate of the payload of a force torque sensor from static wrenches.
+ *
+ * A sample is the wrench measured in the sensor frame while only gravity acts on the payload,
+ * with the rotation of the sensor frame in a world frame in which gravity points down (neg. Z).
+ * The force is modeled as weight * g + force_offset and the torque as
+ * cog x (weight * g) + torque_offset, with the unit gravity vector g in the sensor frame, both
+ * linear in the unknowns. Only the normal equations are accumulated, so neither add_sample() nor
+ * estimate() allocate memory.
+ *
+ * The samples have to be measured in at least three orientations of the sensor, whose gravity
+ * vectors don't lie on a line, so that all unknowns are determined.
+ */
+class PayloadEstimator
+{
+public:
+  using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+  /// Smallest eigenvalue of the normal equations per sample for an estimate, about the squared
+  /// angle in radians between the orientations of the sensor
+  static constexpr double MIN_EXCITATION = 1e-3;
+
+  void reset()
+  {
+    force_normal_.setZero();
+    force_rhs_.setZero();
+    torque_normal_.setZero();
+    torque_rhs_.setZero();
+    num_samples_ = 0;
+  }
+
+  /**
+   * \param[in] rot_world_sensor rotation of the sensor frame in the world frame
+   * \param[in] wrench force and torque measured in the sensor frame
+   */
+  void add_sample(const Eigen::Matrix3d & rot_world_sensor, const Vector6d & wrench)
+  {
+    // gravity (0, 0, -1) of the world in the sensor frame
+    const Eigen::Vector3d gravity = -rot_world_sensor.row(2).transpose();
+
+    Eigen::Matrix<double, 3, 4> force_rows;
+    force_rows.col(0) = gravity;
+    force_rows.rightCols<3>().setIdentity();
+    force_normal_.noalias() += force_rows.transpose() * force_rows;
+    force_rhs_.noalias() += force_rows.transpose() * wrench.head<3>();
+
+    // cog x (weight * g) = -[g]x * (weight * cog), linear in the first moment weight * cog
+    Eigen::Matrix<double, 3, 6> torque_rows;
+    torque_rows.leftCols<3>() << 0.0, gravity.z(), -gravity.y(), -gravity.z(), 0.0, gravity.x(),
+      gravity.y(), -gravity.x(), 0.0;
+    torque_rows.rightCols<3>().setIdentity();
+    torque_normal_.noalias() += torque_rows.transpose() * torque_rows;
+    torque_rhs_.noalias() += torque_rows.transpose() * wrench.tail<3>();
+
+    ++num_samples_;
+  }
+
+  size_t num_samples() const { return num_samples_; }
+
+  /**
+   * \param[out] payload estimated payload, not changed on failure
+   * \return false if the orientations of the samples don't determine the payload
+   */
+  bool estimate(Payload & payload) const
+  {
+    if (num_samples_ == 0)
+    {
+      return false;
+    }
+    const double min_eigenvalue = MIN_EXCITATION * static_cast<double>(num_samples_);
+    const Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> force_eigenvalues(
+      force_normal_, Eigen::EigenvaluesOnly);
+    const Eigen::SelfAdjointEigenSolver<Matrix6d> torque_eigenvalues(
+      torque_normal_, Eigen::EigenvaluesOnly);
+    if (
+      force_eigenvalues.eigenvalues()(0) < min_eigenvalue ||
+      torque_eigenvalues.eigenvalues()(0) < min_eigenvalue)
+    {
+      return false;
+    }
+
+    const Eigen::Vector4d force_solution = force_normal_.ldlt().solve(force_rhs_);
+    const Vector6d torque_solution = torque_normal_.ldlt().solve(torque_rhs_);
+    payload.weight = force_solution(0);
+    payload.force_offset = force_solution.tail<3>();
+    // without weight, the center of gravity has no effect
+    payload.cog = std::abs(payload.weight) > MIN_WEIGHT
+                    ? Eigen::Vector3d(torque_solution.head<3>() / payload.weight)
+                    : Eigen::Vector3d::Zero();
+    payload.torque_offset = torque_solution.tail<3>();
+    return true;
+  }
+
+private:
+  using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+  static constexpr double MIN_WEIGHT = 1e-6;
+
+  Eigen::Matrix4d force_normal_ = Eigen::Matrix4d::Zero();
+  Eigen::Vector4d force_rhs_ = Eigen::Vector4d::Zero();
+  Matrix6d torque_normal_ = Matrix6d::Zero();
+  Vector6d torque_rhs_ = Vector6d::Zero();
+  size_t num_samples_ = 0;
+};
+
+}  // namespace admittance_controller
+
+#endif  // ADMITTANCE_CONTROLLER__PAYLOAD_ESTIMATOR_HPP_
@@ -0,0 +1,145 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ADMITTANCE_CONTROLLER__REFERENCE_INTERPOLATOR_HPP_
+#define ADMITTANCE_CONTROLLER__REFERENCE_INTERPOLATOR_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace admittance_controller
+{
+enum class ReferenceInterpolation
+{
+  /// ramp from the previous reference to a new one over the period of the references, i.e.,
+  /// interpolate linearly between them with a delay of one period
+  INTERPOLATE,
+  /// move the position of a reference with its velocity until the next one, without delay
+  EXTRAPOLATE,
+};
+
+/**
+ * \brief Smooths references which change at a lower rate than the updates, e.g., those of a
+ * preceding controller running at 100 Hz in front of the admittance controller at 1 kHz.
+ *
+ * A reference changes if any of its positions or velocities differs from the previous one, and the
+ * period of the references is the time between the last two changes. Periods longer than the
+ * maximum interval, e.g., while the preceding controller holds its reference, are no rate: the
+ * references are taken as they are until the next two changes tell the period again.
+ *
+ * All memory is allocated in configure(), update() is realtime-safe.
+ */
+class ReferenceInterpolator
+{
+public:
+  /**
+   * \param max_interval_ns longest period of the references which is interpolated or extrapolated
+   */
+  void configure(size_t num_joints, ReferenceInterpolation mode, int64_t max_interval_ns)
+  {
+    mode_ = mode;
+    max_interval_ns_ = max_interval_ns;
+    received_positions_.assign(num_joints, 0.0);
+    received_velocities_.assign(num_joints, 0.0);
+    previous_positions_.assign(num_joints, 0.0);
+    previous_velocities_.assign(num_joints, 0.0);
+    reset();
+  }
+
+  /// Take the reference of the next update as it is, e.g., on activation
+  void reset()
+  {
+    has_reference_ = false;
+    interval_ns_ = 0;
+  }
+
+  /// Replace the \p positions and \p velocities of the reference at \p time_ns by smooth ones
+  void update(int64_t time_ns, std::vector<double> & positions, std::vector<double> & velocities)
+  {
+    const size_t num_joints = std::min(
+      received_positions_.size(), std::min(positions.size(), velocities.size()));
+    if (!has_reference_)
+    {
+      std::copy_n(positions.begin(), num_joints, received_positions_.begin());
+      std::copy_n(velocities.begin(), num_joints, received_velocities_.begin());
+      change_time_ns_ = time_ns;
+      has_reference_ = true;
+      return;
+    }
+
+    const auto end = static_cast<std::ptrdiff_t>(num_joints);
+    if (
+      !std::equal(positions.begin(), positions.begin() + end, received_positions_.begin()) ||
+      !std::equal(velocities.begin(), velocities.begin() + end, received_velocities_.begin()))
+    {
+      const int64_t interval_ns = time_ns - change_time_ns_;
+      interval_ns_ = interval_ns <= max_interval_ns_ ? interval_ns : 0;
+      change_time_ns_ = time_ns;
+      previous_positions_.swap(received_positions_);
+      previous_velocities_.swap(received_velocities_);
+      std::copy_n(positions.begin(), num_joints, received_positions_.begin());
+      std::copy_n(velocities.begin(), num_joints, received_velocities_.begin());
+    }
+
+    const int64_t elapsed_ns = time_ns - change_time_ns_;
+    if (interval_ns_ <= 0)
+    {
+      std::copy_n(received_positions_.begin(), num_joints, positions.begin());
+      std::copy_n(received_velocities_.begin(), num_joints, velocities.begin());
+    }
+    else if (mode_ == ReferenceInterpolation::INTERPOLATE)
+    {
+      const double ratio =
+        std::min(static_cast<double>(elapsed_ns) / static_cast<double>(interval_ns_), 1.0);
+      for (size_t i = 0; i < num_joints; ++i)
+      {
+        positions[i] =
+          previous_positions_[i] + ratio * (received_positions_[i] - previous_positions_[i]);
+        velocities[i] =
+          previous_velocities_[i] + ratio * (received_velocities_[i] - previous_velocities_[i]);
+      }
+    }
+    else
+    {
+      // at most one period, a reference which stops changing isn't moved further
+      const double dt = static_cast<double>(std::min(elapsed_ns, interval_ns_)) / 1e9;
+      for (size_t i = 0; i < num_joints; ++i)
+      {
+        positions[i] = received_positions_[i] + received_velocities_[i] * dt;
+        velocities[i] = received_velocities_[i];
+      }
+    }
+  }
+
+  /// Period of the references in nanoseconds, zero if unknown
+  int64_t interval_ns() const { return interval_ns_; }
+
+private:
+  ReferenceInterpolation mode_ = ReferenceInterpolation::INTERPOLATE;
+  int64_t max_interval_ns_ = 0;
+  bool has_reference_ = false;
+  int64_t change_time_ns_ = 0;
+  int64_t interval_ns_ = 0;
+  // the last reference as it changed, and the one before
+  std::vector<double> received_positions_;
+  std::vector<double> received_velocities_;
+  std::vector<double> previous_positions_;
+  std::vector<double> previous_velocities_;
+};
+
+}  // namespace admittance_controller
+
+#endif  // ADMITTANCE_CONTROLLER__REFERENCE_INTERPOLATOR_HPP_
@@ -16,19 +16,82 @@
 
 #include "admittance_controller/admittance_controller.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <functional>
+#include <initializer_list>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "admittance_controller/admittance_rule_impl.hpp"
 #include "geometry_msgs/msg/wrench.hpp"
+#include "interface_values/copy_values.hpp"
 #include "rcutils/logging_macros.h"
 #include "tf2_ros/buffer.h"
 #include "trajectory_msgs/msg/joint_trajectory_point.hpp"
 
+namespace
+{
+size_t prefault_point(trajectory_msgs::msg::JointTrajectoryPoint & point)
+{
+  return memory_prefault::prefault(
+    point.positions, point.velocities, point.accelerations, point.effort);
+}
+
+size_t prefault_state_msg(control_msgs::msg::AdmittanceControllerState & msg)
+{
+  return memory_prefault::prefault(
+    msg.joint_state.name, msg.joint_state.position, msg.joint_state.velocity,
+    msg.joint_state.effort, msg.mass.data, msg.selected_axes.data, msg.damping.data,
+    msg.stiffness.data);
+}
+
+/// Read the wrench of \p sensor, zero if any of its values is NaN
+void read_wrench(
+  semantic_components::ForceTorqueSensor & sensor, geometry_msgs::msg::Wrench & ft_values)
+{
+  sensor.get_values_as_message(ft_values);
+  if (
+    std::isnan(ft_values.force.x) || std::isnan(ft_values.force.y) ||
+    std::isnan(ft_values.force.z) || std::isnan(ft_values.torque.x) ||
+    std::isnan(ft_values.torque.y) || std::isnan(ft_values.torque.z))
+  {
+    ft_values = geometry_msgs::msg::Wrench();
+  }
+}
+
+/// Log the result of the payload identification of \p admittance if it was running before the
+/// last update, the identification ends in a single update
+void log_payload_identification(
+  const rclcpp::Logger & logger, const admittance_controller::AdmittanceRule & admittance)
+{
+  using admittance_controller::PayloadIdentification;
+  if (admittance.get_payload_identification() == PayloadIdentification::RUNNING)
+  {
+    return;
+  }
+  const auto & sensor_name = admittance.parameters_.ft_sensor.name;
+  if (admittance.get_payload_identification() == PayloadIdentification::FAILED)
+  {
+    RCLCPP_WARN(
+      logger,
+      "Failed to identify the payload of '%s', the orientations of the sensor varied too little.",
+      sensor_name.c_str());
+    return;
+  }
+  const auto & payload = admittance.get_identified_payload();
+  RCLCPP_INFO(
+    logger,
+    "Identified the payload of '%s': weight %.3f, center of gravity [%.4f, %.4f, %.4f] in the "
+    "sensor frame.",
+    sensor_name.c_str(), payload.weight, payload.cog.x(), payload.cog.y(), payload.cog.z());
+}
+}  // namespace
+
 namespace admittance_controller
 {
 controller_interface::CallbackReturn AdmittanceController::on_init()
@@ -38,6 +101,14 @@ controller_interface::CallbackReturn AdmittanceController::on_init()
   {
     parameter_handler_ = std::make_shared<admittance_controller::ParamListener>(get_node());
     admittance_ = std::make_unique<admittance_controller::AdmittanceRule>(parameter_handler_);
+    for (const auto & end_effector : admittance_->parameters_.end_effectors)
+    {
+      EndEffector additional_end_effector;
+      additional_end_effector.name = end_effector;
+      additional_end_effector.admittance =
+        std::make_unique<admittance_controller::AdmittanceRule>(parameter_handler_, end_effector);
+      end_effectors_.push_back(std::move(additional_end_effector));
+    }
   }
   catch (const std::exception & e)
   {
@@ -46,6 +117,15 @@ controller_interface::CallbackReturn AdmittanceController::on_init()
     return controller_interface::CallbackReturn::ERROR;
   }
 
+  joint_space_ = admittance_->parameters_.admittance.joint_space.enable;
+  if (joint_space_ && !end_effectors_.empty())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "'end_effectors' are not supported with 'admittance.joint_space.enable'.");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
   // number of joints in controllers is fixed after initialization
   num_joints_ = admittance_->parameters_.joints.size();
 
@@ -57,6 +137,11 @@ controller_interface::CallbackReturn AdmittanceController::on_init()
   reference_ = last_reference_;
   reference_admittance_ = last_reference_;
   joint_state_ = last_reference_;
+  joint_state_.effort.assign(num_joints_, 0.0);
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.reference_admittance = last_reference_;
+  }
 
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -93,9 +178,28 @@ controller_interface::InterfaceConfiguration AdmittanceController::state_interfa
     }
   }
 
+  // the external joint torques follow the joint states, instead of the force torque sensors
+  if (joint_space_)
+  {
+    for (const auto & joint : admittance_->parameters_.joints)
+    {
+      state_interfaces_config_names.push_back(
+        joint + "/" + admittance_->parameters_.admittance.joint_space.torque_interface);
+    }
+    return {
+      controller_interface::interface_configuration_type::INDIVIDUAL,
+      state_interfaces_config_names};
+  }
+
   auto ft_interfaces = force_torque_sensor_->get_state_interface_names();
   state_interfaces_config_names.insert(
     state_interfaces_config_names.end(), ft_interfaces.begin(), ft_interfaces.end());
+  for (const auto & end_effector : end_effectors_)
+  {
+    ft_interfaces = end_effector.force_torque_sensor->get_state_interface_names();
+    state_interfaces_config_names.insert(
+      state_interfaces_config_names.end(), ft_interfaces.begin(), ft_interfaces.end());
+  }
 
   return {
     controller_interface::interface_configuration_type::INDIVIDUAL, state_interfaces_config_names};
@@ -111,9 +215,13 @@ AdmittanceController::on_export_reference_interfaces()
   }
 
   std::vector<hardware_interface::CommandInterface> chainable_command_interfaces;
+  const size_t num_gain_references = admittance_->parameters_.admittance.gain_reference_interfaces
+                                       ? AdmittanceRule::NUM_GAIN_REFERENCES
+                                       : 0;
   const auto num_chainable_interfaces =
     admittance_->parameters_.chainable_command_interfaces.size() *
-    admittance_->parameters_.joints.size();
+      admittance_->parameters_.joints.size() +
+    num_gain_references;
 
   // allocate dynamic memory
   chainable_command_interfaces.reserve(num_chainable_interfaces);
@@ -141,6 +249,23 @@ AdmittanceController::on_export_reference_interfaces()
     }
   }
 
+  // the gains follow the joint references, in the order of AdmittanceRule::set_gain_references()
+  gain_references_index_ = index;
+  has_gain_references_ = num_gain_references > 0;
+  if (has_gain_references_)
+  {
+    for (const auto * gain : {"mass", "stiffness", "damping"})
+    {
+      for (const auto * axis : {"x", "y", "z", "rx", "ry", "rz"})
+      {
+        chainable_command_interfaces.emplace_back(hardware_interface::CommandInterface(
+          std::string(get_node()->get_name()), std::string("admittance/") + gain + "." + axis,
+          reference_interfaces_.data() + index));
+        index++;
+      }
+    }
+  }
+
   return chainable_command_interfaces;
 }
 
@@ -265,7 +390,21 @@ controller_interface::CallbackReturn AdmittanceController::on_configure(
   // setup subscribers and publishers
   auto joint_command_callback =
     [this](const std::shared_ptr<trajectory_msgs::msg::JointTrajectoryPoint> msg)
-  { input_joint_command_.writeFromNonRT(msg); };
+  {
+    const auto is_valid_size = [this](const std::vector<double> & values)
+    { return values.empty() || values.size() == num_joints_; };
+    if (!is_valid_size(msg->positions) || !is_valid_size(msg->velocities))
+    {
+      RCLCPP_WARN(
+        get_node()->get_logger(),
+        "Ignoring joint reference with %zu positions and %zu velocities, expected 0 or %zu.",
+        msg->positions.size(), msg->velocities.size(), num_joints_);
+      return;
+    }
+    input_joint_command_.writeFromNonRT(*msg);
+  };
+  // no reference until the first message is received
+  input_joint_command_.initRT(trajectory_msgs::msg::JointTrajectoryPoint());
   input_joint_command_subscriber_ =
     get_node()->create_subscription<trajectory_msgs::msg::JointTrajectoryPoint>(
       "~/joint_references", rclcpp::SystemDefaultsQoS(), joint_command_callback);
@@ -274,9 +413,43 @@ controller_interface::CallbackReturn AdmittanceController::on_configure(
   state_publisher_ =
     std::make_unique<realtime_tools::RealtimePublisher<ControllerStateMsg>>(s_publisher_);
 
+  // the rate of ~/status applies to the states of the end effectors as well
+  state_publish_rate_ = telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+    get_node()->get_namespace(), s_publisher_->get_topic_name(),
+    admittance_->parameters_.state_publish_rate);
+
+  admittance_state_slot_.reset();
+  if (admittance_->parameters_.export_state)
+  {
+    admittance_state_slot_ =
+      admittance_state_exchange::AdmittanceStateExchange::get_instance().get_slot(
+        get_node()->get_fully_qualified_name());
+  }
+
+  payload_identification_requested_ = false;
+  payload_identification_service_ = get_node()->create_service<std_srvs::srv::Trigger>(
+    "~/identify_payload",
+    [this](
+      const std::shared_ptr<std_srvs::srv::Trigger::Request>,
+      std::shared_ptr<std_srvs::srv::Trigger::Response> response)
+    {
+      if (joint_space_)
+      {
+        response->success = false;
+        response->message = "There is no payload to identify in joint space.";
+        return;
+      }
+      payload_identification_requested_ = true;
+      response->success = true;
+      response->message =
+        "Identifying the payload, move the end effector through different orientations without "
+        "contact.";
+    });
+
   // Initialize state message
   state_publisher_->lock();
-  state_publisher_->msg_ = admittance_->get_controller_state();
+  admittance_->init_controller_state(state_publisher_->msg_);
+  admittance_->get_controller_state(state_publisher_->msg_);
   state_publisher_->unlock();
 
   // Initialize FTS semantic semantic_component
@@ -284,11 +457,68 @@ controller_interface::CallbackReturn AdmittanceController::on_configure(
     semantic_components::ForceTorqueSensor(admittance_->parameters_.ft_sensor.name));
 
   // configure admittance rule
-  if (admittance_->configure(get_node(), num_joints_) == controller_interface::return_type::ERROR)
+  if (admittance_->configure(get_node()) == controller_interface::return_type::ERROR)
   {
     return controller_interface::CallbackReturn::ERROR;
   }
 
+  // the additional end effectors have their own sensor, kinematics, status and exported state
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.force_torque_sensor = std::make_unique<semantic_components::ForceTorqueSensor>(
+      end_effector.admittance->parameters_.ft_sensor.name);
+    if (end_effector.admittance->configure(get_node()) == controller_interface::return_type::ERROR)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Failed to configure end effector '%s'.",
+        end_effector.name.c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    end_effector.s_publisher = get_node()->create_publisher<ControllerStateMsg>(
+      "~/" + end_effector.name + "/status", rclcpp::SystemDefaultsQoS());
+    end_effector.state_publisher =
+      std::make_unique<realtime_tools::RealtimePublisher<ControllerStateMsg>>(
+        end_effector.s_publisher);
+    end_effector.state_publisher->lock();
+    end_effector.admittance->init_controller_state(end_effector.state_publisher->msg_);
+    end_effector.admittance->get_controller_state(end_effector.state_publisher->msg_);
+    end_effector.state_publisher->unlock();
+
+    end_effector.state_slot.reset();
+    if (admittance_->parameters_.export_state)
+    {
+      end_effector.state_slot =
+        admittance_state_exchange::AdmittanceStateExchange::get_instance().get_slot(
+          std::string(get_node()->get_fully_qualified_name()) + "/" + end_effector.name);
+    }
+  }
+
+  update_time_statistics_.reset();
+  if (admittance_->parameters_.update_statistics.enable)
+  {
+    update_time_statistics_ = std::make_unique<update_time_statistics::UpdateTimeStatistics>();
+    const auto window_size =
+      static_cast<size_t>(admittance_->parameters_.update_statistics.window_size);
+    if (!update_time_statistics_->configure(get_node(), "~/statistics", window_size))
+    {
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+  cycle_budget_ = update_time_statistics::make_cycle_budget(
+    admittance_->parameters_.cycle_budget, static_cast<double>(get_update_rate()));
+
+  reference_interpolator_.reset();
+  const auto & interpolation = admittance_->parameters_.reference_interpolation;
+  if (interpolation.mode != "none")
+  {
+    reference_interpolator_ = std::make_unique<ReferenceInterpolator>();
+    reference_interpolator_->configure(
+      num_joints_,
+      interpolation.mode == "interpolate" ? ReferenceInterpolation::INTERPOLATE
+                                          : ReferenceInterpolation::EXTRAPOLATE,
+      rclcpp::Duration::from_seconds(interpolation.max_interval).nanoseconds());
+  }
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -336,7 +566,15 @@ controller_interface::CallbackReturn AdmittanceController::on_activate(
   admittance_->apply_parameters_update();
 
   // initialize interface of the FTS semantic component
-  force_torque_sensor_->assign_loaned_state_interfaces(state_interfaces_);
+  if (!joint_space_)
+  {
+    force_torque_sensor_->assign_loaned_state_interfaces(state_interfaces_);
+  }
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.admittance->apply_parameters_update();
+    end_effector.force_torque_sensor->assign_loaned_state_interfaces(state_interfaces_);
+  }
 
   // initialize states
   read_state_from_hardware(joint_state_, ft_values_);
@@ -354,6 +592,27 @@ controller_interface::CallbackReturn AdmittanceController::on_activate(
   last_commanded_ = joint_state_;
   reference_ = joint_state_;
   reference_admittance_ = joint_state_;
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.reference_admittance = joint_state_;
+  }
+
+  prefault_rt_buffers();
+
+  // the state is published in the first update
+  state_publish_rate_->reset();
+  if (update_time_statistics_)
+  {
+    update_time_statistics_->reset();
+  }
+  if (cycle_budget_)
+  {
+    cycle_budget_->reset();
+  }
+  if (reference_interpolator_)
+  {
+    reference_interpolator_->reset();
+  }
 
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -367,27 +626,28 @@ controller_interface::return_type AdmittanceController::update_reference_from_su
     return controller_interface::return_type::ERROR;
   }
 
-  joint_command_msg_ = *input_joint_command_.readFromRT();
-
-  // if message exists, load values into references
-  if (joint_command_msg_.get())
+  // load the values of the last message into references, the sizes are checked on reception
+  const auto & joint_command = *input_joint_command_.readFromRT();
+  for (size_t i = 0; i < std::min(joint_command.positions.size(), position_reference_.size());
+       ++i)
   {
-    for (size_t i = 0; i < joint_command_msg_->positions.size(); ++i)
-    {
-      position_reference_[i].get() = joint_command_msg_->positions[i];
-    }
-    for (size_t i = 0; i < joint_command_msg_->velocities.size(); ++i)
-    {
-      velocity_reference_[i].get() = joint_command_msg_->velocities[i];
-    }
+    position_reference_[i].get() = joint_command.positions[i];
+  }
+  for (size_t i = 0; i < std::min(joint_command.velocities.size(), velocity_reference_.size());
+       ++i)
+  {
+    velocity_reference_[i].get() = joint_command.velocities[i];
   }
 
   return controller_interface::return_type::OK;
 }
 
 controller_interface::return_type AdmittanceController::update_and_write_commands(
-  const rclcpp::Time & /*time*/, const rclcpp::Duration & period)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
+  update_time_statistics::ScopedUpdateTimer update_timer(update_time_statistics_.get(), time);
+  update_time_statistics::ScopedCycleBudget cycle_budget_scope(
+    cycle_budget_.get(), period.nanoseconds());
   // Realtime constraints are required in this function
   if (!admittance_)
   {
@@ -396,20 +656,106 @@ controller_interface::return_type AdmittanceController::update_and_write_command
 
   // update input reference from chainable interfaces
   read_state_reference_interfaces(reference_);
+  if (reference_interpolator_)
+  {
+    reference_interpolator_->update(
+      time.nanoseconds(), reference_.positions, reference_.velocities);
+  }
 
   // get all controller inputs
   read_state_from_hardware(joint_state_, ft_values_);
+  if (has_gain_references_)
+  {
+    // the gains are the same for all end effectors
+    const double * gain_references = reference_interfaces_.data() + gain_references_index_;
+    admittance_->set_gain_references(gain_references);
+    for (auto & end_effector : end_effectors_)
+    {
+      end_effector.admittance->set_gain_references(gain_references);
+    }
+  }
+
+  if (payload_identification_requested_.exchange(false))
+  {
+    const auto num_samples = static_cast<size_t>(
+      admittance_->parameters_.gravity_compensation.payload_identification.samples);
+    admittance_->start_payload_identification(num_samples);
+    for (auto & end_effector : end_effectors_)
+    {
+      end_effector.admittance->start_payload_identification(num_samples);
+    }
+  }
 
   // apply admittance control to reference to determine desired state
+  bool identifying_payload = admittance_->get_payload_identification() ==
+                             admittance_controller::PayloadIdentification::RUNNING;
   admittance_->update(joint_state_, ft_values_, reference_, period, reference_admittance_);
+  if (identifying_payload)
+  {
+    log_payload_identification(get_node()->get_logger(), *admittance_);
+  }
+
+  // the offsets of the additional end effectors are added, also for joints shared with others
+  for (auto & end_effector : end_effectors_)
+  {
+    auto & end_effector_reference = end_effector.reference_admittance;
+    identifying_payload = end_effector.admittance->get_payload_identification() ==
+                          admittance_controller::PayloadIdentification::RUNNING;
+    end_effector.admittance->update(
+      joint_state_, end_effector.ft_values, reference_, period, end_effector_reference);
+    if (identifying_payload)
+    {
+      log_payload_identification(get_node()->get_logger(), *end_effector.admittance);
+    }
+    for (size_t i = 0; i < num_joints_; ++i)
+    {
+      reference_admittance_.positions[i] +=
+        end_effector_reference.positions[i] - reference_.positions[i];
+      reference_admittance_.velocities[i] +=
+        end_effector_reference.velocities[i] - reference_.velocities[i];
+      reference_admittance_.accelerations[i] +=
+        end_effector_reference.accelerations[i] - reference_.accelerations[i];
+    }
+  }
 
   // write calculated values to joint interfaces
   write_state_to_hardware(reference_admittance_);
 
-  // Publish controller state
-  state_publisher_->lock();
-  state_publisher_->msg_ = admittance_->get_controller_state();
-  state_publisher_->unlockAndPublish();
+  if (admittance_state_slot_)
+  {
+    // readers in the same cycle get the state of this update
+    exchange_state_.stamp_nanoseconds = time.nanoseconds();
+    admittance_->get_exchange_state(exchange_state_);
+    admittance_state_slot_->write(exchange_state_);
+  }
+  for (auto & end_effector : end_effectors_)
+  {
+    if (end_effector.state_slot)
+    {
+      exchange_state_.stamp_nanoseconds = time.nanoseconds();
+      end_effector.admittance->get_exchange_state(exchange_state_);
+      end_effector.state_slot->write(exchange_state_);
+    }
+  }
+
+  // Publish controller state, skipped if the publisher is still busy with the previous message,
+  // and delayed while the cycle budget is exceeded
+  const bool publish_state =
+    update_time_statistics::allows_optional_work(cycle_budget_.get()) &&
+    state_publish_rate_->is_due(time);
+  if (publish_state && state_publisher_->trylock())
+  {
+    admittance_->get_controller_state(state_publisher_->msg_);
+    state_publisher_->unlockAndPublish();
+  }
+  for (auto & end_effector : end_effectors_)
+  {
+    if (publish_state && end_effector.state_publisher->trylock())
+    {
+      end_effector.admittance->get_controller_state(end_effector.state_publisher->msg_);
+      end_effector.state_publisher->unlockAndPublish();
+    }
+  }
 
   return controller_interface::return_type::OK;
 }
@@ -423,7 +769,14 @@ controller_interface::CallbackReturn AdmittanceController::on_deactivate(
   }
 
   // release force torque sensor interface
-  force_torque_sensor_->release_interfaces();
+  if (!joint_space_)
+  {
+    force_torque_sensor_->release_interfaces();
+  }
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.force_torque_sensor->release_interfaces();
+  }
 
   // reset to prevent stale references
   for (size_t i = 0; i < num_joints_; i++)
@@ -431,6 +784,12 @@ controller_interface::CallbackReturn AdmittanceController::on_deactivate(
     position_reference_[i].get() = std::numeric_limits<double>::quiet_NaN();
     velocity_reference_[i].get() = std::numeric_limits<double>::quiet_NaN();
   }
+  if (has_gain_references_)
+  {
+    std::fill_n(
+      reference_interfaces_.begin() + static_cast<std::ptrdiff_t>(gain_references_index_),
+      AdmittanceRule::NUM_GAIN_REFERENCES, std::numeric_limits<double>::quiet_NaN());
+  }
 
   for (size_t index = 0; index < allowed_interface_types_.size(); ++index)
   {
@@ -438,7 +797,11 @@ controller_interface::CallbackReturn AdmittanceController::on_deactivate(
     joint_state_interface_[index].clear();
   }
   release_interfaces();
-  admittance_->reset(num_joints_);
+  admittance_->reset();
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.admittance->reset();
+  }
 
   return CallbackReturn::SUCCESS;
 }
@@ -446,6 +809,11 @@ controller_interface::CallbackReturn AdmittanceController::on_deactivate(
 controller_interface::CallbackReturn AdmittanceController::on_cleanup(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
+  admittance_state_slot_.reset();
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.state_slot.reset();
+  }
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -456,7 +824,11 @@ controller_interface::CallbackReturn AdmittanceController::on_error(
   {
     return controller_interface::CallbackReturn::ERROR;
   }
-  admittance_->reset(num_joints_);
+  admittance_->reset();
+  for (auto & end_effector : end_effectors_)
+  {
+    end_effector.admittance->reset();
+  }
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -472,26 +844,25 @@ void AdmittanceController::read_state_from_hardware(
   size_t pos_ind = 0;
   size_t vel_ind = pos_ind + has_velocity_command_interface_;
   size_t acc_ind = vel_ind + has_acceleration_state_interface_;
-  for (size_t joint_ind = 0; joint_ind < num_joints_; ++joint_ind)
+  // the interfaces of each type are consecutive, copied and screened for NaN in one pass
+  const auto copy_interfaces = [this](size_t type_ind, std::vector<double> & values)
   {
-    if (has_position_state_interface_)
-    {
-      state_current.positions[joint_ind] =
-        state_interfaces_[pos_ind * num_joints_ + joint_ind].get_value();
-      nan_position |= std::isnan(state_current.positions[joint_ind]);
-    }
-    else if (has_velocity_state_interface_)
-    {
-      state_current.velocities[joint_ind] =
-        state_interfaces_[vel_ind * num_joints_ + joint_ind].get_value();
-      nan_velocity |= std::isnan(state_current.velocities[joint_ind]);
-    }
-    else if (has_acceleration_state_interface_)
-    {
-      state_current.accelerations[joint_ind] =
-        state_interfaces_[acc_ind * num_joints_ + joint_ind].get_value();
-      nan_acceleration |= std::isnan(state_current.accelerations[joint_ind]);
-    }
+    const auto first =
+      state_interfaces_.cbegin() + static_cast<std::ptrdiff_t>(type_ind * num_joints_);
+    return interface_values::copy_values(
+             first, first + static_cast<std::ptrdiff_t>(num_joints_), values.begin()) != 0;
+  };
+  if (has_position_state_interface_)
+  {
+    nan_position = copy_interfaces(pos_ind, state_current.positions);
+  }
+  else if (has_velocity_state_interface_)
+  {
+    nan_velocity = copy_interfaces(vel_ind, state_current.velocities);
+  }
+  else if (has_acceleration_state_interface_)
+  {
+    nan_acceleration = copy_interfaces(acc_ind, state_current.accelerations);
   }
 
   if (nan_position)
@@ -507,14 +878,29 @@ void AdmittanceController::read_state_from_hardware(
     state_current.accelerations = last_commanded_.accelerations;
   }
 
+  if (joint_space_)
+  {
+    // the external torques follow the joint state interfaces, NaN torques are assumed to be zero
+    const auto first = state_interfaces_.cbegin() +
+                       static_cast<std::ptrdiff_t>(
+                         admittance_->parameters_.state_interfaces.size() * num_joints_);
+    if (
+      interface_values::copy_values(
+        first, first + static_cast<std::ptrdiff_t>(num_joints_), state_current.effort.begin()) !=
+      0)
+    {
+      std::replace_if(
+        state_current.effort.begin(), state_current.effort.end(),
+        [](const double torque) { return std::isnan(torque); }, 0.0);
+    }
+    return;
+  }
+
   // if any ft_values are nan, assume values are zero
-  force_torque_sensor_->get_values_as_message(ft_values);
-  if (
-    std::isnan(ft_values.force.x) || std::isnan(ft_values.force.y) ||
-    std::isnan(ft_values.force.z) || std::isnan(ft_values.torque.x) ||
-    std::isnan(ft_values.torque.y) || std::isnan(ft_values.torque.z))
+  read_wrench(*force_torque_sensor_, ft_values);
+  for (auto & end_effector : end_effectors_)
   {
-    ft_values = geometry_msgs::msg::Wrench();
+    read_wrench(*end_effector.force_torque_sensor, end_effector.ft_values);
   }
 }
 
@@ -546,6 +932,25 @@ void AdmittanceController::write_state_to_hardware(
   last_commanded_ = state_commanded;
 }
 
+void AdmittanceController::prefault_rt_buffers()
+{
+  size_t bytes = prefault_point(reference_) + prefault_point(joint_state_) +
+                 prefault_point(reference_admittance_) + prefault_point(last_commanded_) +
+                 prefault_point(last_reference_) + admittance_->prefault();
+  state_publisher_->lock();
+  bytes += prefault_state_msg(state_publisher_->msg_);
+  state_publisher_->unlock();
+  for (auto & end_effector : end_effectors_)
+  {
+    bytes +=
+      prefault_point(end_effector.reference_admittance) + end_effector.admittance->prefault();
+    end_effector.state_publisher->lock();
+    bytes += prefault_state_msg(end_effector.state_publisher->msg_);
+    end_effector.state_publisher->unlock();
+  }
+  RCLCPP_DEBUG(get_node()->get_logger(), "Prefaulted %zu bytes of the update.", bytes);
+}
+
 void AdmittanceController::read_state_reference_interfaces(
   trajectory_msgs::msg::JointTrajectoryPoint & state_reference)
 {
@@ -0,0 +1,248 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "admittance_controller/admittance_controller.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "test_asset_6d_robot_description.hpp"
+
+namespace
+{
+const rclcpp::Duration CONTROL_PERIOD = rclcpp::Duration::from_seconds(0.001);
+// latencies are recorded for at most this many iterations, google benchmark picks the number
+constexpr size_t MAX_RECORDED_LATENCIES = 1000000;
+
+const std::vector<std::string> JOINT_NAMES = {"joint1", "joint2", "joint3",
+                                              "joint4", "joint5", "joint6"};
+const std::string FT_SENSOR_NAME = "ft_sensor_name";
+const std::vector<std::string> FT_INTERFACE_NAMES = {"force.x",  "force.y",  "force.z",
+                                                     "torque.x", "torque.y", "torque.z"};
+
+class BenchmarkableAdmittanceController : public admittance_controller::AdmittanceController
+{
+public:
+  CallbackReturn on_init() override
+  {
+    get_node()->declare_parameter("robot_description", rclcpp::ParameterType::PARAMETER_STRING);
+    get_node()->set_parameter({"robot_description", ros2_control_test_assets::valid_6d_robot_urdf});
+    return admittance_controller::AdmittanceController::on_init();
+  }
+
+  /// Run the admittance rule on the inputs of the last controller update
+  controller_interface::return_type update_admittance_rule(const rclcpp::Duration & period)
+  {
+    return admittance_->update(joint_state_, ft_values_, reference_, period, reference_admittance_);
+  }
+};
+
+/// Percentiles and maximum of the recorded latencies, reported as counters in microseconds
+void report_latencies(benchmark::State & state, std::vector<double> & latencies)
+{
+  if (latencies.empty())
+  {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&latencies](const double p)
+  {
+    const auto index = static_cast<size_t>(std::ceil(p * static_cast<double>(latencies.size())));
+    return latencies[std::min(std::max<size_t>(index, 1), latencies.size()) - 1];
+  };
+  state.counters["p50_us"] = percentile(0.5);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["max_us"] = latencies.back();
+}
+
+/**
+ * Admittance controller on the 6-DoF test robot with the KDL kinematics plugin.
+ *
+ * Arguments: kinematics.refresh_cycles, and 1 for the 'damped_least_squares' kinematics.solver
+ */
+class AdmittanceControllerBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(const benchmark::State & state) override
+  {
+    if (!rclcpp::ok())
+    {
+      rclcpp::init(0, nullptr);
+    }
+    activate_controller(state.range(0), state.range(1) != 0);
+    latencies_.clear();
+    latencies_.reserve(MAX_RECORDED_LATENCIES);
+  }
+
+  void TearDown(const benchmark::State &) override
+  {
+    if (controller_)
+    {
+      controller_->get_node()->deactivate();
+      controller_->get_node()->cleanup();
+      controller_.reset();
+    }
+    command_interfaces_.clear();
+    state_interfaces_.clear();
+    rclcpp::shutdown();
+  }
+
+  /// Configure and activate a controller for position commands on mocked hardware
+  void activate_controller(const int64_t refresh_cycles, const bool damped_least_squares)
+  {
+    controller_ = std::make_shared<BenchmarkableAdmittanceController>();
+    auto node_options = rclcpp::NodeOptions();
+    node_options.allow_undeclared_parameters(false)
+      .automatically_declare_parameters_from_overrides(false)
+      .parameter_overrides(
+        {rclcpp::Parameter("joints", JOINT_NAMES),
+         rclcpp::Parameter("command_interfaces", std::vector<std::string>{"position"}),
+         rclcpp::Parameter("state_interfaces", std::vector<std::string>{"position"}),
+         rclcpp::Parameter(
+           "chainable_command_interfaces", std::vector<std::string>{"position", "velocity"}),
+         rclcpp::Parameter(
+           "kinematics.plugin_name", "kinematics_interface_kdl/KinematicsInterfaceKDL"),
+         rclcpp::Parameter("kinematics.plugin_package", "kinematics_interface"),
+         rclcpp::Parameter("kinematics.base", "base_link"),
+         rclcpp::Parameter("kinematics.tip", "tool0"),
+         rclcpp::Parameter("kinematics.alpha", 0.0005),
+         rclcpp::Parameter("kinematics.refresh_cycles", refresh_cycles),
+         rclcpp::Parameter(
+           "kinematics.solver", damped_least_squares ? "damped_least_squares" : "plugin"),
+         rclcpp::Parameter("ft_sensor.name", FT_SENSOR_NAME),
+         rclcpp::Parameter("ft_sensor.frame.id", "link_6"),
+         rclcpp::Parameter("ft_sensor.filter_coefficient", 0.005),
+         rclcpp::Parameter("control.frame.id", "tool0"),
+         rclcpp::Parameter("fixed_world_frame.frame.id", "base_link"),
+         rclcpp::Parameter("gravity_compensation.frame.id", "tool0"),
+         rclcpp::Parameter("gravity_compensation.CoG.pos", std::vector<double>{0.1, 0.0, 0.0}),
+         rclcpp::Parameter("gravity_compensation.CoG.force", 23.0),
+         rclcpp::Parameter("admittance.selected_axes", std::vector<bool>(6, true)),
+         rclcpp::Parameter(
+           "admittance.mass", std::vector<double>{5.5, 6.6, 7.7, 8.8, 9.9, 10.10}),
+         rclcpp::Parameter("admittance.damping_ratio", std::vector<double>(6, 2.828427)),
+         rclcpp::Parameter(
+           "admittance.stiffness",
+           std::vector<double>{214.1, 214.2, 214.3, 214.4, 214.5, 214.6})});
+    controller_->init("benchmark_admittance_controller", "", 0, "", node_options);
+    controller_->export_reference_interfaces();
+
+    const size_t n_joints = JOINT_NAMES.size();
+    // away from singularities, and a contact force to be reacted to
+    joint_position_ = {0.0, -0.5, 1.0, 0.0, 0.5, 0.0};
+    joint_command_ = joint_position_;
+    wrench_ = {1.0, -2.0, 3.0, 0.1, -0.2, 0.3};
+    command_interfaces_.reserve(n_joints);
+    state_interfaces_.reserve(n_joints + FT_INTERFACE_NAMES.size());
+    std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+    std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+    for (size_t i = 0; i < n_joints; ++i)
+    {
+      command_interfaces_.emplace_back(
+        JOINT_NAMES[i], hardware_interface::HW_IF_POSITION, &joint_command_[i]);
+      loaned_command_interfaces.emplace_back(command_interfaces_.back());
+      state_interfaces_.emplace_back(
+        JOINT_NAMES[i], hardware_interface::HW_IF_POSITION, &joint_position_[i]);
+      loaned_state_interfaces.emplace_back(state_interfaces_.back());
+    }
+    for (size_t i = 0; i < FT_INTERFACE_NAMES.size(); ++i)
+    {
+      state_interfaces_.emplace_back(FT_SENSOR_NAME, FT_INTERFACE_NAMES[i], &wrench_[i]);
+      loaned_state_interfaces.emplace_back(state_interfaces_.back());
+    }
+    controller_->assign_interfaces(
+      std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+    controller_->get_node()->configure();
+    controller_->get_node()->activate();
+  }
+
+protected:
+  std::shared_ptr<BenchmarkableAdmittanceController> controller_;
+  std::array<double, 6> joint_position_;
+  std::array<double, 6> joint_command_;
+  std::array<double, 6> wrench_;
+  std::vector<hardware_interface::CommandInterface> command_interfaces_;
+  std::vector<hardware_interface::StateInterface> state_interfaces_;
+  std::vector<double> latencies_;
+};
+
+/// Time one call of \p function in microseconds, recorded until the reserved storage is full
+template <typename Function>
+void record_latency(std::vector<double> & latencies, Function && function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const auto end = std::chrono::steady_clock::now();
+  if (latencies.size() < latencies.capacity())
+  {
+    latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+}
+
+void kinematics_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"refresh_cycles", "dls"})
+    ->Args({1, 0})
+    ->Args({1, 1})
+    ->Args({4, 0})
+    ->Args({10, 0});
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(AdmittanceControllerBenchmark, admittance_rule_update)
+(benchmark::State & state)
+{
+  // read the inputs from the hardware once
+  rclcpp::Time time = controller_->get_node()->now();
+  controller_->update_and_write_commands(time, CONTROL_PERIOD);
+
+  for (auto _ : state)
+  {
+    record_latency(
+      latencies_, [this]()
+      { benchmark::DoNotOptimize(controller_->update_admittance_rule(CONTROL_PERIOD)); });
+  }
+  report_latencies(state, latencies_);
+}
+BENCHMARK_REGISTER_F(AdmittanceControllerBenchmark, admittance_rule_update)
+  ->Apply(kinematics_arguments);
+
+BENCHMARK_DEFINE_F(AdmittanceControllerBenchmark, update_and_write_commands)
+(benchmark::State & state)
+{
+  rclcpp::Time time = controller_->get_node()->now();
+  for (auto _ : state)
+  {
+    record_latency(
+      latencies_, [this, &time]()
+      { benchmark::DoNotOptimize(controller_->update_and_write_commands(time, CONTROL_PERIOD)); });
+    time += CONTROL_PERIOD;
+  }
+  report_latencies(state, latencies_);
+}
+BENCHMARK_REGISTER_F(AdmittanceControllerBenchmark, update_and_write_commands)
+  ->Apply(kinematics_arguments);
@@ -18,9 +18,12 @@
 
 #include <limits>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "rt_safety_checks/rt_safety_checker.hpp"
+
 // Test on_init returns ERROR when a required parameter is missing
 TEST_P(AdmittanceControllerTestParameterizedMissingParameters, one_init_parameter_is_missing)
 {
@@ -191,6 +194,247 @@ TEST_F(AdmittanceControllerTest, update_success)
     controller_interface::return_type::OK);
 }
 
+TEST_F(AdmittanceControllerTest, update_is_realtime_safe)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  broadcast_tfs();
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time(1, 0);
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+
+  // the state is published in every update the realtime publisher isn't busy
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    time += period;
+    controller_->update(time, period);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+}
+
+TEST_F(AdmittanceControllerTest, update_with_damped_least_squares_is_realtime_safe)
+{
+  SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("kinematics.solver", "damped_least_squares"),
+     rclcpp::Parameter("kinematics.singularity.manipulability_threshold", 0.01)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  broadcast_tfs();
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time(1, 0);
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+
+  // the Jacobian inverse is calculated in the controller in every update
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    time += period;
+    ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+}
+
+TEST_F(AdmittanceControllerTest, state_is_exported_at_each_update)
+{
+  SetUpController("test_admittance_controller", {rclcpp::Parameter("export_state", true)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  auto slot = admittance_state_exchange::AdmittanceStateExchange::get_instance().get_slot(
+    "/test_admittance_controller");
+  admittance_state_exchange::AdmittanceExchangeState state;
+  EXPECT_FALSE(slot->read(state));
+
+  broadcast_tfs();
+  const rclcpp::Time time(1, 0);
+  ASSERT_EQ(
+    controller_->update(time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_TRUE(slot->read(state));
+  EXPECT_EQ(state.stamp_nanoseconds, time.nanoseconds());
+
+  // the same values as in the status message of the next update
+  ControllerStateMsg msg;
+  subscribe_and_get_messages(msg);
+  ASSERT_TRUE(slot->read(state));
+  EXPECT_DOUBLE_EQ(state.wrench_base[0], msg.wrench_base.wrench.force.x);
+  EXPECT_DOUBLE_EQ(state.wrench_base[5], msg.wrench_base.wrench.torque.z);
+  EXPECT_DOUBLE_EQ(state.velocity[0], msg.admittance_velocity.twist.linear.x);
+  EXPECT_DOUBLE_EQ(state.velocity[5], msg.admittance_velocity.twist.angular.z);
+}
+
+TEST_F(AdmittanceControllerTest, additional_end_effector_is_updated_with_its_joints)
+{
+  // the wrist shares the sensor of the fixture, and is an end effector of the same chain
+  SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("end_effectors", std::vector<std::string>{"wrist"}),
+     rclcpp::Parameter(
+       "end_effector.wrist.joints",
+       std::vector<std::string>{"joint1", "joint2", "joint3", "joint4"}),
+     rclcpp::Parameter("end_effector.wrist.kinematics_tip", "link_4"),
+     rclcpp::Parameter("end_effector.wrist.ft_sensor_name", ft_sensor_name_),
+     rclcpp::Parameter("end_effector.wrist.ft_sensor_frame_id", "link_4"),
+     rclcpp::Parameter("end_effector.wrist.control_frame_id", "link_4"),
+     rclcpp::Parameter("end_effector.wrist.gravity_compensation_frame_id", "link_4")});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->end_effectors_.size(), 1u);
+  auto state_interfaces = controller_->state_interface_configuration();
+  EXPECT_EQ(
+    state_interfaces.names.size(), joint_state_values_.size() + 2 * fts_state_values_.size());
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto subscription = test_subscription_node_->create_subscription<ControllerStateMsg>(
+    "/test_admittance_controller/wrist/status", 10, [](const ControllerStateMsg::SharedPtr) {});
+  broadcast_tfs();
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(wait_for(subscription), rclcpp::WaitResultKind::Ready);
+  ControllerStateMsg msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(msg, msg_info));
+  EXPECT_THAT(
+    msg.joint_state.name, ::testing::ElementsAre("joint1", "joint2", "joint3", "joint4"));
+  EXPECT_EQ(msg.ft_sensor_frame.data, "link_4");
+}
+
+TEST_F(AdmittanceControllerTest, gain_references_override_the_parameters)
+{
+  SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("admittance.gain_reference_interfaces", true)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_TRUE(controller_->has_gain_references_);
+  ASSERT_EQ(controller_->reference_interfaces_.size(), 2 * joint_names_.size() + 18);
+  double * gains = controller_->reference_interfaces_.data() + controller_->gain_references_index_;
+
+  // the mass and stiffness of x, and the damping of y
+  gains[0] = 2.0;
+  gains[6] = 50.0;
+  gains[13] = 30.0;
+  broadcast_tfs();
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ControllerStateMsg msg;
+  controller_->admittance_->init_controller_state(msg);
+  controller_->admittance_->get_controller_state(msg);
+  EXPECT_DOUBLE_EQ(msg.mass.data[0], 2.0);
+  EXPECT_DOUBLE_EQ(msg.stiffness.data[0], 50.0);
+  // the damping ratio of the parameters applies to the mass and stiffness in use
+  EXPECT_NEAR(msg.damping.data[0], 2.828427 * 2.0 * 10.0, 1e-9);
+  EXPECT_DOUBLE_EQ(msg.damping.data[1], 30.0);
+  EXPECT_DOUBLE_EQ(msg.mass.data[1], 6.6);
+  EXPECT_DOUBLE_EQ(msg.stiffness.data[1], 214.2);
+
+  // NaN and invalid references restore the parameters
+  gains[0] = std::numeric_limits<double>::quiet_NaN();
+  gains[6] = -1.0;
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(10000000), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  controller_->admittance_->get_controller_state(msg);
+  EXPECT_DOUBLE_EQ(msg.mass.data[0], 5.5);
+  EXPECT_DOUBLE_EQ(msg.stiffness.data[0], 214.1);
+  EXPECT_DOUBLE_EQ(msg.damping.data[1], 30.0);
+}
+
+TEST_F(AdmittanceControllerTest, joint_space_admittance_follows_the_joint_torques)
+{
+  has_joint_torque_interfaces_ = true;
+  SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("admittance.joint_space.enable", true),
+     rclcpp::Parameter("admittance.joint_space.mass", std::vector<double>(6, 2.0)),
+     rclcpp::Parameter("admittance.joint_space.damping", std::vector<double>(6, 10.0)),
+     rclcpp::Parameter("admittance.joint_space.stiffness", std::vector<double>(6, 50.0))});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  auto state_interfaces = controller_->state_interface_configuration();
+  ASSERT_EQ(state_interfaces.names.size(), 2 * joint_names_.size());
+  EXPECT_EQ(state_interfaces.names[joint_names_.size()], "joint1/effort");
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // no transforms are needed, and only the joint with a torque moves: q_ddot = 4 / 2
+  joint_torque_values_[1] = 4.0;
+  joint_torque_values_[2] = std::numeric_limits<double>::quiet_NaN();
+  const double dt = 0.01;
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(dt)),
+    controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_command_values_[1], joint_state_values_[1] + 2.0 * dt * dt, 1e-12);
+  EXPECT_DOUBLE_EQ(joint_command_values_[0], joint_state_values_[0]);
+  EXPECT_DOUBLE_EQ(joint_command_values_[2], joint_state_values_[2]);
+}
+
+TEST_F(AdmittanceControllerTest, joint_space_admittance_without_joint_gains_fails_to_configure)
+{
+  has_joint_torque_interfaces_ = true;
+  SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("admittance.joint_space.enable", true),
+     rclcpp::Parameter("admittance.joint_space.mass", std::vector<double>(6, 2.0))});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+}
+
+TEST_F(AdmittanceControllerTest, end_effector_with_unknown_joint_fails_to_init)
+{
+  const auto result = SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("end_effectors", std::vector<std::string>{"wrist"}),
+     rclcpp::Parameter("end_effector.wrist.joints", std::vector<std::string>{"joint1", "joint7"}),
+     rclcpp::Parameter("end_effector.wrist.kinematics_tip", "link_4"),
+     rclcpp::Parameter("end_effector.wrist.ft_sensor_name", ft_sensor_name_),
+     rclcpp::Parameter("end_effector.wrist.ft_sensor_frame_id", "link_4"),
+     rclcpp::Parameter("end_effector.wrist.control_frame_id", "link_4"),
+     rclcpp::Parameter("end_effector.wrist.gravity_compensation_frame_id", "link_4")});
+  EXPECT_EQ(result, controller_interface::return_type::ERROR);
+}
+
+TEST_F(AdmittanceControllerTest, payload_identification_fails_without_motion)
+{
+  SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("gravity_compensation.payload_identification.samples", 10)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  broadcast_tfs();
+  controller_->payload_identification_requested_ = true;
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time(1, 0);
+  for (int i = 0; i < 9; ++i)
+  {
+    ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+    time += period;
+  }
+  EXPECT_EQ(
+    controller_->admittance_->get_payload_identification(),
+    admittance_controller::PayloadIdentification::RUNNING);
+
+  // a single orientation of the sensor doesn't determine the payload
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  EXPECT_EQ(
+    controller_->admittance_->get_payload_identification(),
+    admittance_controller::PayloadIdentification::FAILED);
+  EXPECT_DOUBLE_EQ(controller_->admittance_->get_identified_payload().weight, 0.0);
+}
+
 TEST_F(AdmittanceControllerTest, deactivate_success)
 {
   SetUpController();
@@ -249,6 +493,33 @@ TEST_F(AdmittanceControllerTest, publish_status_success)
   //   }
 }
 
+TEST_F(AdmittanceControllerTest, publish_status_decimated)
+{
+  SetUpController("test_admittance_controller", {rclcpp::Parameter("state_publish_rate", 10.0)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  broadcast_tfs();
+
+  const auto & rate = controller_->state_publish_rate_;
+  EXPECT_DOUBLE_EQ(rate->get_rate(), 10.0);
+
+  // published in the first update, the rate is not due again before its period passed
+  const rclcpp::Time start_time(1, 0);
+  ASSERT_EQ(
+    controller_->update(start_time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_FALSE(rate->is_due(start_time + rclcpp::Duration::from_seconds(0.05)));
+
+  // published once per period
+  ASSERT_EQ(
+    controller_->update(
+      start_time + rclcpp::Duration::from_seconds(0.15), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_FALSE(rate->is_due(start_time + rclcpp::Duration::from_seconds(0.19)));
+  EXPECT_TRUE(rate->is_due(start_time + rclcpp::Duration::from_seconds(0.21)));
+}
+
 TEST_F(AdmittanceControllerTest, receive_message_and_publish_updated_status)
 {
   SetUpController();
@@ -286,6 +557,28 @@ TEST_F(AdmittanceControllerTest, receive_message_and_publish_updated_status)
   subscribe_and_get_messages(msg);
 }
 
+TEST_F(AdmittanceControllerTest, ignore_joint_references_with_wrong_size)
+{
+  SetUpController();
+  rclcpp::executors::MultiThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  for (size_t wait_count = 0;
+       joint_command_publisher_->get_subscription_count() == 0 && wait_count < 5; ++wait_count)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  ControllerCommandJointMsg joint_msg;
+  joint_msg.positions.assign(joint_names_.size() + 1, 0.5);
+  joint_command_publisher_->publish(joint_msg);
+  ASSERT_TRUE(controller_->wait_for_commands(executor));
+
+  EXPECT_TRUE(controller_->input_joint_command_.readFromRT()->positions.empty());
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -33,6 +33,7 @@
 #include "hardware_interface/loaned_command_interface.hpp"
 #include "hardware_interface/loaned_state_interface.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "rclcpp/parameter_value.hpp"
 #include "rclcpp/utilities.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
@@ -77,6 +78,11 @@ class TestableAdmittanceController : public admittance_controller::AdmittanceCon
   FRIEND_TEST(AdmittanceControllerTest, check_interfaces);
   FRIEND_TEST(AdmittanceControllerTest, activate_success);
   FRIEND_TEST(AdmittanceControllerTest, receive_message_and_publish_updated_status);
+  FRIEND_TEST(AdmittanceControllerTest, publish_status_decimated);
+  FRIEND_TEST(AdmittanceControllerTest, ignore_joint_references_with_wrong_size);
+  FRIEND_TEST(AdmittanceControllerTest, additional_end_effector_is_updated_with_its_joints);
+  FRIEND_TEST(AdmittanceControllerTest, payload_identification_fails_without_motion);
+  FRIEND_TEST(AdmittanceControllerTest, gain_references_override_the_parameters);
 
 public:
   CallbackReturn on_init() override
@@ -210,7 +216,8 @@ protected:
     fts_state_names_ = sc_fts.get_state_interface_names();
     std::vector<hardware_interface::LoanedStateInterface> state_ifs;
 
-    const size_t num_state_ifs = joint_state_values_.size() + fts_state_names_.size();
+    const size_t num_state_ifs =
+      joint_state_values_.size() + fts_state_names_.size() + joint_torque_values_.size();
     state_itfs_.reserve(num_state_ifs);
     state_ifs.reserve(num_state_ifs);
 
@@ -221,6 +228,19 @@ protected:
       state_ifs.emplace_back(state_itfs_.back());
     }
 
+    // the joint torques replace the sensor in joint space
+    if (has_joint_torque_interfaces_)
+    {
+      for (auto i = 0u; i < joint_torque_values_.size(); ++i)
+      {
+        state_itfs_.emplace_back(hardware_interface::StateInterface(
+          joint_names_[i], hardware_interface::HW_IF_EFFORT, &joint_torque_values_[i]));
+        state_ifs.emplace_back(state_itfs_.back());
+      }
+      controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+      return;
+    }
+
     std::vector<std::string> fts_itf_names = {"force.x",  "force.y",  "force.z",
                                               "torque.x", "torque.y", "torque.z"};
 
@@ -396,6 +416,9 @@ protected:
   std::array<double, 6> joint_state_values_ = {1.1, 2.2, 3.3, 4.4, 5.5, 6.6};
   std::array<double, 6> fts_state_values_ = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
   std::vector<std::string> fts_state_names_;
+  // external joint torques, assigned instead of the sensor if set before SetUpController()
+  bool has_joint_torque_interfaces_ = false;
+  std::array<double, 6> joint_torque_values_ = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
 
   std::vector<hardware_interface::StateInterface> state_itfs_;
   std::vector<hardware_interface::CommandInterface> command_itfs_;
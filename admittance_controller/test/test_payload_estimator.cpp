@@ -0,0 +1,97 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Eigen/Geometry>
+#include <cmath>
+
+#include "gmock/gmock.h"
+
+#include "admittance_controller/payload_estimator.hpp"
+
+using admittance_controller::Payload;
+using admittance_controller::PayloadEstimator;
+
+namespace
+{
+/// Wrench measured in the sensor frame with the rotation \p rot_world_sensor
+PayloadEstimator::Vector6d measure(
+  const Payload & payload, const Eigen::Matrix3d & rot_world_sensor)
+{
+  const Eigen::Vector3d weight =
+    rot_world_sensor.transpose() * Eigen::Vector3d(0.0, 0.0, -payload.weight);
+  PayloadEstimator::Vector6d wrench;
+  wrench.head<3>() = weight + payload.force_offset;
+  wrench.tail<3>() = payload.cog.cross(weight) + payload.torque_offset;
+  return wrench;
+}
+
+Eigen::Matrix3d rotation(const double angle, const Eigen::Vector3d & axis)
+{
+  return Eigen::AngleAxisd(angle, axis.normalized()).toRotationMatrix();
+}
+}  // namespace
+
+TEST(PayloadEstimatorTest, payload_is_estimated_from_three_orientations)
+{
+  Payload payload;
+  payload.weight = 23.0;
+  payload.cog = Eigen::Vector3d(0.1, -0.02, 0.05);
+  payload.force_offset = Eigen::Vector3d(1.0, -2.0, 0.5);
+  payload.torque_offset = Eigen::Vector3d(0.1, 0.2, -0.3);
+
+  PayloadEstimator estimator;
+  estimator.reset();
+  for (const auto & rot_world_sensor :
+       {Eigen::Matrix3d::Identity().eval(), rotation(0.5, Eigen::Vector3d::UnitX()),
+        rotation(0.5, Eigen::Vector3d::UnitY()), rotation(0.3, Eigen::Vector3d(1.0, 1.0, 0.0))})
+  {
+    estimator.add_sample(rot_world_sensor, measure(payload, rot_world_sensor));
+  }
+  EXPECT_EQ(estimator.num_samples(), 4u);
+
+  Payload estimated_payload;
+  ASSERT_TRUE(estimator.estimate(estimated_payload));
+  EXPECT_NEAR(estimated_payload.weight, payload.weight, 1e-9);
+  EXPECT_TRUE(estimated_payload.cog.isApprox(payload.cog, 1e-9));
+  EXPECT_TRUE(estimated_payload.force_offset.isApprox(payload.force_offset, 1e-9));
+  EXPECT_TRUE(estimated_payload.torque_offset.isApprox(payload.torque_offset, 1e-9));
+}
+
+TEST(PayloadEstimatorTest, payload_is_not_estimated_from_one_orientation)
+{
+  Payload payload;
+  payload.weight = 10.0;
+  payload.cog = Eigen::Vector3d(0.0, 0.0, 0.1);
+
+  PayloadEstimator estimator;
+  Payload estimated_payload;
+  EXPECT_FALSE(estimator.estimate(estimated_payload));
+
+  // weight and offsets are indistinguishable in a single orientation
+  const Eigen::Matrix3d rot_world_sensor = rotation(0.2, Eigen::Vector3d::UnitX());
+  for (int i = 0; i < 100; ++i)
+  {
+    estimator.add_sample(rot_world_sensor, measure(payload, rot_world_sensor));
+  }
+  EXPECT_FALSE(estimator.estimate(estimated_payload));
+  EXPECT_DOUBLE_EQ(estimated_payload.weight, 0.0);
+
+  // nor is the center of gravity along the axis of a rotation in two orientations
+  estimator.add_sample(Eigen::Matrix3d::Identity(), measure(payload, Eigen::Matrix3d::Identity()));
+  EXPECT_FALSE(estimator.estimate(estimated_payload));
+
+  estimator.reset();
+  EXPECT_EQ(estimator.num_samples(), 0u);
+  EXPECT_FALSE(estimator.estimate(estimated_payload));
+}
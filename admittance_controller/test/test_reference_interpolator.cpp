@@ -0,0 +1,111 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "admittance_controller/reference_interpolator.hpp"
+
+using admittance_controller::ReferenceInterpolation;
+using admittance_controller::ReferenceInterpolator;
+
+namespace
+{
+// updates at 1 kHz, references at 100 Hz
+constexpr int64_t UPDATE_PERIOD_NS = 1000000;
+constexpr int64_t REFERENCE_PERIOD_NS = 10000000;
+constexpr int64_t MAX_INTERVAL_NS = 100000000;
+
+class TestReferenceInterpolator : public ::testing::Test
+{
+protected:
+  // one update with the reference of a preceding controller moving joint 0 with \p velocity
+  void update(double velocity = 1.0)
+  {
+    const int64_t reference_time_ns = time_ns_ - time_ns_ % REFERENCE_PERIOD_NS;
+    positions_ = {velocity * static_cast<double>(reference_time_ns) / 1e9, 0.5};
+    velocities_ = {velocity, 0.0};
+    interpolator_.update(time_ns_, positions_, velocities_);
+    time_ns_ += UPDATE_PERIOD_NS;
+  }
+
+  ReferenceInterpolator interpolator_;
+  int64_t time_ns_ = 0;
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+};
+}  // namespace
+
+TEST_F(TestReferenceInterpolator, interpolation_ramps_over_the_period_of_the_references)
+{
+  interpolator_.configure(2, ReferenceInterpolation::INTERPOLATE, MAX_INTERVAL_NS);
+  for (int i = 0; i < 30; ++i)
+  {
+    update();
+  }
+  EXPECT_EQ(interpolator_.interval_ns(), REFERENCE_PERIOD_NS);
+
+  // delayed by one period of the references, the steps of 10 mm become steps of 1 mm
+  for (int i = 0; i < 20; ++i)
+  {
+    const double expected_position = static_cast<double>(time_ns_ - REFERENCE_PERIOD_NS) / 1e9;
+    update();
+    EXPECT_NEAR(positions_[0], expected_position, 1e-9) << i;
+    EXPECT_DOUBLE_EQ(velocities_[0], 1.0);
+    EXPECT_DOUBLE_EQ(positions_[1], 0.5);
+  }
+}
+
+TEST_F(TestReferenceInterpolator, extrapolation_moves_the_references_with_their_velocities)
+{
+  interpolator_.configure(2, ReferenceInterpolation::EXTRAPOLATE, MAX_INTERVAL_NS);
+  for (int i = 0; i < 30; ++i)
+  {
+    update();
+  }
+  for (int i = 0; i < 20; ++i)
+  {
+    const double expected_position = static_cast<double>(time_ns_) / 1e9;
+    update();
+    EXPECT_NEAR(positions_[0], expected_position, 1e-9) << i;
+    EXPECT_DOUBLE_EQ(velocities_[0], 1.0);
+  }
+}
+
+TEST_F(TestReferenceInterpolator, references_are_taken_as_they_are_without_a_period)
+{
+  interpolator_.configure(2, ReferenceInterpolation::EXTRAPOLATE, MAX_INTERVAL_NS);
+  std::vector<double> positions = {1.0, 2.0};
+  std::vector<double> velocities = {0.1, 0.2};
+  interpolator_.update(0, positions, velocities);
+  EXPECT_THAT(positions, testing::ElementsAre(1.0, 2.0));
+  // a reference held for longer than the maximum interval is no rate
+  positions = {2.0, 3.0};
+  interpolator_.update(2 * MAX_INTERVAL_NS, positions, velocities);
+  EXPECT_EQ(interpolator_.interval_ns(), 0);
+  positions = {3.0, 4.0};
+  interpolator_.update(3 * MAX_INTERVAL_NS, positions, velocities);
+  EXPECT_EQ(interpolator_.interval_ns(), MAX_INTERVAL_NS);
+  positions = {5.0, 6.0};
+  interpolator_.update(5 * MAX_INTERVAL_NS, positions, velocities);
+  EXPECT_EQ(interpolator_.interval_ns(), 0);
+  EXPECT_THAT(positions, testing::ElementsAre(5.0, 6.0));
+
+  interpolator_.reset();
+  positions = {7.0, 8.0};
+  interpolator_.update(5 * MAX_INTERVAL_NS + UPDATE_PERIOD_NS, positions, velocities);
+  EXPECT_THAT(positions, testing::ElementsAre(7.0, 8.0));
+}
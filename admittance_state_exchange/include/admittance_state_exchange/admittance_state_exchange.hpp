@@ -0,0 +1,55 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ADMITTANCE_STATE_EXCHANGE__ADMITTANCE_STATE_EXCHANGE_HPP_
+#define ADMITTANCE_STATE_EXCHANGE__ADMITTANCE_STATE_EXCHANGE_HPP_
+
+#include <array>
+#include <cstdint>
+
+#include "admittance_state_exchange/visibility_control.h"
+#include "command_mailbox/named_slot_registry.hpp"
+
+namespace admittance_state_exchange
+{
+/// Cartesian state of an admittance controller at one update, all in its base frame
+struct AdmittanceExchangeState
+{
+  int64_t stamp_nanoseconds = 0;
+  /// Filtered and gravity compensated wrench: force x, y, z and torque x, y, z
+  std::array<double, 6> wrench_base{};
+  /// Admittance offset from the reference: translation x, y, z and rotation vector x, y, z
+  std::array<double, 6> displacement{};
+  /// Admittance velocity: linear x, y, z and angular x, y, z
+  std::array<double, 6> velocity{};
+};
+
+/// Latest state of one admittance controller, written by its update and read by the others
+using AdmittanceStateSlot = command_mailbox::NamedMailbox<AdmittanceExchangeState>;
+
+/// Admittance state slots of all controllers in this process, by name
+class AdmittanceStateExchange : public command_mailbox::NamedSlotRegistry<AdmittanceStateSlot>
+{
+public:
+  /// The exchange of this process
+  ADMITTANCE_STATE_EXCHANGE_PUBLIC
+  static AdmittanceStateExchange & get_instance();
+
+private:
+  AdmittanceStateExchange() = default;
+};
+
+}  // namespace admittance_state_exchange
+
+#endif  // ADMITTANCE_STATE_EXCHANGE__ADMITTANCE_STATE_EXCHANGE_HPP_
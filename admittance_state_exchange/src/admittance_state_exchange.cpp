@@ -0,0 +1,25 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "admittance_state_exchange/admittance_state_exchange.hpp"
+
+namespace admittance_state_exchange
+{
+AdmittanceStateExchange & AdmittanceStateExchange::get_instance()
+{
+  static AdmittanceStateExchange instance;
+  return instance;
+}
+
+}  // namespace admittance_state_exchange
@@ -0,0 +1,103 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "admittance_state_exchange/admittance_state_exchange.hpp"
+
+using admittance_state_exchange::AdmittanceExchangeState;
+using admittance_state_exchange::AdmittanceStateExchange;
+
+namespace
+{
+/// State with all values set to \p value
+AdmittanceExchangeState make_state(int64_t stamp_nanoseconds, double value)
+{
+  AdmittanceExchangeState state;
+  state.stamp_nanoseconds = stamp_nanoseconds;
+  state.wrench_base.fill(value);
+  state.displacement.fill(value);
+  state.velocity.fill(value);
+  return state;
+}
+}  // namespace
+
+TEST(TestAdmittanceStateExchange, slots_are_shared_by_name)
+{
+  auto & exchange = AdmittanceStateExchange::get_instance();
+  EXPECT_EQ(&exchange, &AdmittanceStateExchange::get_instance());
+
+  auto writer_slot = exchange.get_slot("/first_controller");
+  auto reader_slot = exchange.get_slot("/first_controller");
+  EXPECT_EQ(writer_slot, reader_slot);
+  EXPECT_NE(writer_slot, exchange.get_slot("/second_controller"));
+  EXPECT_EQ(writer_slot->get_name(), "/first_controller");
+}
+
+TEST(TestAdmittanceStateExchange, latest_state_is_read)
+{
+  auto slot = AdmittanceStateExchange::get_instance().get_slot("/latest_controller");
+
+  AdmittanceExchangeState state;
+  state.wrench_base[0] = -1.0;
+  EXPECT_FALSE(slot->read(state));
+  EXPECT_DOUBLE_EQ(state.wrench_base[0], -1.0);
+
+  slot->write(make_state(100, 1.0));
+  auto latest_state = make_state(200, 0.0);
+  latest_state.wrench_base = {1.0, 2.0, 3.0, 0.1, 0.2, 0.3};
+  latest_state.displacement = {0.01, 0.02, 0.03, 0.0, 0.0, 0.05};
+  latest_state.velocity = {0.1, 0.0, -0.1, 0.0, 0.2, 0.0};
+  slot->write(latest_state);
+  ASSERT_TRUE(slot->read(state));
+  EXPECT_EQ(state.stamp_nanoseconds, 200);
+  EXPECT_THAT(state.wrench_base, ::testing::ElementsAreArray(latest_state.wrench_base));
+  EXPECT_THAT(state.displacement, ::testing::ElementsAreArray(latest_state.displacement));
+  EXPECT_THAT(state.velocity, ::testing::ElementsAreArray(latest_state.velocity));
+}
+
+TEST(TestAdmittanceStateExchange, concurrent_reads_are_consistent)
+{
+  auto slot = AdmittanceStateExchange::get_instance().get_slot("/concurrent_controller");
+  std::atomic<bool> keep_writing{true};
+  std::thread writer(
+    [&]()
+    {
+      for (int64_t i = 1; keep_writing; ++i)
+      {
+        slot->write(make_state(i, static_cast<double>(i)));
+      }
+    });
+
+  size_t num_reads = 0;
+  while (num_reads < 10000)
+  {
+    AdmittanceExchangeState state;
+    if (slot->read(state))
+    {
+      const auto value = static_cast<double>(state.stamp_nanoseconds);
+      ASSERT_THAT(state.wrench_base, ::testing::Each(value));
+      ASSERT_THAT(state.displacement, ::testing::Each(value));
+      ASSERT_THAT(state.velocity, ::testing::Each(value));
+      ++num_reads;
+    }
+  }
+  keep_writing = false;
+  writer.join();
+}
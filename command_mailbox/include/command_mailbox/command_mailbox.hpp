@@ -0,0 +1,133 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMAND_MAILBOX__COMMAND_MAILBOX_HPP_
+#define COMMAND_MAILBOX__COMMAND_MAILBOX_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace command_mailbox
+{
+/**
+ * \brief Single-slot mailbox passing the latest command from non-realtime threads to the realtime
+ * loop.
+ *
+ * A seqlock: the sequence number is odd while a write is in progress, so the reader detects a
+ * concurrent write and retries instead of waiting for it. The reader never locks or allocates
+ * memory, concurrent writers are serialized by a mutex. The value is stored as atomic words, hence
+ * \p T has to be trivially copyable.
+ */
+template <typename T>
+class CommandMailbox
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T has to be trivially copyable");
+
+public:
+  /// Attempts of try_read() before giving up, in case a writer is preempted within write()
+  static constexpr size_t MAX_READ_ATTEMPTS = 8;
+
+  /// Replace the stored value, not realtime-safe
+  void write(const T & value)
+  {
+    std::lock_guard<std::mutex> guard(write_mutex_);
+    write_unlocked(value);
+  }
+
+  /**
+   * Replace the stored value without locking, realtime-safe.
+   *
+   * Only if there is a single writer, which never mixes it with write(), e.g. the update of the
+   * controller owning the mailbox.
+   */
+  void write_unlocked(const T & value)
+  {
+    std::array<uint64_t, NUM_WORDS> words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+
+    const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < NUM_WORDS; ++i)
+    {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * Copy the stored value to \p value, realtime-safe.
+   *
+   * \return false if nothing was written yet, or if a write was in progress during all attempts.
+   * \p value is not changed in that case.
+   */
+  bool try_read(T & value) const
+  {
+    uint64_t version = 0;
+    return try_read_newer(value, version);
+  }
+
+  /**
+   * Copy the stored value to \p value if it was written after the value read with \p version,
+   * realtime-safe.
+   *
+   * \param[in,out] version version of the last read value, 0 if none, updated on success
+   * \return false if there is no newer value, or if a write was in progress during all attempts.
+   * \p value is not changed in that case.
+   */
+  bool try_read_newer(T & value, uint64_t & version) const
+  {
+    for (size_t attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt)
+    {
+      const uint64_t sequence = sequence_.load(std::memory_order_acquire);
+      if (sequence == version)
+      {
+        return false;
+      }
+      if (sequence % 2 != 0)
+      {
+        continue;
+      }
+      std::array<uint64_t, NUM_WORDS> words;
+      for (size_t i = 0; i < NUM_WORDS; ++i)
+      {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == sequence)
+      {
+        std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+        version = sequence;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::mutex write_mutex_;
+  std::atomic<uint64_t> sequence_{0};
+  std::array<std::atomic<uint64_t>, NUM_WORDS> words_{};
+};
+
+}  // namespace command_mailbox
+
+#endif  // COMMAND_MAILBOX__COMMAND_MAILBOX_HPP_
@@ -0,0 +1,99 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMMAND_MAILBOX__NAMED_SLOT_REGISTRY_HPP_
+#define COMMAND_MAILBOX__NAMED_SLOT_REGISTRY_HPP_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "command_mailbox/command_mailbox.hpp"
+
+namespace command_mailbox
+{
+/**
+ * \brief Latest value of one controller, written by its update, the slot of a NamedSlotRegistry.
+ *
+ * A CommandMailbox with a single writer, hence neither write() nor read() locks or allocates.
+ */
+template <typename T>
+class NamedMailbox
+{
+public:
+  explicit NamedMailbox(const std::string & name) : name_(name) {}
+
+  NamedMailbox(const NamedMailbox &) = delete;
+  NamedMailbox & operator=(const NamedMailbox &) = delete;
+
+  /// Replace the value, realtime-safe. Only one thread may call it.
+  void write(const T & value) { mailbox_.write_unlocked(value); }
+
+  /**
+   * Copy the latest value to \p value, realtime-safe.
+   *
+   * \return false if nothing was written yet, or if a write was in progress during all attempts.
+   * \p value is not changed in that case.
+   */
+  bool read(T & value) const { return mailbox_.try_read(value); }
+
+  const std::string & get_name() const { return name_; }
+
+private:
+  std::string name_;
+  CommandMailbox<T> mailbox_;
+};
+
+/**
+ * \brief Slots of all controllers in this process, by name.
+ *
+ * Controllers write into the slot named after them in their ``update()``, other controllers read
+ * it in the same cycle of the controller manager. A slot is created by the first call of
+ * get_slot() for its name, by the writer or a reader, and lives as long as the registry, so the
+ * controllers may be configured in any order.
+ *
+ * An exchange derives from it with a ``get_instance()`` defined in its library, so there is one
+ * registry per process. \p SlotT is constructed from the name, e.g. a NamedMailbox.
+ */
+template <typename SlotT>
+class NamedSlotRegistry
+{
+public:
+  NamedSlotRegistry(const NamedSlotRegistry &) = delete;
+  NamedSlotRegistry & operator=(const NamedSlotRegistry &) = delete;
+
+  /// The slot named \p name, created if there is none, not realtime-safe
+  std::shared_ptr<SlotT> get_slot(const std::string & name)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto & slot = slots_[name];
+    if (!slot)
+    {
+      slot = std::make_shared<SlotT>(name);
+    }
+    return slot;
+  }
+
+protected:
+  NamedSlotRegistry() = default;
+
+private:
+  std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<SlotT>> slots_;
+};
+
+}  // namespace command_mailbox
+
+#endif  // COMMAND_MAILBOX__NAMED_SLOT_REGISTRY_HPP_
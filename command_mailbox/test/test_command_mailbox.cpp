@@ -0,0 +1,111 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "command_mailbox/command_mailbox.hpp"
+
+namespace
+{
+struct Command
+{
+  int64_t stamp = 0;
+  double linear = 0.0;
+  double angular = 0.0;
+};
+}  // namespace
+
+TEST(TestCommandMailbox, empty_mailbox_is_not_read)
+{
+  command_mailbox::CommandMailbox<Command> mailbox;
+  Command command{1, 2.0, 3.0};
+  EXPECT_FALSE(mailbox.try_read(command));
+  EXPECT_EQ(command.stamp, 1);
+  EXPECT_EQ(command.linear, 2.0);
+  EXPECT_EQ(command.angular, 3.0);
+}
+
+TEST(TestCommandMailbox, last_written_command_is_read)
+{
+  command_mailbox::CommandMailbox<Command> mailbox;
+  mailbox.write({1, 2.0, 3.0});
+  mailbox.write({4, 5.0, 6.0});
+
+  Command command;
+  ASSERT_TRUE(mailbox.try_read(command));
+  EXPECT_EQ(command.stamp, 4);
+  EXPECT_EQ(command.linear, 5.0);
+  EXPECT_EQ(command.angular, 6.0);
+
+  // reading does not consume the command
+  ASSERT_TRUE(mailbox.try_read(command));
+  EXPECT_EQ(command.stamp, 4);
+}
+
+TEST(TestCommandMailbox, only_newer_commands_are_read)
+{
+  command_mailbox::CommandMailbox<Command> mailbox;
+  uint64_t version = 0;
+  Command command;
+  EXPECT_FALSE(mailbox.try_read_newer(command, version));
+
+  mailbox.write({1, 2.0, 3.0});
+  ASSERT_TRUE(mailbox.try_read_newer(command, version));
+  EXPECT_EQ(command.stamp, 1);
+  EXPECT_FALSE(mailbox.try_read_newer(command, version));
+
+  // the same value written again is newer
+  mailbox.write({1, 2.0, 3.0});
+  EXPECT_TRUE(mailbox.try_read_newer(command, version));
+}
+
+TEST(TestCommandMailbox, concurrent_reads_are_consistent)
+{
+  command_mailbox::CommandMailbox<Command> mailbox;
+  mailbox.write({0, 0.0, 0.0});
+
+  std::atomic<bool> done{false};
+  std::thread writer(
+    [&mailbox, &done]()
+    {
+      for (int64_t i = 1; i <= 100000; ++i)
+      {
+        mailbox.write({i, static_cast<double>(i), -static_cast<double>(i)});
+      }
+      done = true;
+    });
+
+  int64_t last_stamp = 0;
+  while (!done)
+  {
+    Command command;
+    if (mailbox.try_read(command))
+    {
+      // never a mix of two writes, and never older than the last read
+      ASSERT_EQ(command.linear, static_cast<double>(command.stamp));
+      ASSERT_EQ(command.angular, -static_cast<double>(command.stamp));
+      ASSERT_GE(command.stamp, last_stamp);
+      last_stamp = command.stamp;
+    }
+  }
+  writer.join();
+
+  Command command;
+  ASSERT_TRUE(mailbox.try_read(command));
+  EXPECT_EQ(command.stamp, 100000);
+}
@@ -0,0 +1,89 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "command_mailbox/named_slot_registry.hpp"
+
+namespace
+{
+struct State
+{
+  int64_t stamp = 0;
+  double position = 0.0;
+  double velocity = 0.0;
+};
+
+using StateSlot = command_mailbox::NamedMailbox<State>;
+
+class StateRegistry : public command_mailbox::NamedSlotRegistry<StateSlot>
+{
+};
+}  // namespace
+
+TEST(TestNamedSlotRegistry, slots_are_shared_by_name)
+{
+  StateRegistry registry;
+  auto writer_slot = registry.get_slot("/first_controller");
+  auto reader_slot = registry.get_slot("/first_controller");
+  EXPECT_EQ(writer_slot, reader_slot);
+  EXPECT_NE(writer_slot, registry.get_slot("/second_controller"));
+  EXPECT_EQ(writer_slot->get_name(), "/first_controller");
+}
+
+TEST(TestNamedSlotRegistry, latest_value_is_read)
+{
+  StateSlot slot("/controller");
+  State state{-1, -1.0, -1.0};
+  EXPECT_FALSE(slot.read(state));
+  EXPECT_EQ(state.stamp, -1);
+
+  slot.write({1, 2.0, 3.0});
+  slot.write({4, 5.0, 6.0});
+  ASSERT_TRUE(slot.read(state));
+  EXPECT_EQ(state.stamp, 4);
+  EXPECT_EQ(state.position, 5.0);
+  EXPECT_EQ(state.velocity, 6.0);
+}
+
+TEST(TestNamedSlotRegistry, concurrent_reads_are_consistent)
+{
+  StateSlot slot("/concurrent_controller");
+  std::atomic<bool> done{false};
+  std::thread writer(
+    [&slot, &done]()
+    {
+      for (int64_t i = 1; i <= 100000; ++i)
+      {
+        slot.write({i, static_cast<double>(i), -static_cast<double>(i)});
+      }
+      done = true;
+    });
+
+  while (!done)
+  {
+    State state;
+    if (slot.read(state))
+    {
+      // never a mix of two writes
+      ASSERT_EQ(state.position, static_cast<double>(state.stamp));
+      ASSERT_EQ(state.velocity, -static_cast<double>(state.stamp));
+    }
+  }
+  writer.join();
+}
@@ -0,0 +1,69 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// LTTng tracepoint provider, included by the library only
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER controller_tracetools
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "controller_tracetools/tp_call.h"
+
+#if !defined(CONTROLLER_TRACETOOLS__TP_CALL_H_) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define CONTROLLER_TRACETOOLS__TP_CALL_H_
+
+#include <lttng/tracepoint.h>
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  controller_init,
+  TP_ARGS(
+    const void *, controller_arg,
+    const char *, name_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, controller, controller_arg)
+    ctf_string(name, name_arg)
+  )
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  stage_begin,
+  TP_ARGS(
+    const void *, controller_arg,
+    const char *, stage_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, controller, controller_arg)
+    ctf_string(stage, stage_arg)
+  )
+)
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER,
+  stage_end,
+  TP_ARGS(
+    const void *, controller_arg,
+    const char *, stage_arg
+  ),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, controller, controller_arg)
+    ctf_string(stage, stage_arg)
+  )
+)
+
+#endif  // CONTROLLER_TRACETOOLS__TP_CALL_H_
+
+#include <lttng/tracepoint-event.h>
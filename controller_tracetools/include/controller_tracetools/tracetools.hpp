@@ -0,0 +1,57 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_TRACETOOLS__TRACETOOLS_HPP_
+#define CONTROLLER_TRACETOOLS__TRACETOOLS_HPP_
+
+#include "controller_tracetools/config.h"
+
+/**
+ * \brief Emit the controller tracepoint \p event_name with its arguments.
+ *
+ * The tracepoints are
+ * - controller_init(const void * controller, const char * name): maps the handle of a controller
+ *   to its name, emitted on configuration,
+ * - stage_begin(const void * controller, const char * stage) and
+ *   stage_end(const void * controller, const char * stage): enclose a stage of an update, e.g.,
+ *   "sample" of the joint trajectory controller.
+ *
+ * The stage is a string literal, the handle is usually `this`. If the library was built without
+ * LTTng or with CONTROLLER_TRACETOOLS_DISABLED, the macro expands to nothing and its arguments are
+ * not evaluated.
+ *
+ * Example:
+ * \code
+ * CONTROLLER_TRACEPOINT(stage_begin, this, "publish_state");
+ * publish_state(...);
+ * CONTROLLER_TRACEPOINT(stage_end, this, "publish_state");
+ * \endcode
+ */
+#ifdef CONTROLLER_TRACETOOLS_LTTNG_ENABLED
+#define CONTROLLER_TRACEPOINT(event_name, ...) (::controller_tracetools::event_name)(__VA_ARGS__)
+#else
+#define CONTROLLER_TRACEPOINT(event_name, ...) ((void)(0))
+#endif
+
+#ifdef CONTROLLER_TRACETOOLS_LTTNG_ENABLED
+namespace controller_tracetools
+{
+void controller_init(const void * controller, const char * name);
+void stage_begin(const void * controller, const char * stage);
+void stage_end(const void * controller, const char * stage);
+
+}  // namespace controller_tracetools
+#endif
+
+#endif  // CONTROLLER_TRACETOOLS__TRACETOOLS_HPP_
@@ -0,0 +1,39 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "controller_tracetools/tracetools.hpp"
+
+#ifdef CONTROLLER_TRACETOOLS_LTTNG_ENABLED
+#include "controller_tracetools/tp_call.h"
+
+namespace controller_tracetools
+{
+// the tracepoint() macros only check if the event is enabled, if no session records it
+void controller_init(const void * controller, const char * name)
+{
+  tracepoint(controller_tracetools, controller_init, controller, name);
+}
+
+void stage_begin(const void * controller, const char * stage)
+{
+  tracepoint(controller_tracetools, stage_begin, controller, stage);
+}
+
+void stage_end(const void * controller, const char * stage)
+{
+  tracepoint(controller_tracetools, stage_end, controller, stage);
+}
+
+}  // namespace controller_tracetools
+#endif
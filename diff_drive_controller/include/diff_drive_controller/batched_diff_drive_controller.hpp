@@ -0,0 +1,161 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIFF_DRIVE_CONTROLLER__BATCHED_DIFF_DRIVE_CONTROLLER_HPP_
+#define DIFF_DRIVE_CONTROLLER__BATCHED_DIFF_DRIVE_CONTROLLER_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "controller_interface/controller_interface.hpp"
+#include "diff_drive_controller/batched_kinematics.hpp"
+#include "diff_drive_controller/visibility_control.h"
+#include "geometry_msgs/msg/twist_stamped.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+#include "realtime_tools/realtime_buffer.h"
+#include "std_msgs/msg/float64_multi_array.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+#include "update_time_source/update_time_source.hpp"
+
+// auto-generated by generate_parameter_library
+#include "batched_diff_drive_controller_parameters.hpp"
+
+namespace diff_drive_controller
+{
+/**
+ * \brief Differential drive controller for several identical robots with one wheel per side.
+ *
+ * One instance replaces a DiffDriveController per robot, e.g., of a fleet in simulation. The state
+ * of all robots is stored as structure of arrays in BatchedKinematics, so the kinematics and the
+ * odometry of all robots are computed in one loop each.
+ *
+ * Subscribes to:
+ * - \b cmd_vel_batch (std_msgs::msg::Float64MultiArray) : The linear velocities of all robots,
+ *   followed by their angular velocities.
+ * - \b <robot>/cmd_vel (geometry_msgs::msg::TwistStamped) : The velocity of one robot, if
+ *   per_robot_topics is set.
+ *
+ * Publishes:
+ * - \b odom_batch (std_msgs::msg::Float64MultiArray) : The x, y, heading, linear and angular
+ *   velocity of all robots, each field for all robots before the next one.
+ * - \b <robot>/odom (nav_msgs::msg::Odometry) : The odometry of one robot, if per_robot_topics is
+ *   set.
+ * - \b /tf (tf2_msgs::msg::TFMessage) : The transforms of all robots in one message.
+ */
+class BatchedDiffDriveController : public controller_interface::ControllerInterface
+{
+  using Twist = geometry_msgs::msg::TwistStamped;
+  using BatchMsg = std_msgs::msg::Float64MultiArray;
+
+public:
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  BatchedDiffDriveController();
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_init() override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_configure(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_activate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_cleanup(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_error(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+protected:
+  /// Velocity commands of all robots, with the time at which each robot was commanded
+  struct VelocityCommands
+  {
+    std::vector<double> linear;
+    std::vector<double> angular;
+    // negative if the robot wasn't commanded yet
+    std::vector<int64_t> stamps_nanoseconds;
+  };
+
+  /// Names of the wheel joints of all robots, left before right wheel of each robot
+  std::vector<std::string> wheel_joint_names() const;
+
+  /// Pass the commands of the callbacks to update(), locks commands_mutex_, not realtime-safe
+  void write_commands(const std::function<void(VelocityCommands &)> & modify);
+
+  /// Reset the odometry and the commands of all robots
+  void reset();
+  /// Forget the received commands, so that all robots stand until they are commanded again
+  void reset_commands();
+  void halt();
+
+  std::shared_ptr<batched_diff_drive_controller::ParamListener> param_listener_;
+  batched_diff_drive_controller::Params params_;
+
+  BatchedKinematics kinematics_;
+  int64_t cmd_vel_timeout_nanoseconds_ = 0;
+
+  // last commands of all callbacks, only changed with commands_mutex_ locked
+  std::mutex commands_mutex_;
+  VelocityCommands received_commands_;
+  // preallocated on configuration, so passing the commands doesn't allocate memory
+  realtime_tools::RealtimeBuffer<VelocityCommands> rt_commands_;
+  // time of the last update, stamps the commands in the subscriber callbacks
+  update_time_source::UpdateTimeSource update_time_;
+
+  bool subscriber_is_active_ = false;
+  rclcpp::Subscription<BatchMsg>::SharedPtr batch_command_subscriber_;
+  std::vector<rclcpp::Subscription<Twist>::SharedPtr> robot_command_subscribers_;
+
+  std::shared_ptr<rclcpp::Publisher<BatchMsg>> batch_odometry_publisher_;
+  std::shared_ptr<publisher_pool::RealtimePublisher<BatchMsg>> realtime_batch_odometry_publisher_;
+  std::vector<std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>>> odometry_publishers_;
+  std::vector<std::shared_ptr<publisher_pool::RealtimePublisher<nav_msgs::msg::Odometry>>>
+    realtime_odometry_publishers_;
+  std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> odometry_transform_publisher_;
+  std::shared_ptr<publisher_pool::RealtimePublisher<tf2_msgs::msg::TFMessage>>
+    realtime_odometry_transform_publisher_;
+
+  // publish rate limiter, with the telemetry rate policy of the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> publish_rate_;
+
+  bool is_halted_ = false;
+};
+}  // namespace diff_drive_controller
+#endif  // DIFF_DRIVE_CONTROLLER__BATCHED_DIFF_DRIVE_CONTROLLER_HPP_
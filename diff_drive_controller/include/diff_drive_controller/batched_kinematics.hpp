@@ -0,0 +1,213 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIFF_DRIVE_CONTROLLER__BATCHED_KINEMATICS_HPP_
+#define DIFF_DRIVE_CONTROLLER__BATCHED_KINEMATICS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace diff_drive_controller
+{
+/**
+ * \brief Kinematics and odometry of several identical differential drive robots.
+ *
+ * Every quantity of all robots is stored in its own contiguous array, indexed by robot. The loops
+ * over the robots have no branches, invalid feedback is masked by selects, so the compiler can
+ * vectorize them. The pose is integrated with second-order Runge-Kutta, and the velocities are the
+ * ones of the last update, without the rolling mean of Odometry. Only configure() allocates memory.
+ */
+class BatchedKinematics
+{
+public:
+  /// Geometry shared by all robots, and the number of robots, not realtime-safe
+  void configure(
+    size_t num_robots, double wheel_separation, double left_wheel_radius,
+    double right_wheel_radius)
+  {
+    wheel_separation_ = wheel_separation;
+    left_wheel_radius_ = left_wheel_radius;
+    right_wheel_radius_ = right_wheel_radius;
+    for (auto * values :
+         {&left_feedback_, &right_feedback_, &x_, &y_, &heading_, &linear_, &angular_,
+          &linear_commands_, &angular_commands_, &left_commands_, &right_commands_})
+    {
+      values->assign(num_robots, 0.0);
+    }
+    left_previous_.assign(num_robots, std::numeric_limits<double>::quiet_NaN());
+    right_previous_.assign(num_robots, std::numeric_limits<double>::quiet_NaN());
+  }
+
+  size_t size() const { return x_.size(); }
+
+  /// Symmetric limits of the commanded body velocities, infinity to not limit them
+  void set_velocity_limits(double max_linear, double max_angular)
+  {
+    max_linear_ = max_linear;
+    max_angular_ = max_angular;
+  }
+
+  /// Reset the poses and velocities of all robots, and forget the previous wheel positions
+  void reset()
+  {
+    for (auto * values : {&x_, &y_, &heading_, &linear_, &angular_})
+    {
+      std::fill(values->begin(), values->end(), 0.0);
+    }
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+    std::fill(left_previous_.begin(), left_previous_.end(), NaN);
+    std::fill(right_previous_.begin(), right_previous_.end(), NaN);
+  }
+
+  /// Feedback of the left and right wheel of every robot, in rad or rad/s
+  std::vector<double> & left_feedback() { return left_feedback_; }
+  std::vector<double> & right_feedback() { return right_feedback_; }
+
+  /// Commanded body velocities of every robot, in m/s and rad/s, limited by compute_commands()
+  std::vector<double> & linear_commands() { return linear_commands_; }
+  std::vector<double> & angular_commands() { return angular_commands_; }
+
+  /// Velocity commands of the left and right wheel of every robot, in rad/s
+  const std::vector<double> & left_commands() const { return left_commands_; }
+  const std::vector<double> & right_commands() const { return right_commands_; }
+
+  const std::vector<double> & x() const { return x_; }
+  const std::vector<double> & y() const { return y_; }
+  const std::vector<double> & heading() const { return heading_; }
+  const std::vector<double> & linear() const { return linear_; }
+  const std::vector<double> & angular() const { return angular_; }
+
+  /**
+   * Integrate the odometry of all robots from the wheel positions in the feedback.
+   *
+   * The first valid positions of a robot only initialize it. Robots with NaN feedback keep their
+   * pose and velocities.
+   * \return the number of robots with NaN feedback
+   */
+  size_t update_from_positions(double dt)
+  {
+    size_t num_invalid = 0;
+    for (size_t i = 0; i < x_.size(); ++i)
+    {
+      const double left = left_feedback_[i];
+      const double right = right_feedback_[i];
+      // NaN compares unequal to itself, std::isnan() may not be vectorized
+      const bool is_valid = left == left && right == right;
+      num_invalid += is_valid ? 0u : 1u;
+      // NaN if the previous positions are missing
+      const double left_travel = (left - left_previous_[i]) * left_wheel_radius_;
+      const double right_travel = (right - right_previous_[i]) * right_wheel_radius_;
+      // both sides continue from the same update
+      left_previous_[i] = is_valid ? left : left_previous_[i];
+      right_previous_[i] = is_valid ? right : right_previous_[i];
+      integrate(i, left_travel, right_travel, dt);
+    }
+    return num_invalid;
+  }
+
+  /**
+   * Integrate the odometry of all robots from the wheel velocities in the feedback.
+   *
+   * Robots with NaN feedback keep their pose and velocities.
+   * \return the number of robots with NaN feedback
+   */
+  size_t update_from_velocities(double dt)
+  {
+    size_t num_invalid = 0;
+    for (size_t i = 0; i < x_.size(); ++i)
+    {
+      const double left_travel = left_feedback_[i] * left_wheel_radius_ * dt;
+      const double right_travel = right_feedback_[i] * right_wheel_radius_ * dt;
+      num_invalid += (left_travel == left_travel && right_travel == right_travel) ? 0u : 1u;
+      integrate(i, left_travel, right_travel, dt);
+    }
+    return num_invalid;
+  }
+
+  /// Integrate the odometry of all robots from the limited commands of compute_commands()
+  void update_open_loop(double dt)
+  {
+    for (size_t i = 0; i < x_.size(); ++i)
+    {
+      integrate_body(i, linear_commands_[i] * dt, angular_commands_[i] * dt, dt, true);
+    }
+  }
+
+  /// Limit the body velocity commands and compute the wheel commands of all robots
+  void compute_commands()
+  {
+    const double half_separation = 0.5 * wheel_separation_;
+    for (size_t i = 0; i < x_.size(); ++i)
+    {
+      const double linear = std::min(std::max(linear_commands_[i], -max_linear_), max_linear_);
+      const double angular = std::min(std::max(angular_commands_[i], -max_angular_), max_angular_);
+      linear_commands_[i] = linear;
+      angular_commands_[i] = angular;
+      left_commands_[i] = (linear - angular * half_separation) / left_wheel_radius_;
+      right_commands_[i] = (linear + angular * half_separation) / right_wheel_radius_;
+    }
+  }
+
+private:
+  void integrate(size_t i, double left_travel, double right_travel, double dt)
+  {
+    const bool is_valid = left_travel == left_travel && right_travel == right_travel;
+    integrate_body(
+      i, 0.5 * (left_travel + right_travel), (right_travel - left_travel) / wheel_separation_, dt,
+      is_valid);
+  }
+
+  void integrate_body(
+    size_t i, double linear_travel, double angular_travel, double dt, bool is_valid)
+  {
+    // selects instead of branches, an invalid robot doesn't move
+    linear_travel = is_valid ? linear_travel : 0.0;
+    angular_travel = is_valid ? angular_travel : 0.0;
+    const double direction = heading_[i] + 0.5 * angular_travel;
+    x_[i] += linear_travel * std::cos(direction);
+    y_[i] += linear_travel * std::sin(direction);
+    heading_[i] += angular_travel;
+    const bool has_velocities = is_valid && dt > 0.0;
+    linear_[i] = has_velocities ? linear_travel / dt : linear_[i];
+    angular_[i] = has_velocities ? angular_travel / dt : angular_[i];
+  }
+
+  double wheel_separation_ = 0.0;
+  double left_wheel_radius_ = 0.0;
+  double right_wheel_radius_ = 0.0;
+  double max_linear_ = std::numeric_limits<double>::infinity();
+  double max_angular_ = std::numeric_limits<double>::infinity();
+
+  std::vector<double> left_feedback_;
+  std::vector<double> right_feedback_;
+  // wheel positions of the last valid feedback, NaN before the first one
+  std::vector<double> left_previous_;
+  std::vector<double> right_previous_;
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> heading_;
+  std::vector<double> linear_;
+  std::vector<double> angular_;
+  std::vector<double> linear_commands_;
+  std::vector<double> angular_commands_;
+  std::vector<double> left_commands_;
+  std::vector<double> right_commands_;
+};
+
+}  // namespace diff_drive_controller
+
+#endif  // DIFF_DRIVE_CONTROLLER__BATCHED_KINEMATICS_HPP_
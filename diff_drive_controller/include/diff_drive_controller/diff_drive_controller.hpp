@@ -19,35 +19,44 @@
 #ifndef DIFF_DRIVE_CONTROLLER__DIFF_DRIVE_CONTROLLER_HPP_
 #define DIFF_DRIVE_CONTROLLER__DIFF_DRIVE_CONTROLLER_HPP_
 
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <limits>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 
-#include "controller_interface/controller_interface.hpp"
+#include "command_mailbox/command_mailbox.hpp"
+#include "controller_interface/chainable_controller_interface.hpp"
 #include "diff_drive_controller/odometry.hpp"
-#include "diff_drive_controller/speed_limiter.hpp"
 #include "diff_drive_controller/visibility_control.h"
+#include "diff_drive_controller/wheel_kinematics.hpp"
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "hardware_interface/handle.hpp"
+#include "motion_limits/axis_limiter.hpp"
 #include "nav_msgs/msg/odometry.hpp"
 #include "odometry.hpp"
+#include "odometry_exchange/odometry_exchange.hpp"
+#include "odometry_persistence/odometry_snapshot.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_box.h"
+#include "realtime_logging/realtime_logger.hpp"
 #include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
 #include "tf2_msgs/msg/tf_message.hpp"
+#include "tf_aggregator/transform_aggregator.hpp"
+#include "trajectory_msgs/msg/multi_dof_joint_trajectory.hpp"
+#include "update_time_source/update_time_source.hpp"
 
 // auto-generated by generate_parameter_library
 #include "diff_drive_controller_parameters.hpp"
 
 namespace diff_drive_controller
 {
-class DiffDriveController : public controller_interface::ControllerInterface
+class DiffDriveController : public controller_interface::ChainableControllerInterface
 {
   using Twist = geometry_msgs::msg::TwistStamped;
 
@@ -62,7 +71,11 @@ public:
   controller_interface::InterfaceConfiguration state_interface_configuration() const override;
 
   DIFF_DRIVE_CONTROLLER_PUBLIC
-  controller_interface::return_type update(
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
   DIFF_DRIVE_CONTROLLER_PUBLIC
@@ -93,10 +106,17 @@ public:
     const rclcpp_lifecycle::State & previous_state) override;
 
 protected:
+  // override methods from ChainableControllerInterface
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
   struct WheelHandle
   {
     std::reference_wrapper<const hardware_interface::LoanedStateInterface> feedback;
     std::reference_wrapper<hardware_interface::LoanedCommandInterface> velocity;
+    // time of the feedback, only if hardware_timestamp_interface is set
+    const hardware_interface::LoanedStateInterface * timestamp = nullptr;
   };
 
   const char * feedback_type() const;
@@ -112,46 +132,89 @@ protected:
   Params params_;
 
   Odometry odometry_;
+  WheelKinematics wheel_kinematics_;
 
   // Timeout to consider cmd_vel commands old
   std::chrono::milliseconds cmd_vel_timeout_{500};
 
   std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odometry_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<nav_msgs::msg::Odometry>>
     realtime_odometry_publisher_ = nullptr;
 
   std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> odometry_transform_publisher_ =
     nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<tf2_msgs::msg::TFMessage>>
     realtime_odometry_transform_publisher_ = nullptr;
+  // replaces the transform publisher if the transform is aggregated
+  std::shared_ptr<tf_aggregator::TransformSlot> odometry_transform_slot_;
+  // odometry shared with the other controllers of the process, if export_odometry is set
+  std::shared_ptr<odometry_exchange::OdometrySlot> odometry_slot_;
+  // writes the odometry to a file in the background, if odometry_persistence.enable is set
+  std::unique_ptr<odometry_persistence::SnapshotWriter> odometry_snapshot_writer_;
 
   bool subscriber_is_active_ = false;
   rclcpp::Subscription<Twist>::SharedPtr velocity_command_subscriber_ = nullptr;
 
-  realtime_tools::RealtimeBox<std::shared_ptr<Twist>> received_velocity_msg_ptr_{nullptr};
-
-  std::queue<Twist> previous_commands_;  // last two commands
-
-  // speed limiters
-  SpeedLimiter limiter_linear_;
-  SpeedLimiter limiter_angular_;
+  // velocities of the last cmd_vel message, passed from the subscriber to update()
+  struct StampedVelocityCommand
+  {
+    int64_t stamp_nanoseconds = 0;
+    double linear = 0.0;
+    double angular = 0.0;
+  };
+  command_mailbox::CommandMailbox<StampedVelocityCommand> received_velocity_command_;
+  // last command read by update(), kept if the subscriber is writing at the same time
+  StampedVelocityCommand last_velocity_command_;
+
+  // velocities planned ahead of cmd_vel, if enable_velocity_preview is set, the points after
+  // MAX_PREVIEW_POINTS are dropped
+  static constexpr size_t MAX_PREVIEW_POINTS = 16;
+  struct VelocityPreview
+  {
+    size_t num_points = 0;
+    std::array<StampedVelocityCommand, MAX_PREVIEW_POINTS> points{};
+  };
+  using VelocityPreviewMsg = trajectory_msgs::msg::MultiDOFJointTrajectory;
+  rclcpp::Subscription<VelocityPreviewMsg>::SharedPtr velocity_preview_subscriber_ = nullptr;
+  command_mailbox::CommandMailbox<VelocityPreview> received_velocity_preview_;
+  // last preview read by update()
+  VelocityPreview velocity_preview_;
+  // time of the last update, stamps the commands in the subscriber callback
+  update_time_source::UpdateTimeSource update_time_;
+  // logger of update(), whose messages are output by a non-realtime thread
+  std::unique_ptr<realtime_logging::RealtimeLogger> rt_logger_;
+
+  // limits the linear and the angular velocity together
+  using VelocityLimiter = motion_limits::AxisLimiter<2>;
+  // linear and angular velocity
+  using VelocityCommand = VelocityLimiter::Vector;
+
+  // last two limited commands, stored as ring without the headers of the messages
+  std::array<VelocityCommand, 2> previous_commands_;
+  size_t last_command_index_ = 0;  // the other entry is the second to last command
+
+  VelocityLimiter limiter_;
 
   bool publish_limited_velocity_ = false;
   std::shared_ptr<rclcpp::Publisher<Twist>> limited_velocity_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<Twist>> realtime_limited_velocity_publisher_ =
-    nullptr;
+  std::shared_ptr<publisher_pool::RealtimePublisher<Twist>>
+    realtime_limited_velocity_publisher_ = nullptr;
 
   rclcpp::Time previous_update_timestamp_{0};
+  // mean hardware timestamp of the wheel feedback in the last update [s], NaN if there is none
+  double previous_hardware_stamp_ = std::numeric_limits<double>::quiet_NaN();
 
-  // publish rate limiter
-  double publish_rate_ = 50.0;
-  rclcpp::Duration publish_period_ = rclcpp::Duration::from_nanoseconds(0);
-  rclcpp::Time previous_publish_timestamp_{0, 0, RCL_CLOCK_UNINITIALIZED};
+  // publish rate limiter, with the telemetry rate policy of the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> publish_rate_;
 
   bool is_halted = false;
 
   bool reset();
   void halt();
+  // reduce the command where the limits wouldn't reach the previewed velocities otherwise
+  void limit_to_velocity_preview(VelocityCommand & command, const rclcpp::Time & time);
+  // continue from the persisted odometry, if there is a recent one
+  void restore_odometry();
 };
 }  // namespace diff_drive_controller
 #endif  // DIFF_DRIVE_CONTROLLER__DIFF_DRIVE_CONTROLLER_HPP_
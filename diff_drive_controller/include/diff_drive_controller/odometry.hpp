@@ -22,16 +22,24 @@
 #ifndef DIFF_DRIVE_CONTROLLER__ODOMETRY_HPP_
 #define DIFF_DRIVE_CONTROLLER__ODOMETRY_HPP_
 
+#include <array>
 #include <cmath>
 
+#include "diff_drive_controller/velocity_filters.hpp"
+#include "odometry_integration/pose_integrator.hpp"
 #include "rclcpp/time.hpp"
-#include "rcpputils/rolling_mean_accumulator.hpp"
 
 namespace diff_drive_controller
 {
 class Odometry
 {
 public:
+  enum class VelocityEstimator
+  {
+    ROLLING_MEAN,
+    ALPHA_BETA
+  };
+
   explicit Odometry(size_t velocity_rolling_window_size = 10);
 
   void init(const rclcpp::Time & time);
@@ -39,30 +47,58 @@ public:
   bool updateFromVelocity(double left_vel, double right_vel, const rclcpp::Time & time);
   void updateOpenLoop(double linear, double angular, const rclcpp::Time & time);
   void resetOdometry();
-
-  double getX() const { return x_; }
-  double getY() const { return y_; }
-  double getHeading() const { return heading_; }
+  /**
+   * Continue from a persisted odometry: the pose, the velocities, which seed the velocity
+   * estimation, and the last wheel positions [m] of update(). The next update() continues from
+   * these wheel positions if no wheel turned more than \p max_wheel_rotation [rad] since, and from
+   * its own ones otherwise, e.g. after the encoders were reset.
+   */
+  void restore(
+    double x, double y, double heading, double linear, double angular, double left_wheel_pos,
+    double right_wheel_pos, double max_wheel_rotation);
+
+  double getX() const { return pose_.x(); }
+  double getY() const { return pose_.y(); }
+  double getHeading() const { return pose_.heading(); }
   double getLinear() const { return linear_; }
   double getAngular() const { return angular_; }
+  /// Last wheel positions of update() [m], e.g. to persist the odometry
+  double getLeftWheelPosition() const { return left_wheel_old_pos_; }
+  double getRightWheelPosition() const { return right_wheel_old_pos_; }
+  /**
+   * Pose after moving \p dt seconds further with the current velocities, the odometry is not
+   * changed.
+   */
+  void getExtrapolatedPose(double dt, double & x, double & y, double & heading) const;
+  /// Propagated covariance of x, y and heading, row-major
+  const std::array<double, 9> & getPoseCovariance() const { return pose_covariance_; }
+  /// Covariance of the linear and angular velocity of the last update, row-major
+  const std::array<double, 4> & getTwistCovariance() const { return twist_covariance_; }
 
   void setWheelParams(double wheel_separation, double left_wheel_radius, double right_wheel_radius);
   void setVelocityRollingWindowSize(size_t velocity_rolling_window_size);
+  void setVelocityEstimator(VelocityEstimator estimator, double alpha, double beta);
+  /**
+   * Propagate the covariance of the pose, assuming that the travelled distance of each wheel has a
+   * variance of \p variance_per_meter times that distance. 0 disables the propagation.
+   */
+  void setWheelTravelVariance(double variance_per_meter);
+  /**
+   * Integrate each update in \p substeps steps, with the velocities changing linearly from the
+   * ones of the previous update. 1 integrates each update in one step.
+   */
+  void setIntegrationSubsteps(unsigned int substeps);
 
 private:
-  using RollingMeanAccumulator = rcpputils::RollingMeanAccumulator<double>;
-
-  void integrateRungeKutta2(double linear, double angular);
-  void integrateExact(double linear, double angular);
+  void integrate(double linear, double angular, double dt, unsigned int substeps);
+  void propagatePoseCovariance(const odometry_integration::StepJacobian<double> & jacobian);
   void resetAccumulators();
 
   // Current timestamp:
   rclcpp::Time timestamp_;
 
   // Current pose:
-  double x_;        //   [m]
-  double y_;        //   [m]
-  double heading_;  // [rad]
+  odometry_integration::PoseIntegrator<> pose_;
 
   // Current velocity:
   double linear_;   //   [m/s]
@@ -76,11 +112,28 @@ private:
   // Previous wheel position/state [rad]:
   double left_wheel_old_pos_;
   double right_wheel_old_pos_;
-
-  // Rolling mean accumulators for the linear and angular velocities:
-  size_t velocity_rolling_window_size_;
-  RollingMeanAccumulator linear_accumulator_;
-  RollingMeanAccumulator angular_accumulator_;
+  // Wheel rotation [rad] up to which update() continues from restored positions, infinite
+  // without a restore():
+  double restored_max_wheel_rotation_;
+
+  // Sub-steps of the integration, and the velocities of the previous update:
+  unsigned int integration_substeps_;
+  double previous_linear_rate_;   //   [m/s]
+  double previous_angular_rate_;  // [rad/s]
+
+  // Covariance propagation, the input covariance is the one of the linear and angular deltas
+  // of the current update:
+  double wheel_travel_variance_;
+  std::array<double, 4> input_covariance_;
+  std::array<double, 9> pose_covariance_;
+  std::array<double, 4> twist_covariance_;
+
+  // Estimators of the linear and angular velocities:
+  VelocityEstimator velocity_estimator_;
+  RollingMean linear_accumulator_;
+  RollingMean angular_accumulator_;
+  AlphaBetaFilter linear_filter_;
+  AlphaBetaFilter angular_filter_;
 };
 
 }  // namespace diff_drive_controller
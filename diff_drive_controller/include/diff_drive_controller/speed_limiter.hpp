@@ -21,8 +21,11 @@
 
 #include <cmath>
 
+#include "motion_limits/axis_limiter.hpp"
+
 namespace diff_drive_controller
 {
+/// Limits one velocity, see motion_limits::AxisLimiter to limit several velocities together
 class SpeedLimiter
 {
 public:
@@ -37,6 +40,7 @@ public:
    * \param [in] max_acceleration Maximum acceleration [m/s^2], usually >= 0
    * \param [in] min_jerk Minimum jerk [m/s^3], usually <= 0
    * \param [in] max_jerk Maximum jerk [m/s^3], usually >= 0
+   * \throw std::runtime_error if the maximum of an enabled limit is not specified
    */
   SpeedLimiter(
     bool has_velocity_limits = false, bool has_acceleration_limits = false,
@@ -82,22 +86,8 @@ public:
   double limit_jerk(double & v, double v0, double v1, double dt);
 
 private:
-  // Enable/Disable velocity/acceleration/jerk limits:
-  bool has_velocity_limits_;
-  bool has_acceleration_limits_;
-  bool has_jerk_limits_;
-
-  // Velocity limits:
-  double min_velocity_;
-  double max_velocity_;
-
-  // Acceleration limits:
-  double min_acceleration_;
-  double max_acceleration_;
-
-  // Jerk limits:
-  double min_jerk_;
-  double max_jerk_;
+  using Limiter = motion_limits::AxisLimiter<1>;
+  Limiter limiter_;
 };
 
 }  // namespace diff_drive_controller
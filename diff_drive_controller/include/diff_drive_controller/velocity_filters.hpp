@@ -0,0 +1,152 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIFF_DRIVE_CONTROLLER__VELOCITY_FILTERS_HPP_
+#define DIFF_DRIVE_CONTROLLER__VELOCITY_FILTERS_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace diff_drive_controller
+{
+/**
+ * \brief Mean of the last samples, O(1) per sample.
+ *
+ * The running sum is Kahan-compensated, and it is summed again from the window every time the
+ * window is filled, so removing old samples does not accumulate rounding errors on long runs.
+ * Only resize() allocates memory.
+ */
+class RollingMean
+{
+public:
+  explicit RollingMean(size_t window_size = 1) { resize(window_size); }
+
+  /// Set the number of samples of the mean and drop all samples, not realtime-safe
+  void resize(size_t window_size)
+  {
+    window_.assign(std::max<size_t>(window_size, 1), 0.0);
+    reset();
+  }
+
+  /// Drop all samples
+  void reset()
+  {
+    next_ = 0;
+    count_ = 0;
+    sum_ = 0.0;
+    compensation_ = 0.0;
+  }
+
+  void accumulate(double value)
+  {
+    if (count_ == window_.size())
+    {
+      add(-window_[next_]);
+    }
+    else
+    {
+      ++count_;
+    }
+    add(value);
+    window_[next_] = value;
+    next_ = (next_ + 1) % window_.size();
+    if (next_ == 0)
+    {
+      // amortized O(1), drops the rounding errors of removed samples
+      sum_ = 0.0;
+      compensation_ = 0.0;
+      for (const double sample : window_)
+      {
+        add(sample);
+      }
+    }
+  }
+
+  /// Mean of the samples in the window, 0 if there are none
+  double getRollingMean() const
+  {
+    return count_ == 0 ? 0.0 : sum_ / static_cast<double>(count_);
+  }
+
+private:
+  void add(double value)
+  {
+    const double compensated = value - compensation_;
+    const double sum = sum_ + compensated;
+    compensation_ = (sum - sum_) - compensated;
+    sum_ = sum;
+  }
+
+  std::vector<double> window_;
+  size_t next_ = 0;
+  size_t count_ = 0;
+  double sum_ = 0.0;
+  double compensation_ = 0.0;
+};
+
+/**
+ * \brief Alpha-beta filter of a measured value and its rate of change.
+ *
+ * This is the steady-state Kalman filter of a constant rate model. \p alpha weights the
+ * correction of the value, \p beta the one of its rate, both in (0, 1]. Smaller values filter more.
+ */
+class AlphaBetaFilter
+{
+public:
+  explicit AlphaBetaFilter(double alpha = 0.5, double beta = 0.1) : alpha_(alpha), beta_(beta) {}
+
+  void setGains(double alpha, double beta)
+  {
+    alpha_ = alpha;
+    beta_ = beta;
+  }
+
+  /// The next measurement initializes the filter
+  void reset() { initialized_ = false; }
+
+  /// Filter \p measurement taken \p dt seconds after the previous one, returns the filtered value
+  double update(double measurement, double dt)
+  {
+    if (!initialized_)
+    {
+      value_ = measurement;
+      rate_ = 0.0;
+      initialized_ = true;
+      return value_;
+    }
+    if (dt <= 0.0)
+    {
+      return value_;
+    }
+    const double predicted = value_ + rate_ * dt;
+    const double residual = measurement - predicted;
+    value_ = predicted + alpha_ * residual;
+    rate_ += beta_ * residual / dt;
+    return value_;
+  }
+
+  double getValue() const { return value_; }
+
+private:
+  double alpha_;
+  double beta_;
+  bool initialized_ = false;
+  double value_ = 0.0;
+  double rate_ = 0.0;
+};
+
+}  // namespace diff_drive_controller
+
+#endif  // DIFF_DRIVE_CONTROLLER__VELOCITY_FILTERS_HPP_
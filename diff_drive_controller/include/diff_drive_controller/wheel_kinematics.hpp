@@ -0,0 +1,127 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIFF_DRIVE_CONTROLLER__WHEEL_KINEMATICS_HPP_
+#define DIFF_DRIVE_CONTROLLER__WHEEL_KINEMATICS_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace diff_drive_controller
+{
+/**
+ * \brief Kinematics of a differential drive with any number of wheels per side.
+ *
+ * The feedback and commands of all wheels are stored contiguously, each wheel has its own radius.
+ * The motion of the body is the least-squares fit to the linear motion of all wheels, so slipping
+ * wheels are averaged out instead of being ignored. Only configure() allocates memory.
+ */
+class WheelKinematics
+{
+public:
+  /// Radii of the left and right wheels, and the distance between both sides, not realtime-safe
+  void configure(
+    const std::vector<double> & left_radii, const std::vector<double> & right_radii,
+    double wheel_separation)
+  {
+    num_left_ = left_radii.size();
+    radii_ = left_radii;
+    radii_.insert(radii_.end(), right_radii.begin(), right_radii.end());
+    wheel_separation_ = wheel_separation;
+    lateral_offsets_.assign(radii_.size(), 0.5 * wheel_separation);
+    for (size_t i = 0; i < num_left_; ++i)
+    {
+      lateral_offsets_[i] = -0.5 * wheel_separation;
+    }
+    feedback_.assign(radii_.size(), 0.0);
+    commands_.assign(radii_.size(), 0.0);
+
+    // normal equations of the fit only depend on the geometry
+    double sum_offsets = 0.0;
+    double sum_squared_offsets = 0.0;
+    for (const double offset : lateral_offsets_)
+    {
+      sum_offsets += offset;
+      sum_squared_offsets += offset * offset;
+    }
+    const double n = static_cast<double>(radii_.size());
+    const double determinant = n * sum_squared_offsets - sum_offsets * sum_offsets;
+    inverse_normal_ = {sum_squared_offsets / determinant, -sum_offsets / determinant,
+                       n / determinant};
+  }
+
+  size_t num_left() const { return num_left_; }
+  size_t size() const { return radii_.size(); }
+
+  /// Feedback of the left wheels followed by the right wheels, in rad or rad/s
+  std::vector<double> & feedback() { return feedback_; }
+
+  /// Velocity commands of the left wheels followed by the right wheels, in rad/s
+  const std::vector<double> & commands() const { return commands_; }
+
+  /**
+   * Least-squares fit of the body motion to the feedback of all wheels.
+   *
+   * \param[out] linear linear motion of the body, in m or m/s
+   * \param[out] angular angular motion of the body, in rad or rad/s
+   * \return false if the motion is NaN, e.g., for NaN feedback or infinite feedback of both signs
+   */
+  bool fit(double & linear, double & angular) const
+  {
+    double sum_motion = 0.0;
+    double sum_moments = 0.0;
+    for (size_t i = 0; i < feedback_.size(); ++i)
+    {
+      const double motion = feedback_[i] * radii_[i];
+      sum_motion += motion;
+      sum_moments += lateral_offsets_[i] * motion;
+    }
+    linear = inverse_normal_[0] * sum_motion + inverse_normal_[1] * sum_moments;
+    angular = inverse_normal_[1] * sum_motion + inverse_normal_[2] * sum_moments;
+    // NaN propagates through the sums
+    return !std::isnan(linear) && !std::isnan(angular);
+  }
+
+  /// Linear motion of the left and right side for the body motion
+  void side_motion(double linear, double angular, double & left, double & right) const
+  {
+    left = linear - angular * 0.5 * wheel_separation_;
+    right = linear + angular * 0.5 * wheel_separation_;
+  }
+
+  /// Velocity commands of all wheels for a body twist in m/s and rad/s
+  void compute_commands(double linear, double angular)
+  {
+    for (size_t i = 0; i < commands_.size(); ++i)
+    {
+      commands_[i] = (linear + angular * lateral_offsets_[i]) / radii_[i];
+    }
+  }
+
+private:
+  size_t num_left_ = 0;
+  double wheel_separation_ = 0.0;
+  std::vector<double> radii_;
+  std::vector<double> lateral_offsets_;
+  std::vector<double> feedback_;
+  std::vector<double> commands_;
+  // upper triangle of the inverse of the symmetric 2x2 normal matrix
+  std::array<double, 3> inverse_normal_ = {0.0, 0.0, 0.0};
+};
+
+}  // namespace diff_drive_controller
+
+#endif  // DIFF_DRIVE_CONTROLLER__WHEEL_KINEMATICS_HPP_
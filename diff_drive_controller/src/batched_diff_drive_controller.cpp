@@ -0,0 +1,499 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "diff_drive_controller/batched_diff_drive_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/logging.hpp"
+
+namespace
+{
+constexpr auto DEFAULT_BATCH_COMMAND_TOPIC = "~/cmd_vel_batch";
+constexpr auto DEFAULT_BATCH_ODOMETRY_TOPIC = "~/odom_batch";
+constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
+// x, y, heading, linear and angular velocity
+constexpr size_t NUM_ODOMETRY_FIELDS = 5;
+
+/// Symmetric limit of a velocity, NaN for no limit
+double velocity_limit(const double max_velocity)
+{
+  return std::isnan(max_velocity) ? std::numeric_limits<double>::infinity()
+                                  : std::abs(max_velocity);
+}
+}  // namespace
+
+namespace diff_drive_controller
+{
+using controller_interface::interface_configuration_type;
+using controller_interface::InterfaceConfiguration;
+using hardware_interface::HW_IF_POSITION;
+using hardware_interface::HW_IF_VELOCITY;
+
+BatchedDiffDriveController::BatchedDiffDriveController()
+: controller_interface::ControllerInterface()
+{
+}
+
+controller_interface::CallbackReturn BatchedDiffDriveController::on_init()
+{
+  try
+  {
+    param_listener_ = std::make_shared<batched_diff_drive_controller::ParamListener>(get_node());
+    params_ = param_listener_->get_params();
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(stderr, "Exception thrown during init stage with message: %s \n", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+std::vector<std::string> BatchedDiffDriveController::wheel_joint_names() const
+{
+  std::vector<std::string> names;
+  names.reserve(2 * params_.robots.size());
+  for (const auto & robot : params_.robots)
+  {
+    names.push_back(robot + params_.robot_joint_separator + params_.left_wheel_name);
+    names.push_back(robot + params_.robot_joint_separator + params_.right_wheel_name);
+  }
+  return names;
+}
+
+InterfaceConfiguration BatchedDiffDriveController::command_interface_configuration() const
+{
+  std::vector<std::string> conf_names;
+  for (const auto & joint_name : wheel_joint_names())
+  {
+    conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
+  }
+  return {interface_configuration_type::INDIVIDUAL, conf_names};
+}
+
+InterfaceConfiguration BatchedDiffDriveController::state_interface_configuration() const
+{
+  std::vector<std::string> conf_names;
+  if (params_.open_loop)
+  {
+    return {interface_configuration_type::INDIVIDUAL, conf_names};
+  }
+  const char * feedback_type = params_.position_feedback ? HW_IF_POSITION : HW_IF_VELOCITY;
+  for (const auto & joint_name : wheel_joint_names())
+  {
+    conf_names.push_back(joint_name + "/" + feedback_type);
+  }
+  return {interface_configuration_type::INDIVIDUAL, conf_names};
+}
+
+controller_interface::return_type BatchedDiffDriveController::update(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  update_time_.set(time);
+  if (!subscriber_is_active_)
+  {
+    if (!is_halted_)
+    {
+      halt();
+      is_halted_ = true;
+    }
+    return controller_interface::return_type::OK;
+  }
+
+  const size_t num_robots = kinematics_.size();
+  const auto & commands = *rt_commands_.readFromRT();
+  const int64_t now_nanoseconds = time.nanoseconds();
+  auto & linear_commands = kinematics_.linear_commands();
+  auto & angular_commands = kinematics_.angular_commands();
+  for (size_t i = 0; i < num_robots; ++i)
+  {
+    // robots without a recent command brake
+    const int64_t stamp = commands.stamps_nanoseconds[i];
+    const bool is_recent = stamp >= 0 && now_nanoseconds - stamp <= cmd_vel_timeout_nanoseconds_;
+    linear_commands[i] = is_recent ? commands.linear[i] : 0.0;
+    angular_commands[i] = is_recent ? commands.angular[i] : 0.0;
+  }
+  kinematics_.compute_commands();
+
+  const double dt = period.seconds();
+  if (params_.open_loop)
+  {
+    kinematics_.update_open_loop(dt);
+  }
+  else
+  {
+    // the handles aren't contiguous, the kinematics work on contiguous storage
+    auto & left_feedback = kinematics_.left_feedback();
+    auto & right_feedback = kinematics_.right_feedback();
+    for (size_t i = 0; i < num_robots; ++i)
+    {
+      left_feedback[i] = state_interfaces_[2 * i].get_value();
+      right_feedback[i] = state_interfaces_[2 * i + 1].get_value();
+    }
+    const size_t num_invalid = params_.position_feedback ? kinematics_.update_from_positions(dt)
+                                                         : kinematics_.update_from_velocities(dt);
+    if (num_invalid > 0)
+    {
+      // the other robots keep driving
+      RCLCPP_WARN_THROTTLE(
+        get_node()->get_logger(), *get_node()->get_clock(), 1000,
+        "The wheel feedback of %zu robots is invalid, their odometry is not updated", num_invalid);
+    }
+  }
+
+  const auto & left_commands = kinematics_.left_commands();
+  const auto & right_commands = kinematics_.right_commands();
+  for (size_t i = 0; i < num_robots; ++i)
+  {
+    command_interfaces_[2 * i].set_value(left_commands[i]);
+    command_interfaces_[2 * i + 1].set_value(right_commands[i]);
+  }
+
+  if (!publish_rate_->is_due(time))
+  {
+    return controller_interface::return_type::OK;
+  }
+
+  const auto & x = kinematics_.x();
+  const auto & y = kinematics_.y();
+  const auto & heading = kinematics_.heading();
+  const auto & linear = kinematics_.linear();
+  const auto & angular = kinematics_.angular();
+  if (realtime_batch_odometry_publisher_->trylock())
+  {
+    auto & data = realtime_batch_odometry_publisher_->msg_.data;
+    size_t index = 0;
+    for (const auto * field : {&x, &y, &heading, &linear, &angular})
+    {
+      std::copy(field->begin(), field->end(), data.begin() + static_cast<std::ptrdiff_t>(index));
+      index += num_robots;
+    }
+    realtime_batch_odometry_publisher_->unlockAndPublish();
+  }
+
+  for (size_t i = 0; i < realtime_odometry_publishers_.size(); ++i)
+  {
+    auto & publisher = realtime_odometry_publishers_[i];
+    if (publisher->trylock())
+    {
+      auto & odometry_message = publisher->msg_;
+      odometry_message.header.stamp = time;
+      odometry_message.pose.pose.position.x = x[i];
+      odometry_message.pose.pose.position.y = y[i];
+      // rotation about z only
+      odometry_message.pose.pose.orientation.z = std::sin(0.5 * heading[i]);
+      odometry_message.pose.pose.orientation.w = std::cos(0.5 * heading[i]);
+      odometry_message.twist.twist.linear.x = linear[i];
+      odometry_message.twist.twist.angular.z = angular[i];
+      publisher->unlockAndPublish();
+    }
+  }
+
+  if (params_.enable_odom_tf && realtime_odometry_transform_publisher_->trylock())
+  {
+    auto & transforms = realtime_odometry_transform_publisher_->msg_.transforms;
+    for (size_t i = 0; i < num_robots; ++i)
+    {
+      auto & transform = transforms[i];
+      transform.header.stamp = time;
+      transform.transform.translation.x = x[i];
+      transform.transform.translation.y = y[i];
+      transform.transform.rotation.z = std::sin(0.5 * heading[i]);
+      transform.transform.rotation.w = std::cos(0.5 * heading[i]);
+    }
+    realtime_odometry_transform_publisher_->unlockAndPublish();
+  }
+
+  return controller_interface::return_type::OK;
+}
+
+void BatchedDiffDriveController::write_commands(
+  const std::function<void(VelocityCommands &)> & modify)
+{
+  std::lock_guard<std::mutex> guard(commands_mutex_);
+  modify(received_commands_);
+  rt_commands_.writeFromNonRT(received_commands_);
+}
+
+controller_interface::CallbackReturn BatchedDiffDriveController::on_configure(
+  const rclcpp_lifecycle::State &)
+{
+  auto logger = get_node()->get_logger();
+
+  // update parameters if they have changed
+  if (param_listener_->is_old(params_))
+  {
+    params_ = param_listener_->get_params();
+    RCLCPP_INFO(logger, "Parameters were updated");
+  }
+
+  if (params_.robots.empty())
+  {
+    RCLCPP_ERROR(logger, "'robots' parameter was empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  if (params_.left_wheel_name.empty() || params_.right_wheel_name.empty())
+  {
+    RCLCPP_ERROR(logger, "Wheel names parameters are empty!");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  const size_t num_robots = params_.robots.size();
+  kinematics_.configure(
+    num_robots, params_.wheel_separation_multiplier * params_.wheel_separation,
+    params_.left_wheel_radius_multiplier * params_.wheel_radius,
+    params_.right_wheel_radius_multiplier * params_.wheel_radius);
+  kinematics_.set_velocity_limits(
+    velocity_limit(params_.linear.x.max_velocity), velocity_limit(params_.angular.z.max_velocity));
+  cmd_vel_timeout_nanoseconds_ = static_cast<int64_t>(params_.cmd_vel_timeout * 1e9);
+
+  reset();
+
+  // the subscribers only accept commands while the controller is active
+  const auto ignore_inactive = [this]()
+  {
+    if (!subscriber_is_active_)
+    {
+      RCLCPP_WARN_THROTTLE(
+        get_node()->get_logger(), *get_node()->get_clock(), 1000,
+        "Can't accept new commands. subscriber is inactive");
+      return true;
+    }
+    return false;
+  };
+
+  batch_command_subscriber_ = get_node()->create_subscription<BatchMsg>(
+    DEFAULT_BATCH_COMMAND_TOPIC, rclcpp::SystemDefaultsQoS(),
+    [this, num_robots, ignore_inactive](const std::shared_ptr<BatchMsg> msg)
+    {
+      if (ignore_inactive())
+      {
+        return;
+      }
+      if (msg->data.size() != 2 * num_robots)
+      {
+        RCLCPP_ERROR_THROTTLE(
+          get_node()->get_logger(), *get_node()->get_clock(), 1000,
+          "command size (%zu) does not match twice the number of robots (%zu), ignoring it",
+          msg->data.size(), num_robots);
+        return;
+      }
+      const int64_t stamp = update_time_.now(*get_node()->get_clock()).nanoseconds();
+      write_commands(
+        [&msg, num_robots, stamp](VelocityCommands & commands)
+        {
+          const auto middle = msg->data.begin() + static_cast<std::ptrdiff_t>(num_robots);
+          std::copy(msg->data.begin(), middle, commands.linear.begin());
+          std::copy(middle, msg->data.end(), commands.angular.begin());
+          std::fill(commands.stamps_nanoseconds.begin(), commands.stamps_nanoseconds.end(), stamp);
+        });
+    });
+
+  const auto pool = publisher_pool::get_shared_pool(params_.publisher_pool);
+  batch_odometry_publisher_ = get_node()->create_publisher<BatchMsg>(
+    DEFAULT_BATCH_ODOMETRY_TOPIC, rclcpp::SystemDefaultsQoS());
+  realtime_batch_odometry_publisher_ =
+    std::make_shared<publisher_pool::RealtimePublisher<BatchMsg>>(batch_odometry_publisher_, pool);
+  auto & batch_message = realtime_batch_odometry_publisher_->msg_;
+  batch_message.layout.dim.resize(2);
+  batch_message.layout.dim[0].label = "field";
+  batch_message.layout.dim[0].size = static_cast<uint32_t>(NUM_ODOMETRY_FIELDS);
+  batch_message.layout.dim[0].stride = static_cast<uint32_t>(NUM_ODOMETRY_FIELDS * num_robots);
+  batch_message.layout.dim[1].label = "robot";
+  batch_message.layout.dim[1].size = static_cast<uint32_t>(num_robots);
+  batch_message.layout.dim[1].stride = static_cast<uint32_t>(num_robots);
+  batch_message.data.assign(NUM_ODOMETRY_FIELDS * num_robots, 0.0);
+
+  robot_command_subscribers_.clear();
+  odometry_publishers_.clear();
+  realtime_odometry_publishers_.clear();
+  const size_t num_robot_topics = params_.per_robot_topics ? num_robots : 0;
+  try
+  {
+    for (size_t i = 0; i < num_robot_topics; ++i)
+    {
+      const auto & robot = params_.robots[i];
+      robot_command_subscribers_.push_back(get_node()->create_subscription<Twist>(
+        "~/" + robot + "/cmd_vel", rclcpp::SystemDefaultsQoS(),
+        [this, i, ignore_inactive](const std::shared_ptr<Twist> msg)
+        {
+          if (ignore_inactive())
+          {
+            return;
+          }
+          if ((msg->header.stamp.sec == 0) && (msg->header.stamp.nanosec == 0))
+          {
+            RCLCPP_WARN_ONCE(
+              get_node()->get_logger(),
+              "Received TwistStamped with zero timestamp, setting it to current "
+              "time, this message will only be shown once");
+            msg->header.stamp = update_time_.now(*get_node()->get_clock());
+          }
+          write_commands(
+            [&msg, i](VelocityCommands & commands)
+            {
+              commands.linear[i] = msg->twist.linear.x;
+              commands.angular[i] = msg->twist.angular.z;
+              commands.stamps_nanoseconds[i] = rclcpp::Time(msg->header.stamp).nanoseconds();
+            });
+        }));
+
+      odometry_publishers_.push_back(get_node()->create_publisher<nav_msgs::msg::Odometry>(
+        "~/" + robot + "/odom", rclcpp::SystemDefaultsQoS()));
+      realtime_odometry_publishers_.push_back(
+        std::make_shared<publisher_pool::RealtimePublisher<nav_msgs::msg::Odometry>>(
+          odometry_publishers_.back(), pool));
+      auto & odometry_message = realtime_odometry_publishers_.back()->msg_;
+      odometry_message.header.frame_id = robot + "/" + params_.odom_frame_id;
+      odometry_message.child_frame_id = robot + "/" + params_.base_frame_id;
+      odometry_message.pose.pose.orientation.w = 1.0;
+    }
+  }
+  catch (const std::exception & e)
+  {
+    RCLCPP_ERROR(logger, "Can't create the topics of every robot: %s", e.what());
+    robot_command_subscribers_.clear();
+    odometry_publishers_.clear();
+    realtime_odometry_publishers_.clear();
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  // the transforms of all robots are published in one message
+  odometry_transform_publisher_ = get_node()->create_publisher<tf2_msgs::msg::TFMessage>(
+    DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
+  realtime_odometry_transform_publisher_ =
+    std::make_shared<publisher_pool::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
+      odometry_transform_publisher_, pool);
+  auto & transforms = realtime_odometry_transform_publisher_->msg_.transforms;
+  transforms.resize(num_robots);
+  for (size_t i = 0; i < num_robots; ++i)
+  {
+    transforms[i].header.frame_id = params_.robots[i] + "/" + params_.odom_frame_id;
+    transforms[i].child_frame_id = params_.robots[i] + "/" + params_.base_frame_id;
+    transforms[i].transform.rotation.w = 1.0;
+  }
+
+  // the rate of the batch applies to the odometry of the single robots and the transforms as well
+  publish_rate_ = telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+    get_node()->get_namespace(), batch_odometry_publisher_->get_topic_name(), params_.publish_rate);
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn BatchedDiffDriveController::on_activate(
+  const rclcpp_lifecycle::State &)
+{
+  // update() indexes the interfaces, robot after robot with the left before the right wheel
+  const auto joint_names = wheel_joint_names();
+  const bool has_feedback = !params_.open_loop;
+  if (
+    command_interfaces_.size() != joint_names.size() ||
+    (has_feedback && state_interfaces_.size() != joint_names.size()))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Expected %zu command and state interfaces, got %zu and %zu",
+      joint_names.size(), command_interfaces_.size(), state_interfaces_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  for (size_t i = 0; i < joint_names.size(); ++i)
+  {
+    if (
+      command_interfaces_[i].get_prefix_name() != joint_names[i] ||
+      (has_feedback && state_interfaces_[i].get_prefix_name() != joint_names[i]))
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Unable to obtain the wheel handles of joint %s in order",
+        joint_names[i].c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+
+  reset_commands();
+  is_halted_ = false;
+  update_time_.reset();
+  subscriber_is_active_ = true;
+
+  RCLCPP_DEBUG(get_node()->get_logger(), "Subscriber and publisher are now active.");
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn BatchedDiffDriveController::on_deactivate(
+  const rclcpp_lifecycle::State &)
+{
+  subscriber_is_active_ = false;
+  if (!is_halted_)
+  {
+    halt();
+    is_halted_ = true;
+  }
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn BatchedDiffDriveController::on_cleanup(
+  const rclcpp_lifecycle::State &)
+{
+  reset();
+  batch_command_subscriber_.reset();
+  robot_command_subscribers_.clear();
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn BatchedDiffDriveController::on_error(
+  const rclcpp_lifecycle::State &)
+{
+  reset();
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+void BatchedDiffDriveController::reset()
+{
+  kinematics_.reset();
+  reset_commands();
+  subscriber_is_active_ = false;
+  is_halted_ = false;
+}
+
+void BatchedDiffDriveController::reset_commands()
+{
+  // commands received before the activation are dropped
+  std::lock_guard<std::mutex> guard(commands_mutex_);
+  const size_t num_robots = kinematics_.size();
+  received_commands_.linear.assign(num_robots, 0.0);
+  received_commands_.angular.assign(num_robots, 0.0);
+  received_commands_.stamps_nanoseconds.assign(num_robots, -1);
+  // both buffers are sized for all robots, whichever update() reads first
+  rt_commands_ = realtime_tools::RealtimeBuffer<VelocityCommands>(received_commands_);
+}
+
+void BatchedDiffDriveController::halt()
+{
+  for (auto & command_interface : command_interfaces_)
+  {
+    command_interface.set_value(0.0);
+  }
+}
+}  // namespace diff_drive_controller
+
+#include "class_loader/register_macro.hpp"
+
+CLASS_LOADER_REGISTER_CLASS(
+  diff_drive_controller::BatchedDiffDriveController, controller_interface::ControllerInterface)
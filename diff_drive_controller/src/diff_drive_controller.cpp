@@ -16,15 +16,26 @@
  * Author: Bence Magyar, Enrique Fernández, Manuel Meraz
  */
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <memory>
-#include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "controller_tracetools/tracetools.hpp"
 #include "diff_drive_controller/diff_drive_controller.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "interface_values/copy_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
+#include "motion_limits/speed_limits.hpp"
+#include "object_pool/message_memory_strategy.hpp"
+#include "publisher_pool/publisher_qos.hpp"
 #include "rclcpp/logging.hpp"
 #include "tf2/LinearMath/Quaternion.h"
 
@@ -32,8 +43,34 @@ namespace
 {
 constexpr auto DEFAULT_COMMAND_TOPIC = "~/cmd_vel";
 constexpr auto DEFAULT_COMMAND_OUT_TOPIC = "~/cmd_vel_out";
+constexpr auto DEFAULT_COMMAND_PREVIEW_TOPIC = "~/cmd_vel_preview";
 constexpr auto DEFAULT_ODOMETRY_TOPIC = "~/odom";
 constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
+// rows and columns of x, y and yaw in the pose covariance, of vx and wz in the twist covariance
+constexpr std::array<size_t, 3> PLANAR_INDICES = {0, 1, 5};
+constexpr std::array<size_t, 2> TWIST_INDICES = {0, 5};
+
+/// Radii of the single wheels of one side, corrected by the optional multiplier of each wheel
+bool get_wheel_radii(
+  const rclcpp::Logger & logger, const std::string & side,
+  const std::vector<std::string> & wheel_names, const std::vector<double> & multipliers,
+  const double side_radius, std::vector<double> & radii)
+{
+  if (!multipliers.empty() && multipliers.size() != wheel_names.size())
+  {
+    RCLCPP_ERROR(
+      logger,
+      "The number of %s wheel radius multipliers [%zu] and of %s wheels [%zu] are different",
+      side.c_str(), multipliers.size(), side.c_str(), wheel_names.size());
+    return false;
+  }
+  radii.assign(wheel_names.size(), side_radius);
+  for (size_t index = 0; index < multipliers.size(); ++index)
+  {
+    radii[index] *= multipliers[index];
+  }
+  return true;
+}
 }  // namespace
 
 namespace diff_drive_controller
@@ -59,6 +96,7 @@ controller_interface::CallbackReturn DiffDriveController::on_init()
     // Create the parameter listener and get the parameters
     param_listener_ = std::make_shared<ParamListener>(get_node());
     params_ = param_listener_->get_params();
+    rt_logger_ = std::make_unique<realtime_logging::RealtimeLogger>(get_node()->get_logger());
   }
   catch (const std::exception & e)
   {
@@ -66,6 +104,9 @@ controller_interface::CallbackReturn DiffDriveController::on_init()
     return controller_interface::CallbackReturn::ERROR;
   }
 
+  // linear and angular velocity, sized once as the exported interfaces point to them
+  reference_interfaces_.assign(2, std::numeric_limits<double>::quiet_NaN());
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -94,14 +135,67 @@ InterfaceConfiguration DiffDriveController::state_interface_configuration() cons
   {
     conf_names.push_back(joint_name + "/" + feedback_type());
   }
+  if (!params_.hardware_timestamp_interface.empty())
+  {
+    for (const auto & joint_name : params_.left_wheel_names)
+    {
+      conf_names.push_back(joint_name + "/" + params_.hardware_timestamp_interface);
+    }
+    for (const auto & joint_name : params_.right_wheel_names)
+    {
+      conf_names.push_back(joint_name + "/" + params_.hardware_timestamp_interface);
+    }
+  }
   return {interface_configuration_type::INDIVIDUAL, conf_names};
 }
 
-controller_interface::return_type DiffDriveController::update(
+std::vector<hardware_interface::CommandInterface>
+DiffDriveController::on_export_reference_interfaces()
+{
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.reserve(reference_interfaces_.size());
+  reference_interfaces.push_back(hardware_interface::CommandInterface(
+    get_node()->get_name(), std::string("linear/") + hardware_interface::HW_IF_VELOCITY,
+    &reference_interfaces_[0]));
+  reference_interfaces.push_back(hardware_interface::CommandInterface(
+    get_node()->get_name(), std::string("angular/") + hardware_interface::HW_IF_VELOCITY,
+    &reference_interfaces_[1]));
+  return reference_interfaces;
+}
+
+bool DiffDriveController::on_set_chained_mode(bool /*chained_mode*/)
+{
+  // the references are written by the preceding controller, or from the cmd_vel topic
+  return true;
+}
+
+controller_interface::return_type DiffDriveController::update_reference_from_subscribers(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+{
+  received_velocity_command_.try_read(last_velocity_command_);
+
+  const auto age_of_last_command =
+    time - rclcpp::Time(last_velocity_command_.stamp_nanoseconds, RCL_ROS_TIME);
+  // Brake if cmd_vel has timeout
+  if (age_of_last_command > cmd_vel_timeout_)
+  {
+    reference_interfaces_[0] = 0.0;
+    reference_interfaces_[1] = 0.0;
+  }
+  else
+  {
+    reference_interfaces_[0] = last_velocity_command_.linear;
+    reference_interfaces_[1] = last_velocity_command_.angular;
+  }
+  return controller_interface::return_type::OK;
+}
+
+controller_interface::return_type DiffDriveController::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  auto logger = get_node()->get_logger();
-  if (get_state().id() == State::PRIMARY_STATE_INACTIVE)
+  update_time_.set(time);
+  // the flag follows on_activate() and on_deactivate(), reading the lifecycle state would lock it
+  if (!subscriber_is_active_)
   {
     if (!is_halted)
     {
@@ -111,156 +205,243 @@ controller_interface::return_type DiffDriveController::update(
     return controller_interface::return_type::OK;
   }
 
-  std::shared_ptr<Twist> last_command_msg;
-  received_velocity_msg_ptr_.get(last_command_msg);
-
-  if (last_command_msg == nullptr)
-  {
-    RCLCPP_WARN(logger, "Velocity message received was a nullptr.");
-    return controller_interface::return_type::ERROR;
-  }
-
-  const auto age_of_last_command = time - last_command_msg->header.stamp;
-  // Brake if cmd_vel has timeout, override the stored command
-  if (age_of_last_command > cmd_vel_timeout_)
+  // command may be limited further by SpeedLimit,
+  // without affecting the references
+  double linear_command = reference_interfaces_[0];
+  double angular_command = reference_interfaces_[1];
+  if (std::isnan(linear_command) || std::isnan(angular_command))
   {
-    last_command_msg->twist.linear.x = 0.0;
-    last_command_msg->twist.angular.z = 0.0;
+    // no reference from the preceding controller yet
+    linear_command = 0.0;
+    angular_command = 0.0;
   }
 
-  // command may be limited further by SpeedLimit,
-  // without affecting the stored twist command
-  Twist command = *last_command_msg;
-  double & linear_command = command.twist.linear.x;
-  double & angular_command = command.twist.angular.z;
-
   previous_update_timestamp_ = time;
 
-  // Apply (possibly new) multipliers:
-  const double wheel_separation = params_.wheel_separation_multiplier * params_.wheel_separation;
-  const double left_wheel_radius = params_.left_wheel_radius_multiplier * params_.wheel_radius;
-  const double right_wheel_radius = params_.right_wheel_radius_multiplier * params_.wheel_radius;
+  // time at which the feedback was measured, the pose of the odometry is the one at this time
+  rclcpp::Time measurement_time = time;
+  double measurement_period = period.seconds();
+  bool is_first_measurement = false;
+  if (!params_.open_loop && !params_.hardware_timestamp_interface.empty())
+  {
+    double stamp = 0.0;
+    for (const auto & handles : {&registered_left_wheel_handles_, &registered_right_wheel_handles_})
+    {
+      for (const auto & handle : *handles)
+      {
+        stamp += handle.timestamp->get_value();
+      }
+    }
+    stamp /= static_cast<double>(wheel_kinematics_.size());
+    if (std::isfinite(stamp))
+    {
+      measurement_time =
+        rclcpp::Time(static_cast<int64_t>(std::llround(stamp * 1e9)), time.get_clock_type());
+      is_first_measurement = std::isnan(previous_hardware_stamp_);
+      measurement_period = stamp - previous_hardware_stamp_;
+      previous_hardware_stamp_ = stamp;
+    }
+  }
 
+  CONTROLLER_TRACEPOINT(stage_begin, this, "integrate_odometry");
   if (params_.open_loop)
   {
     odometry_.updateOpenLoop(linear_command, angular_command, time);
   }
-  else
+  else if (is_first_measurement)
+  {
+    // the hardware clock may have another origin than the update time
+    odometry_.init(measurement_time);
+  }
+  else if (measurement_period > 0.0)
   {
-    double left_feedback_mean = 0.0;
-    double right_feedback_mean = 0.0;
-    for (size_t index = 0; index < static_cast<size_t>(params_.wheels_per_side); ++index)
+    // gather the feedback of all wheels, the kinematics work on contiguous storage
+    auto & feedback = wheel_kinematics_.feedback();
+    const auto feedback_value = [](const WheelHandle & handle)
+    { return handle.feedback.get().get_value(); };
+    const auto left_nan = interface_values::copy_values(
+      registered_left_wheel_handles_.cbegin(), registered_left_wheel_handles_.cend(),
+      feedback.begin(), feedback_value);
+    const auto right_nan = interface_values::copy_values(
+      registered_right_wheel_handles_.cbegin(), registered_right_wheel_handles_.cend(),
+      feedback.begin() + static_cast<std::ptrdiff_t>(registered_left_wheel_handles_.size()),
+      feedback_value);
+
+    if (left_nan != 0 || right_nan != 0)
     {
-      const double left_feedback = registered_left_wheel_handles_[index].feedback.get().get_value();
-      const double right_feedback =
-        registered_right_wheel_handles_[index].feedback.get().get_value();
-
-      if (std::isnan(left_feedback) || std::isnan(right_feedback))
-      {
-        RCLCPP_ERROR(
-          logger, "Either the left or right wheel %s is invalid for index [%zu]", feedback_type(),
-          index);
-        return controller_interface::return_type::ERROR;
-      }
-
-      left_feedback_mean += left_feedback;
-      right_feedback_mean += right_feedback;
+      const bool left_is_invalid = left_nan != 0;
+      rt_logger_->error(
+        "The %s wheel %s is invalid for index [%zu]", left_is_invalid ? "left" : "right",
+        feedback_type(), interface_values::first_nan(left_is_invalid ? left_nan : right_nan));
+      CONTROLLER_TRACEPOINT(stage_end, this, "integrate_odometry");
+      return controller_interface::return_type::ERROR;
+    }
+    double linear_feedback = 0.0;
+    double angular_feedback = 0.0;
+    if (!wheel_kinematics_.fit(linear_feedback, angular_feedback))
+    {
+      // feedback without NaN may still sum up to NaN, e.g., infinite values of both signs
+      rt_logger_->error("The wheel %s doesn't give a valid motion of the body", feedback_type());
+      CONTROLLER_TRACEPOINT(stage_end, this, "integrate_odometry");
+      return controller_interface::return_type::ERROR;
     }
-    left_feedback_mean /= static_cast<double>(params_.wheels_per_side);
-    right_feedback_mean /= static_cast<double>(params_.wheels_per_side);
 
+    double left_feedback = 0.0;
+    double right_feedback = 0.0;
+    wheel_kinematics_.side_motion(linear_feedback, angular_feedback, left_feedback, right_feedback);
     if (params_.position_feedback)
     {
-      odometry_.update(left_feedback_mean, right_feedback_mean, time);
+      // odometry expects the positions of wheels with the nominal radius of each side
+      odometry_.update(
+        left_feedback / (params_.left_wheel_radius_multiplier * params_.wheel_radius),
+        right_feedback / (params_.right_wheel_radius_multiplier * params_.wheel_radius),
+        measurement_time);
     }
     else
     {
       odometry_.updateFromVelocity(
-        left_feedback_mean * left_wheel_radius * period.seconds(),
-        right_feedback_mean * right_wheel_radius * period.seconds(), time);
+        left_feedback * measurement_period, right_feedback * measurement_period, measurement_time);
     }
   }
 
-  tf2::Quaternion orientation;
-  orientation.setRPY(0.0, 0.0, odometry_.getHeading());
+  CONTROLLER_TRACEPOINT(stage_end, this, "integrate_odometry");
 
-  bool should_publish = false;
-  try
+  // pose at the update time, which is the time stamp of the published messages
+  double odometry_x = odometry_.getX();
+  double odometry_y = odometry_.getY();
+  double odometry_heading = odometry_.getHeading();
+  if (params_.extrapolate_odometry_to_update_time)
   {
-    if (previous_publish_timestamp_ + publish_period_ < time)
-    {
-      previous_publish_timestamp_ += publish_period_;
-      should_publish = true;
-    }
+    odometry_.getExtrapolatedPose(
+      (time - measurement_time).seconds(), odometry_x, odometry_y, odometry_heading);
+  }
+  if (odometry_slot_)
+  {
+    // readers in the same cycle get the odometry of this update
+    odometry_slot_->write(
+      {time.nanoseconds(), odometry_x, odometry_y, odometry_heading, odometry_.getLinear(), 0.0,
+       odometry_.getAngular()});
   }
-  catch (const std::runtime_error &)
+  if (odometry_snapshot_writer_)
   {
-    // Handle exceptions when the time source changes and initialize publish timestamp
-    previous_publish_timestamp_ = time;
-    should_publish = true;
+    // the pose at the measurement time belongs to the last wheel positions
+    odometry_persistence::OdometrySnapshot snapshot;
+    snapshot.stamp_nanoseconds = time.nanoseconds();
+    snapshot.x = odometry_.getX();
+    snapshot.y = odometry_.getY();
+    snapshot.heading = odometry_.getHeading();
+    snapshot.linear = odometry_.getLinear();
+    snapshot.angular = odometry_.getAngular();
+    snapshot.num_wheels = 2;
+    snapshot.wheel_positions[0] = odometry_.getLeftWheelPosition();
+    snapshot.wheel_positions[1] = odometry_.getRightWheelPosition();
+    odometry_snapshot_writer_->update(snapshot);
   }
 
+  tf2::Quaternion orientation;
+  orientation.setRPY(0.0, 0.0, odometry_heading);
+
+  const bool should_publish = publish_rate_->is_due(time);
+
   if (should_publish)
   {
+    CONTROLLER_TRACEPOINT(stage_begin, this, "publish_odometry");
     if (realtime_odometry_publisher_->trylock())
     {
       auto & odometry_message = realtime_odometry_publisher_->msg_;
       odometry_message.header.stamp = time;
-      odometry_message.pose.pose.position.x = odometry_.getX();
-      odometry_message.pose.pose.position.y = odometry_.getY();
+      odometry_message.pose.pose.position.x = odometry_x;
+      odometry_message.pose.pose.position.y = odometry_y;
       odometry_message.pose.pose.orientation.x = orientation.x();
       odometry_message.pose.pose.orientation.y = orientation.y();
       odometry_message.pose.pose.orientation.z = orientation.z();
       odometry_message.pose.pose.orientation.w = orientation.w();
       odometry_message.twist.twist.linear.x = odometry_.getLinear();
       odometry_message.twist.twist.angular.z = odometry_.getAngular();
+      if (params_.wheel_travel_variance > 0.0)
+      {
+        // propagated covariance on top of the configured diagonal, written in place
+        const auto & pose_covariance = odometry_.getPoseCovariance();
+        const auto & twist_covariance = odometry_.getTwistCovariance();
+        for (size_t row = 0; row < PLANAR_INDICES.size(); ++row)
+        {
+          for (size_t col = 0; col < PLANAR_INDICES.size(); ++col)
+          {
+            const size_t index = 6 * PLANAR_INDICES[row] + PLANAR_INDICES[col];
+            odometry_message.pose.covariance[index] =
+              pose_covariance[3 * row + col] +
+              (row == col ? params_.pose_covariance_diagonal[PLANAR_INDICES[row]] : 0.0);
+          }
+        }
+        for (size_t row = 0; row < TWIST_INDICES.size(); ++row)
+        {
+          for (size_t col = 0; col < TWIST_INDICES.size(); ++col)
+          {
+            const size_t index = 6 * TWIST_INDICES[row] + TWIST_INDICES[col];
+            odometry_message.twist.covariance[index] =
+              twist_covariance[2 * row + col] +
+              (row == col ? params_.twist_covariance_diagonal[TWIST_INDICES[row]] : 0.0);
+          }
+        }
+      }
       realtime_odometry_publisher_->unlockAndPublish();
     }
 
-    if (params_.enable_odom_tf && realtime_odometry_transform_publisher_->trylock())
+    if (odometry_transform_slot_)
+    {
+      odometry_transform_slot_->set(time, odometry_x, odometry_y, odometry_heading);
+    }
+    else if (params_.enable_odom_tf && realtime_odometry_transform_publisher_->trylock())
     {
       auto & transform = realtime_odometry_transform_publisher_->msg_.transforms.front();
       transform.header.stamp = time;
-      transform.transform.translation.x = odometry_.getX();
-      transform.transform.translation.y = odometry_.getY();
+      transform.transform.translation.x = odometry_x;
+      transform.transform.translation.y = odometry_y;
       transform.transform.rotation.x = orientation.x();
       transform.transform.rotation.y = orientation.y();
       transform.transform.rotation.z = orientation.z();
       transform.transform.rotation.w = orientation.w();
       realtime_odometry_transform_publisher_->unlockAndPublish();
     }
+    CONTROLLER_TRACEPOINT(stage_end, this, "publish_odometry");
   }
 
-  auto & last_command = previous_commands_.back().twist;
-  auto & second_to_last_command = previous_commands_.front().twist;
-  limiter_linear_.limit(
-    linear_command, last_command.linear.x, second_to_last_command.linear.x, period.seconds());
-  limiter_angular_.limit(
-    angular_command, last_command.angular.z, second_to_last_command.angular.z, period.seconds());
+  VelocityCommand limited_command{linear_command, angular_command};
+  if (velocity_preview_subscriber_)
+  {
+    limit_to_velocity_preview(limited_command, time);
+  }
+  limiter_.limit(
+    limited_command, previous_commands_[last_command_index_],
+    previous_commands_[1 - last_command_index_], period.seconds());
+  linear_command = limited_command[0];
+  angular_command = limited_command[1];
 
-  previous_commands_.pop();
-  previous_commands_.emplace(command);
+  // the new command replaces the second to last one
+  last_command_index_ = 1 - last_command_index_;
+  previous_commands_[last_command_index_] = limited_command;
 
   //    Publish limited velocity
   if (publish_limited_velocity_ && realtime_limited_velocity_publisher_->trylock())
   {
     auto & limited_velocity_command = realtime_limited_velocity_publisher_->msg_;
     limited_velocity_command.header.stamp = time;
-    limited_velocity_command.twist = command.twist;
+    limited_velocity_command.twist.linear.x = linear_command;
+    limited_velocity_command.twist.angular.z = angular_command;
     realtime_limited_velocity_publisher_->unlockAndPublish();
   }
 
-  // Compute wheels velocities:
-  const double velocity_left =
-    (linear_command - angular_command * wheel_separation / 2.0) / left_wheel_radius;
-  const double velocity_right =
-    (linear_command + angular_command * wheel_separation / 2.0) / right_wheel_radius;
-
-  // Set wheels velocities:
-  for (size_t index = 0; index < static_cast<size_t>(params_.wheels_per_side); ++index)
+  // Compute and set wheels velocities:
+  wheel_kinematics_.compute_commands(linear_command, angular_command);
+  const auto & commands = wheel_kinematics_.commands();
+  const size_t num_left = registered_left_wheel_handles_.size();
+  for (size_t index = 0; index < num_left; ++index)
+  {
+    registered_left_wheel_handles_[index].velocity.get().set_value(commands[index]);
+  }
+  for (size_t index = 0; index < registered_right_wheel_handles_.size(); ++index)
   {
-    registered_left_wheel_handles_[index].velocity.get().set_value(velocity_left);
-    registered_right_wheel_handles_[index].velocity.get().set_value(velocity_right);
+    registered_right_wheel_handles_[index].velocity.get().set_value(commands[num_left + index]);
   }
 
   return controller_interface::return_type::OK;
@@ -277,6 +458,8 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
     params_ = param_listener_->get_params();
     RCLCPP_INFO(logger, "Parameters were updated");
   }
+  // names the handle of the tracepoints of the updates
+  CONTROLLER_TRACEPOINT(controller_init, this, get_node()->get_name());
 
   if (params_.left_wheel_names.size() != params_.right_wheel_names.size())
   {
@@ -297,22 +480,45 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
   const double right_wheel_radius = params_.right_wheel_radius_multiplier * params_.wheel_radius;
 
   odometry_.setWheelParams(wheel_separation, left_wheel_radius, right_wheel_radius);
+
+  std::vector<double> left_wheel_radii;
+  std::vector<double> right_wheel_radii;
+  if (
+    !get_wheel_radii(
+      logger, "left", params_.left_wheel_names, params_.left_wheel_radius_multipliers,
+      left_wheel_radius, left_wheel_radii) ||
+    !get_wheel_radii(
+      logger, "right", params_.right_wheel_names, params_.right_wheel_radius_multipliers,
+      right_wheel_radius, right_wheel_radii))
+  {
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  wheel_kinematics_.configure(left_wheel_radii, right_wheel_radii, wheel_separation);
   odometry_.setVelocityRollingWindowSize(params_.velocity_rolling_window_size);
+  odometry_.setWheelTravelVariance(params_.wheel_travel_variance);
+  odometry_.setIntegrationSubsteps(static_cast<unsigned int>(params_.integration_substeps));
+  odometry_.setVelocityEstimator(
+    params_.velocity_estimator.type == "alpha_beta" ? Odometry::VelocityEstimator::ALPHA_BETA
+                                                    : Odometry::VelocityEstimator::ROLLING_MEAN,
+    params_.velocity_estimator.alpha, params_.velocity_estimator.beta);
 
   cmd_vel_timeout_ = std::chrono::milliseconds{static_cast<int>(params_.cmd_vel_timeout * 1000.0)};
   publish_limited_velocity_ = params_.publish_limited_velocity;
 
-  limiter_linear_ = SpeedLimiter(
-    params_.linear.x.has_velocity_limits, params_.linear.x.has_acceleration_limits,
-    params_.linear.x.has_jerk_limits, params_.linear.x.min_velocity, params_.linear.x.max_velocity,
-    params_.linear.x.min_acceleration, params_.linear.x.max_acceleration, params_.linear.x.min_jerk,
-    params_.linear.x.max_jerk);
-
-  limiter_angular_ = SpeedLimiter(
-    params_.angular.z.has_velocity_limits, params_.angular.z.has_acceleration_limits,
-    params_.angular.z.has_jerk_limits, params_.angular.z.min_velocity,
-    params_.angular.z.max_velocity, params_.angular.z.min_acceleration,
-    params_.angular.z.max_acceleration, params_.angular.z.min_jerk, params_.angular.z.max_jerk);
+  limiter_ = VelocityLimiter();
+  limiter_.set_limits(
+    0, motion_limits::make_speed_limits(
+         params_.linear.x.has_velocity_limits, params_.linear.x.has_acceleration_limits,
+         params_.linear.x.has_jerk_limits, params_.linear.x.min_velocity,
+         params_.linear.x.max_velocity, params_.linear.x.min_acceleration,
+         params_.linear.x.max_acceleration, params_.linear.x.min_jerk, params_.linear.x.max_jerk));
+  limiter_.set_limits(
+    1, motion_limits::make_speed_limits(
+         params_.angular.z.has_velocity_limits, params_.angular.z.has_acceleration_limits,
+         params_.angular.z.has_jerk_limits, params_.angular.z.min_velocity,
+         params_.angular.z.max_velocity, params_.angular.z.min_acceleration,
+         params_.angular.z.max_acceleration, params_.angular.z.min_jerk,
+         params_.angular.z.max_jerk));
 
   if (!reset())
   {
@@ -322,20 +528,17 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
   // left and right sides are both equal at this point
   params_.wheels_per_side = params_.left_wheel_names.size();
 
+  const auto pool = publisher_pool::get_shared_pool(params_.publisher_pool);
+  const auto queue_depth = static_cast<size_t>(params_.publisher_pool.queue_depth);
   if (publish_limited_velocity_)
   {
     limited_velocity_publisher_ =
       get_node()->create_publisher<Twist>(DEFAULT_COMMAND_OUT_TOPIC, rclcpp::SystemDefaultsQoS());
     realtime_limited_velocity_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<Twist>>(limited_velocity_publisher_);
+      std::make_shared<publisher_pool::RealtimePublisher<Twist>>(limited_velocity_publisher_, pool);
   }
 
-  const Twist empty_twist;
-  received_velocity_msg_ptr_.set(std::make_shared<Twist>(empty_twist));
-
-  // Fill last two commands with default constructed commands
-  previous_commands_.emplace(empty_twist);
-  previous_commands_.emplace(empty_twist);
+  received_velocity_command_.write(StampedVelocityCommand());
 
   // initialize command subscriber
   velocity_command_subscriber_ = get_node()->create_subscription<Twist>(
@@ -353,17 +556,62 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
           get_node()->get_logger(),
           "Received TwistStamped with zero timestamp, setting it to current "
           "time, this message will only be shown once");
-        msg->header.stamp = get_node()->get_clock()->now();
+        msg->header.stamp = update_time_.now(*get_node()->get_clock());
       }
-      received_velocity_msg_ptr_.set(std::move(msg));
-    });
+      received_velocity_command_.write(
+        {rclcpp::Time(msg->header.stamp).nanoseconds(), msg->twist.linear.x,
+         msg->twist.angular.z});
+    },
+    rclcpp::SubscriptionOptions(),
+    std::make_shared<object_pool::PoolMessageMemoryStrategy<Twist>>());
+
+  received_velocity_preview_.write(VelocityPreview());
+  velocity_preview_subscriber_.reset();
+  if (params_.enable_velocity_preview)
+  {
+    velocity_preview_subscriber_ = get_node()->create_subscription<VelocityPreviewMsg>(
+      DEFAULT_COMMAND_PREVIEW_TOPIC, rclcpp::SystemDefaultsQoS(),
+      [this](const std::shared_ptr<VelocityPreviewMsg> msg) -> void
+      {
+        if (!subscriber_is_active_)
+        {
+          return;
+        }
+        // the points are planned from the time of the message
+        rclcpp::Time start = msg->header.stamp;
+        if (start.nanoseconds() == 0)
+        {
+          start = update_time_.now(*get_node()->get_clock());
+        }
+        VelocityPreview preview;
+        for (const auto & point : msg->points)
+        {
+          if (preview.num_points == MAX_PREVIEW_POINTS)
+          {
+            RCLCPP_WARN_ONCE(
+              get_node()->get_logger(),
+              "Velocity preview has more than %zu points, the later ones are ignored",
+              MAX_PREVIEW_POINTS);
+            break;
+          }
+          if (point.velocities.empty())
+          {
+            continue;
+          }
+          preview.points[preview.num_points++] = {
+            (start + rclcpp::Duration(point.time_from_start)).nanoseconds(),
+            point.velocities.front().linear.x, point.velocities.front().angular.z};
+        }
+        received_velocity_preview_.write(preview);
+      });
+  }
 
   // initialize odometry publisher and messasge
   odometry_publisher_ = get_node()->create_publisher<nav_msgs::msg::Odometry>(
-    DEFAULT_ODOMETRY_TOPIC, rclcpp::SystemDefaultsQoS());
+    DEFAULT_ODOMETRY_TOPIC, publisher_pool::make_qos(params_.qos.odom));
   realtime_odometry_publisher_ =
-    std::make_shared<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(
-      odometry_publisher_);
+    std::make_shared<publisher_pool::RealtimePublisher<nav_msgs::msg::Odometry>>(
+      odometry_publisher_, pool, false, queue_depth);
 
   // Append the tf prefix if there is one
   std::string tf_prefix = "";
@@ -391,13 +639,15 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
   const auto odom_frame_id = tf_prefix + params_.odom_frame_id;
   const auto base_frame_id = tf_prefix + params_.base_frame_id;
 
+  // unlocking initializes the queue of the publisher with the message, if there is one
+  realtime_odometry_publisher_->lock();
   auto & odometry_message = realtime_odometry_publisher_->msg_;
   odometry_message.header.frame_id = odom_frame_id;
   odometry_message.child_frame_id = base_frame_id;
 
   // limit the publication on the topics /odom and /tf
-  publish_rate_ = params_.publish_rate;
-  publish_period_ = rclcpp::Duration::from_seconds(1.0 / publish_rate_);
+  publish_rate_ = telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+    get_node()->get_namespace(), odometry_publisher_->get_topic_name(), params_.publish_rate);
 
   // initialize odom values zeros
   odometry_message.twist =
@@ -411,19 +661,55 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
     odometry_message.pose.covariance[diagonal_index] = params_.pose_covariance_diagonal[index];
     odometry_message.twist.covariance[diagonal_index] = params_.twist_covariance_diagonal[index];
   }
+  realtime_odometry_publisher_->unlock();
 
   // initialize transform publisher and message
   odometry_transform_publisher_ = get_node()->create_publisher<tf2_msgs::msg::TFMessage>(
-    DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
+    DEFAULT_TRANSFORM_TOPIC, publisher_pool::make_qos(params_.qos.tf));
   realtime_odometry_transform_publisher_ =
-    std::make_shared<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
-      odometry_transform_publisher_);
+    std::make_shared<publisher_pool::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
+      odometry_transform_publisher_, pool, false, queue_depth);
 
   // keeping track of odom and base_link transforms only
+  realtime_odometry_transform_publisher_->lock();
   auto & odometry_transform_message = realtime_odometry_transform_publisher_->msg_;
   odometry_transform_message.transforms.resize(1);
   odometry_transform_message.transforms.front().header.frame_id = odom_frame_id;
   odometry_transform_message.transforms.front().child_frame_id = base_frame_id;
+  realtime_odometry_transform_publisher_->unlock();
+
+  odometry_transform_slot_.reset();
+  if (params_.enable_odom_tf && params_.aggregate_odom_tf)
+  {
+    odometry_transform_slot_ =
+      tf_aggregator::TransformAggregator::get_instance()->register_transform(
+        get_node()->get_namespace(), odom_frame_id, base_frame_id);
+  }
+
+  odometry_slot_.reset();
+  if (params_.export_odometry)
+  {
+    odometry_slot_ = odometry_exchange::OdometryExchange::get_instance().get_slot(
+      get_node()->get_fully_qualified_name());
+  }
+
+  odometry_snapshot_writer_.reset();
+  if (params_.odometry_persistence.enable)
+  {
+    if (params_.odometry_persistence.path.empty())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "odometry_persistence.path has to be set if odometry_persistence.enable is set");
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    odometry_snapshot_writer_ = std::make_unique<odometry_persistence::SnapshotWriter>(
+      params_.odometry_persistence.path,
+      std::chrono::nanoseconds(
+        static_cast<int64_t>(params_.odometry_persistence.period * 1e9)),
+      [logger = get_node()->get_logger()](const std::string & error)
+      { RCLCPP_WARN(logger, "Failed to persist the odometry: %s", error.c_str()); });
+  }
 
   previous_update_timestamp_ = get_node()->get_clock()->now();
   return controller_interface::CallbackReturn::SUCCESS;
@@ -452,7 +738,17 @@ controller_interface::CallbackReturn DiffDriveController::on_activate(
     return controller_interface::CallbackReturn::ERROR;
   }
 
+  if (odometry_snapshot_writer_)
+  {
+    restore_odometry();
+  }
+
+  // stand still until the first reference of this activation
+  std::fill(
+    reference_interfaces_.begin(), reference_interfaces_.end(),
+    std::numeric_limits<double>::quiet_NaN());
   is_halted = false;
+  update_time_.reset();
   subscriber_is_active_ = true;
 
   RCLCPP_DEBUG(get_node()->get_logger(), "Subscriber and publisher are now active.");
@@ -470,6 +766,11 @@ controller_interface::CallbackReturn DiffDriveController::on_deactivate(
   }
   registered_left_wheel_handles_.clear();
   registered_right_wheel_handles_.clear();
+  if (odometry_snapshot_writer_)
+  {
+    // the next activation continues from the last update
+    odometry_snapshot_writer_->flush();
+  }
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -480,8 +781,10 @@ controller_interface::CallbackReturn DiffDriveController::on_cleanup(
   {
     return controller_interface::CallbackReturn::ERROR;
   }
+  odometry_transform_slot_.reset();
+  odometry_slot_.reset();
+  odometry_snapshot_writer_.reset();
 
-  received_velocity_msg_ptr_.set(std::make_shared<Twist>());
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -498,9 +801,9 @@ bool DiffDriveController::reset()
 {
   odometry_.resetOdometry();
 
-  // release the old queue
-  std::queue<Twist> empty;
-  std::swap(previous_commands_, empty);
+  previous_commands_.fill(VelocityCommand());
+  last_command_index_ = 0;
+  previous_hardware_stamp_ = std::numeric_limits<double>::quiet_NaN();
 
   registered_left_wheel_handles_.clear();
   registered_right_wheel_handles_.clear();
@@ -508,11 +811,80 @@ bool DiffDriveController::reset()
   subscriber_is_active_ = false;
   velocity_command_subscriber_.reset();
 
-  received_velocity_msg_ptr_.set(nullptr);
+  received_velocity_command_.write(StampedVelocityCommand());
+  last_velocity_command_ = StampedVelocityCommand();
+  velocity_preview_subscriber_.reset();
+  received_velocity_preview_.write(VelocityPreview());
+  velocity_preview_ = VelocityPreview();
   is_halted = false;
   return true;
 }
 
+void DiffDriveController::limit_to_velocity_preview(
+  VelocityCommand & command, const rclcpp::Time & time)
+{
+  // keep the last preview if the subscriber is writing right now
+  received_velocity_preview_.try_read(velocity_preview_);
+  VelocityCommand previewed = command;
+  for (size_t i = 0; i < velocity_preview_.num_points; ++i)
+  {
+    const auto & point = velocity_preview_.points[i];
+    // the points which are due are reached through cmd_vel
+    const double time_ahead =
+      static_cast<double>(point.stamp_nanoseconds - time.nanoseconds()) * 1e-9;
+    if (time_ahead > 0.0)
+    {
+      limiter_.limit_to_preview(previewed, {point.linear, point.angular}, time_ahead);
+    }
+  }
+  // the preview only brings planned decelerations forward, it never speeds up or turns faster
+  for (size_t i = 0; i < command.size(); ++i)
+  {
+    if (previewed[i] * command[i] <= 0.0)
+    {
+      command[i] = 0.0;
+    }
+    else if (std::fabs(previewed[i]) < std::fabs(command[i]))
+    {
+      command[i] = previewed[i];
+    }
+  }
+}
+
+void DiffDriveController::restore_odometry()
+{
+  const auto & persistence = params_.odometry_persistence;
+  odometry_persistence::OdometrySnapshot snapshot;
+  std::string error;
+  if (!odometry_persistence::load_snapshot(persistence.path, snapshot, error))
+  {
+    RCLCPP_INFO(get_node()->get_logger(), "Not restoring the odometry: %s", error.c_str());
+    return;
+  }
+  const double age =
+    (get_node()->now() - rclcpp::Time(snapshot.stamp_nanoseconds, RCL_ROS_TIME)).seconds();
+  if (persistence.max_age > 0.0 && age > persistence.max_age)
+  {
+    RCLCPP_INFO(
+      get_node()->get_logger(), "Not restoring the odometry, it is %.1f s old", age);
+    return;
+  }
+  if (snapshot.num_wheels != 2)
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(), "Not restoring the odometry of %zu wheels instead of 2",
+      snapshot.num_wheels);
+    return;
+  }
+
+  odometry_.restore(
+    snapshot.x, snapshot.y, snapshot.heading, snapshot.linear, snapshot.angular,
+    snapshot.wheel_positions[0], snapshot.wheel_positions[1], persistence.max_wheel_rotation);
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Restored the odometry at x %f, y %f, heading %f", snapshot.x,
+    snapshot.y, snapshot.heading);
+}
+
 controller_interface::CallbackReturn DiffDriveController::on_shutdown(
   const rclcpp_lifecycle::State &)
 {
@@ -578,8 +950,27 @@ controller_interface::CallbackReturn DiffDriveController::configure_side(
       return controller_interface::CallbackReturn::ERROR;
     }
 
+    const hardware_interface::LoanedStateInterface * timestamp_handle = nullptr;
+    if (!params_.hardware_timestamp_interface.empty())
+    {
+      const auto & timestamp_name = params_.hardware_timestamp_interface;
+      const auto found_handle = std::find_if(
+        state_interfaces_.cbegin(), state_interfaces_.cend(),
+        [&wheel_name, &timestamp_name](const auto & interface)
+        {
+          return interface.get_prefix_name() == wheel_name &&
+                 interface.get_interface_name() == timestamp_name;
+        });
+      if (found_handle == state_interfaces_.cend())
+      {
+        RCLCPP_ERROR(logger, "Unable to obtain joint timestamp handle for %s", wheel_name.c_str());
+        return controller_interface::CallbackReturn::ERROR;
+      }
+      timestamp_handle = &*found_handle;
+    }
+
     registered_handles.emplace_back(
-      WheelHandle{std::ref(*state_handle), std::ref(*command_handle)});
+      WheelHandle{std::ref(*state_handle), std::ref(*command_handle), timestamp_handle});
   }
 
   return controller_interface::CallbackReturn::SUCCESS;
@@ -589,4 +980,4 @@ controller_interface::CallbackReturn DiffDriveController::configure_side(
 #include "class_loader/register_macro.hpp"
 
 CLASS_LOADER_REGISTER_CLASS(
-  diff_drive_controller::DiffDriveController, controller_interface::ControllerInterface)
+  diff_drive_controller::DiffDriveController, controller_interface::ChainableControllerInterface)
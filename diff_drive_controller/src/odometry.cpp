@@ -18,13 +18,13 @@
 
 #include "diff_drive_controller/odometry.hpp"
 
+#include <cmath>
+#include <limits>
+
 namespace diff_drive_controller
 {
 Odometry::Odometry(size_t velocity_rolling_window_size)
 : timestamp_(0.0),
-  x_(0.0),
-  y_(0.0),
-  heading_(0.0),
   linear_(0.0),
   angular_(0.0),
   wheel_separation_(0.0),
@@ -32,7 +32,15 @@ Odometry::Odometry(size_t velocity_rolling_window_size)
   right_wheel_radius_(0.0),
   left_wheel_old_pos_(0.0),
   right_wheel_old_pos_(0.0),
-  velocity_rolling_window_size_(velocity_rolling_window_size),
+  restored_max_wheel_rotation_(std::numeric_limits<double>::infinity()),
+  integration_substeps_(1),
+  previous_linear_rate_(0.0),
+  previous_angular_rate_(0.0),
+  wheel_travel_variance_(0.0),
+  input_covariance_{},
+  pose_covariance_{},
+  twist_covariance_{},
+  velocity_estimator_(VelocityEstimator::ROLLING_MEAN),
   linear_accumulator_(velocity_rolling_window_size),
   angular_accumulator_(velocity_rolling_window_size)
 {
@@ -43,6 +51,8 @@ void Odometry::init(const rclcpp::Time & time)
   // Reset accumulators and timestamp:
   resetAccumulators();
   timestamp_ = time;
+  previous_linear_rate_ = 0.0;
+  previous_angular_rate_ = 0.0;
 }
 
 bool Odometry::update(double left_pos, double right_pos, const rclcpp::Time & time)
@@ -58,6 +68,18 @@ bool Odometry::update(double left_pos, double right_pos, const rclcpp::Time & ti
   const double left_wheel_cur_pos = left_pos * left_wheel_radius_;
   const double right_wheel_cur_pos = right_pos * right_wheel_radius_;
 
+  // the encoders may have been reset since the positions were restored
+  if (
+    std::fabs(left_wheel_cur_pos - left_wheel_old_pos_) >
+      restored_max_wheel_rotation_ * left_wheel_radius_ ||
+    std::fabs(right_wheel_cur_pos - right_wheel_old_pos_) >
+      restored_max_wheel_rotation_ * right_wheel_radius_)
+  {
+    left_wheel_old_pos_ = left_wheel_cur_pos;
+    right_wheel_old_pos_ = right_wheel_cur_pos;
+  }
+  restored_max_wheel_rotation_ = std::numeric_limits<double>::infinity();
+
   // Estimate velocity of wheels using old and current position:
   const double left_wheel_est_vel = left_wheel_cur_pos - left_wheel_old_pos_;
   const double right_wheel_est_vel = right_wheel_cur_pos - right_wheel_old_pos_;
@@ -80,17 +102,42 @@ bool Odometry::updateFromVelocity(double left_vel, double right_vel, const rclcp
   // Now there is a bug about scout angular velocity
   const double angular = (right_vel - left_vel) / wheel_separation_;
 
+  if (wheel_travel_variance_ > 0.0)
+  {
+    // variances of the wheel travels, mapped to the linear and angular deltas
+    const double left_variance = wheel_travel_variance_ * std::fabs(left_vel);
+    const double right_variance = wheel_travel_variance_ * std::fabs(right_vel);
+    input_covariance_[0] = 0.25 * (left_variance + right_variance);
+    input_covariance_[1] = 0.5 * (right_variance - left_variance) / wheel_separation_;
+    input_covariance_[2] = input_covariance_[1];
+    input_covariance_[3] =
+      (left_variance + right_variance) / (wheel_separation_ * wheel_separation_);
+    for (size_t i = 0; i < twist_covariance_.size(); ++i)
+    {
+      twist_covariance_[i] = input_covariance_[i] / (dt * dt);
+    }
+  }
+
   // Integrate odometry:
-  integrateExact(linear, angular);
+  integrate(linear, angular, dt, integration_substeps_);
+  input_covariance_.fill(0.0);
 
   timestamp_ = time;
 
-  // Estimate speeds using a rolling mean to filter them out:
-  linear_accumulator_.accumulate(linear / dt);
-  angular_accumulator_.accumulate(angular / dt);
+  // Estimate speeds using a rolling mean or alpha-beta filters to filter them out:
+  if (velocity_estimator_ == VelocityEstimator::ALPHA_BETA)
+  {
+    linear_ = linear_filter_.update(linear / dt, dt);
+    angular_ = angular_filter_.update(angular / dt, dt);
+  }
+  else
+  {
+    linear_accumulator_.accumulate(linear / dt);
+    angular_accumulator_.accumulate(angular / dt);
 
-  linear_ = linear_accumulator_.getRollingMean();
-  angular_ = angular_accumulator_.getRollingMean();
+    linear_ = linear_accumulator_.getRollingMean();
+    angular_ = angular_accumulator_.getRollingMean();
+  }
 
   return true;
 }
@@ -104,14 +151,49 @@ void Odometry::updateOpenLoop(double linear, double angular, const rclcpp::Time
   /// Integrate odometry:
   const double dt = time.seconds() - timestamp_.seconds();
   timestamp_ = time;
-  integrateExact(linear * dt, angular * dt);
+  integrate(linear * dt, angular * dt, dt, 1);
+}
+
+void Odometry::getExtrapolatedPose(double dt, double & x, double & y, double & heading) const
+{
+  // constant velocities over a fraction of a cycle, second order is enough
+  const double linear = linear_ * dt;
+  const double angular = angular_ * dt;
+  const double direction = pose_.heading() + angular * 0.5;
+  x = pose_.x() + linear * cos(direction);
+  y = pose_.y() + linear * sin(direction);
+  heading = pose_.heading() + angular;
 }
 
 void Odometry::resetOdometry()
 {
-  x_ = 0.0;
-  y_ = 0.0;
-  heading_ = 0.0;
+  pose_.reset();
+  pose_covariance_.fill(0.0);
+  twist_covariance_.fill(0.0);
+}
+
+void Odometry::restore(
+  double x, double y, double heading, double linear, double angular, double left_wheel_pos,
+  double right_wheel_pos, double max_wheel_rotation)
+{
+  pose_.reset(x, y, heading);
+  pose_covariance_.fill(0.0);
+  twist_covariance_.fill(0.0);
+
+  // the velocity estimation starts from the persisted velocities
+  resetAccumulators();
+  linear_accumulator_.accumulate(linear);
+  angular_accumulator_.accumulate(angular);
+  linear_filter_.update(linear, 0.0);
+  angular_filter_.update(angular, 0.0);
+  linear_ = linear;
+  angular_ = angular;
+  previous_linear_rate_ = linear;
+  previous_angular_rate_ = angular;
+
+  left_wheel_old_pos_ = left_wheel_pos;
+  right_wheel_old_pos_ = right_wheel_pos;
+  restored_max_wheel_rotation_ = max_wheel_rotation;
 }
 
 void Odometry::setWheelParams(
@@ -124,42 +206,96 @@ void Odometry::setWheelParams(
 
 void Odometry::setVelocityRollingWindowSize(size_t velocity_rolling_window_size)
 {
-  velocity_rolling_window_size_ = velocity_rolling_window_size;
+  linear_accumulator_.resize(velocity_rolling_window_size);
+  angular_accumulator_.resize(velocity_rolling_window_size);
+}
+
+void Odometry::setVelocityEstimator(VelocityEstimator estimator, double alpha, double beta)
+{
+  velocity_estimator_ = estimator;
+  linear_filter_.setGains(alpha, beta);
+  angular_filter_.setGains(alpha, beta);
 
   resetAccumulators();
 }
 
-void Odometry::integrateRungeKutta2(double linear, double angular)
-{
-  const double direction = heading_ + angular * 0.5;
+void Odometry::setIntegrationSubsteps(unsigned int substeps) { integration_substeps_ = substeps; }
 
-  /// Runge-Kutta 2nd order integration:
-  x_ += linear * cos(direction);
-  y_ += linear * sin(direction);
-  heading_ += angular;
+void Odometry::setWheelTravelVariance(double variance_per_meter)
+{
+  wheel_travel_variance_ = variance_per_meter;
+  input_covariance_.fill(0.0);
+  pose_covariance_.fill(0.0);
+  twist_covariance_.fill(0.0);
 }
 
-void Odometry::integrateExact(double linear, double angular)
+void Odometry::integrate(double linear, double angular, double dt, unsigned int substeps)
 {
-  if (fabs(angular) < 1e-6)
+  if (wheel_travel_variance_ > 0.0 && substeps <= 1)
   {
-    integrateRungeKutta2(linear, angular);
+    odometry_integration::StepJacobian<double> jacobian;
+    pose_.integrate_exact(linear, angular, &jacobian);
+    propagatePoseCovariance(jacobian);
   }
   else
   {
-    /// Exact integration (should solve problems when angular is zero):
-    const double heading_old = heading_;
-    const double r = linear / angular;
-    heading_ += angular;
-    x_ += r * (sin(heading_) - sin(heading_old));
-    y_ += -r * (cos(heading_) - cos(heading_old));
+    if (wheel_travel_variance_ > 0.0)
+    {
+      // the covariance is propagated with a single step over the update
+      odometry_integration::StepJacobian<double> jacobian;
+      auto single_step = pose_;
+      single_step.integrate_exact(linear, angular, &jacobian);
+      propagatePoseCovariance(jacobian);
+    }
+    pose_.integrate_substeps(
+      linear, angular, previous_linear_rate_ * dt, previous_angular_rate_ * dt, substeps);
+  }
+
+  if (dt > 0.0)
+  {
+    previous_linear_rate_ = linear / dt;
+    previous_angular_rate_ = angular / dt;
+  }
+}
+
+void Odometry::propagatePoseCovariance(const odometry_integration::StepJacobian<double> & jacobian)
+{
+  // P = F P F^T + G Q G^T, F is the identity apart from the heading column
+  const std::array<double, 3> heading_column = {jacobian.dx_dheading, jacobian.dy_dheading, 0.0};
+  const auto & input_jacobian = jacobian.input;
+  std::array<double, 9> f_p = pose_covariance_;
+  for (size_t row = 0; row < 3; ++row)
+  {
+    for (size_t col = 0; col < 3; ++col)
+    {
+      f_p[3 * row + col] += heading_column[row] * pose_covariance_[3 * 2 + col];
+    }
+  }
+  for (size_t row = 0; row < 3; ++row)
+  {
+    for (size_t col = 0; col < 3; ++col)
+    {
+      // (F P) F^T plus the input part
+      double value = f_p[3 * row + col] + f_p[3 * row + 2] * heading_column[col];
+      for (size_t i = 0; i < 2; ++i)
+      {
+        for (size_t j = 0; j < 2; ++j)
+        {
+          value += input_jacobian[2 * row + i] * input_covariance_[2 * i + j] *
+                   input_jacobian[2 * col + j];
+        }
+      }
+      pose_covariance_[3 * row + col] = value;
+    }
   }
 }
 
 void Odometry::resetAccumulators()
 {
-  linear_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
-  angular_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
+  linear_accumulator_.reset();
+  angular_accumulator_.reset();
+  linear_filter_.reset();
+  angular_filter_.reset();
 }
 
 }  // namespace diff_drive_controller
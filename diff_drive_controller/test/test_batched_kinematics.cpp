@@ -0,0 +1,133 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "diff_drive_controller/batched_kinematics.hpp"
+
+using diff_drive_controller::BatchedKinematics;
+using testing::DoubleNear;
+using testing::ElementsAre;
+
+TEST(TestBatchedKinematics, commands_of_every_robot)
+{
+  BatchedKinematics kinematics;
+  kinematics.configure(3, 0.5, 0.1, 0.2);
+  ASSERT_EQ(kinematics.size(), 3u);
+
+  kinematics.linear_commands() = {1.0, 0.0, -1.0};
+  kinematics.angular_commands() = {0.0, 2.0, 2.0};
+  kinematics.compute_commands();
+  EXPECT_THAT(kinematics.left_commands(), ElementsAre(10.0, -5.0, -15.0));
+  EXPECT_THAT(kinematics.right_commands(), ElementsAre(5.0, 2.5, -2.5));
+}
+
+TEST(TestBatchedKinematics, commands_are_limited)
+{
+  BatchedKinematics kinematics;
+  kinematics.configure(2, 0.5, 0.1, 0.1);
+  kinematics.set_velocity_limits(0.5, 1.0);
+
+  kinematics.linear_commands() = {1.0, -0.2};
+  kinematics.angular_commands() = {-3.0, 0.5};
+  kinematics.compute_commands();
+  EXPECT_THAT(kinematics.linear_commands(), ElementsAre(0.5, -0.2));
+  EXPECT_THAT(kinematics.angular_commands(), ElementsAre(-1.0, 0.5));
+}
+
+TEST(TestBatchedKinematics, odometry_from_positions)
+{
+  BatchedKinematics kinematics;
+  kinematics.configure(2, 0.5, 0.1, 0.1);
+
+  // the first positions only initialize the odometry
+  kinematics.left_feedback() = {1.0, 2.0};
+  kinematics.right_feedback() = {1.0, 2.0};
+  EXPECT_EQ(kinematics.update_from_positions(0.1), 0u);
+  EXPECT_THAT(kinematics.x(), ElementsAre(0.0, 0.0));
+
+  // robot 0 drives straight 0.1 m, robot 1 turns on the spot
+  kinematics.left_feedback() = {2.0, 1.0};
+  kinematics.right_feedback() = {2.0, 3.0};
+  EXPECT_EQ(kinematics.update_from_positions(0.1), 0u);
+  EXPECT_THAT(kinematics.x(), ElementsAre(DoubleNear(0.1, 1e-12), DoubleNear(0.0, 1e-12)));
+  EXPECT_THAT(kinematics.heading(), ElementsAre(DoubleNear(0.0, 1e-12), DoubleNear(0.4, 1e-12)));
+  EXPECT_THAT(kinematics.linear(), ElementsAre(DoubleNear(1.0, 1e-12), DoubleNear(0.0, 1e-12)));
+  EXPECT_THAT(kinematics.angular(), ElementsAre(DoubleNear(0.0, 1e-12), DoubleNear(4.0, 1e-12)));
+}
+
+TEST(TestBatchedKinematics, odometry_from_velocities_follows_an_arc)
+{
+  BatchedKinematics kinematics;
+  kinematics.configure(1, 0.5, 0.1, 0.1);
+
+  // 1 m/s and 1 rad/s, a circle with a radius of 1 m
+  kinematics.left_feedback() = {7.5};
+  kinematics.right_feedback() = {12.5};
+  for (int step = 0; step < 1000; ++step)
+  {
+    ASSERT_EQ(kinematics.update_from_velocities(M_PI / 2000.0), 0u);
+  }
+  // a quarter circle
+  EXPECT_NEAR(kinematics.x()[0], 1.0, 1e-6);
+  EXPECT_NEAR(kinematics.y()[0], 1.0, 1e-6);
+  EXPECT_NEAR(kinematics.heading()[0], M_PI / 2.0, 1e-9);
+  EXPECT_NEAR(kinematics.linear()[0], 1.0, 1e-9);
+  EXPECT_NEAR(kinematics.angular()[0], 1.0, 1e-9);
+}
+
+TEST(TestBatchedKinematics, invalid_feedback_stops_one_robot)
+{
+  constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+  BatchedKinematics kinematics;
+  kinematics.configure(2, 0.5, 0.1, 0.1);
+  kinematics.left_feedback() = {0.0, 0.0};
+  kinematics.right_feedback() = {0.0, 0.0};
+  kinematics.update_from_positions(0.1);
+
+  kinematics.left_feedback() = {1.0, NaN};
+  kinematics.right_feedback() = {1.0, 1.0};
+  EXPECT_EQ(kinematics.update_from_positions(0.1), 1u);
+  EXPECT_THAT(kinematics.x(), ElementsAre(DoubleNear(0.1, 1e-12), 0.0));
+
+  // the robot continues from its last valid positions
+  kinematics.left_feedback() = {2.0, 1.0};
+  kinematics.right_feedback() = {2.0, 1.0};
+  EXPECT_EQ(kinematics.update_from_positions(0.1), 0u);
+  EXPECT_THAT(kinematics.x(), ElementsAre(DoubleNear(0.2, 1e-12), DoubleNear(0.1, 1e-12)));
+
+  kinematics.left_feedback() = {NaN, 1.0};
+  EXPECT_EQ(kinematics.update_from_velocities(0.1), 1u);
+  EXPECT_THAT(kinematics.x(), ElementsAre(DoubleNear(0.2, 1e-12), DoubleNear(0.11, 1e-12)));
+}
+
+TEST(TestBatchedKinematics, open_loop_and_reset)
+{
+  BatchedKinematics kinematics;
+  kinematics.configure(2, 0.5, 0.1, 0.1);
+  kinematics.linear_commands() = {1.0, 2.0};
+  kinematics.angular_commands() = {0.0, 0.0};
+  kinematics.compute_commands();
+  kinematics.update_open_loop(0.5);
+  EXPECT_THAT(kinematics.x(), ElementsAre(0.5, 1.0));
+  EXPECT_THAT(kinematics.linear(), ElementsAre(1.0, 2.0));
+
+  kinematics.reset();
+  EXPECT_THAT(kinematics.x(), ElementsAre(0.0, 0.0));
+  EXPECT_THAT(kinematics.linear(), ElementsAre(0.0, 0.0));
+}
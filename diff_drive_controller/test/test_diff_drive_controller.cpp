@@ -15,6 +15,7 @@
 #include <gmock/gmock.h>
 
 #include <array>
+#include <cstdio>
 #include <memory>
 #include <string>
 #include <thread>
@@ -27,6 +28,8 @@
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/rclcpp.hpp"
+#include "rt_safety_checks/rt_safety_checker.hpp"
+#include "trajectory_msgs/msg/multi_dof_joint_trajectory.hpp"
 
 using CallbackReturn = controller_interface::CallbackReturn;
 using hardware_interface::HW_IF_POSITION;
@@ -40,10 +43,10 @@ class TestableDiffDriveController : public diff_drive_controller::DiffDriveContr
 {
 public:
   using DiffDriveController::DiffDriveController;
-  std::shared_ptr<geometry_msgs::msg::TwistStamped> getLastReceivedTwist()
+  StampedVelocityCommand getLastReceivedCommand()
   {
-    std::shared_ptr<geometry_msgs::msg::TwistStamped> ret;
-    received_velocity_msg_ptr_.get(ret);
+    StampedVelocityCommand ret;
+    received_velocity_command_.try_read(ret);
     return ret;
   }
 
@@ -69,16 +72,34 @@ public:
     return false;
   }
 
+  /// Block until a velocity preview is received, like wait_for_twist()
+  bool wait_for_velocity_preview(
+    rclcpp::Executor & executor,
+    const std::chrono::milliseconds & timeout = std::chrono::milliseconds(500))
+  {
+    rclcpp::WaitSet wait_set;
+    wait_set.add_subscription(velocity_preview_subscriber_);
+
+    if (wait_set.wait(timeout).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      executor.spin_some();
+      return true;
+    }
+    return false;
+  }
+
   /**
    * @brief Used to get the real_time_odometry_publisher to verify its contents
    *
    * @return Copy of realtime_odometry_publisher_ object
    */
-  std::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<nav_msgs::msg::Odometry>>
   get_rt_odom_publisher()
   {
     return realtime_odometry_publisher_;
   }
+
+  const diff_drive_controller::Odometry & get_odometry() const { return odometry_; }
 };
 
 class TestDiffDriveController : public ::testing::Test
@@ -657,3 +678,304 @@ TEST_F(TestDiffDriveController, correct_initialization_using_parameters)
   ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
   executor.cancel();
 }
+
+TEST_F(TestDiffDriveController, chained_mode_uses_reference_interfaces)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->configure().id());
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_THAT(reference_interfaces, SizeIs(2));
+  EXPECT_EQ(reference_interfaces[0].get_name(), controller_name + "/linear/" + HW_IF_VELOCITY);
+  EXPECT_EQ(reference_interfaces[1].get_name(), controller_name + "/angular/" + HW_IF_VELOCITY);
+
+  assignResourcesPosFeedback();
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, controller_->get_node()->activate().id());
+  ASSERT_TRUE(controller_->is_in_chained_mode());
+
+  // no reference written yet
+  const rclcpp::Time time(0, 0, RCL_ROS_TIME);
+  ASSERT_EQ(
+    controller_->update(time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, left_wheel_vel_cmd_.get_value());
+  EXPECT_EQ(0.0, right_wheel_vel_cmd_.get_value());
+
+  // the references are used in the same update, without a cmd_vel message and its timeout
+  reference_interfaces[0].set_value(1.0);
+  reference_interfaces[1].set_value(0.5);
+  ASSERT_EQ(
+    controller_->update(time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(0.9, left_wheel_vel_cmd_.get_value());
+  EXPECT_DOUBLE_EQ(1.1, right_wheel_vel_cmd_.get_value());
+}
+
+TEST_F(TestDiffDriveController, velocity_preview_decelerates_before_a_planned_stop)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("enable_velocity_preview", true));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("linear.x.has_acceleration_limits", true));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("linear.x.max_acceleration", 1.0));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->configure().id());
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  assignResourcesPosFeedback();
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, controller_->get_node()->activate().id());
+
+  // a stop is planned 2 s after the start, the reference is 1 m/s until then
+  const rclcpp::Time start(10, 0, RCL_ROS_TIME);
+  using trajectory_msgs::msg::MultiDOFJointTrajectory;
+  auto preview_publisher = pub_node->create_publisher<MultiDOFJointTrajectory>(
+    controller_name + "/cmd_vel_preview", rclcpp::SystemDefaultsQoS());
+  while (preview_publisher->get_subscription_count() == 0)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  MultiDOFJointTrajectory preview;
+  preview.header.stamp = start;
+  preview.points.resize(1);
+  preview.points[0].time_from_start = rclcpp::Duration::from_seconds(2.0);
+  preview.points[0].velocities.resize(1);
+  preview_publisher->publish(preview);
+  ASSERT_TRUE(controller_->wait_for_velocity_preview(executor));
+
+  reference_interfaces[0].set_value(1.0);
+  reference_interfaces[1].set_value(0.0);
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  for (int i = 1; i <= 150; ++i)
+  {
+    ASSERT_EQ(
+      controller_->update(start + period * i, period), controller_interface::return_type::OK);
+    if (i == 100)
+    {
+      // accelerated to the reference
+      EXPECT_NEAR(left_wheel_vel_cmd_.get_value(), 1.0, 1e-9);
+    }
+  }
+  // decelerating with the limit since 1 s before the stop, instead of at the stop
+  EXPECT_NEAR(left_wheel_vel_cmd_.get_value(), 0.5, 1e-9);
+  EXPECT_NEAR(right_wheel_vel_cmd_.get_value(), 0.5, 1e-9);
+  executor.cancel();
+}
+
+TEST_F(TestDiffDriveController, odometry_uses_hardware_timestamps)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("position_feedback", false));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("hardware_timestamp_interface", "timestamp"));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("extrapolate_odometry_to_update_time", true));
+
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->configure().id());
+
+  // feedback not overwritten by the commands
+  std::vector<double> feedback_values = {1.0, 1.0};
+  std::vector<double> timestamp_values = {9.99, 9.99};
+  hardware_interface::StateInterface left_feedback{
+    left_wheel_names[0], HW_IF_VELOCITY, &feedback_values[0]};
+  hardware_interface::StateInterface right_feedback{
+    right_wheel_names[0], HW_IF_VELOCITY, &feedback_values[1]};
+  hardware_interface::StateInterface left_timestamp{
+    left_wheel_names[0], "timestamp", &timestamp_values[0]};
+  hardware_interface::StateInterface right_timestamp{
+    right_wheel_names[0], "timestamp", &timestamp_values[1]};
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(left_feedback);
+  state_ifs.emplace_back(right_feedback);
+  state_ifs.emplace_back(left_timestamp);
+  state_ifs.emplace_back(right_timestamp);
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(left_wheel_vel_cmd_);
+  command_ifs.emplace_back(right_wheel_vel_cmd_);
+  controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, controller_->get_node()->activate().id());
+
+  // the first measurement only initializes the time base
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(10, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.05)),
+    controller_interface::return_type::OK);
+
+  // 0.04 s between the measurements instead of the update period
+  timestamp_values = {10.02, 10.04};
+  ASSERT_EQ(
+    controller_->update(
+      rclcpp::Time(10, 50000000, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.05)),
+    controller_interface::return_type::OK);
+
+  // 0.04 m integrated, extrapolated with 1 m/s over the 0.02 s to the update time
+  const auto odometry_message = controller_->get_rt_odom_publisher()->msg_;
+  EXPECT_NEAR(odometry_message.pose.pose.position.x, 0.06, 1e-9);
+  EXPECT_NEAR(odometry_message.pose.pose.position.y, 0.0, 1e-9);
+  EXPECT_NEAR(odometry_message.twist.twist.linear.x, 1.0, 1e-9);
+}
+
+TEST_F(TestDiffDriveController, odometry_is_exported_at_each_update)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("export_odometry", true));
+
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->configure().id());
+  assignResourcesPosFeedback();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, controller_->get_node()->activate().id());
+
+  // the slot is found by the name of the controller, e.g., by a controller configured before
+  const auto slot =
+    odometry_exchange::OdometryExchange::get_instance().get_slot("/" + controller_name);
+  odometry_exchange::OdometryState state;
+  EXPECT_FALSE(slot->read(state));
+
+  rclcpp::Time time(10, 0, RCL_ROS_TIME);
+  const auto period = rclcpp::Duration::from_seconds(0.1);
+  for (const double position : {0.3, 0.5})
+  {
+    position_values_ = {position, position};
+    time += period;
+    ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  }
+
+  // the exported odometry is the one published in the same update
+  const auto odometry_message = controller_->get_rt_odom_publisher()->msg_;
+  ASSERT_TRUE(slot->read(state));
+  EXPECT_EQ(state.stamp_nanoseconds, time.nanoseconds());
+  EXPECT_GT(state.x, 0.0);
+  EXPECT_DOUBLE_EQ(state.x, odometry_message.pose.pose.position.x);
+  EXPECT_DOUBLE_EQ(state.y, odometry_message.pose.pose.position.y);
+  EXPECT_DOUBLE_EQ(state.yaw, 0.0);
+  EXPECT_DOUBLE_EQ(state.linear, odometry_message.twist.twist.linear.x);
+  EXPECT_DOUBLE_EQ(state.angular, odometry_message.twist.twist.angular.z);
+}
+
+TEST_F(TestDiffDriveController, persisted_odometry_is_restored_on_activation)
+{
+  const std::string path = ::testing::TempDir() + "test_diff_drive_controller.odom";
+  std::remove(path.c_str());
+  const auto configure_and_activate = [&]()
+  {
+    controller_ = std::make_unique<TestableDiffDriveController>();
+    ASSERT_EQ(controller_->init(controller_name, urdf_, 0), controller_interface::return_type::OK);
+    controller_->get_node()->set_parameter(
+      rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+    controller_->get_node()->set_parameter(
+      rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+    controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+    controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+    controller_->get_node()->set_parameter(rclcpp::Parameter("odometry_persistence.enable", true));
+    controller_->get_node()->set_parameter(rclcpp::Parameter("odometry_persistence.path", path));
+    ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->configure().id());
+    assignResourcesPosFeedback();
+    ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, controller_->get_node()->activate().id());
+  };
+
+  configure_and_activate();
+  rclcpp::Time time(10, 0, RCL_ROS_TIME);
+  const auto period = rclcpp::Duration::from_seconds(0.1);
+  for (const double left_position : {0.3, 0.5, 0.8})
+  {
+    position_values_ = {left_position, 0.5};
+    time += period;
+    ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  }
+  const double x = controller_->get_odometry().getX();
+  const double y = controller_->get_odometry().getY();
+  const double heading = controller_->get_odometry().getHeading();
+  EXPECT_GT(x, 0.0);
+  EXPECT_NE(heading, 0.0);
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->deactivate().id());
+
+  // a new instance, e.g., after a restart, continues from the wheel positions of the last update
+  configure_and_activate();
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getX(), x);
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getY(), y);
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getHeading(), heading);
+  time += period;
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getX(), x);
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->deactivate().id());
+
+  // the wheel positions jumped, e.g., after a reset of the encoders
+  configure_and_activate();
+  position_values_ = {-100.0, 200.0};
+  time += period;
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getX(), x);
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getHeading(), heading);
+  std::remove(path.c_str());
+}
+
+TEST_F(TestDiffDriveController, update_is_realtime_safe)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 0.1));
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  rclcpp::Time time(0, 0, RCL_ROS_TIME);
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  // the first cycle may still initialize
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    time += period;
+    ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+}
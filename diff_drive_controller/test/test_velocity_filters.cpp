@@ -0,0 +1,91 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "diff_drive_controller/velocity_filters.hpp"
+
+TEST(TestRollingMean, mean_of_last_samples)
+{
+  diff_drive_controller::RollingMean mean(3);
+  EXPECT_EQ(mean.getRollingMean(), 0.0);
+
+  mean.accumulate(1.0);
+  EXPECT_DOUBLE_EQ(mean.getRollingMean(), 1.0);
+  mean.accumulate(2.0);
+  EXPECT_DOUBLE_EQ(mean.getRollingMean(), 1.5);
+  mean.accumulate(3.0);
+  EXPECT_DOUBLE_EQ(mean.getRollingMean(), 2.0);
+  // the first sample leaves the window
+  mean.accumulate(7.0);
+  EXPECT_DOUBLE_EQ(mean.getRollingMean(), 4.0);
+
+  mean.reset();
+  EXPECT_EQ(mean.getRollingMean(), 0.0);
+  mean.accumulate(5.0);
+  EXPECT_DOUBLE_EQ(mean.getRollingMean(), 5.0);
+}
+
+TEST(TestRollingMean, no_drift_on_long_runs)
+{
+  const size_t window_size = 100;
+  diff_drive_controller::RollingMean mean(window_size);
+  // large values followed by small ones, the removed large values must not leave rounding errors
+  for (size_t i = 0; i < 100000; ++i)
+  {
+    mean.accumulate(1e8 + 0.1 * static_cast<double>(i % 7));
+  }
+  for (size_t i = 0; i < 10 * window_size; ++i)
+  {
+    mean.accumulate(0.1);
+  }
+  EXPECT_NEAR(mean.getRollingMean(), 0.1, 1e-12);
+}
+
+TEST(TestAlphaBetaFilter, tracks_ramp_without_lag)
+{
+  diff_drive_controller::AlphaBetaFilter filter(0.5, 0.1);
+  const double dt = 0.01;
+  double value = 0.0;
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    value = filter.update(2.0 * static_cast<double>(i) * dt, dt);
+  }
+  // the rate is estimated, so a ramp is tracked without steady-state error
+  EXPECT_NEAR(value, 2.0 * 999.0 * dt, 1e-6);
+
+  filter.reset();
+  EXPECT_EQ(filter.update(1.0, dt), 1.0);
+}
+
+TEST(TestAlphaBetaFilter, attenuates_noise)
+{
+  diff_drive_controller::AlphaBetaFilter filter(0.2, 0.02);
+  const double dt = 0.01;
+  double max_error = 0.0;
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    const double noise = (i % 2 == 0) ? 0.1 : -0.1;
+    const double value = filter.update(1.0 + noise, dt);
+    if (i > 500)
+    {
+      max_error = std::max(max_error, std::abs(value - 1.0));
+    }
+  }
+  EXPECT_LT(max_error, 0.05);
+}
@@ -0,0 +1,85 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <limits>
+#include <vector>
+
+#include "diff_drive_controller/wheel_kinematics.hpp"
+
+using diff_drive_controller::WheelKinematics;
+using testing::DoubleNear;
+using testing::ElementsAre;
+
+TEST(TestWheelKinematics, commands_follow_the_radius_of_each_wheel)
+{
+  WheelKinematics kinematics;
+  kinematics.configure({0.1, 0.2, 0.25}, {0.1, 0.2, 0.25}, 0.5);
+  ASSERT_EQ(kinematics.size(), 6u);
+  ASSERT_EQ(kinematics.num_left(), 3u);
+
+  kinematics.compute_commands(1.0, 2.0);
+  // left side moves with 0.5 m/s, right side with 1.5 m/s
+  EXPECT_THAT(
+    kinematics.commands(), ElementsAre(
+                             DoubleNear(5.0, 1e-12), DoubleNear(2.5, 1e-12), DoubleNear(2.0, 1e-12),
+                             DoubleNear(15.0, 1e-12), DoubleNear(7.5, 1e-12),
+                             DoubleNear(6.0, 1e-12)));
+}
+
+TEST(TestWheelKinematics, fit_recovers_the_commanded_motion)
+{
+  WheelKinematics kinematics;
+  kinematics.configure({0.1, 0.2, 0.25, 0.3}, {0.15, 0.2, 0.25, 0.3}, 0.8);
+  kinematics.compute_commands(0.7, -0.3);
+  kinematics.feedback() = kinematics.commands();
+
+  double linear = 0.0;
+  double angular = 0.0;
+  ASSERT_TRUE(kinematics.fit(linear, angular));
+  EXPECT_NEAR(linear, 0.7, 1e-12);
+  EXPECT_NEAR(angular, -0.3, 1e-12);
+
+  double left = 0.0;
+  double right = 0.0;
+  kinematics.side_motion(linear, angular, left, right);
+  EXPECT_NEAR(left, 0.82, 1e-12);
+  EXPECT_NEAR(right, 0.58, 1e-12);
+}
+
+TEST(TestWheelKinematics, slipping_wheel_is_averaged_out)
+{
+  WheelKinematics kinematics;
+  kinematics.configure({0.1, 0.1, 0.1}, {0.1, 0.1, 0.1}, 1.0);
+  // the middle left wheel spins twice as fast as the others
+  kinematics.feedback() = {10.0, 20.0, 10.0, 10.0, 10.0, 10.0};
+
+  double linear = 0.0;
+  double angular = 0.0;
+  ASSERT_TRUE(kinematics.fit(linear, angular));
+  EXPECT_NEAR(linear, 7.0 / 6.0, 1e-12);
+  EXPECT_NEAR(angular, -1.0 / 3.0, 1e-12);
+}
+
+TEST(TestWheelKinematics, invalid_feedback_is_detected)
+{
+  WheelKinematics kinematics;
+  kinematics.configure({0.1, 0.1}, {0.1, 0.1}, 1.0);
+  kinematics.feedback() = {1.0, 1.0, std::numeric_limits<double>::quiet_NaN(), 1.0};
+
+  double linear = 0.0;
+  double angular = 0.0;
+  EXPECT_FALSE(kinematics.fit(linear, angular));
+}
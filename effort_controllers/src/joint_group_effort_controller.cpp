@@ -71,4 +71,5 @@ controller_interface::CallbackReturn JointGroupEffortController::on_deactivate(
 #include "pluginlib/class_list_macros.hpp"
 
 PLUGINLIB_EXPORT_CLASS(
-  effort_controllers::JointGroupEffortController, controller_interface::ControllerInterface)
+  effort_controllers::JointGroupEffortController,
+  controller_interface::ChainableControllerInterface)
@@ -19,34 +19,39 @@
 #ifndef FORCE_TORQUE_SENSOR_BROADCASTER__FORCE_TORQUE_SENSOR_BROADCASTER_HPP_
 #define FORCE_TORQUE_SENSOR_BROADCASTER__FORCE_TORQUE_SENSOR_BROADCASTER_HPP_
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <Eigen/Core>
+
 #include "controller_interface/controller_interface.hpp"
 #include "force_torque_sensor_broadcaster/visibility_control.h"
+#include "force_torque_sensor_broadcaster/wrench_statistics.hpp"
 // auto-generated by generate_parameter_library
 #include "force_torque_sensor_broadcaster_parameters.hpp"
 #include "geometry_msgs/msg/wrench_stamped.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 #include "realtime_tools/realtime_publisher.h"
+#include "semantic_component_broadcaster/semantic_component_broadcaster.hpp"
 #include "semantic_components/force_torque_sensor.hpp"
+#include "statistics_msgs/msg/metrics_message.hpp"
+#include "std_srvs/srv/empty.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "wrench_filter_chain/wrench_filter_chain.hpp"
 
 namespace force_torque_sensor_broadcaster
 {
-class ForceTorqueSensorBroadcaster : public controller_interface::ControllerInterface
+class ForceTorqueSensorBroadcaster
+: public semantic_component_broadcaster::SemanticComponentBroadcaster<
+    semantic_components::ForceTorqueSensor, geometry_msgs::msg::WrenchStamped>
 {
 public:
   FORCE_TORQUE_SENSOR_BROADCASTER_PUBLIC
   ForceTorqueSensorBroadcaster();
 
-  FORCE_TORQUE_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
-
-  FORCE_TORQUE_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
-
   FORCE_TORQUE_SENSOR_BROADCASTER_PUBLIC controller_interface::CallbackReturn on_init() override;
 
   FORCE_TORQUE_SENSOR_BROADCASTER_PUBLIC
@@ -66,14 +71,78 @@ public:
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
 protected:
+  using Base = semantic_component_broadcaster::SemanticComponentBroadcaster<
+    semantic_components::ForceTorqueSensor, geometry_msgs::msg::WrenchStamped>;
+
+  /// The interfaces of the sensor and the timestamp interface
+  std::vector<std::string> get_sensor_state_interface_names() const override;
+
+  /// Stamp the wrench of the current sample with its sample time
+  void fill_message(
+    const rclcpp::Time & time, geometry_msgs::msg::WrenchStamped & message) override;
+
+  /// \return time of the current sample, from the timestamp state interface if there is one
+  rclcpp::Time get_sample_time(const rclcpp::Time & time) const;
+
+  /// Add the current wrench to the batch, publishes the batch once it is full
+  void add_wrench_batch_sample(const rclcpp::Time & sample_time);
+
+  void init_wrench_batch_msg();
+
+  /// Create the publishers of the wrench statistics, if enabled
+  bool configure_wrench_statistics();
+
+  /// Add the current wrench to the statistics, publishes them once the window is full
+  void add_wrench_statistics_sample(const rclcpp::Time & sample_time);
+
+  /// Configure the filter chain, bias and transformation of the filtered wrench
+  bool configure_filtered_wrench();
+
+  /// Filter the current wrench, remove the bias and transform it, realtime-safe
+  void update_filtered_wrench();
+
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
 
-  std::unique_ptr<semantic_components::ForceTorqueSensor> force_torque_sensor_;
-
   using StatePublisher = realtime_tools::RealtimePublisher<geometry_msgs::msg::WrenchStamped>;
-  rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr sensor_state_publisher_;
-  std::unique_ptr<StatePublisher> realtime_publisher_;
+
+  /// State interface with the time of the samples in seconds, nullptr if not configured
+  const hardware_interface::LoanedStateInterface * timestamp_interface_ = nullptr;
+  /// Time and values of the current sample
+  rclcpp::Time sample_time_;
+  geometry_msgs::msg::Wrench wrench_;
+
+  using BatchPublisher = realtime_tools::RealtimePublisher<trajectory_msgs::msg::JointTrajectory>;
+  rclcpp::Publisher<trajectory_msgs::msg::JointTrajectory>::SharedPtr wrench_batch_publisher_;
+  std::unique_ptr<BatchPublisher> realtime_wrench_batch_publisher_;
+  /// Batch being filled, swapped with the message of the publisher when it is full
+  trajectory_msgs::msg::JointTrajectory wrench_batch_msg_;
+  size_t wrench_batch_num_samples_ = 0;
+  /// Number of full batches that were dropped because the publisher was busy
+  size_t dropped_wrench_batches_ = 0;
+
+  using StatisticsPublisher =
+    realtime_tools::RealtimePublisher<statistics_msgs::msg::MetricsMessage>;
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr wrench_statistics_publisher_;
+  /// One publisher for each wrench component, empty if the statistics are disabled
+  std::vector<std::unique_ptr<StatisticsPublisher>> realtime_statistics_publishers_;
+  WrenchStatistics wrench_statistics_;
+  rclcpp::Time wrench_statistics_window_start_;
+  size_t wrench_statistics_num_samples_ = 0;
+
+  using WrenchFilterChain = wrench_filter_chain::WrenchFilterChain;
+  std::unique_ptr<StatePublisher> realtime_filtered_publisher_;
+  rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr filtered_publisher_;
+  WrenchFilterChain wrench_filter_chain_;
+  /// Last filtered wrench [force, torque] without bias, in the frame of the filtered wrench
+  WrenchFilterChain::Vector6d filtered_wrench_ = WrenchFilterChain::Vector6d::Zero();
+  WrenchFilterChain::Vector6d bias_ = WrenchFilterChain::Vector6d::Zero();
+  /// Pose of the sensor frame in the frame of the filtered wrench
+  Eigen::Matrix3d filtered_frame_rotation_ = Eigen::Matrix3d::Identity();
+  Eigen::Vector3d filtered_frame_translation_ = Eigen::Vector3d::Zero();
+  rclcpp::Service<std_srvs::srv::Empty>::SharedPtr tare_service_;
+  /// Set by the tare service, the next filtered wrench becomes the bias
+  std::atomic<bool> tare_requested_{false};
 };
 
 }  // namespace force_torque_sensor_broadcaster
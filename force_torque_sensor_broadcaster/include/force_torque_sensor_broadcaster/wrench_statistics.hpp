@@ -0,0 +1,107 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FORCE_TORQUE_SENSOR_BROADCASTER__WRENCH_STATISTICS_HPP_
+#define FORCE_TORQUE_SENSOR_BROADCASTER__WRENCH_STATISTICS_HPP_
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace force_torque_sensor_broadcaster
+{
+/**
+ * \brief Mean, variance, minimum and maximum of the six components of a wrench.
+ *
+ * The samples are accumulated with Welford's algorithm, which is numerically stable for long
+ * windows and needs constant time and memory per sample. Components that are not finite, e.g., of
+ * missing interfaces, are not accumulated, so every component counts its own samples.
+ */
+class WrenchStatistics
+{
+public:
+  using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+  WrenchStatistics() { reset(); }
+
+  /// Start a new window
+  void reset()
+  {
+    counts_.setZero();
+    mean_.setZero();
+    squared_deviations_.setZero();
+    min_.setConstant(std::numeric_limits<double>::infinity());
+    max_.setConstant(-std::numeric_limits<double>::infinity());
+  }
+
+  /// Accumulate \p wrench [force, torque], realtime-safe
+  void add(const Vector6d & wrench)
+  {
+    for (Eigen::Index i = 0; i < 6; ++i)
+    {
+      const double value = wrench[i];
+      if (!std::isfinite(value))
+      {
+        continue;
+      }
+      counts_[i] += 1.0;
+      const double delta = value - mean_[i];
+      mean_[i] += delta / counts_[i];
+      squared_deviations_[i] += delta * (value - mean_[i]);
+      min_[i] = std::min(min_[i], value);
+      max_[i] = std::max(max_[i], value);
+    }
+  }
+
+  /// Number of samples of \p axis in the window
+  size_t count(Eigen::Index axis) const { return static_cast<size_t>(counts_[axis]); }
+
+  /// Mean of \p axis, zero without samples
+  double mean(Eigen::Index axis) const { return mean_[axis]; }
+
+  /// Unbiased variance of \p axis, zero with less than two samples
+  double variance(Eigen::Index axis) const
+  {
+    return counts_[axis] > 1.0 ? squared_deviations_[axis] / (counts_[axis] - 1.0) : 0.0;
+  }
+
+  double stddev(Eigen::Index axis) const { return std::sqrt(variance(axis)); }
+
+  /// Minimum of \p axis, NaN without samples
+  double min(Eigen::Index axis) const
+  {
+    return counts_[axis] > 0.0 ? min_[axis] : std::numeric_limits<double>::quiet_NaN();
+  }
+
+  /// Maximum of \p axis, NaN without samples
+  double max(Eigen::Index axis) const
+  {
+    return counts_[axis] > 0.0 ? max_[axis] : std::numeric_limits<double>::quiet_NaN();
+  }
+
+private:
+  // the counts are doubles, so the updates don't convert between integers and doubles
+  Vector6d counts_;
+  Vector6d mean_;
+  // sum of the squared deviations from the mean
+  Vector6d squared_deviations_;
+  Vector6d min_;
+  Vector6d max_;
+};
+
+}  // namespace force_torque_sensor_broadcaster
+
+#endif  // FORCE_TORQUE_SENSOR_BROADCASTER__WRENCH_STATISTICS_HPP_
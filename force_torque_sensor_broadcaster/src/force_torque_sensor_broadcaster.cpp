@@ -18,15 +18,20 @@
 
 #include "force_torque_sensor_broadcaster/force_torque_sensor_broadcaster.hpp"
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
+#include <utility>
+
+#include <Eigen/Geometry>
+
+#include "statistics_msgs/msg/statistic_data_type.hpp"
 
 namespace force_torque_sensor_broadcaster
 {
-ForceTorqueSensorBroadcaster::ForceTorqueSensorBroadcaster()
-: controller_interface::ControllerInterface()
-{
-}
+ForceTorqueSensorBroadcaster::ForceTorqueSensorBroadcaster() : Base() {}
 
 controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_init()
 {
@@ -72,31 +77,29 @@ controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_configure(
 
   if (!params_.sensor_name.empty())
   {
-    force_torque_sensor_ = std::make_unique<semantic_components::ForceTorqueSensor>(
+    semantic_component_ = std::make_unique<semantic_components::ForceTorqueSensor>(
       semantic_components::ForceTorqueSensor(params_.sensor_name));
   }
   else
   {
     auto const & force_names = params_.interface_names.force;
     auto const & torque_names = params_.interface_names.torque;
-    force_torque_sensor_ = std::make_unique<semantic_components::ForceTorqueSensor>(
+    semantic_component_ = std::make_unique<semantic_components::ForceTorqueSensor>(
       semantic_components::ForceTorqueSensor(
         force_names.x, force_names.y, force_names.z, torque_names.x, torque_names.y,
         torque_names.z));
   }
 
-  try
+  semantic_component_broadcaster::BroadcasterOptions options;
+  options.publish_rate = params_.publish_rate;
+  options.publish_on_change = params_.publish_on_change;
+  options.sequence_interface_name = params_.sequence_interface_name;
+  options.publisher_thread = params_.publisher_thread.enable;
+  options.queue_size = static_cast<size_t>(params_.publisher_thread.queue_size);
+  options.batch_size = static_cast<size_t>(params_.publisher_thread.batch_size);
+  options.publish_unique_ptr = params_.publisher_thread.publish_unique_ptr;
+  if (!configure_broadcaster("~/wrench", options))
   {
-    // register ft sensor data publisher
-    sensor_state_publisher_ = get_node()->create_publisher<geometry_msgs::msg::WrenchStamped>(
-      "~/wrench", rclcpp::SystemDefaultsQoS());
-    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_);
-  }
-  catch (const std::exception & e)
-  {
-    fprintf(
-      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
-      e.what());
     return controller_interface::CallbackReturn::ERROR;
   }
 
@@ -104,52 +107,385 @@ controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_configure(
   realtime_publisher_->msg_.header.frame_id = params_.frame_id;
   realtime_publisher_->unlock();
 
+  realtime_wrench_batch_publisher_.reset();
+  if (params_.wrench_batch.enable)
+  {
+    try
+    {
+      wrench_batch_publisher_ = get_node()->create_publisher<trajectory_msgs::msg::JointTrajectory>(
+        "~/wrench_batch", rclcpp::SystemDefaultsQoS());
+      realtime_wrench_batch_publisher_ = std::make_unique<BatchPublisher>(wrench_batch_publisher_);
+    }
+    catch (const std::exception & e)
+    {
+      fprintf(
+        stderr,
+        "Exception thrown during publisher creation at configure stage with message : %s \n",
+        e.what());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+  init_wrench_batch_msg();
+
+  if (!configure_wrench_statistics())
+  {
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  if (!configure_filtered_wrench())
+  {
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
   RCLCPP_DEBUG(get_node()->get_logger(), "configure successful");
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
-controller_interface::InterfaceConfiguration
-ForceTorqueSensorBroadcaster::command_interface_configuration() const
+std::vector<std::string> ForceTorqueSensorBroadcaster::get_sensor_state_interface_names() const
 {
-  controller_interface::InterfaceConfiguration command_interfaces_config;
-  command_interfaces_config.type = controller_interface::interface_configuration_type::NONE;
-  return command_interfaces_config;
-}
-
-controller_interface::InterfaceConfiguration
-ForceTorqueSensorBroadcaster::state_interface_configuration() const
-{
-  controller_interface::InterfaceConfiguration state_interfaces_config;
-  state_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-  state_interfaces_config.names = force_torque_sensor_->get_state_interface_names();
-  return state_interfaces_config;
+  auto names = Base::get_sensor_state_interface_names();
+  if (!params_.timestamp_interface_name.empty())
+  {
+    names.push_back(params_.timestamp_interface_name);
+  }
+  return names;
 }
 
 controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_activate(
-  const rclcpp_lifecycle::State & /*previous_state*/)
+  const rclcpp_lifecycle::State & previous_state)
 {
-  force_torque_sensor_->assign_loaned_state_interfaces(state_interfaces_);
+  if (Base::on_activate(previous_state) != controller_interface::CallbackReturn::SUCCESS)
+  {
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  timestamp_interface_ = nullptr;
+  if (!params_.timestamp_interface_name.empty())
+  {
+    for (const auto & state_interface : state_interfaces_)
+    {
+      if (state_interface.get_name() == params_.timestamp_interface_name)
+      {
+        timestamp_interface_ = &state_interface;
+      }
+    }
+    if (timestamp_interface_ == nullptr)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Timestamp state interface '%s' is not available.",
+        params_.timestamp_interface_name.c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+
+  // a batch is never continued after a pause, and the filters restart with the next sample
+  wrench_batch_num_samples_ = 0;
+  wrench_statistics_num_samples_ = 0;
+  wrench_statistics_.reset();
+  wrench_filter_chain_.reset();
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
 controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_deactivate(
-  const rclcpp_lifecycle::State & /*previous_state*/)
+  const rclcpp_lifecycle::State & previous_state)
 {
-  force_torque_sensor_->release_interfaces();
-  return controller_interface::CallbackReturn::SUCCESS;
+  timestamp_interface_ = nullptr;
+  return Base::on_deactivate(previous_state);
 }
 
 controller_interface::return_type ForceTorqueSensorBroadcaster::update(
-  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  sample_time_ = get_sample_time(time);
+  semantic_component_->get_values_as_message(wrench_);
+
+  // the batches and filters see every sample, the publishing options only apply to the wrench
+  if (realtime_wrench_batch_publisher_)
+  {
+    add_wrench_batch_sample(sample_time_);
+  }
+  if (!realtime_statistics_publishers_.empty())
+  {
+    add_wrench_statistics_sample(sample_time_);
+  }
+
+  if (realtime_filtered_publisher_)
+  {
+    // the filters have to see every sample, also if the message can't be published
+    update_filtered_wrench();
+    if (realtime_filtered_publisher_->trylock())
+    {
+      auto & wrench = realtime_filtered_publisher_->msg_.wrench;
+      realtime_filtered_publisher_->msg_.header.stamp = sample_time_;
+      wrench.force.x = filtered_wrench_[0];
+      wrench.force.y = filtered_wrench_[1];
+      wrench.force.z = filtered_wrench_[2];
+      wrench.torque.x = filtered_wrench_[3];
+      wrench.torque.y = filtered_wrench_[4];
+      wrench.torque.z = filtered_wrench_[5];
+      realtime_filtered_publisher_->unlockAndPublish();
+    }
+  }
+
+  return Base::update(time, period);
+}
+
+void ForceTorqueSensorBroadcaster::fill_message(
+  const rclcpp::Time & /*time*/, geometry_msgs::msg::WrenchStamped & message)
+{
+  message.header.stamp = sample_time_;
+  message.wrench = wrench_;
+}
+
+rclcpp::Time ForceTorqueSensorBroadcaster::get_sample_time(const rclcpp::Time & time) const
+{
+  if (timestamp_interface_ == nullptr)
+  {
+    return time;
+  }
+  const double seconds = timestamp_interface_->get_value();
+  // e.g., before the hardware received the first sample
+  if (!std::isfinite(seconds) || seconds < 0.0)
+  {
+    return time;
+  }
+  return rclcpp::Time(static_cast<int64_t>(std::llround(seconds * 1e9)), time.get_clock_type());
+}
+
+bool ForceTorqueSensorBroadcaster::configure_filtered_wrench()
+{
+  realtime_filtered_publisher_.reset();
+  tare_service_.reset();
+  const auto & filtered_params = params_.filtered_wrench;
+  if (!filtered_params.enable)
+  {
+    return true;
+  }
+
+  const auto & filter_chain = filtered_params.filter_chain;
+  std::string error;
+  if (!wrench_filter_chain_.configure(
+        filter_chain.types, filter_chain.frequencies, filter_chain.notch_quality_factor,
+        static_cast<size_t>(filter_chain.median_window_size), filter_chain.sampling_frequency,
+        error))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Invalid 'filtered_wrench.filter_chain' parameters: %s",
+      error.c_str());
+    return false;
+  }
+
+  for (Eigen::Index i = 0; i < 6; ++i)
+  {
+    bias_[i] = filtered_params.bias[static_cast<size_t>(i)];
+  }
+  const auto & rotation = filtered_params.frame.rotation;
+  filtered_frame_rotation_ = (Eigen::AngleAxisd(rotation[2], Eigen::Vector3d::UnitZ()) *
+                              Eigen::AngleAxisd(rotation[1], Eigen::Vector3d::UnitY()) *
+                              Eigen::AngleAxisd(rotation[0], Eigen::Vector3d::UnitX()))
+                               .toRotationMatrix();
+  const auto & translation = filtered_params.frame.translation;
+  filtered_frame_translation_ = Eigen::Vector3d(translation[0], translation[1], translation[2]);
+  tare_requested_ = false;
+
+  try
+  {
+    filtered_publisher_ = get_node()->create_publisher<geometry_msgs::msg::WrenchStamped>(
+      "~/wrench_filtered", rclcpp::SystemDefaultsQoS());
+    realtime_filtered_publisher_ = std::make_unique<StatePublisher>(filtered_publisher_);
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(
+      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
+      e.what());
+    return false;
+  }
+  realtime_filtered_publisher_->lock();
+  realtime_filtered_publisher_->msg_.header.frame_id =
+    filtered_params.frame.id.empty() ? params_.frame_id : filtered_params.frame.id;
+  realtime_filtered_publisher_->unlock();
+
+  tare_service_ = get_node()->create_service<std_srvs::srv::Empty>(
+    "~/tare", [this](
+                const std::shared_ptr<std_srvs::srv::Empty::Request>,
+                std::shared_ptr<std_srvs::srv::Empty::Response>) { tare_requested_ = true; });
+  return true;
+}
+
+void ForceTorqueSensorBroadcaster::update_filtered_wrench()
+{
+  // missing axes are zero, so that they don't spread into the others by the transformation
+  auto value_or_zero = [](const double value) { return std::isfinite(value) ? value : 0.0; };
+  filtered_wrench_ << value_or_zero(wrench_.force.x), value_or_zero(wrench_.force.y),
+    value_or_zero(wrench_.force.z), value_or_zero(wrench_.torque.x),
+    value_or_zero(wrench_.torque.y), value_or_zero(wrench_.torque.z);
+  wrench_filter_chain_.update(filtered_wrench_);
+
+  if (tare_requested_.exchange(false))
+  {
+    bias_ = filtered_wrench_;
+  }
+  filtered_wrench_ -= bias_;
+
+  const Eigen::Vector3d force = filtered_frame_rotation_ * filtered_wrench_.head<3>();
+  const Eigen::Vector3d torque = filtered_frame_rotation_ * filtered_wrench_.tail<3>() +
+                                 filtered_frame_translation_.cross(force);
+  filtered_wrench_.head<3>() = force;
+  filtered_wrench_.tail<3>() = torque;
+}
+
+void ForceTorqueSensorBroadcaster::init_wrench_batch_msg()
+{
+  wrench_batch_num_samples_ = 0;
+  dropped_wrench_batches_ = 0;
+  if (!realtime_wrench_batch_publisher_)
+  {
+    return;
+  }
+
+  trajectory_msgs::msg::JointTrajectoryPoint point;
+  point.effort.resize(6, std::numeric_limits<double>::quiet_NaN());
+
+  wrench_batch_msg_.header.frame_id = params_.frame_id;
+  wrench_batch_msg_.joint_names = {"force.x",  "force.y",  "force.z",
+                                   "torque.x", "torque.y", "torque.z"};
+  wrench_batch_msg_.points.assign(static_cast<size_t>(params_.wrench_batch.size), point);
+  // both are swapped when a batch is published, so they have to have the same size
+  realtime_wrench_batch_publisher_->msg_ = wrench_batch_msg_;
+}
+
+bool ForceTorqueSensorBroadcaster::configure_wrench_statistics()
+{
+  realtime_statistics_publishers_.clear();
+  wrench_statistics_num_samples_ = 0;
+  wrench_statistics_.reset();
+  if (!params_.wrench_statistics.enable)
+  {
+    return true;
+  }
+
+  try
+  {
+    wrench_statistics_publisher_ =
+      get_node()->create_publisher<statistics_msgs::msg::MetricsMessage>(
+        "~/wrench_statistics", rclcpp::SystemDefaultsQoS());
+    for (size_t axis = 0; axis < 6; ++axis)
+    {
+      realtime_statistics_publishers_.push_back(
+        std::make_unique<StatisticsPublisher>(wrench_statistics_publisher_));
+    }
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(
+      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
+      e.what());
+    realtime_statistics_publishers_.clear();
+    return false;
+  }
+
+  using statistics_msgs::msg::StatisticDataType;
+  const char * sources[] = {"force.x", "force.y", "force.z", "torque.x", "torque.y", "torque.z"};
+  for (size_t axis = 0; axis < 6; ++axis)
+  {
+    auto & publisher = realtime_statistics_publishers_[axis];
+    publisher->lock();
+    auto & msg = publisher->msg_;
+    msg.measurement_source_name = params_.frame_id;
+    msg.metrics_source = sources[axis];
+    msg.unit = axis < 3 ? "N" : "Nm";
+    msg.statistics.resize(5);
+    msg.statistics[0].data_type = StatisticDataType::STATISTICS_DATA_TYPE_AVERAGE;
+    msg.statistics[1].data_type = StatisticDataType::STATISTICS_DATA_TYPE_MINIMUM;
+    msg.statistics[2].data_type = StatisticDataType::STATISTICS_DATA_TYPE_MAXIMUM;
+    msg.statistics[3].data_type = StatisticDataType::STATISTICS_DATA_TYPE_STDDEV;
+    msg.statistics[4].data_type = StatisticDataType::STATISTICS_DATA_TYPE_SAMPLE_COUNT;
+    publisher->unlock();
+  }
+  return true;
+}
+
+void ForceTorqueSensorBroadcaster::add_wrench_statistics_sample(const rclcpp::Time & sample_time)
+{
+  if (wrench_statistics_num_samples_ == 0)
+  {
+    wrench_statistics_window_start_ = sample_time;
+  }
+  WrenchStatistics::Vector6d wrench;
+  wrench << wrench_.force.x, wrench_.force.y, wrench_.force.z, wrench_.torque.x,
+    wrench_.torque.y, wrench_.torque.z;
+  wrench_statistics_.add(wrench);
+  if (++wrench_statistics_num_samples_ < static_cast<size_t>(params_.wrench_statistics.window_size))
+  {
+    return;
+  }
+
+  // the components are published together, else the window continues until the next update
+  size_t num_locked = 0;
+  while (num_locked < realtime_statistics_publishers_.size() &&
+         realtime_statistics_publishers_[num_locked]->trylock())
+  {
+    ++num_locked;
+  }
+  if (num_locked < realtime_statistics_publishers_.size())
+  {
+    for (size_t axis = 0; axis < num_locked; ++axis)
+    {
+      realtime_statistics_publishers_[axis]->unlock();
+    }
+    return;
+  }
+
+  for (size_t axis = 0; axis < realtime_statistics_publishers_.size(); ++axis)
+  {
+    const auto index = static_cast<Eigen::Index>(axis);
+    auto & msg = realtime_statistics_publishers_[axis]->msg_;
+    msg.window_start = wrench_statistics_window_start_;
+    msg.window_stop = sample_time;
+    msg.statistics[0].data = wrench_statistics_.mean(index);
+    msg.statistics[1].data = wrench_statistics_.min(index);
+    msg.statistics[2].data = wrench_statistics_.max(index);
+    msg.statistics[3].data = wrench_statistics_.stddev(index);
+    msg.statistics[4].data = static_cast<double>(wrench_statistics_.count(index));
+    realtime_statistics_publishers_[axis]->unlockAndPublish();
+  }
+  wrench_statistics_.reset();
+  wrench_statistics_num_samples_ = 0;
+}
+
+void ForceTorqueSensorBroadcaster::add_wrench_batch_sample(const rclcpp::Time & sample_time)
 {
-  if (realtime_publisher_ && realtime_publisher_->trylock())
+  if (wrench_batch_num_samples_ == 0)
   {
-    realtime_publisher_->msg_.header.stamp = time;
-    force_torque_sensor_->get_values_as_message(realtime_publisher_->msg_.wrench);
-    realtime_publisher_->unlockAndPublish();
+    wrench_batch_msg_.header.stamp = sample_time;
   }
+  auto & point = wrench_batch_msg_.points[wrench_batch_num_samples_];
+  const rclcpp::Time batch_start_time(
+    wrench_batch_msg_.header.stamp, sample_time.get_clock_type());
+  point.time_from_start = sample_time - batch_start_time;
+  point.effort[0] = wrench_.force.x;
+  point.effort[1] = wrench_.force.y;
+  point.effort[2] = wrench_.force.z;
+  point.effort[3] = wrench_.torque.x;
+  point.effort[4] = wrench_.torque.y;
+  point.effort[5] = wrench_.torque.z;
 
-  return controller_interface::return_type::OK;
+  if (++wrench_batch_num_samples_ < wrench_batch_msg_.points.size())
+  {
+    return;
+  }
+  wrench_batch_num_samples_ = 0;
+  if (realtime_wrench_batch_publisher_->trylock())
+  {
+    // no copy, the previously published message is reused for the next batch
+    std::swap(realtime_wrench_batch_publisher_->msg_, wrench_batch_msg_);
+    realtime_wrench_batch_publisher_->unlockAndPublish();
+  }
+  else
+  {
+    ++dropped_wrench_batches_;
+  }
 }
 
 }  // namespace force_torque_sensor_broadcaster
@@ -18,7 +18,12 @@
 
 #include "test_force_torque_sensor_broadcaster.hpp"
 
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -30,6 +35,8 @@
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/utilities.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+#include "statistics_msgs/msg/metrics_message.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
 
 using hardware_interface::LoanedStateInterface;
 using testing::IsEmpty;
@@ -323,6 +330,206 @@ TEST_F(ForceTorqueSensorBroadcasterTest, All_InterfaceNames_Publish_Success)
   ASSERT_EQ(wrench_msg.wrench.torque.z, sensor_values_[5]);
 }
 
+TEST_F(ForceTorqueSensorBroadcasterTest, HardwareTimestamp_Batch_Publish_Success)
+{
+  ASSERT_EQ(
+    fts_broadcaster_->init("test_force_torque_sensor_broadcaster", "", 0),
+    controller_interface::return_type::OK);
+  fts_broadcaster_->get_node()->declare_parameter("sensor_name", sensor_name_);
+  fts_broadcaster_->get_node()->declare_parameter("frame_id", frame_id_);
+  fts_broadcaster_->get_node()->declare_parameter(
+    "timestamp_interface_name", "fts_sensor/timestamp");
+  fts_broadcaster_->get_node()->declare_parameter("wrench_batch.enable", true);
+  fts_broadcaster_->get_node()->declare_parameter("wrench_batch.size", 3);
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  EXPECT_EQ(
+    fts_broadcaster_->state_interface_configuration().names.back(), "fts_sensor/timestamp");
+
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(fts_force_x_);
+  state_ifs.emplace_back(fts_force_y_);
+  state_ifs.emplace_back(fts_force_z_);
+  state_ifs.emplace_back(fts_torque_x_);
+  state_ifs.emplace_back(fts_torque_y_);
+  state_ifs.emplace_back(fts_torque_z_);
+  state_ifs.emplace_back(fts_timestamp_);
+  fts_broadcaster_->assign_interfaces({}, std::move(state_ifs));
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription =
+    test_subscription_node.create_subscription<trajectory_msgs::msg::JointTrajectory>(
+      "/test_force_torque_sensor_broadcaster/wrench_batch", 10,
+      [](const trajectory_msgs::msg::JointTrajectory::SharedPtr) {});
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+
+  // the samples are stamped with the hardware time, not with the time of the updates
+  for (int sample = 0; sample < 3; ++sample)
+  {
+    timestamp_value_ = 10.0 + 0.25e-3 * sample;
+    sensor_values_[2] = static_cast<double>(sample);
+    ASSERT_EQ(
+      fts_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    EXPECT_EQ(fts_broadcaster_->wrench_batch_num_samples_, static_cast<size_t>((sample + 1) % 3));
+  }
+  ASSERT_EQ(
+    wait_set.wait(std::chrono::milliseconds(100)).kind(), rclcpp::WaitResultKind::Ready);
+
+  trajectory_msgs::msg::JointTrajectory batch_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(batch_msg, msg_info));
+  EXPECT_EQ(batch_msg.header.frame_id, frame_id_);
+  EXPECT_EQ(rclcpp::Time(batch_msg.header.stamp).nanoseconds(), 10000000000);
+  EXPECT_THAT(batch_msg.joint_names, SizeIs(6));
+  ASSERT_THAT(batch_msg.points, SizeIs(3));
+  for (size_t sample = 0; sample < 3; ++sample)
+  {
+    const auto & point = batch_msg.points[sample];
+    EXPECT_EQ(
+      rclcpp::Duration(point.time_from_start).nanoseconds(), static_cast<int64_t>(250000 * sample));
+    ASSERT_THAT(point.effort, SizeIs(6));
+    EXPECT_EQ(point.effort[0], sensor_values_[0]);
+    EXPECT_EQ(point.effort[2], static_cast<double>(sample));
+    EXPECT_EQ(point.effort[5], sensor_values_[5]);
+  }
+  EXPECT_EQ(fts_broadcaster_->dropped_wrench_batches_, 0u);
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, FilteredWrench_BiasAndFrame_Success)
+{
+  SetUpFTSBroadcaster();
+  fts_broadcaster_->get_node()->declare_parameter("sensor_name", sensor_name_);
+  fts_broadcaster_->get_node()->declare_parameter("frame_id", frame_id_);
+  fts_broadcaster_->get_node()->declare_parameter("filtered_wrench.enable", true);
+  fts_broadcaster_->get_node()->declare_parameter(
+    "filtered_wrench.filter_chain.types", std::vector<std::string>{"lowpass"});
+  fts_broadcaster_->get_node()->declare_parameter(
+    "filtered_wrench.filter_chain.frequencies", std::vector<double>{10.0});
+  fts_broadcaster_->get_node()->declare_parameter(
+    "filtered_wrench.bias", std::vector<double>{1.0, 2.0, 3.0, 0.0, 0.0, 0.0});
+  fts_broadcaster_->get_node()->declare_parameter("filtered_wrench.frame.id", "tool");
+  fts_broadcaster_->get_node()->declare_parameter(
+    "filtered_wrench.frame.translation", std::vector<double>{0.0, 0.0, 1.0});
+  fts_broadcaster_->get_node()->declare_parameter(
+    "filtered_wrench.frame.rotation", std::vector<double>{0.0, 0.0, M_PI_2});
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  EXPECT_EQ(fts_broadcaster_->realtime_filtered_publisher_->msg_.header.frame_id, "tool");
+
+  // the first sample initializes the low-pass filter, so a constant wrench isn't attenuated
+  sensor_values_ = {1.5, 2.0, 4.0, 0.5, 0.0, 0.0};
+  ASSERT_EQ(
+    fts_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.001)),
+    controller_interface::return_type::OK);
+  // [0.5, 0, 1, 0.5, 0, 0] without bias, rotated by 90 degrees around z and moved along z
+  const auto & wrench = fts_broadcaster_->filtered_wrench_;
+  EXPECT_NEAR(wrench[0], 0.0, 1e-12);
+  EXPECT_NEAR(wrench[1], 0.5, 1e-12);
+  EXPECT_NEAR(wrench[2], 1.0, 1e-12);
+  EXPECT_NEAR(wrench[3], -0.5, 1e-12);
+  EXPECT_NEAR(wrench[4], 0.5, 1e-12);
+  EXPECT_NEAR(wrench[5], 0.0, 1e-12);
+
+  // the filtered wrench of the next sample becomes the bias
+  fts_broadcaster_->tare_requested_ = true;
+  ASSERT_EQ(
+    fts_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.001)),
+    controller_interface::return_type::OK);
+  EXPECT_FALSE(fts_broadcaster_->tare_requested_);
+  EXPECT_NEAR(wrench.norm(), 0.0, 1e-12);
+  EXPECT_NEAR(fts_broadcaster_->bias_[2], 4.0, 1e-12);
+}
+
+TEST(WrenchStatisticsTest, MeanVarianceMinMax_SkipNaN)
+{
+  force_torque_sensor_broadcaster::WrenchStatistics statistics;
+  EXPECT_EQ(statistics.count(0), 0u);
+  EXPECT_TRUE(std::isnan(statistics.min(0)));
+
+  force_torque_sensor_broadcaster::WrenchStatistics::Vector6d wrench;
+  for (const double value : {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0})
+  {
+    wrench.setConstant(value);
+    wrench[5] = std::numeric_limits<double>::quiet_NaN();
+    statistics.add(wrench);
+  }
+  EXPECT_EQ(statistics.count(0), 8u);
+  EXPECT_DOUBLE_EQ(statistics.mean(0), 5.0);
+  EXPECT_DOUBLE_EQ(statistics.variance(0), 32.0 / 7.0);
+  EXPECT_DOUBLE_EQ(statistics.min(4), 2.0);
+  EXPECT_DOUBLE_EQ(statistics.max(4), 9.0);
+  // the missing component has no samples
+  EXPECT_EQ(statistics.count(5), 0u);
+  EXPECT_DOUBLE_EQ(statistics.mean(5), 0.0);
+  EXPECT_DOUBLE_EQ(statistics.variance(5), 0.0);
+
+  statistics.reset();
+  EXPECT_EQ(statistics.count(0), 0u);
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, WrenchStatistics_Publish_Success)
+{
+  SetUpFTSBroadcaster();
+  fts_broadcaster_->get_node()->declare_parameter("sensor_name", sensor_name_);
+  fts_broadcaster_->get_node()->declare_parameter("frame_id", frame_id_);
+  fts_broadcaster_->get_node()->declare_parameter("wrench_statistics.enable", true);
+  fts_broadcaster_->get_node()->declare_parameter("wrench_statistics.window_size", 3);
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription =
+    test_subscription_node.create_subscription<statistics_msgs::msg::MetricsMessage>(
+      "/test_force_torque_sensor_broadcaster/wrench_statistics", 10,
+      [](const statistics_msgs::msg::MetricsMessage::SharedPtr) {});
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+
+  for (int sample = 0; sample < 3; ++sample)
+  {
+    sensor_values_[2] = static_cast<double>(sample + 1);
+    ASSERT_EQ(
+      fts_broadcaster_->update(
+        rclcpp::Time(10000000 * sample), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  }
+  EXPECT_EQ(fts_broadcaster_->wrench_statistics_num_samples_, 0u);
+
+  // one message for every component of the window
+  size_t num_msgs = 0;
+  statistics_msgs::msg::MetricsMessage msg;
+  rclcpp::MessageInfo msg_info;
+  while (num_msgs < 6 &&
+         wait_set.wait(std::chrono::milliseconds(100)).kind() == rclcpp::WaitResultKind::Ready)
+  {
+    while (subscription->take(msg, msg_info))
+    {
+      ++num_msgs;
+      EXPECT_EQ(msg.measurement_source_name, frame_id_);
+      ASSERT_THAT(msg.statistics, SizeIs(5));
+      EXPECT_EQ(rclcpp::Time(msg.window_stop).nanoseconds(), 20000000);
+      EXPECT_DOUBLE_EQ(msg.statistics[4].data, 3.0);
+      if (msg.metrics_source == "force.z")
+      {
+        EXPECT_EQ(msg.unit, "N");
+        EXPECT_DOUBLE_EQ(msg.statistics[0].data, 2.0);
+        EXPECT_DOUBLE_EQ(msg.statistics[1].data, 1.0);
+        EXPECT_DOUBLE_EQ(msg.statistics[2].data, 3.0);
+        EXPECT_DOUBLE_EQ(msg.statistics[3].data, 1.0);
+      }
+      else if (msg.metrics_source == "torque.z")
+      {
+        EXPECT_EQ(msg.unit, "Nm");
+        EXPECT_DOUBLE_EQ(msg.statistics[0].data, sensor_values_[5]);
+        EXPECT_DOUBLE_EQ(msg.statistics[3].data, 0.0);
+      }
+    }
+  }
+  EXPECT_EQ(num_msgs, 6u);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
@@ -39,6 +39,9 @@ class FriendForceTorqueSensorBroadcaster
   FRIEND_TEST(ForceTorqueSensorBroadcasterTest, SensorName_ActivateDeactivate_Success);
   FRIEND_TEST(ForceTorqueSensorBroadcasterTest, UpdateTest);
   FRIEND_TEST(ForceTorqueSensorBroadcasterTest, SensorStatePublishTest);
+  FRIEND_TEST(ForceTorqueSensorBroadcasterTest, HardwareTimestamp_Batch_Publish_Success);
+  FRIEND_TEST(ForceTorqueSensorBroadcasterTest, FilteredWrench_BiasAndFrame_Success);
+  FRIEND_TEST(ForceTorqueSensorBroadcasterTest, WrenchStatistics_Publish_Success);
 };
 
 class ForceTorqueSensorBroadcasterTest : public ::testing::Test
@@ -63,6 +66,8 @@ protected:
   hardware_interface::StateInterface fts_torque_x_{sensor_name_, "torque.x", &sensor_values_[3]};
   hardware_interface::StateInterface fts_torque_y_{sensor_name_, "torque.y", &sensor_values_[4]};
   hardware_interface::StateInterface fts_torque_z_{sensor_name_, "torque.z", &sensor_values_[5]};
+  double timestamp_value_ = 0.0;
+  hardware_interface::StateInterface fts_timestamp_{sensor_name_, "timestamp", &timestamp_value_};
 
   std::unique_ptr<FriendForceTorqueSensorBroadcaster> fts_broadcaster_;
 
@@ -0,0 +1,171 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FORWARD_COMMAND_CONTROLLER__COMMAND_SCHEDULE_HPP_
+#define FORWARD_COMMAND_CONTROLLER__COMMAND_SCHEDULE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace forward_command_controller
+{
+/**
+ * \brief Commands scheduled for a time, ordered by their time.
+ *
+ * The topic callback (producer) pushes the commands of a msg into a lock-free single-producer/
+ * single-consumer ring, the realtime loop (consumer) sorts them into the schedule and takes the
+ * commands whose time has come. The first command of a msg replaces the commands scheduled at or
+ * after its time, so a sender may resend the future commands with corrections. The commands are
+ * swapped between slots preallocated by resize(), so neither side allocates memory.
+ */
+class CommandSchedule
+{
+public:
+  /// Preallocate \p capacity commands of \p num_values values, not realtime-safe
+  void resize(size_t capacity, size_t num_values)
+  {
+    ring_.assign(capacity, Command{0, false, std::vector<double>(num_values, 0.0)});
+    schedule_.assign(capacity, Command{0, false, std::vector<double>(num_values, 0.0)});
+    num_values_ = num_values;
+    num_scheduled_ = 0;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+  }
+
+  /// Append a command scheduled for \p stamp_ns, only for the producer
+  /**
+   * \param replaces_later true for the first command of a msg, which replaces the commands
+   * scheduled at or after \p stamp_ns.
+   * \return false if the ring is full or \p values doesn't have the size of the commands
+   */
+  bool push(int64_t stamp_ns, const std::vector<double> & values, bool replaces_later)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (
+      values.size() != num_values_ || ring_.empty() ||
+      head - tail_.load(std::memory_order_acquire) >= ring_.size())
+    {
+      return false;
+    }
+    auto & command = ring_[head % ring_.size()];
+    command.stamp_ns = stamp_ns;
+    command.replaces_later = replaces_later;
+    command.values.assign(values.begin(), values.end());
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Take all commands scheduled until \p time_ns, only for the consumer, realtime-safe
+  /**
+   * \param[out] values Values of the latest command taken, it has to have the size of the
+   * commands already.
+   * \return false if no command is scheduled until \p time_ns, \p values is unchanged then.
+   */
+  bool pop_until(int64_t time_ns, std::vector<double> & values)
+  {
+    schedule_pushed_commands();
+    const auto scheduled_end = schedule_.begin() + static_cast<std::ptrdiff_t>(num_scheduled_);
+    const auto due_end = std::upper_bound(
+      schedule_.begin(), scheduled_end, time_ns,
+      [](int64_t time, const Command & command) { return time < command.stamp_ns; });
+    if (due_end == schedule_.begin())
+    {
+      return false;
+    }
+    values.assign(std::prev(due_end)->values.begin(), std::prev(due_end)->values.end());
+    // the slots of the taken commands are reused at the end
+    std::rotate(schedule_.begin(), due_end, scheduled_end);
+    num_scheduled_ -= static_cast<size_t>(due_end - schedule_.begin());
+    return true;
+  }
+
+  /// Drop all commands, only for the consumer
+  void clear()
+  {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    num_scheduled_ = 0;
+  }
+
+  /// Number of commands in the schedule, only for the consumer
+  size_t num_scheduled() const { return num_scheduled_; }
+
+  /// Number of commands dropped because the schedule was full, only for the consumer
+  uint64_t num_dropped() const { return num_dropped_; }
+
+private:
+  struct Command
+  {
+    int64_t stamp_ns;
+    bool replaces_later;
+    std::vector<double> values;
+  };
+
+  // sort the commands of the ring into the schedule
+  void schedule_pushed_commands()
+  {
+    const size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail)
+    {
+      schedule(ring_[tail % ring_.size()]);
+    }
+    tail_.store(tail, std::memory_order_release);
+  }
+
+  void schedule(Command & command)
+  {
+    const auto by_stamp = [](const Command & lhs, const Command & rhs)
+    { return lhs.stamp_ns < rhs.stamp_ns; };
+    auto scheduled_end = schedule_.begin() + static_cast<std::ptrdiff_t>(num_scheduled_);
+    if (command.replaces_later)
+    {
+      scheduled_end = std::lower_bound(schedule_.begin(), scheduled_end, command, by_stamp);
+      num_scheduled_ = static_cast<size_t>(scheduled_end - schedule_.begin());
+    }
+    // after the commands of the same time, which were pushed before
+    const auto position = std::upper_bound(schedule_.begin(), scheduled_end, command, by_stamp);
+    if (num_scheduled_ == schedule_.size())
+    {
+      ++num_dropped_;
+      // the latest command is dropped, which is the new one if it is after all others
+      if (position == scheduled_end)
+      {
+        return;
+      }
+      --scheduled_end;
+      --num_scheduled_;
+    }
+    scheduled_end->stamp_ns = command.stamp_ns;
+    scheduled_end->values.swap(command.values);
+    std::rotate(position, scheduled_end, std::next(scheduled_end));
+    ++num_scheduled_;
+  }
+
+  std::vector<Command> ring_;
+  size_t num_values_ = 0;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  // sorted by time, the first num_scheduled_ slots are used
+  std::vector<Command> schedule_;
+  size_t num_scheduled_ = 0;
+  uint64_t num_dropped_ = 0;
+};
+
+}  // namespace forward_command_controller
+
+#endif  // FORWARD_COMMAND_CONTROLLER__COMMAND_SCHEDULE_HPP_
@@ -15,17 +15,22 @@
 #ifndef FORWARD_COMMAND_CONTROLLER__FORWARD_CONTROLLERS_BASE_HPP_
 #define FORWARD_COMMAND_CONTROLLER__FORWARD_CONTROLLERS_BASE_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
-#include "controller_interface/controller_interface.hpp"
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "forward_command_controller/command_schedule.hpp"
 #include "forward_command_controller/visibility_control.h"
 #include "rclcpp/subscription.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 #include "realtime_tools/realtime_buffer.h"
+#include "shm_command_ingress/shm_command_ring.hpp"
 #include "std_msgs/msg/float64_multi_array.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
 
 namespace forward_command_controller
 {
@@ -35,11 +40,17 @@ using CmdType = std_msgs::msg::Float64MultiArray;
  * \brief Forward command controller for a set of joints and interfaces.
  *
  * This class forwards the command signal down to a set of joints or interfaces.
+ * The commands are staged in the reference interfaces, which are exported for chaining, so an
+ * upstream controller can write them directly instead of publishing to the topic.
  *
  * Subscribes to:
  * - \b commands (std_msgs::msg::Float64MultiArray) : The commands to apply.
+ * - \b scheduled_commands (trajectory_msgs::msg::JointTrajectory) : Commands to apply at the time
+ *   of their points, if enabled.
+ *
+ * Polls a shared memory ring of commands written by other processes, if enabled.
  */
-class ForwardControllersBase : public controller_interface::ControllerInterface
+class ForwardControllersBase : public controller_interface::ChainableControllerInterface
 {
 public:
   FORWARD_COMMAND_CONTROLLER_PUBLIC
@@ -70,10 +81,18 @@ public:
     const rclcpp_lifecycle::State & previous_state) override;
 
   FORWARD_COMMAND_CONTROLLER_PUBLIC
-  controller_interface::return_type update(
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
 protected:
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
   /**
    * Derived controllers have to declare parameters in this method.
    * Error handling does not have to be done. It is done in `on_init`-method of this class.
@@ -92,13 +111,118 @@ protected:
    */
   virtual controller_interface::CallbackReturn read_parameters() = 0;
 
+  /**
+   * Set the timeout and the rate limits of the commands, to be called by `read_parameters`
+   * after `command_interface_types_` is set.
+   *
+   * \param command_timeout time without a new command on the topic after which the command is
+   * held or ramped to zero, zero to never time out.
+   * \param timeout_behavior "hold" or "zero".
+   * \param max_command_rates maximum rate of change of every command, zero to not limit one of
+   * them, empty to not limit any.
+   * \returns controller_interface::CallbackReturn::ERROR if \p max_command_rates has neither the
+   * size of `command_interface_types_` nor is empty, SUCCESS otherwise.
+   */
+  controller_interface::CallbackReturn set_command_limits(
+    double command_timeout, const std::string & timeout_behavior,
+    const std::vector<double> & max_command_rates);
+
+  /**
+   * Set the interpolation between the commands received on the topic, to be called by
+   * `read_parameters`.
+   *
+   * \param interpolation "none" to apply the commands step-wise, "linear" or "cubic" to
+   * interpolate from the current command to the newest one within the time between the arrivals
+   * of the last two commands.
+   */
+  void set_interpolation(const std::string & interpolation);
+
+  /**
+   * Enable the commands with the time to apply them, to be called by `read_parameters`.
+   *
+   * \param enable subscribe to `~/scheduled_commands`.
+   * \param capacity maximum number of commands waiting for their time.
+   */
+  void set_scheduled_commands(bool enable, int64_t capacity);
+
+  /**
+   * Enable the commands of a shared memory ring, to be called by `read_parameters`.
+   *
+   * \param enable create the ring on configure and poll it in every update.
+   * \param name of the shared memory segment, '/<controller name>_commands' if empty.
+   * \param slots of the ring.
+   */
+  void set_shm_ingress(bool enable, const std::string & name, int64_t slots);
+
   std::vector<std::string> joint_names_;
   std::string interface_name_;
 
   std::vector<std::string> command_interface_types_;
 
+  // commands received on the topic, with the size of command_interface_types_
   realtime_tools::RealtimeBuffer<std::shared_ptr<CmdType>> rt_command_ptr_;
   rclcpp::Subscription<CmdType>::SharedPtr joints_command_subscriber_;
+
+  double command_timeout_ = 0.0;
+  bool zero_on_timeout_ = false;
+  std::vector<double> max_command_rates_;
+
+  // number of commands received on the topic, incremented by the callback
+  std::atomic<uint64_t> received_commands_{0};
+  // accessed from update() only
+  uint64_t applied_received_commands_ = 0;
+  // time of the last command on the topic, negative if none was received since the activation
+  int64_t last_command_time_ns_ = -1;
+  // time the timeout of the last command counts from, its stamp for a command of the ring
+  int64_t last_command_stamp_ns_ = -1;
+  bool command_timed_out_ = false;
+  // commands scheduled for a time, nullptr if disabled
+  std::unique_ptr<CommandSchedule> command_schedule_;
+  rclcpp::Subscription<trajectory_msgs::msg::JointTrajectory>::SharedPtr
+    scheduled_commands_subscriber_;
+  size_t scheduled_commands_capacity_ = 0;
+  // the latest scheduled command whose time has come
+  std::vector<double> scheduled_commands_;
+  // true if the latest new command was a scheduled one, not one of the topic
+  bool scheduled_command_is_latest_ = false;
+  // commands written by other processes, nullptr if disabled
+  std::unique_ptr<shm_command_ingress::ShmCommandRing> shm_ingress_;
+  std::string shm_ingress_name_;
+  size_t shm_ingress_slots_ = 0;
+  // the latest valid command of the ring, and whether it is newer than the ones of the topic
+  std::vector<double> shm_commands_;
+  // the command read from the ring, copied into shm_commands_ if all of its values are finite
+  std::vector<double> shm_read_commands_;
+  int64_t shm_command_stamp_ns_ = 0;
+  bool shm_command_is_latest_ = false;
+  // commands written in the last update
+  std::vector<double> previous_commands_;
+
+  enum class Interpolation
+  {
+    NONE,
+    LINEAR,
+    CUBIC
+  };
+  Interpolation interpolation_ = Interpolation::NONE;
+  // time of the command before the last one, negative if there is none since the activation
+  int64_t previous_command_time_ns_ = -1;
+  // the segment from the references to the newest command, preallocated on configure
+  double interpolation_duration_ = 0.0;
+  std::vector<double> interpolation_starts_;
+  std::vector<double> interpolation_start_velocities_;
+  std::vector<double> interpolation_targets_;
+  std::vector<double> interpolation_target_velocities_;
+  // rate of change of the interpolated references
+  std::vector<double> reference_velocities_;
+
+private:
+  // push the points of \p msg into the schedule, called by the subscription
+  void schedule_commands(const trajectory_msgs::msg::JointTrajectory & msg);
+  // start a segment from the references to the newest received commands, realtime-safe
+  void start_interpolation(const std::vector<double> & commands);
+  // set the references to the segment at \p time, realtime-safe
+  void interpolate_references(const rclcpp::Time & time);
 };
 
 }  // namespace forward_command_controller
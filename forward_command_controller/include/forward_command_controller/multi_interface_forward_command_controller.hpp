@@ -28,11 +28,15 @@ namespace forward_command_controller
 /**
  * \brief Multi interface forward command controller for a set of interfaces.
  *
- * This class forwards the command signal down to a set of interfaces on the specified joint.
+ * This class forwards the command signal down to a set of interfaces on the specified joints.
  *
- * \param joint Name of the joint to control.
+ * \param joint Name of the joint to control, if \p joints is empty.
+ * \param joints Names of the joints to control.
  * \param interface_names Names of the interfaces to command.
  *
+ * The commands are interleaved by joint: the values of all interfaces of the first joint, in the
+ * order of \p interface_names, then those of the second joint, and so on.
+ *
  * Subscribes to:
  * - \b commands (std_msgs::msg::Float64MultiArray) : The commands to apply.
  */
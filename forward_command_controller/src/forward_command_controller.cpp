@@ -58,7 +58,12 @@ controller_interface::CallbackReturn ForwardCommandController::read_parameters()
     command_interface_types_.push_back(joint + "/" + params_.interface_name);
   }
 
-  return controller_interface::CallbackReturn::SUCCESS;
+  set_interpolation(params_.interpolation);
+  set_scheduled_commands(params_.scheduled_commands.enable, params_.scheduled_commands.capacity);
+  set_shm_ingress(
+    params_.shm_ingress.enable, params_.shm_ingress.name, params_.shm_ingress.slots);
+  return set_command_limits(
+    params_.command_timeout, params_.timeout_behavior, params_.max_command_rates);
 }
 
 }  // namespace forward_command_controller
@@ -66,4 +71,5 @@ controller_interface::CallbackReturn ForwardCommandController::read_parameters()
 #include "pluginlib/class_list_macros.hpp"
 
 PLUGINLIB_EXPORT_CLASS(
-  forward_command_controller::ForwardCommandController, controller_interface::ControllerInterface)
+  forward_command_controller::ForwardCommandController,
+  controller_interface::ChainableControllerInterface)
@@ -15,6 +15,8 @@
 #include "forward_command_controller/forward_controllers_base.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -28,7 +30,7 @@
 namespace forward_command_controller
 {
 ForwardControllersBase::ForwardControllersBase()
-: controller_interface::ControllerInterface(),
+: controller_interface::ChainableControllerInterface(),
   rt_command_ptr_(nullptr),
   joints_command_subscriber_(nullptr)
 {
@@ -58,14 +60,154 @@ controller_interface::CallbackReturn ForwardControllersBase::on_configure(
     return ret;
   }
 
+  // staged commands, exported as reference interfaces
+  reference_interfaces_.assign(
+    command_interface_types_.size(), std::numeric_limits<double>::quiet_NaN());
+  interpolation_starts_.resize(command_interface_types_.size());
+  interpolation_start_velocities_.resize(command_interface_types_.size());
+  interpolation_targets_.resize(command_interface_types_.size());
+  interpolation_target_velocities_.resize(command_interface_types_.size());
+  reference_velocities_.resize(command_interface_types_.size());
+
+  // the size is validated here, so update() only copies the commands
   joints_command_subscriber_ = get_node()->create_subscription<CmdType>(
     "~/commands", rclcpp::SystemDefaultsQoS(),
-    [this](const CmdType::SharedPtr msg) { rt_command_ptr_.writeFromNonRT(msg); });
+    [this](const CmdType::SharedPtr msg)
+    {
+      if (msg->data.size() != command_interface_types_.size())
+      {
+        RCLCPP_ERROR_THROTTLE(
+          get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+          "command size (%zu) does not match number of interfaces (%zu), ignoring it",
+          msg->data.size(), command_interface_types_.size());
+        return;
+      }
+      rt_command_ptr_.writeFromNonRT(msg);
+      received_commands_.fetch_add(1, std::memory_order_release);
+    });
+
+  scheduled_commands_subscriber_.reset();
+  if (scheduled_commands_capacity_ > 0)
+  {
+    command_schedule_ = std::make_unique<CommandSchedule>();
+    command_schedule_->resize(scheduled_commands_capacity_, command_interface_types_.size());
+    scheduled_commands_.assign(
+      command_interface_types_.size(), std::numeric_limits<double>::quiet_NaN());
+    scheduled_commands_subscriber_ =
+      get_node()->create_subscription<trajectory_msgs::msg::JointTrajectory>(
+        "~/scheduled_commands", rclcpp::SystemDefaultsQoS(),
+        [this](const trajectory_msgs::msg::JointTrajectory::SharedPtr msg)
+        { schedule_commands(*msg); });
+  }
+  else
+  {
+    command_schedule_.reset();
+  }
+
+  // the segment of the previous configuration is removed first
+  shm_ingress_.reset();
+  if (shm_ingress_slots_ > 0)
+  {
+    const std::string name = shm_ingress_name_.empty()
+                               ? "/" + std::string(get_node()->get_name()) + "_commands"
+                               : shm_ingress_name_;
+    shm_ingress_ = std::make_unique<shm_command_ingress::ShmCommandRing>();
+    std::string error;
+    if (!shm_ingress_->create(name, command_interface_types_.size(), shm_ingress_slots_, error))
+    {
+      RCLCPP_ERROR(get_node()->get_logger(), "%s", error.c_str());
+      shm_ingress_.reset();
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    shm_commands_.assign(
+      command_interface_types_.size(), std::numeric_limits<double>::quiet_NaN());
+    shm_read_commands_ = shm_commands_;
+    RCLCPP_INFO(get_node()->get_logger(), "Polling the commands of '%s'", name.c_str());
+  }
 
   RCLCPP_INFO(get_node()->get_logger(), "configure successful");
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
+controller_interface::CallbackReturn ForwardControllersBase::set_command_limits(
+  double command_timeout, const std::string & timeout_behavior,
+  const std::vector<double> & max_command_rates)
+{
+  if (!max_command_rates.empty() && max_command_rates.size() != command_interface_types_.size())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "'max_command_rates' has %zu values, expected one for each of the %zu command interfaces",
+      max_command_rates.size(), command_interface_types_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  command_timeout_ = command_timeout;
+  zero_on_timeout_ = timeout_behavior == "zero";
+  max_command_rates_ = max_command_rates;
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+void ForwardControllersBase::set_interpolation(const std::string & interpolation)
+{
+  if (interpolation == "linear")
+  {
+    interpolation_ = Interpolation::LINEAR;
+  }
+  else if (interpolation == "cubic")
+  {
+    interpolation_ = Interpolation::CUBIC;
+  }
+  else
+  {
+    interpolation_ = Interpolation::NONE;
+  }
+}
+
+void ForwardControllersBase::set_scheduled_commands(bool enable, int64_t capacity)
+{
+  scheduled_commands_capacity_ = enable ? static_cast<size_t>(std::max<int64_t>(capacity, 1)) : 0;
+}
+
+void ForwardControllersBase::set_shm_ingress(
+  bool enable, const std::string & name, int64_t slots)
+{
+  shm_ingress_name_ = name;
+  shm_ingress_slots_ = enable ? static_cast<size_t>(std::max<int64_t>(slots, 2)) : 0;
+}
+
+void ForwardControllersBase::schedule_commands(const trajectory_msgs::msg::JointTrajectory & msg)
+{
+  // the whole msg is ignored, so the schedule doesn't get a part of it
+  for (const auto & point : msg.points)
+  {
+    if (point.positions.size() != command_interface_types_.size())
+    {
+      RCLCPP_ERROR_THROTTLE(
+        get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+        "scheduled command size (%zu) does not match number of interfaces (%zu), ignoring them",
+        point.positions.size(), command_interface_types_.size());
+      return;
+    }
+  }
+
+  const rclcpp::Time stamp(msg.header.stamp);
+  const int64_t start_ns = stamp.nanoseconds() == 0 ? get_node()->now().nanoseconds()
+                                                     : stamp.nanoseconds();
+  bool first_point = true;
+  for (const auto & point : msg.points)
+  {
+    const int64_t stamp_ns = start_ns + rclcpp::Duration(point.time_from_start).nanoseconds();
+    if (!command_schedule_->push(stamp_ns, point.positions, first_point))
+    {
+      RCLCPP_ERROR_THROTTLE(
+        get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+        "too many scheduled commands waiting to be scheduled, dropping the rest of the msg");
+      return;
+    }
+    first_point = false;
+  }
+}
+
 controller_interface::InterfaceConfiguration
 ForwardControllersBase::command_interface_configuration() const
 {
@@ -83,6 +225,29 @@ controller_interface::InterfaceConfiguration ForwardControllersBase::state_inter
     controller_interface::interface_configuration_type::NONE};
 }
 
+std::vector<hardware_interface::CommandInterface>
+ForwardControllersBase::on_export_reference_interfaces()
+{
+  reference_interfaces_.resize(
+    command_interface_types_.size(), std::numeric_limits<double>::quiet_NaN());
+
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.reserve(reference_interfaces_.size());
+  for (size_t index = 0; index < command_interface_types_.size(); ++index)
+  {
+    reference_interfaces.push_back(hardware_interface::CommandInterface(
+      get_node()->get_name(), command_interface_types_[index], &reference_interfaces_[index]));
+  }
+
+  return reference_interfaces;
+}
+
+bool ForwardControllersBase::on_set_chained_mode(bool chained_mode)
+{
+  // Always accept switch to/from chained mode
+  return true || chained_mode;
+}
+
 controller_interface::CallbackReturn ForwardControllersBase::on_activate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
@@ -104,6 +269,36 @@ controller_interface::CallbackReturn ForwardControllersBase::on_activate(
 
   // reset command buffer if a command came through callback when controller was inactive
   rt_command_ptr_ = realtime_tools::RealtimeBuffer<std::shared_ptr<CmdType>>(nullptr);
+  reference_interfaces_.assign(
+    reference_interfaces_.size(), std::numeric_limits<double>::quiet_NaN());
+  applied_received_commands_ = received_commands_.load(std::memory_order_acquire);
+  last_command_time_ns_ = -1;
+  last_command_stamp_ns_ = -1;
+  previous_command_time_ns_ = -1;
+  command_timed_out_ = false;
+  interpolation_duration_ = 0.0;
+  interpolation_targets_.assign(
+    interpolation_targets_.size(), std::numeric_limits<double>::quiet_NaN());
+  reference_velocities_.assign(reference_velocities_.size(), 0.0);
+  // drop the commands scheduled while the controller was inactive
+  if (command_schedule_)
+  {
+    command_schedule_->clear();
+  }
+  scheduled_command_is_latest_ = false;
+  // drop the commands written while the controller was inactive
+  if (shm_ingress_)
+  {
+    shm_ingress_->clear();
+  }
+  shm_command_is_latest_ = false;
+
+  // the rate limits start from the current commands
+  previous_commands_.resize(command_interfaces_.size());
+  for (size_t index = 0; index < command_interfaces_.size(); ++index)
+  {
+    previous_commands_[index] = command_interfaces_[index].get_value();
+  }
 
   RCLCPP_INFO(get_node()->get_logger(), "activate successful");
   return controller_interface::CallbackReturn::SUCCESS;
@@ -117,29 +312,199 @@ controller_interface::CallbackReturn ForwardControllersBase::on_deactivate(
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
-controller_interface::return_type ForwardControllersBase::update(
-  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+controller_interface::return_type ForwardControllersBase::update_reference_from_subscribers(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
 {
-  auto joint_commands = rt_command_ptr_.readFromRT();
+  // a new command on the topic restarts the timeout
+  const uint64_t received_commands = received_commands_.load(std::memory_order_acquire);
+  bool new_command = received_commands != applied_received_commands_;
+  if (new_command)
+  {
+    applied_received_commands_ = received_commands;
+    scheduled_command_is_latest_ = false;
+    shm_command_is_latest_ = false;
+  }
+  int64_t command_stamp_ns = time.nanoseconds();
+  // a command of the shared memory ring counts as a new command as well, applied instead of one
+  // arriving on the topic in the same update, a command with non-finite values is ignored
+  if (
+    shm_ingress_ && shm_ingress_->read_latest(shm_command_stamp_ns_, shm_read_commands_) &&
+    std::all_of(
+      shm_read_commands_.begin(), shm_read_commands_.end(),
+      [](const double command) { return std::isfinite(command); }))
+  {
+    std::copy(shm_read_commands_.begin(), shm_read_commands_.end(), shm_commands_.begin());
+    new_command = true;
+    scheduled_command_is_latest_ = false;
+    shm_command_is_latest_ = true;
+    // the timeout counts from the stamp of the writer, zero or a future stamp meaning now
+    if (shm_command_stamp_ns_ > 0 && shm_command_stamp_ns_ < command_stamp_ns)
+    {
+      command_stamp_ns = shm_command_stamp_ns_;
+    }
+  }
+  // a scheduled command whose time has come counts as a new command, and is applied instead of
+  // one arriving on the topic or the ring in the same update
+  if (command_schedule_ && command_schedule_->pop_until(time.nanoseconds(), scheduled_commands_))
+  {
+    new_command = true;
+    scheduled_command_is_latest_ = true;
+    shm_command_is_latest_ = false;
+    command_stamp_ns = time.nanoseconds();
+  }
+  if (new_command)
+  {
+    previous_command_time_ns_ = last_command_time_ns_;
+    last_command_time_ns_ = time.nanoseconds();
+    last_command_stamp_ns_ = command_stamp_ns;
+  }
+  command_timed_out_ =
+    command_timeout_ > 0.0 && last_command_stamp_ns_ >= 0 &&
+    static_cast<double>(time.nanoseconds() - last_command_stamp_ns_) * 1e-9 > command_timeout_;
 
-  // no command received yet
-  if (!joint_commands || !(*joint_commands))
+  const std::vector<double> * commands = &scheduled_commands_;
+  if (shm_command_is_latest_)
   {
-    return controller_interface::return_type::OK;
+    commands = &shm_commands_;
+  }
+  else if (!scheduled_command_is_latest_)
+  {
+    auto joint_commands = rt_command_ptr_.readFromRT();
+
+    // no command received yet
+    if (!joint_commands || !(*joint_commands))
+    {
+      return controller_interface::return_type::OK;
+    }
+    commands = &(*joint_commands)->data;
   }
 
-  if ((*joint_commands)->data.size() != command_interfaces_.size())
+  // the callbacks drop commands of a different size, this only catches direct writes
+  const auto & data = *commands;
+  if (data.size() != reference_interfaces_.size())
   {
     RCLCPP_ERROR_THROTTLE(
       get_node()->get_logger(), *(get_node()->get_clock()), 1000,
-      "command size (%zu) does not match number of interfaces (%zu)",
-      (*joint_commands)->data.size(), command_interfaces_.size());
+      "command size (%zu) does not match number of interfaces (%zu)", data.size(),
+      reference_interfaces_.size());
     return controller_interface::return_type::ERROR;
   }
 
-  for (auto index = 0ul; index < command_interfaces_.size(); ++index)
+  if (interpolation_ == Interpolation::NONE)
+  {
+    // one contiguous copy instead of one check per interface
+    std::copy(data.begin(), data.end(), reference_interfaces_.begin());
+    return controller_interface::return_type::OK;
+  }
+
+  if (new_command)
+  {
+    start_interpolation(data);
+  }
+  interpolate_references(time);
+
+  return controller_interface::return_type::OK;
+}
+
+void ForwardControllersBase::start_interpolation(const std::vector<double> & commands)
+{
+  // the arrival times of the last two commands, a step for the first command
+  interpolation_duration_ =
+    previous_command_time_ns_ < 0
+      ? 0.0
+      : static_cast<double>(last_command_time_ns_ - previous_command_time_ns_) * 1e-9;
+
+  for (size_t index = 0; index < commands.size(); ++index)
+  {
+    const double reference = reference_interfaces_[index];
+    const double previous_target = interpolation_targets_[index];
+    // starts from the current reference, so the references stay continuous
+    interpolation_starts_[index] = std::isnan(reference) ? commands[index] : reference;
+    interpolation_start_velocities_[index] = reference_velocities_[index];
+    interpolation_targets_[index] = commands[index];
+    // the trend of the last two commands
+    interpolation_target_velocities_[index] =
+      (interpolation_duration_ > 0.0 && !std::isnan(previous_target))
+        ? (commands[index] - previous_target) / interpolation_duration_
+        : 0.0;
+  }
+}
+
+void ForwardControllersBase::interpolate_references(const rclcpp::Time & time)
+{
+  const double elapsed = static_cast<double>(time.nanoseconds() - last_command_time_ns_) * 1e-9;
+  if (!(interpolation_duration_ > 0.0) || elapsed >= interpolation_duration_)
+  {
+    std::copy(
+      interpolation_targets_.begin(), interpolation_targets_.end(), reference_interfaces_.begin());
+    std::fill(reference_velocities_.begin(), reference_velocities_.end(), 0.0);
+    return;
+  }
+
+  const double duration = interpolation_duration_;
+  const double u = std::max(elapsed, 0.0) / duration;
+  if (interpolation_ == Interpolation::LINEAR)
+  {
+    for (size_t index = 0; index < reference_interfaces_.size(); ++index)
+    {
+      const double change = interpolation_targets_[index] - interpolation_starts_[index];
+      reference_interfaces_[index] = interpolation_starts_[index] + change * u;
+      reference_velocities_[index] = change / duration;
+    }
+    return;
+  }
+
+  // cubic Hermite segment from the current reference and velocity to the newest command with
+  // the velocity of the last two commands
+  const double u2 = u * u;
+  const double u3 = u2 * u;
+  const double h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+  const double h10 = u3 - 2.0 * u2 + u;
+  const double h01 = -2.0 * u3 + 3.0 * u2;
+  const double h11 = u3 - u2;
+  const double dh00 = 6.0 * u2 - 6.0 * u;
+  const double dh10 = 3.0 * u2 - 4.0 * u + 1.0;
+  const double dh01 = -6.0 * u2 + 6.0 * u;
+  const double dh11 = 3.0 * u2 - 2.0 * u;
+  for (size_t index = 0; index < reference_interfaces_.size(); ++index)
+  {
+    const double start = interpolation_starts_[index];
+    const double start_slope = interpolation_start_velocities_[index] * duration;
+    const double target = interpolation_targets_[index];
+    const double target_slope = interpolation_target_velocities_[index] * duration;
+    reference_interfaces_[index] =
+      h00 * start + h10 * start_slope + h01 * target + h11 * target_slope;
+    reference_velocities_[index] =
+      (dh00 * start + dh10 * start_slope + dh01 * target + dh11 * target_slope) / duration;
+  }
+}
+
+controller_interface::return_type ForwardControllersBase::update_and_write_commands(
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & period)
+{
+  const double dt = period.seconds();
+  const bool limit_rates = !max_command_rates_.empty() && dt > 0.0;
+  // timeout and rate limits of all interfaces in one pass
+  for (size_t index = 0; index < command_interfaces_.size(); ++index)
   {
-    command_interfaces_[index].set_value((*joint_commands)->data[index]);
+    double command = reference_interfaces_[index];
+    // no command received yet, neither from the topic nor from a preceding controller
+    if (std::isnan(command))
+    {
+      continue;
+    }
+    const double previous_command = previous_commands_[index];
+    if (command_timed_out_)
+    {
+      command = zero_on_timeout_ ? 0.0 : previous_command;
+    }
+    if (limit_rates && max_command_rates_[index] > 0.0 && !std::isnan(previous_command))
+    {
+      const double max_change = max_command_rates_[index] * dt;
+      command = std::clamp(command, previous_command - max_change, previous_command + max_change);
+    }
+    command_interfaces_[index].set_value(command);
+    previous_commands_[index] = command;
   }
 
   return controller_interface::return_type::OK;
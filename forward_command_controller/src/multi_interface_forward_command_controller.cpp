@@ -39,7 +39,9 @@ controller_interface::CallbackReturn MultiInterfaceForwardCommandController::rea
   }
   params_ = param_listener_->get_params();
 
-  if (params_.joint.empty())
+  const std::vector<std::string> joints =
+    params_.joints.empty() ? std::vector<std::string>{params_.joint} : params_.joints;
+  if (joints.front().empty())
   {
     RCLCPP_ERROR(get_node()->get_logger(), "'joint' parameter is empty");
     return controller_interface::CallbackReturn::ERROR;
@@ -51,12 +53,22 @@ controller_interface::CallbackReturn MultiInterfaceForwardCommandController::rea
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  for (const auto & interface : params_.interface_names)
+  // interleaved by joint, all interfaces of a joint are adjacent
+  command_interface_types_.clear();
+  for (const auto & joint : joints)
   {
-    command_interface_types_.push_back(params_.joint + "/" + interface);
+    for (const auto & interface : params_.interface_names)
+    {
+      command_interface_types_.push_back(joint + "/" + interface);
+    }
   }
 
-  return controller_interface::CallbackReturn::SUCCESS;
+  set_interpolation(params_.interpolation);
+  set_scheduled_commands(params_.scheduled_commands.enable, params_.scheduled_commands.capacity);
+  set_shm_ingress(
+    params_.shm_ingress.enable, params_.shm_ingress.name, params_.shm_ingress.slots);
+  return set_command_limits(
+    params_.command_timeout, params_.timeout_behavior, params_.max_command_rates);
 }
 
 }  // namespace forward_command_controller
@@ -65,4 +77,4 @@ controller_interface::CallbackReturn MultiInterfaceForwardCommandController::rea
 
 PLUGINLIB_EXPORT_CLASS(
   forward_command_controller::MultiInterfaceForwardCommandController,
-  controller_interface::ControllerInterface)
+  controller_interface::ChainableControllerInterface)
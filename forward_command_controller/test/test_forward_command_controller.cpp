@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <unistd.h>
+
 #include "gmock/gmock.h"
 
 #include "test_forward_command_controller.hpp"
@@ -32,6 +35,8 @@
 #include "rclcpp/utilities.hpp"
 #include "rclcpp/wait_set.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+#include "rt_safety_checks/rt_safety_checker.hpp"
+#include "shm_command_ingress/shm_command_ring.hpp"
 
 using hardware_interface::LoanedCommandInterface;
 using testing::IsEmpty;
@@ -440,3 +445,379 @@ TEST_F(ForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess)
   ASSERT_EQ(joint_2_pos_cmd_.get_value(), 6.6);
   ASSERT_EQ(joint_3_pos_cmd_.get_value(), 7.7);
 }
+
+TEST_F(ForwardCommandControllerTest, WrongSizeCommandsAreDroppedByCallback)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // send a command with too few values
+  rclcpp::Node test_node("test_node");
+  auto command_pub = test_node.create_publisher<std_msgs::msg::Float64MultiArray>(
+    std::string(controller_->get_node()->get_name()) + "/commands", rclcpp::SystemDefaultsQoS());
+  std_msgs::msg::Float64MultiArray command_msg;
+  command_msg.data = {10.0, 20.0};
+  command_pub->publish(command_msg);
+
+  ASSERT_EQ(wait_for(controller_->joints_command_subscriber_), rclcpp::WaitResultKind::Ready);
+  rclcpp::spin_some(controller_->get_node()->get_node_base_interface());
+
+  // the command never reaches update()
+  ASSERT_FALSE(
+    controller_->rt_command_ptr_.readFromNonRT() &&
+    *(controller_->rt_command_ptr_.readFromNonRT()));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  // check command in handle was not changed
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 3.1);
+}
+
+TEST_F(ForwardCommandControllerTest, ChainedReferenceInterfacesAreForwarded)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+  auto reference_interfaces = controller_->on_export_reference_interfaces();
+  ASSERT_THAT(reference_interfaces, SizeIs(joint_names_.size()));
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_EQ(
+      reference_interfaces[i].get_name(),
+      std::string(controller_->get_node()->get_name()) + "/" + joint_names_[i] + "/" +
+        HW_IF_POSITION);
+  }
+
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // the topic is ignored in chained mode
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_msg);
+
+  // a preceding controller commands two of the joints
+  reference_interfaces[0].set_value(5.5);
+  reference_interfaces[2].set_value(7.7);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 5.5);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 7.7);
+}
+
+TEST_F(ForwardCommandControllerTest, CommandsAreRateLimitedAndTimeOut)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter(
+    {"max_command_rates", std::vector<double>{1.0, 0.0, 10.0}});
+  controller_->get_node()->set_parameter({"command_timeout", 0.5});
+  controller_->get_node()->set_parameter({"timeout_behavior", "zero"});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // a command as the callback stores it
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_msg);
+  ++controller_->received_commands_;
+
+  // the commands move from the current ones with the maximum rates, the second one is not limited
+  const auto period = rclcpp::Duration::from_seconds(0.1);
+  ASSERT_EQ(controller_->update(rclcpp::Time(0), period), controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_1_pos_cmd_.get_value(), 1.2, 1e-12);
+  EXPECT_NEAR(joint_2_pos_cmd_.get_value(), 20.0, 1e-12);
+  EXPECT_NEAR(joint_3_pos_cmd_.get_value(), 4.1, 1e-12);
+
+  // timed out: the commands are ramped to zero
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1000000000), period), controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_1_pos_cmd_.get_value(), 1.1, 1e-12);
+  EXPECT_NEAR(joint_2_pos_cmd_.get_value(), 0.0, 1e-12);
+  EXPECT_NEAR(joint_3_pos_cmd_.get_value(), 3.1, 1e-12);
+
+  // a new command restarts the timeout
+  controller_->rt_command_ptr_.writeFromNonRT(command_msg);
+  ++controller_->received_commands_;
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1100000000), period), controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_1_pos_cmd_.get_value(), 1.2, 1e-12);
+  EXPECT_NEAR(joint_2_pos_cmd_.get_value(), 20.0, 1e-12);
+  EXPECT_NEAR(joint_3_pos_cmd_.get_value(), 4.1, 1e-12);
+}
+
+TEST_F(ForwardCommandControllerTest, CommandsAreInterpolated)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"interpolation", "linear"});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  auto send_command = [this](const std::vector<double> & data)
+  {
+    // as the callback stores it
+    auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+    command_msg->data = data;
+    controller_->rt_command_ptr_.writeFromNonRT(command_msg);
+    ++controller_->received_commands_;
+  };
+
+  // the first command is applied right away
+  send_command({10.0, 20.0, 30.0});
+  ASSERT_EQ(controller_->update(rclcpp::Time(0), period), controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_1_pos_cmd_.get_value(), 10.0, 1e-9);
+  EXPECT_NEAR(joint_3_pos_cmd_.get_value(), 30.0, 1e-9);
+
+  // the next one 100 ms later is reached within 100 ms
+  send_command({20.0, 30.0, 40.0});
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(100000000), period), controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_1_pos_cmd_.get_value(), 10.0, 1e-9);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(150000000), period), controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_1_pos_cmd_.get_value(), 15.0, 1e-9);
+  EXPECT_NEAR(joint_2_pos_cmd_.get_value(), 25.0, 1e-9);
+  EXPECT_NEAR(joint_3_pos_cmd_.get_value(), 35.0, 1e-9);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(300000000), period), controller_interface::return_type::OK);
+  EXPECT_NEAR(joint_1_pos_cmd_.get_value(), 20.0, 1e-9);
+  EXPECT_NEAR(joint_3_pos_cmd_.get_value(), 40.0, 1e-9);
+}
+
+TEST_F(ForwardCommandControllerTest, ScheduledCommandsAreAppliedAtTheirTime)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"scheduled_commands.enable", true});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // commands at 1.1 s and 1.2 s, as the callback receives them
+  auto schedule = [this](int64_t stamp_ns, const std::vector<std::vector<double>> & commands)
+  {
+    trajectory_msgs::msg::JointTrajectory msg;
+    msg.header.stamp = rclcpp::Time(stamp_ns);
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+      trajectory_msgs::msg::JointTrajectoryPoint point;
+      point.positions = commands[i];
+      point.time_from_start = rclcpp::Duration::from_seconds(0.1 * static_cast<double>(i + 1));
+      msg.points.push_back(point);
+    }
+    controller_->schedule_commands(msg);
+  };
+  schedule(1000000000, {{10.0, 20.0, 30.0}, {11.0, 21.0, 31.0}});
+
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1050000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1100000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  EXPECT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+  // corrects the command at 1.2 s and appends one at 1.3 s
+  schedule(1100000000, {{12.0, 22.0, 32.0}, {13.0, 23.0, 33.0}});
+  // wrong size, ignored
+  schedule(1000000000, {{0.0, 0.0}});
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1250000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 12.0);
+  EXPECT_EQ(joint_2_pos_cmd_.get_value(), 22.0);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1400000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 13.0);
+  EXPECT_EQ(joint_3_pos_cmd_.get_value(), 33.0);
+  EXPECT_EQ(controller_->command_schedule_->num_scheduled(), 0u);
+
+  // a command on the topic replaces the last scheduled one
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {5.0, 6.0, 7.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_msg);
+  ++controller_->received_commands_;
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1500000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 5.0);
+  EXPECT_EQ(joint_3_pos_cmd_.get_value(), 7.0);
+}
+
+TEST_F(ForwardCommandControllerTest, ShmIngressCommandsAreApplied)
+{
+  SetUpController();
+
+  const std::string name = "/test_forward_command_controller_" + std::to_string(getpid());
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"shm_ingress.enable", true});
+  controller_->get_node()->set_parameter({"shm_ingress.name", name});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+  // another process opens the ring of the controller by its name
+  shm_command_ingress::ShmCommandRing writer;
+  std::string error;
+  ASSERT_TRUE(writer.open(name, joint_names_.size(), error)) << error;
+  // written while inactive, dropped on activation
+  ASSERT_TRUE(writer.write(0, {1.0, 2.0, 3.0}));
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1000000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+
+  ASSERT_TRUE(writer.write(0, {10.0, 20.0, 30.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1010000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  EXPECT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+  // a command on the topic replaces it, and is replaced by the next one of the ring
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {5.0, 6.0, 7.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_msg);
+  ++controller_->received_commands_;
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1020000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 5.0);
+  ASSERT_TRUE(writer.write(0, {11.0, 21.0, 31.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1030000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_2_pos_cmd_.get_value(), 21.0);
+
+  // polling the ring is realtime-safe
+  const std::vector<double> commands = {12.0, 22.0, 32.0};
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 10; ++i)
+  {
+    writer.write(0, commands);
+    controller_->update(rclcpp::Time(1040000000 + 10000000 * i), period);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+  EXPECT_EQ(joint_3_pos_cmd_.get_value(), 32.0);
+}
+
+TEST_F(ForwardCommandControllerTest, ShmIngressSkipsInvalidCommandsAndTimesOutFromTheStamp)
+{
+  SetUpController();
+
+  const std::string name = "/test_forward_command_controller_stamp_" + std::to_string(getpid());
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"command_timeout", 0.5});
+  controller_->get_node()->set_parameter({"timeout_behavior", "zero"});
+  controller_->get_node()->set_parameter({"shm_ingress.enable", true});
+  controller_->get_node()->set_parameter({"shm_ingress.name", name});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  shm_command_ingress::ShmCommandRing writer;
+  std::string error;
+  ASSERT_TRUE(writer.open(name, joint_names_.size(), error)) << error;
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // a command with a NaN is skipped
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  ASSERT_TRUE(writer.write(0, {1.0, std::numeric_limits<double>::quiet_NaN(), 3.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1000000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  EXPECT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+
+  ASSERT_TRUE(writer.write(0, {10.0, 20.0, 30.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1010000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_2_pos_cmd_.get_value(), 20.0);
+
+  // written longer than the timeout ago
+  ASSERT_TRUE(writer.write(200000000, {11.0, 21.0, 31.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1020000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_2_pos_cmd_.get_value(), 0.0);
+
+  // written within the timeout
+  ASSERT_TRUE(writer.write(1000000000, {12.0, 22.0, 32.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(1030000000), period), controller_interface::return_type::OK);
+  EXPECT_EQ(joint_2_pos_cmd_.get_value(), 22.0);
+}
+
+TEST_F(ForwardCommandControllerTest, UpdateIsRealtimeSafe)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"interpolation", "linear"});
+  controller_->get_node()->set_parameter(
+    {"max_command_rates", std::vector<double>{1.0, 0.0, 10.0}});
+  controller_->get_node()->set_parameter({"command_timeout", 0.5});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // a command as the callback stores it, writing it locks the buffer
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_msg);
+  ++controller_->received_commands_;
+
+  // interpolated, rate limited and timed out
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time(0);
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    controller_->update(time, period);
+    time += period;
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+}
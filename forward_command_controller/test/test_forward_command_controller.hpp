@@ -45,6 +45,12 @@ class FriendForwardCommandController : public forward_command_controller::Forwar
   FRIEND_TEST(ForwardCommandControllerTest, NoCommandCheckTest);
   FRIEND_TEST(ForwardCommandControllerTest, CommandCallbackTest);
   FRIEND_TEST(ForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess);
+  FRIEND_TEST(ForwardCommandControllerTest, WrongSizeCommandsAreDroppedByCallback);
+  FRIEND_TEST(ForwardCommandControllerTest, ChainedReferenceInterfacesAreForwarded);
+  FRIEND_TEST(ForwardCommandControllerTest, CommandsAreRateLimitedAndTimeOut);
+  FRIEND_TEST(ForwardCommandControllerTest, CommandsAreInterpolated);
+  FRIEND_TEST(ForwardCommandControllerTest, ScheduledCommandsAreAppliedAtTheirTime);
+  FRIEND_TEST(ForwardCommandControllerTest, UpdateIsRealtimeSafe);
 };
 
 class ForwardCommandControllerTest : public ::testing::Test
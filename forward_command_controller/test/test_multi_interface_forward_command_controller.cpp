@@ -376,3 +376,50 @@ TEST_F(MultiInterfaceForwardCommandControllerTest, ActivateDeactivateCommandsRes
   ASSERT_EQ(joint_1_vel_cmd_.get_value(), 6.6);
   ASSERT_EQ(joint_1_eff_cmd_.get_value(), 7.7);
 }
+
+TEST_F(MultiInterfaceForwardCommandControllerTest, MultipleJointsCommandSuccessTest)
+{
+  const auto result = controller_->init("multi_interface_forward_command_controller", "", 0);
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+
+  double joint_2_pos = 4.1;
+  double joint_2_vel = 5.1;
+  CommandInterface joint_2_pos_cmd{"joint2", HW_IF_POSITION, &joint_2_pos};
+  CommandInterface joint_2_vel_cmd{"joint2", HW_IF_VELOCITY, &joint_2_vel};
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(joint_1_pos_cmd_);
+  command_ifs.emplace_back(joint_1_vel_cmd_);
+  command_ifs.emplace_back(joint_2_pos_cmd);
+  command_ifs.emplace_back(joint_2_vel_cmd);
+  controller_->assign_interfaces(std::move(command_ifs), {});
+
+  controller_->get_node()->set_parameter(
+    {"joints", std::vector<std::string>{"joint1", "joint2"}});
+  controller_->get_node()->set_parameter(
+    {"interface_names", std::vector<std::string>{"position", "velocity"}});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  EXPECT_THAT(
+    controller_->command_interface_configuration().names,
+    testing::ElementsAre(
+      "joint1/position", "joint1/velocity", "joint2/position", "joint2/velocity"));
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // one message with the interfaces of every joint
+  auto command_ptr = std::make_shared<forward_command_controller::CmdType>();
+  command_ptr->data = {10.0, 20.0, 30.0, 40.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_ptr);
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_2_pos_cmd.get_value(), 30.0);
+  ASSERT_EQ(joint_2_vel_cmd.get_value(), 40.0);
+  // not claimed by the controller
+  ASSERT_EQ(joint_1_eff_cmd_.get_value(), 3.1);
+}
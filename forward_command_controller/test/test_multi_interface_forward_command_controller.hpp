@@ -50,6 +50,7 @@ class FriendMultiInterfaceForwardCommandController
   FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, NoCommandCheckTest);
   FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, CommandCallbackTest);
   FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess);
+  FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, MultipleJointsCommandSuccessTest);
 };
 
 class MultiInterfaceForwardCommandControllerTest : public ::testing::Test
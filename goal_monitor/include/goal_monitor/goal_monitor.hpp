@@ -0,0 +1,95 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GOAL_MONITOR__GOAL_MONITOR_HPP_
+#define GOAL_MONITOR__GOAL_MONITOR_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "rclcpp/context.hpp"
+#include "rclcpp/guard_condition.hpp"
+#include "rclcpp/wait_set.hpp"
+
+namespace goal_monitor
+{
+/**
+ * \brief Thread running a non-realtime callback of a controller, e.g., for its action goals.
+ *
+ * The callback runs right after notify(), e.g. when the realtime loop finished a goal, and at
+ * least once per period otherwise, for the feedback. This replaces a wall timer per goal, so the
+ * result of a goal doesn't wait for the next timer tick and no timer is created for every goal.
+ */
+class GoalMonitor
+{
+public:
+  ~GoalMonitor() { stop(); }
+
+  /// Start the thread, stops a running one first; not realtime-safe
+  void start(
+    const rclcpp::Context::SharedPtr & context, std::chrono::nanoseconds period,
+    std::function<void()> callback)
+  {
+    stop();
+    guard_condition_ = std::make_shared<rclcpp::GuardCondition>(context);
+    running_ = true;
+    thread_ = std::thread(
+      [this, context, period, callback = std::move(callback)]()
+      {
+        rclcpp::WaitSet wait_set({}, {guard_condition_}, {}, {}, {}, {}, context);
+        while (running_ && context->is_valid())
+        {
+          wait_set.wait(period);
+          if (running_)
+          {
+            callback();
+          }
+        }
+      });
+  }
+
+  /// Stop and join the thread; not realtime-safe
+  void stop()
+  {
+    running_ = false;
+    if (thread_.joinable())
+    {
+      notify();
+      thread_.join();
+    }
+    guard_condition_.reset();
+  }
+
+  /// Wake the thread to run the callback, only triggers a guard condition without allocating
+  void notify()
+  {
+    if (guard_condition_)
+    {
+      guard_condition_->trigger();
+    }
+  }
+
+private:
+  rclcpp::GuardCondition::SharedPtr guard_condition_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
+
+}  // namespace goal_monitor
+
+#endif  // GOAL_MONITOR__GOAL_MONITOR_HPP_
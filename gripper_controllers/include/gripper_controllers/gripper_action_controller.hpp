@@ -18,10 +18,15 @@
 #define GRIPPER_CONTROLLERS__GRIPPER_ACTION_CONTROLLER_HPP_
 
 // C++ standard
+#include <array>
 #include <cassert>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // ROS
 #include "rclcpp/rclcpp.hpp"
@@ -33,7 +38,9 @@
 #include "rclcpp_action/create_server.hpp"
 
 // ros_controls
+#include "command_mailbox/command_mailbox.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "goal_monitor/goal_monitor.hpp"
 #include "gripper_controllers/visibility_control.hpp"
 #include "hardware_interface/loaned_command_interface.hpp"
 #include "hardware_interface/loaned_state_interface.hpp"
@@ -50,7 +57,7 @@ namespace gripper_action_controller
 {
 /**
  * \brief Controller for executing a gripper command action for simple
- * single-dof grippers.
+ * grippers, with one joint or several coupled joints which share the commanded position.
  *
  * \tparam HardwareInterface Controller hardware interface. Currently \p
  * hardware_interface::HW_IF_POSITION and \p
@@ -62,7 +69,7 @@ class GripperActionController : public controller_interface::ControllerInterface
 public:
   /**
    * \brief Store position and max effort in struct to allow easier realtime
-   * buffer usage
+   * mailbox usage
    */
   struct Commands
   {
@@ -105,9 +112,11 @@ public:
   controller_interface::CallbackReturn on_deactivate(
     const rclcpp_lifecycle::State & previous_state) override;
 
-  realtime_tools::RealtimeBuffer<Commands> command_;
-  // pre-allocated memory that is re-used to set the realtime buffer
+  command_mailbox::CommandMailbox<Commands> command_;
+  // pre-allocated memory that is re-used to set the realtime mailbox
   Commands command_struct_, command_struct_rt_;
+  // version of command_struct_rt_ in the mailbox, to copy only new commands
+  uint64_t command_version_ = 0;
 
 protected:
   using GripperCommandAction = control_msgs::action::GripperCommand;
@@ -125,12 +134,19 @@ protected:
 
   bool verbose_ = false;  ///< Hard coded verbose flag to help in debugging
   std::string name_;      ///< Controller name.
-  std::optional<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>
-    joint_command_interface_;
-  std::optional<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
-    joint_position_state_interface_;
-  std::optional<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
-    joint_velocity_state_interface_;
+  /// Names of the controlled joints, from 'joints' or else 'joint'
+  std::vector<std::string> joint_names_;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>
+    joint_command_interfaces_;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
+    joint_position_state_interfaces_;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
+    joint_velocity_state_interfaces_;
+  // preallocated errors of all joints to the commanded position and velocity
+  std::vector<double> error_positions_;
+  std::vector<double> error_velocities_;
+  /// Commanded position, ramping to the goal position at max_velocity, or equal to it
+  double ramped_position_ = 0.0;
 
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
@@ -140,13 +156,24 @@ protected:
   RealtimeGoalHandleBuffer
     rt_active_goal_;  ///< Container for the currently active action goal, if any.
   control_msgs::action::GripperCommand::Result::SharedPtr pre_alloc_result_;
+  // empty result of canceled and preempted goals, never changed
+  control_msgs::action::GripperCommand::Result::SharedPtr pre_alloc_canceled_result_;
 
   rclcpp::Duration action_monitor_period_;
 
+  /// Two preallocated feedbacks, update() fills one while the goal monitor may send the other
+  std::array<control_msgs::action::GripperCommand::Feedback::SharedPtr, 2> pre_alloc_feedbacks_;
+  size_t next_feedback_index_ = 0;
+  /// Minimum time between two action feedbacks, zero to fill the feedback in every update
+  rclcpp::Duration action_feedback_period_;
+  rclcpp::Time previous_feedback_timestamp_{0, 0, RCL_CLOCK_UNINITIALIZED};
+
   // ROS API
   ActionServerPtr action_server_;
 
-  rclcpp::TimerBase::SharedPtr goal_handle_timer_;
+  /// Last accepted goal, whose feedback and result are sent by goal_monitor_
+  RealtimeGoalHandlePtr monitored_goal_;
+  std::mutex monitored_goal_mutex_;
 
   rclcpp_action::GoalResponse goal_callback(
     const rclcpp_action::GoalUUID & uuid, std::shared_ptr<const GripperCommandAction::Goal> goal);
@@ -159,15 +186,40 @@ protected:
 
   void set_hold_position();
 
+  /// Mean position of the joints
+  double get_mean_position() const;
+
+  /// Move ramped_position_ towards the goal position for \p period, realtime-safe
+  /**
+   * \return The commanded velocity of the ramp, 0 without max_velocity.
+   */
+  double update_ramped_position(const rclcpp::Duration & period);
+
   rclcpp::Time last_movement_time_ = rclcpp::Time(0, 0, RCL_ROS_TIME);  ///< Store stall time
   double computed_command_;                                             ///< Computed command
 
   /**
    * \brief Check for success and publish appropriate result and feedback.
+   *
+   * \param[in] time Time of the update.
+   * \param[in] error_position Largest position error magnitude of the joints.
+   * \param[in] current_position Mean position of the joints.
+   * \param[in] current_velocity Largest velocity magnitude of the joints.
    **/
   void check_for_success(
     const rclcpp::Time & time, double error_position, double current_position,
     double current_velocity);
+
+  /// Send the feedback and the result of the monitored goal, run by goal_monitor_
+  void monitor_goal();
+
+  /// True if \p period passed since \p previous_timestamp, which is advanced then.
+  /// Always true for a zero \p period.
+  static bool is_period_elapsed(
+    const rclcpp::Time & time, const rclcpp::Duration & period, rclcpp::Time & previous_timestamp);
+
+  // declared last, so the thread is stopped before the members it uses are destroyed
+  goal_monitor::GoalMonitor goal_monitor_;
 };
 
 }  // namespace gripper_action_controller
@@ -19,8 +19,11 @@
 
 #include "gripper_controllers/gripper_action_controller.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace gripper_action_controller
 {
@@ -32,7 +35,7 @@ void GripperActionController<HardwareInterface>::preempt_active_goal()
   if (active_goal)
   {
     // Marks the current goal as canceled
-    active_goal->setCanceled(std::make_shared<GripperCommandAction::Result>());
+    active_goal->setCanceled(pre_alloc_canceled_result_);
     rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
   }
 }
@@ -56,25 +59,66 @@ controller_interface::CallbackReturn GripperActionController<HardwareInterface>:
 
 template <const char * HardwareInterface>
 controller_interface::return_type GripperActionController<HardwareInterface>::update(
-  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  command_struct_rt_ = *(command_.readFromRT());
+  if (command_.try_read_newer(command_struct_rt_, command_version_))
+  {
+    // a new goal or hold position starts the stall detection, and its first feedback is sent
+    last_movement_time_ = time;
+    previous_feedback_timestamp_ = rclcpp::Time(0, 0, RCL_CLOCK_UNINITIALIZED);
+  }
 
-  const double current_position = joint_position_state_interface_->get().get_value();
-  const double current_velocity = joint_velocity_state_interface_->get().get_value();
+  const double desired_velocity = update_ramped_position(period);
 
-  const double error_position = command_struct_rt_.position_ - current_position;
-  const double error_velocity = -current_velocity;
+  // the goal is reached when all joints are, and the gripper stalls when none of them moves
+  double max_error_position = 0.0;
+  double max_velocity = 0.0;
+  double sum_position = 0.0;
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    const double current_position = joint_position_state_interfaces_[i].get().get_value();
+    const double current_velocity = joint_velocity_state_interfaces_[i].get().get_value();
+    error_positions_[i] = ramped_position_ - current_position;
+    error_velocities_[i] = desired_velocity - current_velocity;
+    max_error_position =
+      std::max(max_error_position, std::fabs(command_struct_rt_.position_ - current_position));
+    max_velocity = std::max(max_velocity, std::fabs(current_velocity));
+    sum_position += current_position;
+  }
 
-  check_for_success(get_node()->now(), error_position, current_position, current_velocity);
+  check_for_success(
+    time, max_error_position, sum_position / static_cast<double>(joint_names_.size()),
+    max_velocity);
 
   // Hardware interface adapter: Generate and send commands
   computed_command_ = hw_iface_adapter_.updateCommand(
-    command_struct_rt_.position_, 0.0, error_position, error_velocity,
-    command_struct_rt_.max_effort_);
+    ramped_position_, desired_velocity, error_positions_, error_velocities_,
+    command_struct_rt_.max_effort_, period);
   return controller_interface::return_type::OK;
 }
 
+template <const char * HardwareInterface>
+double GripperActionController<HardwareInterface>::update_ramped_position(
+  const rclcpp::Duration & period)
+{
+  const double goal_position = command_struct_rt_.position_;
+  if (params_.max_velocity <= 0.0)
+  {
+    ramped_position_ = goal_position;
+    return 0.0;
+  }
+  const double dt = period.seconds();
+  if (dt <= 0.0)
+  {
+    return 0.0;
+  }
+  // a new goal continues from the last commanded position, so the command never steps
+  const double max_step = params_.max_velocity * dt;
+  const double step = std::clamp(goal_position - ramped_position_, -max_step, max_step);
+  ramped_position_ += step;
+  return step / dt;
+}
+
 template <const char * HardwareInterface>
 rclcpp_action::GoalResponse GripperActionController<HardwareInterface>::goal_callback(
   const rclcpp_action::GoalUUID &, std::shared_ptr<const GripperCommandAction::Goal>)
@@ -96,22 +140,33 @@ void GripperActionController<HardwareInterface>::accepted_callback(
   // We use command_ for sharing
   command_struct_.position_ = goal_handle->get_goal()->command.position;
   command_struct_.max_effort_ = goal_handle->get_goal()->command.max_effort;
-  command_.writeFromNonRT(command_struct_);
+  command_.write(command_struct_);
 
   pre_alloc_result_->reached_goal = false;
   pre_alloc_result_->stalled = false;
 
-  last_movement_time_ = get_node()->now();
   rt_goal->execute();
   rt_active_goal_.writeFromNonRT(rt_goal);
 
-  // Set smartpointer to expire for create_wall_timer to delete previous entry from timer list
-  goal_handle_timer_.reset();
+  // the goal monitor sends the feedback and the result of the goal from now on
+  {
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    monitored_goal_ = rt_goal;
+  }
+}
 
-  // Setup goal status checking timer
-  goal_handle_timer_ = get_node()->create_wall_timer(
-    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
-    std::bind(&RealtimeGoalHandle::runNonRealtime, rt_goal));
+template <const char * HardwareInterface>
+void GripperActionController<HardwareInterface>::monitor_goal()
+{
+  RealtimeGoalHandlePtr goal;
+  {
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    goal = monitored_goal_;
+  }
+  if (goal)
+  {
+    goal->runNonRealtime();
+  }
 }
 
 template <const char * HardwareInterface>
@@ -131,10 +186,10 @@ rclcpp_action::CancelResponse GripperActionController<HardwareInterface>::cancel
       get_node()->get_logger(), "Canceling active action goal because cancel callback received.");
 
     // Mark the current goal as canceled
-    auto action_res = std::make_shared<GripperCommandAction::Result>();
-    active_goal->setCanceled(action_res);
+    active_goal->setCanceled(pre_alloc_canceled_result_);
     // Reset current goal
     rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    goal_monitor_.notify();
   }
   return rclcpp_action::CancelResponse::ACCEPT;
 }
@@ -142,9 +197,20 @@ rclcpp_action::CancelResponse GripperActionController<HardwareInterface>::cancel
 template <const char * HardwareInterface>
 void GripperActionController<HardwareInterface>::set_hold_position()
 {
-  command_struct_.position_ = joint_position_state_interface_->get().get_value();
+  command_struct_.position_ = get_mean_position();
   command_struct_.max_effort_ = params_.max_effort;
-  command_.writeFromNonRT(command_struct_);
+  command_.write(command_struct_);
+}
+
+template <const char * HardwareInterface>
+double GripperActionController<HardwareInterface>::get_mean_position() const
+{
+  double sum = 0.0;
+  for (const auto & state_interface : joint_position_state_interfaces_)
+  {
+    sum += state_interface.get().get_value();
+  }
+  return sum / static_cast<double>(joint_position_state_interfaces_.size());
 }
 
 template <const char * HardwareInterface>
@@ -158,6 +224,21 @@ void GripperActionController<HardwareInterface>::check_for_success(
     return;
   }
 
+  if (is_period_elapsed(time, action_feedback_period_, previous_feedback_timestamp_))
+  {
+    // the other feedback may still be sent by the goal monitor, it is only reused after this one
+    // was set, so the messages are never written while they are sent
+    auto & feedback = pre_alloc_feedbacks_[next_feedback_index_];
+    next_feedback_index_ = 1 - next_feedback_index_;
+    feedback->position = current_position;
+    feedback->effort = computed_command_;
+    feedback->reached_goal = fabs(error_position) < params_.goal_tolerance;
+    // the stall timeout is running
+    feedback->stalled =
+      !feedback->reached_goal && fabs(current_velocity) <= params_.stall_velocity_threshold;
+    active_goal->setFeedback(feedback);
+  }
+
   if (fabs(error_position) < params_.goal_tolerance)
   {
     pre_alloc_result_->effort = computed_command_;
@@ -167,6 +248,8 @@ void GripperActionController<HardwareInterface>::check_for_success(
     RCLCPP_DEBUG(get_node()->get_logger(), "Successfully moved to goal.");
     active_goal->setSucceeded(pre_alloc_result_);
     rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    // send the result right away instead of at the next monitor period
+    goal_monitor_.notify();
   }
   else
   {
@@ -192,6 +275,7 @@ void GripperActionController<HardwareInterface>::check_for_success(
         active_goal->setAborted(pre_alloc_result_);
       }
       rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+      goal_monitor_.notify();
     }
   }
 }
@@ -212,13 +296,33 @@ controller_interface::CallbackReturn GripperActionController<HardwareInterface>:
   action_monitor_period_ = rclcpp::Duration::from_seconds(1.0 / params_.action_monitor_rate);
   RCLCPP_INFO_STREAM(
     logger, "Action status changes will be monitored at " << params_.action_monitor_rate << "Hz.");
+  if (params_.action_feedback_rate > 0.0)
+  {
+    action_feedback_period_ = rclcpp::Duration::from_seconds(1.0 / params_.action_feedback_rate);
+    RCLCPP_INFO(logger, "Action feedback will be filled at %.2f Hz.", params_.action_feedback_rate);
+  }
+  else
+  {
+    action_feedback_period_ = rclcpp::Duration::from_nanoseconds(0);
+  }
 
-  // Controlled joint
-  if (params_.joint.empty())
+  // Controlled joints
+  if (!params_.joints.empty())
+  {
+    joint_names_ = params_.joints;
+  }
+  else if (!params_.joint.empty())
+  {
+    joint_names_ = {params_.joint};
+  }
+  else
   {
+    joint_names_.clear();
     RCLCPP_ERROR(logger, "Joint name cannot be empty");
     return controller_interface::CallbackReturn::ERROR;
   }
+  error_positions_.assign(joint_names_.size(), 0.0);
+  error_velocities_.assign(joint_names_.size(), 0.0);
 
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -226,76 +330,84 @@ template <const char * HardwareInterface>
 controller_interface::CallbackReturn GripperActionController<HardwareInterface>::on_activate(
   const rclcpp_lifecycle::State &)
 {
-  auto command_interface_it = std::find_if(
-    command_interfaces_.begin(), command_interfaces_.end(),
-    [](const hardware_interface::LoanedCommandInterface & command_interface)
-    { return command_interface.get_interface_name() == HardwareInterface; });
-  if (command_interface_it == command_interfaces_.end())
+  joint_command_interfaces_.clear();
+  joint_position_state_interfaces_.clear();
+  joint_velocity_state_interfaces_.clear();
+  for (const auto & joint_name : joint_names_)
   {
-    RCLCPP_ERROR_STREAM(
-      get_node()->get_logger(), "Expected 1 " << HardwareInterface << " command interface");
-    return controller_interface::CallbackReturn::ERROR;
-  }
-  if (command_interface_it->get_prefix_name() != params_.joint)
-  {
-    RCLCPP_ERROR_STREAM(
-      get_node()->get_logger(), "Command interface is different than joint name `"
-                                  << command_interface_it->get_prefix_name() << "` != `"
-                                  << params_.joint << "`");
-    return controller_interface::CallbackReturn::ERROR;
-  }
-  const auto position_state_interface_it = std::find_if(
-    state_interfaces_.begin(), state_interfaces_.end(),
-    [](const hardware_interface::LoanedStateInterface & state_interface)
-    { return state_interface.get_interface_name() == hardware_interface::HW_IF_POSITION; });
-  if (position_state_interface_it == state_interfaces_.end())
-  {
-    RCLCPP_ERROR(get_node()->get_logger(), "Expected 1 position state interface");
-    return controller_interface::CallbackReturn::ERROR;
-  }
-  if (position_state_interface_it->get_prefix_name() != params_.joint)
-  {
-    RCLCPP_ERROR_STREAM(
-      get_node()->get_logger(), "Position state interface is different than joint name `"
-                                  << position_state_interface_it->get_prefix_name() << "` != `"
-                                  << params_.joint << "`");
-    return controller_interface::CallbackReturn::ERROR;
-  }
-  const auto velocity_state_interface_it = std::find_if(
-    state_interfaces_.begin(), state_interfaces_.end(),
-    [](const hardware_interface::LoanedStateInterface & state_interface)
-    { return state_interface.get_interface_name() == hardware_interface::HW_IF_VELOCITY; });
-  if (velocity_state_interface_it == state_interfaces_.end())
-  {
-    RCLCPP_ERROR(get_node()->get_logger(), "Expected 1 velocity state interface");
-    return controller_interface::CallbackReturn::ERROR;
-  }
-  if (velocity_state_interface_it->get_prefix_name() != params_.joint)
-  {
-    RCLCPP_ERROR_STREAM(
-      get_node()->get_logger(), "Velocity command interface is different than joint name `"
-                                  << velocity_state_interface_it->get_prefix_name() << "` != `"
-                                  << params_.joint << "`");
-    return controller_interface::CallbackReturn::ERROR;
-  }
+    const auto command_interface_it = std::find_if(
+      command_interfaces_.begin(), command_interfaces_.end(),
+      [&joint_name](const hardware_interface::LoanedCommandInterface & command_interface)
+      {
+        return command_interface.get_prefix_name() == joint_name &&
+               command_interface.get_interface_name() == HardwareInterface;
+      });
+    if (command_interface_it == command_interfaces_.end())
+    {
+      RCLCPP_ERROR_STREAM(
+        get_node()->get_logger(),
+        "Expected 1 " << HardwareInterface << " command interface of joint `" << joint_name << "`");
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    const auto position_state_interface_it = std::find_if(
+      state_interfaces_.begin(), state_interfaces_.end(),
+      [&joint_name](const hardware_interface::LoanedStateInterface & state_interface)
+      {
+        return state_interface.get_prefix_name() == joint_name &&
+               state_interface.get_interface_name() == hardware_interface::HW_IF_POSITION;
+      });
+    if (position_state_interface_it == state_interfaces_.end())
+    {
+      RCLCPP_ERROR_STREAM(
+        get_node()->get_logger(),
+        "Expected 1 position state interface of joint `" << joint_name << "`");
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    const auto velocity_state_interface_it = std::find_if(
+      state_interfaces_.begin(), state_interfaces_.end(),
+      [&joint_name](const hardware_interface::LoanedStateInterface & state_interface)
+      {
+        return state_interface.get_prefix_name() == joint_name &&
+               state_interface.get_interface_name() == hardware_interface::HW_IF_VELOCITY;
+      });
+    if (velocity_state_interface_it == state_interfaces_.end())
+    {
+      RCLCPP_ERROR_STREAM(
+        get_node()->get_logger(),
+        "Expected 1 velocity state interface of joint `" << joint_name << "`");
+      return controller_interface::CallbackReturn::ERROR;
+    }
 
-  joint_command_interface_ = *command_interface_it;
-  joint_position_state_interface_ = *position_state_interface_it;
-  joint_velocity_state_interface_ = *velocity_state_interface_it;
+    joint_command_interfaces_.emplace_back(*command_interface_it);
+    joint_position_state_interfaces_.emplace_back(*position_state_interface_it);
+    joint_velocity_state_interfaces_.emplace_back(*velocity_state_interface_it);
+  }
 
-  // Hardware interface adapter
-  hw_iface_adapter_.init(joint_command_interface_, get_node());
+  // Hardware interface adapter of all joints
+  hw_iface_adapter_.init(joint_command_interfaces_, get_node());
 
   // Command - non RT version
-  command_struct_.position_ = joint_position_state_interface_->get().get_value();
+  command_struct_.position_ = get_mean_position();
   command_struct_.max_effort_ = params_.max_effort;
-  command_.initRT(command_struct_);
+  command_.write(command_struct_);
+  command_struct_rt_ = command_struct_;
+  // the ramp starts at the current position
+  ramped_position_ = command_struct_.position_;
 
   // Result
   pre_alloc_result_ = std::make_shared<control_msgs::action::GripperCommand::Result>();
   pre_alloc_result_->position = command_struct_.position_;
   pre_alloc_result_->reached_goal = false;
   pre_alloc_result_->stalled = false;
+  pre_alloc_canceled_result_ = std::make_shared<control_msgs::action::GripperCommand::Result>();
+
+  // Feedback
+  for (auto & feedback : pre_alloc_feedbacks_)
+  {
+    feedback = std::make_shared<control_msgs::action::GripperCommand::Feedback>();
+  }
+  next_feedback_index_ = 0;
+  previous_feedback_timestamp_ = rclcpp::Time(0, 0, RCL_CLOCK_UNINITIALIZED);
 
   // Action interface
   action_server_ = rclcpp_action::create_server<control_msgs::action::GripperCommand>(
@@ -305,6 +417,10 @@ controller_interface::CallbackReturn GripperActionController<HardwareInterface>:
     std::bind(&GripperActionController::cancel_callback, this, std::placeholders::_1),
     std::bind(&GripperActionController::accepted_callback, this, std::placeholders::_1));
 
+  goal_monitor_.start(
+    get_node()->get_node_base_interface()->get_context(),
+    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(), [this]() { monitor_goal(); });
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -312,10 +428,14 @@ template <const char * HardwareInterface>
 controller_interface::CallbackReturn GripperActionController<HardwareInterface>::on_deactivate(
   const rclcpp_lifecycle::State &)
 {
-  joint_command_interface_ = std::nullopt;
-  joint_position_state_interface_ = std::nullopt;
-  joint_velocity_state_interface_ = std::nullopt;
+  joint_command_interfaces_.clear();
+  joint_position_state_interfaces_.clear();
+  joint_velocity_state_interfaces_.clear();
   release_interfaces();
+
+  // send what update() requested last
+  goal_monitor_.stop();
+  monitor_goal();
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -323,25 +443,59 @@ template <const char * HardwareInterface>
 controller_interface::InterfaceConfiguration
 GripperActionController<HardwareInterface>::command_interface_configuration() const
 {
-  return {
-    controller_interface::interface_configuration_type::INDIVIDUAL,
-    {params_.joint + "/" + HardwareInterface}};
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & joint_name : joint_names_)
+  {
+    config.names.push_back(joint_name + "/" + HardwareInterface);
+  }
+  return config;
 }
 
 template <const char * HardwareInterface>
 controller_interface::InterfaceConfiguration
 GripperActionController<HardwareInterface>::state_interface_configuration() const
 {
-  return {
-    controller_interface::interface_configuration_type::INDIVIDUAL,
-    {params_.joint + "/" + hardware_interface::HW_IF_POSITION,
-     params_.joint + "/" + hardware_interface::HW_IF_VELOCITY}};
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & joint_name : joint_names_)
+  {
+    config.names.push_back(joint_name + "/" + hardware_interface::HW_IF_POSITION);
+    config.names.push_back(joint_name + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  return config;
+}
+
+template <const char * HardwareInterface>
+bool GripperActionController<HardwareInterface>::is_period_elapsed(
+  const rclcpp::Time & time, const rclcpp::Duration & period, rclcpp::Time & previous_timestamp)
+{
+  if (period.nanoseconds() <= 0)
+  {
+    return true;
+  }
+  try
+  {
+    if (previous_timestamp + period < time)
+    {
+      previous_timestamp += period;
+      return true;
+    }
+  }
+  catch (const std::runtime_error &)
+  {
+    // Handle exceptions when the time source changes and initialize the timestamp
+    previous_timestamp = time;
+    return true;
+  }
+  return false;
 }
 
 template <const char * HardwareInterface>
 GripperActionController<HardwareInterface>::GripperActionController()
 : controller_interface::ControllerInterface(),
-  action_monitor_period_(rclcpp::Duration::from_seconds(0))
+  action_monitor_period_(rclcpp::Duration::from_seconds(0)),
+  action_feedback_period_(rclcpp::Duration::from_seconds(0))
 {
 }
 
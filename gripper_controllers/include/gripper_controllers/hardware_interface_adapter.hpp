@@ -20,12 +20,17 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
-#include "control_toolbox/pid.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "pid_bank/pid_bank.hpp"
+#include "rclcpp/duration.hpp"
 #include "rclcpp/time.hpp"
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
 
@@ -35,16 +40,19 @@
  *
  * The GripperActionController outputs position while
  * it is supposed to work with either position or effort commands.
+ * An adapter commands all joints of the gripper, which are coupled and share the desired position.
  *
  */
 template <const char * HardwareInterface>
 class HardwareInterfaceAdapter
 {
 public:
+  using JointHandles =
+    std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>;
+
   bool init(
-    std::optional<
-      std::reference_wrapper<hardware_interface::LoanedCommandInterface>> /* joint_handle */,
-    std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & /* node */)
+    const JointHandles & /* joint_handles */,
+    const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & /* node */)
   {
     return false;
   }
@@ -52,9 +60,18 @@ public:
   void starting(const rclcpp::Time & /* time */) {}
   void stopping(const rclcpp::Time & /* time */) {}
 
+  /**
+   * \brief Command all joints, realtime-safe
+   * \param[in] error_position Position error of every joint.
+   * \param[in] error_velocity Velocity error of every joint.
+   * \param[in] period Time since the last update of the controller.
+   * \return The mean effort of the joints.
+   */
   double updateCommand(
-    double /* desired_position */, double /* desired_velocity */, double /* error_position */,
-    double /* error_velocity */, double /* max_allowed_effort */)
+    double /* desired_position */, double /* desired_velocity */,
+    const std::vector<double> & /* error_position */,
+    const std::vector<double> & /* error_velocity */, double /* max_allowed_effort */,
+    const rclcpp::Duration & /* period */)
   {
     return 0.0;
   }
@@ -68,11 +85,14 @@ template <>
 class HardwareInterfaceAdapter<hardware_interface::HW_IF_POSITION>
 {
 public:
+  using JointHandles =
+    std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>;
+
   bool init(
-    std::optional<std::reference_wrapper<hardware_interface::LoanedCommandInterface>> joint_handle,
-    const rclcpp_lifecycle::LifecycleNode::SharedPtr & /* node */)
+    const JointHandles & joint_handles,
+    const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & /* node */)
   {
-    joint_handle_ = joint_handle;
+    joint_handles_ = joint_handles;
     return true;
   }
 
@@ -80,21 +100,26 @@ public:
   void stopping(const rclcpp::Time & /* time */) {}
 
   double updateCommand(
-    double desired_position, double /* desired_velocity */, double /* error_position */,
-    double /* error_velocity */, double max_allowed_effort)
+    double desired_position, double /* desired_velocity */,
+    const std::vector<double> & /* error_position */,
+    const std::vector<double> & /* error_velocity */, double max_allowed_effort,
+    const rclcpp::Duration & /* period */)
   {
     // Forward desired position to command
-    joint_handle_->get().set_value(desired_position);
+    for (auto & joint_handle : joint_handles_)
+    {
+      joint_handle.get().set_value(desired_position);
+    }
     return max_allowed_effort;
   }
 
 private:
-  std::optional<std::reference_wrapper<hardware_interface::LoanedCommandInterface>> joint_handle_;
+  JointHandles joint_handles_;
 };
 
 /**
  * \brief Adapter for an effort-controlled hardware interface. Maps position and
- * velocity errors to effort commands through a position PID loop.
+ * velocity errors to effort commands through a position PID loop of every joint.
  *
  * The following is an example configuration of a controller that uses this
  * adapter. Notice the \p gains entry: \code gripper_controller: type:
@@ -110,6 +135,9 @@ template <>
 class HardwareInterfaceAdapter<hardware_interface::HW_IF_EFFORT>
 {
 public:
+  using JointHandles =
+    std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>;
+
   template <typename ParameterT>
   auto auto_declare(
     const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node, const std::string & name,
@@ -126,59 +154,67 @@ public:
   }
 
   bool init(
-    std::optional<std::reference_wrapper<hardware_interface::LoanedCommandInterface>> joint_handle,
+    const JointHandles & joint_handles,
     const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node)
   {
-    joint_handle_ = joint_handle;
-    // Init PID gains from ROS parameter server
-    const std::string prefix = "gains." + joint_handle_->get().get_prefix_name();
-    const auto k_p = auto_declare<double>(node, prefix + ".p", 0.0);
-    const auto k_i = auto_declare<double>(node, prefix + ".i", 0.0);
-    const auto k_d = auto_declare<double>(node, prefix + ".d", 0.0);
-    const auto i_clamp = auto_declare<double>(node, prefix + ".i_clamp", 0.0);
-    // Initialize PID
-    pid_ = std::make_shared<control_toolbox::Pid>(k_p, k_i, k_d, i_clamp, -i_clamp);
+    joint_handles_ = joint_handles;
+    pid_.resize(joint_handles_.size());
+    commands_.assign(joint_handles_.size(), 0.0);
+    for (size_t i = 0; i < joint_handles_.size(); ++i)
+    {
+      // Init PID gains from ROS parameter server
+      const std::string prefix = "gains." + joint_handles_[i].get().get_prefix_name();
+      const auto k_p = auto_declare<double>(node, prefix + ".p", 0.0);
+      const auto k_i = auto_declare<double>(node, prefix + ".i", 0.0);
+      const auto k_d = auto_declare<double>(node, prefix + ".d", 0.0);
+      const auto i_clamp = auto_declare<double>(node, prefix + ".i_clamp", 0.0);
+      pid_.set_gains(i, {k_p, k_i, k_d, i_clamp, -i_clamp, false});
+    }
     return true;
   }
 
   void starting(const rclcpp::Time & /* time */)
   {
-    if (!joint_handle_)
+    // Reset PIDs, zero effort commands
+    pid_.reset();
+    for (auto & joint_handle : joint_handles_)
     {
-      return;
+      joint_handle.get().set_value(0.0);
     }
-    // Reset PIDs, zero effort commands
-    pid_->reset();
-    joint_handle_->get().set_value(0.0);
   }
 
   void stopping(const rclcpp::Time & /* time */) {}
 
   double updateCommand(
-    double /* desired_position */, double /* desired_velocity */, double error_position,
-    double error_velocity, double max_allowed_effort)
+    double /* desired_position */, double /* desired_velocity */,
+    const std::vector<double> & error_position, const std::vector<double> & error_velocity,
+    double max_allowed_effort, const rclcpp::Duration & period)
   {
     // Preconditions
-    if (!joint_handle_)
+    if (joint_handles_.empty())
     {
       return 0.0;
     }
-    // Time since the last call to update
-    const auto period = std::chrono::steady_clock::now() - last_update_time_;
-    // Update PIDs
-    double command = pid_->computeCommand(error_position, error_velocity, period.count());
-    command = std::min<double>(
-      fabs(max_allowed_effort), std::max<double>(-fabs(max_allowed_effort), command));
-    joint_handle_->get().set_value(command);
-    last_update_time_ = std::chrono::steady_clock::now();
-    return command;
+    // Update the PIDs of all joints in one pass, with the period of the controller update instead
+    // of the wall time, so the gripper behaves the same in a simulation faster than real time
+    pid_.compute_commands(
+      error_position, error_velocity, static_cast<uint64_t>(period.nanoseconds()), commands_);
+    double sum = 0.0;
+    for (size_t i = 0; i < joint_handles_.size(); ++i)
+    {
+      const double command = std::min<double>(
+        fabs(max_allowed_effort), std::max<double>(-fabs(max_allowed_effort), commands_[i]));
+      joint_handles_[i].get().set_value(command);
+      sum += command;
+    }
+    return sum / static_cast<double>(joint_handles_.size());
   }
 
 private:
-  using PidPtr = std::shared_ptr<control_toolbox::Pid>;
-  PidPtr pid_;
-  std::optional<std::reference_wrapper<hardware_interface::LoanedCommandInterface>> joint_handle_;
-  std::chrono::steady_clock::time_point last_update_time_;
+  pid_bank::PidBank pid_;
+  JointHandles joint_handles_;
+  // preallocated commands of all joints
+  std::vector<double> commands_;
 };
 
 #endif  // GRIPPER_CONTROLLERS__HARDWARE_INTERFACE_ADAPTER_HPP_
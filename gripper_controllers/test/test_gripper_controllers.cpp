@@ -12,9 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -25,12 +27,14 @@
 #include "hardware_interface/loaned_command_interface.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp_action/create_client.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 
 using hardware_interface::LoanedCommandInterface;
 using hardware_interface::LoanedStateInterface;
 using GripperCommandAction = control_msgs::action::GripperCommand;
 using GoalHandle = rclcpp_action::ServerGoalHandle<GripperCommandAction>;
+using testing::ElementsAre;
 using testing::SizeIs;
 using testing::UnorderedElementsAre;
 
@@ -183,3 +187,193 @@ TYPED_TEST(GripperControllerTest, ActivateDeactivateActivateSuccess)
     this->controller_->on_activate(rclcpp_lifecycle::State()),
     controller_interface::CallbackReturn::SUCCESS);
 }
+
+TYPED_TEST(GripperControllerTest, UpdateUsesTheUpdateTime)
+{
+  this->SetUpController();
+
+  this->controller_->get_node()->set_parameter({"joint", "joint1"});
+
+  ASSERT_EQ(
+    this->controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    this->controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  // the hold position command of the activation starts the stall detection at the update time
+  const rclcpp::Time time(10, 0, RCL_ROS_TIME);
+  ASSERT_EQ(
+    this->controller_->update(time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(this->controller_->get_last_movement_time(), time);
+
+  // without a new command it is kept
+  ASSERT_EQ(
+    this->controller_->update(
+      time + rclcpp::Duration::from_seconds(1.0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(this->controller_->get_last_movement_time(), time);
+}
+
+TYPED_TEST(GripperControllerTest, CoupledJointsAreCommandedTogether)
+{
+  ASSERT_EQ(
+    this->controller_->init("gripper_controller", "", 0), controller_interface::return_type::OK);
+
+  std::vector<double> states = {1.0, 0.0, 2.0, 0.0};
+  std::vector<double> commands = {0.0, 0.0};
+  StateInterface finger_1_pos_state{"finger_1", HW_IF_POSITION, &states[0]};
+  StateInterface finger_1_vel_state{"finger_1", HW_IF_VELOCITY, &states[1]};
+  StateInterface finger_2_pos_state{"finger_2", HW_IF_POSITION, &states[2]};
+  StateInterface finger_2_vel_state{"finger_2", HW_IF_VELOCITY, &states[3]};
+  CommandInterface finger_1_cmd{"finger_1", TypeParam::value, &commands[0]};
+  CommandInterface finger_2_cmd{"finger_2", TypeParam::value, &commands[1]};
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(finger_2_cmd);
+  command_ifs.emplace_back(finger_1_cmd);
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(finger_1_pos_state);
+  state_ifs.emplace_back(finger_1_vel_state);
+  state_ifs.emplace_back(finger_2_pos_state);
+  state_ifs.emplace_back(finger_2_vel_state);
+  this->controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+
+  // the joints take precedence over the joint
+  this->controller_->get_node()->set_parameter({"joint", "joint1"});
+  this->controller_->get_node()->set_parameter(
+    {"joints", std::vector<std::string>{"finger_1", "finger_2"}});
+  ASSERT_EQ(
+    this->controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  EXPECT_THAT(
+    this->controller_->command_interface_configuration().names,
+    ElementsAre(
+      std::string("finger_1/") + TypeParam::value, std::string("finger_2/") + TypeParam::value));
+  EXPECT_THAT(
+    this->controller_->state_interface_configuration().names,
+    ElementsAre(
+      "finger_1/position", "finger_1/velocity", "finger_2/position", "finger_2/velocity"));
+
+  ASSERT_EQ(
+    this->controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    this->controller_->update(
+      rclcpp::Time(10, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  // both joints hold the mean position
+  if (std::string(TypeParam::value) == HW_IF_POSITION)
+  {
+    EXPECT_THAT(commands, ElementsAre(1.5, 1.5));
+  }
+  else
+  {
+    // without gains
+    EXPECT_THAT(commands, ElementsAre(0.0, 0.0));
+  }
+}
+
+TYPED_TEST(GripperControllerTest, FeedbackIsFilledInUpdate)
+{
+  this->SetUpController();
+
+  this->controller_->get_node()->set_parameter({"joint", "joint1"});
+
+  ASSERT_EQ(
+    this->controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    this->controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  auto client_node = std::make_shared<rclcpp::Node>("gripper_client");
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(this->controller_->get_node()->get_node_base_interface());
+  executor.add_node(client_node);
+  auto action_client = rclcpp_action::create_client<GripperCommandAction>(
+    client_node, "/gripper_controller/gripper_cmd");
+  ASSERT_TRUE(action_client->wait_for_action_server(std::chrono::seconds(1)));
+
+  std::shared_ptr<const GripperCommandAction::Feedback> received_feedback;
+  rclcpp_action::Client<GripperCommandAction>::SendGoalOptions goal_options;
+  goal_options.feedback_callback =
+    [&received_feedback](
+      rclcpp_action::ClientGoalHandle<GripperCommandAction>::SharedPtr,
+      const std::shared_ptr<const GripperCommandAction::Feedback> feedback)
+  { received_feedback = feedback; };
+  GripperCommandAction::Goal goal;
+  goal.command.position = 0.5;
+  goal.command.max_effort = 1.0;
+  auto goal_handle_future = action_client->async_send_goal(goal, goal_options);
+  ASSERT_EQ(
+    executor.spin_until_future_complete(goal_handle_future, std::chrono::seconds(1)),
+    rclcpp::FutureReturnCode::SUCCESS);
+  ASSERT_TRUE(goal_handle_future.get());
+
+  // the goal monitor sends the feedback of the update
+  rclcpp::Time time(10, 0, RCL_ROS_TIME);
+  for (int i = 0; i < 100 && !received_feedback; ++i)
+  {
+    ASSERT_EQ(
+      this->controller_->update(time, rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    time += rclcpp::Duration::from_seconds(0.01);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    executor.spin_some();
+  }
+  ASSERT_TRUE(received_feedback);
+  EXPECT_DOUBLE_EQ(received_feedback->position, this->joint_states_[0]);
+  EXPECT_FALSE(received_feedback->reached_goal);
+  // the joint moves faster than the stall velocity threshold
+  EXPECT_FALSE(received_feedback->stalled);
+}
+
+TYPED_TEST(GripperControllerTest, CommandRampsToTheGoalAtMaxVelocity)
+{
+  this->SetUpController();
+
+  this->controller_->get_node()->set_parameter({"joint", "joint1"});
+  this->controller_->get_node()->set_parameter({"max_velocity", 1.0});
+  this->controller_->get_node()->declare_parameter("gains.joint1.p", 100.0);
+  ASSERT_EQ(
+    this->controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    this->controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  // one goal, the joint doesn't move
+  const double start_position = this->joint_states_[0];
+  this->controller_->command_.write({start_position + 0.025, 10.0});
+  rclcpp::Time time(10, 0, RCL_ROS_TIME);
+  std::vector<double> commands;
+  for (int i = 0; i < 4; ++i)
+  {
+    ASSERT_EQ(
+      this->controller_->update(time, rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    time += rclcpp::Duration::from_seconds(0.01);
+    commands.push_back(this->joint_commands_[0]);
+  }
+
+  // 0.01 per update until the goal is reached, instead of a step to the goal
+  if (std::string(TypeParam::value) == HW_IF_POSITION)
+  {
+    EXPECT_THAT(
+      commands, ElementsAre(
+                  testing::DoubleNear(start_position + 0.01, 1e-9),
+                  testing::DoubleNear(start_position + 0.02, 1e-9),
+                  testing::DoubleNear(start_position + 0.025, 1e-9),
+                  testing::DoubleNear(start_position + 0.025, 1e-9)));
+  }
+  else
+  {
+    // the PID loops track the ramp
+    EXPECT_THAT(
+      commands, ElementsAre(
+                  testing::DoubleNear(1.0, 1e-6), testing::DoubleNear(2.0, 1e-6),
+                  testing::DoubleNear(2.5, 1e-6), testing::DoubleNear(2.5, 1e-6)));
+  }
+}
@@ -39,6 +39,9 @@ class FriendGripperController
 : public gripper_action_controller::GripperActionController<HardwareInterface>
 {
   FRIEND_TEST(GripperControllerTest, CommandSuccessTest);
+
+public:
+  const rclcpp::Time & get_last_movement_time() const { return this->last_movement_time_; }
 };
 
 template <typename T>
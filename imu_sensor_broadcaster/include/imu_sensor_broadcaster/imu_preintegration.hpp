@@ -0,0 +1,146 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IMU_SENSOR_BROADCASTER__IMU_PREINTEGRATION_HPP_
+#define IMU_SENSOR_BROADCASTER__IMU_PREINTEGRATION_HPP_
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <cmath>
+
+namespace imu_sensor_broadcaster
+{
+/**
+ * \brief Preintegration of IMU samples between two keyframes.
+ *
+ * Integrates the angular velocities and linear accelerations into the rotation, velocity and
+ * position deltas in the IMU frame at the start of the interval, as in "On-Manifold
+ * Preintegration for Real-Time Visual-Inertial Odometry" by C. Forster et al. Gravity is not
+ * removed, and biases have to be removed from the samples before, so that the deltas only depend
+ * on the samples of the interval.
+ *
+ * The covariance of the deltas [rotation, velocity, position] is propagated from the covariances
+ * of the samples. All storage is fixed, so integrate() is realtime-safe.
+ */
+class ImuPreintegration
+{
+public:
+  using Matrix9d = Eigen::Matrix<double, 9, 9>;
+
+  /// Set the covariances of a single angular velocity and linear acceleration sample
+  void set_sample_covariances(
+    const Eigen::Matrix3d & angular_velocity_covariance,
+    const Eigen::Matrix3d & linear_acceleration_covariance)
+  {
+    angular_velocity_covariance_ = angular_velocity_covariance;
+    linear_acceleration_covariance_ = linear_acceleration_covariance;
+  }
+
+  /// Start a new interval
+  void reset()
+  {
+    delta_rotation_.setIdentity();
+    delta_velocity_.setZero();
+    delta_position_.setZero();
+    covariance_.setZero();
+    delta_time_ = 0.0;
+  }
+
+  /// Add a sample held for \p dt seconds; samples with non-finite values or \p dt are ignored
+  void integrate(
+    const Eigen::Vector3d & angular_velocity, const Eigen::Vector3d & linear_acceleration,
+    const double dt)
+  {
+    if (!(dt > 0.0) || !angular_velocity.allFinite() || !linear_acceleration.allFinite())
+    {
+      return;
+    }
+    const Eigen::Matrix3d rotation = delta_rotation_.toRotationMatrix();
+    const Eigen::Vector3d rotation_vector = angular_velocity * dt;
+    const Eigen::Matrix3d increment = exp(rotation_vector);
+    const Eigen::Matrix3d acceleration_skew = skew(linear_acceleration);
+
+    // propagation of the errors of [rotation, velocity, position] and of the sample noise
+    Matrix9d a = Matrix9d::Identity();
+    a.block<3, 3>(0, 0) = increment.transpose();
+    a.block<3, 3>(3, 0) = -rotation * acceleration_skew * dt;
+    a.block<3, 3>(6, 0) = -0.5 * rotation * acceleration_skew * dt * dt;
+    a.block<3, 3>(6, 3) = Eigen::Matrix3d::Identity() * dt;
+    Eigen::Matrix<double, 9, 3> b = Eigen::Matrix<double, 9, 3>::Zero();
+    b.block<3, 3>(0, 0) = right_jacobian(rotation_vector) * dt;
+    Eigen::Matrix<double, 9, 3> c = Eigen::Matrix<double, 9, 3>::Zero();
+    c.block<3, 3>(3, 0) = rotation * dt;
+    c.block<3, 3>(6, 0) = 0.5 * rotation * dt * dt;
+    covariance_ = a * covariance_ * a.transpose() +
+                  b * angular_velocity_covariance_ * b.transpose() +
+                  c * linear_acceleration_covariance_ * c.transpose();
+
+    const Eigen::Vector3d acceleration = rotation * linear_acceleration;
+    delta_position_ += delta_velocity_ * dt + 0.5 * acceleration * dt * dt;
+    delta_velocity_ += acceleration * dt;
+    delta_rotation_ = (delta_rotation_ * Eigen::Quaterniond(increment)).normalized();
+    delta_time_ += dt;
+  }
+
+  const Eigen::Quaterniond & delta_rotation() const { return delta_rotation_; }
+  const Eigen::Vector3d & delta_velocity() const { return delta_velocity_; }
+  const Eigen::Vector3d & delta_position() const { return delta_position_; }
+  /// Covariance of the errors of [rotation, velocity, position], the rotation error on the right
+  const Matrix9d & covariance() const { return covariance_; }
+  /// Sum of the time steps of the integrated samples
+  double delta_time() const { return delta_time_; }
+
+private:
+  static Eigen::Matrix3d skew(const Eigen::Vector3d & v)
+  {
+    Eigen::Matrix3d m;
+    m << 0.0, -v.z(), v.y(), v.z(), 0.0, -v.x(), -v.y(), v.x(), 0.0;
+    return m;
+  }
+
+  static Eigen::Matrix3d exp(const Eigen::Vector3d & rotation_vector)
+  {
+    const double angle = rotation_vector.norm();
+    if (angle < 1e-12)
+    {
+      return Eigen::Matrix3d::Identity() + skew(rotation_vector);
+    }
+    return Eigen::AngleAxisd(angle, rotation_vector / angle).toRotationMatrix();
+  }
+
+  static Eigen::Matrix3d right_jacobian(const Eigen::Vector3d & rotation_vector)
+  {
+    const double angle = rotation_vector.norm();
+    const Eigen::Matrix3d phi = skew(rotation_vector);
+    if (angle < 1e-6)
+    {
+      return Eigen::Matrix3d::Identity() - 0.5 * phi;
+    }
+    const double angle2 = angle * angle;
+    return Eigen::Matrix3d::Identity() - (1.0 - std::cos(angle)) / angle2 * phi +
+           (angle - std::sin(angle)) / (angle2 * angle) * phi * phi;
+  }
+
+  Eigen::Quaterniond delta_rotation_ = Eigen::Quaterniond::Identity();
+  Eigen::Vector3d delta_velocity_ = Eigen::Vector3d::Zero();
+  Eigen::Vector3d delta_position_ = Eigen::Vector3d::Zero();
+  Matrix9d covariance_ = Matrix9d::Zero();
+  double delta_time_ = 0.0;
+  Eigen::Matrix3d angular_velocity_covariance_ = Eigen::Matrix3d::Zero();
+  Eigen::Matrix3d linear_acceleration_covariance_ = Eigen::Matrix3d::Zero();
+};
+
+}  // namespace imu_sensor_broadcaster
+
+#endif  // IMU_SENSOR_BROADCASTER__IMU_PREINTEGRATION_HPP_
@@ -19,31 +19,33 @@
 #ifndef IMU_SENSOR_BROADCASTER__IMU_SENSOR_BROADCASTER_HPP_
 #define IMU_SENSOR_BROADCASTER__IMU_SENSOR_BROADCASTER_HPP_
 
+#include <array>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
+#include "imu_sensor_broadcaster/imu_preintegration.hpp"
+#include "imu_sensor_broadcaster/orientation_filter.hpp"
 #include "imu_sensor_broadcaster/visibility_control.h"
 // auto-generated by generate_parameter_library
 #include "imu_sensor_broadcaster_parameters.hpp"
+#include "nav_msgs/msg/odometry.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 #include "realtime_tools/realtime_publisher.h"
+#include "semantic_component_broadcaster/semantic_component_broadcaster.hpp"
 #include "semantic_components/imu_sensor.hpp"
 #include "sensor_msgs/msg/imu.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
 
 namespace imu_sensor_broadcaster
 {
-class IMUSensorBroadcaster : public controller_interface::ControllerInterface
+class IMUSensorBroadcaster
+: public semantic_component_broadcaster::SemanticComponentBroadcaster<
+    semantic_components::IMUSensor, sensor_msgs::msg::Imu>
 {
 public:
-  IMU_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
-
-  IMU_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
-
   IMU_SENSOR_BROADCASTER_PUBLIC controller_interface::CallbackReturn on_init() override;
 
   IMU_SENSOR_BROADCASTER_PUBLIC
@@ -54,23 +56,39 @@ public:
   controller_interface::CallbackReturn on_activate(
     const rclcpp_lifecycle::State & previous_state) override;
 
-  IMU_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::CallbackReturn on_deactivate(
-    const rclcpp_lifecycle::State & previous_state) override;
-
   IMU_SENSOR_BROADCASTER_PUBLIC
   controller_interface::return_type update(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
 protected:
+  using Base = semantic_component_broadcaster::SemanticComponentBroadcaster<
+    semantic_components::IMUSensor, sensor_msgs::msg::Imu>;
+
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
 
-  std::unique_ptr<semantic_components::IMUSensor> imu_sensor_;
+  /// Without the orientation interfaces if the orientation is estimated
+  std::vector<std::string> get_sensor_state_interface_names() const override;
+
+  /// Fill the message with the estimated orientation if the orientation is estimated
+  void fill_message(const rclcpp::Time & time, sensor_msgs::msg::Imu & message) override;
+
+  /// Read the angular velocity and linear acceleration of the current sample
+  void read_sample();
+
+  std::array<double, 3> angular_velocity_ = {0.0, 0.0, 0.0};
+  std::array<double, 3> linear_acceleration_ = {0.0, 0.0, 0.0};
+
+  std::unique_ptr<OrientationFilter> orientation_filter_;
+
+  /// Integrate the current sample, publishes the deltas at the preintegration publish rate
+  void update_preintegration(const rclcpp::Time & time, const rclcpp::Duration & period);
 
-  using StatePublisher = realtime_tools::RealtimePublisher<sensor_msgs::msg::Imu>;
-  rclcpp::Publisher<sensor_msgs::msg::Imu>::SharedPtr sensor_state_publisher_;
-  std::unique_ptr<StatePublisher> realtime_publisher_;
+  using PreintegratedPublisher = realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>;
+  rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr preintegrated_publisher_;
+  std::unique_ptr<PreintegratedPublisher> realtime_preintegrated_publisher_;
+  ImuPreintegration preintegration_;
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> preintegration_publish_rate_;
 };
 
 }  // namespace imu_sensor_broadcaster
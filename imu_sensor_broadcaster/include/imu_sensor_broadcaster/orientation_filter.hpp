@@ -0,0 +1,173 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IMU_SENSOR_BROADCASTER__ORIENTATION_FILTER_HPP_
+#define IMU_SENSOR_BROADCASTER__ORIENTATION_FILTER_HPP_
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <cmath>
+
+namespace imu_sensor_broadcaster
+{
+/**
+ * \brief Estimation of the orientation of an IMU from its angular velocities and linear
+ * accelerations.
+ *
+ * The angular velocities are integrated, and the drift of roll and pitch is corrected towards the
+ * direction of gravity measured by the accelerometer. The correction is either the gradient
+ * descent step of "An efficient orientation filter for inertial and inertial/magnetic sensor
+ * arrays" by S. Madgwick, as in imu_filter_madgwick without a magnetometer, or the proportional
+ * feedback of the explicit complementary filter of "Nonlinear Complementary Filters on the
+ * Special Orthogonal Group" by R. Mahony et al. Without a magnetometer, the yaw is only
+ * integrated and starts at zero.
+ *
+ * The orientation is the one of the IMU frame in a frame with the z axis up. All storage is
+ * fixed, so update() is realtime-safe.
+ */
+class OrientationFilter
+{
+public:
+  enum class Type
+  {
+    MADGWICK,
+    COMPLEMENTARY,
+  };
+
+  /// Set the \p type of the correction and its \p gain, beta for Madgwick and k_P (1/s) otherwise
+  void configure(Type type, double gain)
+  {
+    type_ = type;
+    gain_ = gain;
+    reset();
+  }
+
+  /// Start over, the next sample with a valid acceleration initializes roll and pitch
+  void reset()
+  {
+    orientation_.setIdentity();
+    initialized_ = false;
+  }
+
+  /// Add a sample held for \p dt seconds; samples with non-finite values or \p dt are ignored
+  void update(
+    const Eigen::Vector3d & angular_velocity, const Eigen::Vector3d & linear_acceleration,
+    const double dt)
+  {
+    if (!(dt > 0.0) || !angular_velocity.allFinite() || !linear_acceleration.allFinite())
+    {
+      return;
+    }
+    // the direction of the acceleration is not used in free fall
+    const double acceleration_norm = linear_acceleration.norm();
+    const bool has_acceleration = acceleration_norm > 0.0;
+    Eigen::Vector3d acceleration_direction = Eigen::Vector3d::Zero();
+    if (has_acceleration)
+    {
+      acceleration_direction = linear_acceleration / acceleration_norm;
+    }
+    if (!initialized_)
+    {
+      if (!has_acceleration)
+      {
+        return;
+      }
+      // the smallest rotation of the measured acceleration to the z axis, i.e., zero yaw
+      orientation_.setFromTwoVectors(linear_acceleration, Eigen::Vector3d::UnitZ());
+      initialized_ = true;
+      return;
+    }
+
+    if (type_ == Type::MADGWICK)
+    {
+      update_madgwick(angular_velocity, acceleration_direction, has_acceleration, dt);
+    }
+    else
+    {
+      Eigen::Vector3d corrected_angular_velocity = angular_velocity;
+      if (has_acceleration)
+      {
+        // the error between the measured and the estimated direction of gravity
+        corrected_angular_velocity += gain_ * acceleration_direction.cross(estimated_up());
+      }
+      const Eigen::Vector3d rotation_vector = corrected_angular_velocity * dt;
+      const double angle = rotation_vector.norm();
+      if (angle > 0.0)
+      {
+        orientation_ *= Eigen::Quaterniond(Eigen::AngleAxisd(angle, rotation_vector / angle));
+      }
+    }
+    orientation_.normalize();
+  }
+
+  /// \return true if the orientation was initialized by an acceleration since reset()
+  bool is_initialized() const { return initialized_; }
+
+  const Eigen::Quaterniond & orientation() const { return orientation_; }
+
+private:
+  // the z axis of the world in the IMU frame
+  Eigen::Vector3d estimated_up() const
+  {
+    const double w = orientation_.w();
+    const double x = orientation_.x();
+    const double y = orientation_.y();
+    const double z = orientation_.z();
+    return Eigen::Vector3d(
+      2.0 * (x * z - w * y), 2.0 * (w * x + y * z), 1.0 - 2.0 * (x * x + y * y));
+  }
+
+  void update_madgwick(
+    const Eigen::Vector3d & angular_velocity, const Eigen::Vector3d & acceleration_direction,
+    bool has_acceleration, double dt)
+  {
+    // [w, x, y, z]
+    Eigen::Vector4d q(orientation_.w(), orientation_.x(), orientation_.y(), orientation_.z());
+    // rate of change of the orientation by the angular velocity, 0.5 * q * (0, angular_velocity)
+    const double gx = angular_velocity.x();
+    const double gy = angular_velocity.y();
+    const double gz = angular_velocity.z();
+    Eigen::Vector4d q_dot(
+      -q[1] * gx - q[2] * gy - q[3] * gz, q[0] * gx + q[2] * gz - q[3] * gy,
+      q[0] * gy - q[1] * gz + q[3] * gx, q[0] * gz + q[1] * gy - q[2] * gx);
+    q_dot *= 0.5;
+
+    if (has_acceleration)
+    {
+      // gradient of the squared error between the estimated and the measured direction of gravity
+      const Eigen::Vector3d error = estimated_up() - acceleration_direction;
+      Eigen::Matrix<double, 3, 4> jacobian;
+      jacobian << -2.0 * q[2], 2.0 * q[3], -2.0 * q[0], 2.0 * q[1],  //
+        2.0 * q[1], 2.0 * q[0], 2.0 * q[3], 2.0 * q[2],               //
+        0.0, -4.0 * q[1], -4.0 * q[2], 0.0;
+      const Eigen::Vector4d gradient = jacobian.transpose() * error;
+      const double gradient_norm = gradient.norm();
+      if (gradient_norm > 0.0)
+      {
+        q_dot -= gain_ * gradient / gradient_norm;
+      }
+    }
+    q += q_dot * dt;
+    orientation_ = Eigen::Quaterniond(q[0], q[1], q[2], q[3]);
+  }
+
+  Type type_ = Type::MADGWICK;
+  double gain_ = 0.1;
+  Eigen::Quaterniond orientation_ = Eigen::Quaterniond::Identity();
+  bool initialized_ = false;
+};
+
+}  // namespace imu_sensor_broadcaster
+
+#endif  // IMU_SENSOR_BROADCASTER__ORIENTATION_FILTER_HPP_
@@ -18,8 +18,11 @@
 
 #include "imu_sensor_broadcaster/imu_sensor_broadcaster.hpp"
 
+#include <initializer_list>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace imu_sensor_broadcaster
 {
@@ -45,20 +48,18 @@ controller_interface::CallbackReturn IMUSensorBroadcaster::on_configure(
 {
   params_ = param_listener_->get_params();
 
-  imu_sensor_ = std::make_unique<semantic_components::IMUSensor>(
+  semantic_component_ = std::make_unique<semantic_components::IMUSensor>(
     semantic_components::IMUSensor(params_.sensor_name));
-  try
-  {
-    // register ft sensor data publisher
-    sensor_state_publisher_ =
-      get_node()->create_publisher<sensor_msgs::msg::Imu>("~/imu", rclcpp::SystemDefaultsQoS());
-    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_);
-  }
-  catch (const std::exception & e)
+  semantic_component_broadcaster::BroadcasterOptions options;
+  options.publish_rate = params_.publish_rate;
+  options.publish_on_change = params_.publish_on_change;
+  options.sequence_interface_name = params_.sequence_interface_name;
+  options.publisher_thread = params_.publisher_thread.enable;
+  options.queue_size = static_cast<size_t>(params_.publisher_thread.queue_size);
+  options.batch_size = static_cast<size_t>(params_.publisher_thread.batch_size);
+  options.publish_unique_ptr = params_.publisher_thread.publish_unique_ptr;
+  if (!configure_broadcaster("~/imu", options))
   {
-    fprintf(
-      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
-      e.what());
     return CallbackReturn::ERROR;
   }
 
@@ -75,52 +76,201 @@ controller_interface::CallbackReturn IMUSensorBroadcaster::on_configure(
   }
   realtime_publisher_->unlock();
 
+  realtime_preintegrated_publisher_.reset();
+  preintegration_publish_rate_.reset();
+  if (params_.preintegration.enable)
+  {
+    try
+    {
+      preintegrated_publisher_ = get_node()->create_publisher<nav_msgs::msg::Odometry>(
+        "~/preintegrated", rclcpp::SystemDefaultsQoS());
+      realtime_preintegrated_publisher_ =
+        std::make_unique<PreintegratedPublisher>(preintegrated_publisher_);
+    }
+    catch (const std::exception & e)
+    {
+      fprintf(
+        stderr,
+        "Exception thrown during publisher creation at configure stage with message : %s \n",
+        e.what());
+      return CallbackReturn::ERROR;
+    }
+    // both frames are the IMU frame, at the start and at the end of the interval
+    realtime_preintegrated_publisher_->lock();
+    realtime_preintegrated_publisher_->msg_.header.frame_id = params_.frame_id;
+    realtime_preintegrated_publisher_->msg_.child_frame_id = params_.frame_id;
+    realtime_preintegrated_publisher_->unlock();
+
+    using RowMajorMatrix3d = Eigen::Matrix<double, 3, 3, Eigen::RowMajor>;
+    preintegration_.set_sample_covariances(
+      Eigen::Map<const RowMajorMatrix3d>(params_.static_covariance_angular_velocity.data()),
+      Eigen::Map<const RowMajorMatrix3d>(params_.static_covariance_linear_acceleration.data()));
+    preintegration_publish_rate_ =
+      telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+        get_node()->get_namespace(), preintegrated_publisher_->get_topic_name(),
+        params_.preintegration.publish_rate);
+  }
+
+  orientation_filter_.reset();
+  if (params_.orientation_filter.enable)
+  {
+    orientation_filter_ = std::make_unique<OrientationFilter>();
+    orientation_filter_->configure(
+      params_.orientation_filter.type == "complementary" ? OrientationFilter::Type::COMPLEMENTARY
+                                                         : OrientationFilter::Type::MADGWICK,
+      params_.orientation_filter.gain);
+  }
+
   RCLCPP_DEBUG(get_node()->get_logger(), "configure successful");
   return CallbackReturn::SUCCESS;
 }
 
-controller_interface::InterfaceConfiguration IMUSensorBroadcaster::command_interface_configuration()
-  const
+std::vector<std::string> IMUSensorBroadcaster::get_sensor_state_interface_names() const
 {
-  controller_interface::InterfaceConfiguration command_interfaces_config;
-  command_interfaces_config.type = controller_interface::interface_configuration_type::NONE;
-  return command_interfaces_config;
+  if (!params_.orientation_filter.enable)
+  {
+    return Base::get_sensor_state_interface_names();
+  }
+  // read by read_sample() in this order
+  std::vector<std::string> names;
+  for (const auto & name :
+       {"angular_velocity.x", "angular_velocity.y", "angular_velocity.z", "linear_acceleration.x",
+        "linear_acceleration.y", "linear_acceleration.z"})
+  {
+    names.push_back(params_.sensor_name + "/" + name);
+  }
+  return names;
+}
+
+controller_interface::CallbackReturn IMUSensorBroadcaster::on_activate(
+  const rclcpp_lifecycle::State & previous_state)
+{
+  if (Base::on_activate(previous_state) != CallbackReturn::SUCCESS)
+  {
+    return CallbackReturn::ERROR;
+  }
+  preintegration_.reset();
+  if (preintegration_publish_rate_)
+  {
+    preintegration_publish_rate_->reset();
+  }
+  if (orientation_filter_)
+  {
+    // the orientation interfaces are not claimed, the semantic component can't read the sample
+    if (state_interfaces_.size() < 6)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "The angular velocity and linear acceleration state interfaces are not available.");
+      return CallbackReturn::ERROR;
+    }
+    orientation_filter_->reset();
+  }
+  return CallbackReturn::SUCCESS;
 }
 
-controller_interface::InterfaceConfiguration IMUSensorBroadcaster::state_interface_configuration()
-  const
+controller_interface::return_type IMUSensorBroadcaster::update(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  controller_interface::InterfaceConfiguration state_interfaces_config;
-  state_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-  state_interfaces_config.names = imu_sensor_->get_state_interface_names();
-  return state_interfaces_config;
+  read_sample();
+  if (orientation_filter_)
+  {
+    orientation_filter_->update(
+      Eigen::Map<const Eigen::Vector3d>(angular_velocity_.data()),
+      Eigen::Map<const Eigen::Vector3d>(linear_acceleration_.data()), period.seconds());
+  }
+  if (realtime_preintegrated_publisher_)
+  {
+    update_preintegration(time, period);
+  }
+
+  return Base::update(time, period);
 }
 
-controller_interface::CallbackReturn IMUSensorBroadcaster::on_activate(
-  const rclcpp_lifecycle::State & /*previous_state*/)
+void IMUSensorBroadcaster::read_sample()
 {
-  imu_sensor_->assign_loaned_state_interfaces(state_interfaces_);
-  return CallbackReturn::SUCCESS;
+  if (!orientation_filter_)
+  {
+    angular_velocity_ = semantic_component_->get_angular_velocity();
+    linear_acceleration_ = semantic_component_->get_linear_acceleration();
+    return;
+  }
+  for (size_t i = 0; i < 3; ++i)
+  {
+    angular_velocity_[i] = state_interfaces_[i].get_value();
+    linear_acceleration_[i] = state_interfaces_[3 + i].get_value();
+  }
 }
 
-controller_interface::CallbackReturn IMUSensorBroadcaster::on_deactivate(
-  const rclcpp_lifecycle::State & /*previous_state*/)
+void IMUSensorBroadcaster::fill_message(const rclcpp::Time & time, sensor_msgs::msg::Imu & message)
 {
-  imu_sensor_->release_interfaces();
-  return CallbackReturn::SUCCESS;
+  if (!orientation_filter_)
+  {
+    Base::fill_message(time, message);
+    return;
+  }
+  message.header.stamp = time;
+  const auto & orientation = orientation_filter_->orientation();
+  message.orientation.x = orientation.x();
+  message.orientation.y = orientation.y();
+  message.orientation.z = orientation.z();
+  message.orientation.w = orientation.w();
+  // no orientation estimate until the first valid acceleration, see sensor_msgs/msg/Imu
+  message.orientation_covariance[0] = orientation_filter_->is_initialized()
+                                        ? params_.static_covariance_orientation[0]
+                                        : -1.0;
+  message.angular_velocity.x = angular_velocity_[0];
+  message.angular_velocity.y = angular_velocity_[1];
+  message.angular_velocity.z = angular_velocity_[2];
+  message.linear_acceleration.x = linear_acceleration_[0];
+  message.linear_acceleration.y = linear_acceleration_[1];
+  message.linear_acceleration.z = linear_acceleration_[2];
 }
 
-controller_interface::return_type IMUSensorBroadcaster::update(
-  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+void IMUSensorBroadcaster::update_preintegration(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  if (realtime_publisher_ && realtime_publisher_->trylock())
+  preintegration_.integrate(
+    Eigen::Map<const Eigen::Vector3d>(angular_velocity_.data()),
+    Eigen::Map<const Eigen::Vector3d>(linear_acceleration_.data()), period.seconds());
+
+  if (
+    !preintegration_publish_rate_->is_due(time) ||
+    !realtime_preintegrated_publisher_->trylock())
   {
-    realtime_publisher_->msg_.header.stamp = time;
-    imu_sensor_->get_values_as_message(realtime_publisher_->msg_);
-    realtime_publisher_->unlockAndPublish();
+    // the interval continues until the deltas can be published
+    return;
   }
+  auto & msg = realtime_preintegrated_publisher_->msg_;
+  msg.header.stamp = time;
+  const auto & delta_position = preintegration_.delta_position();
+  const auto & delta_rotation = preintegration_.delta_rotation();
+  const auto & delta_velocity = preintegration_.delta_velocity();
+  msg.pose.pose.position.x = delta_position.x();
+  msg.pose.pose.position.y = delta_position.y();
+  msg.pose.pose.position.z = delta_position.z();
+  msg.pose.pose.orientation.x = delta_rotation.x();
+  msg.pose.pose.orientation.y = delta_rotation.y();
+  msg.pose.pose.orientation.z = delta_rotation.z();
+  msg.pose.pose.orientation.w = delta_rotation.w();
+  msg.twist.twist.linear.x = delta_velocity.x();
+  msg.twist.twist.linear.y = delta_velocity.y();
+  msg.twist.twist.linear.z = delta_velocity.z();
 
-  return controller_interface::return_type::OK;
+  // [rotation, velocity, position] to the [position, rotation] of the pose and the linear part of
+  // the twist, the correlations between the pose and the velocity are dropped
+  const auto & covariance = preintegration_.covariance();
+  Eigen::Map<Eigen::Matrix<double, 6, 6, Eigen::RowMajor>> pose_covariance(
+    msg.pose.covariance.data());
+  pose_covariance.block<3, 3>(0, 0) = covariance.block<3, 3>(6, 6);
+  pose_covariance.block<3, 3>(0, 3) = covariance.block<3, 3>(6, 0);
+  pose_covariance.block<3, 3>(3, 0) = covariance.block<3, 3>(0, 6);
+  pose_covariance.block<3, 3>(3, 3) = covariance.block<3, 3>(0, 0);
+  Eigen::Map<Eigen::Matrix<double, 6, 6, Eigen::RowMajor>> twist_covariance(
+    msg.twist.covariance.data());
+  twist_covariance.block<3, 3>(0, 0) = covariance.block<3, 3>(3, 3);
+  realtime_preintegrated_publisher_->unlockAndPublish();
+  preintegration_.reset();
 }
 
 }  // namespace imu_sensor_broadcaster
@@ -0,0 +1,104 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <limits>
+
+#include "imu_sensor_broadcaster/imu_preintegration.hpp"
+
+using imu_sensor_broadcaster::ImuPreintegration;
+
+namespace
+{
+constexpr double DT = 0.001;
+constexpr int NUM_SAMPLES = 500;
+}  // namespace
+
+TEST(TestImuPreintegration, constant_acceleration_and_rotation)
+{
+  ImuPreintegration preintegration;
+  preintegration.reset();
+  for (int i = 0; i < NUM_SAMPLES; ++i)
+  {
+    preintegration.integrate({0.0, 0.0, 0.0}, {1.0, 0.0, 2.0}, DT);
+  }
+  const double t = DT * NUM_SAMPLES;
+  EXPECT_NEAR(preintegration.delta_time(), t, 1e-12);
+  EXPECT_TRUE(preintegration.delta_velocity().isApprox(Eigen::Vector3d(t, 0.0, 2.0 * t)));
+  EXPECT_TRUE(
+    preintegration.delta_position().isApprox(Eigen::Vector3d(0.5 * t * t, 0.0, t * t)));
+  EXPECT_NEAR(
+    preintegration.delta_rotation().angularDistance(Eigen::Quaterniond::Identity()), 0.0, 1e-12);
+
+  // the rotation of the samples is integrated as well
+  preintegration.reset();
+  for (int i = 0; i < NUM_SAMPLES; ++i)
+  {
+    preintegration.integrate({0.0, 0.0, 2.0}, {0.0, 0.0, 0.0}, DT);
+  }
+  const Eigen::Quaterniond expected(Eigen::AngleAxisd(2.0 * t, Eigen::Vector3d::UnitZ()));
+  EXPECT_NEAR(preintegration.delta_rotation().angularDistance(expected), 0.0, 1e-9);
+  EXPECT_TRUE(preintegration.delta_velocity().isZero());
+}
+
+TEST(TestImuPreintegration, centripetal_acceleration_of_a_circle)
+{
+  // moving on a circle with the x axis along the velocity, the acceleration points to the center
+  const double radius = 2.0;
+  const double speed = 1.0;
+  const double yaw_rate = speed / radius;
+  ImuPreintegration preintegration;
+  for (int i = 0; i < NUM_SAMPLES; ++i)
+  {
+    preintegration.integrate({0.0, 0.0, yaw_rate}, {0.0, speed * yaw_rate, 0.0}, DT);
+  }
+  // the velocity relative to the initial one, in the initial frame
+  const double angle = yaw_rate * DT * NUM_SAMPLES;
+  const Eigen::Vector3d expected_velocity(
+    speed * (std::cos(angle) - 1.0), speed * std::sin(angle), 0.0);
+  const Eigen::Vector3d expected_position(
+    radius * std::sin(angle) - speed * DT * NUM_SAMPLES, radius * (1.0 - std::cos(angle)), 0.0);
+  EXPECT_LT((preintegration.delta_velocity() - expected_velocity).norm(), 1e-3);
+  EXPECT_LT((preintegration.delta_position() - expected_position).norm(), 1e-3);
+}
+
+TEST(TestImuPreintegration, covariance_and_invalid_samples)
+{
+  ImuPreintegration preintegration;
+  preintegration.set_sample_covariances(
+    Eigen::Matrix3d::Identity() * 1e-4, Eigen::Matrix3d::Identity() * 1e-2);
+  for (int i = 0; i < NUM_SAMPLES; ++i)
+  {
+    preintegration.integrate({0.1, -0.2, 0.3}, {0.5, 0.0, 9.81}, DT);
+  }
+  const auto & covariance = preintegration.covariance();
+  EXPECT_TRUE(covariance.isApprox(covariance.transpose()));
+  // the isotropic rotation error only grows with the angular velocity noise
+  EXPECT_NEAR(covariance(0, 0), NUM_SAMPLES * DT * DT * 1e-4, 1e-9);
+  EXPECT_GT(covariance.diagonal().minCoeff(), 0.0);
+
+  // the deltas are not changed by invalid samples
+  const Eigen::Vector3d delta_velocity = preintegration.delta_velocity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  preintegration.integrate({nan, 0.0, 0.0}, {0.0, 0.0, 0.0}, DT);
+  preintegration.integrate({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, 0.0);
+  EXPECT_EQ(preintegration.delta_velocity(), delta_velocity);
+  EXPECT_NEAR(preintegration.delta_time(), NUM_SAMPLES * DT, 1e-12);
+
+  preintegration.reset();
+  EXPECT_TRUE(preintegration.covariance().isZero());
+  EXPECT_EQ(preintegration.delta_time(), 0.0);
+}
@@ -201,6 +201,112 @@ TEST_F(IMUSensorBroadcasterTest, SensorName_Publish_Success)
   }
 }
 
+TEST_F(IMUSensorBroadcasterTest, SensorName_PublishOnNewSequence_Success)
+{
+  SetUpIMUBroadcaster();
+  imu_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  imu_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  imu_broadcaster_->get_node()->set_parameter({"publish_on_change", true});
+  imu_broadcaster_->get_node()->set_parameter({"sequence_interface_name", "imu_sensor/sequence"});
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(
+    imu_broadcaster_->state_interface_configuration().names.back(), "imu_sensor/sequence");
+
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(imu_orientation_x_);
+  state_ifs.emplace_back(imu_orientation_y_);
+  state_ifs.emplace_back(imu_orientation_z_);
+  state_ifs.emplace_back(imu_orientation_w_);
+  state_ifs.emplace_back(imu_angular_velocity_x_);
+  state_ifs.emplace_back(imu_angular_velocity_y_);
+  state_ifs.emplace_back(imu_angular_velocity_z_);
+  state_ifs.emplace_back(imu_linear_acceleration_x_);
+  state_ifs.emplace_back(imu_linear_acceleration_y_);
+  state_ifs.emplace_back(imu_linear_acceleration_z_);
+  state_ifs.emplace_back(imu_sequence_);
+  imu_broadcaster_->assign_interfaces({}, std::move(state_ifs));
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription = test_subscription_node.create_subscription<sensor_msgs::msg::Imu>(
+    "/test_imu_sensor_broadcaster/imu", 10, [](const sensor_msgs::msg::Imu::SharedPtr) {});
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  sensor_msgs::msg::Imu imu_msg;
+  rclcpp::MessageInfo msg_info;
+
+  ASSERT_EQ(
+    imu_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(wait_set.wait(std::chrono::milliseconds(100)).kind(), rclcpp::WaitResultKind::Ready);
+  ASSERT_TRUE(subscription->take(imu_msg, msg_info));
+
+  // only the sequence counter decides if there is a new sample
+  sensor_values_[4] = 0.5;
+  ASSERT_EQ(
+    imu_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(wait_set.wait(std::chrono::milliseconds(20)).kind(), rclcpp::WaitResultKind::Timeout);
+
+  sequence_value_ = 1.0;
+  ASSERT_EQ(
+    imu_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(wait_set.wait(std::chrono::milliseconds(100)).kind(), rclcpp::WaitResultKind::Ready);
+  ASSERT_TRUE(subscription->take(imu_msg, msg_info));
+  EXPECT_EQ(imu_msg.angular_velocity.x, 0.5);
+}
+
+TEST_F(IMUSensorBroadcasterTest, OrientationFilter_Publish_Success)
+{
+  ASSERT_EQ(
+    imu_broadcaster_->init("test_imu_sensor_broadcaster", "", 0),
+    controller_interface::return_type::OK);
+  imu_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  imu_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  imu_broadcaster_->get_node()->set_parameter({"orientation_filter.enable", true});
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  // the orientation interfaces are not claimed
+  EXPECT_THAT(
+    imu_broadcaster_->state_interface_configuration().names,
+    testing::ElementsAre(
+      "imu_sensor/angular_velocity.x", "imu_sensor/angular_velocity.y",
+      "imu_sensor/angular_velocity.z", "imu_sensor/linear_acceleration.x",
+      "imu_sensor/linear_acceleration.y", "imu_sensor/linear_acceleration.z"));
+
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(imu_angular_velocity_x_);
+  state_ifs.emplace_back(imu_angular_velocity_y_);
+  state_ifs.emplace_back(imu_angular_velocity_z_);
+  state_ifs.emplace_back(imu_linear_acceleration_x_);
+  state_ifs.emplace_back(imu_linear_acceleration_y_);
+  state_ifs.emplace_back(imu_linear_acceleration_z_);
+  imu_broadcaster_->assign_interfaces({}, std::move(state_ifs));
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // at rest, whichever update the received message is from
+  sensor_values_[4] = 0.0;
+  sensor_values_[5] = 0.0;
+  sensor_values_[6] = 0.0;
+  sensor_msgs::msg::Imu imu_msg;
+  subscribe_and_get_message(imu_msg);
+
+  EXPECT_EQ(imu_msg.header.frame_id, frame_id_);
+  EXPECT_EQ(imu_msg.angular_velocity.x, sensor_values_[4]);
+  EXPECT_EQ(imu_msg.angular_velocity.z, sensor_values_[6]);
+  EXPECT_EQ(imu_msg.linear_acceleration.x, sensor_values_[7]);
+  EXPECT_EQ(imu_msg.linear_acceleration.z, sensor_values_[9]);
+  EXPECT_EQ(imu_msg.orientation_covariance[0], 0.0);
+
+  // the estimate is initialized with the measured acceleration along the z axis
+  const Eigen::Quaterniond orientation(
+    imu_msg.orientation.w, imu_msg.orientation.x, imu_msg.orientation.y, imu_msg.orientation.z);
+  EXPECT_NEAR(orientation.norm(), 1.0, 1e-9);
+  const Eigen::Vector3d acceleration(sensor_values_[7], sensor_values_[8], sensor_values_[9]);
+  const Eigen::Vector3d up = (orientation * acceleration).normalized();
+  EXPECT_NEAR(up.z(), 1.0, 1e-6);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
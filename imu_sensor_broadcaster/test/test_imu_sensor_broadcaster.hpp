@@ -76,6 +76,9 @@ protected:
   hardware_interface::StateInterface imu_linear_acceleration_z_{
     sensor_name_, "linear_acceleration.z", &sensor_values_[9]};
 
+  double sequence_value_ = 0.0;
+  hardware_interface::StateInterface imu_sequence_{sensor_name_, "sequence", &sequence_value_};
+
   std::unique_ptr<FriendIMUSensorBroadcaster> imu_broadcaster_;
 
   void subscribe_and_get_message(sensor_msgs::msg::Imu & imu_msg);
@@ -0,0 +1,122 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "imu_sensor_broadcaster/orientation_filter.hpp"
+
+using imu_sensor_broadcaster::OrientationFilter;
+
+namespace
+{
+constexpr double DT = 0.001;
+constexpr double GRAVITY = 9.81;
+
+// the acceleration an IMU at rest with \p orientation measures
+Eigen::Vector3d acceleration_at_rest(const Eigen::Quaterniond & orientation)
+{
+  return orientation.conjugate() * Eigen::Vector3d(0.0, 0.0, GRAVITY);
+}
+}  // namespace
+
+class TestOrientationFilter : public testing::TestWithParam<OrientationFilter::Type>
+{
+};
+
+TEST_P(TestOrientationFilter, initialized_by_the_acceleration)
+{
+  OrientationFilter filter;
+  filter.configure(GetParam(), 0.1);
+  // no orientation without an acceleration
+  filter.update({0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, DT);
+  EXPECT_FALSE(filter.is_initialized());
+
+  const Eigen::Quaterniond tilted(
+    Eigen::AngleAxisd(0.3, Eigen::Vector3d(1.0, -1.0, 0.0).normalized()));
+  filter.update({0.0, 0.0, 0.0}, acceleration_at_rest(tilted), DT);
+  EXPECT_TRUE(filter.is_initialized());
+  // the yaw is zero, so the tilt about a horizontal axis is found exactly
+  EXPECT_NEAR(filter.orientation().angularDistance(tilted), 0.0, 1e-9);
+
+  filter.reset();
+  EXPECT_FALSE(filter.is_initialized());
+}
+
+TEST_P(TestOrientationFilter, rotation_is_integrated)
+{
+  OrientationFilter filter;
+  filter.configure(GetParam(), 0.1);
+  filter.update({0.0, 0.0, 0.0}, {0.0, 0.0, GRAVITY}, DT);
+  // the yaw is not observable by the acceleration, so it follows the angular velocity only
+  for (int i = 0; i < 1000; ++i)
+  {
+    filter.update({0.0, 0.0, 1.0}, {0.0, 0.0, GRAVITY}, DT);
+  }
+  const Eigen::Quaterniond expected(Eigen::AngleAxisd(1.0, Eigen::Vector3d::UnitZ()));
+  EXPECT_NEAR(filter.orientation().angularDistance(expected), 0.0, 1e-6);
+
+  // rolling with gravity measured accordingly
+  Eigen::Quaterniond true_orientation = Eigen::Quaterniond::Identity();
+  filter.reset();
+  filter.update({0.0, 0.0, 0.0}, acceleration_at_rest(true_orientation), DT);
+  for (int i = 0; i < 1000; ++i)
+  {
+    true_orientation *= Eigen::Quaterniond(Eigen::AngleAxisd(0.5 * DT, Eigen::Vector3d::UnitX()));
+    filter.update({0.5, 0.0, 0.0}, acceleration_at_rest(true_orientation), DT);
+  }
+  EXPECT_NEAR(filter.orientation().angularDistance(true_orientation), 0.0, 1e-3);
+}
+
+TEST_P(TestOrientationFilter, gyro_bias_drift_is_corrected)
+{
+  const Eigen::Quaterniond tilted(Eigen::AngleAxisd(0.2, Eigen::Vector3d::UnitY()));
+  OrientationFilter filter;
+  filter.configure(GetParam(), 0.5);
+  filter.update({0.0, 0.0, 0.0}, acceleration_at_rest(tilted), DT);
+  // without the correction, the bias would roll the estimate by 0.5 rad
+  for (int i = 0; i < 10000; ++i)
+  {
+    filter.update({0.05, 0.0, 0.0}, acceleration_at_rest(tilted), DT);
+  }
+  const Eigen::Vector3d estimated_up = filter.orientation().conjugate() * Eigen::Vector3d::UnitZ();
+  const Eigen::Vector3d true_up = tilted.conjugate() * Eigen::Vector3d::UnitZ();
+  EXPECT_LT(std::acos(std::min(1.0, estimated_up.dot(true_up))), 0.15);
+  EXPECT_NEAR(filter.orientation().norm(), 1.0, 1e-12);
+}
+
+TEST_P(TestOrientationFilter, invalid_samples_are_ignored)
+{
+  OrientationFilter filter;
+  filter.configure(GetParam(), 0.1);
+  filter.update({0.0, 0.0, 0.0}, {0.0, 0.0, GRAVITY}, DT);
+  const Eigen::Quaterniond orientation = filter.orientation();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  filter.update({nan, 0.0, 0.0}, {0.0, 0.0, GRAVITY}, DT);
+  filter.update({0.0, 0.0, 0.0}, {0.0, nan, GRAVITY}, DT);
+  filter.update({1.0, 0.0, 0.0}, {0.0, 0.0, GRAVITY}, 0.0);
+  EXPECT_TRUE(filter.orientation().coeffs().isApprox(orientation.coeffs()));
+
+  // in free fall, the angular velocity is integrated only
+  filter.update({1.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, DT);
+  const Eigen::Quaterniond expected(Eigen::AngleAxisd(DT, Eigen::Vector3d::UnitX()));
+  EXPECT_NEAR(filter.orientation().angularDistance(expected), 0.0, 1e-9);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  Types, TestOrientationFilter,
+  testing::Values(OrientationFilter::Type::MADGWICK, OrientationFilter::Type::COMPLEMENTARY));
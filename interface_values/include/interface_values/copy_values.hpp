@@ -0,0 +1,122 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INTERFACE_VALUES__COPY_VALUES_HPP_
+#define INTERFACE_VALUES__COPY_VALUES_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+
+namespace interface_values
+{
+/**
+ * \brief Bit i is set if the i-th copied value is NaN.
+ *
+ * The values from index NAN_MASK_BITS - 1 on share the last bit, so a mask is exact for up to 63
+ * values, and zero if and only if no value is NaN for any number of values.
+ */
+using NanMask = uint64_t;
+
+constexpr size_t NAN_MASK_BITS = 64;
+
+/// Bit of the value with \p index in a NanMask
+constexpr NanMask nan_bit(size_t index)
+{
+  return NanMask{1} << std::min(index, NAN_MASK_BITS - 1);
+}
+
+/// True if the value with \p index may be NaN, exact for indices below NAN_MASK_BITS - 1
+constexpr bool is_nan(NanMask mask, size_t index) { return (mask & nan_bit(index)) != 0; }
+
+/// Index of the first NaN value in \p mask, NAN_MASK_BITS if there is none
+inline size_t first_nan(NanMask mask)
+{
+  if (mask == 0)
+  {
+    return NAN_MASK_BITS;
+  }
+  size_t index = 0;
+  while ((mask & 1) == 0)
+  {
+    mask >>= 1;
+    ++index;
+  }
+  return index;
+}
+
+/// Value of a state or command interface, e.g., a hardware_interface::LoanedStateInterface
+template <typename InterfaceT>
+double value_of(const InterfaceT & interface)
+{
+  return interface.get_value();
+}
+
+template <typename InterfaceT>
+double value_of(const std::reference_wrapper<InterfaceT> & interface)
+{
+  return interface.get().get_value();
+}
+
+template <typename InterfaceT>
+double value_of(const InterfaceT * interface)
+{
+  return interface->get_value();
+}
+
+inline double value_of(double value) { return value; }
+
+/// Copy the values of [\p first, \p last) to \p out while screening them for NaN, realtime-safe
+/**
+ * Every interface is read once, unlike a std::find_if scan for NaN followed by a copy.
+ *
+ * \param get_value returns the value of an element of the input range
+ * \return the NaN values, zero if all values are valid
+ */
+template <typename InputIt, typename OutputIt, typename GetValue>
+NanMask copy_values(InputIt first, InputIt last, OutputIt out, GetValue get_value)
+{
+  NanMask mask = 0;
+  for (size_t index = 0; first != last; ++first, ++out, ++index)
+  {
+    const double value = get_value(*first);
+    *out = value;
+    if (std::isnan(value))
+    {
+      mask |= nan_bit(index);
+    }
+  }
+  return mask;
+}
+
+template <typename InputIt, typename OutputIt>
+NanMask copy_values(InputIt first, InputIt last, OutputIt out)
+{
+  return copy_values(
+    first, last, out, [](const auto & element) { return value_of(element); });
+}
+
+/// Copy the values of all interfaces of \p interfaces to \p out, see copy_values()
+template <typename InputRange, typename OutputIt>
+NanMask copy_values(const InputRange & interfaces, OutputIt out)
+{
+  return copy_values(std::begin(interfaces), std::end(interfaces), out);
+}
+
+}  // namespace interface_values
+
+#endif  // INTERFACE_VALUES__COPY_VALUES_HPP_
@@ -0,0 +1,107 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "interface_values/copy_values.hpp"
+
+using interface_values::copy_values;
+using interface_values::first_nan;
+using interface_values::is_nan;
+using interface_values::NAN_MASK_BITS;
+
+namespace
+{
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+// counts the reads, like a loaned interface reading the hardware
+struct FakeInterface
+{
+  double value;
+  mutable size_t reads = 0;
+
+  double get_value() const
+  {
+    ++reads;
+    return value;
+  }
+};
+}  // namespace
+
+TEST(TestCopyValues, copies_valid_values_with_one_read_per_interface)
+{
+  std::vector<FakeInterface> interfaces{{1.0}, {2.0}, {3.0}};
+  std::vector<double> values(3, 0.0);
+
+  EXPECT_EQ(copy_values(interfaces, values.begin()), 0u);
+  EXPECT_THAT(values, ::testing::ElementsAre(1.0, 2.0, 3.0));
+  for (const auto & interface : interfaces)
+  {
+    EXPECT_EQ(interface.reads, 1u);
+  }
+}
+
+TEST(TestCopyValues, flags_the_nan_values)
+{
+  std::vector<FakeInterface> interfaces{{1.0}, {NaN}, {3.0}, {NaN}};
+  // as the controllers hold their interfaces
+  std::vector<std::reference_wrapper<const FakeInterface>> references(
+    interfaces.begin(), interfaces.end());
+  std::vector<double> values(4, 0.0);
+
+  const auto mask = copy_values(references, values.begin());
+  EXPECT_FALSE(is_nan(mask, 0));
+  EXPECT_TRUE(is_nan(mask, 1));
+  EXPECT_FALSE(is_nan(mask, 2));
+  EXPECT_TRUE(is_nan(mask, 3));
+  EXPECT_EQ(first_nan(mask), 1u);
+  // the NaN values are copied as well
+  EXPECT_EQ(values[2], 3.0);
+  EXPECT_TRUE(std::isnan(values[3]));
+  EXPECT_EQ(first_nan(0), NAN_MASK_BITS);
+}
+
+TEST(TestCopyValues, flags_nan_values_beyond_the_bits_of_the_mask)
+{
+  std::vector<double> input(2 * NAN_MASK_BITS, 1.0);
+  std::vector<double> values(input.size(), 0.0);
+  input.back() = NaN;
+
+  const auto mask = copy_values(input, values.begin());
+  EXPECT_NE(mask, 0u);
+  EXPECT_TRUE(is_nan(mask, input.size() - 1));
+  EXPECT_EQ(first_nan(mask), NAN_MASK_BITS - 1);
+}
+
+TEST(TestCopyValues, reads_the_values_with_a_getter)
+{
+  struct Handle
+  {
+    std::reference_wrapper<const FakeInterface> feedback;
+  };
+  const FakeInterface left{NaN};
+  const FakeInterface right{2.0};
+  std::vector<Handle> handles{{std::cref(left)}, {std::cref(right)}};
+  std::vector<double> values(2, 0.0);
+
+  const auto mask = copy_values(
+    handles.begin(), handles.end(), values.begin(),
+    [](const Handle & handle) { return handle.feedback.get().get_value(); });
+  EXPECT_EQ(first_nan(mask), 0u);
+  EXPECT_EQ(values[1], 2.0);
+}
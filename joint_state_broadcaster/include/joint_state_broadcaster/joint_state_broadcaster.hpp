@@ -15,20 +15,33 @@
 #ifndef JOINT_STATE_BROADCASTER__JOINT_STATE_BROADCASTER_HPP_
 #define JOINT_STATE_BROADCASTER__JOINT_STATE_BROADCASTER_HPP_
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "bounded_joint_state_msgs/msg/bounded_joint_state.hpp"
 #include "control_msgs/msg/dynamic_joint_state.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "joint_state_broadcaster/snapshot_ring.hpp"
 #include "joint_state_broadcaster/visibility_control.h"
 // auto-generated by generate_parameter_library
 #include "joint_state_broadcaster_parameters.hpp"
+#include "publisher_pool/loaned_publisher.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/time.hpp"
 #include "rclcpp_lifecycle/lifecycle_publisher.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
-#include "realtime_tools/realtime_publisher.h"
+#include "realtime_logging/realtime_logger.hpp"
 #include "sensor_msgs/msg/joint_state.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "update_time_statistics/cycle_budget.hpp"
+#include "update_time_statistics/update_period_statistics.hpp"
+#include "update_time_statistics/update_time_statistics.hpp"
 
 namespace joint_state_broadcaster
 {
@@ -55,6 +68,12 @@ namespace joint_state_broadcaster
  * (position, velocity, effort).
  * - \b dynamic_joint_states (control_msgs::msg::DynamicJointState): Joint states regardless of
  * its interface type.
+ * - \b joint_states_batch (trajectory_msgs::msg::JointTrajectory): Joint states of consecutive
+ * updates, one point per update, if 'joint_states_batch.enable' is set.
+ * - \b bounded_joint_states (bounded_joint_state_msgs::msg::BoundedJointState): Joint states in
+ * a message of fixed size, loaned from the middleware if possible, if
+ * 'bounded_joint_states.enable' is set. Their names are published once on
+ * \b bounded_joint_states/names (sensor_msgs::msg::JointState), transient local.
  */
 class JointStateBroadcaster : public controller_interface::ControllerInterface
 {
@@ -62,6 +81,9 @@ public:
   JOINT_STATE_BROADCASTER_PUBLIC
   JointStateBroadcaster();
 
+  JOINT_STATE_BROADCASTER_PUBLIC
+  ~JointStateBroadcaster() override;
+
   JOINT_STATE_BROADCASTER_PUBLIC
   controller_interface::InterfaceConfiguration command_interface_configuration() const override;
 
@@ -91,7 +113,60 @@ protected:
   bool init_joint_data();
   void init_joint_state_msg();
   void init_dynamic_joint_state_msg();
+  void init_joint_states_batch_msg();
+  /// Publish the names of the bounded joint states, false if there are too many joints
+  bool init_bounded_joint_state_msg();
   bool use_all_available_interfaces() const;
+  /// Resolve the values of the joints of every group, false if a joint has no state interface
+  bool init_joint_groups();
+  /// Add the velocities of 'velocity_synthesis.joints' as values after those of the interfaces
+  void init_velocity_synthesis();
+  /// Differentiate the positions of the joints with synthesized velocities
+  void update_synthesized_velocities(const rclcpp::Duration & period);
+  /// Touch the buffers and msgs used by update(), so its first cycles don't page fault
+  void prefault_rt_buffers();
+  /// Fill \p msg with \p values, which are indexed like 'interface_values_'
+  /**
+   * \param[in] value_indices Index in \p values of position, velocity and effort of every joint
+   * of \p msg, like 'joint_state_value_indices_'.
+   */
+  void fill_joint_state_msg(
+    const rclcpp::Time & time, const std::vector<double> & values,
+    const std::vector<size_t> & value_indices, sensor_msgs::msg::JointState & msg) const;
+  /// Fill \p msg with \p values, which are indexed like 'interface_values_'
+  void fill_dynamic_joint_state_msg(
+    const rclcpp::Time & time, const std::vector<double> & values,
+    control_msgs::msg::DynamicJointState & msg) const;
+  /// Check if the DynamicJointState message with \p values has to be published
+  /**
+   * Always true, unless 'dynamic_joint_states_deadband' is enabled.
+   * \param[in] published_msg The last published message, compared against for the deadband.
+   */
+  bool is_dynamic_joint_state_due(
+    const rclcpp::Time & time, const std::vector<double> & values,
+    const control_msgs::msg::DynamicJointState & published_msg) const;
+  /// Check if any of \p values moved out of its deadband compared to \p published_msg
+  bool dynamic_joint_state_changed(
+    const std::vector<double> & values,
+    const control_msgs::msg::DynamicJointState & published_msg) const;
+
+  /// Fill \p msg with \p values, which are indexed like 'interface_values_'
+  void fill_bounded_joint_state_msg(
+    const rclcpp::Time & time, const std::vector<double> & values,
+    bounded_joint_state_msgs::msg::BoundedJointState & msg) const;
+  /// Publish the bounded joint states, in a loaned message if the middleware supports it
+  void publish_bounded_joint_state(const rclcpp::Time & time);
+
+  /// Add the current values to the batch, and publish the batch if it is full
+  void add_joint_states_batch_sample(const rclcpp::Time & time);
+
+  /// Start the thread publishing the snapshots of 'snapshot_ring_'
+  void start_publisher_thread();
+  void stop_publisher_thread();
+  /// Publish a snapshot of the values from the publisher thread
+  void publish_snapshot(const SnapshotHeader & header, const std::vector<double> & values);
+  /// Index in 'interface_values_' of the value of \p interface_name of joint \p name
+  size_t get_value_index(const std::string & name, const std::string & interface_name) const;
 
 protected:
   // Optional parameters
@@ -103,16 +178,113 @@ protected:
   //  we store the name of joints with compatible interfaces
   std::vector<std::string> joint_names_;
   std::shared_ptr<rclcpp::Publisher<sensor_msgs::msg::JointState>> joint_state_publisher_;
-  std::shared_ptr<realtime_tools::RealtimePublisher<sensor_msgs::msg::JointState>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<sensor_msgs::msg::JointState>>
     realtime_joint_state_publisher_;
 
-  //  For the DynamicJointState format, we use a map to buffer values in for easier lookup
+  //  For the DynamicJointState format, every joint with its interfaces and where their values are
+  //  stored in 'interface_values_', in the order of their first state interface.
   //  This allows to preserve whatever order or names/interfaces were initialized.
-  std::unordered_map<std::string, std::unordered_map<std::string, double>> name_if_value_mapping_;
+  struct JointInterfaces
+  {
+    std::string name;
+    std::vector<std::string> interface_names;
+    std::vector<size_t> value_indices;
+  };
+  std::vector<JointInterfaces> joint_interfaces_;
+  //  Index in 'joint_interfaces_' of every joint name
+  std::unordered_map<std::string, size_t> joint_interfaces_indices_;
+
+  //  Values of all state interfaces in the order of 'state_interfaces_', copied in every update,
+  //  followed by the constant values of missing interfaces and of extra joints
+  std::vector<double> interface_values_;
+  //  Velocities computed from the positions, see 'velocity_synthesis'. They are stored in
+  //  'interface_values_' after the constant values, so all messages take them like the values of
+  //  velocity state interfaces.
+  struct SynthesizedVelocity
+  {
+    size_t position_index;
+    size_t velocity_index;
+    //  NaN until the first valid position
+    double previous_position;
+  };
+  std::vector<SynthesizedVelocity> synthesized_velocities_;
+  //  Index in 'interface_values_' of position, velocity and effort of every joint in the
+  //  JointState message, stored as [joint * 3 + field]
+  std::vector<size_t> joint_state_value_indices_;
+  //  Index in 'interface_values_' of every value in the DynamicJointState message
+  std::vector<std::vector<size_t>> dynamic_joint_state_value_indices_;
+  //  Deadband of every value in the DynamicJointState message, see 'dynamic_joint_states_deadband'
+  std::vector<std::vector<double>> dynamic_joint_state_deadbands_;
+  //  Time the DynamicJointState message was published last, valid if it was published already
+  rclcpp::Time last_dynamic_joint_state_publish_time_;
+  bool dynamic_joint_state_published_ = false;
+
+  //  Snapshots of 'interface_values_' passed from update() to the publisher thread,
+  //  used if 'publisher_thread.enable' is set
+  SnapshotRing snapshot_ring_;
+  std::thread publisher_thread_;
+  std::atomic<bool> publisher_thread_running_{false};
+  //  Snapshots not published because the queue was full
+  std::atomic<size_t> dropped_snapshots_{0};
+  //  Storage of the publisher thread
+  std::vector<double> publisher_thread_values_;
+  sensor_msgs::msg::JointState publisher_thread_joint_state_msg_;
+  control_msgs::msg::DynamicJointState publisher_thread_dynamic_joint_state_msg_;
   std::shared_ptr<rclcpp::Publisher<control_msgs::msg::DynamicJointState>>
     dynamic_joint_state_publisher_;
-  std::shared_ptr<realtime_tools::RealtimePublisher<control_msgs::msg::DynamicJointState>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<control_msgs::msg::DynamicJointState>>
     realtime_dynamic_joint_state_publisher_;
+
+  //  Groups of joints published on their own topics, see 'joint_groups'
+  struct JointGroup
+  {
+    std::string name;
+    std::vector<std::string> joint_names;
+    std::shared_ptr<rclcpp::Publisher<sensor_msgs::msg::JointState>> publisher;
+    std::shared_ptr<publisher_pool::RealtimePublisher<sensor_msgs::msg::JointState>>
+      realtime_publisher;
+    std::shared_ptr<telemetry_rate_policy::TelemetryRate> publish_rate;
+    //  If the message is published in the current update
+    bool is_due = false;
+    //  Index in 'interface_values_' of position, velocity and effort of every joint of the group,
+    //  resolved on activation and stored like 'joint_state_value_indices_'
+    std::vector<size_t> value_indices;
+  };
+  std::vector<JointGroup> joint_groups_;
+
+  //  Joint states of consecutive updates, used if 'joint_states_batch.enable' is set.
+  //  The batch is collected in 'joint_states_batch_msg_' and swapped with the message of the
+  //  realtime publisher once it is full, both have the same size.
+  std::shared_ptr<rclcpp::Publisher<trajectory_msgs::msg::JointTrajectory>>
+    joint_states_batch_publisher_;
+  std::shared_ptr<publisher_pool::RealtimePublisher<trajectory_msgs::msg::JointTrajectory>>
+    realtime_joint_states_batch_publisher_;
+  trajectory_msgs::msg::JointTrajectory joint_states_batch_msg_;
+  size_t joint_states_batch_num_samples_ = 0;
+  //  Batches not published because the previous one was still being published
+  size_t dropped_joint_states_batches_ = 0;
+
+  //  Joint states of fixed size and the names of their joints, used if
+  //  'bounded_joint_states.enable' is set
+  std::unique_ptr<
+    publisher_pool::LoanedPublisher<bounded_joint_state_msgs::msg::BoundedJointState>>
+    bounded_joint_state_publisher_;
+  std::shared_ptr<rclcpp::Publisher<sensor_msgs::msg::JointState>>
+    bounded_joint_state_names_publisher_;
+
+  //  Publish rates of both messages with the telemetry rate policy of the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> joint_state_publish_rate_;
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> dynamic_joint_state_publish_rate_;
+
+  //  Update times published on the statistics topic, used if 'update_statistics.enable' is set
+  std::unique_ptr<update_time_statistics::UpdateTimeStatistics> update_time_statistics_;
+  //  Update periods published on the period_statistics topic, if 'period_statistics.enable' is set
+  std::unique_ptr<update_time_statistics::UpdatePeriodStatistics> update_period_statistics_;
+  //  Decimates the dynamic joint states under load, used if 'cycle_budget.enable' is set
+  std::unique_ptr<update_time_statistics::CycleBudget> cycle_budget_;
+
+  //  Logger of update(), whose messages are output by a non-realtime thread
+  std::unique_ptr<realtime_logging::RealtimeLogger> rt_logger_;
 };
 
 }  // namespace joint_state_broadcaster
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_STATE_BROADCASTER__SNAPSHOT_RING_HPP_
+#define JOINT_STATE_BROADCASTER__SNAPSHOT_RING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "rclcpp/time.hpp"
+
+namespace joint_state_broadcaster
+{
+/// Which messages a snapshot has to be published in, and its time
+struct SnapshotHeader
+{
+  rclcpp::Time stamp;
+  bool publish_joint_state = false;
+  bool publish_dynamic_joint_state = false;
+};
+
+/**
+ * \brief Lock-free single-producer/single-consumer ring of snapshots of state values.
+ *
+ * All snapshots have the same number of values. The memory is allocated by resize(), pushing and
+ * popping only copy values and never block.
+ */
+class SnapshotRing
+{
+public:
+  /// Allocate \p capacity snapshots of \p num_values each, not thread-safe
+  void resize(const size_t capacity, const size_t num_values)
+  {
+    headers_.assign(capacity, SnapshotHeader());
+    values_.assign(capacity * num_values, 0.0);
+    num_values_ = num_values;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return headers_.size(); }
+
+  /// Copy a snapshot into the ring, fails if it is full
+  /**
+   * \pre \p values has the size given to resize().
+   */
+  bool push(const SnapshotHeader & header, const std::vector<double> & values)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (capacity() == 0 || head - tail_.load(std::memory_order_acquire) >= capacity())
+    {
+      return false;
+    }
+    const size_t slot = head % capacity();
+    headers_[slot] = header;
+    std::copy(
+      values.begin(), values.end(),
+      values_.begin() + static_cast<std::ptrdiff_t>(slot * num_values_));
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Copy the oldest snapshot out of the ring, fails if it is empty
+  /**
+   * \pre \p values has the size given to resize().
+   */
+  bool pop(SnapshotHeader & header, std::vector<double> & values)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    const size_t slot = tail % capacity();
+    header = headers_[slot];
+    const auto slot_values = values_.begin() + static_cast<std::ptrdiff_t>(slot * num_values_);
+    std::copy(
+      slot_values, slot_values + static_cast<std::ptrdiff_t>(num_values_), values.begin());
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::vector<SnapshotHeader> headers_;
+  /// Values of all snapshots, stored as [slot * num_values_ + index]
+  std::vector<double> values_;
+  size_t num_values_ = 0;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace joint_state_broadcaster
+
+#endif  // JOINT_STATE_BROADCASTER__SNAPSHOT_RING_HPP_
@@ -15,14 +15,22 @@
 #include "joint_state_broadcaster/joint_state_broadcaster.hpp"
 
 #include <stddef.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "controller_tracetools/tracetools.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "memory_prefault/memory_prefault.hpp"
+#include "publisher_pool/publisher_qos.hpp"
 #include "rclcpp/clock.hpp"
 #include "rclcpp/event_handler.hpp"
 #include "rclcpp/qos.hpp"
@@ -44,14 +52,35 @@ using hardware_interface::HW_IF_EFFORT;
 using hardware_interface::HW_IF_POSITION;
 using hardware_interface::HW_IF_VELOCITY;
 
+namespace
+{
+size_t prefault_joint_state(sensor_msgs::msg::JointState & msg)
+{
+  return memory_prefault::prefault(msg.name, msg.position, msg.velocity, msg.effort);
+}
+
+size_t prefault_joint_trajectory(trajectory_msgs::msg::JointTrajectory & msg)
+{
+  size_t bytes = memory_prefault::prefault(msg.joint_names, msg.points);
+  for (auto & point : msg.points)
+  {
+    bytes += memory_prefault::prefault(point.positions, point.velocities, point.effort);
+  }
+  return bytes;
+}
+}  // namespace
+
 JointStateBroadcaster::JointStateBroadcaster() {}
 
+JointStateBroadcaster::~JointStateBroadcaster() { stop_publisher_thread(); }
+
 controller_interface::CallbackReturn JointStateBroadcaster::on_init()
 {
   try
   {
     param_listener_ = std::make_shared<ParamListener>(get_node());
     params_ = param_listener_->get_params();
+    rt_logger_ = std::make_unique<realtime_logging::RealtimeLogger>(get_node()->get_logger());
   }
   catch (const std::exception & e)
   {
@@ -102,6 +131,8 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_configure(
     return controller_interface::CallbackReturn::ERROR;
   }
   params_ = param_listener_->get_params();
+  // names the handle of the tracepoints of the updates
+  CONTROLLER_TRACEPOINT(controller_init, this, get_node()->get_name());
 
   if (use_all_available_interfaces())
   {
@@ -139,6 +170,19 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_configure(
     }
   };
 
+  if (
+    params_.dynamic_joint_states_deadband.interfaces.size() !=
+    params_.dynamic_joint_states_deadband.thresholds.size())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "Size of 'dynamic_joint_states_deadband.interfaces' (%zu) and "
+      "'dynamic_joint_states_deadband.thresholds' (%zu) parameters has to be the same.",
+      params_.dynamic_joint_states_deadband.interfaces.size(),
+      params_.dynamic_joint_states_deadband.thresholds.size());
+    return CallbackReturn::ERROR;
+  }
+
   map_interface_to_joint_state_ = {};
   get_map_interface_parameter(HW_IF_POSITION, params_.map_interface_to_joint_state.position);
   get_map_interface_parameter(HW_IF_VELOCITY, params_.map_interface_to_joint_state.velocity);
@@ -147,21 +191,90 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_configure(
   try
   {
     const std::string topic_name_prefix = params_.use_local_topics ? "~/" : "";
+    const auto pool = publisher_pool::get_shared_pool(params_.publisher_pool);
+    const auto rate_policy = telemetry_rate_policy::TelemetryRatePolicy::get_instance();
 
     joint_state_publisher_ = get_node()->create_publisher<sensor_msgs::msg::JointState>(
-      topic_name_prefix + "joint_states", rclcpp::SystemDefaultsQoS());
+      topic_name_prefix + "joint_states", publisher_pool::make_qos(params_.qos.joint_states));
 
     realtime_joint_state_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<sensor_msgs::msg::JointState>>(
-        joint_state_publisher_);
+      std::make_shared<publisher_pool::RealtimePublisher<sensor_msgs::msg::JointState>>(
+        joint_state_publisher_, pool, params_.publish_unique_ptr);
 
     dynamic_joint_state_publisher_ =
       get_node()->create_publisher<control_msgs::msg::DynamicJointState>(
-        topic_name_prefix + "dynamic_joint_states", rclcpp::SystemDefaultsQoS());
+        topic_name_prefix + "dynamic_joint_states",
+        publisher_pool::make_qos(params_.qos.dynamic_joint_states));
 
     realtime_dynamic_joint_state_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<control_msgs::msg::DynamicJointState>>(
-        dynamic_joint_state_publisher_);
+      std::make_shared<publisher_pool::RealtimePublisher<control_msgs::msg::DynamicJointState>>(
+        dynamic_joint_state_publisher_, pool, params_.publish_unique_ptr);
+
+    joint_state_publish_rate_ = rate_policy->register_topic(
+      get_node()->get_namespace(), joint_state_publisher_->get_topic_name(),
+      params_.joint_states_publish_rate);
+    dynamic_joint_state_publish_rate_ = rate_policy->register_topic(
+      get_node()->get_namespace(), dynamic_joint_state_publisher_->get_topic_name(),
+      params_.dynamic_joint_states_publish_rate);
+
+    if (params_.joint_states_batch.enable)
+    {
+      joint_states_batch_publisher_ =
+        get_node()->create_publisher<trajectory_msgs::msg::JointTrajectory>(
+          topic_name_prefix + "joint_states_batch",
+          publisher_pool::make_qos(params_.qos.joint_states_batch));
+
+      realtime_joint_states_batch_publisher_ = std::make_shared<
+        publisher_pool::RealtimePublisher<trajectory_msgs::msg::JointTrajectory>>(
+        joint_states_batch_publisher_, pool, params_.publish_unique_ptr);
+    }
+
+    bounded_joint_state_publisher_.reset();
+    bounded_joint_state_names_publisher_.reset();
+    if (params_.bounded_joint_states.enable)
+    {
+      using bounded_joint_state_msgs::msg::BoundedJointState;
+      // without loans, a copy is published outside of the update like the other messages
+      bounded_joint_state_publisher_ =
+        std::make_unique<publisher_pool::LoanedPublisher<BoundedJointState>>(
+          get_node()->create_publisher<BoundedJointState>(
+            topic_name_prefix + "bounded_joint_states",
+            publisher_pool::make_qos(params_.qos.joint_states)),
+          pool, params_.publish_unique_ptr);
+      // late subscribers still get the names, which are published once per activation
+      bounded_joint_state_names_publisher_ =
+        get_node()->create_publisher<sensor_msgs::msg::JointState>(
+          topic_name_prefix + "bounded_joint_states/names",
+          rclcpp::QoS(1).reliable().transient_local());
+      RCLCPP_INFO(
+        get_node()->get_logger(), "The middleware %s loan the bounded joint states.",
+        bounded_joint_state_publisher_->is_loaning() ? "does" : "doesn't");
+    }
+
+    joint_groups_.clear();
+    for (const auto & group_name : params_.joint_groups)
+    {
+      const auto & group_params = params_.groups.joint_groups_map.at(group_name);
+      if (group_params.joints.empty())
+      {
+        RCLCPP_ERROR(
+          get_node()->get_logger(), "Joint group '%s' has no joints.", group_name.c_str());
+        return CallbackReturn::ERROR;
+      }
+      JointGroup group;
+      group.name = group_name;
+      group.joint_names = group_params.joints;
+      // the same QoS as all joint states, a group is a part of them
+      group.publisher = get_node()->create_publisher<sensor_msgs::msg::JointState>(
+        topic_name_prefix + group_name + "/joint_states",
+        publisher_pool::make_qos(params_.qos.joint_states));
+      group.publish_rate = rate_policy->register_topic(
+        get_node()->get_namespace(), group.publisher->get_topic_name(), group_params.publish_rate);
+      group.realtime_publisher =
+        std::make_shared<publisher_pool::RealtimePublisher<sensor_msgs::msg::JointState>>(
+          group.publisher, pool, params_.publish_unique_ptr);
+      joint_groups_.push_back(std::move(group));
+    }
   }
   catch (const std::exception & e)
   {
@@ -169,6 +282,44 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_configure(
     fprintf(stderr, "Exception thrown during init stage with message: %s \n", e.what());
     return CallbackReturn::ERROR;
   }
+
+  update_time_statistics_.reset();
+  if (params_.update_statistics.enable)
+  {
+    update_time_statistics_ = std::make_unique<update_time_statistics::UpdateTimeStatistics>();
+    if (!update_time_statistics_->configure(
+          get_node(), "~/statistics", static_cast<size_t>(params_.update_statistics.window_size)))
+    {
+      return CallbackReturn::ERROR;
+    }
+  }
+
+  update_period_statistics_.reset();
+  if (params_.period_statistics.enable)
+  {
+    const double update_rate = params_.period_statistics.update_rate > 0.0
+                                 ? params_.period_statistics.update_rate
+                                 : static_cast<double>(get_update_rate());
+    if (update_rate <= 0.0)
+    {
+      RCLCPP_WARN(
+        get_node()->get_logger(),
+        "Neither 'period_statistics.update_rate' nor 'update_rate' is set, overruns and missed "
+        "cycles are not counted.");
+    }
+    const int64_t nominal_period_ns =
+      update_rate > 0.0 ? rclcpp::Duration::from_seconds(1.0 / update_rate).nanoseconds() : 0;
+    update_period_statistics_ = std::make_unique<update_time_statistics::UpdatePeriodStatistics>();
+    if (!update_period_statistics_->configure(
+          get_node(), "~/period_statistics",
+          static_cast<size_t>(params_.period_statistics.window_size), nominal_period_ns,
+          params_.period_statistics.overrun_ratio))
+    {
+      return CallbackReturn::ERROR;
+    }
+  }
+  cycle_budget_ = update_time_statistics::make_cycle_budget(
+    params_.cycle_budget, static_cast<double>(get_update_rate()));
   return CallbackReturn::SUCCESS;
 }
 
@@ -184,6 +335,21 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_activate(
 
   init_joint_state_msg();
   init_dynamic_joint_state_msg();
+  init_joint_states_batch_msg();
+  if (!init_bounded_joint_state_msg())
+  {
+    return CallbackReturn::ERROR;
+  }
+  if (!init_joint_groups())
+  {
+    return CallbackReturn::ERROR;
+  }
+  prefault_rt_buffers();
+
+  // both messages are published in the first update
+  joint_state_publish_rate_->reset();
+  dynamic_joint_state_publish_rate_->reset();
+  dynamic_joint_state_published_ = false;
 
   if (
     !use_all_available_interfaces() &&
@@ -195,90 +361,200 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_activate(
       "Check ControllerManager output for more detailed information.");
   }
 
+  if (params_.publisher_thread.enable)
+  {
+    start_publisher_thread();
+  }
+  if (update_time_statistics_)
+  {
+    update_time_statistics_->reset();
+  }
+  if (update_period_statistics_)
+  {
+    update_period_statistics_->reset();
+  }
+  if (cycle_budget_)
+  {
+    cycle_budget_->reset();
+  }
+
   return CallbackReturn::SUCCESS;
 }
 
 controller_interface::CallbackReturn JointStateBroadcaster::on_deactivate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
+  stop_publisher_thread();
   joint_names_.clear();
 
   return CallbackReturn::SUCCESS;
 }
 
-template <typename T>
-bool has_any_key(
-  const std::unordered_map<std::string, T> & map, const std::vector<std::string> & keys)
-{
-  bool found_key = false;
-  for (const auto & key_item : map)
-  {
-    const auto & key = key_item.first;
-    if (std::find(keys.cbegin(), keys.cend(), key) != keys.cend())
-    {
-      found_key = true;
-      break;
-    }
-  }
-  return found_key;
-}
-
 bool JointStateBroadcaster::init_joint_data()
 {
   joint_names_.clear();
+  joint_interfaces_.clear();
+  joint_interfaces_indices_.clear();
   if (state_interfaces_.empty())
   {
     return false;
   }
 
-  // loop in reverse order, this maintains the order of values at retrieval time
-  for (auto si = state_interfaces_.crbegin(); si != state_interfaces_.crend(); si++)
+  // the values of the state interfaces are followed by the constant values
+  const size_t uninitialized_value_index = state_interfaces_.size();
+  const size_t zero_value_index = uninitialized_value_index + 1;
+  interface_values_.assign(state_interfaces_.size(), kUninitializedValue);
+  interface_values_.push_back(kUninitializedValue);
+  interface_values_.push_back(0.0);
+
+  // sized for the worst case of one joint per interface, so a large robot rehashes at most once
+  rclcpp::Parameter extra_joints;
+  const bool has_extra_joints = get_node()->get_parameter("extra_joints", extra_joints);
+  const size_t max_num_joints =
+    state_interfaces_.size() + (has_extra_joints ? extra_joints.as_string_array().size() : 0);
+  joint_interfaces_.reserve(max_num_joints);
+  joint_interfaces_indices_.reserve(max_num_joints);
+  // if the joint has at least one of the joint_states fields, the others are ignored there
+  std::vector<bool> has_joint_state_interface;
+  has_joint_state_interface.reserve(max_num_joints);
+
+  // one pass in the order of the state interfaces, which is the order of the values at retrieval
+  for (size_t index = 0; index < state_interfaces_.size(); ++index)
   {
-    // initialize map if name is new
-    if (name_if_value_mapping_.count(si->get_prefix_name()) == 0)
+    const auto & si = state_interfaces_[index];
+    const auto joint_and_index =
+      joint_interfaces_indices_.try_emplace(si.get_prefix_name(), joint_interfaces_.size());
+    if (joint_and_index.second)
     {
-      name_if_value_mapping_[si->get_prefix_name()] = {};
+      joint_interfaces_.push_back({si.get_prefix_name(), {}, {}});
+      has_joint_state_interface.push_back(false);
     }
-    // add interface name
-    std::string interface_name = si->get_interface_name();
-    if (map_interface_to_joint_state_.count(interface_name) > 0)
+    auto & joint = joint_interfaces_[joint_and_index.first->second];
+
+    const auto mapped_name = map_interface_to_joint_state_.find(si.get_interface_name());
+    const auto & interface_name = mapped_name != map_interface_to_joint_state_.end()
+                                    ? mapped_name->second
+                                    : si.get_interface_name();
+    // a joint has a few interfaces, searching them is faster than a map per joint
+    const auto existing =
+      std::find(joint.interface_names.begin(), joint.interface_names.end(), interface_name);
+    if (existing != joint.interface_names.end())
     {
-      interface_name = map_interface_to_joint_state_[interface_name];
+      // if several interfaces are mapped to the same name, the last one is published
+      joint.value_indices[static_cast<size_t>(existing - joint.interface_names.begin())] = index;
+      continue;
+    }
+    joint.interface_names.push_back(interface_name);
+    joint.value_indices.push_back(index);
+    if (
+      interface_name == HW_IF_POSITION || interface_name == HW_IF_VELOCITY ||
+      interface_name == HW_IF_EFFORT)
+    {
+      has_joint_state_interface[joint_and_index.first->second] = true;
     }
-    name_if_value_mapping_[si->get_prefix_name()][interface_name] = kUninitializedValue;
   }
 
   // filter state interfaces that have at least one of the joint_states fields,
   // the rest will be ignored for this message
-  for (const auto & name_ifv : name_if_value_mapping_)
+  joint_names_.reserve(max_num_joints);
+  for (size_t i = 0; i < joint_interfaces_.size(); ++i)
   {
-    const auto & interfaces_and_values = name_ifv.second;
-    if (has_any_key(interfaces_and_values, {HW_IF_POSITION, HW_IF_VELOCITY, HW_IF_EFFORT}))
+    if (has_joint_state_interface[i])
     {
-      joint_names_.push_back(name_ifv.first);
+      joint_names_.push_back(joint_interfaces_[i].name);
     }
   }
 
   // Add extra joints from parameters, each joint will be added to joint_names_ and
-  // name_if_value_mapping_ if it is not already there
-  rclcpp::Parameter extra_joints;
-  if (get_node()->get_parameter("extra_joints", extra_joints))
+  // joint_interfaces_ if it is not already there
+  if (has_extra_joints)
   {
-    const std::vector<std::string> & extra_joints_names = extra_joints.as_string_array();
-    for (const auto & extra_joint_name : extra_joints_names)
+    for (const auto & extra_joint_name : extra_joints.as_string_array())
     {
-      if (name_if_value_mapping_.count(extra_joint_name) == 0)
+      if (joint_interfaces_indices_.try_emplace(extra_joint_name, joint_interfaces_.size()).second)
       {
-        name_if_value_mapping_[extra_joint_name] = {
-          {HW_IF_POSITION, 0.0}, {HW_IF_VELOCITY, 0.0}, {HW_IF_EFFORT, 0.0}};
+        joint_interfaces_.push_back(
+          {extra_joint_name,
+           {HW_IF_POSITION, HW_IF_VELOCITY, HW_IF_EFFORT},
+           {zero_value_index, zero_value_index, zero_value_index}});
         joint_names_.push_back(extra_joint_name);
       }
     }
   }
 
+  init_velocity_synthesis();
   return true;
 }
 
+void JointStateBroadcaster::init_velocity_synthesis()
+{
+  synthesized_velocities_.clear();
+  synthesized_velocities_.reserve(params_.velocity_synthesis.joints.size());
+  for (const auto & joint_name : params_.velocity_synthesis.joints)
+  {
+    const auto joint_index = joint_interfaces_indices_.find(joint_name);
+    if (joint_index == joint_interfaces_indices_.end())
+    {
+      RCLCPP_WARN(
+        get_node()->get_logger(),
+        "Joint '%s' of 'velocity_synthesis.joints' has no state interfaces, its velocity is not "
+        "computed.",
+        joint_name.c_str());
+      continue;
+    }
+    auto & joint = joint_interfaces_[joint_index->second];
+    const auto & names = joint.interface_names;
+    const auto position = std::find(names.begin(), names.end(), HW_IF_POSITION);
+    if (
+      position == names.end() ||
+      std::find(names.begin(), names.end(), HW_IF_VELOCITY) != names.end())
+    {
+      RCLCPP_WARN(
+        get_node()->get_logger(),
+        "Joint '%s' of 'velocity_synthesis.joints' needs a position and no velocity state "
+        "interface, its velocity is not computed.",
+        joint_name.c_str());
+      continue;
+    }
+    const size_t position_index =
+      joint.value_indices[static_cast<size_t>(position - names.begin())];
+    // published like a velocity state interface of the joint
+    joint.interface_names.push_back(HW_IF_VELOCITY);
+    joint.value_indices.push_back(interface_values_.size());
+    synthesized_velocities_.push_back(
+      {position_index, interface_values_.size(), kUninitializedValue});
+    interface_values_.push_back(kUninitializedValue);
+  }
+}
+
+void JointStateBroadcaster::update_synthesized_velocities(const rclcpp::Duration & period)
+{
+  const double dt = period.seconds();
+  const double cutoff_frequency = params_.velocity_synthesis.cutoff_frequency;
+  // discretized first-order low-pass filter, the raw finite difference without a cutoff
+  const double smoothing =
+    cutoff_frequency > 0.0 ? dt / (dt + 1.0 / (2.0 * M_PI * cutoff_frequency)) : 1.0;
+  for (auto & synthesized : synthesized_velocities_)
+  {
+    const double position = interface_values_[synthesized.position_index];
+    double & velocity = interface_values_[synthesized.velocity_index];
+    if (!std::isfinite(position))
+    {
+      // start over with the next valid position
+      velocity = kUninitializedValue;
+      synthesized.previous_position = kUninitializedValue;
+      continue;
+    }
+    if (std::isfinite(synthesized.previous_position) && dt > 0.0)
+    {
+      const double difference = (position - synthesized.previous_position) / dt;
+      velocity = std::isfinite(velocity) ? velocity + smoothing * (difference - velocity)
+                                         : difference;
+    }
+    synthesized.previous_position = position;
+  }
+}
+
 void JointStateBroadcaster::init_joint_state_msg()
 {
   const size_t num_joints = joint_names_.size();
@@ -292,23 +568,132 @@ void JointStateBroadcaster::init_joint_state_msg()
   joint_state_msg.position.resize(num_joints, kUninitializedValue);
   joint_state_msg.velocity.resize(num_joints, kUninitializedValue);
   joint_state_msg.effort.resize(num_joints, kUninitializedValue);
+
+  // resolve where the values are taken from in update()
+  joint_state_value_indices_.clear();
+  joint_state_value_indices_.reserve(3 * num_joints);
+  for (const auto & joint_name : joint_names_)
+  {
+    for (const auto & interface_name : {HW_IF_POSITION, HW_IF_VELOCITY, HW_IF_EFFORT})
+    {
+      joint_state_value_indices_.push_back(get_value_index(joint_name, interface_name));
+    }
+  }
+}
+
+bool JointStateBroadcaster::init_joint_groups()
+{
+  for (auto & group : joint_groups_)
+  {
+    auto & msg = group.realtime_publisher->msg_;
+    msg.name = group.joint_names;
+    msg.position.assign(group.joint_names.size(), kUninitializedValue);
+    msg.velocity.assign(group.joint_names.size(), kUninitializedValue);
+    msg.effort.assign(group.joint_names.size(), kUninitializedValue);
+
+    group.value_indices.clear();
+    group.value_indices.reserve(3 * group.joint_names.size());
+    for (const auto & joint_name : group.joint_names)
+    {
+      if (joint_interfaces_indices_.count(joint_name) == 0)
+      {
+        RCLCPP_ERROR(
+          get_node()->get_logger(), "Joint '%s' of joint group '%s' has no state interfaces.",
+          joint_name.c_str(), group.name.c_str());
+        return false;
+      }
+      for (const auto & interface_name : {HW_IF_POSITION, HW_IF_VELOCITY, HW_IF_EFFORT})
+      {
+        group.value_indices.push_back(get_value_index(joint_name, interface_name));
+      }
+    }
+    // published in the first update like the other messages
+    group.publish_rate->reset();
+  }
+  return true;
+}
+
+void JointStateBroadcaster::init_joint_states_batch_msg()
+{
+  joint_states_batch_num_samples_ = 0;
+  dropped_joint_states_batches_ = 0;
+  if (!realtime_joint_states_batch_publisher_)
+  {
+    return;
+  }
+
+  const size_t num_joints = joint_names_.size();
+  trajectory_msgs::msg::JointTrajectoryPoint point;
+  point.positions.resize(num_joints, kUninitializedValue);
+  point.velocities.resize(num_joints, kUninitializedValue);
+  point.effort.resize(num_joints, kUninitializedValue);
+
+  joint_states_batch_msg_.joint_names = joint_names_;
+  joint_states_batch_msg_.points.assign(
+    static_cast<size_t>(params_.joint_states_batch.size), point);
+  // both are swapped when a batch is published, so they have to have the same size
+  realtime_joint_states_batch_publisher_->msg_ = joint_states_batch_msg_;
+}
+
+bool JointStateBroadcaster::init_bounded_joint_state_msg()
+{
+  using bounded_joint_state_msgs::msg::BoundedJointState;
+  if (!bounded_joint_state_publisher_)
+  {
+    return true;
+  }
+  if (joint_names_.size() > BoundedJointState::MAX_JOINTS)
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "The bounded joint states hold at most %u joints, but there are %zu joints.",
+      BoundedJointState::MAX_JOINTS, joint_names_.size());
+    return false;
+  }
+
+  // the names are only sent once, instead of with every message
+  sensor_msgs::msg::JointState names_msg;
+  names_msg.header.stamp = get_node()->now();
+  names_msg.name = joint_names_;
+  bounded_joint_state_names_publisher_->publish(names_msg);
+  return true;
 }
 
 void JointStateBroadcaster::init_dynamic_joint_state_msg()
 {
   auto & dynamic_joint_state_msg = realtime_dynamic_joint_state_publisher_->msg_;
-  for (const auto & name_ifv : name_if_value_mapping_)
+  dynamic_joint_state_msg.joint_names.clear();
+  dynamic_joint_state_msg.interface_values.clear();
+  dynamic_joint_state_value_indices_.clear();
+  dynamic_joint_state_deadbands_.clear();
+  const auto & deadband_params = params_.dynamic_joint_states_deadband;
+  auto get_deadband = [&deadband_params](const std::string & interface_name)
   {
-    const auto & name = name_ifv.first;
-    const auto & interfaces_and_values = name_ifv.second;
-    dynamic_joint_state_msg.joint_names.push_back(name);
+    const auto & interfaces = deadband_params.interfaces;
+    const auto it = std::find(interfaces.begin(), interfaces.end(), interface_name);
+    return it != interfaces.end()
+             ? deadband_params.thresholds[static_cast<size_t>(it - interfaces.begin())]
+             : deadband_params.default_threshold;
+  };
+  dynamic_joint_state_msg.joint_names.reserve(joint_interfaces_.size());
+  dynamic_joint_state_msg.interface_values.reserve(joint_interfaces_.size());
+  dynamic_joint_state_value_indices_.reserve(joint_interfaces_.size());
+  dynamic_joint_state_deadbands_.reserve(joint_interfaces_.size());
+  for (const auto & joint : joint_interfaces_)
+  {
+    dynamic_joint_state_msg.joint_names.push_back(joint.name);
     control_msgs::msg::InterfaceValue if_value;
-    for (const auto & interface_and_value : interfaces_and_values)
+    if_value.interface_names = joint.interface_names;
+    if_value.values.assign(joint.interface_names.size(), kUninitializedValue);
+    std::vector<double> deadbands;
+    deadbands.reserve(joint.interface_names.size());
+    for (const auto & interface_name : joint.interface_names)
     {
-      if_value.interface_names.emplace_back(interface_and_value.first);
-      if_value.values.emplace_back(kUninitializedValue);
+      deadbands.push_back(get_deadband(interface_name));
     }
-    dynamic_joint_state_msg.interface_values.emplace_back(if_value);
+    dynamic_joint_state_msg.interface_values.push_back(std::move(if_value));
+    dynamic_joint_state_value_indices_.push_back(joint.value_indices);
+    dynamic_joint_state_deadbands_.push_back(std::move(deadbands));
   }
 }
 
@@ -317,78 +702,385 @@ bool JointStateBroadcaster::use_all_available_interfaces() const
   return params_.joints.empty() || params_.interfaces.empty();
 }
 
-double get_value(
-  const std::unordered_map<std::string, std::unordered_map<std::string, double>> & map,
-  const std::string & name, const std::string & interface_name)
+void JointStateBroadcaster::fill_joint_state_msg(
+  const rclcpp::Time & time, const std::vector<double> & values,
+  const std::vector<size_t> & value_indices, sensor_msgs::msg::JointState & msg) const
+{
+  msg.header.stamp = time;
+  for (size_t i = 0; i < msg.name.size(); ++i)
+  {
+    msg.position[i] = values[value_indices[3 * i]];
+    msg.velocity[i] = values[value_indices[3 * i + 1]];
+    msg.effort[i] = values[value_indices[3 * i + 2]];
+  }
+}
+
+void JointStateBroadcaster::fill_bounded_joint_state_msg(
+  const rclcpp::Time & time, const std::vector<double> & values,
+  bounded_joint_state_msgs::msg::BoundedJointState & msg) const
+{
+  msg.stamp = time;
+  msg.size = static_cast<uint32_t>(joint_names_.size());
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    msg.position[i] = values[joint_state_value_indices_[3 * i]];
+    msg.velocity[i] = values[joint_state_value_indices_[3 * i + 1]];
+    msg.effort[i] = values[joint_state_value_indices_[3 * i + 2]];
+  }
+}
+
+void JointStateBroadcaster::fill_dynamic_joint_state_msg(
+  const rclcpp::Time & time, const std::vector<double> & values,
+  control_msgs::msg::DynamicJointState & msg) const
+{
+  msg.header.stamp = time;
+  for (size_t joint_index = 0; joint_index < dynamic_joint_state_value_indices_.size();
+       ++joint_index)
+  {
+    const auto & value_indices = dynamic_joint_state_value_indices_[joint_index];
+    auto & msg_values = msg.interface_values[joint_index].values;
+    for (size_t interface_index = 0; interface_index < value_indices.size(); ++interface_index)
+    {
+      msg_values[interface_index] = values[value_indices[interface_index]];
+    }
+  }
+}
+
+bool JointStateBroadcaster::is_dynamic_joint_state_due(
+  const rclcpp::Time & time, const std::vector<double> & values,
+  const control_msgs::msg::DynamicJointState & published_msg) const
+{
+  const auto & deadband_params = params_.dynamic_joint_states_deadband;
+  const bool keepalive_elapsed =
+    !dynamic_joint_state_published_ ||
+    (deadband_params.keepalive_period > 0.0 &&
+     (time - last_dynamic_joint_state_publish_time_).seconds() >=
+       deadband_params.keepalive_period);
+  return !deadband_params.enable || keepalive_elapsed ||
+         dynamic_joint_state_changed(values, published_msg);
+}
+
+bool JointStateBroadcaster::dynamic_joint_state_changed(
+  const std::vector<double> & values,
+  const control_msgs::msg::DynamicJointState & published_msg) const
+{
+  for (size_t joint_index = 0; joint_index < dynamic_joint_state_value_indices_.size();
+       ++joint_index)
+  {
+    const auto & value_indices = dynamic_joint_state_value_indices_[joint_index];
+    const auto & deadbands = dynamic_joint_state_deadbands_[joint_index];
+    const auto & published_values = published_msg.interface_values[joint_index].values;
+    for (size_t interface_index = 0; interface_index < value_indices.size(); ++interface_index)
+    {
+      const double value = values[value_indices[interface_index]];
+      const double published_value = published_values[interface_index];
+      if (
+        std::isnan(value) != std::isnan(published_value) ||
+        std::abs(value - published_value) > deadbands[interface_index])
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void JointStateBroadcaster::prefault_rt_buffers()
+{
+  size_t bytes = memory_prefault::prefault(
+    interface_values_, joint_state_value_indices_, dynamic_joint_state_value_indices_,
+    dynamic_joint_state_deadbands_);
+  bytes += prefault_joint_state(realtime_joint_state_publisher_->msg_);
+
+  auto & dynamic_joint_state_msg = realtime_dynamic_joint_state_publisher_->msg_;
+  bytes += memory_prefault::prefault(
+    dynamic_joint_state_msg.joint_names, dynamic_joint_state_msg.interface_values);
+  for (auto & interface_value : dynamic_joint_state_msg.interface_values)
+  {
+    bytes += memory_prefault::prefault(interface_value.interface_names, interface_value.values);
+  }
+
+  for (auto & group : joint_groups_)
+  {
+    bytes += memory_prefault::prefault(group.value_indices) +
+             prefault_joint_state(group.realtime_publisher->msg_);
+  }
+  if (realtime_joint_states_batch_publisher_)
+  {
+    bytes += prefault_joint_trajectory(joint_states_batch_msg_) +
+             prefault_joint_trajectory(realtime_joint_states_batch_publisher_->msg_);
+  }
+  RCLCPP_DEBUG(get_node()->get_logger(), "Prefaulted %zu bytes of the update.", bytes);
+}
+
+void JointStateBroadcaster::start_publisher_thread()
+{
+  stop_publisher_thread();
+  snapshot_ring_.resize(
+    static_cast<size_t>(params_.publisher_thread.queue_size), interface_values_.size());
+  dropped_snapshots_ = 0;
+  publisher_thread_values_ = interface_values_;
+  // the initialized messages of the realtime publishers are the templates
+  publisher_thread_joint_state_msg_ = realtime_joint_state_publisher_->msg_;
+  publisher_thread_dynamic_joint_state_msg_ = realtime_dynamic_joint_state_publisher_->msg_;
+
+  publisher_thread_running_ = true;
+  publisher_thread_ = std::thread(
+    [this]()
+    {
+      SnapshotHeader header;
+      size_t reported_dropped_snapshots = 0;
+      while (publisher_thread_running_)
+      {
+        while (snapshot_ring_.pop(header, publisher_thread_values_))
+        {
+          publish_snapshot(header, publisher_thread_values_);
+        }
+        const size_t dropped_snapshots = dropped_snapshots_;
+        if (dropped_snapshots != reported_dropped_snapshots)
+        {
+          RCLCPP_WARN(
+            get_node()->get_logger(),
+            "Publisher thread queue was full, %zu snapshots were dropped so far.",
+            dropped_snapshots);
+          reported_dropped_snapshots = dropped_snapshots;
+        }
+        // the realtime loop never wakes this thread, so it polls the queue
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+}
+
+void JointStateBroadcaster::stop_publisher_thread()
+{
+  publisher_thread_running_ = false;
+  if (publisher_thread_.joinable())
+  {
+    publisher_thread_.join();
+  }
+}
+
+namespace
+{
+/// Publish \p message, copied into a std::unique_ptr for intra-process subscribers if requested
+template <typename MessageT>
+void publish_message(
+  rclcpp::Publisher<MessageT> & publisher, const MessageT & message, const bool as_unique_ptr)
+{
+  if (as_unique_ptr)
+  {
+    publisher.publish(std::make_unique<MessageT>(message));
+  }
+  else
+  {
+    publisher.publish(message);
+  }
+}
+}  // namespace
+
+void JointStateBroadcaster::publish_snapshot(
+  const SnapshotHeader & header, const std::vector<double> & values)
+{
+  if (header.publish_joint_state)
+  {
+    fill_joint_state_msg(
+      header.stamp, values, joint_state_value_indices_, publisher_thread_joint_state_msg_);
+    publish_message(
+      *joint_state_publisher_, publisher_thread_joint_state_msg_, params_.publish_unique_ptr);
+  }
+  if (
+    header.publish_dynamic_joint_state &&
+    is_dynamic_joint_state_due(header.stamp, values, publisher_thread_dynamic_joint_state_msg_))
+  {
+    fill_dynamic_joint_state_msg(header.stamp, values, publisher_thread_dynamic_joint_state_msg_);
+    publish_message(
+      *dynamic_joint_state_publisher_, publisher_thread_dynamic_joint_state_msg_,
+      params_.publish_unique_ptr);
+    last_dynamic_joint_state_publish_time_ = header.stamp;
+    dynamic_joint_state_published_ = true;
+  }
+}
+
+void JointStateBroadcaster::publish_bounded_joint_state(const rclcpp::Time & time)
+{
+  // a loaned message is written into the memory of the middleware, neither allocated nor copied
+  if (!bounded_joint_state_publisher_->publish(
+        [this, &time](bounded_joint_state_msgs::msg::BoundedJointState & msg)
+        { fill_bounded_joint_state_msg(time, interface_values_, msg); }))
+  {
+    // e.g., all loans of the shared memory transport are taken by slow subscribers
+    rt_logger_->warn("Couldn't loan a message for the bounded joint states.");
+  }
+}
+
+void JointStateBroadcaster::add_joint_states_batch_sample(const rclcpp::Time & time)
 {
-  const auto & interfaces_and_values = map.at(name);
-  const auto interface_and_value = interfaces_and_values.find(interface_name);
-  if (interface_and_value != interfaces_and_values.cend())
+  if (joint_states_batch_num_samples_ == 0)
   {
-    return interface_and_value->second;
+    joint_states_batch_msg_.header.stamp = time;
+  }
+  auto & point = joint_states_batch_msg_.points[joint_states_batch_num_samples_];
+  const rclcpp::Time batch_start_time(
+    joint_states_batch_msg_.header.stamp, time.get_clock_type());
+  point.time_from_start = time - batch_start_time;
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    point.positions[i] = interface_values_[joint_state_value_indices_[3 * i]];
+    point.velocities[i] = interface_values_[joint_state_value_indices_[3 * i + 1]];
+    point.effort[i] = interface_values_[joint_state_value_indices_[3 * i + 2]];
+  }
+
+  if (++joint_states_batch_num_samples_ < joint_states_batch_msg_.points.size())
+  {
+    return;
+  }
+  joint_states_batch_num_samples_ = 0;
+  if (realtime_joint_states_batch_publisher_->trylock())
+  {
+    // no copy, the previously published message is reused for the next batch
+    std::swap(realtime_joint_states_batch_publisher_->msg_, joint_states_batch_msg_);
+    realtime_joint_states_batch_publisher_->unlockAndPublish();
+  }
+  else
+  {
+    ++dropped_joint_states_batches_;
+  }
+}
+
+size_t JointStateBroadcaster::get_value_index(
+  const std::string & name, const std::string & interface_name) const
+{
+  const auto & joint = joint_interfaces_[joint_interfaces_indices_.at(name)];
+  const auto interface = std::find(
+    joint.interface_names.cbegin(), joint.interface_names.cend(), interface_name);
+  if (interface != joint.interface_names.cend())
+  {
+    return joint.value_indices[static_cast<size_t>(interface - joint.interface_names.cbegin())];
   }
   else
   {
-    return kUninitializedValue;
+    // the value following the state interfaces is always uninitialized
+    return state_interfaces_.size();
   }
 }
 
 controller_interface::return_type JointStateBroadcaster::update(
-  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  for (const auto & state_interface : state_interfaces_)
+  update_time_statistics::ScopedUpdateTimer update_timer(update_time_statistics_.get(), time);
+  if (update_period_statistics_)
   {
-    std::string interface_name = state_interface.get_interface_name();
-    if (map_interface_to_joint_state_.count(interface_name) > 0)
+    update_period_statistics_->add_period(time, period);
+  }
+  update_time_statistics::ScopedCycleBudget cycle_budget_scope(
+    cycle_budget_.get(), period.nanoseconds());
+  const bool publish_joint_state = joint_state_publish_rate_->is_due(time);
+  // the joint states feed the TF of the robot, the dynamic joint states are delayed under load
+  const bool publish_dynamic_joint_state =
+    update_time_statistics::allows_optional_work(cycle_budget_.get()) &&
+    dynamic_joint_state_publish_rate_->is_due(time);
+  const bool sample_joint_states_batch = realtime_joint_states_batch_publisher_ != nullptr;
+  bool publish_joint_groups = false;
+  for (auto & group : joint_groups_)
+  {
+    group.is_due = group.publish_rate->is_due(time);
+    publish_joint_groups = publish_joint_groups || group.is_due;
+  }
+  // the positions are differentiated in every update
+  const bool synthesize_velocities = !synthesized_velocities_.empty();
+  if (
+    !publish_joint_state && !publish_dynamic_joint_state && !sample_joint_states_batch &&
+    !publish_joint_groups && !synthesize_velocities)
+  {
+    return controller_interface::return_type::OK;
+  }
+
+  CONTROLLER_TRACEPOINT(stage_begin, this, "copy");
+  // the names of the interfaces are only built if they are logged
+  const bool log_values = rt_logger_->is_enabled_for(realtime_logging::Severity::DEBUG);
+  for (size_t index = 0; index < state_interfaces_.size(); ++index)
+  {
+    const auto & state_interface = state_interfaces_[index];
+    interface_values_[index] = state_interface.get_value();
+    if (log_values)
     {
-      interface_name = map_interface_to_joint_state_[interface_name];
+      rt_logger_->debug("%s: %f", state_interface.get_name().c_str(), interface_values_[index]);
     }
-    name_if_value_mapping_[state_interface.get_prefix_name()][interface_name] =
-      state_interface.get_value();
-    RCLCPP_DEBUG(
-      get_node()->get_logger(), "%s: %f\n", state_interface.get_name().c_str(),
-      state_interface.get_value());
   }
-
-  if (realtime_joint_state_publisher_ && realtime_joint_state_publisher_->trylock())
+  if (synthesize_velocities)
   {
-    auto & joint_state_msg = realtime_joint_state_publisher_->msg_;
+    update_synthesized_velocities(period);
+  }
+  CONTROLLER_TRACEPOINT(stage_end, this, "copy");
 
-    joint_state_msg.header.stamp = time;
+  if (sample_joint_states_batch)
+  {
+    add_joint_states_batch_sample(time);
+  }
+  if (publish_joint_groups)
+  {
+    // also with the publisher thread, the messages of the groups are filled here
+    for (auto & group : joint_groups_)
+    {
+      if (group.is_due && group.realtime_publisher->trylock())
+      {
+        fill_joint_state_msg(
+          time, interface_values_, group.value_indices, group.realtime_publisher->msg_);
+        group.realtime_publisher->unlockAndPublish();
+      }
+    }
+  }
+  // also with the publisher thread, a loaned message is filled in place by the update
+  if (publish_joint_state && bounded_joint_state_publisher_)
+  {
+    publish_bounded_joint_state(time);
+  }
+  if (!publish_joint_state && !publish_dynamic_joint_state)
+  {
+    return controller_interface::return_type::OK;
+  }
 
-    // update joint state message and dynamic joint state message
-    for (size_t i = 0; i < joint_names_.size(); ++i)
+  CONTROLLER_TRACEPOINT(stage_begin, this, "publish");
+  if (publisher_thread_running_)
+  {
+    // the messages are filled and published by the publisher thread
+    if (!snapshot_ring_.push(
+          {time, publish_joint_state, publish_dynamic_joint_state}, interface_values_))
     {
-      joint_state_msg.position[i] =
-        get_value(name_if_value_mapping_, joint_names_[i], HW_IF_POSITION);
-      joint_state_msg.velocity[i] =
-        get_value(name_if_value_mapping_, joint_names_[i], HW_IF_VELOCITY);
-      joint_state_msg.effort[i] = get_value(name_if_value_mapping_, joint_names_[i], HW_IF_EFFORT);
+      ++dropped_snapshots_;
     }
+    CONTROLLER_TRACEPOINT(stage_end, this, "publish");
+    return controller_interface::return_type::OK;
+  }
+
+  if (
+    publish_joint_state && realtime_joint_state_publisher_ &&
+    realtime_joint_state_publisher_->trylock())
+  {
+    fill_joint_state_msg(
+      time, interface_values_, joint_state_value_indices_, realtime_joint_state_publisher_->msg_);
     realtime_joint_state_publisher_->unlockAndPublish();
   }
 
-  if (realtime_dynamic_joint_state_publisher_ && realtime_dynamic_joint_state_publisher_->trylock())
+  if (
+    publish_dynamic_joint_state && realtime_dynamic_joint_state_publisher_ &&
+    realtime_dynamic_joint_state_publisher_->trylock())
   {
     auto & dynamic_joint_state_msg = realtime_dynamic_joint_state_publisher_->msg_;
-    dynamic_joint_state_msg.header.stamp = time;
-    for (size_t joint_index = 0; joint_index < dynamic_joint_state_msg.joint_names.size();
-         ++joint_index)
+    // the message holds the last published values
+    if (is_dynamic_joint_state_due(time, interface_values_, dynamic_joint_state_msg))
     {
-      const auto & name = dynamic_joint_state_msg.joint_names[joint_index];
-      for (size_t interface_index = 0;
-           interface_index <
-           dynamic_joint_state_msg.interface_values[joint_index].interface_names.size();
-           ++interface_index)
-      {
-        const auto & interface_name =
-          dynamic_joint_state_msg.interface_values[joint_index].interface_names[interface_index];
-        dynamic_joint_state_msg.interface_values[joint_index].values[interface_index] =
-          name_if_value_mapping_[name][interface_name];
-      }
+      fill_dynamic_joint_state_msg(time, interface_values_, dynamic_joint_state_msg);
+      realtime_dynamic_joint_state_publisher_->unlockAndPublish();
+      last_dynamic_joint_state_publish_time_ = time;
+      dynamic_joint_state_published_ = true;
+    }
+    else
+    {
+      realtime_dynamic_joint_state_publisher_->unlock();
     }
-    realtime_dynamic_joint_state_publisher_->unlockAndPublish();
   }
+  CONTROLLER_TRACEPOINT(stage_end, this, "publish");
 
   return controller_interface::return_type::OK;
 }
@@ -14,9 +14,14 @@
 
 #include <stddef.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -29,6 +34,8 @@
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/utilities.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+#include "rt_safety_checks/rt_safety_checker.hpp"
+#include "rt_safety_checks/update_time_bound.hpp"
 #include "test_joint_state_broadcaster.hpp"
 
 using hardware_interface::HW_IF_EFFORT;
@@ -76,6 +83,18 @@ void JointStateBroadcasterTest::init_broadcaster_and_set_parameters(
   state_broadcaster_->get_node()->set_parameter({"interfaces", interfaces});
 }
 
+void JointStateBroadcasterTest::SetUpStateBroadcasterWithOverrides(
+  const std::vector<rclcpp::Parameter> & overrides)
+{
+  // read-only parameters can't be set after the parameters are declared in on_init
+  const auto options = rclcpp::NodeOptions()
+                         .parameter_overrides(overrides)
+                         .automatically_declare_parameters_from_overrides(false);
+  const auto result = state_broadcaster_->init("joint_state_broadcaster", "", 0, "", options);
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+  assign_state_interfaces();
+}
+
 void JointStateBroadcasterTest::assign_state_interfaces(
   const std::vector<std::string> & joint_names, const std::vector<std::string> & interfaces)
 {
@@ -363,6 +382,9 @@ TEST_F(JointStateBroadcasterTest, ActivateDeactivateTestTwoJointsOneInterface)
   state_if_conf = state_broadcaster_->state_interface_configuration();
   ASSERT_THAT(
     state_if_conf.names, SizeIs(JOINT_NAMES.size() * IF_NAMES.size()));  // does not change
+  // the dynamic joint state message is initialized again, not extended
+  ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
+  ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
 }
 
 TEST_F(JointStateBroadcasterTest, ActivateTestOneJointTwoInterfaces)
@@ -703,6 +725,17 @@ TEST_F(JointStateBroadcasterTest, JointStatePublishTestLocalTopic)
   test_published_joint_state_message("joint_state_broadcaster/joint_states");
 }
 
+TEST_F(JointStateBroadcasterTest, JointStatePublishTestPublisherPool)
+{
+  SetUpStateBroadcasterWithOverrides(
+    {rclcpp::Parameter("publisher_pool.enable", true),
+     rclcpp::Parameter("publisher_pool.threads", 2)});
+
+  test_published_joint_state_message("joint_states");
+  EXPECT_TRUE(state_broadcaster_->realtime_joint_state_publisher_->is_pooled());
+  EXPECT_TRUE(state_broadcaster_->realtime_dynamic_joint_state_publisher_->is_pooled());
+}
+
 void JointStateBroadcasterTest::test_published_dynamic_joint_state_message(
   const std::string & topic)
 {
@@ -809,3 +842,510 @@ TEST_F(JointStateBroadcasterTest, ExtraJointStatePublishTest)
     state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
 }
+
+TEST_F(JointStateBroadcasterTest, PublishRateTest)
+{
+  SetUpStateBroadcaster();
+  state_broadcaster_->get_node()->set_parameter({"joint_states_publish_rate", 10.0});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg =
+    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  auto update_at = [&](const rclcpp::Time & time)
+  {
+    // give the realtime publishers time to publish the previous message
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(
+      state_broadcaster_->update(time, rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  // both messages are published in the first update
+  const rclcpp::Time start_time(1, 0, RCL_STEADY_TIME);
+  update_at(start_time);
+  EXPECT_EQ(rclcpp::Time(joint_state_msg.header.stamp, RCL_STEADY_TIME), start_time);
+  EXPECT_EQ(rclcpp::Time(dynamic_joint_state_msg.header.stamp, RCL_STEADY_TIME), start_time);
+
+  // only dynamic_joint_states is published in every update
+  auto time = start_time + rclcpp::Duration::from_seconds(0.01);
+  update_at(time);
+  EXPECT_EQ(rclcpp::Time(joint_state_msg.header.stamp, RCL_STEADY_TIME), start_time);
+  EXPECT_EQ(rclcpp::Time(dynamic_joint_state_msg.header.stamp, RCL_STEADY_TIME), time);
+
+  time = start_time + rclcpp::Duration::from_seconds(0.11);
+  update_at(time);
+  EXPECT_EQ(rclcpp::Time(joint_state_msg.header.stamp, RCL_STEADY_TIME), time);
+}
+
+TEST_F(JointStateBroadcasterTest, DynamicJointStateDeadbandTest)
+{
+  SetUpStateBroadcaster();
+  auto node = state_broadcaster_->get_node();
+  node->set_parameter({"dynamic_joint_states_deadband.enable", true});
+  node->set_parameter({"dynamic_joint_states_deadband.default_threshold", 1.0});
+  node->set_parameter({"dynamic_joint_states_deadband.keepalive_period", 1.0});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  const auto & dynamic_joint_state_msg =
+    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  auto update_at = [&](const rclcpp::Time & time)
+  {
+    // give the realtime publisher time to publish the previous message
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(
+      state_broadcaster_->update(time, rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+  auto last_stamp = [&]()
+  { return rclcpp::Time(dynamic_joint_state_msg.header.stamp, RCL_STEADY_TIME); };
+
+  // always published first
+  const rclcpp::Time start_time(1, 0, RCL_STEADY_TIME);
+  update_at(start_time);
+  EXPECT_EQ(last_stamp(), start_time);
+
+  // within the deadband
+  joint_values_[0] += 0.5;
+  update_at(start_time + rclcpp::Duration::from_seconds(0.1));
+  EXPECT_EQ(last_stamp(), start_time);
+
+  // the change since the last published message is out of the deadband
+  joint_values_[0] += 1.0;
+  auto time = start_time + rclcpp::Duration::from_seconds(0.2);
+  update_at(time);
+  EXPECT_EQ(last_stamp(), time);
+
+  // keepalive without any change
+  update_at(start_time + rclcpp::Duration::from_seconds(0.5));
+  EXPECT_EQ(last_stamp(), time);
+  time = start_time + rclcpp::Duration::from_seconds(1.3);
+  update_at(time);
+  EXPECT_EQ(last_stamp(), time);
+}
+
+TEST_F(JointStateBroadcasterTest, DynamicJointStateDeadbandConfigureErrorTest)
+{
+  SetUpStateBroadcaster();
+  state_broadcaster_->get_node()->set_parameter(
+    {"dynamic_joint_states_deadband.interfaces", std::vector<std::string>{"temperature"}});
+
+  // thresholds are missing
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+}
+
+TEST_F(JointStateBroadcasterTest, JointStatesBatchTest)
+{
+  SetUpStateBroadcasterWithOverrides(
+    {rclcpp::Parameter("joint_states_batch.enable", true),
+     rclcpp::Parameter("joint_states_batch.size", 2)});
+  // the batch does not depend on the publishing rate of joint_states
+  state_broadcaster_->get_node()->set_parameter({"joint_states_publish_rate", 1.0});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  const auto & batch_msg = state_broadcaster_->realtime_joint_states_batch_publisher_->msg_;
+  ASSERT_THAT(batch_msg.joint_names, ElementsAreArray(joint_names_));
+  ASSERT_EQ(batch_msg.points.size(), 2u);
+
+  const rclcpp::Time start_time(1, 0, RCL_STEADY_TIME);
+  const auto period = rclcpp::Duration::from_seconds(0.001);
+  ASSERT_EQ(state_broadcaster_->update(start_time, period), controller_interface::return_type::OK);
+  joint_values_[0] += 1.0;
+  ASSERT_EQ(
+    state_broadcaster_->update(start_time + period, period),
+    controller_interface::return_type::OK);
+
+  EXPECT_EQ(rclcpp::Time(batch_msg.header.stamp, RCL_STEADY_TIME), start_time);
+  EXPECT_EQ(rclcpp::Duration(batch_msg.points[0].time_from_start), rclcpp::Duration(0, 0));
+  EXPECT_EQ(rclcpp::Duration(batch_msg.points[1].time_from_start), period);
+  EXPECT_EQ(batch_msg.points[1].positions[0], batch_msg.points[0].positions[0] + 1.0);
+  EXPECT_EQ(state_broadcaster_->dropped_joint_states_batches_, 0u);
+}
+
+TEST_F(JointStateBroadcasterTest, JointGroupsTest)
+{
+  SetUpStateBroadcasterWithOverrides(
+    {rclcpp::Parameter("joint_groups", std::vector<std::string>{"arm", "head"}),
+     rclcpp::Parameter("groups.arm.joints", std::vector<std::string>{"joint3", "joint1"}),
+     rclcpp::Parameter("groups.head.joints", std::vector<std::string>{"joint2"}),
+     rclcpp::Parameter("groups.head.publish_rate", 10.0)});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_THAT(state_broadcaster_->joint_groups_, SizeIs(2));
+  EXPECT_STREQ(
+    state_broadcaster_->joint_groups_[0].publisher->get_topic_name(), "/arm/joint_states");
+
+  // the groups keep the order of their joints
+  const auto & arm_msg = state_broadcaster_->joint_groups_[0].realtime_publisher->msg_;
+  const auto & head_msg = state_broadcaster_->joint_groups_[1].realtime_publisher->msg_;
+  ASSERT_THAT(arm_msg.name, ElementsAreArray({"joint3", "joint1"}));
+  ASSERT_THAT(head_msg.name, ElementsAreArray({"joint2"}));
+
+  auto update_at = [&](const rclcpp::Time & time)
+  {
+    // give the realtime publishers time to publish the previous message
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(
+      state_broadcaster_->update(time, rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  // all groups are published in the first update
+  const rclcpp::Time start_time(1, 0, RCL_STEADY_TIME);
+  update_at(start_time);
+  EXPECT_EQ(rclcpp::Time(arm_msg.header.stamp, RCL_STEADY_TIME), start_time);
+  EXPECT_EQ(rclcpp::Time(head_msg.header.stamp, RCL_STEADY_TIME), start_time);
+  EXPECT_THAT(arm_msg.position, ElementsAreArray({joint_values_[2], joint_values_[0]}));
+  EXPECT_THAT(arm_msg.velocity, ElementsAreArray({joint_values_[2], joint_values_[0]}));
+  EXPECT_THAT(head_msg.effort, ElementsAreArray({joint_values_[1]}));
+
+  // each at its own rate
+  auto time = start_time + rclcpp::Duration::from_seconds(0.01);
+  update_at(time);
+  EXPECT_EQ(rclcpp::Time(arm_msg.header.stamp, RCL_STEADY_TIME), time);
+  EXPECT_EQ(rclcpp::Time(head_msg.header.stamp, RCL_STEADY_TIME), start_time);
+  time = start_time + rclcpp::Duration::from_seconds(0.11);
+  update_at(time);
+  EXPECT_EQ(rclcpp::Time(head_msg.header.stamp, RCL_STEADY_TIME), time);
+}
+
+TEST_F(JointStateBroadcasterTest, JointGroupsActivateErrorTest)
+{
+  SetUpStateBroadcasterWithOverrides(
+    {rclcpp::Parameter("joint_groups", std::vector<std::string>{"gripper"}),
+     rclcpp::Parameter("groups.gripper.joints", std::vector<std::string>{"finger_joint"})});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  // the joint has no state interfaces
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_ERROR);
+}
+
+TEST_F(JointStateBroadcasterTest, BoundedJointStatesTest)
+{
+  SetUpStateBroadcasterWithOverrides({rclcpp::Parameter("bounded_joint_states.enable", true)});
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  const auto & joint_names = state_broadcaster_->joint_names_;
+  ASSERT_THAT(joint_names, SizeIs(joint_names_.size()));
+
+  // the names are published once, a subscriber joining after the activation still receives them
+  rclcpp::Node test_node("test_node");
+  auto names_subscription = test_node.create_subscription<sensor_msgs::msg::JointState>(
+    "/bounded_joint_states/names", rclcpp::QoS(1).reliable().transient_local(),
+    [](const sensor_msgs::msg::JointState::SharedPtr) {});
+  rclcpp::WaitSet names_wait_set;
+  names_wait_set.add_subscription(names_subscription);
+  ASSERT_EQ(names_wait_set.wait(std::chrono::seconds(5)).kind(), rclcpp::WaitResultKind::Ready);
+  sensor_msgs::msg::JointState names_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(names_subscription->take(names_msg, msg_info));
+  EXPECT_THAT(names_msg.name, ElementsAreArray(joint_names));
+  EXPECT_THAT(names_msg.position, IsEmpty());
+
+  using bounded_joint_state_msgs::msg::BoundedJointState;
+  auto subscription = test_node.create_subscription<BoundedJointState>(
+    "/bounded_joint_states", 10, [](const BoundedJointState::SharedPtr) {});
+  int max_sub_check_loop_count = 5;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (max_sub_check_loop_count--)
+  {
+    state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01));
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0) << "No bounded joint states were published";
+
+  // the values are in the order of the names
+  BoundedJointState msg;
+  ASSERT_TRUE(subscription->take(msg, msg_info));
+  ASSERT_EQ(msg.size, joint_names.size());
+  for (size_t i = 0; i < joint_names.size(); ++i)
+  {
+    const auto joint = std::find(joint_names_.begin(), joint_names_.end(), joint_names[i]);
+    ASSERT_NE(joint, joint_names_.end());
+    const double value = joint_values_[static_cast<size_t>(joint - joint_names_.begin())];
+    EXPECT_EQ(msg.position[i], value);
+    EXPECT_EQ(msg.velocity[i], value);
+    EXPECT_EQ(msg.effort[i], value);
+  }
+}
+
+TEST_F(JointStateBroadcasterTest, BoundedJointStatesActivateErrorTest)
+{
+  // the state interfaces and the extra joints are one joint more than the message holds
+  std::vector<std::string> extra_joints;
+  for (size_t i = joint_names_.size();
+       i <= bounded_joint_state_msgs::msg::BoundedJointState::MAX_JOINTS; ++i)
+  {
+    extra_joints.push_back("extra_joint_" + std::to_string(i));
+  }
+  SetUpStateBroadcasterWithOverrides(
+    {rclcpp::Parameter("bounded_joint_states.enable", true),
+     rclcpp::Parameter("extra_joints", extra_joints)});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_ERROR);
+}
+
+TEST_F(JointStateBroadcasterTest, VelocitySynthesisTest)
+{
+  const auto options = rclcpp::NodeOptions()
+                         .parameter_overrides(
+                           {rclcpp::Parameter(
+                              "velocity_synthesis.joints",
+                              std::vector<std::string>{"joint1", "joint2", "joint3"}),
+                            rclcpp::Parameter("velocity_synthesis.cutoff_frequency", 10.0)})
+                         .automatically_declare_parameters_from_overrides(false);
+  ASSERT_EQ(
+    state_broadcaster_->init("joint_state_broadcaster", "", 0, "", options),
+    controller_interface::return_type::OK);
+  // only joint3 has a velocity state interface
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(joint_1_pos_state_);
+  state_ifs.emplace_back(joint_2_pos_state_);
+  state_ifs.emplace_back(joint_3_pos_state_);
+  state_ifs.emplace_back(joint_3_vel_state_);
+  state_broadcaster_->assign_interfaces({}, std::move(state_ifs));
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_THAT(state_broadcaster_->synthesized_velocities_, SizeIs(2));
+
+  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg =
+    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto period = rclcpp::Duration::from_seconds(0.001);
+  rclcpp::Time time(1, 0, RCL_STEADY_TIME);
+  auto update = [&]()
+  {
+    // give the realtime publishers time to publish the previous message
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    time += period;
+    ASSERT_EQ(state_broadcaster_->update(time, period), controller_interface::return_type::OK);
+  };
+  update();
+  EXPECT_TRUE(std::isnan(joint_state_msg.velocity[0]));
+
+  // the raw finite difference initializes the filter, later ones are low-pass filtered
+  joint_values_[0] += 0.002;
+  update();
+  EXPECT_NEAR(joint_state_msg.velocity[0], 2.0, 1e-9);
+  EXPECT_NEAR(joint_state_msg.velocity[1], 0.0, 1e-9);
+  joint_values_[0] += 0.001;
+  joint_values_[1] -= 0.001;
+  update();
+  const double smoothing = 0.001 / (0.001 + 1.0 / (2.0 * M_PI * 10.0));
+  EXPECT_NEAR(joint_state_msg.velocity[0], 2.0 + smoothing * (1.0 - 2.0), 1e-9);
+  EXPECT_NEAR(joint_state_msg.velocity[1], -smoothing, 1e-9);
+  // the velocity of the hardware is not replaced
+  EXPECT_EQ(joint_state_msg.velocity[2], joint_values_[2]);
+  EXPECT_THAT(
+    dynamic_joint_state_msg.interface_values[0].interface_names,
+    ElementsAreArray({HW_IF_POSITION, HW_IF_VELOCITY}));
+  EXPECT_NEAR(
+    dynamic_joint_state_msg.interface_values[0].values[1], joint_state_msg.velocity[0], 1e-12);
+}
+
+TEST_F(JointStateBroadcasterTest, UpdateStatisticsTest)
+{
+  SetUpStateBroadcasterWithOverrides(
+    {rclcpp::Parameter("update_statistics.enable", true),
+     rclcpp::Parameter("update_statistics.window_size", 2)});
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_node("test_node");
+  auto subscription = test_node.create_subscription<statistics_msgs::msg::MetricsMessage>(
+    "/joint_state_broadcaster/statistics", 10,
+    [](const statistics_msgs::msg::MetricsMessage::SharedPtr) {});
+
+  // every window of two updates is published
+  int max_sub_check_loop_count = 5;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (max_sub_check_loop_count--)
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01));
+    }
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0) << "No statistics were published";
+
+  statistics_msgs::msg::MetricsMessage statistics_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(statistics_msg, msg_info));
+  EXPECT_EQ(statistics_msg.measurement_source_name, "joint_state_broadcaster");
+  EXPECT_EQ(statistics_msg.unit, "ms");
+  ASSERT_THAT(statistics_msg.statistics, SizeIs(6));
+  using statistics_msgs::msg::StatisticDataType;
+  std::map<uint8_t, double> values;
+  for (const auto & data_point : statistics_msg.statistics)
+  {
+    values[data_point.data_type] = data_point.data;
+  }
+  EXPECT_EQ(values[StatisticDataType::STATISTICS_DATA_TYPE_SAMPLE_COUNT], 2.0);
+  EXPECT_LE(
+    values[StatisticDataType::STATISTICS_DATA_TYPE_MINIMUM],
+    values[StatisticDataType::STATISTICS_DATA_TYPE_AVERAGE]);
+  EXPECT_LE(
+    values[StatisticDataType::STATISTICS_DATA_TYPE_AVERAGE],
+    values[StatisticDataType::STATISTICS_DATA_TYPE_MAXIMUM]);
+  EXPECT_LE(
+    values[update_time_statistics::STATISTICS_DATA_TYPE_PERCENTILE_99],
+    values[StatisticDataType::STATISTICS_DATA_TYPE_MAXIMUM]);
+}
+
+TEST_F(JointStateBroadcasterTest, PeriodStatisticsTest)
+{
+  SetUpStateBroadcasterWithOverrides(
+    {rclcpp::Parameter("period_statistics.enable", true),
+     rclcpp::Parameter("period_statistics.window_size", 3),
+     rclcpp::Parameter("period_statistics.update_rate", 100.0)});
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_node("test_node");
+  auto subscription = test_node.create_subscription<statistics_msgs::msg::MetricsMessage>(
+    "/joint_state_broadcaster/period_statistics", 10,
+    [](const statistics_msgs::msg::MetricsMessage::SharedPtr) {});
+
+  // the first period after activation is skipped
+  state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(1.0));
+  // in every window of three updates, the second one overruns and misses two cycles
+  int max_sub_check_loop_count = 5;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (max_sub_check_loop_count--)
+  {
+    for (const double period : {0.01, 0.03, 0.01})
+    {
+      state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(period));
+    }
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0) << "No period statistics were published";
+
+  statistics_msgs::msg::MetricsMessage statistics_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(statistics_msg, msg_info));
+  EXPECT_EQ(statistics_msg.metrics_source, "update_period");
+  EXPECT_EQ(statistics_msg.unit, "ms");
+  ASSERT_THAT(statistics_msg.statistics, SizeIs(8));
+  using statistics_msgs::msg::StatisticDataType;
+  std::map<uint8_t, double> values;
+  for (const auto & data_point : statistics_msg.statistics)
+  {
+    values[data_point.data_type] = data_point.data;
+  }
+  EXPECT_EQ(values[StatisticDataType::STATISTICS_DATA_TYPE_SAMPLE_COUNT], 3.0);
+  EXPECT_NEAR(values[StatisticDataType::STATISTICS_DATA_TYPE_MINIMUM], 10.0, 1e-6);
+  EXPECT_NEAR(values[StatisticDataType::STATISTICS_DATA_TYPE_MAXIMUM], 30.0, 1e-6);
+  EXPECT_EQ(values[update_time_statistics::STATISTICS_DATA_TYPE_OVERRUNS], 1.0);
+  EXPECT_EQ(values[update_time_statistics::STATISTICS_DATA_TYPE_MISSED_CYCLES], 2.0);
+}
+
+TEST_F(JointStateBroadcasterTest, UpdateIsRealtimeSafeTest)
+{
+  SetUpStateBroadcaster();
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // both messages are published in every update the realtime publishers aren't busy
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time(1, 0, RCL_STEADY_TIME);
+  ASSERT_EQ(state_broadcaster_->update(time, period), controller_interface::return_type::OK);
+
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    time += period;
+    joint_values_[0] += 0.1;
+    state_broadcaster_->update(time, period);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+}
+
+TEST_F(JointStateBroadcasterTest, UpdateTimeScalesLinearlyWithTheInterfacesTest)
+{
+  constexpr size_t NUM_CYCLES = 200;
+  constexpr size_t NUM_LARGE_JOINTS = 334;
+  const auto period = rclcpp::Duration::from_seconds(0.001);
+  rclcpp::Time time(1, 0, RCL_STEADY_TIME);
+  const auto update = [this, &time, &period](size_t)
+  {
+    time += period;
+    for (auto & value : joint_values_)
+    {
+      value += 0.1;
+    }
+    state_broadcaster_->update(time, period);
+  };
+
+  // the baseline are the updates of the 9 interfaces of the fixture, the updates of 1002
+  // interfaces may take up to twice as long per interface, plus the scheduling of the test
+  const size_t num_interfaces = joint_names_.size() * interface_names_.size();
+  const size_t num_large_interfaces = NUM_LARGE_JOINTS * interface_names_.size();
+  rt_safety_checks::UpdateTimeBound bound(
+    2.0 * static_cast<double>(num_large_interfaces) / static_cast<double>(num_interfaces),
+    std::chrono::microseconds(500));
+  SetUpStateBroadcaster();
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->update(time, period), controller_interface::return_type::OK);
+  bound.calibrate(NUM_CYCLES, update);
+
+  std::vector<double> large_values(num_large_interfaces, 1.0);
+  std::vector<hardware_interface::StateInterface> large_interfaces;
+  large_interfaces.reserve(num_large_interfaces);
+  for (size_t joint = 0; joint < NUM_LARGE_JOINTS; ++joint)
+  {
+    for (const auto & interface : interface_names_)
+    {
+      large_interfaces.emplace_back(
+        "joint" + std::to_string(joint), interface, &large_values[large_interfaces.size()]);
+    }
+  }
+  std::vector<LoanedStateInterface> state_ifs;
+  for (auto & interface : large_interfaces)
+  {
+    state_ifs.emplace_back(interface);
+  }
+  state_broadcaster_ = std::make_unique<FriendJointStateBroadcaster>();
+  init_broadcaster_and_set_parameters();
+  state_broadcaster_->assign_interfaces({}, std::move(state_ifs));
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // all values change in every update, as in the baseline
+  const auto times = rt_safety_checks::measure_update_times(
+    NUM_CYCLES,
+    [&](size_t i)
+    {
+      std::fill(large_values.begin(), large_values.end(), static_cast<double>(i));
+      time += period;
+      state_broadcaster_->update(time, period);
+    });
+  EXPECT_TRUE(bound.holds(times))
+    << "worst update " << times.max.count() << " ns, baseline " << bound.get_baseline().count()
+    << " ns, bound " << bound.get_bound().count() << " ns";
+}
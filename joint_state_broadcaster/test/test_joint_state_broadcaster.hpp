@@ -44,6 +44,12 @@ class FriendJointStateBroadcaster : public joint_state_broadcaster::JointStateBr
   FRIEND_TEST(JointStateBroadcasterTest, TestCustomInterfaceMapping);
   FRIEND_TEST(JointStateBroadcasterTest, TestCustomInterfaceMappingUpdate);
   FRIEND_TEST(JointStateBroadcasterTest, ExtraJointStatePublishTest);
+  FRIEND_TEST(JointStateBroadcasterTest, PublishRateTest);
+  FRIEND_TEST(JointStateBroadcasterTest, DynamicJointStateDeadbandTest);
+  FRIEND_TEST(JointStateBroadcasterTest, JointStatesBatchTest);
+  FRIEND_TEST(JointStateBroadcasterTest, JointGroupsTest);
+  FRIEND_TEST(JointStateBroadcasterTest, BoundedJointStatesTest);
+  FRIEND_TEST(JointStateBroadcasterTest, VelocitySynthesisTest);
 };
 
 class JointStateBroadcasterTest : public ::testing::Test
@@ -63,6 +69,9 @@ public:
     const std::vector<std::string> & joint_names = {},
     const std::vector<std::string> & interfaces = {});
 
+  /// Set up the broadcaster with all interfaces, \p overrides can also set read-only parameters
+  void SetUpStateBroadcasterWithOverrides(const std::vector<rclcpp::Parameter> & overrides);
+
   void assign_state_interfaces(
     const std::vector<std::string> & joint_names = {},
     const std::vector<std::string> & interfaces = {});
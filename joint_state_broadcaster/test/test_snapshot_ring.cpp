@@ -0,0 +1,66 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <vector>
+
+#include "joint_state_broadcaster/snapshot_ring.hpp"
+
+using joint_state_broadcaster::SnapshotHeader;
+using joint_state_broadcaster::SnapshotRing;
+using testing::ElementsAre;
+
+TEST(SnapshotRingTest, PushAndPopInOrder)
+{
+  SnapshotRing ring;
+  ring.resize(2, 3);
+  ASSERT_EQ(ring.capacity(), 2u);
+
+  SnapshotHeader header;
+  std::vector<double> values(3);
+  // empty
+  EXPECT_FALSE(ring.pop(header, values));
+
+  EXPECT_TRUE(ring.push({rclcpp::Time(1, 0), true, false}, {1.0, 2.0, 3.0}));
+  EXPECT_TRUE(ring.push({rclcpp::Time(2, 0), false, true}, {4.0, 5.0, 6.0}));
+  // full
+  EXPECT_FALSE(ring.push({rclcpp::Time(3, 0), true, true}, {7.0, 8.0, 9.0}));
+
+  ASSERT_TRUE(ring.pop(header, values));
+  EXPECT_EQ(header.stamp, rclcpp::Time(1, 0));
+  EXPECT_TRUE(header.publish_joint_state);
+  EXPECT_FALSE(header.publish_dynamic_joint_state);
+  EXPECT_THAT(values, ElementsAre(1.0, 2.0, 3.0));
+
+  // the freed slot is reused
+  EXPECT_TRUE(ring.push({rclcpp::Time(3, 0), true, true}, {7.0, 8.0, 9.0}));
+
+  ASSERT_TRUE(ring.pop(header, values));
+  EXPECT_EQ(header.stamp, rclcpp::Time(2, 0));
+  EXPECT_FALSE(header.publish_joint_state);
+  EXPECT_TRUE(header.publish_dynamic_joint_state);
+  EXPECT_THAT(values, ElementsAre(4.0, 5.0, 6.0));
+
+  ASSERT_TRUE(ring.pop(header, values));
+  EXPECT_EQ(header.stamp, rclcpp::Time(3, 0));
+  EXPECT_THAT(values, ElementsAre(7.0, 8.0, 9.0));
+  EXPECT_FALSE(ring.pop(header, values));
+}
+
+TEST(SnapshotRingTest, PushFailsWithoutCapacity)
+{
+  SnapshotRing ring;
+  EXPECT_FALSE(ring.push({rclcpp::Time(1, 0), true, true}, {}));
+}
@@ -0,0 +1,42 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__CACHE_LINE_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__CACHE_LINE_HPP_
+
+#include <cstddef>
+
+namespace joint_trajectory_controller
+{
+/// Size of a cache line of the supported platforms. std::hardware_destructive_interference_size
+/// is not available with all supported compilers, and its value may change between them.
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * \brief \p T alone on its cache lines.
+ *
+ * For the values written by the non-realtime threads and read by update() in every cycle, so the
+ * writes to neighbouring members don't invalidate the cache line of update() or the other way
+ * round. It can be used like \p T, e.g., CacheLineAligned<std::atomic<bool>>.
+ */
+template <typename T>
+struct alignas(CACHE_LINE_SIZE) CacheLineAligned : T
+{
+  using T::T;
+  using T::operator=;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__CACHE_LINE_HPP_
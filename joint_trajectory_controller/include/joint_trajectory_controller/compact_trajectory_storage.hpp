@@ -0,0 +1,111 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__COMPACT_TRAJECTORY_STORAGE_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__COMPACT_TRAJECTORY_STORAGE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/visibility_control.h"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+/// Precision of the values of a CompactTrajectoryStorage
+enum class CompactValueType : uint8_t
+{
+  FLOAT64,
+  /// Half of the memory, the values are rounded to about 7 significant digits
+  FLOAT32,
+};
+
+/**
+ * \brief Points of a trajectory msg in one contiguous allocation, sampled by Trajectory.
+ *
+ * Every point of a msg has its own vectors, so the points of a long trajectory are scattered over
+ * the heap. The storage keeps the times from start of all points, followed by the positions of all
+ * points and, if all points have them, their velocities and accelerations. Within a field, the
+ * values of one point are consecutive, so loading a segment reads a few cache lines only.
+ * It is built once outside of the realtime loop and not changed afterwards, so it can be shared by
+ * copies of a Trajectory.
+ */
+class CompactTrajectoryStorage
+{
+public:
+  /// Store the points of \p trajectory, not realtime-safe
+  /**
+   * \return nullptr if a point misses positions, or has velocities or accelerations while others
+   * don't, e.g., before the msg was completed with complete_trajectory_points()
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  static std::shared_ptr<const CompactTrajectoryStorage> build(
+    const trajectory_msgs::msg::JointTrajectory & trajectory, CompactValueType value_type);
+
+  size_t size() const { return num_points_; }
+
+  size_t dim() const { return dim_; }
+
+  bool has_velocities() const { return has_velocities_; }
+
+  bool has_accelerations() const { return has_accelerations_; }
+
+  CompactValueType value_type() const { return value_type_; }
+
+  /// Bytes allocated for the points
+  size_t memory_size() const { return data_.size(); }
+
+  /// Time from start of point \p index in nanoseconds
+  int64_t time_from_start_ns(size_t index) const { return times_ns()[index]; }
+
+  /// Copy point \p index into \p point, realtime-safe if its fields have the capacity for dim()
+  /**
+   * Fields the storage doesn't have are cleared, the time from start and efforts are not set.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void load_point(size_t index, trajectory_msgs::msg::JointTrajectoryPoint & point) const;
+
+private:
+  CompactTrajectoryStorage() = default;
+
+  const int64_t * times_ns() const { return reinterpret_cast<const int64_t *>(data_.data()); }
+
+  /// Copy the \p field values of point \p index into \p values
+  template <typename T>
+  void load_values(size_t field_offset, size_t index, std::vector<double> & values) const;
+
+  size_t num_points_ = 0;
+  size_t dim_ = 0;
+  bool has_velocities_ = false;
+  bool has_accelerations_ = false;
+  CompactValueType value_type_ = CompactValueType::FLOAT64;
+  // offsets of the fields in data_, the times start at 0
+  size_t positions_offset_ = 0;
+  size_t velocities_offset_ = 0;
+  size_t accelerations_offset_ = 0;
+  // the only allocation, aligned for int64_t and double by the allocator
+  std::vector<uint8_t> data_;
+};
+
+/// \return the value type of the `trajectory_storage` parameter \p name, false for "msg"
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+bool compact_value_type_from_string(const std::string & name, CompactValueType & value_type);
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__COMPACT_TRAJECTORY_STORAGE_HPP_
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__GOAL_STATE_CHANNEL_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__GOAL_STATE_CHANNEL_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace joint_trajectory_controller
+{
+/// No data is sent along with the goal states
+struct NoGoalStatePayload
+{
+};
+
+/**
+ * \brief Lock-free single-producer/single-consumer channel for terminal goal states.
+ *
+ * The realtime loop (producer) pushes a goal together with the error code of its result and an
+ * optional \p Payload, e.g., statistics for the result, the non-realtime action side (consumer)
+ * pops it and finishes the goal.
+ * Pushing never blocks or allocates memory, if the payloads are copied into the storage prepared
+ * by prepare_payloads(). It fails if \p Capacity requests are still waiting to be processed.
+ */
+template <typename GoalHandlePtr, size_t Capacity = 4, typename Payload = NoGoalStatePayload>
+class GoalStateChannel
+{
+public:
+  /// Request to finish \p goal with \p error_code, realtime-safe
+  bool push(const GoalHandlePtr & goal, int32_t error_code)
+  {
+    return push(goal, error_code, nullptr);
+  }
+
+  /// Request to finish \p goal with \p error_code and a copy of \p payload, realtime-safe
+  bool push(const GoalHandlePtr & goal, int32_t error_code, const Payload & payload)
+  {
+    return push(goal, error_code, &payload);
+  }
+
+  /// Take the oldest request, not realtime-safe as it might release the last goal reference
+  bool pop(GoalHandlePtr & goal, int32_t & error_code) { return pop(goal, error_code, nullptr); }
+
+  /// Take the oldest request with its payload, not realtime-safe
+  bool pop(GoalHandlePtr & goal, int32_t & error_code, Payload & payload)
+  {
+    return pop(goal, error_code, &payload);
+  }
+
+  /**
+   * Copy \p prototype into the payloads of all requests, e.g., to allocate their memory, not
+   * realtime-safe. No request may be pending.
+   */
+  void prepare_payloads(const Payload & prototype)
+  {
+    for (auto & request : requests_)
+    {
+      request.payload = prototype;
+    }
+  }
+
+private:
+  bool push(const GoalHandlePtr & goal, int32_t error_code, const Payload * payload)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= Capacity)
+    {
+      return false;
+    }
+    auto & request = requests_[head % Capacity];
+    // the slot was emptied by pop(), so no goal handle is destroyed here
+    request.goal = goal;
+    request.error_code = error_code;
+    if (payload)
+    {
+      request.payload = *payload;
+    }
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(GoalHandlePtr & goal, int32_t & error_code, Payload * payload)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    auto & request = requests_[tail % Capacity];
+    goal = std::move(request.goal);
+    request.goal = GoalHandlePtr();
+    error_code = request.error_code;
+    if (payload)
+    {
+      // copied, the memory of the request is kept for the next push()
+      *payload = request.payload;
+    }
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  struct Request
+  {
+    GoalHandlePtr goal;
+    int32_t error_code = 0;
+    Payload payload;
+  };
+
+  std::array<Request, Capacity> requests_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__GOAL_STATE_CHANNEL_HPP_
@@ -0,0 +1,81 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__HANDOFF_BUFFER_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__HANDOFF_BUFFER_HPP_
+
+#include <mutex>
+
+#include "joint_trajectory_controller/cache_line.hpp"
+#include "joint_trajectory_controller/triple_buffer.hpp"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Wait-free hand-over of the latest value from the non-realtime threads to update().
+ *
+ * Replaces realtime_tools::RealtimeBuffer, whose readFromRT() only takes a new value if it gets the
+ * lock of the writer, so a value written at the wrong moment is taken one cycle later. Here,
+ * read_from_rt() takes the latest value written before it in every call, through a TripleBuffer.
+ * Only the writers are serialized by a mutex.
+ *
+ * The value taken by update() stays in its buffer of the TripleBuffer until update() takes the next
+ * one; it is then released by the next writer, so update() never releases the last reference of a
+ * shared_ptr it replaced this way.
+ *
+ * The buffers start at a cache line, apart from the storage of the writers and from neighbouring
+ * members.
+ */
+template <typename T>
+class HandoffBuffer
+{
+public:
+  /// Hand \p value over to the next read_from_rt(), not realtime-safe
+  void write_from_non_rt(const T & value)
+  {
+    std::lock_guard<std::mutex> guard(write_mutex_);
+    non_rt_value_ = value;
+    buffers_.write_buffer() = value;
+    buffers_.publish();
+  }
+
+  /// Latest value written by write_from_non_rt(), only for update(), wait-free
+  T * read_from_rt()
+  {
+    buffers_.update_read_buffer();
+    return &buffers_.read_buffer();
+  }
+
+  /// Value taken by the last read_from_rt(), only for update(), e.g., to replace it
+  /**
+   * Unlike read_from_rt(), a value written since then is not taken, so it isn't overwritten.
+   */
+  T & current_from_rt() { return buffers_.read_buffer(); }
+
+  /// Latest value written by write_from_non_rt(), not the changes of update(); not realtime-safe
+  const T * read_from_non_rt() const
+  {
+    std::lock_guard<std::mutex> guard(write_mutex_);
+    return &non_rt_value_;
+  }
+
+private:
+  mutable std::mutex write_mutex_;
+  T non_rt_value_{};
+  alignas(CACHE_LINE_SIZE) TripleBuffer<T> buffers_;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__HANDOFF_BUFFER_HPP_
@@ -30,13 +30,18 @@ namespace interpolation_methods
 enum class InterpolationMethod
 {
   NONE,
-  VARIABLE_DEGREE_SPLINE
+  VARIABLE_DEGREE_SPLINE,
+  QUINTIC_SPLINE,
+  CUBIC_SPLINE
 };
 
 const InterpolationMethod DEFAULT_INTERPOLATION = InterpolationMethod::VARIABLE_DEGREE_SPLINE;
 
 const std::unordered_map<InterpolationMethod, std::string> InterpolationMethodMap(
-  {{InterpolationMethod::NONE, "none"}, {InterpolationMethod::VARIABLE_DEGREE_SPLINE, "splines"}});
+  {{InterpolationMethod::NONE, "none"},
+   {InterpolationMethod::VARIABLE_DEGREE_SPLINE, "splines"},
+   {InterpolationMethod::QUINTIC_SPLINE, "quintic_splines"},
+   {InterpolationMethod::CUBIC_SPLINE, "cubic_splines"}});
 
 [[nodiscard]] inline InterpolationMethod from_string(const std::string & interpolation_method)
 {
@@ -50,6 +55,18 @@ const std::unordered_map<InterpolationMethod, std::string> InterpolationMethodMa
   {
     return InterpolationMethod::VARIABLE_DEGREE_SPLINE;
   }
+  else if (
+    interpolation_method.compare(InterpolationMethodMap.at(InterpolationMethod::QUINTIC_SPLINE)) ==
+    0)
+  {
+    return InterpolationMethod::QUINTIC_SPLINE;
+  }
+  else if (
+    interpolation_method.compare(InterpolationMethodMap.at(InterpolationMethod::CUBIC_SPLINE)) ==
+    0)
+  {
+    return InterpolationMethod::CUBIC_SPLINE;
+  }
   // Default
   else
   {
@@ -0,0 +1,72 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__JOINT_GROUP_TRAJECTORY_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__JOINT_GROUP_TRAJECTORY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/interpolation_methods.hpp"
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "joint_trajectory_controller/visibility_control.h"
+#include "rclcpp/time.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+namespace joint_trajectory_controller
+{
+/// Times closer than this are merged into one point by merge_group_trajectory()
+constexpr int64_t MERGED_POINT_RESOLUTION_NS = 1000;
+
+/// Continuation of a trajectory of all joints, in which the joints of a group follow a new one
+/**
+ * The result starts at \p start_time. The joints of \p moved_joint_indices follow \p group_msg,
+ * whose joints are in the order of \p moved_joint_indices and whose points all have positions.
+ * It starts from the state of \p base at \p base_time, and at \p start_time if its stamp is zero.
+ * The joints of \p held_joint_indices stop at their positions of that state. All other joints
+ * continue \p base from \p base_time on, so that time \p start_time of the result is time
+ * \p base_time of \p base.
+ *
+ * The points of the result are at the times of the points of both trajectories after the start,
+ * plus one at the start, with positions, velocities and accelerations of all joints. Spline
+ * segments of both trajectories are reproduced exactly by the quintic splines between them.
+ *
+ * Not realtime-safe, meant for the goals of joint groups.
+ *
+ * \param[in] base Trajectory continued by the joints which are not in the group.
+ * \param[in] base_time Time of \p base at the start of the result.
+ * \param[in] start_time Stamp of the result.
+ * \param[in] joint_names Joints of \p base and the result.
+ * \param[in] group_msg Trajectory of the joints of \p moved_joint_indices, or nullptr.
+ * \param[in] moved_joint_indices Index in \p joint_names of every joint of \p group_msg.
+ * \param[in] held_joint_indices Index in \p joint_names of the joints to stop.
+ * \param[in] interpolation_method Interpolation used for sampling both trajectories.
+ * \param[out] group_duration_ns Time from \p start_time to the last point of \p group_msg, zero
+ * without \p group_msg.
+ * \return nullptr if \p base can't be sampled at \p base_time for all joints.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+std::shared_ptr<trajectory_msgs::msg::JointTrajectory> merge_group_trajectory(
+  const Trajectory & base, const rclcpp::Time & base_time, const rclcpp::Time & start_time,
+  const std::vector<std::string> & joint_names,
+  const trajectory_msgs::msg::JointTrajectory * group_msg,
+  const std::vector<size_t> & moved_joint_indices, const std::vector<size_t> & held_joint_indices,
+  interpolation_methods::InterpolationMethod interpolation_method, int64_t & group_duration_ns);
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__JOINT_GROUP_TRAJECTORY_HPP_
@@ -15,35 +15,68 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__JOINT_TRAJECTORY_CONTROLLER_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__JOINT_TRAJECTORY_CONTROLLER_HPP_
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "bounded_controller_state_msgs/msg/bounded_joint_trajectory_controller_state.hpp"
 #include "control_msgs/action/follow_joint_trajectory.hpp"
 #include "control_msgs/msg/joint_trajectory_controller_state.hpp"
 #include "control_msgs/srv/query_trajectory_state.hpp"
-#include "control_toolbox/pid.hpp"
-#include "controller_interface/controller_interface.hpp"
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "goal_monitor/goal_monitor.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "joint_trajectory_controller/cache_line.hpp"
+#include "joint_trajectory_controller/compact_trajectory_storage.hpp"
+#include "joint_trajectory_controller/goal_state_channel.hpp"
+#include "joint_trajectory_controller/handoff_buffer.hpp"
 #include "joint_trajectory_controller/interpolation_methods.hpp"
+#include "joint_trajectory_controller/look_ahead.hpp"
+#include "joint_trajectory_controller/mapped_trajectory.hpp"
+#include "joint_trajectory_controller/reclaim_queue.hpp"
 #include "joint_trajectory_controller/tolerances.hpp"
+#include "joint_trajectory_controller/tracking_statistics.hpp"
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "joint_trajectory_controller/trajectory_cdr_decoder.hpp"
+#include "joint_trajectory_controller/trajectory_recorder.hpp"
+#include "joint_trajectory_controller/triple_buffer.hpp"
+#include "joint_trajectory_controller/velocity_stream.hpp"
 #include "joint_trajectory_controller/visibility_control.h"
+#include "memory_prefault/memory_prefault.hpp"
+#include "object_pool/object_pool.hpp"
+#include "pid_bank/pid_bank.hpp"
+#include "publisher_pool/loaned_publisher.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
 #include "rclcpp/duration.hpp"
+#include "rclcpp/serialized_message.hpp"
 #include "rclcpp/subscription.hpp"
 #include "rclcpp/time.hpp"
-#include "rclcpp/timer.hpp"
 #include "rclcpp_action/server.hpp"
 #include "rclcpp_action/types.hpp"
 #include "rclcpp_lifecycle/lifecycle_publisher.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+#include "realtime_logging/realtime_logger.hpp"
 #include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
 #include "realtime_tools/realtime_server_goal_handle.h"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "shm_command_ingress/shm_command_ring.hpp"
+#include "std_msgs/msg/string.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+#include "trajectory_horizon_exchange/trajectory_horizon_exchange.hpp"
 #include "trajectory_msgs/msg/joint_trajectory.hpp"
 #include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+#include "update_time_source/update_time_source.hpp"
+#include "update_time_statistics/cycle_budget.hpp"
+#include "update_time_statistics/startup_profile.hpp"
+#include "update_time_statistics/update_time_statistics.hpp"
 
 // auto-generated by generate_parameter_library
 #include "joint_trajectory_controller_parameters.hpp"
@@ -62,9 +95,7 @@ class State;
 
 namespace joint_trajectory_controller
 {
-class Trajectory;
-
-class JointTrajectoryController : public controller_interface::ControllerInterface
+class JointTrajectoryController : public controller_interface::ChainableControllerInterface
 {
 public:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
@@ -83,7 +114,11 @@ public:
   controller_interface::InterfaceConfiguration state_interface_configuration() const override;
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
-  controller_interface::return_type update(
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
@@ -131,6 +166,15 @@ protected:
 
   // Degrees of freedom
   size_t dof_;
+  // Index of every joint in 'params_.joints' by its name, for looking up incoming joint names
+  std::unordered_map<std::string, size_t> joint_index_;
+  // Joint order of the last reordered message and its mapping to the local joint order
+  std::vector<std::string> mapped_joint_names_;
+  std::vector<size_t> joint_mapping_;
+  // Values of one point being reordered to the local joint order, see sort_to_local_joint_order()
+  std::vector<double> sort_scratch_;
+  // Guards the joint mapping and the scratch, the topic and action callbacks may run in parallel
+  std::mutex sort_mutex_;
 
   // Storing command joint names for interfaces
   std::vector<std::string> command_joint_names_;
@@ -138,6 +182,8 @@ protected:
   // Parameters from ROS for joint_trajectory_controller
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
+  // durations of declaring the parameters and of the configuration, logged at debug level
+  update_time_statistics::StartupProfile startup_profile_;
 
   trajectory_msgs::msg::JointTrajectoryPoint last_commanded_state_;
   /// Specify interpolation method. Default to splines.
@@ -152,6 +198,21 @@ protected:
 
   InterfaceReferences<hardware_interface::LoanedCommandInterface> joint_command_interface_;
   InterfaceReferences<hardware_interface::LoanedStateInterface> joint_state_interface_;
+  // Values written to the command interfaces by update(), as pairs of the index in
+  // 'joint_command_interface_' and the source of the values. Selected on activation.
+  std::vector<std::pair<size_t, const std::vector<double> *>> command_sources_;
+  // The interfaces written by update(), flattened to 'dof_' consecutive entries per element of
+  // 'command_sources_', so the commands are written in one indexed loop. Set on activation.
+  std::vector<hardware_interface::LoanedCommandInterface *> rt_command_interfaces_;
+  // The state interfaces read by update(), 'dof_' consecutive entries per type of
+  // 'allowed_interface_types_', nullptr for the types which are not claimed. Set on activation.
+  std::vector<const hardware_interface::LoanedStateInterface *> rt_state_interfaces_;
+  // Full names of the interfaces of each type of 'allowed_interface_types_' in joint order, which
+  // the activation binds without allocating with 'hot_standby'. Set on configuration.
+  std::vector<std::vector<std::string>> standby_command_interface_names_;
+  std::vector<std::vector<std::string>> standby_state_interface_names_;
+  // State read on activation with 'hot_standby', preallocated on configuration
+  trajectory_msgs::msg::JointTrajectoryPoint activation_state_;
 
   bool has_position_state_interface_ = false;
   bool has_velocity_state_interface_ = false;
@@ -163,52 +224,236 @@ protected:
 
   /// If true, a velocity feedforward term plus corrective PID term is used
   bool use_closed_loop_pid_adapter_ = false;
-  using PidPtr = std::shared_ptr<control_toolbox::Pid>;
-  std::vector<PidPtr> pids_;
+  // PID controllers of all joints
+  pid_bank::PidBank pid_bank_;
   // Feed-forward velocity weight factor when calculating closed loop pid adapter's command
   std::vector<double> ff_velocity_scale_;
   // Configuration for every joint, if position error is wrapped around
   std::vector<bool> joints_angle_wraparound_;
+  // Indices of the joints with angle_wraparound, the position error of only these is normalized
+  std::vector<size_t> wraparound_joint_indices_;
   // reserved storage for result of the command when closed loop pid adapter is used
   std::vector<double> tmp_command_;
 
+  // Optional state interface providing the speed scaling factor
+  std::optional<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
+    speed_scaling_state_interface_;
+  // Factor the trajectory time advances with relative to the controller time
+  double speed_scaling_factor_ = 1.0;
+  // Time the active trajectory is sampled at, advanced by the scaled period in every update
+  rclcpp::Time traj_time_;
+  // traj_time_ of the last update, for the look-ahead
+  std::atomic<int64_t> rt_traj_time_ns_{0};
+
+  // Limits checked by the look-ahead, not changed while active
+  LookAheadLimits look_ahead_limits_;
+  // Trajectory generation and trajectory time of the first limit violation found by the look-ahead
+  std::atomic<uint64_t> look_ahead_generation_{0};
+  std::atomic<int64_t> look_ahead_violation_time_ns_{0};
+  // Storage of the samples checked by the look-ahead, accessed by check_look_ahead() only
+  TrajectorySamples look_ahead_samples_;
+  // Factor of the trajectory time while decelerating before a violation, one otherwise
+  double rt_look_ahead_scaling_ = 1.0;
+  // Decrease of rt_look_ahead_scaling_ per second, zero if not decelerating
+  double rt_look_ahead_scaling_rate_ = 0.0;
+
+  // Slot the horizon is exported to, nullptr if trajectory_horizon.enable is false
+  std::shared_ptr<trajectory_horizon_exchange::TrajectoryHorizonSlot> horizon_slot_;
+  // Samples of the horizon and the horizon written to horizon_slot_, reserved on configuration
+  TrajectorySamples horizon_samples_;
+  trajectory_horizon_exchange::TrajectoryHorizon horizon_;
+
+  // Streamed velocity points of the topic, see velocity_streaming parameters
+  VelocityStream velocity_stream_;
+  // true while update() integrates the streamed velocities instead of sampling the trajectory
+  bool rt_streaming_velocity_ = false;
+  // velocities of the latest streamed point and the time it applies from
+  std::vector<double> rt_stream_velocities_;
+  int64_t rt_stream_stamp_ns_ = 0;
+  // Ring of streamed velocities in shared memory, see shm_ingress parameters
+  std::unique_ptr<shm_command_ingress::ShmCommandRing> shm_ingress_;
+  // velocities read from the ring, taken if they are finite
+  std::vector<double> rt_shm_velocities_;
+  int64_t rt_shm_stamp_ns_ = 0;
+
+  // Trajectory files of the topic, see trajectory_file parameters
+  rclcpp::Subscription<std_msgs::msg::String>::SharedPtr file_trajectory_subscriber_ = nullptr;
+  // Latest opened file for update(), nullptr to stop following it
+  HandoffBuffer<std::shared_ptr<MappedTrajectory>> file_trajectory_buffer_;
+  // File taken by update(), and whether update() samples it instead of the trajectory
+  std::shared_ptr<MappedTrajectory> rt_file_trajectory_;
+  bool rt_following_file_ = false;
+  // time of the next sample of the file, advanced with the speed scaling factor
+  int64_t rt_file_time_ns_ = 0;
+  // Latest opened file for file_prefetch_monitor_
+  std::shared_ptr<MappedTrajectory> file_trajectory_;
+  std::mutex file_trajectory_mutex_;
+  /// Files dropped by update(), released by goal_monitor_ so that update() never unmaps them
+  ReclaimQueue<MappedTrajectory> rt_released_file_trajectories_;
+
   // Timeout to consider commands old
   double cmd_timeout_;
-  // True if holding position or repeating last trajectory point in case of success
-  realtime_tools::RealtimeBuffer<bool> rt_is_holding_;
+  // True if holding position or repeating last trajectory point in case of success, written by
+  // the non-RT callbacks and update()
+  CacheLineAligned<std::atomic<bool>> rt_is_holding_{false};
+  // rt_is_holding_ as read at the start of update() and changed by it, only used by update()
+  bool rt_holding_ = false;
+  // True while the reference interfaces violate the state tolerances in chained mode
+  bool rt_reference_violates_tolerance_ = false;
   // TODO(karsten1987): eventually activate and deactivate subscriber directly when its supported
   bool subscriber_is_active_ = false;
+  // time of the last update, the current time of the subscriber and action callbacks
+  update_time_source::UpdateTimeSource update_time_;
+  // logger of update(), whose messages are output by a non-realtime thread
+  std::unique_ptr<realtime_logging::RealtimeLogger> rt_logger_;
   rclcpp::Subscription<trajectory_msgs::msg::JointTrajectory>::SharedPtr joint_command_subscriber_ =
     nullptr;
+  // decodes the serialized msgs of the subscriber, nullptr unless 'serialized_trajectory_intake'
+  std::unique_ptr<TrajectoryCdrDecoder> trajectory_decoder_;
+  // positions of the joints missing in partial goals, reused by serialized_topic_callback()
+  std::vector<double> partial_goal_positions_;
+  /// Positions held by the joints missing in partial goals, the last commands or else the states,
+  /// written by update() as the callbacks must not read the interfaces it uses
+  TripleBuffer<std::vector<double>> rt_hold_positions_;
+  std::mutex hold_positions_mutex_;
 
   rclcpp::Service<control_msgs::srv::QueryTrajectoryState>::SharedPtr query_state_srv_;
 
   std::shared_ptr<Trajectory> traj_external_point_ptr_ = nullptr;
-  realtime_tools::RealtimeBuffer<std::shared_ptr<trajectory_msgs::msg::JointTrajectory>>
-    traj_msg_external_point_ptr_;
-
+  /// Latest trajectory msg for update(), which replaces it to hold the position or start a queued
+  /// goal
+  using TrajectoryMsgBuffer = HandoffBuffer<std::shared_ptr<trajectory_msgs::msg::JointTrajectory>>;
+  TrajectoryMsgBuffer traj_msg_external_point_ptr_;
+  /// Copy of the trajectory of update(), numbered to tell the trajectories apart
+  struct TrajectorySnapshot
+  {
+    Trajectory trajectory;
+    uint64_t generation = 0;
+  };
+  /// Copies of traj_external_point_ptr_ made by update() when it starts sampling a new msg
+  TripleBuffer<TrajectorySnapshot> rt_trajectory_snapshots_;
+  /// Incremented by update() for every new trajectory it samples
+  uint64_t rt_trajectory_generation_ = 0;
+  /// Latest of rt_trajectory_snapshots_ for the non-RT side, see get_trajectory_snapshot()
+  std::shared_ptr<const Trajectory> trajectory_snapshot_;
+  uint64_t trajectory_snapshot_generation_ = 0;
+  std::mutex trajectory_snapshot_mutex_;
+
+  /// Msgs dropped by update(), released by goal_monitor_ so that update() never frees them
+  ReclaimQueue<trajectory_msgs::msg::JointTrajectory> rt_released_msgs_;
+
+  // Template of the hold position msg, not changed after configuration
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> hold_position_msg_ptr_ = nullptr;
+  // Preallocated hold position msgs for update(), used alternately
+  std::array<std::shared_ptr<trajectory_msgs::msg::JointTrajectory>, 2> rt_hold_position_msgs_;
+  size_t rt_hold_position_msg_index_ = 0;
 
   using ControllerStateMsg = control_msgs::msg::JointTrajectoryControllerState;
-  using StatePublisher = realtime_tools::RealtimePublisher<ControllerStateMsg>;
+  using StatePublisher = publisher_pool::RealtimePublisher<ControllerStateMsg>;
   using StatePublisherPtr = std::unique_ptr<StatePublisher>;
   rclcpp::Publisher<ControllerStateMsg>::SharedPtr publisher_;
   StatePublisherPtr state_publisher_;
+  /// Controller state of fixed size and the names of its joints, if bounded_controller_state.enable
+  using BoundedStateMsg =
+    bounded_controller_state_msgs::msg::BoundedJointTrajectoryControllerState;
+  std::unique_ptr<publisher_pool::LoanedPublisher<BoundedStateMsg>> bounded_state_publisher_;
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr bounded_state_names_publisher_;
+  /// Minimum time between two published controller states, with the telemetry rate policy of
+  /// the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> state_publish_rate_;
 
   using FollowJTrajAction = control_msgs::action::FollowJointTrajectory;
   using RealtimeGoalHandle = realtime_tools::RealtimeServerGoalHandle<FollowJTrajAction>;
   using RealtimeGoalHandlePtr = std::shared_ptr<RealtimeGoalHandle>;
-  using RealtimeGoalHandleBuffer = realtime_tools::RealtimeBuffer<RealtimeGoalHandlePtr>;
+  using RealtimeGoalHandleBuffer = HandoffBuffer<RealtimeGoalHandlePtr>;
 
   rclcpp_action::Server<FollowJTrajAction>::SharedPtr action_server_;
   RealtimeGoalHandleBuffer rt_active_goal_;  ///< Currently active action goal, if any.
-  realtime_tools::RealtimeBuffer<bool> rt_has_pending_goal_;  ///< Is there a pending action goal?
-  rclcpp::TimerBase::SharedPtr goal_handle_timer_;
+  CacheLineAligned<std::atomic<bool>> rt_has_pending_goal_{false};  ///< Is there a pending goal?
+  /// Terminal goal states requested by update(), processed by the non-RT action side. The goals
+  /// of several joint groups might finish within one period of goal_monitor_
+  GoalStateChannel<RealtimeGoalHandlePtr, 16, TrackingStatistics> goal_state_channel_;
+  std::mutex goal_state_consumer_mutex_;
+  /// Tracking errors of the trajectory of the active goal, see goal_tracking_statistics
+  TrackingStatistics rt_tracking_statistics_;
+  /// Statistics of the goal state request processed last, accessed by the non-RT action side only
+  TrackingStatistics finished_goal_statistics_;
+  /// Goal finished by update() which might still be in rt_active_goal_, accessed from RT only
+  const RealtimeGoalHandle * rt_finished_goal_ = nullptr;
+  /// Finished goal whose request didn't fit into goal_state_channel_, pushed again by the next
+  /// updates, accessed from RT only
+  RealtimeGoalHandlePtr rt_unpushed_goal_;
+  int32_t rt_unpushed_error_code_ = 0;
+  /// Last accepted goal, whose feedback and result are sent by goal_monitor_
+  RealtimeGoalHandlePtr monitored_goal_;
+  std::mutex monitored_goal_mutex_;
   rclcpp::Duration action_monitor_period_ = rclcpp::Duration(50ms);
+  /// Minimum time between two action feedback messages, zero to send feedback every cycle
+  rclcpp::Duration action_feedback_period_ = rclcpp::Duration::from_nanoseconds(0);
+  rclcpp::Time previous_feedback_timestamp_{0, 0, RCL_CLOCK_UNINITIALIZED};
+  /// Results of the goals canceled or preempted by the non-RT side
+  object_pool::ObjectPool<FollowJTrajAction::Result> result_pool_{8};
+
+  /// Joints with their own action server and goals, see joint_groups
+  struct JointGroup
+  {
+    // not changed after configuration
+    std::string name;
+    std::vector<size_t> joint_indices;
+    std::vector<std::string> joint_names;
+    rclcpp_action::Server<FollowJTrajAction>::SharedPtr action_server;
+    // guarded by joint_groups_mutex_
+    RealtimeGoalHandlePtr goal;
+    // last accepted goal, whose feedback and result are sent by goal_monitor_
+    RealtimeGoalHandlePtr monitored_goal;
+    // trajectory time of the last point of the goal, in the timeline of the written msg
+    int64_t end_time_ns = 0;
+    double goal_time_tolerance = 0.0;
+  };
+  std::vector<JointGroup> joint_groups_;
+  std::mutex joint_groups_mutex_;
+  /// Tolerances of the msgs of the groups, of its goal for the joints of each group. Guarded by
+  /// joint_groups_mutex_, as well as the last msg of the groups and the generation of the
+  /// trajectory snapshot when it was written
+  SegmentTolerances group_tolerances_;
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> group_msg_;
+  uint64_t group_msg_generation_ = 0;
+
+  /// Goals of the joint groups for one trajectory msg, prepared outside of update()
+  struct GroupGoals
+  {
+    // msg the goals belong to, only compared with the msg taken by update()
+    const trajectory_msgs::msg::JointTrajectory * msg = nullptr;
+    // by the index of the group in joint_groups_, nullptr for groups without a goal
+    std::vector<RealtimeGoalHandlePtr> goals;
+    std::vector<int64_t> end_times_ns;
+    std::vector<double> goal_time_tolerances;
+  };
+  /// written right before the msg of traj_msg_external_point_ptr_ it belongs to
+  HandoffBuffer<std::shared_ptr<const GroupGoals>> rt_group_goals_;
+  /// Goals checked by update(), nullptr if the trajectory it samples has none
+  std::shared_ptr<const GroupGoals> rt_active_group_goals_;
+  /// Goal of every group finished by update(), accessed from RT only
+  std::vector<const RealtimeGoalHandle *> rt_finished_group_goals_;
+  /// Finished goal of every group whose request didn't fit into goal_state_channel_, see
+  /// rt_unpushed_goal_
+  std::vector<RealtimeGoalHandlePtr> rt_unpushed_group_goals_;
+  std::vector<int32_t> rt_unpushed_group_error_codes_;
+  /// Groups whose goal update() aborted, their joints stay at rt_group_hold_positions_ until the
+  /// non-RT side replaced the trajectory of the group
+  std::vector<bool> rt_group_holding_;
+  std::vector<double> rt_group_hold_positions_;
+  /// Goals dropped by update(), released by goal_monitor_ so that update() never frees them
+  ReclaimQueue<const GroupGoals> rt_released_group_goals_;
 
   // callback for topic interface
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void topic_callback(const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg);
+  // callback for the topic interface with 'serialized_trajectory_intake'
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void serialized_topic_callback(const std::shared_ptr<const rclcpp::SerializedMessage> msg);
+  // handles a msg of the topic interface after recording it
+  void process_trajectory_msg(const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg);
 
   // callbacks for action_server_
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
@@ -221,41 +466,347 @@ protected:
   void goal_accepted_callback(
     std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle);
 
+  // callbacks for the action servers of joint_groups_, by the index of the group
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  rclcpp_action::GoalResponse group_goal_received_callback(
+    size_t group_index, const rclcpp_action::GoalUUID & uuid,
+    std::shared_ptr<const FollowJTrajAction::Goal> goal);
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  rclcpp_action::CancelResponse group_goal_cancelled_callback(
+    size_t group_index,
+    const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle);
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void group_goal_accepted_callback(
+    size_t group_index,
+    std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle);
+
   // fill trajectory_msg so it matches joints controlled by this controller
   // positions set to current position, velocities, accelerations and efforts to 0.0
+  // called from the non-RT callbacks, so update() gets a trajectory ready to be sampled
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
-  void fill_partial_goal(
-    std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg) const;
-  // sorts the joints of the incoming message to our local order
+  void fill_partial_goal(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg);
+  /// Write the positions of rt_hold_positions_, realtime-safe
+  void publish_hold_positions();
+  /// Copy the latest positions of rt_hold_positions_ into \p positions, for the non-RT callbacks
+  void get_hold_positions(std::vector<double> & positions);
+  // sorts the joints of the incoming message to our local order, not realtime-safe
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void sort_to_local_joint_order(
     std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg);
+  // a trajectory for a goal of \p group has to move joints of the group only
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool validate_trajectory_msg(
+    const trajectory_msgs::msg::JointTrajectory & trajectory,
+    const JointGroup * group = nullptr) const;
+  // true for single-point msgs with velocities of all joints only, if velocity streaming is enabled
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
-  bool validate_trajectory_msg(const trajectory_msgs::msg::JointTrajectory & trajectory) const;
+  bool is_velocity_stream_point(const trajectory_msgs::msg::JointTrajectory & trajectory) const;
+  // returns the trajectory from the still pending points of the current trajectory up to the start
+  // of traj_msg, followed by the points of traj_msg. Returns traj_msg if nothing is kept.
+  // traj_msg has to be in local joint order already, not realtime-safe
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> splice_trajectory_msg(
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg) const;
+  // the trajectory is checked against goal_tolerances, if not nullptr, or against the default
+  // tolerances of the parameters otherwise. Not realtime-safe
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void add_new_trajectory_msg(
-    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg);
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg,
+    const SegmentTolerances * goal_tolerances = nullptr);
+  // integrates the missing points of traj_msg for sampling, not realtime-safe
+  void prepare_trajectory_msg(trajectory_msgs::msg::JointTrajectory & traj_msg) const;
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool validate_trajectory_point_field(
     size_t joint_names_size, const std::vector<double> & vector_field,
     const std::string & string_for_vector_field, size_t i, bool allow_empty) const;
 
   SegmentTolerances default_tolerances_;
+  // default_tolerances_ rearranged for checking all joints in one sweep
+  StateToleranceArrays state_tolerance_arrays_;
+  StateToleranceArrays goal_state_tolerance_arrays_;
+
+  // tolerances of a trajectory msg, prepared by add_new_trajectory_msg() outside of update()
+  struct TrajectoryTolerances
+  {
+    // msg the tolerances belong to, only compared with the msg taken by update()
+    const trajectory_msgs::msg::JointTrajectory * msg = nullptr;
+    // false if the default tolerances apply, the other members are not used then
+    bool from_goal = false;
+    SegmentTolerances tolerances;
+    StateToleranceArrays state_tolerance_arrays;
+    StateToleranceArrays goal_state_tolerance_arrays;
+  };
+  // written right before the msg of traj_msg_external_point_ptr_ it belongs to
+  HandoffBuffer<TrajectoryTolerances> rt_trajectory_tolerances_;
+  // tolerances checked by update(), preallocated for all joints, so that switching them only copies
+  TrajectoryTolerances active_tolerances_;
+  // tolerances of traj_msg as taken by update(), see add_new_trajectory_msg(), not realtime-safe
+  TrajectoryTolerances make_trajectory_tolerances(
+    const trajectory_msgs::msg::JointTrajectory & traj_msg,
+    const SegmentTolerances * goal_tolerances) const;
+
+  // compact storage of a trajectory msg, built by add_new_trajectory_msg() outside of update()
+  struct TrajectoryStorage
+  {
+    // msg the storage belongs to, only compared with the msg taken by update()
+    const trajectory_msgs::msg::JointTrajectory * msg = nullptr;
+    std::shared_ptr<const CompactTrajectoryStorage> storage;
+  };
+  // written right before the msg of traj_msg_external_point_ptr_ it belongs to, if
+  // trajectory_storage isn't "msg"
+  HandoffBuffer<TrajectoryStorage> rt_trajectory_storage_;
+  // msg of traj_external_point_ptr_ whose storage update() took
+  const trajectory_msgs::msg::JointTrajectory * rt_storage_msg_ = nullptr;
+  /// Storages dropped by update(), released by goal_monitor_ so that update() never frees them
+  ReclaimQueue<const CompactTrajectoryStorage> rt_released_storages_;
+  // set on configuration from trajectory_storage
+  bool use_compact_storage_ = false;
+  CompactValueType compact_value_type_ = CompactValueType::FLOAT64;
+  // compact storage of traj_msg, not realtime-safe
+  TrajectoryStorage make_trajectory_storage(
+    const trajectory_msgs::msg::JointTrajectory & traj_msg) const;
+
+  /// State of a queued goal, leaves QUEUED once, either by update() or by the non-RT side
+  enum class QueuedGoalState : uint8_t
+  {
+    QUEUED,
+    STARTED_FROM_RT,
+    TAKEN_FROM_NON_RT
+  };
+  /// Goal accepted while another goal is active, started by update() once that one succeeded
+  struct QueuedGoal
+  {
+    RealtimeGoalHandlePtr goal;
+    // prepared like the msgs of add_new_trajectory_msg()
+    std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg;
+    TrajectoryTolerances tolerances;
+    TrajectoryStorage storage;
+    std::atomic<QueuedGoalState> state{QueuedGoalState::QUEUED};
+  };
+  /// Goal following the active goal, if queue_goals is set. Guarded by queued_goal_mutex_
+  std::shared_ptr<QueuedGoal> queued_goal_;
+  std::mutex queued_goal_mutex_;
+  /// queued_goal_ for update()
+  HandoffBuffer<std::shared_ptr<QueuedGoal>> rt_queued_goal_;
+  /// Queued goal started by update(), which is active for update() as long as the non-RT side
+  /// didn't replace rt_queued_goal_predecessor_ in rt_active_goal_
+  std::shared_ptr<QueuedGoal> rt_started_queued_goal_;
+  const RealtimeGoalHandle * rt_queued_goal_predecessor_ = nullptr;
+  /// Started queued goals dropped by update(), released by goal_monitor_
+  ReclaimQueue<QueuedGoal> rt_released_queued_goals_;
+
+  // parameters used by update() that change at runtime, prepared on the parameter callback thread
+  struct RuntimeParameters
+  {
+    uint64_t version = 0;
+    SegmentTolerances tolerances;
+    StateToleranceArrays state_tolerance_arrays;
+    StateToleranceArrays goal_state_tolerance_arrays;
+    std::vector<pid_bank::PidBank::Gains> gains;
+    std::vector<double> ff_velocity_scale;
+  };
+  realtime_tools::RealtimeBuffer<RuntimeParameters> runtime_parameters_;
+  std::atomic<uint64_t> runtime_parameters_version_{0};
+  // version of the runtime parameters used by update()
+  uint64_t applied_runtime_parameters_version_ = 0;
+  // dynamic parameters of the topic and action callbacks, updated by the parameter callback
+  std::atomic<bool> allow_partial_joints_goal_{false};
+  std::atomic<bool> splice_incoming_trajectories_{false};
+  std::atomic<bool> allow_integration_in_goal_trajectories_{false};
+  std::atomic<bool> allow_nonzero_velocity_at_trajectory_end_{false};
+  std::atomic<bool> queue_goals_{false};
+
+  // declared last, so the threads are stopped before the members they use are destroyed
+  goal_monitor::GoalMonitor goal_monitor_;
+  goal_monitor::GoalMonitor look_ahead_monitor_;
+  goal_monitor::GoalMonitor file_prefetch_monitor_;
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void preempt_active_goal();
 
+  // override methods from ChainableControllerInterface
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
+  /** @brief set \p desired to the reference interfaces written by the preceding controller,
+   * realtime-safe
+   *
+   * The velocity is zero if its reference is NaN.
+   * \return false if any position reference is NaN, \p desired is not changed then.
+   */
+  bool read_desired_state_from_reference_interfaces(
+    trajectory_msgs::msg::JointTrajectoryPoint & desired) const;
+
+  /** @brief request to finish the goal with the given result code, realtime-safe
+   *
+   * The goal is considered inactive by update() from now on, its result is sent by
+   * process_goal_state_requests().
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void finish_goal_from_rt(const RealtimeGoalHandlePtr & goal, int32_t error_code);
+
+  /** @brief push the goal state requests which didn't fit into goal_state_channel_ before again,
+   * realtime-safe
+   */
+  void push_unpushed_goal_states_from_rt();
+
+  /** @brief push the request of rt_unpushed_goal_ again, realtime-safe
+   * \return false if it still didn't fit into goal_state_channel_.
+   */
+  bool push_unpushed_goal_state_from_rt();
+
+  /** @brief make the accepted goal the active one, not realtime-safe
+   */
+  void activate_goal(const RealtimeGoalHandlePtr & goal);
+
+  /** @brief queue the goal to follow the active goal, not realtime-safe
+   *
+   * A goal queued before is canceled, unless update() started it already. If the active goal
+   * finished meanwhile, the goal is started right away.
+   */
+  void queue_goal(
+    const RealtimeGoalHandlePtr & goal,
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg,
+    const SegmentTolerances & goal_tolerances);
+
+  /** @brief start the prepared goal as the active one, not realtime-safe
+   */
+  void start_goal_from_non_rt(const QueuedGoal & queued_goal);
+
+  /** @brief start the queued goal right after \p finished_goal succeeded, realtime-safe
+   *
+   * \return false if there is no queued goal or if the non-RT side starts it.
+   */
+  bool start_queued_goal_from_rt(const RealtimeGoalHandlePtr & finished_goal);
+
+  /** @brief cancel the queued goal with the given result, not realtime-safe
+   *
+   * queued_goal_mutex_ has to be locked.
+   * \return false if update() started the queued goal already, it is not canceled then.
+   */
+  bool try_cancel_queued_goal(int32_t error_code, const std::string & reason);
+
+  /** @brief cancel the queued goal with the given result, not realtime-safe
+   *
+   * If update() started the queued goal already, it is made the active goal instead.
+   */
+  void cancel_queued_goal(int32_t error_code, const std::string & reason);
+
+  /** @brief continue with the queued goal after the active goal finished, not realtime-safe
+   *
+   * The queued goal is started if \p succeeded, unless update() started it already, and canceled
+   * otherwise. queued_goal_mutex_ has to be locked.
+   */
+  void continue_with_queued_goal(bool succeeded);
+
+  /** @brief finish the goals requested by update() and send their results, not realtime-safe
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void process_goal_state_requests();
+
+  /** @brief send the feedback and the results of the goals, run by goal_monitor_
+   */
+  void monitor_goals();
+
+  /** @brief write the trajectory in which the joints of a group follow \p group_msg, not
+   * realtime-safe
+   *
+   * The joints of \p group_msg are \p moved_joint_indices, the other joints of the group stop.
+   * Without \p group_msg, they stop at their current positions. The joints of the other groups
+   * continue the current trajectory, unless \p hold_other_joints is set.
+   * joint_groups_mutex_ has to be locked.
+   */
+  void write_group_trajectory(
+    size_t group_index, const trajectory_msgs::msg::JointTrajectory * group_msg,
+    const std::vector<size_t> & moved_joint_indices, bool hold_other_joints);
+
+  /** @brief cancel the goals of all groups, before another trajectory is written, not
+   * realtime-safe
+   */
+  void preempt_group_goals(const std::string & reason);
+
+  /** @brief remove a goal finished by update() from its group, not realtime-safe
+   *
+   * The joints of the group stop at their current positions if it failed.
+   * \return false if \p goal isn't a goal of a group.
+   */
+  bool finish_group_goal(const RealtimeGoalHandlePtr & goal, bool succeeded);
+
+  /** @brief take the goals of the groups written with the trajectory update() samples,
+   * realtime-safe
+   */
+  void update_active_group_goals();
+
+  /** @brief check the active goals of the groups against their tolerances, realtime-safe
+   *
+   * \return true if a goal was aborted, its joints stop at their current positions then.
+   */
+  bool check_group_goals(const rclcpp::Time & time, bool first_sample);
+
+  /** @brief the joints of the groups whose goals were aborted stop, realtime-safe
+   */
+  void hold_aborted_groups_from_rt();
+
+  /** @brief request to finish the goal of a group with the given result code, realtime-safe
+   */
+  void finish_group_goal_from_rt(size_t group_index, int32_t error_code);
+
+  /** @brief check the next samples of the trajectory against the look-ahead limits, run by
+   * look_ahead_monitor_
+   *
+   * The first violation is signaled to update(), which decelerates the trajectory before it.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void check_look_ahead();
+
+  /** @brief start or continue the deceleration before a violation found by check_look_ahead(),
+   * realtime-safe
+   */
+  void update_look_ahead_scaling(const rclcpp::Duration & period);
+
+  /** @brief write the next samples of the active trajectory from traj_time_ on to horizon_slot_,
+   * or a horizon without samples if \p has_trajectory is false, realtime-safe
+   */
+  void export_trajectory_horizon(const rclcpp::Time & time, bool has_trajectory);
+
+  /** @brief integrate the streamed velocities to state_desired_, realtime-safe
+   *
+   * \param take_shm_points whether the latest velocities of shm_ingress_ are taken as a streamed
+   * point applying at \p time, false while an action goal is active
+   * \return true while streaming, i.e., since the first streamed point until update() takes a
+   * new trajectory msg.
+   */
+  bool update_velocity_stream(
+    const rclcpp::Time & time, const rclcpp::Duration & period, bool take_shm_points);
+
+  /** @brief start or stop following the latest trajectory file of the topic, realtime-safe
+   */
+  void take_file_trajectory();
+
+  /** @brief sample the followed trajectory file into state_desired_ and command it,
+   * realtime-safe
+   */
+  void update_file_trajectory(const rclcpp::Duration & period);
+
+  /** @brief open the trajectory file of \p msg, or stop following the file if it is empty
+   */
+  void file_trajectory_callback(const std::shared_ptr<std_msgs::msg::String> msg);
+
   /** @brief set the current position with zero velocity and acceleration as new command
+   *
+   * returns a new msg to be added with add_new_trajectory_msg(), not realtime-safe
    */
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> set_hold_position();
 
-  /** @brief set last trajectory point to be repeated at success
+  /** @brief switch update() to hold the current position, realtime-safe
    *
+   * @param repeat_last_point if true, the last trajectory point is repeated instead (at success),
    * no matter if it has nonzero velocity or acceleration
    */
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
-  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> set_success_trajectory_point();
+  void switch_to_hold_from_rt(bool repeat_last_point);
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool reset();
@@ -268,6 +819,10 @@ protected:
   void publish_state(
     const rclcpp::Time & time, const JointTrajectoryPoint & desired_state,
     const JointTrajectoryPoint & current_state, const JointTrajectoryPoint & state_error);
+  /// Publish the state in bounded_state_publisher_, loaned from the middleware if possible
+  void publish_bounded_state(
+    const rclcpp::Time & time, const JointTrajectoryPoint & desired_state,
+    const JointTrajectoryPoint & current_state, const JointTrajectoryPoint & state_error);
 
   void read_state_from_state_interfaces(JointTrajectoryPoint & state);
 
@@ -284,8 +839,52 @@ protected:
     const std::shared_ptr<control_msgs::srv::QueryTrajectoryState::Request> request,
     std::shared_ptr<control_msgs::srv::QueryTrajectoryState::Response> response);
 
+  /// Immutable copy of the trajectory update() samples, nullptr before its first sample
+  /**
+   * Not realtime-safe. The copy can be sampled with Trajectory::sample_at() from any thread
+   * without locking, e.g., for queries, look-ahead checks or visualization.
+   *
+   * \param[out] generation Number of the trajectory, if not nullptr. It increases with every new
+   * trajectory update() samples.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<const Trajectory> get_trajectory_snapshot(uint64_t * generation = nullptr);
+
+  /// Update times published on the statistics topic, nullptr if 'update_statistics.enable' is off
+  std::unique_ptr<update_time_statistics::UpdateTimeStatistics> update_time_statistics_;
+  /// Decimates the state publishing and the action feedback under load, nullptr if
+  /// 'cycle_budget.enable' is off
+  std::unique_ptr<update_time_statistics::CycleBudget> cycle_budget_;
+
+  /// Log of the msgs, goals and interface values, nullptr if 'recording.enable' is off
+  std::unique_ptr<TrajectoryRecorder> trajectory_recorder_;
+
 private:
-  void update_pids();
+  /// Resolve the runtime parameters of update() from \p params, not realtime-safe
+  RuntimeParameters make_runtime_parameters(const Params & params);
+  /// Use the newest runtime parameters if they are not used yet, realtime-safe
+  void update_runtime_parameters();
+  /// Check the active trajectory against its goal tolerances, or the defaults, realtime-safe
+  void update_active_tolerances();
+  /// Sample the active trajectory from its compact storage once it is written, realtime-safe
+  void update_compact_storage();
+  /// Check the active trajectory against the default tolerances, realtime-safe
+  void set_default_tolerances_active();
+  void store_dynamic_parameters(const Params & params);
+  /// Prepare everything allocated by on_activate() for the activation in hot standby
+  void prepare_hot_standby();
+  /// Start the threads of goal_monitor_, look_ahead_monitor_ and file_prefetch_monitor_, not
+  /// realtime-safe
+  void start_monitors();
+  /// Touch the buffers used by update(), so its first cycles don't page fault, not realtime-safe
+  void prefault_rt_buffers();
+  /// Drop the trajectory snapshots of the previous activation
+  void drop_trajectory_snapshots();
+
+  /// True if \p period passed since \p previous_timestamp, which is advanced then.
+  /// Always true for a zero \p period.
+  static bool is_period_elapsed(
+    const rclcpp::Time & time, const rclcpp::Duration & period, rclcpp::Time & previous_timestamp);
 
   bool contains_interface_type(
     const std::vector<std::string> & interface_type_list, const std::string & interface_type);
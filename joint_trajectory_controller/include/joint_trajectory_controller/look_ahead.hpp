@@ -0,0 +1,93 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__LOOK_AHEAD_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__LOOK_AHEAD_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "joint_trajectory_controller_parameters.hpp"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Limits of the look-ahead check, stored as one contiguous array per variable.
+ *
+ * Limits which are not set are stored as infinity, so that all joints can be checked with the
+ * same branch-free comparison.
+ */
+struct LookAheadLimits
+{
+  std::vector<double> min_position;
+  std::vector<double> max_position;
+  std::vector<double> max_velocity;
+};
+
+/**
+ * \param params The ROS Parameters
+ * \return The limits of the ``look_ahead`` parameters of all joints.
+ */
+inline LookAheadLimits get_look_ahead_limits(const Params & params)
+{
+  constexpr double INF = std::numeric_limits<double>::infinity();
+  auto or_infinity = [](double limit, double infinity)
+  { return std::isfinite(limit) ? limit : infinity; };
+
+  LookAheadLimits limits;
+  for (const auto & joint : params.joints)
+  {
+    const auto & joint_limits = params.look_ahead.joints_map.at(joint);
+    limits.min_position.push_back(or_infinity(joint_limits.min_position, -INF));
+    limits.max_position.push_back(or_infinity(joint_limits.max_position, INF));
+    limits.max_velocity.push_back(or_infinity(std::abs(joint_limits.max_velocity), INF));
+  }
+  return limits;
+}
+
+/**
+ * \brief Find the first sample of a trajectory outside of the limits of any joint.
+ *
+ * \param samples Samples of the trajectory, e.g., of Trajectory::sample_range().
+ * \param limits Limits of all joints, its arrays have at least the size of the samples.
+ * \return Index of the first sample violating the limits, or the number of samples if there is
+ * none.
+ */
+inline size_t find_look_ahead_violation(
+  const TrajectorySamples & samples, const LookAheadLimits & limits)
+{
+  for (size_t k = 0; k < samples.num_samples; ++k)
+  {
+    const double * positions = samples.positions.data() + k * samples.dim;
+    const double * velocities = samples.velocities.data() + k * samples.dim;
+    bool violated = false;
+    for (size_t i = 0; i < samples.dim; ++i)
+    {
+      violated |= positions[i] < limits.min_position[i] || positions[i] > limits.max_position[i] ||
+                  std::abs(velocities[i]) > limits.max_velocity[i];
+    }
+    if (violated)
+    {
+      return k;
+    }
+  }
+  return samples.num_samples;
+}
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__LOOK_AHEAD_HPP_
@@ -0,0 +1,150 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__MAPPED_TRAJECTORY_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__MAPPED_TRAJECTORY_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Trajectory file mapped into memory, sampled by the realtime loop without copying it.
+ *
+ * Trajectories with millions of points, e.g., of machining jobs, don't fit into one
+ * trajectory_msgs/msg/JointTrajectory. A trajectory file stores their points as structure of
+ * arrays: the times from start of all points, followed by the positions of each joint, and
+ * optionally the velocities and the accelerations of each joint. The file is mapped read-only,
+ * so only the pages around the sampled segment have to be in memory. prefetch() loads the pages
+ * ahead of the realtime loop from another thread, so that sample() doesn't wait for the disk.
+ *
+ * The file starts with the magic "JTCTRAJ", a uint32 version, a uint32 with the fields (bit 0:
+ * velocities, bit 1: accelerations), the uint64 number of points, the uint64 offset of the arrays
+ * and the joint names (uint32 count, then uint32 length and characters of each name). The arrays
+ * start at a multiple of 64 bytes with int64 times in nanoseconds, followed by the double arrays
+ * of the joints. The values are stored in the byte order of the writing machine, see
+ * write_mapped_trajectory().
+ */
+class MappedTrajectory
+{
+public:
+  MappedTrajectory() = default;
+  ~MappedTrajectory() { close(); }
+
+  MappedTrajectory(const MappedTrajectory &) = delete;
+  MappedTrajectory & operator=(const MappedTrajectory &) = delete;
+
+  /// Map the trajectory file at \p path, not realtime-safe
+  /**
+   * \return false with the reason in \p error if the file can't be mapped or isn't a trajectory
+   * file of this version with increasing times
+   */
+  bool open(const std::string & path, std::string & error);
+
+  /// Unmap the file, not realtime-safe
+  void close();
+
+  const std::vector<std::string> & get_joint_names() const { return joint_names_; }
+
+  size_t size() const { return num_points_; }
+
+  bool has_velocities() const { return velocities_ != nullptr; }
+
+  bool has_accelerations() const { return accelerations_ != nullptr; }
+
+  /// Time from start of the last point
+  int64_t get_duration_ns() const { return num_points_ > 0 ? times_ns_[num_points_ - 1] : 0; }
+
+  /// Sample the joints in the order of \p joint_names, and preallocate the sampling, not
+  /// realtime-safe
+  /**
+   * \return false with the reason in \p error if the joints of the file are different
+   */
+  bool set_joint_order(const std::vector<std::string> & joint_names, std::string & error);
+
+  /// Start sampling from \p start_state at time 0 towards the first point, realtime-safe
+  void start(const trajectory_msgs::msg::JointTrajectoryPoint & start_state);
+
+  /// Sample the trajectory at \p time_ns after the start into \p output, realtime-safe
+  /**
+   * The segments are interpolated like the ones of Trajectory::interpolate_between_points(),
+   * with the derivatives of the file. The segment cursor only steps forward, and the points after
+   * it are prefetched into the cache.
+   * \return false after the last point, whose state is sampled then
+   */
+  bool sample(int64_t time_ns, trajectory_msgs::msg::JointTrajectoryPoint & output);
+
+  /// Load the pages of the points within \p horizon_ns after the sampled segment, not realtime-safe
+  /**
+   * Can be called by another thread while the realtime loop samples the trajectory.
+   */
+  void prefetch(int64_t horizon_ns);
+
+private:
+  /// Copy point \p index of the file into \p point, in the joint order of set_joint_order()
+  void load_point(size_t index, trajectory_msgs::msg::JointTrajectoryPoint & point) const;
+
+  /// Index of the first point after \p time_ns, searched from \p first
+  size_t find_point_after(size_t first, int64_t time_ns) const;
+
+  /// Advise the kernel to read the bytes [\p begin, \p end) of the mapping, and touch their pages
+  void load_pages(const void * begin, const void * end) const;
+
+  void * mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  std::vector<std::string> joint_names_;
+  size_t num_points_ = 0;
+  const int64_t * times_ns_ = nullptr;
+  const double * positions_ = nullptr;
+  const double * velocities_ = nullptr;
+  const double * accelerations_ = nullptr;
+
+  // index of the joint of the file for each sampled joint
+  std::vector<size_t> joint_mapping_;
+  trajectory_msgs::msg::JointTrajectoryPoint start_state_;
+  trajectory_msgs::msg::JointTrajectoryPoint segment_start_;
+  trajectory_msgs::msg::JointTrajectoryPoint segment_end_;
+  // interpolates the segments, has no msg
+  Trajectory interpolator_;
+  // index of the point ending the sampled segment, 0 for the segment from the start state
+  std::atomic<size_t> segment_end_idx_{0};
+  // segment_start_ and segment_end_ belong to this segment, none before the first sample
+  size_t loaded_segment_end_idx_ = NO_SEGMENT;
+  // end of the points loaded by prefetch(), only used by its thread
+  size_t prefetched_idx_ = 0;
+
+  static constexpr size_t NO_SEGMENT = static_cast<size_t>(-1);
+};
+
+/// Write the points of \p trajectory as a trajectory file, see MappedTrajectory, not realtime-safe
+/**
+ * The velocities or accelerations are written if all points have them.
+ * \return false with the reason in \p error if the file can't be written or the points are
+ * incomplete
+ */
+bool write_mapped_trajectory(
+  const std::string & path, const trajectory_msgs::msg::JointTrajectory & trajectory,
+  std::string & error);
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__MAPPED_TRAJECTORY_HPP_
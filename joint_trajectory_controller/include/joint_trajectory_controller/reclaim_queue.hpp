@@ -0,0 +1,93 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__RECLAIM_QUEUE_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__RECLAIM_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Lock-free single-producer/single-consumer queue deferring the release of shared objects.
+ *
+ * The realtime loop (producer) hands over the references it drops with retain(), so that it never
+ * releases the last reference of, e.g., a trajectory msg and frees its memory. A non-realtime
+ * thread (consumer) drops them with reclaim(). Retaining only copies a shared_ptr into one of the
+ * slots preallocated by resize(), so it doesn't allocate memory.
+ */
+template <typename T>
+class ReclaimQueue
+{
+public:
+  /// Preallocate \p capacity slots, neither realtime-safe nor thread-safe
+  void resize(size_t capacity)
+  {
+    slots_.clear();
+    slots_.resize(capacity);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+  }
+
+  /// Defer the release of \p ptr to reclaim(), only for the producer, realtime-safe
+  /**
+   * \return false if the queue is full, \p ptr is released by the caller then
+   */
+  bool retain(const std::shared_ptr<T> & ptr)
+  {
+    if (!ptr)
+    {
+      return true;
+    }
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (slots_.empty() || head - tail_.load(std::memory_order_acquire) >= slots_.size())
+    {
+      return false;
+    }
+    // the slot was reset by reclaim(), so nothing is released here
+    slots_[head % slots_.size()] = ptr;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Release all retained objects, only for the consumer, not realtime-safe
+  /**
+   * \return number of released references
+   */
+  size_t reclaim()
+  {
+    const size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t num_reclaimed = head - tail;
+    for (; tail != head; ++tail)
+    {
+      slots_[tail % slots_.size()].reset();
+      // free the slot right away, the producer may fill it while the next one is released
+      tail_.store(tail + 1, std::memory_order_release);
+    }
+    return num_reclaimed;
+  }
+
+private:
+  std::vector<std::shared_ptr<T>> slots_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__RECLAIM_QUEUE_HPP_
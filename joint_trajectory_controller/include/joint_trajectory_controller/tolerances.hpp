@@ -30,14 +30,19 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__TOLERANCES_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__TOLERANCES_HPP_
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <iterator>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include "control_msgs/action/follow_joint_trajectory.hpp"
+#include "control_msgs/msg/joint_tolerance.hpp"
 #include "joint_trajectory_controller_parameters.hpp"
 
+#include "rclcpp/duration.hpp"
 #include "rclcpp/node.hpp"
 
 namespace joint_trajectory_controller
@@ -119,6 +124,203 @@ SegmentTolerances get_segment_tolerances(Params const & params)
   return tolerances;
 }
 
+/**
+ * \brief Populate trajectory segment tolerances from the tolerances of a FollowJointTrajectory
+ * goal.
+ *
+ * The tolerances of the goal override \p default_tolerances for the joints they name. As defined
+ * by control_msgs::msg::JointTolerance, a tolerance of zero keeps the default, -1 means that the
+ * tolerance is not enforced and a positive value replaces the default. A zero
+ * goal_time_tolerance of the goal keeps the default too.
+ *
+ * Not realtime-safe, the tolerances are meant to be prepared once when a goal is accepted.
+ *
+ * \param default_tolerances Tolerances of the parameters, see get_segment_tolerances().
+ * \param goal Goal with the path_tolerance, goal_tolerance and goal_time_tolerance to apply.
+ * \param joints Names of the joints, in the order of the tolerances.
+ * \param[out] tolerances Trajectory segment tolerances of the goal.
+ * \return false if a tolerance of the goal is negative other than -1 or names an unknown joint,
+ * \p tolerances is unchanged then.
+ */
+inline bool get_goal_segment_tolerances(
+  const SegmentTolerances & default_tolerances,
+  const control_msgs::action::FollowJointTrajectory::Goal & goal,
+  const std::vector<std::string> & joints, SegmentTolerances & tolerances)
+{
+  const auto logger = rclcpp::get_logger("tolerances");
+  SegmentTolerances goal_tolerances = default_tolerances;
+
+  auto apply = [&](double & tolerance, double goal_tolerance, const std::string & name)
+  {
+    if (goal_tolerance == -1.0)
+    {
+      tolerance = 0.0;
+    }
+    else if (goal_tolerance > 0.0)
+    {
+      tolerance = goal_tolerance;
+    }
+    else if (goal_tolerance != 0.0)
+    {
+      RCLCPP_ERROR(logger, "Invalid tolerance %f of '%s'", goal_tolerance, name.c_str());
+      return false;
+    }
+    return true;
+  };
+  auto apply_joint_tolerances =
+    [&](
+      std::vector<StateTolerances> & state_tolerances,
+      const std::vector<control_msgs::msg::JointTolerance> & joint_tolerances)
+  {
+    for (const auto & joint_tolerance : joint_tolerances)
+    {
+      const auto it = std::find(joints.begin(), joints.end(), joint_tolerance.name);
+      if (it == joints.end())
+      {
+        RCLCPP_ERROR(logger, "Tolerance of unknown joint '%s'", joint_tolerance.name.c_str());
+        return false;
+      }
+      auto & state_tolerance =
+        state_tolerances[static_cast<size_t>(std::distance(joints.begin(), it))];
+      if (
+        !apply(state_tolerance.position, joint_tolerance.position, joint_tolerance.name) ||
+        !apply(state_tolerance.velocity, joint_tolerance.velocity, joint_tolerance.name) ||
+        !apply(state_tolerance.acceleration, joint_tolerance.acceleration, joint_tolerance.name))
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  if (
+    !apply_joint_tolerances(goal_tolerances.state_tolerance, goal.path_tolerance) ||
+    !apply_joint_tolerances(goal_tolerances.goal_state_tolerance, goal.goal_tolerance))
+  {
+    return false;
+  }
+
+  const double goal_time_tolerance = rclcpp::Duration(goal.goal_time_tolerance).seconds();
+  if (goal_time_tolerance < 0.0)
+  {
+    RCLCPP_ERROR(logger, "Invalid goal_time_tolerance %f", goal_time_tolerance);
+    return false;
+  }
+  if (goal_time_tolerance > 0.0)
+  {
+    goal_tolerances.goal_time_tolerance = goal_time_tolerance;
+  }
+
+  tolerances = goal_tolerances;
+  return true;
+}
+
+/**
+ * \brief State tolerances of all joints, stored as one contiguous array per variable.
+ *
+ * Tolerances which are not enforced are stored as infinity, so that all joints can be checked
+ * with the same branch-free comparison.
+ */
+struct StateToleranceArrays
+{
+  std::vector<double> position;
+  std::vector<double> velocity;
+  std::vector<double> acceleration;
+};
+
+/**
+ * \param state_tolerances State tolerances, one per joint.
+ * \return The tolerances of \p state_tolerances rearranged to contiguous arrays.
+ */
+inline StateToleranceArrays to_state_tolerance_arrays(
+  const std::vector<StateTolerances> & state_tolerances)
+{
+  auto enforced_or_infinity = [](double tolerance)
+  { return tolerance > 0.0 ? tolerance : std::numeric_limits<double>::infinity(); };
+
+  StateToleranceArrays arrays;
+  arrays.position.reserve(state_tolerances.size());
+  arrays.velocity.reserve(state_tolerances.size());
+  arrays.acceleration.reserve(state_tolerances.size());
+  for (const auto & state_tolerance : state_tolerances)
+  {
+    arrays.position.push_back(enforced_or_infinity(state_tolerance.position));
+    arrays.velocity.push_back(enforced_or_infinity(state_tolerance.velocity));
+    arrays.acceleration.push_back(enforced_or_infinity(state_tolerance.acceleration));
+  }
+  return arrays;
+}
+
+/**
+ * \brief Check the state error of all joints in one sweep, realtime-safe.
+ *
+ * The loops run over contiguous arrays without branches, so they are vectorized by the compiler.
+ * Empty velocity or acceleration errors are not checked, the same as with
+ * check_state_tolerance_per_joint().
+ *
+ * \param state_error State error to check.
+ * \param state_tolerance Tolerances of all joints, its arrays have at least the size of the
+ * position error.
+ * \return True if \p state_error fulfills \p state_tolerance for all joints.
+ */
+inline bool check_state_tolerance(
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_error,
+  const StateToleranceArrays & state_tolerance)
+{
+  auto is_violated = [](const std::vector<double> & error, const std::vector<double> & tolerance)
+  {
+    assert(tolerance.size() >= error.size());
+    bool violated = false;
+    for (size_t i = 0; i < error.size(); ++i)
+    {
+      violated |= std::abs(error[i]) > tolerance[i];
+    }
+    return violated;
+  };
+
+  return !(
+    is_violated(state_error.positions, state_tolerance.position) ||
+    is_violated(state_error.velocities, state_tolerance.velocity) ||
+    is_violated(state_error.accelerations, state_tolerance.acceleration));
+}
+
+/**
+ * \brief Check the state error of some of the joints, realtime-safe.
+ *
+ * The same as check_state_tolerance(), but only for the joints of \p joint_indices, e.g., the
+ * joints of one joint group.
+ *
+ * \param state_error State error of all joints.
+ * \param state_tolerance Tolerances of all joints.
+ * \param joint_indices Indices of the joints to check in \p state_error.
+ * \return True if \p state_error fulfills \p state_tolerance for all joints of \p joint_indices.
+ */
+inline bool check_state_tolerance_of_joints(
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_error,
+  const StateToleranceArrays & state_tolerance, const std::vector<size_t> & joint_indices)
+{
+  auto is_violated = [&joint_indices](
+                       const std::vector<double> & error, const std::vector<double> & tolerance)
+  {
+    if (error.empty())
+    {
+      return false;
+    }
+    bool violated = false;
+    for (const size_t index : joint_indices)
+    {
+      assert(index < error.size() && index < tolerance.size());
+      violated |= std::abs(error[index]) > tolerance[index];
+    }
+    return violated;
+  };
+
+  return !(
+    is_violated(state_error.positions, state_tolerance.position) ||
+    is_violated(state_error.velocities, state_tolerance.velocity) ||
+    is_violated(state_error.accelerations, state_tolerance.acceleration));
+}
+
 /**
  * \param state_error State error to check.
  * \param joint_idx Joint index for the state error
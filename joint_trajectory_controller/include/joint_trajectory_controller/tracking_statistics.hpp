@@ -0,0 +1,139 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__TRACKING_STATISTICS_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__TRACKING_STATISTICS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief RMS and maximum of the tracking errors of the joints while following a trajectory, and
+ * the maximum time the trajectory fell behind the controller time.
+ *
+ * The errors of every update are accumulated in constant time per joint, independent of the
+ * number of updates. All memory is allocated in configure(), reset() and add() are
+ * realtime-safe, and copies into a configured instance don't allocate either.
+ */
+class TrackingStatistics
+{
+public:
+  void configure(size_t dof)
+  {
+    sum_squared_position_errors_.assign(dof, 0.0);
+    max_position_errors_.assign(dof, 0.0);
+    sum_squared_velocity_errors_.assign(dof, 0.0);
+    max_velocity_errors_.assign(dof, 0.0);
+    reset();
+  }
+
+  /// Start over, e.g., with a new trajectory
+  void reset()
+  {
+    num_updates_ = 0;
+    max_time_lag_ns_ = 0;
+    std::fill(sum_squared_position_errors_.begin(), sum_squared_position_errors_.end(), 0.0);
+    std::fill(max_position_errors_.begin(), max_position_errors_.end(), 0.0);
+    std::fill(sum_squared_velocity_errors_.begin(), sum_squared_velocity_errors_.end(), 0.0);
+    std::fill(max_velocity_errors_.begin(), max_velocity_errors_.end(), 0.0);
+  }
+
+  /**
+   * Add the \p error of one update, in which the trajectory time is \p time_lag_ns behind the
+   * controller time. Missing velocity errors are not accumulated.
+   */
+  void add(const trajectory_msgs::msg::JointTrajectoryPoint & error, int64_t time_lag_ns)
+  {
+    ++num_updates_;
+    max_time_lag_ns_ = std::max(max_time_lag_ns_, time_lag_ns);
+    accumulate(error.positions, sum_squared_position_errors_, max_position_errors_);
+    accumulate(error.velocities, sum_squared_velocity_errors_, max_velocity_errors_);
+  }
+
+  size_t num_updates() const { return num_updates_; }
+  int64_t max_time_lag_ns() const { return max_time_lag_ns_; }
+
+  double rms_position_error(size_t joint) const
+  {
+    return rms(sum_squared_position_errors_[joint]);
+  }
+  double max_position_error(size_t joint) const { return max_position_errors_[joint]; }
+  double rms_velocity_error(size_t joint) const
+  {
+    return rms(sum_squared_velocity_errors_[joint]);
+  }
+  double max_velocity_error(size_t joint) const { return max_velocity_errors_[joint]; }
+
+  /**
+   * "<n> updates, max time lag <lag> s; <joint>: position error rms <rms> max <max>, velocity
+   * error rms <rms> max <max>; ...", not realtime-safe
+   */
+  std::string summary(const std::vector<std::string> & joint_names) const
+  {
+    char text[160];
+    std::snprintf(
+      text, sizeof(text), "%zu updates, max time lag %.4f s", num_updates_,
+      static_cast<double>(max_time_lag_ns_) / 1e9);
+    std::string summary = text;
+    const size_t dof = std::min(joint_names.size(), max_position_errors_.size());
+    for (size_t i = 0; i < dof; ++i)
+    {
+      std::snprintf(
+        text, sizeof(text), ": position error rms %.6g max %.6g, velocity error rms %.6g max %.6g",
+        rms_position_error(i), max_position_error(i), rms_velocity_error(i),
+        max_velocity_error(i));
+      summary += "; " + joint_names[i] + text;
+    }
+    return summary;
+  }
+
+private:
+  static void accumulate(
+    const std::vector<double> & errors, std::vector<double> & sum_squared_errors,
+    std::vector<double> & max_errors)
+  {
+    const size_t dof = std::min(errors.size(), sum_squared_errors.size());
+    for (size_t i = 0; i < dof; ++i)
+    {
+      sum_squared_errors[i] += errors[i] * errors[i];
+      max_errors[i] = std::max(max_errors[i], std::abs(errors[i]));
+    }
+  }
+
+  double rms(double sum_squared_errors) const
+  {
+    return num_updates_ > 0 ? std::sqrt(sum_squared_errors / static_cast<double>(num_updates_))
+                            : 0.0;
+  }
+
+  size_t num_updates_ = 0;
+  int64_t max_time_lag_ns_ = 0;
+  std::vector<double> sum_squared_position_errors_;
+  std::vector<double> max_position_errors_;
+  std::vector<double> sum_squared_velocity_errors_;
+  std::vector<double> max_velocity_errors_;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__TRACKING_STATISTICS_HPP_
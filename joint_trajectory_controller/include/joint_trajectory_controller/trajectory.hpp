@@ -15,9 +15,12 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_HPP_
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <vector>
 
+#include "joint_trajectory_controller/compact_trajectory_storage.hpp"
 #include "joint_trajectory_controller/interpolation_methods.hpp"
 #include "joint_trajectory_controller/visibility_control.h"
 #include "rclcpp/time.hpp"
@@ -29,6 +32,20 @@ using TrajectoryPointIter = std::vector<trajectory_msgs::msg::JointTrajectoryPoi
 using TrajectoryPointConstIter =
   std::vector<trajectory_msgs::msg::JointTrajectoryPoint>::const_iterator;
 
+/// Consecutive samples of a trajectory, every field is stored as [sample * dim + joint]
+struct TrajectorySamples
+{
+  /// Number of valid samples
+  size_t num_samples = 0;
+  /// Number of joints per sample
+  size_t dim = 0;
+  std::vector<double> positions;
+  std::vector<double> velocities;
+  std::vector<double> accelerations;
+  /// Memory of the single samples, reused by repeated calls of Trajectory::sample_range()
+  trajectory_msgs::msg::JointTrajectoryPoint sample_state;
+};
+
 class Trajectory
 {
 public:
@@ -53,9 +70,28 @@ public:
     const rclcpp::Time & current_time,
     const trajectory_msgs::msg::JointTrajectoryPoint & current_point);
 
+  /// Replace the msg, its compact storage is released, see set_compact_storage()
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory);
 
+  /// Sample the segments from \p storage of the msg instead of its points, realtime-safe
+  /**
+   * The storage is ignored if it doesn't have the points of the msg. It replaces the previous
+   * storage, whose memory is freed here unless the caller keeps a reference to it.
+   * The quintic spline and the sampling without interpolation still read the points of the msg.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_compact_storage(std::shared_ptr<const CompactTrajectoryStorage> storage);
+
+  const std::shared_ptr<const CompactTrajectoryStorage> & get_compact_storage() const
+  {
+    return compact_storage_;
+  }
+
+  /// Reserve the sampling storage for \p dim joints, so the first samples don't allocate either
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void reserve(size_t dim);
+
   /// Find the segment (made up of 2 points) and its expected state from the
   /// containing trajectory.
   /**
@@ -91,6 +127,51 @@ public:
     trajectory_msgs::msg::JointTrajectoryPoint & output_state,
     TrajectoryPointConstIter & start_segment_itr, TrajectoryPointConstIter & end_segment_itr);
 
+  /// Read-only version of sample(), e.g., for queries from other threads than the realtime loop
+  /**
+   * Samples like sample(), but changes neither the trajectory nor its caches, so any number of
+   * threads may call it on a trajectory that isn't changed anymore, e.g., a copy of it. The start
+   * time of a msg with zero stamp is \p sample_time until sample() was called.
+   * Missing positions are not deduced from the derivatives, the sampling fails for such segments
+   * unless complete_trajectory_points() or sample() deduced them before.
+   * It allocates memory and is slower than sample(), so don't use it in the realtime loop.
+   *
+   * \param[in] sample_time Time at which trajectory will be sampled.
+   * \param[in] interpolation_method Specify whether splines, another method, or no interpolation at
+   * all.
+   * \param[out] output_state Calculated new at \p sample_time.
+   * \param[out] start_segment_itr Iterator to the start segment, see sample().
+   * \param[out] end_segment_itr Iterator to the end segment, see sample().
+   * \return false in the cases sample() returns false, or if positions of the segment are missing.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool sample_at(
+    const rclcpp::Time & sample_time,
+    const interpolation_methods::InterpolationMethod interpolation_method,
+    trajectory_msgs::msg::JointTrajectoryPoint & output_state,
+    TrajectoryPointConstIter & start_segment_itr, TrajectoryPointConstIter & end_segment_itr) const;
+
+  /// Sample the trajectory at \p num_samples equidistant points in time
+  /**
+   * Same as calling sample() at <tt>start_time + k * period</tt> for every k, meant for offline
+   * tools, simulators and the horizon exported by the controller. Consecutive samples reuse the
+   * segment search and spline coefficients. The memory of \p samples is reused, so repeated calls
+   * on the same buffer don't allocate.
+   *
+   * \param[in] start_time Time of the first sample.
+   * \param[in] period Time between two samples, must not be negative.
+   * \param[in] num_samples Number of samples to take.
+   * \param[in] interpolation_method Specify whether splines, another method, or no interpolation at
+   * all.
+   * \param[out] samples The samples, missing velocities or accelerations are set to zero.
+   * \return Number of valid samples, sampling stops at the first time sample() fails.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  size_t sample_range(
+    const rclcpp::Time & start_time, const rclcpp::Duration & period, const size_t num_samples,
+    const interpolation_methods::InterpolationMethod interpolation_method,
+    TrajectorySamples & samples);
+
   /**
    * Do interpolation between 2 states given a time in between their respective timestamps
    *
@@ -143,10 +224,61 @@ public:
   bool is_sampled_already() const { return sampled_already_; }
 
 private:
-  void deduce_from_derivatives(
-    trajectory_msgs::msg::JointTrajectoryPoint & first_state,
-    trajectory_msgs::msg::JointTrajectoryPoint & second_state, const size_t dim,
-    const double delta_t);
+  /// Interpolate within a segment of the trajectory, reusing its spline coefficients
+  /**
+   * Same as interpolate_between_points(), but the coefficients are computed only once per segment.
+   * \param[in] segment_end_idx Index of the point ending the segment, 0 for the segment between
+   * the state before the trajectory and the first point.
+   * All times are absolute nanoseconds on the timeline of point_times_ns_.
+   * For InterpolationMethod::QUINTIC_SPLINE, the missing derivatives of \p state_a and \p state_b
+   * are completed by complete_knot_state() first.
+   * \pre \p sample_time_ns is between \p time_a_ns and \p time_b_ns.
+   */
+  void interpolate_segment(
+    const size_t segment_end_idx,
+    const interpolation_methods::InterpolationMethod interpolation_method, const int64_t time_a_ns,
+    const trajectory_msgs::msg::JointTrajectoryPoint & state_a, const int64_t time_b_ns,
+    const trajectory_msgs::msg::JointTrajectoryPoint & state_b, const int64_t sample_time_ns,
+    trajectory_msgs::msg::JointTrajectoryPoint & output);
+
+  /// Compute the spline coefficients between \p state_a and \p state_b into \p coefficients
+  /**
+   * Linear and cubic splines are stored as quintic ones with zero high-order coefficients.
+   */
+  static void compute_coefficients(
+    const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
+    const trajectory_msgs::msg::JointTrajectoryPoint & state_b, const double duration_btwn_points,
+    const bool has_velocity, const bool has_accel, std::vector<double> & coefficients);
+
+  /// Evaluate \p coefficients at time \p t after the segment start with Horner's scheme
+  static void evaluate_coefficients(
+    const std::vector<double> & coefficients, const size_t dim, const double t,
+    trajectory_msgs::msg::JointTrajectoryPoint & output);
+
+  /// Completed state of waypoint \p knot_idx for InterpolationMethod::QUINTIC_SPLINE
+  /**
+   * Waypoint 0 is the state before the trajectory, waypoint k > 0 is the point k - 1 of the
+   * message. Missing velocities are estimated as the mean slope of the two adjacent segments, or
+   * zero if the slopes differ in sign or the waypoint is the first or last one. Missing
+   * accelerations are zero.
+   * \param[in] point_times_ns Absolute times of the points of the message, see point_times_ns_.
+   */
+  void complete_knot_state(
+    const size_t knot_idx, const size_t dim, const std::vector<int64_t> & point_times_ns,
+    trajectory_msgs::msg::JointTrajectoryPoint & output) const;
+
+  /// Find the index of the segment start point for \p sample_time_ns
+  /**
+   * Starts searching at the segment found by the previous call and steps forward, falls back to a
+   * binary search over the point times for backward or large forward jumps in time.
+   * \pre point_times_ns_ is filled and \p sample_time_ns is not before the first point.
+   * \return index i with point_times_ns_[i] <= sample_time_ns < point_times_ns_[i + 1], or the
+   * index of the last point if \p sample_time_ns is after the whole trajectory.
+   */
+  size_t find_segment_index(const int64_t sample_time_ns);
+
+  /// Maximum number of segments stepped over linearly before using binary search
+  static constexpr size_t MAX_CURSOR_STEPS = 8;
 
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg_;
   rclcpp::Time trajectory_start_time_;
@@ -155,8 +287,57 @@ private:
   trajectory_msgs::msg::JointTrajectoryPoint state_before_traj_msg_;
 
   bool sampled_already_ = false;
+
+  /// Absolute time of every point in trajectory_msg_ in nanoseconds, valid after the first sample
+  std::vector<int64_t> point_times_ns_;
+  /// Index of the segment the last sample was in
+  size_t segment_cursor_ = 0;
+
+  static constexpr size_t NUM_SPLINE_COEFFICIENTS = 6;
+  static constexpr size_t NO_CACHED_SEGMENT = std::numeric_limits<size_t>::max();
+  /// Spline coefficients of one segment, stored as [order * dim + joint]
+  std::vector<double> segment_coefficients_;
+  /// End point index of the segment segment_coefficients_ belong to, see interpolate_segment()
+  size_t cached_segment_end_idx_ = NO_CACHED_SEGMENT;
+  /// Interpolation method segment_coefficients_ were computed with
+  interpolation_methods::InterpolationMethod cached_interpolation_method_ =
+    interpolation_methods::DEFAULT_INTERPOLATION;
+  /// Completed segment boundary states, see complete_knot_state()
+  trajectory_msgs::msg::JointTrajectoryPoint quintic_state_a_;
+  trajectory_msgs::msg::JointTrajectoryPoint quintic_state_b_;
+
+  /// Points of trajectory_msg_ sampled instead of the msg, see set_compact_storage()
+  std::shared_ptr<const CompactTrajectoryStorage> compact_storage_;
+  /// Segment boundary states loaded from compact_storage_ for the segment of the coefficients
+  trajectory_msgs::msg::JointTrajectoryPoint compact_state_a_;
+  trajectory_msgs::msg::JointTrajectoryPoint compact_state_b_;
 };
 
+/// Deduce the missing positions and velocities of all points after the first one
+/**
+ * Integrates the velocities and accelerations like sample() would, but once for the whole
+ * trajectory and outside of the realtime loop, e.g., when a msg is received. Points with
+ * positions are not changed. A first point without positions depends on the state before the
+ * trajectory, so such a msg is completed by the first sample() instead.
+ * \return true if the trajectory is complete, i.e., all points have positions.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+bool complete_trajectory_points(trajectory_msgs::msg::JointTrajectory & trajectory);
+
+/// Set the velocities and accelerations of waypoints with positions only to a cubic spline
+/**
+ * Solves the tridiagonal system of the spline through the positions of all points for every joint
+ * with the Thomas algorithm, i.e., in linear time of the number of points. The spline has
+ * continuous velocities and accelerations at the waypoints. The acceleration is zero at the first
+ * point and the velocity is zero at the last point. Sampling the points with the velocities and
+ * accelerations reproduces the spline, so its coefficients are cached per segment as usual.
+ * Not realtime-safe, it runs once when a msg is received.
+ * \return false, and no point is changed, if any point has velocities or accelerations, misses
+ * positions, or there are fewer than two points.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+bool compute_cubic_spline_derivatives(trajectory_msgs::msg::JointTrajectory & trajectory);
+
 /**
  * \return The map between \p t1 indices (implicitly encoded in return vector indices) to \p t2
  * indices. If \p t1 is <tt>"{C, B}"</tt> and \p t2 is <tt>"{A, B, C, D}"</tt>, the associated
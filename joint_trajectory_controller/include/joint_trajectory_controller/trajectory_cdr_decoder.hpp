@@ -0,0 +1,89 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_CDR_DECODER_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_CDR_DECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/visibility_control.h"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+namespace joint_trajectory_controller
+{
+/// Result of TrajectoryCdrDecoder::decode()
+enum class CdrDecodeResult : uint8_t
+{
+  DECODED,
+  /// The msg is malformed or doesn't pass the checks of the controller
+  INVALID,
+  /// The encoding isn't plain CDR, the msg has to be deserialized by the middleware instead
+  UNSUPPORTED,
+};
+
+/// Checks of TrajectoryCdrDecoder::decode(), with the parameters of validate_trajectory_msg()
+struct TrajectoryDecodeOptions
+{
+  bool allow_partial_joints_goal = false;
+  bool allow_integration_in_goal_trajectories = false;
+  bool allow_nonzero_velocity_at_trajectory_end = false;
+  /// Trajectories with a nonzero stamp ending before are rejected
+  int64_t now_ns = 0;
+  /// Positions of the joints missing in partial goals in local joint order, NaN if nullptr
+  const std::vector<double> * partial_goal_positions = nullptr;
+};
+
+/**
+ * \brief Decodes CDR serialized trajectory_msgs/msg/JointTrajectory msgs in local joint order.
+ *
+ * Deserializing a msg, validating it, filling the joints missing in partial goals and sorting it to
+ * the joint order of the controller each walk all points, and every step resizes their vectors.
+ * decode() does all of it in one pass over the serialized msg: the values of every field are
+ * written to their local joint indices in a vector allocated once with the size of all joints.
+ * The checks and their errors are the same as the ones of the topic callback.
+ *
+ * Plain CDR and CDR2 in both byte orders are decoded, other encapsulations are UNSUPPORTED.
+ * Not realtime-safe, it is meant for the subscription callback.
+ */
+class TrajectoryCdrDecoder
+{
+public:
+  /// Decode msgs into the order of \p joint_names, the joints of the controller
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  explicit TrajectoryCdrDecoder(std::vector<std::string> joint_names);
+
+  /// Decode the serialized msg of \p size bytes at \p data into \p trajectory
+  /**
+   * \param[out] trajectory the decoded msg with all joints in local order, unspecified unless
+   * DECODED
+   * \param[out] error reason if the msg is INVALID or UNSUPPORTED
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  CdrDecodeResult decode(
+    const uint8_t * data, size_t size, const TrajectoryDecodeOptions & options,
+    trajectory_msgs::msg::JointTrajectory & trajectory, std::string & error);
+
+private:
+  std::vector<std::string> joint_names_;
+  // local index of every joint of the msg, reused for all msgs
+  std::vector<size_t> mapping_;
+  std::vector<bool> is_joint_in_msg_;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_CDR_DECODER_HPP_
@@ -0,0 +1,227 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_RECORDER_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_RECORDER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+
+namespace joint_trajectory_controller
+{
+/// Kinds of the records of a trajectory log, stored as one byte
+enum class RecordKind : uint8_t
+{
+  /// Start of an activation, with the names of the state and command interfaces
+  SESSION = 0,
+  /// Values of the state interfaces read and of the command interfaces written by an update
+  UPDATE = 1,
+  /// Serialized trajectory_msgs/msg/JointTrajectory received on the topic
+  TRAJECTORY = 2,
+  /// Serialized control_msgs/action/FollowJointTrajectory goal that was accepted
+  GOAL = 3,
+  /// Cancellation of the active goal
+  CANCEL = 4,
+};
+
+/// Record of a trajectory log, the members not used by its kind are empty
+struct LogRecord
+{
+  RecordKind kind = RecordKind::UPDATE;
+  /// Number of the update in its session. Other records go right before this update
+  uint64_t cycle = 0;
+  int64_t time_ns = 0;
+  int64_t period_ns = 0;
+  std::vector<double> state_values;
+  std::vector<double> command_values;
+  std::vector<std::string> state_names;
+  std::vector<std::string> command_names;
+  std::vector<uint8_t> payload;
+};
+
+/**
+ * \brief Binary log of the inputs and outputs of a controller, written without blocking update().
+ *
+ * The log starts with the name and the parameters of the controller. Every activation starts a
+ * session with the names of the interfaces, followed by the records of its updates and of the
+ * trajectories and goals received meanwhile. The updates are copied into slots preallocated by
+ * start_session() with a lock-free single-producer/single-consumer ring, a background thread
+ * drains the ring and writes the records to the file. If the thread falls behind, updates are
+ * dropped and counted, the gaps are visible in the cycles of the log.
+ *
+ * The values are stored in the byte order of the recording machine, see TrajectoryLogReader.
+ */
+class TrajectoryRecorder
+{
+public:
+  ~TrajectoryRecorder() { close(); }
+
+  /// Create the log at \p path and write its header, not realtime-safe
+  /**
+   * \param parameters serialized rcl_interfaces/msg/ParameterEvent with the parameters of the
+   * controller as new_parameters
+   * \return false if the file can't be written
+   */
+  bool open(
+    const std::string & path, const std::string & controller_name,
+    const std::vector<uint8_t> & parameters);
+
+  /// Stop the session, if any, and close the file, not realtime-safe
+  void close();
+
+  bool is_open() const { return file_.is_open(); }
+
+  /// Start a session and its writer thread, not realtime-safe
+  /**
+   * \param capacity number of updates buffered for the writer thread
+   * \param flush_period time between two writes of the writer thread
+   */
+  void start_session(
+    const std::vector<std::string> & state_names, const std::vector<std::string> & command_names,
+    size_t capacity, std::chrono::nanoseconds flush_period = std::chrono::milliseconds(10));
+
+  /// Stop the writer thread and write all remaining records, not realtime-safe
+  void stop_session();
+
+  /// Record the interface values of an update, only for the realtime loop, realtime-safe
+  /**
+   * The interfaces have to be in the order of the names of start_session(). Nothing is recorded
+   * outside of a session.
+   */
+  void record_update(
+    int64_t time_ns, int64_t period_ns,
+    const std::vector<hardware_interface::LoanedStateInterface> & state_interfaces,
+    const std::vector<hardware_interface::LoanedCommandInterface> & command_interfaces);
+
+  /// Record a trajectory, goal or cancellation before the next update, not realtime-safe
+  void record_event(RecordKind kind, std::vector<uint8_t> payload = {});
+
+  /// Number of updates dropped since start_session() because the ring was full
+  uint64_t dropped_updates() const { return dropped_updates_.load(std::memory_order_relaxed); }
+
+private:
+  struct UpdateSlot
+  {
+    uint64_t cycle = 0;
+    int64_t time_ns = 0;
+    int64_t period_ns = 0;
+    // values of the state interfaces followed by the ones of the command interfaces
+    std::vector<double> values;
+  };
+
+  struct Event
+  {
+    RecordKind kind;
+    uint64_t cycle;
+    std::vector<uint8_t> payload;
+  };
+
+  /// Write the buffered updates and the events in their order, file_mutex_ has to be locked
+  void flush();
+  void write_update(const UpdateSlot & slot);
+  void write_event(const Event & event);
+
+  std::ofstream file_;
+  // guards the file, the events and the session state against the callbacks and the writer
+  std::mutex file_mutex_;
+  std::deque<Event> events_;
+  bool session_active_ = false;
+  size_t state_count_ = 0;
+  size_t command_count_ = 0;
+
+  std::vector<UpdateSlot> slots_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  // true while record_update() records, set before the writer starts and after it stopped
+  std::atomic<bool> recording_{false};
+  // number of the next update, also counting the dropped ones
+  std::atomic<uint64_t> cycle_{0};
+  std::atomic<uint64_t> dropped_updates_{0};
+
+  std::thread writer_;
+  std::condition_variable writer_condition_;
+  bool stop_writer_ = false;
+};
+
+/// Reader of the logs of TrajectoryRecorder, not realtime-safe
+class TrajectoryLogReader
+{
+public:
+  /// Open the log at \p path and read its header
+  /**
+   * \return false if the file can't be read or isn't a trajectory log of this version
+   */
+  bool open(const std::string & path);
+
+  const std::string & controller_name() const { return controller_name_; }
+
+  /// Serialized rcl_interfaces/msg/ParameterEvent with the parameters of the recorded controller
+  const std::vector<uint8_t> & parameters() const { return parameters_; }
+
+  /// Read the next record
+  /**
+   * \return false at the end of the log, or if the last record is incomplete, e.g., because the
+   * recording process was killed
+   */
+  bool read(LogRecord & record);
+
+private:
+  std::ifstream file_;
+  std::string controller_name_;
+  std::vector<uint8_t> parameters_;
+  size_t state_count_ = 0;
+  size_t command_count_ = 0;
+};
+
+/// Serialize \p msg for the payload of a record, not realtime-safe
+template <typename MessageT>
+std::vector<uint8_t> serialize_record_payload(const MessageT & msg)
+{
+  rclcpp::Serialization<MessageT> serialization;
+  rclcpp::SerializedMessage serialized_msg;
+  serialization.serialize_message(&msg, &serialized_msg);
+  const auto & buffer = serialized_msg.get_rcl_serialized_message();
+  return std::vector<uint8_t>(buffer.buffer, buffer.buffer + buffer.buffer_length);
+}
+
+/// Deserialize the payload of a record, not realtime-safe
+template <typename MessageT>
+MessageT deserialize_record_payload(const std::vector<uint8_t> & payload)
+{
+  rclcpp::SerializedMessage serialized_msg(payload.size());
+  auto & buffer = serialized_msg.get_rcl_serialized_message();
+  std::copy(payload.begin(), payload.end(), buffer.buffer);
+  buffer.buffer_length = payload.size();
+  MessageT msg;
+  rclcpp::Serialization<MessageT>().deserialize_message(&serialized_msg, &msg);
+  return msg;
+}
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_RECORDER_HPP_
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__TRIPLE_BUFFER_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__TRIPLE_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Lock-free single-producer/single-consumer hand-over of the latest value.
+ *
+ * The producer, e.g., the realtime loop, fills write_buffer() and publishes it, the consumer takes
+ * the latest published value with update_read_buffer() and reads it from read_buffer(). Neither
+ * side ever waits for the other and values are only copied into the buffers, so publishing doesn't
+ * allocate memory once the buffers had the size of the values.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+  /// Buffer for the next value, only for the producer
+  T & write_buffer() { return buffers_[write_index_]; }
+
+  /// Make the value of write_buffer() the latest one, realtime-safe
+  void publish()
+  {
+    const uint8_t published = static_cast<uint8_t>(write_index_ | FRESH);
+    write_index_ =
+      static_cast<uint8_t>(middle_.exchange(published, std::memory_order_acq_rel) & INDEX_MASK);
+  }
+
+  /// Switch read_buffer() to the latest published value, only for the consumer
+  /**
+   * \return false if nothing was published since the last call, read_buffer() is unchanged then
+   */
+  bool update_read_buffer()
+  {
+    if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0)
+    {
+      return false;
+    }
+    read_index_ =
+      static_cast<uint8_t>(middle_.exchange(read_index_, std::memory_order_acq_rel) & INDEX_MASK);
+    return true;
+  }
+
+  /// Set all buffers to \p value, e.g., to allocate them, with nothing published; only while
+  /// neither side uses the buffer
+  void assign(const T & value)
+  {
+    buffers_.fill(value);
+    middle_.store(
+      static_cast<uint8_t>(middle_.load(std::memory_order_relaxed) & INDEX_MASK),
+      std::memory_order_relaxed);
+  }
+
+  /// Latest value taken by update_read_buffer(), only for the consumer
+  const T & read_buffer() const { return buffers_[read_index_]; }
+
+  /// Latest value taken by update_read_buffer(), the consumer may change it until it takes the next
+  T & read_buffer() { return buffers_[read_index_]; }
+
+private:
+  static constexpr uint8_t INDEX_MASK = 0x3;
+  static constexpr uint8_t FRESH = 0x4;
+
+  std::array<T, 3> buffers_{};
+  uint8_t write_index_ = 0;
+  /// Index of the buffer between producer and consumer, and if it holds an unread value
+  std::atomic<uint8_t> middle_{1};
+  uint8_t read_index_ = 2;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__TRIPLE_BUFFER_HPP_
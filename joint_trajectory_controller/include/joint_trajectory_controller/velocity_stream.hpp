@@ -0,0 +1,106 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__VELOCITY_STREAM_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__VELOCITY_STREAM_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Lock-free single-producer/single-consumer ring of time-stamped velocity points.
+ *
+ * The topic callback (producer) pushes the velocities of streamed points with the time they apply
+ * from, the realtime loop (consumer) takes the points whose time has come. The points are copied
+ * into slots preallocated by resize(), so neither side allocates memory.
+ */
+class VelocityStream
+{
+public:
+  /// Preallocate \p capacity points of \p dof joints, neither realtime-safe nor thread-safe
+  void resize(size_t capacity, size_t dof)
+  {
+    points_.assign(capacity, Point{0, std::vector<double>(dof, 0.0)});
+    dof_ = dof;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+  }
+
+  /// Append a point applying from \p stamp_ns, only for the producer
+  /**
+   * \return false if the ring is full or \p velocities doesn't have one value per joint
+   */
+  bool push(int64_t stamp_ns, const std::vector<double> & velocities)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (
+      velocities.size() != dof_ || points_.empty() ||
+      head - tail_.load(std::memory_order_acquire) >= points_.size())
+    {
+      return false;
+    }
+    auto & point = points_[head % points_.size()];
+    point.stamp_ns = stamp_ns;
+    point.velocities.assign(velocities.begin(), velocities.end());
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Take all points applying until \p time_ns, only for the consumer, realtime-safe
+  /**
+   * \param[out] velocities Velocities of the latest point taken, it has to have the size of the
+   * points already.
+   * \param[out] stamp_ns Time the latest point taken applies from.
+   * \return false if no point applies until \p time_ns, the outputs are unchanged then.
+   */
+  bool pop_until(int64_t time_ns, std::vector<double> & velocities, int64_t & stamp_ns)
+  {
+    const size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    bool popped = false;
+    while (tail != head && points_[tail % points_.size()].stamp_ns <= time_ns)
+    {
+      const auto & point = points_[tail % points_.size()];
+      velocities.assign(point.velocities.begin(), point.velocities.end());
+      stamp_ns = point.stamp_ns;
+      popped = true;
+      ++tail;
+    }
+    tail_.store(tail, std::memory_order_release);
+    return popped;
+  }
+
+  /// Drop all points, only for the consumer
+  void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+  struct Point
+  {
+    int64_t stamp_ns;
+    std::vector<double> velocities;
+  };
+
+  std::vector<Point> points_;
+  size_t dof_ = 0;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__VELOCITY_STREAM_HPP_
@@ -0,0 +1,162 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/compact_trajectory_storage.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/duration.hpp"
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+template <typename T>
+void store_values(
+  const trajectory_msgs::msg::JointTrajectory & trajectory,
+  const std::vector<double> trajectory_msgs::msg::JointTrajectoryPoint::*field, uint8_t * data)
+{
+  auto * values = reinterpret_cast<T *>(data);
+  for (const auto & point : trajectory.points)
+  {
+    for (const double value : point.*field)
+    {
+      *values++ = static_cast<T>(value);
+    }
+  }
+}
+}  // namespace
+
+std::shared_ptr<const CompactTrajectoryStorage> CompactTrajectoryStorage::build(
+  const trajectory_msgs::msg::JointTrajectory & trajectory, const CompactValueType value_type)
+{
+  const auto & points = trajectory.points;
+  if (points.empty())
+  {
+    return nullptr;
+  }
+  const size_t dim = points[0].positions.size();
+  const bool has_velocities = points[0].velocities.size() == dim;
+  const bool has_accelerations = points[0].accelerations.size() == dim;
+  for (const auto & point : points)
+  {
+    if (
+      point.positions.size() != dim || (point.velocities.size() == dim) != has_velocities ||
+      (point.accelerations.size() == dim) != has_accelerations)
+    {
+      return nullptr;
+    }
+  }
+
+  // make_shared can't use the private constructor
+  std::shared_ptr<CompactTrajectoryStorage> storage(new CompactTrajectoryStorage());
+  storage->num_points_ = points.size();
+  storage->dim_ = dim;
+  storage->has_velocities_ = has_velocities;
+  storage->has_accelerations_ = has_accelerations;
+  storage->value_type_ = value_type;
+
+  // the times are 8 bytes each, so every field starts aligned for its values
+  const size_t value_size =
+    value_type == CompactValueType::FLOAT32 ? sizeof(float) : sizeof(double);
+  const size_t field_size = points.size() * dim * value_size;
+  storage->positions_offset_ = points.size() * sizeof(int64_t);
+  storage->velocities_offset_ = storage->positions_offset_ + field_size;
+  storage->accelerations_offset_ =
+    storage->velocities_offset_ + (has_velocities ? field_size : 0u);
+  storage->data_.resize(storage->accelerations_offset_ + (has_accelerations ? field_size : 0u));
+
+  auto * times_ns = reinterpret_cast<int64_t *>(storage->data_.data());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    times_ns[i] = rclcpp::Duration(points[i].time_from_start).nanoseconds();
+  }
+  auto store_field = [&](
+                       const std::vector<double> trajectory_msgs::msg::JointTrajectoryPoint::*field,
+                       size_t offset)
+  {
+    if (value_type == CompactValueType::FLOAT32)
+    {
+      store_values<float>(trajectory, field, storage->data_.data() + offset);
+    }
+    else
+    {
+      store_values<double>(trajectory, field, storage->data_.data() + offset);
+    }
+  };
+  store_field(&trajectory_msgs::msg::JointTrajectoryPoint::positions, storage->positions_offset_);
+  if (has_velocities)
+  {
+    store_field(
+      &trajectory_msgs::msg::JointTrajectoryPoint::velocities, storage->velocities_offset_);
+  }
+  if (has_accelerations)
+  {
+    store_field(
+      &trajectory_msgs::msg::JointTrajectoryPoint::accelerations, storage->accelerations_offset_);
+  }
+  return storage;
+}
+
+template <typename T>
+void CompactTrajectoryStorage::load_values(
+  const size_t field_offset, const size_t index, std::vector<double> & values) const
+{
+  const auto * first = reinterpret_cast<const T *>(data_.data() + field_offset) + index * dim_;
+  values.assign(first, first + dim_);
+}
+
+void CompactTrajectoryStorage::load_point(
+  const size_t index, trajectory_msgs::msg::JointTrajectoryPoint & point) const
+{
+  const bool is_float32 = value_type_ == CompactValueType::FLOAT32;
+  auto load_field = [&](const bool has_field, const size_t offset, std::vector<double> & values)
+  {
+    if (!has_field)
+    {
+      values.clear();
+    }
+    else if (is_float32)
+    {
+      load_values<float>(offset, index, values);
+    }
+    else
+    {
+      load_values<double>(offset, index, values);
+    }
+  };
+  load_field(true, positions_offset_, point.positions);
+  load_field(has_velocities_, velocities_offset_, point.velocities);
+  load_field(has_accelerations_, accelerations_offset_, point.accelerations);
+}
+
+bool compact_value_type_from_string(const std::string & name, CompactValueType & value_type)
+{
+  if (name == "compact")
+  {
+    value_type = CompactValueType::FLOAT64;
+    return true;
+  }
+  if (name == "compact_float32")
+  {
+    value_type = CompactValueType::FLOAT32;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace joint_trajectory_controller
@@ -0,0 +1,182 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/joint_group_trajectory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/duration.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+// the missing derivatives of a sample are zero, e.g., of the last point of a trajectory
+void complete_derivatives(trajectory_msgs::msg::JointTrajectoryPoint & point, size_t size)
+{
+  point.velocities.resize(size, 0.0);
+  point.accelerations.resize(size, 0.0);
+}
+
+// times of the points of msg after the time after_ns, relative to it
+void append_point_times(
+  const trajectory_msgs::msg::JointTrajectory & msg, int64_t start_time_ns, int64_t after_ns,
+  std::vector<int64_t> & times_ns)
+{
+  for (const auto & point : msg.points)
+  {
+    const int64_t time_ns =
+      start_time_ns + rclcpp::Duration(point.time_from_start).nanoseconds() - after_ns;
+    if (time_ns > 0)
+    {
+      times_ns.push_back(time_ns);
+    }
+  }
+}
+}  // namespace
+
+std::shared_ptr<trajectory_msgs::msg::JointTrajectory> merge_group_trajectory(
+  const Trajectory & base, const rclcpp::Time & base_time, const rclcpp::Time & start_time,
+  const std::vector<std::string> & joint_names,
+  const trajectory_msgs::msg::JointTrajectory * group_msg,
+  const std::vector<size_t> & moved_joint_indices, const std::vector<size_t> & held_joint_indices,
+  interpolation_methods::InterpolationMethod interpolation_method, int64_t & group_duration_ns)
+{
+  group_duration_ns = 0;
+  const size_t dof = joint_names.size();
+  const auto clock_type = start_time.get_clock_type();
+  const int64_t base_time_ns = base_time.nanoseconds();
+  const int64_t start_time_ns = start_time.nanoseconds();
+  if (!base.has_trajectory_msg())
+  {
+    return nullptr;
+  }
+
+  // the state all joints start from
+  trajectory_msgs::msg::JointTrajectoryPoint start_state;
+  TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+  if (
+    !base.sample_at(base_time, interpolation_method, start_state, start_segment_itr,
+                    end_segment_itr) ||
+    start_state.positions.size() != dof)
+  {
+    return nullptr;
+  }
+  complete_derivatives(start_state, dof);
+
+  std::vector<int64_t> times_ns{0};
+  // the start time of a msg with zero stamp is only known to update(), it starts at base_time then
+  const int64_t base_start_ns = base.time_from_start().nanoseconds() == 0
+                                  ? base_time_ns
+                                  : base.time_from_start().nanoseconds();
+  append_point_times(*base.get_trajectory_msg(), base_start_ns, base_time_ns, times_ns);
+
+  std::unique_ptr<Trajectory> group_trajectory;
+  if (group_msg && !group_msg->points.empty())
+  {
+    auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*group_msg);
+    if (rclcpp::Time(msg->header.stamp).nanoseconds() == 0)
+    {
+      msg->header.stamp = start_time;
+    }
+    trajectory_msgs::msg::JointTrajectoryPoint group_start;
+    group_start.positions.resize(moved_joint_indices.size());
+    group_start.velocities.resize(moved_joint_indices.size());
+    group_start.accelerations.resize(moved_joint_indices.size());
+    for (size_t k = 0; k < moved_joint_indices.size(); ++k)
+    {
+      group_start.positions[k] = start_state.positions[moved_joint_indices[k]];
+      group_start.velocities[k] = start_state.velocities[moved_joint_indices[k]];
+      group_start.accelerations[k] = start_state.accelerations[moved_joint_indices[k]];
+    }
+    group_trajectory = std::make_unique<Trajectory>(start_time, group_start, msg);
+
+    const size_t first_group_time = times_ns.size();
+    const int64_t group_start_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
+    append_point_times(*msg, group_start_ns, start_time_ns, times_ns);
+    if (times_ns.size() > first_group_time)
+    {
+      group_duration_ns = *std::max_element(times_ns.begin() + first_group_time, times_ns.end());
+    }
+  }
+
+  // points closer than the resolution are merged, keeping the earlier one
+  std::sort(times_ns.begin(), times_ns.end());
+  times_ns.erase(
+    std::unique(
+      times_ns.begin(), times_ns.end(),
+      [](int64_t first, int64_t second) { return second - first < MERGED_POINT_RESOLUTION_NS; }),
+    times_ns.end());
+
+  auto merged_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  merged_msg->header.stamp = start_time;
+  merged_msg->joint_names = joint_names;
+  merged_msg->points.reserve(times_ns.size());
+  trajectory_msgs::msg::JointTrajectoryPoint sample;
+  for (const int64_t time_ns : times_ns)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint point;
+    point.time_from_start = rclcpp::Duration::from_nanoseconds(time_ns);
+    if (
+      time_ns > 0 &&
+      base.sample_at(
+        rclcpp::Time(base_time_ns + time_ns, clock_type), interpolation_method, sample,
+        start_segment_itr, end_segment_itr) &&
+      sample.positions.size() == dof)
+    {
+      complete_derivatives(sample, dof);
+      point.positions = sample.positions;
+      point.velocities = sample.velocities;
+      point.accelerations = sample.accelerations;
+    }
+    else
+    {
+      point.positions = start_state.positions;
+      point.velocities = start_state.velocities;
+      point.accelerations = start_state.accelerations;
+    }
+
+    for (const size_t index : held_joint_indices)
+    {
+      point.positions[index] = start_state.positions[index];
+      point.velocities[index] = 0.0;
+      point.accelerations[index] = 0.0;
+    }
+
+    if (
+      group_trajectory &&
+      group_trajectory->sample_at(
+        rclcpp::Time(start_time_ns + time_ns, clock_type), interpolation_method, sample,
+        start_segment_itr, end_segment_itr) &&
+      sample.positions.size() == moved_joint_indices.size())
+    {
+      complete_derivatives(sample, moved_joint_indices.size());
+      for (size_t k = 0; k < moved_joint_indices.size(); ++k)
+      {
+        point.positions[moved_joint_indices[k]] = sample.positions[k];
+        point.velocities[moved_joint_indices[k]] = sample.velocities[k];
+        point.accelerations[moved_joint_indices[k]] = sample.accelerations[k];
+      }
+    }
+    merged_msg->points.push_back(std::move(point));
+  }
+  return merged_msg;
+}
+
+}  // namespace joint_trajectory_controller
@@ -15,8 +15,13 @@
 #include "joint_trajectory_controller/joint_trajectory_controller.hpp"
 
 #include <stddef.h>
+#include <algorithm>
+#include <cmath>
 #include <chrono>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <limits>
 #include <memory>
 #include <ostream>
 #include <ratio>
@@ -27,14 +32,20 @@
 #include "builtin_interfaces/msg/duration.hpp"
 #include "builtin_interfaces/msg/time.hpp"
 #include "controller_interface/helpers.hpp"
+#include "controller_tracetools/tracetools.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "interface_values/copy_values.hpp"
+#include "joint_trajectory_controller/joint_group_trajectory.hpp"
 #include "joint_trajectory_controller/trajectory.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
+#include "publisher_pool/publisher_qos.hpp"
+#include "rcl_interfaces/msg/parameter_event.hpp"
 #include "rclcpp/event_handler.hpp"
 #include "rclcpp/logging.hpp"
 #include "rclcpp/parameter.hpp"
 #include "rclcpp/qos.hpp"
+#include "rclcpp/serialization.hpp"
 #include "rclcpp/time.hpp"
 #include "rclcpp_action/create_server.hpp"
 #include "rclcpp_action/server_goal_handle.hpp"
@@ -45,8 +56,39 @@
 
 namespace joint_trajectory_controller
 {
+namespace
+{
+/// Order \p interfaces like their full \p names into \p ordered_interfaces, which doesn't
+/// allocate if it has the capacity for all names
+template <typename T>
+bool bind_ordered_interfaces(
+  std::vector<T> & interfaces, const std::vector<std::string> & names,
+  std::vector<std::reference_wrapper<T>> & ordered_interfaces)
+{
+  ordered_interfaces.clear();
+  for (const auto & name : names)
+  {
+    for (auto & interface : interfaces)
+    {
+      if (interface.get_name() == name)
+      {
+        ordered_interfaces.push_back(std::ref(interface));
+        break;
+      }
+    }
+  }
+  return ordered_interfaces.size() == names.size();
+}
+
+size_t prefault_point(trajectory_msgs::msg::JointTrajectoryPoint & point)
+{
+  return memory_prefault::prefault(
+    point.positions, point.velocities, point.accelerations, point.effort);
+}
+}  // namespace
+
 JointTrajectoryController::JointTrajectoryController()
-: controller_interface::ControllerInterface(), dof_(0)
+: controller_interface::ChainableControllerInterface(), dof_(0)
 {
 }
 
@@ -54,9 +96,25 @@ controller_interface::CallbackReturn JointTrajectoryController::on_init()
 {
   try
   {
+    startup_profile_.clear();
     // Create the parameter listener and get the parameters
-    param_listener_ = std::make_shared<ParamListener>(get_node());
-    params_ = param_listener_->get_params();
+    {
+      update_time_statistics::ScopedStartupPhase phase(startup_profile_, "declare parameters");
+      param_listener_ = std::make_shared<ParamListener>(get_node());
+    }
+    {
+      update_time_statistics::ScopedStartupPhase phase(startup_profile_, "read parameters");
+      params_ = param_listener_->get_params();
+      store_dynamic_parameters(params_);
+    }
+    rt_logger_ = std::make_unique<realtime_logging::RealtimeLogger>(get_node()->get_logger());
+    // the parameters are prepared on the parameter callback thread, update() only swaps them in
+    param_listener_->setUserCallback(
+      [this](const Params & params)
+      {
+        store_dynamic_parameters(params);
+        runtime_parameters_.writeFromNonRT(make_runtime_parameters(params));
+      });
   }
   catch (const std::exception & e)
   {
@@ -97,7 +155,7 @@ JointTrajectoryController::state_interface_configuration() const
 {
   controller_interface::InterfaceConfiguration conf;
   conf.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-  conf.names.reserve(dof_ * params_.state_interfaces.size());
+  conf.names.reserve(dof_ * params_.state_interfaces.size() + 1);
   for (const auto & joint_name : params_.joints)
   {
     for (const auto & interface_type : params_.state_interfaces)
@@ -105,92 +163,252 @@ JointTrajectoryController::state_interface_configuration() const
       conf.names.push_back(joint_name + "/" + interface_type);
     }
   }
+  if (!params_.speed_scaling.state_interface.empty())
+  {
+    conf.names.push_back(params_.speed_scaling.state_interface);
+  }
   return conf;
 }
 
-controller_interface::return_type JointTrajectoryController::update(
+controller_interface::return_type JointTrajectoryController::update_reference_from_subscribers(
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+{
+  // the msgs of the topic and the action goals are taken as trajectories in
+  // update_and_write_commands(), the reference interfaces are used in chained mode only
+  return controller_interface::return_type::OK;
+}
+
+controller_interface::return_type JointTrajectoryController::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  if (get_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+  update_time_.set(time);
+  // the flag follows on_activate() and on_deactivate(), reading the lifecycle state would lock it
+  if (!subscriber_is_active_)
   {
     return controller_interface::return_type::OK;
   }
+  update_time_statistics::ScopedUpdateTimer update_timer(update_time_statistics_.get(), time);
+  update_time_statistics::ScopedCycleBudget cycle_budget_scope(
+    cycle_budget_.get(), period.nanoseconds());
   // update dynamic parameters
-  if (param_listener_->is_old(params_))
-  {
-    params_ = param_listener_->get_params();
-    default_tolerances_ = get_segment_tolerances(params_);
-    // update the PID gains
-    // variable use_closed_loop_pid_adapter_ is updated in on_configure only
-    if (use_closed_loop_pid_adapter_)
-    {
-      update_pids();
-    }
-  }
+  update_runtime_parameters();
 
-  auto compute_error_for_joint = [&](
-                                   JointTrajectoryPoint & error, size_t index,
-                                   const JointTrajectoryPoint & current,
-                                   const JointTrajectoryPoint & desired)
+  auto compute_error = [&](
+                         JointTrajectoryPoint & error, const JointTrajectoryPoint & current,
+                         const JointTrajectoryPoint & desired)
   {
-    // error defined as the difference between current and desired
-    if (joints_angle_wraparound_[index])
+    // error defined as the difference between current and desired, computed over all joints
+    // without per-joint branches
+    auto subtract = [&](
+                      std::vector<double> & difference, const std::vector<double> & minuend,
+                      const std::vector<double> & subtrahend)
     {
-      // if desired, the shortest_angular_distance is calculated, i.e., the error is
-      //  normalized between -pi<error<pi
-      error.positions[index] =
-        angles::shortest_angular_distance(current.positions[index], desired.positions[index]);
-    }
-    else
+      for (size_t index = 0; index < dof_; ++index)
+      {
+        difference[index] = minuend[index] - subtrahend[index];
+      }
+    };
+
+    subtract(error.positions, desired.positions, current.positions);
+    // if desired, the shortest_angular_distance is calculated, i.e., the error is
+    //  normalized between -pi<error<pi
+    for (const auto index : wraparound_joint_indices_)
     {
-      error.positions[index] = desired.positions[index] - current.positions[index];
+      error.positions[index] = angles::normalize_angle(error.positions[index]);
     }
     if (
       has_velocity_state_interface_ &&
       (has_velocity_command_interface_ || has_effort_command_interface_))
     {
-      error.velocities[index] = desired.velocities[index] - current.velocities[index];
+      subtract(error.velocities, desired.velocities, current.velocities);
     }
     if (has_acceleration_state_interface_ && has_acceleration_command_interface_)
     {
-      error.accelerations[index] = desired.accelerations[index] - current.accelerations[index];
+      subtract(error.accelerations, desired.accelerations, current.accelerations);
     }
   };
 
   // don't update goal after we sampled the trajectory to avoid any racecondition
-  const auto active_goal = *rt_active_goal_.readFromRT();
+  auto active_goal = *rt_active_goal_.read_from_rt();
+  // a queued goal started in here is active until the non-RT side replaced its predecessor
+  if (rt_started_queued_goal_)
+  {
+    if (active_goal.get() == rt_queued_goal_predecessor_)
+    {
+      active_goal = rt_started_queued_goal_->goal;
+    }
+    else
+    {
+      rt_released_queued_goals_.retain(rt_started_queued_goal_);
+      rt_started_queued_goal_.reset();
+    }
+  }
+  push_unpushed_goal_states_from_rt();
+  bool has_pending_goal = rt_has_pending_goal_.load(std::memory_order_acquire);
+  // a goal finished in here stays active until the non-RT side processed the goal state request
+  if (active_goal && active_goal.get() == rt_finished_goal_)
+  {
+    active_goal.reset();
+    has_pending_goal = false;
+  }
+  else
+  {
+    rt_finished_goal_ = nullptr;
+  }
 
   // Check if a new external message has been received from nonRT threads
   auto current_external_msg = traj_external_point_ptr_->get_trajectory_msg();
-  auto new_external_msg = traj_msg_external_point_ptr_.readFromRT();
-  // Discard, if a goal is pending but still not active (somewhere stuck in goal_handle_timer_)
+  auto new_external_msg = traj_msg_external_point_ptr_.read_from_rt();
+  // Discard, if a goal is pending but still not active (not accepted completely yet)
   if (
-    current_external_msg != *new_external_msg &&
-    (*(rt_has_pending_goal_.readFromRT()) && !active_goal) == false)
+    current_external_msg != *new_external_msg && (has_pending_goal && !active_goal) == false)
   {
-    fill_partial_goal(*new_external_msg);
-    sort_to_local_joint_order(*new_external_msg);
-    // TODO(denis): Add here integration of position and velocity
+    // the message was already brought into local joint order and its missing positions were
+    // integrated by the non-RT callbacks
+    rt_released_storages_.retain(traj_external_point_ptr_->get_compact_storage());
     traj_external_point_ptr_->update(*new_external_msg);
+    rt_released_msgs_.retain(current_external_msg);
+    // a new trajectory ends the velocity stream and the trajectory file
+    rt_streaming_velocity_ = false;
+    rt_following_file_ = false;
   }
+  // read once per cycle, update() changes its own copy along with rt_is_holding_
+  rt_holding_ = rt_is_holding_.load(std::memory_order_acquire);
 
-  // TODO(anyone): can I here also use const on joint_interface since the reference_wrapper is not
-  // changed, but its value only?
-  auto assign_interface_from_point =
-    [&](auto & joint_interface, const std::vector<double> & trajectory_point_interface)
+  // the tolerances of the msg are written before it, so they are taken in the same cycle
+  if (active_tolerances_.msg != traj_external_point_ptr_->get_trajectory_msg().get())
   {
-    for (size_t index = 0; index < dof_; ++index)
+    update_active_tolerances();
+  }
+  // the same for the storage, sampling the msg until then
+  if (
+    use_compact_storage_ &&
+    rt_storage_msg_ != traj_external_point_ptr_->get_trajectory_msg().get())
+  {
+    update_compact_storage();
+  }
+  // the same for the goals of the joint groups
+  if (!joint_groups_.empty())
+  {
+    update_active_group_goals();
+  }
+
+  // set values for next hardware write(), the sources were selected on activation
+  auto write_commands = [&]()
+  {
+    if (use_closed_loop_pid_adapter_)
+    {
+      // Update PIDs
+      pid_bank_.compute_commands(
+        state_error_.positions, state_error_.velocities,
+        static_cast<uint64_t>(period.nanoseconds()), tmp_command_);
+      for (auto i = 0ul; i < dof_; ++i)
+      {
+        tmp_command_[i] += state_desired_.velocities[i] * ff_velocity_scale_[i];
+      }
+    }
+
+    auto * const * command_interface = rt_command_interfaces_.data();
+    for (const auto & command_source : command_sources_)
     {
-      joint_interface[index].get().set_value(trajectory_point_interface[index]);
+      const double * values = command_source.second->data();
+      for (size_t index = 0; index < dof_; ++index)
+      {
+        command_interface[index]->set_value(values[index]);
+      }
+      command_interface += dof_;
     }
+
+    // store the previous command. Used in open-loop control mode
+    last_commanded_state_ = state_desired_;
   };
 
   // current state update
   state_current_.time_from_start.set__sec(0);
   read_state_from_state_interfaces(state_current_);
+  publish_hold_positions();
+
+  // the factor of the hardware is used as long as it is valid
+  if (speed_scaling_state_interface_)
+  {
+    const double speed_scaling_factor = speed_scaling_state_interface_->get().get_value();
+    if (std::isfinite(speed_scaling_factor) && speed_scaling_factor >= 0.0)
+    {
+      speed_scaling_factor_ = speed_scaling_factor;
+    }
+  }
+
+  if (params_.trajectory_file.enable)
+  {
+    take_file_trajectory();
+  }
+
+  bool horizon_exported = false;
+
+  // the preceding controller writes the reference every cycle, no trajectory is sampled
+  if (is_in_chained_mode())
+  {
+    const bool has_reference = read_desired_state_from_reference_interfaces(state_desired_);
+    compute_error(state_error_, state_current_, state_desired_);
+    const bool violates_tolerance =
+      has_reference && !check_state_tolerance(state_error_, state_tolerance_arrays_);
+    // logged once per violation, the reference is written every cycle
+    if (violates_tolerance && !rt_reference_violates_tolerance_)
+    {
+      rt_logger_->warn(
+        "Holding position due to state tolerance violation of the reference interfaces");
+    }
+    rt_reference_violates_tolerance_ = violates_tolerance;
+    if (!has_reference || violates_tolerance)
+    {
+      // hold the last command until the reference is valid again
+      state_desired_.positions.assign(
+        last_commanded_state_.positions.begin(), last_commanded_state_.positions.end());
+      state_desired_.velocities.assign(dof_, 0.0);
+      state_desired_.accelerations.assign(dof_, 0.0);
+      compute_error(state_error_, state_current_, state_desired_);
+    }
+    write_commands();
+  }
+  // integrate the streamed velocities instead of sampling the trajectory
+  else if (
+    params_.velocity_streaming.enable &&
+    update_velocity_stream(time, period, active_goal == nullptr))
+  {
+    compute_error(state_error_, state_current_, state_desired_);
+    if (!check_state_tolerance(state_error_, state_tolerance_arrays_))
+    {
+      rt_logger_->error(
+        "Holding position due to state tolerance violation of the velocity stream");
+
+      rt_streaming_velocity_ = false;
+      switch_to_hold_from_rt(false);
+    }
+    else
+    {
+      write_commands();
+    }
+  }
+  // sample the trajectory file instead of the trajectory
+  else if (rt_following_file_)
+  {
+    update_file_trajectory(period);
+    compute_error(state_error_, state_current_, state_desired_);
+    if (!check_state_tolerance(state_error_, state_tolerance_arrays_))
+    {
+      rt_logger_->error(
+        "Holding position due to state tolerance violation of the trajectory file");
 
+      rt_following_file_ = false;
+      switch_to_hold_from_rt(false);
+    }
+    else
+    {
+      write_commands();
+    }
+  }
   // currently carrying out a trajectory
-  if (has_active_trajectory())
+  else if (has_active_trajectory())
   {
     bool first_sample = false;
     // if sampling the first time, set the point before you sample
@@ -205,24 +423,74 @@ controller_interface::return_type JointTrajectoryController::update(
       {
         traj_external_point_ptr_->set_point_before_trajectory_msg(time, state_current_);
       }
+      traj_time_ = time;
+      ++rt_trajectory_generation_;
+      rt_tracking_statistics_.reset();
+      rt_look_ahead_scaling_ = 1.0;
+      rt_look_ahead_scaling_rate_ = 0.0;
+    }
+    else
+    {
+      // warp the time of the trajectory instead of re-timing its points
+      traj_time_ += period * (speed_scaling_factor_ * rt_look_ahead_scaling_);
     }
 
     // find segment for current timestamp
     TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+    CONTROLLER_TRACEPOINT(stage_begin, this, "sample");
     const bool valid_point = traj_external_point_ptr_->sample(
-      time, interpolation_method_, state_desired_, start_segment_itr, end_segment_itr);
+      traj_time_, interpolation_method_, state_desired_, start_segment_itr, end_segment_itr);
+    CONTROLLER_TRACEPOINT(stage_end, this, "sample");
+    rt_traj_time_ns_.store(traj_time_.nanoseconds(), std::memory_order_relaxed);
+    if (first_sample)
+    {
+      // the start time is known and the msg is completed now, hand a copy over to the non-RT side
+      auto & snapshot = rt_trajectory_snapshots_.write_buffer();
+      rt_released_msgs_.retain(snapshot.trajectory.get_trajectory_msg());
+      rt_released_storages_.retain(snapshot.trajectory.get_compact_storage());
+      snapshot.trajectory = *traj_external_point_ptr_;
+      snapshot.generation = rt_trajectory_generation_;
+      rt_trajectory_snapshots_.publish();
+    }
+
+    if (params_.look_ahead.enable)
+    {
+      update_look_ahead_scaling(period);
+    }
+
+    // before a switch to hold replaces the trajectory, which is sampled first in the next update
+    if (horizon_slot_)
+    {
+      export_trajectory_horizon(time, valid_point);
+      horizon_exported = true;
+    }
 
     if (valid_point)
     {
-      const rclcpp::Time traj_start = traj_external_point_ptr_->time_from_start();
+      // the reference slows down with the trajectory time while decelerating
+      if (rt_look_ahead_scaling_ < 1.0)
+      {
+        for (auto & velocity : state_desired_.velocities)
+        {
+          velocity *= rt_look_ahead_scaling_;
+        }
+        for (auto & acceleration : state_desired_.accelerations)
+        {
+          acceleration *= rt_look_ahead_scaling_ * rt_look_ahead_scaling_;
+        }
+      }
+
+      const int64_t traj_start_ns = traj_external_point_ptr_->time_from_start().nanoseconds();
       // this is the time instance
       // - started with the first segment: when the first point will be reached (in the future)
       // - later: when the point of the current segment was reached
-      const rclcpp::Time segment_time_from_start = traj_start + start_segment_itr->time_from_start;
+      const int64_t segment_time_from_start_ns =
+        traj_start_ns + rclcpp::Duration(start_segment_itr->time_from_start).nanoseconds();
       // time_difference is
       // - negative until first point is reached
       // - counting from zero to time_from_start of next point
-      double time_difference = time.seconds() - segment_time_from_start.seconds();
+      const double time_difference =
+        static_cast<double>(traj_time_.nanoseconds() - segment_time_from_start_ns) / 1e9;
       bool tolerance_violated_while_moving = false;
       bool outside_goal_tolerance = false;
       bool within_goal_time = true;
@@ -231,361 +499,499 @@ controller_interface::return_type JointTrajectoryController::update(
       // have we reached the end, are not holding position, and is a timeout configured?
       // Check independently of other tolerances
       if (
-        !before_last_point && *(rt_is_holding_.readFromRT()) == false && cmd_timeout_ > 0.0 &&
+        !before_last_point && !rt_holding_ && cmd_timeout_ > 0.0 &&
         time_difference > cmd_timeout_)
       {
-        RCLCPP_WARN(get_node()->get_logger(), "Aborted due to command timeout");
+        rt_logger_->warn("Aborted due to command timeout");
+
+        switch_to_hold_from_rt(false);
+      }
 
-        traj_msg_external_point_ptr_.reset();
-        traj_msg_external_point_ptr_.initRT(set_hold_position());
+      // the joints of aborted groups stop until their trajectory is replaced
+      if (rt_active_group_goals_)
+      {
+        hold_aborted_groups_from_rt();
       }
 
       // Check state/goal tolerance
-      for (size_t index = 0; index < dof_; ++index)
+      CONTROLLER_TRACEPOINT(stage_begin, this, "check_tolerances");
+      compute_error(state_error_, state_current_, state_desired_);
+      // the goals of the joint groups are checked per group instead
+      const bool is_holding = rt_holding_ || rt_active_group_goals_ != nullptr;
+      if (params_.goal_tracking_statistics && active_goal)
       {
-        compute_error_for_joint(state_error_, index, state_current_, state_desired_);
+        // the trajectory time falls behind the controller time while it is scaled down
+        rt_tracking_statistics_.add(state_error_, time.nanoseconds() - traj_time_.nanoseconds());
+      }
 
-        // Always check the state tolerance on the first sample in case the first sample
-        // is the last point
-        if (
-          (before_last_point || first_sample) &&
-          !check_state_tolerance_per_joint(
-            state_error_, index, default_tolerances_.state_tolerance[index], false) &&
-          *(rt_is_holding_.readFromRT()) == false)
-        {
-          tolerance_violated_while_moving = true;
-        }
-        // past the final point, check that we end up inside goal tolerance
-        if (
-          !before_last_point &&
-          !check_state_tolerance_per_joint(
-            state_error_, index, default_tolerances_.goal_state_tolerance[index], false) &&
-          *(rt_is_holding_.readFromRT()) == false)
-        {
-          outside_goal_tolerance = true;
+      // Always check the state tolerance on the first sample in case the first sample
+      // is the last point
+      if (
+        (before_last_point || first_sample) && !is_holding &&
+        !check_state_tolerance(state_error_, active_tolerances_.state_tolerance_arrays))
+      {
+        tolerance_violated_while_moving = true;
+      }
+      // past the final point, check that we end up inside goal tolerance
+      if (
+        !before_last_point && !is_holding &&
+        !check_state_tolerance(state_error_, active_tolerances_.goal_state_tolerance_arrays))
+      {
+        outside_goal_tolerance = true;
 
-          if (default_tolerances_.goal_time_tolerance != 0.0)
+        if (active_tolerances_.tolerances.goal_time_tolerance != 0.0)
+        {
+          if (time_difference > active_tolerances_.tolerances.goal_time_tolerance)
           {
-            if (time_difference > default_tolerances_.goal_time_tolerance)
-            {
-              within_goal_time = false;
-            }
+            within_goal_time = false;
           }
         }
       }
+      if (rt_active_group_goals_ && !rt_holding_ && check_group_goals(time, first_sample))
+      {
+        compute_error(state_error_, state_current_, state_desired_);
+      }
+      CONTROLLER_TRACEPOINT(stage_end, this, "check_tolerances");
 
       // set values for next hardware write() if tolerance is met
       if (!tolerance_violated_while_moving && within_goal_time)
       {
-        if (use_closed_loop_pid_adapter_)
-        {
-          // Update PIDs
-          for (auto i = 0ul; i < dof_; ++i)
-          {
-            tmp_command_[i] = (state_desired_.velocities[i] * ff_velocity_scale_[i]) +
-                              pids_[i]->computeCommand(
-                                state_error_.positions[i], state_error_.velocities[i],
-                                (uint64_t)period.nanoseconds());
-          }
-        }
-
-        // set values for next hardware write()
-        if (has_position_command_interface_)
-        {
-          assign_interface_from_point(joint_command_interface_[0], state_desired_.positions);
-        }
-        if (has_velocity_command_interface_)
-        {
-          if (use_closed_loop_pid_adapter_)
-          {
-            assign_interface_from_point(joint_command_interface_[1], tmp_command_);
-          }
-          else
-          {
-            assign_interface_from_point(joint_command_interface_[1], state_desired_.velocities);
-          }
-        }
-        if (has_acceleration_command_interface_)
-        {
-          assign_interface_from_point(joint_command_interface_[2], state_desired_.accelerations);
-        }
-        if (has_effort_command_interface_)
-        {
-          assign_interface_from_point(joint_command_interface_[3], tmp_command_);
-        }
-
-        // store the previous command. Used in open-loop control mode
-        last_commanded_state_ = state_desired_;
+        write_commands();
       }
 
       if (active_goal)
       {
-        // send feedback
-        auto feedback = std::make_shared<FollowJTrajAction::Feedback>();
-        feedback->header.stamp = time;
-        feedback->joint_names = params_.joints;
-
-        feedback->actual = state_current_;
-        feedback->desired = state_desired_;
-        feedback->error = state_error_;
-        active_goal->setFeedback(feedback);
+        // the feedback is delayed while the cycle budget is exceeded, the commands are not
+        if (
+          update_time_statistics::allows_optional_work(cycle_budget_.get()) &&
+          is_period_elapsed(time, action_feedback_period_, previous_feedback_timestamp_))
+        {
+          // send feedback, the preallocated message (joint names set on goal acceptance) is filled
+          // in place so no memory is allocated here
+          auto & feedback = active_goal->preallocated_feedback_;
+          feedback->header.stamp = time;
+          feedback->actual = state_current_;
+          feedback->desired = state_desired_;
+          feedback->error = state_error_;
+          active_goal->setFeedback(feedback);
+        }
 
         // check abort
         if (tolerance_violated_while_moving)
         {
-          auto result = std::make_shared<FollowJTrajAction::Result>();
-          result->set__error_code(FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
-          active_goal->setAborted(result);
-          // TODO(matthew-reynolds): Need a lock-free write here
-          // See https://github.com/ros-controls/ros2_controllers/issues/168
-          rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
-          rt_has_pending_goal_.writeFromNonRT(false);
-
-          RCLCPP_WARN(get_node()->get_logger(), "Aborted due to state tolerance violation");
-
-          traj_msg_external_point_ptr_.reset();
-          traj_msg_external_point_ptr_.initRT(set_hold_position());
+          finish_goal_from_rt(active_goal, FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
+
+          rt_logger_->warn("Aborted due to state tolerance violation");
+
+          switch_to_hold_from_rt(false);
         }
         // check goal tolerance
         else if (!before_last_point)
         {
           if (!outside_goal_tolerance)
           {
-            auto res = std::make_shared<FollowJTrajAction::Result>();
-            res->set__error_code(FollowJTrajAction::Result::SUCCESSFUL);
-            active_goal->setSucceeded(res);
-            // TODO(matthew-reynolds): Need a lock-free write here
-            // See https://github.com/ros-controls/ros2_controllers/issues/168
-            rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
-            rt_has_pending_goal_.writeFromNonRT(false);
-
-            RCLCPP_INFO(get_node()->get_logger(), "Goal reached, success!");
-
-            traj_msg_external_point_ptr_.reset();
-            traj_msg_external_point_ptr_.initRT(set_success_trajectory_point());
+            finish_goal_from_rt(active_goal, FollowJTrajAction::Result::SUCCESSFUL);
+
+            rt_logger_->info("Goal reached, success!");
+
+            if (!start_queued_goal_from_rt(active_goal))
+            {
+              switch_to_hold_from_rt(true);
+            }
           }
           else if (!within_goal_time)
           {
-            auto result = std::make_shared<FollowJTrajAction::Result>();
-            result->set__error_code(FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
-            active_goal->setAborted(result);
-            // TODO(matthew-reynolds): Need a lock-free write here
-            // See https://github.com/ros-controls/ros2_controllers/issues/168
-            rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
-            rt_has_pending_goal_.writeFromNonRT(false);
-
-            RCLCPP_WARN(
-              get_node()->get_logger(), "Aborted due goal_time_tolerance exceeding by %f seconds",
-              time_difference);
-
-            traj_msg_external_point_ptr_.reset();
-            traj_msg_external_point_ptr_.initRT(set_hold_position());
+            finish_goal_from_rt(active_goal, FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
+
+            rt_logger_->warn(
+              "Aborted due goal_time_tolerance exceeding by %f seconds", time_difference);
+
+            switch_to_hold_from_rt(false);
           }
         }
       }
-      else if (tolerance_violated_while_moving && *(rt_has_pending_goal_.readFromRT()) == false)
+      else if (tolerance_violated_while_moving && has_pending_goal == false)
       {
         // we need to ensure that there is no pending goal -> we get a race condition otherwise
-        RCLCPP_ERROR(get_node()->get_logger(), "Holding position due to state tolerance violation");
+        rt_logger_->error("Holding position due to state tolerance violation");
 
-        traj_msg_external_point_ptr_.reset();
-        traj_msg_external_point_ptr_.initRT(set_hold_position());
+        switch_to_hold_from_rt(false);
       }
-      else if (
-        !before_last_point && !within_goal_time && *(rt_has_pending_goal_.readFromRT()) == false)
+      else if (!before_last_point && !within_goal_time && has_pending_goal == false)
       {
-        RCLCPP_ERROR(get_node()->get_logger(), "Exceeded goal_time_tolerance: holding position...");
+        rt_logger_->error("Exceeded goal_time_tolerance: holding position...");
 
-        traj_msg_external_point_ptr_.reset();
-        traj_msg_external_point_ptr_.initRT(set_hold_position());
+        switch_to_hold_from_rt(false);
       }
       // else, run another cycle while waiting for outside_goal_tolerance
       // to be satisfied (will stay in this state until new message arrives)
       // or outside_goal_tolerance violated within the goal_time_tolerance
+
+      // stopped before the limits found by the look-ahead
+      if (rt_look_ahead_scaling_rate_ > 0.0 && rt_look_ahead_scaling_ == 0.0 && !rt_holding_)
+      {
+        if (active_goal)
+        {
+          finish_goal_from_rt(active_goal, FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
+        }
+        rt_logger_->warn("Stopped before violating the look-ahead limits");
+
+        switch_to_hold_from_rt(false);
+      }
     }
   }
 
+  if (horizon_slot_ && !horizon_exported)
+  {
+    export_trajectory_horizon(time, false);
+  }
+
+  CONTROLLER_TRACEPOINT(stage_begin, this, "publish_state");
   publish_state(time, state_desired_, state_current_, state_error_);
+  CONTROLLER_TRACEPOINT(stage_end, this, "publish_state");
+
+  if (trajectory_recorder_)
+  {
+    trajectory_recorder_->record_update(
+      time.nanoseconds(), period.nanoseconds(), state_interfaces_, command_interfaces_);
+  }
   return controller_interface::return_type::OK;
 }
 
-void JointTrajectoryController::read_state_from_state_interfaces(JointTrajectoryPoint & state)
+bool JointTrajectoryController::update_velocity_stream(
+  const rclcpp::Time & time, const rclcpp::Duration & period, const bool take_shm_points)
 {
-  auto assign_point_from_interface =
-    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
+  bool new_point =
+    velocity_stream_.pop_until(time.nanoseconds(), rt_stream_velocities_, rt_stream_stamp_ns_);
+  // the velocities of the ring apply from now on, and replace a point of the topic, the timeout
+  // counts from the stamp of the writer, zero or a future stamp meaning now
+  if (
+    take_shm_points && shm_ingress_ &&
+    shm_ingress_->read_latest(rt_shm_stamp_ns_, rt_shm_velocities_) &&
+    std::all_of(
+      rt_shm_velocities_.begin(), rt_shm_velocities_.end(),
+      [](const double velocity) { return std::isfinite(velocity); }))
   {
-    for (size_t index = 0; index < dof_; ++index)
-    {
-      trajectory_point_interface[index] = joint_interface[index].get().get_value();
-    }
-  };
-
-  // Assign values from the hardware
-  // Position states always exist
-  assign_point_from_interface(state.positions, joint_state_interface_[0]);
-  // velocity and acceleration states are optional
-  if (has_velocity_state_interface_)
+    rt_stream_velocities_.assign(rt_shm_velocities_.begin(), rt_shm_velocities_.end());
+    rt_stream_stamp_ns_ = rt_shm_stamp_ns_ > 0 && rt_shm_stamp_ns_ < time.nanoseconds()
+                            ? rt_shm_stamp_ns_
+                            : time.nanoseconds();
+    new_point = true;
+  }
+  if (new_point)
   {
-    assign_point_from_interface(state.velocities, joint_state_interface_[1]);
-    // Acceleration is used only in combination with velocity
-    if (has_acceleration_state_interface_)
+    if (!rt_streaming_velocity_)
     {
-      assign_point_from_interface(state.accelerations, joint_state_interface_[2]);
-    }
-    else
-    {
-      // Make empty so the property is ignored during interpolation
-      state.accelerations.clear();
+      // continue from the last command, the trajectory is not followed anymore
+      rt_streaming_velocity_ = true;
+      rt_following_file_ = false;
+      rt_is_holding_ = true;
+      rt_holding_ = true;
+      state_desired_.positions.assign(
+        last_commanded_state_.positions.begin(), last_commanded_state_.positions.end());
+      state_desired_.velocities.assign(dof_, 0.0);
     }
   }
-  else
+  if (!rt_streaming_velocity_)
   {
-    // Make empty so the property is ignored during interpolation
-    state.velocities.clear();
-    state.accelerations.clear();
+    return false;
   }
-}
-
-bool JointTrajectoryController::read_state_from_command_interfaces(JointTrajectoryPoint & state)
-{
-  bool has_values = true;
-
-  auto assign_point_from_interface =
-    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
-  {
-    for (size_t index = 0; index < dof_; ++index)
-    {
-      trajectory_point_interface[index] = joint_interface[index].get().get_value();
-    }
-  };
 
-  auto interface_has_values = [](const auto & joint_interface)
+  // stop if the stream stalls, e.g., the teleoperation lost its connection
+  const bool timed_out = static_cast<double>(time.nanoseconds() - rt_stream_stamp_ns_) / 1e9 >
+                         params_.velocity_streaming.timeout;
+  const double dt = period.seconds() * speed_scaling_factor_;
+  for (size_t i = 0; i < dof_; ++i)
   {
-    return std::find_if(
-             joint_interface.begin(), joint_interface.end(),
-             [](const auto & interface)
-             { return std::isnan(interface.get().get_value()); }) == joint_interface.end();
-  };
+    const double velocity = timed_out ? 0.0 : rt_stream_velocities_[i];
+    state_desired_.positions[i] += velocity * dt;
+    state_desired_.velocities[i] = velocity * speed_scaling_factor_;
+  }
+  state_desired_.accelerations.assign(dof_, 0.0);
+  return true;
+}
 
-  // Assign values from the command interfaces as state. Therefore needs check for both.
-  // Position state interface has to exist always
-  if (has_position_command_interface_ && interface_has_values(joint_command_interface_[0]))
+void JointTrajectoryController::take_file_trajectory()
+{
+  const auto new_file = *file_trajectory_buffer_.read_from_rt();
+  if (new_file == rt_file_trajectory_)
   {
-    assign_point_from_interface(state.positions, joint_command_interface_[0]);
+    return;
   }
-  else
+  rt_released_file_trajectories_.retain(rt_file_trajectory_);
+  rt_file_trajectory_ = new_file;
+  if (rt_file_trajectory_)
   {
-    state.positions.clear();
-    has_values = false;
+    // continue from the last command, like a new trajectory msg does
+    rt_file_trajectory_->start(params_.open_loop_control ? last_commanded_state_ : state_current_);
+    rt_file_time_ns_ = 0;
+    rt_following_file_ = true;
+    rt_streaming_velocity_ = false;
+    rt_is_holding_ = true;
+    rt_holding_ = true;
   }
-  // velocity and acceleration states are optional
-  if (has_velocity_state_interface_)
+  else if (rt_following_file_)
   {
-    if (has_velocity_command_interface_ && interface_has_values(joint_command_interface_[1]))
-    {
-      assign_point_from_interface(state.velocities, joint_command_interface_[1]);
-    }
-    else
-    {
-      state.velocities.clear();
-      has_values = false;
-    }
+    rt_following_file_ = false;
+    switch_to_hold_from_rt(false);
   }
-  else
+}
+
+void JointTrajectoryController::update_file_trajectory(const rclcpp::Duration & period)
+{
+  CONTROLLER_TRACEPOINT(stage_begin, this, "sample");
+  // the last point is commanded after the end of the file
+  rt_file_trajectory_->sample(rt_file_time_ns_, state_desired_);
+  CONTROLLER_TRACEPOINT(stage_end, this, "sample");
+  // warp the time of the file like the one of a trajectory
+  rt_file_time_ns_ +=
+    static_cast<int64_t>(static_cast<double>(period.nanoseconds()) * speed_scaling_factor_);
+}
+
+std::vector<hardware_interface::CommandInterface>
+JointTrajectoryController::on_export_reference_interfaces()
+{
+  // positions of all joints, followed by their velocities
+  reference_interfaces_.resize(2 * dof_, std::numeric_limits<double>::quiet_NaN());
+
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.reserve(reference_interfaces_.size());
+  for (size_t i = 0; i < dof_; ++i)
   {
-    state.velocities.clear();
+    reference_interfaces.push_back(hardware_interface::CommandInterface(
+      get_node()->get_name(), params_.joints[i] + "/" + hardware_interface::HW_IF_POSITION,
+      &reference_interfaces_[i]));
   }
-  // Acceleration is used only in combination with velocity
-  if (has_acceleration_state_interface_)
+  for (size_t i = 0; i < dof_; ++i)
   {
-    if (has_acceleration_command_interface_ && interface_has_values(joint_command_interface_[2]))
-    {
-      assign_point_from_interface(state.accelerations, joint_command_interface_[2]);
-    }
-    else
+    reference_interfaces.push_back(hardware_interface::CommandInterface(
+      get_node()->get_name(), params_.joints[i] + "/" + hardware_interface::HW_IF_VELOCITY,
+      &reference_interfaces_[dof_ + i]));
+  }
+  return reference_interfaces;
+}
+
+bool JointTrajectoryController::on_set_chained_mode(bool /*chained_mode*/)
+{
+  // the mode is switched while inactive, the controller holds the position on activation anyway
+  return true;
+}
+
+bool JointTrajectoryController::is_velocity_stream_point(
+  const trajectory_msgs::msg::JointTrajectory & trajectory) const
+{
+  if (
+    !params_.velocity_streaming.enable || trajectory.points.size() != 1 ||
+    trajectory.joint_names.size() != dof_)
+  {
+    return false;
+  }
+  const auto & point = trajectory.points[0];
+  if (
+    !point.positions.empty() || !point.accelerations.empty() || !point.effort.empty() ||
+    point.velocities.size() != dof_ ||
+    !std::all_of(
+      point.velocities.begin(), point.velocities.end(), [](double v) { return std::isfinite(v); }))
+  {
+    return false;
+  }
+  // all joints of the controller, in any order
+  return std::is_permutation(
+    trajectory.joint_names.begin(), trajectory.joint_names.end(), params_.joints.begin());
+}
+
+bool JointTrajectoryController::read_desired_state_from_reference_interfaces(
+  JointTrajectoryPoint & desired) const
+{
+  if (reference_interfaces_.size() != 2 * dof_)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    if (std::isnan(reference_interfaces_[i]))
     {
-      state.accelerations.clear();
-      has_values = false;
+      return false;
     }
   }
-  else
+  // the fields were reserved for all joints on configuration
+  desired.positions.assign(reference_interfaces_.begin(), reference_interfaces_.begin() + dof_);
+  desired.velocities.resize(dof_);
+  for (size_t i = 0; i < dof_; ++i)
   {
-    state.accelerations.clear();
+    const double velocity = reference_interfaces_[dof_ + i];
+    desired.velocities[i] = std::isnan(velocity) ? 0.0 : velocity;
   }
-
-  return has_values;
+  desired.accelerations.assign(dof_, 0.0);
+  return true;
 }
 
-bool JointTrajectoryController::read_commands_from_command_interfaces(
-  JointTrajectoryPoint & commands)
+void JointTrajectoryController::update_look_ahead_scaling(const rclcpp::Duration & period)
 {
-  bool has_values = true;
+  // start to decelerate once the look-ahead found a violation of the current trajectory
+  if (
+    rt_look_ahead_scaling_rate_ == 0.0 && !rt_holding_ &&
+    look_ahead_generation_.load(std::memory_order_acquire) == rt_trajectory_generation_)
+  {
+    const double time_to_violation =
+      static_cast<double>(
+        look_ahead_violation_time_ns_.load(std::memory_order_relaxed) - traj_time_.nanoseconds()) /
+      1e9;
+    // with a linear ramp of the scaling, the trajectory time advances by half of the deceleration
+    // time, so it is shortened to stop before the violation
+    double deceleration_time = params_.look_ahead.deceleration_time;
+    if (speed_scaling_factor_ > 0.0)
+    {
+      deceleration_time =
+        std::min(deceleration_time, 2.0 * std::max(time_to_violation, 0.0) / speed_scaling_factor_);
+    }
+    rt_look_ahead_scaling_rate_ = deceleration_time > 0.0
+                                    ? 1.0 / deceleration_time
+                                    : std::numeric_limits<double>::infinity();
+    rt_logger_->warn(
+      "Look-ahead limits are violated in %f s of the trajectory, decelerating within %f s",
+      time_to_violation, deceleration_time);
+  }
+  if (rt_look_ahead_scaling_rate_ > 0.0)
+  {
+    rt_look_ahead_scaling_ =
+      std::max(0.0, rt_look_ahead_scaling_ - period.seconds() * rt_look_ahead_scaling_rate_);
+  }
+}
 
+void JointTrajectoryController::read_state_from_state_interfaces(JointTrajectoryPoint & state)
+{
+  // the interfaces of the i-th type start at i * dof_ in the flattened array
   auto assign_point_from_interface =
-    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
+    [&](std::vector<double> & trajectory_point_interface, size_t interface_index)
   {
+    const auto * const * state_interface = rt_state_interfaces_.data() + interface_index * dof_;
+    double * values = trajectory_point_interface.data();
     for (size_t index = 0; index < dof_; ++index)
     {
-      trajectory_point_interface[index] = joint_interface[index].get().get_value();
+      values[index] = state_interface[index]->get_value();
     }
   };
 
-  auto interface_has_values = [](const auto & joint_interface)
-  {
-    return std::find_if(
-             joint_interface.begin(), joint_interface.end(),
-             [](const auto & interface)
-             { return std::isnan(interface.get().get_value()); }) == joint_interface.end();
-  };
-
-  // Assign values from the command interfaces as command.
-  if (has_position_command_interface_)
+  // Assign values from the hardware
+  // Position states always exist
+  assign_point_from_interface(state.positions, 0);
+  // velocity and acceleration states are optional
+  if (has_velocity_state_interface_)
   {
-    if (interface_has_values(joint_command_interface_[0]))
+    assign_point_from_interface(state.velocities, 1);
+    // Acceleration is used only in combination with velocity
+    if (has_acceleration_state_interface_)
     {
-      assign_point_from_interface(commands.positions, joint_command_interface_[0]);
+      assign_point_from_interface(state.accelerations, 2);
     }
     else
     {
-      commands.positions.clear();
-      has_values = false;
+      // Make empty so the property is ignored during interpolation
+      state.accelerations.clear();
     }
   }
-  if (has_velocity_command_interface_)
+  else
+  {
+    // Make empty so the property is ignored during interpolation
+    state.velocities.clear();
+    state.accelerations.clear();
+  }
+}
+
+bool JointTrajectoryController::read_state_from_command_interfaces(JointTrajectoryPoint & state)
+{
+  bool has_values = true;
+
+  // reads every interface once, the values are dropped if any of them is NaN
+  auto assign_point_from_interface =
+    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
   {
-    if (interface_has_values(joint_command_interface_[1]))
+    trajectory_point_interface.resize(dof_);
+    if (interface_values::copy_values(joint_interface, trajectory_point_interface.begin()) != 0)
     {
-      assign_point_from_interface(commands.velocities, joint_command_interface_[1]);
+      trajectory_point_interface.clear();
+      return false;
     }
-    else
+    return true;
+  };
+
+  // Assign values from the command interfaces as state. Therefore needs check for both.
+  // Position state interface has to exist always
+  if (
+    !has_position_command_interface_ ||
+    !assign_point_from_interface(state.positions, joint_command_interface_[0]))
+  {
+    state.positions.clear();
+    has_values = false;
+  }
+  // velocity and acceleration states are optional
+  if (has_velocity_state_interface_)
+  {
+    if (
+      !has_velocity_command_interface_ ||
+      !assign_point_from_interface(state.velocities, joint_command_interface_[1]))
     {
-      commands.velocities.clear();
+      state.velocities.clear();
       has_values = false;
     }
   }
-  if (has_acceleration_command_interface_)
+  else
   {
-    if (interface_has_values(joint_command_interface_[2]))
-    {
-      assign_point_from_interface(commands.accelerations, joint_command_interface_[2]);
-    }
-    else
+    state.velocities.clear();
+  }
+  // Acceleration is used only in combination with velocity
+  if (has_acceleration_state_interface_)
+  {
+    if (
+      !has_acceleration_command_interface_ ||
+      !assign_point_from_interface(state.accelerations, joint_command_interface_[2]))
     {
-      commands.accelerations.clear();
+      state.accelerations.clear();
       has_values = false;
     }
   }
-  if (has_effort_command_interface_)
+  else
   {
-    if (interface_has_values(joint_command_interface_[3]))
-    {
-      assign_point_from_interface(commands.effort, joint_command_interface_[3]);
-    }
-    else
+    state.accelerations.clear();
+  }
+
+  return has_values;
+}
+
+bool JointTrajectoryController::read_commands_from_command_interfaces(
+  JointTrajectoryPoint & commands)
+{
+  bool has_values = true;
+
+  // reads every interface once, the values are dropped if any of them is NaN
+  auto assign_point_from_interface =
+    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
+  {
+    trajectory_point_interface.resize(dof_);
+    if (interface_values::copy_values(joint_interface, trajectory_point_interface.begin()) != 0)
     {
-      commands.effort.clear();
+      trajectory_point_interface.clear();
       has_values = false;
     }
+  };
+
+  // Assign values from the command interfaces as command.
+  if (has_position_command_interface_)
+  {
+    assign_point_from_interface(commands.positions, joint_command_interface_[0]);
+  }
+  if (has_velocity_command_interface_)
+  {
+    assign_point_from_interface(commands.velocities, joint_command_interface_[1]);
+  }
+  if (has_acceleration_command_interface_)
+  {
+    assign_point_from_interface(commands.accelerations, joint_command_interface_[2]);
+  }
+  if (has_effort_command_interface_)
+  {
+    assign_point_from_interface(commands.effort, joint_command_interface_[3]);
   }
 
   return has_values;
@@ -603,19 +1009,20 @@ void JointTrajectoryController::query_state_service(
     response->success = false;
     return;
   }
-  const auto active_goal = *rt_active_goal_.readFromRT();
   response->name = params_.joints;
   trajectory_msgs::msg::JointTrajectoryPoint state_requested = state_current_;
-  if (has_active_trajectory())
+  // the trajectory of update() must not be sampled here, it is changed by every sample
+  const auto trajectory = get_trajectory_snapshot();
+  if (trajectory && trajectory->has_trajectory_msg())
   {
     TrajectoryPointConstIter start_segment_itr, end_segment_itr;
-    response->success = traj_external_point_ptr_->sample(
+    response->success = trajectory->sample_at(
       static_cast<rclcpp::Time>(request->time), interpolation_method_, state_requested,
       start_segment_itr, end_segment_itr);
     // If the requested sample time precedes the trajectory finish time respond as failure
     if (response->success)
     {
-      if (end_segment_itr == traj_external_point_ptr_->end())
+      if (end_segment_itr == trajectory->end())
       {
         RCLCPP_ERROR(logger, "Requested sample time precedes the current trajectory end time.");
         response->success = false;
@@ -637,6 +1044,93 @@ void JointTrajectoryController::query_state_service(
   response->acceleration = state_requested.accelerations;
 }
 
+std::shared_ptr<const Trajectory> JointTrajectoryController::get_trajectory_snapshot(
+  uint64_t * generation)
+{
+  std::lock_guard<std::mutex> guard(trajectory_snapshot_mutex_);
+  if (rt_trajectory_snapshots_.update_read_buffer())
+  {
+    const auto & snapshot = rt_trajectory_snapshots_.read_buffer();
+    trajectory_snapshot_ = std::make_shared<const Trajectory>(snapshot.trajectory);
+    trajectory_snapshot_generation_ = snapshot.generation;
+  }
+  if (generation)
+  {
+    *generation = trajectory_snapshot_generation_;
+  }
+  return trajectory_snapshot_;
+}
+
+void JointTrajectoryController::check_look_ahead()
+{
+  uint64_t generation = 0;
+  const auto trajectory = get_trajectory_snapshot(&generation);
+  // the first violation of a trajectory is enough
+  if (
+    !trajectory || !trajectory->has_nontrivial_msg() || rt_is_holding_ ||
+    look_ahead_generation_.load(std::memory_order_relaxed) == generation)
+  {
+    return;
+  }
+
+  // sample_range() changes the caches of the trajectory, so a copy of the snapshot is sampled
+  Trajectory look_ahead_trajectory = *trajectory;
+  // update() stores the time before the snapshot, so it belongs to this or a newer trajectory
+  const rclcpp::Time start_time(
+    rt_traj_time_ns_.load(std::memory_order_relaxed),
+    trajectory->time_from_start().get_clock_type());
+  const auto sample_period = rclcpp::Duration::from_seconds(params_.look_ahead.sample_period);
+  const auto num_samples =
+    static_cast<size_t>(params_.look_ahead.horizon / params_.look_ahead.sample_period) + 1;
+  look_ahead_trajectory.sample_range(
+    start_time, sample_period, num_samples, interpolation_method_, look_ahead_samples_);
+
+  const size_t violation = find_look_ahead_violation(look_ahead_samples_, look_ahead_limits_);
+  if (violation < look_ahead_samples_.num_samples)
+  {
+    // update() ignores the violation if it follows another trajectory by now
+    look_ahead_violation_time_ns_.store(
+      start_time.nanoseconds() + static_cast<int64_t>(violation) * sample_period.nanoseconds(),
+      std::memory_order_relaxed);
+    look_ahead_generation_.store(generation, std::memory_order_release);
+  }
+}
+
+void JointTrajectoryController::export_trajectory_horizon(
+  const rclcpp::Time & time, const bool has_trajectory)
+{
+  horizon_.stamp_nanoseconds = time.nanoseconds();
+  horizon_.start_nanoseconds = 0;
+  horizon_.period_nanoseconds = 0;
+  horizon_.num_samples = 0;
+  horizon_.positions.clear();
+  horizon_.velocities.clear();
+  horizon_.accelerations.clear();
+  if (has_trajectory)
+  {
+    // sampled in the trajectory time, without the speed scaling of the following updates
+    const auto sample_period =
+      rclcpp::Duration::from_seconds(params_.trajectory_horizon.sample_period);
+    horizon_.start_nanoseconds = traj_time_.nanoseconds();
+    horizon_.period_nanoseconds = sample_period.nanoseconds();
+    traj_external_point_ptr_->sample_range(
+      traj_time_, sample_period, static_cast<size_t>(params_.trajectory_horizon.num_samples),
+      interpolation_method_, horizon_samples_);
+    if (horizon_samples_.dim == dof_)
+    {
+      horizon_.num_samples = horizon_samples_.num_samples;
+      // within the reserved capacity, no memory is allocated
+      horizon_.positions.assign(
+        horizon_samples_.positions.begin(), horizon_samples_.positions.end());
+      horizon_.velocities.assign(
+        horizon_samples_.velocities.begin(), horizon_samples_.velocities.end());
+      horizon_.accelerations.assign(
+        horizon_samples_.accelerations.begin(), horizon_samples_.accelerations.end());
+    }
+  }
+  horizon_slot_->write(horizon_);
+}
+
 controller_interface::CallbackReturn JointTrajectoryController::on_configure(
   const rclcpp_lifecycle::State &)
 {
@@ -647,15 +1141,32 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
     RCLCPP_ERROR(get_node()->get_logger(), "Error encountered during init");
     return controller_interface::CallbackReturn::ERROR;
   }
+  // names the handle of the tracepoints of the updates
+  CONTROLLER_TRACEPOINT(controller_init, this, get_node()->get_name());
+  const auto configure_start = update_time_statistics::StartupProfile::Clock::now();
 
-  // update the dynamic map parameters
-  param_listener_->refresh_dynamic_parameters();
-
-  // get parameters from the listener in case they were updated
+  // The keys of the map parameters, i.e., 'joints', are read-only, so the parameter listener
+  // declared all of them on init and their changes reach it by its parameter callback. Refreshing
+  // the dynamic parameters would format, read and validate every one of them again.
   params_ = param_listener_->get_params();
 
   // get degrees of freedom
   dof_ = params_.joints.size();
+  joint_index_.clear();
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    joint_index_.emplace(params_.joints[i], i);
+  }
+  mapped_joint_names_.clear();
+  joint_mapping_.clear();
+  joint_mapping_.reserve(dof_);
+  sort_scratch_.reserve(dof_);
+  if (params_.goal_tracking_statistics)
+  {
+    // the statistics are copied into the requests of the channel without allocating
+    rt_tracking_statistics_.configure(dof_);
+    goal_state_channel_.prepare_payloads(rt_tracking_statistics_);
+  }
 
   // TODO(destogl): why is this here? Add comment or move
   if (!reset())
@@ -712,19 +1223,25 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
 
   if (use_closed_loop_pid_adapter_)
   {
-    pids_.resize(dof_);
+    pid_bank_.resize(dof_);
     ff_velocity_scale_.resize(dof_);
     tmp_command_.resize(dof_, 0.0);
-
-    update_pids();
   }
+  store_dynamic_parameters(params_);
+  runtime_parameters_.initRT(make_runtime_parameters(params_));
+  update_runtime_parameters();
 
   // Configure joint position error normalization from ROS parameters (angle_wraparound)
   joints_angle_wraparound_.resize(dof_);
+  wraparound_joint_indices_.clear();
   for (size_t i = 0; i < dof_; ++i)
   {
     const auto & gains = params_.gains.joints_map.at(params_.joints[i]);
     joints_angle_wraparound_[i] = gains.angle_wraparound;
+    if (gains.angle_wraparound)
+    {
+      wraparound_joint_indices_.push_back(i);
+    }
   }
 
   if (params_.state_interfaces.empty())
@@ -798,19 +1315,95 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
   RCLCPP_INFO(
     logger, "Using '%s' interpolation method.",
     interpolation_methods::InterpolationMethodMap.at(interpolation_method_).c_str());
+  use_compact_storage_ =
+    compact_value_type_from_string(params_.trajectory_storage, compact_value_type_);
 
   // prepare hold_position_msg
   init_hold_position_msg();
 
+  // the recorder is ready before the first msg of the subscriber
+  trajectory_recorder_.reset();
+  if (params_.recording.enable)
+  {
+    if (params_.recording.path.empty())
+    {
+      RCLCPP_ERROR(logger, "'recording.path' has to be set if 'recording.enable' is true.");
+      return CallbackReturn::ERROR;
+    }
+    rcl_interfaces::msg::ParameterEvent parameters;
+    for (const auto & parameter :
+         get_node()->get_parameters(get_node()->list_parameters({}, 0).names))
+    {
+      parameters.new_parameters.push_back(parameter.to_parameter_msg());
+    }
+    trajectory_recorder_ = std::make_unique<TrajectoryRecorder>();
+    if (!trajectory_recorder_->open(
+          params_.recording.path, get_node()->get_name(), serialize_record_payload(parameters)))
+    {
+      RCLCPP_ERROR(
+        logger, "Can't write the recording to '%s'.", params_.recording.path.c_str());
+      trajectory_recorder_.reset();
+      return CallbackReturn::ERROR;
+    }
+    RCLCPP_INFO(logger, "Recording to '%s'.", params_.recording.path.c_str());
+  }
+
+  horizon_slot_.reset();
+  if (params_.trajectory_horizon.enable)
+  {
+    const auto num_samples = static_cast<size_t>(params_.trajectory_horizon.num_samples);
+    horizon_slot_ = trajectory_horizon_exchange::TrajectoryHorizonExchange::get_instance().get_slot(
+      get_node()->get_fully_qualified_name());
+    horizon_slot_->configure(num_samples, dof_);
+    for (auto * samples : {&horizon_samples_.positions, &horizon_samples_.velocities,
+                           &horizon_samples_.accelerations, &horizon_.positions,
+                           &horizon_.velocities, &horizon_.accelerations})
+    {
+      samples->reserve(num_samples * dof_);
+    }
+    resize_joint_trajectory_point(horizon_samples_.sample_state, dof_);
+    horizon_.num_joints = dof_;
+  }
+
   // create subscriber and publishers
-  joint_command_subscriber_ =
-    get_node()->create_subscription<trajectory_msgs::msg::JointTrajectory>(
-      "~/joint_trajectory", rclcpp::SystemDefaultsQoS(),
-      std::bind(&JointTrajectoryController::topic_callback, this, std::placeholders::_1));
+  if (params_.serialized_trajectory_intake)
+  {
+    trajectory_decoder_ = std::make_unique<TrajectoryCdrDecoder>(params_.joints);
+    partial_goal_positions_.resize(dof_);
+    joint_command_subscriber_ =
+      get_node()->create_subscription<trajectory_msgs::msg::JointTrajectory>(
+        "~/joint_trajectory", rclcpp::SystemDefaultsQoS(),
+        [this](const std::shared_ptr<const rclcpp::SerializedMessage> msg)
+        { serialized_topic_callback(msg); });
+  }
+  else
+  {
+    trajectory_decoder_.reset();
+    joint_command_subscriber_ =
+      get_node()->create_subscription<trajectory_msgs::msg::JointTrajectory>(
+        "~/joint_trajectory", rclcpp::SystemDefaultsQoS(),
+        std::bind(&JointTrajectoryController::topic_callback, this, std::placeholders::_1));
+  }
+  if (params_.trajectory_file.enable)
+  {
+    file_trajectory_subscriber_ = get_node()->create_subscription<std_msgs::msg::String>(
+      "~/trajectory_file", rclcpp::SystemDefaultsQoS(),
+      std::bind(
+        &JointTrajectoryController::file_trajectory_callback, this, std::placeholders::_1));
+  }
 
   publisher_ = get_node()->create_publisher<ControllerStateMsg>(
-    "~/controller_state", rclcpp::SystemDefaultsQoS());
-  state_publisher_ = std::make_unique<StatePublisher>(publisher_);
+    "~/controller_state", publisher_pool::make_qos(params_.qos.controller_state));
+  state_publish_rate_ = telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+    get_node()->get_namespace(), publisher_->get_topic_name(), params_.state_publish_rate);
+  if (state_publish_rate_->get_rate() > 0.0)
+  {
+    RCLCPP_INFO(
+      logger, "Controller state will be published at %.2f Hz.", state_publish_rate_->get_rate());
+  }
+  state_publisher_ = std::make_unique<StatePublisher>(
+    publisher_, publisher_pool::get_shared_pool(params_.publisher_pool),
+    params_.publish_unique_ptr, static_cast<size_t>(params_.publisher_pool.queue_depth));
 
   state_publisher_->lock();
   state_publisher_->msg_.joint_names = params_.joints;
@@ -848,6 +1441,34 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
 
   state_publisher_->unlock();
 
+  bounded_state_publisher_.reset();
+  bounded_state_names_publisher_.reset();
+  if (params_.bounded_controller_state.enable)
+  {
+    if (dof_ > BoundedStateMsg::MAX_JOINTS)
+    {
+      RCLCPP_ERROR(
+        logger, "The bounded controller state holds at most %u joints, but there are %zu joints.",
+        BoundedStateMsg::MAX_JOINTS, dof_);
+      return CallbackReturn::FAILURE;
+    }
+    // without loans, a copy is published outside of the update like the controller state
+    bounded_state_publisher_ = std::make_unique<publisher_pool::LoanedPublisher<BoundedStateMsg>>(
+      get_node()->create_publisher<BoundedStateMsg>(
+        "~/bounded_controller_state", publisher_pool::make_qos(params_.qos.controller_state)),
+      publisher_pool::get_shared_pool(params_.publisher_pool), params_.publish_unique_ptr);
+    // the names are only sent once, late subscribers still get them
+    bounded_state_names_publisher_ = get_node()->create_publisher<sensor_msgs::msg::JointState>(
+      "~/bounded_controller_state/names", rclcpp::QoS(1).reliable().transient_local());
+    sensor_msgs::msg::JointState names_msg;
+    names_msg.header.stamp = get_node()->now();
+    names_msg.name = params_.joints;
+    bounded_state_names_publisher_->publish(names_msg);
+    RCLCPP_INFO(
+      logger, "The middleware %s loan the bounded controller state.",
+      bounded_state_publisher_->is_loaning() ? "does" : "doesn't");
+  }
+
   // action server configuration
   if (params_.allow_partial_joints_goal)
   {
@@ -857,6 +1478,15 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
   RCLCPP_INFO(
     logger, "Action status changes will be monitored at %.2f Hz.", params_.action_monitor_rate);
   action_monitor_period_ = rclcpp::Duration::from_seconds(1.0 / params_.action_monitor_rate);
+  if (params_.action_feedback_rate > 0.0)
+  {
+    RCLCPP_INFO(logger, "Action feedback will be sent at %.2f Hz.", params_.action_feedback_rate);
+    action_feedback_period_ = rclcpp::Duration::from_seconds(1.0 / params_.action_feedback_rate);
+  }
+  else
+  {
+    action_feedback_period_ = rclcpp::Duration::from_nanoseconds(0);
+  }
 
   using namespace std::placeholders;
   action_server_ = rclcpp_action::create_server<FollowJTrajAction>(
@@ -867,39 +1497,308 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
     std::bind(&JointTrajectoryController::goal_cancelled_callback, this, _1),
     std::bind(&JointTrajectoryController::goal_accepted_callback, this, _1));
 
+  // every joint group gets its own action server, its joints are in no other group
+  joint_groups_.clear();
+  joint_groups_.reserve(params_.joint_groups.size());
+  std::vector<bool> is_group_joint(dof_, false);
+  for (const auto & group_name : params_.joint_groups)
+  {
+    JointGroup group;
+    group.name = group_name;
+    group.joint_names = params_.groups.joint_groups_map.at(group_name).joints;
+    if (group.joint_names.empty())
+    {
+      RCLCPP_ERROR(logger, "Joint group '%s' has no joints.", group_name.c_str());
+      return CallbackReturn::FAILURE;
+    }
+    for (const auto & joint_name : group.joint_names)
+    {
+      const auto joint = joint_index_.find(joint_name);
+      if (joint == joint_index_.end())
+      {
+        RCLCPP_ERROR(
+          logger, "Joint '%s' of joint group '%s' is not a joint of the controller.",
+          joint_name.c_str(), group_name.c_str());
+        return CallbackReturn::FAILURE;
+      }
+      if (is_group_joint[joint->second])
+      {
+        RCLCPP_ERROR(logger, "Joint '%s' is in several joint groups.", joint_name.c_str());
+        return CallbackReturn::FAILURE;
+      }
+      is_group_joint[joint->second] = true;
+      group.joint_indices.push_back(joint->second);
+    }
+    joint_groups_.push_back(std::move(group));
+  }
+  if (
+    !joint_groups_.empty() &&
+    interpolation_method_ == interpolation_methods::InterpolationMethod::NONE)
+  {
+    RCLCPP_ERROR(logger, "Joint groups need an interpolation method other than 'none'.");
+    return CallbackReturn::FAILURE;
+  }
+  for (size_t group_index = 0; group_index < joint_groups_.size(); ++group_index)
+  {
+    auto & group = joint_groups_[group_index];
+    group.action_server = rclcpp_action::create_server<FollowJTrajAction>(
+      get_node()->get_node_base_interface(), get_node()->get_node_clock_interface(),
+      get_node()->get_node_logging_interface(), get_node()->get_node_waitables_interface(),
+      std::string(get_node()->get_name()) + "/" + group.name + "/follow_joint_trajectory",
+      std::bind(
+        &JointTrajectoryController::group_goal_received_callback, this, group_index, _1, _2),
+      std::bind(&JointTrajectoryController::group_goal_cancelled_callback, this, group_index, _1),
+      std::bind(&JointTrajectoryController::group_goal_accepted_callback, this, group_index, _1));
+    RCLCPP_INFO(
+      logger, "Joint group '%s' with %zu joints has its own action server.", group.name.c_str(),
+      group.joint_indices.size());
+  }
+  group_tolerances_ = get_segment_tolerances(params_);
+  group_msg_.reset();
+  rt_group_goals_.write_from_non_rt(nullptr);
+  rt_active_group_goals_.reset();
+  rt_finished_group_goals_.assign(joint_groups_.size(), nullptr);
+  rt_unpushed_group_goals_.assign(joint_groups_.size(), nullptr);
+  rt_unpushed_group_error_codes_.assign(joint_groups_.size(), 0);
+  rt_group_holding_.assign(joint_groups_.size(), false);
+  rt_group_hold_positions_.assign(dof_, 0.0);
+
   resize_joint_trajectory_point(state_current_, dof_);
+  rt_hold_positions_.assign(std::vector<double>(dof_, std::numeric_limits<double>::quiet_NaN()));
   resize_joint_trajectory_point_command(command_current_, dof_);
   resize_joint_trajectory_point(state_desired_, dof_);
   resize_joint_trajectory_point(state_error_, dof_);
   resize_joint_trajectory_point(last_commanded_state_, dof_);
+  if (params_.velocity_streaming.enable)
+  {
+    velocity_stream_.resize(static_cast<size_t>(params_.velocity_streaming.capacity), dof_);
+    rt_stream_velocities_.assign(dof_, 0.0);
+  }
+  // the segment of the previous configuration is removed first
+  shm_ingress_.reset();
+  if (params_.shm_ingress.enable)
+  {
+    if (!params_.velocity_streaming.enable)
+    {
+      RCLCPP_ERROR(logger, "The shared memory ingress needs 'velocity_streaming.enable'.");
+      return CallbackReturn::FAILURE;
+    }
+    const std::string name = params_.shm_ingress.name.empty()
+                               ? "/" + std::string(get_node()->get_name()) + "_commands"
+                               : params_.shm_ingress.name;
+    shm_ingress_ = std::make_unique<shm_command_ingress::ShmCommandRing>();
+    std::string error;
+    if (!shm_ingress_->create(name, dof_, static_cast<size_t>(params_.shm_ingress.slots), error))
+    {
+      RCLCPP_ERROR(logger, "%s", error.c_str());
+      shm_ingress_.reset();
+      return CallbackReturn::ERROR;
+    }
+    rt_shm_velocities_.assign(dof_, 0.0);
+    RCLCPP_INFO(logger, "Polling the streamed velocities of '%s'", name.c_str());
+  }
+  // update() drops at most a few msgs per new trajectory, goal_monitor_ releases them every period
+  rt_released_msgs_.resize(64);
+  rt_released_queued_goals_.resize(8);
+  rt_released_file_trajectories_.resize(8);
+  rt_released_storages_.resize(8);
+  rt_released_group_goals_.resize(8);
+  // sampling fills all fields of these points, independent of the configured interfaces. Reserve
+  // the memory now, so that the realtime loop only copies into it
+  for (auto * point : {&state_desired_, &last_commanded_state_})
+  {
+    point->positions.reserve(dof_);
+    point->velocities.reserve(dof_);
+    point->accelerations.reserve(dof_);
+    point->effort.reserve(dof_);
+  }
 
   query_state_srv_ = get_node()->create_service<control_msgs::srv::QueryTrajectoryState>(
     std::string(get_node()->get_name()) + "/query_state",
     std::bind(&JointTrajectoryController::query_state_service, this, _1, _2));
 
+  update_time_statistics_.reset();
+  if (params_.update_statistics.enable)
+  {
+    update_time_statistics_ = std::make_unique<update_time_statistics::UpdateTimeStatistics>();
+    if (!update_time_statistics_->configure(
+          get_node(), "~/statistics", static_cast<size_t>(params_.update_statistics.window_size)))
+    {
+      return CallbackReturn::ERROR;
+    }
+  }
+  cycle_budget_ = update_time_statistics::make_cycle_budget(
+    params_.cycle_budget, static_cast<double>(get_update_rate()));
+
+  if (params_.hot_standby)
+  {
+    prepare_hot_standby();
+    RCLCPP_INFO(logger, "Prepared for the activation in hot standby.");
+  }
+
+  startup_profile_.add(
+    "configure", update_time_statistics::StartupProfile::Clock::now() - configure_start);
+  RCLCPP_DEBUG(
+    logger, "Startup with %zu parameters: %s",
+    update_time_statistics::count_parameters(get_node()->get_node_parameters_interface()),
+    startup_profile_.summary().c_str());
   return CallbackReturn::SUCCESS;
 }
 
-controller_interface::CallbackReturn JointTrajectoryController::on_activate(
-  const rclcpp_lifecycle::State &)
+void JointTrajectoryController::prepare_hot_standby()
 {
-  // update the dynamic map parameters
-  param_listener_->refresh_dynamic_parameters();
-
-  // get parameters from the listener in case they were updated
-  params_ = param_listener_->get_params();
-
-  // parse remaining parameters
-  default_tolerances_ = get_segment_tolerances(params_);
-
-  // order all joints in the storage
-  for (const auto & interface : params_.command_interfaces)
+  // the full names bound on activation, and the capacity for the bound interfaces
+  standby_command_interface_names_.assign(allowed_interface_types_.size(), {});
+  standby_state_interface_names_.assign(allowed_interface_types_.size(), {});
+  for (size_t index = 0; index < allowed_interface_types_.size(); ++index)
+  {
+    const auto & interface_type = allowed_interface_types_[index];
+    if (contains_interface_type(params_.command_interfaces, interface_type))
+    {
+      for (const auto & joint_name : command_joint_names_)
+      {
+        standby_command_interface_names_[index].push_back(joint_name + "/" + interface_type);
+      }
+    }
+    if (contains_interface_type(params_.state_interfaces, interface_type))
+    {
+      for (const auto & joint_name : params_.joints)
+      {
+        standby_state_interface_names_[index].push_back(joint_name + "/" + interface_type);
+      }
+    }
+    joint_command_interface_[index].reserve(dof_);
+    joint_state_interface_[index].reserve(dof_);
+  }
+  command_sources_.reserve(allowed_interface_types_.size());
+  rt_command_interfaces_.reserve(allowed_interface_types_.size() * dof_);
+  rt_state_interfaces_.reserve(allowed_interface_types_.size() * dof_);
+  resize_joint_trajectory_point(activation_state_, dof_);
+
+  // kept from here until cleanup, only the msg it follows is replaced on activation
+  traj_external_point_ptr_ = std::make_shared<Trajectory>();
+  traj_external_point_ptr_->reserve(dof_);
+
+  start_monitors();
+  prefault_rt_buffers();
+}
+
+void JointTrajectoryController::prefault_rt_buffers()
+{
+  size_t bytes = prefault_point(state_current_) + prefault_point(command_current_) +
+                 prefault_point(state_desired_) + prefault_point(state_error_) +
+                 prefault_point(last_commanded_state_) + prefault_point(activation_state_);
+  bytes += memory_prefault::prefault(
+    command_sources_, rt_command_interfaces_, rt_state_interfaces_, ff_velocity_scale_,
+    wraparound_joint_indices_, tmp_command_, rt_stream_velocities_);
+  if (horizon_slot_)
+  {
+    bytes += prefault_point(horizon_samples_.sample_state) +
+             memory_prefault::prefault(
+               horizon_samples_.positions, horizon_samples_.velocities,
+               horizon_samples_.accelerations, horizon_.positions, horizon_.velocities,
+               horizon_.accelerations);
+  }
+  if (state_publisher_)
+  {
+    state_publisher_->lock();
+    auto & msg = state_publisher_->msg_;
+    bytes += memory_prefault::prefault(msg.joint_names) + prefault_point(msg.reference) +
+             prefault_point(msg.feedback) + prefault_point(msg.error) + prefault_point(msg.output);
+    state_publisher_->unlock();
+  }
+  RCLCPP_DEBUG(get_node()->get_logger(), "Prefaulted %zu bytes of the update.", bytes);
+}
+
+void JointTrajectoryController::start_monitors()
+{
+  goal_monitor_.start(
+    get_node()->get_node_base_interface()->get_context(),
+    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
+    [this]()
+    {
+      monitor_goals();
+      rt_released_msgs_.reclaim();
+      rt_released_queued_goals_.reclaim();
+      rt_released_file_trajectories_.reclaim();
+      rt_released_storages_.reclaim();
+      rt_released_group_goals_.reclaim();
+    });
+  if (params_.look_ahead.enable)
+  {
+    look_ahead_limits_ = get_look_ahead_limits(params_);
+    look_ahead_monitor_.start(
+      get_node()->get_node_base_interface()->get_context(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(1.0 / params_.look_ahead.check_rate)),
+      [this]() { check_look_ahead(); });
+  }
+  if (params_.trajectory_file.enable)
+  {
+    // the pages of the horizon are loaded several times before the realtime loop needs them
+    const double horizon = params_.trajectory_file.prefetch_horizon;
+    file_prefetch_monitor_.start(
+      get_node()->get_node_base_interface()->get_context(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(horizon / 4.0)),
+      [this, horizon]()
+      {
+        std::lock_guard<std::mutex> lock(file_trajectory_mutex_);
+        if (file_trajectory_)
+        {
+          file_trajectory_->prefetch(static_cast<int64_t>(horizon * 1e9));
+        }
+      });
+  }
+}
+
+controller_interface::CallbackReturn JointTrajectoryController::on_activate(
+  const rclcpp_lifecycle::State &)
+{
+  // in hot standby, the parameters of the configuration are used, and the dynamic ones are
+  // already updated by the parameter callback
+  if (!params_.hot_standby)
+  {
+    // get parameters from the listener in case they were updated, the map parameters are declared
+    // already, see on_configure()
+    params_ = param_listener_->get_params();
+
+    // parse remaining parameters
+    store_dynamic_parameters(params_);
+    runtime_parameters_.initRT(make_runtime_parameters(params_));
+  }
+  update_runtime_parameters();
+  // preallocate the tolerances of the trajectories for all joints
+  set_default_tolerances_active();
+  active_tolerances_.msg = nullptr;
+  // drop the points streamed before the activation
+  velocity_stream_.clear();
+  if (shm_ingress_)
+  {
+    shm_ingress_->clear();
+  }
+  rt_streaming_velocity_ = false;
+  rt_following_file_ = false;
+  rt_reference_violates_tolerance_ = false;
+  rt_storage_msg_ = nullptr;
+  // wait for the preceding controller to write the references
+  reference_interfaces_.assign(
+    reference_interfaces_.size(), std::numeric_limits<double>::quiet_NaN());
+
+  // order all joints in the storage
+  for (const auto & interface : params_.command_interfaces)
   {
     auto it =
       std::find(allowed_interface_types_.begin(), allowed_interface_types_.end(), interface);
     auto index = std::distance(allowed_interface_types_.begin(), it);
-    if (!controller_interface::get_ordered_interfaces(
-          command_interfaces_, command_joint_names_, interface, joint_command_interface_[index]))
+    const bool is_ordered =
+      params_.hot_standby
+        ? bind_ordered_interfaces(
+            command_interfaces_, standby_command_interface_names_[index],
+            joint_command_interface_[index])
+        : controller_interface::get_ordered_interfaces(
+            command_interfaces_, command_joint_names_, interface, joint_command_interface_[index]);
+    if (!is_ordered)
     {
       RCLCPP_ERROR(
         get_node()->get_logger(), "Expected %zu '%s' command interfaces, got %zu.", dof_,
@@ -907,13 +1806,47 @@ controller_interface::CallbackReturn JointTrajectoryController::on_activate(
       return CallbackReturn::ERROR;
     }
   }
+  // select once which values update() writes to each command interface type
+  command_sources_.clear();
+  if (has_position_command_interface_)
+  {
+    command_sources_.emplace_back(0, &state_desired_.positions);
+  }
+  if (has_velocity_command_interface_)
+  {
+    command_sources_.emplace_back(
+      1, use_closed_loop_pid_adapter_ ? &tmp_command_ : &state_desired_.velocities);
+  }
+  if (has_acceleration_command_interface_)
+  {
+    command_sources_.emplace_back(2, &state_desired_.accelerations);
+  }
+  if (has_effort_command_interface_)
+  {
+    command_sources_.emplace_back(3, &tmp_command_);
+  }
+  rt_command_interfaces_.clear();
+  for (const auto & command_source : command_sources_)
+  {
+    for (auto & command_interface : joint_command_interface_[command_source.first])
+    {
+      rt_command_interfaces_.push_back(&command_interface.get());
+    }
+  }
+
   for (const auto & interface : params_.state_interfaces)
   {
     auto it =
       std::find(allowed_interface_types_.begin(), allowed_interface_types_.end(), interface);
     auto index = std::distance(allowed_interface_types_.begin(), it);
-    if (!controller_interface::get_ordered_interfaces(
-          state_interfaces_, params_.joints, interface, joint_state_interface_[index]))
+    const bool is_ordered =
+      params_.hot_standby
+        ? bind_ordered_interfaces(
+            state_interfaces_, standby_state_interface_names_[index],
+            joint_state_interface_[index])
+        : controller_interface::get_ordered_interfaces(
+            state_interfaces_, params_.joints, interface, joint_state_interface_[index]);
+    if (!is_ordered)
     {
       RCLCPP_ERROR(
         get_node()->get_logger(), "Expected %zu '%s' state interfaces, got %zu.", dof_,
@@ -921,21 +1854,70 @@ controller_interface::CallbackReturn JointTrajectoryController::on_activate(
       return CallbackReturn::ERROR;
     }
   }
+  rt_state_interfaces_.assign(allowed_interface_types_.size() * dof_, nullptr);
+  for (size_t index = 0; index < allowed_interface_types_.size(); ++index)
+  {
+    for (size_t joint = 0; joint < joint_state_interface_[index].size(); ++joint)
+    {
+      rt_state_interfaces_[index * dof_ + joint] = &joint_state_interface_[index][joint].get();
+    }
+  }
 
-  traj_external_point_ptr_ = std::make_shared<Trajectory>();
-  traj_msg_external_point_ptr_.writeFromNonRT(
-    std::shared_ptr<trajectory_msgs::msg::JointTrajectory>());
+  speed_scaling_state_interface_.reset();
+  if (!params_.speed_scaling.state_interface.empty())
+  {
+    const auto it = std::find_if(
+      state_interfaces_.begin(), state_interfaces_.end(), [this](const auto & state_interface)
+      { return state_interface.get_name() == params_.speed_scaling.state_interface; });
+    if (it == state_interfaces_.end())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Expected speed scaling state interface '%s'.",
+        params_.speed_scaling.state_interface.c_str());
+      return CallbackReturn::ERROR;
+    }
+    speed_scaling_state_interface_ = std::ref(*it);
+  }
+  speed_scaling_factor_ = params_.speed_scaling.initial_factor;
+
+  if (!params_.hot_standby)
+  {
+    traj_external_point_ptr_ = std::make_shared<Trajectory>();
+    traj_external_point_ptr_->reserve(dof_);
+    // in hot standby, they are dropped on deactivation
+    drop_trajectory_snapshots();
+    traj_msg_external_point_ptr_.write_from_non_rt(
+      std::shared_ptr<trajectory_msgs::msg::JointTrajectory>());
+  }
+
+  if (trajectory_recorder_)
+  {
+    std::vector<std::string> state_names;
+    for (const auto & state_interface : state_interfaces_)
+    {
+      state_names.push_back(state_interface.get_name());
+    }
+    std::vector<std::string> command_names;
+    for (const auto & command_interface : command_interfaces_)
+    {
+      command_names.push_back(command_interface.get_name());
+    }
+    trajectory_recorder_->start_session(
+      state_names, command_names, static_cast<size_t>(params_.recording.capacity));
+  }
 
+  update_time_.reset();
   subscriber_is_active_ = true;
 
   // Handle restart of controller by reading from commands if those are not NaN (a controller was
   // running already)
   trajectory_msgs::msg::JointTrajectoryPoint state;
-  resize_joint_trajectory_point(state, dof_);
-  if (read_state_from_command_interfaces(state))
+  auto & activation_state = params_.hot_standby ? activation_state_ : state;
+  resize_joint_trajectory_point(activation_state, dof_);
+  if (read_state_from_command_interfaces(activation_state))
   {
-    state_current_ = state;
-    last_commanded_state_ = state;
+    state_current_ = activation_state;
+    last_commanded_state_ = activation_state;
   }
   else
   {
@@ -943,10 +1925,20 @@ controller_interface::CallbackReturn JointTrajectoryController::on_activate(
     read_state_from_state_interfaces(state_current_);
     read_state_from_state_interfaces(last_commanded_state_);
   }
+  // for the partial goals received before the first update
+  publish_hold_positions();
 
   // The controller should start by holding position at the beginning of active state
-  add_new_trajectory_msg(set_hold_position());
-  rt_is_holding_.writeFromNonRT(true);
+  if (params_.hot_standby)
+  {
+    // with a preallocated msg, the replaced msg is released by goal_monitor_
+    switch_to_hold_from_rt(false);
+  }
+  else
+  {
+    add_new_trajectory_msg(set_hold_position());
+  }
+  rt_is_holding_ = true;
 
   // parse timeout parameter
   if (params_.cmd_timeout > 0.0)
@@ -970,6 +1962,21 @@ controller_interface::CallbackReturn JointTrajectoryController::on_activate(
     cmd_timeout_ = 0.0;
   }
 
+  if (!params_.hot_standby)
+  {
+    start_monitors();
+    // in hot standby, the buffers were touched on configuration
+    prefault_rt_buffers();
+  }
+  if (update_time_statistics_)
+  {
+    update_time_statistics_->reset();
+  }
+  if (cycle_budget_)
+  {
+    cycle_budget_->reset();
+  }
+
   return CallbackReturn::SUCCESS;
 }
 
@@ -1006,11 +2013,76 @@ controller_interface::CallbackReturn JointTrajectoryController::on_deactivate(
     joint_command_interface_[index].clear();
     joint_state_interface_[index].clear();
   }
+  rt_command_interfaces_.clear();
+  rt_state_interfaces_.clear();
+  speed_scaling_state_interface_.reset();
   release_interfaces();
 
   subscriber_is_active_ = false;
 
-  traj_external_point_ptr_.reset();
+  // readers don't follow the last trajectory of an inactive controller
+  if (horizon_slot_)
+  {
+    export_trajectory_horizon(get_node()->now(), false);
+  }
+
+  if (trajectory_recorder_)
+  {
+    trajectory_recorder_->stop_session();
+    if (trajectory_recorder_->dropped_updates() > 0)
+    {
+      RCLCPP_WARN(
+        get_node()->get_logger(), "The recording dropped %zu updates, the writer fell behind.",
+        static_cast<size_t>(trajectory_recorder_->dropped_updates()));
+    }
+  }
+
+  if (params_.hot_standby)
+  {
+    // the monitors keep running, a look-ahead check still sampling the last snapshot is ignored
+    drop_trajectory_snapshots();
+  }
+  else
+  {
+    look_ahead_monitor_.stop();
+    file_prefetch_monitor_.stop();
+    traj_external_point_ptr_.reset();
+    goal_monitor_.stop();
+  }
+  // a trajectory file is followed until the deactivation
+  file_trajectory_buffer_.write_from_non_rt(nullptr);
+  rt_file_trajectory_.reset();
+  rt_following_file_ = false;
+  {
+    std::lock_guard<std::mutex> lock(file_trajectory_mutex_);
+    file_trajectory_.reset();
+  }
+
+  // send what update() requested last
+  monitor_goals();
+  // update() doesn't run anymore to retry the requests which didn't fit into the channel
+  if (
+    rt_unpushed_goal_ || std::any_of(
+                           rt_unpushed_group_goals_.begin(), rt_unpushed_group_goals_.end(),
+                           [](const RealtimeGoalHandlePtr & goal) { return goal != nullptr; }))
+  {
+    push_unpushed_goal_states_from_rt();
+    monitor_goals();
+  }
+  cancel_queued_goal(
+    FollowJTrajAction::Result::INVALID_GOAL, "Queued goal cancelled due to deactivation.");
+  rt_started_queued_goal_.reset();
+  preempt_group_goals("Goal of the joint group cancelled due to deactivation.");
+  rt_active_group_goals_.reset();
+  // a running goal_monitor_ is the only consumer of the queues
+  if (!params_.hot_standby)
+  {
+    rt_released_msgs_.reclaim();
+    rt_released_queued_goals_.reclaim();
+    rt_released_file_trajectories_.reclaim();
+    rt_released_storages_.reclaim();
+    rt_released_group_goals_.reclaim();
+  }
 
   return CallbackReturn::SUCCESS;
 }
@@ -1018,6 +2090,16 @@ controller_interface::CallbackReturn JointTrajectoryController::on_deactivate(
 controller_interface::CallbackReturn JointTrajectoryController::on_cleanup(
   const rclcpp_lifecycle::State &)
 {
+  // running since the configuration in hot standby
+  look_ahead_monitor_.stop();
+  file_prefetch_monitor_.stop();
+  goal_monitor_.stop();
+  traj_external_point_ptr_.reset();
+  shm_ingress_.reset();
+  if (trajectory_recorder_)
+  {
+    trajectory_recorder_->close();
+  }
   return CallbackReturn::SUCCESS;
 }
 
@@ -1036,15 +2118,13 @@ bool JointTrajectoryController::reset()
   subscriber_is_active_ = false;
   joint_command_subscriber_.reset();
 
-  for (const auto & pid : pids_)
-  {
-    if (pid)
-    {
-      pid->reset();
-    }
-  }
+  pid_bank_.reset();
 
+  look_ahead_monitor_.stop();
+  file_prefetch_monitor_.stop();
+  goal_monitor_.stop();
   traj_external_point_ptr_.reset();
+  shm_ingress_.reset();
 
   return true;
 }
@@ -1061,46 +2141,296 @@ void JointTrajectoryController::publish_state(
   const rclcpp::Time & time, const JointTrajectoryPoint & desired_state,
   const JointTrajectoryPoint & current_state, const JointTrajectoryPoint & state_error)
 {
+  // reading the command interfaces and filling the message is skipped in decimated cycles, and
+  // while the cycle budget is exceeded
+  if (
+    !update_time_statistics::allows_optional_work(cycle_budget_.get()) ||
+    !state_publish_rate_->is_due(time))
+  {
+    return;
+  }
+
   if (state_publisher_->trylock())
   {
-    state_publisher_->msg_.header.stamp = time;
-    state_publisher_->msg_.reference.positions = desired_state.positions;
-    state_publisher_->msg_.reference.velocities = desired_state.velocities;
-    state_publisher_->msg_.reference.accelerations = desired_state.accelerations;
-    state_publisher_->msg_.feedback.positions = current_state.positions;
-    state_publisher_->msg_.error.positions = state_error.positions;
+    // the message fields are preallocated in on_configure, so usually no memory is allocated here
+    auto copy_to_msg = [](const std::vector<double> & from, std::vector<double> & to)
+    {
+      if (from.size() == to.size())
+      {
+        std::copy(from.begin(), from.end(), to.begin());
+      }
+      else
+      {
+        to = from;
+      }
+    };
+
+    auto & msg = state_publisher_->msg_;
+    msg.header.stamp = time;
+    copy_to_msg(desired_state.positions, msg.reference.positions);
+    copy_to_msg(desired_state.velocities, msg.reference.velocities);
+    copy_to_msg(desired_state.accelerations, msg.reference.accelerations);
+    copy_to_msg(current_state.positions, msg.feedback.positions);
+    copy_to_msg(state_error.positions, msg.error.positions);
     if (has_velocity_state_interface_)
     {
-      state_publisher_->msg_.feedback.velocities = current_state.velocities;
-      state_publisher_->msg_.error.velocities = state_error.velocities;
+      copy_to_msg(current_state.velocities, msg.feedback.velocities);
+      copy_to_msg(state_error.velocities, msg.error.velocities);
     }
     if (has_acceleration_state_interface_)
     {
-      state_publisher_->msg_.feedback.accelerations = current_state.accelerations;
-      state_publisher_->msg_.error.accelerations = state_error.accelerations;
+      copy_to_msg(current_state.accelerations, msg.feedback.accelerations);
+      copy_to_msg(state_error.accelerations, msg.error.accelerations);
     }
     if (read_commands_from_command_interfaces(command_current_))
     {
-      state_publisher_->msg_.output = command_current_;
+      copy_to_msg(command_current_.positions, msg.output.positions);
+      copy_to_msg(command_current_.velocities, msg.output.velocities);
+      copy_to_msg(command_current_.accelerations, msg.output.accelerations);
+      copy_to_msg(command_current_.effort, msg.output.effort);
     }
 
     state_publisher_->unlockAndPublish();
   }
+
+  if (bounded_state_publisher_)
+  {
+    publish_bounded_state(time, desired_state, current_state, state_error);
+  }
+}
+
+void JointTrajectoryController::publish_bounded_state(
+  const rclcpp::Time & time, const JointTrajectoryPoint & desired_state,
+  const JointTrajectoryPoint & current_state, const JointTrajectoryPoint & state_error)
+{
+  const bool has_commands = read_commands_from_command_interfaces(command_current_);
+  // the entries of values the controller doesn't have are NaN
+  auto copy_to_msg = [this](const std::vector<double> & from, const bool available, auto & to)
+  {
+    for (size_t i = 0; i < dof_; ++i)
+    {
+      to[i] = available && i < from.size() ? from[i] : std::numeric_limits<double>::quiet_NaN();
+    }
+  };
+  // a loaned message is written into the memory of the middleware, neither allocated nor copied
+  const bool published = bounded_state_publisher_->publish(
+    [&](BoundedStateMsg & msg)
+    {
+      msg.stamp = time;
+      msg.size = static_cast<uint32_t>(dof_);
+      copy_to_msg(desired_state.positions, true, msg.reference_positions);
+      copy_to_msg(desired_state.velocities, true, msg.reference_velocities);
+      copy_to_msg(desired_state.accelerations, true, msg.reference_accelerations);
+      copy_to_msg(current_state.positions, true, msg.feedback_positions);
+      copy_to_msg(current_state.velocities, has_velocity_state_interface_, msg.feedback_velocities);
+      copy_to_msg(
+        current_state.accelerations, has_acceleration_state_interface_,
+        msg.feedback_accelerations);
+      copy_to_msg(state_error.positions, true, msg.error_positions);
+      copy_to_msg(state_error.velocities, has_velocity_state_interface_, msg.error_velocities);
+      copy_to_msg(
+        state_error.accelerations, has_acceleration_state_interface_, msg.error_accelerations);
+      copy_to_msg(
+        command_current_.positions, has_commands && has_position_command_interface_,
+        msg.output_positions);
+      copy_to_msg(
+        command_current_.velocities, has_commands && has_velocity_command_interface_,
+        msg.output_velocities);
+      copy_to_msg(
+        command_current_.accelerations, has_commands && has_acceleration_command_interface_,
+        msg.output_accelerations);
+      copy_to_msg(
+        command_current_.effort, has_commands && has_effort_command_interface_, msg.output_effort);
+    });
+  if (!published)
+  {
+    // e.g., all loans of the shared memory transport are taken by slow subscribers
+    rt_logger_->warn("Couldn't loan a message for the bounded controller state.");
+  }
+}
+
+void JointTrajectoryController::file_trajectory_callback(
+  const std::shared_ptr<std_msgs::msg::String> msg)
+{
+  if (!subscriber_is_active_)
+  {
+    return;
+  }
+  const auto & logger = get_node()->get_logger();
+  if (is_in_chained_mode())
+  {
+    RCLCPP_WARN(
+      logger,
+      "Ignoring the trajectory file, the reference interfaces are followed in chained mode");
+    return;
+  }
+  if (*rt_active_goal_.read_from_non_rt())
+  {
+    RCLCPP_WARN(logger, "Ignoring the trajectory file while an action goal is active.");
+    return;
+  }
+
+  std::shared_ptr<MappedTrajectory> file_trajectory;
+  if (!msg->data.empty())
+  {
+    file_trajectory = std::make_shared<MappedTrajectory>();
+    std::string error;
+    if (
+      !file_trajectory->open(msg->data, error) ||
+      !file_trajectory->set_joint_order(params_.joints, error))
+    {
+      RCLCPP_ERROR(logger, "Ignoring the trajectory file: %s", error.c_str());
+      return;
+    }
+    RCLCPP_INFO(
+      logger, "Following the trajectory file '%s' with %zu points over %f s.", msg->data.c_str(),
+      file_trajectory->size(), static_cast<double>(file_trajectory->get_duration_ns()) / 1e9);
+  }
+  {
+    std::lock_guard<std::mutex> lock(file_trajectory_mutex_);
+    file_trajectory_ = file_trajectory;
+  }
+  file_trajectory_buffer_.write_from_non_rt(file_trajectory);
 }
 
 void JointTrajectoryController::topic_callback(
   const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg)
 {
+  if (trajectory_recorder_)
+  {
+    trajectory_recorder_->record_event(RecordKind::TRAJECTORY, serialize_record_payload(*msg));
+  }
+  process_trajectory_msg(msg);
+}
+
+void JointTrajectoryController::serialized_topic_callback(
+  const std::shared_ptr<const rclcpp::SerializedMessage> msg)
+{
+  const auto & buffer = msg->get_rcl_serialized_message();
+  if (trajectory_recorder_)
+  {
+    // the payload of the records is the serialized msg already
+    trajectory_recorder_->record_event(
+      RecordKind::TRAJECTORY,
+      std::vector<uint8_t>(buffer.buffer, buffer.buffer + buffer.buffer_length));
+  }
+  const auto deserialize_and_process = [this, &msg]()
+  {
+    auto traj_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+    rclcpp::Serialization<trajectory_msgs::msg::JointTrajectory>().deserialize_message(
+      msg.get(), traj_msg.get());
+    process_trajectory_msg(traj_msg);
+  };
+  // streamed points are told apart from the deserialized msg
+  if (params_.velocity_streaming.enable)
+  {
+    deserialize_and_process();
+    return;
+  }
+  if (is_in_chained_mode())
+  {
+    RCLCPP_WARN_THROTTLE(
+      get_node()->get_logger(), *get_node()->get_clock(), 1000,
+      "Ignoring the trajectory msg, the reference interfaces are followed in chained mode");
+    return;
+  }
+
+  // the missing joints of partial goals hold the position, as in fill_partial_goal()
+  TrajectoryDecodeOptions options;
+  options.allow_partial_joints_goal = allow_partial_joints_goal_.load();
+  options.allow_integration_in_goal_trajectories = allow_integration_in_goal_trajectories_.load();
+  options.allow_nonzero_velocity_at_trajectory_end =
+    allow_nonzero_velocity_at_trajectory_end_.load();
+  options.now_ns = update_time_.now(*get_node()->get_clock()).nanoseconds();
+  if (subscriber_is_active_)
+  {
+    get_hold_positions(partial_goal_positions_);
+    options.partial_goal_positions = &partial_goal_positions_;
+  }
+
+  auto traj_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  std::string error;
+  switch (trajectory_decoder_->decode(
+    buffer.buffer, buffer.buffer_length, options, *traj_msg, error))
+  {
+    case CdrDecodeResult::UNSUPPORTED:
+      deserialize_and_process();
+      return;
+    case CdrDecodeResult::INVALID:
+      RCLCPP_ERROR(get_node()->get_logger(), "%s", error.c_str());
+      return;
+    case CdrDecodeResult::DECODED:
+      break;
+  }
+  // http://wiki.ros.org/joint_trajectory_controller/UnderstandingTrajectoryReplacement
+  // replace old msg with new one, unless splicing is configured
+  if (subscriber_is_active_)
+  {
+    preempt_group_goals("Goal of the joint group cancelled due to a trajectory of the topic.");
+    if (splice_incoming_trajectories_.load())
+    {
+      add_new_trajectory_msg(splice_trajectory_msg(traj_msg));
+    }
+    else
+    {
+      add_new_trajectory_msg(traj_msg);
+    }
+    rt_is_holding_ = false;
+  }
+}
+
+void JointTrajectoryController::process_trajectory_msg(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg)
+{
+  if (is_in_chained_mode())
+  {
+    RCLCPP_WARN_THROTTLE(
+      get_node()->get_logger(), *get_node()->get_clock(), 1000,
+      "Ignoring the trajectory msg, the reference interfaces are followed in chained mode");
+    return;
+  }
+  if (is_velocity_stream_point(*msg))
+  {
+    if (*rt_active_goal_.read_from_non_rt())
+    {
+      RCLCPP_WARN(
+        get_node()->get_logger(), "Ignoring the streamed point while an action goal is active.");
+    }
+    else if (subscriber_is_active_)
+    {
+      sort_to_local_joint_order(msg);
+      const rclcpp::Time stamp = rclcpp::Time(msg->header.stamp).seconds() == 0.0
+                                   ? update_time_.now(*get_node()->get_clock())
+                                   : rclcpp::Time(msg->header.stamp);
+      const auto & point = msg->points[0];
+      if (!velocity_stream_.push(
+            (stamp + rclcpp::Duration(point.time_from_start)).nanoseconds(), point.velocities))
+      {
+        RCLCPP_WARN(get_node()->get_logger(), "Dropping the streamed point, the stream is full.");
+      }
+    }
+    return;
+  }
   if (!validate_trajectory_msg(*msg))
   {
     return;
   }
   // http://wiki.ros.org/joint_trajectory_controller/UnderstandingTrajectoryReplacement
-  // always replace old msg with new one for now
+  // replace old msg with new one, unless splicing is configured
   if (subscriber_is_active_)
   {
-    add_new_trajectory_msg(msg);
-    rt_is_holding_.writeFromNonRT(false);
+    fill_partial_goal(msg);
+    sort_to_local_joint_order(msg);
+    preempt_group_goals("Goal of the joint group cancelled due to a trajectory of the topic.");
+    if (splice_incoming_trajectories_.load())
+    {
+      add_new_trajectory_msg(splice_trajectory_msg(msg));
+    }
+    else
+    {
+      add_new_trajectory_msg(msg);
+    }
+    rt_is_holding_ = false;
   }
 };
 
@@ -1117,72 +2447,721 @@ rclcpp_action::GoalResponse JointTrajectoryController::goal_received_callback(
     return rclcpp_action::GoalResponse::REJECT;
   }
 
-  if (!validate_trajectory_msg(goal->trajectory))
+  if (is_in_chained_mode())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "Can't accept new action goals. The reference interfaces are followed in chained mode.");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (!validate_trajectory_msg(goal->trajectory))
+  {
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  RCLCPP_INFO(get_node()->get_logger(), "Accepted new action goal");
+  return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+}
+
+rclcpp_action::CancelResponse JointTrajectoryController::goal_cancelled_callback(
+  const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+{
+  RCLCPP_INFO(get_node()->get_logger(), "Got request to cancel goal");
+
+  // a goal finished by update() can't be canceled anymore
+  process_goal_state_requests();
+
+  {
+    std::unique_lock<std::mutex> lock(queued_goal_mutex_);
+    if (queued_goal_ && queued_goal_->goal->gh_ == goal_handle)
+    {
+      if (try_cancel_queued_goal(FollowJTrajAction::Result::SUCCESSFUL, ""))
+      {
+        RCLCPP_INFO(get_node()->get_logger(), "Canceling queued action goal.");
+        return rclcpp_action::CancelResponse::ACCEPT;
+      }
+      // started by update() meanwhile, it is canceled as the active goal
+      lock.unlock();
+      process_goal_state_requests();
+    }
+  }
+
+  // Check that cancel request refers to currently active goal (if any)
+  auto active_goal = *rt_active_goal_.read_from_non_rt();
+  if (active_goal && active_goal->gh_ == goal_handle)
+  {
+    // the goal queued after it is canceled as well, unless it was started already
+    cancel_queued_goal(
+      FollowJTrajAction::Result::INVALID_GOAL,
+      "Queued goal cancelled due to the cancellation of the preceding goal.");
+    active_goal = *rt_active_goal_.read_from_non_rt();
+  }
+  if (active_goal && active_goal->gh_ == goal_handle)
+  {
+    RCLCPP_INFO(
+      get_node()->get_logger(), "Canceling active action goal because cancel callback received.");
+
+    // Mark the current goal as canceled
+    rt_has_pending_goal_.store(false, std::memory_order_release);
+    auto action_res = result_pool_.make_shared();
+    active_goal->setCanceled(action_res);
+    rt_active_goal_.write_from_non_rt(RealtimeGoalHandlePtr());
+    goal_monitor_.notify();
+
+    if (trajectory_recorder_)
+    {
+      trajectory_recorder_->record_event(RecordKind::CANCEL);
+    }
+    // Enter hold current position mode
+    add_new_trajectory_msg(set_hold_position());
+  }
+  return rclcpp_action::CancelResponse::ACCEPT;
+}
+
+void JointTrajectoryController::goal_accepted_callback(
+  std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+{
+  // finish goals terminated by update() before their goal handle is replaced
+  process_goal_state_requests();
+
+  // the active goal continues if the new goal is queued
+  const bool queue_goal_after_active_goal =
+    queue_goals_.load() && *rt_active_goal_.read_from_non_rt() != nullptr;
+  if (!queue_goal_after_active_goal)
+  {
+    // mark a pending goal
+    rt_has_pending_goal_.store(true, std::memory_order_release);
+    preempt_active_goal();
+    preempt_group_goals("Goal of the joint group cancelled due to a goal of all joints.");
+  }
+
+  // Update new trajectory
+  const auto goal = goal_handle->get_goal();
+  if (trajectory_recorder_)
+  {
+    trajectory_recorder_->record_event(RecordKind::GOAL, serialize_record_payload(*goal));
+  }
+
+  // the tolerances of the goal are applied to the defaults of the current parameters
+  const auto default_tolerances = get_segment_tolerances(param_listener_->get_params());
+  SegmentTolerances goal_tolerances;
+  if (!get_goal_segment_tolerances(default_tolerances, *goal, params_.joints, goal_tolerances))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Invalid tolerances of the goal, using the default tolerances");
+    goal_tolerances = default_tolerances;
+  }
+  // preparing the msg for update() writes the points of a cubic spline, and the points without
+  // positions when they are integrated by complete_trajectory_points() or by the first sample()
+  const bool all_points_have_positions = std::all_of(
+    goal->trajectory.points.begin(), goal->trajectory.points.end(),
+    [](const trajectory_msgs::msg::JointTrajectoryPoint & point)
+    { return !point.positions.empty(); });
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> traj_msg;
+  if (
+    goal->trajectory.joint_names == params_.joints && all_points_have_positions &&
+    interpolation_method_ != interpolation_methods::InterpolationMethod::CUBIC_SPLINE)
+  {
+    // nothing writes to the points of this trajectory: share it with the goal instead of
+    // copying it
+    traj_msg = std::shared_ptr<trajectory_msgs::msg::JointTrajectory>(
+      goal, const_cast<trajectory_msgs::msg::JointTrajectory *>(&goal->trajectory));
+  }
+  else
+  {
+    traj_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(goal->trajectory);
+    fill_partial_goal(traj_msg);
+    sort_to_local_joint_order(traj_msg);
+  }
+
+  RealtimeGoalHandlePtr rt_goal = std::make_shared<RealtimeGoalHandle>(goal_handle);
+  rt_goal->preallocated_feedback_->joint_names = params_.joints;
+  if (queue_goal_after_active_goal)
+  {
+    queue_goal(rt_goal, traj_msg, goal_tolerances);
+    return;
+  }
+
+  add_new_trajectory_msg(traj_msg, &goal_tolerances);
+  rt_is_holding_ = false;
+
+  // Update the active goal
+  activate_goal(rt_goal);
+}
+
+void JointTrajectoryController::activate_goal(const RealtimeGoalHandlePtr & goal)
+{
+  goal->execute();
+  rt_active_goal_.write_from_non_rt(goal);
+
+  // the goal monitor sends the feedback and the result of the goal from now on
+  std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+  monitored_goal_ = goal;
+}
+
+void JointTrajectoryController::queue_goal(
+  const RealtimeGoalHandlePtr & goal,
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg,
+  const SegmentTolerances & goal_tolerances)
+{
+  auto queued_goal = std::make_shared<QueuedGoal>();
+  queued_goal->goal = goal;
+  queued_goal->msg = traj_msg;
+  prepare_trajectory_msg(*traj_msg);
+  queued_goal->tolerances = make_trajectory_tolerances(*traj_msg, &goal_tolerances);
+  if (use_compact_storage_)
+  {
+    queued_goal->storage = make_trajectory_storage(*traj_msg);
+  }
+
+  cancel_queued_goal(
+    FollowJTrajAction::Result::INVALID_GOAL, "Queued goal cancelled due to new incoming action.");
+  std::lock_guard<std::mutex> guard(queued_goal_mutex_);
+  // checked under the lock, as the active goal is finished under it
+  if (!*rt_active_goal_.read_from_non_rt())
+  {
+    start_goal_from_non_rt(*queued_goal);
+    return;
+  }
+  queued_goal_ = queued_goal;
+  rt_queued_goal_.write_from_non_rt(queued_goal_);
+  RCLCPP_INFO(get_node()->get_logger(), "Queued the goal after the active goal");
+}
+
+void JointTrajectoryController::start_goal_from_non_rt(const QueuedGoal & queued_goal)
+{
+  rt_has_pending_goal_.store(true, std::memory_order_release);
+  if (use_compact_storage_)
+  {
+    rt_trajectory_storage_.write_from_non_rt(queued_goal.storage);
+  }
+  rt_trajectory_tolerances_.write_from_non_rt(queued_goal.tolerances);
+  traj_msg_external_point_ptr_.write_from_non_rt(queued_goal.msg);
+  rt_is_holding_ = false;
+  activate_goal(queued_goal.goal);
+}
+
+bool JointTrajectoryController::start_queued_goal_from_rt(
+  const RealtimeGoalHandlePtr & finished_goal)
+{
+  // the previously started goal is not active on the non-RT side yet, which starts this one then
+  if (rt_started_queued_goal_)
+  {
+    return false;
+  }
+  const auto & queued_goal = *rt_queued_goal_.read_from_rt();
+  auto expected = QueuedGoalState::QUEUED;
+  if (
+    !queued_goal || !queued_goal->state.compare_exchange_strong(
+                      expected, QueuedGoalState::STARTED_FROM_RT, std::memory_order_acq_rel))
+  {
+    return false;
+  }
+  rt_started_queued_goal_ = queued_goal;
+  rt_queued_goal_predecessor_ = finished_goal.get();
+
+  // taken as a new trajectory in the next cycle, starting from the last command if its stamp is
+  // zero. The prepared tolerances are copied into the preallocated ones.
+  rt_released_msgs_.retain(traj_msg_external_point_ptr_.current_from_rt());
+  traj_msg_external_point_ptr_.current_from_rt() = queued_goal->msg;
+  active_tolerances_ = queued_goal->tolerances;
+  if (use_compact_storage_)
+  {
+    auto & storage = rt_trajectory_storage_.current_from_rt();
+    rt_released_storages_.retain(storage.storage);
+    storage = queued_goal->storage;
+  }
+  rt_is_holding_ = false;
+  return true;
+}
+
+bool JointTrajectoryController::try_cancel_queued_goal(
+  int32_t error_code, const std::string & reason)
+{
+  if (!queued_goal_)
+  {
+    return true;
+  }
+  auto expected = QueuedGoalState::QUEUED;
+  if (!queued_goal_->state.compare_exchange_strong(
+        expected, QueuedGoalState::TAKEN_FROM_NON_RT, std::memory_order_acq_rel))
+  {
+    return false;
+  }
+  auto action_res = result_pool_.make_shared();
+  action_res->set__error_code(error_code);
+  action_res->set__error_string(reason);
+  // executed first, unless it is canceled on request, as the goal was only accepted so far
+  queued_goal_->goal->execute();
+  queued_goal_->goal->setCanceled(action_res);
+  queued_goal_->goal->runNonRealtime();
+
+  queued_goal_.reset();
+  rt_queued_goal_.write_from_non_rt(nullptr);
+  return true;
+}
+
+void JointTrajectoryController::cancel_queued_goal(int32_t error_code, const std::string & reason)
+{
+  std::unique_lock<std::mutex> lock(queued_goal_mutex_);
+  if (!try_cancel_queued_goal(error_code, reason))
+  {
+    // update() started the queued goal, it becomes the active goal with its predecessor's result
+    lock.unlock();
+    process_goal_state_requests();
+  }
+}
+
+void JointTrajectoryController::continue_with_queued_goal(bool succeeded)
+{
+  if (!succeeded || !queued_goal_)
+  {
+    try_cancel_queued_goal(
+      FollowJTrajAction::Result::INVALID_GOAL,
+      "Queued goal cancelled due to the failure of the preceding goal.");
+    rt_has_pending_goal_.store(false, std::memory_order_release);
+    rt_active_goal_.write_from_non_rt(RealtimeGoalHandlePtr());
+    return;
+  }
+
+  const auto queued_goal = queued_goal_;
+  queued_goal_.reset();
+  rt_queued_goal_.write_from_non_rt(nullptr);
+  auto expected = QueuedGoalState::QUEUED;
+  if (queued_goal->state.compare_exchange_strong(
+        expected, QueuedGoalState::TAKEN_FROM_NON_RT, std::memory_order_acq_rel))
+  {
+    // update() didn't start it, e.g., as the previously started goal wasn't active here yet
+    start_goal_from_non_rt(*queued_goal);
+  }
+  else
+  {
+    activate_goal(queued_goal->goal);
+  }
+}
+
+void JointTrajectoryController::finish_goal_from_rt(
+  const RealtimeGoalHandlePtr & goal, int32_t error_code)
+{
+  rt_finished_goal_ = goal.get();
+  // an older request waiting for the channel goes first
+  push_unpushed_goal_states_from_rt();
+  if (rt_unpushed_goal_)
+  {
+    // only the reference of the caller is dropped here, so no goal handle is destroyed
+    rt_logger_->error("Too many unprocessed goal state requests, dropped the goal result.");
+    return;
+  }
+  const bool pushed = params_.goal_tracking_statistics
+                        ? goal_state_channel_.push(goal, error_code, rt_tracking_statistics_)
+                        : goal_state_channel_.push(goal, error_code);
+  if (!pushed)
+  {
+    // the goal stays finished for update(), its result is sent as soon as the channel has room
+    rt_logger_->warn("Too many unprocessed goal state requests, retrying in the next update.");
+    rt_unpushed_goal_ = goal;
+    rt_unpushed_error_code_ = error_code;
+  }
+  // send the result right away instead of at the next monitor period
+  goal_monitor_.notify();
+}
+
+void JointTrajectoryController::push_unpushed_goal_states_from_rt()
+{
+  if (rt_unpushed_goal_ && !push_unpushed_goal_state_from_rt())
+  {
+    return;
+  }
+  bool pushed = false;
+  for (size_t group_index = 0; group_index < rt_unpushed_group_goals_.size(); ++group_index)
+  {
+    auto & goal = rt_unpushed_group_goals_[group_index];
+    if (goal)
+    {
+      if (!goal_state_channel_.push(goal, rt_unpushed_group_error_codes_[group_index]))
+      {
+        break;
+      }
+      // the channel holds a reference now, so this can't destroy the goal handle
+      goal.reset();
+      pushed = true;
+    }
+  }
+  if (pushed)
+  {
+    goal_monitor_.notify();
+  }
+}
+
+bool JointTrajectoryController::push_unpushed_goal_state_from_rt()
+{
+  // the statistics are the ones of the goal as long as no new goal started
+  const int32_t error_code = rt_unpushed_error_code_;
+  const bool pushed =
+    params_.goal_tracking_statistics
+      ? goal_state_channel_.push(rt_unpushed_goal_, error_code, rt_tracking_statistics_)
+      : goal_state_channel_.push(rt_unpushed_goal_, error_code);
+  if (pushed)
+  {
+    // the channel holds a reference now, so this can't destroy the goal handle
+    rt_unpushed_goal_.reset();
+    goal_monitor_.notify();
+  }
+  return pushed;
+}
+
+void JointTrajectoryController::process_goal_state_requests()
+{
+  std::lock_guard<std::mutex> guard(goal_state_consumer_mutex_);
+
+  RealtimeGoalHandlePtr goal;
+  int32_t error_code = 0;
+  while (goal_state_channel_.pop(goal, error_code, finished_goal_statistics_))
+  {
+    // the goals of the joint groups have neither statistics nor queued goals
+    const bool is_group_goal =
+      finish_group_goal(goal, error_code == FollowJTrajAction::Result::SUCCESSFUL);
+    goal->preallocated_result_->set__error_code(error_code);
+    if (params_.goal_tracking_statistics && !is_group_goal)
+    {
+      goal->preallocated_result_->set__error_string(
+        finished_goal_statistics_.summary(params_.joints));
+    }
+    if (error_code == FollowJTrajAction::Result::SUCCESSFUL)
+    {
+      goal->setSucceeded(goal->preallocated_result_);
+    }
+    else
+    {
+      goal->setAborted(goal->preallocated_result_);
+    }
+
+    // a new goal might have been accepted meanwhile
+    if (!is_group_goal && *rt_active_goal_.read_from_non_rt() == goal)
+    {
+      std::lock_guard<std::mutex> queued_goal_guard(queued_goal_mutex_);
+      continue_with_queued_goal(error_code == FollowJTrajAction::Result::SUCCESSFUL);
+    }
+
+    // send the result right away
+    goal->runNonRealtime();
+  }
+}
+
+void JointTrajectoryController::monitor_goals()
+{
+  process_goal_state_requests();
+
+  RealtimeGoalHandlePtr goal;
+  {
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    goal = monitored_goal_;
+  }
+  // also sends the result of a canceled goal
+  if (goal)
+  {
+    goal->runNonRealtime();
+  }
+  if (!joint_groups_.empty())
+  {
+    std::lock_guard<std::mutex> guard(joint_groups_mutex_);
+    for (const auto & group : joint_groups_)
+    {
+      if (group.monitored_goal)
+      {
+        group.monitored_goal->runNonRealtime();
+      }
+    }
+  }
+}
+
+rclcpp_action::GoalResponse JointTrajectoryController::group_goal_received_callback(
+  size_t group_index, const rclcpp_action::GoalUUID &,
+  std::shared_ptr<const FollowJTrajAction::Goal> goal)
+{
+  const auto & group = joint_groups_[group_index];
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Received new action goal of joint group '%s'", group.name.c_str());
+
+  if (get_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Can't accept new action goals. Controller is not running.");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (is_in_chained_mode())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "Can't accept new action goals. The reference interfaces are followed in chained mode.");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (!validate_trajectory_msg(goal->trajectory, &group))
+  {
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Accepted new action goal of joint group '%s'", group.name.c_str());
+  return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+}
+
+rclcpp_action::CancelResponse JointTrajectoryController::group_goal_cancelled_callback(
+  size_t group_index,
+  const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+{
+  auto & group = joint_groups_[group_index];
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Got request to cancel goal of joint group '%s'",
+    group.name.c_str());
+
+  // a goal finished by update() can't be canceled anymore
+  process_goal_state_requests();
+
+  std::lock_guard<std::mutex> guard(joint_groups_mutex_);
+  if (group.goal && group.goal->gh_ == goal_handle)
+  {
+    RCLCPP_INFO(
+      get_node()->get_logger(), "Canceling active action goal of joint group '%s'.",
+      group.name.c_str());
+    group.goal->setCanceled(result_pool_.make_shared());
+    group.goal.reset();
+    goal_monitor_.notify();
+
+    // the joints of the group stop at their current positions
+    write_group_trajectory(group_index, nullptr, {}, false);
+  }
+  return rclcpp_action::CancelResponse::ACCEPT;
+}
+
+void JointTrajectoryController::group_goal_accepted_callback(
+  size_t group_index,
+  std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+{
+  // finish goals terminated by update() before their goal handle is replaced
+  process_goal_state_requests();
+
+  // the joints of the other groups stop if they followed a goal of all joints
+  const bool hold_other_joints = *rt_active_goal_.read_from_non_rt() != nullptr;
+  preempt_active_goal();
+
+  auto & group = joint_groups_[group_index];
+  const auto goal = goal_handle->get_goal();
+  // the tolerances of the goal apply to the joints of the group
+  const auto default_tolerances = get_segment_tolerances(param_listener_->get_params());
+  SegmentTolerances goal_tolerances;
+  if (!get_goal_segment_tolerances(default_tolerances, *goal, params_.joints, goal_tolerances))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Invalid tolerances of the goal, using the default tolerances");
+    goal_tolerances = default_tolerances;
+  }
+
+  // in the joint order of the goal, the joints of the group missing in it stop
+  auto group_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(goal->trajectory);
+  std::vector<size_t> moved_joint_indices;
+  moved_joint_indices.reserve(group_msg->joint_names.size());
+  for (const auto & joint_name : group_msg->joint_names)
+  {
+    moved_joint_indices.push_back(joint_index_.at(joint_name));
+  }
+  prepare_trajectory_msg(*group_msg);
+
+  RealtimeGoalHandlePtr rt_goal = std::make_shared<RealtimeGoalHandle>(goal_handle);
+  // the feedback of the group is copied from the states of all joints into these fields
+  auto & feedback = rt_goal->preallocated_feedback_;
+  feedback->joint_names = group.joint_names;
+  const size_t group_size = group.joint_indices.size();
+  auto resize_like = [group_size](
+                       const JointTrajectoryPoint & point, JointTrajectoryPoint & group_point)
+  {
+    group_point.positions.resize(point.positions.empty() ? 0 : group_size);
+    group_point.velocities.resize(point.velocities.empty() ? 0 : group_size);
+    group_point.accelerations.resize(point.accelerations.empty() ? 0 : group_size);
+  };
+  resize_like(state_current_, feedback->actual);
+  resize_like(state_error_, feedback->error);
+  feedback->desired.positions.resize(group_size);
+  feedback->desired.velocities.resize(group_size);
+  feedback->desired.accelerations.resize(group_size);
+
+  std::lock_guard<std::mutex> guard(joint_groups_mutex_);
+  if (group.goal)
+  {
+    auto action_res = result_pool_.make_shared();
+    action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+    action_res->set__error_string("Current goal cancelled due to new incoming action.");
+    group.goal->setCanceled(action_res);
+  }
+  for (const size_t index : group.joint_indices)
+  {
+    group_tolerances_.state_tolerance[index] = goal_tolerances.state_tolerance[index];
+    group_tolerances_.goal_state_tolerance[index] = goal_tolerances.goal_state_tolerance[index];
+  }
+  group.goal_time_tolerance = goal_tolerances.goal_time_tolerance;
+
+  rt_goal->execute();
+  group.goal = rt_goal;
+  // the goal monitor sends the feedback and the result of the goal from now on
+  group.monitored_goal = rt_goal;
+  write_group_trajectory(group_index, group_msg.get(), moved_joint_indices, hold_other_joints);
+}
+
+void JointTrajectoryController::write_group_trajectory(
+  size_t group_index, const trajectory_msgs::msg::JointTrajectory * group_msg,
+  const std::vector<size_t> & moved_joint_indices, bool hold_other_joints)
+{
+  auto & group = joint_groups_[group_index];
+  const rclcpp::Time now = update_time_.now(*get_node()->get_clock());
+
+  // continue the trajectory update() samples, or the msg of the groups written last if update()
+  // didn't start it yet
+  uint64_t generation = 0;
+  std::shared_ptr<const Trajectory> base = get_trajectory_snapshot(&generation);
+  rclcpp::Time base_time(rt_traj_time_ns_.load(std::memory_order_relaxed), now.get_clock_type());
+  const auto written_msg = *traj_msg_external_point_ptr_.read_from_non_rt();
+  if (
+    group_msg_ && written_msg == group_msg_ && generation == group_msg_generation_ &&
+    !rt_is_holding_)
+  {
+    base = std::make_shared<const Trajectory>(written_msg);
+    base_time = now;
+  }
+
+  std::vector<size_t> held_joint_indices;
+  for (const size_t index : group.joint_indices)
+  {
+    if (
+      std::find(moved_joint_indices.begin(), moved_joint_indices.end(), index) ==
+      moved_joint_indices.end())
+    {
+      held_joint_indices.push_back(index);
+    }
+  }
+  int64_t group_duration_ns = 0;
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> merged_msg;
+  if (base && !hold_other_joints)
+  {
+    merged_msg = merge_group_trajectory(
+      *base, base_time, now, params_.joints, group_msg, moved_joint_indices, held_joint_indices,
+      interpolation_method_, group_duration_ns);
+  }
+  if (!merged_msg)
+  {
+    // start from the current positions instead, e.g., before the first update
+    auto hold_msg =
+      std::make_shared<trajectory_msgs::msg::JointTrajectory>(*hold_position_msg_ptr_);
+    hold_msg->header.stamp = now;
+    hold_msg->points[0].positions = state_current_.positions;
+    base_time = now;
+    merged_msg = merge_group_trajectory(
+      Trajectory(now, hold_msg->points[0], hold_msg), now, now, params_.joints, group_msg,
+      moved_joint_indices, held_joint_indices, interpolation_method_, group_duration_ns);
+  }
+  if (!merged_msg)
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Can't write the trajectory of joint group '%s'.",
+      group.name.c_str());
+    return;
+  }
+  if (!group_msg)
+  {
+    // the same positions update() holds after aborting a goal, or not much apart
+    for (auto & point : merged_msg->points)
+    {
+      for (const size_t index : held_joint_indices)
+      {
+        point.positions[index] = state_current_.positions[index];
+      }
+    }
+  }
+
+  // the goals of the groups in the timeline of the new msg
+  auto group_goals = std::make_shared<GroupGoals>();
+  group_goals->msg = merged_msg.get();
+  const int64_t now_ns = now.nanoseconds();
+  for (size_t index = 0; index < joint_groups_.size(); ++index)
   {
-    return rclcpp_action::GoalResponse::REJECT;
-  }
-
-  RCLCPP_INFO(get_node()->get_logger(), "Accepted new action goal");
-  return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+    auto & joint_group = joint_groups_[index];
+    if (index == group_index && group_msg)
+    {
+      joint_group.end_time_ns = now_ns + group_duration_ns;
+    }
+    else if (joint_group.goal)
+    {
+      joint_group.end_time_ns =
+        now_ns + std::max<int64_t>(0, joint_group.end_time_ns - base_time.nanoseconds());
+    }
+    group_goals->goals.push_back(joint_group.goal);
+    group_goals->end_times_ns.push_back(joint_group.end_time_ns);
+    group_goals->goal_time_tolerances.push_back(joint_group.goal_time_tolerance);
+  }
+  rt_group_goals_.write_from_non_rt(group_goals);
+  add_new_trajectory_msg(merged_msg, &group_tolerances_);
+  group_msg_ = merged_msg;
+  group_msg_generation_ = generation;
+  rt_is_holding_ = false;
 }
 
-rclcpp_action::CancelResponse JointTrajectoryController::goal_cancelled_callback(
-  const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+void JointTrajectoryController::preempt_group_goals(const std::string & reason)
 {
-  RCLCPP_INFO(get_node()->get_logger(), "Got request to cancel goal");
-
-  // Check that cancel request refers to currently active goal (if any)
-  const auto active_goal = *rt_active_goal_.readFromNonRT();
-  if (active_goal && active_goal->gh_ == goal_handle)
+  if (joint_groups_.empty())
   {
-    RCLCPP_INFO(
-      get_node()->get_logger(), "Canceling active action goal because cancel callback received.");
-
-    // Mark the current goal as canceled
-    rt_has_pending_goal_.writeFromNonRT(false);
-    auto action_res = std::make_shared<FollowJTrajAction::Result>();
-    active_goal->setCanceled(action_res);
-    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
-
-    // Enter hold current position mode
-    add_new_trajectory_msg(set_hold_position());
+    return;
   }
-  return rclcpp_action::CancelResponse::ACCEPT;
+  std::lock_guard<std::mutex> guard(joint_groups_mutex_);
+  for (auto & group : joint_groups_)
+  {
+    if (group.goal)
+    {
+      auto action_res = result_pool_.make_shared();
+      action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+      action_res->set__error_string(reason);
+      group.goal->setCanceled(action_res);
+      group.goal.reset();
+    }
+  }
+  // the goals end with the trajectory update() replaces
+  rt_group_goals_.write_from_non_rt(nullptr);
+  group_msg_.reset();
 }
 
-void JointTrajectoryController::goal_accepted_callback(
-  std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+bool JointTrajectoryController::finish_group_goal(
+  const RealtimeGoalHandlePtr & goal, bool succeeded)
 {
-  // mark a pending goal
-  rt_has_pending_goal_.writeFromNonRT(true);
-
-  // Update new trajectory
+  if (joint_groups_.empty())
   {
-    preempt_active_goal();
-    auto traj_msg =
-      std::make_shared<trajectory_msgs::msg::JointTrajectory>(goal_handle->get_goal()->trajectory);
-
-    add_new_trajectory_msg(traj_msg);
-    rt_is_holding_.writeFromNonRT(false);
+    return false;
   }
-
-  // Update the active goal
-  RealtimeGoalHandlePtr rt_goal = std::make_shared<RealtimeGoalHandle>(goal_handle);
-  rt_goal->preallocated_feedback_->joint_names = params_.joints;
-  rt_goal->execute();
-  rt_active_goal_.writeFromNonRT(rt_goal);
-
-  // Set smartpointer to expire for create_wall_timer to delete previous entry from timer list
-  goal_handle_timer_.reset();
-
-  // Setup goal status checking timer
-  goal_handle_timer_ = get_node()->create_wall_timer(
-    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
-    std::bind(&RealtimeGoalHandle::runNonRealtime, rt_goal));
+  std::lock_guard<std::mutex> guard(joint_groups_mutex_);
+  for (size_t group_index = 0; group_index < joint_groups_.size(); ++group_index)
+  {
+    auto & group = joint_groups_[group_index];
+    if (group.goal == goal)
+    {
+      group.goal.reset();
+      // update() stopped the joints of the group, unless it holds the position of all joints
+      if (!succeeded && !rt_is_holding_)
+      {
+        write_group_trajectory(group_index, nullptr, {}, false);
+      }
+      return true;
+    }
+    // canceled meanwhile
+    if (group.monitored_goal == goal)
+    {
+      return true;
+    }
+  }
+  return false;
 }
 
 void JointTrajectoryController::fill_partial_goal(
-  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg) const
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg)
 {
   // joint names in the goal are a subset of existing joints, as checked in goal_callback
   // so if the size matches, the goal contains all controller joints
@@ -1191,15 +3170,19 @@ void JointTrajectoryController::fill_partial_goal(
     return;
   }
 
+  std::vector<bool> is_joint_in_msg(dof_, false);
+  for (const auto & joint_name : trajectory_msg->joint_names)
+  {
+    is_joint_in_msg[joint_index_.at(joint_name)] = true;
+  }
   trajectory_msg->joint_names.reserve(dof_);
+  std::vector<double> hold_positions;
+  get_hold_positions(hold_positions);
 
   for (size_t index = 0; index < dof_; ++index)
   {
     {
-      if (
-        std::find(
-          trajectory_msg->joint_names.begin(), trajectory_msg->joint_names.end(),
-          params_.joints[index]) != trajectory_msg->joint_names.end())
+      if (is_joint_in_msg[index])
       {
         // joint found on msg
         continue;
@@ -1211,18 +3194,7 @@ void JointTrajectoryController::fill_partial_goal(
         // Assume hold position with 0 velocity and acceleration for missing joints
         if (!it.positions.empty())
         {
-          if (
-            has_position_command_interface_ &&
-            !std::isnan(joint_command_interface_[0][index].get().get_value()))
-          {
-            // copy last command if cmd interface exists
-            it.positions.push_back(joint_command_interface_[0][index].get().get_value());
-          }
-          else if (has_position_state_interface_)
-          {
-            // copy current state if state interface exists
-            it.positions.push_back(joint_state_interface_[0][index].get().get_value());
-          }
+          it.positions.push_back(hold_positions[index]);
         }
         if (!it.velocities.empty())
         {
@@ -1244,49 +3216,67 @@ void JointTrajectoryController::fill_partial_goal(
 void JointTrajectoryController::sort_to_local_joint_order(
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg)
 {
-  // rearrange all points in the trajectory message based on mapping
-  std::vector<size_t> mapping_vector = mapping(trajectory_msg->joint_names, params_.joints);
-  auto remap = [this](
-                 const std::vector<double> & to_remap,
-                 const std::vector<size_t> & mapping) -> std::vector<double>
+  // nothing to do for a message in local joint order already
+  if (trajectory_msg->joint_names == params_.joints)
+  {
+    return;
+  }
+
+  // rearrange all points in the trajectory message based on mapping, which is kept as long as the
+  // messages arrive with the same joint order
+  std::lock_guard<std::mutex> guard(sort_mutex_);
+  if (trajectory_msg->joint_names != mapped_joint_names_)
+  {
+    mapped_joint_names_ = trajectory_msg->joint_names;
+    joint_mapping_.clear();
+    for (const auto & joint_name : trajectory_msg->joint_names)
+    {
+      const auto it = joint_index_.find(joint_name);
+      if (it == joint_index_.end())
+      {
+        // same as mapping(), the message is not reordered if it has an unknown joint
+        joint_mapping_.clear();
+        break;
+      }
+      joint_mapping_.push_back(it->second);
+    }
+  }
+  const std::vector<size_t> & mapping_vector = joint_mapping_;
+  // scratch of this instance reused for all points and messages, swapped with the remapped values
+  std::vector<double> & output = sort_scratch_;
+  output.resize(mapping_vector.size());
+  auto remap = [this, &output](std::vector<double> & to_remap, const std::vector<size_t> & mapping)
   {
     if (to_remap.empty())
     {
-      return to_remap;
+      return;
     }
     if (to_remap.size() != mapping.size())
     {
       RCLCPP_WARN(
         get_node()->get_logger(), "Invalid input size (%zu) for sorting", to_remap.size());
-      return to_remap;
-    }
-    static std::vector<double> output(dof_, 0.0);
-    // Only resize if necessary since it's an expensive operation
-    if (output.size() != mapping.size())
-    {
-      output.resize(mapping.size(), 0.0);
+      return;
     }
     for (size_t index = 0; index < mapping.size(); ++index)
     {
       auto map_index = mapping[index];
       output[map_index] = to_remap[index];
     }
-    return output;
+    to_remap.swap(output);
   };
 
-  for (size_t index = 0; index < trajectory_msg->points.size(); ++index)
+  for (auto & point : trajectory_msg->points)
   {
-    trajectory_msg->points[index].positions =
-      remap(trajectory_msg->points[index].positions, mapping_vector);
-
-    trajectory_msg->points[index].velocities =
-      remap(trajectory_msg->points[index].velocities, mapping_vector);
-
-    trajectory_msg->points[index].accelerations =
-      remap(trajectory_msg->points[index].accelerations, mapping_vector);
+    remap(point.positions, mapping_vector);
+    remap(point.velocities, mapping_vector);
+    remap(point.accelerations, mapping_vector);
+    remap(point.effort, mapping_vector);
+  }
 
-    trajectory_msg->points[index].effort =
-      remap(trajectory_msg->points[index].effort, mapping_vector);
+  if (mapping_vector.size() == params_.joints.size())
+  {
+    // the values are in local joint order now
+    trajectory_msg->joint_names = params_.joints;
   }
 }
 
@@ -1310,12 +3300,20 @@ bool JointTrajectoryController::validate_trajectory_point_field(
 }
 
 bool JointTrajectoryController::validate_trajectory_msg(
-  const trajectory_msgs::msg::JointTrajectory & trajectory) const
+  const trajectory_msgs::msg::JointTrajectory & trajectory, const JointGroup * group) const
 {
   // If partial joints goals are not allowed, goal should specify all controller joints
-  if (!params_.allow_partial_joints_goal)
+  if (!allow_partial_joints_goal_.load())
   {
-    if (trajectory.joint_names.size() != dof_)
+    if (group && trajectory.joint_names.size() != group->joint_names.size())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "Joints on incoming trajectory don't match the joints of joint group '%s'.",
+        group->name.c_str());
+      return false;
+    }
+    if (!group && trajectory.joint_names.size() != dof_)
     {
       RCLCPP_ERROR(
         get_node()->get_logger(),
@@ -1341,7 +3339,7 @@ bool JointTrajectoryController::validate_trajectory_msg(
     {
       trajectory_end_time += p.time_from_start;
     }
-    if (trajectory_end_time < get_node()->now())
+    if (trajectory_end_time < update_time_.now(*get_node()->get_clock()))
     {
       RCLCPP_ERROR(
         get_node()->get_logger(),
@@ -1355,17 +3353,25 @@ bool JointTrajectoryController::validate_trajectory_msg(
   {
     const std::string & incoming_joint_name = trajectory.joint_names[i];
 
-    auto it = std::find(params_.joints.begin(), params_.joints.end(), incoming_joint_name);
-    if (it == params_.joints.end())
+    if (joint_index_.find(incoming_joint_name) == joint_index_.end())
     {
       RCLCPP_ERROR(
         get_node()->get_logger(), "Incoming joint %s doesn't match the controller's joints.",
         incoming_joint_name.c_str());
       return false;
     }
+    if (
+      group && std::find(group->joint_names.begin(), group->joint_names.end(),
+                         incoming_joint_name) == group->joint_names.end())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Incoming joint %s isn't a joint of joint group '%s'.",
+        incoming_joint_name.c_str(), group->name.c_str());
+      return false;
+    }
   }
 
-  if (!params_.allow_nonzero_velocity_at_trajectory_end)
+  if (!allow_nonzero_velocity_at_trajectory_end_.load())
   {
     for (size_t i = 0; i < trajectory.points.back().velocities.size(); ++i)
     {
@@ -1380,24 +3386,32 @@ bool JointTrajectoryController::validate_trajectory_msg(
     }
   }
 
+  const size_t joint_count = trajectory.joint_names.size();
+  const auto & points = trajectory.points;
   rclcpp::Duration previous_traj_time(0ms);
-  for (size_t i = 0; i < trajectory.points.size(); ++i)
+  for (size_t i = 0; i < points.size(); ++i)
   {
-    if ((i > 0) && (rclcpp::Duration(trajectory.points[i].time_from_start) <= previous_traj_time))
+    const rclcpp::Duration traj_time = points[i].time_from_start;
+    if ((i > 0) && (traj_time <= previous_traj_time))
     {
       RCLCPP_ERROR(
         get_node()->get_logger(),
         "Time between points %zu and %zu is not strictly increasing, it is %f and %f respectively",
-        i - 1, i, previous_traj_time.seconds(),
-        rclcpp::Duration(trajectory.points[i].time_from_start).seconds());
+        i - 1, i, previous_traj_time.seconds(), traj_time.seconds());
+      return false;
+    }
+    previous_traj_time = traj_time;
+
+    // the other joints continue their trajectory, which is sampled at the points of the group
+    if (group && points[i].positions.empty())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Goals of joint groups need the positions of all points.");
       return false;
     }
-    previous_traj_time = trajectory.points[i].time_from_start;
 
-    const size_t joint_count = trajectory.joint_names.size();
-    const auto & points = trajectory.points;
     // This currently supports only position, velocity and acceleration inputs
-    if (params_.allow_integration_in_goal_trajectories)
+    if (allow_integration_in_goal_trajectories_.load())
     {
       const bool all_empty = points[i].positions.empty() && points[i].velocities.empty() &&
                              points[i].accelerations.empty();
@@ -1436,49 +3450,215 @@ bool JointTrajectoryController::validate_trajectory_msg(
 }
 
 void JointTrajectoryController::add_new_trajectory_msg(
-  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg)
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg,
+  const SegmentTolerances * goal_tolerances)
+{
+  prepare_trajectory_msg(*traj_msg);
+  if (use_compact_storage_)
+  {
+    rt_trajectory_storage_.write_from_non_rt(make_trajectory_storage(*traj_msg));
+  }
+  rt_trajectory_tolerances_.write_from_non_rt(
+    make_trajectory_tolerances(*traj_msg, goal_tolerances));
+  traj_msg_external_point_ptr_.write_from_non_rt(traj_msg);
+}
+
+void JointTrajectoryController::prepare_trajectory_msg(
+  trajectory_msgs::msg::JointTrajectory & traj_msg) const
+{
+  // integrate the missing points here, not in update(). A cubic spline through positions only
+  // sets the velocities and accelerations of all points instead
+  const bool is_cubic_spline =
+    interpolation_method_ == interpolation_methods::InterpolationMethod::CUBIC_SPLINE &&
+    compute_cubic_spline_derivatives(traj_msg);
+  if (!is_cubic_spline && interpolation_method_ != interpolation_methods::InterpolationMethod::NONE)
+  {
+    complete_trajectory_points(traj_msg);
+  }
+}
+
+JointTrajectoryController::TrajectoryTolerances
+JointTrajectoryController::make_trajectory_tolerances(
+  const trajectory_msgs::msg::JointTrajectory & traj_msg,
+  const SegmentTolerances * goal_tolerances) const
 {
-  traj_msg_external_point_ptr_.writeFromNonRT(traj_msg);
+  // the tolerances are taken by update() with the msg, they are resolved here only once
+  TrajectoryTolerances tolerances;
+  tolerances.msg = &traj_msg;
+  if (goal_tolerances)
+  {
+    tolerances.from_goal = true;
+    tolerances.tolerances = *goal_tolerances;
+    tolerances.state_tolerance_arrays = to_state_tolerance_arrays(goal_tolerances->state_tolerance);
+    tolerances.goal_state_tolerance_arrays =
+      to_state_tolerance_arrays(goal_tolerances->goal_state_tolerance);
+  }
+  return tolerances;
+}
+
+JointTrajectoryController::TrajectoryStorage JointTrajectoryController::make_trajectory_storage(
+  const trajectory_msgs::msg::JointTrajectory & traj_msg) const
+{
+  // msgs which aren't complete yet are sampled from their points
+  TrajectoryStorage storage;
+  storage.msg = &traj_msg;
+  storage.storage = CompactTrajectoryStorage::build(traj_msg, compact_value_type_);
+  return storage;
+}
+
+std::shared_ptr<trajectory_msgs::msg::JointTrajectory>
+JointTrajectoryController::splice_trajectory_msg(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg) const
+{
+  const auto current_msg = *traj_msg_external_point_ptr_.read_from_non_rt();
+  const rclcpp::Time new_start_time = traj_msg->header.stamp;
+  // the start time of a msg with zero stamp is known only to update(), it starts now anyway.
+  // When holding, update() might have replaced the current msg without the non-RT side knowing.
+  if (
+    rt_is_holding_ || !current_msg || current_msg->points.empty() ||
+    rclcpp::Time(current_msg->header.stamp).seconds() == 0.0 || new_start_time.seconds() == 0.0)
+  {
+    return traj_msg;
+  }
+
+  // keep the points of the current trajectory which are still ahead, up to the new start time
+  const rclcpp::Time current_start_time = current_msg->header.stamp;
+  const rclcpp::Time now = update_time_.now(*get_node()->get_clock());
+  auto first_kept = std::find_if(
+    current_msg->points.begin(), current_msg->points.end(),
+    [&](const auto & point) { return current_start_time + point.time_from_start > now; });
+  auto last_kept = std::find_if(
+    first_kept, current_msg->points.end(),
+    [&](const auto & point)
+    { return current_start_time + point.time_from_start >= new_start_time; });
+  if (first_kept == last_kept)
+  {
+    return traj_msg;
+  }
+
+  // only the new points are already processed, the kept ones are in local joint order
+  auto spliced_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  spliced_msg->header = current_msg->header;
+  spliced_msg->joint_names = current_msg->joint_names;
+  spliced_msg->points.reserve(
+    static_cast<size_t>(std::distance(first_kept, last_kept)) + traj_msg->points.size());
+  spliced_msg->points.insert(spliced_msg->points.end(), first_kept, last_kept);
+  const rclcpp::Duration start_offset = new_start_time - current_start_time;
+  for (auto & point : traj_msg->points)
+  {
+    point.time_from_start = start_offset + point.time_from_start;
+    spliced_msg->points.push_back(std::move(point));
+  }
+  return spliced_msg;
 }
 
 void JointTrajectoryController::preempt_active_goal()
 {
-  const auto active_goal = *rt_active_goal_.readFromNonRT();
+  // a goal still queued from before queue_goals was reset is preempted as well
+  cancel_queued_goal(
+    FollowJTrajAction::Result::INVALID_GOAL, "Queued goal cancelled due to new incoming action.");
+  const auto active_goal = *rt_active_goal_.read_from_non_rt();
   if (active_goal)
   {
     add_new_trajectory_msg(set_hold_position());
-    auto action_res = std::make_shared<FollowJTrajAction::Result>();
+    auto action_res = result_pool_.make_shared();
     action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
     action_res->set__error_string("Current goal cancelled due to new incoming action.");
     active_goal->setCanceled(action_res);
-    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    rt_active_goal_.write_from_non_rt(RealtimeGoalHandlePtr());
   }
 }
 
 std::shared_ptr<trajectory_msgs::msg::JointTrajectory>
 JointTrajectoryController::set_hold_position()
 {
-  // Command to stay at current position
-  hold_position_msg_ptr_->points[0].positions = state_current_.positions;
+  // Command to stay at current position, in a new msg as update() might still sample the last one
+  auto hold_position_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(
+    *hold_position_msg_ptr_);
+  hold_position_msg->points[0].positions = state_current_.positions;
 
   // set flag, otherwise tolerances will be checked with holding position too
-  rt_is_holding_.writeFromNonRT(true);
+  rt_is_holding_ = true;
 
-  return hold_position_msg_ptr_;
+  return hold_position_msg;
 }
 
-std::shared_ptr<trajectory_msgs::msg::JointTrajectory>
-JointTrajectoryController::set_success_trajectory_point()
+void JointTrajectoryController::switch_to_hold_from_rt(bool repeat_last_point)
 {
-  // set last command to be repeated at success, no matter if it has nonzero velocity or
-  // acceleration
-  hold_position_msg_ptr_->points[0] = traj_external_point_ptr_->get_trajectory_msg()->points.back();
-  hold_position_msg_ptr_->points[0].time_from_start = rclcpp::Duration(0, 0);
+  // the goals of the joint groups end with the trajectory they belong to
+  if (rt_active_group_goals_)
+  {
+    for (size_t group_index = 0; group_index < rt_active_group_goals_->goals.size(); ++group_index)
+    {
+      const auto & goal = rt_active_group_goals_->goals[group_index];
+      if (goal && goal.get() != rt_finished_group_goals_[group_index])
+      {
+        finish_group_goal_from_rt(group_index, FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
+      }
+    }
+    rt_released_group_goals_.retain(rt_active_group_goals_);
+    rt_active_group_goals_.reset();
+    std::fill(rt_group_holding_.begin(), rt_group_holding_.end(), false);
+  }
+
+  // alternate between the preallocated msgs, so that the switch is taken as a new trajectory even
+  // if holding already
+  rt_hold_position_msg_index_ = (rt_hold_position_msg_index_ + 1) % rt_hold_position_msgs_.size();
+  const auto & hold_position_msg = rt_hold_position_msgs_[rt_hold_position_msg_index_];
+  auto & hold_point = hold_position_msg->points[0];
+  const auto & hold_point_template = hold_position_msg_ptr_->points[0];
+  if (repeat_last_point)
+  {
+    // set last command to be repeated at success, no matter if it has nonzero velocity or
+    // acceleration
+    const auto & last_point = traj_external_point_ptr_->get_trajectory_msg()->points.back();
+    hold_point.positions = last_point.positions;
+    hold_point.velocities = last_point.velocities;
+    hold_point.accelerations = last_point.accelerations;
+    hold_point.effort = last_point.effort;
+  }
+  else
+  {
+    // Command to stay at current position
+    hold_point.positions = state_current_.positions;
+    hold_point.velocities = hold_point_template.velocities;
+    hold_point.accelerations = hold_point_template.accelerations;
+    hold_point.effort.clear();
+  }
 
-  // set flag, otherwise tolerances will be checked with success_trajectory_point too
-  rt_is_holding_.writeFromNonRT(true);
+  // set flag, otherwise tolerances will be checked with the hold point too
+  rt_is_holding_ = true;
+  rt_holding_ = true;
+
+  // the value taken by update() is owned by it, so it is replaced without locking, and a msg
+  // written since then is taken in the next cycle. The fields of the msg have reserved memory for
+  // all joints, so nothing is allocated here.
+  rt_released_msgs_.retain(traj_msg_external_point_ptr_.current_from_rt());
+  traj_msg_external_point_ptr_.current_from_rt() = hold_position_msg;
+}
 
-  return hold_position_msg_ptr_;
+bool JointTrajectoryController::is_period_elapsed(
+  const rclcpp::Time & time, const rclcpp::Duration & period, rclcpp::Time & previous_timestamp)
+{
+  if (period.nanoseconds() <= 0)
+  {
+    return true;
+  }
+  try
+  {
+    if (previous_timestamp + period < time)
+    {
+      previous_timestamp += period;
+      return true;
+    }
+  }
+  catch (const std::runtime_error &)
+  {
+    // Handle exceptions when the time source changes and initialize the timestamp
+    previous_timestamp = time;
+    return true;
+  }
+  return false;
 }
 
 bool JointTrajectoryController::contains_interface_type(
@@ -1528,24 +3708,324 @@ bool JointTrajectoryController::has_active_trajectory() const
   return traj_external_point_ptr_ != nullptr && traj_external_point_ptr_->has_trajectory_msg();
 }
 
-void JointTrajectoryController::update_pids()
+JointTrajectoryController::RuntimeParameters
+JointTrajectoryController::make_runtime_parameters(const Params & params)
 {
-  for (size_t i = 0; i < dof_; ++i)
+  RuntimeParameters parameters;
+  parameters.version = ++runtime_parameters_version_;
+  parameters.tolerances = get_segment_tolerances(params);
+  parameters.state_tolerance_arrays =
+    to_state_tolerance_arrays(parameters.tolerances.state_tolerance);
+  parameters.goal_state_tolerance_arrays =
+    to_state_tolerance_arrays(parameters.tolerances.goal_state_tolerance);
+
+  // gains of the PIDs, resolved by joint name only when they change
+  parameters.gains.resize(params.joints.size());
+  parameters.ff_velocity_scale.resize(params.joints.size(), 0.0);
+  for (size_t i = 0; i < params.joints.size(); ++i)
+  {
+    const auto gains = params.gains.joints_map.find(params.joints[i]);
+    if (gains != params.gains.joints_map.end())
+    {
+      parameters.gains[i] = {
+        gains->second.p, gains->second.i, gains->second.d, gains->second.i_clamp,
+        -gains->second.i_clamp, false};
+      parameters.ff_velocity_scale[i] = gains->second.ff_velocity_scale;
+    }
+  }
+  return parameters;
+}
+
+void JointTrajectoryController::update_runtime_parameters()
+{
+  const auto & parameters = *(runtime_parameters_.readFromRT());
+  if (parameters.version == applied_runtime_parameters_version_)
   {
-    const auto & gains = params_.gains.joints_map.at(params_.joints[i]);
-    if (pids_[i])
+    return;
+  }
+  applied_runtime_parameters_version_ = parameters.version;
+
+  // the number of joints does not change, so these copies do not allocate
+  default_tolerances_ = parameters.tolerances;
+  state_tolerance_arrays_ = parameters.state_tolerance_arrays;
+  goal_state_tolerance_arrays_ = parameters.goal_state_tolerance_arrays;
+  if (!active_tolerances_.from_goal)
+  {
+    set_default_tolerances_active();
+  }
+  // variable use_closed_loop_pid_adapter_ is updated in on_configure only
+  if (use_closed_loop_pid_adapter_ && parameters.gains.size() == dof_)
+  {
+    for (size_t i = 0; i < dof_; ++i)
+    {
+      pid_bank_.set_gains(i, parameters.gains[i]);
+      ff_velocity_scale_[i] = parameters.ff_velocity_scale[i];
+    }
+  }
+}
+
+void JointTrajectoryController::update_active_tolerances()
+{
+  const auto * active_msg = traj_external_point_ptr_->get_trajectory_msg().get();
+  const auto & tolerances = *rt_trajectory_tolerances_.read_from_rt();
+  if (tolerances.msg == active_msg)
+  {
+    if (tolerances.from_goal)
     {
-      // update PIDs with gains from ROS parameters
-      pids_[i]->setGains(gains.p, gains.i, gains.d, gains.i_clamp, -gains.i_clamp);
+      // the sizes match the preallocated tolerances, so the copy does not allocate
+      active_tolerances_ = tolerances;
     }
     else
     {
-      // Init PIDs with gains from ROS parameters
-      pids_[i] = std::make_shared<control_toolbox::Pid>(
-        gains.p, gains.i, gains.d, gains.i_clamp, -gains.i_clamp);
+      set_default_tolerances_active();
+    }
+    active_tolerances_.msg = active_msg;
+  }
+  else if (active_tolerances_.from_goal)
+  {
+    // not written yet, or a msg of update() itself like the hold position
+    set_default_tolerances_active();
+  }
+}
+
+void JointTrajectoryController::update_compact_storage()
+{
+  const auto * active_msg = traj_external_point_ptr_->get_trajectory_msg().get();
+  const auto & storage = *rt_trajectory_storage_.read_from_rt();
+  if (storage.msg == active_msg)
+  {
+    rt_released_storages_.retain(traj_external_point_ptr_->get_compact_storage());
+    traj_external_point_ptr_->set_compact_storage(storage.storage);
+    rt_storage_msg_ = active_msg;
+  }
+}
+
+void JointTrajectoryController::update_active_group_goals()
+{
+  const auto * active_msg = traj_external_point_ptr_->get_trajectory_msg().get();
+  if (rt_active_group_goals_ && rt_active_group_goals_->msg == active_msg)
+  {
+    return;
+  }
+  const auto & group_goals = *rt_group_goals_.read_from_rt();
+  if (group_goals && group_goals->msg == active_msg)
+  {
+    for (size_t group_index = 0; group_index < joint_groups_.size(); ++group_index)
+    {
+      // an aborted group stops until its goal is replaced, a finished goal stays finished
+      if (group_goals->goals[group_index].get() != rt_finished_group_goals_[group_index])
+      {
+        rt_finished_group_goals_[group_index] = nullptr;
+        rt_group_holding_[group_index] = false;
+      }
+    }
+    rt_released_group_goals_.retain(rt_active_group_goals_);
+    rt_active_group_goals_ = group_goals;
+  }
+  else if (rt_active_group_goals_)
+  {
+    // replaced by a trajectory without goals of the groups, whose writer ended them
+    rt_released_group_goals_.retain(rt_active_group_goals_);
+    rt_active_group_goals_.reset();
+    std::fill(rt_finished_group_goals_.begin(), rt_finished_group_goals_.end(), nullptr);
+    std::fill(rt_group_holding_.begin(), rt_group_holding_.end(), false);
+  }
+}
+
+bool JointTrajectoryController::check_group_goals(const rclcpp::Time & time, bool first_sample)
+{
+  // copies the values of the joints of a group, the fields of the feedback are preallocated
+  auto copy_joints = [](
+                       const std::vector<double> & values, const std::vector<size_t> & indices,
+                       std::vector<double> & group_values)
+  {
+    for (size_t k = 0; k < group_values.size() && k < indices.size(); ++k)
+    {
+      group_values[k] = indices[k] < values.size() ? values[indices[k]] : 0.0;
+    }
+  };
+  auto copy_point = [&copy_joints](
+                      const JointTrajectoryPoint & point, const std::vector<size_t> & indices,
+                      JointTrajectoryPoint & group_point)
+  {
+    copy_joints(point.positions, indices, group_point.positions);
+    copy_joints(point.velocities, indices, group_point.velocities);
+    copy_joints(point.accelerations, indices, group_point.accelerations);
+  };
+
+  const auto & group_goals = *rt_active_group_goals_;
+  const int64_t traj_time_ns = traj_time_.nanoseconds();
+  // the feedback is delayed while the cycle budget is exceeded, the commands are not
+  const bool send_feedback =
+    update_time_statistics::allows_optional_work(cycle_budget_.get()) &&
+    is_period_elapsed(time, action_feedback_period_, previous_feedback_timestamp_);
+  bool aborted = false;
+  for (size_t group_index = 0; group_index < group_goals.goals.size(); ++group_index)
+  {
+    const auto & goal = group_goals.goals[group_index];
+    if (!goal || goal.get() == rt_finished_group_goals_[group_index])
+    {
+      continue;
+    }
+    const auto & group = joint_groups_[group_index];
+    if (send_feedback)
+    {
+      auto & feedback = goal->preallocated_feedback_;
+      feedback->header.stamp = time;
+      copy_point(state_current_, group.joint_indices, feedback->actual);
+      copy_point(state_desired_, group.joint_indices, feedback->desired);
+      copy_point(state_error_, group.joint_indices, feedback->error);
+      goal->setFeedback(feedback);
+    }
+
+    // same checks as for the goal of all joints, up to the end of the goal of the group
+    const int64_t end_time_ns = group_goals.end_times_ns[group_index];
+    const bool before_last_point = traj_time_ns < end_time_ns;
+    if (
+      (before_last_point || first_sample) &&
+      !check_state_tolerance_of_joints(
+        state_error_, active_tolerances_.state_tolerance_arrays, group.joint_indices))
+    {
+      finish_group_goal_from_rt(group_index, FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
+      rt_logger_->warn(
+        "Aborted the goal of joint group '%s' due to state tolerance violation",
+        group.name.c_str());
+      aborted = true;
+    }
+    else if (!before_last_point)
+    {
+      const double time_difference = static_cast<double>(traj_time_ns - end_time_ns) / 1e9;
+      const double goal_time_tolerance = group_goals.goal_time_tolerances[group_index];
+      if (check_state_tolerance_of_joints(
+            state_error_, active_tolerances_.goal_state_tolerance_arrays, group.joint_indices))
+      {
+        finish_group_goal_from_rt(group_index, FollowJTrajAction::Result::SUCCESSFUL);
+        rt_logger_->info("Goal of joint group '%s' reached, success!", group.name.c_str());
+      }
+      else if (goal_time_tolerance != 0.0 && time_difference > goal_time_tolerance)
+      {
+        finish_group_goal_from_rt(group_index, FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
+        rt_logger_->warn(
+          "Aborted the goal of joint group '%s' due goal_time_tolerance exceeding by %f seconds",
+          group.name.c_str(), time_difference);
+        aborted = true;
+      }
+    }
+  }
+  return aborted;
+}
+
+void JointTrajectoryController::hold_aborted_groups_from_rt()
+{
+  for (size_t group_index = 0; group_index < joint_groups_.size(); ++group_index)
+  {
+    if (!rt_group_holding_[group_index])
+    {
+      continue;
+    }
+    for (const size_t index : joint_groups_[group_index].joint_indices)
+    {
+      state_desired_.positions[index] = rt_group_hold_positions_[index];
+      if (index < state_desired_.velocities.size())
+      {
+        state_desired_.velocities[index] = 0.0;
+      }
+      if (index < state_desired_.accelerations.size())
+      {
+        state_desired_.accelerations[index] = 0.0;
+      }
+    }
+  }
+}
+
+void JointTrajectoryController::finish_group_goal_from_rt(size_t group_index, int32_t error_code)
+{
+  const auto & goal = rt_active_group_goals_->goals[group_index];
+  rt_finished_group_goals_[group_index] = goal.get();
+  // older requests waiting for the channel go first
+  push_unpushed_goal_states_from_rt();
+  if (rt_unpushed_group_goals_[group_index])
+  {
+    // the older request of the group keeps waiting, no goal handle is released here
+    rt_logger_->error(
+      "Too many unprocessed goal state requests, dropped the result of joint group '%s'.",
+      joint_groups_[group_index].name.c_str());
+  }
+  else if (!goal_state_channel_.push(goal, error_code))
+  {
+    // the goal stays finished for update(), its result is sent as soon as the channel has room
+    rt_logger_->warn(
+      "Too many unprocessed goal state requests, retrying the result of joint group '%s' in the "
+      "next update.",
+      joint_groups_[group_index].name.c_str());
+    rt_unpushed_group_goals_[group_index] = goal;
+    rt_unpushed_group_error_codes_[group_index] = error_code;
+  }
+  if (error_code != FollowJTrajAction::Result::SUCCESSFUL)
+  {
+    // the non-RT side replaces the trajectory of the group with holding these positions then
+    rt_group_holding_[group_index] = true;
+    for (const size_t index : joint_groups_[group_index].joint_indices)
+    {
+      rt_group_hold_positions_[index] = state_current_.positions[index];
+    }
+    hold_aborted_groups_from_rt();
+  }
+  goal_monitor_.notify();
+}
+
+void JointTrajectoryController::publish_hold_positions()
+{
+  auto & positions = rt_hold_positions_.write_buffer();
+  for (size_t index = 0; index < dof_; ++index)
+  {
+    positions[index] = std::numeric_limits<double>::quiet_NaN();
+    if (
+      has_position_command_interface_ &&
+      !std::isnan(joint_command_interface_[0][index].get().get_value()))
+    {
+      // copy last command if cmd interface exists
+      positions[index] = joint_command_interface_[0][index].get().get_value();
+    }
+    else if (has_position_state_interface_)
+    {
+      // copy current state if state interface exists
+      positions[index] = joint_state_interface_[0][index].get().get_value();
     }
-    ff_velocity_scale_[i] = gains.ff_velocity_scale;
   }
+  rt_hold_positions_.publish();
+}
+
+void JointTrajectoryController::get_hold_positions(std::vector<double> & positions)
+{
+  std::lock_guard<std::mutex> guard(hold_positions_mutex_);
+  rt_hold_positions_.update_read_buffer();
+  positions = rt_hold_positions_.read_buffer();
+}
+
+void JointTrajectoryController::drop_trajectory_snapshots()
+{
+  std::lock_guard<std::mutex> guard(trajectory_snapshot_mutex_);
+  rt_trajectory_snapshots_.update_read_buffer();
+  trajectory_snapshot_.reset();
+  trajectory_snapshot_generation_ = 0;
+}
+
+void JointTrajectoryController::set_default_tolerances_active()
+{
+  active_tolerances_.from_goal = false;
+  active_tolerances_.tolerances = default_tolerances_;
+  active_tolerances_.state_tolerance_arrays = state_tolerance_arrays_;
+  active_tolerances_.goal_state_tolerance_arrays = goal_state_tolerance_arrays_;
+}
+
+void JointTrajectoryController::store_dynamic_parameters(const Params & params)
+{
+  allow_partial_joints_goal_.store(params.allow_partial_joints_goal);
+  splice_incoming_trajectories_.store(params.splice_incoming_trajectories);
+  allow_integration_in_goal_trajectories_.store(params.allow_integration_in_goal_trajectories);
+  allow_nonzero_velocity_at_trajectory_end_.store(params.allow_nonzero_velocity_at_trajectory_end);
+  queue_goals_.store(params.queue_goals);
 }
 
 void JointTrajectoryController::init_hold_position_msg()
@@ -1568,6 +4048,19 @@ void JointTrajectoryController::init_hold_position_msg()
     // add velocity, so that trajectory sampling returns acceleration points in any case
     hold_position_msg_ptr_->points[0].accelerations.resize(dof_, 0.0);
   }
+
+  // msgs used by update(), with memory for all fields of a trajectory point
+  for (auto & rt_hold_position_msg : rt_hold_position_msgs_)
+  {
+    rt_hold_position_msg =
+      std::make_shared<trajectory_msgs::msg::JointTrajectory>(*hold_position_msg_ptr_);
+    auto & hold_point = rt_hold_position_msg->points[0];
+    hold_point.positions.reserve(dof_);
+    hold_point.velocities.reserve(dof_);
+    hold_point.accelerations.reserve(dof_);
+    hold_point.effort.reserve(dof_);
+  }
+  rt_hold_position_msg_index_ = 0;
 }
 
 }  // namespace joint_trajectory_controller
@@ -1575,4 +4068,5 @@ void JointTrajectoryController::init_hold_position_msg()
 #include "pluginlib/class_list_macros.hpp"
 
 PLUGINLIB_EXPORT_CLASS(
-  joint_trajectory_controller::JointTrajectoryController, controller_interface::ControllerInterface)
+  joint_trajectory_controller::JointTrajectoryController,
+  controller_interface::ChainableControllerInterface)
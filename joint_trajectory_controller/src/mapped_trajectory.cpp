@@ -0,0 +1,501 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/mapped_trajectory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "rclcpp/duration.hpp"
+#include "rclcpp/time.hpp"
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+constexpr std::array<char, 8> TRAJECTORY_MAGIC = {'J', 'T', 'C', 'T', 'R', 'A', 'J', '\0'};
+constexpr uint32_t TRAJECTORY_VERSION = 1;
+constexpr uint32_t HAS_VELOCITIES = 1u << 0;
+constexpr uint32_t HAS_ACCELERATIONS = 1u << 1;
+// the arrays start at a cache line
+constexpr uint64_t DATA_ALIGNMENT = 64;
+// points ahead of the sampled segment prefetched into the cache by sample()
+constexpr size_t CACHE_PREFETCH_POINTS = 8;
+// forward steps of the segment cursor before searching
+constexpr size_t MAX_CURSOR_STEPS = 8;
+
+/// Read a \p value at \p offset of the \p size bytes at \p data, and advance \p offset
+template <typename T>
+bool read_value(const uint8_t * data, size_t size, size_t & offset, T & value)
+{
+  if (size < sizeof(T) || offset > size - sizeof(T))
+  {
+    return false;
+  }
+  std::memcpy(&value, data + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+template <typename T>
+void write_value(std::ofstream & file, const T & value)
+{
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+}  // namespace
+
+bool MappedTrajectory::open(const std::string & path, std::string & error)
+{
+  close();
+#ifdef _WIN32
+  error = "Trajectory files are not supported on Windows.";
+  return false;
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    error = "Can't open '" + path + "': " + std::strerror(errno);
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0)
+  {
+    ::close(fd);
+    error = "'" + path + "' is empty.";
+    return false;
+  }
+  mapping_size_ = static_cast<size_t>(file_stat.st_size);
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping_ == MAP_FAILED)
+  {
+    mapping_ = nullptr;
+    error = "Can't map '" + path + "': " + std::strerror(errno);
+    return false;
+  }
+  // the realtime loop reads the file from the beginning to the end
+  madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+
+  const auto * data = static_cast<const uint8_t *>(mapping_);
+  size_t offset = 0;
+  std::array<char, 8> magic;
+  uint32_t version = 0;
+  uint32_t fields = 0;
+  uint64_t num_points = 0;
+  uint64_t data_offset = 0;
+  uint32_t num_joints = 0;
+  if (
+    !read_value(data, mapping_size_, offset, magic) || magic != TRAJECTORY_MAGIC ||
+    !read_value(data, mapping_size_, offset, version) || version != TRAJECTORY_VERSION ||
+    !read_value(data, mapping_size_, offset, fields) ||
+    !read_value(data, mapping_size_, offset, num_points) ||
+    !read_value(data, mapping_size_, offset, data_offset) ||
+    !read_value(data, mapping_size_, offset, num_joints))
+  {
+    close();
+    error = "'" + path + "' isn't a trajectory file of version " +
+            std::to_string(TRAJECTORY_VERSION) + ".";
+    return false;
+  }
+  for (uint32_t i = 0; i < num_joints; ++i)
+  {
+    uint32_t length = 0;
+    if (!read_value(data, mapping_size_, offset, length) || length > mapping_size_ - offset)
+    {
+      close();
+      error = "The joint names of '" + path + "' are incomplete.";
+      return false;
+    }
+    joint_names_.emplace_back(reinterpret_cast<const char *>(data + offset), length);
+    offset += length;
+  }
+
+  // all arrays have one value per point, of each joint for the positions and derivatives
+  const uint64_t num_arrays = 1u + (fields & HAS_VELOCITIES ? 1u : 0u) +
+                              (fields & HAS_ACCELERATIONS ? 1u : 0u);
+  if (
+    num_joints == 0 || num_points == 0 || data_offset < offset ||
+    data_offset % DATA_ALIGNMENT != 0 || data_offset > mapping_size_ ||
+    num_points > (mapping_size_ - data_offset) / sizeof(int64_t) / (1u + num_arrays * num_joints))
+  {
+    close();
+    error = "'" + path + "' has no points or is truncated.";
+    return false;
+  }
+  num_points_ = static_cast<size_t>(num_points);
+  times_ns_ = reinterpret_cast<const int64_t *>(data + data_offset);
+  positions_ = reinterpret_cast<const double *>(times_ns_ + num_points_);
+  const double * next_array = positions_ + num_points_ * num_joints;
+  if (fields & HAS_VELOCITIES)
+  {
+    velocities_ = next_array;
+    next_array += num_points_ * num_joints;
+  }
+  if (fields & HAS_ACCELERATIONS)
+  {
+    accelerations_ = next_array;
+  }
+
+  // the times are read here once anyway, which also loads their pages
+  for (size_t i = 0; i < num_points_; ++i)
+  {
+    if (times_ns_[i] < 0 || (i > 0 && times_ns_[i] <= times_ns_[i - 1]))
+    {
+      close();
+      error = "The times from start of '" + path + "' aren't increasing at point " +
+              std::to_string(i) + ".";
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+void MappedTrajectory::close()
+{
+#ifndef _WIN32
+  if (mapping_)
+  {
+    munmap(mapping_, mapping_size_);
+  }
+#endif
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  joint_names_.clear();
+  num_points_ = 0;
+  times_ns_ = nullptr;
+  positions_ = nullptr;
+  velocities_ = nullptr;
+  accelerations_ = nullptr;
+  joint_mapping_.clear();
+}
+
+bool MappedTrajectory::set_joint_order(
+  const std::vector<std::string> & joint_names, std::string & error)
+{
+  if (joint_names.size() != joint_names_.size())
+  {
+    error = "The trajectory file has " + std::to_string(joint_names_.size()) +
+            " joints, expected " + std::to_string(joint_names.size()) + ".";
+    return false;
+  }
+  joint_mapping_.clear();
+  for (const auto & joint_name : joint_names)
+  {
+    const auto it = std::find(joint_names_.begin(), joint_names_.end(), joint_name);
+    if (it == joint_names_.end())
+    {
+      error = "The trajectory file has no joint '" + joint_name + "'.";
+      return false;
+    }
+    joint_mapping_.push_back(static_cast<size_t>(std::distance(joint_names_.begin(), it)));
+  }
+
+  const size_t dim = joint_names.size();
+  for (auto * point : {&start_state_, &segment_start_, &segment_end_})
+  {
+    point->positions.reserve(dim);
+    point->velocities.reserve(dim);
+    point->accelerations.reserve(dim);
+  }
+  interpolator_.reserve(dim);
+  return true;
+}
+
+void MappedTrajectory::start(const trajectory_msgs::msg::JointTrajectoryPoint & start_state)
+{
+  // a derivative is only interpolated from the start state if both have it
+  start_state_.positions.assign(start_state.positions.begin(), start_state.positions.end());
+  if (has_velocities() && start_state.velocities.size() == start_state.positions.size())
+  {
+    start_state_.velocities.assign(start_state.velocities.begin(), start_state.velocities.end());
+  }
+  else
+  {
+    start_state_.velocities.clear();
+  }
+  if (has_accelerations() && start_state.accelerations.size() == start_state.positions.size())
+  {
+    start_state_.accelerations.assign(
+      start_state.accelerations.begin(), start_state.accelerations.end());
+  }
+  else
+  {
+    start_state_.accelerations.clear();
+  }
+  segment_end_idx_.store(0, std::memory_order_relaxed);
+  loaded_segment_end_idx_ = NO_SEGMENT;
+}
+
+bool MappedTrajectory::sample(
+  const int64_t time_ns, trajectory_msgs::msg::JointTrajectoryPoint & output)
+{
+  size_t end_idx = segment_end_idx_.load(std::memory_order_relaxed);
+  if (end_idx < num_points_ && time_ns >= times_ns_[end_idx])
+  {
+    end_idx = find_point_after(end_idx, time_ns);
+    segment_end_idx_.store(end_idx, std::memory_order_relaxed);
+  }
+
+  // past the last point, its state is held
+  if (end_idx == num_points_)
+  {
+    if (loaded_segment_end_idx_ != end_idx)
+    {
+      load_point(num_points_ - 1, segment_end_);
+      loaded_segment_end_idx_ = end_idx;
+    }
+    output.positions.assign(segment_end_.positions.begin(), segment_end_.positions.end());
+    output.velocities.assign(segment_end_.positions.size(), 0.0);
+    output.accelerations.assign(segment_end_.positions.size(), 0.0);
+    for (size_t i = 0; i < segment_end_.velocities.size(); ++i)
+    {
+      output.velocities[i] = segment_end_.velocities[i];
+    }
+    for (size_t i = 0; i < segment_end_.accelerations.size(); ++i)
+    {
+      output.accelerations[i] = segment_end_.accelerations[i];
+    }
+    return false;
+  }
+
+  if (loaded_segment_end_idx_ != end_idx)
+  {
+    if (end_idx == 0)
+    {
+      segment_start_ = start_state_;
+    }
+    else
+    {
+      load_point(end_idx - 1, segment_start_);
+    }
+    load_point(end_idx, segment_end_);
+    loaded_segment_end_idx_ = end_idx;
+
+#if defined(__GNUC__) || defined(__clang__)
+    // the next segments are in the cache when the cursor gets there
+    const size_t ahead_idx = std::min(end_idx + CACHE_PREFETCH_POINTS, num_points_ - 1);
+    __builtin_prefetch(times_ns_ + ahead_idx);
+    for (const size_t joint : joint_mapping_)
+    {
+      const size_t value_idx = joint * num_points_ + ahead_idx;
+      __builtin_prefetch(positions_ + value_idx);
+      if (velocities_)
+      {
+        __builtin_prefetch(velocities_ + value_idx);
+      }
+      if (accelerations_)
+      {
+        __builtin_prefetch(accelerations_ + value_idx);
+      }
+    }
+#endif
+  }
+
+  const int64_t start_ns = end_idx == 0 ? 0 : times_ns_[end_idx - 1];
+  interpolator_.interpolate_between_points(
+    rclcpp::Time(start_ns), segment_start_, rclcpp::Time(times_ns_[end_idx]), segment_end_,
+    rclcpp::Time(time_ns), output);
+  return true;
+}
+
+void MappedTrajectory::prefetch(const int64_t horizon_ns)
+{
+  const size_t cursor = segment_end_idx_.load(std::memory_order_relaxed);
+  if (cursor >= num_points_)
+  {
+    return;
+  }
+  const size_t begin_idx = std::max(cursor, prefetched_idx_);
+  const size_t end_idx = find_point_after(cursor, times_ns_[cursor] + horizon_ns);
+  if (begin_idx >= end_idx)
+  {
+    return;
+  }
+
+  load_pages(times_ns_ + begin_idx, times_ns_ + end_idx);
+  for (const auto * values : {positions_, velocities_, accelerations_})
+  {
+    if (!values)
+    {
+      continue;
+    }
+    for (const size_t joint : joint_mapping_)
+    {
+      const double * joint_values = values + joint * num_points_;
+      load_pages(joint_values + begin_idx, joint_values + end_idx);
+    }
+  }
+  prefetched_idx_ = end_idx;
+}
+
+void MappedTrajectory::load_point(
+  const size_t index, trajectory_msgs::msg::JointTrajectoryPoint & point) const
+{
+  // the memory was reserved by set_joint_order(), the point might be a copy of the start state
+  const size_t dim = joint_mapping_.size();
+  point.positions.resize(dim);
+  point.velocities.resize(velocities_ ? dim : 0);
+  point.accelerations.resize(accelerations_ ? dim : 0);
+  for (size_t i = 0; i < dim; ++i)
+  {
+    const size_t value_idx = joint_mapping_[i] * num_points_ + index;
+    point.positions[i] = positions_[value_idx];
+    if (velocities_)
+    {
+      point.velocities[i] = velocities_[value_idx];
+    }
+    if (accelerations_)
+    {
+      point.accelerations[i] = accelerations_[value_idx];
+    }
+  }
+}
+
+size_t MappedTrajectory::find_point_after(const size_t first, const int64_t time_ns) const
+{
+  size_t index = first;
+  for (size_t step = 0; step < MAX_CURSOR_STEPS; ++step, ++index)
+  {
+    if (index == num_points_ || times_ns_[index] > time_ns)
+    {
+      return index;
+    }
+  }
+  return static_cast<size_t>(
+    std::upper_bound(times_ns_ + index, times_ns_ + num_points_, time_ns) - times_ns_);
+}
+
+void MappedTrajectory::load_pages(const void * begin, const void * end) const
+{
+#ifndef _WIN32
+  static const auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t first_page = reinterpret_cast<uintptr_t>(begin) & ~(page_size - 1);
+  const uintptr_t end_address = reinterpret_cast<uintptr_t>(end);
+  madvise(
+    reinterpret_cast<void *>(first_page), static_cast<size_t>(end_address - first_page),
+    MADV_WILLNEED);
+  // the advice is asynchronous, reading a byte of every page waits until it is loaded
+  for (uintptr_t page = first_page; page < end_address; page += page_size)
+  {
+    static_cast<void>(*reinterpret_cast<const volatile uint8_t *>(page));
+  }
+#else
+  static_cast<void>(begin);
+  static_cast<void>(end);
+#endif
+}
+
+bool write_mapped_trajectory(
+  const std::string & path, const trajectory_msgs::msg::JointTrajectory & trajectory,
+  std::string & error)
+{
+  const size_t num_joints = trajectory.joint_names.size();
+  if (num_joints == 0 || trajectory.points.empty())
+  {
+    error = "The trajectory has no joints or no points.";
+    return false;
+  }
+  bool has_velocities = true;
+  bool has_accelerations = true;
+  for (const auto & point : trajectory.points)
+  {
+    if (point.positions.size() != num_joints)
+    {
+      error = "Every point needs the positions of all joints.";
+      return false;
+    }
+    has_velocities = has_velocities && point.velocities.size() == num_joints;
+    has_accelerations = has_accelerations && point.accelerations.size() == num_joints;
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    error = "Can't write '" + path + "'.";
+    return false;
+  }
+  uint64_t header_size = sizeof(TRAJECTORY_MAGIC) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t) +
+                         sizeof(uint32_t);
+  for (const auto & joint_name : trajectory.joint_names)
+  {
+    header_size += sizeof(uint32_t) + joint_name.size();
+  }
+  const uint64_t data_offset = (header_size + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+
+  write_value(file, TRAJECTORY_MAGIC);
+  write_value(file, TRAJECTORY_VERSION);
+  write_value(
+    file, (has_velocities ? HAS_VELOCITIES : 0u) | (has_accelerations ? HAS_ACCELERATIONS : 0u));
+  write_value(file, static_cast<uint64_t>(trajectory.points.size()));
+  write_value(file, data_offset);
+  write_value(file, static_cast<uint32_t>(num_joints));
+  for (const auto & joint_name : trajectory.joint_names)
+  {
+    write_value(file, static_cast<uint32_t>(joint_name.size()));
+    file.write(joint_name.data(), static_cast<std::streamsize>(joint_name.size()));
+  }
+  for (uint64_t i = header_size; i < data_offset; ++i)
+  {
+    write_value(file, uint8_t{0});
+  }
+
+  for (const auto & point : trajectory.points)
+  {
+    write_value(file, static_cast<int64_t>(rclcpp::Duration(point.time_from_start).nanoseconds()));
+  }
+  auto write_joint_arrays =
+    [&](const std::vector<double> trajectory_msgs::msg::JointTrajectoryPoint::*field)
+  {
+    for (size_t joint = 0; joint < num_joints; ++joint)
+    {
+      for (const auto & point : trajectory.points)
+      {
+        write_value(file, (point.*field)[joint]);
+      }
+    }
+  };
+  write_joint_arrays(&trajectory_msgs::msg::JointTrajectoryPoint::positions);
+  if (has_velocities)
+  {
+    write_joint_arrays(&trajectory_msgs::msg::JointTrajectoryPoint::velocities);
+  }
+  if (has_accelerations)
+  {
+    write_joint_arrays(&trajectory_msgs::msg::JointTrajectoryPoint::accelerations);
+  }
+
+  file.close();
+  if (!file)
+  {
+    error = "Can't write '" + path + "'.";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace joint_trajectory_controller
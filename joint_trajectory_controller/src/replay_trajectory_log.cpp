@@ -0,0 +1,392 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replays a log of the joint trajectory controller through update() at full speed, see the
+// 'recording' parameters of the controller.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "control_msgs/action/follow_joint_trajectory.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "joint_trajectory_controller/joint_trajectory_controller.hpp"
+#include "joint_trajectory_controller/trajectory_recorder.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rcl_interfaces/msg/parameter_event.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+namespace
+{
+using joint_trajectory_controller::LogRecord;
+using joint_trajectory_controller::RecordKind;
+using FollowJTrajGoal = control_msgs::action::FollowJointTrajectory::Goal;
+
+constexpr char USAGE[] =
+  "Usage: replay_trajectory_log <log> [--latencies <file>] [--no-recorded-parameters]\n"
+  "                             [--ros-args ...]\n"
+  "\n"
+  "Replays the trajectories, goals and state interface values of a log of the joint trajectory\n"
+  "controller through update() as fast as possible, and reports the latencies of the updates and\n"
+  "the deviation of the commands from the recorded ones.\n"
+  "\n"
+  "  --latencies <file>        write the latency of every update in microseconds to <file>\n"
+  "  --no-recorded-parameters  use the parameters of --ros-args instead of the recorded ones\n";
+
+/// Controller taking the msgs and goals of the log instead of its topic and action server
+class ReplayController : public joint_trajectory_controller::JointTrajectoryController
+{
+public:
+  void replay_trajectory(const trajectory_msgs::msg::JointTrajectory & msg)
+  {
+    topic_callback(std::make_shared<trajectory_msgs::msg::JointTrajectory>(msg));
+  }
+
+  /// Execute the trajectory of \p goal with its tolerances, like an accepted goal without a client
+  void replay_goal(const FollowJTrajGoal & goal)
+  {
+    const auto default_tolerances =
+      joint_trajectory_controller::get_segment_tolerances(param_listener_->get_params());
+    joint_trajectory_controller::SegmentTolerances goal_tolerances;
+    if (!joint_trajectory_controller::get_goal_segment_tolerances(
+          default_tolerances, goal, params_.joints, goal_tolerances))
+    {
+      goal_tolerances = default_tolerances;
+    }
+    auto traj_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(goal.trajectory);
+    fill_partial_goal(traj_msg);
+    sort_to_local_joint_order(traj_msg);
+    add_new_trajectory_msg(traj_msg, &goal_tolerances);
+    rt_is_holding_ = false;
+  }
+
+  void replay_cancel() { add_new_trajectory_msg(set_hold_position()); }
+};
+
+struct Session
+{
+  std::vector<std::string> state_names;
+  std::vector<std::string> command_names;
+  std::vector<LogRecord> records;
+};
+
+/// Statistics of the replay of a session
+struct Result
+{
+  size_t updates = 0;
+  size_t dropped_updates = 0;
+  size_t trajectories = 0;
+  size_t goals = 0;
+  size_t cancellations = 0;
+  std::vector<double> latencies_us;
+  double max_command_deviation = 0.0;
+};
+
+double deviation(double replayed, double recorded)
+{
+  if (std::isnan(replayed) || std::isnan(recorded))
+  {
+    return std::isnan(replayed) == std::isnan(recorded) ? 0.0
+                                                         : std::numeric_limits<double>::infinity();
+  }
+  return std::abs(replayed - recorded);
+}
+
+double percentile(const std::vector<double> & sorted_values, double p)
+{
+  const auto index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted_values.size())));
+  return sorted_values[std::min(std::max<size_t>(index, 1), sorted_values.size()) - 1];
+}
+
+/// Index of every name of \p names in \p interface_names, or -1 if the controller doesn't use it
+std::vector<int> map_names(
+  const std::vector<std::string> & names, const std::vector<std::string> & interface_names)
+{
+  std::vector<int> indices;
+  for (const auto & name : names)
+  {
+    const auto it = std::find(interface_names.begin(), interface_names.end(), name);
+    indices.push_back(
+      it == interface_names.end() ? -1 : static_cast<int>(it - interface_names.begin()));
+  }
+  return indices;
+}
+
+/// Activate \p controller on in-memory interfaces, replay \p session and deactivate it again
+bool replay_session(ReplayController & controller, const Session & session, Result & result)
+{
+  const auto state_names = controller.state_interface_configuration().names;
+  const auto command_names = controller.command_interface_configuration().names;
+  const auto state_indices = map_names(session.state_names, state_names);
+  const auto command_indices = map_names(session.command_names, command_names);
+  for (size_t index = 0; index < state_names.size(); ++index)
+  {
+    if (
+      std::find(session.state_names.begin(), session.state_names.end(), state_names[index]) ==
+      session.state_names.end())
+    {
+      std::fprintf(
+        stderr, "The state interface '%s' wasn't recorded, it is zero.\n",
+        state_names[index].c_str());
+    }
+  }
+
+  // deques, so the addresses stay valid while the interfaces are created
+  std::deque<double> state_values(state_names.size(), 0.0);
+  std::deque<double> command_values(command_names.size(), 0.0);
+  std::deque<hardware_interface::StateInterface> state_interfaces;
+  std::deque<hardware_interface::CommandInterface> command_interfaces;
+  std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+  std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+  for (size_t index = 0; index < state_names.size(); ++index)
+  {
+    const auto separator = state_names[index].rfind('/');
+    state_interfaces.emplace_back(
+      state_names[index].substr(0, separator), state_names[index].substr(separator + 1),
+      &state_values[index]);
+    loaned_state_interfaces.emplace_back(state_interfaces.back());
+  }
+  for (size_t index = 0; index < command_names.size(); ++index)
+  {
+    const auto separator = command_names[index].rfind('/');
+    command_interfaces.emplace_back(
+      command_names[index].substr(0, separator), command_names[index].substr(separator + 1),
+      &command_values[index]);
+    loaned_command_interfaces.emplace_back(command_interfaces.back());
+  }
+
+  auto write_states = [&](const LogRecord & record)
+  {
+    for (size_t index = 0; index < state_indices.size(); ++index)
+    {
+      if (state_indices[index] >= 0)
+      {
+        state_values[static_cast<size_t>(state_indices[index])] = record.state_values[index];
+      }
+    }
+  };
+  // the controller holds the position of the first update on activation
+  const auto first_update = std::find_if(
+    session.records.begin(), session.records.end(),
+    [](const LogRecord & record) { return record.kind == RecordKind::UPDATE; });
+  if (first_update != session.records.end())
+  {
+    write_states(*first_update);
+  }
+
+  controller.assign_interfaces(
+    std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+  if (
+    controller.get_node()->activate().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+  {
+    std::fprintf(stderr, "Failed to activate the controller.\n");
+    return false;
+  }
+
+  uint64_t next_cycle = 0;
+  for (const auto & record : session.records)
+  {
+    switch (record.kind)
+    {
+      case RecordKind::TRAJECTORY:
+        controller.replay_trajectory(
+          joint_trajectory_controller::deserialize_record_payload<
+            trajectory_msgs::msg::JointTrajectory>(record.payload));
+        ++result.trajectories;
+        break;
+      case RecordKind::GOAL:
+        controller.replay_goal(
+          joint_trajectory_controller::deserialize_record_payload<FollowJTrajGoal>(
+            record.payload));
+        ++result.goals;
+        break;
+      case RecordKind::CANCEL:
+        controller.replay_cancel();
+        ++result.cancellations;
+        break;
+      case RecordKind::UPDATE:
+      {
+        result.dropped_updates += static_cast<size_t>(record.cycle - next_cycle);
+        next_cycle = record.cycle + 1;
+        write_states(record);
+        const rclcpp::Time time(record.time_ns, RCL_ROS_TIME);
+        const auto period = rclcpp::Duration::from_nanoseconds(record.period_ns);
+        const auto start = std::chrono::steady_clock::now();
+        controller.update(time, period);
+        const auto end = std::chrono::steady_clock::now();
+        result.latencies_us.push_back(
+          std::chrono::duration<double, std::micro>(end - start).count());
+        for (size_t index = 0; index < command_indices.size(); ++index)
+        {
+          if (command_indices[index] >= 0)
+          {
+            result.max_command_deviation = std::max(
+              result.max_command_deviation,
+              deviation(
+                command_values[static_cast<size_t>(command_indices[index])],
+                record.command_values[index]));
+          }
+        }
+        ++result.updates;
+        break;
+      }
+      case RecordKind::SESSION:
+        break;
+    }
+  }
+
+  controller.get_node()->deactivate();
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  const auto arguments = rclcpp::remove_ros_arguments(argc, argv);
+  std::string log_path;
+  std::string latencies_path;
+  bool use_recorded_parameters = true;
+  for (size_t index = 1; index < arguments.size(); ++index)
+  {
+    if (arguments[index] == "--latencies" && index + 1 < arguments.size())
+    {
+      latencies_path = arguments[++index];
+    }
+    else if (arguments[index] == "--no-recorded-parameters")
+    {
+      use_recorded_parameters = false;
+    }
+    else if (log_path.empty() && arguments[index].rfind("--", 0) != 0)
+    {
+      log_path = arguments[index];
+    }
+    else
+    {
+      std::fprintf(stderr, "%s", USAGE);
+      return 1;
+    }
+  }
+  if (log_path.empty())
+  {
+    std::fprintf(stderr, "%s", USAGE);
+    return 1;
+  }
+
+  // the whole log is read first, so the replay doesn't wait for the file
+  joint_trajectory_controller::TrajectoryLogReader reader;
+  if (!reader.open(log_path))
+  {
+    std::fprintf(
+      stderr, "'%s' is not a log of the joint trajectory controller.\n", log_path.c_str());
+    return 1;
+  }
+  std::vector<Session> sessions;
+  LogRecord record;
+  while (reader.read(record))
+  {
+    if (record.kind == RecordKind::SESSION)
+    {
+      sessions.push_back(Session{record.state_names, record.command_names, {}});
+    }
+    else if (!sessions.empty())
+    {
+      sessions.back().records.push_back(record);
+    }
+  }
+
+  std::vector<rclcpp::Parameter> parameter_overrides;
+  if (use_recorded_parameters)
+  {
+    const auto parameters =
+      joint_trajectory_controller::deserialize_record_payload<rcl_interfaces::msg::ParameterEvent>(
+        reader.parameters());
+    for (const auto & parameter : parameters.new_parameters)
+    {
+      parameter_overrides.push_back(rclcpp::Parameter::from_parameter_msg(parameter));
+    }
+  }
+  // the replay is not recorded again
+  parameter_overrides.erase(
+    std::remove_if(
+      parameter_overrides.begin(), parameter_overrides.end(),
+      [](const rclcpp::Parameter & parameter)
+      { return parameter.get_name() == "recording.enable"; }),
+    parameter_overrides.end());
+  parameter_overrides.emplace_back("recording.enable", false);
+
+  auto controller = std::make_shared<ReplayController>();
+  auto node_options = rclcpp::NodeOptions()
+                        .allow_undeclared_parameters(false)
+                        .automatically_declare_parameters_from_overrides(false)
+                        .parameter_overrides(parameter_overrides);
+  if (
+    controller->init(reader.controller_name(), "", 0, "", node_options) !=
+      controller_interface::return_type::OK ||
+    controller->get_node()->configure().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+  {
+    std::fprintf(stderr, "Failed to configure the controller.\n");
+    return 1;
+  }
+
+  std::ofstream latencies_file;
+  if (!latencies_path.empty())
+  {
+    latencies_file.open(latencies_path);
+  }
+  for (size_t index = 0; index < sessions.size(); ++index)
+  {
+    Result result;
+    if (!replay_session(*controller, sessions[index], result))
+    {
+      return 1;
+    }
+    for (const auto latency : result.latencies_us)
+    {
+      latencies_file << latency << '\n';
+    }
+    std::printf(
+      "session %zu: %zu updates (%zu dropped while recording), %zu trajectories, %zu goals, "
+      "%zu cancellations\n",
+      index + 1, result.updates, result.dropped_updates, result.trajectories, result.goals,
+      result.cancellations);
+    if (!result.latencies_us.empty())
+    {
+      std::sort(result.latencies_us.begin(), result.latencies_us.end());
+      std::printf(
+        "  update latency [us]: p50 %.3f, p99 %.3f, max %.3f\n",
+        percentile(result.latencies_us, 0.5), percentile(result.latencies_us, 0.99),
+        result.latencies_us.back());
+      std::printf(
+        "  max deviation of the commands from the recording: %g\n", result.max_command_deviation);
+    }
+  }
+
+  controller->get_node()->cleanup();
+  controller.reset();
+  rclcpp::shutdown();
+  return 0;
+}
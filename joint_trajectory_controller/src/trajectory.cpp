@@ -14,8 +14,16 @@
 
 #include "joint_trajectory_controller/trajectory.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <utility>
+#include <vector>
 
+#include "builtin_interfaces/msg/duration.hpp"
 #include "hardware_interface/macros.hpp"
 #include "rclcpp/duration.hpp"
 #include "rclcpp/time.hpp"
@@ -23,6 +31,142 @@
 
 namespace joint_trajectory_controller
 {
+namespace
+{
+// same conversion as rclcpp::Duration::seconds()
+double nanoseconds_to_seconds(int64_t nanoseconds)
+{
+  return static_cast<double>(nanoseconds) / 1e9;
+}
+
+// it changes points only if position and velocity do not exist, but their derivatives
+void deduce_from_derivatives(
+  trajectory_msgs::msg::JointTrajectoryPoint & first_state,
+  trajectory_msgs::msg::JointTrajectoryPoint & second_state, const size_t dim, const double delta_t)
+{
+  if (second_state.positions.empty())
+  {
+    second_state.positions.resize(dim);
+    if (first_state.velocities.empty())
+    {
+      first_state.velocities.resize(dim, 0.0);
+    }
+    if (second_state.velocities.empty())
+    {
+      second_state.velocities.resize(dim);
+      if (first_state.accelerations.empty())
+      {
+        first_state.accelerations.resize(dim, 0.0);
+      }
+      for (size_t i = 0; i < dim; ++i)
+      {
+        second_state.velocities[i] =
+          first_state.velocities[i] +
+          (first_state.accelerations[i] + second_state.accelerations[i]) * 0.5 * delta_t;
+      }
+    }
+    for (size_t i = 0; i < dim; ++i)
+    {
+      // second state velocity should be reached on the end of the segment, so use middle
+      second_state.positions[i] =
+        first_state.positions[i] +
+        (first_state.velocities[i] + second_state.velocities[i]) * 0.5 * delta_t;
+    }
+  }
+}
+}  // namespace
+
+bool complete_trajectory_points(trajectory_msgs::msg::JointTrajectory & trajectory)
+{
+  auto & points = trajectory.points;
+  if (points.empty() || points[0].positions.empty())
+  {
+    return false;
+  }
+  const size_t dim = points[0].positions.size();
+  for (size_t i = 0; i + 1 < points.size(); ++i)
+  {
+    const rclcpp::Duration delta_t =
+      rclcpp::Duration(points[i + 1].time_from_start) - rclcpp::Duration(points[i].time_from_start);
+    deduce_from_derivatives(points[i], points[i + 1], dim, delta_t.seconds());
+  }
+  return true;
+}
+
+bool compute_cubic_spline_derivatives(trajectory_msgs::msg::JointTrajectory & trajectory)
+{
+  auto & points = trajectory.points;
+  if (points.size() < 2)
+  {
+    return false;
+  }
+  const size_t dim = points[0].positions.size();
+  for (const auto & point : points)
+  {
+    if (point.positions.size() != dim || !point.velocities.empty() || !point.accelerations.empty())
+    {
+      return false;
+    }
+  }
+
+  const size_t n = points.size();
+  std::vector<double> h(n - 1);
+  for (size_t k = 0; k + 1 < n; ++k)
+  {
+    h[k] = (rclcpp::Duration(points[k + 1].time_from_start) -
+            rclcpp::Duration(points[k].time_from_start))
+             .seconds();
+    if (h[k] <= 0.0)
+    {
+      return false;
+    }
+  }
+
+  // modified upper diagonal and right-hand side of the forward sweep, shared by all joints
+  std::vector<double> c(n);
+  std::vector<double> d(n);
+  for (auto & point : points)
+  {
+    point.velocities.resize(dim);
+    point.accelerations.resize(dim);
+  }
+  for (size_t i = 0; i < dim; ++i)
+  {
+    auto slope = [&](size_t k)
+    { return (points[k + 1].positions[i] - points[k].positions[i]) / h[k]; };
+
+    // the rows of the accelerations M: h[k-1] M[k-1] + 2 (h[k-1] + h[k]) M[k] + h[k] M[k+1] =
+    // 6 (slope[k] - slope[k-1]), with M[0] = 0 and zero velocity at the last point
+    c[0] = 0.0;
+    d[0] = 0.0;
+    for (size_t k = 1; k < n; ++k)
+    {
+      const double lower = h[k - 1];
+      const double diagonal = k + 1 < n ? 2.0 * (h[k - 1] + h[k]) : 2.0 * h[k - 1];
+      const double upper = k + 1 < n ? h[k] : 0.0;
+      const double rhs = k + 1 < n ? 6.0 * (slope(k) - slope(k - 1)) : -6.0 * slope(k - 1);
+      const double denominator = diagonal - lower * c[k - 1];
+      c[k] = upper / denominator;
+      d[k] = (rhs - lower * d[k - 1]) / denominator;
+    }
+    // back substitution
+    points[n - 1].accelerations[i] = d[n - 1];
+    for (size_t k = n - 1; k-- > 0;)
+    {
+      points[k].accelerations[i] = d[k] - c[k] * points[k + 1].accelerations[i];
+    }
+
+    for (size_t k = 0; k + 1 < n; ++k)
+    {
+      points[k].velocities[i] =
+        slope(k) -
+        h[k] * (2.0 * points[k].accelerations[i] + points[k + 1].accelerations[i]) / 6.0;
+    }
+    points[n - 1].velocities[i] = 0.0;
+  }
+  return true;
+}
+
 Trajectory::Trajectory() : trajectory_start_time_(0), time_before_traj_msg_(0) {}
 
 Trajectory::Trajectory(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory)
@@ -48,6 +192,8 @@ void Trajectory::set_point_before_trajectory_msg(
 {
   time_before_traj_msg_ = current_time;
   state_before_traj_msg_ = current_point;
+  segment_cursor_ = 0;
+  cached_segment_end_idx_ = NO_CACHED_SEGMENT;
 }
 
 void Trajectory::update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory)
@@ -55,6 +201,37 @@ void Trajectory::update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> j
   trajectory_msg_ = joint_trajectory;
   trajectory_start_time_ = static_cast<rclcpp::Time>(joint_trajectory->header.stamp);
   sampled_already_ = false;
+  point_times_ns_.clear();
+  segment_cursor_ = 0;
+  cached_segment_end_idx_ = NO_CACHED_SEGMENT;
+  compact_storage_.reset();
+}
+
+void Trajectory::set_compact_storage(std::shared_ptr<const CompactTrajectoryStorage> storage)
+{
+  if (
+    storage && (!trajectory_msg_ || storage->size() != trajectory_msg_->points.size() ||
+                storage->dim() != trajectory_msg_->points[0].positions.size()))
+  {
+    storage.reset();
+  }
+  compact_storage_ = std::move(storage);
+  // the coefficients might have been computed from the points of the msg
+  cached_segment_end_idx_ = NO_CACHED_SEGMENT;
+}
+
+void Trajectory::reserve(const size_t dim)
+{
+  segment_coefficients_.reserve(NUM_SPLINE_COEFFICIENTS * dim);
+  for (auto * point :
+       {&state_before_traj_msg_, &quintic_state_a_, &quintic_state_b_, &compact_state_a_,
+        &compact_state_b_})
+  {
+    point->positions.reserve(dim);
+    point->velocities.reserve(dim);
+    point->accelerations.reserve(dim);
+    point->effort.reserve(dim);
+  }
 }
 
 bool Trajectory::sample(
@@ -75,43 +252,91 @@ bool Trajectory::sample(
   // first sampling of this trajectory
   if (!sampled_already_)
   {
-    if (trajectory_start_time_.seconds() == 0.0)
+    if (trajectory_start_time_.nanoseconds() == 0)
     {
       trajectory_start_time_ = sample_time;
     }
 
+    // the start time is known from now on, so the absolute time of every point can be cached
+    const int64_t trajectory_start_time_ns = trajectory_start_time_.nanoseconds();
+    point_times_ns_.resize(trajectory_msg_->points.size());
+    for (size_t i = 0; i < point_times_ns_.size(); ++i)
+    {
+      point_times_ns_[i] =
+        trajectory_start_time_ns +
+        (compact_storage_
+           ? compact_storage_->time_from_start_ns(i)
+           : rclcpp::Duration(trajectory_msg_->points[i].time_from_start).nanoseconds());
+    }
+    segment_cursor_ = 0;
+
+    // the msg is completed when it is received, see complete_trajectory_points(), except if the
+    // first point depends on the state before the msg. It isn't changed anymore once sampled.
+    if (
+      interpolation_method != interpolation_methods::InterpolationMethod::NONE &&
+      trajectory_msg_->points[0].positions.empty())
+    {
+      deduce_from_derivatives(
+        state_before_traj_msg_, trajectory_msg_->points[0], state_before_traj_msg_.positions.size(),
+        nanoseconds_to_seconds(point_times_ns_[0] - time_before_traj_msg_.nanoseconds()));
+      complete_trajectory_points(*trajectory_msg_);
+    }
+
     sampled_already_ = true;
   }
 
+  // all comparisons are done on the integer timeline of the trajectory
+  const int64_t sample_time_ns = sample_time.nanoseconds();
+  const int64_t time_before_traj_msg_ns = time_before_traj_msg_.nanoseconds();
+
   // sampling before the current point
-  if (sample_time < time_before_traj_msg_)
+  if (sample_time_ns < time_before_traj_msg_ns)
   {
     return false;
   }
 
-  output_state = trajectory_msgs::msg::JointTrajectoryPoint();
-  auto & first_point_in_msg = trajectory_msg_->points[0];
-  const rclcpp::Time first_point_timestamp =
-    trajectory_start_time_ + first_point_in_msg.time_from_start;
+  // the segments are loaded from the compact storage only when the coefficients change
+  const bool use_compact_storage =
+    compact_storage_ &&
+    interpolation_method != interpolation_methods::InterpolationMethod::QUINTIC_SPLINE;
+  auto is_new_segment = [this, interpolation_method](size_t segment_end_idx)
+  {
+    return cached_segment_end_idx_ != segment_end_idx ||
+           cached_interpolation_method_ != interpolation_method;
+  };
+
+  // reset the output but keep the memory of its fields, so sampling doesn't allocate every cycle
+  output_state.positions.clear();
+  output_state.velocities.clear();
+  output_state.accelerations.clear();
+  output_state.effort.clear();
+  output_state.time_from_start = builtin_interfaces::msg::Duration();
+  const auto & first_point_in_msg = trajectory_msg_->points[0];
+  const int64_t first_point_time_ns = point_times_ns_[0];
 
   // current time hasn't reached traj time of the first point in the msg yet
-  if (sample_time < first_point_timestamp)
+  if (sample_time_ns < first_point_time_ns)
   {
     // If interpolation is disabled, just forward the next waypoint
     if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
     {
       output_state = state_before_traj_msg_;
     }
+    else if (use_compact_storage)
+    {
+      if (is_new_segment(0))
+      {
+        compact_storage_->load_point(0, compact_state_b_);
+      }
+      interpolate_segment(
+        0, interpolation_method, time_before_traj_msg_ns, state_before_traj_msg_,
+        first_point_time_ns, compact_state_b_, sample_time_ns, output_state);
+    }
     else
     {
-      // it changes points only if position and velocity do not exist, but their derivatives
-      deduce_from_derivatives(
-        state_before_traj_msg_, first_point_in_msg, state_before_traj_msg_.positions.size(),
-        (first_point_timestamp - time_before_traj_msg_).seconds());
-
-      interpolate_between_points(
-        time_before_traj_msg_, state_before_traj_msg_, first_point_timestamp, first_point_in_msg,
-        sample_time, output_state);
+      interpolate_segment(
+        0, interpolation_method, time_before_traj_msg_ns, state_before_traj_msg_,
+        first_point_time_ns, first_point_in_msg, sample_time_ns, output_state);
     }
     start_segment_itr = begin();  // no segments before the first
     end_segment_itr = begin();
@@ -120,34 +345,40 @@ bool Trajectory::sample(
 
   // time_from_start + trajectory time is the expected arrival time of trajectory
   const auto last_idx = trajectory_msg_->points.size() - 1;
-  for (size_t i = 0; i < last_idx; ++i)
+  const size_t i = find_segment_index(sample_time_ns);
+  if (i < last_idx)
   {
-    auto & point = trajectory_msg_->points[i];
-    auto & next_point = trajectory_msg_->points[i + 1];
+    const auto & point = trajectory_msg_->points[i];
+    const auto & next_point = trajectory_msg_->points[i + 1];
 
-    const rclcpp::Time t0 = trajectory_start_time_ + point.time_from_start;
-    const rclcpp::Time t1 = trajectory_start_time_ + next_point.time_from_start;
+    const int64_t t0 = point_times_ns_[i];
+    const int64_t t1 = point_times_ns_[i + 1];
 
-    if (sample_time >= t0 && sample_time < t1)
+    // If interpolation is disabled, just forward the next waypoint
+    if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
     {
-      // If interpolation is disabled, just forward the next waypoint
-      if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
-      {
-        output_state = next_point;
-      }
-      // Do interpolation
-      else
+      output_state = next_point;
+    }
+    else if (use_compact_storage)
+    {
+      if (is_new_segment(i + 1))
       {
-        // it changes points only if position and velocity do not exist, but their derivatives
-        deduce_from_derivatives(
-          point, next_point, state_before_traj_msg_.positions.size(), (t1 - t0).seconds());
-
-        interpolate_between_points(t0, point, t1, next_point, sample_time, output_state);
+        compact_storage_->load_point(i, compact_state_a_);
+        compact_storage_->load_point(i + 1, compact_state_b_);
       }
-      start_segment_itr = begin() + i;
-      end_segment_itr = begin() + (i + 1);
-      return true;
+      interpolate_segment(
+        i + 1, interpolation_method, t0, compact_state_a_, t1, compact_state_b_, sample_time_ns,
+        output_state);
     }
+    // Do interpolation
+    else
+    {
+      interpolate_segment(
+        i + 1, interpolation_method, t0, point, t1, next_point, sample_time_ns, output_state);
+    }
+    start_segment_itr = begin() + i;
+    end_segment_itr = begin() + (i + 1);
+    return true;
   }
 
   // whole animation has played out
@@ -166,28 +397,228 @@ bool Trajectory::sample(
   return true;
 }
 
-void Trajectory::interpolate_between_points(
-  const rclcpp::Time & time_a, const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
-  const rclcpp::Time & time_b, const trajectory_msgs::msg::JointTrajectoryPoint & state_b,
-  const rclcpp::Time & sample_time, trajectory_msgs::msg::JointTrajectoryPoint & output)
+bool Trajectory::sample_at(
+  const rclcpp::Time & sample_time,
+  const interpolation_methods::InterpolationMethod interpolation_method,
+  trajectory_msgs::msg::JointTrajectoryPoint & output_state,
+  TrajectoryPointConstIter & start_segment_itr, TrajectoryPointConstIter & end_segment_itr) const
 {
-  rclcpp::Duration duration_so_far = sample_time - time_a;
-  rclcpp::Duration duration_btwn_points = time_b - time_a;
+  THROW_ON_NULLPTR(trajectory_msg_)
 
-  const size_t dim = state_a.positions.size();
-  output.positions.resize(dim, 0.0);
-  output.velocities.resize(dim, 0.0);
-  output.accelerations.resize(dim, 0.0);
+  const auto & points = trajectory_msg_->points;
+  if (points.empty())
+  {
+    start_segment_itr = end();
+    end_segment_itr = end();
+    return false;
+  }
 
-  auto generate_powers = [](int n, double x, double * powers)
+  // same timeline as sample(), but not cached
+  const int64_t sample_time_ns = sample_time.nanoseconds();
+  const int64_t time_before_traj_msg_ns = time_before_traj_msg_.nanoseconds();
+  const int64_t trajectory_start_time_ns = trajectory_start_time_.nanoseconds() == 0
+                                             ? sample_time_ns
+                                             : trajectory_start_time_.nanoseconds();
+  std::vector<int64_t> point_times_ns(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
   {
-    powers[0] = 1.0;
-    for (int i = 1; i <= n; ++i)
+    point_times_ns[i] =
+      trajectory_start_time_ns + rclcpp::Duration(points[i].time_from_start).nanoseconds();
+  }
+
+  if (sample_time_ns < time_before_traj_msg_ns)
+  {
+    return false;
+  }
+
+  output_state = trajectory_msgs::msg::JointTrajectoryPoint();
+  const size_t last_idx = points.size() - 1;
+  // whole animation has played out
+  if (sample_time_ns >= point_times_ns[last_idx])
+  {
+    start_segment_itr = --end();
+    end_segment_itr = end();
+    output_state = points[last_idx];
+    // the trajectories in msg may have empty velocities/accel, so resize them
+    if (output_state.velocities.empty())
     {
-      powers[i] = powers[i - 1] * x;
+      output_state.velocities.resize(output_state.positions.size(), 0.0);
     }
+    if (output_state.accelerations.empty())
+    {
+      output_state.accelerations.resize(output_state.positions.size(), 0.0);
+    }
+    return true;
+  }
+
+  // the segment from state_a to state_b, state_a is the waypoint segment_end_idx of
+  // complete_knot_state()
+  size_t segment_end_idx = 0;
+  const trajectory_msgs::msg::JointTrajectoryPoint * state_a = &state_before_traj_msg_;
+  const trajectory_msgs::msg::JointTrajectoryPoint * state_b = &points[0];
+  int64_t time_a_ns = time_before_traj_msg_ns;
+  int64_t time_b_ns = point_times_ns[0];
+  if (sample_time_ns < point_times_ns[0])
+  {
+    start_segment_itr = begin();  // no segments before the first
+    end_segment_itr = begin();
+  }
+  else
+  {
+    const auto it = std::upper_bound(point_times_ns.begin(), point_times_ns.end(), sample_time_ns);
+    const size_t i = static_cast<size_t>(std::distance(point_times_ns.begin(), it)) - 1;
+    segment_end_idx = i + 1;
+    state_a = &points[i];
+    state_b = &points[i + 1];
+    time_a_ns = point_times_ns[i];
+    time_b_ns = point_times_ns[i + 1];
+    start_segment_itr = begin() + static_cast<std::ptrdiff_t>(i);
+    end_segment_itr = begin() + static_cast<std::ptrdiff_t>(i + 1);
+  }
+
+  // If interpolation is disabled, just forward the next waypoint
+  if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
+  {
+    output_state = segment_end_idx == 0 ? state_before_traj_msg_ : *state_b;
+    return true;
+  }
+
+  const size_t dim = state_b->positions.size();
+  if (state_a->positions.size() != dim)
+  {
+    return false;
+  }
+  std::vector<double> coefficients;
+  const double duration_btwn_points = nanoseconds_to_seconds(time_b_ns - time_a_ns);
+  if (interpolation_method == interpolation_methods::InterpolationMethod::QUINTIC_SPLINE)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint knot_a, knot_b;
+    complete_knot_state(segment_end_idx, dim, point_times_ns, knot_a);
+    complete_knot_state(segment_end_idx + 1, dim, point_times_ns, knot_b);
+    compute_coefficients(knot_a, knot_b, duration_btwn_points, true, true, coefficients);
+  }
+  else
+  {
+    const bool has_velocity = !state_a->velocities.empty() && !state_b->velocities.empty();
+    const bool has_accel = !state_a->accelerations.empty() && !state_b->accelerations.empty();
+    compute_coefficients(
+      *state_a, *state_b, duration_btwn_points, has_velocity, has_accel, coefficients);
+  }
+  evaluate_coefficients(
+    coefficients, dim, nanoseconds_to_seconds(sample_time_ns - time_a_ns), output_state);
+  return true;
+}
+
+size_t Trajectory::sample_range(
+  const rclcpp::Time & start_time, const rclcpp::Duration & period, const size_t num_samples,
+  const interpolation_methods::InterpolationMethod interpolation_method,
+  TrajectorySamples & samples)
+{
+  samples.num_samples = 0;
+  samples.dim = 0;
+  samples.positions.clear();
+  samples.velocities.clear();
+  samples.accelerations.clear();
+
+  const int64_t start_time_ns = start_time.nanoseconds();
+  const int64_t period_ns = period.nanoseconds();
+  auto & output_state = samples.sample_state;
+  TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+  for (size_t k = 0; k < num_samples; ++k)
+  {
+    const rclcpp::Time sample_time(
+      start_time_ns + static_cast<int64_t>(k) * period_ns, start_time.get_clock_type());
+    if (!sample(
+          sample_time, interpolation_method, output_state, start_segment_itr, end_segment_itr))
+    {
+      break;
+    }
+
+    // the dimension is only known after the first valid sample
+    if (k == 0)
+    {
+      samples.dim = output_state.positions.size();
+      samples.positions.resize(num_samples * samples.dim);
+      samples.velocities.resize(num_samples * samples.dim);
+      samples.accelerations.resize(num_samples * samples.dim);
+    }
+    const auto copy_field =
+      [&samples, k](const std::vector<double> & from, std::vector<double> & to)
+    {
+      const auto to_begin = to.begin() + static_cast<std::ptrdiff_t>(k * samples.dim);
+      if (from.size() == samples.dim)
+      {
+        std::copy(from.begin(), from.end(), to_begin);
+      }
+      else
+      {
+        std::fill_n(to_begin, samples.dim, 0.0);
+      }
+    };
+    copy_field(output_state.positions, samples.positions);
+    copy_field(output_state.velocities, samples.velocities);
+    copy_field(output_state.accelerations, samples.accelerations);
+    ++samples.num_samples;
+  }
+
+  // drop what is left over after a failed sample
+  samples.positions.resize(samples.num_samples * samples.dim);
+  samples.velocities.resize(samples.num_samples * samples.dim);
+  samples.accelerations.resize(samples.num_samples * samples.dim);
+  return samples.num_samples;
+}
+
+size_t Trajectory::find_segment_index(const int64_t sample_time_ns)
+{
+  const size_t last_idx = point_times_ns_.size() - 1;
+  if (sample_time_ns >= point_times_ns_[last_idx])
+  {
+    return last_idx;
+  }
+
+  auto binary_search_from = [&](size_t lower_idx)
+  {
+    // first point after sample_time, the segment starts one point before it
+    const auto it = std::upper_bound(
+      point_times_ns_.begin() + static_cast<std::ptrdiff_t>(lower_idx), point_times_ns_.end(),
+      sample_time_ns);
+    return static_cast<size_t>(std::distance(point_times_ns_.begin(), it)) - 1;
   };
 
+  size_t idx = segment_cursor_;
+  if (idx >= last_idx || sample_time_ns < point_times_ns_[idx])
+  {
+    // time jumped backwards, search from the beginning
+    idx = binary_search_from(0);
+  }
+  else
+  {
+    // usually the sample is in the same or the next segment, so step forward from the cursor
+    size_t steps = 0;
+    while (sample_time_ns >= point_times_ns_[idx + 1])
+    {
+      ++idx;
+      if (++steps >= MAX_CURSOR_STEPS)
+      {
+        // large jump forward
+        idx = binary_search_from(idx);
+        break;
+      }
+    }
+  }
+
+  segment_cursor_ = idx;
+  return idx;
+}
+
+void Trajectory::interpolate_between_points(
+  const rclcpp::Time & time_a, const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
+  const rclcpp::Time & time_b, const trajectory_msgs::msg::JointTrajectoryPoint & state_b,
+  const rclcpp::Time & sample_time, trajectory_msgs::msg::JointTrajectoryPoint & output)
+{
+  rclcpp::Duration duration_so_far = sample_time - time_a;
+  rclcpp::Duration duration_btwn_points = time_b - time_a;
+
   bool has_velocity = !state_a.velocities.empty() && !state_b.velocities.empty();
   bool has_accel = !state_a.accelerations.empty() && !state_b.accelerations.empty();
   if (duration_so_far.seconds() < 0.0)
@@ -201,10 +632,141 @@ void Trajectory::interpolate_between_points(
     has_velocity = has_accel = false;
   }
 
-  double t[6];
-  generate_powers(5, duration_so_far.seconds(), t);
+  compute_coefficients(
+    state_a, state_b, duration_btwn_points.seconds(), has_velocity, has_accel,
+    segment_coefficients_);
+  // the coefficients don't belong to a segment of the trajectory anymore
+  cached_segment_end_idx_ = NO_CACHED_SEGMENT;
+  evaluate_coefficients(
+    segment_coefficients_, state_a.positions.size(), duration_so_far.seconds(), output);
+}
+
+void Trajectory::interpolate_segment(
+  const size_t segment_end_idx,
+  const interpolation_methods::InterpolationMethod interpolation_method, const int64_t time_a_ns,
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_a, const int64_t time_b_ns,
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_b, const int64_t sample_time_ns,
+  trajectory_msgs::msg::JointTrajectoryPoint & output)
+{
+  if (
+    cached_segment_end_idx_ != segment_end_idx ||
+    cached_interpolation_method_ != interpolation_method)
+  {
+    const double duration_btwn_points = nanoseconds_to_seconds(time_b_ns - time_a_ns);
+    if (interpolation_method == interpolation_methods::InterpolationMethod::QUINTIC_SPLINE)
+    {
+      // segment_end_idx is the waypoint index of state_a, see complete_knot_state()
+      const size_t dim = state_a.positions.size();
+      complete_knot_state(segment_end_idx, dim, point_times_ns_, quintic_state_a_);
+      complete_knot_state(segment_end_idx + 1, dim, point_times_ns_, quintic_state_b_);
+      compute_coefficients(
+        quintic_state_a_, quintic_state_b_, duration_btwn_points, true, true,
+        segment_coefficients_);
+    }
+    else
+    {
+      const bool has_velocity = !state_a.velocities.empty() && !state_b.velocities.empty();
+      const bool has_accel = !state_a.accelerations.empty() && !state_b.accelerations.empty();
+      compute_coefficients(
+        state_a, state_b, duration_btwn_points, has_velocity, has_accel, segment_coefficients_);
+    }
+    cached_segment_end_idx_ = segment_end_idx;
+    cached_interpolation_method_ = interpolation_method;
+  }
+  evaluate_coefficients(
+    segment_coefficients_, state_a.positions.size(),
+    nanoseconds_to_seconds(sample_time_ns - time_a_ns), output);
+}
+
+void Trajectory::complete_knot_state(
+  const size_t knot_idx, const size_t dim, const std::vector<int64_t> & point_times_ns,
+  trajectory_msgs::msg::JointTrajectoryPoint & output) const
+{
+  auto knot_point = [this](size_t idx) -> const trajectory_msgs::msg::JointTrajectoryPoint &
+  { return idx == 0 ? state_before_traj_msg_ : trajectory_msg_->points[idx - 1]; };
+  auto knot_time_ns = [this, &point_times_ns](size_t idx)
+  { return idx == 0 ? time_before_traj_msg_.nanoseconds() : point_times_ns[idx - 1]; };
+
+  const auto & point = knot_point(knot_idx);
+  // assign() keeps the memory of the output fields
+  output.positions.assign(point.positions.begin(), point.positions.end());
+  if (point.velocities.size() == dim)
+  {
+    output.velocities.assign(point.velocities.begin(), point.velocities.end());
+  }
+  else
+  {
+    output.velocities.assign(dim, 0.0);
+    const size_t num_knots = trajectory_msg_->points.size() + 1;
+    // neighbors without positions, e.g. not yet deduced from derivatives, are treated as missing
+    if (
+      knot_idx > 0 && knot_idx + 1 < num_knots &&
+      knot_point(knot_idx - 1).positions.size() == dim &&
+      knot_point(knot_idx + 1).positions.size() == dim)
+    {
+      const auto & prev = knot_point(knot_idx - 1);
+      const auto & next = knot_point(knot_idx + 1);
+      const double dt_prev =
+        nanoseconds_to_seconds(knot_time_ns(knot_idx) - knot_time_ns(knot_idx - 1));
+      const double dt_next =
+        nanoseconds_to_seconds(knot_time_ns(knot_idx + 1) - knot_time_ns(knot_idx));
+      if (dt_prev > 0.0 && dt_next > 0.0)
+      {
+        for (size_t i = 0; i < dim; ++i)
+        {
+          const double slope_prev = (point.positions[i] - prev.positions[i]) / dt_prev;
+          const double slope_next = (next.positions[i] - point.positions[i]) / dt_next;
+          // stop at local extrema, so the spline doesn't overshoot the waypoints
+          if (slope_prev * slope_next > 0.0)
+          {
+            output.velocities[i] = 0.5 * (slope_prev + slope_next);
+          }
+        }
+      }
+    }
+  }
+  if (point.accelerations.size() == dim)
+  {
+    output.accelerations.assign(point.accelerations.begin(), point.accelerations.end());
+  }
+  else
+  {
+    output.accelerations.assign(dim, 0.0);
+  }
+}
+
+void Trajectory::compute_coefficients(
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
+  const trajectory_msgs::msg::JointTrajectoryPoint & state_b, const double duration_btwn_points,
+  const bool has_velocity, const bool has_accel, std::vector<double> & coefficients)
+{
+  const size_t dim = state_a.positions.size();
+  // Only resize if necessary since it's an expensive operation
+  if (coefficients.size() != NUM_SPLINE_COEFFICIENTS * dim)
+  {
+    coefficients.resize(NUM_SPLINE_COEFFICIENTS * dim);
+  }
+  std::fill(coefficients.begin(), coefficients.end(), 0.0);
+  double * c0 = coefficients.data();
+  double * c1 = c0 + dim;
+  double * c2 = c1 + dim;
+  double * c3 = c2 + dim;
+  double * c4 = c3 + dim;
+  double * c5 = c4 + dim;
+
+  auto generate_powers = [](int n, double x, double * powers)
+  {
+    powers[0] = 1.0;
+    for (int i = 1; i <= n; ++i)
+    {
+      powers[i] = powers[i - 1] * x;
+    }
+  };
+
+  double T[6];
+  generate_powers(5, duration_btwn_points, T);
 
-  if (!has_velocity && !has_accel)
+  if (!has_velocity)
   {
     // do linear interpolation
     for (size_t i = 0; i < dim; ++i)
@@ -212,23 +774,16 @@ void Trajectory::interpolate_between_points(
       double start_pos = state_a.positions[i];
       double end_pos = state_b.positions[i];
 
-      double coefficients[2] = {0.0, 0.0};
-      coefficients[0] = start_pos;
-      if (duration_btwn_points.seconds() != 0.0)
+      c0[i] = start_pos;
+      if (duration_btwn_points != 0.0)
       {
-        coefficients[1] = (end_pos - start_pos) / duration_btwn_points.seconds();
+        c1[i] = (end_pos - start_pos) / duration_btwn_points;
       }
-
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1];
-      output.velocities[i] = t[0] * coefficients[1];
     }
   }
-  else if (has_velocity && !has_accel)
+  else if (!has_accel)
   {
     // do cubic interpolation
-    double T[4];
-    generate_powers(3, duration_btwn_points.seconds(), T);
-
     for (size_t i = 0; i < dim; ++i)
     {
       double start_pos = state_a.positions[i];
@@ -236,30 +791,18 @@ void Trajectory::interpolate_between_points(
       double end_pos = state_b.positions[i];
       double end_vel = state_b.velocities[i];
 
-      double coefficients[4] = {0.0, 0.0, 0.0, 0.0};
-      coefficients[0] = start_pos;
-      coefficients[1] = start_vel;
-      if (duration_btwn_points.seconds() != 0.0)
+      c0[i] = start_pos;
+      c1[i] = start_vel;
+      if (duration_btwn_points != 0.0)
       {
-        coefficients[2] =
-          (-3.0 * start_pos + 3.0 * end_pos - 2.0 * start_vel * T[1] - end_vel * T[1]) / T[2];
-        coefficients[3] =
-          (2.0 * start_pos - 2.0 * end_pos + start_vel * T[1] + end_vel * T[1]) / T[3];
+        c2[i] = (-3.0 * start_pos + 3.0 * end_pos - 2.0 * start_vel * T[1] - end_vel * T[1]) / T[2];
+        c3[i] = (2.0 * start_pos - 2.0 * end_pos + start_vel * T[1] + end_vel * T[1]) / T[3];
       }
-
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1] +
-                            t[2] * coefficients[2] + t[3] * coefficients[3];
-      output.velocities[i] =
-        t[0] * coefficients[1] + t[1] * 2.0 * coefficients[2] + t[2] * 3.0 * coefficients[3];
-      output.accelerations[i] = t[0] * 2.0 * coefficients[2] + t[1] * 6.0 * coefficients[3];
     }
   }
-  else if (has_velocity && has_accel)
+  else
   {
     // do quintic interpolation
-    double T[6];
-    generate_powers(5, duration_btwn_points.seconds(), T);
-
     for (size_t i = 0; i < dim; ++i)
     {
       double start_pos = state_a.positions[i];
@@ -269,67 +812,48 @@ void Trajectory::interpolate_between_points(
       double end_vel = state_b.velocities[i];
       double end_acc = state_b.accelerations[i];
 
-      double coefficients[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-      coefficients[0] = start_pos;
-      coefficients[1] = start_vel;
-      coefficients[2] = 0.5 * start_acc;
-      if (duration_btwn_points.seconds() != 0.0)
+      c0[i] = start_pos;
+      c1[i] = start_vel;
+      c2[i] = 0.5 * start_acc;
+      if (duration_btwn_points != 0.0)
       {
-        coefficients[3] = (-20.0 * start_pos + 20.0 * end_pos - 3.0 * start_acc * T[2] +
-                           end_acc * T[2] - 12.0 * start_vel * T[1] - 8.0 * end_vel * T[1]) /
-                          (2.0 * T[3]);
-        coefficients[4] = (30.0 * start_pos - 30.0 * end_pos + 3.0 * start_acc * T[2] -
-                           2.0 * end_acc * T[2] + 16.0 * start_vel * T[1] + 14.0 * end_vel * T[1]) /
-                          (2.0 * T[4]);
-        coefficients[5] = (-12.0 * start_pos + 12.0 * end_pos - start_acc * T[2] + end_acc * T[2] -
-                           6.0 * start_vel * T[1] - 6.0 * end_vel * T[1]) /
-                          (2.0 * T[5]);
+        c3[i] = (-20.0 * start_pos + 20.0 * end_pos - 3.0 * start_acc * T[2] + end_acc * T[2] -
+                 12.0 * start_vel * T[1] - 8.0 * end_vel * T[1]) /
+                (2.0 * T[3]);
+        c4[i] = (30.0 * start_pos - 30.0 * end_pos + 3.0 * start_acc * T[2] -
+                 2.0 * end_acc * T[2] + 16.0 * start_vel * T[1] + 14.0 * end_vel * T[1]) /
+                (2.0 * T[4]);
+        c5[i] = (-12.0 * start_pos + 12.0 * end_pos - start_acc * T[2] + end_acc * T[2] -
+                 6.0 * start_vel * T[1] - 6.0 * end_vel * T[1]) /
+                (2.0 * T[5]);
       }
-
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1] +
-                            t[2] * coefficients[2] + t[3] * coefficients[3] +
-                            t[4] * coefficients[4] + t[5] * coefficients[5];
-      output.velocities[i] = t[0] * coefficients[1] + t[1] * 2.0 * coefficients[2] +
-                             t[2] * 3.0 * coefficients[3] + t[3] * 4.0 * coefficients[4] +
-                             t[4] * 5.0 * coefficients[5];
-      output.accelerations[i] = t[0] * 2.0 * coefficients[2] + t[1] * 6.0 * coefficients[3] +
-                                t[2] * 12.0 * coefficients[4] + t[3] * 20.0 * coefficients[5];
     }
   }
 }
 
-void Trajectory::deduce_from_derivatives(
-  trajectory_msgs::msg::JointTrajectoryPoint & first_state,
-  trajectory_msgs::msg::JointTrajectoryPoint & second_state, const size_t dim, const double delta_t)
+void Trajectory::evaluate_coefficients(
+  const std::vector<double> & coefficients, const size_t dim, const double t,
+  trajectory_msgs::msg::JointTrajectoryPoint & output)
 {
-  if (second_state.positions.empty())
+  output.positions.resize(dim, 0.0);
+  output.velocities.resize(dim, 0.0);
+  output.accelerations.resize(dim, 0.0);
+
+  const double * c0 = coefficients.data();
+  const double * c1 = c0 + dim;
+  const double * c2 = c1 + dim;
+  const double * c3 = c2 + dim;
+  const double * c4 = c3 + dim;
+  const double * c5 = c4 + dim;
+
+  // lower degree splines have zero high-order coefficients, so every segment costs the same
+  for (size_t i = 0; i < dim; ++i)
   {
-    second_state.positions.resize(dim);
-    if (first_state.velocities.empty())
-    {
-      first_state.velocities.resize(dim, 0.0);
-    }
-    if (second_state.velocities.empty())
-    {
-      second_state.velocities.resize(dim);
-      if (first_state.accelerations.empty())
-      {
-        first_state.accelerations.resize(dim, 0.0);
-      }
-      for (size_t i = 0; i < dim; ++i)
-      {
-        second_state.velocities[i] =
-          first_state.velocities[i] +
-          (first_state.accelerations[i] + second_state.accelerations[i]) * 0.5 * delta_t;
-      }
-    }
-    for (size_t i = 0; i < dim; ++i)
-    {
-      // second state velocity should be reached on the end of the segment, so use middle
-      second_state.positions[i] =
-        first_state.positions[i] +
-        (first_state.velocities[i] + second_state.velocities[i]) * 0.5 * delta_t;
-    }
+    output.positions[i] = c0[i] + t * (c1[i] + t * (c2[i] + t * (c3[i] + t * (c4[i] + t * c5[i]))));
+    output.velocities[i] =
+      c1[i] + t * (2.0 * c2[i] + t * (3.0 * c3[i] + t * (4.0 * c4[i] + t * 5.0 * c5[i])));
+    output.accelerations[i] =
+      2.0 * c2[i] + t * (6.0 * c3[i] + t * (12.0 * c4[i] + t * 20.0 * c5[i]));
   }
 }
 
@@ -0,0 +1,412 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/trajectory_cdr_decoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+constexpr size_t NO_INDEX = std::numeric_limits<size_t>::max();
+
+bool is_little_endian_host()
+{
+  const uint16_t one = 1;
+  uint8_t first_byte;
+  std::memcpy(&first_byte, &one, 1);
+  return first_byte == 1;
+}
+
+// reverses the byte order of \p bits
+template <typename T>
+T swap_bytes(T bits)
+{
+  T swapped = 0;
+  for (size_t i = 0; i < sizeof(T); ++i)
+  {
+    swapped = static_cast<T>((swapped << 8) | (bits & 0xff));
+    bits = static_cast<T>(bits >> 8);
+  }
+  return swapped;
+}
+
+// reads the payload after the encapsulation header, whose first byte is the origin of alignment
+class CdrReader
+{
+public:
+  CdrReader(const uint8_t * data, size_t size, bool swap, size_t max_alignment)
+  : data_(data), size_(size), swap_(swap), max_alignment_(max_alignment)
+  {
+  }
+
+  bool read(uint32_t & value) { return read_primitive(value); }
+
+  bool read(int32_t & value) { return read_primitive(value); }
+
+  /// view of a string, without its terminating null character
+  bool read_string(const char *& chars, size_t & length)
+  {
+    uint32_t size;
+    if (!read(size) || size > size_ - offset_)
+    {
+      return false;
+    }
+    chars = reinterpret_cast<const char *>(data_ + offset_);
+    length = size > 0 ? size - 1 : 0;
+    offset_ += size;
+    return true;
+  }
+
+  /// sequence of doubles, stored at the local joint indices of \p mapping in \p values
+  bool read_doubles(size_t count, const std::vector<size_t> & mapping, std::vector<double> & values)
+  {
+    if (count == 0)
+    {
+      return true;
+    }
+    if (!align(sizeof(double)) || count > (size_ - offset_) / sizeof(double))
+    {
+      return false;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+      uint64_t bits;
+      std::memcpy(&bits, data_ + offset_, sizeof(bits));
+      offset_ += sizeof(bits);
+      if (swap_)
+      {
+        bits = swap_bytes(bits);
+      }
+      std::memcpy(&values[mapping[i]], &bits, sizeof(bits));
+    }
+    return true;
+  }
+
+  size_t remaining() const { return size_ - offset_; }
+
+private:
+  bool align(size_t alignment)
+  {
+    alignment = std::min(alignment, max_alignment_);
+    const size_t padding = (alignment - offset_ % alignment) % alignment;
+    if (padding > size_ - offset_)
+    {
+      return false;
+    }
+    offset_ += padding;
+    return true;
+  }
+
+  template <typename T>
+  bool read_primitive(T & value)
+  {
+    static_assert(sizeof(T) == sizeof(uint32_t), "only 4 byte primitives");
+    if (!align(sizeof(T)) || sizeof(T) > size_ - offset_)
+    {
+      return false;
+    }
+    uint32_t bits;
+    std::memcpy(&bits, data_ + offset_, sizeof(bits));
+    offset_ += sizeof(bits);
+    if (swap_)
+    {
+      bits = swap_bytes(bits);
+    }
+    std::memcpy(&value, &bits, sizeof(bits));
+    return true;
+  }
+
+  const uint8_t * data_;
+  size_t size_;
+  size_t offset_ = 0;
+  bool swap_;
+  size_t max_alignment_;
+};
+
+template <typename... Args>
+std::string format(const char * format, Args... args)
+{
+  char message[256];
+  std::snprintf(message, sizeof(message), format, args...);
+  return message;
+}
+
+std::string field_size_error(
+  size_t joint_count, const char * field, size_t field_size, size_t point_index)
+{
+  return format(
+    "Mismatch between joint_names size (%zu) and %s (%zu) at point #%zu.", joint_count, field,
+    field_size, point_index);
+}
+
+int64_t to_ns(int32_t sec, uint32_t nanosec)
+{
+  return static_cast<int64_t>(sec) * 1000000000 + static_cast<int64_t>(nanosec);
+}
+}  // namespace
+
+TrajectoryCdrDecoder::TrajectoryCdrDecoder(std::vector<std::string> joint_names)
+: joint_names_(std::move(joint_names)), is_joint_in_msg_(joint_names_.size(), false)
+{
+  mapping_.reserve(joint_names_.size());
+}
+
+CdrDecodeResult TrajectoryCdrDecoder::decode(
+  const uint8_t * data, size_t size, const TrajectoryDecodeOptions & options,
+  trajectory_msgs::msg::JointTrajectory & trajectory, std::string & error)
+{
+  constexpr size_t ENCAPSULATION_SIZE = 4;
+  if (size < ENCAPSULATION_SIZE)
+  {
+    error = "The serialized trajectory is truncated.";
+    return CdrDecodeResult::INVALID;
+  }
+  // big-endian representation identifier, the options are ignored
+  const uint16_t representation = static_cast<uint16_t>((data[0] << 8) | data[1]);
+  bool little_endian;
+  size_t max_alignment;
+  switch (representation)
+  {
+    case 0x0000:  // CDR_BE
+    case 0x0001:  // CDR_LE
+      little_endian = representation == 0x0001;
+      max_alignment = 8;
+      break;
+    case 0x0006:  // PLAIN_CDR2_BE
+    case 0x0007:  // PLAIN_CDR2_LE
+      little_endian = representation == 0x0007;
+      max_alignment = 4;
+      break;
+    default:
+      error = format("Unsupported CDR representation 0x%04x.", representation);
+      return CdrDecodeResult::UNSUPPORTED;
+  }
+  CdrReader reader(
+    data + ENCAPSULATION_SIZE, size - ENCAPSULATION_SIZE, little_endian != is_little_endian_host(),
+    max_alignment);
+  const std::string truncated = "The serialized trajectory is truncated.";
+
+  // header
+  const char * chars;
+  size_t length;
+  if (
+    !reader.read(trajectory.header.stamp.sec) || !reader.read(trajectory.header.stamp.nanosec) ||
+    !reader.read_string(chars, length))
+  {
+    error = truncated;
+    return CdrDecodeResult::INVALID;
+  }
+  trajectory.header.frame_id.assign(chars, length);
+
+  // joint names, mapped to the local joint indices
+  const size_t dof = joint_names_.size();
+  uint32_t joint_count;
+  if (!reader.read(joint_count))
+  {
+    error = truncated;
+    return CdrDecodeResult::INVALID;
+  }
+  if (!options.allow_partial_joints_goal && joint_count != dof)
+  {
+    error = "Joints on incoming trajectory don't match the controller joints.";
+    return CdrDecodeResult::INVALID;
+  }
+  if (joint_count == 0)
+  {
+    error = "Empty joint names on incoming trajectory.";
+    return CdrDecodeResult::INVALID;
+  }
+  if (joint_count > dof)
+  {
+    error = "Incoming trajectory has more joints than the controller.";
+    return CdrDecodeResult::INVALID;
+  }
+  mapping_.clear();
+  std::fill(is_joint_in_msg_.begin(), is_joint_in_msg_.end(), false);
+  for (uint32_t i = 0; i < joint_count; ++i)
+  {
+    if (!reader.read_string(chars, length))
+    {
+      error = truncated;
+      return CdrDecodeResult::INVALID;
+    }
+    size_t index = NO_INDEX;
+    for (size_t j = 0; j < dof; ++j)
+    {
+      const auto & name = joint_names_[j];
+      if (name.size() == length && name.compare(0, length, chars, length) == 0)
+      {
+        index = j;
+        break;
+      }
+    }
+    if (index == NO_INDEX)
+    {
+      error = "Incoming joint " + std::string(chars, length) +
+              " doesn't match the controller's joints.";
+      return CdrDecodeResult::INVALID;
+    }
+    if (is_joint_in_msg_[index])
+    {
+      error = "Incoming joint " + joint_names_[index] + " is given twice.";
+      return CdrDecodeResult::INVALID;
+    }
+    is_joint_in_msg_[index] = true;
+    mapping_.push_back(index);
+  }
+  trajectory.joint_names = joint_names_;
+
+  // points, every field is written at its local joint indices
+  uint32_t point_count;
+  // a point has at least four sequence lengths and its time_from_start
+  constexpr size_t MIN_POINT_SIZE = 6 * sizeof(uint32_t);
+  if (!reader.read(point_count) || point_count > reader.remaining() / MIN_POINT_SIZE)
+  {
+    error = truncated;
+    return CdrDecodeResult::INVALID;
+  }
+  trajectory.points.resize(point_count);
+  const double fill_nan = std::numeric_limits<double>::quiet_NaN();
+  int64_t sum_time_from_start_ns = 0;
+  int64_t previous_time_ns = 0;
+  for (size_t p = 0; p < point_count; ++p)
+  {
+    auto & point = trajectory.points[p];
+    size_t field_sizes[4];
+    std::vector<double> * fields[4] = {
+      &point.positions, &point.velocities, &point.accelerations, &point.effort};
+    static constexpr const char * FIELD_NAMES[4] = {
+      "positions", "velocities", "accelerations", "effort"};
+    for (size_t f = 0; f < 4; ++f)
+    {
+      uint32_t count;
+      if (!reader.read(count))
+      {
+        error = truncated;
+        return CdrDecodeResult::INVALID;
+      }
+      field_sizes[f] = count;
+      if (count != 0 && count != joint_count)
+      {
+        error = field_size_error(joint_count, FIELD_NAMES[f], count, p);
+        return CdrDecodeResult::INVALID;
+      }
+      auto & values = *fields[f];
+      if (count == 0)
+      {
+        values.clear();
+        continue;
+      }
+      // the joints missing in partial goals hold their position, the derivatives are zero
+      if (f == 0 && joint_count != dof)
+      {
+        if (options.partial_goal_positions)
+        {
+          values = *options.partial_goal_positions;
+        }
+        else
+        {
+          values.assign(dof, fill_nan);
+        }
+      }
+      else
+      {
+        values.assign(dof, 0.0);
+      }
+      if (!reader.read_doubles(count, mapping_, values))
+      {
+        error = truncated;
+        return CdrDecodeResult::INVALID;
+      }
+    }
+    if (
+      !reader.read(point.time_from_start.sec) || !reader.read(point.time_from_start.nanosec))
+    {
+      error = truncated;
+      return CdrDecodeResult::INVALID;
+    }
+
+    const int64_t time_ns = to_ns(point.time_from_start.sec, point.time_from_start.nanosec);
+    if (p > 0 && time_ns <= previous_time_ns)
+    {
+      error = format(
+        "Time between points %zu and %zu is not strictly increasing, it is %f and %f "
+        "respectively",
+        p - 1, p, static_cast<double>(previous_time_ns) / 1e9, static_cast<double>(time_ns) / 1e9);
+      return CdrDecodeResult::INVALID;
+    }
+    previous_time_ns = time_ns;
+    sum_time_from_start_ns += time_ns;
+
+    // This currently supports only position, velocity and acceleration inputs
+    if (options.allow_integration_in_goal_trajectories)
+    {
+      if (field_sizes[0] == 0 && field_sizes[1] == 0 && field_sizes[2] == 0)
+      {
+        error = format("No positions, velocities or accelerations at point #%zu.", p);
+        return CdrDecodeResult::INVALID;
+      }
+    }
+    else if (field_sizes[0] == 0)
+    {
+      error = field_size_error(joint_count, FIELD_NAMES[0], 0, p);
+      return CdrDecodeResult::INVALID;
+    }
+    if (field_sizes[3] != 0)
+    {
+      error = "Trajectories with effort fields are currently not supported.";
+      return CdrDecodeResult::INVALID;
+    }
+  }
+
+  // If the starting time it set to 0.0, it means the controller should start it now.
+  // Otherwise we check if the trajectory ends before the current time,
+  // in which case it can be ignored.
+  const int64_t start_ns = to_ns(trajectory.header.stamp.sec, trajectory.header.stamp.nanosec);
+  if (start_ns != 0 && start_ns + sum_time_from_start_ns < options.now_ns)
+  {
+    error = format(
+      "Received trajectory with non-zero start time (%f) that ends in the past (%f)",
+      static_cast<double>(start_ns) / 1e9,
+      static_cast<double>(start_ns + sum_time_from_start_ns) / 1e9);
+    return CdrDecodeResult::INVALID;
+  }
+
+  if (!options.allow_nonzero_velocity_at_trajectory_end && !trajectory.points.empty())
+  {
+    const auto & velocities = trajectory.points.back().velocities;
+    for (size_t i = 0; i < velocities.size(); ++i)
+    {
+      if (std::fabs(velocities[i]) > std::numeric_limits<float>::epsilon())
+      {
+        error = format(
+          "Velocity of last trajectory point of joint %s is not zero: %.15f",
+          joint_names_[i].c_str(), velocities[i]);
+        return CdrDecodeResult::INVALID;
+      }
+    }
+  }
+  return CdrDecodeResult::DECODED;
+}
+
+}  // namespace joint_trajectory_controller
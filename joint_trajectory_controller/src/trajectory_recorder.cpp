@@ -0,0 +1,347 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/trajectory_recorder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+constexpr std::array<char, 8> LOG_MAGIC = {'J', 'T', 'C', 'L', 'O', 'G', '\0', '\0'};
+constexpr uint32_t LOG_VERSION = 1;
+
+template <typename T>
+void write_value(std::ofstream & file, const T & value)
+{
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void write_bytes(std::ofstream & file, const std::vector<uint8_t> & bytes)
+{
+  write_value(file, static_cast<uint32_t>(bytes.size()));
+  file.write(
+    reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+void write_string(std::ofstream & file, const std::string & string)
+{
+  write_value(file, static_cast<uint32_t>(string.size()));
+  file.write(string.data(), static_cast<std::streamsize>(string.size()));
+}
+
+void write_strings(std::ofstream & file, const std::vector<std::string> & strings)
+{
+  write_value(file, static_cast<uint32_t>(strings.size()));
+  for (const auto & string : strings)
+  {
+    write_string(file, string);
+  }
+}
+
+template <typename T>
+bool read_value(std::ifstream & file, T & value)
+{
+  return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+bool read_bytes(std::ifstream & file, std::vector<uint8_t> & bytes)
+{
+  uint32_t size = 0;
+  if (!read_value(file, size))
+  {
+    return false;
+  }
+  bytes.resize(size);
+  return static_cast<bool>(
+    file.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(size)));
+}
+
+bool read_string(std::ifstream & file, std::string & string)
+{
+  uint32_t size = 0;
+  if (!read_value(file, size))
+  {
+    return false;
+  }
+  string.resize(size);
+  return static_cast<bool>(file.read(string.data(), static_cast<std::streamsize>(size)));
+}
+
+bool read_strings(std::ifstream & file, std::vector<std::string> & strings)
+{
+  uint32_t size = 0;
+  if (!read_value(file, size))
+  {
+    return false;
+  }
+  strings.resize(size);
+  for (auto & string : strings)
+  {
+    if (!read_string(file, string))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool read_doubles(std::ifstream & file, size_t count, std::vector<double> & values)
+{
+  values.resize(count);
+  return static_cast<bool>(file.read(
+    reinterpret_cast<char *>(values.data()), static_cast<std::streamsize>(count * sizeof(double))));
+}
+}  // namespace
+
+bool TrajectoryRecorder::open(
+  const std::string & path, const std::string & controller_name,
+  const std::vector<uint8_t> & parameters)
+{
+  close();
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  if (!file_)
+  {
+    return false;
+  }
+  file_.write(LOG_MAGIC.data(), LOG_MAGIC.size());
+  write_value(file_, LOG_VERSION);
+  write_string(file_, controller_name);
+  write_bytes(file_, parameters);
+  file_.flush();
+  return file_.good();
+}
+
+void TrajectoryRecorder::close()
+{
+  stop_session();
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  if (file_.is_open())
+  {
+    file_.close();
+  }
+}
+
+void TrajectoryRecorder::start_session(
+  const std::vector<std::string> & state_names, const std::vector<std::string> & command_names,
+  size_t capacity, std::chrono::nanoseconds flush_period)
+{
+  stop_session();
+  {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (!file_.is_open())
+    {
+      return;
+    }
+    state_count_ = state_names.size();
+    command_count_ = command_names.size();
+    UpdateSlot empty_slot;
+    empty_slot.values.assign(state_count_ + command_count_, 0.0);
+    slots_.assign(std::max<size_t>(capacity, 1), empty_slot);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    cycle_.store(0, std::memory_order_relaxed);
+    dropped_updates_.store(0, std::memory_order_relaxed);
+    events_.clear();
+
+    write_value(file_, RecordKind::SESSION);
+    write_value(file_, uint64_t{0});
+    write_strings(file_, state_names);
+    write_strings(file_, command_names);
+    session_active_ = true;
+    stop_writer_ = false;
+  }
+  recording_.store(true, std::memory_order_release);
+
+  writer_ = std::thread(
+    [this, flush_period]()
+    {
+      std::unique_lock<std::mutex> lock(file_mutex_);
+      while (!stop_writer_)
+      {
+        writer_condition_.wait_for(lock, flush_period, [this]() { return stop_writer_; });
+        flush();
+      }
+    });
+}
+
+void TrajectoryRecorder::stop_session()
+{
+  // update() is not called anymore at this point, e.g., once the controller is deactivated
+  recording_.store(false, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    stop_writer_ = true;
+  }
+  writer_condition_.notify_all();
+  if (writer_.joinable())
+  {
+    writer_.join();
+  }
+
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  if (session_active_)
+  {
+    flush();
+    session_active_ = false;
+  }
+}
+
+void TrajectoryRecorder::record_update(
+  int64_t time_ns, int64_t period_ns,
+  const std::vector<hardware_interface::LoanedStateInterface> & state_interfaces,
+  const std::vector<hardware_interface::LoanedCommandInterface> & command_interfaces)
+{
+  if (!recording_.load(std::memory_order_acquire))
+  {
+    return;
+  }
+  const uint64_t cycle = cycle_.load(std::memory_order_relaxed);
+  const size_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) >= slots_.size())
+  {
+    dropped_updates_.fetch_add(1, std::memory_order_relaxed);
+  }
+  else
+  {
+    auto & slot = slots_[head % slots_.size()];
+    slot.cycle = cycle;
+    slot.time_ns = time_ns;
+    slot.period_ns = period_ns;
+    const size_t state_count = std::min(state_count_, state_interfaces.size());
+    for (size_t index = 0; index < state_count; ++index)
+    {
+      slot.values[index] = state_interfaces[index].get_value();
+    }
+    const size_t command_count = std::min(command_count_, command_interfaces.size());
+    for (size_t index = 0; index < command_count; ++index)
+    {
+      slot.values[state_count_ + index] = command_interfaces[index].get_value();
+    }
+    head_.store(head + 1, std::memory_order_release);
+  }
+  // the events taking this cycle are written after the slot of the previous update
+  cycle_.store(cycle + 1, std::memory_order_release);
+}
+
+void TrajectoryRecorder::record_event(RecordKind kind, std::vector<uint8_t> payload)
+{
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  if (!session_active_)
+  {
+    return;
+  }
+  events_.push_back(Event{kind, cycle_.load(std::memory_order_acquire), std::move(payload)});
+}
+
+void TrajectoryRecorder::flush()
+{
+  // the events were received after the updates before their cycle were pushed, so all of them
+  // precede the updates pushed after this point
+  const size_t head = head_.load(std::memory_order_acquire);
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  for (; tail != head; ++tail)
+  {
+    const auto & slot = slots_[tail % slots_.size()];
+    while (!events_.empty() && events_.front().cycle <= slot.cycle)
+    {
+      write_event(events_.front());
+      events_.pop_front();
+    }
+    write_update(slot);
+  }
+  tail_.store(tail, std::memory_order_release);
+  for (const auto & event : events_)
+  {
+    write_event(event);
+  }
+  events_.clear();
+  file_.flush();
+}
+
+void TrajectoryRecorder::write_update(const UpdateSlot & slot)
+{
+  write_value(file_, RecordKind::UPDATE);
+  write_value(file_, slot.cycle);
+  write_value(file_, slot.time_ns);
+  write_value(file_, slot.period_ns);
+  file_.write(
+    reinterpret_cast<const char *>(slot.values.data()),
+    static_cast<std::streamsize>(slot.values.size() * sizeof(double)));
+}
+
+void TrajectoryRecorder::write_event(const Event & event)
+{
+  write_value(file_, event.kind);
+  write_value(file_, event.cycle);
+  if (event.kind != RecordKind::CANCEL)
+  {
+    write_bytes(file_, event.payload);
+  }
+}
+
+bool TrajectoryLogReader::open(const std::string & path)
+{
+  file_.close();
+  file_.clear();
+  file_.open(path, std::ios::binary);
+  std::array<char, LOG_MAGIC.size()> magic{};
+  uint32_t version = 0;
+  state_count_ = 0;
+  command_count_ = 0;
+  return file_.read(magic.data(), magic.size()) && magic == LOG_MAGIC &&
+         read_value(file_, version) && version == LOG_VERSION &&
+         read_string(file_, controller_name_) && read_bytes(file_, parameters_);
+}
+
+bool TrajectoryLogReader::read(LogRecord & record)
+{
+  if (!read_value(file_, record.kind) || !read_value(file_, record.cycle))
+  {
+    return false;
+  }
+  switch (record.kind)
+  {
+    case RecordKind::SESSION:
+      if (!read_strings(file_, record.state_names) || !read_strings(file_, record.command_names))
+      {
+        return false;
+      }
+      state_count_ = record.state_names.size();
+      command_count_ = record.command_names.size();
+      return true;
+    case RecordKind::UPDATE:
+      return read_value(file_, record.time_ns) && read_value(file_, record.period_ns) &&
+             read_doubles(file_, state_count_, record.state_values) &&
+             read_doubles(file_, command_count_, record.command_values);
+    case RecordKind::TRAJECTORY:
+    case RecordKind::GOAL:
+      return read_bytes(file_, record.payload);
+    case RecordKind::CANCEL:
+      record.payload.clear();
+      return true;
+  }
+  // unknown kind, e.g., of a corrupted file
+  return false;
+}
+
+}  // namespace joint_trajectory_controller
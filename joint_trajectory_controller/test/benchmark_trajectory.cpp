@@ -0,0 +1,271 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "joint_trajectory_controller/joint_trajectory_controller.hpp"
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace
+{
+// time between two points of the benchmarked trajectories, and period of the control loop
+const rclcpp::Duration POINT_PERIOD = rclcpp::Duration::from_seconds(0.01);
+const rclcpp::Duration CONTROL_PERIOD = rclcpp::Duration::from_seconds(0.001);
+
+std::vector<std::string> make_joint_names(size_t n_joints)
+{
+  std::vector<std::string> joint_names;
+  for (size_t i = 0; i < n_joints; ++i)
+  {
+    joint_names.push_back("joint" + std::to_string(i));
+  }
+  return joint_names;
+}
+
+std::shared_ptr<trajectory_msgs::msg::JointTrajectory> make_trajectory(
+  const std::vector<std::string> & joint_names, size_t n_points)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->joint_names = joint_names;
+  msg->points.resize(n_points);
+  for (size_t i = 0; i < n_points; ++i)
+  {
+    auto & point = msg->points[i];
+    point.time_from_start = POINT_PERIOD * static_cast<double>(i + 1);
+    point.positions.resize(joint_names.size());
+    point.velocities.resize(joint_names.size());
+    for (size_t j = 0; j < joint_names.size(); ++j)
+    {
+      point.positions[j] = 0.1 * std::sin(0.01 * static_cast<double>(i + j));
+      point.velocities[j] = 0.001 * std::cos(0.01 * static_cast<double>(i + j));
+    }
+  }
+  // come to a stop at the end
+  std::fill(msg->points.back().velocities.begin(), msg->points.back().velocities.end(), 0.0);
+  return msg;
+}
+
+trajectory_msgs::msg::JointTrajectoryPoint make_zero_point(size_t n_joints)
+{
+  trajectory_msgs::msg::JointTrajectoryPoint point;
+  point.positions.resize(n_joints, 0.0);
+  point.velocities.resize(n_joints, 0.0);
+  point.accelerations.resize(n_joints, 0.0);
+  return point;
+}
+
+class BenchmarkableJointTrajectoryController
+: public joint_trajectory_controller::JointTrajectoryController
+{
+public:
+  using joint_trajectory_controller::JointTrajectoryController::add_new_trajectory_msg;
+  using joint_trajectory_controller::JointTrajectoryController::sort_to_local_joint_order;
+  using joint_trajectory_controller::JointTrajectoryController::validate_trajectory_msg;
+};
+
+/// Arguments: number of joints, number of trajectory points
+class JointTrajectoryControllerBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(const benchmark::State & state) override
+  {
+    if (!rclcpp::ok())
+    {
+      rclcpp::init(0, nullptr);
+    }
+    joint_names_ = make_joint_names(static_cast<size_t>(state.range(0)));
+    trajectory_msg_ = make_trajectory(joint_names_, static_cast<size_t>(state.range(1)));
+  }
+
+  void TearDown(const benchmark::State &) override
+  {
+    if (controller_)
+    {
+      controller_->get_node()->deactivate();
+      controller_->get_node()->cleanup();
+      controller_.reset();
+    }
+    command_interfaces_.clear();
+    state_interfaces_.clear();
+    rclcpp::shutdown();
+  }
+
+  /// Configure and activate a controller for position commands on mocked hardware
+  void activate_controller()
+  {
+    controller_ = std::make_shared<BenchmarkableJointTrajectoryController>();
+    auto node_options = rclcpp::NodeOptions();
+    node_options.parameter_overrides(
+      {rclcpp::Parameter("joints", joint_names_),
+       rclcpp::Parameter("command_interfaces", std::vector<std::string>{"position"}),
+       rclcpp::Parameter("state_interfaces", std::vector<std::string>{"position", "velocity"}),
+       rclcpp::Parameter("allow_nonzero_velocity_at_trajectory_end", true)});
+    controller_->init("benchmark_joint_trajectory_controller", "", 0, "", node_options);
+    controller_->get_node()->configure();
+
+    const size_t n_joints = joint_names_.size();
+    joint_position_.assign(n_joints, 0.0);
+    joint_velocity_.assign(n_joints, 0.0);
+    command_interfaces_.reserve(n_joints);
+    state_interfaces_.reserve(2 * n_joints);
+    std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+    std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+    for (size_t i = 0; i < n_joints; ++i)
+    {
+      command_interfaces_.emplace_back(
+        joint_names_[i], hardware_interface::HW_IF_POSITION, &joint_position_[i]);
+      loaned_command_interfaces.emplace_back(command_interfaces_.back());
+      state_interfaces_.emplace_back(
+        joint_names_[i], hardware_interface::HW_IF_POSITION, &joint_position_[i]);
+      loaned_state_interfaces.emplace_back(state_interfaces_.back());
+      state_interfaces_.emplace_back(
+        joint_names_[i], hardware_interface::HW_IF_VELOCITY, &joint_velocity_[i]);
+      loaned_state_interfaces.emplace_back(state_interfaces_.back());
+    }
+    controller_->assign_interfaces(
+      std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+    controller_->get_node()->activate();
+  }
+
+protected:
+  std::vector<std::string> joint_names_;
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg_;
+
+  std::shared_ptr<BenchmarkableJointTrajectoryController> controller_;
+  std::vector<double> joint_position_;
+  std::vector<double> joint_velocity_;
+  std::vector<hardware_interface::CommandInterface> command_interfaces_;
+  std::vector<hardware_interface::StateInterface> state_interfaces_;
+};
+
+void trajectory_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgsProduct({{6, 16, 32, 64}, {2, 100, 5000, 50000}});
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(JointTrajectoryControllerBenchmark, sample)(benchmark::State & state)
+{
+  const rclcpp::Time start_time(0, 0, RCL_STEADY_TIME);
+  joint_trajectory_controller::Trajectory trajectory(
+    start_time, make_zero_point(joint_names_.size()), trajectory_msg_);
+  const auto duration =
+    rclcpp::Duration(trajectory_msg_->points.back().time_from_start) + POINT_PERIOD;
+
+  trajectory_msgs::msg::JointTrajectoryPoint output_state;
+  joint_trajectory_controller::TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+  rclcpp::Duration time_from_start = rclcpp::Duration::from_seconds(0.0);
+  for (auto _ : state)
+  {
+    trajectory.sample(
+      start_time + time_from_start,
+      joint_trajectory_controller::interpolation_methods::DEFAULT_INTERPOLATION, output_state,
+      start_segment_itr, end_segment_itr);
+    benchmark::DoNotOptimize(output_state);
+    // loop over the whole trajectory, including the jump back to its start
+    time_from_start = time_from_start + CONTROL_PERIOD;
+    if (time_from_start > duration)
+    {
+      time_from_start = rclcpp::Duration::from_seconds(0.0);
+    }
+  }
+}
+BENCHMARK_REGISTER_F(JointTrajectoryControllerBenchmark, sample)->Apply(trajectory_arguments);
+
+BENCHMARK_DEFINE_F(JointTrajectoryControllerBenchmark, interpolate_between_points)
+(benchmark::State & state)
+{
+  joint_trajectory_controller::Trajectory trajectory;
+  const rclcpp::Time time_a(0, 0, RCL_STEADY_TIME);
+  const rclcpp::Time time_b = time_a + POINT_PERIOD;
+  const auto & state_a = trajectory_msg_->points.front();
+  const auto & state_b = trajectory_msg_->points.back();
+
+  trajectory_msgs::msg::JointTrajectoryPoint output;
+  for (auto _ : state)
+  {
+    trajectory.interpolate_between_points(
+      time_a, state_a, time_b, state_b, time_a + CONTROL_PERIOD * 3.0, output);
+    benchmark::DoNotOptimize(output);
+  }
+}
+BENCHMARK_REGISTER_F(JointTrajectoryControllerBenchmark, interpolate_between_points)
+  ->ArgsProduct({{6, 16, 32, 64}, {2}});
+
+BENCHMARK_DEFINE_F(JointTrajectoryControllerBenchmark, sort_to_local_joint_order)
+(benchmark::State & state)
+{
+  activate_controller();
+  // the incoming joints are in reverse order
+  auto reversed_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*trajectory_msg_);
+  std::reverse(reversed_msg->joint_names.begin(), reversed_msg->joint_names.end());
+  for (auto & point : reversed_msg->points)
+  {
+    std::reverse(point.positions.begin(), point.positions.end());
+    std::reverse(point.velocities.begin(), point.velocities.end());
+  }
+
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    *msg = *reversed_msg;
+    state.ResumeTiming();
+    controller_->sort_to_local_joint_order(msg);
+    benchmark::DoNotOptimize(msg->points.data());
+  }
+}
+BENCHMARK_REGISTER_F(JointTrajectoryControllerBenchmark, sort_to_local_joint_order)
+  ->Apply(trajectory_arguments);
+
+BENCHMARK_DEFINE_F(JointTrajectoryControllerBenchmark, validate_trajectory_msg)
+(benchmark::State & state)
+{
+  activate_controller();
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(controller_->validate_trajectory_msg(*trajectory_msg_));
+  }
+}
+BENCHMARK_REGISTER_F(JointTrajectoryControllerBenchmark, validate_trajectory_msg)
+  ->Apply(trajectory_arguments);
+
+BENCHMARK_DEFINE_F(JointTrajectoryControllerBenchmark, update)(benchmark::State & state)
+{
+  activate_controller();
+  controller_->add_new_trajectory_msg(trajectory_msg_);
+
+  rclcpp::Time time = controller_->get_node()->now();
+  for (auto _ : state)
+  {
+    controller_->update(time, CONTROL_PERIOD);
+    time += CONTROL_PERIOD;
+  }
+}
+BENCHMARK_REGISTER_F(JointTrajectoryControllerBenchmark, update)->Apply(trajectory_arguments);
@@ -0,0 +1,197 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "joint_trajectory_controller/joint_group_trajectory.hpp"
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/time.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+using joint_trajectory_controller::merge_group_trajectory;
+using joint_trajectory_controller::Trajectory;
+using joint_trajectory_controller::TrajectoryPointConstIter;
+using joint_trajectory_controller::interpolation_methods::InterpolationMethod;
+using trajectory_msgs::msg::JointTrajectory;
+using trajectory_msgs::msg::JointTrajectoryPoint;
+
+namespace
+{
+const std::vector<std::string> JOINT_NAMES = {"joint1", "joint2"};
+constexpr auto SPLINE = InterpolationMethod::VARIABLE_DEGREE_SPLINE;
+
+JointTrajectoryPoint make_point(
+  double time_from_start, const std::vector<double> & positions,
+  const std::vector<double> & velocities)
+{
+  JointTrajectoryPoint point;
+  point.time_from_start = rclcpp::Duration::from_seconds(time_from_start);
+  point.positions = positions;
+  point.velocities = velocities;
+  point.accelerations.assign(positions.size(), 0.0);
+  return point;
+}
+
+/// Trajectory of both joints starting at 1 s, with points at 2 s and 4 s
+std::shared_ptr<Trajectory> make_base()
+{
+  auto msg = std::make_shared<JointTrajectory>();
+  msg->header.stamp = rclcpp::Time(1000000000);
+  msg->joint_names = JOINT_NAMES;
+  msg->points.push_back(make_point(1.0, {1.0, -1.0}, {0.5, -0.5}));
+  msg->points.push_back(make_point(3.0, {2.0, -2.0}, {0.0, 0.0}));
+  return std::make_shared<Trajectory>(
+    rclcpp::Time(1000000000), make_point(0.0, {0.0, 0.0}, {0.0, 0.0}), msg);
+}
+
+JointTrajectoryPoint sample(const Trajectory & trajectory, int64_t time_ns)
+{
+  JointTrajectoryPoint state;
+  TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+  EXPECT_TRUE(
+    trajectory.sample_at(rclcpp::Time(time_ns), SPLINE, state, start_segment_itr, end_segment_itr));
+  return state;
+}
+
+std::vector<int64_t> point_times_ns(const JointTrajectory & msg)
+{
+  std::vector<int64_t> times_ns;
+  for (const auto & point : msg.points)
+  {
+    times_ns.push_back(rclcpp::Duration(point.time_from_start).nanoseconds());
+  }
+  return times_ns;
+}
+}  // namespace
+
+TEST(TestJointGroupTrajectory, group_follows_its_trajectory_and_the_others_continue)
+{
+  const auto base = make_base();
+  const int64_t base_time_ns = 1500000000;
+  const int64_t start_time_ns = 10000000000;
+
+  JointTrajectory group_msg;
+  group_msg.joint_names = {"joint2"};
+  group_msg.points.push_back(make_point(1.0, {5.0}, {1.0}));
+  group_msg.points.push_back(make_point(2.0, {6.0}, {0.0}));
+
+  int64_t group_duration_ns = 0;
+  const auto merged = merge_group_trajectory(
+    *base, rclcpp::Time(base_time_ns), rclcpp::Time(start_time_ns), JOINT_NAMES, &group_msg, {1},
+    {}, SPLINE, group_duration_ns);
+  ASSERT_TRUE(merged);
+  EXPECT_EQ(merged->joint_names, JOINT_NAMES);
+  EXPECT_EQ(rclcpp::Time(merged->header.stamp).nanoseconds(), start_time_ns);
+  EXPECT_EQ(group_duration_ns, 2000000000);
+  // the start, the points of the base after base_time and the points of the group
+  EXPECT_THAT(
+    point_times_ns(*merged),
+    ::testing::ElementsAre(0, 500000000, 1000000000, 2000000000, 2500000000));
+  for (const auto & point : merged->points)
+  {
+    EXPECT_EQ(point.positions.size(), 2u);
+    EXPECT_EQ(point.velocities.size(), 2u);
+    EXPECT_EQ(point.accelerations.size(), 2u);
+  }
+
+  // the group trajectory starts from the state of the base
+  const auto start_state = sample(*base, base_time_ns);
+  auto stamped_group_msg = std::make_shared<JointTrajectory>(group_msg);
+  stamped_group_msg->header.stamp = rclcpp::Time(start_time_ns);
+  JointTrajectoryPoint group_start;
+  group_start.positions = {start_state.positions[1]};
+  group_start.velocities = {start_state.velocities[1]};
+  group_start.accelerations = {start_state.accelerations[1]};
+  const Trajectory group_trajectory(
+    rclcpp::Time(start_time_ns), group_start, stamped_group_msg);
+
+  const Trajectory merged_trajectory(rclcpp::Time(start_time_ns), merged->points[0], merged);
+  for (int64_t time_ns = 0; time_ns <= 3000000000; time_ns += 50000000)
+  {
+    const auto merged_state = sample(merged_trajectory, start_time_ns + time_ns);
+    const auto base_state = sample(*base, base_time_ns + time_ns);
+    const auto group_state = sample(group_trajectory, start_time_ns + time_ns);
+    EXPECT_NEAR(merged_state.positions[0], base_state.positions[0], 1e-9) << time_ns;
+    EXPECT_NEAR(merged_state.velocities[0], base_state.velocities[0], 1e-9) << time_ns;
+    EXPECT_NEAR(merged_state.positions[1], group_state.positions[0], 1e-9) << time_ns;
+    EXPECT_NEAR(merged_state.velocities[1], group_state.velocities[0], 1e-9) << time_ns;
+  }
+  EXPECT_DOUBLE_EQ(merged->points.back().positions[1], 6.0);
+  EXPECT_DOUBLE_EQ(merged->points.back().positions[0], 2.0);
+}
+
+TEST(TestJointGroupTrajectory, held_joints_stop_at_their_start_position)
+{
+  const auto base = make_base();
+  const int64_t base_time_ns = 1500000000;
+
+  int64_t group_duration_ns = -1;
+  const auto merged = merge_group_trajectory(
+    *base, rclcpp::Time(base_time_ns), rclcpp::Time(base_time_ns), JOINT_NAMES, nullptr, {}, {1},
+    SPLINE, group_duration_ns);
+  ASSERT_TRUE(merged);
+  EXPECT_EQ(group_duration_ns, 0);
+  EXPECT_THAT(point_times_ns(*merged), ::testing::ElementsAre(0, 500000000, 2500000000));
+
+  const auto start_state = sample(*base, base_time_ns);
+  for (size_t i = 0; i < merged->points.size(); ++i)
+  {
+    const auto & point = merged->points[i];
+    EXPECT_DOUBLE_EQ(point.positions[1], start_state.positions[1]);
+    EXPECT_DOUBLE_EQ(point.velocities[1], 0.0);
+    EXPECT_DOUBLE_EQ(point.accelerations[1], 0.0);
+    const auto base_state =
+      sample(*base, base_time_ns + rclcpp::Duration(point.time_from_start).nanoseconds());
+    EXPECT_DOUBLE_EQ(point.positions[0], base_state.positions[0]);
+  }
+  // the joint continues with its velocity at the start
+  EXPECT_DOUBLE_EQ(merged->points[0].velocities[0], start_state.velocities[0]);
+}
+
+TEST(TestJointGroupTrajectory, close_points_are_merged)
+{
+  const auto base = make_base();
+
+  JointTrajectory group_msg;
+  group_msg.joint_names = {"joint1"};
+  // 300 ns after the first point of the base
+  group_msg.points.push_back(make_point(1.0000003, {3.0}, {0.0}));
+
+  int64_t group_duration_ns = 0;
+  const auto merged = merge_group_trajectory(
+    *base, rclcpp::Time(1000000000), rclcpp::Time(1000000000), JOINT_NAMES, &group_msg, {0}, {},
+    SPLINE, group_duration_ns);
+  ASSERT_TRUE(merged);
+  EXPECT_EQ(group_duration_ns, 1000000300);
+  EXPECT_THAT(point_times_ns(*merged), ::testing::ElementsAre(0, 1000000000, 3000000000));
+}
+
+TEST(TestJointGroupTrajectory, base_before_its_start_is_rejected)
+{
+  const auto base = make_base();
+
+  int64_t group_duration_ns = 0;
+  EXPECT_FALSE(merge_group_trajectory(
+    *base, rclcpp::Time(500000000), rclcpp::Time(500000000), JOINT_NAMES, nullptr, {}, {1},
+    SPLINE, group_duration_ns));
+  EXPECT_FALSE(merge_group_trajectory(
+    Trajectory(), rclcpp::Time(1000000000), rclcpp::Time(1000000000), JOINT_NAMES, nullptr, {},
+    {1}, SPLINE, group_duration_ns));
+}
@@ -0,0 +1,194 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "joint_trajectory_controller/mapped_trajectory.hpp"
+#include "rclcpp/duration.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+using joint_trajectory_controller::MappedTrajectory;
+using joint_trajectory_controller::write_mapped_trajectory;
+using trajectory_msgs::msg::JointTrajectory;
+using trajectory_msgs::msg::JointTrajectoryPoint;
+
+class TestMappedTrajectory : public ::testing::Test
+{
+protected:
+  void SetUp() override { path_ = testing::TempDir() + "test_mapped_trajectory.traj"; }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  /// Trajectory of two joints moving linearly, joint2 in the opposite direction
+  JointTrajectory make_trajectory(size_t num_points, bool with_velocities)
+  {
+    JointTrajectory trajectory;
+    trajectory.joint_names = {"joint1", "joint2"};
+    for (size_t i = 0; i < num_points; ++i)
+    {
+      JointTrajectoryPoint point;
+      point.time_from_start = rclcpp::Duration::from_seconds(0.1 * static_cast<double>(i + 1));
+      point.positions = {static_cast<double>(i + 1), -static_cast<double>(i + 1)};
+      if (with_velocities)
+      {
+        point.velocities = {10.0, -10.0};
+      }
+      trajectory.points.push_back(point);
+    }
+    return trajectory;
+  }
+
+  JointTrajectoryPoint make_start_state() const
+  {
+    JointTrajectoryPoint start_state;
+    start_state.positions = {0.0, 0.0};
+    start_state.velocities = {0.0, 0.0};
+    start_state.accelerations = {0.0, 0.0};
+    return start_state;
+  }
+
+  std::string path_;
+};
+
+TEST_F(TestMappedTrajectory, open_written_trajectory)
+{
+  std::string error;
+  ASSERT_TRUE(write_mapped_trajectory(path_, make_trajectory(5, true), error)) << error;
+
+  MappedTrajectory trajectory;
+  ASSERT_TRUE(trajectory.open(path_, error)) << error;
+  EXPECT_THAT(trajectory.get_joint_names(), ::testing::ElementsAre("joint1", "joint2"));
+  EXPECT_EQ(trajectory.size(), 5u);
+  EXPECT_TRUE(trajectory.has_velocities());
+  EXPECT_FALSE(trajectory.has_accelerations());
+  EXPECT_EQ(trajectory.get_duration_ns(), 500000000);
+}
+
+TEST_F(TestMappedTrajectory, sample_points_and_segments)
+{
+  std::string error;
+  ASSERT_TRUE(write_mapped_trajectory(path_, make_trajectory(5, false), error)) << error;
+  MappedTrajectory trajectory;
+  ASSERT_TRUE(trajectory.open(path_, error)) << error;
+  ASSERT_TRUE(trajectory.set_joint_order({"joint1", "joint2"}, error)) << error;
+  trajectory.start(make_start_state());
+
+  JointTrajectoryPoint output;
+  ASSERT_TRUE(trajectory.sample(0, output));
+  EXPECT_NEAR(output.positions[0], 0.0, 1e-9);
+  ASSERT_TRUE(trajectory.sample(100000000, output));
+  EXPECT_NEAR(output.positions[0], 1.0, 1e-9);
+  EXPECT_NEAR(output.positions[1], -1.0, 1e-9);
+  // linear segment between the points without derivatives
+  ASSERT_TRUE(trajectory.sample(250000000, output));
+  EXPECT_NEAR(output.positions[0], 2.5, 1e-9);
+  EXPECT_NEAR(output.positions[1], -2.5, 1e-9);
+  // the cursor skips several segments at once
+  ASSERT_TRUE(trajectory.sample(450000000, output));
+  EXPECT_NEAR(output.positions[0], 4.5, 1e-9);
+
+  // the last point is held after the end
+  EXPECT_FALSE(trajectory.sample(600000000, output));
+  EXPECT_NEAR(output.positions[0], 5.0, 1e-9);
+  EXPECT_NEAR(output.positions[1], -5.0, 1e-9);
+  EXPECT_THAT(output.velocities, ::testing::ElementsAre(0.0, 0.0));
+}
+
+TEST_F(TestMappedTrajectory, sample_many_points_after_prefetch)
+{
+  std::string error;
+  ASSERT_TRUE(write_mapped_trajectory(path_, make_trajectory(10000, true), error)) << error;
+  MappedTrajectory trajectory;
+  ASSERT_TRUE(trajectory.open(path_, error)) << error;
+  ASSERT_TRUE(trajectory.set_joint_order({"joint1", "joint2"}, error)) << error;
+  trajectory.start(make_start_state());
+
+  JointTrajectoryPoint output;
+  for (int64_t time_ns = 0; time_ns < 1000000000; time_ns += 10000000)
+  {
+    trajectory.prefetch(100000000);
+    ASSERT_TRUE(trajectory.sample(time_ns, output));
+  }
+  // far ahead of the cursor, found by searching
+  ASSERT_TRUE(trajectory.sample(500000000000, output));
+  EXPECT_NEAR(output.positions[0], 5000.0, 1e-6);
+  EXPECT_NEAR(output.velocities[0], 10.0, 1e-6);
+}
+
+TEST_F(TestMappedTrajectory, sample_in_joint_order)
+{
+  std::string error;
+  ASSERT_TRUE(write_mapped_trajectory(path_, make_trajectory(2, true), error)) << error;
+  MappedTrajectory trajectory;
+  ASSERT_TRUE(trajectory.open(path_, error)) << error;
+  ASSERT_TRUE(trajectory.set_joint_order({"joint2", "joint1"}, error)) << error;
+  trajectory.start(make_start_state());
+
+  JointTrajectoryPoint output;
+  ASSERT_TRUE(trajectory.sample(100000000, output));
+  EXPECT_NEAR(output.positions[0], -1.0, 1e-9);
+  EXPECT_NEAR(output.positions[1], 1.0, 1e-9);
+  EXPECT_NEAR(output.velocities[0], -10.0, 1e-9);
+
+  EXPECT_FALSE(trajectory.set_joint_order({"joint1", "joint3"}, error));
+  EXPECT_FALSE(trajectory.set_joint_order({"joint1"}, error));
+}
+
+TEST_F(TestMappedTrajectory, reject_invalid_files)
+{
+  std::string error;
+  MappedTrajectory trajectory;
+  EXPECT_FALSE(trajectory.open(path_, error));
+
+  {
+    std::ofstream file(path_, std::ios::binary);
+    file << "not a trajectory file";
+  }
+  EXPECT_FALSE(trajectory.open(path_, error));
+
+  // truncated arrays
+  ASSERT_TRUE(write_mapped_trajectory(path_, make_trajectory(100, true), error)) << error;
+  std::filesystem::resize_file(path_, std::filesystem::file_size(path_) - 8);
+  EXPECT_FALSE(trajectory.open(path_, error));
+
+  // not increasing times
+  auto not_increasing = make_trajectory(3, false);
+  not_increasing.points[2].time_from_start = not_increasing.points[1].time_from_start;
+  ASSERT_TRUE(write_mapped_trajectory(path_, not_increasing, error)) << error;
+  EXPECT_FALSE(trajectory.open(path_, error));
+  EXPECT_EQ(trajectory.size(), 0u);
+}
+
+TEST_F(TestMappedTrajectory, reject_incomplete_trajectories_on_write)
+{
+  std::string error;
+  EXPECT_FALSE(write_mapped_trajectory(path_, JointTrajectory(), error));
+
+  auto incomplete = make_trajectory(3, true);
+  incomplete.points[1].positions.pop_back();
+  EXPECT_FALSE(write_mapped_trajectory(path_, incomplete, error));
+
+  // velocities are only written if all points have them
+  auto partial_velocities = make_trajectory(3, true);
+  partial_velocities.points[1].velocities.clear();
+  ASSERT_TRUE(write_mapped_trajectory(path_, partial_velocities, error)) << error;
+  MappedTrajectory trajectory;
+  ASSERT_TRUE(trajectory.open(path_, error)) << error;
+  EXPECT_FALSE(trajectory.has_velocities());
+}
@@ -0,0 +1,227 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "control_msgs/action/follow_joint_trajectory.hpp"
+#include "joint_trajectory_controller/tolerances.hpp"
+#include "joint_trajectory_controller/tracking_statistics.hpp"
+#include "rclcpp/duration.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+using joint_trajectory_controller::check_state_tolerance;
+using joint_trajectory_controller::check_state_tolerance_of_joints;
+using joint_trajectory_controller::check_state_tolerance_per_joint;
+using joint_trajectory_controller::get_goal_segment_tolerances;
+using joint_trajectory_controller::SegmentTolerances;
+using joint_trajectory_controller::StateTolerances;
+using joint_trajectory_controller::to_state_tolerance_arrays;
+using joint_trajectory_controller::TrackingStatistics;
+using trajectory_msgs::msg::JointTrajectoryPoint;
+
+TEST(TestTolerances, not_enforced_tolerances_are_infinite)
+{
+  std::vector<StateTolerances> state_tolerances(2);
+  state_tolerances[0].position = 0.1;
+  state_tolerances[1].velocity = 0.2;
+
+  const auto arrays = to_state_tolerance_arrays(state_tolerances);
+  ASSERT_EQ(arrays.position.size(), 2u);
+  EXPECT_DOUBLE_EQ(arrays.position[0], 0.1);
+  EXPECT_TRUE(std::isinf(arrays.position[1]));
+  EXPECT_TRUE(std::isinf(arrays.velocity[0]));
+  EXPECT_DOUBLE_EQ(arrays.velocity[1], 0.2);
+  EXPECT_TRUE(std::isinf(arrays.acceleration[0]));
+  EXPECT_TRUE(std::isinf(arrays.acceleration[1]));
+}
+
+TEST(TestTolerances, check_all_joints_matches_check_per_joint)
+{
+  const size_t n_joints = 33;
+  std::vector<StateTolerances> state_tolerances(n_joints);
+  JointTrajectoryPoint state_error;
+  state_error.positions.resize(n_joints);
+  state_error.velocities.resize(n_joints);
+  for (size_t i = 0; i < n_joints; ++i)
+  {
+    state_tolerances[i].position = (i % 3 == 0) ? 0.0 : 0.1;
+    state_tolerances[i].velocity = (i % 2 == 0) ? 0.0 : 0.5;
+    state_error.positions[i] = (i % 2 == 0) ? -0.05 : 0.05;
+    state_error.velocities[i] = 0.3;
+  }
+  const auto arrays = to_state_tolerance_arrays(state_tolerances);
+
+  auto check_per_joint = [&]()
+  {
+    bool is_valid = true;
+    for (size_t i = 0; i < n_joints; ++i)
+    {
+      is_valid &= check_state_tolerance_per_joint(state_error, i, state_tolerances[i]);
+    }
+    return is_valid;
+  };
+
+  EXPECT_TRUE(check_per_joint());
+  EXPECT_TRUE(check_state_tolerance(state_error, arrays));
+
+  // violate the tolerance of the last joint only, which is not a multiple of a vector width
+  state_error.positions[n_joints - 1] = -0.2;
+  EXPECT_FALSE(check_per_joint());
+  EXPECT_FALSE(check_state_tolerance(state_error, arrays));
+
+  // not enforced tolerances are never violated
+  state_error.positions[n_joints - 1] = 0.0;
+  state_error.positions[0] = 1e3;
+  state_error.velocities[0] = std::numeric_limits<double>::max();
+  EXPECT_TRUE(check_per_joint());
+  EXPECT_TRUE(check_state_tolerance(state_error, arrays));
+
+  state_error.velocities[1] = -0.6;
+  EXPECT_FALSE(check_per_joint());
+  EXPECT_FALSE(check_state_tolerance(state_error, arrays));
+}
+
+TEST(TestTolerances, empty_errors_are_not_checked)
+{
+  std::vector<StateTolerances> state_tolerances(2);
+  for (auto & state_tolerance : state_tolerances)
+  {
+    state_tolerance.position = 0.1;
+    state_tolerance.velocity = 0.1;
+    state_tolerance.acceleration = 0.1;
+  }
+  JointTrajectoryPoint state_error;
+  state_error.positions = {0.05, -0.05};
+
+  EXPECT_TRUE(check_state_tolerance(state_error, to_state_tolerance_arrays(state_tolerances)));
+}
+
+TEST(TestTolerances, check_of_joints_ignores_the_other_joints)
+{
+  std::vector<StateTolerances> state_tolerances(4);
+  for (auto & state_tolerance : state_tolerances)
+  {
+    state_tolerance.position = 0.1;
+    state_tolerance.velocity = 0.2;
+  }
+  const auto arrays = to_state_tolerance_arrays(state_tolerances);
+  JointTrajectoryPoint state_error;
+  state_error.positions = {0.5, 0.05, 0.0, -0.5};
+  state_error.velocities = {0.0, 0.1, 0.0, 0.0};
+
+  EXPECT_FALSE(check_state_tolerance(state_error, arrays));
+  EXPECT_TRUE(check_state_tolerance_of_joints(state_error, arrays, {1, 2}));
+  EXPECT_FALSE(check_state_tolerance_of_joints(state_error, arrays, {2, 3}));
+
+  state_error.velocities[2] = 0.3;
+  EXPECT_FALSE(check_state_tolerance_of_joints(state_error, arrays, {1, 2}));
+  EXPECT_TRUE(check_state_tolerance_of_joints(state_error, arrays, {}));
+
+  // empty errors are not checked, as with check_state_tolerance()
+  state_error.velocities.clear();
+  EXPECT_TRUE(check_state_tolerance_of_joints(state_error, arrays, {1, 2}));
+}
+
+TEST(TestTolerances, goal_tolerances_override_the_defaults)
+{
+  const std::vector<std::string> joints = {"joint1", "joint2"};
+  SegmentTolerances default_tolerances(joints.size());
+  default_tolerances.goal_time_tolerance = 2.0;
+  default_tolerances.state_tolerance[0].position = 0.1;
+  default_tolerances.state_tolerance[1].position = 0.1;
+  default_tolerances.goal_state_tolerance[1].velocity = 0.01;
+
+  control_msgs::action::FollowJointTrajectory::Goal goal;
+  goal.path_tolerance.resize(2);
+  goal.path_tolerance[0].name = "joint2";
+  goal.path_tolerance[0].position = 0.2;
+  goal.path_tolerance[0].velocity = 0.5;
+  goal.path_tolerance[1].name = "joint1";
+  goal.path_tolerance[1].position = -1.0;
+  goal.goal_tolerance.resize(1);
+  goal.goal_tolerance[0].name = "joint2";
+  goal.goal_tolerance[0].position = 0.03;
+
+  SegmentTolerances tolerances;
+  ASSERT_TRUE(get_goal_segment_tolerances(default_tolerances, goal, joints, tolerances));
+  // -1 disables the default, zero keeps it
+  EXPECT_DOUBLE_EQ(tolerances.state_tolerance[0].position, 0.0);
+  EXPECT_DOUBLE_EQ(tolerances.state_tolerance[1].position, 0.2);
+  EXPECT_DOUBLE_EQ(tolerances.state_tolerance[1].velocity, 0.5);
+  EXPECT_DOUBLE_EQ(tolerances.goal_state_tolerance[1].position, 0.03);
+  EXPECT_DOUBLE_EQ(tolerances.goal_state_tolerance[1].velocity, 0.01);
+  EXPECT_DOUBLE_EQ(tolerances.goal_time_tolerance, 2.0);
+
+  goal.goal_time_tolerance = rclcpp::Duration::from_seconds(0.5);
+  ASSERT_TRUE(get_goal_segment_tolerances(default_tolerances, goal, joints, tolerances));
+  EXPECT_DOUBLE_EQ(tolerances.goal_time_tolerance, 0.5);
+}
+
+TEST(TestTolerances, invalid_goal_tolerances_are_rejected)
+{
+  const std::vector<std::string> joints = {"joint1", "joint2"};
+  SegmentTolerances default_tolerances(joints.size());
+  control_msgs::action::FollowJointTrajectory::Goal goal;
+  goal.goal_tolerance.resize(1);
+  goal.goal_tolerance[0].name = "joint3";
+
+  SegmentTolerances tolerances(1);
+  EXPECT_FALSE(get_goal_segment_tolerances(default_tolerances, goal, joints, tolerances));
+  EXPECT_EQ(tolerances.goal_state_tolerance.size(), 1u);
+
+  goal.goal_tolerance[0].name = "joint1";
+  goal.goal_tolerance[0].velocity = -0.5;
+  EXPECT_FALSE(get_goal_segment_tolerances(default_tolerances, goal, joints, tolerances));
+}
+
+TEST(TestTolerances, tracking_statistics_accumulate_the_errors)
+{
+  TrackingStatistics statistics;
+  statistics.configure(2);
+  JointTrajectoryPoint error;
+  error.positions = {0.3, -0.1};
+  error.velocities = {0.0, 0.2};
+  statistics.add(error, 1000000);
+  error.positions = {-0.4, 0.1};
+  error.velocities = {0.0, -0.4};
+  statistics.add(error, 3000000);
+  // missing velocity errors are not accumulated
+  error.velocities.clear();
+  error.positions = {0.0, 0.1};
+  statistics.add(error, 2000000);
+
+  EXPECT_EQ(statistics.num_updates(), 3u);
+  EXPECT_EQ(statistics.max_time_lag_ns(), 3000000);
+  EXPECT_DOUBLE_EQ(statistics.rms_position_error(0), std::sqrt(0.25 / 3.0));
+  EXPECT_DOUBLE_EQ(statistics.max_position_error(0), 0.4);
+  EXPECT_DOUBLE_EQ(statistics.rms_position_error(1), 0.1);
+  EXPECT_DOUBLE_EQ(statistics.max_position_error(1), 0.1);
+  EXPECT_DOUBLE_EQ(statistics.rms_velocity_error(1), std::sqrt(0.2 / 3.0));
+  EXPECT_DOUBLE_EQ(statistics.max_velocity_error(1), 0.4);
+  EXPECT_EQ(
+    statistics.summary({"joint1", "joint2"}),
+    "3 updates, max time lag 0.0030 s; "
+    "joint1: position error rms 0.288675 max 0.4, velocity error rms 0 max 0; "
+    "joint2: position error rms 0.1 max 0.1, velocity error rms 0.258199 max 0.4");
+
+  statistics.reset();
+  EXPECT_EQ(statistics.num_updates(), 0u);
+  EXPECT_DOUBLE_EQ(statistics.rms_position_error(0), 0.0);
+  EXPECT_DOUBLE_EQ(statistics.max_velocity_error(1), 0.0);
+}
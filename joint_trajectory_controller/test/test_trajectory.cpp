@@ -12,15 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <limits>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "gmock/gmock.h"
 
 #include "builtin_interfaces/msg/duration.hpp"
 #include "builtin_interfaces/msg/time.hpp"
+#include "joint_trajectory_controller/look_ahead.hpp"
 #include "joint_trajectory_controller/trajectory.hpp"
 #include "rclcpp/clock.hpp"
 #include "rclcpp/duration.hpp"
@@ -821,3 +825,553 @@ TEST(TestTrajectory, skip_interpolation)
     }
   }
 }
+
+TEST(TestTrajectory, sample_long_trajectory_with_time_jumps)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+
+  // point i is at position i+1 and reached (i+1) seconds after start
+  const size_t n_points = 1000;
+  for (size_t i = 0; i < n_points; ++i)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions.push_back(static_cast<double>(i + 1));
+    p.time_from_start = rclcpp::Duration::from_seconds(static_cast<double>(i + 1));
+    full_msg->points.push_back(p);
+  }
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.time_from_start = rclcpp::Duration::from_seconds(0.0);
+  point_before_msg.positions.push_back(0.0);
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+
+  auto sample_and_check = [&](double time_offset, size_t expected_segment)
+  {
+    ASSERT_TRUE(traj.sample(
+      time_now + rclcpp::Duration::from_seconds(time_offset), DEFAULT_INTERPOLATION,
+      expected_state, start, end));
+    ASSERT_EQ(traj.begin() + static_cast<std::ptrdiff_t>(expected_segment), start);
+    ASSERT_EQ(traj.begin() + static_cast<std::ptrdiff_t>(expected_segment + 1), end);
+    EXPECT_NEAR(time_offset, expected_state.positions[0], EPS);
+  };
+
+  // stepping forward segment by segment
+  for (size_t i = 0; i < 20; ++i)
+  {
+    sample_and_check(static_cast<double>(i) + 1.5, i);
+  }
+  // large jump forward
+  sample_and_check(800.25, 799);
+  // jump backwards
+  sample_and_check(10.75, 9);
+  sample_and_check(10.0, 9);
+  // exactly at the last segment
+  sample_and_check(999.5, 998);
+
+  // after the whole trajectory
+  ASSERT_TRUE(traj.sample(
+    time_now + rclcpp::Duration::from_seconds(1200.0), DEFAULT_INTERPOLATION, expected_state, start,
+    end));
+  ASSERT_EQ(--traj.end(), start);
+  ASSERT_EQ(traj.end(), end);
+  EXPECT_NEAR(static_cast<double>(n_points), expected_state.positions[0], EPS);
+
+  // and back into the trajectory
+  sample_and_check(2.5, 1);
+}
+
+TEST(TestTrajectory, sample_with_cached_segment_coefficients)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+
+  // segments of different degree: quintic, cubic and linear
+  trajectory_msgs::msg::JointTrajectoryPoint p1;
+  p1.positions = {1.0, -1.0};
+  p1.velocities = {0.5, -0.5};
+  p1.accelerations = {0.1, 0.2};
+  p1.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  full_msg->points.push_back(p1);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p2;
+  p2.positions = {2.0, -3.0};
+  p2.velocities = {1.0, 0.0};
+  p2.accelerations = {0.0, -0.3};
+  p2.time_from_start = rclcpp::Duration::from_seconds(2.0);
+  full_msg->points.push_back(p2);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p3;
+  p3.positions = {4.0, 1.0};
+  p3.velocities = {0.0, 0.0};
+  p3.time_from_start = rclcpp::Duration::from_seconds(4.0);
+  full_msg->points.push_back(p3);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p4;
+  p4.positions = {5.0, 2.0};
+  p4.time_from_start = rclcpp::Duration::from_seconds(5.0);
+  full_msg->points.push_back(p4);
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.time_from_start = rclcpp::Duration::from_seconds(0.0);
+  point_before_msg.positions = {0.0, 0.0};
+  point_before_msg.velocities = {0.0, 0.0};
+  point_before_msg.accelerations = {0.0, 0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+  // reference without any cached state
+  auto reference_traj = joint_trajectory_controller::Trajectory();
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  trajectory_msgs::msg::JointTrajectoryPoint reference_state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+
+  const std::vector<trajectory_msgs::msg::JointTrajectoryPoint> points = {
+    point_before_msg, p1, p2, p3, p4};
+  for (int k = 0; k < 50; ++k)
+  {
+    const double t = 0.1 * k;
+    const auto sample_time = time_now + rclcpp::Duration::from_seconds(t);
+    ASSERT_TRUE(traj.sample(sample_time, DEFAULT_INTERPOLATION, expected_state, start, end));
+
+    // index of the point ending the sampled segment
+    size_t seg = 0;
+    while (seg < points.size() - 1 &&
+           rclcpp::Duration(points[seg + 1].time_from_start).seconds() <= t)
+    {
+      ++seg;
+    }
+    reference_traj.interpolate_between_points(
+      time_now + points[seg].time_from_start, points[seg],
+      time_now + points[seg + 1].time_from_start, points[seg + 1], sample_time, reference_state);
+
+    for (size_t j = 0; j < 2; ++j)
+    {
+      EXPECT_NEAR(reference_state.positions[j], expected_state.positions[j], EPS);
+      EXPECT_NEAR(reference_state.velocities[j], expected_state.velocities[j], EPS);
+      EXPECT_NEAR(reference_state.accelerations[j], expected_state.accelerations[j], EPS);
+    }
+  }
+}
+
+TEST(TestTrajectory, sample_reuses_memory_of_output_state)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p1;
+  p1.positions = {1.0, 2.0, 3.0};
+  p1.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  full_msg->points.push_back(p1);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p2;
+  p2.positions = {2.0, 3.0, 4.0};
+  p2.time_from_start = rclcpp::Duration::from_seconds(2.0);
+  full_msg->points.push_back(p2);
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 0.0, 0.0};
+  point_before_msg.velocities = {0.0, 0.0, 0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  ASSERT_TRUE(traj.sample(
+    time_now + rclcpp::Duration::from_seconds(0.5), DEFAULT_INTERPOLATION, expected_state, start,
+    end));
+  const double * positions = expected_state.positions.data();
+  const double * velocities = expected_state.velocities.data();
+  const double * accelerations = expected_state.accelerations.data();
+
+  // before, within and after the trajectory
+  for (const double t : {0.7, 1.5, 2.5})
+  {
+    ASSERT_TRUE(traj.sample(
+      time_now + rclcpp::Duration::from_seconds(t), DEFAULT_INTERPOLATION, expected_state, start,
+      end));
+    ASSERT_EQ(expected_state.positions.size(), 3u);
+    EXPECT_EQ(expected_state.positions.data(), positions);
+    EXPECT_EQ(expected_state.velocities.data(), velocities);
+    EXPECT_EQ(expected_state.accelerations.data(), accelerations);
+  }
+  EXPECT_NEAR(expected_state.positions[0], 2.0, EPS);
+}
+
+TEST(TestTrajectory, sample_range_matches_single_samples)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p1;
+  p1.positions = {1.0, -1.0};
+  p1.velocities = {0.5, -0.5};
+  p1.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  full_msg->points.push_back(p1);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p2;
+  p2.positions = {2.0, -3.0};
+  p2.velocities = {0.0, 0.0};
+  p2.time_from_start = rclcpp::Duration::from_seconds(2.0);
+  full_msg->points.push_back(p2);
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 0.0};
+  point_before_msg.velocities = {0.0, 0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto range_traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+  auto single_traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  // before, within and after the trajectory
+  const auto period = rclcpp::Duration::from_seconds(0.1);
+  const size_t num_samples = 30;
+  joint_trajectory_controller::TrajectorySamples samples;
+  ASSERT_EQ(
+    range_traj.sample_range(time_now, period, num_samples, DEFAULT_INTERPOLATION, samples),
+    num_samples);
+  ASSERT_EQ(samples.num_samples, num_samples);
+  ASSERT_EQ(samples.dim, 2u);
+  ASSERT_EQ(samples.positions.size(), num_samples * 2);
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  for (size_t k = 0; k < num_samples; ++k)
+  {
+    ASSERT_TRUE(single_traj.sample(
+      time_now + period * static_cast<double>(k), DEFAULT_INTERPOLATION, expected_state, start,
+      end));
+    for (size_t j = 0; j < 2; ++j)
+    {
+      EXPECT_NEAR(samples.positions[k * 2 + j], expected_state.positions[j], EPS);
+      EXPECT_NEAR(samples.velocities[k * 2 + j], expected_state.velocities[j], EPS);
+      EXPECT_NEAR(samples.accelerations[k * 2 + j], expected_state.accelerations[j], EPS);
+    }
+  }
+
+  // the buffer is reused for the next range
+  const double * positions = samples.positions.data();
+  ASSERT_EQ(
+    range_traj.sample_range(time_now, period, num_samples, DEFAULT_INTERPOLATION, samples),
+    num_samples);
+  EXPECT_EQ(samples.positions.data(), positions);
+
+  // sampling before the point before the trajectory fails right away
+  EXPECT_EQ(
+    range_traj.sample_range(
+      time_now - rclcpp::Duration::from_seconds(1.0), period, num_samples, DEFAULT_INTERPOLATION,
+      samples),
+    0u);
+  EXPECT_EQ(samples.num_samples, 0u);
+  EXPECT_TRUE(samples.positions.empty());
+}
+
+TEST(TestTrajectory, sample_quintic_splines_from_sparse_waypoints)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+
+  // positions only, so the derivatives at the waypoints have to be completed
+  trajectory_msgs::msg::JointTrajectoryPoint p1;
+  p1.positions = {1.0};
+  p1.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  full_msg->points.push_back(p1);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p2;
+  p2.positions = {3.0};
+  p2.time_from_start = rclcpp::Duration::from_seconds(2.0);
+  full_msg->points.push_back(p2);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p3;
+  p3.positions = {2.0};
+  p3.time_from_start = rclcpp::Duration::from_seconds(3.0);
+  full_msg->points.push_back(p3);
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0};
+  point_before_msg.velocities = {0.0};
+  point_before_msg.accelerations = {0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  auto sample_at = [&](double t, InterpolationMethod method)
+  {
+    EXPECT_TRUE(traj.sample(
+      time_now + rclcpp::Duration::from_seconds(t), method, expected_state, start, end));
+  };
+
+  // waypoints are reached with the mean slope of the adjacent segments, or zero at extrema
+  const std::vector<std::array<double, 3>> knots = {{1.0, 1.0, 1.5}, {2.0, 3.0, 0.0}};
+  for (const auto & knot : knots)
+  {
+    sample_at(knot[0], InterpolationMethod::QUINTIC_SPLINE);
+    EXPECT_NEAR(knot[1], expected_state.positions[0], EPS);
+    EXPECT_NEAR(knot[2], expected_state.velocities[0], EPS);
+    EXPECT_NEAR(0.0, expected_state.accelerations[0], EPS);
+
+    // velocity and acceleration are continuous at the waypoint
+    sample_at(knot[0] - 1e-6, InterpolationMethod::QUINTIC_SPLINE);
+    EXPECT_NEAR(knot[2], expected_state.velocities[0], 1e-4);
+    EXPECT_NEAR(0.0, expected_state.accelerations[0], 1e-4);
+  }
+
+  // switching the method doesn't reuse the coefficients of the other one
+  sample_at(1.5, InterpolationMethod::QUINTIC_SPLINE);
+  const double quintic_velocity = expected_state.velocities[0];
+  sample_at(1.5, InterpolationMethod::VARIABLE_DEGREE_SPLINE);
+  EXPECT_NEAR(2.0, expected_state.velocities[0], EPS);
+  sample_at(1.5, InterpolationMethod::QUINTIC_SPLINE);
+  EXPECT_NEAR(quintic_velocity, expected_state.velocities[0], EPS);
+
+  // end of the trajectory
+  sample_at(3.5, InterpolationMethod::QUINTIC_SPLINE);
+  EXPECT_NEAR(2.0, expected_state.positions[0], EPS);
+  EXPECT_NEAR(0.0, expected_state.velocities[0], EPS);
+}
+
+TEST(TestTrajectory, sample_at_matches_sample_without_changing_the_trajectory)
+{
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = time_now;
+
+  trajectory_msgs::msg::JointTrajectoryPoint p1;
+  p1.positions = {1.0, -1.0};
+  p1.velocities = {0.5, -0.5};
+  p1.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  full_msg->points.push_back(p1);
+
+  // the positions are deduced from the velocities
+  trajectory_msgs::msg::JointTrajectoryPoint p2;
+  p2.velocities = {0.0, 0.0};
+  p2.time_from_start = rclcpp::Duration::from_seconds(2.0);
+  full_msg->points.push_back(p2);
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 0.0};
+  point_before_msg.velocities = {0.0, 0.0};
+
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+  const auto sample_time = [&time_now](double t)
+  { return time_now + rclcpp::Duration::from_seconds(t); };
+
+  trajectory_msgs::msg::JointTrajectoryPoint state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  // the missing positions are known only after the msg was completed
+  EXPECT_TRUE(traj.sample_at(sample_time(0.5), DEFAULT_INTERPOLATION, state, start, end));
+  EXPECT_FALSE(traj.sample_at(sample_time(1.5), DEFAULT_INTERPOLATION, state, start, end));
+  EXPECT_FALSE(traj.is_sampled_already());
+  EXPECT_TRUE(full_msg->points[1].positions.empty());
+  ASSERT_TRUE(joint_trajectory_controller::complete_trajectory_points(*full_msg));
+  EXPECT_THAT(full_msg->points[1].positions, ::testing::ElementsAre(1.25, -1.25));
+  EXPECT_TRUE(traj.sample_at(sample_time(1.5), DEFAULT_INTERPOLATION, state, start, end));
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  joint_trajectory_controller::TrajectoryPointConstIter expected_start, expected_end;
+  for (const auto method : {InterpolationMethod::VARIABLE_DEGREE_SPLINE,
+                            InterpolationMethod::QUINTIC_SPLINE, InterpolationMethod::NONE})
+  {
+    for (const double t : {0.0, 0.5, 1.0, 1.5, 2.5})
+    {
+      SCOPED_TRACE("t = " + std::to_string(t));
+      ASSERT_TRUE(
+        traj.sample(sample_time(t), method, expected_state, expected_start, expected_end));
+      ASSERT_TRUE(traj.sample_at(sample_time(t), method, state, start, end));
+      EXPECT_EQ(expected_start, start);
+      EXPECT_EQ(expected_end, end);
+      ASSERT_EQ(expected_state.positions.size(), state.positions.size());
+      ASSERT_EQ(expected_state.velocities.size(), state.velocities.size());
+      for (size_t j = 0; j < state.positions.size(); ++j)
+      {
+        EXPECT_NEAR(expected_state.positions[j], state.positions[j], EPS);
+      }
+      for (size_t j = 0; j < state.velocities.size(); ++j)
+      {
+        EXPECT_NEAR(expected_state.velocities[j], state.velocities[j], EPS);
+      }
+    }
+  }
+
+  // a copy is sampled the same way
+  const joint_trajectory_controller::Trajectory snapshot = traj;
+  ASSERT_TRUE(snapshot.sample_at(sample_time(1.5), DEFAULT_INTERPOLATION, state, start, end));
+  ASSERT_TRUE(traj.sample(sample_time(1.5), DEFAULT_INTERPOLATION, expected_state, start, end));
+  EXPECT_NEAR(expected_state.positions[0], state.positions[0], EPS);
+
+  // before the point before the trajectory
+  EXPECT_FALSE(traj.sample_at(sample_time(-1.0), DEFAULT_INTERPOLATION, state, start, end));
+}
+
+TEST(TestTrajectory, find_look_ahead_violation_of_samples)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+
+  trajectory_msgs::msg::JointTrajectoryPoint p1;
+  p1.positions = {1.0, -1.0};
+  p1.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  full_msg->points.push_back(p1);
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  // linear interpolation with 1 rad/s from 0.0 to 1.0 and -1.0
+  const auto period = rclcpp::Duration::from_seconds(0.1);
+  const size_t num_samples = 11;
+  joint_trajectory_controller::TrajectorySamples samples;
+  ASSERT_EQ(
+    traj.sample_range(time_now, period, num_samples, DEFAULT_INTERPOLATION, samples), num_samples);
+
+  const double INF = std::numeric_limits<double>::infinity();
+  joint_trajectory_controller::LookAheadLimits limits;
+  limits.min_position = {-INF, -INF};
+  limits.max_position = {INF, INF};
+  limits.max_velocity = {INF, INF};
+  EXPECT_EQ(joint_trajectory_controller::find_look_ahead_violation(samples, limits), num_samples);
+
+  // the second joint passes -0.55 at the 6th sample
+  limits.min_position[1] = -0.55;
+  EXPECT_EQ(joint_trajectory_controller::find_look_ahead_violation(samples, limits), 6u);
+
+  // the first joint is too fast right away
+  limits.max_velocity[0] = 0.5;
+  EXPECT_EQ(joint_trajectory_controller::find_look_ahead_violation(samples, limits), 0u);
+}
+
+TEST(TestTrajectory, cubic_spline_through_positions_is_continuous)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+  const std::vector<double> times = {0.5, 1.0, 1.7, 2.0, 3.0};
+  const std::vector<double> positions = {0.0, 1.0, 0.5, 2.0, 2.5};
+  for (size_t k = 0; k < times.size(); ++k)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint point;
+    point.positions = {positions[k], -positions[k]};
+    point.time_from_start = rclcpp::Duration::from_seconds(times[k]);
+    full_msg->points.push_back(point);
+  }
+
+  ASSERT_TRUE(joint_trajectory_controller::compute_cubic_spline_derivatives(*full_msg));
+  // the boundary conditions, and the waypoints are kept
+  EXPECT_NEAR(full_msg->points.front().accelerations[0], 0.0, EPS);
+  EXPECT_NEAR(full_msg->points.back().velocities[0], 0.0, EPS);
+  EXPECT_NEAR(full_msg->points[2].positions[0], 0.5, EPS);
+  // the joints are solved independently
+  EXPECT_NEAR(full_msg->points[2].velocities[1], -full_msg->points[2].velocities[0], EPS);
+  // the points are complete now
+  EXPECT_FALSE(joint_trajectory_controller::compute_cubic_spline_derivatives(*full_msg));
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 0.0};
+  point_before_msg.velocities = {0.0, 0.0};
+  point_before_msg.accelerations = {0.0, 0.0};
+  const rclcpp::Time time_now(0);
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  trajectory_msgs::msg::JointTrajectoryPoint before, after;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  for (size_t k = 1; k + 1 < times.size(); ++k)
+  {
+    const auto knot = time_now + rclcpp::Duration::from_seconds(times[k]);
+    const auto delta = rclcpp::Duration::from_nanoseconds(1000);
+    ASSERT_TRUE(traj.sample(knot - delta, DEFAULT_INTERPOLATION, before, start, end));
+    ASSERT_TRUE(traj.sample(knot + delta, DEFAULT_INTERPOLATION, after, start, end));
+    // velocity and acceleration are continuous at the waypoints
+    EXPECT_NEAR(before.positions[0], positions[k], 1e-4);
+    EXPECT_NEAR(before.velocities[0], after.velocities[0], 1e-3);
+    EXPECT_NEAR(before.accelerations[0], after.accelerations[0], 1e-3);
+  }
+
+  // a single point is no spline
+  auto single_point_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  single_point_msg->points.push_back(full_msg->points.front());
+  single_point_msg->points[0].velocities.clear();
+  single_point_msg->points[0].accelerations.clear();
+  EXPECT_FALSE(joint_trajectory_controller::compute_cubic_spline_derivatives(*single_point_msg));
+  EXPECT_TRUE(single_point_msg->points[0].velocities.empty());
+}
+
+TEST(TestTrajectory, compact_storage_samples_like_the_msg)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+  for (size_t k = 0; k < 50; ++k)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint point;
+    const double t = 0.1 * static_cast<double>(k + 1);
+    point.positions = {std::sin(t), 2.0 * std::cos(t)};
+    point.velocities = {std::cos(t), -2.0 * std::sin(t)};
+    point.time_from_start = rclcpp::Duration::from_seconds(t);
+    full_msg->points.push_back(point);
+  }
+  using joint_trajectory_controller::CompactTrajectoryStorage;
+  using joint_trajectory_controller::CompactValueType;
+  const auto storage = CompactTrajectoryStorage::build(*full_msg, CompactValueType::FLOAT64);
+  ASSERT_TRUE(storage);
+  EXPECT_EQ(storage->size(), 50u);
+  EXPECT_EQ(storage->dim(), 2u);
+  EXPECT_TRUE(storage->has_velocities());
+  EXPECT_FALSE(storage->has_accelerations());
+  const auto float_storage = CompactTrajectoryStorage::build(*full_msg, CompactValueType::FLOAT32);
+  ASSERT_TRUE(float_storage);
+  EXPECT_LT(float_storage->memory_size(), storage->memory_size());
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 2.0};
+  point_before_msg.velocities = {1.0, 0.0};
+  const rclcpp::Time time_now(0);
+  auto msg_traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+  auto compact_traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+  auto float_traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+  compact_traj.set_compact_storage(storage);
+  float_traj.set_compact_storage(float_storage);
+  EXPECT_EQ(compact_traj.get_compact_storage(), storage);
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected, compact, rounded;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end, compact_start, compact_end;
+  // before, within and after the trajectory
+  for (int64_t time_ns = 0; time_ns < 5500000000; time_ns += 7000000)
+  {
+    const rclcpp::Time sample_time = time_now + rclcpp::Duration::from_nanoseconds(time_ns);
+    ASSERT_TRUE(msg_traj.sample(sample_time, DEFAULT_INTERPOLATION, expected, start, end));
+    ASSERT_TRUE(compact_traj.sample(
+      sample_time, DEFAULT_INTERPOLATION, compact, compact_start, compact_end));
+    ASSERT_TRUE(float_traj.sample(sample_time, DEFAULT_INTERPOLATION, rounded, start, end));
+    EXPECT_EQ(compact_start, start);
+    EXPECT_EQ(compact_end, end);
+    for (size_t j = 0; j < 2; ++j)
+    {
+      EXPECT_DOUBLE_EQ(compact.positions[j], expected.positions[j]);
+      EXPECT_DOUBLE_EQ(compact.velocities[j], expected.velocities[j]);
+      EXPECT_NEAR(rounded.positions[j], expected.positions[j], 1e-6);
+      EXPECT_NEAR(rounded.velocities[j], expected.velocities[j], 1e-4);
+    }
+  }
+
+  // a new msg releases the storage, which belongs to the previous one
+  compact_traj.update(full_msg);
+  EXPECT_FALSE(compact_traj.get_compact_storage());
+
+  // incomplete msgs and storages of other msgs are not used
+  auto partial_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*full_msg);
+  partial_msg->points[10].velocities.clear();
+  EXPECT_FALSE(CompactTrajectoryStorage::build(*partial_msg, CompactValueType::FLOAT64));
+  partial_msg->points.pop_back();
+  compact_traj.update(partial_msg);
+  compact_traj.set_compact_storage(storage);
+  EXPECT_FALSE(compact_traj.get_compact_storage());
+}
@@ -16,6 +16,7 @@
 #include <cxxabi.h>
 #endif
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <future>
@@ -30,6 +31,7 @@
 #include "action_msgs/msg/goal_status_array.hpp"
 #include "control_msgs/action/detail/follow_joint_trajectory__struct.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "hardware_interface/resource_manager.hpp"
 #include "joint_trajectory_controller/joint_trajectory_controller.hpp"
@@ -430,6 +432,107 @@ TEST_F(TestTrajectoryActions, test_goal_tolerances_single_point_success)
   expectCommandPoint(points_positions.at(0));
 }
 
+TEST_F(TestTrajectoryActions, test_decimated_feedback)
+{
+  // feedback would be sent with action_monitor_rate (20 Hz) otherwise
+  std::vector<rclcpp::Parameter> params = {rclcpp::Parameter("action_feedback_rate", 2.0)};
+
+  std::atomic<int> feedback_count{0};
+  goal_options_.feedback_callback =
+    [&](GoalHandle::SharedPtr, const std::shared_ptr<const FollowJointTrajectoryMsg::Feedback>)
+  { ++feedback_count; };
+
+  SetUpExecutor(params);
+  SetUpControllerHardware();
+
+  std::shared_future<typename GoalHandle::SharedPtr> gh_future;
+  // send goal
+  {
+    std::vector<JointTrajectoryPoint> points;
+    JointTrajectoryPoint point;
+    point.time_from_start = rclcpp::Duration::from_seconds(1.0);
+    point.positions = {1.0, 2.0, 3.0};
+    points.push_back(point);
+
+    gh_future = sendActionGoal(points, 1.0, goal_options_);
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, common_resultcode_);
+  EXPECT_GE(feedback_count, 1);
+  EXPECT_LE(feedback_count, 4);
+}
+
+TEST_F(TestTrajectoryActions, test_result_is_sent_before_the_monitor_period)
+{
+  // the first monitor period of 5 s ends after the hardware loop of 2 s
+  std::vector<rclcpp::Parameter> params = {rclcpp::Parameter("action_monitor_rate", 0.2)};
+
+  std::atomic<bool> result_received{false};
+  goal_options_.result_callback = [&](const GoalHandle::WrappedResult & result)
+  {
+    common_result_response(result);
+    result_received = true;
+  };
+
+  SetUpExecutor(params);
+  SetUpControllerHardware();
+
+  std::shared_future<typename GoalHandle::SharedPtr> gh_future;
+  // send goal
+  {
+    std::vector<JointTrajectoryPoint> points;
+    JointTrajectoryPoint point;
+    point.time_from_start = rclcpp::Duration::from_seconds(0.2);
+    point.positions = {1.0, 2.0, 3.0};
+    points.push_back(point);
+
+    gh_future = sendActionGoal(points, 1.0, goal_options_);
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_future.get());
+  EXPECT_TRUE(result_received);
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, common_resultcode_);
+}
+
+TEST_F(TestTrajectoryActions, test_tracking_statistics_are_returned_in_the_result)
+{
+  std::vector<rclcpp::Parameter> params = {rclcpp::Parameter("goal_tracking_statistics", true)};
+
+  std::string error_string;
+  goal_options_.result_callback = [&](const GoalHandle::WrappedResult & result)
+  {
+    common_result_response(result);
+    error_string = result.result->error_string;
+  };
+
+  SetUpExecutor(params);
+  SetUpControllerHardware();
+
+  std::shared_future<typename GoalHandle::SharedPtr> gh_future;
+  // send goal
+  {
+    std::vector<JointTrajectoryPoint> points;
+    JointTrajectoryPoint point;
+    point.time_from_start = rclcpp::Duration::from_seconds(0.2);
+    point.positions = {1.0, 2.0, 3.0};
+    points.push_back(point);
+
+    gh_future = sendActionGoal(points, 1.0, goal_options_);
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, common_resultcode_);
+  EXPECT_THAT(error_string, testing::HasSubstr(" updates, max time lag "));
+  for (const auto & joint_name : joint_names_)
+  {
+    EXPECT_THAT(error_string, testing::HasSubstr("; " + joint_name + ": position error rms "));
+  }
+}
+
 /**
  * Makes sense with position command interface only,
  * because no integration to position state interface is implemented
@@ -489,6 +592,108 @@ TEST_F(TestTrajectoryActions, test_goal_tolerances_multi_point_success)
   expectCommandPoint(points_positions.at(1));
 }
 
+TEST_F(TestTrajectoryActions, test_queued_goal_follows_the_active_goal)
+{
+  std::vector<rclcpp::Parameter> params = {rclcpp::Parameter("queue_goals", true)};
+  SetUpExecutor(params);
+  SetUpControllerHardware();
+
+  // the first goal succeeds instead of being preempted by the second
+  std::atomic<rclcpp_action::ResultCode> first_resultcode{rclcpp_action::ResultCode::UNKNOWN};
+  GoalOptions first_goal_options;
+  first_goal_options.result_callback = [&](const GoalHandle::WrappedResult & result)
+  { first_resultcode = result.code; };
+
+  std::shared_future<typename GoalHandle::SharedPtr> first_gh_future;
+  std::shared_future<typename GoalHandle::SharedPtr> second_gh_future;
+  const std::vector<double> second_positions{2.0, 3.0, 4.0};
+  {
+    std::vector<JointTrajectoryPoint> points(1);
+    points[0].time_from_start = rclcpp::Duration::from_seconds(0.5);
+    points[0].positions = {1.0, 2.0, 3.0};
+    first_gh_future = sendActionGoal(points, 1.0, first_goal_options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    points[0].positions = second_positions;
+    second_gh_future = sendActionGoal(points, 1.0, goal_options_);
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(first_gh_future.get());
+  EXPECT_TRUE(second_gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, first_resultcode.load());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, common_resultcode_);
+  EXPECT_EQ(
+    control_msgs::action::FollowJointTrajectory_Result::SUCCESSFUL, common_action_result_code_);
+
+  // run an update
+  updateControllerAsync(rclcpp::Duration::from_seconds(0.01));
+
+  // it should be holding the last position of the queued goal
+  expectCommandPoint(second_positions);
+}
+
+TEST_F(TestTrajectoryActions, test_goals_of_joint_groups_run_side_by_side)
+{
+  std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("joint_groups", std::vector<std::string>{"arm", "tool"}),
+    rclcpp::Parameter("groups.arm.joints", std::vector<std::string>{"joint1", "joint2"}),
+    rclcpp::Parameter("groups.tool.joints", std::vector<std::string>{"joint3"})};
+  SetUpExecutor(params);
+  SetUpControllerHardware();
+
+  auto create_group_client = [&](const std::string & group)
+  {
+    auto client = rclcpp_action::create_client<FollowJointTrajectoryMsg>(
+      node_->get_node_base_interface(), node_->get_node_graph_interface(),
+      node_->get_node_logging_interface(), node_->get_node_waitables_interface(),
+      controller_name_ + "/" + group + "/follow_joint_trajectory");
+    EXPECT_TRUE(client->wait_for_action_server(std::chrono::seconds(1)));
+    return client;
+  };
+  auto arm_client = create_group_client("arm");
+  auto tool_client = create_group_client("tool");
+
+  // the goal of the tool is neither preempted by nor preempts the goal of the arm
+  std::atomic<rclcpp_action::ResultCode> arm_resultcode{rclcpp_action::ResultCode::UNKNOWN};
+  std::atomic<rclcpp_action::ResultCode> tool_resultcode{rclcpp_action::ResultCode::UNKNOWN};
+  GoalOptions arm_goal_options;
+  arm_goal_options.result_callback = [&](const GoalHandle::WrappedResult & result)
+  { arm_resultcode = result.code; };
+  GoalOptions tool_goal_options;
+  tool_goal_options.result_callback = [&](const GoalHandle::WrappedResult & result)
+  { tool_resultcode = result.code; };
+
+  FollowJointTrajectoryMsg::Goal arm_goal;
+  arm_goal.goal_time_tolerance = rclcpp::Duration::from_seconds(1.0);
+  arm_goal.trajectory.joint_names = {"joint1", "joint2"};
+  arm_goal.trajectory.points.resize(1);
+  arm_goal.trajectory.points[0].time_from_start = rclcpp::Duration::from_seconds(0.5);
+  arm_goal.trajectory.points[0].positions = {1.0, 2.0};
+  auto arm_gh_future = arm_client->async_send_goal(arm_goal, arm_goal_options);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  FollowJointTrajectoryMsg::Goal tool_goal;
+  tool_goal.goal_time_tolerance = rclcpp::Duration::from_seconds(1.0);
+  tool_goal.trajectory.joint_names = {"joint3"};
+  tool_goal.trajectory.points.resize(1);
+  tool_goal.trajectory.points[0].time_from_start = rclcpp::Duration::from_seconds(0.5);
+  tool_goal.trajectory.points[0].positions = {3.0};
+  auto tool_gh_future = tool_client->async_send_goal(tool_goal, tool_goal_options);
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(arm_gh_future.get());
+  EXPECT_TRUE(tool_gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, arm_resultcode.load());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, tool_resultcode.load());
+
+  // run an update
+  updateControllerAsync(rclcpp::Duration::from_seconds(0.01));
+
+  // it should be holding the last positions of both groups
+  expectCommandPoint({1.0, 2.0, 3.0});
+}
+
 TEST_P(TestTrajectoryActionsTestParameterized, test_state_tolerances_fail)
 {
   // set joint tolerance parameters
@@ -540,6 +745,48 @@ TEST_P(TestTrajectoryActionsTestParameterized, test_state_tolerances_fail)
   expectCommandPoint(INITIAL_POS_JOINTS);
 }
 
+TEST_P(TestTrajectoryActionsTestParameterized, test_state_tolerances_of_goal_fail)
+{
+  // no tolerance parameters, the tolerances of the goal are checked
+  // separate command from states -> immediate state tolerance fail
+  bool separate_cmd_and_state_values = true;
+  SetUpExecutor({}, separate_cmd_and_state_values);
+  SetUpControllerHardware();
+
+  std::shared_future<typename GoalHandle::SharedPtr> gh_future;
+  // send goal
+  {
+    control_msgs::action::FollowJointTrajectory_Goal goal_msg;
+    goal_msg.goal_time_tolerance = rclcpp::Duration::from_seconds(1.0);
+    goal_msg.trajectory.joint_names = joint_names_;
+    goal_msg.path_tolerance.resize(1);
+    goal_msg.path_tolerance[0].name = joint_names_[1];
+    goal_msg.path_tolerance[0].position = 0.0001;
+
+    JointTrajectoryPoint point1;
+    point1.time_from_start = rclcpp::Duration::from_seconds(0.0);
+    point1.positions = {4.0, 5.0, 6.0};
+    goal_msg.trajectory.points.push_back(point1);
+
+    JointTrajectoryPoint point2;
+    point2.time_from_start = rclcpp::Duration::from_seconds(0.1);
+    point2.positions = {7.0, 8.0, 9.0};
+    goal_msg.trajectory.points.push_back(point2);
+
+    gh_future = action_client_->async_send_goal(goal_msg, goal_options_);
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::ABORTED, common_resultcode_);
+  EXPECT_EQ(
+    control_msgs::action::FollowJointTrajectory_Result::PATH_TOLERANCE_VIOLATED,
+    common_action_result_code_);
+
+  // the tolerances of the goal are not kept for the following trajectories
+  EXPECT_DOUBLE_EQ(traj_controller_->get_tolerances().state_tolerance[1].position, 0.0);
+}
+
 TEST_P(TestTrajectoryActionsTestParameterized, test_goal_tolerances_fail)
 {
   // set joint tolerance parameters
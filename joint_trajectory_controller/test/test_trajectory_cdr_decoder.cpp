@@ -0,0 +1,176 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "joint_trajectory_controller/trajectory_cdr_decoder.hpp"
+#include "joint_trajectory_controller/trajectory_recorder.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+using joint_trajectory_controller::CdrDecodeResult;
+using joint_trajectory_controller::serialize_record_payload;
+using joint_trajectory_controller::TrajectoryCdrDecoder;
+using joint_trajectory_controller::TrajectoryDecodeOptions;
+using trajectory_msgs::msg::JointTrajectory;
+using trajectory_msgs::msg::JointTrajectoryPoint;
+
+namespace
+{
+JointTrajectoryPoint make_point(
+  const std::vector<double> & positions, const std::vector<double> & velocities, int32_t sec)
+{
+  JointTrajectoryPoint point;
+  point.positions = positions;
+  point.velocities = velocities;
+  point.time_from_start.sec = sec;
+  return point;
+}
+}  // namespace
+
+class TestTrajectoryCdrDecoder : public ::testing::Test
+{
+protected:
+  CdrDecodeResult decode(const JointTrajectory & msg)
+  {
+    return decode(serialize_record_payload(msg));
+  }
+
+  CdrDecodeResult decode(const std::vector<uint8_t> & payload)
+  {
+    decoded_ = JointTrajectory();
+    error_.clear();
+    return decoder_.decode(payload.data(), payload.size(), options_, decoded_, error_);
+  }
+
+  TrajectoryCdrDecoder decoder_{{"joint1", "joint2", "joint3"}};
+  TrajectoryDecodeOptions options_;
+  JointTrajectory decoded_;
+  std::string error_;
+};
+
+TEST_F(TestTrajectoryCdrDecoder, decodes_in_local_joint_order)
+{
+  JointTrajectory msg;
+  msg.header.frame_id = "base";
+  msg.joint_names = {"joint3", "joint1", "joint2"};
+  msg.points.push_back(make_point({3.0, 1.0, 2.0}, {0.3, 0.1, 0.2}, 1));
+  msg.points.push_back(make_point({6.0, 4.0, 5.0}, {}, 2));
+  msg.points[1].time_from_start.nanosec = 500000000;
+
+  ASSERT_EQ(decode(msg), CdrDecodeResult::DECODED) << error_;
+  EXPECT_EQ(decoded_.header.frame_id, "base");
+  EXPECT_THAT(decoded_.joint_names, testing::ElementsAre("joint1", "joint2", "joint3"));
+  ASSERT_EQ(decoded_.points.size(), 2u);
+  EXPECT_THAT(decoded_.points[0].positions, testing::ElementsAre(1.0, 2.0, 3.0));
+  EXPECT_THAT(decoded_.points[0].velocities, testing::ElementsAre(0.1, 0.2, 0.3));
+  EXPECT_TRUE(decoded_.points[0].accelerations.empty());
+  EXPECT_THAT(decoded_.points[1].positions, testing::ElementsAre(4.0, 5.0, 6.0));
+  EXPECT_TRUE(decoded_.points[1].velocities.empty());
+  EXPECT_EQ(decoded_.points[1].time_from_start.sec, 2);
+  EXPECT_EQ(decoded_.points[1].time_from_start.nanosec, 500000000u);
+}
+
+TEST_F(TestTrajectoryCdrDecoder, fills_the_joints_missing_in_partial_goals)
+{
+  JointTrajectory msg;
+  msg.joint_names = {"joint2"};
+  msg.points.push_back(make_point({2.0}, {0.2}, 1));
+  msg.points.push_back(make_point({2.5}, {0.0}, 2));
+
+  EXPECT_EQ(decode(msg), CdrDecodeResult::INVALID);
+  options_.allow_partial_joints_goal = true;
+  const std::vector<double> hold_positions = {-1.0, -2.0, -3.0};
+  options_.partial_goal_positions = &hold_positions;
+  ASSERT_EQ(decode(msg), CdrDecodeResult::DECODED) << error_;
+  EXPECT_THAT(decoded_.points[0].positions, testing::ElementsAre(-1.0, 2.0, -3.0));
+  EXPECT_THAT(decoded_.points[0].velocities, testing::ElementsAre(0.0, 0.2, 0.0));
+
+  options_.partial_goal_positions = nullptr;
+  ASSERT_EQ(decode(msg), CdrDecodeResult::DECODED) << error_;
+  EXPECT_TRUE(std::isnan(decoded_.points[0].positions[0]));
+}
+
+TEST_F(TestTrajectoryCdrDecoder, rejects_what_the_topic_callback_rejects)
+{
+  JointTrajectory msg;
+  msg.joint_names = {"joint1", "joint2", "joint3"};
+  msg.points.push_back(make_point({1.0, 2.0, 3.0}, {}, 1));
+  ASSERT_EQ(decode(msg), CdrDecodeResult::DECODED) << error_;
+
+  auto unknown_joint = msg;
+  unknown_joint.joint_names[1] = "joint4";
+  EXPECT_EQ(decode(unknown_joint), CdrDecodeResult::INVALID);
+  EXPECT_THAT(error_, testing::HasSubstr("joint4"));
+
+  auto duplicate_joint = msg;
+  duplicate_joint.joint_names[1] = "joint1";
+  EXPECT_EQ(decode(duplicate_joint), CdrDecodeResult::INVALID);
+
+  auto wrong_size = msg;
+  wrong_size.points[0].positions.pop_back();
+  EXPECT_EQ(decode(wrong_size), CdrDecodeResult::INVALID);
+  EXPECT_THAT(error_, testing::HasSubstr("Mismatch between joint_names size (3) and positions"));
+
+  auto not_increasing = msg;
+  not_increasing.points.push_back(not_increasing.points[0]);
+  EXPECT_EQ(decode(not_increasing), CdrDecodeResult::INVALID);
+
+  auto with_effort = msg;
+  with_effort.points[0].effort = {0.0, 0.0, 0.0};
+  EXPECT_EQ(decode(with_effort), CdrDecodeResult::INVALID);
+
+  auto moving_at_end = msg;
+  moving_at_end.points[0].velocities = {0.0, 0.1, 0.0};
+  EXPECT_EQ(decode(moving_at_end), CdrDecodeResult::INVALID);
+  EXPECT_THAT(error_, testing::HasSubstr("joint2"));
+  options_.allow_nonzero_velocity_at_trajectory_end = true;
+  EXPECT_EQ(decode(moving_at_end), CdrDecodeResult::DECODED) << error_;
+
+  auto in_the_past = msg;
+  in_the_past.header.stamp.sec = 10;
+  options_.now_ns = 12000000000;
+  EXPECT_EQ(decode(in_the_past), CdrDecodeResult::INVALID);
+  options_.now_ns = 10500000000;
+  EXPECT_EQ(decode(in_the_past), CdrDecodeResult::DECODED) << error_;
+
+  auto only_velocities = msg;
+  only_velocities.points[0].positions.clear();
+  only_velocities.points[0].velocities = {0.0, 0.0, 0.0};
+  EXPECT_EQ(decode(only_velocities), CdrDecodeResult::INVALID);
+  options_.allow_integration_in_goal_trajectories = true;
+  EXPECT_EQ(decode(only_velocities), CdrDecodeResult::DECODED) << error_;
+}
+
+TEST_F(TestTrajectoryCdrDecoder, rejects_truncated_and_unsupported_payloads)
+{
+  JointTrajectory msg;
+  msg.joint_names = {"joint1", "joint2", "joint3"};
+  msg.points.push_back(make_point({1.0, 2.0, 3.0}, {}, 1));
+  const auto payload = serialize_record_payload(msg);
+
+  for (size_t size = 0; size < payload.size(); ++size)
+  {
+    EXPECT_EQ(
+      decode(std::vector<uint8_t>(payload.begin(), payload.begin() + static_cast<long>(size))),
+      CdrDecodeResult::INVALID);
+  }
+
+  auto parameter_list = payload;
+  parameter_list[1] = 0x03;  // PL_CDR_LE
+  EXPECT_EQ(decode(parameter_list), CdrDecodeResult::UNSUPPORTED);
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <stddef.h>
+#include <unistd.h>
 
 #include <array>
 #include <chrono>
@@ -26,6 +27,7 @@
 #include <thread>
 #include <vector>
 
+#include "bounded_controller_state_msgs/msg/bounded_joint_trajectory_controller_state.hpp"
 #include "builtin_interfaces/msg/duration.hpp"
 #include "builtin_interfaces/msg/time.hpp"
 #include "controller_interface/controller_interface.hpp"
@@ -46,7 +48,10 @@
 #include "rclcpp/utilities.hpp"
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
 #include "rclcpp_lifecycle/state.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "shm_command_ingress/shm_command_ring.hpp"
 #include "std_msgs/msg/header.hpp"
+#include "trajectory_horizon_exchange/trajectory_horizon_exchange.hpp"
 #include "trajectory_msgs/msg/joint_trajectory.hpp"
 #include "trajectory_msgs/msg/joint_trajectory_point.hpp"
 
@@ -355,6 +360,80 @@ TEST_P(TrajectoryControllerTestParameterized, state_topic_consistency)
   }
 }
 
+/**
+ * @brief check if the controller state is published with the configured rate only
+ */
+TEST_P(TrajectoryControllerTestParameterized, state_publish_rate)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, {rclcpp::Parameter("state_publish_rate", 10.0)});
+
+  using control_msgs::msg::JointTrajectoryControllerState;
+  size_t received_states = 0;
+  auto subscription =
+    traj_controller_->get_node()->create_subscription<JointTrajectoryControllerState>(
+      controller_name_ + "/controller_state", rclcpp::SystemDefaultsQoS().keep_last(100),
+      [&](const std::shared_ptr<JointTrajectoryControllerState>) { ++received_states; });
+
+  // 1 s of updates with 100 Hz
+  updateControllerAsync(rclcpp::Duration::from_seconds(1.0));
+  for (int i = 0; i < 10; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    executor.spin_some();
+  }
+
+  EXPECT_GE(received_states, 1u);
+  EXPECT_LE(received_states, 11u);
+}
+
+/**
+ * @brief check if the bounded controller state is published along with its joint names
+ */
+TEST_P(TrajectoryControllerTestParameterized, bounded_controller_state)
+{
+  using bounded_controller_state_msgs::msg::BoundedJointTrajectoryControllerState;
+  rclcpp::executors::SingleThreadedExecutor executor;
+  std::shared_ptr<sensor_msgs::msg::JointState> names_msg;
+  std::shared_ptr<BoundedJointTrajectoryControllerState> state;
+  SetUpAndActivateTrajectoryController(
+    executor, {rclcpp::Parameter("bounded_controller_state.enable", true)});
+  // the names were published once on configuration, a late subscriber still receives them
+  auto names_subscription =
+    traj_controller_->get_node()->create_subscription<sensor_msgs::msg::JointState>(
+      controller_name_ + "/bounded_controller_state/names",
+      rclcpp::QoS(1).reliable().transient_local(),
+      [&](const std::shared_ptr<sensor_msgs::msg::JointState> msg) { names_msg = msg; });
+  auto subscription =
+    traj_controller_->get_node()->create_subscription<BoundedJointTrajectoryControllerState>(
+      controller_name_ + "/bounded_controller_state", rclcpp::SystemDefaultsQoS(),
+      [&](const std::shared_ptr<BoundedJointTrajectoryControllerState> msg) { state = msg; });
+
+  for (int i = 0; i < 10 && (!names_msg || !state); ++i)
+  {
+    updateController(rclcpp::Duration::from_seconds(0.01));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    executor.spin_some();
+  }
+  ASSERT_TRUE(names_msg);
+  EXPECT_EQ(names_msg->name, joint_names_);
+  ASSERT_TRUE(state);
+  ASSERT_EQ(state->size, joint_names_.size());
+
+  const bool has_velocity_state =
+    std::find(state_interface_types_.begin(), state_interface_types_.end(), "velocity") !=
+    state_interface_types_.end();
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    SCOPED_TRACE("Joint " + std::to_string(i));
+    EXPECT_EQ(state->feedback_positions[i], INITIAL_POS_JOINTS[i]);
+    EXPECT_EQ(state->error_positions[i], 0.0);
+    // values of interfaces the controller doesn't have are NaN
+    EXPECT_EQ(std::isnan(state->feedback_velocities[i]), !has_velocity_state);
+  }
+}
+
 /**
  * @brief check if dynamic parameters are updated
  */
@@ -365,27 +444,26 @@ TEST_P(TrajectoryControllerTestParameterized, update_dynamic_parameters)
   SetUpAndActivateTrajectoryController(executor);
 
   updateControllerAsync();
-  auto pids = traj_controller_->get_pids();
+  const auto & pid_bank = traj_controller_->get_pid_bank();
 
   if (traj_controller_->use_closed_loop_pid_adapter())
   {
-    EXPECT_EQ(pids.size(), 3);
-    auto gain_0 = pids.at(0)->getGains();
-    EXPECT_EQ(gain_0.p_gain_, 0.0);
+    EXPECT_EQ(pid_bank.size(), 3);
+    auto gain_0 = pid_bank.get_gains(0);
+    EXPECT_EQ(gain_0.p, 0.0);
 
     double kp = 1.0;
     SetPidParameters(kp);
     updateControllerAsync();
 
-    pids = traj_controller_->get_pids();
-    EXPECT_EQ(pids.size(), 3);
-    gain_0 = pids.at(0)->getGains();
-    EXPECT_EQ(gain_0.p_gain_, kp);
+    EXPECT_EQ(pid_bank.size(), 3);
+    gain_0 = pid_bank.get_gains(0);
+    EXPECT_EQ(gain_0.p, kp);
   }
   else
   {
     // nothing to check here, skip further test
-    EXPECT_EQ(pids.size(), 0);
+    EXPECT_EQ(pid_bank.size(), 0);
   }
 
   executor.cancel();
@@ -1294,6 +1372,105 @@ TEST_P(TrajectoryControllerTestParameterized, missing_positions_message_accepted
   EXPECT_FALSE(traj_controller_->validate_trajectory_msg(traj_msg));
 }
 
+/**
+ * @brief check that the pending part of the current trajectory is kept up to the new start time
+ */
+TEST_P(TrajectoryControllerTestParameterized, test_splice_trajectory)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, {rclcpp::Parameter("splice_incoming_trajectories", true)});
+
+  auto make_msg = [&](const rclcpp::Time & start, const std::vector<double> & times_from_start)
+  {
+    auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+    msg->header.stamp = start;
+    msg->joint_names = joint_names_;
+    for (const auto time_from_start : times_from_start)
+    {
+      trajectory_msgs::msg::JointTrajectoryPoint point;
+      point.time_from_start = rclcpp::Duration::from_seconds(time_from_start);
+      point.positions = {time_from_start, time_from_start, time_from_start};
+      msg->points.push_back(point);
+    }
+    return msg;
+  };
+  auto times_from_start = [](const trajectory_msgs::msg::JointTrajectory & msg)
+  {
+    std::vector<double> times;
+    for (const auto & point : msg.points)
+    {
+      times.push_back(rclcpp::Duration(point.time_from_start).seconds());
+    }
+    return times;
+  };
+
+  const rclcpp::Time now = traj_controller_->get_node()->now();
+  const auto current_msg =
+    make_msg(now - rclcpp::Duration::from_seconds(1.0), {0.5, 2.0, 3.0, 4.0});
+  traj_controller_->add_new_trajectory_msg(current_msg);
+
+  // the first point is passed already, the last one is after the start of the new trajectory
+  auto spliced_msg = traj_controller_->splice_trajectory_msg(
+    make_msg(now + rclcpp::Duration::from_seconds(2.5), {0.5, 1.0}));
+  EXPECT_EQ(rclcpp::Time(spliced_msg->header.stamp), rclcpp::Time(current_msg->header.stamp));
+  EXPECT_THAT(
+    times_from_start(*spliced_msg),
+    testing::Pointwise(testing::DoubleNear(COMMON_THRESHOLD), {2.0, 3.0, 4.0, 4.5}));
+  EXPECT_DOUBLE_EQ(spliced_msg->points[1].positions[0], 3.0);
+  EXPECT_DOUBLE_EQ(spliced_msg->points[2].positions[0], 0.5);
+
+  // nothing to keep if the new trajectory starts before the next point of the current one
+  auto new_msg = make_msg(now + rclcpp::Duration::from_seconds(0.5), {0.5, 1.0});
+  EXPECT_EQ(traj_controller_->splice_trajectory_msg(new_msg), new_msg);
+
+  // the trajectory is replaced if it has to start now
+  new_msg = make_msg(rclcpp::Time(0, 0, RCL_ROS_TIME), {0.5, 1.0});
+  EXPECT_EQ(traj_controller_->splice_trajectory_msg(new_msg), new_msg);
+
+  executor.cancel();
+}
+
+/**
+ * @brief test_speed_scaling_initial_factor Test that the trajectory time is scaled
+ */
+TEST_P(TrajectoryControllerTestParameterized, test_speed_scaling_initial_factor)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, {rclcpp::Parameter("speed_scaling.initial_factor", 0.5)});
+
+  // starts when sampled the first time
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->joint_names = joint_names_;
+  trajectory_msgs::msg::JointTrajectoryPoint point;
+  point.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  for (const auto initial_position : INITIAL_POS_JOINTS)
+  {
+    point.positions.push_back(initial_position + 1.0);
+  }
+  msg->points.push_back(point);
+  traj_controller_->add_new_trajectory_msg(msg);
+
+  // half of the trajectory time passed after one second
+  auto end_time = updateControllerAsync(rclcpp::Duration::from_seconds(1.0));
+  auto state_reference = traj_controller_->get_state_reference();
+  for (size_t i = 0; i < INITIAL_POS_JOINTS.size(); ++i)
+  {
+    EXPECT_NEAR(INITIAL_POS_JOINTS[i] + 0.5, state_reference.positions[i], COMMON_THRESHOLD);
+  }
+
+  // the end is reached after two seconds
+  updateControllerAsync(rclcpp::Duration::from_seconds(1.1), end_time);
+  state_reference = traj_controller_->get_state_reference();
+  for (size_t i = 0; i < INITIAL_POS_JOINTS.size(); ++i)
+  {
+    EXPECT_NEAR(INITIAL_POS_JOINTS[i] + 1.0, state_reference.positions[i], COMMON_THRESHOLD);
+  }
+
+  executor.cancel();
+}
+
 /**
  * @brief test_trajectory_replace Test replacing an existing trajectory
  */
@@ -1965,3 +2142,237 @@ TEST_F(TrajectoryControllerTest, incorrect_initialization_using_interface_parame
   state_interface_types_ = {"velocity"};
   EXPECT_EQ(SetUpTrajectoryControllerLocal(), controller_interface::return_type::ERROR);
 }
+
+/**
+ * @brief in chained mode, the reference interfaces of the preceding controller are commanded
+ */
+TEST_F(TrajectoryControllerTest, chained_mode_commands_the_reference_interfaces)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpTrajectoryController(executor);
+  SetPidParameters();
+  traj_controller_->get_node()->configure();
+
+  auto reference_interfaces = traj_controller_->export_reference_interfaces();
+  ASSERT_EQ(reference_interfaces.size(), 2 * joint_names_.size());
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_EQ(
+      reference_interfaces[i].get_interface_name(),
+      joint_names_[i] + "/" + hardware_interface::HW_IF_POSITION);
+    EXPECT_EQ(
+      reference_interfaces[joint_names_.size() + i].get_interface_name(),
+      joint_names_[i] + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  ASSERT_TRUE(traj_controller_->set_chained_mode(true));
+  ActivateTrajectoryController();
+  ASSERT_TRUE(traj_controller_->is_in_chained_mode());
+
+  // no reference yet, the position is held
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  traj_controller_->update(rclcpp::Time(0, 0, RCL_STEADY_TIME), period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(joint_pos_[i], INITIAL_POS_JOINTS[i], COMMON_THRESHOLD);
+  }
+
+  // the reference is commanded in the same cycle, the velocity reference is optional
+  const std::vector<double> reference = {1.2, 2.2, 3.2};
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    reference_interfaces[i].set_value(reference[i]);
+  }
+  traj_controller_->update(rclcpp::Time(0, 10000000, RCL_STEADY_TIME), period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(joint_pos_[i], reference[i], COMMON_THRESHOLD);
+    EXPECT_NEAR(traj_controller_->get_state_reference().velocities[i], 0.0, COMMON_THRESHOLD);
+  }
+  EXPECT_FALSE(traj_controller_->has_nontrivial_traj());
+}
+
+/**
+ * @brief streamed velocity points are integrated from the last command until they time out
+ */
+TEST_F(TrajectoryControllerTest, velocity_streaming_integrates_the_streamed_velocities)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("velocity_streaming.enable", true),
+    rclcpp::Parameter("velocity_streaming.timeout", 0.5)};
+  SetUpAndActivateTrajectoryController(executor, params);
+
+  // the joints may be in any order
+  trajectory_msgs::msg::JointTrajectory traj_msg;
+  traj_msg.header.stamp = rclcpp::Time(1, 0);
+  traj_msg.joint_names = {joint_names_[2], joint_names_[0], joint_names_[1]};
+  traj_msg.points.resize(1);
+  traj_msg.points[0].velocities = {0.3, 0.1, 0.2};
+  ASSERT_TRUE(traj_controller_->is_velocity_stream_point(traj_msg));
+  trajectory_publisher_->publish(traj_msg);
+  ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor));
+
+  // nothing is streamed before the stamp of the point
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  traj_controller_->update(rclcpp::Time(0, 500000000, RCL_STEADY_TIME), period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(joint_pos_[i], INITIAL_POS_JOINTS[i], COMMON_THRESHOLD);
+  }
+
+  const std::vector<double> velocities = {0.1, 0.2, 0.3};
+  for (int k = 1; k <= 10; ++k)
+  {
+    traj_controller_->update(rclcpp::Time(1, 10000000 * k, RCL_STEADY_TIME), period);
+  }
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(joint_pos_[i], INITIAL_POS_JOINTS[i] + 0.1 * velocities[i], COMMON_THRESHOLD);
+    EXPECT_NEAR(
+      traj_controller_->get_state_reference().velocities[i], velocities[i], COMMON_THRESHOLD);
+  }
+
+  // the stream timed out, the joints stop
+  traj_controller_->update(rclcpp::Time(2, 0, RCL_STEADY_TIME), period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(joint_pos_[i], INITIAL_POS_JOINTS[i] + 0.1 * velocities[i], COMMON_THRESHOLD);
+    EXPECT_NEAR(traj_controller_->get_state_reference().velocities[i], 0.0, COMMON_THRESHOLD);
+  }
+  EXPECT_FALSE(traj_controller_->has_nontrivial_traj());
+}
+
+/**
+ * @brief the velocities written into the shared memory ring are streamed from the next update
+ */
+TEST_F(TrajectoryControllerTest, shm_ingress_streams_the_written_velocities)
+{
+  const std::string segment_name = "/test_jtc_shm_ingress_" + std::to_string(getpid());
+  rclcpp::executors::SingleThreadedExecutor executor;
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("velocity_streaming.enable", true),
+    rclcpp::Parameter("velocity_streaming.timeout", 0.5),
+    rclcpp::Parameter("shm_ingress.enable", true),
+    rclcpp::Parameter("shm_ingress.name", segment_name)};
+  SetUpAndActivateTrajectoryController(executor, params);
+
+  shm_command_ingress::ShmCommandRing writer;
+  std::string error;
+  ASSERT_TRUE(writer.open(segment_name, joint_names_.size(), error)) << error;
+  // in the order of the joints of the controller, a command with a NaN is ignored
+  const std::vector<double> velocities = {0.1, 0.2, 0.3};
+  ASSERT_TRUE(writer.write(0, {0.1, std::numeric_limits<double>::quiet_NaN(), 0.3}));
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  traj_controller_->update(rclcpp::Time(1, 0, RCL_STEADY_TIME), period);
+  EXPECT_FALSE(traj_controller_->has_nontrivial_traj());
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(joint_pos_[i], INITIAL_POS_JOINTS[i], COMMON_THRESHOLD);
+  }
+
+  ASSERT_TRUE(writer.write(0, velocities));
+  for (int k = 1; k <= 10; ++k)
+  {
+    traj_controller_->update(rclcpp::Time(1, 10000000 * k, RCL_STEADY_TIME), period);
+  }
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(joint_pos_[i], INITIAL_POS_JOINTS[i] + 0.1 * velocities[i], COMMON_THRESHOLD);
+    EXPECT_NEAR(
+      traj_controller_->get_state_reference().velocities[i], velocities[i], COMMON_THRESHOLD);
+  }
+
+  // the writer stopped, the stream times out after the arrival of its latest velocities
+  traj_controller_->update(rclcpp::Time(2, 0, RCL_STEADY_TIME), period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(traj_controller_->get_state_reference().velocities[i], 0.0, COMMON_THRESHOLD);
+  }
+
+  // the timeout counts from the stamp of the velocities, written longer than the timeout ago
+  ASSERT_TRUE(writer.write(1000000000, velocities));
+  traj_controller_->update(rclcpp::Time(2, 10000000, RCL_STEADY_TIME), period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(traj_controller_->get_state_reference().velocities[i], 0.0, COMMON_THRESHOLD);
+  }
+  ASSERT_TRUE(writer.write(2000000000, velocities));
+  traj_controller_->update(rclcpp::Time(2, 20000000, RCL_STEADY_TIME), period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(
+      traj_controller_->get_state_reference().velocities[i], velocities[i], COMMON_THRESHOLD);
+  }
+}
+
+/**
+ * @brief the next samples of the trajectory are exported to the trajectory horizon exchange
+ */
+TEST_F(TrajectoryControllerTest, trajectory_horizon_is_exported_every_update)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("trajectory_horizon.enable", true),
+    rclcpp::Parameter("trajectory_horizon.num_samples", 5),
+    rclcpp::Parameter("trajectory_horizon.sample_period", 0.1)};
+  SetUpAndActivateTrajectoryController(executor, params);
+
+  auto slot = trajectory_horizon_exchange::TrajectoryHorizonExchange::get_instance().get_slot(
+    "/" + controller_name_);
+  trajectory_horizon_exchange::TrajectoryHorizon horizon;
+  ASSERT_TRUE(slot->prepare(horizon));
+
+  // the position is held after the activation
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  traj_controller_->update(rclcpp::Time(0, 0, RCL_STEADY_TIME), period);
+  ASSERT_TRUE(slot->read(horizon));
+  EXPECT_EQ(horizon.stamp_nanoseconds, 0);
+  EXPECT_EQ(horizon.period_nanoseconds, 100000000);
+  ASSERT_EQ(horizon.num_samples, 5u);
+  ASSERT_EQ(horizon.num_joints, joint_names_.size());
+  for (size_t k = 0; k < horizon.num_samples; ++k)
+  {
+    for (size_t i = 0; i < joint_names_.size(); ++i)
+    {
+      EXPECT_NEAR(horizon.positions[k * 3 + i], INITIAL_POS_JOINTS[i], COMMON_THRESHOLD);
+    }
+  }
+
+  // reaches the point after one second and stays there
+  const std::vector<double> point = {1.5, 2.5, 3.5};
+  trajectory_msgs::msg::JointTrajectory traj_msg;
+  traj_msg.joint_names = joint_names_;
+  traj_msg.points.resize(2);
+  traj_msg.points[0].positions = point;
+  traj_msg.points[0].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  traj_msg.points[1].positions = point;
+  traj_msg.points[1].time_from_start = rclcpp::Duration::from_seconds(2.0);
+  trajectory_publisher_->publish(traj_msg);
+  ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor));
+
+  for (int k = 0; k <= 70; ++k)
+  {
+    traj_controller_->update(rclcpp::Time(1, 10000000 * k, RCL_STEADY_TIME), period);
+  }
+  ASSERT_TRUE(slot->read(horizon));
+  EXPECT_EQ(horizon.stamp_nanoseconds, rclcpp::Time(1, 700000000).nanoseconds());
+  EXPECT_EQ(horizon.start_nanoseconds, rclcpp::Time(1, 700000000).nanoseconds());
+  ASSERT_EQ(horizon.num_samples, 5u);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    // the first sample is the reference of the update
+    EXPECT_NEAR(
+      horizon.positions[i], traj_controller_->get_state_reference().positions[i],
+      COMMON_THRESHOLD);
+    EXPECT_LT(
+      std::abs(horizon.positions[i] - point[i]), std::abs(INITIAL_POS_JOINTS[i] - point[i]));
+    // the samples after one second of the trajectory are at the point
+    EXPECT_NEAR(horizon.positions[3 * 3 + i], point[i], COMMON_THRESHOLD);
+    EXPECT_NEAR(horizon.positions[4 * 3 + i], point[i], COMMON_THRESHOLD);
+  }
+
+  // no samples without an active controller
+  traj_controller_->get_node()->deactivate();
+  ASSERT_TRUE(slot->read(horizon));
+  EXPECT_EQ(horizon.num_samples, 0u);
+}
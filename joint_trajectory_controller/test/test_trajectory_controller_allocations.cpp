@@ -0,0 +1,181 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "builtin_interfaces/msg/duration.hpp"
+#include "controller_interface/controller_interface_base.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/executors/single_threaded_executor.hpp"
+#include "rclcpp/parameter.hpp"
+#include "rclcpp/time.hpp"
+#include "rt_safety_checks/rt_safety_checker.hpp"
+
+#include "test_trajectory_controller_utils.hpp"
+
+using test_trajectory_controllers::TrajectoryControllerTest;
+
+class TrajectoryControllerAllocationTest
+: public TrajectoryControllerTest,
+  public ::testing::WithParamInterface<
+    std::tuple<std::vector<std::string>, std::vector<std::string>, std::string>>
+{
+public:
+  void SetUp() override
+  {
+    TrajectoryControllerTest::SetUp();
+    command_interface_types_ = std::get<0>(GetParam());
+    state_interface_types_ = std::get<1>(GetParam());
+  }
+};
+
+/**
+ * @brief update() doesn't allocate or lock while following a trajectory, once the msg was taken
+ * over
+ */
+TEST_P(TrajectoryControllerAllocationTest, no_allocations_in_steady_state)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("interpolation_method", std::get<2>(GetParam()))};
+  SetUpAndActivateTrajectoryController(executor, params, true, 1.0);
+
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.5)};
+  // *INDENT-OFF*
+  std::vector<std::vector<double>> points{
+    {{3.3, 4.4, 5.5}}, {{7.7, 8.8, 9.9}}, {{10.10, 11.11, 12.12}}};
+  std::vector<std::vector<double>> points_velocities{
+    {{0.01, 0.01, 0.01}}, {{0.05, 0.05, 0.05}}, {{0.0, 0.0, 0.0}}};
+  // *INDENT-ON*
+  publish(time_from_start, points, rclcpp::Time(), {}, points_velocities);
+  ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor));
+
+  // taking over the new msg may allocate, e.g., the point times of the trajectory
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  auto time = updateControllerAsync(
+    rclcpp::Duration::from_seconds(0.05), rclcpp::Time(0, 0, RCL_STEADY_TIME), period);
+
+  // crosses the first points
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    time += period;
+    traj_controller_->update(time, period);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+  EXPECT_TRUE(traj_controller_->has_active_traj());
+}
+
+/**
+ * @brief update() doesn't free the trajectory msgs it replaces, they are released by a non-RT
+ * thread
+ */
+TEST_P(TrajectoryControllerAllocationTest, no_deallocations_when_replacing_trajectories)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("interpolation_method", std::get<2>(GetParam()))};
+  SetUpAndActivateTrajectoryController(executor, params, true, 1.0);
+
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.5)};
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  auto time = rclcpp::Time(0, 0, RCL_STEADY_TIME);
+  size_t num_deallocations = 0;
+  for (int k = 0; k < 6; ++k)
+  {
+    const double offset = 0.1 * k;
+    publish(
+      time_from_start, {{3.3 + offset, 4.4, 5.5}, {7.7 + offset, 8.8, 9.9}}, rclcpp::Time(), {},
+      {{0.01, 0.01, 0.01}, {0.0, 0.0, 0.0}});
+    ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor));
+
+    // the first trajectory may reallocate the memory for its points, the msgs of the earlier
+    // trajectories are dropped when the later ones are taken over
+    rt_safety_checks::RtSafetyChecker checker;
+    for (int i = 0; i < 5; ++i)
+    {
+      time += period;
+      traj_controller_->update(time, period);
+    }
+    checker.stop();
+    if (k > 0)
+    {
+      num_deallocations += checker.deallocations();
+    }
+  }
+  EXPECT_EQ(num_deallocations, 0u);
+  EXPECT_TRUE(traj_controller_->has_active_traj());
+}
+
+/**
+ * @brief the activation in hot standby, e.g., when switching back from another controller, doesn't
+ * allocate
+ */
+TEST_P(TrajectoryControllerAllocationTest, no_allocations_on_activation_in_hot_standby)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("interpolation_method", std::get<2>(GetParam())),
+    rclcpp::Parameter("hot_standby", true)};
+  SetUpAndActivateTrajectoryController(executor, params, true, 1.0);
+
+  // follow a trajectory until switching to another controller
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.5)};
+  publish(
+    time_from_start, {{3.3, 4.4, 5.5}, {7.7, 8.8, 9.9}}, rclcpp::Time(), {},
+    {{0.01, 0.01, 0.01}, {0.0, 0.0, 0.0}});
+  ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor));
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  auto time = updateControllerAsync(
+    rclcpp::Duration::from_seconds(0.1), rclcpp::Time(0, 0, RCL_STEADY_TIME), period);
+  auto state = traj_controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+  // switch back, the lifecycle transition itself allocates so only the callback is checked
+  AssignTrajectoryControllerInterfaces(true);
+  rt_safety_checks::RtSafetyChecker checker;
+  const auto ret = traj_controller_->on_activate(state);
+  checker.stop();
+  ASSERT_EQ(ret, controller_interface::CallbackReturn::SUCCESS);
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+
+  // it holds the position of the activation
+  time += period;
+  traj_controller_->update(time, period);
+  EXPECT_TRUE(traj_controller_->has_trivial_traj());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  TrajectoryControllerAllocations, TrajectoryControllerAllocationTest,
+  ::testing::Values(
+    std::make_tuple(
+      std::vector<std::string>({"position"}), std::vector<std::string>({"position"}), "splines"),
+    std::make_tuple(
+      std::vector<std::string>({"position", "velocity"}),
+      std::vector<std::string>({"position", "velocity"}), "quintic_splines"),
+    std::make_tuple(
+      std::vector<std::string>({"velocity"}), std::vector<std::string>({"position", "velocity"}),
+      "splines"),
+    std::make_tuple(
+      std::vector<std::string>({"effort"}), std::vector<std::string>({"position", "velocity"}),
+      "none")));
@@ -0,0 +1,139 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "builtin_interfaces/msg/duration.hpp"
+#include "rclcpp/clock.hpp"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/executors/single_threaded_executor.hpp"
+#include "rclcpp/parameter.hpp"
+#include "rclcpp/time.hpp"
+#include "rt_safety_checks/update_time_bound.hpp"
+
+#include "test_trajectory_controller_utils.hpp"
+
+using test_trajectory_controllers::TrajectoryControllerTest;
+
+namespace
+{
+// the updates with adversarial inputs may take this many times the median of the nominal
+// updates, plus half of a 1 kHz cycle for the scheduling of the test process
+constexpr double UPDATE_TIME_RATIO = 10.0;
+constexpr auto UPDATE_TIME_SLACK = std::chrono::microseconds(500);
+constexpr size_t NUM_CYCLES = 200;
+// adversarial trajectory, which takes a while to be published and validated
+constexpr size_t NUM_LARGE_TRAJECTORY_POINTS = 50000;
+constexpr std::chrono::milliseconds LARGE_TRAJECTORY_TIMEOUT{10000};
+}  // namespace
+
+class TrajectoryControllerUpdateTimeTest : public TrajectoryControllerTest
+{
+protected:
+  /// Calibrate bound_ with the updates following a short trajectory, which is still followed
+  /// afterwards
+  void calibrate(rclcpp::Executor & executor)
+  {
+    builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.5)};
+    publish(
+      time_from_start, {{3.3, 4.4, 5.5}, {7.7, 8.8, 9.9}, {10.10, 11.11, 12.12}}, rclcpp::Time(),
+      {}, {{0.01, 0.01, 0.01}, {0.05, 0.05, 0.05}, {0.0, 0.0, 0.0}});
+    ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor));
+
+    // taking over the short trajectory is not part of the baseline
+    time_ = rclcpp::Clock(RCL_STEADY_TIME).now();
+    traj_controller_->update(time_, period_);
+    bound_.calibrate(NUM_CYCLES, [this](size_t) { update(); });
+    ASSERT_TRUE(traj_controller_->has_active_traj());
+  }
+
+  void update()
+  {
+    time_ += period_;
+    traj_controller_->update(time_, period_);
+  }
+
+  /// Positions of \p num_joints joints oscillating around the positions of the short trajectory
+  static std::vector<std::vector<double>> large_trajectory(const size_t num_joints)
+  {
+    std::vector<std::vector<double>> points(NUM_LARGE_TRAJECTORY_POINTS);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      for (size_t j = 0; j < num_joints; ++j)
+      {
+        const double offset = 0.1 * std::sin(0.01 * static_cast<double>(i));
+        points[i].push_back(7.7 + static_cast<double>(j) + offset);
+      }
+    }
+    return points;
+  }
+
+  void expect_within_bound(const rt_safety_checks::UpdateTimes & times) const
+  {
+    EXPECT_TRUE(bound_.holds(times))
+      << "worst update " << times.max.count() << " ns, median " << times.median.count()
+      << " ns, baseline " << bound_.get_baseline().count() << " ns, bound "
+      << bound_.get_bound().count() << " ns";
+  }
+
+  rt_safety_checks::UpdateTimeBound bound_{UPDATE_TIME_RATIO, UPDATE_TIME_SLACK};
+  const rclcpp::Duration period_ = rclcpp::Duration::from_seconds(0.001);
+  rclcpp::Time time_;
+};
+
+/**
+ * @brief the update taking over a trajectory with many points mid-motion, and the updates
+ * following it, stay within the bound of the updates following a short trajectory
+ */
+TEST_F(TrajectoryControllerUpdateTimeTest, large_trajectory_arriving_mid_motion)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(executor, {}, true, 1.0);
+  calibrate(executor);
+
+  builtin_interfaces::msg::Duration point_interval{rclcpp::Duration::from_seconds(0.01)};
+  publish(point_interval, large_trajectory(joint_names_.size()), rclcpp::Time());
+  ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor, LARGE_TRAJECTORY_TIMEOUT));
+
+  const auto times =
+    rt_safety_checks::measure_update_times(NUM_CYCLES, [this](size_t) { update(); });
+  EXPECT_TRUE(traj_controller_->has_active_traj());
+  expect_within_bound(times);
+}
+
+/**
+ * @brief a large trajectory of a subset of the joints, whose missing joints are filled in, is
+ * followed within the same bound
+ */
+TEST_F(TrajectoryControllerUpdateTimeTest, large_partial_joints_goal_arriving_mid_motion)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, {rclcpp::Parameter("allow_partial_joints_goal", true)}, true, 1.0);
+  calibrate(executor);
+
+  builtin_interfaces::msg::Duration point_interval{rclcpp::Duration::from_seconds(0.01)};
+  publish(point_interval, large_trajectory(1), rclcpp::Time(), {joint_names_[0]});
+  ASSERT_TRUE(traj_controller_->wait_for_trajectory(executor, LARGE_TRAJECTORY_TIMEOUT));
+
+  const auto times =
+    rt_safety_checks::measure_update_times(NUM_CYCLES, [this](size_t) { update(); });
+  EXPECT_TRUE(traj_controller_->has_active_traj());
+  expect_within_bound(times);
+}
@@ -53,6 +53,8 @@ class TestableJointTrajectoryController
 {
 public:
   using joint_trajectory_controller::JointTrajectoryController::JointTrajectoryController;
+  using joint_trajectory_controller::JointTrajectoryController::add_new_trajectory_msg;
+  using joint_trajectory_controller::JointTrajectoryController::splice_trajectory_msg;
   using joint_trajectory_controller::JointTrajectoryController::validate_trajectory_msg;
 
   controller_interface::CallbackReturn on_configure(
@@ -130,7 +132,7 @@ public:
 
   bool is_open_loop() const { return params_.open_loop_control; }
 
-  std::vector<PidPtr> get_pids() const { return pids_; }
+  const pid_bank::PidBank & get_pid_bank() const { return pid_bank_; }
 
   joint_trajectory_controller::SegmentTolerances get_tolerances() const
   {
@@ -274,6 +276,20 @@ public:
     const std::vector<double> initial_vel_joints = INITIAL_VEL_JOINTS,
     const std::vector<double> initial_acc_joints = INITIAL_ACC_JOINTS,
     const std::vector<double> initial_eff_joints = INITIAL_EFF_JOINTS)
+  {
+    AssignTrajectoryControllerInterfaces(
+      separate_cmd_and_state_values, initial_pos_joints, initial_vel_joints, initial_acc_joints,
+      initial_eff_joints);
+    return traj_controller_->get_node()->activate();
+  }
+
+  /// Hand over the interfaces to the controller like the controller manager before the activation
+  void AssignTrajectoryControllerInterfaces(
+    bool separate_cmd_and_state_values = false,
+    const std::vector<double> initial_pos_joints = INITIAL_POS_JOINTS,
+    const std::vector<double> initial_vel_joints = INITIAL_VEL_JOINTS,
+    const std::vector<double> initial_acc_joints = INITIAL_ACC_JOINTS,
+    const std::vector<double> initial_eff_joints = INITIAL_EFF_JOINTS)
   {
     std::vector<hardware_interface::LoanedCommandInterface> cmd_interfaces;
     std::vector<hardware_interface::LoanedStateInterface> state_interfaces;
@@ -326,7 +342,6 @@ public:
     }
 
     traj_controller_->assign_interfaces(std::move(cmd_interfaces), std::move(state_interfaces));
-    return traj_controller_->get_node()->activate();
   }
 
   static void TearDownTestCase() { rclcpp::shutdown(); }
@@ -0,0 +1,206 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "joint_trajectory_controller/trajectory_recorder.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+using joint_trajectory_controller::deserialize_record_payload;
+using joint_trajectory_controller::LogRecord;
+using joint_trajectory_controller::RecordKind;
+using joint_trajectory_controller::serialize_record_payload;
+using joint_trajectory_controller::TrajectoryLogReader;
+using joint_trajectory_controller::TrajectoryRecorder;
+
+class TestTrajectoryRecorder : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    path_ = testing::TempDir() + "test_trajectory_recorder.log";
+    state_interfaces_.emplace_back(state_interface_1_);
+    state_interfaces_.emplace_back(state_interface_2_);
+    command_interfaces_.emplace_back(command_interface_);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  void record_update(int64_t time_ns, double state_value, double command_value)
+  {
+    state_values_[0] = state_value;
+    state_values_[1] = -state_value;
+    command_value_ = command_value;
+    recorder_.record_update(time_ns, 1000000, state_interfaces_, command_interfaces_);
+  }
+
+  std::vector<LogRecord> read_records()
+  {
+    TrajectoryLogReader reader;
+    EXPECT_TRUE(reader.open(path_));
+    EXPECT_EQ(reader.controller_name(), "test_controller");
+    std::vector<LogRecord> records;
+    LogRecord record;
+    while (reader.read(record))
+    {
+      records.push_back(record);
+    }
+    return records;
+  }
+
+  std::string path_;
+  TrajectoryRecorder recorder_;
+  const std::vector<std::string> state_names_ = {"joint1/position", "joint1/velocity"};
+  const std::vector<std::string> command_names_ = {"joint1/position"};
+
+  double state_values_[2] = {0.0, 0.0};
+  double command_value_ = 0.0;
+  hardware_interface::StateInterface state_interface_1_{"joint1", "position", &state_values_[0]};
+  hardware_interface::StateInterface state_interface_2_{"joint1", "velocity", &state_values_[1]};
+  hardware_interface::CommandInterface command_interface_{"joint1", "position", &command_value_};
+  std::vector<hardware_interface::LoanedStateInterface> state_interfaces_;
+  std::vector<hardware_interface::LoanedCommandInterface> command_interfaces_;
+};
+
+TEST_F(TestTrajectoryRecorder, records_updates_and_events_in_their_order)
+{
+  ASSERT_TRUE(recorder_.open(path_, "test_controller", {1, 2, 3}));
+  recorder_.start_session(state_names_, command_names_, 16);
+  record_update(1000, 0.5, 1.5);
+  recorder_.record_event(RecordKind::TRAJECTORY, {4, 5});
+  record_update(2000, 0.6, 1.6);
+  recorder_.record_event(RecordKind::CANCEL);
+  record_update(3000, 0.7, 1.7);
+  recorder_.stop_session();
+  recorder_.close();
+
+  TrajectoryLogReader reader;
+  ASSERT_TRUE(reader.open(path_));
+  EXPECT_THAT(reader.parameters(), ::testing::ElementsAre(1, 2, 3));
+
+  const auto records = read_records();
+  ASSERT_EQ(records.size(), 6u);
+  EXPECT_EQ(records[0].kind, RecordKind::SESSION);
+  EXPECT_EQ(records[0].state_names, state_names_);
+  EXPECT_EQ(records[0].command_names, command_names_);
+
+  EXPECT_EQ(records[1].kind, RecordKind::UPDATE);
+  EXPECT_EQ(records[1].cycle, 0u);
+  EXPECT_EQ(records[1].time_ns, 1000);
+  EXPECT_EQ(records[1].period_ns, 1000000);
+  EXPECT_THAT(records[1].state_values, ::testing::ElementsAre(0.5, -0.5));
+  EXPECT_THAT(records[1].command_values, ::testing::ElementsAre(1.5));
+
+  // the events go right before the update following them
+  EXPECT_EQ(records[2].kind, RecordKind::TRAJECTORY);
+  EXPECT_EQ(records[2].cycle, 1u);
+  EXPECT_THAT(records[2].payload, ::testing::ElementsAre(4, 5));
+  EXPECT_EQ(records[3].kind, RecordKind::UPDATE);
+  EXPECT_EQ(records[3].cycle, 1u);
+  EXPECT_EQ(records[4].kind, RecordKind::CANCEL);
+  EXPECT_EQ(records[4].cycle, 2u);
+  EXPECT_EQ(records[5].kind, RecordKind::UPDATE);
+  EXPECT_EQ(records[5].cycle, 2u);
+  EXPECT_THAT(records[5].command_values, ::testing::ElementsAre(1.7));
+}
+
+TEST_F(TestTrajectoryRecorder, every_session_restarts_the_cycles)
+{
+  ASSERT_TRUE(recorder_.open(path_, "test_controller", {}));
+  for (int session = 0; session < 2; ++session)
+  {
+    recorder_.start_session(state_names_, command_names_, 16);
+    record_update(1000, 0.5, 1.5);
+    recorder_.stop_session();
+  }
+  // nothing is recorded outside of a session
+  record_update(2000, 0.6, 1.6);
+  recorder_.record_event(RecordKind::CANCEL);
+  recorder_.close();
+
+  const auto records = read_records();
+  ASSERT_EQ(records.size(), 4u);
+  for (size_t index : {0u, 2u})
+  {
+    EXPECT_EQ(records[index].kind, RecordKind::SESSION);
+    EXPECT_EQ(records[index + 1].kind, RecordKind::UPDATE);
+    EXPECT_EQ(records[index + 1].cycle, 0u);
+  }
+}
+
+TEST_F(TestTrajectoryRecorder, drops_updates_if_the_writer_falls_behind)
+{
+  ASSERT_TRUE(recorder_.open(path_, "test_controller", {}));
+  // the writer doesn't run before the session stops
+  recorder_.start_session(state_names_, command_names_, 2, std::chrono::hours(1));
+  for (int64_t cycle = 0; cycle < 5; ++cycle)
+  {
+    record_update(cycle, 0.0, 0.0);
+  }
+  recorder_.record_event(RecordKind::CANCEL);
+  EXPECT_EQ(recorder_.dropped_updates(), 3u);
+  recorder_.close();
+
+  const auto records = read_records();
+  ASSERT_EQ(records.size(), 4u);
+  EXPECT_EQ(records[1].cycle, 0u);
+  EXPECT_EQ(records[2].cycle, 1u);
+  // the gap of the dropped updates is kept
+  EXPECT_EQ(records[3].kind, RecordKind::CANCEL);
+  EXPECT_EQ(records[3].cycle, 5u);
+}
+
+TEST_F(TestTrajectoryRecorder, incomplete_last_record_ends_the_log)
+{
+  ASSERT_TRUE(recorder_.open(path_, "test_controller", {}));
+  recorder_.start_session(state_names_, command_names_, 16);
+  record_update(1000, 0.5, 1.5);
+  record_update(2000, 0.6, 1.6);
+  recorder_.close();
+  std::filesystem::resize_file(path_, std::filesystem::file_size(path_) - 4);
+
+  const auto records = read_records();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[1].time_ns, 1000);
+}
+
+TEST_F(TestTrajectoryRecorder, rejects_other_files)
+{
+  std::ofstream(path_) << "not a trajectory log";
+  TrajectoryLogReader reader;
+  EXPECT_FALSE(reader.open(path_));
+  EXPECT_FALSE(reader.open(path_ + ".missing"));
+}
+
+TEST(TestTrajectoryRecorderPayload, msgs_survive_serialization)
+{
+  trajectory_msgs::msg::JointTrajectory msg;
+  msg.joint_names = {"joint1", "joint2"};
+  msg.points.resize(2);
+  msg.points[1].positions = {1.0, 2.0};
+  msg.points[1].time_from_start.sec = 3;
+
+  const auto payload = serialize_record_payload(msg);
+  EXPECT_FALSE(payload.empty());
+  EXPECT_EQ(deserialize_record_payload<trajectory_msgs::msg::JointTrajectory>(payload), msg);
+}
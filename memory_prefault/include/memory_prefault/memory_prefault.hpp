@@ -0,0 +1,124 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEMORY_PREFAULT__MEMORY_PREFAULT_HPP_
+#define MEMORY_PREFAULT__MEMORY_PREFAULT_HPP_
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace memory_prefault
+{
+/// Distance of the touched bytes, the smallest page size of the supported platforms, so every page
+/// is touched also with larger pages
+constexpr size_t PAGE_STRIDE = 4096;
+
+/**
+ * \brief Touch every page of the \p size bytes at \p data, so they are mapped before the realtime
+ * loop uses them.
+ *
+ * Heap memory is mapped by the kernel on its first access, and storage which is only reserved,
+ * e.g., the capacity of a vector beyond its size, is first accessed by an update otherwise. Every
+ * page is written with the value it has, since reading alone may map a shared zero page. Not
+ * realtime-safe, and the memory may not be used by another thread meanwhile.
+ *
+ * \returns \p size
+ */
+inline size_t prefault_bytes(void * data, size_t size)
+{
+  if (data == nullptr || size == 0)
+  {
+    return 0;
+  }
+  auto * bytes = static_cast<volatile unsigned char *>(data);
+  for (size_t offset = 0; offset < size; offset += PAGE_STRIDE)
+  {
+    bytes[offset] = bytes[offset];
+  }
+  // the page of the end, if the stride stepped over it
+  bytes[size - 1] = bytes[size - 1];
+  return size;
+}
+
+/// Touch the storage of \p count contiguous elements at \p data, e.g., of an Eigen vector
+template <typename T>
+size_t prefault_span(T * data, size_t count)
+{
+  static_assert(std::is_trivially_copyable_v<T>, "only the storage of plain values is touched");
+  return prefault_bytes(static_cast<void *>(data), count * sizeof(T));
+}
+
+/// True for the types whose elements own buffers touched by prefault()
+template <typename T>
+struct is_buffer : std::false_type
+{
+};
+template <>
+struct is_buffer<std::string> : std::true_type
+{
+};
+template <typename T, typename AllocatorT>
+struct is_buffer<std::vector<T, AllocatorT>> : std::true_type
+{
+};
+
+/// Touch the storage of \p text up to its capacity
+inline size_t prefault(std::string & text)
+{
+  return prefault_bytes(static_cast<void *>(text.data()), text.capacity() + 1);
+}
+
+/// Touch the storage of \p values up to its capacity, and the storage of its elements which are
+/// strings or vectors
+/**
+ * Other buffers owned by the elements, e.g., by messages, are not touched.
+ */
+template <typename T>
+size_t prefault(std::vector<T> & values)
+{
+  if constexpr (std::is_same_v<T, bool>)
+  {
+    // packed, whose storage isn't accessible
+    return 0;
+  }
+  else
+  {
+    size_t bytes =
+      prefault_bytes(static_cast<void *>(values.data()), values.capacity() * sizeof(T));
+    if constexpr (is_buffer<T>::value)
+    {
+      for (auto & value : values)
+      {
+        bytes += prefault(value);
+      }
+    }
+    return bytes;
+  }
+}
+
+/// Touch the storage of all \p buffers, e.g., of the fields of a preallocated message
+/**
+ * \returns the number of touched bytes
+ */
+template <typename FirstT, typename SecondT, typename... BufferT>
+size_t prefault(FirstT & first, SecondT & second, BufferT &... buffers)
+{
+  return prefault(first) + prefault(second) + (prefault(buffers) + ... + size_t{0});
+}
+
+}  // namespace memory_prefault
+
+#endif  // MEMORY_PREFAULT__MEMORY_PREFAULT_HPP_
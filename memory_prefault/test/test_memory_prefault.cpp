@@ -0,0 +1,61 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory_prefault/memory_prefault.hpp"
+
+using memory_prefault::prefault;
+
+TEST(TestMemoryPrefault, touches_the_capacity_and_keeps_the_values)
+{
+  std::vector<double> values = {1.0, 2.0, 3.0};
+  values.reserve(10000);
+  EXPECT_EQ(prefault(values), values.capacity() * sizeof(double));
+  EXPECT_THAT(values, testing::ElementsAre(1.0, 2.0, 3.0));
+
+  std::vector<double> empty;
+  EXPECT_EQ(prefault(empty), 0u);
+  EXPECT_EQ(memory_prefault::prefault_bytes(nullptr, 100), 0u);
+}
+
+TEST(TestMemoryPrefault, touches_nested_buffers)
+{
+  std::vector<std::string> names(2);
+  names[0] = std::string(100, 'a');
+  names[0].reserve(200);
+  names[1] = "b";
+  const size_t expected =
+    names.capacity() * sizeof(std::string) + names[0].capacity() + 1 + names[1].capacity() + 1;
+  EXPECT_EQ(prefault(names), expected);
+  EXPECT_EQ(names[0], std::string(100, 'a'));
+  EXPECT_EQ(names[1], "b");
+
+  std::vector<double> positions(6, 0.5);
+  std::vector<int> indices(3, 1);
+  std::vector<bool> flags(4, true);
+  std::vector<std::pair<size_t, const double *>> sources(2);
+  EXPECT_EQ(
+    prefault(positions, indices, flags, sources),
+    positions.capacity() * sizeof(double) + indices.capacity() * sizeof(int) +
+      sources.capacity() * sizeof(sources[0]));
+
+  double span[3] = {1.0, 2.0, 3.0};
+  EXPECT_EQ(memory_prefault::prefault_span(span, 3), sizeof(span));
+  EXPECT_DOUBLE_EQ(span[2], 3.0);
+}
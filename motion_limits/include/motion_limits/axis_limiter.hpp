@@ -0,0 +1,251 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MOTION_LIMITS__AXIS_LIMITER_HPP_
+#define MOTION_LIMITS__AXIS_LIMITER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <optional>
+
+namespace motion_limits
+{
+/**
+ * \brief Limits of a value, or of one of its derivatives.
+ *
+ * The signed limits are applied first, then the limits of the magnitude, keeping the sign.
+ * The defaults do not limit.
+ */
+template <typename Scalar>
+struct Bounds
+{
+  Scalar min = -std::numeric_limits<Scalar>::infinity();
+  Scalar max = std::numeric_limits<Scalar>::infinity();
+  Scalar min_magnitude = Scalar(0);
+  Scalar max_magnitude = std::numeric_limits<Scalar>::infinity();
+};
+
+/// Limits of one axis, e.g. a velocity with acceleration and jerk limits
+template <typename Scalar>
+struct AxisLimits
+{
+  /// Limits of the value
+  Bounds<Scalar> value;
+  /// Limits of the first derivative [1/s]
+  Bounds<Scalar> derivative;
+  /// Limits of the first derivative while the magnitude of the value decreases, e.g. the
+  /// deceleration. The limits of the first derivative if not set.
+  std::optional<Bounds<Scalar>> derivative_towards_zero;
+  /// Limits of the second derivative [1/s^2]
+  Bounds<Scalar> second_derivative;
+};
+
+/**
+ * \brief Limits N axes together, from the values of the two previous updates.
+ *
+ * The limits are stored per bound for all axes, so each limit is one pass of min/max over arrays,
+ * without branches, which the compiler can vectorize. Realtime-safe.
+ *
+ * \tparam N number of axes
+ * \tparam Scalar floating point type of the values
+ */
+template <std::size_t N, typename Scalar = double>
+class AxisLimiter
+{
+public:
+  using Vector = std::array<Scalar, N>;
+
+  /// Set the limits of \p axis, which are not limited by default
+  void set_limits(std::size_t axis, const AxisLimits<Scalar> & limits)
+  {
+    value_.set(axis, limits.value);
+    derivative_.set(axis, limits.derivative);
+    derivative_towards_zero_.set(
+      axis, limits.derivative_towards_zero.value_or(limits.derivative));
+    second_derivative_.set(axis, limits.second_derivative);
+  }
+
+  /**
+   * \brief Limit the second derivative, the first derivative and the value, in this order
+   * \param[in, out] x  Values
+   * \param[in] x0 Values of the previous update
+   * \param[in] x1 Values of the update before the previous one
+   * \param[in] dt Time step [s]
+   */
+  void limit(Vector & x, const Vector & x0, const Vector & x1, Scalar dt) const
+  {
+    limit_second_derivative(x, x0, x1, dt);
+    limit_derivative(x, x0, dt);
+    limit_value(x);
+  }
+
+  /**
+   * \brief Limit the values
+   * \param[in, out] x Values
+   */
+  void limit_value(Vector & x) const
+  {
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      x[i] = value_.clamp(i, x[i], Scalar(1));
+    }
+  }
+
+  /**
+   * \brief Limit the first derivative
+   * \param[in, out] x  Values
+   * \param[in] x0 Values of the previous update
+   * \param[in] dt Time step [s]
+   */
+  void limit_derivative(Vector & x, const Vector & x0, Scalar dt) const
+  {
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      const Scalar change = x[i] - x0[i];
+      const Scalar towards_zero_change = derivative_towards_zero_.clamp(i, change, dt);
+      const Scalar away_from_zero_change = derivative_.clamp(i, change, dt);
+      const Scalar limited_change =
+        std::fabs(x[i]) < std::fabs(x0[i]) ? towards_zero_change : away_from_zero_change;
+      // keeps values within the limits exactly, instead of rounding them through the change
+      x[i] = limited_change == change ? x[i] : x0[i] + limited_change;
+    }
+  }
+
+  /**
+   * \brief Limit the second derivative
+   *
+   * The bounds apply to the change of the difference between consecutive values, scaled with
+   * 2 dt^2.
+   * \param[in, out] x  Values
+   * \param[in] x0 Values of the previous update
+   * \param[in] x1 Values of the update before the previous one
+   * \param[in] dt Time step [s]
+   * \see http://en.wikipedia.org/wiki/Jerk_%28physics%29#Motion_control
+   */
+  void limit_second_derivative(Vector & x, const Vector & x0, const Vector & x1, Scalar dt) const
+  {
+    const Scalar scale = Scalar(2) * dt * dt;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      const Scalar previous_change = x0[i] - x1[i];
+      const Scalar change_of_change = x[i] - x0[i] - previous_change;
+      const Scalar limited = second_derivative_.clamp(i, change_of_change, scale);
+      x[i] = limited == change_of_change ? x[i] : x0[i] + previous_change + limited;
+    }
+  }
+
+  /**
+   * \brief Limit the values so that planned values can still be reached in time.
+   *
+   * Bounds the values by the change which the limits of the first and the second derivative allow
+   * within \p time_ahead, starting without a first derivative. Applied before limit() for each
+   * point of a preview of the values, the values change early enough towards the planned ones,
+   * e.g. a velocity starts to decelerate before a planned stop instead of when it is commanded.
+   * \param[in, out] x Values
+   * \param[in] planned Values planned \p time_ahead after \p x
+   * \param[in] time_ahead Time until \p planned [s], values planned for now or earlier have to
+   * be reached right away
+   */
+  void limit_to_preview(Vector & x, const Vector & planned, Scalar time_ahead) const
+  {
+    constexpr Scalar INF = std::numeric_limits<Scalar>::infinity();
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      // rates of rising to and of falling to the planned value, the towards zero limits only
+      // apply if the value doesn't cross zero on the way
+      const Scalar rise_towards_zero = derivative_towards_zero_.clamp(i, INF, Scalar(1));
+      const Scalar fall_towards_zero = -derivative_towards_zero_.clamp(i, -INF, Scalar(1));
+      const Scalar rise = planned[i] <= Scalar(0)
+                            ? rise_towards_zero
+                            : std::min(rise_towards_zero, derivative_.clamp(i, INF, Scalar(1)));
+      const Scalar fall = planned[i] >= Scalar(0)
+                            ? fall_towards_zero
+                            : std::min(fall_towards_zero, -derivative_.clamp(i, -INF, Scalar(1)));
+      const Scalar jerk = std::min(
+        second_derivative_.clamp(i, INF, Scalar(1)), -second_derivative_.clamp(i, -INF, Scalar(1)));
+      x[i] = std::clamp(
+        x[i], planned[i] - reachable_change(rise, jerk, time_ahead),
+        planned[i] + reachable_change(fall, jerk, time_ahead));
+    }
+  }
+
+private:
+  /// Largest change within \p time from a standstill of the first derivative, with the limits
+  /// \p rate of the first and \p jerk of the second derivative
+  static Scalar reachable_change(Scalar rate, Scalar jerk, Scalar time)
+  {
+    if (!(rate > Scalar(0) && jerk > Scalar(0) && time > Scalar(0)))
+    {
+      return Scalar(0);
+    }
+    if (std::isinf(jerk))
+    {
+      return rate * time;
+    }
+    if (std::isinf(rate) || time < Scalar(2) * rate / jerk)
+    {
+      // the first derivative ramps up and down again without reaching its limit
+      return Scalar(0.25) * jerk * time * time;
+    }
+    return rate * (time - rate / jerk);
+  }
+
+  // bounds of all axes, one array per bound
+  struct BoundsArrays
+  {
+    BoundsArrays()
+    {
+      const Bounds<Scalar> unlimited;
+      min.fill(unlimited.min);
+      max.fill(unlimited.max);
+      min_magnitude.fill(unlimited.min_magnitude);
+      max_magnitude.fill(unlimited.max_magnitude);
+    }
+
+    void set(std::size_t axis, const Bounds<Scalar> & bounds)
+    {
+      min[axis] = bounds.min;
+      max[axis] = bounds.max;
+      min_magnitude[axis] = bounds.min_magnitude;
+      max_magnitude[axis] = bounds.max_magnitude;
+    }
+
+    // the unlimited bounds stay infinite after scaling, or NaN for a scale of 0, which std::min
+    // and std::max ignore as second argument
+    Scalar clamp(std::size_t axis, Scalar x, Scalar scale) const
+    {
+      x = std::min(std::max(x, min[axis] * scale), max[axis] * scale);
+      const Scalar magnitude = std::min(
+        std::max(std::fabs(x), min_magnitude[axis] * scale), max_magnitude[axis] * scale);
+      return std::copysign(magnitude, x);
+    }
+
+    Vector min;
+    Vector max;
+    Vector min_magnitude;
+    Vector max_magnitude;
+  };
+
+  BoundsArrays value_;
+  BoundsArrays derivative_;
+  BoundsArrays derivative_towards_zero_;
+  BoundsArrays second_derivative_;
+};
+
+}  // namespace motion_limits
+
+#endif  // MOTION_LIMITS__AXIS_LIMITER_HPP_
@@ -0,0 +1,80 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MOTION_LIMITS__SPEED_LIMITS_HPP_
+#define MOTION_LIMITS__SPEED_LIMITS_HPP_
+
+#include <cmath>
+#include <stdexcept>
+
+#include "motion_limits/axis_limiter.hpp"
+
+namespace motion_limits
+{
+/**
+ * \brief Limits of a velocity, from the velocity, acceleration and jerk limits parameters of the
+ * mobile base controllers.
+ *
+ * The maximum of an enabled limit has to be specified, the minimum defaults to -maximum.
+ * \param [in] has_velocity_limits     if true, applies velocity limits
+ * \param [in] has_acceleration_limits if true, applies acceleration limits
+ * \param [in] has_jerk_limits         if true, applies jerk limits
+ * \param [in] min_velocity Minimum velocity [m/s], usually <= 0
+ * \param [in] max_velocity Maximum velocity [m/s], usually >= 0
+ * \param [in] min_acceleration Minimum acceleration [m/s^2], usually <= 0
+ * \param [in] max_acceleration Maximum acceleration [m/s^2], usually >= 0
+ * \param [in] min_jerk Minimum jerk [m/s^3], usually <= 0
+ * \param [in] max_jerk Maximum jerk [m/s^3], usually >= 0
+ * \throw std::runtime_error if the maximum of an enabled limit is NaN
+ */
+inline AxisLimits<double> make_speed_limits(
+  bool has_velocity_limits, bool has_acceleration_limits, bool has_jerk_limits,
+  double min_velocity, double max_velocity, double min_acceleration, double max_acceleration,
+  double min_jerk, double max_jerk)
+{
+  AxisLimits<double> limits;
+  if (has_velocity_limits)
+  {
+    if (std::isnan(max_velocity))
+    {
+      throw std::runtime_error("Cannot apply velocity limits if max_velocity is not specified");
+    }
+    limits.value.min = std::isnan(min_velocity) ? -max_velocity : min_velocity;
+    limits.value.max = max_velocity;
+  }
+  if (has_acceleration_limits)
+  {
+    if (std::isnan(max_acceleration))
+    {
+      throw std::runtime_error(
+        "Cannot apply acceleration limits if max_acceleration is not specified");
+    }
+    limits.derivative.min = std::isnan(min_acceleration) ? -max_acceleration : min_acceleration;
+    limits.derivative.max = max_acceleration;
+  }
+  if (has_jerk_limits)
+  {
+    if (std::isnan(max_jerk))
+    {
+      throw std::runtime_error("Cannot apply jerk limits if max_jerk is not specified");
+    }
+    limits.second_derivative.min = std::isnan(min_jerk) ? -max_jerk : min_jerk;
+    limits.second_derivative.max = max_jerk;
+  }
+  return limits;
+}
+
+}  // namespace motion_limits
+
+#endif  // MOTION_LIMITS__SPEED_LIMITS_HPP_
@@ -0,0 +1,86 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+
+#include "benchmark/benchmark.h"
+
+#include "motion_limits/axis_limiter.hpp"
+#include "motion_limits/speed_limits.hpp"
+
+namespace
+{
+// one cycle at 1 kHz
+constexpr double DT = 1e-3;
+
+template <std::size_t N>
+motion_limits::AxisLimiter<N> make_limiter()
+{
+  motion_limits::AxisLimiter<N> limiter;
+  for (std::size_t i = 0; i < N; ++i)
+  {
+    limiter.set_limits(
+      i, motion_limits::make_speed_limits(true, true, true, NAN, 1.0, NAN, 2.0, NAN, 10.0));
+  }
+  return limiter;
+}
+}  // namespace
+
+// all axes in one pass
+template <std::size_t N>
+static void BM_AxisLimiter(benchmark::State & state)
+{
+  const auto limiter = make_limiter<N>();
+  std::array<double, N> x0{}, x1{};
+  for (auto _ : state)
+  {
+    std::array<double, N> x;
+    x.fill(1.0);
+    limiter.limit(x, x0, x1, DT);
+    x1 = x0;
+    x0 = x;
+    benchmark::DoNotOptimize(x0);
+  }
+}
+BENCHMARK_TEMPLATE(BM_AxisLimiter, 1);
+BENCHMARK_TEMPLATE(BM_AxisLimiter, 2);
+BENCHMARK_TEMPLATE(BM_AxisLimiter, 4);
+BENCHMARK_TEMPLATE(BM_AxisLimiter, 8);
+
+// one limiter per axis, like the scalar limiters
+template <std::size_t N>
+static void BM_ScalarLimiters(benchmark::State & state)
+{
+  std::array<motion_limits::AxisLimiter<1>, N> limiters;
+  limiters.fill(make_limiter<1>());
+  std::array<double, N> x0{}, x1{};
+  for (auto _ : state)
+  {
+    std::array<double, N> x;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      std::array<double, 1> axis{1.0};
+      limiters[i].limit(axis, {x0[i]}, {x1[i]}, DT);
+      x[i] = axis[0];
+    }
+    x1 = x0;
+    x0 = x;
+    benchmark::DoNotOptimize(x0);
+  }
+}
+BENCHMARK_TEMPLATE(BM_ScalarLimiters, 2);
+BENCHMARK_TEMPLATE(BM_ScalarLimiters, 4);
+BENCHMARK_TEMPLATE(BM_ScalarLimiters, 8);
+
+BENCHMARK_MAIN();
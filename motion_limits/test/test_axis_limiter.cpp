@@ -0,0 +1,172 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include "motion_limits/axis_limiter.hpp"
+#include "motion_limits/speed_limits.hpp"
+
+using motion_limits::AxisLimiter;
+using motion_limits::AxisLimits;
+using motion_limits::make_speed_limits;
+
+namespace
+{
+// the scalar limiting of a velocity with asymmetric limits, one axis at a time
+double limit_speed(
+  double v, double v0, double v1, double dt, double max_velocity, double max_acceleration,
+  double max_jerk)
+{
+  const double dv0 = v0 - v1;
+  const double dt2 = 2. * dt * dt;
+  v = v0 + dv0 + std::clamp(v - v0 - dv0, -max_jerk * dt2, max_jerk * dt2);
+  v = v0 + std::clamp(v - v0, -max_acceleration * dt, max_acceleration * dt);
+  return std::clamp(v, -max_velocity, max_velocity);
+}
+}  // namespace
+
+TEST(TestAxisLimiter, unlimited_axes_are_unchanged)
+{
+  AxisLimiter<3> limiter;
+  AxisLimiter<3>::Vector x{1.0, -2.0, 0.0};
+  limiter.limit(x, {0.0, 0.0, 0.0}, {5.0, 5.0, 5.0}, 0.01);
+  EXPECT_THAT(x, testing::ElementsAre(1.0, -2.0, 0.0));
+
+  // also without a time step
+  limiter.limit(x, {0.0, 0.0, 0.0}, {5.0, 5.0, 5.0}, 0.0);
+  EXPECT_THAT(x, testing::ElementsAre(1.0, -2.0, 0.0));
+}
+
+TEST(TestAxisLimiter, speed_limits_match_scalar_limiting)
+{
+  const std::array<double, 3> max_velocity{1.0, 2.0, 0.5};
+  const std::array<double, 3> max_acceleration{0.5, 3.0, 1.0};
+  const std::array<double, 3> max_jerk{5.0, 10.0, 2.0};
+
+  AxisLimiter<3> limiter;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    limiter.set_limits(
+      i, make_speed_limits(
+           true, true, true, NAN, max_velocity[i], NAN, max_acceleration[i], NAN, max_jerk[i]));
+  }
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> velocity(-3.0, 3.0);
+  AxisLimiter<3>::Vector x0{}, x1{};
+  const double dt = 0.01;
+  for (int update = 0; update < 1000; ++update)
+  {
+    AxisLimiter<3>::Vector x{velocity(generator), velocity(generator), velocity(generator)};
+    AxisLimiter<3>::Vector expected;
+    for (size_t i = 0; i < 3; ++i)
+    {
+      expected[i] =
+        limit_speed(x[i], x0[i], x1[i], dt, max_velocity[i], max_acceleration[i], max_jerk[i]);
+    }
+    limiter.limit(x, x0, x1, dt);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      EXPECT_NEAR(x[i], expected[i], 1e-12);
+    }
+    x1 = x0;
+    x0 = x;
+  }
+
+  // only the maximum is required
+  EXPECT_THROW(
+    make_speed_limits(true, false, false, -1.0, NAN, NAN, NAN, NAN, NAN), std::runtime_error);
+  EXPECT_THROW(
+    make_speed_limits(false, true, false, NAN, NAN, -1.0, NAN, NAN, NAN), std::runtime_error);
+  EXPECT_THROW(
+    make_speed_limits(false, false, true, NAN, NAN, NAN, NAN, -1.0, NAN), std::runtime_error);
+  const auto limits = make_speed_limits(true, false, false, -0.5, 1.0, NAN, NAN, NAN, NAN);
+  EXPECT_EQ(limits.value.min, -0.5);
+  EXPECT_EQ(limits.value.max, 1.0);
+}
+
+TEST(TestAxisLimiter, magnitude_and_towards_zero_limits)
+{
+  // a traction wheel that accelerates with 1/s^2 and decelerates with 2/s^2
+  AxisLimits<double> limits;
+  limits.value.max_magnitude = 4.0;
+  limits.derivative.max_magnitude = 1.0;
+  limits.derivative_towards_zero = limits.derivative;
+  limits.derivative_towards_zero->max_magnitude = 2.0;
+
+  AxisLimiter<2> limiter;
+  limiter.set_limits(0, limits);
+  limiter.set_limits(1, limits);
+
+  AxisLimiter<2>::Vector x{5.0, -5.0};
+  limiter.limit_value(x);
+  EXPECT_THAT(x, testing::ElementsAre(4.0, -4.0));
+
+  // accelerating forwards and backwards
+  x = {5.0, -5.0};
+  limiter.limit(x, {1.0, -1.0}, {1.0, -1.0}, 1.0);
+  EXPECT_THAT(x, testing::ElementsAre(2.0, -2.0));
+
+  // decelerating
+  x = {0.0, 0.0};
+  limiter.limit(x, {3.0, -3.0}, {3.0, -3.0}, 1.0);
+  EXPECT_THAT(x, testing::ElementsAre(1.0, -1.0));
+}
+
+TEST(TestAxisLimiter, preview_starts_to_decelerate_in_time)
+{
+  AxisLimiter<1> limiter;
+  limiter.set_limits(0, make_speed_limits(false, true, false, NAN, NAN, NAN, 1.0, NAN, NAN));
+
+  // a stop 0.5 s ahead can be reached from 0.5 m/s at most
+  AxisLimiter<1>::Vector x{1.0};
+  limiter.limit_to_preview(x, {0.0}, 0.5);
+  EXPECT_DOUBLE_EQ(x[0], 0.5);
+  // also with a jerk limit, which spends half of the time ramping the deceleration up and down
+  AxisLimiter<1> jerk_limiter;
+  jerk_limiter.set_limits(0, make_speed_limits(false, true, true, NAN, NAN, NAN, 1.0, NAN, 4.0));
+  x = {1.0};
+  jerk_limiter.limit_to_preview(x, {0.0}, 0.5);
+  EXPECT_DOUBLE_EQ(x[0], 0.25);
+  // without limits, or if the value can reach the planned one
+  x = {1.0};
+  AxisLimiter<1>().limit_to_preview(x, {0.0}, 0.5);
+  EXPECT_EQ(x[0], 1.0);
+  x = {0.25};
+  limiter.limit_to_preview(x, {-0.25}, 0.5);
+  EXPECT_EQ(x[0], 0.25);
+
+  // driving at 1 m/s with a stop planned at 2 s, which is commanded only then
+  const double dt = 0.01;
+  AxisLimiter<1>::Vector with_preview{1.0}, without_preview{1.0};
+  AxisLimiter<1>::Vector with_preview0 = with_preview, without_preview0 = without_preview;
+  for (int update = 1; update <= 200; ++update)
+  {
+    const double time_to_stop = 2.0 - update * dt;
+    const AxisLimiter<1>::Vector reference{time_to_stop > 0.0 ? 1.0 : 0.0};
+    with_preview = reference;
+    limiter.limit_to_preview(with_preview, {0.0}, time_to_stop);
+    limiter.limit(with_preview, with_preview0, with_preview0, dt);
+    without_preview = reference;
+    limiter.limit(without_preview, without_preview0, without_preview0, dt);
+    with_preview0 = with_preview;
+    without_preview0 = without_preview;
+  }
+  EXPECT_NEAR(with_preview[0], 0.0, 1e-9);
+  EXPECT_NEAR(without_preview[0], 1.0 - dt, 1e-9);
+}
@@ -0,0 +1,54 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OBJECT_POOL__MESSAGE_MEMORY_STRATEGY_HPP_
+#define OBJECT_POOL__MESSAGE_MEMORY_STRATEGY_HPP_
+
+#include <memory>
+
+#include "object_pool/object_pool.hpp"
+#include "rclcpp/message_memory_strategy.hpp"
+
+namespace object_pool
+{
+/**
+ * \brief Memory strategy of a subscription taking the msgs it receives from an ObjectPool.
+ *
+ * The executor borrows a msg for every msg it takes from the subscription and releases it after
+ * the callback, so a few msgs are enough unless the callback keeps them.
+ *
+ * \code
+ * subscriber_ = node->create_subscription<geometry_msgs::msg::TwistStamped>(
+ *   "~/cmd_vel", rclcpp::SystemDefaultsQoS(), callback, rclcpp::SubscriptionOptions(),
+ *   std::make_shared<object_pool::PoolMessageMemoryStrategy<geometry_msgs::msg::TwistStamped>>());
+ * \endcode
+ */
+template <typename MessageT>
+class PoolMessageMemoryStrategy
+: public rclcpp::message_memory_strategy::MessageMemoryStrategy<MessageT>
+{
+public:
+  explicit PoolMessageMemoryStrategy(size_t capacity = 4) : pool_(capacity) {}
+
+  std::shared_ptr<MessageT> borrow_message() override { return pool_.make_shared(); }
+
+  const ObjectPool<MessageT> & pool() const { return pool_; }
+
+private:
+  ObjectPool<MessageT> pool_;
+};
+
+}  // namespace object_pool
+
+#endif  // OBJECT_POOL__MESSAGE_MEMORY_STRATEGY_HPP_
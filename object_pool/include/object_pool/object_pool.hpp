@@ -0,0 +1,281 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OBJECT_POOL__OBJECT_POOL_HPP_
+#define OBJECT_POOL__OBJECT_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace object_pool
+{
+/**
+ * \brief Fixed number of equally sized memory blocks, taken and returned lock-free.
+ *
+ * All blocks are allocated by the constructor. The free blocks form a stack of block indices,
+ * whose head is tagged with a counter of its changes, so a block taken and returned by another
+ * thread meanwhile doesn't corrupt the stack (ABA). Blocks can be taken and returned by any
+ * number of threads.
+ */
+class BlockPool
+{
+public:
+  /// Allocate \p capacity blocks of at least \p block_size bytes, not realtime-safe
+  BlockPool(size_t block_size, size_t capacity)
+  : block_size_(round_up(block_size)),
+    capacity_(capacity),
+    blocks_(new std::max_align_t[(block_size_ * capacity_) / alignof(std::max_align_t)]),
+    next_(new std::atomic<uint32_t>[capacity_])
+  {
+    for (size_t index = 0; index < capacity_; ++index)
+    {
+      next_[index].store(
+        index + 1 < capacity_ ? static_cast<uint32_t>(index + 1) : NO_BLOCK,
+        std::memory_order_relaxed);
+    }
+    head_.store(capacity_ > 0 ? 0 : NO_BLOCK, std::memory_order_release);
+    available_.store(capacity_, std::memory_order_relaxed);
+  }
+
+  BlockPool(const BlockPool &) = delete;
+  BlockPool & operator=(const BlockPool &) = delete;
+
+  /// Take a free block, realtime-safe
+  /**
+   * \return nullptr if all blocks are taken
+   */
+  void * allocate() noexcept
+  {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != NO_BLOCK)
+    {
+      const auto index = static_cast<uint32_t>(head);
+      const uint64_t next = tag_of(head) | next_[index].load(std::memory_order_relaxed);
+      if (head_.compare_exchange_weak(
+            head, next, std::memory_order_acq_rel, std::memory_order_acquire))
+      {
+        available_.fetch_sub(1, std::memory_order_relaxed);
+        return block(index);
+      }
+    }
+    return nullptr;
+  }
+
+  /// Return a block taken by allocate(), realtime-safe
+  void deallocate(void * pointer) noexcept
+  {
+    const auto index = static_cast<uint32_t>(
+      (static_cast<std::byte *>(pointer) - reinterpret_cast<std::byte *>(blocks_.get())) /
+      static_cast<std::ptrdiff_t>(block_size_));
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    do
+    {
+      next_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(
+      head, tag_of(head) | index, std::memory_order_release, std::memory_order_relaxed));
+    available_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// True if \p pointer is a block of this pool
+  bool owns(const void * pointer) const noexcept
+  {
+    const auto * begin = reinterpret_cast<const std::byte *>(blocks_.get());
+    const auto * byte = static_cast<const std::byte *>(pointer);
+    return byte >= begin && byte < begin + block_size_ * capacity_;
+  }
+
+  size_t block_size() const noexcept { return block_size_; }
+  size_t capacity() const noexcept { return capacity_; }
+  /// Number of free blocks, only a snapshot if the blocks are used concurrently
+  size_t available() const noexcept { return available_.load(std::memory_order_relaxed); }
+
+  /// Count an allocation of \p size bytes which didn't fit into a block or found none free
+  void count_heap_fallback(size_t size) noexcept
+  {
+    heap_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+    size_t largest = largest_heap_fallback_.load(std::memory_order_relaxed);
+    while (size > largest && !largest_heap_fallback_.compare_exchange_weak(
+                               largest, size, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  /// Number of allocations by the PoolAllocator of this pool which used the heap
+  uint64_t heap_fallbacks() const noexcept
+  {
+    return heap_fallbacks_.load(std::memory_order_relaxed);
+  }
+
+  /// Size in bytes of the largest of heap_fallbacks()
+  size_t largest_heap_fallback() const noexcept
+  {
+    return largest_heap_fallback_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr uint32_t NO_BLOCK = UINT32_MAX;
+
+  static size_t round_up(size_t size)
+  {
+    constexpr size_t alignment = alignof(std::max_align_t);
+    return std::max<size_t>((size + alignment - 1) / alignment, 1) * alignment;
+  }
+
+  /// Tag of the next head after \p head, in the upper 32 bits
+  static uint64_t tag_of(uint64_t head) { return ((head >> 32) + 1) << 32; }
+
+  void * block(uint32_t index) noexcept
+  {
+    return reinterpret_cast<std::byte *>(blocks_.get()) + static_cast<size_t>(index) * block_size_;
+  }
+
+  const size_t block_size_;
+  const size_t capacity_;
+  std::unique_ptr<std::max_align_t[]> blocks_;
+  // index of the free block below every free block in the stack
+  std::unique_ptr<std::atomic<uint32_t>[]> next_;
+  // tag in the upper, index of the top free block in the lower 32 bits
+  std::atomic<uint64_t> head_{NO_BLOCK};
+  std::atomic<size_t> available_{0};
+  std::atomic<uint64_t> heap_fallbacks_{0};
+  std::atomic<size_t> largest_heap_fallback_{0};
+};
+
+/**
+ * \brief Allocator taking single objects from a BlockPool, e.g., for std::allocate_shared.
+ *
+ * Allocations of single objects which fit into a block are realtime-safe while the pool has free
+ * blocks. Other allocations, and those of an exhausted pool, fall back to the heap and are counted
+ * by the pool. The allocators rebound from each other share the pool, and keep it alive as long as
+ * one of its blocks may be in use, e.g., by a shared_ptr outliving its ObjectPool.
+ */
+template <typename T>
+class PoolAllocator
+{
+public:
+  using value_type = T;
+
+  explicit PoolAllocator(std::shared_ptr<BlockPool> pool) noexcept : pool_(std::move(pool)) {}
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> & other) noexcept  // NOLINT(runtime/explicit)
+  : pool_(other.pool())
+  {
+  }
+
+  T * allocate(size_t count)
+  {
+    if (
+      count == 1 && sizeof(T) <= pool_->block_size() &&
+      alignof(T) <= alignof(std::max_align_t))
+    {
+      if (void * block = pool_->allocate())
+      {
+        return static_cast<T *>(block);
+      }
+    }
+    pool_->count_heap_fallback(count * sizeof(T));
+    return std::allocator<T>().allocate(count);
+  }
+
+  void deallocate(T * pointer, size_t count) noexcept
+  {
+    if (pool_->owns(pointer))
+    {
+      pool_->deallocate(pointer);
+    }
+    else
+    {
+      std::allocator<T>().deallocate(pointer, count);
+    }
+  }
+
+  const std::shared_ptr<BlockPool> & pool() const noexcept { return pool_; }
+
+private:
+  std::shared_ptr<BlockPool> pool_;
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T> & lhs, const PoolAllocator<U> & rhs) noexcept
+{
+  return lhs.pool() == rhs.pool();
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T> & lhs, const PoolAllocator<U> & rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+/**
+ * \brief Fixed number of preallocated shared objects, created and released lock-free.
+ *
+ * make_shared() places the object and its control block together in one block of the pool, like
+ * std::make_shared() does on the heap. Releasing the last reference returns the block from any
+ * thread. If all blocks are in use, the objects are allocated on the heap, see heap_fallbacks().
+ *
+ * \code
+ * // on configuration
+ * object_pool::ObjectPool<FollowJTrajAction::Result> result_pool(8);
+ * // in the control loop
+ * auto result = result_pool.make_shared();
+ * \endcode
+ */
+template <typename T>
+class ObjectPool
+{
+public:
+  /// Allocate the blocks of \p capacity objects, not realtime-safe
+  /**
+   * The size of the blocks is the size std::allocate_shared() requests for T and its control
+   * block, which is implementation-defined. It is measured by creating one object on the heap.
+   */
+  explicit ObjectPool(size_t capacity)
+  {
+    auto probe = std::make_shared<BlockPool>(0, 0);
+    std::allocate_shared<T>(PoolAllocator<T>(probe));
+    pool_ = std::make_shared<BlockPool>(probe->largest_heap_fallback(), capacity);
+  }
+
+  /// Create an object in a free block, realtime-safe if the pool isn't exhausted
+  /**
+   * Constructing T itself is realtime-safe only if \p args don't make it allocate memory.
+   */
+  template <typename... Args>
+  std::shared_ptr<T> make_shared(Args &&... args)
+  {
+    return std::allocate_shared<T>(get_allocator(), std::forward<Args>(args)...);
+  }
+
+  PoolAllocator<T> get_allocator() const noexcept { return PoolAllocator<T>(pool_); }
+
+  size_t capacity() const noexcept { return pool_->capacity(); }
+  /// Number of objects which can be created without the heap
+  size_t available() const noexcept { return pool_->available(); }
+  /// Number of objects allocated on the heap because the pool was exhausted
+  uint64_t heap_fallbacks() const noexcept { return pool_->heap_fallbacks(); }
+
+private:
+  std::shared_ptr<BlockPool> pool_;
+};
+
+}  // namespace object_pool
+
+#endif  // OBJECT_POOL__OBJECT_POOL_HPP_
@@ -0,0 +1,162 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "object_pool/object_pool.hpp"
+
+using object_pool::BlockPool;
+using object_pool::ObjectPool;
+using object_pool::PoolAllocator;
+
+namespace
+{
+struct Result
+{
+  Result() = default;
+  Result(int code, double value) : code(code), value(value) {}
+
+  int code = 0;
+  double value = 0.0;
+  std::array<double, 6> payload{};
+};
+}  // namespace
+
+TEST(TestBlockPool, hands_out_every_block_once)
+{
+  BlockPool pool(24, 3);
+  EXPECT_EQ(pool.block_size() % alignof(std::max_align_t), 0u);
+  EXPECT_GE(pool.block_size(), 24u);
+
+  std::vector<void *> blocks;
+  for (int i = 0; i < 3; ++i)
+  {
+    blocks.push_back(pool.allocate());
+    ASSERT_NE(blocks.back(), nullptr);
+    EXPECT_TRUE(pool.owns(blocks.back()));
+  }
+  EXPECT_EQ(pool.allocate(), nullptr);
+  EXPECT_EQ(pool.available(), 0u);
+  EXPECT_NE(blocks[0], blocks[1]);
+  EXPECT_NE(blocks[1], blocks[2]);
+  EXPECT_NE(blocks[0], blocks[2]);
+
+  pool.deallocate(blocks[1]);
+  EXPECT_EQ(pool.available(), 1u);
+  EXPECT_EQ(pool.allocate(), blocks[1]);
+
+  int other = 0;
+  EXPECT_FALSE(pool.owns(&other));
+}
+
+TEST(TestObjectPool, objects_are_created_in_the_blocks)
+{
+  ObjectPool<Result> pool(2);
+  EXPECT_EQ(pool.capacity(), 2u);
+  EXPECT_EQ(pool.available(), 2u);
+
+  auto first = pool.make_shared(1, 0.5);
+  EXPECT_EQ(first->code, 1);
+  EXPECT_DOUBLE_EQ(first->value, 0.5);
+  EXPECT_EQ(pool.available(), 1u);
+  {
+    auto second = pool.make_shared();
+    EXPECT_EQ(pool.available(), 0u);
+  }
+  // releasing the last reference returns the block
+  EXPECT_EQ(pool.available(), 1u);
+  first.reset();
+  EXPECT_EQ(pool.available(), 2u);
+  EXPECT_EQ(pool.heap_fallbacks(), 0u);
+}
+
+TEST(TestObjectPool, exhausted_pool_falls_back_to_the_heap)
+{
+  ObjectPool<Result> pool(1);
+  auto pooled = pool.make_shared(1, 1.0);
+  auto allocated = pool.make_shared(2, 2.0);
+  EXPECT_EQ(pool.heap_fallbacks(), 1u);
+  EXPECT_EQ(allocated->code, 2);
+
+  allocated.reset();
+  EXPECT_EQ(pool.available(), 0u);
+  pooled.reset();
+  EXPECT_EQ(pool.available(), 1u);
+}
+
+TEST(TestObjectPool, objects_outlive_the_pool)
+{
+  std::shared_ptr<std::string> name;
+  {
+    ObjectPool<std::string> pool(1);
+    name = pool.make_shared("joint_trajectory_controller");
+  }
+  EXPECT_EQ(*name, "joint_trajectory_controller");
+  name.reset();
+}
+
+TEST(TestObjectPool, allocator_serves_containers)
+{
+  ObjectPool<double> pool(2);
+  // arrays don't fit into the blocks
+  std::vector<double, PoolAllocator<double>> values(pool.get_allocator());
+  values.assign(16, 1.0);
+  EXPECT_EQ(pool.heap_fallbacks(), 1u);
+  EXPECT_EQ(pool.available(), 2u);
+  EXPECT_EQ(pool.get_allocator(), values.get_allocator());
+  EXPECT_NE(pool.get_allocator(), ObjectPool<double>(1).get_allocator());
+}
+
+TEST(TestObjectPool, threads_share_the_pool)
+{
+  constexpr int thread_count = 4;
+  constexpr int iterations = 20000;
+  ObjectPool<Result> pool(thread_count * 2);
+
+  std::vector<std::thread> threads;
+  std::vector<int> errors(thread_count, 0);
+  for (int thread = 0; thread < thread_count; ++thread)
+  {
+    threads.emplace_back(
+      [&pool, &errors, thread]()
+      {
+        for (int i = 0; i < iterations; ++i)
+        {
+          auto first = pool.make_shared(thread, static_cast<double>(i));
+          auto second = pool.make_shared(thread, -static_cast<double>(i));
+          // a block handed out twice would be overwritten by another thread
+          if (
+            first->code != thread || second->code != thread ||
+            first->value != static_cast<double>(i) || second->value != -static_cast<double>(i))
+          {
+            ++errors[static_cast<size_t>(thread)];
+          }
+        }
+      });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_THAT(errors, ::testing::Each(0));
+  EXPECT_EQ(pool.heap_fallbacks(), 0u);
+  EXPECT_EQ(pool.available(), pool.capacity());
+}
@@ -0,0 +1,55 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ODOMETRY_EXCHANGE__ODOMETRY_EXCHANGE_HPP_
+#define ODOMETRY_EXCHANGE__ODOMETRY_EXCHANGE_HPP_
+
+#include <cstdint>
+
+#include "command_mailbox/named_slot_registry.hpp"
+#include "odometry_exchange/visibility_control.h"
+
+namespace odometry_exchange
+{
+/// Planar odometry of a mobile base at one update
+struct OdometryState
+{
+  int64_t stamp_nanoseconds = 0;
+  double x = 0.0;
+  double y = 0.0;
+  double yaw = 0.0;
+  // velocities in the base frame
+  double linear = 0.0;
+  double lateral = 0.0;
+  double angular = 0.0;
+};
+
+/// Latest odometry of one controller, written by its update and read by the other controllers
+using OdometrySlot = command_mailbox::NamedMailbox<OdometryState>;
+
+/// Odometry slots of all controllers in this process, by name
+class OdometryExchange : public command_mailbox::NamedSlotRegistry<OdometrySlot>
+{
+public:
+  /// The exchange of this process
+  ODOMETRY_EXCHANGE_PUBLIC
+  static OdometryExchange & get_instance();
+
+private:
+  OdometryExchange() = default;
+};
+
+}  // namespace odometry_exchange
+
+#endif  // ODOMETRY_EXCHANGE__ODOMETRY_EXCHANGE_HPP_
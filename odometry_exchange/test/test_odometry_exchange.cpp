@@ -0,0 +1,92 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "odometry_exchange/odometry_exchange.hpp"
+
+using odometry_exchange::OdometryExchange;
+using odometry_exchange::OdometryState;
+
+TEST(TestOdometryExchange, slots_are_shared_by_name)
+{
+  auto & exchange = OdometryExchange::get_instance();
+  EXPECT_EQ(&exchange, &OdometryExchange::get_instance());
+
+  auto writer_slot = exchange.get_slot("/first_controller");
+  auto reader_slot = exchange.get_slot("/first_controller");
+  EXPECT_EQ(writer_slot, reader_slot);
+  EXPECT_NE(writer_slot, exchange.get_slot("/second_controller"));
+  EXPECT_EQ(writer_slot->get_name(), "/first_controller");
+}
+
+TEST(TestOdometryExchange, latest_odometry_is_read)
+{
+  auto slot = OdometryExchange::get_instance().get_slot("/latest_controller");
+
+  OdometryState state;
+  state.x = -1.0;
+  EXPECT_FALSE(slot->read(state));
+  EXPECT_DOUBLE_EQ(state.x, -1.0);
+
+  slot->write({100, 1.0, 2.0, 0.5, 0.1, 0.0, -0.2});
+  slot->write({200, 3.0, 4.0, 1.5, 0.3, 0.05, -0.4});
+  ASSERT_TRUE(slot->read(state));
+  EXPECT_EQ(state.stamp_nanoseconds, 200);
+  EXPECT_DOUBLE_EQ(state.x, 3.0);
+  EXPECT_DOUBLE_EQ(state.y, 4.0);
+  EXPECT_DOUBLE_EQ(state.yaw, 1.5);
+  EXPECT_DOUBLE_EQ(state.linear, 0.3);
+  EXPECT_DOUBLE_EQ(state.lateral, 0.05);
+  EXPECT_DOUBLE_EQ(state.angular, -0.4);
+}
+
+TEST(TestOdometryExchange, concurrent_reads_are_consistent)
+{
+  auto slot = OdometryExchange::get_instance().get_slot("/concurrent_controller");
+  std::atomic<bool> keep_writing{true};
+  std::thread writer(
+    [&]()
+    {
+      for (int64_t i = 1; keep_writing; ++i)
+      {
+        const auto value = static_cast<double>(i);
+        slot->write({i, value, value, value, value, value, value});
+      }
+    });
+
+  size_t num_reads = 0;
+  while (num_reads < 10000)
+  {
+    OdometryState state;
+    if (slot->read(state))
+    {
+      const auto value = static_cast<double>(state.stamp_nanoseconds);
+      ASSERT_DOUBLE_EQ(state.x, value);
+      ASSERT_DOUBLE_EQ(state.y, value);
+      ASSERT_DOUBLE_EQ(state.yaw, value);
+      ASSERT_DOUBLE_EQ(state.linear, value);
+      ASSERT_DOUBLE_EQ(state.lateral, value);
+      ASSERT_DOUBLE_EQ(state.angular, value);
+      ++num_reads;
+    }
+  }
+  keep_writing = false;
+  writer.join();
+}
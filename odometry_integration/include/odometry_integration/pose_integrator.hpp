@@ -0,0 +1,252 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ODOMETRY_INTEGRATION__POSE_INTEGRATOR_HPP_
+#define ODOMETRY_INTEGRATION__POSE_INTEGRATOR_HPP_
+
+#include <array>
+#include <cmath>
+
+namespace odometry_integration
+{
+/// Plain floating point sum
+template <typename Scalar>
+class NaiveSum
+{
+public:
+  void add(Scalar increment) { sum_ += increment; }
+  Scalar value() const { return sum_; }
+  void reset() { sum_ = Scalar(0); }
+
+private:
+  Scalar sum_ = Scalar(0);
+};
+
+/**
+ * \brief Compensated sum (Kahan-Babuska-Neumaier).
+ *
+ * The rounding errors of adding many small increments to a large sum are carried along instead of
+ * being lost, e.g. when integrating at a high rate far away from the origin.
+ */
+template <typename Scalar>
+class CompensatedSum
+{
+public:
+  void add(Scalar increment)
+  {
+    const Scalar sum = sum_ + increment;
+    if (std::fabs(sum_) >= std::fabs(increment))
+    {
+      compensation_ += (sum_ - sum) + increment;
+    }
+    else
+    {
+      compensation_ += (increment - sum) + sum_;
+    }
+    sum_ = sum;
+  }
+  Scalar value() const { return sum_ + compensation_; }
+  void reset()
+  {
+    sum_ = Scalar(0);
+    compensation_ = Scalar(0);
+  }
+
+private:
+  Scalar sum_ = Scalar(0);
+  Scalar compensation_ = Scalar(0);
+};
+
+/// Derivatives of one integration step, for propagating the covariance of the pose
+template <typename Scalar>
+struct StepJacobian
+{
+  /// Derivatives of x and y with respect to the heading before the step
+  Scalar dx_dheading = Scalar(0);
+  Scalar dy_dheading = Scalar(0);
+  /// Derivatives of x, y and heading with respect to the linear and angular displacement,
+  /// row-major
+  std::array<Scalar, 6> input{};
+};
+
+/**
+ * \brief Planar pose of a mobile base, integrated from the displacements of each update.
+ *
+ * Shared by the odometry of the mobile base controllers, which estimate the displacements from
+ * their kinematics. Header-only, realtime-safe.
+ *
+ * \tparam Scalar floating point type of the pose
+ * \tparam Sum summation of the pose increments, NaiveSum or CompensatedSum
+ */
+template <typename Scalar = double, template <typename> class Sum = CompensatedSum>
+class PoseIntegrator
+{
+public:
+  /// Below this angular displacement [rad], integrate_exact() uses integrate_runge_kutta_2()
+  static constexpr Scalar EXACT_THRESHOLD = Scalar(1e-6);
+
+  Scalar x() const { return x_.value(); }
+  Scalar y() const { return y_.value(); }
+  Scalar heading() const { return heading_.value(); }
+
+  /// Move the pose back to the origin
+  void reset()
+  {
+    x_.reset();
+    y_.reset();
+    heading_.reset();
+  }
+
+  /// Move the pose to \p x, \p y and \p heading, e.g. to continue a persisted odometry
+  void reset(Scalar x, Scalar y, Scalar heading)
+  {
+    reset();
+    x_.add(x);
+    y_.add(y);
+    heading_.add(heading);
+  }
+
+  /**
+   * \brief Integrates the displacements with 2nd order Runge-Kutta
+   * \param[in] linear  Linear  displacement [m]
+   * \param[in] angular Angular displacement [rad]
+   * \param[out] jacobian derivatives of the step, if not nullptr
+   */
+  void integrate_runge_kutta_2(
+    Scalar linear, Scalar angular, StepJacobian<Scalar> * jacobian = nullptr)
+  {
+    const Scalar direction = heading() + angular * Scalar(0.5);
+    const Scalar cos_direction = std::cos(direction);
+    const Scalar sin_direction = std::sin(direction);
+
+    if (jacobian != nullptr)
+    {
+      jacobian->dx_dheading = -linear * sin_direction;
+      jacobian->dy_dheading = linear * cos_direction;
+      jacobian->input = {cos_direction, Scalar(-0.5) * linear * sin_direction, sin_direction,
+                         Scalar(0.5) * linear * cos_direction, Scalar(0), Scalar(1)};
+    }
+
+    x_.add(linear * cos_direction);
+    y_.add(linear * sin_direction);
+    heading_.add(angular);
+  }
+
+  /**
+   * \brief Integrates the displacements exactly, assuming a constant twist during the step
+   * \param[in] linear  Linear  displacement [m]
+   * \param[in] angular Angular displacement [rad]
+   * \param[out] jacobian derivatives of the step, if not nullptr
+   */
+  void integrate_exact(Scalar linear, Scalar angular, StepJacobian<Scalar> * jacobian = nullptr)
+  {
+    if (std::fabs(angular) < EXACT_THRESHOLD)
+    {
+      integrate_runge_kutta_2(linear, angular, jacobian);
+      return;
+    }
+
+    const Scalar heading_old = heading();
+    const Scalar heading_new = heading_old + angular;
+    const Scalar r = linear / angular;
+    const Scalar delta_sin = std::sin(heading_new) - std::sin(heading_old);
+    const Scalar delta_cos = std::cos(heading_new) - std::cos(heading_old);
+
+    if (jacobian != nullptr)
+    {
+      jacobian->dx_dheading = r * delta_cos;
+      jacobian->dy_dheading = r * delta_sin;
+      jacobian->input = {
+        delta_sin / angular,  -r / angular * delta_sin + r * std::cos(heading_new),
+        -delta_cos / angular, r / angular * delta_cos + r * std::sin(heading_new),
+        Scalar(0),            Scalar(1)};
+    }
+
+    x_.add(r * delta_sin);
+    y_.add(-r * delta_cos);
+    heading_.add(angular);
+  }
+
+  /**
+   * \brief Integrates the displacements of an update exactly in \p substeps, with changing rates.
+   *
+   * The rates change linearly during the update, by their difference to the previous update and
+   * centered on the rates of this update, so the total displacements stay the given ones. This
+   * follows accelerating turns more closely than one step with a constant twist.
+   * \param[in] linear  Linear  displacement of this update [m]
+   * \param[in] angular Angular displacement of this update [rad]
+   * \param[in] previous_linear  Linear  displacement of the previous update, scaled to the
+   * duration of this update [m]
+   * \param[in] previous_angular Angular displacement of the previous update, scaled to the
+   * duration of this update [rad]
+   * \param[in] substeps number of steps, 1 integrates like integrate_exact()
+   */
+  void integrate_substeps(
+    Scalar linear, Scalar angular, Scalar previous_linear, Scalar previous_angular,
+    unsigned int substeps)
+  {
+    if (substeps <= 1)
+    {
+      integrate_exact(linear, angular);
+      return;
+    }
+    const Scalar n = static_cast<Scalar>(substeps);
+    const Scalar linear_change = linear - previous_linear;
+    const Scalar angular_change = angular - previous_angular;
+    for (unsigned int i = 0; i < substeps; ++i)
+    {
+      // offset of the middle of the sub-step from the middle of the update, in updates
+      const Scalar offset = (static_cast<Scalar>(i) + Scalar(0.5)) / n - Scalar(0.5);
+      integrate_exact(
+        (linear + linear_change * offset) / n, (angular + angular_change * offset) / n);
+    }
+  }
+
+  /**
+   * \brief Integrates displacements with a lateral component, assuming a constant body twist
+   * \param[in] linear  Linear  displacement [m]
+   * \param[in] lateral Lateral displacement [m]
+   * \param[in] angular Angular displacement [rad]
+   */
+  void integrate_holonomic(Scalar linear, Scalar lateral, Scalar angular)
+  {
+    const Scalar heading_old = heading();
+    if (std::fabs(angular) < EXACT_THRESHOLD)
+    {
+      const Scalar direction = heading_old + angular * Scalar(0.5);
+      const Scalar cos_direction = std::cos(direction);
+      const Scalar sin_direction = std::sin(direction);
+      x_.add(linear * cos_direction - lateral * sin_direction);
+      y_.add(linear * sin_direction + lateral * cos_direction);
+    }
+    else
+    {
+      const Scalar heading_new = heading_old + angular;
+      const Scalar delta_sin = std::sin(heading_new) - std::sin(heading_old);
+      const Scalar delta_cos = std::cos(heading_new) - std::cos(heading_old);
+      x_.add((linear * delta_sin + lateral * delta_cos) / angular);
+      y_.add((lateral * delta_sin - linear * delta_cos) / angular);
+    }
+    heading_.add(angular);
+  }
+
+private:
+  Sum<Scalar> x_;
+  Sum<Scalar> y_;
+  Sum<Scalar> heading_;
+};
+
+}  // namespace odometry_integration
+
+#endif  // ODOMETRY_INTEGRATION__POSE_INTEGRATOR_HPP_
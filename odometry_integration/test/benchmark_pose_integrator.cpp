@@ -0,0 +1,75 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark/benchmark.h"
+
+#include "odometry_integration/pose_integrator.hpp"
+
+namespace
+{
+// displacements of one cycle at 1 kHz, driving a wide curve
+constexpr double LINEAR = 1e-3;
+constexpr double ANGULAR = 2e-4;
+}  // namespace
+
+template <template <typename> class Sum>
+static void BM_IntegrateExact(benchmark::State & state)
+{
+  odometry_integration::PoseIntegrator<double, Sum> pose;
+  for (auto _ : state)
+  {
+    pose.integrate_exact(LINEAR, ANGULAR);
+    benchmark::DoNotOptimize(pose);
+  }
+}
+BENCHMARK_TEMPLATE(BM_IntegrateExact, odometry_integration::NaiveSum);
+BENCHMARK_TEMPLATE(BM_IntegrateExact, odometry_integration::CompensatedSum);
+
+template <template <typename> class Sum>
+static void BM_IntegrateRungeKutta2(benchmark::State & state)
+{
+  odometry_integration::PoseIntegrator<double, Sum> pose;
+  for (auto _ : state)
+  {
+    pose.integrate_runge_kutta_2(LINEAR, ANGULAR);
+    benchmark::DoNotOptimize(pose);
+  }
+}
+BENCHMARK_TEMPLATE(BM_IntegrateRungeKutta2, odometry_integration::NaiveSum);
+BENCHMARK_TEMPLATE(BM_IntegrateRungeKutta2, odometry_integration::CompensatedSum);
+
+static void BM_IntegrateExactWithJacobian(benchmark::State & state)
+{
+  odometry_integration::PoseIntegrator<> pose;
+  odometry_integration::StepJacobian<double> jacobian;
+  for (auto _ : state)
+  {
+    pose.integrate_exact(LINEAR, ANGULAR, &jacobian);
+    benchmark::DoNotOptimize(jacobian);
+  }
+}
+BENCHMARK(BM_IntegrateExactWithJacobian);
+
+static void BM_IntegrateHolonomic(benchmark::State & state)
+{
+  odometry_integration::PoseIntegrator<> pose;
+  for (auto _ : state)
+  {
+    pose.integrate_holonomic(LINEAR, 0.5 * LINEAR, ANGULAR);
+    benchmark::DoNotOptimize(pose);
+  }
+}
+BENCHMARK(BM_IntegrateHolonomic);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,186 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+
+#include "odometry_integration/pose_integrator.hpp"
+
+using odometry_integration::CompensatedSum;
+using odometry_integration::NaiveSum;
+using odometry_integration::PoseIntegrator;
+using odometry_integration::StepJacobian;
+
+TEST(TestPoseIntegrator, exact_integration_follows_circle)
+{
+  PoseIntegrator<> pose;
+
+  // a quarter circle with a radius of 2 m in 100 steps
+  for (int i = 0; i < 100; ++i)
+  {
+    pose.integrate_exact(M_PI / 100.0, M_PI_2 / 100.0);
+  }
+  EXPECT_NEAR(pose.x(), 2.0, 1e-12);
+  EXPECT_NEAR(pose.y(), 2.0, 1e-12);
+  EXPECT_NEAR(pose.heading(), M_PI_2, 1e-12);
+
+  pose.reset();
+  EXPECT_EQ(pose.x(), 0.0);
+  EXPECT_EQ(pose.y(), 0.0);
+  EXPECT_EQ(pose.heading(), 0.0);
+
+  pose.reset(1.5, -2.5, 0.25);
+  EXPECT_EQ(pose.x(), 1.5);
+  EXPECT_EQ(pose.y(), -2.5);
+  EXPECT_EQ(pose.heading(), 0.25);
+}
+
+TEST(TestPoseIntegrator, runge_kutta_2_is_used_when_driving_straight)
+{
+  PoseIntegrator<> exact;
+  PoseIntegrator<> runge_kutta;
+  exact.integrate_exact(1.0, 0.0);
+  runge_kutta.integrate_runge_kutta_2(1.0, 0.0);
+  EXPECT_EQ(exact.x(), runge_kutta.x());
+  EXPECT_EQ(exact.y(), runge_kutta.y());
+
+  // a small rotation does not divide by zero
+  exact.integrate_exact(1.0, 1e-9);
+  EXPECT_NEAR(exact.x(), 2.0, 1e-9);
+  EXPECT_NEAR(exact.y(), 0.0, 1e-9);
+}
+
+TEST(TestPoseIntegrator, holonomic_integration_matches_exact_without_lateral)
+{
+  PoseIntegrator<> exact;
+  PoseIntegrator<> holonomic;
+  for (int i = 0; i < 10; ++i)
+  {
+    exact.integrate_exact(0.1, 0.05);
+    holonomic.integrate_holonomic(0.1, 0.0, 0.05);
+  }
+  EXPECT_NEAR(holonomic.x(), exact.x(), 1e-12);
+  EXPECT_NEAR(holonomic.y(), exact.y(), 1e-12);
+  EXPECT_NEAR(holonomic.heading(), exact.heading(), 1e-12);
+
+  // driving sideways to the left while heading forward
+  holonomic.reset();
+  holonomic.integrate_holonomic(0.0, 1.0, 0.0);
+  EXPECT_NEAR(holonomic.x(), 0.0, 1e-12);
+  EXPECT_NEAR(holonomic.y(), 1.0, 1e-12);
+}
+
+TEST(TestPoseIntegrator, substeps_follow_accelerating_turn)
+{
+  // 1 m/s while the angular velocity rises by 10 rad/s^2, updated at 100 Hz
+  const double linear_velocity = 1.0;
+  const double angular_acceleration = 10.0;
+  const double dt = 0.01;
+  const int updates = 50;
+
+  // reference with 1000 steps per update
+  PoseIntegrator<> reference;
+  const int reference_steps = 1000;
+  for (int i = 0; i < updates * reference_steps; ++i)
+  {
+    const double t = (i + 0.5) * dt / reference_steps;
+    reference.integrate_exact(
+      linear_velocity * dt / reference_steps, angular_acceleration * t * dt / reference_steps);
+  }
+
+  PoseIntegrator<> single_step;
+  PoseIntegrator<> substeps;
+  double previous_angular = 0.0;
+  for (int i = 0; i < updates; ++i)
+  {
+    // rotation measured during the update
+    const double angular = angular_acceleration * (i + 0.5) * dt * dt;
+    single_step.integrate_exact(linear_velocity * dt, angular);
+    substeps.integrate_substeps(
+      linear_velocity * dt, angular, linear_velocity * dt, previous_angular, 10);
+    previous_angular = angular;
+  }
+
+  // the total rotation is the measured one
+  EXPECT_NEAR(substeps.heading(), single_step.heading(), 1e-12);
+  const double single_step_error =
+    std::hypot(single_step.x() - reference.x(), single_step.y() - reference.y());
+  const double substeps_error =
+    std::hypot(substeps.x() - reference.x(), substeps.y() - reference.y());
+  EXPECT_LT(substeps_error, 0.1 * single_step_error);
+
+  // one sub-step is a single step
+  PoseIntegrator<> one_substep;
+  one_substep.integrate_substeps(0.1, 0.2, 0.0, 0.0, 1);
+  single_step.reset();
+  single_step.integrate_exact(0.1, 0.2);
+  EXPECT_EQ(one_substep.x(), single_step.x());
+  EXPECT_EQ(one_substep.y(), single_step.y());
+}
+
+TEST(TestPoseIntegrator, jacobian_matches_finite_differences)
+{
+  const double heading = 0.3;
+  const double linear = 0.2;
+  for (const double angular : {0.0, 0.1})
+  {
+    // pose after one step from the heading, with the given displacements
+    const auto step = [](double start_heading, double step_linear, double step_angular)
+    {
+      PoseIntegrator<> pose;
+      pose.integrate_exact(0.0, start_heading);
+      const double x = pose.x();
+      const double y = pose.y();
+      pose.integrate_exact(step_linear, step_angular);
+      return std::array<double, 3>{pose.x() - x, pose.y() - y, pose.heading()};
+    };
+
+    PoseIntegrator<> pose;
+    pose.integrate_exact(0.0, heading);
+    StepJacobian<double> jacobian;
+    pose.integrate_exact(linear, angular, &jacobian);
+
+    const double delta = 1e-7;
+    const auto nominal = step(heading, linear, angular);
+    const auto heading_step = step(heading + delta, linear, angular);
+    const auto linear_step = step(heading, linear + delta, angular);
+    const auto angular_step = step(heading, linear, angular + delta);
+    EXPECT_NEAR(jacobian.dx_dheading, (heading_step[0] - nominal[0]) / delta, 1e-6);
+    EXPECT_NEAR(jacobian.dy_dheading, (heading_step[1] - nominal[1]) / delta, 1e-6);
+    for (size_t row = 0; row < 3; ++row)
+    {
+      EXPECT_NEAR(jacobian.input[2 * row], (linear_step[row] - nominal[row]) / delta, 1e-6);
+      EXPECT_NEAR(jacobian.input[2 * row + 1], (angular_step[row] - nominal[row]) / delta, 1e-6);
+    }
+  }
+}
+
+TEST(TestPoseIntegrator, compensated_sum_keeps_small_increments)
+{
+  // one hour at 1 kHz with 10 um per cycle, far away from the origin
+  NaiveSum<double> naive;
+  CompensatedSum<double> compensated;
+  naive.add(1e6);
+  compensated.add(1e6);
+  const int steps = 3600 * 1000;
+  for (int i = 0; i < steps; ++i)
+  {
+    naive.add(1e-5);
+    compensated.add(1e-5);
+  }
+  const double expected = 1e6 + 1e-5 * steps;
+  EXPECT_NEAR(compensated.value(), expected, 1e-9);
+  EXPECT_GT(std::fabs(naive.value() - expected), 1e-6);
+}
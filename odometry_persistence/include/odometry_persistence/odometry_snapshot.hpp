@@ -0,0 +1,134 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ODOMETRY_PERSISTENCE__ODOMETRY_SNAPSHOT_HPP_
+#define ODOMETRY_PERSISTENCE__ODOMETRY_SNAPSHOT_HPP_
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "odometry_persistence/visibility_control.h"
+
+namespace odometry_persistence
+{
+/// State of the odometry of a mobile base at one update, to continue from after a restart
+struct OdometrySnapshot
+{
+  static constexpr size_t MAX_WHEELS = 16;
+
+  int64_t stamp_nanoseconds = 0;
+  double x = 0.0;
+  double y = 0.0;
+  double heading = 0.0;
+  // estimated velocities in the base frame
+  double linear = 0.0;
+  double lateral = 0.0;
+  double angular = 0.0;
+  // last wheel positions of the odometry, in the units it keeps them
+  size_t num_wheels = 0;
+  std::array<double, MAX_WHEELS> wheel_positions{};
+};
+
+/**
+ * Write \p snapshot to the file \p path, not realtime-safe.
+ *
+ * The snapshot is written to a temporary file next to \p path first, which then replaces it, so
+ * the file is never left incomplete.
+ *
+ * \return false if the file can't be written, with the reason in \p error
+ */
+ODOMETRY_PERSISTENCE_PUBLIC
+bool save_snapshot(
+  const std::string & path, const OdometrySnapshot & snapshot, std::string & error);
+
+/**
+ * Read the snapshot written by save_snapshot() from the file \p path, not realtime-safe.
+ *
+ * \return false if the file doesn't exist or isn't a snapshot, with the reason in \p error.
+ * \p snapshot is not changed in that case.
+ */
+ODOMETRY_PERSISTENCE_PUBLIC
+bool load_snapshot(const std::string & path, OdometrySnapshot & snapshot, std::string & error);
+
+/**
+ * \brief Writes the latest snapshot of a controller periodically from a background thread.
+ *
+ * The control loop hands the snapshot over with update(), which neither waits nor allocates
+ * memory: if the thread is copying the previous snapshot, the snapshot of this update is skipped.
+ * The thread writes the file only if a new snapshot arrived since the last write.
+ */
+class SnapshotWriter
+{
+public:
+  /// Called from the writer thread with the reason if writing the file failed
+  using ErrorCallback = std::function<void(const std::string &)>;
+
+  /**
+   * Start the thread writing to \p path every \p period, not realtime-safe.
+   *
+   * \p on_error is called for the first failure and again after a successful write.
+   */
+  ODOMETRY_PERSISTENCE_PUBLIC
+  SnapshotWriter(
+    const std::string & path, std::chrono::nanoseconds period, ErrorCallback on_error = nullptr);
+
+  /// Stop the thread and write the latest snapshot
+  ODOMETRY_PERSISTENCE_PUBLIC
+  ~SnapshotWriter();
+
+  SnapshotWriter(const SnapshotWriter &) = delete;
+  SnapshotWriter & operator=(const SnapshotWriter &) = delete;
+
+  /// Hand over the snapshot of this update, realtime-safe. Only one thread may call it.
+  ODOMETRY_PERSISTENCE_PUBLIC
+  void update(const OdometrySnapshot & snapshot);
+
+  /// Write the latest snapshot now if it wasn't written yet, not realtime-safe
+  ODOMETRY_PERSISTENCE_PUBLIC
+  bool flush();
+
+  const std::string & get_path() const { return path_; }
+
+private:
+  void run();
+
+  std::string path_;
+  std::chrono::nanoseconds period_;
+  ErrorCallback on_error_;
+
+  // the latest snapshot, guarded by mutex_; the control loop only tries to lock it
+  std::mutex mutex_;
+  OdometrySnapshot latest_;
+  bool has_new_snapshot_ = false;
+
+  // serializes the writes of the thread and flush()
+  std::mutex write_mutex_;
+  bool has_failed_ = false;
+
+  std::mutex stop_mutex_;
+  std::condition_variable stop_condition_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace odometry_persistence
+
+#endif  // ODOMETRY_PERSISTENCE__ODOMETRY_SNAPSHOT_HPP_
@@ -0,0 +1,199 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "odometry_persistence/odometry_snapshot.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <locale>
+#include <string>
+#include <utility>
+
+namespace odometry_persistence
+{
+namespace
+{
+constexpr char MAGIC[] = "odometry_snapshot";
+constexpr int VERSION = 1;
+
+// reads "<key> <value>", the values are written in the classic locale
+template <typename T>
+bool read_value(std::istream & stream, const char * key, T & value)
+{
+  std::string name;
+  return static_cast<bool>(stream >> name) && name == key && static_cast<bool>(stream >> value);
+}
+}  // namespace
+
+bool save_snapshot(
+  const std::string & path, const OdometrySnapshot & snapshot, std::string & error)
+{
+  if (snapshot.num_wheels > OdometrySnapshot::MAX_WHEELS)
+  {
+    error = "too many wheel positions";
+    return false;
+  }
+
+  const std::string temporary_path = path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::trunc);
+    if (!file)
+    {
+      error = "can't open " + temporary_path + ": " + std::strerror(errno);
+      return false;
+    }
+    file.imbue(std::locale::classic());
+    file.precision(std::numeric_limits<double>::max_digits10);
+    file << MAGIC << ' ' << VERSION << '\n'
+         << "stamp_nanoseconds " << snapshot.stamp_nanoseconds << '\n'
+         << "x " << snapshot.x << '\n'
+         << "y " << snapshot.y << '\n'
+         << "heading " << snapshot.heading << '\n'
+         << "linear " << snapshot.linear << '\n'
+         << "lateral " << snapshot.lateral << '\n'
+         << "angular " << snapshot.angular << '\n'
+         << "wheel_positions " << snapshot.num_wheels;
+    for (size_t i = 0; i < snapshot.num_wheels; ++i)
+    {
+      file << ' ' << snapshot.wheel_positions[i];
+    }
+    file << '\n';
+    file.flush();
+    if (!file)
+    {
+      error = "can't write " + temporary_path;
+      return false;
+    }
+  }
+
+#ifdef _WIN32
+  // rename() doesn't replace an existing file on Windows
+  std::remove(path.c_str());
+#endif
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+  {
+    error = "can't replace " + path + ": " + std::strerror(errno);
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool load_snapshot(const std::string & path, OdometrySnapshot & snapshot, std::string & error)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    error = "can't open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  file.imbue(std::locale::classic());
+
+  int version = 0;
+  OdometrySnapshot loaded;
+  if (!read_value(file, MAGIC, version) || version != VERSION)
+  {
+    error = path + " is not an odometry snapshot of version " + std::to_string(VERSION);
+    return false;
+  }
+  if (
+    !read_value(file, "stamp_nanoseconds", loaded.stamp_nanoseconds) ||
+    !read_value(file, "x", loaded.x) || !read_value(file, "y", loaded.y) ||
+    !read_value(file, "heading", loaded.heading) || !read_value(file, "linear", loaded.linear) ||
+    !read_value(file, "lateral", loaded.lateral) || !read_value(file, "angular", loaded.angular) ||
+    !read_value(file, "wheel_positions", loaded.num_wheels) ||
+    loaded.num_wheels > OdometrySnapshot::MAX_WHEELS)
+  {
+    error = path + " is malformed";
+    return false;
+  }
+  for (size_t i = 0; i < loaded.num_wheels; ++i)
+  {
+    if (!(file >> loaded.wheel_positions[i]))
+    {
+      error = path + " is malformed";
+      return false;
+    }
+  }
+  snapshot = loaded;
+  return true;
+}
+
+SnapshotWriter::SnapshotWriter(
+  const std::string & path, std::chrono::nanoseconds period, ErrorCallback on_error)
+: path_(path), period_(period), on_error_(std::move(on_error))
+{
+  thread_ = std::thread(&SnapshotWriter::run, this);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    stop_ = true;
+  }
+  stop_condition_.notify_one();
+  thread_.join();
+  flush();
+}
+
+void SnapshotWriter::update(const OdometrySnapshot & snapshot)
+{
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (lock.owns_lock())
+  {
+    latest_ = snapshot;
+    has_new_snapshot_ = true;
+  }
+}
+
+bool SnapshotWriter::flush()
+{
+  std::lock_guard<std::mutex> write_lock(write_mutex_);
+  OdometrySnapshot snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_new_snapshot_)
+    {
+      return true;
+    }
+    snapshot = latest_;
+    has_new_snapshot_ = false;
+  }
+
+  std::string error;
+  const bool success = save_snapshot(path_, snapshot, error);
+  if (!success && !has_failed_ && on_error_)
+  {
+    on_error_(error);
+  }
+  has_failed_ = !success;
+  return success;
+}
+
+void SnapshotWriter::run()
+{
+  std::unique_lock<std::mutex> lock(stop_mutex_);
+  while (!stop_condition_.wait_for(lock, period_, [this] { return stop_; }))
+  {
+    lock.unlock();
+    flush();
+    lock.lock();
+  }
+}
+
+}  // namespace odometry_persistence
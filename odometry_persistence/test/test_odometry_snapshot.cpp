@@ -0,0 +1,133 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "odometry_persistence/odometry_snapshot.hpp"
+
+using odometry_persistence::load_snapshot;
+using odometry_persistence::OdometrySnapshot;
+using odometry_persistence::save_snapshot;
+using odometry_persistence::SnapshotWriter;
+
+namespace
+{
+std::string temporary_path(const std::string & name)
+{
+  const std::string path = ::testing::TempDir() + name;
+  std::remove(path.c_str());
+  return path;
+}
+
+OdometrySnapshot make_snapshot()
+{
+  OdometrySnapshot snapshot;
+  snapshot.stamp_nanoseconds = 1700000000123456789;
+  snapshot.x = 1234.5678901234567;
+  snapshot.y = -0.1;
+  snapshot.heading = 3.0 / 7.0;
+  snapshot.linear = 0.5;
+  snapshot.lateral = 0.0;
+  snapshot.angular = -1e-17;
+  snapshot.num_wheels = 2;
+  snapshot.wheel_positions[0] = 1e9 / 3.0;
+  snapshot.wheel_positions[1] = -2.0;
+  return snapshot;
+}
+}  // namespace
+
+TEST(TestOdometrySnapshot, snapshot_is_restored_exactly)
+{
+  const auto path = temporary_path("exact.odom");
+  const auto snapshot = make_snapshot();
+  std::string error;
+  ASSERT_TRUE(save_snapshot(path, snapshot, error)) << error;
+
+  OdometrySnapshot loaded;
+  ASSERT_TRUE(load_snapshot(path, loaded, error)) << error;
+  EXPECT_EQ(loaded.stamp_nanoseconds, snapshot.stamp_nanoseconds);
+  EXPECT_EQ(loaded.x, snapshot.x);
+  EXPECT_EQ(loaded.y, snapshot.y);
+  EXPECT_EQ(loaded.heading, snapshot.heading);
+  EXPECT_EQ(loaded.linear, snapshot.linear);
+  EXPECT_EQ(loaded.lateral, snapshot.lateral);
+  EXPECT_EQ(loaded.angular, snapshot.angular);
+  ASSERT_EQ(loaded.num_wheels, 2u);
+  EXPECT_EQ(loaded.wheel_positions[0], snapshot.wheel_positions[0]);
+  EXPECT_EQ(loaded.wheel_positions[1], snapshot.wheel_positions[1]);
+}
+
+TEST(TestOdometrySnapshot, invalid_files_are_rejected)
+{
+  const auto path = temporary_path("invalid.odom");
+  OdometrySnapshot loaded;
+  loaded.x = -1.0;
+  std::string error;
+  EXPECT_FALSE(load_snapshot(path, loaded, error));
+  EXPECT_FALSE(error.empty());
+
+  std::ofstream(path) << "odometry_snapshot 1\nstamp_nanoseconds 10\nx 1.0\n";
+  EXPECT_FALSE(load_snapshot(path, loaded, error));
+  std::ofstream(path) << "odometry_snapshot 2\n";
+  EXPECT_FALSE(load_snapshot(path, loaded, error));
+  EXPECT_DOUBLE_EQ(loaded.x, -1.0);
+
+  auto snapshot = make_snapshot();
+  snapshot.num_wheels = OdometrySnapshot::MAX_WHEELS + 1;
+  EXPECT_FALSE(save_snapshot(path, snapshot, error));
+}
+
+TEST(TestOdometrySnapshot, writer_writes_the_latest_snapshot)
+{
+  const auto path = temporary_path("writer.odom");
+  std::string error;
+  OdometrySnapshot loaded;
+  {
+    SnapshotWriter writer(path, std::chrono::milliseconds(10));
+    auto snapshot = make_snapshot();
+    writer.update(snapshot);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_TRUE(load_snapshot(path, loaded, error)) << error;
+    EXPECT_EQ(loaded.x, snapshot.x);
+
+    // the last snapshot is written when the writer stops
+    snapshot.x = 2.0;
+    writer.update(snapshot);
+  }
+  ASSERT_TRUE(load_snapshot(path, loaded, error)) << error;
+  EXPECT_EQ(loaded.x, 2.0);
+}
+
+TEST(TestOdometrySnapshot, writer_reports_the_first_failure)
+{
+  int failures = 0;
+  {
+    SnapshotWriter writer(
+      ::testing::TempDir() + "missing_directory/writer.odom", std::chrono::hours(1),
+      [&failures](const std::string &) { ++failures; });
+    writer.update(make_snapshot());
+    EXPECT_FALSE(writer.flush());
+    writer.update(make_snapshot());
+    EXPECT_FALSE(writer.flush());
+    // nothing new to write
+    EXPECT_TRUE(writer.flush());
+  }
+  EXPECT_EQ(failures, 1);
+}
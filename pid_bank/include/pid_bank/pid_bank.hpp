@@ -0,0 +1,264 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PID_BANK__PID_BANK_HPP_
+#define PID_BANK__PID_BANK_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace pid_bank
+{
+/**
+ * \brief PID controllers of many DoFs, with gains and states stored in contiguous arrays.
+ *
+ * Computes the same commands as one control_toolbox::Pid per DoF. The clamps of the integral term
+ * are converted into bounds of the integrated error and of the integral term when the gains are
+ * set, so the commands of all DoFs are computed in one pass over the arrays, with selects instead
+ * of branches.
+ *
+ * The gains are not synchronized between threads, so they have to be set from the thread
+ * computing the commands or while it is not running.
+ */
+class PidBank
+{
+public:
+  struct Gains
+  {
+    double p = 0.0;
+    double i = 0.0;
+    double d = 0.0;
+    /// Upper limit of the integral term
+    double i_clamp_max = 0.0;
+    /// Lower limit of the integral term
+    double i_clamp_min = 0.0;
+    /// If true, the integrated error is limited so that the integral term stays within the clamps.
+    /// Otherwise, only the integral term is limited and the error keeps being integrated.
+    bool antiwindup = false;
+  };
+
+  /// Resize the bank for \p dof DoFs with zero gains, resets all states
+  void resize(const size_t dof)
+  {
+    gains_.assign(dof, Gains());
+    p_.assign(dof, 0.0);
+    i_.assign(dof, 0.0);
+    d_.assign(dof, 0.0);
+    i_error_min_.assign(dof, -INF);
+    i_error_max_.assign(dof, INF);
+    i_term_min_.assign(dof, 0.0);
+    i_term_max_.assign(dof, 0.0);
+    i_error_.assign(dof, 0.0);
+    error_dot_.assign(dof, 0.0);
+    previous_error_.assign(dof, 0.0);
+  }
+
+  size_t size() const { return gains_.size(); }
+
+  void set_gains(const size_t index, const Gains & gains)
+  {
+    gains_[index] = gains;
+    p_[index] = gains.p;
+    i_[index] = gains.i;
+    d_[index] = gains.d;
+    if (gains.antiwindup && gains.i != 0.0)
+    {
+      const double bound_0 = gains.i_clamp_min / gains.i;
+      const double bound_1 = gains.i_clamp_max / gains.i;
+      i_error_min_[index] = std::min(bound_0, bound_1);
+      i_error_max_[index] = std::max(bound_0, bound_1);
+    }
+    else
+    {
+      i_error_min_[index] = -INF;
+      i_error_max_[index] = INF;
+    }
+    i_term_min_[index] = gains.antiwindup ? -INF : gains.i_clamp_min;
+    i_term_max_[index] = gains.antiwindup ? INF : gains.i_clamp_max;
+  }
+
+  const Gains & get_gains(const size_t index) const { return gains_[index]; }
+
+  /// Integrated error of the last computation of a DoF, like control_toolbox::Pid's i_error
+  double get_integrated_error(const size_t index) const { return i_error_[index]; }
+
+  /// Derivative of the error of the last computation of a DoF, given or from the previous error
+  double get_error_dot(const size_t index) const { return error_dot_[index]; }
+
+  /// Reset the integrated and the previous errors
+  void reset()
+  {
+    std::fill(i_error_.begin(), i_error_.end(), 0.0);
+    std::fill(error_dot_.begin(), error_dot_.end(), 0.0);
+    std::fill(previous_error_.begin(), previous_error_.end(), 0.0);
+  }
+
+  /// Compute the commands of all DoFs, realtime-safe
+  /**
+   * \param[in] error Error of every DoF.
+   * \param[in] error_dot Derivative of the error of every DoF. A NaN derivative is replaced with
+   * the difference to the error of the last call without derivative, like
+   * control_toolbox::Pid::computeCommand(error, dt) does.
+   * \param[in] dt_ns Time since the last call in nanoseconds.
+   * \param[out] command Output of every DoF, zero if \p dt_ns is zero or the errors of the DoF
+   * are not finite. The states of these DoFs are not changed.
+   * \pre All vectors have the size of the bank.
+   */
+  void compute_commands(
+    const std::vector<double> & error, const std::vector<double> & error_dot, const uint64_t dt_ns,
+    std::vector<double> & command)
+  {
+    compute_all(
+      error, [&error_dot](const size_t index) { return error_dot[index]; }, dt_ns, command);
+  }
+
+  /// Compute the commands of all DoFs with the derivatives from the previous errors
+  /**
+   * \see compute_commands(const std::vector<double> &, const std::vector<double> &, uint64_t,
+   * std::vector<double> &)
+   */
+  void compute_commands(
+    const std::vector<double> & error, const uint64_t dt_ns, std::vector<double> & command)
+  {
+    compute_all(error, [](const size_t) { return NAN_DERIVATIVE; }, dt_ns, command);
+  }
+
+  /// Compute the commands of the DoFs due in this call, each with its own time step
+  /**
+   * For DoFs computed at lower rates than the calls, e.g. every n-th call with the time since
+   * their last computation. DoFs with a zero time step are not due: the loop skips them, their
+   * commands and states are not changed.
+   * \param[in] dt_ns Time since the last computation of every DoF in nanoseconds, 0 if not due.
+   * \see compute_commands(const std::vector<double> &, const std::vector<double> &, uint64_t,
+   * std::vector<double> &)
+   */
+  void compute_commands(
+    const std::vector<double> & error, const std::vector<double> & error_dot,
+    const std::vector<uint64_t> & dt_ns, std::vector<double> & command)
+  {
+    compute_due(
+      error, [&error_dot](const size_t index) { return error_dot[index]; }, dt_ns, command);
+  }
+
+  /// Compute the commands of the due DoFs with the derivatives from the previous errors
+  /**
+   * \see compute_commands(const std::vector<double> &, const std::vector<double> &,
+   * const std::vector<uint64_t> &, std::vector<double> &)
+   */
+  void compute_commands(
+    const std::vector<double> & error, const std::vector<uint64_t> & dt_ns,
+    std::vector<double> & command)
+  {
+    compute_due(error, [](const size_t) { return NAN_DERIVATIVE; }, dt_ns, command);
+  }
+
+  /// Compute the command of one DoF, realtime-safe
+  /**
+   * \see compute_commands(const std::vector<double> &, const std::vector<double> &, uint64_t,
+   * std::vector<double> &)
+   */
+  double compute_command(
+    const size_t index, const double error, const double error_dot, const uint64_t dt_ns)
+  {
+    if (dt_ns == 0)
+    {
+      return 0.0;
+    }
+    return compute(index, error, error_dot, static_cast<double>(dt_ns) / 1e9);
+  }
+
+private:
+  static constexpr double INF = std::numeric_limits<double>::infinity();
+  static constexpr double NAN_DERIVATIVE = std::numeric_limits<double>::quiet_NaN();
+
+  template <typename ErrorDot>
+  void compute_all(
+    const std::vector<double> & error, const ErrorDot & error_dot, const uint64_t dt_ns,
+    std::vector<double> & command)
+  {
+    const size_t dof = size();
+    if (dt_ns == 0)
+    {
+      std::fill_n(command.begin(), dof, 0.0);
+      return;
+    }
+    const double dt = static_cast<double>(dt_ns) / 1e9;
+    for (size_t index = 0; index < dof; ++index)
+    {
+      command[index] = compute(index, error[index], error_dot(index), dt);
+    }
+  }
+
+  template <typename ErrorDot>
+  void compute_due(
+    const std::vector<double> & error, const ErrorDot & error_dot,
+    const std::vector<uint64_t> & dt_ns, std::vector<double> & command)
+  {
+    const size_t dof = size();
+    for (size_t index = 0; index < dof; ++index)
+    {
+      if (dt_ns[index] != 0)
+      {
+        command[index] =
+          compute(index, error[index], error_dot(index), static_cast<double>(dt_ns[index]) / 1e9);
+      }
+    }
+  }
+
+  // command of one DoF, keeps its states if the errors are not finite
+  double compute(const size_t index, const double e, const double error_dot, const double dt)
+  {
+    const double previous_error = previous_error_[index];
+    const double previous_i_error = i_error_[index];
+
+    const bool derive = std::isnan(error_dot);
+    const bool finite_e = std::isfinite(e);
+    const double e_dot = derive ? (e - previous_error) / dt : error_dot;
+    previous_error_[index] = derive && finite_e ? e : previous_error;
+
+    const bool valid = finite_e && std::isfinite(e_dot);
+    const double i_error =
+      std::min(std::max(previous_i_error + dt * e, i_error_min_[index]), i_error_max_[index]);
+    const double i_term =
+      std::min(std::max(i_[index] * i_error, i_term_min_[index]), i_term_max_[index]);
+    i_error_[index] = valid ? i_error : previous_i_error;
+    error_dot_[index] = valid ? e_dot : error_dot_[index];
+    return valid ? p_[index] * e + i_term + d_[index] * e_dot : 0.0;
+  }
+
+  std::vector<Gains> gains_;
+  std::vector<double> p_;
+  std::vector<double> i_;
+  std::vector<double> d_;
+  /// Bounds of the integrated error, infinite without anti-windup
+  std::vector<double> i_error_min_;
+  std::vector<double> i_error_max_;
+  /// Bounds of the integral term, infinite with anti-windup
+  std::vector<double> i_term_min_;
+  std::vector<double> i_term_max_;
+  /// Integral of the error of every DoF
+  std::vector<double> i_error_;
+  /// Derivative of the error of the last computation of every DoF
+  std::vector<double> error_dot_;
+  /// Error of the last call without derivative of every DoF
+  std::vector<double> previous_error_;
+};
+
+}  // namespace pid_bank
+
+#endif  // PID_BANK__PID_BANK_HPP_
@@ -0,0 +1,70 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "control_toolbox/pid.hpp"
+#include "pid_bank/pid_bank.hpp"
+
+namespace
+{
+// one cycle at 1 kHz
+constexpr uint64_t DT_NS = 1000000;
+}  // namespace
+
+// all DoFs in one pass
+static void BM_PidBank(benchmark::State & state)
+{
+  const auto dof = static_cast<size_t>(state.range(0));
+  pid_bank::PidBank pid_bank;
+  pid_bank.resize(dof);
+  for (size_t i = 0; i < dof; ++i)
+  {
+    pid_bank.set_gains(i, {1.0, 0.5, 0.1, 1.0, -1.0, true});
+  }
+  std::vector<double> error(dof, 0.1), error_dot(dof, 0.01), command(dof);
+  for (auto _ : state)
+  {
+    pid_bank.compute_commands(error, error_dot, DT_NS, command);
+    benchmark::DoNotOptimize(command.data());
+  }
+}
+BENCHMARK(BM_PidBank)->Arg(1)->Arg(6)->Arg(24);
+
+// one heap-allocated PID per DoF, like the controllers did before
+static void BM_ControlToolboxPids(benchmark::State & state)
+{
+  const auto dof = static_cast<size_t>(state.range(0));
+  std::vector<std::shared_ptr<control_toolbox::Pid>> pids;
+  for (size_t i = 0; i < dof; ++i)
+  {
+    pids.push_back(std::make_shared<control_toolbox::Pid>(1.0, 0.5, 0.1, 1.0, -1.0, true));
+  }
+  std::vector<double> error(dof, 0.1), error_dot(dof, 0.01), command(dof);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < dof; ++i)
+    {
+      command[i] = pids[i]->computeCommand(error[i], error_dot[i], DT_NS);
+    }
+    benchmark::DoNotOptimize(command.data());
+  }
+}
+BENCHMARK(BM_ControlToolboxPids)->Arg(1)->Arg(6)->Arg(24);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,169 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "control_toolbox/pid.hpp"
+#include "pid_bank/pid_bank.hpp"
+
+using pid_bank::PidBank;
+
+namespace
+{
+constexpr uint64_t DT_NS = 10000000;
+
+// symmetric and asymmetric clamps, with and without anti-windup
+const std::vector<PidBank::Gains> GAINS = {
+  {1.0, 0.0, 0.0, 0.0, 0.0, false},  {2.0, 3.0, 0.5, 0.2, -0.2, false},
+  {0.5, 10.0, 0.1, 100.0, -100.0, false}, {2.0, 3.0, 0.5, 0.2, -0.1, true},
+  {1.0, -4.0, 0.2, 0.3, -0.5, true}, {1.0, 0.0, 1.0, 0.3, -0.3, true}};
+
+void make_pids(PidBank & pid_bank, std::vector<control_toolbox::Pid> & pids)
+{
+  pid_bank.resize(GAINS.size());
+  for (size_t i = 0; i < GAINS.size(); ++i)
+  {
+    pid_bank.set_gains(i, GAINS[i]);
+    pids.emplace_back(
+      GAINS[i].p, GAINS[i].i, GAINS[i].d, GAINS[i].i_clamp_max, GAINS[i].i_clamp_min,
+      GAINS[i].antiwindup);
+  }
+}
+}  // namespace
+
+TEST(TestPidBank, same_commands_as_control_toolbox_pid)
+{
+  PidBank pid_bank;
+  std::vector<control_toolbox::Pid> pids;
+  make_pids(pid_bank, pids);
+  EXPECT_EQ(pid_bank.get_gains(3).i_clamp_min, -0.1);
+  EXPECT_TRUE(pid_bank.get_gains(3).antiwindup);
+
+  std::vector<double> error(GAINS.size());
+  std::vector<double> error_dot(GAINS.size());
+  std::vector<double> command(GAINS.size());
+  for (int k = 0; k < 200; ++k)
+  {
+    for (size_t i = 0; i < GAINS.size(); ++i)
+    {
+      // long enough on one side for the integral terms to reach the clamps
+      error[i] = std::sin(0.02 * k + static_cast<double>(i)) + 0.5;
+      error_dot[i] = std::cos(0.02 * k + static_cast<double>(i));
+    }
+    pid_bank.compute_commands(error, error_dot, DT_NS, command);
+    for (size_t i = 0; i < GAINS.size(); ++i)
+    {
+      EXPECT_NEAR(command[i], pids[i].computeCommand(error[i], error_dot[i], DT_NS), 1e-12);
+    }
+  }
+}
+
+TEST(TestPidBank, derivatives_from_previous_errors)
+{
+  PidBank pid_bank;
+  std::vector<control_toolbox::Pid> pids;
+  make_pids(pid_bank, pids);
+
+  std::vector<double> error(GAINS.size());
+  std::vector<double> error_dot(GAINS.size());
+  std::vector<double> command(GAINS.size());
+  for (int k = 0; k < 100; ++k)
+  {
+    for (size_t i = 0; i < GAINS.size(); ++i)
+    {
+      error[i] = std::sin(0.05 * k + static_cast<double>(i));
+      // every other DoF falls back to the derivative from the previous error now and then
+      error_dot[i] = (i % 2 == 0 && k % 3 == 0) ? std::numeric_limits<double>::quiet_NaN()
+                                                : std::cos(0.05 * k + static_cast<double>(i));
+    }
+    if (k < 50)
+    {
+      pid_bank.compute_commands(error, DT_NS, command);
+      for (size_t i = 0; i < GAINS.size(); ++i)
+      {
+        EXPECT_NEAR(command[i], pids[i].computeCommand(error[i], DT_NS), 1e-9);
+      }
+      continue;
+    }
+    pid_bank.compute_commands(error, error_dot, DT_NS, command);
+    for (size_t i = 0; i < GAINS.size(); ++i)
+    {
+      const double expected = std::isnan(error_dot[i])
+                                ? pids[i].computeCommand(error[i], DT_NS)
+                                : pids[i].computeCommand(error[i], error_dot[i], DT_NS);
+      EXPECT_NEAR(command[i], expected, 1e-9);
+      double p_error, i_error, d_error;
+      pids[i].getCurrentPIDErrors(p_error, i_error, d_error);
+      EXPECT_NEAR(pid_bank.get_integrated_error(i), i_error, 1e-9);
+      EXPECT_NEAR(pid_bank.get_error_dot(i), d_error, 1e-9);
+    }
+  }
+}
+
+TEST(TestPidBank, due_dofs_with_their_own_time_steps)
+{
+  PidBank pid_bank;
+  std::vector<control_toolbox::Pid> pids;
+  make_pids(pid_bank, pids);
+
+  // every other DoF is computed every third call, with the time since its last computation
+  std::vector<double> error(GAINS.size());
+  std::vector<uint64_t> dt_ns(GAINS.size());
+  std::vector<double> command(GAINS.size(), -1.0);
+  for (int k = 0; k < 30; ++k)
+  {
+    const std::vector<double> previous_command = command;
+    for (size_t i = 0; i < GAINS.size(); ++i)
+    {
+      error[i] = std::sin(0.05 * k + static_cast<double>(i));
+      dt_ns[i] = i % 2 == 0 ? DT_NS : (k % 3 == 2 ? 3 * DT_NS : 0);
+    }
+    pid_bank.compute_commands(error, dt_ns, command);
+    for (size_t i = 0; i < GAINS.size(); ++i)
+    {
+      const double expected =
+        dt_ns[i] == 0 ? previous_command[i] : pids[i].computeCommand(error[i], dt_ns[i]);
+      EXPECT_NEAR(command[i], expected, 1e-9);
+    }
+  }
+}
+
+TEST(TestPidBank, zero_command_for_invalid_input)
+{
+  PidBank pid_bank;
+  pid_bank.resize(2);
+  pid_bank.set_gains(0, {1.0, 1.0, 1.0, 10.0, -10.0, false});
+  pid_bank.set_gains(1, {1.0, 1.0, 1.0, 10.0, -10.0, false});
+
+  std::vector<double> command = {1.0, 1.0};
+  pid_bank.compute_commands({1.0, 1.0}, {0.0, 0.0}, 0, command);
+  EXPECT_THAT(command, testing::ElementsAre(0.0, 0.0));
+
+  // the DoF with valid errors is not affected, the integral is not changed by the other one
+  pid_bank.compute_commands(
+    {1.0, std::numeric_limits<double>::quiet_NaN()}, {0.0, 0.0}, 1000000000, command);
+  EXPECT_THAT(command, testing::ElementsAre(2.0, 0.0));
+  pid_bank.compute_commands({0.0, 0.0}, {0.0, 0.0}, 1000000000, command);
+  EXPECT_THAT(command, testing::ElementsAre(1.0, 0.0));
+  EXPECT_EQ(pid_bank.compute_command(1, 0.0, std::numeric_limits<double>::infinity(), 1), 0.0);
+
+  pid_bank.reset();
+  pid_bank.compute_commands({0.0, 0.0}, {0.0, 0.0}, 1000000000, command);
+  EXPECT_THAT(command, testing::ElementsAre(0.0, 0.0));
+}
@@ -18,21 +18,29 @@
 #ifndef PID_CONTROLLER__PID_CONTROLLER_HPP_
 #define PID_CONTROLLER__PID_CONTROLLER_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "bounded_controller_state_msgs/msg/bounded_multi_dof_state.hpp"
 #include "control_msgs/msg/multi_dof_command.hpp"
 #include "control_msgs/msg/multi_dof_state_stamped.hpp"
-#include "control_toolbox/pid_ros.hpp"
 #include "controller_interface/chainable_controller_interface.hpp"
+#include "pid_bank/pid_bank.hpp"
 #include "pid_controller/visibility_control.h"
 #include "pid_controller_parameters.hpp"
+#include "publisher_pool/loaned_publisher.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 #include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
+#include "sensor_msgs/msg/joint_state.hpp"
 #include "std_srvs/srv/set_bool.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+#include "update_time_statistics/startup_profile.hpp"
 
 #include "control_msgs/msg/joint_controller_state.hpp"
 #include "control_msgs/msg/joint_jog.hpp"
@@ -92,34 +100,90 @@ public:
   using ControllerMeasuredStateMsg = control_msgs::msg::MultiDOFCommand;
   using ControllerModeSrvType = std_srvs::srv::SetBool;
   using ControllerStateMsg = control_msgs::msg::MultiDOFStateStamped;
+  using BoundedControllerStateMsg = bounded_controller_state_msgs::msg::BoundedMultiDOFState;
 
 protected:
   std::shared_ptr<pid_controller::ParamListener> param_listener_;
+  // durations of declaring the parameters and of the configuration, logged at debug level
+  update_time_statistics::StartupProfile startup_profile_;
   pid_controller::Params params_;
 
   std::vector<std::string> reference_and_state_dof_names_;
+  // Index of every DoF in 'reference_and_state_dof_names_' by its name
+  std::unordered_map<std::string, size_t> reference_and_state_dof_index_;
   size_t dof_;
   std::vector<double> measured_state_values_;
 
-  using PidPtr = std::shared_ptr<control_toolbox::PidROS>;
-  std::vector<PidPtr> pids_;
-  // Feed-forward velocity weight factor when calculating closed loop pid adapter's command
-  std::vector<double> feedforward_gain_;
+  pid_bank::PidBank pid_bank_;
+  // inputs and outputs of the PIDs of all DoFs, a NaN error means no command for its DoF
+  std::vector<double> pid_errors_;
+  std::vector<double> pid_error_dots_;
+  std::vector<double> pid_commands_;
+  // inner PIDs of the derivatives in cascade mode, their outputs are the commands
+  pid_bank::PidBank inner_pid_bank_;
+  std::vector<double> inner_pid_errors_;
+  // outputs of the outer PIDs in cascade mode, the references of the inner PIDs
+  std::vector<double> outer_pid_commands_;
+  // last command written to every DoF, published as output of the PID
+  std::vector<double> dof_outputs_;
+  // gains used by the update loop besides the PIDs, indexed like 'dof_names'
+  struct DofGains
+  {
+    // Feed-forward velocity weight factor when calculating closed loop pid adapter's command
+    double feedforward_gain = 0.0;
+    bool angle_wraparound = false;
+    // the PIDs of the DoF are computed every update_divider-th update
+    size_t update_divider = 1;
+  };
+  std::vector<DofGains> dof_gains_;
+  // updates since the last computation of every DoF, and the time of these updates
+  std::vector<size_t> dof_skipped_updates_;
+  std::vector<uint64_t> dof_elapsed_ns_;
+  // time steps of the PIDs of every DoF in this update, 0 if the DoF is not due
+  std::vector<uint64_t> dof_dt_ns_;
+  // gains of all DoFs resolved from the parameters on the parameter callback thread
+  struct GainsSnapshot
+  {
+    uint64_t version = 0;
+    std::vector<DofGains> dof_gains;
+    std::vector<pid_bank::PidBank::Gains> gains;
+    std::vector<pid_bank::PidBank::Gains> inner_gains;
+  };
+  realtime_tools::RealtimeBuffer<GainsSnapshot> gains_snapshot_;
+  std::atomic<uint64_t> gains_version_{0};
+  // version of the snapshot whose gains are used by the update loop
+  uint64_t applied_gains_version_ = 0;
 
   // Command subscribers and Controller State publisher
   rclcpp::Subscription<ControllerReferenceMsg>::SharedPtr ref_subscriber_ = nullptr;
   realtime_tools::RealtimeBuffer<std::shared_ptr<ControllerReferenceMsg>> input_ref_;
 
   rclcpp::Subscription<ControllerMeasuredStateMsg>::SharedPtr measured_state_subscriber_ = nullptr;
-  realtime_tools::RealtimeBuffer<std::shared_ptr<ControllerMeasuredStateMsg>> measured_state_;
+  // measured values, followed by their derivatives if two interfaces are used
+  realtime_tools::RealtimeBuffer<std::vector<double>> measured_state_;
+  // measured state of the last message with the size of 'measured_state_values_'
+  std::vector<double> measured_state_staging_;
 
   rclcpp::Service<ControllerModeSrvType>::SharedPtr set_feedforward_control_service_;
   realtime_tools::RealtimeBuffer<feedforward_mode_type> control_mode_;
 
-  using ControllerStatePublisher = realtime_tools::RealtimePublisher<ControllerStateMsg>;
+  using ControllerStatePublisher = publisher_pool::RealtimePublisher<ControllerStateMsg>;
 
   rclcpp::Publisher<ControllerStateMsg>::SharedPtr s_publisher_;
   std::unique_ptr<ControllerStatePublisher> state_publisher_;
+  // index of the DoF of every entry of the state message
+  std::vector<size_t> state_dof_indices_;
+  // state of fixed size and the names of its DoFs, if 'bounded_controller_state.enable' is set
+  std::unique_ptr<publisher_pool::LoanedPublisher<BoundedControllerStateMsg>>
+    bounded_state_publisher_;
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr bounded_state_names_publisher_;
+  // the DoFs which aren't due keep the state of their last computation in here
+  BoundedControllerStateMsg bounded_state_;
+  // state of the PID of every DoF on '~/gains/<dof_name>/pid_state', like control_toolbox::PidROS
+  using PidStatePublisher = publisher_pool::RealtimePublisher<control_msgs::msg::PidState>;
+  std::vector<std::unique_ptr<PidStatePublisher>> pid_state_publishers_;
+  // rate of s_publisher_ with the telemetry rate policy of the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> state_publish_rate_;
 
   // override methods from ChainableControllerInterface
   std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
@@ -127,13 +191,19 @@ protected:
   bool on_set_chained_mode(bool chained_mode) override;
 
   // internal methods
-  void update_parameters();
+  GainsSnapshot make_gains_snapshot(const pid_controller::Params & params);
+  /// Apply the gains of the newest snapshot if they are not used yet, realtime-safe
+  void update_gains();
   controller_interface::CallbackReturn configure_parameters();
+  /// Whether the state is published at \p time, at the rate of state_publish_rate_
+  bool should_publish_state(const rclcpp::Time & time);
 
 private:
   // callback for topic interface
   PID_CONTROLLER__VISIBILITY_LOCAL
   void reference_callback(const std::shared_ptr<ControllerReferenceMsg> msg);
+  PID_CONTROLLER__VISIBILITY_LOCAL
+  void measured_state_callback(const std::shared_ptr<ControllerMeasuredStateMsg> msg);
 };
 
 }  // namespace pid_controller
@@ -17,6 +17,9 @@
 
 #include "pid_controller/pid_controller.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <string>
@@ -25,6 +28,7 @@
 #include "angles/angles.h"
 #include "control_msgs/msg/single_dof_state.hpp"
 #include "controller_interface/helpers.hpp"
+#include "publisher_pool/publisher_qos.hpp"
 
 namespace
 {  // utility
@@ -46,12 +50,6 @@ void reset_controller_reference_msg(
   msg->values_dot.resize(dof_names.size(), std::numeric_limits<double>::quiet_NaN());
 }
 
-void reset_controller_measured_state_msg(
-  const std::shared_ptr<ControllerCommandMsg> & msg, const std::vector<std::string> & dof_names)
-{
-  reset_controller_reference_msg(msg, dof_names);
-}
-
 }  // namespace
 
 namespace pid_controller
@@ -64,7 +62,13 @@ controller_interface::CallbackReturn PidController::on_init()
 
   try
   {
+    startup_profile_.clear();
+    update_time_statistics::ScopedStartupPhase phase(startup_profile_, "declare parameters");
     param_listener_ = std::make_shared<pid_controller::ParamListener>(get_node());
+    // the gains are resolved on the parameter callback thread, the update only swaps them in
+    param_listener_->setUserCallback(
+      [this](const pid_controller::Params & params)
+      { gains_snapshot_.writeFromNonRT(make_gains_snapshot(params)); });
   }
   catch (const std::exception & e)
   {
@@ -75,18 +79,68 @@ controller_interface::CallbackReturn PidController::on_init()
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
-void PidController::update_parameters()
+PidController::GainsSnapshot PidController::make_gains_snapshot(
+  const pid_controller::Params & params)
+{
+  GainsSnapshot snapshot;
+  snapshot.version = ++gains_version_;
+  snapshot.dof_gains.resize(params.dof_names.size());
+  snapshot.gains.resize(params.dof_names.size());
+  snapshot.inner_gains.resize(params.dof_names.size());
+
+  // resolve the gains by name only when they change, not in every update
+  for (size_t i = 0; i < params.dof_names.size(); ++i)
+  {
+    const auto gains = params.gains.dof_names_map.find(params.dof_names[i]);
+    if (gains != params.gains.dof_names_map.end())
+    {
+      snapshot.dof_gains[i].feedforward_gain = gains->second.feedforward_gain;
+      snapshot.dof_gains[i].angle_wraparound = gains->second.angle_wraparound;
+      snapshot.dof_gains[i].update_divider = static_cast<size_t>(gains->second.update_divider);
+      snapshot.gains[i] = {
+        gains->second.p, gains->second.i, gains->second.d, gains->second.i_clamp_max,
+        gains->second.i_clamp_min, gains->second.antiwindup};
+    }
+
+    const auto inner_gains = params.inner_gains.dof_names_map.find(params.dof_names[i]);
+    if (inner_gains != params.inner_gains.dof_names_map.end())
+    {
+      snapshot.inner_gains[i] = {
+        inner_gains->second.p, inner_gains->second.i, inner_gains->second.d,
+        inner_gains->second.i_clamp_max, inner_gains->second.i_clamp_min,
+        inner_gains->second.antiwindup};
+    }
+  }
+  return snapshot;
+}
+
+void PidController::update_gains()
 {
-  if (!param_listener_->is_old(params_))
+  const auto & snapshot = *(gains_snapshot_.readFromRT());
+  if (snapshot.version == applied_gains_version_)
   {
     return;
   }
-  params_ = param_listener_->get_params();
+  applied_gains_version_ = snapshot.version;
+
+  // the number of DoFs changes only when configuring, as 'dof_names' is read-only
+  if (dof_gains_.size() != snapshot.dof_gains.size())
+  {
+    dof_gains_.resize(snapshot.dof_gains.size());
+    pid_bank_.resize(snapshot.dof_gains.size());
+    inner_pid_bank_.resize(snapshot.dof_gains.size());
+  }
+  for (size_t i = 0; i < snapshot.dof_gains.size(); ++i)
+  {
+    dof_gains_[i] = snapshot.dof_gains[i];
+    pid_bank_.set_gains(i, snapshot.gains[i]);
+    inner_pid_bank_.set_gains(i, snapshot.inner_gains[i]);
+  }
 }
 
 controller_interface::CallbackReturn PidController::configure_parameters()
 {
-  update_parameters();
+  params_ = param_listener_->get_params();
 
   if (!params_.reference_and_state_dof_names.empty())
   {
@@ -109,6 +163,12 @@ controller_interface::CallbackReturn PidController::configure_parameters()
 
   dof_ = params_.dof_names.size();
 
+  reference_and_state_dof_index_.clear();
+  for (size_t i = 0; i < reference_and_state_dof_names_.size(); ++i)
+  {
+    reference_and_state_dof_index_.emplace(reference_and_state_dof_names_[i], i);
+  }
+
   // TODO(destogl): is this even possible? Test it...
   if (params_.gains.dof_names_map.size() != dof_)
   {
@@ -119,17 +179,59 @@ controller_interface::CallbackReturn PidController::configure_parameters()
     return CallbackReturn::FAILURE;
   }
 
-  pids_.resize(dof_);
+  if (params_.cascade && params_.reference_and_state_interfaces.size() != 2)
+  {
+    RCLCPP_FATAL(
+      get_node()->get_logger(),
+      "Cascade mode requires two 'reference_and_state_interfaces', the value and its derivative, "
+      "but %zu are defined!",
+      params_.reference_and_state_interfaces.size());
+    return CallbackReturn::FAILURE;
+  }
 
-  for (size_t i = 0; i < dof_; ++i)
+  if (params_.measured_state_reference_interfaces && !params_.use_external_measured_states)
+  {
+    RCLCPP_FATAL(
+      get_node()->get_logger(),
+      "'measured_state_reference_interfaces' requires 'use_external_measured_states'!");
+    return CallbackReturn::FAILURE;
+  }
+
+  // the PIDs start without integrated errors
+  gains_snapshot_.initRT(make_gains_snapshot(params_));
+  update_gains();
+  pid_bank_.reset();
+  inner_pid_bank_.reset();
+  inner_pid_errors_.assign(dof_, std::numeric_limits<double>::quiet_NaN());
+  outer_pid_commands_.assign(dof_, 0.0);
+  pid_errors_.assign(dof_, std::numeric_limits<double>::quiet_NaN());
+  pid_error_dots_.assign(dof_, std::numeric_limits<double>::quiet_NaN());
+  pid_commands_.assign(dof_, 0.0);
+  dof_outputs_.assign(dof_, std::numeric_limits<double>::quiet_NaN());
+  dof_skipped_updates_.assign(dof_, 0);
+  dof_elapsed_ns_.assign(dof_, 0);
+  dof_dt_ns_.assign(dof_, 0);
+
+  state_dof_indices_.clear();
+  if (params_.state_dof_names.empty())
   {
-    // prefix should be interpreted as parameters prefix
-    pids_[i] =
-      std::make_shared<control_toolbox::PidROS>(get_node(), "gains." + params_.dof_names[i], true);
-    if (!pids_[i]->initPid())
+    for (size_t i = 0; i < dof_; ++i)
     {
+      state_dof_indices_.push_back(i);
+    }
+  }
+  for (const auto & name : params_.state_dof_names)
+  {
+    const auto found_it = reference_and_state_dof_index_.find(name);
+    if (found_it == reference_and_state_dof_index_.end())
+    {
+      RCLCPP_FATAL(
+        get_node()->get_logger(),
+        "DoF name '%s' of 'state_dof_names' is not in the reference and state DoF names!",
+        name.c_str());
       return CallbackReturn::FAILURE;
     }
+    state_dof_indices_.push_back(found_it->second);
   }
 
   return CallbackReturn::SUCCESS;
@@ -139,7 +241,12 @@ controller_interface::CallbackReturn PidController::on_cleanup(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   reference_and_state_dof_names_.clear();
-  pids_.clear();
+  reference_and_state_dof_index_.clear();
+  dof_gains_.clear();
+  pid_bank_.resize(0);
+  inner_pid_bank_.resize(0);
+  state_dof_indices_.clear();
+  pid_state_publishers_.clear();
 
   return CallbackReturn::SUCCESS;
 }
@@ -147,6 +254,7 @@ controller_interface::CallbackReturn PidController::on_cleanup(
 controller_interface::CallbackReturn PidController::on_configure(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
+  const auto configure_start = update_time_statistics::StartupProfile::Clock::now();
   auto ret = configure_parameters();
   if (ret != CallbackReturn::SUCCESS)
   {
@@ -167,25 +275,19 @@ controller_interface::CallbackReturn PidController::on_configure(
   reset_controller_reference_msg(msg, reference_and_state_dof_names_);
   input_ref_.writeFromNonRT(msg);
 
+  measured_state_values_.resize(
+    dof_ * params_.reference_and_state_interfaces.size(), std::numeric_limits<double>::quiet_NaN());
+
   // input state Subscriber and callback
+  measured_state_staging_.assign(
+    measured_state_values_.size(), std::numeric_limits<double>::quiet_NaN());
+  measured_state_.initRT(measured_state_staging_);
   if (params_.use_external_measured_states)
   {
-    auto measured_state_callback =
-      [&](const std::shared_ptr<ControllerMeasuredStateMsg> msg) -> void
-    {
-      // TODO(destogl): Sort the input values based on joint and interface names
-      measured_state_.writeFromNonRT(msg);
-    };
     measured_state_subscriber_ = get_node()->create_subscription<ControllerMeasuredStateMsg>(
-      "~/measured_state", subscribers_qos, measured_state_callback);
+      "~/measured_state", subscribers_qos,
+      std::bind(&PidController::measured_state_callback, this, std::placeholders::_1));
   }
-  std::shared_ptr<ControllerMeasuredStateMsg> measured_state_msg =
-    std::make_shared<ControllerMeasuredStateMsg>();
-  reset_controller_measured_state_msg(measured_state_msg, reference_and_state_dof_names_);
-  measured_state_.writeFromNonRT(measured_state_msg);
-
-  measured_state_values_.resize(
-    dof_ * params_.reference_and_state_interfaces.size(), std::numeric_limits<double>::quiet_NaN());
 
   auto set_feedforward_control_callback =
     [&](
@@ -210,8 +312,23 @@ controller_interface::CallbackReturn PidController::on_configure(
   {
     // State publisher
     s_publisher_ = get_node()->create_publisher<ControllerStateMsg>(
-      "~/controller_state", rclcpp::SystemDefaultsQoS());
-    state_publisher_ = std::make_unique<ControllerStatePublisher>(s_publisher_);
+      "~/controller_state", publisher_pool::make_qos(params_.qos.controller_state));
+    state_publisher_ = std::make_unique<ControllerStatePublisher>(
+      s_publisher_, publisher_pool::get_shared_pool(params_.publisher_pool),
+      params_.publish_unique_ptr);
+    state_publish_rate_ =
+      telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+        get_node()->get_namespace(), s_publisher_->get_topic_name(), params_.state_publish_rate);
+
+    // the topics of the PidROS instances the controller used to create for every DoF
+    pid_state_publishers_.clear();
+    for (const auto & dof_name : params_.dof_names)
+    {
+      pid_state_publishers_.push_back(std::make_unique<PidStatePublisher>(
+        get_node()->create_publisher<control_msgs::msg::PidState>(
+          "~/gains/" + dof_name + "/pid_state", rclcpp::SensorDataQoS()),
+        publisher_pool::get_shared_pool(params_.publisher_pool), params_.publish_unique_ptr));
+    }
   }
   catch (const std::exception & e)
   {
@@ -221,15 +338,57 @@ controller_interface::CallbackReturn PidController::on_configure(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  // Reserve memory in state publisher
+  // Reserve memory in state publisher, only for the published DoFs
   state_publisher_->lock();
-  state_publisher_->msg_.dof_states.resize(reference_and_state_dof_names_.size());
-  for (size_t i = 0; i < reference_and_state_dof_names_.size(); ++i)
+  state_publisher_->msg_.dof_states.resize(state_dof_indices_.size());
+  for (size_t i = 0; i < state_dof_indices_.size(); ++i)
   {
-    state_publisher_->msg_.dof_states[i].name = reference_and_state_dof_names_[i];
+    state_publisher_->msg_.dof_states[i].name =
+      reference_and_state_dof_names_[state_dof_indices_[i]];
   }
   state_publisher_->unlock();
 
+  bounded_state_publisher_.reset();
+  bounded_state_names_publisher_.reset();
+  if (params_.bounded_controller_state.enable)
+  {
+    if (state_dof_indices_.size() > BoundedControllerStateMsg::MAX_DOFS)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "The bounded controller state holds at most %u DoFs, but %zu DoFs are published.",
+        BoundedControllerStateMsg::MAX_DOFS, state_dof_indices_.size());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    // without loans, a copy is published outside of the update like the controller state
+    bounded_state_publisher_ =
+      std::make_unique<publisher_pool::LoanedPublisher<BoundedControllerStateMsg>>(
+        get_node()->create_publisher<BoundedControllerStateMsg>(
+          "~/bounded_controller_state", publisher_pool::make_qos(params_.qos.controller_state)),
+        publisher_pool::get_shared_pool(params_.publisher_pool), params_.publish_unique_ptr);
+    bounded_state_ = BoundedControllerStateMsg();
+    bounded_state_.size = static_cast<uint32_t>(state_dof_indices_.size());
+    // the names are only sent once, late subscribers still get them
+    bounded_state_names_publisher_ = get_node()->create_publisher<sensor_msgs::msg::JointState>(
+      "~/bounded_controller_state/names", rclcpp::QoS(1).reliable().transient_local());
+    sensor_msgs::msg::JointState names_msg;
+    names_msg.header.stamp = get_node()->now();
+    for (const size_t i : state_dof_indices_)
+    {
+      names_msg.name.push_back(reference_and_state_dof_names_[i]);
+    }
+    bounded_state_names_publisher_->publish(names_msg);
+    RCLCPP_INFO(
+      get_node()->get_logger(), "The middleware %s loan the bounded controller state.",
+      bounded_state_publisher_->is_loaning() ? "does" : "doesn't");
+  }
+
+  startup_profile_.add(
+    "configure", update_time_statistics::StartupProfile::Clock::now() - configure_start);
+  RCLCPP_DEBUG(
+    get_node()->get_logger(), "Startup with %zu parameters: %s",
+    update_time_statistics::count_parameters(get_node()->get_node_parameters_interface()),
+    startup_profile_.summary().c_str());
   RCLCPP_INFO(get_node()->get_logger(), "configure successful");
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -250,17 +409,24 @@ void PidController::reference_callback(const std::shared_ptr<ControllerReference
     msg->dof_names.size() == reference_and_state_dof_names_.size() &&
     msg->values.size() == reference_and_state_dof_names_.size())
   {
-    auto ref_msg = msg;  // simple initialization
+    // the values are usually sent in the defined order, so they don't have to be sorted
+    if (msg->dof_names == reference_and_state_dof_names_)
+    {
+      msg->values_dot.resize(
+        reference_and_state_dof_names_.size(), std::numeric_limits<double>::quiet_NaN());
+      input_ref_.writeFromNonRT(msg);
+      return;
+    }
 
     // sort values in the ref_msg
-    reset_controller_reference_msg(msg, reference_and_state_dof_names_);
+    auto ref_msg = std::make_shared<ControllerReferenceMsg>();
+    reset_controller_reference_msg(ref_msg, reference_and_state_dof_names_);
 
     bool all_found = true;
     for (size_t i = 0; i < msg->dof_names.size(); ++i)
     {
-      auto found_it =
-        std::find(ref_msg->dof_names.begin(), ref_msg->dof_names.end(), msg->dof_names[i]);
-      if (found_it == msg->dof_names.end())
+      const auto found_it = reference_and_state_dof_index_.find(msg->dof_names[i]);
+      if (found_it == reference_and_state_dof_index_.end())
       {
         all_found = false;
         RCLCPP_WARN(
@@ -269,9 +435,12 @@ void PidController::reference_callback(const std::shared_ptr<ControllerReference
         break;
       }
 
-      auto position = std::distance(ref_msg->dof_names.begin(), found_it);
+      const auto position = found_it->second;
       ref_msg->values[position] = msg->values[i];
-      ref_msg->values_dot[position] = msg->values_dot[i];
+      if (i < msg->values_dot.size())
+      {
+        ref_msg->values_dot[position] = msg->values_dot[i];
+      }
     }
 
     if (all_found)
@@ -288,6 +457,41 @@ void PidController::reference_callback(const std::shared_ptr<ControllerReference
   }
 }
 
+void PidController::measured_state_callback(
+  const std::shared_ptr<ControllerMeasuredStateMsg> msg)
+{
+  // TODO(destogl): Sort the input values based on joint and interface names
+  const size_t dof = reference_and_state_dof_names_.size();
+  if (msg->values.size() != dof || (!msg->values_dot.empty() && msg->values_dot.size() != dof))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "Size of measured state values (%zu) and/or values_dot (%zu) is not matching the expected "
+      "size (%zu).",
+      msg->values.size(), msg->values_dot.size(), dof);
+    return;
+  }
+
+  // the staging buffer has the size of 'measured_state_values_', so the update only copies it
+  std::copy(msg->values.begin(), msg->values.end(), measured_state_staging_.begin());
+  if (measured_state_staging_.size() == 2 * dof)
+  {
+    if (msg->values_dot.empty())
+    {
+      std::fill_n(
+        measured_state_staging_.begin() + static_cast<std::ptrdiff_t>(dof), dof,
+        std::numeric_limits<double>::quiet_NaN());
+    }
+    else
+    {
+      std::copy(
+        msg->values_dot.begin(), msg->values_dot.end(),
+        measured_state_staging_.begin() + static_cast<std::ptrdiff_t>(dof));
+    }
+  }
+  measured_state_.writeFromNonRT(measured_state_staging_);
+}
+
 controller_interface::InterfaceConfiguration PidController::command_interface_configuration() const
 {
   controller_interface::InterfaceConfiguration command_interfaces_config;
@@ -329,20 +533,31 @@ controller_interface::InterfaceConfiguration PidController::state_interface_conf
 
 std::vector<hardware_interface::CommandInterface> PidController::on_export_reference_interfaces()
 {
+  // the measured states follow the references, with the same order of interfaces and DoFs
+  const size_t num_references = dof_ * params_.reference_and_state_interfaces.size();
   reference_interfaces_.resize(
-    dof_ * params_.reference_and_state_interfaces.size(), std::numeric_limits<double>::quiet_NaN());
+    params_.measured_state_reference_interfaces ? 2 * num_references : num_references,
+    std::numeric_limits<double>::quiet_NaN());
 
   std::vector<hardware_interface::CommandInterface> reference_interfaces;
   reference_interfaces.reserve(reference_interfaces_.size());
 
   size_t index = 0;
-  for (const auto & interface : params_.reference_and_state_interfaces)
+  for (const std::string prefix : {"", "measured_"})
   {
-    for (const auto & dof_name : reference_and_state_dof_names_)
+    if (index == reference_interfaces_.size())
+    {
+      break;
+    }
+    for (const auto & interface : params_.reference_and_state_interfaces)
     {
-      reference_interfaces.push_back(hardware_interface::CommandInterface(
-        get_node()->get_name(), dof_name + "/" + interface, &reference_interfaces_[index]));
-      ++index;
+      for (const auto & dof_name : reference_and_state_dof_names_)
+      {
+        reference_interfaces.push_back(hardware_interface::CommandInterface(
+          get_node()->get_name(), dof_name + "/" + prefix + interface,
+          &reference_interfaces_[index]));
+        ++index;
+      }
     }
   }
 
@@ -360,14 +575,25 @@ controller_interface::CallbackReturn PidController::on_activate(
 {
   // Set default value in command (the same number as state interfaces)
   reset_controller_reference_msg(*(input_ref_.readFromRT()), reference_and_state_dof_names_);
-  reset_controller_measured_state_msg(
-    *(measured_state_.readFromRT()), reference_and_state_dof_names_);
+  measured_state_staging_.assign(
+    measured_state_staging_.size(), std::numeric_limits<double>::quiet_NaN());
+  measured_state_.initRT(measured_state_staging_);
 
   reference_interfaces_.assign(
     reference_interfaces_.size(), std::numeric_limits<double>::quiet_NaN());
   measured_state_values_.assign(
     measured_state_values_.size(), std::numeric_limits<double>::quiet_NaN());
 
+  // the outputs are the current commands until the PIDs write new ones, all DoFs are computed in
+  // the first update
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    dof_outputs_[i] = command_interfaces_[i].get_value();
+    dof_skipped_updates_[i] = dof_gains_[i].update_divider - 1;
+    dof_elapsed_ns_[i] = 0;
+  }
+  state_publish_rate_->reset();
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -387,7 +613,7 @@ controller_interface::return_type PidController::update_reference_from_subscribe
     if (!std::isnan((*current_ref)->values[i]))
     {
       reference_interfaces_[i] = (*current_ref)->values[i];
-      if (reference_interfaces_.size() == 2 * dof_ && !std::isnan((*current_ref)->values_dot[i]))
+      if (measured_state_values_.size() == 2 * dof_ && !std::isnan((*current_ref)->values_dot[i]))
       {
         reference_interfaces_[dof_ + i] = (*current_ref)->values_dot[i];
       }
@@ -395,26 +621,36 @@ controller_interface::return_type PidController::update_reference_from_subscribe
       (*current_ref)->values[i] = std::numeric_limits<double>::quiet_NaN();
     }
   }
+
+  if (params_.measured_state_reference_interfaces)
+  {
+    // outside of chained mode, the measured states of the topic are written to the references
+    const auto & measured_state = *(measured_state_.readFromRT());
+    std::copy(
+      measured_state.begin(), measured_state.end(),
+      reference_interfaces_.begin() + static_cast<std::ptrdiff_t>(measured_state_values_.size()));
+  }
   return controller_interface::return_type::OK;
 }
 
 controller_interface::return_type PidController::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  // check for any parameter updates
-  update_parameters();
+  // check for any gain updates, prepared by the parameter callback
+  update_gains();
 
-  if (params_.use_external_measured_states)
+  if (params_.measured_state_reference_interfaces)
   {
-    const auto measured_state = *(measured_state_.readFromRT());
-    for (size_t i = 0; i < dof_; ++i)
-    {
-      measured_state_values_[i] = measured_state->values[i];
-      if (measured_state_values_.size() == 2 * dof_)
-      {
-        measured_state_values_[dof_ + i] = measured_state->values_dot[i];
-      }
-    }
+    // written by the preceding controller in this cycle, or copied from the topic
+    std::copy(
+      reference_interfaces_.begin() + static_cast<std::ptrdiff_t>(measured_state_values_.size()),
+      reference_interfaces_.end(), measured_state_values_.begin());
+  }
+  else if (params_.use_external_measured_states)
+  {
+    // the values were validated by the callback and have the same size
+    const auto & measured_state = *(measured_state_.readFromRT());
+    std::copy(measured_state.begin(), measured_state.end(), measured_state_values_.begin());
   }
   else
   {
@@ -424,95 +660,220 @@ controller_interface::return_type PidController::update_and_write_commands(
     }
   }
 
+  // the DoFs with an update divider accumulate the periods until they are due, the others are
+  // computed with the period
+  const auto dt_ns = static_cast<uint64_t>(period.nanoseconds());
+  bool all_due = true;
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    dof_elapsed_ns_[i] += dt_ns;
+    if (++dof_skipped_updates_[i] >= dof_gains_[i].update_divider)
+    {
+      dof_dt_ns_[i] = dof_elapsed_ns_[i];
+      dof_skipped_updates_[i] = 0;
+      dof_elapsed_ns_[i] = 0;
+    }
+    else
+    {
+      dof_dt_ns_[i] = 0;
+      all_due = false;
+    }
+  }
+  const auto is_due = [this, all_due](const size_t i) { return all_due || dof_dt_ns_[i] != 0; };
+
   for (size_t i = 0; i < dof_; ++i)
   {
-    double tmp_command = std::numeric_limits<double>::quiet_NaN();
+    if (!is_due(i))
+    {
+      continue;
+    }
+    pid_errors_[i] = std::numeric_limits<double>::quiet_NaN();
+    pid_error_dots_[i] = std::numeric_limits<double>::quiet_NaN();
 
-    // Using feedforward
     if (!std::isnan(reference_interfaces_[i]) && !std::isnan(measured_state_values_[i]))
     {
-      // calculate feed-forward
-      if (*(control_mode_.readFromRT()) == feedforward_mode_type::ON)
+      pid_errors_[i] = reference_interfaces_[i] - measured_state_values_[i];
+      if (dof_gains_[i].angle_wraparound)
       {
-        tmp_command = reference_interfaces_[dof_ + i] *
-                      params_.gains.dof_names_map[params_.dof_names[i]].feedforward_gain;
+        // for continuous angles the error is normalized between -pi<error<pi
+        pid_errors_[i] =
+          angles::shortest_angular_distance(measured_state_values_[i], reference_interfaces_[i]);
       }
-      else
+
+      // checking if there are two interfaces, a NaN 'error_dot' falls back to the calculation
+      // with 'error' only
+      if (measured_state_values_.size() == 2 * dof_)
       {
-        tmp_command = 0.0;
+        pid_error_dots_[i] = reference_interfaces_[dof_ + i] - measured_state_values_[dof_ + i];
       }
+    }
+  }
 
-      double error = reference_interfaces_[i] - measured_state_values_[i];
-      if (params_.gains.dof_names_map[params_.dof_names[i]].angle_wraparound)
+  if (all_due)
+  {
+    pid_bank_.compute_commands(pid_errors_, pid_error_dots_, dt_ns, pid_commands_);
+  }
+  else
+  {
+    pid_bank_.compute_commands(pid_errors_, pid_error_dots_, dof_dt_ns_, pid_commands_);
+  }
+  const bool feedforward = *(control_mode_.readFromRT()) == feedforward_mode_type::ON;
+
+  if (params_.cascade)
+  {
+    // the outputs of the outer PIDs, with the feed-forward, are the references of the derivatives
+    for (size_t i = 0; i < dof_; ++i)
+    {
+      if (!is_due(i))
       {
-        // for continuous angles the error is normalized between -pi<error<pi
-        error =
-          angles::shortest_angular_distance(measured_state_values_[i], reference_interfaces_[i]);
+        continue;
       }
+      outer_pid_commands_[i] = pid_commands_[i];
+      const double reference_dot =
+        pid_commands_[i] +
+        (feedforward ? reference_interfaces_[dof_ + i] * dof_gains_[i].feedforward_gain : 0.0);
+      inner_pid_errors_[i] = std::isnan(pid_errors_[i])
+                               ? std::numeric_limits<double>::quiet_NaN()
+                               : reference_dot - measured_state_values_[dof_ + i];
+    }
+    if (all_due)
+    {
+      inner_pid_bank_.compute_commands(inner_pid_errors_, dt_ns, pid_commands_);
+    }
+    else
+    {
+      inner_pid_bank_.compute_commands(inner_pid_errors_, dof_dt_ns_, pid_commands_);
+    }
 
-      // checking if there are two interfaces
-      if (reference_interfaces_.size() == 2 * dof_ && measured_state_values_.size() == 2 * dof_)
+    for (size_t i = 0; i < dof_; ++i)
+    {
+      if (is_due(i) && !std::isnan(inner_pid_errors_[i]))
       {
-        if (
-          !std::isnan(reference_interfaces_[dof_ + i]) &&
-          !std::isnan(measured_state_values_[dof_ + i]))
-        {
-          // use calculation with 'error' and 'error_dot'
-          tmp_command += pids_[i]->computeCommand(
-            error, reference_interfaces_[dof_ + i] - measured_state_values_[dof_ + i], period);
-        }
-        else
-        {
-          // Fallback to calculation with 'error' only
-          tmp_command += pids_[i]->computeCommand(error, period);
-        }
+        dof_outputs_[i] = pid_commands_[i];
+        command_interfaces_[i].set_value(dof_outputs_[i]);
       }
-      else
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < dof_; ++i)
+    {
+      // Using feedforward
+      if (
+        is_due(i) && !std::isnan(reference_interfaces_[i]) &&
+        !std::isnan(measured_state_values_[i]))
       {
-        // use calculation with 'error' only
-        tmp_command += pids_[i]->computeCommand(error, period);
+        double tmp_command = 0.0;
+        // calculate feed-forward
+        if (feedforward)
+        {
+          tmp_command = reference_interfaces_[dof_ + i] * dof_gains_[i].feedforward_gain;
+        }
+
+        // write calculated values
+        dof_outputs_[i] = tmp_command + pid_commands_[i];
+        command_interfaces_[i].set_value(dof_outputs_[i]);
       }
+    }
+  }
+
+  if (!should_publish_state(time))
+  {
+    return controller_interface::return_type::OK;
+  }
 
-      // write calculated values
-      command_interfaces_[i].set_value(tmp_command);
+  // the PIDs computed in this update publish their states like control_toolbox::PidROS, which
+  // reports the gains as the terms
+  for (size_t i = 0; i < pid_state_publishers_.size(); ++i)
+  {
+    if (!is_due(i) || std::isnan(pid_errors_[i]) || !pid_state_publishers_[i]->trylock())
+    {
+      continue;
     }
+    const auto & gains = pid_bank_.get_gains(i);
+    auto & pid_state = pid_state_publishers_[i]->msg_;
+    pid_state.header.stamp = time;
+    pid_state.timestep =
+      all_due ? period : rclcpp::Duration::from_nanoseconds(static_cast<int64_t>(dof_dt_ns_[i]));
+    pid_state.error = pid_errors_[i];
+    pid_state.error_dot = pid_bank_.get_error_dot(i);
+    pid_state.p_error = pid_errors_[i];
+    pid_state.i_error = pid_bank_.get_integrated_error(i);
+    pid_state.d_error = pid_state.error_dot;
+    pid_state.p_term = gains.p;
+    pid_state.i_term = gains.i;
+    pid_state.d_term = gains.d;
+    pid_state.i_max = gains.i_clamp_max;
+    pid_state.i_min = gains.i_clamp_min;
+    pid_state.output = params_.cascade ? outer_pid_commands_[i] : pid_commands_[i];
+    pid_state_publishers_[i]->unlockAndPublish();
   }
 
+  const bool has_derivatives = measured_state_values_.size() == 2 * dof_;
   if (state_publisher_ && state_publisher_->trylock())
   {
     state_publisher_->msg_.header.stamp = time;
-    for (size_t i = 0; i < dof_; ++i)
+    for (size_t k = 0; k < state_dof_indices_.size(); ++k)
     {
-      state_publisher_->msg_.dof_states[i].reference = reference_interfaces_[i];
-      state_publisher_->msg_.dof_states[i].feedback = measured_state_values_[i];
-      if (reference_interfaces_.size() == 2 * dof_ && measured_state_values_.size() == 2 * dof_)
-      {
-        state_publisher_->msg_.dof_states[i].feedback_dot = measured_state_values_[dof_ + i];
-      }
-      state_publisher_->msg_.dof_states[i].error =
-        reference_interfaces_[i] - measured_state_values_[i];
-      if (params_.gains.dof_names_map[params_.dof_names[i]].angle_wraparound)
+      const size_t i = state_dof_indices_[k];
+      if (!is_due(i))
       {
-        // for continuous angles the error is normalized between -pi<error<pi
-        state_publisher_->msg_.dof_states[i].error =
-          angles::shortest_angular_distance(measured_state_values_[i], reference_interfaces_[i]);
+        // the state of the last computation of the DoF is published again
+        continue;
       }
-      if (reference_interfaces_.size() == 2 * dof_ && measured_state_values_.size() == 2 * dof_)
+      auto & dof_state = state_publisher_->msg_.dof_states[k];
+      dof_state.reference = reference_interfaces_[i];
+      dof_state.feedback = measured_state_values_[i];
+      // the errors of the PIDs, NaN if the DoF has no reference or feedback
+      dof_state.error = pid_errors_[i];
+      if (has_derivatives)
       {
-        state_publisher_->msg_.dof_states[i].error_dot =
-          reference_interfaces_[dof_ + i] - measured_state_values_[dof_ + i];
+        dof_state.feedback_dot = measured_state_values_[dof_ + i];
+        dof_state.error_dot = pid_error_dots_[i];
       }
-      state_publisher_->msg_.dof_states[i].time_step = period.seconds();
-      // Command can store the old calculated values. This should be obvious because at least one
+      dof_state.time_step =
+        all_due ? period.seconds() : static_cast<double>(dof_dt_ns_[i]) / 1e9;
+      // Output can store the old calculated values. This should be obvious because at least one
       // another value is NaN.
-      state_publisher_->msg_.dof_states[i].output = command_interfaces_[i].get_value();
+      dof_state.output = dof_outputs_[i];
     }
     state_publisher_->unlockAndPublish();
   }
 
+  if (bounded_state_publisher_)
+  {
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+    bounded_state_.stamp = time;
+    for (size_t k = 0; k < state_dof_indices_.size(); ++k)
+    {
+      const size_t i = state_dof_indices_[k];
+      if (!is_due(i))
+      {
+        continue;
+      }
+      bounded_state_.reference[k] = reference_interfaces_[i];
+      bounded_state_.feedback[k] = measured_state_values_[i];
+      bounded_state_.error[k] = pid_errors_[i];
+      bounded_state_.feedback_dot[k] = has_derivatives ? measured_state_values_[dof_ + i] : NaN;
+      bounded_state_.error_dot[k] = has_derivatives ? pid_error_dots_[i] : NaN;
+      bounded_state_.time_step[k] =
+        all_due ? period.seconds() : static_cast<double>(dof_dt_ns_[i]) / 1e9;
+      bounded_state_.output[k] = dof_outputs_[i];
+    }
+    // a loaned message is only copied into, it is neither allocated nor serialized; it is dropped
+    // if the middleware has no loan left, like a message of a busy realtime publisher
+    bounded_state_publisher_->publish(
+      [this](BoundedControllerStateMsg & msg) { msg = bounded_state_; });
+  }
+
   return controller_interface::return_type::OK;
 }
 
+bool PidController::should_publish_state(const rclcpp::Time & time)
+{
+  return state_publish_rate_->is_due(time);
+}
+
 }  // namespace pid_controller
 
 #include "pluginlib/class_list_macros.hpp"
@@ -17,12 +17,18 @@
 
 #include "test_pid_controller.hpp"
 
+#include <chrono>
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "rt_safety_checks/rt_safety_checker.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+
 using pid_controller::feedforward_mode_type;
 
 class PidControllerTest : public PidControllerFixture<TestablePidController>
@@ -54,6 +60,23 @@ TEST_F(PidControllerTest, all_parameters_set_configure_success)
     ASSERT_EQ(controller_->params_.gains.dof_names_map[dof_name].i_clamp_min, -5.0);
     ASSERT_EQ(controller_->params_.gains.dof_names_map[dof_name].feedforward_gain, 0.0);
   }
+  ASSERT_THAT(controller_->dof_gains_, testing::SizeIs(dof_names_.size()));
+  for (const auto & dof_gains : controller_->dof_gains_)
+  {
+    ASSERT_EQ(dof_gains.feedforward_gain, 0.0);
+    ASSERT_FALSE(dof_gains.angle_wraparound);
+  }
+  ASSERT_EQ(controller_->pid_bank_.size(), dof_names_.size());
+  for (size_t i = 0; i < dof_names_.size(); ++i)
+  {
+    const auto & pid_gains = controller_->pid_bank_.get_gains(i);
+    ASSERT_EQ(pid_gains.p, 1.0);
+    ASSERT_EQ(pid_gains.i, 2.0);
+    ASSERT_EQ(pid_gains.d, 10.0);
+    ASSERT_EQ(pid_gains.i_clamp_max, 5.0);
+    ASSERT_EQ(pid_gains.i_clamp_min, -5.0);
+    ASSERT_FALSE(pid_gains.antiwindup);
+  }
   ASSERT_EQ(controller_->params_.command_interface, command_interface_);
   EXPECT_THAT(
     controller_->params_.reference_and_state_interfaces,
@@ -464,6 +487,125 @@ TEST_F(PidControllerTest, subscribe_and_get_messages_success)
   }
 }
 
+TEST_F(PidControllerTest, state_is_published_by_publisher_pool)
+{
+  SetUpController(
+    "test_pid_controller",
+    {rclcpp::Parameter("publisher_pool.enable", true),
+     rclcpp::Parameter("publish_unique_ptr", true)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  EXPECT_TRUE(controller_->state_publisher_->is_pooled());
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  ControllerStateMsg msg;
+  subscribe_and_get_messages(msg);
+  ASSERT_EQ(msg.dof_states.size(), dof_names_.size());
+  EXPECT_EQ(msg.dof_states[0].name, dof_names_[0]);
+}
+
+TEST_F(PidControllerTest, bounded_state_is_published)
+{
+  SetUpController(
+    "test_pid_controller", {rclcpp::Parameter("bounded_controller_state.enable", true)});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_TRUE(controller_->bounded_state_publisher_);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // the names were published once on configuration, a late subscriber still receives them
+  rclcpp::Node test_node("test_node");
+  auto names_subscription = test_node.create_subscription<sensor_msgs::msg::JointState>(
+    "/test_pid_controller/bounded_controller_state/names",
+    rclcpp::QoS(1).reliable().transient_local(),
+    [](const sensor_msgs::msg::JointState::SharedPtr) {});
+  rclcpp::WaitSet names_wait_set;
+  names_wait_set.add_subscription(names_subscription);
+  ASSERT_EQ(names_wait_set.wait(std::chrono::seconds(5)).kind(), rclcpp::WaitResultKind::Ready);
+  sensor_msgs::msg::JointState names_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(names_subscription->take(names_msg, msg_info));
+  EXPECT_EQ(names_msg.name, dof_names_);
+
+  using BoundedState = pid_controller::PidController::BoundedControllerStateMsg;
+  auto subscription = test_node.create_subscription<BoundedState>(
+    "/test_pid_controller/bounded_controller_state", 10, [](const BoundedState::SharedPtr) {});
+  int max_sub_check_loop_count = 5;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (max_sub_check_loop_count--)
+  {
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01));
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0) << "No bounded state was published";
+
+  BoundedState msg;
+  ASSERT_TRUE(subscription->take(msg, msg_info));
+  ASSERT_EQ(msg.size, dof_names_.size());
+  for (size_t i = 0; i < dof_names_.size(); ++i)
+  {
+    EXPECT_TRUE(std::isnan(msg.reference[i]));
+    EXPECT_EQ(msg.output[i], dof_command_values_[i]);
+  }
+}
+
+TEST_F(PidControllerTest, pid_states_are_published)
+{
+  SetUpController();
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->pid_state_publishers_.size(), dof_names_.size());
+  controller_->set_chained_mode(false);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_node("test_node");
+  auto subscription = test_node.create_subscription<control_msgs::msg::PidState>(
+    "/test_pid_controller/gains/" + dof_names_[0] + "/pid_state", rclcpp::SensorDataQoS(),
+    [](const control_msgs::msg::PidState::SharedPtr) {});
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+
+  const std::vector<double> reference = dof_command_values_;
+  const double error = reference[0] - dof_state_values_[0];
+  std::shared_ptr<ControllerCommandMsg> msg = std::make_shared<ControllerCommandMsg>();
+  msg->dof_names = dof_names_;
+  msg->values_dot.resize(dof_names_.size(), std::numeric_limits<double>::quiet_NaN());
+
+  // only the computed PIDs publish their states, the update consumes the reference
+  int max_sub_check_loop_count = 5;
+  while (max_sub_check_loop_count--)
+  {
+    msg->values = reference;
+    controller_->input_ref_.writeFromNonRT(msg);
+    controller_->pid_bank_.reset();
+    ASSERT_EQ(
+      controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0) << "No PID state was published";
+
+  control_msgs::msg::PidState pid_state;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(pid_state, msg_info));
+  EXPECT_EQ(rclcpp::Duration(pid_state.timestep).seconds(), 0.01);
+  EXPECT_NEAR(pid_state.error, error, 1e-9);
+  EXPECT_NEAR(pid_state.p_error, error, 1e-9);
+  EXPECT_NEAR(pid_state.i_error, 0.01 * error, 1e-9);
+  EXPECT_NEAR(pid_state.error_dot, error / 0.01, 1e-6);
+  EXPECT_EQ(pid_state.p_term, 1.0);
+  EXPECT_EQ(pid_state.i_term, 2.0);
+  EXPECT_EQ(pid_state.d_term, 10.0);
+  EXPECT_EQ(pid_state.i_max, 5.0);
+  EXPECT_EQ(pid_state.i_min, -5.0);
+  EXPECT_EQ(pid_state.output, dof_command_values_[0]);
+}
+
 TEST_F(PidControllerTest, receive_message_and_publish_updated_status)
 {
   SetUpController();
@@ -521,6 +663,261 @@ TEST_F(PidControllerTest, receive_message_and_publish_updated_status)
   }
 }
 
+TEST_F(PidControllerTest, measured_state_message_is_validated)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_THAT(*(controller_->measured_state_.readFromRT()), testing::SizeIs(dof_names_.size()));
+
+  auto msg = std::make_shared<ControllerCommandMsg>();
+  msg->values = {1.0, 2.0};
+  controller_->measured_state_callback(msg);
+  EXPECT_TRUE(std::isnan((*(controller_->measured_state_.readFromRT()))[0]));
+
+  msg->values = {1.0};
+  msg->values_dot = {1.0, 2.0};
+  controller_->measured_state_callback(msg);
+  EXPECT_TRUE(std::isnan((*(controller_->measured_state_.readFromRT()))[0]));
+
+  msg->values_dot.clear();
+  controller_->measured_state_callback(msg);
+  EXPECT_THAT(*(controller_->measured_state_.readFromRT()), testing::ElementsAre(1.0));
+}
+
+TEST_F(PidControllerTest, measured_state_from_reference_interfaces_in_chained_mode)
+{
+  SetUpController(
+    "test_pid_controller", {rclcpp::Parameter("use_external_measured_states", true),
+                            rclcpp::Parameter("measured_state_reference_interfaces", true)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_EQ(reference_interfaces.size(), 2 * dof_names_.size());
+  EXPECT_EQ(
+    reference_interfaces[0].get_interface_name(),
+    reference_and_state_dof_names_[0] + "/" + state_interfaces_[0]);
+  EXPECT_EQ(
+    reference_interfaces[1].get_interface_name(),
+    reference_and_state_dof_names_[0] + "/measured_" + state_interfaces_[0]);
+
+  controller_->set_chained_mode(true);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_TRUE(controller_->is_in_chained_mode());
+
+  // the preceding controller writes the reference and the measured state, the topic is not used
+  auto msg = std::make_shared<ControllerCommandMsg>();
+  msg->values = {9.0};
+  controller_->measured_state_callback(msg);
+  reference_interfaces[0].set_value(2.0);
+  reference_interfaces[1].set_value(1.5);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  EXPECT_EQ(controller_->measured_state_values_[0], 1.5);
+  EXPECT_EQ(controller_->pid_errors_[0], 0.5);
+  EXPECT_NE(dof_command_values_[0], 101.101);
+}
+
+TEST_F(PidControllerTest, measured_state_reference_interfaces_require_external_states)
+{
+  SetUpController(
+    "test_pid_controller", {rclcpp::Parameter("measured_state_reference_interfaces", true)});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_FAILURE);
+}
+
+TEST_F(PidControllerTest, state_is_published_for_subset_at_rate)
+{
+  dof_names_ = {"joint1", "joint2"};
+  dof_state_values_ = {1.1, 2.2};
+  dof_command_values_ = {101.101, 202.202};
+  const std::vector<rclcpp::Parameter> parameters = {
+    {"dof_names", dof_names_}, {"gains.joint2.p", 1.0}, {"state_publish_rate", 10.0}};
+
+  // only known DoFs can be published
+  auto overrides = parameters;
+  overrides.emplace_back("state_dof_names", std::vector<std::string>{"joint3"});
+  SetUpController("test_pid_controller", overrides);
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_FAILURE);
+
+  controller_ = std::make_unique<TestablePidController>();
+  command_itfs_.clear();
+  state_itfs_.clear();
+  overrides = parameters;
+  overrides.emplace_back("state_dof_names", std::vector<std::string>{"joint2"});
+  SetUpController("test_pid_controller", overrides);
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_THAT(controller_->state_dof_indices_, testing::ElementsAre(1u));
+  ASSERT_EQ(controller_->state_publisher_->msg_.dof_states.size(), 1u);
+  EXPECT_EQ(controller_->state_publisher_->msg_.dof_states[0].name, "joint2");
+
+  // the first update publishes, the next ones once per period
+  const rclcpp::Time start(10, 0, RCL_ROS_TIME);
+  EXPECT_TRUE(controller_->should_publish_state(start));
+  EXPECT_FALSE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.05)));
+  EXPECT_TRUE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.11)));
+  EXPECT_FALSE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.15)));
+
+  // the published state is the one of the control loop
+  controller_->reference_interfaces_ = {3.2, 2.7};
+  ASSERT_EQ(
+    controller_->update(
+      start + rclcpp::Duration::from_seconds(0.25), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  const auto & dof_state = controller_->state_publisher_->msg_.dof_states[0];
+  EXPECT_DOUBLE_EQ(dof_state.reference, 2.7);
+  EXPECT_DOUBLE_EQ(dof_state.feedback, 2.2);
+  EXPECT_DOUBLE_EQ(dof_state.error, 0.5);
+  EXPECT_DOUBLE_EQ(dof_state.output, 0.5);
+  EXPECT_DOUBLE_EQ(dof_command_values_[1], 0.5);
+}
+
+TEST_F(PidControllerTest, state_publish_rate_follows_the_telemetry_rate_policy)
+{
+  SetUpController("test_pid_controller", {{"state_publish_rate", 100.0}});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  auto policy = telemetry_rate_policy::TelemetryRatePolicy::get_instance();
+  const std::string topic = controller_->s_publisher_->get_topic_name();
+
+  // the default rate of the process bounds the rate of the controller
+  ASSERT_TRUE(policy->set_default_rate(10.0));
+  const rclcpp::Time start(10, 0, RCL_ROS_TIME);
+  EXPECT_TRUE(controller_->should_publish_state(start));
+  EXPECT_FALSE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.05)));
+  EXPECT_TRUE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.11)));
+
+  // the rate of the topic replaces both
+  ASSERT_TRUE(policy->set_topic_rate(topic, 0.0));
+  EXPECT_TRUE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.12)));
+  EXPECT_TRUE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.13)));
+
+  ASSERT_TRUE(policy->set_topic_rate(topic, -1.0));
+  ASSERT_TRUE(policy->set_default_rate(0.0));
+  EXPECT_DOUBLE_EQ(controller_->state_publish_rate_->get_rate(), 100.0);
+}
+
+TEST_F(PidControllerTest, test_update_logic_cascade)
+{
+  // the cascade needs the derivative
+  SetUpController("test_pid_controller", {{"cascade", true}});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_FAILURE);
+
+  controller_ = std::make_unique<TestablePidController>();
+  command_itfs_.clear();
+  state_itfs_.clear();
+  state_interfaces_ = {"position", "velocity"};
+  dof_state_values_ = {1.1, 0.2};
+  SetUpController(
+    "test_pid_controller",
+    {{"cascade", true},
+     {"reference_and_state_interfaces", state_interfaces_},
+     {"gains.joint1.i", 0.0},
+     {"gains.joint1.d", 0.0},
+     {"inner_gains.joint1.p", 2.0}});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  EXPECT_EQ(controller_->inner_pid_bank_.get_gains(0).p, 2.0);
+
+  controller_->set_chained_mode(true);
+  controller_->reference_interfaces_ = {3.1, 0.0};
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  // the outer PID commands 2.0 * 1.0 as velocity, the inner one (2.0 - 0.2) * 2.0
+  EXPECT_DOUBLE_EQ(controller_->inner_pid_errors_[0], 1.8);
+  EXPECT_DOUBLE_EQ(dof_command_values_[0], 3.6);
+
+  // no command without the measured derivative
+  dof_state_values_[1] = std::numeric_limits<double>::quiet_NaN();
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(dof_command_values_[0], 3.6);
+}
+
+TEST_F(PidControllerTest, dofs_are_computed_every_update_divider_updates)
+{
+  SetUpController(
+    "test_pid_controller", {{"gains.joint1.i", 1.0},
+                            {"gains.joint1.d", 0.0},
+                            {"gains.joint1.update_divider", 3}});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  controller_->set_chained_mode(true);
+  controller_->reference_interfaces_ = {3.1};
+
+  // computed in the first update
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  ASSERT_EQ(controller_->update(rclcpp::Time(0), period), controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(dof_command_values_[0], 2.0 + 0.01 * 2.0);
+
+  // held in the next two updates, then integrated over the time of all three
+  dof_state_values_[0] = 2.1;
+  for (int update = 0; update < 2; ++update)
+  {
+    ASSERT_EQ(
+      controller_->update(rclcpp::Time(0), period), controller_interface::return_type::OK);
+    EXPECT_DOUBLE_EQ(dof_command_values_[0], 2.0 + 0.01 * 2.0);
+  }
+  ASSERT_EQ(controller_->update(rclcpp::Time(0), period), controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(dof_command_values_[0], 1.0 + 0.01 * 2.0 + 0.03 * 1.0);
+}
+
+TEST_F(PidControllerTest, gain_updates_are_applied_by_the_update)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->pid_bank_.get_gains(0).p, 1.0);
+
+  // the gains are prepared on the parameter change, but only used from the next update
+  ASSERT_TRUE(controller_->get_node()->set_parameter({"gains.joint1.p", 3.0}).successful);
+  ASSERT_TRUE(
+    controller_->get_node()->set_parameter({"gains.joint1.feedforward_gain", 0.5}).successful);
+  EXPECT_EQ(controller_->pid_bank_.get_gains(0).p, 1.0);
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(controller_->pid_bank_.get_gains(0).p, 3.0);
+  EXPECT_EQ(controller_->pid_bank_.get_gains(0).i, 2.0);
+  EXPECT_EQ(controller_->dof_gains_[0].feedforward_gain, 0.5);
+}
+
+TEST_F(PidControllerTest, update_is_realtime_safe)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // the gain update is prepared by the parameter callback, and applied by the first update
+  ASSERT_TRUE(controller_->get_node()->set_parameter({"gains.joint1.p", 3.0}).successful);
+  controller_->set_chained_mode(true);
+  controller_->reference_interfaces_[0] = 3.1;
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time(0);
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+
+  // the state is published in every update the realtime publisher isn't busy
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    time += period;
+    controller_->update(time, period);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -44,6 +44,7 @@ namespace
 {
 constexpr auto NODE_SUCCESS = controller_interface::CallbackReturn::SUCCESS;
 constexpr auto NODE_ERROR = controller_interface::CallbackReturn::ERROR;
+constexpr auto NODE_FAILURE = controller_interface::CallbackReturn::FAILURE;
 }  // namespace
 // namespace
 
@@ -59,7 +60,17 @@ class TestablePidController : public pid_controller::PidController
   FRIEND_TEST(PidControllerTest, test_update_logic_chainable_feedforward_off);
   FRIEND_TEST(PidControllerTest, test_update_logic_chainable_feedforward_on);
   FRIEND_TEST(PidControllerTest, subscribe_and_get_messages_success);
+  FRIEND_TEST(PidControllerTest, state_is_published_by_publisher_pool);
+  FRIEND_TEST(PidControllerTest, bounded_state_is_published);
+  FRIEND_TEST(PidControllerTest, pid_states_are_published);
   FRIEND_TEST(PidControllerTest, receive_message_and_publish_updated_status);
+  FRIEND_TEST(PidControllerTest, measured_state_message_is_validated);
+  FRIEND_TEST(PidControllerTest, measured_state_from_reference_interfaces_in_chained_mode);
+  FRIEND_TEST(PidControllerTest, state_is_published_for_subset_at_rate);
+  FRIEND_TEST(PidControllerTest, state_publish_rate_follows_the_telemetry_rate_policy);
+  FRIEND_TEST(PidControllerTest, test_update_logic_cascade);
+  FRIEND_TEST(PidControllerTest, gain_updates_are_applied_by_the_update);
+  FRIEND_TEST(PidControllerTest, update_is_realtime_safe);
 
 public:
   controller_interface::CallbackReturn on_configure(
@@ -144,9 +155,25 @@ public:
   void TearDown() { controller_.reset(nullptr); }
 
 protected:
-  void SetUpController(const std::string controller_name = "test_pid_controller")
+  void SetUpController(
+    const std::string controller_name = "test_pid_controller",
+    const std::vector<rclcpp::Parameter> & parameter_overrides = {})
   {
-    ASSERT_EQ(controller_->init(controller_name, "", 0), controller_interface::return_type::OK);
+    if (parameter_overrides.empty())
+    {
+      ASSERT_EQ(controller_->init(controller_name, "", 0), controller_interface::return_type::OK);
+    }
+    else
+    {
+      // the overrides take precedence over the parameters file, also for read-only parameters
+      const auto options = rclcpp::NodeOptions()
+                             .allow_undeclared_parameters(false)
+                             .parameter_overrides(parameter_overrides)
+                             .automatically_declare_parameters_from_overrides(false);
+      ASSERT_EQ(
+        controller_->init(controller_name, "", 0, "", options),
+        controller_interface::return_type::OK);
+    }
 
     std::vector<hardware_interface::LoanedCommandInterface> command_ifs;
     command_itfs_.reserve(dof_names_.size());
@@ -0,0 +1,77 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POSITION_CONTROLLERS__BATCHED_JOINT_GROUP_POSITION_CONTROLLER_HPP_
+#define POSITION_CONTROLLERS__BATCHED_JOINT_GROUP_POSITION_CONTROLLER_HPP_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "forward_command_controller/forward_controllers_base.hpp"
+#include "position_controllers/visibility_control.h"
+#include "rclcpp/subscription.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+// auto-generated by generate_parameter_library
+#include "batched_joint_group_position_controller_parameters.hpp"
+
+namespace position_controllers
+{
+/**
+ * \brief Position controller for the same group of joints of several identical robots.
+ *
+ * One instance replaces a JointGroupPositionController per robot, e.g., of a fleet in simulation.
+ * The commands of all robots are stored contiguously, robot after robot, so the timeout, rate
+ * limits and interpolation of ForwardControllersBase run in one loop over all joints.
+ *
+ * \param robots Names of the robots, which prefix the names of their joints.
+ * \param joints Names of the joints of one robot.
+ *
+ * Subscribes to:
+ * - \b commands (std_msgs::msg::Float64MultiArray) : The position commands of all joints of all
+ *   robots, robot after robot.
+ * - \b <robot>/commands (std_msgs::msg::Float64MultiArray) : The position commands of the joints of
+ *   one robot, if per_robot_topics is set. The other robots keep their last commands.
+ */
+class BatchedJointGroupPositionController
+: public forward_command_controller::ForwardControllersBase
+{
+public:
+  POSITION_CONTROLLERS_PUBLIC
+  BatchedJointGroupPositionController();
+
+  POSITION_CONTROLLERS_PUBLIC
+  controller_interface::CallbackReturn on_configure(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+protected:
+  void declare_parameters() override;
+  controller_interface::CallbackReturn read_parameters() override;
+
+  /// Replace the commands of the joints of \p robot_index with \p commands, not realtime-safe
+  void write_robot_commands(size_t robot_index, const std::vector<double> & commands);
+
+  std::shared_ptr<batched_joint_group_position_controller::ParamListener> param_listener_;
+  batched_joint_group_position_controller::Params params_;
+
+  // serializes the callbacks, which merge their commands into the last received ones
+  std::mutex commands_mutex_;
+  std::vector<rclcpp::Subscription<forward_command_controller::CmdType>::SharedPtr>
+    robot_command_subscribers_;
+};
+
+}  // namespace position_controllers
+
+#endif  // POSITION_CONTROLLERS__BATCHED_JOINT_GROUP_POSITION_CONTROLLER_HPP_
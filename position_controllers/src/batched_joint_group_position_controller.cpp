@@ -0,0 +1,178 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "position_controllers/batched_joint_group_position_controller.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/logging.hpp"
+#include "rclcpp/qos.hpp"
+
+namespace position_controllers
+{
+using forward_command_controller::CmdType;
+
+BatchedJointGroupPositionController::BatchedJointGroupPositionController()
+: forward_command_controller::ForwardControllersBase()
+{
+  interface_name_ = hardware_interface::HW_IF_POSITION;
+}
+
+void BatchedJointGroupPositionController::declare_parameters()
+{
+  param_listener_ =
+    std::make_shared<batched_joint_group_position_controller::ParamListener>(get_node());
+}
+
+controller_interface::CallbackReturn BatchedJointGroupPositionController::read_parameters()
+{
+  if (!param_listener_)
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Error encountered during init");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  params_ = param_listener_->get_params();
+
+  if (params_.robots.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'robots' parameter was empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  if (params_.joints.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'joints' parameter was empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  // robot after robot, so the joints of one robot are a contiguous slice of the commands
+  command_interface_types_.clear();
+  joint_names_.clear();
+  for (const auto & robot : params_.robots)
+  {
+    for (const auto & joint : params_.joints)
+    {
+      joint_names_.push_back(robot + params_.robot_joint_separator + joint);
+      command_interface_types_.push_back(joint_names_.back() + "/" + interface_name_);
+    }
+  }
+
+  set_interpolation(params_.interpolation);
+  return set_command_limits(
+    params_.command_timeout, "hold",
+    params_.max_command_rate > 0.0
+      ? std::vector<double>(command_interface_types_.size(), params_.max_command_rate)
+      : std::vector<double>());
+}
+
+controller_interface::CallbackReturn BatchedJointGroupPositionController::on_configure(
+  const rclcpp_lifecycle::State & previous_state)
+{
+  robot_command_subscribers_.clear();
+  auto ret = ForwardControllersBase::on_configure(previous_state);
+  if (ret != controller_interface::CallbackReturn::SUCCESS)
+  {
+    return ret;
+  }
+
+  // replaces the subscription of the base class, whose callback doesn't lock commands_mutex_
+  joints_command_subscriber_ = get_node()->create_subscription<CmdType>(
+    "~/commands", rclcpp::SystemDefaultsQoS(),
+    [this](const CmdType::SharedPtr msg)
+    {
+      if (msg->data.size() != command_interface_types_.size())
+      {
+        RCLCPP_ERROR_THROTTLE(
+          get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+          "command size (%zu) does not match number of interfaces (%zu), ignoring it",
+          msg->data.size(), command_interface_types_.size());
+        return;
+      }
+      std::lock_guard<std::mutex> guard(commands_mutex_);
+      rt_command_ptr_.writeFromNonRT(msg);
+      received_commands_.fetch_add(1, std::memory_order_release);
+    });
+
+  if (!params_.per_robot_topics)
+  {
+    return controller_interface::CallbackReturn::SUCCESS;
+  }
+
+  try
+  {
+    for (size_t robot_index = 0; robot_index < params_.robots.size(); ++robot_index)
+    {
+      robot_command_subscribers_.push_back(get_node()->create_subscription<CmdType>(
+        "~/" + params_.robots[robot_index] + "/commands", rclcpp::SystemDefaultsQoS(),
+        [this, robot_index](const CmdType::SharedPtr msg)
+        {
+          if (msg->data.size() != params_.joints.size())
+          {
+            RCLCPP_ERROR_THROTTLE(
+              get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+              "command size (%zu) of robot '%s' does not match number of joints (%zu)",
+              msg->data.size(), params_.robots[robot_index].c_str(), params_.joints.size());
+            return;
+          }
+          write_robot_commands(robot_index, msg->data);
+        }));
+    }
+  }
+  catch (const std::exception & e)
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Can't subscribe to the commands of every robot: %s", e.what());
+    robot_command_subscribers_.clear();
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+void BatchedJointGroupPositionController::write_robot_commands(
+  const size_t robot_index, const std::vector<double> & commands)
+{
+  // the realtime loop only swaps the pointer, so the merged commands are a new message
+  auto merged = std::make_shared<CmdType>();
+  std::lock_guard<std::mutex> guard(commands_mutex_);
+  const auto * last_received = rt_command_ptr_.readFromNonRT();
+  if (last_received && *last_received)
+  {
+    merged->data = (*last_received)->data;
+  }
+  else
+  {
+    // robots without a command yet are skipped by update_and_write_commands()
+    merged->data.assign(command_interface_types_.size(), std::numeric_limits<double>::quiet_NaN());
+  }
+  std::copy(
+    commands.begin(), commands.end(),
+    merged->data.begin() + static_cast<std::ptrdiff_t>(robot_index * params_.joints.size()));
+  rt_command_ptr_.writeFromNonRT(merged);
+  received_commands_.fetch_add(1, std::memory_order_release);
+}
+
+}  // namespace position_controllers
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  position_controllers::BatchedJointGroupPositionController,
+  controller_interface::ChainableControllerInterface)
@@ -56,4 +56,5 @@ controller_interface::CallbackReturn JointGroupPositionController::on_init()
 #include "pluginlib/class_list_macros.hpp"
 
 PLUGINLIB_EXPORT_CLASS(
-  position_controllers::JointGroupPositionController, controller_interface::ControllerInterface)
+  position_controllers::JointGroupPositionController,
+  controller_interface::ChainableControllerInterface)
@@ -0,0 +1,160 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/utilities.hpp"
+#include "rclcpp/wait_set.hpp"
+#include "test_batched_joint_group_position_controller.hpp"
+
+using CallbackReturn = controller_interface::CallbackReturn;
+using hardware_interface::LoanedCommandInterface;
+
+namespace
+{
+rclcpp::WaitResultKind wait_for(rclcpp::SubscriptionBase::SharedPtr subscription)
+{
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  const auto timeout = std::chrono::seconds(10);
+  return wait_set.wait(timeout).kind();
+}
+}  // namespace
+
+void BatchedJointGroupPositionControllerTest::SetUpTestCase() { rclcpp::init(0, nullptr); }
+
+void BatchedJointGroupPositionControllerTest::TearDownTestCase() { rclcpp::shutdown(); }
+
+void BatchedJointGroupPositionControllerTest::SetUp()
+{
+  controller_ = std::make_unique<FriendBatchedJointGroupPositionController>();
+}
+
+void BatchedJointGroupPositionControllerTest::TearDown() { controller_.reset(nullptr); }
+
+void BatchedJointGroupPositionControllerTest::SetUpController()
+{
+  const auto result = controller_->init("test_batched_joint_group_position_controller", "", 0);
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(robot_1_joint_1_pos_cmd_);
+  command_ifs.emplace_back(robot_1_joint_2_pos_cmd_);
+  command_ifs.emplace_back(robot_2_joint_1_pos_cmd_);
+  command_ifs.emplace_back(robot_2_joint_2_pos_cmd_);
+  controller_->assign_interfaces(std::move(command_ifs), {});
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+}
+
+TEST_F(BatchedJointGroupPositionControllerTest, RobotsParameterIsEmpty)
+{
+  SetUpController();
+
+  // configure failed, 'robots' parameter not set
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::ERROR);
+}
+
+TEST_F(BatchedJointGroupPositionControllerTest, InterfacesRobotAfterRobot)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"robots", robot_names_});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+
+  EXPECT_THAT(
+    controller_->command_interface_configuration().names,
+    ::testing::ElementsAre(
+      "robot1_joint1/position", "robot1_joint2/position", "robot2_joint1/position",
+      "robot2_joint2/position"));
+
+  // reconfiguring doesn't add the interfaces again
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+  EXPECT_EQ(controller_->command_interface_configuration().names.size(), 4u);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+}
+
+TEST_F(BatchedJointGroupPositionControllerTest, BatchCommandTest)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"robots", robot_names_});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+
+  auto command_ptr = std::make_shared<forward_command_controller::CmdType>();
+  command_ptr->data = {10.0, 20.0, 30.0, 40.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_ptr);
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_THAT(joint_commands_, ::testing::ElementsAre(10.0, 20.0, 30.0, 40.0));
+}
+
+TEST_F(BatchedJointGroupPositionControllerTest, RobotCommandKeepsOtherRobotsTest)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"robots", robot_names_});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+
+  // robot1 has no command yet, its joints keep their commands
+  controller_->write_robot_commands(1, {30.0, 40.0});
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_THAT(joint_commands_, ::testing::ElementsAre(1.1, 2.1, 30.0, 40.0));
+
+  // the command of robot1 is merged with the last one of robot2
+  controller_->write_robot_commands(0, {10.0, 20.0});
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_THAT(joint_commands_, ::testing::ElementsAre(10.0, 20.0, 30.0, 40.0));
+}
+
+TEST_F(BatchedJointGroupPositionControllerTest, RobotCommandCallbackTest)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"robots", robot_names_});
+  controller_->get_node()->set_parameter({"per_robot_topics", true});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+  ASSERT_EQ(controller_->robot_command_subscribers_.size(), 2u);
+
+  // send a command to robot2 only
+  rclcpp::Node test_node("test_node");
+  auto command_pub = test_node.create_publisher<std_msgs::msg::Float64MultiArray>(
+    std::string(controller_->get_node()->get_name()) + "/robot2/commands",
+    rclcpp::SystemDefaultsQoS());
+  std_msgs::msg::Float64MultiArray command_msg;
+  command_msg.data = {30.0, 40.0};
+  command_pub->publish(command_msg);
+
+  ASSERT_EQ(wait_for(controller_->robot_command_subscribers_[1]), rclcpp::WaitResultKind::Ready);
+  rclcpp::spin_some(controller_->get_node()->get_node_base_interface());
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_THAT(joint_commands_, ::testing::ElementsAre(1.1, 2.1, 30.0, 40.0));
+}
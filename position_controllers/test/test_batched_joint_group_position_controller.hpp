@@ -0,0 +1,65 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TEST_BATCHED_JOINT_GROUP_POSITION_CONTROLLER_HPP_
+#define TEST_BATCHED_JOINT_GROUP_POSITION_CONTROLLER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "position_controllers/batched_joint_group_position_controller.hpp"
+
+using hardware_interface::CommandInterface;
+using hardware_interface::HW_IF_POSITION;
+
+// subclassing and friending so we can access member variables
+class FriendBatchedJointGroupPositionController
+: public position_controllers::BatchedJointGroupPositionController
+{
+  FRIEND_TEST(BatchedJointGroupPositionControllerTest, BatchCommandTest);
+  FRIEND_TEST(BatchedJointGroupPositionControllerTest, RobotCommandKeepsOtherRobotsTest);
+  FRIEND_TEST(BatchedJointGroupPositionControllerTest, RobotCommandCallbackTest);
+};
+
+class BatchedJointGroupPositionControllerTest : public ::testing::Test
+{
+public:
+  static void SetUpTestCase();
+  static void TearDownTestCase();
+
+  void SetUp();
+  void TearDown();
+
+  void SetUpController();
+
+protected:
+  std::unique_ptr<FriendBatchedJointGroupPositionController> controller_;
+
+  // two robots with two joints each, commanded robot after robot
+  const std::vector<std::string> robot_names_ = {"robot1", "robot2"};
+  const std::vector<std::string> joint_names_ = {"joint1", "joint2"};
+  std::vector<double> joint_commands_ = {1.1, 2.1, 3.1, 4.1};
+
+  CommandInterface robot_1_joint_1_pos_cmd_{"robot1_joint1", HW_IF_POSITION, &joint_commands_[0]};
+  CommandInterface robot_1_joint_2_pos_cmd_{"robot1_joint2", HW_IF_POSITION, &joint_commands_[1]};
+  CommandInterface robot_2_joint_1_pos_cmd_{"robot2_joint1", HW_IF_POSITION, &joint_commands_[2]};
+  CommandInterface robot_2_joint_2_pos_cmd_{"robot2_joint2", HW_IF_POSITION, &joint_commands_[3]};
+};
+
+#endif  // TEST_BATCHED_JOINT_GROUP_POSITION_CONTROLLER_HPP_
@@ -0,0 +1,111 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PUBLISHER_POOL__LOANED_PUBLISHER_HPP_
+#define PUBLISHER_POOL__LOANED_PUBLISHER_HPP_
+
+#include <memory>
+#include <utility>
+
+#include "publisher_pool/publisher_pool.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
+#include "rclcpp/exceptions.hpp"
+#include "rclcpp/publisher.hpp"
+
+namespace publisher_pool
+{
+/**
+ * \brief Publisher of a message of fixed size, loaned from the middleware if it supports it.
+ *
+ * Middlewares with a shared memory transport, e.g., iceoryx or Zenoh, loan messages of fixed size
+ * which the realtime loop fills in place, so they are neither allocated, copied nor serialized.
+ * Otherwise, the message is filled and published by a RealtimePublisher, from \p pool if given.
+ *
+ * \code
+ * // on configuration
+ * bounded_state_publisher_ =
+ *   std::make_unique<publisher_pool::LoanedPublisher<BoundedStateMsg>>(bounded_publisher, pool);
+ * // in the control loop
+ * bounded_state_publisher_->publish([&](BoundedStateMsg & msg) { msg.stamp = time; });
+ * \endcode
+ */
+template <typename MessageT>
+class LoanedPublisher
+{
+public:
+  using PublisherSharedPtr = typename rclcpp::Publisher<MessageT>::SharedPtr;
+
+  /// Publish on \p publisher, see RealtimePublisher for \p pool and \p publish_unique_ptr
+  explicit LoanedPublisher(
+    PublisherSharedPtr publisher, std::shared_ptr<PublisherPool> pool = nullptr,
+    const bool publish_unique_ptr = false)
+  : publisher_(std::move(publisher))
+  {
+    if (!publisher_->can_loan_messages())
+    {
+      realtime_publisher_ =
+        std::make_unique<RealtimePublisher<MessageT>>(publisher_, pool, publish_unique_ptr);
+    }
+  }
+
+  LoanedPublisher(const LoanedPublisher &) = delete;
+  LoanedPublisher & operator=(const LoanedPublisher &) = delete;
+
+  /// True if the messages are loaned from the middleware
+  bool is_loaning() const { return !realtime_publisher_; }
+
+  /// Fill a message with \p fill and publish it, realtime-safe
+  /**
+   * Without loans, the message isn't filled while the previous one isn't published yet, like with
+   * RealtimePublisher::trylock().
+   * \param fill callable taking a MessageT &, which gets a loaned message, or the message of the
+   * realtime publisher holding the values of the previous call
+   * \return false if the middleware couldn't loan a message, e.g., because slow subscribers hold
+   * all loans of the shared memory transport
+   */
+  template <typename FillT>
+  bool publish(FillT && fill)
+  {
+    if (realtime_publisher_)
+    {
+      if (realtime_publisher_->trylock())
+      {
+        fill(realtime_publisher_->msg_);
+        realtime_publisher_->unlockAndPublish();
+      }
+      return true;
+    }
+
+    try
+    {
+      auto loaned_msg = publisher_->borrow_loaned_message();
+      fill(loaned_msg.get());
+      publisher_->publish(std::move(loaned_msg));
+      return true;
+    }
+    catch (const rclcpp::exceptions::RCLError &)
+    {
+      return false;
+    }
+  }
+
+private:
+  PublisherSharedPtr publisher_;
+  // publishes a copy if the middleware can't loan messages
+  std::unique_ptr<RealtimePublisher<MessageT>> realtime_publisher_;
+};
+
+}  // namespace publisher_pool
+
+#endif  // PUBLISHER_POOL__LOANED_PUBLISHER_HPP_
@@ -0,0 +1,151 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PUBLISHER_POOL__PUBLISHER_POOL_HPP_
+#define PUBLISHER_POOL__PUBLISHER_POOL_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "publisher_pool/visibility_control.h"
+
+namespace publisher_pool
+{
+/// Configuration of a PublisherPool, normally set from the `publisher_pool` parameters
+struct PublisherPoolOptions
+{
+  /// Number of publishing threads
+  size_t threads = 1;
+  /// CPUs the threads may run on, all CPUs if empty
+  std::vector<int> cpu_affinity;
+
+  bool operator==(const PublisherPoolOptions & other) const
+  {
+    return threads == other.threads && cpu_affinity == other.cpu_affinity;
+  }
+};
+
+/// Publisher whose messages are published by the threads of a PublisherPool
+class PooledPublisherInterface
+{
+public:
+  virtual ~PooledPublisherInterface() = default;
+
+  /// Publish the message handed over by the realtime thread if there is one, not realtime-safe
+  virtual void publish_pending() = 0;
+};
+
+/**
+ * \brief Threads publishing the messages of many realtime publishers.
+ *
+ * Every realtime_tools::RealtimePublisher owns a thread, so a controller manager with many
+ * controllers runs dozens of mostly idle threads. The publishers of
+ * publisher_pool::RealtimePublisher are instead distributed over the few threads of a pool, which
+ * check their publishers for new messages every POLL_PERIOD, like the thread of a
+ * realtime_tools::RealtimePublisher does.
+ * The realtime thread never wakes the threads, so handing over a message never blocks it.
+ */
+class PublisherPool
+{
+public:
+  /// Period between two checks for new messages, the same as in realtime_tools
+  static constexpr std::chrono::microseconds POLL_PERIOD{500};
+
+  /// Start the threads, not realtime-safe
+  /**
+   * \throws std::invalid_argument if \p options has no threads or a negative CPU
+   */
+  PUBLISHER_POOL_PUBLIC
+  explicit PublisherPool(const PublisherPoolOptions & options);
+
+  /// The pool of this process with \p options, created if there is none
+  /**
+   * All controllers with the same options share one pool, which exists as long as any of them
+   * holds it.
+   *
+   * \throws std::invalid_argument if \p options are invalid
+   */
+  PUBLISHER_POOL_PUBLIC
+  static std::shared_ptr<PublisherPool> get_shared(const PublisherPoolOptions & options);
+
+  /// Stop the threads, the publishers have to be removed before
+  PUBLISHER_POOL_PUBLIC
+  ~PublisherPool();
+
+  PublisherPool(const PublisherPool &) = delete;
+  PublisherPool & operator=(const PublisherPool &) = delete;
+
+  /// Let the thread with the fewest publishers publish the messages of \p publisher
+  PUBLISHER_POOL_PUBLIC
+  void add(PooledPublisherInterface * publisher);
+
+  /// Stop publishing the messages of \p publisher, which isn't used by the pool on return
+  PUBLISHER_POOL_PUBLIC
+  void remove(PooledPublisherInterface * publisher);
+
+  const PublisherPoolOptions & get_options() const { return options_; }
+
+  /// False if the CPU affinity of the options couldn't be applied to all threads
+  bool is_cpu_affinity_applied() const { return cpu_affinity_applied_; }
+
+  /// Number of publishers added to the thread with \p index
+  PUBLISHER_POOL_PUBLIC
+  size_t get_publisher_count(size_t index) const;
+
+private:
+  struct Worker
+  {
+    mutable std::mutex mutex;
+    std::condition_variable stop_condition;
+    bool stop = false;
+    std::vector<PooledPublisherInterface *> publishers;
+    std::thread thread;
+  };
+
+  void run(Worker & worker);
+  bool set_cpu_affinity(std::thread & thread, size_t index);
+
+  const PublisherPoolOptions options_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  bool cpu_affinity_applied_ = true;
+};
+
+/// \return the shared pool of the `publisher_pool` parameters \p params, nullptr if not enabled
+/**
+ * \tparam ParamsT generated parameters with `enable`, `threads` and `cpu_affinity`
+ */
+template <typename ParamsT>
+std::shared_ptr<PublisherPool> get_shared_pool(const ParamsT & params)
+{
+  if (!params.enable)
+  {
+    return nullptr;
+  }
+  PublisherPoolOptions options;
+  options.threads = static_cast<size_t>(params.threads);
+  for (const auto cpu : params.cpu_affinity)
+  {
+    options.cpu_affinity.push_back(static_cast<int>(cpu));
+  }
+  return PublisherPool::get_shared(options);
+}
+
+}  // namespace publisher_pool
+
+#endif  // PUBLISHER_POOL__PUBLISHER_POOL_HPP_
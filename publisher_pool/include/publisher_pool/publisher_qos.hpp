@@ -0,0 +1,73 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PUBLISHER_POOL__PUBLISHER_QOS_HPP_
+#define PUBLISHER_POOL__PUBLISHER_QOS_HPP_
+
+#include <stdexcept>
+#include <string>
+
+#include "rclcpp/qos.hpp"
+
+namespace publisher_pool
+{
+/// \return the QoS of a state topic from its `qos.<topic>` parameters \p params
+/**
+ * The QoS starts from rclcpp::SystemDefaultsQoS(), which is kept for the policies with the value
+ * "system_default", or depth 0.
+ *
+ * \tparam ParamsT generated parameters with `reliability` ("system_default", "reliable" or
+ * "best_effort"), `durability` ("system_default", "volatile" or "transient_local") and `depth`
+ * \throws std::invalid_argument for another reliability or durability
+ */
+template <typename ParamsT>
+rclcpp::QoS make_qos(const ParamsT & params)
+{
+  rclcpp::QoS qos = rclcpp::SystemDefaultsQoS();
+  if (params.depth > 0)
+  {
+    qos.keep_last(static_cast<size_t>(params.depth));
+  }
+
+  if (params.reliability == "reliable")
+  {
+    qos.reliable();
+  }
+  else if (params.reliability == "best_effort")
+  {
+    qos.best_effort();
+  }
+  else if (params.reliability != "system_default")
+  {
+    throw std::invalid_argument("Unknown reliability '" + params.reliability + "'.");
+  }
+
+  if (params.durability == "volatile")
+  {
+    qos.durability_volatile();
+  }
+  else if (params.durability == "transient_local")
+  {
+    qos.transient_local();
+  }
+  else if (params.durability != "system_default")
+  {
+    throw std::invalid_argument("Unknown durability '" + params.durability + "'.");
+  }
+  return qos;
+}
+
+}  // namespace publisher_pool
+
+#endif  // PUBLISHER_POOL__PUBLISHER_QOS_HPP_
@@ -0,0 +1,317 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PUBLISHER_POOL__REALTIME_PUBLISHER_HPP_
+#define PUBLISHER_POOL__REALTIME_PUBLISHER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "publisher_pool/publisher_pool.hpp"
+#include "rclcpp/logging.hpp"
+#include "rclcpp/publisher.hpp"
+#include "realtime_tools/realtime_publisher.h"
+
+namespace publisher_pool
+{
+/**
+ * \brief Drop-in replacement of realtime_tools::RealtimePublisher publishing from a PublisherPool.
+ *
+ * Without a pool, this is a realtime_tools::RealtimePublisher with its own thread. With a pool,
+ * unlockAndPublish() only marks the message as pending, and a thread of the pool publishes it
+ * within PublisherPool::POLL_PERIOD. Until then, trylock() fails like it does while the thread
+ * of a realtime_tools::RealtimePublisher hasn't published the previous message.
+ *
+ * With \p publish_unique_ptr, the thread of the pool copies the message into a std::unique_ptr
+ * while holding the lock, and publishes it after releasing the lock. Intra-process subscribers then
+ * take over that message without another copy by rclcpp, and the realtime loop can fill the next
+ * message while the middleware publishes.
+ *
+ * With a \p queue_depth, unlockAndPublish() copies the message into a lock-free ring of that many
+ * preallocated messages instead, and trylock() only fails, counting the dropped message, while the
+ * ring is full. The messages of the ring are published in order by the thread of the pool, or by
+ * an own thread polling every PublisherPool::POLL_PERIOD without a pool, so bursts of messages are
+ * not lost while the thread is late. The count of the dropped messages is logged by that thread.
+ *
+ * \code
+ * // on configuration
+ * auto pool = publisher_pool::get_shared_pool(params_.publisher_pool);
+ * state_publisher_ =
+ *   std::make_unique<publisher_pool::RealtimePublisher<StateMsg>>(state_publisher, pool);
+ * // in the control loop
+ * if (state_publisher_->trylock())
+ * {
+ *   state_publisher_->msg_.header.stamp = time;
+ *   state_publisher_->unlockAndPublish();
+ * }
+ * \endcode
+ */
+template <typename MessageT>
+class RealtimePublisher : private PooledPublisherInterface
+{
+  // declared before msg_, which refers to them
+  std::unique_ptr<realtime_tools::RealtimePublisher<MessageT>> dedicated_publisher_;
+  MessageT pooled_msg_;
+
+public:
+  using PublisherSharedPtr = typename rclcpp::Publisher<MessageT>::SharedPtr;
+
+  /// Publish on \p publisher from a thread of \p pool, or from an own thread if it is nullptr
+  /**
+   * \param publish_unique_ptr publish a std::unique_ptr from the pool or the queue, ignored
+   * otherwise
+   * \param queue_depth number of messages queued for publishing, 0 to drop the messages while the
+   * previous one isn't published
+   */
+  explicit RealtimePublisher(
+    PublisherSharedPtr publisher, std::shared_ptr<PublisherPool> pool = nullptr,
+    const bool publish_unique_ptr = false, const size_t queue_depth = 0)
+  : dedicated_publisher_(
+      pool || queue_depth > 0
+        ? nullptr
+        : std::make_unique<realtime_tools::RealtimePublisher<MessageT>>(publisher)),
+    msg_(dedicated_publisher_ ? dedicated_publisher_->msg_ : pooled_msg_),
+    publisher_(std::move(publisher)),
+    pool_(std::move(pool)),
+    publish_unique_ptr_(publish_unique_ptr),
+    queue_(queue_depth)
+  {
+    if (pool_)
+    {
+      pool_->add(this);
+    }
+    else if (!queue_.empty())
+    {
+      queue_thread_running_ = true;
+      queue_thread_ = std::thread(
+        [this]()
+        {
+          while (queue_thread_running_.load(std::memory_order_relaxed))
+          {
+            publish_pending();
+            std::this_thread::sleep_for(PublisherPool::POLL_PERIOD);
+          }
+          publish_pending();
+        });
+    }
+  }
+
+  ~RealtimePublisher() override
+  {
+    if (pool_)
+    {
+      pool_->remove(this);
+    }
+    if (queue_thread_.joinable())
+    {
+      queue_thread_running_ = false;
+      queue_thread_.join();
+    }
+  }
+
+  RealtimePublisher(const RealtimePublisher &) = delete;
+  RealtimePublisher & operator=(const RealtimePublisher &) = delete;
+
+  /// Lock the message if the previous one was published, or the queue isn't full, realtime-safe
+  bool trylock()
+  {
+    const bool locked = try_lock_msg();
+    if (!locked)
+    {
+      dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return locked;
+  }
+
+  /// Unlock the message and hand it over for publishing, realtime-safe
+  void unlockAndPublish()
+  {
+    if (dedicated_publisher_)
+    {
+      dedicated_publisher_->unlockAndPublish();
+      return;
+    }
+    if (!queue_.empty())
+    {
+      // assigning reuses the memory of the slot, which was initialized with the message in unlock()
+      const size_t head = queue_head_.load(std::memory_order_relaxed);
+      queue_[head % queue_.size()] = msg_;
+      queue_head_.store(head + 1, std::memory_order_release);
+      msg_mutex_.unlock();
+      return;
+    }
+    pending_.store(true, std::memory_order_release);
+    msg_mutex_.unlock();
+  }
+
+  /// Lock the message, e.g., to initialize it, without waiting for the previous one to be published
+  void lock()
+  {
+    if (dedicated_publisher_)
+    {
+      dedicated_publisher_->lock();
+      return;
+    }
+    // never actually block on the lock, like realtime_tools
+    while (!msg_mutex_.try_lock())
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  /// Unlock the message without publishing it
+  /**
+   * With a queue, the free slots of the queue are initialized with the message, so copying
+   * messages of the same sizes into them doesn't allocate in unlockAndPublish().
+   */
+  void unlock()
+  {
+    if (dedicated_publisher_)
+    {
+      dedicated_publisher_->unlock();
+      return;
+    }
+    // the slots from the head up to a full queue are not published, the tail only moves on
+    const size_t head = queue_head_.load(std::memory_order_relaxed);
+    const size_t end = queue_tail_.load(std::memory_order_acquire) + queue_.size();
+    for (size_t i = head; i < end; ++i)
+    {
+      queue_[i % queue_.size()] = msg_;
+    }
+    msg_mutex_.unlock();
+  }
+
+  /// True if the messages are published by a PublisherPool
+  bool is_pooled() const { return static_cast<bool>(pool_); }
+
+  /// Number of messages queued for publishing, 0 if the messages are not queued
+  size_t get_queue_depth() const { return queue_.size(); }
+
+  /// Number of messages dropped since the construction, i.e., of the calls of trylock() failing
+  size_t get_dropped_count() const { return dropped_count_.load(std::memory_order_relaxed); }
+
+  /// Message filled while locked
+  MessageT & msg_;
+
+private:
+  bool try_lock_msg()
+  {
+    if (dedicated_publisher_)
+    {
+      return dedicated_publisher_->trylock();
+    }
+    if (!queue_.empty())
+    {
+      const size_t tail = queue_tail_.load(std::memory_order_acquire);
+      if (queue_head_.load(std::memory_order_relaxed) - tail >= queue_.size())
+      {
+        return false;
+      }
+      return msg_mutex_.try_lock();
+    }
+    if (pending_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    return msg_mutex_.try_lock();
+  }
+
+  void publish_queued()
+  {
+    const size_t head = queue_head_.load(std::memory_order_acquire);
+    for (size_t tail = queue_tail_.load(std::memory_order_relaxed); tail != head; ++tail)
+    {
+      const MessageT & message = queue_[tail % queue_.size()];
+      if (publish_unique_ptr_)
+      {
+        publisher_->publish(std::make_unique<MessageT>(message));
+      }
+      else
+      {
+        publisher_->publish(message);
+      }
+      // the slot may be filled again from now on
+      queue_tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    // at most once per second, so a full queue doesn't flood the log
+    const size_t dropped_count = get_dropped_count();
+    const auto now = std::chrono::steady_clock::now();
+    if (dropped_count != reported_dropped_count_ && now - last_drop_report_ >= DROP_REPORT_PERIOD)
+    {
+      RCLCPP_WARN(
+        rclcpp::get_logger("publisher_pool"),
+        "Dropped %zu messages on '%s' since the last report, the queue of %zu messages was full.",
+        dropped_count - reported_dropped_count_, publisher_->get_topic_name(), queue_.size());
+      reported_dropped_count_ = dropped_count;
+      last_drop_report_ = now;
+    }
+  }
+
+  void publish_pending() override
+  {
+    if (!queue_.empty())
+    {
+      publish_queued();
+      return;
+    }
+    // a message being filled is checked again in the next period
+    if (!pending_.load(std::memory_order_acquire) || !msg_mutex_.try_lock())
+    {
+      return;
+    }
+    if (!publish_unique_ptr_)
+    {
+      publisher_->publish(msg_);
+      pending_.store(false, std::memory_order_release);
+      msg_mutex_.unlock();
+      return;
+    }
+    // the copy rclcpp would make for intra-process subscribers, taken over by them
+    auto message = std::make_unique<MessageT>(msg_);
+    pending_.store(false, std::memory_order_release);
+    msg_mutex_.unlock();
+    publisher_->publish(std::move(message));
+  }
+
+  PublisherSharedPtr publisher_;
+  std::shared_ptr<PublisherPool> pool_;
+  bool publish_unique_ptr_;
+  std::mutex msg_mutex_;
+  std::atomic<bool> pending_{false};
+  std::atomic<size_t> dropped_count_{0};
+
+  static constexpr std::chrono::seconds DROP_REPORT_PERIOD{1};
+  // single-producer single-consumer ring, the head is only moved by unlockAndPublish() and the
+  // tail by the publishing thread, their difference is the number of queued messages
+  std::vector<MessageT> queue_;
+  std::atomic<size_t> queue_head_{0};
+  std::atomic<size_t> queue_tail_{0};
+  // only used by the publishing thread
+  size_t reported_dropped_count_ = 0;
+  std::chrono::steady_clock::time_point last_drop_report_;
+  // publishing thread of the queue without a pool
+  std::thread queue_thread_;
+  std::atomic<bool> queue_thread_running_{false};
+};
+
+}  // namespace publisher_pool
+
+#endif  // PUBLISHER_POOL__REALTIME_PUBLISHER_HPP_
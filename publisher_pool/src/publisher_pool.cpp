@@ -0,0 +1,179 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "publisher_pool/publisher_pool.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "rclcpp/logging.hpp"
+
+namespace publisher_pool
+{
+PublisherPool::PublisherPool(const PublisherPoolOptions & options) : options_(options)
+{
+  if (options_.threads < 1)
+  {
+    throw std::invalid_argument("A publisher pool needs at least one thread.");
+  }
+  if (std::any_of(
+        options_.cpu_affinity.begin(), options_.cpu_affinity.end(),
+        [](int cpu) { return cpu < 0; }))
+  {
+    throw std::invalid_argument("The CPUs of a publisher pool can't be negative.");
+  }
+
+  workers_.reserve(options_.threads);
+  for (size_t index = 0; index < options_.threads; ++index)
+  {
+    workers_.push_back(std::make_unique<Worker>());
+    auto & worker = *workers_.back();
+    worker.thread = std::thread(&PublisherPool::run, this, std::ref(worker));
+    if (!set_cpu_affinity(worker.thread, index))
+    {
+      cpu_affinity_applied_ = false;
+    }
+  }
+}
+
+std::shared_ptr<PublisherPool> PublisherPool::get_shared(const PublisherPoolOptions & options)
+{
+  static std::mutex pools_mutex;
+  static std::vector<std::weak_ptr<PublisherPool>> pools;
+
+  std::lock_guard<std::mutex> guard(pools_mutex);
+  // forget the pools nobody holds anymore
+  pools.erase(
+    std::remove_if(
+      pools.begin(), pools.end(), [](const auto & pool) { return pool.expired(); }),
+    pools.end());
+  for (const auto & weak_pool : pools)
+  {
+    auto pool = weak_pool.lock();
+    if (pool && pool->get_options() == options)
+    {
+      return pool;
+    }
+  }
+  auto pool = std::make_shared<PublisherPool>(options);
+  pools.push_back(pool);
+  return pool;
+}
+
+PublisherPool::~PublisherPool()
+{
+  for (auto & worker : workers_)
+  {
+    {
+      std::lock_guard<std::mutex> guard(worker->mutex);
+      worker->stop = true;
+    }
+    worker->stop_condition.notify_all();
+  }
+  for (auto & worker : workers_)
+  {
+    if (worker->thread.joinable())
+    {
+      worker->thread.join();
+    }
+  }
+}
+
+void PublisherPool::add(PooledPublisherInterface * publisher)
+{
+  size_t least_busy = 0;
+  for (size_t index = 1; index < workers_.size(); ++index)
+  {
+    if (get_publisher_count(index) < get_publisher_count(least_busy))
+    {
+      least_busy = index;
+    }
+  }
+  std::lock_guard<std::mutex> guard(workers_[least_busy]->mutex);
+  workers_[least_busy]->publishers.push_back(publisher);
+}
+
+void PublisherPool::remove(PooledPublisherInterface * publisher)
+{
+  for (auto & worker : workers_)
+  {
+    // the worker publishes while holding the lock, so it has finished with the publisher after it
+    std::lock_guard<std::mutex> guard(worker->mutex);
+    auto & publishers = worker->publishers;
+    publishers.erase(
+      std::remove(publishers.begin(), publishers.end(), publisher), publishers.end());
+  }
+}
+
+size_t PublisherPool::get_publisher_count(size_t index) const
+{
+  std::lock_guard<std::mutex> guard(workers_.at(index)->mutex);
+  return workers_[index]->publishers.size();
+}
+
+void PublisherPool::run(Worker & worker)
+{
+  std::unique_lock<std::mutex> lock(worker.mutex);
+  while (!worker.stop)
+  {
+    for (auto * publisher : worker.publishers)
+    {
+      publisher->publish_pending();
+    }
+    worker.stop_condition.wait_for(lock, POLL_PERIOD, [&worker]() { return worker.stop; });
+  }
+}
+
+bool PublisherPool::set_cpu_affinity(std::thread & thread, size_t index)
+{
+  if (options_.cpu_affinity.empty())
+  {
+    return true;
+  }
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const int cpu : options_.cpu_affinity)
+  {
+    if (cpu < CPU_SETSIZE)
+    {
+      CPU_SET(static_cast<size_t>(cpu), &cpu_set);
+    }
+  }
+  const int result = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+  if (result == 0)
+  {
+    return true;
+  }
+  RCLCPP_WARN(
+    rclcpp::get_logger("publisher_pool"),
+    "Could not set the CPU affinity of publishing thread %zu: error %d.", index, result);
+#else
+  (void)thread;
+  RCLCPP_WARN(
+    rclcpp::get_logger("publisher_pool"),
+    "The CPU affinity of publishing thread %zu is not supported on this platform.", index);
+#endif
+  return false;
+}
+
+}  // namespace publisher_pool
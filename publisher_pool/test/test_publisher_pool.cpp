@@ -0,0 +1,309 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "publisher_pool/loaned_publisher.hpp"
+#include "publisher_pool/publisher_pool.hpp"
+#include "publisher_pool/publisher_qos.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "std_msgs/msg/int32.hpp"
+
+using namespace std::chrono_literals;
+using publisher_pool::PublisherPool;
+using publisher_pool::PublisherPoolOptions;
+using Int32Publisher = publisher_pool::RealtimePublisher<std_msgs::msg::Int32>;
+
+class TestPublisherPool : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase() { rclcpp::init(0, nullptr); }
+
+  static void TearDownTestCase() { rclcpp::shutdown(); }
+
+  void SetUp() override { node_ = std::make_shared<rclcpp::Node>("test_publisher_pool"); }
+
+  /// Publisher on \p topic_name whose received messages are stored in \p messages
+  std::unique_ptr<Int32Publisher> make_publisher(
+    const std::string & topic_name, std::shared_ptr<PublisherPool> pool,
+    std::vector<int32_t> & messages, const bool publish_unique_ptr = false,
+    const size_t queue_depth = 0)
+  {
+    subscriptions_.push_back(node_->create_subscription<std_msgs::msg::Int32>(
+      topic_name, rclcpp::SystemDefaultsQoS(),
+      [&messages](const std_msgs::msg::Int32::SharedPtr message)
+      { messages.push_back(message->data); }));
+    return std::make_unique<Int32Publisher>(
+      node_->create_publisher<std_msgs::msg::Int32>(topic_name, rclcpp::SystemDefaultsQoS()),
+      pool, publish_unique_ptr, queue_depth);
+  }
+
+  /// Publish \p data once the previous message was published, and receive it
+  void publish(Int32Publisher & publisher, int32_t data)
+  {
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(node_);
+    const auto end = std::chrono::steady_clock::now() + 1s;
+    while (!publisher.trylock() && std::chrono::steady_clock::now() < end)
+    {
+      executor.spin_some(1ms);
+    }
+    publisher.msg_.data = data;
+    publisher.unlockAndPublish();
+    // the next message can be locked once this one was published
+    while (!publisher.trylock() && std::chrono::steady_clock::now() < end)
+    {
+      executor.spin_some(1ms);
+    }
+    publisher.unlock();
+    const auto receive_end = std::chrono::steady_clock::now() + 50ms;
+    while (std::chrono::steady_clock::now() < receive_end)
+    {
+      executor.spin_some(1ms);
+    }
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  std::vector<rclcpp::Subscription<std_msgs::msg::Int32>::SharedPtr> subscriptions_;
+};
+
+TEST_F(TestPublisherPool, pools_are_shared_by_their_options)
+{
+  PublisherPoolOptions options;
+  options.threads = 2;
+  auto pool = PublisherPool::get_shared(options);
+  EXPECT_EQ(pool, PublisherPool::get_shared(options));
+  EXPECT_EQ(pool->get_options().threads, 2u);
+
+  PublisherPoolOptions other_options;
+  EXPECT_NE(pool, PublisherPool::get_shared(other_options));
+
+  // the pool is destroyed once nobody holds it
+  std::weak_ptr<PublisherPool> weak_pool = pool;
+  pool.reset();
+  EXPECT_TRUE(weak_pool.expired());
+}
+
+TEST_F(TestPublisherPool, invalid_options_are_rejected)
+{
+  PublisherPoolOptions options;
+  options.threads = 0;
+  EXPECT_THROW(PublisherPool::get_shared(options), std::invalid_argument);
+
+  options.threads = 1;
+  options.cpu_affinity = {-1};
+  EXPECT_THROW(PublisherPool::get_shared(options), std::invalid_argument);
+}
+
+TEST_F(TestPublisherPool, publishers_are_distributed_over_the_threads)
+{
+  PublisherPoolOptions options;
+  options.threads = 2;
+  auto pool = std::make_shared<PublisherPool>(options);
+
+  std::vector<int32_t> messages;
+  auto first = make_publisher("first", pool, messages);
+  auto second = make_publisher("second", pool, messages);
+  auto third = make_publisher("third", pool, messages);
+  EXPECT_EQ(pool->get_publisher_count(0), 2u);
+  EXPECT_EQ(pool->get_publisher_count(1), 1u);
+
+  second.reset();
+  third.reset();
+  EXPECT_EQ(pool->get_publisher_count(0), 1u);
+  EXPECT_EQ(pool->get_publisher_count(1), 0u);
+}
+
+TEST_F(TestPublisherPool, pooled_publishers_publish_every_handed_over_message)
+{
+  auto pool = std::make_shared<PublisherPool>(PublisherPoolOptions());
+  std::vector<int32_t> first_messages;
+  std::vector<int32_t> second_messages;
+  auto first = make_publisher("first", pool, first_messages);
+  auto second = make_publisher("second", pool, second_messages);
+  EXPECT_TRUE(first->is_pooled());
+
+  publish(*first, 1);
+  publish(*second, 2);
+  publish(*first, 3);
+  EXPECT_THAT(first_messages, ::testing::ElementsAre(1, 3));
+  EXPECT_THAT(second_messages, ::testing::ElementsAre(2));
+
+  // unlocking without publishing hands over nothing
+  ASSERT_TRUE(first->trylock());
+  first->unlock();
+  publish(*second, 4);
+  EXPECT_THAT(first_messages, ::testing::ElementsAre(1, 3));
+}
+
+TEST_F(TestPublisherPool, pooled_publishers_publish_unique_ptr)
+{
+  // subscribers in the same process take over the published messages
+  node_ = std::make_shared<rclcpp::Node>(
+    "test_publisher_pool_intra_process", rclcpp::NodeOptions().use_intra_process_comms(true));
+  auto pool = std::make_shared<PublisherPool>(PublisherPoolOptions());
+  std::vector<int32_t> messages;
+  auto publisher = make_publisher("unique_ptr", pool, messages, true);
+
+  publish(*publisher, 1);
+  publish(*publisher, 2);
+  EXPECT_THAT(messages, ::testing::ElementsAre(1, 2));
+  // the handed over message stays filled for the next update
+  ASSERT_TRUE(publisher->trylock());
+  EXPECT_EQ(publisher->msg_.data, 2);
+  publisher->unlock();
+}
+
+TEST_F(TestPublisherPool, publishers_without_pool_have_their_own_thread)
+{
+  std::vector<int32_t> messages;
+  auto publisher = make_publisher("dedicated", nullptr, messages);
+  EXPECT_FALSE(publisher->is_pooled());
+
+  publish(*publisher, 1);
+  publish(*publisher, 2);
+  EXPECT_THAT(messages, ::testing::ElementsAre(1, 2));
+}
+
+TEST_F(TestPublisherPool, loaned_publishers_publish_with_and_without_loans)
+{
+  std::vector<int32_t> messages;
+  auto subscription = node_->create_subscription<std_msgs::msg::Int32>(
+    "loaned", rclcpp::SystemDefaultsQoS(),
+    [&messages](const std_msgs::msg::Int32::SharedPtr message)
+    { messages.push_back(message->data); });
+  auto pool = std::make_shared<PublisherPool>(PublisherPoolOptions());
+  // the message is loaned if the middleware of the test supports it, and copied otherwise
+  publisher_pool::LoanedPublisher<std_msgs::msg::Int32> publisher(
+    node_->create_publisher<std_msgs::msg::Int32>("loaned", rclcpp::SystemDefaultsQoS()), pool);
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node_);
+  const auto end = std::chrono::steady_clock::now() + 1s;
+  while (messages.empty() && std::chrono::steady_clock::now() < end)
+  {
+    EXPECT_TRUE(publisher.publish([](std_msgs::msg::Int32 & msg) { msg.data = 1; }));
+    executor.spin_some(1ms);
+  }
+  ASSERT_FALSE(messages.empty()) << (publisher.is_loaning() ? "loaned" : "copied");
+  EXPECT_EQ(messages.front(), 1);
+}
+
+TEST_F(TestPublisherPool, queued_publishers_publish_bursts_of_messages)
+{
+  for (const bool pooled : {false, true})
+  {
+    auto pool = pooled ? std::make_shared<PublisherPool>(PublisherPoolOptions()) : nullptr;
+    std::vector<int32_t> messages;
+    auto publisher =
+      make_publisher(pooled ? "queued_pooled" : "queued", pool, messages, false, 8);
+    EXPECT_EQ(publisher->get_queue_depth(), 8u);
+
+    // a burst within a poll period fits into the queue
+    for (int32_t data = 1; data <= 8; ++data)
+    {
+      ASSERT_TRUE(publisher->trylock());
+      publisher->msg_.data = data;
+      publisher->unlockAndPublish();
+    }
+    publish(*publisher, 9);
+    EXPECT_THAT(messages, ::testing::ElementsAre(1, 2, 3, 4, 5, 6, 7, 8, 9));
+    EXPECT_EQ(publisher->get_dropped_count(), 0u);
+  }
+}
+
+TEST_F(TestPublisherPool, queued_publishers_count_the_dropped_messages)
+{
+  std::vector<int32_t> messages;
+  auto publisher = make_publisher("queued_drops", nullptr, messages, false, 2);
+
+  // faster than the queue is emptied
+  constexpr size_t NUM_ATTEMPTS = 1000;
+  size_t num_queued = 0;
+  for (size_t i = 0; i < NUM_ATTEMPTS; ++i)
+  {
+    if (publisher->trylock())
+    {
+      publisher->msg_.data = static_cast<int32_t>(i);
+      publisher->unlockAndPublish();
+      ++num_queued;
+    }
+  }
+  EXPECT_GT(publisher->get_dropped_count(), 0u);
+  EXPECT_EQ(num_queued + publisher->get_dropped_count(), NUM_ATTEMPTS);
+
+  // the queue is emptied and publishes the next messages again
+  publish(*publisher, -1);
+  ASSERT_FALSE(messages.empty());
+  EXPECT_EQ(messages.back(), -1);
+}
+
+struct QosParams
+{
+  std::string reliability = "system_default";
+  int64_t depth = 0;
+  std::string durability = "system_default";
+};
+
+TEST_F(TestPublisherPool, qos_is_set_from_the_parameters)
+{
+  QosParams params;
+  EXPECT_EQ(publisher_pool::make_qos(params), rclcpp::SystemDefaultsQoS());
+
+  params.reliability = "best_effort";
+  params.depth = 1;
+  params.durability = "transient_local";
+  const auto qos = publisher_pool::make_qos(params);
+  EXPECT_EQ(qos.reliability(), rclcpp::ReliabilityPolicy::BestEffort);
+  EXPECT_EQ(qos.history(), rclcpp::HistoryPolicy::KeepLast);
+  EXPECT_EQ(qos.depth(), 1u);
+  EXPECT_EQ(qos.durability(), rclcpp::DurabilityPolicy::TransientLocal);
+
+  params.reliability = "unreliable";
+  EXPECT_THROW(publisher_pool::make_qos(params), std::invalid_argument);
+}
+
+#ifdef __linux__
+TEST_F(TestPublisherPool, cpu_affinity_is_applied_to_the_threads)
+{
+  // any CPU this process may run on
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(cpu_set), &cpu_set), 0);
+  int cpu = 0;
+  while (!CPU_ISSET(static_cast<size_t>(cpu), &cpu_set))
+  {
+    ++cpu;
+  }
+
+  PublisherPoolOptions options;
+  options.threads = 2;
+  options.cpu_affinity = {cpu};
+  PublisherPool pool(options);
+  EXPECT_TRUE(pool.is_cpu_affinity_applied());
+}
+#endif
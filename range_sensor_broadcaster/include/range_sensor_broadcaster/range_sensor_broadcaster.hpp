@@ -29,47 +29,54 @@
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 #include "realtime_tools/realtime_publisher.h"
+#include "semantic_component_broadcaster/semantic_component_broadcaster.hpp"
 #include "semantic_components/range_sensor.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
 #include "sensor_msgs/msg/range.hpp"
 
 namespace range_sensor_broadcaster
 {
-class RangeSensorBroadcaster : public controller_interface::ControllerInterface
+class RangeSensorBroadcaster
+: public semantic_component_broadcaster::SemanticComponentBroadcaster<
+    semantic_components::RangeSensor, sensor_msgs::msg::Range>
 {
 public:
-  RANGE_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
-
-  RANGE_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
-
   RANGE_SENSOR_BROADCASTER_PUBLIC controller_interface::CallbackReturn on_init() override;
 
   RANGE_SENSOR_BROADCASTER_PUBLIC
   controller_interface::CallbackReturn on_configure(
     const rclcpp_lifecycle::State & previous_state) override;
 
-  RANGE_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::CallbackReturn on_activate(
-    const rclcpp_lifecycle::State & previous_state) override;
-
-  RANGE_SENSOR_BROADCASTER_PUBLIC
-  controller_interface::CallbackReturn on_deactivate(
-    const rclcpp_lifecycle::State & previous_state) override;
-
   RANGE_SENSOR_BROADCASTER_PUBLIC
   controller_interface::return_type update(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
 protected:
+  using Base = semantic_component_broadcaster::SemanticComponentBroadcaster<
+    semantic_components::RangeSensor, sensor_msgs::msg::Range>;
+
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
 
-  std::unique_ptr<semantic_components::RangeSensor> range_sensor_;
+  /// The range interfaces of all sensors in the multi-sensor mode
+  std::vector<std::string> get_sensor_state_interface_names() const override;
+
+  /// \return the publishing options from the parameters
+  semantic_component_broadcaster::BroadcasterOptions get_broadcaster_options() const;
+
+  /// Configure the multi-sensor mode, used if 'sensor_names' is set
+  controller_interface::CallbackReturn configure_multi_sensor();
+
+  /// Fill the ranges point cloud from the range interfaces of all sensors, realtime-safe
+  void fill_ranges_message(sensor_msgs::msg::PointCloud2 & ranges_msg) const;
 
-  using StatePublisher = realtime_tools::RealtimePublisher<sensor_msgs::msg::Range>;
-  rclcpp::Publisher<sensor_msgs::msg::Range>::SharedPtr sensor_state_publisher_;
-  std::unique_ptr<StatePublisher> realtime_publisher_;
+  /// Multi-sensor mode, one point of the ranges point cloud per sensor
+  using RangesPublisher = realtime_tools::RealtimePublisher<sensor_msgs::msg::PointCloud2>;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr ranges_publisher_;
+  std::unique_ptr<RangesPublisher> realtime_ranges_publisher_;
+  /// Position and normalized beam direction of every sensor, [x, y, z] each
+  std::vector<double> sensor_positions_;
+  std::vector<double> sensor_directions_;
 };
 
 }  // namespace range_sensor_broadcaster
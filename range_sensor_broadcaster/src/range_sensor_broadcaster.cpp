@@ -18,9 +18,14 @@
 
 #include "range_sensor_broadcaster/range_sensor_broadcaster.hpp"
 
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
 
+#include "sensor_msgs/point_cloud2_iterator.hpp"
+
 namespace range_sensor_broadcaster
 {
 controller_interface::CallbackReturn RangeSensorBroadcaster::on_init()
@@ -44,6 +49,13 @@ controller_interface::CallbackReturn RangeSensorBroadcaster::on_configure(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   params_ = param_listener_->get_params();
+  if (!params_.sensor_names.empty())
+  {
+    return configure_multi_sensor();
+  }
+  semantic_component_.reset();
+  realtime_ranges_publisher_.reset();
+
   if (params_.sensor_name.empty())
   {
     RCLCPP_ERROR(get_node()->get_logger(), "'sensor_name' parameter has to be specified.");
@@ -56,20 +68,10 @@ controller_interface::CallbackReturn RangeSensorBroadcaster::on_configure(
     return CallbackReturn::ERROR;
   }
 
-  range_sensor_ = std::make_unique<semantic_components::RangeSensor>(
+  semantic_component_ = std::make_unique<semantic_components::RangeSensor>(
     semantic_components::RangeSensor(params_.sensor_name));
-  try
-  {
-    // register ft sensor data publisher
-    sensor_state_publisher_ =
-      get_node()->create_publisher<sensor_msgs::msg::Range>("~/range", rclcpp::SystemDefaultsQoS());
-    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_);
-  }
-  catch (const std::exception & e)
+  if (!configure_broadcaster("~/range", get_broadcaster_options()))
   {
-    fprintf(
-      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
-      e.what());
     return CallbackReturn::ERROR;
   }
 
@@ -86,50 +88,152 @@ controller_interface::CallbackReturn RangeSensorBroadcaster::on_configure(
   return CallbackReturn::SUCCESS;
 }
 
-controller_interface::InterfaceConfiguration
-RangeSensorBroadcaster::command_interface_configuration() const
+controller_interface::CallbackReturn RangeSensorBroadcaster::configure_multi_sensor()
 {
-  controller_interface::InterfaceConfiguration command_interfaces_config;
-  command_interfaces_config.type = controller_interface::interface_configuration_type::NONE;
-  return command_interfaces_config;
-}
+  if (params_.frame_id.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'frame_id' parameter has to be provided.");
+    return CallbackReturn::ERROR;
+  }
 
-controller_interface::InterfaceConfiguration RangeSensorBroadcaster::state_interface_configuration()
-  const
-{
-  controller_interface::InterfaceConfiguration state_interfaces_config;
-  state_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-  state_interfaces_config.names = range_sensor_->get_state_interface_names();
-  return state_interfaces_config;
+  const size_t num_sensors = params_.sensor_names.size();
+  sensor_positions_.resize(3 * num_sensors);
+  sensor_directions_.resize(3 * num_sensors);
+  for (size_t i = 0; i < num_sensors; ++i)
+  {
+    const auto & sensor = params_.sensors.sensor_names_map.at(params_.sensor_names[i]);
+    const auto & direction = sensor.direction;
+    const double norm = std::sqrt(
+      direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    if (!(norm > 0.0))
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "The direction of sensor '%s' must not be zero.",
+        params_.sensor_names[i].c_str());
+      return CallbackReturn::ERROR;
+    }
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+      sensor_positions_[3 * i + axis] = sensor.position[axis];
+      sensor_directions_[3 * i + axis] = direction[axis] / norm;
+    }
+  }
+
+  // the ranges are published here, the base only applies the publishing options
+  semantic_component_.reset();
+  if (!configure_broadcaster("", get_broadcaster_options(), "~/ranges"))
+  {
+    return CallbackReturn::ERROR;
+  }
+  try
+  {
+    ranges_publisher_ = get_node()->create_publisher<sensor_msgs::msg::PointCloud2>(
+      "~/ranges", rclcpp::SystemDefaultsQoS());
+    realtime_ranges_publisher_ = std::make_unique<RangesPublisher>(ranges_publisher_);
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(
+      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
+      e.what());
+    return CallbackReturn::ERROR;
+  }
+
+  // one point per sensor, the data is allocated once here
+  realtime_ranges_publisher_->lock();
+  auto & ranges_msg = realtime_ranges_publisher_->msg_;
+  ranges_msg.header.frame_id = params_.frame_id;
+  ranges_msg.height = 1;
+  ranges_msg.is_dense = false;
+  sensor_msgs::PointCloud2Modifier modifier(ranges_msg);
+  modifier.setPointCloud2Fields(
+    4, "x", 1, sensor_msgs::msg::PointField::FLOAT32, "y", 1,
+    sensor_msgs::msg::PointField::FLOAT32, "z", 1, sensor_msgs::msg::PointField::FLOAT32,
+    "range", 1, sensor_msgs::msg::PointField::FLOAT32);
+  modifier.resize(num_sensors);
+  realtime_ranges_publisher_->unlock();
+
+  RCLCPP_DEBUG(get_node()->get_logger(), "configure successful");
+  return CallbackReturn::SUCCESS;
 }
 
-controller_interface::CallbackReturn RangeSensorBroadcaster::on_activate(
-  const rclcpp_lifecycle::State & /*previous_state*/)
+semantic_component_broadcaster::BroadcasterOptions
+RangeSensorBroadcaster::get_broadcaster_options() const
 {
-  range_sensor_->assign_loaned_state_interfaces(state_interfaces_);
-  return CallbackReturn::SUCCESS;
+  semantic_component_broadcaster::BroadcasterOptions options;
+  options.publish_rate = params_.publish_rate;
+  options.publish_on_change = params_.publish_on_change;
+  options.sequence_interface_name = params_.sequence_interface_name;
+  options.publisher_thread = params_.publisher_thread.enable;
+  options.queue_size = static_cast<size_t>(params_.publisher_thread.queue_size);
+  options.batch_size = static_cast<size_t>(params_.publisher_thread.batch_size);
+  return options;
 }
 
-controller_interface::CallbackReturn RangeSensorBroadcaster::on_deactivate(
-  const rclcpp_lifecycle::State & /*previous_state*/)
+std::vector<std::string> RangeSensorBroadcaster::get_sensor_state_interface_names() const
 {
-  range_sensor_->release_interfaces();
-  return CallbackReturn::SUCCESS;
+  if (semantic_component_)
+  {
+    return semantic_component_->get_state_interface_names();
+  }
+  // contiguous range interfaces of all sensors
+  std::vector<std::string> names;
+  for (const auto & sensor_name : params_.sensor_names)
+  {
+    names.push_back(sensor_name + "/range");
+  }
+  return names;
 }
 
 controller_interface::return_type RangeSensorBroadcaster::update(
-  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  if (realtime_publisher_ && realtime_publisher_->trylock())
+  if (!realtime_ranges_publisher_)
   {
-    realtime_publisher_->msg_.header.stamp = time;
-    range_sensor_->get_values_as_message(realtime_publisher_->msg_);
-    realtime_publisher_->unlockAndPublish();
+    return Base::update(time, period);
   }
 
+  if (!is_sample_due(time))
+  {
+    return controller_interface::return_type::OK;
+  }
+  if (realtime_ranges_publisher_->trylock())
+  {
+    realtime_ranges_publisher_->msg_.header.stamp = time;
+    fill_ranges_message(realtime_ranges_publisher_->msg_);
+    realtime_ranges_publisher_->unlockAndPublish();
+    ++published_;
+    on_sample_published();
+  }
+  else
+  {
+    ++dropped_;
+  }
   return controller_interface::return_type::OK;
 }
 
+void RangeSensorBroadcaster::fill_ranges_message(sensor_msgs::msg::PointCloud2 & ranges_msg) const
+{
+  sensor_msgs::PointCloud2Iterator<float> x(ranges_msg, "x");
+  sensor_msgs::PointCloud2Iterator<float> range(ranges_msg, "range");
+  const double min_range = params_.min_range;
+  const double max_range = params_.max_range;
+  for (size_t i = 0; i < params_.sensor_names.size(); ++i, ++x, ++range)
+  {
+    const double value = state_interfaces_[i].get_value();
+    *range = static_cast<float>(value);
+    // like sensor_msgs/Range, readings outside of the limits are no detections
+    const bool detection = value >= min_range && value <= max_range;
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+      x[axis] =
+        detection ? static_cast<float>(
+                      sensor_positions_[3 * i + axis] + value * sensor_directions_[3 * i + axis])
+                  : std::numeric_limits<float>::quiet_NaN();
+    }
+  }
+}
+
 }  // namespace range_sensor_broadcaster
 
 #include "pluginlib/class_list_macros.hpp"
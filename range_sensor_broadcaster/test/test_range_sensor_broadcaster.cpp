@@ -20,7 +20,14 @@
 
 #include "test_range_sensor_broadcaster.hpp"
 
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "hardware_interface/loaned_state_interface.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include "sensor_msgs/point_cloud2_iterator.hpp"
 
 using testing::IsEmpty;
 using testing::SizeIs;
@@ -267,6 +274,114 @@ TEST_F(RangeSensorBroadcasterTest, Publish_OutOfBandaries_RangeBroadcaster_Succe
   EXPECT_THAT(range_msg.variance, ::testing::FloatEq(variance_));
 }
 
+TEST_F(RangeSensorBroadcasterTest, Publish_OnChange_RangeBroadcaster_Success)
+{
+  init_broadcaster("test_range_sensor_broadcaster");
+  std::vector<rclcpp::Parameter> parameters = {
+    rclcpp::Parameter("publish_rate", 10.0), rclcpp::Parameter("publish_on_change", true)};
+  ASSERT_EQ(configure_broadcaster(parameters), controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    range_broadcaster_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription = test_subscription_node.create_subscription<sensor_msgs::msg::Range>(
+    "/test_range_sensor_broadcaster/range", 10, [](const sensor_msgs::msg::Range::SharedPtr) {});
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  auto update = [this](const double seconds)
+  {
+    ASSERT_EQ(
+      range_broadcaster_->update(
+        rclcpp::Time(static_cast<int64_t>(seconds * 1e9)), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+  sensor_msgs::msg::Range range_msg;
+  rclcpp::MessageInfo msg_info;
+
+  // the first sample is published
+  update(0.0);
+  ASSERT_EQ(wait_set.wait(std::chrono::milliseconds(100)).kind(), rclcpp::WaitResultKind::Ready);
+  ASSERT_TRUE(subscription->take(range_msg, msg_info));
+  EXPECT_THAT(range_msg.range, ::testing::FloatEq(sensor_range_));
+
+  // no duplicates, and a new sample waits for the publish period
+  update(0.05);
+  sensor_range_ = 3.5;
+  update(0.06);
+  EXPECT_EQ(wait_set.wait(std::chrono::milliseconds(20)).kind(), rclcpp::WaitResultKind::Timeout);
+  update(0.11);
+  ASSERT_EQ(wait_set.wait(std::chrono::milliseconds(100)).kind(), rclcpp::WaitResultKind::Ready);
+  ASSERT_TRUE(subscription->take(range_msg, msg_info));
+  EXPECT_THAT(range_msg.range, ::testing::FloatEq(3.5));
+
+  update(0.5);
+  EXPECT_EQ(wait_set.wait(std::chrono::milliseconds(20)).kind(), rclcpp::WaitResultKind::Timeout);
+}
+
+TEST_F(RangeSensorBroadcasterTest, Publish_MultiSensor_RangeBroadcaster_Success)
+{
+  // the overrides take precedence over the parameters file, also for read-only parameters
+  const auto options =
+    rclcpp::NodeOptions()
+      .parameter_overrides(
+        {rclcpp::Parameter("sensor_names", std::vector<std::string>{"front", "left"}),
+         rclcpp::Parameter("sensors.front.position", std::vector<double>{0.5, 0.0, 0.2}),
+         rclcpp::Parameter("sensors.left.position", std::vector<double>{0.0, 0.3, 0.2}),
+         rclcpp::Parameter("sensors.left.direction", std::vector<double>{0.0, 2.0, 0.0})})
+      .automatically_declare_parameters_from_overrides(false);
+  ASSERT_EQ(
+    range_broadcaster_->init("test_range_sensor_broadcaster", "", 0, "", options),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(
+    range_broadcaster_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  EXPECT_THAT(
+    range_broadcaster_->state_interface_configuration().names,
+    testing::ElementsAre("front/range", "left/range"));
+
+  double front_range = 2.0;
+  double left_range = 10.0;
+  hardware_interface::StateInterface front{"front", "range", &front_range};
+  hardware_interface::StateInterface left{"left", "range", &left_range};
+  std::vector<hardware_interface::LoanedStateInterface> state_interfaces;
+  state_interfaces.emplace_back(front);
+  state_interfaces.emplace_back(left);
+  range_broadcaster_->assign_interfaces({}, std::move(state_interfaces));
+  ASSERT_EQ(
+    range_broadcaster_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription = test_subscription_node.create_subscription<sensor_msgs::msg::PointCloud2>(
+    "/test_range_sensor_broadcaster/ranges", 10,
+    [](const sensor_msgs::msg::PointCloud2::SharedPtr) {});
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  ASSERT_EQ(
+    range_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(wait_set.wait(std::chrono::milliseconds(100)).kind(), rclcpp::WaitResultKind::Ready);
+  sensor_msgs::msg::PointCloud2 ranges_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(ranges_msg, msg_info));
+
+  EXPECT_EQ(ranges_msg.header.frame_id, frame_id_);
+  ASSERT_EQ(ranges_msg.width, 2u);
+  sensor_msgs::PointCloud2ConstIterator<float> point(ranges_msg, "x");
+  sensor_msgs::PointCloud2ConstIterator<float> range(ranges_msg, "range");
+  // the front sensor detects an obstacle along x
+  EXPECT_FLOAT_EQ(point[0], 2.5);
+  EXPECT_FLOAT_EQ(point[1], 0.0);
+  EXPECT_FLOAT_EQ(point[2], 0.2);
+  EXPECT_FLOAT_EQ(*range, 2.0);
+  // the left sensor is beyond max_range, so it has a range but no point
+  ++point;
+  ++range;
+  EXPECT_TRUE(std::isnan(point[0]));
+  EXPECT_FLOAT_EQ(*range, 10.0);
+}
+
 int main(int argc, char ** argv)
 {
   testing::InitGoogleMock(&argc, argv);
@@ -0,0 +1,198 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REALTIME_LOGGING__REALTIME_LOGGER_HPP_
+#define REALTIME_LOGGING__REALTIME_LOGGER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rclcpp/logger.hpp"
+#include "rcutils/logging.h"
+#include "realtime_logging/visibility_control.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define REALTIME_LOGGING_PRINTF_FORMAT(format_index, first_argument) \
+  __attribute__((format(printf, format_index, first_argument)))
+#else
+#define REALTIME_LOGGING_PRINTF_FORMAT(format_index, first_argument)
+#endif
+
+namespace realtime_logging
+{
+/// Severity of a message, the values of the rcutils severities
+enum class Severity : int
+{
+  DEBUG = RCUTILS_LOG_SEVERITY_DEBUG,
+  INFO = RCUTILS_LOG_SEVERITY_INFO,
+  WARN = RCUTILS_LOG_SEVERITY_WARN,
+  ERROR = RCUTILS_LOG_SEVERITY_ERROR,
+  FATAL = RCUTILS_LOG_SEVERITY_FATAL,
+};
+
+class RealtimeLogFlusher;
+
+/**
+ * \brief Logger of the realtime loop of a controller, whose messages are output by another thread.
+ *
+ * RCLCPP_INFO and friends take the mutex of rcutils logging and write to the console and to
+ * /rosout from the calling thread. The messages of a RealtimeLogger are instead formatted into
+ * one of a fixed number of preallocated entries of a single-producer single-consumer queue,
+ * without locks or memory allocation, and the thread of the RealtimeLogFlusher of the process
+ * outputs them with the rclcpp logger within FLUSH_PERIOD.
+ *
+ * The messages are filtered by the level of the rclcpp logger, e.g., set with the set_logger_level
+ * service of the controller manager, which is read again on every flush. If the queue is full,
+ * a message is dropped, and the number of dropped messages is logged with the next flush.
+ *
+ * Only one thread at a time may log, usually the realtime thread calling update().
+ */
+class RealtimeLogger
+{
+public:
+  /// Longest message including the terminating null character, longer messages are truncated
+  static constexpr size_t MAX_MESSAGE_LENGTH = 256;
+  /// Number of messages which can wait in the queue for the next flush by default
+  static constexpr size_t DEFAULT_CAPACITY = 32;
+
+  /// Preallocate the queue and register with the flusher of the process, not realtime-safe
+  REALTIME_LOGGING_PUBLIC
+  explicit RealtimeLogger(const rclcpp::Logger & logger, size_t capacity = DEFAULT_CAPACITY);
+
+  /// Unregister from the flusher and output the messages still in the queue
+  REALTIME_LOGGING_PUBLIC
+  ~RealtimeLogger();
+
+  RealtimeLogger(const RealtimeLogger &) = delete;
+  RealtimeLogger & operator=(const RealtimeLogger &) = delete;
+
+  /// True if messages of \p severity are output, e.g., to skip computing their arguments
+  bool is_enabled_for(Severity severity) const
+  {
+    return static_cast<int>(severity) >= level_.load(std::memory_order_relaxed);
+  }
+
+  /// Queue a message formatted like printf, realtime-safe
+  REALTIME_LOGGING_PUBLIC
+  void log(Severity severity, const char * format, ...) REALTIME_LOGGING_PRINTF_FORMAT(3, 4);
+
+  REALTIME_LOGGING_PUBLIC
+  void vlog(Severity severity, const char * format, va_list arguments);
+
+  REALTIME_LOGGING_PUBLIC
+  void debug(const char * format, ...) REALTIME_LOGGING_PRINTF_FORMAT(2, 3);
+
+  REALTIME_LOGGING_PUBLIC
+  void info(const char * format, ...) REALTIME_LOGGING_PRINTF_FORMAT(2, 3);
+
+  REALTIME_LOGGING_PUBLIC
+  void warn(const char * format, ...) REALTIME_LOGGING_PRINTF_FORMAT(2, 3);
+
+  REALTIME_LOGGING_PUBLIC
+  void error(const char * format, ...) REALTIME_LOGGING_PRINTF_FORMAT(2, 3);
+
+  /// Output the queued messages and update the level, not realtime-safe
+  /**
+   * Called by the thread of the flusher, and may be called by any other non-realtime thread.
+   */
+  REALTIME_LOGGING_PUBLIC
+  void flush();
+
+  /// Number of messages dropped because the queue was full
+  uint64_t get_dropped_count() const { return dropped_count_.load(std::memory_order_relaxed); }
+
+  const rclcpp::Logger & get_logger() const { return logger_; }
+
+private:
+  struct Entry
+  {
+    Severity severity = Severity::INFO;
+    char text[MAX_MESSAGE_LENGTH] = {};
+  };
+
+  void update_level();
+
+  rclcpp::Logger logger_;
+  // one entry more than the capacity, to tell a full queue from an empty one
+  std::vector<Entry> entries_;
+  // next entry written by the realtime thread
+  std::atomic<size_t> head_{0};
+  // next entry output by flush()
+  std::atomic<size_t> tail_{0};
+  std::atomic<int> level_{RCUTILS_LOG_SEVERITY_DEBUG};
+  std::atomic<uint64_t> dropped_count_{0};
+  // serializes the consumers
+  std::mutex flush_mutex_;
+  uint64_t reported_dropped_count_ = 0;
+  std::shared_ptr<RealtimeLogFlusher> flusher_;
+};
+
+/**
+ * \brief Thread of a process outputting the messages of all its RealtimeLoggers.
+ *
+ * Like the threads of a publisher_pool::PublisherPool, the thread checks the queues every
+ * FLUSH_PERIOD and is never woken by the realtime thread.
+ */
+class RealtimeLogFlusher
+{
+public:
+  /// Period between two flushes of the loggers
+  static constexpr std::chrono::milliseconds FLUSH_PERIOD{10};
+
+  /// Start the thread, not realtime-safe
+  REALTIME_LOGGING_PUBLIC
+  RealtimeLogFlusher();
+
+  /// The flusher of this process, created if there is none
+  /**
+   * It exists as long as any logger holds it.
+   */
+  REALTIME_LOGGING_PUBLIC
+  static std::shared_ptr<RealtimeLogFlusher> get_shared();
+
+  /// Stop the thread, the loggers have to be removed before
+  REALTIME_LOGGING_PUBLIC
+  ~RealtimeLogFlusher();
+
+  RealtimeLogFlusher(const RealtimeLogFlusher &) = delete;
+  RealtimeLogFlusher & operator=(const RealtimeLogFlusher &) = delete;
+
+  REALTIME_LOGGING_PUBLIC
+  void add(RealtimeLogger * logger);
+
+  /// Stop flushing \p logger, which isn't used by the flusher on return
+  REALTIME_LOGGING_PUBLIC
+  void remove(RealtimeLogger * logger);
+
+private:
+  void run();
+
+  std::mutex mutex_;
+  std::condition_variable stop_condition_;
+  bool stop_ = false;
+  std::vector<RealtimeLogger *> loggers_;
+  std::thread thread_;
+};
+
+}  // namespace realtime_logging
+
+#endif  // REALTIME_LOGGING__REALTIME_LOGGER_HPP_
@@ -0,0 +1,181 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "realtime_logging/realtime_logger.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace realtime_logging
+{
+namespace
+{
+// the messages are output by the flusher, the realtime call site isn't known anymore
+const rcutils_log_location_t FLUSH_LOCATION = {"", "", 0};
+}  // namespace
+
+RealtimeLogger::RealtimeLogger(const rclcpp::Logger & logger, size_t capacity)
+: logger_(logger), entries_(std::max<size_t>(capacity, 1) + 1)
+{
+  update_level();
+  flusher_ = RealtimeLogFlusher::get_shared();
+  flusher_->add(this);
+}
+
+RealtimeLogger::~RealtimeLogger()
+{
+  flusher_->remove(this);
+  flush();
+}
+
+void RealtimeLogger::log(Severity severity, const char * format, ...)
+{
+  va_list arguments;
+  va_start(arguments, format);
+  vlog(severity, format, arguments);
+  va_end(arguments);
+}
+
+void RealtimeLogger::vlog(Severity severity, const char * format, va_list arguments)
+{
+  if (!is_enabled_for(severity))
+  {
+    return;
+  }
+  const size_t head = head_.load(std::memory_order_relaxed);
+  const size_t next = (head + 1) % entries_.size();
+  if (next == tail_.load(std::memory_order_acquire))
+  {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto & entry = entries_[head];
+  entry.severity = severity;
+  // formats into the preallocated entry, truncated to MAX_MESSAGE_LENGTH
+  vsnprintf(entry.text, MAX_MESSAGE_LENGTH, format, arguments);
+  head_.store(next, std::memory_order_release);
+}
+
+#define REALTIME_LOGGING_DEFINE_SEVERITY_METHOD(name, severity) \
+  void RealtimeLogger::name(const char * format, ...)             \
+  {                                                               \
+    va_list arguments;                                            \
+    va_start(arguments, format);                                  \
+    vlog(severity, format, arguments);                            \
+    va_end(arguments);                                            \
+  }
+
+REALTIME_LOGGING_DEFINE_SEVERITY_METHOD(debug, Severity::DEBUG)
+REALTIME_LOGGING_DEFINE_SEVERITY_METHOD(info, Severity::INFO)
+REALTIME_LOGGING_DEFINE_SEVERITY_METHOD(warn, Severity::WARN)
+REALTIME_LOGGING_DEFINE_SEVERITY_METHOD(error, Severity::ERROR)
+
+#undef REALTIME_LOGGING_DEFINE_SEVERITY_METHOD
+
+void RealtimeLogger::flush()
+{
+  std::lock_guard<std::mutex> guard(flush_mutex_);
+  const size_t head = head_.load(std::memory_order_acquire);
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  while (tail != head)
+  {
+    const auto & entry = entries_[tail];
+    rcutils_log(
+      &FLUSH_LOCATION, static_cast<int>(entry.severity), logger_.get_name(), "%s", entry.text);
+    tail = (tail + 1) % entries_.size();
+    // hands the entry back to the realtime thread
+    tail_.store(tail, std::memory_order_release);
+  }
+
+  const uint64_t dropped_count = dropped_count_.load(std::memory_order_relaxed);
+  if (dropped_count != reported_dropped_count_)
+  {
+    rcutils_log(
+      &FLUSH_LOCATION, RCUTILS_LOG_SEVERITY_WARN, logger_.get_name(),
+      "Dropped %" PRIu64 " realtime log messages, the queue of %zu messages was full.",
+      dropped_count - reported_dropped_count_, entries_.size() - 1);
+    reported_dropped_count_ = dropped_count;
+  }
+  update_level();
+}
+
+void RealtimeLogger::update_level()
+{
+  const int level = rcutils_logging_get_logger_effective_level(logger_.get_name());
+  if (level >= 0)
+  {
+    level_.store(level, std::memory_order_relaxed);
+  }
+}
+
+RealtimeLogFlusher::RealtimeLogFlusher() { thread_ = std::thread(&RealtimeLogFlusher::run, this); }
+
+std::shared_ptr<RealtimeLogFlusher> RealtimeLogFlusher::get_shared()
+{
+  static std::mutex flusher_mutex;
+  static std::weak_ptr<RealtimeLogFlusher> weak_flusher;
+
+  std::lock_guard<std::mutex> guard(flusher_mutex);
+  auto flusher = weak_flusher.lock();
+  if (!flusher)
+  {
+    flusher = std::make_shared<RealtimeLogFlusher>();
+    weak_flusher = flusher;
+  }
+  return flusher;
+}
+
+RealtimeLogFlusher::~RealtimeLogFlusher()
+{
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  stop_condition_.notify_all();
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+void RealtimeLogFlusher::add(RealtimeLogger * logger)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  loggers_.push_back(logger);
+}
+
+void RealtimeLogFlusher::remove(RealtimeLogger * logger)
+{
+  // the thread flushes while holding the lock, so it has finished with the logger after it
+  std::lock_guard<std::mutex> guard(mutex_);
+  loggers_.erase(std::remove(loggers_.begin(), loggers_.end(), logger), loggers_.end());
+}
+
+void RealtimeLogFlusher::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_)
+  {
+    for (auto * logger : loggers_)
+    {
+      logger->flush();
+    }
+    stop_condition_.wait_for(lock, FLUSH_PERIOD, [this]() { return stop_; });
+  }
+}
+
+}  // namespace realtime_logging
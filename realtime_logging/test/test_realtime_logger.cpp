@@ -0,0 +1,174 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rclcpp/logger.hpp"
+#include "rcutils/logging.h"
+#include "realtime_logging/realtime_logger.hpp"
+
+using realtime_logging::RealtimeLogger;
+using realtime_logging::Severity;
+
+namespace
+{
+std::mutex output_mutex;
+std::vector<std::pair<int, std::string>> output;
+
+void capture_output(
+  const rcutils_log_location_t *, int severity, const char * name, rcutils_time_point_value_t,
+  const char * format, va_list * arguments)
+{
+  if (std::string(name).rfind("test_realtime_logger", 0) != 0)
+  {
+    return;
+  }
+  char text[512];
+  vsnprintf(text, sizeof(text), format, *arguments);
+  std::lock_guard<std::mutex> guard(output_mutex);
+  output.emplace_back(severity, text);
+}
+
+std::vector<std::pair<int, std::string>> take_output()
+{
+  std::vector<std::pair<int, std::string>> taken;
+  std::lock_guard<std::mutex> guard(output_mutex);
+  taken.swap(output);
+  return taken;
+}
+}  // namespace
+
+class TestRealtimeLogger : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    ASSERT_EQ(rcutils_logging_initialize(), RCUTILS_RET_OK);
+    previous_handler_ = rcutils_logging_get_output_handler();
+    rcutils_logging_set_output_handler(capture_output);
+    take_output();
+  }
+
+  void TearDown() override { rcutils_logging_set_output_handler(previous_handler_); }
+
+  rcutils_logging_output_handler_t previous_handler_ = nullptr;
+};
+
+TEST_F(TestRealtimeLogger, outputs_the_messages_in_order_on_flush)
+{
+  RealtimeLogger logger(rclcpp::get_logger("test_realtime_logger"));
+  logger.info("Goal reached after %d points.", 3);
+  logger.warn("Joint %s is %.1f rad off.", "joint1", 0.5);
+  logger.error("Aborted.");
+  logger.flush();
+
+  const auto messages = take_output();
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_EQ(messages[0].first, RCUTILS_LOG_SEVERITY_INFO);
+  EXPECT_EQ(messages[0].second, "Goal reached after 3 points.");
+  EXPECT_EQ(messages[1].first, RCUTILS_LOG_SEVERITY_WARN);
+  EXPECT_EQ(messages[1].second, "Joint joint1 is 0.5 rad off.");
+  EXPECT_EQ(messages[2].first, RCUTILS_LOG_SEVERITY_ERROR);
+  EXPECT_EQ(messages[2].second, "Aborted.");
+  EXPECT_EQ(logger.get_dropped_count(), 0u);
+}
+
+TEST_F(TestRealtimeLogger, flusher_outputs_the_messages_without_flush)
+{
+  RealtimeLogger logger(rclcpp::get_logger("test_realtime_logger"));
+  logger.info("from the realtime thread");
+
+  std::vector<std::pair<int, std::string>> messages;
+  for (int i = 0; i < 100 && messages.empty(); ++i)
+  {
+    std::this_thread::sleep_for(realtime_logging::RealtimeLogFlusher::FLUSH_PERIOD);
+    messages = take_output();
+  }
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(messages[0].second, "from the realtime thread");
+}
+
+TEST_F(TestRealtimeLogger, drops_and_reports_messages_of_a_full_queue)
+{
+  RealtimeLogger logger(rclcpp::get_logger("test_realtime_logger"), 2);
+  for (int i = 0; i < 100; ++i)
+  {
+    logger.info("message %d", i);
+  }
+  logger.flush();
+
+  const auto messages = take_output();
+  // the flusher may have made room for a few more
+  ASSERT_GE(messages.size(), 3u);
+  EXPECT_EQ(messages[0].second, "message 0");
+  EXPECT_GT(logger.get_dropped_count(), 0u);
+  EXPECT_THAT(
+    messages, ::testing::Contains(::testing::Pair(
+                RCUTILS_LOG_SEVERITY_WARN, ::testing::HasSubstr("Dropped"))));
+
+  // reported only once
+  logger.flush();
+  EXPECT_TRUE(take_output().empty());
+}
+
+TEST_F(TestRealtimeLogger, skips_messages_below_the_logger_level)
+{
+  ASSERT_EQ(
+    rcutils_logging_set_logger_level("test_realtime_logger.level", RCUTILS_LOG_SEVERITY_WARN),
+    RCUTILS_RET_OK);
+  RealtimeLogger logger(rclcpp::get_logger("test_realtime_logger.level"));
+  EXPECT_FALSE(logger.is_enabled_for(Severity::INFO));
+  EXPECT_TRUE(logger.is_enabled_for(Severity::WARN));
+  logger.debug("debug");
+  logger.info("info");
+  logger.warn("warn");
+  logger.flush();
+
+  auto messages = take_output();
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(messages[0].second, "warn");
+
+  // the level is read again on every flush
+  ASSERT_EQ(
+    rcutils_logging_set_logger_level("test_realtime_logger.level", RCUTILS_LOG_SEVERITY_DEBUG),
+    RCUTILS_RET_OK);
+  logger.flush();
+  EXPECT_TRUE(logger.is_enabled_for(Severity::DEBUG));
+  logger.debug("debug");
+  logger.flush();
+  messages = take_output();
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(messages[0].first, RCUTILS_LOG_SEVERITY_DEBUG);
+}
+
+TEST_F(TestRealtimeLogger, truncates_long_messages)
+{
+  RealtimeLogger logger(rclcpp::get_logger("test_realtime_logger"));
+  const std::string long_text(2 * RealtimeLogger::MAX_MESSAGE_LENGTH, 'x');
+  logger.info("%s", long_text.c_str());
+  logger.flush();
+
+  const auto messages = take_output();
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(messages[0].second.size(), RealtimeLogger::MAX_MESSAGE_LENGTH - 1);
+}
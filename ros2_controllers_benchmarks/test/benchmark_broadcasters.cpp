@@ -0,0 +1,89 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "controller_benchmark.hpp"
+#include "force_torque_sensor_broadcaster/force_torque_sensor_broadcaster.hpp"
+#include "imu_sensor_broadcaster/imu_sensor_broadcaster.hpp"
+#include "range_sensor_broadcaster/range_sensor_broadcaster.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+
+// the sensor broadcasters publish a message in every update by default
+
+class ImuSensorBroadcasterBenchmark
+: public ControllerBenchmark<imu_sensor_broadcaster::IMUSensorBroadcaster>
+{
+};
+
+class ForceTorqueSensorBroadcasterBenchmark
+: public ControllerBenchmark<force_torque_sensor_broadcaster::ForceTorqueSensorBroadcaster>
+{
+};
+
+/**
+ * Range sensor broadcaster, publishing one point cloud of all sensors.
+ *
+ * Argument: number of sensors
+ */
+class RangeSensorBroadcasterBenchmark
+: public ControllerBenchmark<range_sensor_broadcaster::RangeSensorBroadcaster>
+{
+};
+
+void sensor_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"sensors"})->Arg(1)->Arg(8)->Arg(32);
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(ImuSensorBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  if (activate(
+        state, {rclcpp::Parameter("sensor_name", "imu_sensor"),
+                rclcpp::Parameter("frame_id", "imu_sensor_frame")}))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(ImuSensorBroadcasterBenchmark, update);
+
+BENCHMARK_DEFINE_F(ForceTorqueSensorBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  if (activate(
+        state, {rclcpp::Parameter("sensor_name", "ft_sensor"),
+                rclcpp::Parameter("frame_id", "ft_sensor_frame")}))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(ForceTorqueSensorBroadcasterBenchmark, update);
+
+BENCHMARK_DEFINE_F(RangeSensorBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  // within the default minimum and maximum range
+  const double range = 1.0;
+  if (activate(
+        state,
+        {rclcpp::Parameter(
+           "sensor_names", ros2_controllers_benchmarks::make_names("range_sensor", state.range(0))),
+         rclcpp::Parameter("frame_id", "range_sensor_frame")},
+        range))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(RangeSensorBroadcasterBenchmark, update)->Apply(sensor_arguments);
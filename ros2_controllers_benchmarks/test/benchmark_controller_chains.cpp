@@ -0,0 +1,131 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "bicycle_steering_controller/bicycle_steering_controller.hpp"
+#include "chain_benchmark.hpp"
+#include "pid_controller/pid_controller.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ChainBenchmark;
+
+class ControllerChainBenchmark : public ChainBenchmark
+{
+};
+
+/// Parameters of a PID controller of \p dof_names, with proportional gains only
+/**
+ * Without integral and derivative terms, the commands only change with the references, which the
+ * latency is measured by.
+ *
+ * \param state_dof_names names of the references and states of the DoFs
+ * \param reference_interface the interface of the references and states
+ */
+std::vector<rclcpp::Parameter> pid_parameters(
+  const std::vector<std::string> & dof_names, const std::string & command_interface,
+  const std::vector<std::string> & state_dof_names, const std::string & reference_interface)
+{
+  std::vector<rclcpp::Parameter> parameters = {
+    rclcpp::Parameter("dof_names", dof_names),
+    rclcpp::Parameter("command_interface", command_interface),
+    rclcpp::Parameter("reference_and_state_dof_names", state_dof_names),
+    rclcpp::Parameter(
+      "reference_and_state_interfaces", std::vector<std::string>{reference_interface})};
+  for (const auto & dof_name : dof_names)
+  {
+    parameters.emplace_back("gains." + dof_name + ".p", 1.0);
+  }
+  return parameters;
+}
+
+/// The names of \p names prefixed with the name of the controller \p prefix
+std::vector<std::string> prefixed(
+  const std::string & prefix, const std::vector<std::string> & names)
+{
+  std::vector<std::string> prefixed_names;
+  for (const auto & name : names)
+  {
+    prefixed_names.push_back(prefix + "/" + name);
+  }
+  return prefixed_names;
+}
+
+void pid_chain_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"dofs", "leader_first"})->ArgsProduct({{1, 6, 24}, {1, 0}});
+}
+
+}  // namespace
+
+/**
+ * A PID controller commanding the position references of a PID controller, which commands the
+ * velocities of the joints. The inputs are the references of the leading controller.
+ *
+ * Arguments: number of DoFs, and if the leading controller is updated first, as the controller
+ * manager does. Otherwise, the following controller reads the references of the previous update.
+ */
+BENCHMARK_DEFINE_F(ControllerChainBenchmark, pid_into_pid)(benchmark::State & state)
+{
+  const auto joints = ros2_controllers_benchmarks::make_names("joint", state.range(0));
+  const auto leader = [&]()
+  {
+    return add<pid_controller::PidController>(
+      state, "pid_leader",
+      pid_parameters(prefixed("pid_follower", joints), "position", joints, "position"));
+  };
+  const auto follower = [&]()
+  {
+    return add<pid_controller::PidController>(
+      state, "pid_follower", pid_parameters(joints, "velocity", joints, "position"));
+  };
+  const bool added = state.range(1) ? leader() && follower() : follower() && leader();
+  if (added && activate(state))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(ControllerChainBenchmark, pid_into_pid)->Apply(pid_chain_arguments);
+
+/**
+ * The bicycle steering controller of the steering controllers library, whose linear velocity and
+ * angular references are commanded by a PID controller each, as produced by a preceding
+ * controller. The inputs are the references of the PID controllers.
+ */
+BENCHMARK_DEFINE_F(ControllerChainBenchmark, reference_into_steering)(benchmark::State & state)
+{
+  const std::string steering = "bicycle_steering_controller";
+  const bool added =
+    add<pid_controller::PidController>(
+      state, "linear_reference",
+      pid_parameters({steering + "/linear"}, "velocity", {"base_linear"}, "velocity")) &&
+    add<pid_controller::PidController>(
+      state, "angular_reference",
+      pid_parameters({steering + "/angular"}, "position", {"base_angular"}, "position")) &&
+    add<bicycle_steering_controller::BicycleSteeringController>(
+      state, steering,
+      {rclcpp::Parameter("rear_wheels_names", std::vector<std::string>{"rear_wheel"}),
+       rclcpp::Parameter("front_wheels_names", std::vector<std::string>{"front_steering"}),
+       rclcpp::Parameter("front_steering", true), rclcpp::Parameter("open_loop", false),
+       rclcpp::Parameter("position_feedback", false), rclcpp::Parameter("wheelbase", 3.2),
+       rclcpp::Parameter("front_wheel_radius", 0.45),
+       rclcpp::Parameter("rear_wheel_radius", 0.45)});
+  if (added && activate(state))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(ControllerChainBenchmark, reference_into_steering);
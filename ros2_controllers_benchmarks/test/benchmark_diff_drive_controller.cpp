@@ -0,0 +1,53 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "controller_benchmark.hpp"
+#include "diff_drive_controller/diff_drive_controller.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+using ros2_controllers_benchmarks::make_names;
+
+/**
+ * Diff drive controller with position feedback, publishing odometry and its transform in every
+ * update. Without commands on the topic it brakes, which runs the same computations.
+ *
+ * Argument: number of wheels per side
+ */
+class DiffDriveControllerBenchmark
+: public ControllerBenchmark<diff_drive_controller::DiffDriveController>
+{
+};
+
+void wheel_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"wheels_per_side"})->Arg(1)->Arg(2)->Arg(4);
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(DiffDriveControllerBenchmark, update)(benchmark::State & state)
+{
+  if (activate(
+        state, {rclcpp::Parameter("left_wheel_names", make_names("left_wheel", state.range(0))),
+                rclcpp::Parameter("right_wheel_names", make_names("right_wheel", state.range(0))),
+                rclcpp::Parameter("wheel_separation", 0.4),
+                rclcpp::Parameter("wheel_radius", 0.1),
+                rclcpp::Parameter("publish_rate", 1000.0)}))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(DiffDriveControllerBenchmark, update)->Apply(wheel_arguments);
@@ -0,0 +1,69 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "forward_command_controller/forward_command_controller.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+using ros2_controllers_benchmarks::make_names;
+
+/**
+ * Forward command controller for position interfaces, forwarding its references in chained mode.
+ *
+ * Argument: number of joints
+ */
+class ForwardCommandControllerBenchmark
+: public ControllerBenchmark<forward_command_controller::ForwardCommandController>
+{
+};
+
+void joint_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"joints"})->Arg(1)->Arg(6)->Arg(24)->Arg(100);
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(ForwardCommandControllerBenchmark, forward)(benchmark::State & state)
+{
+  if (activate(
+        state,
+        {rclcpp::Parameter("joints", make_names("joint", state.range(0))),
+         rclcpp::Parameter("interface_name", "position")},
+        0.0, true))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(ForwardCommandControllerBenchmark, forward)->Apply(joint_arguments);
+
+BENCHMARK_DEFINE_F(ForwardCommandControllerBenchmark, limit_rates)(benchmark::State & state)
+{
+  if (activate(
+        state,
+        {rclcpp::Parameter("joints", make_names("joint", state.range(0))),
+         rclcpp::Parameter("interface_name", "position"),
+         rclcpp::Parameter(
+           "max_command_rates", std::vector<double>(static_cast<size_t>(state.range(0)), 1.0))},
+        0.0, true))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(ForwardCommandControllerBenchmark, limit_rates)->Apply(joint_arguments);
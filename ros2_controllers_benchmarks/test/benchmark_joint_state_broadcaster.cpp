@@ -0,0 +1,95 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "joint_state_broadcaster/joint_state_broadcaster.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+using ros2_controllers_benchmarks::make_names;
+
+const std::vector<std::string> INTERFACE_NAMES = {"position", "velocity", "effort"};
+
+/**
+ * Joint state broadcaster publishing both of its messages in every update.
+ *
+ * Arguments: number of joints, number of interfaces per joint (1 to 3)
+ */
+class JointStateBroadcasterBenchmark
+: public ControllerBenchmark<joint_state_broadcaster::JointStateBroadcaster>
+{
+};
+
+void joint_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"joints", "interfaces"})->ArgsProduct({{6, 24, 100}, {1, 3}});
+}
+
+// up to several thousand interfaces, e.g., many robots in one simulation
+void activation_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"joints", "interfaces"})
+    ->ArgsProduct({{10, 100, 1000}, {3}})
+    ->Complexity()
+    ->Unit(benchmark::kMicrosecond);
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(JointStateBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  const std::vector<std::string> interface_names(
+    INTERFACE_NAMES.begin(), INTERFACE_NAMES.begin() + state.range(1));
+  if (activate(
+        state,
+        {rclcpp::Parameter("joints", make_names("joint", state.range(0))),
+         rclcpp::Parameter("interfaces", interface_names)}))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(JointStateBroadcasterBenchmark, update)->Apply(joint_arguments);
+
+// time of activating the broadcaster, which initializes its messages, over the interface count
+BENCHMARK_DEFINE_F(JointStateBroadcasterBenchmark, activate)(benchmark::State & state)
+{
+  const std::vector<std::string> interface_names(
+    INTERFACE_NAMES.begin(), INTERFACE_NAMES.begin() + state.range(1));
+  if (!activate(
+        state,
+        {rclcpp::Parameter("joints", make_names("joint", state.range(0))),
+         rclcpp::Parameter("interfaces", interface_names)}))
+  {
+    return;
+  }
+  const auto node = controller_->get_node();
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    node->deactivate();
+    state.ResumeTiming();
+    if (node->activate().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+    {
+      state.SkipWithError("Failed to activate the controller");
+      break;
+    }
+  }
+  state.SetComplexityN(static_cast<int64_t>(state_interfaces_.size()));
+  report(state);
+}
+BENCHMARK_REGISTER_F(JointStateBroadcasterBenchmark, activate)->Apply(activation_arguments);
@@ -0,0 +1,122 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "joint_trajectory_controller/joint_trajectory_controller.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+
+// a new trajectory is sent before the last one ends, i.e., every 9 s of the 10 s trajectories
+constexpr size_t POINTS_PER_TRAJECTORY = 101;
+const rclcpp::Duration POINT_PERIOD = rclcpp::Duration::from_seconds(0.1);
+constexpr size_t CYCLES_PER_TRAJECTORY = 9000;
+
+class BenchmarkableJointTrajectoryController
+: public joint_trajectory_controller::JointTrajectoryController
+{
+public:
+  using joint_trajectory_controller::JointTrajectoryController::topic_callback;
+};
+
+/**
+ * Joint trajectory controller with position commands, and position and velocity states.
+ *
+ * Argument: number of joints
+ */
+class JointTrajectoryControllerBenchmark
+: public ControllerBenchmark<BenchmarkableJointTrajectoryController>
+{
+public:
+  bool activate_controller(benchmark::State & state)
+  {
+    joint_names_ = ros2_controllers_benchmarks::make_names("joint", state.range(0));
+    return activate(
+      state, {rclcpp::Parameter("joints", joint_names_),
+              rclcpp::Parameter("command_interfaces", std::vector<std::string>{"position"}),
+              rclcpp::Parameter(
+                "state_interfaces", std::vector<std::string>{"position", "velocity"})});
+  }
+
+  /// Sinusoidal trajectory starting on its arrival, with positions and velocities
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> make_trajectory() const
+  {
+    auto trajectory = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+    trajectory->joint_names = joint_names_;
+    trajectory->points.resize(POINTS_PER_TRAJECTORY);
+    for (size_t k = 0; k < POINTS_PER_TRAJECTORY; ++k)
+    {
+      auto & point = trajectory->points[k];
+      const double t = POINT_PERIOD.seconds() * static_cast<double>(k);
+      point.time_from_start = rclcpp::Duration::from_seconds(t);
+      for (size_t j = 0; j < joint_names_.size(); ++j)
+      {
+        point.positions.push_back(0.5 * std::sin(t + static_cast<double>(j)));
+        point.velocities.push_back(0.5 * std::cos(t + static_cast<double>(j)));
+      }
+    }
+    return trajectory;
+  }
+
+protected:
+  std::vector<std::string> joint_names_;
+};
+
+void joint_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"joints"})->Arg(1)->Arg(6)->Arg(12)->Arg(24)->Arg(48);
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(JointTrajectoryControllerBenchmark, hold_position)(benchmark::State & state)
+{
+  if (activate_controller(state))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(JointTrajectoryControllerBenchmark, hold_position)->Apply(joint_arguments);
+
+BENCHMARK_DEFINE_F(JointTrajectoryControllerBenchmark, follow_trajectory)
+(benchmark::State & state)
+{
+  if (!activate_controller(state))
+  {
+    return;
+  }
+  controller_->topic_callback(make_trajectory());
+  size_t cycle = 0;
+  run_updates(
+    state,
+    [this, &state, &cycle](const rclcpp::Time &)
+    {
+      // the message is created outside of the timing, taking it over in the next update is timed
+      if (++cycle % CYCLES_PER_TRAJECTORY == 0)
+      {
+        state.PauseTiming();
+        controller_->topic_callback(make_trajectory());
+        state.ResumeTiming();
+      }
+    });
+}
+BENCHMARK_REGISTER_F(JointTrajectoryControllerBenchmark, follow_trajectory)
+  ->Apply(joint_arguments);
@@ -0,0 +1,62 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "pid_controller/pid_controller.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+
+/**
+ * PID controller commanding velocities from position and velocity references and states, in
+ * chained mode.
+ *
+ * Argument: number of DoFs
+ */
+class PidControllerBenchmark : public ControllerBenchmark<pid_controller::PidController>
+{
+};
+
+void dof_arguments(benchmark::internal::Benchmark * benchmark)
+{
+  benchmark->ArgNames({"dofs"})->Arg(1)->Arg(6)->Arg(12)->Arg(24)->Arg(48);
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(PidControllerBenchmark, update)(benchmark::State & state)
+{
+  const auto dof_names = ros2_controllers_benchmarks::make_names("joint", state.range(0));
+  std::vector<rclcpp::Parameter> parameters = {
+    rclcpp::Parameter("dof_names", dof_names), rclcpp::Parameter("command_interface", "velocity"),
+    rclcpp::Parameter(
+      "reference_and_state_interfaces", std::vector<std::string>{"position", "velocity"})};
+  for (const auto & dof_name : dof_names)
+  {
+    parameters.emplace_back("gains." + dof_name + ".p", 1.0);
+    parameters.emplace_back("gains." + dof_name + ".i", 0.1);
+    parameters.emplace_back("gains." + dof_name + ".d", 0.01);
+    parameters.emplace_back("gains." + dof_name + ".i_clamp_max", 5.0);
+    parameters.emplace_back("gains." + dof_name + ".i_clamp_min", -5.0);
+  }
+  if (activate(state, parameters, 0.0, true))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(PidControllerBenchmark, update)->Apply(dof_arguments);
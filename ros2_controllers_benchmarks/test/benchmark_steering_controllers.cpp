@@ -0,0 +1,101 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "ackermann_steering_controller/ackermann_steering_controller.hpp"
+#include "bicycle_steering_controller/bicycle_steering_controller.hpp"
+#include "controller_benchmark.hpp"
+#include "tricycle_steering_controller/tricycle_steering_controller.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+
+// the steering controllers differ in the number of wheels: 2 of the bicycle, 3 of the tricycle and
+// 4 of the ackermann steering controller
+
+class BicycleSteeringControllerBenchmark
+: public ControllerBenchmark<bicycle_steering_controller::BicycleSteeringController>
+{
+};
+
+class TricycleSteeringControllerBenchmark
+: public ControllerBenchmark<tricycle_steering_controller::TricycleSteeringController>
+{
+};
+
+class AckermannSteeringControllerBenchmark
+: public ControllerBenchmark<ackermann_steering_controller::AckermannSteeringController>
+{
+};
+
+/// Parameters of the steering controllers library, the references are written in chained mode
+std::vector<rclcpp::Parameter> library_parameters(
+  const std::vector<std::string> & rear_wheels_names,
+  const std::vector<std::string> & front_wheels_names)
+{
+  return {
+    rclcpp::Parameter("rear_wheels_names", rear_wheels_names),
+    rclcpp::Parameter("front_wheels_names", front_wheels_names),
+    rclcpp::Parameter("front_steering", true), rclcpp::Parameter("open_loop", false),
+    rclcpp::Parameter("position_feedback", false)};
+}
+
+}  // namespace
+
+BENCHMARK_DEFINE_F(BicycleSteeringControllerBenchmark, update)(benchmark::State & state)
+{
+  auto parameters = library_parameters({"rear_wheel"}, {"front_steering"});
+  parameters.emplace_back("wheelbase", 3.2);
+  parameters.emplace_back("front_wheel_radius", 0.45);
+  parameters.emplace_back("rear_wheel_radius", 0.45);
+  if (activate(state, parameters, 0.0, true))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(BicycleSteeringControllerBenchmark, update);
+
+BENCHMARK_DEFINE_F(TricycleSteeringControllerBenchmark, update)(benchmark::State & state)
+{
+  auto parameters =
+    library_parameters({"rear_right_wheel", "rear_left_wheel"}, {"front_steering"});
+  parameters.emplace_back("wheelbase", 3.2);
+  parameters.emplace_back("wheel_track", 1.2);
+  parameters.emplace_back("front_wheels_radius", 0.45);
+  parameters.emplace_back("rear_wheels_radius", 0.45);
+  if (activate(state, parameters, 0.0, true))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(TricycleSteeringControllerBenchmark, update);
+
+BENCHMARK_DEFINE_F(AckermannSteeringControllerBenchmark, update)(benchmark::State & state)
+{
+  auto parameters = library_parameters(
+    {"rear_right_wheel", "rear_left_wheel"}, {"front_right_steering", "front_left_steering"});
+  parameters.emplace_back("wheelbase", 3.2);
+  parameters.emplace_back("front_wheel_track", 2.1);
+  parameters.emplace_back("rear_wheel_track", 1.8);
+  parameters.emplace_back("front_wheels_radius", 0.45);
+  parameters.emplace_back("rear_wheels_radius", 0.45);
+  if (activate(state, parameters, 0.0, true))
+  {
+    run_updates(state);
+  }
+}
+BENCHMARK_REGISTER_F(AckermannSteeringControllerBenchmark, update);
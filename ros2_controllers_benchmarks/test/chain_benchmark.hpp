@@ -0,0 +1,325 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CHAIN_BENCHMARK_HPP_
+#define CHAIN_BENCHMARK_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+
+namespace ros2_controllers_benchmarks
+{
+// the inputs of the chain change every this many updates
+constexpr int64_t INPUT_STEP_CYCLES = 20;
+
+/**
+ * \brief Fixture timing a chain of controllers on in-memory hardware, as the controller manager
+ * updates it.
+ *
+ * The controllers are updated in the order they are added. The command interfaces of a controller
+ * whose names are reference interfaces of another controller of the chain are connected to them,
+ * like the controller manager does, the others are in-memory hardware. All controllers run in
+ * chained mode, and the reference interfaces no controller writes are the inputs of the chain,
+ * written before every update like by a reference producer.
+ *
+ * The inputs step between two values every INPUT_STEP_CYCLES updates. Besides the counters of
+ * ControllerBenchmark for the cost of updating the whole chain, and the mean cost of each
+ * controller as "<name>_us", the latency from a step of the inputs to the first change of the
+ * hardware commands is reported in updates: latency_cycles is its mean, latency_cycles_max its
+ * maximum, zero if the commands change in the update the inputs were written in.
+ */
+class ChainBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(const benchmark::State &) override
+  {
+    if (!rclcpp::ok())
+    {
+      rclcpp::init(0, nullptr);
+    }
+    latencies_.clear();
+    latencies_.reserve(MAX_RECORDED_LATENCIES);
+  }
+
+  void TearDown(const benchmark::State &) override
+  {
+    for (auto & stage : stages_)
+    {
+      stage.controller->get_node()->deactivate();
+      stage.controller->get_node()->cleanup();
+    }
+    stages_.clear();
+    reference_interfaces_.clear();
+    command_interfaces_.clear();
+    state_interfaces_.clear();
+    values_.clear();
+    inputs_.clear();
+    outputs_.clear();
+    rclcpp::shutdown();
+  }
+
+  /// Add a controller named \p name with \p parameters, updated after the ones added before
+  /**
+   * \returns false if its configuration failed, the benchmark is skipped then
+   */
+  template <typename ControllerT>
+  bool add(
+    benchmark::State & state, const std::string & name,
+    const std::vector<rclcpp::Parameter> & parameters)
+  {
+    auto controller = std::make_shared<ControllerT>();
+    auto node_options = rclcpp::NodeOptions();
+    node_options.allow_undeclared_parameters(false)
+      .automatically_declare_parameters_from_overrides(false)
+      .parameter_overrides(parameters);
+    if (
+      controller->init(name, "", 0, "", node_options) != controller_interface::return_type::OK ||
+      controller->get_node()->configure().id() !=
+        lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+    {
+      state.SkipWithError("Failed to configure the controller " + name);
+      return false;
+    }
+    for (auto & reference_interface : controller->export_reference_interfaces())
+    {
+      reference_interfaces_.push_back(std::move(reference_interface));
+    }
+    if (!controller->set_chained_mode(true))
+    {
+      state.SkipWithError("Failed to switch the controller " + name + " to chained mode");
+      return false;
+    }
+    stages_.push_back({name, controller, 0.0});
+    return true;
+  }
+
+  /**
+   * \brief Connect the controllers of the chain and the in-memory hardware, and activate them,
+   * the last one first, like the controller manager.
+   *
+   * \param state_value initial value of all state interfaces
+   * \param input_value the inputs step between it and its negative
+   */
+  bool activate(
+    benchmark::State & state, const double state_value = 0.0, const double input_value = 0.1)
+  {
+    std::vector<bool> is_written(reference_interfaces_.size(), false);
+    for (auto & stage : stages_)
+    {
+      std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+      for (const auto & name : stage.controller->command_interface_configuration().names)
+      {
+        bool is_reference = false;
+        for (size_t i = 0; i < reference_interfaces_.size(); ++i)
+        {
+          if (reference_interfaces_[i].get_name() == name)
+          {
+            loaned_command_interfaces.emplace_back(reference_interfaces_[i]);
+            is_written[i] = true;
+            is_reference = true;
+            break;
+          }
+        }
+        if (!is_reference)
+        {
+          const auto separator = name.rfind('/');
+          command_interfaces_.emplace_back(
+            name.substr(0, separator), name.substr(separator + 1), &values_.emplace_back(0.0));
+          loaned_command_interfaces.emplace_back(command_interfaces_.back());
+          outputs_.push_back(&values_.back());
+        }
+      }
+      std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+      for (const auto & name : stage.controller->state_interface_configuration().names)
+      {
+        const auto separator = name.rfind('/');
+        state_interfaces_.emplace_back(
+          name.substr(0, separator), name.substr(separator + 1),
+          &values_.emplace_back(state_value));
+        loaned_state_interfaces.emplace_back(state_interfaces_.back());
+      }
+      stage.controller->assign_interfaces(
+        std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+    }
+    for (size_t i = 0; i < reference_interfaces_.size(); ++i)
+    {
+      if (!is_written[i])
+      {
+        inputs_.push_back(&reference_interfaces_[i]);
+      }
+    }
+    if (inputs_.empty() || outputs_.empty())
+    {
+      state.SkipWithError("The chain has no inputs or no hardware commands");
+      return false;
+    }
+    input_value_ = input_value;
+
+    for (auto stage = stages_.rbegin(); stage != stages_.rend(); ++stage)
+    {
+      if (
+        stage->controller->get_node()->activate().id() !=
+        lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+      {
+        state.SkipWithError("Failed to activate the controller " + stage->name);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Time the updates of the activated chain, one update of all controllers per iteration
+  void run_updates(benchmark::State & state)
+  {
+    rclcpp::Time time = stages_.front().controller->get_node()->now();
+    // the first updates may still initialize, and the commands settle on the first input
+    for (int64_t cycle = 0; cycle < INPUT_STEP_CYCLES; ++cycle)
+    {
+      write_inputs(input_value_);
+      update_chain(time, false);
+      time += CONTROL_PERIOD;
+    }
+    std::vector<double> previous_outputs(outputs_.size());
+    read_outputs(previous_outputs);
+
+    int64_t cycle = 0;
+    int64_t step_cycle = 0;
+    bool waiting_for_change = false;
+    double input = input_value_;
+    double latency_sum = 0.0;
+    int64_t latency_max = 0;
+    size_t steps = 0;
+    std::vector<double> outputs(outputs_.size());
+    for (auto _ : state)
+    {
+      if (cycle % INPUT_STEP_CYCLES == 0)
+      {
+        if (waiting_for_change)
+        {
+          // no change within a step, counted with the length of the step
+          latency_sum += static_cast<double>(INPUT_STEP_CYCLES);
+          latency_max = INPUT_STEP_CYCLES;
+          ++steps;
+        }
+        input = -input;
+        step_cycle = cycle;
+        waiting_for_change = true;
+      }
+      write_inputs(input);
+      const auto start = std::chrono::steady_clock::now();
+      update_chain(time, true);
+      const auto end = std::chrono::steady_clock::now();
+      if (latencies_.size() < latencies_.capacity())
+      {
+        latencies_.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+      }
+
+      read_outputs(outputs);
+      if (waiting_for_change && outputs != previous_outputs)
+      {
+        const int64_t latency = cycle - step_cycle;
+        latency_sum += static_cast<double>(latency);
+        latency_max = std::max(latency_max, latency);
+        ++steps;
+        waiting_for_change = false;
+      }
+      previous_outputs.swap(outputs);
+      time += CONTROL_PERIOD;
+      ++cycle;
+    }
+
+    state.counters["controllers"] = static_cast<double>(stages_.size());
+    state.counters["command_interfaces"] = static_cast<double>(command_interfaces_.size());
+    state.counters["state_interfaces"] = static_cast<double>(state_interfaces_.size());
+    state.counters["reference_interfaces"] = static_cast<double>(reference_interfaces_.size());
+    if (steps > 0)
+    {
+      state.counters["latency_cycles"] = latency_sum / static_cast<double>(steps);
+      state.counters["latency_cycles_max"] = static_cast<double>(latency_max);
+    }
+    if (cycle > 0)
+    {
+      for (const auto & stage : stages_)
+      {
+        state.counters[stage.name + "_us"] = stage.duration_us / static_cast<double>(cycle);
+      }
+    }
+    report_latencies(state, latencies_);
+  }
+
+protected:
+  struct Stage
+  {
+    std::string name;
+    std::shared_ptr<controller_interface::ChainableControllerInterface> controller;
+    // sum of the timed updates of the controller
+    double duration_us;
+  };
+
+  void write_inputs(const double value)
+  {
+    for (auto * input : inputs_)
+    {
+      input->set_value(value);
+    }
+  }
+
+  void update_chain(const rclcpp::Time & time, const bool timed)
+  {
+    for (auto & stage : stages_)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      benchmark::DoNotOptimize(stage.controller->update(time, CONTROL_PERIOD));
+      if (timed)
+      {
+        stage.duration_us += std::chrono::duration<double, std::micro>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+      }
+    }
+  }
+
+  void read_outputs(std::vector<double> & outputs) const
+  {
+    for (size_t i = 0; i < outputs_.size(); ++i)
+    {
+      outputs[i] = *outputs_[i];
+    }
+  }
+
+  std::vector<Stage> stages_;
+  // deques, so the addresses stay valid while the interfaces are created
+  std::deque<double> values_;
+  std::deque<hardware_interface::CommandInterface> reference_interfaces_;
+  std::deque<hardware_interface::CommandInterface> command_interfaces_;
+  std::deque<hardware_interface::StateInterface> state_interfaces_;
+  // reference interfaces written by no controller of the chain
+  std::vector<hardware_interface::CommandInterface *> inputs_;
+  // values of the hardware command interfaces
+  std::vector<const double *> outputs_;
+  double input_value_ = 0.1;
+  std::vector<double> latencies_;
+};
+
+}  // namespace ros2_controllers_benchmarks
+
+#endif  // CHAIN_BENCHMARK_HPP_
@@ -0,0 +1,251 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_BENCHMARK_HPP_
+#define CONTROLLER_BENCHMARK_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace ros2_controllers_benchmarks
+{
+const rclcpp::Duration CONTROL_PERIOD = rclcpp::Duration::from_seconds(0.001);
+// latencies are recorded for at most this many iterations, google benchmark picks the number
+constexpr size_t MAX_RECORDED_LATENCIES = 1000000;
+
+/// Names "<prefix>1" to "<prefix><count>"
+inline std::vector<std::string> make_names(const std::string & prefix, const int64_t count)
+{
+  std::vector<std::string> names;
+  for (int64_t i = 1; i <= count; ++i)
+  {
+    names.push_back(prefix + std::to_string(i));
+  }
+  return names;
+}
+
+/// Report the percentiles and the maximum of \p latencies in microseconds, which are sorted
+inline void report_latencies(benchmark::State & state, std::vector<double> & latencies)
+{
+  if (latencies.empty())
+  {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&latencies](const double p)
+  {
+    const auto index = static_cast<size_t>(std::ceil(p * static_cast<double>(latencies.size())));
+    return latencies[std::min(std::max<size_t>(index, 1), latencies.size()) - 1];
+  };
+  state.counters["p50_us"] = percentile(0.5);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["max_us"] = latencies.back();
+}
+
+/**
+ * \brief Fixture timing the update() of a controller on in-memory hardware.
+ *
+ * activate() creates one interface for every name of the command and state interface
+ * configurations of the configured controller, so the benchmarks only set the parameters. The
+ * latencies of the updates are reported as the counters p50_us, p99_us and max_us, besides the
+ * number of interfaces, so the results of different scales can be compared from the JSON output.
+ */
+template <typename ControllerT>
+class ControllerBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(const benchmark::State &) override
+  {
+    if (!rclcpp::ok())
+    {
+      rclcpp::init(0, nullptr);
+    }
+    controller_ = std::make_shared<ControllerT>();
+    latencies_.clear();
+    latencies_.reserve(MAX_RECORDED_LATENCIES);
+  }
+
+  void TearDown(const benchmark::State &) override
+  {
+    if (controller_)
+    {
+      controller_->get_node()->deactivate();
+      controller_->get_node()->cleanup();
+      controller_.reset();
+    }
+    reference_interfaces_.clear();
+    command_interfaces_.clear();
+    state_interfaces_.clear();
+    values_.clear();
+    rclcpp::shutdown();
+  }
+
+  /**
+   * \brief Initialize the controller with \p parameters, configure it, assign the in-memory
+   * hardware and activate it.
+   *
+   * \param state_value initial value of all state interfaces, e.g., to be within sensor ranges
+   * \param chained_mode if the reference interfaces are written with \p reference_value before
+   * every update instead of being read from the subscribers
+   * \returns false if a step failed, the benchmark is skipped then
+   */
+  bool activate(
+    benchmark::State & state, const std::vector<rclcpp::Parameter> & parameters,
+    const double state_value = 0.0, const bool chained_mode = false,
+    const double reference_value = 0.1)
+  {
+    auto node_options = rclcpp::NodeOptions();
+    node_options.allow_undeclared_parameters(false)
+      .automatically_declare_parameters_from_overrides(false)
+      .parameter_overrides(parameters);
+    if (
+      controller_->init("benchmark_controller", "", 0, "", node_options) !=
+        controller_interface::return_type::OK ||
+      controller_->get_node()->configure().id() !=
+        lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+    {
+      state.SkipWithError("Failed to configure the controller");
+      return false;
+    }
+
+    if constexpr (std::is_base_of_v<
+                    controller_interface::ChainableControllerInterface, ControllerT>)
+    {
+      reference_interfaces_ = controller_->export_reference_interfaces();
+      if (chained_mode && !controller_->set_chained_mode(true))
+      {
+        state.SkipWithError("Failed to switch the controller to chained mode");
+        return false;
+      }
+    }
+    chained_mode_ = chained_mode;
+    reference_value_ = reference_value;
+
+    std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+    for (const auto & name : controller_->command_interface_configuration().names)
+    {
+      const auto separator = name.rfind('/');
+      command_interfaces_.emplace_back(
+        name.substr(0, separator), name.substr(separator + 1), &values_.emplace_back(0.0));
+      loaned_command_interfaces.emplace_back(command_interfaces_.back());
+    }
+    std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+    for (const auto & name : controller_->state_interface_configuration().names)
+    {
+      const auto separator = name.rfind('/');
+      state_interfaces_.emplace_back(
+        name.substr(0, separator), name.substr(separator + 1), &values_.emplace_back(state_value));
+      loaned_state_interfaces.emplace_back(state_interfaces_.back());
+    }
+    controller_->assign_interfaces(
+      std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+
+    if (
+      controller_->get_node()->activate().id() !=
+      lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+    {
+      state.SkipWithError("Failed to activate the controller");
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * \brief Time the updates of the activated controller, one per benchmark iteration.
+   *
+   * \param before_update called with the current time before every timed update, e.g., to send a
+   * new command. It can pause the timing of the benchmark itself.
+   */
+  template <typename Function>
+  void run_updates(benchmark::State & state, Function && before_update)
+  {
+    rclcpp::Time time = controller_->get_node()->now();
+    // the first update may still initialize
+    before_update(time);
+    write_references();
+    controller_->update(time, CONTROL_PERIOD);
+
+    for (auto _ : state)
+    {
+      time += CONTROL_PERIOD;
+      before_update(time);
+      write_references();
+      const auto start = std::chrono::steady_clock::now();
+      benchmark::DoNotOptimize(controller_->update(time, CONTROL_PERIOD));
+      const auto end = std::chrono::steady_clock::now();
+      if (latencies_.size() < latencies_.capacity())
+      {
+        latencies_.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+      }
+    }
+    report(state);
+  }
+
+  void run_updates(benchmark::State & state)
+  {
+    run_updates(state, [](const rclcpp::Time &) {});
+  }
+
+protected:
+  /// Write the references like a preceding controller in chained mode
+  void write_references()
+  {
+    if (chained_mode_)
+    {
+      for (auto & reference_interface : reference_interfaces_)
+      {
+        reference_interface.set_value(reference_value_);
+      }
+    }
+  }
+
+  /// Percentiles and maximum of the recorded latencies in microseconds, and the interface counts
+  void report(benchmark::State & state)
+  {
+    state.counters["command_interfaces"] = static_cast<double>(command_interfaces_.size());
+    state.counters["state_interfaces"] = static_cast<double>(state_interfaces_.size());
+    state.counters["reference_interfaces"] = static_cast<double>(reference_interfaces_.size());
+    report_latencies(state, latencies_);
+  }
+
+  std::shared_ptr<ControllerT> controller_;
+  // deques, so the addresses stay valid while the interfaces are created
+  std::deque<double> values_;
+  std::deque<hardware_interface::CommandInterface> command_interfaces_;
+  std::deque<hardware_interface::StateInterface> state_interfaces_;
+  std::vector<hardware_interface::CommandInterface> reference_interfaces_;
+  bool chained_mode_ = false;
+  double reference_value_ = 0.0;
+  std::vector<double> latencies_;
+};
+
+}  // namespace ros2_controllers_benchmarks
+
+#endif  // CONTROLLER_BENCHMARK_HPP_
@@ -0,0 +1,299 @@
+# Copyright (c) 2024 ros2_control Development Team
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Generate command load for controllers and measure the command-to-interface latency.
+
+Each of the ``streams`` publishes commands at its own ``rate``:
+
+.. code-block:: yaml
+
+    load_generator:
+      ros__parameters:
+        streams: ["jtc", "forward", "diff_drive"]
+        report_period: 5.0
+        jtc:
+          type: joint_trajectory  # trajectory_msgs/msg/JointTrajectory
+          topic: /joint_trajectory_controller/joint_trajectory
+          rate: 50.0
+          joints: [joint1, joint2, joint3]
+          sizes: [1, 10, 100]  # points per trajectory, cycled
+          time_from_start: 0.1  # of the last point, the first one is at zero
+          partial_joints: true  # random subsets of the joints, always with probe_joint
+          probe_joint: joint1
+        forward:
+          type: float64_array  # std_msgs/msg/Float64MultiArray
+          topic: /forward_position_controller/commands
+          joints: [joint1, joint2, joint3]
+        diff_drive:
+          type: twist_stamped  # geometry_msgs/msg/TwistStamped, or twist
+          topic: /diff_drive_controller/cmd_vel
+
+Further types are ``multi_dof_command`` (control_msgs/msg/MultiDOFCommand), e.g., for the
+reference of the pid_controller, and ``joint_trajectory_point``
+(trajectory_msgs/msg/JointTrajectoryPoint), e.g., for the reference of the admittance_controller.
+
+The joint commands are ``center + offset`` with the optional ``center`` per joint, and an offset
+stepping from zero to ``amplitude`` with each message. If ``probe_joint`` is set, the offset is
+looked for in the position of the joint on ``feedback_topic`` (sensor_msgs/msg/JointState). That
+requires an interface mirroring the command, e.g., of mock hardware, and includes the period of
+the joint_state_broadcaster. The latency is the time from publishing to receiving the offset, and
+a message is counted as dropped if a later one is received first.
+
+The statistics are logged every ``report_period``, and appended to ``output_file`` as CSV if set.
+"""
+
+import collections
+import random
+
+import rclpy
+from rclpy.node import Node
+from rclpy.duration import Duration
+
+from control_msgs.msg import MultiDOFCommand
+from geometry_msgs.msg import Twist, TwistStamped
+from sensor_msgs.msg import JointState
+from std_msgs.msg import Float64MultiArray
+from trajectory_msgs.msg import JointTrajectory, JointTrajectoryPoint
+
+# Number of offsets the amplitude is divided into, so that the offsets of the messages in flight
+# are distinct
+OFFSET_STEPS = 64
+
+MSG_TYPES = {
+    "joint_trajectory": JointTrajectory,
+    "joint_trajectory_point": JointTrajectoryPoint,
+    "float64_array": Float64MultiArray,
+    "multi_dof_command": MultiDOFCommand,
+    "twist": Twist,
+    "twist_stamped": TwistStamped,
+}
+
+
+class Stream:
+    def __init__(self, node, name):
+        self.name = name
+
+        def param(sub_param, default):
+            return node.declare_parameter(name + "." + sub_param, default).value
+
+        self.type = param("type", "joint_trajectory")
+        if self.type not in MSG_TYPES:
+            raise Exception(f'Stream "{name}" has the unknown type "{self.type}"!')
+        topic = param("topic", "")
+        if not topic:
+            raise Exception(f'"{name}.topic" parameter is not set!')
+        rate = param("rate", 100.0)
+        self.joints = param("joints", [""])
+        if self.joints == [""]:
+            self.joints = []
+        if self.type not in ("twist", "twist_stamped") and not self.joints:
+            raise Exception(f'"{name}.joints" parameter is not set!')
+        self.center = param("center", [0.0] * max(len(self.joints), 1))
+        if len(self.center) != len(self.joints):
+            self.center = [0.0] * len(self.joints)
+        self.amplitude = param("amplitude", 0.1)
+        self.sizes = param("sizes", [1])
+        self.partial_joints = param("partial_joints", False)
+        self.time_from_start = Duration(seconds=param("time_from_start", 0.1))
+        self.probe_joint = param("probe_joint", "")
+        if self.probe_joint and self.probe_joint not in self.joints:
+            raise Exception(f'"{name}.probe_joint" is not one of "{name}.joints"!')
+
+        self._node = node
+        self._publisher = node.create_publisher(MSG_TYPES[self.type], topic, 10)
+        self._timer = node.create_timer(1.0 / rate, self._publish)
+        self._seq = 0
+        self._in_flight = collections.deque()  # (offset, time published) of unreceived probes
+        self._random = random.Random(name)
+        self.reset_statistics()
+
+        node.get_logger().info(f'Stream "{name}" publishes {self.type} on "{topic}" at {rate} Hz')
+
+    def reset_statistics(self):
+        self.published = 0
+        self.received = 0
+        self.dropped = 0
+        self.latencies = []
+
+    def on_feedback(self, msg, now):
+        try:
+            position = msg.position[msg.name.index(self.probe_joint)]
+        except (ValueError, IndexError):
+            return
+        offset = position - self.center[self.joints.index(self.probe_joint)]
+        tolerance = self.amplitude / OFFSET_STEPS / 4.0
+        for idx, (probe_offset, stamp) in enumerate(self._in_flight):
+            if abs(offset - probe_offset) <= tolerance:
+                self.received += 1
+                self.dropped += idx
+                self.latencies.append((now - stamp).nanoseconds * 1e-9)
+                for _ in range(idx + 1):
+                    self._in_flight.popleft()
+                return
+
+    def _publish(self):
+        offset = self.amplitude * (self._seq % OFFSET_STEPS) / OFFSET_STEPS
+        self._seq += 1
+        now = self._node.get_clock().now()
+        self._publisher.publish(getattr(self, "_make_" + self.type)(offset, now))
+        self.published += 1
+        if self.probe_joint:
+            self._in_flight.append((offset, now))
+            # Offsets repeat after OFFSET_STEPS messages, older probes can't be matched anymore
+            while len(self._in_flight) > OFFSET_STEPS // 2:
+                self._in_flight.popleft()
+                self.dropped += 1
+
+    def _positions(self, joints, offset):
+        return [self.center[self.joints.index(joint)] + offset for joint in joints]
+
+    def _make_joint_trajectory(self, offset, now):
+        joints = self.joints
+        if self.partial_joints:
+            joints = [
+                joint
+                for joint in self.joints
+                if joint == self.probe_joint or self._random.random() < 0.5
+            ]
+            if not joints:
+                joints = [self._random.choice(self.joints)]
+        size = max(self.sizes[(self._seq - 1) % len(self.sizes)], 1)
+        msg = JointTrajectory()
+        msg.joint_names = joints
+        # All points hold the same positions, and the first one is at zero, so the probe is
+        # commanded as soon as the trajectory is started
+        positions = self._positions(joints, offset)
+        for idx in range(size):
+            point = JointTrajectoryPoint()
+            point.positions = positions
+            point.time_from_start = Duration(
+                nanoseconds=self.time_from_start.nanoseconds * idx // max(size - 1, 1)
+            ).to_msg()
+            msg.points.append(point)
+        return msg
+
+    def _make_joint_trajectory_point(self, offset, now):
+        msg = JointTrajectoryPoint()
+        msg.positions = self._positions(self.joints, offset)
+        msg.velocities = [0.0] * len(self.joints)
+        return msg
+
+    def _make_float64_array(self, offset, now):
+        msg = Float64MultiArray()
+        msg.data = self._positions(self.joints, offset)
+        return msg
+
+    def _make_multi_dof_command(self, offset, now):
+        msg = MultiDOFCommand()
+        msg.dof_names = self.joints
+        msg.values = self._positions(self.joints, offset)
+        msg.values_dot = [0.0] * len(self.joints)
+        return msg
+
+    def _make_twist(self, offset, now):
+        msg = Twist()
+        msg.linear.x = offset
+        msg.angular.z = offset
+        return msg
+
+    def _make_twist_stamped(self, offset, now):
+        msg = TwistStamped()
+        msg.header.stamp = now.to_msg()
+        msg.twist = self._make_twist(offset, now)
+        return msg
+
+
+class LoadGenerator(Node):
+    def __init__(self):
+        super().__init__("load_generator")
+        # Declare all parameters
+        self.declare_parameter("streams", [""])
+        self.declare_parameter("feedback_topic", "joint_states")
+        self.declare_parameter("report_period", 5.0)
+        self.declare_parameter("output_file", "")
+
+        # Read parameters
+        stream_names = [name for name in self.get_parameter("streams").value if name]
+        feedback_topic = self.get_parameter("feedback_topic").value
+        report_period = self.get_parameter("report_period").value
+        self.output_file = self.get_parameter("output_file").value
+
+        if not stream_names:
+            raise Exception('"streams" parameter is not set!')
+
+        self.streams = [Stream(self, name) for name in stream_names]
+        if any(stream.probe_joint for stream in self.streams):
+            self.feedback_sub = self.create_subscription(
+                JointState, feedback_topic, self.feedback_callback, 10
+            )
+        self.last_report = self.get_clock().now()
+        self.report_timer = self.create_timer(report_period, self.report_callback)
+
+        if self.output_file:
+            with open(self.output_file, "a") as output:
+                output.write(
+                    "stream,period_s,published,received,dropped,"
+                    "latency_mean_s,latency_p99_s,latency_max_s\n"
+                )
+
+    def feedback_callback(self, msg):
+        now = self.get_clock().now()
+        for stream in self.streams:
+            if stream.probe_joint:
+                stream.on_feedback(msg, now)
+
+    def report_callback(self):
+        now = self.get_clock().now()
+        period = (now - self.last_report).nanoseconds * 1e-9
+        self.last_report = now
+        for stream in self.streams:
+            latencies = sorted(stream.latencies)
+            mean = p99 = maximum = float("nan")
+            if latencies:
+                mean = sum(latencies) / len(latencies)
+                p99 = latencies[min(int(0.99 * len(latencies)), len(latencies) - 1)]
+                maximum = latencies[-1]
+
+            summary = f'Stream "{stream.name}": {stream.published / period:.1f} msgs/s'
+            if stream.probe_joint:
+                probes = stream.received + stream.dropped
+                drop_rate = stream.dropped / probes if probes else 0.0
+                summary += (
+                    f", {100.0 * drop_rate:.1f} % dropped, latency mean {1e3 * mean:.2f} ms, "
+                    f"p99 {1e3 * p99:.2f} ms, max {1e3 * maximum:.2f} ms"
+                )
+            self.get_logger().info(summary)
+
+            if self.output_file:
+                with open(self.output_file, "a") as output:
+                    output.write(
+                        f"{stream.name},{period},{stream.published},{stream.received},"
+                        f"{stream.dropped},{mean},{p99},{maximum}\n"
+                    )
+            stream.reset_statistics()
+
+
+def main(args=None):
+    rclpy.init(args=args)
+
+    load_generator = LoadGenerator()
+
+    rclpy.spin(load_generator)
+    load_generator.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == "__main__":
+    main()
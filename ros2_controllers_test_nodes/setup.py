@@ -52,6 +52,8 @@ Demo nodes for showing and testing functionalities of the ros2_control framework
                 ros2_controllers_test_nodes.publisher_forward_position_controller:main",
             "publisher_joint_trajectory_controller = \
                 ros2_controllers_test_nodes.publisher_joint_trajectory_controller:main",
+            "load_generator = \
+                ros2_controllers_test_nodes.load_generator:main",
         ],
     },
 )
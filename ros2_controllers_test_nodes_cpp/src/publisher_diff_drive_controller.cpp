@@ -0,0 +1,119 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Publishes the velocity goals of the parameters cyclically, in the shape of the parameters of
+// publisher_forward_position_controller and those of PublishingLoop:
+//
+//   publisher_diff_drive_controller:
+//     ros__parameters:
+//       publish_topic: /diff_drive_controller/cmd_vel
+//       wait_sec_between_publish: 0.002
+//       goal_names: ["forward", "turn"]
+//       forward: [0.5, 0.0]  # linear.x, angular.z
+//       turn: [0.0, 1.0]
+//       use_stamped_vel: true  # geometry_msgs/msg/TwistStamped, or Twist
+//
+// The header of a TwistStamped is stamped with the time of publishing, which tells the latency,
+// and which the diff_drive_controller compares with its cmd_vel_timeout.
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "geometry_msgs/msg/twist.hpp"
+#include "geometry_msgs/msg/twist_stamped.hpp"
+#include "rate_loop.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace ros2_controllers_test_nodes_cpp
+{
+class PublisherDiffDrive : public rclcpp::Node
+{
+public:
+  PublisherDiffDrive() : rclcpp::Node("publisher_diff_drive_controller")
+  {
+    declare_parameter("publish_topic", "/diff_drive_controller/cmd_vel");
+    declare_parameter("goal_names", std::vector<std::string>{"forward", "backward"});
+    declare_parameter("use_stamped_vel", true);
+    const auto publish_topic = get_parameter("publish_topic").as_string();
+    const auto goal_names = get_parameter("goal_names").as_string_array();
+
+    // the messages are complete before the first one is published, only the stamp is changed
+    for (const auto & name : goal_names)
+    {
+      const auto values = as_double_array(declare_untyped(*this, name));
+      if (values.size() != 2)
+      {
+        throw std::invalid_argument(
+          "Goal \"" + name + "\" needs two values, the linear and the angular velocity!");
+      }
+      geometry_msgs::msg::TwistStamped goal;
+      goal.twist.linear.x = values[0];
+      goal.twist.angular.z = values[1];
+      goals_.push_back(goal);
+    }
+    if (goals_.empty())
+    {
+      throw std::invalid_argument("No goal set!");
+    }
+
+    if (get_parameter("use_stamped_vel").as_bool())
+    {
+      stamped_publisher_ = create_publisher<geometry_msgs::msg::TwistStamped>(publish_topic, 1);
+    }
+    else
+    {
+      publisher_ = create_publisher<geometry_msgs::msg::Twist>(publish_topic, 1);
+    }
+    loop_ = std::make_unique<PublishingLoop>(*this, 5.0, [this]() { publish_next(); });
+    RCLCPP_INFO(
+      get_logger(), "Publishing %zu goals on topic '%s' every %f s", goals_.size(),
+      publish_topic.c_str(), loop_->period());
+    loop_->start();
+  }
+
+private:
+  void publish_next()
+  {
+    auto & goal = goals_[index_];
+    if (stamped_publisher_)
+    {
+      goal.header.stamp = now();
+      stamped_publisher_->publish(goal);
+    }
+    else
+    {
+      publisher_->publish(goal.twist);
+    }
+    index_ = (index_ + 1) % goals_.size();
+  }
+
+  std::vector<geometry_msgs::msg::TwistStamped> goals_;
+  size_t index_ = 0;
+  rclcpp::Publisher<geometry_msgs::msg::TwistStamped>::SharedPtr stamped_publisher_;
+  rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr publisher_;
+  // stopped first on destruction, it uses the members above
+  std::unique_ptr<PublishingLoop> loop_;
+};
+
+}  // namespace ros2_controllers_test_nodes_cpp
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<ros2_controllers_test_nodes_cpp::PublisherDiffDrive>());
+  rclcpp::shutdown();
+  return 0;
+}
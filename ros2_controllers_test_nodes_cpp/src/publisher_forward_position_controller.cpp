@@ -0,0 +1,89 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Publishes the goals of the parameters cyclically, with the parameters of the Python
+// publisher_forward_position_controller and those of PublishingLoop:
+//
+//   publisher_forward_position_controller:
+//     ros__parameters:
+//       publish_topic: /forward_position_controller/commands
+//       wait_sec_between_publish: 0.002
+//       goal_names: ["pos1", "pos2"]
+//       pos1: [0.785, 0.785, 0.785]
+//       pos2: [0.0, 0.0, 0.0]
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rate_loop.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
+
+namespace ros2_controllers_test_nodes_cpp
+{
+class PublisherForwardPosition : public rclcpp::Node
+{
+public:
+  PublisherForwardPosition() : rclcpp::Node("publisher_forward_position_controller")
+  {
+    declare_parameter("publish_topic", "/position_commands");
+    declare_parameter("goal_names", std::vector<std::string>{"pos1", "pos2"});
+    const auto publish_topic = get_parameter("publish_topic").as_string();
+    const auto goal_names = get_parameter("goal_names").as_string_array();
+
+    // the messages are complete before the first one is published
+    for (const auto & name : goal_names)
+    {
+      std_msgs::msg::Float64MultiArray goal;
+      goal.data = as_double_array(declare_untyped(*this, name));
+      if (goal.data.empty())
+      {
+        throw std::invalid_argument("Values for goal \"" + name + "\" not set!");
+      }
+      goals_.push_back(goal);
+    }
+
+    publisher_ = create_publisher<std_msgs::msg::Float64MultiArray>(publish_topic, 1);
+    loop_ = std::make_unique<PublishingLoop>(*this, 5.0, [this]() { publish_next(); });
+    RCLCPP_INFO(
+      get_logger(), "Publishing %zu goals on topic '%s' every %f s", goals_.size(),
+      publish_topic.c_str(), loop_->period());
+    loop_->start();
+  }
+
+private:
+  void publish_next()
+  {
+    publisher_->publish(goals_[index_]);
+    index_ = (index_ + 1) % goals_.size();
+  }
+
+  std::vector<std_msgs::msg::Float64MultiArray> goals_;
+  size_t index_ = 0;
+  rclcpp::Publisher<std_msgs::msg::Float64MultiArray>::SharedPtr publisher_;
+  // stopped first on destruction, it uses the members above
+  std::unique_ptr<PublishingLoop> loop_;
+};
+
+}  // namespace ros2_controllers_test_nodes_cpp
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<ros2_controllers_test_nodes_cpp::PublisherForwardPosition>());
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,215 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Publishes the goals of the parameters cyclically as trajectories of one point, with the
+// parameters of the Python publisher_joint_trajectory_controller and those of PublishingLoop:
+//
+//   publisher_joint_trajectory_controller:
+//     ros__parameters:
+//       controller_name: joint_trajectory_controller
+//       wait_sec_between_publish: 0.002
+//       goal_names: ["pos1", "pos2"]
+//       pos1:
+//         positions: [0.785, 0.785]
+//       pos2:
+//         positions: [0.0, 0.0]
+//         velocities: [0.1, 0.1]
+//       joints: [joint1, joint2]
+//       check_starting_point: false
+//       starting_point_limits:
+//         joint1: [-0.1, 0.1]
+//         joint2: [-0.1, 0.1]
+//       time_from_start: 4.0  # of the point
+//       stamp_messages: false
+//
+// If stamp_messages is set, the header is stamped with the time of publishing, and the trajectory
+// starts at that time instead of when it is received, so the stamp tells the latency.
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rate_loop.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace ros2_controllers_test_nodes_cpp
+{
+class PublisherJointTrajectory : public rclcpp::Node
+{
+public:
+  PublisherJointTrajectory() : rclcpp::Node("publisher_position_trajectory_controller")
+  {
+    declare_parameter("controller_name", "position_trajectory_controller");
+    declare_parameter("goal_names", std::vector<std::string>{"pos1", "pos2"});
+    declare_parameter("joints", std::vector<std::string>{});
+    declare_parameter("check_starting_point", false);
+    declare_parameter("stamp_messages", false);
+    const double time_from_start = declare_number(*this, "time_from_start", 4.0);
+    const auto controller_name = get_parameter("controller_name").as_string();
+    const auto goal_names = get_parameter("goal_names").as_string_array();
+    joints_ = get_parameter("joints").as_string_array();
+    stamp_messages_ = get_parameter("stamp_messages").as_bool();
+    if (joints_.empty())
+    {
+      throw std::invalid_argument("\"joints\" parameter is not set!");
+    }
+
+    if (get_parameter("check_starting_point").as_bool())
+    {
+      for (const auto & name : joints_)
+      {
+        declare_parameter(
+          "starting_point_limits." + name, std::vector<double>{-2 * 3.14159, 2 * 3.14159});
+        const auto limits = get_parameter("starting_point_limits." + name).as_double_array();
+        if (limits.size() != 2)
+        {
+          throw std::invalid_argument("\"starting_point\" parameter is not set correctly!");
+        }
+        starting_point_limits_[name] = {limits[0], limits[1]};
+      }
+      joint_state_subscriber_ = create_subscription<sensor_msgs::msg::JointState>(
+        "joint_states", 10,
+        [this](const std::shared_ptr<sensor_msgs::msg::JointState> msg)
+        { check_starting_point(*msg); });
+    }
+    else
+    {
+      starting_point_ok_ = true;
+    }
+
+    // the messages are complete before the first one is published, only the stamp is changed
+    for (const auto & name : goal_names)
+    {
+      trajectory_msgs::msg::JointTrajectory goal;
+      goal.joint_names = joints_;
+      trajectory_msgs::msg::JointTrajectoryPoint point;
+      bool one_ok = false;
+      const auto read_values = [&](const std::string & sub_param, std::vector<double> & values)
+      {
+        auto parameter_values = as_double_array(declare_untyped(*this, name + "." + sub_param));
+        if (parameter_values.size() == joints_.size())
+        {
+          values = std::move(parameter_values);
+          one_ok = true;
+        }
+      };
+      read_values("positions", point.positions);
+      read_values("velocities", point.velocities);
+      read_values("accelerations", point.accelerations);
+      read_values("effort", point.effort);
+      if (!one_ok)
+      {
+        RCLCPP_WARN(
+          get_logger(),
+          "Goal \"%s\" definition is wrong. This goal will not be used. Use the following "
+          "structure: \n<goal_name>:\n  positions: [joint1, joint2, joint3, ...]\n  "
+          "velocities: [v_joint1, v_joint2, ...]\n  accelerations: [a_joint1, a_joint2, ...]\n  "
+          "effort: [eff_joint1, eff_joint2, ...]",
+          name.c_str());
+        continue;
+      }
+      point.time_from_start = rclcpp::Duration::from_seconds(time_from_start);
+      goal.points.push_back(point);
+      goals_.push_back(goal);
+    }
+    if (goals_.empty())
+    {
+      throw std::invalid_argument("No valid goal found.");
+    }
+
+    const auto publish_topic = "/" + controller_name + "/joint_trajectory";
+    publisher_ = create_publisher<trajectory_msgs::msg::JointTrajectory>(publish_topic, 1);
+    loop_ = std::make_unique<PublishingLoop>(*this, 6.0, [this]() { publish_next(); });
+    RCLCPP_INFO(
+      get_logger(), "Publishing %zu goals on topic '%s' every %f s", goals_.size(),
+      publish_topic.c_str(), loop_->period());
+    loop_->start();
+  }
+
+private:
+  void publish_next()
+  {
+    if (!starting_point_ok_)
+    {
+      // checked on the first joint state
+      return;
+    }
+    auto & goal = goals_[index_];
+    if (stamp_messages_)
+    {
+      goal.header.stamp = now();
+    }
+    publisher_->publish(goal);
+    index_ = (index_ + 1) % goals_.size();
+  }
+
+  void check_starting_point(const sensor_msgs::msg::JointState & msg)
+  {
+    if (joint_state_received_)
+    {
+      return;
+    }
+    bool limit_exceeded = false;
+    for (size_t index = 0; index < msg.name.size() && index < msg.position.size(); ++index)
+    {
+      const auto limits = starting_point_limits_.find(msg.name[index]);
+      if (limits == starting_point_limits_.end())
+      {
+        continue;
+      }
+      if (
+        msg.position[index] < limits->second.first || msg.position[index] > limits->second.second)
+      {
+        RCLCPP_WARN(
+          get_logger(), "Starting point limits exceeded for joint %s !", msg.name[index].c_str());
+        limit_exceeded = true;
+      }
+    }
+    if (limit_exceeded)
+    {
+      RCLCPP_WARN(get_logger(), "Start configuration is not within configured limits!");
+    }
+    starting_point_ok_ = !limit_exceeded;
+    joint_state_received_ = true;
+  }
+
+  std::vector<std::string> joints_;
+  bool stamp_messages_ = false;
+  std::unordered_map<std::string, std::pair<double, double>> starting_point_limits_;
+  bool joint_state_received_ = false;
+  std::atomic<bool> starting_point_ok_{false};
+  std::vector<trajectory_msgs::msg::JointTrajectory> goals_;
+  size_t index_ = 0;
+  rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr joint_state_subscriber_;
+  rclcpp::Publisher<trajectory_msgs::msg::JointTrajectory>::SharedPtr publisher_;
+  // stopped first on destruction, it uses the members above
+  std::unique_ptr<PublishingLoop> loop_;
+};
+
+}  // namespace ros2_controllers_test_nodes_cpp
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<ros2_controllers_test_nodes_cpp::PublisherJointTrajectory>());
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,266 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RATE_LOOP_HPP_
+#define RATE_LOOP_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace ros2_controllers_test_nodes_cpp
+{
+/// Lateness of the ticks of a RateLoop since the last report
+struct RateLoopStatistics
+{
+  uint64_t ticks = 0;
+  // deadlines skipped because a tick was later than a whole period
+  uint64_t missed = 0;
+  // time from the deadline to the start of a tick
+  double mean_lateness_us = 0.0;
+  double max_lateness_us = 0.0;
+};
+
+/**
+ * \brief Thread calling a function at fixed absolute deadlines of the steady clock.
+ *
+ * The executor of rclcpp timers adds the latency of the other callbacks of the node, and the wait
+ * for the next period starts after the callback, so the rate drifts at hundreds of Hz. The thread
+ * of a RateLoop instead sleeps until the next deadline, start + n * period, and skips the
+ * deadlines it missed.
+ */
+class RateLoop
+{
+public:
+  RateLoop(std::chrono::nanoseconds period, std::function<void()> tick)
+  : period_(period), tick_(std::move(tick))
+  {
+    if (period_.count() <= 0)
+    {
+      throw std::invalid_argument("The period of a rate loop has to be positive.");
+    }
+  }
+
+  ~RateLoop() { stop(); }
+
+  /// Start the thread, with SCHED_FIFO at \p priority if it is positive
+  /**
+   * \return false if the priority couldn't be set, the loop runs anyway
+   */
+  bool start(int priority)
+  {
+    stop_ = false;
+    thread_ = std::thread(&RateLoop::run, this);
+    if (priority <= 0)
+    {
+      return true;
+    }
+#ifdef __linux__
+    sched_param param;
+    param.sched_priority = priority;
+    return pthread_setschedparam(thread_.native_handle(), SCHED_FIFO, &param) == 0;
+#else
+    return false;
+#endif
+  }
+
+  void stop()
+  {
+    stop_ = true;
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  /// Statistics of the ticks since the last call
+  RateLoopStatistics take_statistics()
+  {
+    std::lock_guard<std::mutex> guard(statistics_mutex_);
+    RateLoopStatistics statistics = statistics_;
+    if (statistics.ticks > 0)
+    {
+      statistics.mean_lateness_us = lateness_sum_us_ / static_cast<double>(statistics.ticks);
+    }
+    statistics_ = RateLoopStatistics();
+    lateness_sum_us_ = 0.0;
+    return statistics;
+  }
+
+private:
+  void run()
+  {
+    auto deadline = std::chrono::steady_clock::now() + period_;
+    while (!stop_)
+    {
+      std::this_thread::sleep_until(deadline);
+      const auto start = std::chrono::steady_clock::now();
+      tick_();
+
+      const double lateness_us =
+        std::chrono::duration<double, std::micro>(start - deadline).count();
+      uint64_t missed = 0;
+      deadline += period_;
+      // skip the deadlines which passed during the tick, instead of publishing a burst
+      const auto now = std::chrono::steady_clock::now();
+      if (deadline < now)
+      {
+        const auto skipped = (now - deadline) / period_ + 1;
+        deadline += skipped * period_;
+        missed = static_cast<uint64_t>(skipped);
+      }
+
+      std::lock_guard<std::mutex> guard(statistics_mutex_);
+      ++statistics_.ticks;
+      statistics_.missed += missed;
+      lateness_sum_us_ += lateness_us;
+      statistics_.max_lateness_us = std::max(statistics_.max_lateness_us, lateness_us);
+    }
+  }
+
+  const std::chrono::nanoseconds period_;
+  const std::function<void()> tick_;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+  std::mutex statistics_mutex_;
+  RateLoopStatistics statistics_;
+  double lateness_sum_us_ = 0.0;
+};
+
+/// Read a parameter given as integer or double, e.g., wait_sec_between_publish
+inline double get_number(const rclcpp::Node & node, const std::string & name)
+{
+  const auto parameter = node.get_parameter(name);
+  if (parameter.get_type() == rclcpp::ParameterType::PARAMETER_INTEGER)
+  {
+    return static_cast<double>(parameter.as_int());
+  }
+  return parameter.as_double();
+}
+
+/// Declare a number parameter, which may be given as integer or double like in rclpy
+inline double declare_number(rclcpp::Node & node, const std::string & name, double default_value)
+{
+  rcl_interfaces::msg::ParameterDescriptor descriptor;
+  descriptor.dynamic_typing = true;
+  node.declare_parameter(name, rclcpp::ParameterValue(default_value), descriptor);
+  return get_number(node, name);
+}
+
+/// Declare a parameter of any type without a default, as rclpy does without a default
+inline rclcpp::Parameter declare_untyped(rclcpp::Node & node, const std::string & name)
+{
+  rcl_interfaces::msg::ParameterDescriptor descriptor;
+  descriptor.dynamic_typing = true;
+  node.declare_parameter(name, rclcpp::ParameterValue(), descriptor);
+  return node.get_parameter(name);
+}
+
+/// Values of an integer or double array parameter, empty if it isn't set
+inline std::vector<double> as_double_array(const rclcpp::Parameter & parameter)
+{
+  switch (parameter.get_type())
+  {
+    case rclcpp::ParameterType::PARAMETER_DOUBLE_ARRAY:
+      return parameter.as_double_array();
+    case rclcpp::ParameterType::PARAMETER_INTEGER_ARRAY:
+    {
+      const auto values = parameter.as_integer_array();
+      return std::vector<double>(values.begin(), values.end());
+    }
+    case rclcpp::ParameterType::PARAMETER_NOT_SET:
+      return {};
+    default:
+      throw std::invalid_argument(
+        "Parameter '" + parameter.get_name() + "' is not a number array.");
+  }
+}
+
+/**
+ * \brief A RateLoop with the parameters shared by the C++ publisher nodes.
+ *
+ * - wait_sec_between_publish: period of the messages, as for the Python nodes, e.g., 0.002
+ * - thread_priority: SCHED_FIFO priority of the publishing thread, unchanged if 0
+ * - report_period: seconds between the logs of the timing, not logged if 0
+ */
+class PublishingLoop
+{
+public:
+  PublishingLoop(rclcpp::Node & node, double default_wait_sec, std::function<void()> tick)
+  : node_(node)
+  {
+    period_ = declare_number(node, "wait_sec_between_publish", default_wait_sec);
+    node.declare_parameter("thread_priority", 0);
+    report_period_ = declare_number(node, "report_period", 5.0);
+    loop_ = std::make_unique<RateLoop>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(period_)),
+      std::move(tick));
+  }
+
+  double period() const { return period_; }
+
+  void start()
+  {
+    const auto priority = static_cast<int>(node_.get_parameter("thread_priority").as_int());
+    if (!loop_->start(priority))
+    {
+      RCLCPP_WARN(
+        node_.get_logger(), "Could not set the priority %d of the publishing thread.", priority);
+    }
+    if (report_period_ > 0.0)
+    {
+      report_timer_ = node_.create_wall_timer(
+        std::chrono::duration<double>(report_period_), [this]() { report(); });
+    }
+  }
+
+private:
+  void report()
+  {
+    const auto statistics = loop_->take_statistics();
+    RCLCPP_INFO(
+      node_.get_logger(),
+      "Published %" PRIu64 " messages, %" PRIu64
+      " deadlines missed, lateness mean %.1f us, max %.1f us",
+      statistics.ticks, statistics.missed, statistics.mean_lateness_us,
+      statistics.max_lateness_us);
+  }
+
+  rclcpp::Node & node_;
+  double period_ = 0.0;
+  double report_period_ = 0.0;
+  std::unique_ptr<RateLoop> loop_;
+  rclcpp::TimerBase::SharedPtr report_timer_;
+};
+
+}  // namespace ros2_controllers_test_nodes_cpp
+
+#endif  // RATE_LOOP_HPP_
@@ -23,102 +23,157 @@
 # upper is an optional attribute, so I don't understand what's going on
 # See comments in https://github.com/ros/urdfdom/issues/36
 
-import xml.dom.minidom
+import hashlib
+import io
+import xml.etree.ElementTree as ElementTree
 from math import pi
 
 import rclpy
 from std_msgs.msg import String
 
 description = ""
+# Hash of the last received description, the key of the cached joint limits
+description_hash = None
+# Joint limits by (description hash, use_smallest_joint_limits) of the last descriptions
+_joint_limits_cache = {}
+_MAX_CACHED_DESCRIPTIONS = 4
+# Called in the executor thread when another description is received
+_description_listeners = []
 
 
 def callback(msg):
-    global description
+    global description, description_hash
+    new_hash = hashlib.sha1(msg.data.encode("utf-8")).hexdigest()
+    if new_hash == description_hash:
+        return
     description = msg.data
+    description_hash = new_hash
+    for listener in _description_listeners:
+        listener()
 
 
-def subscribe_to_robot_description(node, key="robot_description"):
+def subscribe_to_robot_description(node, key="robot_description", on_change=None):
+    """Subscribe to the robot description, calling on_change when another one is received."""
     qos_profile = rclpy.qos.QoSProfile(depth=1)
     qos_profile.durability = rclpy.qos.DurabilityPolicy.TRANSIENT_LOCAL
     qos_profile.reliability = rclpy.qos.ReliabilityPolicy.RELIABLE
 
+    if on_change is not None:
+        _description_listeners.append(on_change)
     node.create_subscription(String, key, callback, qos_profile)
 
 
+def remove_robot_description_listener(on_change):
+    if on_change in _description_listeners:
+        _description_listeners.remove(on_change)
+
+
 def get_joint_limits(node, use_smallest_joint_limits=True):
-    global description
+    """
+    Return the limits of the free joints of the robot description, empty until it is received.
+
+    The description is parsed once, the limits are cached by its hash.
+    """
+    if description == "":
+        return {}
+    key = (description_hash, use_smallest_joint_limits)
+    if key not in _joint_limits_cache:
+        while len(_joint_limits_cache) >= 2 * _MAX_CACHED_DESCRIPTIONS:
+            del _joint_limits_cache[next(iter(_joint_limits_cache))]
+        _joint_limits_cache[key] = parse_joint_limits(description, use_smallest_joint_limits)
+    return _joint_limits_cache[key]
+
+
+def _local_name(tag):
+    # drops the namespace of '{namespace}joint'
+    return tag.rsplit("}", 1)[-1]
+
+
+def _find_all(element, name):
+    # all descendants with the local name, like getElementsByTagName of xml.dom.minidom
+    return [child for child in element.iter() if _local_name(child.tag) == name]
+
+
+def parse_joint_limits(urdf, use_smallest_joint_limits=True):
+    """
+    Parse the limits of the free joints of a URDF.
+
+    The URDF is read with a streaming parser, which only keeps the top-level element being read,
+    so the links with their meshes and metadata are discarded as soon as they are read.
+    """
     use_small = use_smallest_joint_limits
     use_mimic = True
 
-    count = 0
-    while description == "" and count < 10:
-        print("Waiting for the robot_description!")
-        count += 1
-        rclpy.spin_once(node, timeout_sec=1.0)
-
     free_joints = {}
     dependent_joints = {}
 
-    if description != "":
-        robot = xml.dom.minidom.parseString(description).getElementsByTagName("robot")[0]
-
+    depth = 0
+    source = io.BytesIO(urdf.encode("utf-8"))
+    for event, element in ElementTree.iterparse(source, events=("start", "end")):
+        if event == "start":
+            depth += 1
+            continue
+        depth -= 1
+        if depth > 1:
+            # part of a top-level element, read when it ends
+            continue
         # Find all non-fixed joints
-        for child in robot.childNodes:
-            if child.nodeType is child.TEXT_NODE:
-                continue
-            if child.localName == "joint":
-                jtype = child.getAttribute("type")
-                if jtype == "fixed":
-                    continue
-                name = child.getAttribute("name")
-                try:
-                    limit = child.getElementsByTagName("limit")[0]
-                    try:
-                        minval = float(limit.getAttribute("lower"))
-                        maxval = float(limit.getAttribute("upper"))
-                    except ValueError:
-                        if jtype == "continuous":
-                            minval = -pi
-                            maxval = pi
-                        else:
-                            raise Exception(
-                                f"Missing lower/upper position limits for the joint : {name} of type : {jtype} in the robot_description!"
-                            )
-                    try:
-                        maxvel = float(limit.getAttribute("velocity"))
-                    except ValueError:
-                        raise Exception(
-                            f"Missing velocity limits for the joint : {name} of type : {jtype} in the robot_description!"
-                        )
-                except IndexError:
-                    raise Exception(
-                        f"Missing limits tag for the joint : {name} in the robot_description!"
-                    )
-                safety_tags = child.getElementsByTagName("safety_controller")
-                if use_small and len(safety_tags) == 1:
-                    tag = safety_tags[0]
-                    if tag.hasAttribute("soft_lower_limit"):
-                        minval = max(minval, float(tag.getAttribute("soft_lower_limit")))
-                    if tag.hasAttribute("soft_upper_limit"):
-                        maxval = min(maxval, float(tag.getAttribute("soft_upper_limit")))
-
-                mimic_tags = child.getElementsByTagName("mimic")
-                if use_mimic and len(mimic_tags) == 1:
-                    tag = mimic_tags[0]
-                    entry = {"parent": tag.getAttribute("joint")}
-                    if tag.hasAttribute("multiplier"):
-                        entry["factor"] = float(tag.getAttribute("multiplier"))
-                    if tag.hasAttribute("offset"):
-                        entry["offset"] = float(tag.getAttribute("offset"))
-
-                    dependent_joints[name] = entry
-                    continue
-
-                if name in dependent_joints:
-                    continue
-
-                joint = {"min_position": minval, "max_position": maxval}
-                joint["has_position_limits"] = jtype != "continuous"
-                joint["max_velocity"] = maxvel
-                free_joints[name] = joint
+        if depth == 1 and _local_name(element.tag) == "joint":
+            _add_joint(element, use_small, use_mimic, free_joints, dependent_joints)
+        element.clear()
     return free_joints
+
+
+def _add_joint(child, use_small, use_mimic, free_joints, dependent_joints):
+    jtype = child.get("type", "")
+    if jtype == "fixed":
+        return
+    name = child.get("name", "")
+    try:
+        limit = _find_all(child, "limit")[0]
+        try:
+            minval = float(limit.get("lower", ""))
+            maxval = float(limit.get("upper", ""))
+        except ValueError:
+            if jtype == "continuous":
+                minval = -pi
+                maxval = pi
+            else:
+                raise Exception(
+                    f"Missing lower/upper position limits for the joint : {name} of type : {jtype} in the robot_description!"
+                )
+        try:
+            maxvel = float(limit.get("velocity", ""))
+        except ValueError:
+            raise Exception(
+                f"Missing velocity limits for the joint : {name} of type : {jtype} in the robot_description!"
+            )
+    except IndexError:
+        raise Exception(f"Missing limits tag for the joint : {name} in the robot_description!")
+    safety_tags = _find_all(child, "safety_controller")
+    if use_small and len(safety_tags) == 1:
+        tag = safety_tags[0]
+        if "soft_lower_limit" in tag.attrib:
+            minval = max(minval, float(tag.get("soft_lower_limit")))
+        if "soft_upper_limit" in tag.attrib:
+            maxval = min(maxval, float(tag.get("soft_upper_limit")))
+
+    mimic_tags = _find_all(child, "mimic")
+    if use_mimic and len(mimic_tags) == 1:
+        tag = mimic_tags[0]
+        entry = {"parent": tag.get("joint", "")}
+        if "multiplier" in tag.attrib:
+            entry["factor"] = float(tag.get("multiplier"))
+        if "offset" in tag.attrib:
+            entry["offset"] = float(tag.get("offset"))
+
+        dependent_joints[name] = entry
+        return
+
+    if name in dependent_joints:
+        return
+
+    joint = {"min_position": minval, "max_position": maxval}
+    joint["has_position_limits"] = jtype != "continuous"
+    joint["max_velocity"] = maxvel
+    free_joints[name] = joint
@@ -17,7 +17,9 @@
 import os
 import rclpy
 import threading
+import time
 from ament_index_python.packages import get_package_share_directory
+from rclpy.serialization import deserialize_message
 
 from qt_gui.plugin import Plugin
 from python_qt_binding import loadUi
@@ -29,7 +31,11 @@ from trajectory_msgs.msg import JointTrajectory, JointTrajectoryPoint
 
 from .utils import ControllerLister, ControllerManagerLister
 from .double_editor import DoubleEditor
-from .joint_limits_urdf import get_joint_limits, subscribe_to_robot_description
+from .joint_limits_urdf import (
+    get_joint_limits,
+    remove_robot_description_listener,
+    subscribe_to_robot_description,
+)
 from .update_combo import update_combo
 
 # TODO:
@@ -93,16 +99,17 @@ class JointTrajectoryController(Plugin):
     _cmd_pub_freq = 10.0  # Hz
     _widget_update_freq = 30.0  # Hz
     _ctrlrs_update_freq = 1  # Hz
+    _ctrlrs_refresh_period = 10.0  # s, for controller state changes not visible in the graph
     _min_traj_dur = 5.0 / _cmd_pub_freq  # Minimum trajectory duration
 
     jointStateChanged = Signal([dict])
+    controllersChanged = Signal(object, list)
+    robotDescriptionChanged = Signal()
 
     def __init__(self, context):
         super().__init__(context)
         self.setObjectName("JointTrajectoryController")
         self._node = rclpy.node.Node("rqt_joint_trajectory_controller")
-        self._executor = None
-        self._executor_thread = None
 
         # Create QWidget and extend it with all the attributes and children
         # from the UI file
@@ -145,9 +152,15 @@ class JointTrajectoryController(Plugin):
         self._cm_ns = []  # Namespace of the selected controller manager
         self._joint_pos = {}  # name->pos map for joints of selected controller
         self._joint_names = []  # Ordered list of selected controller joints
-        self._robot_joint_limits = {}  # Lazily evaluated on first use
-
-        # Timer for sending commands to active controller
+        self._robot_joint_limits = {}  # Cached by joint_limits_urdf, read again on changes
+        self._controllers = []  # Controllers of the selected controller manager
+        self._ctrlrs_graph = None  # ROS graph of the last controller list request
+        self._ctrlrs_request_time = 0.0  # Monotonic time of the last controller list request
+        self._restored_jtc_name = None  # Controller to select once it is listed
+        self._cmd_changed = False  # Whether a joint command changed since the last publish
+
+        # Timer for sending commands to active controller, coalescing the changes of the
+        # commands between two timeouts into one trajectory, see _update_cmd_cb
         self._update_cmd_timer = QTimer(self)
         self._update_cmd_timer.setInterval(int(1000.0 / self._cmd_pub_freq))
         self._update_cmd_timer.timeout.connect(self._update_cmd_cb)
@@ -157,33 +170,45 @@ class JointTrajectoryController(Plugin):
         self._update_act_pos_timer.setInterval(int(1000.0 / self._widget_update_freq))
         self._update_act_pos_timer.timeout.connect(self._update_joint_widgets)
 
-        # Timer for controller manager updates
-        self._list_cm = ControllerManagerLister()
+        # Timer for controller manager updates, only querying the local ROS graph
+        self._list_cm = ControllerManagerLister(node=self._node)
         self._update_cm_list_timer = QTimer(self)
         self._update_cm_list_timer.setInterval(int(1000.0 / self._ctrlrs_update_freq))
         self._update_cm_list_timer.timeout.connect(self._update_cm_list)
         self._update_cm_list_timer.start()
 
-        # Timer for running controller updates
+        # Timer for running controller updates, requesting the controller list asynchronously
+        # only after the ROS graph changed, see _update_jtc_list
         self._update_jtc_list_timer = QTimer(self)
         self._update_jtc_list_timer.setInterval(int(1000.0 / self._ctrlrs_update_freq))
         self._update_jtc_list_timer.timeout.connect(self._update_jtc_list)
         self._update_jtc_list_timer.start()
 
         # subscriptions
-        subscribe_to_robot_description(self._node)
+        # the callback runs in the executor thread, the signal hands it over to the Qt thread
+        self._on_robot_description = lambda: self.robotDescriptionChanged.emit()
+        subscribe_to_robot_description(self._node, on_change=self._on_robot_description)
 
         # Signal connections
         w = self._widget
         w.enable_button.toggled.connect(self._on_jtc_enabled)
         w.jtc_combo.currentIndexChanged[str].connect(self._on_jtc_change)
         w.cm_combo.currentIndexChanged[str].connect(self._on_cm_change)
+        self.controllersChanged.connect(self._on_controllers_changed)
+        self.robotDescriptionChanged.connect(self._update_valid_jtc)
 
         self._cmd_pub = None  # Controller command publisher
         self._state_sub = None  # Controller state subscriber
+        self._last_state_time = 0.0  # Monotonic time of the last processed state
 
         self._list_controllers = None
 
+        # The node is spun in the background for the controller list responses and the state
+        self._executor = rclpy.executors.SingleThreadedExecutor()
+        self._executor.add_node(self._node)
+        self._executor_thread = threading.Thread(target=self._executor.spin, daemon=True)
+        self._executor_thread.start()
+
     def shutdown_plugin(self):
         self._update_cmd_timer.stop()
         self._update_act_pos_timer.stop()
@@ -192,6 +217,7 @@ class JointTrajectoryController(Plugin):
         self._unregister_state_sub()
         self._unregister_cmd_pub()
         self._unregister_executor()
+        remove_robot_description_listener(self._on_robot_description)
 
     def save_settings(self, plugin_settings, instance_settings):
         instance_settings.set_value("cm_ns", self._cm_ns)
@@ -206,16 +232,9 @@ class JointTrajectoryController(Plugin):
         try:
             idx = cm_list.index(cm_ns)
             cm_combo.setCurrentIndex(idx)
-            # Restore last session's controller, if running
+            # Restore last session's controller once it is listed, if running
+            self._restored_jtc_name = instance_settings.value("jtc_name")
             self._update_jtc_list()
-            jtc_name = instance_settings.value("jtc_name")
-            jtc_combo = self._widget.jtc_combo
-            jtc_list = [jtc_combo.itemText(i) for i in range(jtc_combo.count())]
-            try:
-                idx = jtc_list.index(jtc_name)
-                jtc_combo.setCurrentIndex(idx)
-            except (ValueError):
-                pass
         except (ValueError):
             pass
 
@@ -234,11 +253,36 @@ class JointTrajectoryController(Plugin):
             self._widget.jtc_combo.clear()
             return
 
+        # Loading or unloading controllers changes the locally cached ROS graph, so the list is
+        # only requested then, and every _ctrlrs_refresh_period for (de)activated controllers
+        graph = sorted(self._node.get_node_names_and_namespaces())
+        now = time.monotonic()
+        if (
+            graph == self._ctrlrs_graph
+            and now - self._ctrlrs_request_time < self._ctrlrs_refresh_period
+        ):
+            return
+        list_controllers = self._list_controllers
+        if list_controllers.call_async(
+            lambda controllers: self.controllersChanged.emit(list_controllers, controllers)
+        ):
+            self._ctrlrs_graph = graph
+            self._ctrlrs_request_time = now
+
+    def _on_controllers_changed(self, list_controllers, controllers):
+        # Ignore responses of a previously selected controller manager, and unchanged lists
+        if list_controllers is not self._list_controllers or controllers == self._controllers:
+            return
+        self._controllers = controllers
+        self._update_valid_jtc()
+
+    def _update_valid_jtc(self):
         # List of running controllers with a valid joint limits specification
         # for _all_ their joints
         running_jtc = self._running_jtc_info()
-        if running_jtc and not self._robot_joint_limits:
-            self._robot_joint_limits = get_joint_limits(self._node)  # Lazy evaluation
+        if running_jtc:
+            # parsed once per robot description
+            self._robot_joint_limits = get_joint_limits(self._node)
         valid_jtc = []
         if self._robot_joint_limits:
             for jtc_info in running_jtc:
@@ -250,7 +294,11 @@ class JointTrajectoryController(Plugin):
         valid_jtc_names = [data.name for data in valid_jtc]
 
         # Update widget
-        update_combo(self._widget.jtc_combo, sorted(valid_jtc_names))
+        jtc_combo = self._widget.jtc_combo
+        update_combo(jtc_combo, sorted(valid_jtc_names))
+        if self._restored_jtc_name in valid_jtc_names:
+            jtc_combo.setCurrentIndex(jtc_combo.findText(self._restored_jtc_name))
+            self._restored_jtc_name = None
 
     def _on_speed_scaling_change(self, val):
         self._speed_scale = val / self._speed_scaling_widget.slider.maximum()
@@ -262,8 +310,12 @@ class JointTrajectoryController(Plugin):
 
     def _on_cm_change(self, cm_ns):
         self._cm_ns = cm_ns
+        if self._list_controllers:
+            self._list_controllers.destroy()
+        self._controllers = []
+        self._ctrlrs_graph = None
         if cm_ns:
-            self._list_controllers = ControllerLister(cm_ns)
+            self._list_controllers = ControllerLister(cm_ns, self._node)
             # NOTE: Clear below is important, as different controller managers
             # might have controllers with the same name but different
             # configurations. Clearing forces controller re-discovery
@@ -292,8 +344,10 @@ class JointTrajectoryController(Plugin):
         self._speed_scaling_widget.setEnabled(val)
 
         if val:
-            # Widgets send reference position commands to controller
+            # Widgets send reference position commands to controller. The commands follow the
+            # feedback positions until then, so nothing is sent before a widget is changed
             self._update_act_pos_timer.stop()
+            self._cmd_changed = False
             self._update_cmd_timer.start()
         else:
             # Controller updates widgets with feedback position
@@ -337,18 +391,16 @@ class JointTrajectoryController(Plugin):
         jtc_ns = _resolve_controller_ns(self._cm_ns, self._jtc_name)
         state_topic = jtc_ns + "/controller_state"
         cmd_topic = jtc_ns + "/joint_trajectory"
+        # The state is published with the controller rate, so it is received serialized and only
+        # the states drawn by the widgets are deserialized, see _state_cb
+        self._last_state_time = 0.0
         self._state_sub = self._node.create_subscription(
-            JointTrajectoryControllerState, state_topic, self._state_cb, 1
+            JointTrajectoryControllerState, state_topic, self._state_cb, 1, raw=True
         )
         self._cmd_pub = self._node.create_publisher(JointTrajectory, cmd_topic, 1)
 
         self.jointStateChanged.connect(self._on_joint_state_change)
 
-        self._executor = rclpy.executors.SingleThreadedExecutor()
-        self._executor.add_node(self._node)
-        self._executor_thread = threading.Thread(target=self._executor.spin, daemon=True)
-        self._executor_thread.start()
-
     def _unload_jtc(self):
         # Stop updating the joint positions
         try:
@@ -359,7 +411,6 @@ class JointTrajectoryController(Plugin):
         # Reset ROS interfaces
         self._unregister_state_sub()
         self._unregister_cmd_pub()
-        self._unregister_executor()
 
         # Clear joint widgets
         # NOTE: Implementation is a workaround for:
@@ -383,9 +434,8 @@ class JointTrajectoryController(Plugin):
     def _running_jtc_info(self):
         from .utils import filter_by_type, filter_by_state
 
-        controller_list = self._list_controllers()
         jtc_list = filter_by_type(
-            controller_list, "JointTrajectoryController", match_substring=True
+            self._controllers, "JointTrajectoryController", match_substring=True
         )
         running_jtc_list = filter_by_state(jtc_list, "active")
         return running_jtc_list
@@ -406,7 +456,14 @@ class JointTrajectoryController(Plugin):
             self._executor_thread.join()
             self._executor = None
 
-    def _state_cb(self, msg):
+    def _state_cb(self, serialized_msg):
+        # Drop the states received faster than the widgets are updated
+        now = time.monotonic()
+        if now - self._last_state_time < 1.0 / self._widget_update_freq:
+            return
+        self._last_state_time = now
+
+        msg = deserialize_message(serialized_msg, JointTrajectoryControllerState)
         current_pos = {}
         for i in range(len(msg.joint_names)):
             joint_name = msg.joint_names[i]
@@ -416,8 +473,15 @@ class JointTrajectoryController(Plugin):
 
     def _update_single_cmd_cb(self, val, name):
         self._joint_pos[name]["command"] = val
+        self._cmd_changed = True
 
     def _update_cmd_cb(self):
+        # Only send a trajectory if the commands changed, each one replaces the trajectory of
+        # the controller, which reaches the last one sent anyway
+        if not self._cmd_changed:
+            return
+        self._cmd_changed = False
+
         dur = []
         traj = JointTrajectory()
         traj.joint_names = self._joint_names
@@ -47,7 +47,7 @@ cm_services = {
 }
 
 
-def get_controller_managers(namespace="/", initial_guess=None):
+def get_controller_managers(namespace="/", initial_guess=None, node=None):
     """
     Get list of active controller manager namespaces.
 
@@ -62,6 +62,9 @@ def get_controller_managers(namespace="/", initial_guess=None):
     significantly reduce the number of ROS master queries incurred by this
     method.
     @type initial_guess: [str]
+    @param node: Node whose ROS graph is queried. If None, a node is created for the query,
+    which is expensive when called periodically.
+    @type node: rclpy.node.Node
     @return: Sorted list of active controller manager namespaces.
     @rtype: [str]
     """
@@ -70,7 +73,8 @@ def get_controller_managers(namespace="/", initial_guess=None):
         ns_list = initial_guess[:]  # force copy
 
     # Get list of (potential) currently running controller managers
-    node = rclpy.node.Node("get_controller_managers_node")
+    if node is None:
+        node = rclpy.node.Node("get_controller_managers_node")
     ns_list_curr = _sloppy_get_controller_managers(node, namespace)
 
     # Update initial guess:
@@ -176,13 +180,21 @@ class ControllerManagerLister:
         >>> print(list_cm())
     """
 
-    def __init__(self, namespace="/"):
+    def __init__(self, namespace="/", node=None):
+        """
+        @param namespace Namespace where to look for controller managers.
+        @param node Node whose ROS graph is queried, see get_controller_managers.
+
+        @type namespace str
+        @type node rclpy.node.Node
+        """
         self._ns = namespace
+        self._node = node
         self._cm_list = []
 
     def __call__(self):
         """Get list of running controller managers."""
-        self._cm_list = get_controller_managers(self._ns, self._cm_list)
+        self._cm_list = get_controller_managers(self._ns, self._cm_list, self._node)
         return self._cm_list
 
 
@@ -198,17 +210,25 @@ class ControllerLister:
         >>> all_ctrl = list_controllers()
         >>> running_ctrl = filter_by_state(all_ctrl, 'running')
         >>> running_bar_ctrl = filter_by_type(running_ctrl, 'bar_base/bar')
+
+    Example usage without blocking, if C{node} is spun by an executor:
+        >>> list_controllers = ControllerLister('foo_robot/controller_manager', node)
+        >>> list_controllers.call_async(lambda all_ctrl: print(all_ctrl))
     """
 
-    def __init__(self, namespace="/controller_manager"):
+    def __init__(self, namespace="/controller_manager", node=None):
         """
         @param namespace Namespace of controller manager to monitor.
+        @param node Node for the service client. If None, a node is created, which is spun
+        by calling this functor.
 
         @type namespace str
+        @type node rclpy.node.Node
         """
-        self._node = rclpy.node.Node("controller_lister")
+        self._node = node if node is not None else rclpy.node.Node("controller_lister")
         self._srv_name = namespace + "/" + _LIST_CONTROLLERS_STR
         self._srv_client = self._create_client()
+        self._future = None
 
     """
     @return: Controller list.
@@ -220,6 +240,32 @@ class ControllerLister:
         rclpy.spin_until_future_complete(self._node, controller_list)
         return controller_list.result().controller
 
+    def call_async(self, callback):
+        """
+        Request the controller list without blocking.
+
+        @param callback: Called with the controller list by the executor spinning the node.
+        @type callback: callable([controller_manager_msgs/ControllerState])
+        @return: False if the previous request is pending or the service is not available.
+        @rtype: bool
+        """
+        if self._future is not None and not self._future.done():
+            return False
+        if not self._srv_client.service_is_ready():
+            return False
+
+        def _done(future):
+            if future.result() is not None:
+                callback(future.result().controller)
+
+        self._future = self._srv_client.call_async(ListControllers.Request())
+        self._future.add_done_callback(_done)
+        return True
+
+    def destroy(self):
+        """Destroy the service client, pending requests are not answered anymore."""
+        self._node.destroy_client(self._srv_client)
+
     def _create_client(self):
         return self._node.create_client(ListControllers, self._srv_name)
 
@@ -0,0 +1,61 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RT_SAFETY_CHECKS__RT_SAFETY_CHECKER_HPP_
+#define RT_SAFETY_CHECKS__RT_SAFETY_CHECKER_HPP_
+
+#include <cstddef>
+
+namespace rt_safety_checks
+{
+/**
+ * \brief Counts the heap allocations, deallocations and mutex locks of the current thread within
+ * its scope.
+ *
+ * Linking the rt_safety_checks library into a test interposes malloc(), calloc(), realloc(),
+ * aligned_alloc(), posix_memalign(), free() and pthread_mutex_lock(), so the calls of all
+ * libraries are counted, e.g., of operator new or std::mutex::lock(). pthread_mutex_trylock() is
+ * not counted, because it never blocks. Only the thread which created the checker is tracked, so
+ * the threads of executors and publishers don't interfere.
+ *
+ * Example, checking the steady-state update cycles of a controller:
+ * \code
+ * rt_safety_checks::RtSafetyChecker checker;
+ * for (int i = 0; i < 100; ++i) { controller_->update(time, period); }
+ * checker.stop();
+ * EXPECT_EQ(checker.allocations(), 0u);
+ * EXPECT_EQ(checker.mutex_locks(), 0u);
+ * \endcode
+ */
+class RtSafetyChecker
+{
+public:
+  /// Start counting on the current thread, checkers of the same thread must not be nested
+  RtSafetyChecker();
+  ~RtSafetyChecker();
+
+  RtSafetyChecker(const RtSafetyChecker &) = delete;
+  RtSafetyChecker & operator=(const RtSafetyChecker &) = delete;
+
+  /// Stop counting, the counts are kept for the accessors
+  void stop();
+
+  size_t allocations() const;
+  size_t deallocations() const;
+  size_t mutex_locks() const;
+};
+
+}  // namespace rt_safety_checks
+
+#endif  // RT_SAFETY_CHECKS__RT_SAFETY_CHECKER_HPP_
@@ -0,0 +1,121 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RT_SAFETY_CHECKS__UPDATE_TIME_BOUND_HPP_
+#define RT_SAFETY_CHECKS__UPDATE_TIME_BOUND_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace rt_safety_checks
+{
+/// Durations of the cycles measured by measure_update_times()
+struct UpdateTimes
+{
+  std::chrono::nanoseconds median{0};
+  std::chrono::nanoseconds max{0};
+};
+
+/**
+ * \brief Measure the durations of \p num_cycles calls of \p update, e.g., of the update of a
+ * controller in one cycle of a mock control loop each.
+ *
+ * \param update called with the index of the cycle
+ */
+template <typename Update>
+UpdateTimes measure_update_times(const size_t num_cycles, Update && update)
+{
+  // allocated before the first cycle, so it is not measured
+  std::vector<std::chrono::nanoseconds> durations(num_cycles);
+  for (size_t i = 0; i < num_cycles; ++i)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    update(i);
+    durations[i] = std::chrono::steady_clock::now() - start;
+  }
+
+  UpdateTimes times;
+  if (num_cycles == 0)
+  {
+    return times;
+  }
+  times.max = *std::max_element(durations.begin(), durations.end());
+  const auto median = durations.begin() + static_cast<std::ptrdiff_t>(num_cycles / 2);
+  std::nth_element(durations.begin(), median, durations.end());
+  times.median = *median;
+  return times;
+}
+
+/**
+ * \brief Upper bound of the duration of a cycle, relative to a baseline calibrated on the same
+ * machine.
+ *
+ * The baseline is the median duration of cycles with nominal inputs, e.g., a short trajectory,
+ * so the bound scales with the speed of the machine and of the build type, e.g., with sanitizers.
+ * Cycles with adversarial inputs have to stay within ratio * baseline + slack in the worst case.
+ * The slack absorbs the scheduling jitter of the test process, which usually doesn't run with a
+ * realtime priority.
+ *
+ * Example, bounding the updates of a controller taking over a large trajectory:
+ * \code
+ * rt_safety_checks::UpdateTimeBound bound(10.0, std::chrono::microseconds(500));
+ * bound.calibrate(100, [&](size_t) { controller_->update(time += period, period); });
+ * // publish the large trajectory ...
+ * const auto times =
+ *   rt_safety_checks::measure_update_times(100, [&](size_t) { controller_->update(...); });
+ * EXPECT_LE(times.max.count(), bound.get_bound().count());
+ * \endcode
+ */
+class UpdateTimeBound
+{
+public:
+  /**
+   * \param ratio of the bound to the baseline, e.g., the ratio of the sizes of the adversarial and
+   * the nominal inputs for updates scaling linearly with them
+   * \param slack added to the bound
+   */
+  UpdateTimeBound(const double ratio, const std::chrono::nanoseconds slack)
+  : ratio_(ratio), slack_(slack)
+  {
+  }
+
+  /// Set the baseline to the median duration of \p num_cycles calls of \p update
+  template <typename Update>
+  void calibrate(const size_t num_cycles, Update && update)
+  {
+    baseline_ = measure_update_times(num_cycles, update).median;
+  }
+
+  std::chrono::nanoseconds get_baseline() const { return baseline_; }
+
+  /// ratio * baseline + slack
+  std::chrono::nanoseconds get_bound() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(ratio_ * baseline_) + slack_;
+  }
+
+  /// Whether all cycles of \p times stayed within the bound
+  bool holds(const UpdateTimes & times) const { return times.max <= get_bound(); }
+
+private:
+  double ratio_;
+  std::chrono::nanoseconds slack_;
+  std::chrono::nanoseconds baseline_{0};
+};
+
+}  // namespace rt_safety_checks
+
+#endif  // RT_SAFETY_CHECKS__UPDATE_TIME_BOUND_HPP_
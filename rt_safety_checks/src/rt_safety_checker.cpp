@@ -0,0 +1,134 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rt_safety_checks/rt_safety_checker.hpp"
+
+#include <dlfcn.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+
+// glibc exports its allocator under these names, so the interposers don't need dlsym(), which may
+// allocate itself
+extern "C"
+{
+  void * __libc_malloc(size_t size);
+  void * __libc_calloc(size_t num, size_t size);
+  void * __libc_realloc(void * ptr, size_t size);
+  void * __libc_memalign(size_t alignment, size_t size);
+  void __libc_free(void * ptr);
+}
+
+namespace
+{
+// trivially initialized, so accessing them doesn't allocate or call TLS wrappers
+thread_local bool tracking = false;
+thread_local size_t num_allocations = 0;
+thread_local size_t num_deallocations = 0;
+thread_local size_t num_mutex_locks = 0;
+
+using MutexLockFunction = int (*)(pthread_mutex_t *);
+std::atomic<MutexLockFunction> next_mutex_lock{nullptr};
+
+int call_next_mutex_lock(pthread_mutex_t * mutex)
+{
+  MutexLockFunction function = next_mutex_lock.load(std::memory_order_acquire);
+  if (function == nullptr)
+  {
+    // not a function-local static, as its guard may lock a mutex
+    function = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    next_mutex_lock.store(function, std::memory_order_release);
+  }
+  return function(mutex);
+}
+}  // namespace
+
+extern "C"
+{
+  void * malloc(size_t size)
+  {
+    num_allocations += tracking;
+    return __libc_malloc(size);
+  }
+
+  void * calloc(size_t num, size_t size)
+  {
+    num_allocations += tracking;
+    return __libc_calloc(num, size);
+  }
+
+  void * realloc(void * ptr, size_t size)
+  {
+    num_allocations += tracking;
+    return __libc_realloc(ptr, size);
+  }
+
+  void * aligned_alloc(size_t alignment, size_t size)
+  {
+    num_allocations += tracking;
+    return __libc_memalign(alignment, size);
+  }
+
+  int posix_memalign(void ** ptr, size_t alignment, size_t size)
+  {
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+    {
+      return EINVAL;
+    }
+    num_allocations += tracking;
+    void * result = __libc_memalign(alignment, size);
+    if (result == nullptr)
+    {
+      return ENOMEM;
+    }
+    *ptr = result;
+    return 0;
+  }
+
+  void free(void * ptr)
+  {
+    num_deallocations += tracking && ptr != nullptr;
+    __libc_free(ptr);
+  }
+
+  int pthread_mutex_lock(pthread_mutex_t * mutex)
+  {
+    num_mutex_locks += tracking;
+    return call_next_mutex_lock(mutex);
+  }
+}
+
+namespace rt_safety_checks
+{
+RtSafetyChecker::RtSafetyChecker()
+{
+  num_allocations = 0;
+  num_deallocations = 0;
+  num_mutex_locks = 0;
+  tracking = true;
+}
+
+RtSafetyChecker::~RtSafetyChecker() { stop(); }
+
+void RtSafetyChecker::stop() { tracking = false; }
+
+size_t RtSafetyChecker::allocations() const { return num_allocations; }
+
+size_t RtSafetyChecker::deallocations() const { return num_deallocations; }
+
+size_t RtSafetyChecker::mutex_locks() const { return num_mutex_locks; }
+
+}  // namespace rt_safety_checks
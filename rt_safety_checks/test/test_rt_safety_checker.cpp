@@ -0,0 +1,76 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rt_safety_checks/rt_safety_checker.hpp"
+
+using rt_safety_checks::RtSafetyChecker;
+
+TEST(TestRtSafetyChecker, counts_allocations_and_deallocations)
+{
+  std::vector<double> preallocated(8, 0.0);
+  RtSafetyChecker checker;
+  preallocated.assign(8, 1.0);
+  EXPECT_EQ(checker.allocations(), 0u);
+
+  auto value = std::make_unique<double>(1.0);
+  std::vector<double> vector(100, 0.0);
+  EXPECT_EQ(checker.allocations(), 2u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+
+  value.reset();
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 2u);
+  EXPECT_EQ(checker.deallocations(), 1u);
+}
+
+TEST(TestRtSafetyChecker, counts_mutex_locks_but_not_try_locks)
+{
+  std::mutex mutex;
+  RtSafetyChecker checker;
+  ASSERT_TRUE(mutex.try_lock());
+  mutex.unlock();
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.mutex_locks(), 1u);
+  EXPECT_EQ(checker.allocations(), 0u);
+}
+
+TEST(TestRtSafetyChecker, ignores_other_threads)
+{
+  std::mutex mutex;
+  RtSafetyChecker checker;
+  std::thread thread(
+    [&mutex]()
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      auto value = std::make_unique<double>(1.0);
+    });
+  checker.stop();
+  thread.join();
+
+  // creating the thread allocates its state, but nothing of the thread itself is counted
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+}
@@ -0,0 +1,64 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+#include "rt_safety_checks/update_time_bound.hpp"
+
+using rt_safety_checks::measure_update_times;
+using rt_safety_checks::UpdateTimeBound;
+using rt_safety_checks::UpdateTimes;
+
+TEST(TestUpdateTimeBound, measures_the_median_and_the_worst_cycle)
+{
+  size_t num_calls = 0;
+  const auto times = measure_update_times(
+    5,
+    [&num_calls](const size_t i)
+    {
+      ++num_calls;
+      if (i == 3)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+    });
+  EXPECT_EQ(num_calls, 5u);
+  EXPECT_GE(times.max, std::chrono::milliseconds(20));
+  EXPECT_LT(times.median, std::chrono::milliseconds(20));
+
+  const auto no_times = measure_update_times(0, [](size_t) {});
+  EXPECT_EQ(no_times.max.count(), 0);
+  EXPECT_EQ(no_times.median.count(), 0);
+}
+
+TEST(TestUpdateTimeBound, bound_is_relative_to_the_baseline)
+{
+  UpdateTimeBound bound(4.0, std::chrono::milliseconds(1));
+  EXPECT_EQ(bound.get_bound(), std::chrono::milliseconds(1));
+
+  bound.calibrate(
+    3, [](size_t) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+  EXPECT_GE(bound.get_baseline(), std::chrono::milliseconds(2));
+  EXPECT_EQ(bound.get_bound(), 4 * bound.get_baseline() + std::chrono::milliseconds(1));
+
+  UpdateTimes times;
+  times.max = bound.get_bound();
+  EXPECT_TRUE(bound.holds(times));
+  times.max += std::chrono::nanoseconds(1);
+  EXPECT_FALSE(bound.holds(times));
+}
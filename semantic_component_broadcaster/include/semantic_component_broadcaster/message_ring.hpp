@@ -0,0 +1,90 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SEMANTIC_COMPONENT_BROADCASTER__MESSAGE_RING_HPP_
+#define SEMANTIC_COMPONENT_BROADCASTER__MESSAGE_RING_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace semantic_component_broadcaster
+{
+/**
+ * \brief Lock-free single-producer/single-consumer ring of messages.
+ *
+ * All slots are copies of a template message made by resize(), so that the producer only
+ * overwrites values in place, e.g., stamps and sensor values, and never allocates memory as long
+ * as it doesn't change the sizes of the fields.
+ */
+template <typename MessageT>
+class MessageRing
+{
+public:
+  /// Allocate \p capacity copies of \p message_template, not thread-safe
+  void resize(const size_t capacity, const MessageT & message_template)
+  {
+    slots_.assign(capacity, message_template);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return slots_.size(); }
+
+  /// Number of messages in the ring, exact only if called by the producer or the consumer
+  size_t size() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  /// \return the slot to fill by the producer, nullptr if the ring is full
+  MessageT * begin_push()
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (capacity() == 0 || head - tail_.load(std::memory_order_acquire) >= capacity())
+    {
+      return nullptr;
+    }
+    return &slots_[head % capacity()];
+  }
+
+  /// Hand the slot of the last begin_push() over to the consumer
+  void end_push()
+  {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /// \return the oldest message for the consumer, nullptr if the ring is empty
+  const MessageT * front() const
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+    return &slots_[tail % capacity()];
+  }
+
+  /// Hand the slot of front() back to the producer
+  void pop() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+  std::vector<MessageT> slots_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace semantic_component_broadcaster
+
+#endif  // SEMANTIC_COMPONENT_BROADCASTER__MESSAGE_RING_HPP_
@@ -0,0 +1,400 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SEMANTIC_COMPONENT_BROADCASTER__SEMANTIC_COMPONENT_BROADCASTER_HPP_
+#define SEMANTIC_COMPONENT_BROADCASTER__SEMANTIC_COMPONENT_BROADCASTER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "controller_interface/controller_interface.hpp"
+#include "rclcpp/publisher.hpp"
+#include "rclcpp/qos.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+#include "realtime_tools/realtime_publisher.h"
+#include "semantic_component_broadcaster/message_ring.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+
+namespace semantic_component_broadcaster
+{
+/// Publishing features shared by all broadcasters, normally set from their parameters
+struct BroadcasterOptions
+{
+  /// Maximum publishing rate in Hz, zero to publish in every update
+  double publish_rate = 0.0;
+  /// Only publish if the compared state interfaces changed since the last message
+  bool publish_on_change = false;
+  /// State interface that changes with every new sample, the only one compared if not empty
+  std::string sequence_interface_name;
+  /// Pass the messages through a lock-free ring to a publisher thread
+  bool publisher_thread = false;
+  /// Capacity of the ring of the publisher thread
+  size_t queue_size = 100;
+  /// Number of queued messages the publisher thread waits for before publishing them at once
+  size_t batch_size = 1;
+  /// Let the publisher thread publish a std::unique_ptr, which intra-process subscribers take over
+  bool publish_unique_ptr = false;
+};
+
+/// Counters since the last activation
+struct BroadcasterStatistics
+{
+  /// Calls of update()
+  uint64_t updates = 0;
+  /// Updates without message because of the publishing rate or without new sample
+  uint64_t skipped = 0;
+  /// Messages handed to the middleware
+  uint64_t published = 0;
+  /// Messages lost because the realtime publisher was busy or the ring was full
+  uint64_t dropped = 0;
+};
+
+/**
+ * \brief Broadcaster publishing the values of a semantic component.
+ *
+ * Implements the interface configuration, activation and update shared by the sensor
+ * broadcasters, so that all of them get the same publishing features, see BroadcasterOptions.
+ * The derived broadcaster creates \ref semantic_component_ and calls configure_broadcaster() in
+ * on_configure(), and can then initialize the constant fields of the message template
+ * `realtime_publisher_->msg_`.
+ *
+ * \tparam SemanticComponentT semantic component with `get_values_as_message(MessageT &)`
+ * \tparam MessageT message type with a `header`
+ */
+template <typename SemanticComponentT, typename MessageT>
+class SemanticComponentBroadcaster : public controller_interface::ControllerInterface
+{
+public:
+  ~SemanticComponentBroadcaster() override { stop_publisher_thread(); }
+
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override
+  {
+    controller_interface::InterfaceConfiguration command_interfaces_config;
+    command_interfaces_config.type = controller_interface::interface_configuration_type::NONE;
+    return command_interfaces_config;
+  }
+
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override
+  {
+    controller_interface::InterfaceConfiguration state_interfaces_config;
+    state_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+    state_interfaces_config.names = get_sensor_state_interface_names();
+    if (!options_.sequence_interface_name.empty())
+    {
+      state_interfaces_config.names.push_back(options_.sequence_interface_name);
+    }
+    return state_interfaces_config;
+  }
+
+  controller_interface::CallbackReturn on_activate(
+    const rclcpp_lifecycle::State & /*previous_state*/) override
+  {
+    if (semantic_component_)
+    {
+      semantic_component_->assign_loaned_state_interfaces(state_interfaces_);
+    }
+
+    // the sequence interface is the last one, otherwise all interfaces are compared
+    const bool has_sequence_interface = !options_.sequence_interface_name.empty();
+    if (
+      has_sequence_interface &&
+      (state_interfaces_.empty() ||
+       state_interfaces_.back().get_name() != options_.sequence_interface_name))
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Sequence state interface '%s' is not available.",
+        options_.sequence_interface_name.c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    compared_interfaces_begin_ = has_sequence_interface ? state_interfaces_.size() - 1 : 0;
+    published_values_.assign(
+      state_interfaces_.size() - compared_interfaces_begin_,
+      std::numeric_limits<double>::quiet_NaN());
+    publish_rate_->reset();
+
+    updates_ = 0;
+    skipped_ = 0;
+    published_ = 0;
+    dropped_ = 0;
+    if (options_.publisher_thread && realtime_publisher_)
+    {
+      start_publisher_thread();
+    }
+    return controller_interface::CallbackReturn::SUCCESS;
+  }
+
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & /*previous_state*/) override
+  {
+    stop_publisher_thread();
+    if (semantic_component_)
+    {
+      semantic_component_->release_interfaces();
+    }
+    const auto statistics = get_statistics();
+    RCLCPP_DEBUG(
+      get_node()->get_logger(),
+      "%lu updates, %lu skipped, %lu published and %lu dropped messages since activation.",
+      static_cast<unsigned long>(statistics.updates),    // NOLINT(runtime/int)
+      static_cast<unsigned long>(statistics.skipped),    // NOLINT(runtime/int)
+      static_cast<unsigned long>(statistics.published),  // NOLINT(runtime/int)
+      static_cast<unsigned long>(statistics.dropped));   // NOLINT(runtime/int)
+    return controller_interface::CallbackReturn::SUCCESS;
+  }
+
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & /*period*/) override
+  {
+    if (!realtime_publisher_ || !is_sample_due(time))
+    {
+      return controller_interface::return_type::OK;
+    }
+
+    if (options_.publisher_thread)
+    {
+      MessageT * message = message_ring_.begin_push();
+      if (message == nullptr)
+      {
+        ++dropped_;
+        return controller_interface::return_type::OK;
+      }
+      fill_message(time, *message);
+      message_ring_.end_push();
+      on_sample_published();
+    }
+    else if (realtime_publisher_->trylock())
+    {
+      fill_message(time, realtime_publisher_->msg_);
+      realtime_publisher_->unlockAndPublish();
+      ++published_;
+      on_sample_published();
+    }
+    else
+    {
+      ++dropped_;
+    }
+    return controller_interface::return_type::OK;
+  }
+
+  /// Counters since the last activation, can be called from any thread
+  BroadcasterStatistics get_statistics() const
+  {
+    BroadcasterStatistics statistics;
+    statistics.updates = updates_;
+    statistics.skipped = skipped_;
+    statistics.published = published_;
+    statistics.dropped = dropped_;
+    return statistics;
+  }
+
+protected:
+  /// Create the publisher on \p topic_name and apply \p options; not realtime-safe
+  /**
+   * No publisher is created if \p topic_name is empty, for broadcasters publishing other messages
+   * with is_sample_due() and on_sample_published(), on \p rate_topic_name then. The publishing
+   * rate is registered at the telemetry rate policy of the process for this topic.
+   *
+   * \return false if the options are invalid or the publisher can't be created, an error is
+   * logged then
+   */
+  bool configure_broadcaster(
+    const std::string & topic_name, const BroadcasterOptions & options,
+    const std::string & rate_topic_name = "")
+  {
+    stop_publisher_thread();
+    if (options.publisher_thread && (options.queue_size < 1 || options.batch_size < 1 ||
+                                     options.batch_size > options.queue_size))
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "The batch size of the publisher thread has to be between 1 and its queue size.");
+      return false;
+    }
+    options_ = options;
+    publish_rate_ = telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+      get_node()->get_namespace(),
+      get_node()->get_node_topics_interface()->resolve_topic_name(
+        topic_name.empty() ? rate_topic_name : topic_name),
+      options.publish_rate);
+    sensor_state_publisher_.reset();
+    realtime_publisher_.reset();
+    if (topic_name.empty())
+    {
+      return true;
+    }
+    try
+    {
+      sensor_state_publisher_ =
+        get_node()->template create_publisher<MessageT>(topic_name, rclcpp::SystemDefaultsQoS());
+      realtime_publisher_ =
+        std::make_unique<realtime_tools::RealtimePublisher<MessageT>>(sensor_state_publisher_);
+    }
+    catch (const std::exception & e)
+    {
+      fprintf(
+        stderr,
+        "Exception thrown during publisher creation at configure stage with message : %s \n",
+        e.what());
+      return false;
+    }
+    return true;
+  }
+
+  /// Names of the state interfaces of the sensor, those of the semantic component by default
+  virtual std::vector<std::string> get_sensor_state_interface_names() const
+  {
+    return semantic_component_ ? semantic_component_->get_state_interface_names()
+                               : std::vector<std::string>();
+  }
+
+  /// Fill the values of \p message in place, realtime-safe
+  virtual void fill_message(const rclcpp::Time & time, MessageT & message)
+  {
+    message.header.stamp = time;
+    semantic_component_->get_values_as_message(message);
+  }
+
+  /// \return true if a message has to be published now, by the publishing rate and on change
+  /**
+   * Also counts the update for the statistics. This is called by update(), derived broadcasters
+   * publishing additional messages can use it for them, followed by on_sample_published().
+   */
+  bool is_sample_due(const rclcpp::Time & time)
+  {
+    ++updates_;
+    // the period is only checked for new samples, so that it doesn't delay their publication
+    if (
+      (options_.publish_on_change && !has_new_sample()) ||
+      !publish_rate_->is_due(time))
+    {
+      ++skipped_;
+      return false;
+    }
+    return true;
+  }
+
+  /// Remember the compared values of the published sample
+  void on_sample_published()
+  {
+    for (size_t i = 0; i < published_values_.size(); ++i)
+    {
+      published_values_[i] = state_interfaces_[compared_interfaces_begin_ + i].get_value();
+    }
+  }
+
+  std::unique_ptr<SemanticComponentT> semantic_component_;
+  typename rclcpp::Publisher<MessageT>::SharedPtr sensor_state_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<MessageT>> realtime_publisher_;
+  BroadcasterOptions options_;
+
+  /// Counters of the statistics, incremented by the realtime loop and the publisher thread
+  std::atomic<uint64_t> updates_{0};
+  std::atomic<uint64_t> skipped_{0};
+  std::atomic<uint64_t> published_{0};
+  std::atomic<uint64_t> dropped_{0};
+
+private:
+  /// \return true if the compared state interfaces changed since the last published message
+  bool has_new_sample() const
+  {
+    for (size_t i = 0; i < published_values_.size(); ++i)
+    {
+      const double value = state_interfaces_[compared_interfaces_begin_ + i].get_value();
+      const double published_value = published_values_[i];
+      // a sensor without samples yet keeps reporting NaN, which is no new sample
+      if (value != published_value && !(std::isnan(value) && std::isnan(published_value)))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void start_publisher_thread()
+  {
+    stop_publisher_thread();
+    // the message initialized in on_configure() is the template of all slots
+    message_ring_.resize(options_.queue_size, realtime_publisher_->msg_);
+    publisher_thread_running_ = true;
+    publisher_thread_ = std::thread(
+      [this]()
+      {
+        while (publisher_thread_running_)
+        {
+          if (message_ring_.size() >= options_.batch_size)
+          {
+            publish_queued_messages();
+          }
+          // the realtime loop never wakes this thread, so it polls the ring
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        publish_queued_messages();
+      });
+  }
+
+  void stop_publisher_thread()
+  {
+    publisher_thread_running_ = false;
+    if (publisher_thread_.joinable())
+    {
+      publisher_thread_.join();
+    }
+  }
+
+  void publish_queued_messages()
+  {
+    for (const MessageT * message = message_ring_.front(); message != nullptr;
+         message = message_ring_.front())
+    {
+      if (options_.publish_unique_ptr)
+      {
+        // copied as rclcpp would for intra-process subscribers, but the slot is freed first
+        auto unique_message = std::make_unique<MessageT>(*message);
+        message_ring_.pop();
+        sensor_state_publisher_->publish(std::move(unique_message));
+      }
+      else
+      {
+        sensor_state_publisher_->publish(*message);
+        message_ring_.pop();
+      }
+      ++published_;
+    }
+  }
+
+  /// Publishing rate with the telemetry rate policy of the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> publish_rate_;
+  /// Index of the first state interface compared with 'publish_on_change'
+  size_t compared_interfaces_begin_ = 0;
+  /// Values of the compared state interfaces in the last published message
+  std::vector<double> published_values_;
+
+  MessageRing<MessageT> message_ring_;
+  std::thread publisher_thread_;
+  std::atomic<bool> publisher_thread_running_{false};
+};
+
+}  // namespace semantic_component_broadcaster
+
+#endif  // SEMANTIC_COMPONENT_BROADCASTER__SEMANTIC_COMPONENT_BROADCASTER_HPP_
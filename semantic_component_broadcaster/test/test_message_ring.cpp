@@ -0,0 +1,95 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+#include "semantic_component_broadcaster/message_ring.hpp"
+
+using semantic_component_broadcaster::MessageRing;
+
+TEST(TestMessageRing, push_and_pop_in_order)
+{
+  MessageRing<std::vector<int>> ring;
+  EXPECT_EQ(ring.begin_push(), nullptr);
+  EXPECT_EQ(ring.front(), nullptr);
+
+  ring.resize(2, std::vector<int>(3, 0));
+  EXPECT_EQ(ring.capacity(), 2u);
+  EXPECT_EQ(ring.front(), nullptr);
+
+  for (int i = 1; i <= 2; ++i)
+  {
+    auto * message = ring.begin_push();
+    ASSERT_NE(message, nullptr);
+    // the slots are copies of the template
+    EXPECT_EQ(message->size(), 3u);
+    (*message)[0] = i;
+    ring.end_push();
+  }
+  EXPECT_EQ(ring.size(), 2u);
+  // full, the messages are not overwritten
+  EXPECT_EQ(ring.begin_push(), nullptr);
+
+  ASSERT_NE(ring.front(), nullptr);
+  EXPECT_EQ((*ring.front())[0], 1);
+  ring.pop();
+  ASSERT_NE(ring.begin_push(), nullptr);
+  ASSERT_NE(ring.front(), nullptr);
+  EXPECT_EQ((*ring.front())[0], 2);
+  ring.pop();
+  EXPECT_EQ(ring.front(), nullptr);
+  EXPECT_EQ(ring.size(), 0u);
+}
+
+TEST(TestMessageRing, producer_and_consumer_threads)
+{
+  constexpr int NUM_MESSAGES = 10000;
+  MessageRing<int> ring;
+  ring.resize(16, 0);
+
+  std::thread producer(
+    [&ring]()
+    {
+      for (int i = 0; i < NUM_MESSAGES;)
+      {
+        int * message = ring.begin_push();
+        if (message == nullptr)
+        {
+          std::this_thread::yield();
+          continue;
+        }
+        *message = i++;
+        ring.end_push();
+      }
+    });
+
+  int expected = 0;
+  while (expected < NUM_MESSAGES)
+  {
+    const int * message = ring.front();
+    if (message == nullptr)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(*message, expected);
+    ring.pop();
+    ++expected;
+  }
+  producer.join();
+  EXPECT_EQ(ring.front(), nullptr);
+}
@@ -0,0 +1,144 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SHM_COMMAND_INGRESS__SHM_COMMAND_RING_HPP_
+#define SHM_COMMAND_INGRESS__SHM_COMMAND_RING_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "shm_command_ingress/visibility_control.h"
+
+namespace shm_command_ingress
+{
+/**
+ * \brief Ring of time-stamped commands in a named POSIX shared memory segment.
+ *
+ * A controller creates the segment in its ``on_configure()`` and reads the latest command in its
+ * ``update()``, a process on the same host, e.g., a motion planner, opens the segment by its name
+ * and writes the commands, without serialization, middleware or executor in between.
+ *
+ * The segment starts with a header of 64 bytes: the magic "CMDRING", a uint32 version, a uint32
+ * padding, the uint64 number of values of a command, the uint64 number of slots and the atomic
+ * uint64 count of written commands. The slots follow at multiples of 64 bytes, each with an atomic
+ * uint64 sequence number, the atomic int64 stamp in nanoseconds and the atomic double values.
+ * Command n is written into slot n % slots. Each slot is a seqlock: its sequence number is 2n + 1
+ * while command n is written and 2n + 2 afterwards, so a reader detects a concurrent write and
+ * retries instead of waiting for it. The writer never waits for the reader, older commands are
+ * overwritten.
+ *
+ * There may be one writer and one reader. Neither of them locks or allocates memory in write() or
+ * read_latest().
+ */
+class ShmCommandRing
+{
+public:
+  /// Attempts of read_latest() before giving up, in case the writer is preempted within write()
+  static constexpr size_t MAX_READ_ATTEMPTS = 8;
+
+  ShmCommandRing() = default;
+  SHM_COMMAND_INGRESS_PUBLIC
+  ~ShmCommandRing();
+
+  ShmCommandRing(const ShmCommandRing &) = delete;
+  ShmCommandRing & operator=(const ShmCommandRing &) = delete;
+
+  /// Create the segment \p name, replacing an existing one, not realtime-safe
+  /**
+   * The segment is removed again by close(), so writers have to open it after the creation.
+   *
+   * \param name of the segment, e.g., "/forward_position_controller_commands"
+   * \param num_values of every command
+   * \param num_slots of the ring, at least 2
+   * \return false with the reason in \p error if the segment can't be created
+   */
+  SHM_COMMAND_INGRESS_PUBLIC
+  bool create(
+    const std::string & name, size_t num_values, size_t num_slots, std::string & error);
+
+  /// Open the existing segment \p name, e.g., to write commands into it, not realtime-safe
+  /**
+   * \return false with the reason in \p error if there is no segment \p name or if its commands
+   * don't have \p num_values values
+   */
+  SHM_COMMAND_INGRESS_PUBLIC
+  bool open(const std::string & name, size_t num_values, std::string & error);
+
+  /// Unmap the segment, and remove it if it was created by create(), not realtime-safe
+  SHM_COMMAND_INGRESS_PUBLIC
+  void close();
+
+  bool is_open() const { return header_ != nullptr; }
+
+  const std::string & get_name() const { return name_; }
+
+  size_t get_num_values() const { return num_values_; }
+
+  size_t get_num_slots() const { return num_slots_; }
+
+  /// Append the command \p values written at \p stamp_ns, zero for the time of reading,
+  /// realtime-safe
+  /**
+   * \return false if the segment isn't open or \p values doesn't have get_num_values() values
+   */
+  SHM_COMMAND_INGRESS_PUBLIC
+  bool write(int64_t stamp_ns, const std::vector<double> & values);
+
+  /// Copy the latest command written since the last call, realtime-safe
+  /**
+   * \param[out] values of the command, it has to have get_num_values() values already.
+   * \return false if no command was written since the last command read, or if a write was in
+   * progress during all attempts. The outputs are not changed in that case.
+   */
+  SHM_COMMAND_INGRESS_PUBLIC
+  bool read_latest(int64_t & stamp_ns, std::vector<double> & values);
+
+  /// Skip the commands written until now, e.g., on activation, realtime-safe
+  SHM_COMMAND_INGRESS_PUBLIC
+  void clear();
+
+  /// Number of commands written into the segment since its creation, realtime-safe
+  SHM_COMMAND_INGRESS_PUBLIC
+  uint64_t get_write_count() const;
+
+private:
+  struct Header;
+
+  /// Map the segment of \p fd with \p size bytes, and close \p fd
+  bool map(int fd, size_t size, std::string & error);
+
+  std::atomic<uint64_t> & get_slot_sequence(size_t slot) const;
+  std::atomic<int64_t> & get_slot_stamp(size_t slot) const;
+  std::atomic<double> * get_slot_values(size_t slot) const;
+
+  std::string name_;
+  bool owner_ = false;
+  void * mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  Header * header_ = nullptr;
+  size_t num_values_ = 0;
+  size_t num_slots_ = 0;
+  size_t slot_size_ = 0;
+  // count of written commands at the last command read
+  uint64_t read_count_ = 0;
+  // values of the command being read, copied to the output if it wasn't overwritten meanwhile
+  std::vector<double> read_values_;
+};
+
+}  // namespace shm_command_ingress
+
+#endif  // SHM_COMMAND_INGRESS__SHM_COMMAND_RING_HPP_
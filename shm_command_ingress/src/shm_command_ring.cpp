@@ -0,0 +1,336 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "shm_command_ingress/shm_command_ring.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace shm_command_ingress
+{
+namespace
+{
+constexpr std::array<char, 8> RING_MAGIC = {'C', 'M', 'D', 'R', 'I', 'N', 'G', '\0'};
+constexpr uint32_t RING_VERSION = 1;
+// the header and every slot start at a cache line, so the writer and the reader of different
+// slots don't share one
+constexpr size_t CACHE_LINE_SIZE = 64;
+constexpr size_t HEADER_SIZE = CACHE_LINE_SIZE;
+// sequence number and stamp of a slot
+constexpr size_t SLOT_PREFIX_SIZE = 2 * sizeof(uint64_t);
+
+static_assert(
+  std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free &&
+    std::atomic<double>::is_always_lock_free,
+  "the atomics shared with other processes have to be lock-free");
+static_assert(sizeof(std::atomic<double>) == sizeof(double), "atomic doubles have to be packed");
+
+size_t get_slot_size(const size_t num_values)
+{
+  const size_t size = SLOT_PREFIX_SIZE + num_values * sizeof(double);
+  return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+}  // namespace
+
+struct ShmCommandRing::Header
+{
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t padding;
+  uint64_t num_values;
+  uint64_t num_slots;
+  std::atomic<uint64_t> write_count;
+};
+
+ShmCommandRing::~ShmCommandRing() { close(); }
+
+bool ShmCommandRing::create(
+  const std::string & name, const size_t num_values, const size_t num_slots, std::string & error)
+{
+  close();
+#ifdef _WIN32
+  (void)name;
+  (void)num_values;
+  (void)num_slots;
+  error = "Shared memory command rings are not supported on Windows.";
+  return false;
+#else
+  if (num_values == 0 || num_slots < 2)
+  {
+    error = "A command ring needs at least one value and two slots.";
+    return false;
+  }
+  // the segment of a previous run, e.g., of a crashed process
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+  {
+    error = "Can't create the shared memory segment '" + name + "': " + std::strerror(errno);
+    return false;
+  }
+  const size_t slot_size = get_slot_size(num_values);
+  const size_t size = HEADER_SIZE + num_slots * slot_size;
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+  {
+    error = "Can't resize the shared memory segment '" + name + "': " + std::strerror(errno);
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  if (!map(fd, size, error))
+  {
+    shm_unlink(name.c_str());
+    return false;
+  }
+  name_ = name;
+  owner_ = true;
+
+  static_assert(sizeof(Header) <= HEADER_SIZE, "the header has to fit");
+  // touch all pages, so read_latest() doesn't page fault
+  std::memset(mapping_, 0, size);
+  header_ = new (mapping_) Header;
+  header_->version = RING_VERSION;
+  header_->padding = 0;
+  header_->num_values = num_values;
+  header_->num_slots = num_slots;
+  header_->write_count.store(0, std::memory_order_relaxed);
+  // writers opening the segment meanwhile see an incomplete header until here
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = RING_MAGIC;
+
+  num_values_ = num_values;
+  num_slots_ = num_slots;
+  slot_size_ = slot_size;
+  read_count_ = 0;
+  read_values_.assign(num_values, 0.0);
+  return true;
+#endif
+}
+
+bool ShmCommandRing::open(const std::string & name, const size_t num_values, std::string & error)
+{
+  close();
+#ifdef _WIN32
+  (void)name;
+  (void)num_values;
+  error = "Shared memory command rings are not supported on Windows.";
+  return false;
+#else
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    error = "Can't open the shared memory segment '" + name + "': " + std::strerror(errno);
+    return false;
+  }
+  struct stat segment_stat;
+  if (fstat(fd, &segment_stat) != 0 || static_cast<size_t>(segment_stat.st_size) < HEADER_SIZE)
+  {
+    ::close(fd);
+    error = "The shared memory segment '" + name + "' isn't a command ring.";
+    return false;
+  }
+  const auto size = static_cast<size_t>(segment_stat.st_size);
+  if (!map(fd, size, error))
+  {
+    return false;
+  }
+
+  auto * header = static_cast<Header *>(mapping_);
+  if (header->magic != RING_MAGIC || header->version != RING_VERSION)
+  {
+    close();
+    error = "The shared memory segment '" + name + "' isn't a command ring of version " +
+            std::to_string(RING_VERSION) + ".";
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->num_values != num_values)
+  {
+    error = "The commands of the shared memory segment '" + name + "' have " +
+            std::to_string(header->num_values) + " values, expected " +
+            std::to_string(num_values) + ".";
+    close();
+    return false;
+  }
+  const size_t slot_size = get_slot_size(num_values);
+  if (header->num_slots < 2 || size < HEADER_SIZE + header->num_slots * slot_size)
+  {
+    close();
+    error = "The shared memory segment '" + name + "' is truncated.";
+    return false;
+  }
+
+  name_ = name;
+  owner_ = false;
+  header_ = header;
+  num_values_ = num_values;
+  num_slots_ = static_cast<size_t>(header->num_slots);
+  slot_size_ = slot_size;
+  // the commands written before are not read
+  read_count_ = header_->write_count.load(std::memory_order_acquire);
+  read_values_.assign(num_values, 0.0);
+  return true;
+#endif
+}
+
+void ShmCommandRing::close()
+{
+#ifndef _WIN32
+  if (mapping_)
+  {
+    munmap(mapping_, mapping_size_);
+  }
+  if (owner_)
+  {
+    shm_unlink(name_.c_str());
+  }
+#endif
+  name_.clear();
+  owner_ = false;
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  header_ = nullptr;
+  num_values_ = 0;
+  num_slots_ = 0;
+  slot_size_ = 0;
+  read_count_ = 0;
+  read_values_.clear();
+}
+
+bool ShmCommandRing::write(const int64_t stamp_ns, const std::vector<double> & values)
+{
+  if (!header_ || values.size() != num_values_)
+  {
+    return false;
+  }
+  // only this writer changes the count
+  const uint64_t count = header_->write_count.load(std::memory_order_relaxed);
+  const auto slot = static_cast<size_t>(count % num_slots_);
+  auto & sequence = get_slot_sequence(slot);
+  sequence.store(2 * count + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  get_slot_stamp(slot).store(stamp_ns, std::memory_order_relaxed);
+  auto * slot_values = get_slot_values(slot);
+  for (size_t i = 0; i < num_values_; ++i)
+  {
+    slot_values[i].store(values[i], std::memory_order_relaxed);
+  }
+  sequence.store(2 * count + 2, std::memory_order_release);
+  header_->write_count.store(count + 1, std::memory_order_release);
+  return true;
+}
+
+bool ShmCommandRing::read_latest(int64_t & stamp_ns, std::vector<double> & values)
+{
+  if (!header_ || values.size() != num_values_)
+  {
+    return false;
+  }
+  for (size_t attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt)
+  {
+    const uint64_t count = header_->write_count.load(std::memory_order_acquire);
+    if (count == read_count_)
+    {
+      return false;
+    }
+    // the slot of the latest command, unless the writer is overwriting it with a newer one
+    const uint64_t index = count - 1;
+    const auto slot = static_cast<size_t>(index % num_slots_);
+    const auto & sequence = get_slot_sequence(slot);
+    const uint64_t written_sequence = 2 * index + 2;
+    if (sequence.load(std::memory_order_acquire) != written_sequence)
+    {
+      continue;
+    }
+    const int64_t stamp = get_slot_stamp(slot).load(std::memory_order_relaxed);
+    const auto * slot_values = get_slot_values(slot);
+    for (size_t i = 0; i < num_values_; ++i)
+    {
+      read_values_[i] = slot_values[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) != written_sequence)
+    {
+      continue;
+    }
+    stamp_ns = stamp;
+    std::copy(read_values_.begin(), read_values_.end(), values.begin());
+    read_count_ = count;
+    return true;
+  }
+  return false;
+}
+
+void ShmCommandRing::clear()
+{
+  read_count_ = get_write_count();
+}
+
+uint64_t ShmCommandRing::get_write_count() const
+{
+  return header_ ? header_->write_count.load(std::memory_order_acquire) : 0;
+}
+
+bool ShmCommandRing::map(const int fd, const size_t size, std::string & error)
+{
+#ifdef _WIN32
+  (void)fd;
+  (void)size;
+  (void)error;
+  return false;
+#else
+  mapping_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping_ == MAP_FAILED)
+  {
+    mapping_ = nullptr;
+    error = std::string("Can't map the shared memory segment: ") + std::strerror(errno);
+    return false;
+  }
+  mapping_size_ = size;
+  return true;
+#endif
+}
+
+std::atomic<uint64_t> & ShmCommandRing::get_slot_sequence(const size_t slot) const
+{
+  auto * data = static_cast<uint8_t *>(mapping_) + HEADER_SIZE + slot * slot_size_;
+  return *reinterpret_cast<std::atomic<uint64_t> *>(data);
+}
+
+std::atomic<int64_t> & ShmCommandRing::get_slot_stamp(const size_t slot) const
+{
+  auto * data = static_cast<uint8_t *>(mapping_) + HEADER_SIZE + slot * slot_size_;
+  return *reinterpret_cast<std::atomic<int64_t> *>(data + sizeof(uint64_t));
+}
+
+std::atomic<double> * ShmCommandRing::get_slot_values(const size_t slot) const
+{
+  auto * data = static_cast<uint8_t *>(mapping_) + HEADER_SIZE + slot * slot_size_;
+  return reinterpret_cast<std::atomic<double> *>(data + SLOT_PREFIX_SIZE);
+}
+
+}  // namespace shm_command_ingress
@@ -0,0 +1,137 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "shm_command_ingress/shm_command_ring.hpp"
+
+using shm_command_ingress::ShmCommandRing;
+
+class TestShmCommandRing : public ::testing::Test
+{
+protected:
+  // unique per process, so tests running in parallel don't share segments
+  const std::string name_ = "/test_shm_command_ring_" + std::to_string(getpid());
+  std::string error_;
+};
+
+TEST_F(TestShmCommandRing, writer_commands_are_read_by_the_creator)
+{
+  ShmCommandRing reader;
+  ASSERT_TRUE(reader.create(name_, 2, 4, error_)) << error_;
+  EXPECT_EQ(reader.get_num_values(), 2u);
+  EXPECT_EQ(reader.get_num_slots(), 4u);
+
+  ShmCommandRing writer;
+  ASSERT_TRUE(writer.open(name_, 2, error_)) << error_;
+  EXPECT_EQ(writer.get_num_slots(), 4u);
+
+  int64_t stamp_ns = 0;
+  std::vector<double> values(2, 0.0);
+  EXPECT_FALSE(reader.read_latest(stamp_ns, values));
+
+  ASSERT_TRUE(writer.write(10, {1.0, 2.0}));
+  ASSERT_TRUE(reader.read_latest(stamp_ns, values));
+  EXPECT_EQ(stamp_ns, 10);
+  EXPECT_THAT(values, ::testing::ElementsAre(1.0, 2.0));
+  // a command is read once
+  EXPECT_FALSE(reader.read_latest(stamp_ns, values));
+
+  // only the latest command is read, also after the writer wrapped around the ring
+  for (int64_t i = 0; i < 9; ++i)
+  {
+    ASSERT_TRUE(writer.write(20 + i, {static_cast<double>(i), -static_cast<double>(i)}));
+  }
+  ASSERT_TRUE(reader.read_latest(stamp_ns, values));
+  EXPECT_EQ(stamp_ns, 28);
+  EXPECT_THAT(values, ::testing::ElementsAre(8.0, -8.0));
+  EXPECT_EQ(reader.get_write_count(), 10u);
+
+  // skipped commands are not read
+  ASSERT_TRUE(writer.write(30, {3.0, 3.0}));
+  reader.clear();
+  EXPECT_FALSE(reader.read_latest(stamp_ns, values));
+}
+
+TEST_F(TestShmCommandRing, invalid_segments_and_commands_are_rejected)
+{
+  ShmCommandRing ring;
+  EXPECT_FALSE(ring.open(name_, 2, error_));
+  EXPECT_FALSE(error_.empty());
+  EXPECT_FALSE(ring.create(name_, 2, 1, error_));
+
+  ShmCommandRing reader;
+  ASSERT_TRUE(reader.create(name_, 2, 2, error_)) << error_;
+  EXPECT_FALSE(ring.open(name_, 3, error_));
+  ASSERT_TRUE(ring.open(name_, 2, error_)) << error_;
+  EXPECT_FALSE(ring.write(0, {1.0}));
+
+  int64_t stamp_ns = 0;
+  std::vector<double> values(1, 0.0);
+  ASSERT_TRUE(ring.write(0, {1.0, 2.0}));
+  EXPECT_FALSE(reader.read_latest(stamp_ns, values));
+
+  // the creator removes the segment
+  reader.close();
+  ShmCommandRing other;
+  EXPECT_FALSE(other.open(name_, 2, error_));
+}
+
+TEST_F(TestShmCommandRing, concurrent_reads_are_never_torn)
+{
+  ShmCommandRing reader;
+  ASSERT_TRUE(reader.create(name_, 8, 2, error_)) << error_;
+  ShmCommandRing writer;
+  ASSERT_TRUE(writer.open(name_, 8, error_)) << error_;
+
+  // all values of a command are its stamp
+  constexpr int64_t NUM_COMMANDS = 100000;
+  std::atomic<bool> torn{false};
+  std::thread reading(
+    [&reader, &torn]()
+    {
+      int64_t stamp_ns = 0;
+      std::vector<double> values(8, 0.0);
+      int64_t last_stamp_ns = -1;
+      while (last_stamp_ns < NUM_COMMANDS - 1)
+      {
+        if (!reader.read_latest(stamp_ns, values))
+        {
+          continue;
+        }
+        for (const double value : values)
+        {
+          torn = torn || value != static_cast<double>(stamp_ns);
+        }
+        torn = torn || stamp_ns <= last_stamp_ns;
+        last_stamp_ns = stamp_ns;
+      }
+    });
+  std::vector<double> values(8, 0.0);
+  for (int64_t i = 0; i < NUM_COMMANDS; ++i)
+  {
+    values.assign(8, static_cast<double>(i));
+    writer.write(i, values);
+  }
+  reading.join();
+  EXPECT_FALSE(torn);
+}
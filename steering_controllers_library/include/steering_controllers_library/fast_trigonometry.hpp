@@ -0,0 +1,107 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STEERING_CONTROLLERS_LIBRARY__FAST_TRIGONOMETRY_HPP_
+#define STEERING_CONTROLLERS_LIBRARY__FAST_TRIGONOMETRY_HPP_
+
+#include <cmath>
+
+/**
+ * Polynomial approximations of the trigonometric functions of the steering kinematics.
+ *
+ * Steering angles do not exceed a quarter turn, so short polynomials without range reduction
+ * replace the libm calls. The absolute error is below MAX_ERROR, angles outside of
+ * [-pi/2, pi/2] and non-finite values fall back to the exact functions.
+ */
+namespace steering_odometry::fast_trigonometry
+{
+/// Bound of the absolute error of sin(), cos() and atan() [rad]
+constexpr double MAX_ERROR = 1e-7;
+
+/// Sine, Taylor series up to x^11
+inline double sin(const double x)
+{
+  // NaN fails the comparison as well
+  if (!(std::fabs(x) <= M_PI_2))
+  {
+    return std::sin(x);
+  }
+  const double x2 = x * x;
+  return x *
+         (1.0 +
+          x2 * (-1.0 / 6.0 +
+                x2 * (1.0 / 120.0 +
+                      x2 * (-1.0 / 5040.0 + x2 * (1.0 / 362880.0 + x2 * (-1.0 / 39916800.0))))));
+}
+
+/// Cosine, Taylor series up to x^12
+inline double cos(const double x)
+{
+  if (!(std::fabs(x) <= M_PI_2))
+  {
+    return std::cos(x);
+  }
+  const double x2 = x * x;
+  return 1.0 +
+         x2 * (-1.0 / 2.0 +
+               x2 * (1.0 / 24.0 +
+                     x2 * (-1.0 / 720.0 +
+                           x2 * (1.0 / 40320.0 +
+                                 x2 * (-1.0 / 3628800.0 + x2 * (1.0 / 479001600.0))))));
+}
+
+/// Tangent, with the relative error of sin() and cos()
+inline double tan(const double x) { return sin(x) / cos(x); }
+
+/// Arc tangent, Abramowitz and Stegun 4.4.49 on [-1, 1], reflected for larger values
+inline double atan(const double x)
+{
+  const bool reflected = !(std::fabs(x) <= 1.0);
+  // NaN propagates through the reflected branch
+  const double t = reflected ? 1.0 / x : x;
+  const double t2 = t * t;
+  const double result =
+    t * (1.0 +
+         t2 * (-0.3333314528 +
+               t2 * (0.1999355085 +
+                     t2 * (-0.1420889944 +
+                           t2 * (0.1065626393 +
+                                 t2 * (-0.0752896400 +
+                                       t2 * (0.0429096138 +
+                                             t2 * (-0.0161657367 + t2 * 0.0028662257))))))));
+  if (!reflected)
+  {
+    return result;
+  }
+  return (x > 0.0 ? M_PI_2 : -M_PI_2) - result;
+}
+
+/// Arc tangent of y / x in the quadrant of (x, y)
+inline double atan2(const double y, const double x)
+{
+  if (x > 0.0)
+  {
+    return atan(y / x);
+  }
+  if (x < 0.0)
+  {
+    return std::signbit(y) ? atan(y / x) - M_PI : atan(y / x) + M_PI;
+  }
+  // the axes, signed zeros and NaN
+  return std::atan2(y, x);
+}
+
+}  // namespace steering_odometry::fast_trigonometry
+
+#endif  // STEERING_CONTROLLERS_LIBRARY__FAST_TRIGONOMETRY_HPP_
@@ -17,18 +17,27 @@
 
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "bounded_controller_state_msgs/msg/bounded_steering_controller_status.hpp"
+#include "command_mailbox/command_mailbox.hpp"
 #include "controller_interface/chainable_controller_interface.hpp"
 #include "hardware_interface/handle.hpp"
+#include "motion_limits/axis_limiter.hpp"
+#include "odometry_exchange/odometry_exchange.hpp"
+#include "odometry_persistence/odometry_snapshot.hpp"
+#include "publisher_pool/loaned_publisher.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 #include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
+#include "sensor_msgs/msg/joint_state.hpp"
 #include "std_srvs/srv/set_bool.hpp"
 #include "steering_controllers_library/steering_odometry.hpp"
 #include "steering_controllers_library/visibility_control.h"
@@ -40,7 +49,11 @@
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "nav_msgs/msg/odometry.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
 #include "tf2_msgs/msg/tf_message.hpp"
+#include "tf_aggregator/transform_aggregator.hpp"
+#include "update_time_source/update_time_source.hpp"
+#include "update_time_statistics/cycle_budget.hpp"
 
 namespace steering_controllers_library
 {
@@ -99,17 +112,35 @@ protected:
   rclcpp::Subscription<ControllerTwistReferenceMsg>::SharedPtr ref_subscriber_twist_ = nullptr;
   rclcpp::Subscription<ControllerTwistReferenceMsg>::SharedPtr ref_subscriber_ackermann_ = nullptr;
   rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr ref_subscriber_unstamped_ = nullptr;
-  realtime_tools::RealtimeBuffer<std::shared_ptr<ControllerTwistReferenceMsg>> input_ref_;
+  // velocities of the last reference message, passed from the subscriber to the realtime loop
+  struct StampedVelocityReference
+  {
+    int64_t stamp_nanoseconds = 0;
+    double linear = std::numeric_limits<double>::quiet_NaN();
+    double angular = std::numeric_limits<double>::quiet_NaN();
+  };
+  command_mailbox::CommandMailbox<StampedVelocityReference> input_ref_;
+  // reference used by the realtime loop, set to NaN after its timeout
+  StampedVelocityReference current_ref_;
+  uint64_t current_ref_version_ = 0;
   rclcpp::Duration ref_timeout_ = rclcpp::Duration::from_seconds(0.0);  // 0ms
+  // time of the last update, stamps the references in the subscriber callbacks
+  update_time_source::UpdateTimeSource update_time_;
 
-  using ControllerStatePublisherOdom = realtime_tools::RealtimePublisher<ControllerStateMsgOdom>;
-  using ControllerStatePublisherTf = realtime_tools::RealtimePublisher<ControllerStateMsgTf>;
+  using ControllerStatePublisherOdom = publisher_pool::RealtimePublisher<ControllerStateMsgOdom>;
+  using ControllerStatePublisherTf = publisher_pool::RealtimePublisher<ControllerStateMsgTf>;
 
   rclcpp::Publisher<ControllerStateMsgOdom>::SharedPtr odom_s_publisher_;
   rclcpp::Publisher<ControllerStateMsgTf>::SharedPtr tf_odom_s_publisher_;
 
   std::unique_ptr<ControllerStatePublisherOdom> rt_odom_state_publisher_;
   std::unique_ptr<ControllerStatePublisherTf> rt_tf_odom_state_publisher_;
+  // replaces rt_tf_odom_state_publisher_ if the transform is aggregated
+  std::shared_ptr<tf_aggregator::TransformSlot> odom_transform_slot_;
+  // odometry shared with the other controllers of the process, if export_odometry is set
+  std::shared_ptr<odometry_exchange::OdometrySlot> odometry_slot_;
+  // writes the odometry to a file in the background, if odometry_persistence.enable is set
+  std::unique_ptr<odometry_persistence::SnapshotWriter> odometry_snapshot_writer_;
 
   // override methods from ChainableControllerInterface
   std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
@@ -121,9 +152,26 @@ protected:
 
   AckermanControllerState published_state_;
 
-  using ControllerStatePublisher = realtime_tools::RealtimePublisher<AckermanControllerState>;
+  using ControllerStatePublisher = publisher_pool::RealtimePublisher<AckermanControllerState>;
   rclcpp::Publisher<AckermanControllerState>::SharedPtr controller_s_publisher_;
   std::unique_ptr<ControllerStatePublisher> controller_state_publisher_;
+  // controller state of fixed size and the names of its joints, if bounded_controller_state.enable
+  using BoundedControllerState =
+    bounded_controller_state_msgs::msg::BoundedSteeringControllerStatus;
+  std::unique_ptr<publisher_pool::LoanedPublisher<BoundedControllerState>>
+    bounded_controller_state_publisher_;
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr
+    bounded_controller_state_names_publisher_;
+  size_t number_of_traction_wheels_ = 0;
+  size_t number_of_steering_wheels_ = 0;
+  // commands of the wheel modules, the steering commands are kept while the vehicle stands still
+  std::vector<double> module_traction_commands_;
+  std::vector<double> module_steering_commands_;
+
+  // rate of the state with the telemetry rate policy of the process applied
+  std::shared_ptr<telemetry_rate_policy::TelemetryRate> publish_rate_;
+  // decimates the controller state under load, nullptr if cycle_budget.enable is off
+  std::unique_ptr<update_time_statistics::CycleBudget> cycle_budget_;
 
   // name constants for state interfaces
   size_t nr_state_itfs_;
@@ -135,6 +183,12 @@ protected:
   // store last velocity
   double last_linear_velocity_ = 0.0;
   double last_angular_velocity_ = 0.0;
+  // velocity before the last one, for the jerk limits
+  double previous_linear_velocity_ = 0.0;
+  double previous_angular_velocity_ = 0.0;
+
+  // limits the linear and the angular velocity together
+  motion_limits::AxisLimiter<2> limiter_;
 
   std::vector<std::string> rear_wheels_state_names_;
   std::vector<std::string> front_wheels_state_names_;
@@ -144,6 +198,17 @@ private:
   STEERING_CONTROLLERS__VISIBILITY_LOCAL void reference_callback(
     const std::shared_ptr<ControllerTwistReferenceMsg> msg);
   void reference_callback_unstamped(const std::shared_ptr<geometry_msgs::msg::Twist> msg);
+
+  /// Store a NaN reference with the current time, not realtime-safe
+  void reset_reference();
+
+  /// Whether the state is published at \p time, at the rate of publish_rate_
+  bool should_publish_state(const rclcpp::Time & time);
+  /// Publish the state in bounded_controller_state_publisher_, loaned if possible, realtime-safe
+  void publish_bounded_controller_state(const rclcpp::Time & time);
+
+  /// Continue from the persisted odometry, if there is a recent one
+  void restore_odometry();
 };
 
 }  // namespace steering_controllers_library
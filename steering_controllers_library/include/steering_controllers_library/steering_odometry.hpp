@@ -18,19 +18,32 @@
 #ifndef STEERING_CONTROLLERS_LIBRARY__STEERING_ODOMETRY_HPP_
 #define STEERING_CONTROLLERS_LIBRARY__STEERING_ODOMETRY_HPP_
 
-#include <tuple>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
 #include <vector>
 
 #include "realtime_tools/realtime_buffer.h"
 #include "realtime_tools/realtime_publisher.h"
 
+#include "odometry_integration/pose_integrator.hpp"
 #include "rcpputils/rolling_mean_accumulator.hpp"
+#include "steering_controllers_library/fast_trigonometry.hpp"
+#include "steering_controllers_library/wheel_module_kinematics.hpp"
 
 namespace steering_odometry
 {
 const unsigned int BICYCLE_CONFIG = 0;
 const unsigned int TRICYCLE_CONFIG = 1;
 const unsigned int ACKERMANN_CONFIG = 2;
+/// Any number of wheel modules, set by SteeringOdometry::set_wheel_modules()
+const unsigned int WHEEL_MODULES_CONFIG = 3;
+
+/// Maximum number of traction or steering joints of all configurations
+constexpr size_t MAX_JOINTS_PER_AXLE = 2;
+/// Commands of the traction or steering joints, only the joints of the configuration are written
+using AxleCommands = std::array<double, MAX_JOINTS_PER_AXLE>;
 /**
  * \brief The Odometry class handles odometry readings
  * (2D pose and velocity with related timestamp)
@@ -123,6 +136,28 @@ public:
     const double right_traction_wheel_vel, const double left_traction_wheel_vel,
     const double right_steer_pos, const double left_steer_pos, const double dt);
 
+  /**
+   * \brief Updates the odometry class with latest wheel module positions
+   * \param traction_wheels_pos Positions of the driven wheels [rad]
+   * \param steers_pos Positions of the steered wheels [rad]
+   * \param dt      time difference to last call
+   * \return true if the odometry is actually updated
+   */
+  bool update_from_module_position(
+    const std::vector<double> & traction_wheels_pos, const std::vector<double> & steers_pos,
+    const double dt);
+
+  /**
+   * \brief Updates the odometry class with latest wheel module velocities
+   * \param traction_wheels_vel Velocities of the driven wheels [rad/s]
+   * \param steers_pos Positions of the steered wheels [rad]
+   * \param dt      time difference to last call
+   * \return true if the odometry is actually updated
+   */
+  bool update_from_module_velocity(
+    const std::vector<double> & traction_wheels_vel, const std::vector<double> & steers_pos,
+    const double dt);
+
   /**
    * \brief Updates the odometry class with latest velocity command
    * \param linear  Linear velocity [m/s]
@@ -132,28 +167,49 @@ public:
   void update_open_loop(const double linear, const double angular, const double dt);
 
   /**
-   * \brief Set odometry type
+   * \brief Set odometry type, which selects the kinematics of get_commands()
    * \param type odometry type
+   * \return false if the type is unknown
    */
-  void set_odometry_type(const unsigned int type);
+  bool set_odometry_type(const unsigned int type);
+
+  /**
+   * \brief Use the kinematics of \p modules, not realtime-safe
+   *
+   * The traction values are ordered like the driven modules, the steering values like the steered
+   * modules.
+   */
+  void set_wheel_modules(const std::vector<WheelModule> & modules);
+
+  /**
+   * \brief wheel module kinematics getter
+   * \return kinematics set by set_wheel_modules()
+   */
+  const WheelModuleKinematics & get_wheel_modules() const { return wheel_modules_; }
+
+  /**
+   * \brief Odometry type getter
+   * \return type of the odometry, -1 if none is set
+   */
+  int get_odometry_type() const { return config_type_; }
 
   /**
    * \brief heading getter
    * \return heading [rad]
    */
-  double get_heading() const { return heading_; }
+  double get_heading() const { return pose_.heading(); }
 
   /**
    * \brief x position getter
    * \return x position [m]
    */
-  double get_x() const { return x_; }
+  double get_x() const { return pose_.x(); }
 
   /**
    * \brief y position getter
    * \return y position [m]
    */
-  double get_y() const { return y_; }
+  double get_y() const { return pose_.y(); }
 
   /**
    * \brief linear velocity getter
@@ -161,6 +217,12 @@ public:
    */
   double get_linear() const { return linear_; }
 
+  /**
+   * \brief lateral velocity getter
+   * \return lateral velocity [m/s], only wheel modules can move sideways
+   */
+  double get_lateral() const { return lateral_; }
+
   /**
    * \brief angular velocity getter
    * \return angular velocity [rad/s]
@@ -172,6 +234,19 @@ public:
    */
   void set_wheel_params(double wheel_radius, double wheelbase = 0.0, double wheel_track = 0.0);
 
+  /**
+   * \brief Integrate each update in \p substeps steps, with the velocities changing linearly from
+   * the ones of the previous update. Not used by open loop and wheel module odometry.
+   * \param substeps number of steps, 1 integrates each update in one step
+   */
+  void set_integration_substeps(unsigned int substeps) { integration_substeps_ = substeps; }
+
+  /**
+   * \brief Use the polynomial approximations of fast_trigonometry in the steering kinematics
+   * \param fast_trigonometry if false, the exact functions are used
+   */
+  void set_fast_trigonometry(bool fast_trigonometry) { fast_trigonometry_ = fast_trigonometry; }
+
   /**
    * \brief Velocity rolling window size setter
    * \param velocity_rolling_window_size Velocity rolling window size
@@ -182,40 +257,64 @@ public:
    * \brief Calculates inverse kinematics for the desired linear and angular velocities
    * \param Vx  Desired linear velocity [m/s]
    * \param theta_dot Desired angular velocity [rad/s]
-   * \return Tuple of velocity commands and steering commands
+   * \param[out] traction_commands velocity commands of the traction joints, the right one first
+   * \param[out] steering_commands position commands of the steering joints, the right one first
+   * \return false if no odometry type is set
+   */
+  bool get_commands(
+    const double Vx, const double theta_dot, AxleCommands & traction_commands,
+    AxleCommands & steering_commands);
+
+  /**
+   * \brief Calculates inverse kinematics of the wheel modules for the desired body twist
+   * \param Vx  Desired linear velocity [m/s]
+   * \param Vy  Desired lateral velocity [m/s]
+   * \param theta_dot Desired angular velocity [rad/s]
+   * \param[out] traction_commands velocity commands of the driven wheels, sized by the caller
+   * \param[in,out] steering_commands position commands of the steered wheels, sized by the caller
+   * \return false if the wheel modules are not set
    */
-  std::tuple<std::vector<double>, std::vector<double>> get_commands(
-    const double Vx, const double theta_dot);
+  bool get_module_commands(
+    const double Vx, const double Vy, const double theta_dot,
+    std::vector<double> & traction_commands, std::vector<double> & steering_commands) const;
 
   /**
    *  \brief Reset poses, heading, and accumulators
    */
   void reset_odometry();
 
-private:
   /**
-   * \brief Uses precomputed linear and angular velocities to compute dometry and update
-   * accumulators \param linear  Linear  velocity   [m] (linear  displacement, i.e. m/s * dt)
-   * computed by previous odometry method \param angular Angular velocity [rad] (angular
-   * displacement, i.e. m/s * dt) computed by previous odometry method
+   * \brief Last traction wheel positions of the position updates, e.g. to persist the odometry
+   * \param[out] positions single, right and left traction wheel [m] of the axle configurations,
+   * the driven wheels [rad] of the wheel modules
+   * \param capacity size of \p positions
+   * \return number of positions, 0 if they don't fit into \p positions
    */
-  bool update_odometry(const double linear_velocity, const double angular, const double dt);
+  size_t get_wheel_positions(double * positions, size_t capacity) const;
 
   /**
-   * \brief Integrates the velocities (linear and angular) using 2nd order Runge-Kutta
-   * \param linear  Linear  velocity   [m] (linear  displacement, i.e. m/s * dt) computed by
-   * encoders \param angular Angular velocity [rad] (angular displacement, i.e. m/s * dt) computed
-   * by encoders
+   * \brief Continue from a persisted odometry
+   *
+   * The velocities seed the rolling means. The next position update continues from the
+   * \p wheel_positions of get_wheel_positions() if no wheel turned more than
+   * \p max_wheel_rotation [rad] since, and from its own positions otherwise, e.g. after the
+   * encoders were reset.
+   * \return false if the number of wheel positions doesn't match the configuration, the pose and
+   * the velocities are restored anyway
    */
-  void integrate_runge_kutta_2(double linear, double angular);
+  bool restore(
+    double x, double y, double heading, double linear, double lateral, double angular,
+    const double * wheel_positions, size_t num_wheel_positions, double max_wheel_rotation);
 
+private:
   /**
-   * \brief Integrates the velocities (linear and angular) using exact method
-   * \param linear  Linear  velocity   [m] (linear  displacement, i.e. m/s * dt) computed by
-   * encoders \param angular Angular velocity [rad] (angular displacement, i.e. m/s * dt) computed
-   * by encoders
+   * \brief Uses precomputed linear and angular velocities to compute odometry and update
+   * accumulators
+   * \param linear_velocity Linear velocity [m/s] computed by previous odometry method
+   * \param angular Angular velocity [rad/s] computed by previous odometry method
+   * \param dt time difference to last call
    */
-  void integrate_exact(double linear, double angular);
+  bool update_odometry(const double linear_velocity, const double angular, const double dt);
 
   /**
    * \brief Calculates steering angle from the desired translational and rotational velocity
@@ -224,22 +323,73 @@ private:
    */
   double convert_trans_rot_vel_to_steering_angle(double Vx, double theta_dot);
 
+  /**
+   * \brief Uses the twist fitted to the wheel modules to compute odometry and update accumulators
+   * \param traction_wheels_vel Velocities of the driven wheels [rad/s]
+   * \param steers_pos Positions of the steered wheels [rad]
+   */
+  bool update_module_odometry(
+    const std::vector<double> & traction_wheels_vel, const std::vector<double> & steers_pos,
+    const double dt);
+
   /**
    *  \brief Reset linear and angular accumulators
    */
   void reset_accumulators();
 
+  /// Whether a wheel turned further than allowed since restore(), \p radius converts to [rad]
+  bool turned_since_restore(double current, double old, double radius) const
+  {
+    return std::fabs(current - old) > restored_max_wheel_rotation_ * radius;
+  }
+
+  /// Trigonometric functions of the steering kinematics, exact or approximated
+  double sin_of(double x) const
+  {
+    return fast_trigonometry_ ? fast_trigonometry::sin(x) : std::sin(x);
+  }
+  double cos_of(double x) const
+  {
+    return fast_trigonometry_ ? fast_trigonometry::cos(x) : std::cos(x);
+  }
+  double tan_of(double x) const
+  {
+    return fast_trigonometry_ ? fast_trigonometry::tan(x) : std::tan(x);
+  }
+  double atan_of(double x) const
+  {
+    return fast_trigonometry_ ? fast_trigonometry::atan(x) : std::atan(x);
+  }
+  double atan2_of(double y, double x) const
+  {
+    return fast_trigonometry_ ? fast_trigonometry::atan2(y, x) : std::atan2(y, x);
+  }
+
+  /**
+   * \brief Commands of the joints of the configuration \p CONFIG_TYPE
+   * \param Ws  Velocity of the middle of the traction axle [rad/s]
+   * \param alpha Steering angle of the middle of the steering axle [rad]
+   */
+  template <unsigned int CONFIG_TYPE>
+  void compute_commands(
+    const double Ws, const double alpha, AxleCommands & traction_commands,
+    AxleCommands & steering_commands) const;
+
   /// Current timestamp:
   rclcpp::Time timestamp_;
 
   /// Current pose:
-  double x_;          //   [m]
-  double y_;          //   [m]
+  odometry_integration::PoseIntegrator<> pose_;
   double steer_pos_;  // [rad]
-  double heading_;    // [rad]
+
+  /// Sub-steps of the integration, and the velocities of the previous update
+  unsigned int integration_substeps_ = 1;
+  double previous_linear_velocity_ = 0.0;   //   [m/s]
+  double previous_angular_velocity_ = 0.0;  // [rad/s]
 
   /// Current velocity:
   double linear_;   //   [m/s]
+  double lateral_;  //   [m/s]
   double angular_;  // [rad/s]
 
   /// Kinematic parameters
@@ -249,14 +399,27 @@ private:
 
   /// Configuration type used for the forward kinematics
   int config_type_ = -1;
+  bool fast_trigonometry_ = false;
+  /// Kinematics of the configuration, selected once by set_odometry_type()
+  void (SteeringOdometry::*compute_commands_)(
+    const double, const double, AxleCommands &, AxleCommands &) const = nullptr;
 
   /// Previous wheel position/state [rad]:
   double traction_wheel_old_pos_;
   double traction_right_wheel_old_pos_;
   double traction_left_wheel_old_pos_;
+
+  /// Wheel modules, previous positions and velocities of their driven wheels
+  WheelModuleKinematics wheel_modules_;
+  std::vector<double> traction_wheels_old_pos_;
+  std::vector<double> traction_wheels_vel_;
+  /// Rotation [rad] up to which the next position update continues from the restored positions,
+  /// infinite without restore()
+  double restored_max_wheel_rotation_ = std::numeric_limits<double>::infinity();
   /// Rolling mean accumulators for the linear and angular velocities:
   size_t velocity_rolling_window_size_;
   rcpputils::RollingMeanAccumulator<double> linear_acc_;
+  rcpputils::RollingMeanAccumulator<double> lateral_acc_;
   rcpputils::RollingMeanAccumulator<double> angular_acc_;
 };
 }  // namespace steering_odometry
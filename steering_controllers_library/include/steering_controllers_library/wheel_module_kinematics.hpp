@@ -0,0 +1,101 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STEERING_CONTROLLERS_LIBRARY__WHEEL_MODULE_KINEMATICS_HPP_
+#define STEERING_CONTROLLERS_LIBRARY__WHEEL_MODULE_KINEMATICS_HPP_
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace steering_odometry
+{
+/// Wheel of a vehicle with any number of steered and driven wheels, e.g. 4WS or swerve drives
+struct WheelModule
+{
+  /// Position of the contact point of the wheel in the base frame [m]
+  double x = 0.0;
+  double y = 0.0;
+  /// Radius of the wheel [m]
+  double radius = 0.0;
+  /// Whether the wheel has a steering joint, otherwise it points forward
+  bool steerable = false;
+  /// Whether the wheel has a traction joint, otherwise it rolls freely
+  bool driven = false;
+};
+
+/**
+ * \brief Planar kinematics of a vehicle made of wheel modules.
+ *
+ * The body twist is the least-squares fit to the rolling speed of all driven wheels and to the
+ * rolling constraint of all wheels, i.e. that no wheel slips sideways. The inverse kinematics
+ * steers each wheel along the velocity of its contact point. The geometry is stored per module in
+ * contiguous arrays, only configure() allocates memory.
+ *
+ * Traction values are ordered like the driven modules, steering values like the steerable modules.
+ */
+class WheelModuleKinematics
+{
+public:
+  /// Set the wheel modules, not realtime-safe
+  void configure(const std::vector<WheelModule> & modules);
+
+  size_t size() const { return x_.size(); }
+  size_t num_driven() const { return num_driven_; }
+  size_t num_steerable() const { return num_steerable_; }
+
+  /**
+   * Least-squares fit of the body twist to the state of the wheels.
+   *
+   * \param[in] traction_velocities velocities of the driven wheels [rad/s]
+   * \param[in] steering_positions positions of the steered wheels [rad]
+   * \param[out] linear, lateral velocity of the body along x and y [m/s]
+   * \param[out] angular velocity of the body around z [rad/s]
+   * \return false if an input is NaN or the twist is not observable from the wheels
+   */
+  bool fit(
+    const std::vector<double> & traction_velocities, const std::vector<double> & steering_positions,
+    double & linear, double & lateral, double & angular) const;
+
+  /**
+   * Steering and traction commands of all wheels for a body twist.
+   *
+   * A wheel whose contact point does not move keeps its steering position. Steering positions stay
+   * within [-pi/2, pi/2], the wheel drives backwards instead.
+   *
+   * \param[in,out] steering_commands positions of the steered wheels [rad], previous commands on
+   * input
+   * \param[out] traction_commands velocities of the driven wheels [rad/s]
+   */
+  void compute_commands(
+    double linear, double lateral, double angular, std::vector<double> & traction_commands,
+    std::vector<double> & steering_commands) const;
+
+private:
+  static constexpr size_t NO_VALUE = std::numeric_limits<size_t>::max();
+
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> radius_;
+  // index of the steering value of each module, NO_VALUE if it does not steer
+  std::vector<size_t> steering_index_;
+  // index of the traction value of each module, NO_VALUE if it is not driven
+  std::vector<size_t> traction_index_;
+  size_t num_driven_ = 0;
+  size_t num_steerable_ = 0;
+};
+
+}  // namespace steering_odometry
+
+#endif  // STEERING_CONTROLLERS_LIBRARY__WHEEL_MODULE_KINEMATICS_HPP_
@@ -14,9 +14,13 @@
 
 #include "steering_controllers_library/steering_controllers_library.hpp"
 
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <queue>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -24,30 +28,11 @@
 #include "controller_interface/helpers.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
+#include "motion_limits/speed_limits.hpp"
+#include "publisher_pool/publisher_qos.hpp"
 #include "tf2/transform_datatypes.h"
 #include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
 
-namespace
-{  // utility
-
-using ControllerTwistReferenceMsg =
-  steering_controllers_library::SteeringControllersLibrary::ControllerTwistReferenceMsg;
-
-// called from RT control loop
-void reset_controller_reference_msg(
-  const std::shared_ptr<ControllerTwistReferenceMsg> & msg,
-  const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node)
-{
-  msg->header.stamp = node->now();
-  msg->twist.linear.x = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.linear.y = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.linear.z = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.angular.x = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.angular.y = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.angular.z = std::numeric_limits<double>::quiet_NaN();
-}
-
-}  // namespace
 
 namespace steering_controllers_library
 {
@@ -86,8 +71,70 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
 {
   params_ = param_listener_->get_params();
   odometry_.set_velocity_rolling_window_size(params_.velocity_rolling_window_size);
+  odometry_.set_fast_trigonometry(params_.fast_trigonometry);
+  odometry_.set_integration_substeps(static_cast<unsigned int>(params_.integration_substeps));
 
-  configure_odometry();
+  if (configure_odometry() != controller_interface::CallbackReturn::SUCCESS)
+  {
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  number_of_traction_wheels_ = params_.rear_wheels_names.size();
+  number_of_steering_wheels_ = params_.front_wheels_names.size();
+  if (!params_.front_steering)
+  {
+    std::swap(number_of_traction_wheels_, number_of_steering_wheels_);
+  }
+  if (odometry_.get_odometry_type() == static_cast<int>(steering_odometry::WHEEL_MODULES_CONFIG))
+  {
+    const auto & wheel_modules = odometry_.get_wheel_modules();
+    if (
+      number_of_traction_wheels_ != wheel_modules.num_driven() ||
+      number_of_steering_wheels_ != wheel_modules.num_steerable())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "The wheel modules have %zu traction and %zu steering joints, but %zu and %zu are named.",
+        wheel_modules.num_driven(), wheel_modules.num_steerable(), number_of_traction_wheels_,
+        number_of_steering_wheels_);
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+  else if (
+    number_of_traction_wheels_ > steering_odometry::MAX_JOINTS_PER_AXLE ||
+    number_of_steering_wheels_ > steering_odometry::MAX_JOINTS_PER_AXLE)
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "At most %zu traction and steering joints are supported.",
+      steering_odometry::MAX_JOINTS_PER_AXLE);
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  module_traction_commands_.assign(number_of_traction_wheels_, 0.0);
+  module_steering_commands_.assign(number_of_steering_wheels_, 0.0);
+
+  try
+  {
+    limiter_ = motion_limits::AxisLimiter<2>();
+    limiter_.set_limits(
+      0, motion_limits::make_speed_limits(
+           params_.linear.x.has_velocity_limits, params_.linear.x.has_acceleration_limits,
+           params_.linear.x.has_jerk_limits, params_.linear.x.min_velocity,
+           params_.linear.x.max_velocity, params_.linear.x.min_acceleration,
+           params_.linear.x.max_acceleration, params_.linear.x.min_jerk,
+           params_.linear.x.max_jerk));
+    limiter_.set_limits(
+      1, motion_limits::make_speed_limits(
+           params_.angular.z.has_velocity_limits, params_.angular.z.has_acceleration_limits,
+           params_.angular.z.has_jerk_limits, params_.angular.z.min_velocity,
+           params_.angular.z.max_velocity, params_.angular.z.min_acceleration,
+           params_.angular.z.max_acceleration, params_.angular.z.min_jerk,
+           params_.angular.z.max_jerk));
+  }
+  catch (const std::runtime_error & e)
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Invalid velocity limits: %s", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
 
   if (!params_.rear_wheels_state_names.empty())
   {
@@ -128,17 +175,18 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
         &SteeringControllersLibrary::reference_callback_unstamped, this, std::placeholders::_1));
   }
 
-  std::shared_ptr<ControllerTwistReferenceMsg> msg =
-    std::make_shared<ControllerTwistReferenceMsg>();
-  reset_controller_reference_msg(msg, get_node());
-  input_ref_.writeFromNonRT(msg);
+  reset_reference();
 
+  std::shared_ptr<publisher_pool::PublisherPool> pool;
   try
   {
+    pool = publisher_pool::get_shared_pool(params_.publisher_pool);
     // Odom state publisher
     odom_s_publisher_ = get_node()->create_publisher<ControllerStateMsgOdom>(
-      "~/odometry", rclcpp::SystemDefaultsQoS());
-    rt_odom_state_publisher_ = std::make_unique<ControllerStatePublisherOdom>(odom_s_publisher_);
+      "~/odometry", publisher_pool::make_qos(params_.qos.odometry));
+    rt_odom_state_publisher_ = std::make_unique<ControllerStatePublisherOdom>(
+      odom_s_publisher_, pool, params_.publish_unique_ptr,
+      static_cast<size_t>(params_.publisher_pool.queue_depth));
   }
   catch (const std::exception & e)
   {
@@ -169,9 +217,10 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
   {
     // Tf State publisher
     tf_odom_s_publisher_ = get_node()->create_publisher<ControllerStateMsgTf>(
-      "~/tf_odometry", rclcpp::SystemDefaultsQoS());
-    rt_tf_odom_state_publisher_ =
-      std::make_unique<ControllerStatePublisherTf>(tf_odom_s_publisher_);
+      "~/tf_odometry", publisher_pool::make_qos(params_.qos.tf_odometry));
+    rt_tf_odom_state_publisher_ = std::make_unique<ControllerStatePublisherTf>(
+      tf_odom_s_publisher_, pool, params_.publish_unique_ptr,
+      static_cast<size_t>(params_.publisher_pool.queue_depth));
   }
   catch (const std::exception & e)
   {
@@ -189,13 +238,45 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
   rt_tf_odom_state_publisher_->msg_.transforms[0].transform.translation.z = 0.0;
   rt_tf_odom_state_publisher_->unlock();
 
+  odom_transform_slot_.reset();
+  if (params_.enable_odom_tf && params_.aggregate_odom_tf)
+  {
+    odom_transform_slot_ = tf_aggregator::TransformAggregator::get_instance()->register_transform(
+      get_node()->get_namespace(), params_.odom_frame_id, params_.base_frame_id);
+  }
+
+  odometry_slot_.reset();
+  if (params_.export_odometry)
+  {
+    odometry_slot_ = odometry_exchange::OdometryExchange::get_instance().get_slot(
+      get_node()->get_fully_qualified_name());
+  }
+
+  odometry_snapshot_writer_.reset();
+  if (params_.odometry_persistence.enable)
+  {
+    if (params_.odometry_persistence.path.empty())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "odometry_persistence.path has to be set if odometry_persistence.enable is set");
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    odometry_snapshot_writer_ = std::make_unique<odometry_persistence::SnapshotWriter>(
+      params_.odometry_persistence.path,
+      std::chrono::nanoseconds(
+        static_cast<int64_t>(params_.odometry_persistence.period * 1e9)),
+      [logger = get_node()->get_logger()](const std::string & error)
+      { RCLCPP_WARN(logger, "Failed to persist the odometry: %s", error.c_str()); });
+  }
+
   try
   {
     // State publisher
     controller_s_publisher_ = get_node()->create_publisher<AckermanControllerState>(
-      "~/controller_state", rclcpp::SystemDefaultsQoS());
-    controller_state_publisher_ =
-      std::make_unique<ControllerStatePublisher>(controller_s_publisher_);
+      "~/controller_state", publisher_pool::make_qos(params_.qos.controller_state));
+    controller_state_publisher_ = std::make_unique<ControllerStatePublisher>(
+      controller_s_publisher_, pool, params_.publish_unique_ptr);
   }
   catch (const std::exception & e)
   {
@@ -208,7 +289,61 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
   controller_state_publisher_->lock();
   controller_state_publisher_->msg_.header.stamp = get_node()->now();
   controller_state_publisher_->msg_.header.frame_id = params_.odom_frame_id;
+  // sized once, update_and_write_commands() only writes the values
+  controller_state_publisher_->msg_.traction_wheels_position.assign(
+    params_.position_feedback ? number_of_traction_wheels_ : 0, 0.0);
+  controller_state_publisher_->msg_.traction_wheels_velocity.assign(
+    params_.position_feedback ? 0 : number_of_traction_wheels_, 0.0);
+  controller_state_publisher_->msg_.linear_velocity_command.assign(
+    number_of_traction_wheels_, 0.0);
+  controller_state_publisher_->msg_.steer_positions.assign(number_of_steering_wheels_, 0.0);
+  controller_state_publisher_->msg_.steering_angle_command.assign(
+    number_of_steering_wheels_, 0.0);
   controller_state_publisher_->unlock();
+
+  bounded_controller_state_publisher_.reset();
+  bounded_controller_state_names_publisher_.reset();
+  if (params_.bounded_controller_state.enable)
+  {
+    if (
+      number_of_traction_wheels_ > BoundedControllerState::MAX_WHEELS ||
+      number_of_steering_wheels_ > BoundedControllerState::MAX_WHEELS)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "The bounded controller state holds at most %u traction and steering wheels each.",
+        BoundedControllerState::MAX_WHEELS);
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    // without loans, a copy is published outside of the update like the controller state
+    bounded_controller_state_publisher_ =
+      std::make_unique<publisher_pool::LoanedPublisher<BoundedControllerState>>(
+        get_node()->create_publisher<BoundedControllerState>(
+          "~/bounded_controller_state", publisher_pool::make_qos(params_.qos.controller_state)),
+        pool, params_.publish_unique_ptr);
+    // the names are only sent once, late subscribers still get them
+    bounded_controller_state_names_publisher_ =
+      get_node()->create_publisher<sensor_msgs::msg::JointState>(
+        "~/bounded_controller_state/names", rclcpp::QoS(1).reliable().transient_local());
+    const auto & traction_names =
+      params_.front_steering ? rear_wheels_state_names_ : front_wheels_state_names_;
+    const auto & steering_names =
+      params_.front_steering ? front_wheels_state_names_ : rear_wheels_state_names_;
+    sensor_msgs::msg::JointState names_msg;
+    names_msg.header.stamp = get_node()->now();
+    names_msg.name = traction_names;
+    names_msg.name.insert(names_msg.name.end(), steering_names.begin(), steering_names.end());
+    bounded_controller_state_names_publisher_->publish(names_msg);
+    RCLCPP_INFO(
+      get_node()->get_logger(), "The middleware %s loan the bounded controller state.",
+      bounded_controller_state_publisher_->is_loaning() ? "does" : "doesn't");
+  }
+
+  // one rate for the odometry, its transform and the controller state
+  publish_rate_ = telemetry_rate_policy::TelemetryRatePolicy::get_instance()->register_topic(
+    get_node()->get_namespace(), odom_s_publisher_->get_topic_name(), params_.state_publish_rate);
+  cycle_budget_ = update_time_statistics::make_cycle_budget(
+    params_.cycle_budget, static_cast<double>(get_update_rate()));
   RCLCPP_INFO(get_node()->get_logger(), "configure successful");
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -216,19 +351,23 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
 void SteeringControllersLibrary::reference_callback(
   const std::shared_ptr<ControllerTwistReferenceMsg> msg)
 {
+  // the time of the last update, not of the node clock, so the controller follows only the time
+  // of the controller manager
+  const auto now = update_time_.now(*get_node()->get_clock());
   // if no timestamp provided use current time for command timestamp
   if (msg->header.stamp.sec == 0 && msg->header.stamp.nanosec == 0u)
   {
     RCLCPP_WARN(
       get_node()->get_logger(),
       "Timestamp in header is missing, using current time as command timestamp.");
-    msg->header.stamp = get_node()->now();
+    msg->header.stamp = now;
   }
-  const auto age_of_last_command = get_node()->now() - msg->header.stamp;
+  const auto age_of_last_command = now - msg->header.stamp;
 
   if (ref_timeout_ == rclcpp::Duration::from_seconds(0) || age_of_last_command <= ref_timeout_)
   {
-    input_ref_.writeFromNonRT(msg);
+    input_ref_.write(
+      {rclcpp::Time(msg->header.stamp).nanoseconds(), msg->twist.linear.x, msg->twist.angular.z});
   }
   else
   {
@@ -249,32 +388,18 @@ void SteeringControllersLibrary::reference_callback_unstamped(
     "Use of Twist message without stamped is deprecated and it will be removed in ROS 2 J-Turtle "
     "version. Use '~/reference' topic with 'geometry_msgs::msg::TwistStamped' message type in the "
     "future.");
-  auto twist_stamped = *(input_ref_.readFromNonRT());
-  twist_stamped->header.stamp = get_node()->now();
-  // if no timestamp provided use current time for command timestamp
-  if (twist_stamped->header.stamp.sec == 0 && twist_stamped->header.stamp.nanosec == 0u)
-  {
-    RCLCPP_WARN(
-      get_node()->get_logger(),
-      "Timestamp in header is missing, using current time as command timestamp.");
-    twist_stamped->header.stamp = get_node()->now();
-  }
-
-  const auto age_of_last_command = get_node()->now() - twist_stamped->header.stamp;
+  // the time of reception is the command timestamp, so the reference is never too old here
+  input_ref_.write(
+    {update_time_.now(*get_node()->get_clock()).nanoseconds(), msg->linear.x, msg->angular.z});
+}
 
-  if (ref_timeout_ == rclcpp::Duration::from_seconds(0) || age_of_last_command <= ref_timeout_)
-  {
-    twist_stamped->twist = *msg;
-  }
-  else
-  {
-    RCLCPP_ERROR(
-      get_node()->get_logger(),
-      "Received message has timestamp %.10f older for %.10f which is more then allowed timeout "
-      "(%.4f).",
-      rclcpp::Time(twist_stamped->header.stamp).seconds(), age_of_last_command.seconds(),
-      ref_timeout_.seconds());
-  }
+void SteeringControllersLibrary::reset_reference()
+{
+  input_ref_.write({update_time_.now(*get_node()->get_clock()).nanoseconds(),
+                    std::numeric_limits<double>::quiet_NaN(),
+                    std::numeric_limits<double>::quiet_NaN()});
+  current_ref_ = StampedVelocityReference();
+  current_ref_version_ = 0;
 }
 
 controller_interface::InterfaceConfiguration
@@ -386,7 +511,23 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_activate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   // Set default value in command
-  reset_controller_reference_msg(*(input_ref_.readFromRT()), get_node());
+  update_time_.reset();
+  reset_reference();
+
+  // the limiters start from standstill
+  last_linear_velocity_ = 0.0;
+  last_angular_velocity_ = 0.0;
+  previous_linear_velocity_ = 0.0;
+  previous_angular_velocity_ = 0.0;
+  publish_rate_->reset();
+  if (cycle_budget_)
+  {
+    cycle_budget_->reset();
+  }
+  if (odometry_snapshot_writer_)
+  {
+    restore_odometry();
+  }
 
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -398,32 +539,73 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_deactivate(
   {
     command_interfaces_[i].set_value(std::numeric_limits<double>::quiet_NaN());
   }
+  if (odometry_snapshot_writer_)
+  {
+    // the next activation continues from the last update
+    odometry_snapshot_writer_->flush();
+  }
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
+void SteeringControllersLibrary::restore_odometry()
+{
+  const auto & persistence = params_.odometry_persistence;
+  odometry_persistence::OdometrySnapshot snapshot;
+  std::string error;
+  if (!odometry_persistence::load_snapshot(persistence.path, snapshot, error))
+  {
+    RCLCPP_INFO(get_node()->get_logger(), "Not restoring the odometry: %s", error.c_str());
+    return;
+  }
+  const double age =
+    (get_node()->now() - rclcpp::Time(snapshot.stamp_nanoseconds, RCL_ROS_TIME)).seconds();
+  if (persistence.max_age > 0.0 && age > persistence.max_age)
+  {
+    RCLCPP_INFO(
+      get_node()->get_logger(), "Not restoring the odometry, it is %.1f s old", age);
+    return;
+  }
+
+  if (!odometry_.restore(
+        snapshot.x, snapshot.y, snapshot.heading, snapshot.linear, snapshot.lateral,
+        snapshot.angular, snapshot.wheel_positions.data(), snapshot.num_wheels,
+        persistence.max_wheel_rotation))
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(),
+      "Persisted odometry has %zu wheel positions, continuing from the current ones",
+      snapshot.num_wheels);
+  }
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Restored the odometry at x %f, y %f, heading %f", snapshot.x,
+    snapshot.y, snapshot.heading);
+}
+
 controller_interface::return_type SteeringControllersLibrary::update_reference_from_subscribers(
   const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
 {
-  auto current_ref = *(input_ref_.readFromRT());
-  const auto age_of_last_command = time - (current_ref)->header.stamp;
+  // keep the current reference if there is no new one, or the subscriber is writing right now
+  input_ref_.try_read_newer(current_ref_, current_ref_version_);
+  const auto age_of_last_command =
+    time - rclcpp::Time(current_ref_.stamp_nanoseconds, RCL_ROS_TIME);
 
   // send message only if there is no timeout
   if (age_of_last_command <= ref_timeout_ || ref_timeout_ == rclcpp::Duration::from_seconds(0))
   {
-    if (!std::isnan(current_ref->twist.linear.x) && !std::isnan(current_ref->twist.angular.z))
+    if (!std::isnan(current_ref_.linear) && !std::isnan(current_ref_.angular))
     {
-      reference_interfaces_[0] = current_ref->twist.linear.x;
-      reference_interfaces_[1] = current_ref->twist.angular.z;
+      reference_interfaces_[0] = current_ref_.linear;
+      reference_interfaces_[1] = current_ref_.angular;
     }
   }
   else
   {
-    if (!std::isnan(current_ref->twist.linear.x) && !std::isnan(current_ref->twist.angular.z))
+    if (!std::isnan(current_ref_.linear) && !std::isnan(current_ref_.angular))
     {
       reference_interfaces_[0] = 0.0;
       reference_interfaces_[1] = 0.0;
-      current_ref->twist.linear.x = std::numeric_limits<double>::quiet_NaN();
-      current_ref->twist.angular.z = std::numeric_limits<double>::quiet_NaN();
+      current_ref_.linear = std::numeric_limits<double>::quiet_NaN();
+      current_ref_.angular = std::numeric_limits<double>::quiet_NaN();
     }
   }
 
@@ -433,121 +615,182 @@ controller_interface::return_type SteeringControllersLibrary::update_reference_f
 controller_interface::return_type SteeringControllersLibrary::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
+  update_time_.set(time);
+  update_time_statistics::ScopedCycleBudget cycle_budget_scope(
+    cycle_budget_.get(), period.nanoseconds());
   update_odometry(period);
+  if (odometry_slot_)
+  {
+    // readers in the same cycle get the odometry of this update
+    odometry_slot_->write(
+      {time.nanoseconds(), odometry_.get_x(), odometry_.get_y(), odometry_.get_heading(),
+       odometry_.get_linear(), odometry_.get_lateral(), odometry_.get_angular()});
+  }
+  if (odometry_snapshot_writer_)
+  {
+    odometry_persistence::OdometrySnapshot snapshot;
+    snapshot.stamp_nanoseconds = time.nanoseconds();
+    snapshot.x = odometry_.get_x();
+    snapshot.y = odometry_.get_y();
+    snapshot.heading = odometry_.get_heading();
+    snapshot.linear = odometry_.get_linear();
+    snapshot.lateral = odometry_.get_lateral();
+    snapshot.angular = odometry_.get_angular();
+    snapshot.num_wheels = odometry_.get_wheel_positions(
+      snapshot.wheel_positions.data(), snapshot.wheel_positions.size());
+    odometry_snapshot_writer_->update(snapshot);
+  }
 
   // MOVE ROBOT
 
-  // Limit velocities and accelerations:
-  // TODO(destogl): add limiter for the velocities
-
   if (!std::isnan(reference_interfaces_[0]) && !std::isnan(reference_interfaces_[1]))
   {
+    // Limit velocities and accelerations:
+    std::array<double, 2> velocities{reference_interfaces_[0], reference_interfaces_[1]};
+    limiter_.limit(
+      velocities, {last_linear_velocity_, last_angular_velocity_},
+      {previous_linear_velocity_, previous_angular_velocity_}, period.seconds());
+    const double linear_velocity = velocities[0];
+    const double angular_velocity = velocities[1];
+
     // store and set commands
-    last_linear_velocity_ = reference_interfaces_[0];
-    last_angular_velocity_ = reference_interfaces_[1];
+    previous_linear_velocity_ = last_linear_velocity_;
+    previous_angular_velocity_ = last_angular_velocity_;
+    last_linear_velocity_ = linear_velocity;
+    last_angular_velocity_ = angular_velocity;
 
-    auto [traction_commands, steering_commands] =
-      odometry_.get_commands(last_linear_velocity_, last_angular_velocity_);
-    if (params_.front_steering)
+    if (odometry_.get_odometry_type() == static_cast<int>(steering_odometry::WHEEL_MODULES_CONFIG))
     {
-      for (size_t i = 0; i < params_.rear_wheels_names.size(); i++)
+      // traction joints come first for any position of the steering
+      odometry_.get_module_commands(
+        last_linear_velocity_, 0.0, last_angular_velocity_, module_traction_commands_,
+        module_steering_commands_);
+      for (size_t i = 0; i < number_of_traction_wheels_; ++i)
       {
-        command_interfaces_[i].set_value(traction_commands[i]);
+        command_interfaces_[i].set_value(module_traction_commands_[i]);
       }
-      for (size_t i = 0; i < params_.front_wheels_names.size(); i++)
+      for (size_t i = 0; i < number_of_steering_wheels_; ++i)
       {
-        command_interfaces_[i + params_.rear_wheels_names.size()].set_value(steering_commands[i]);
+        command_interfaces_[number_of_traction_wheels_ + i].set_value(
+          module_steering_commands_[i]);
       }
     }
     else
     {
+      steering_odometry::AxleCommands traction_commands{};
+      steering_odometry::AxleCommands steering_commands{};
+      if (!odometry_.get_commands(
+            last_linear_velocity_, last_angular_velocity_, traction_commands, steering_commands))
       {
-        for (size_t i = 0; i < params_.front_wheels_names.size(); i++)
+        return controller_interface::return_type::ERROR;
+      }
+      if (params_.front_steering)
+      {
+        for (size_t i = 0; i < params_.rear_wheels_names.size(); i++)
         {
           command_interfaces_[i].set_value(traction_commands[i]);
         }
-        for (size_t i = 0; i < params_.rear_wheels_names.size(); i++)
+        for (size_t i = 0; i < params_.front_wheels_names.size(); i++)
+        {
+          command_interfaces_[i + params_.rear_wheels_names.size()].set_value(steering_commands[i]);
+        }
+      }
+      else
+      {
         {
-          command_interfaces_[i + params_.front_wheels_names.size()].set_value(
-            steering_commands[i]);
+          for (size_t i = 0; i < params_.front_wheels_names.size(); i++)
+          {
+            command_interfaces_[i].set_value(traction_commands[i]);
+          }
+          for (size_t i = 0; i < params_.rear_wheels_names.size(); i++)
+          {
+            command_interfaces_[i + params_.front_wheels_names.size()].set_value(
+              steering_commands[i]);
+          }
         }
       }
     }
   }
 
-  // Publish odometry message
-  // Compute and store orientation info
-  tf2::Quaternion orientation;
-  orientation.setRPY(0.0, 0.0, odometry_.get_heading());
-
-  // Populate odom message and publish
-  if (rt_odom_state_publisher_->trylock())
-  {
-    rt_odom_state_publisher_->msg_.header.stamp = time;
-    rt_odom_state_publisher_->msg_.pose.pose.position.x = odometry_.get_x();
-    rt_odom_state_publisher_->msg_.pose.pose.position.y = odometry_.get_y();
-    rt_odom_state_publisher_->msg_.pose.pose.orientation = tf2::toMsg(orientation);
-    rt_odom_state_publisher_->msg_.twist.twist.linear.x = odometry_.get_linear();
-    rt_odom_state_publisher_->msg_.twist.twist.angular.z = odometry_.get_angular();
-    rt_odom_state_publisher_->unlockAndPublish();
-  }
-
-  // Publish tf /odom frame
-  if (params_.enable_odom_tf && rt_tf_odom_state_publisher_->trylock())
-  {
-    rt_tf_odom_state_publisher_->msg_.transforms.front().header.stamp = time;
-    rt_tf_odom_state_publisher_->msg_.transforms.front().transform.translation.x =
-      odometry_.get_x();
-    rt_tf_odom_state_publisher_->msg_.transforms.front().transform.translation.y =
-      odometry_.get_y();
-    rt_tf_odom_state_publisher_->msg_.transforms.front().transform.rotation =
-      tf2::toMsg(orientation);
-    rt_tf_odom_state_publisher_->unlockAndPublish();
-  }
-
-  if (controller_state_publisher_->trylock())
+  if (should_publish_state(time))
   {
-    controller_state_publisher_->msg_.header.stamp = time;
-    controller_state_publisher_->msg_.traction_wheels_position.clear();
-    controller_state_publisher_->msg_.traction_wheels_velocity.clear();
-    controller_state_publisher_->msg_.linear_velocity_command.clear();
-    controller_state_publisher_->msg_.steer_positions.clear();
-    controller_state_publisher_->msg_.steering_angle_command.clear();
+    // Publish odometry message
+    // Compute and store orientation info
+    tf2::Quaternion orientation;
+    orientation.setRPY(0.0, 0.0, odometry_.get_heading());
 
-    auto number_of_traction_wheels = params_.rear_wheels_names.size();
-    auto number_of_steering_wheels = params_.front_wheels_names.size();
+    // Populate odom message and publish
+    if (rt_odom_state_publisher_->trylock())
+    {
+      rt_odom_state_publisher_->msg_.header.stamp = time;
+      rt_odom_state_publisher_->msg_.pose.pose.position.x = odometry_.get_x();
+      rt_odom_state_publisher_->msg_.pose.pose.position.y = odometry_.get_y();
+      rt_odom_state_publisher_->msg_.pose.pose.orientation = tf2::toMsg(orientation);
+      rt_odom_state_publisher_->msg_.twist.twist.linear.x = odometry_.get_linear();
+      rt_odom_state_publisher_->msg_.twist.twist.linear.y = odometry_.get_lateral();
+      rt_odom_state_publisher_->msg_.twist.twist.angular.z = odometry_.get_angular();
+      rt_odom_state_publisher_->unlockAndPublish();
+    }
 
-    if (!params_.front_steering)
+    // Publish tf /odom frame
+    if (odom_transform_slot_)
+    {
+      odom_transform_slot_->set(
+        time, odometry_.get_x(), odometry_.get_y(), odometry_.get_heading());
+    }
+    else if (params_.enable_odom_tf && rt_tf_odom_state_publisher_->trylock())
     {
-      number_of_traction_wheels = params_.front_wheels_names.size();
-      number_of_steering_wheels = params_.rear_wheels_names.size();
+      rt_tf_odom_state_publisher_->msg_.transforms.front().header.stamp = time;
+      rt_tf_odom_state_publisher_->msg_.transforms.front().transform.translation.x =
+        odometry_.get_x();
+      rt_tf_odom_state_publisher_->msg_.transforms.front().transform.translation.y =
+        odometry_.get_y();
+      rt_tf_odom_state_publisher_->msg_.transforms.front().transform.rotation =
+        tf2::toMsg(orientation);
+      rt_tf_odom_state_publisher_->unlockAndPublish();
     }
 
-    for (size_t i = 0; i < number_of_traction_wheels; ++i)
+    // odometry and TF are used for navigation, the controller state is left out under load
+    if (
+      update_time_statistics::allows_optional_work(cycle_budget_.get()) &&
+      controller_state_publisher_->trylock())
     {
-      if (params_.position_feedback)
+      auto & state_message = controller_state_publisher_->msg_;
+      state_message.header.stamp = time;
+
+      auto & traction_wheels_feedback = params_.position_feedback
+                                          ? state_message.traction_wheels_position
+                                          : state_message.traction_wheels_velocity;
+      if (traction_wheels_feedback.size() != number_of_traction_wheels_)
       {
-        controller_state_publisher_->msg_.traction_wheels_position.push_back(
-          state_interfaces_[i].get_value());
+        // position_feedback changed since on_configure()
+        state_message.traction_wheels_position.clear();
+        state_message.traction_wheels_velocity.clear();
+        traction_wheels_feedback.resize(number_of_traction_wheels_);
       }
-      else
+      for (size_t i = 0; i < number_of_traction_wheels_; ++i)
       {
-        controller_state_publisher_->msg_.traction_wheels_velocity.push_back(
-          state_interfaces_[i].get_value());
+        traction_wheels_feedback[i] = state_interfaces_[i].get_value();
+        state_message.linear_velocity_command[i] = command_interfaces_[i].get_value();
       }
-      controller_state_publisher_->msg_.linear_velocity_command.push_back(
-        command_interfaces_[i].get_value());
+
+      for (size_t i = 0; i < number_of_steering_wheels_; ++i)
+      {
+        state_message.steer_positions[i] =
+          state_interfaces_[number_of_traction_wheels_ + i].get_value();
+        state_message.steering_angle_command[i] =
+          command_interfaces_[number_of_traction_wheels_ + i].get_value();
+      }
+
+      controller_state_publisher_->unlockAndPublish();
     }
 
-    for (size_t i = 0; i < number_of_steering_wheels; ++i)
+    if (
+      bounded_controller_state_publisher_ &&
+      update_time_statistics::allows_optional_work(cycle_budget_.get()))
     {
-      controller_state_publisher_->msg_.steer_positions.push_back(
-        state_interfaces_[number_of_traction_wheels + i].get_value());
-      controller_state_publisher_->msg_.steering_angle_command.push_back(
-        command_interfaces_[number_of_traction_wheels + i].get_value());
+      publish_bounded_controller_state(time);
     }
-
-    controller_state_publisher_->unlockAndPublish();
   }
 
   reference_interfaces_[0] = std::numeric_limits<double>::quiet_NaN();
@@ -556,4 +799,39 @@ controller_interface::return_type SteeringControllersLibrary::update_and_write_c
   return controller_interface::return_type::OK;
 }
 
+void SteeringControllersLibrary::publish_bounded_controller_state(const rclcpp::Time & time)
+{
+  // a loaned message is written into the memory of the middleware, neither allocated nor copied,
+  // it is dropped if the middleware has no loan left like a message of a busy realtime publisher
+  bounded_controller_state_publisher_->publish(
+    [this, &time](BoundedControllerState & msg)
+    {
+      msg.stamp = time;
+      msg.traction_size = static_cast<uint32_t>(number_of_traction_wheels_);
+      msg.steering_size = static_cast<uint32_t>(number_of_steering_wheels_);
+      // the traction wheel feedback which isn't used is NaN
+      auto & traction_wheels_feedback =
+        params_.position_feedback ? msg.traction_wheels_position : msg.traction_wheels_velocity;
+      auto & unused_traction_wheels_feedback =
+        params_.position_feedback ? msg.traction_wheels_velocity : msg.traction_wheels_position;
+      for (size_t i = 0; i < number_of_traction_wheels_; ++i)
+      {
+        traction_wheels_feedback[i] = state_interfaces_[i].get_value();
+        unused_traction_wheels_feedback[i] = std::numeric_limits<double>::quiet_NaN();
+        msg.linear_velocity_command[i] = command_interfaces_[i].get_value();
+      }
+      for (size_t i = 0; i < number_of_steering_wheels_; ++i)
+      {
+        msg.steer_positions[i] = state_interfaces_[number_of_traction_wheels_ + i].get_value();
+        msg.steering_angle_command[i] =
+          command_interfaces_[number_of_traction_wheels_ + i].get_value();
+      }
+    });
+}
+
+bool SteeringControllersLibrary::should_publish_state(const rclcpp::Time & time)
+{
+  return publish_rate_->is_due(time);
+}
+
 }  // namespace steering_controllers_library
@@ -19,24 +19,28 @@
 
 #include "steering_controllers_library/steering_odometry.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <iostream>
 
 namespace steering_odometry
 {
 SteeringOdometry::SteeringOdometry(size_t velocity_rolling_window_size)
 : timestamp_(0.0),
-  x_(0.0),
-  y_(0.0),
-  heading_(0.0),
+  steer_pos_(0.0),
   linear_(0.0),
+  lateral_(0.0),
   angular_(0.0),
   wheel_track_(0.0),
   wheelbase_(0.0),
   wheel_radius_(0.0),
   traction_wheel_old_pos_(0.0),
+  traction_right_wheel_old_pos_(0.0),
+  traction_left_wheel_old_pos_(0.0),
   velocity_rolling_window_size_(velocity_rolling_window_size),
   linear_acc_(velocity_rolling_window_size),
+  lateral_acc_(velocity_rolling_window_size),
   angular_acc_(velocity_rolling_window_size)
 {
 }
@@ -46,13 +50,19 @@ void SteeringOdometry::init(const rclcpp::Time & time)
   // Reset accumulators and timestamp:
   reset_accumulators();
   timestamp_ = time;
+  previous_linear_velocity_ = 0.0;
+  previous_angular_velocity_ = 0.0;
 }
 
 bool SteeringOdometry::update_odometry(
   const double linear_velocity, const double angular, const double dt)
 {
   /// Integrate odometry:
-  SteeringOdometry::integrate_exact(linear_velocity * dt, angular);
+  pose_.integrate_substeps(
+    linear_velocity * dt, angular * dt, previous_linear_velocity_ * dt,
+    previous_angular_velocity_ * dt, integration_substeps_);
+  previous_linear_velocity_ = linear_velocity;
+  previous_angular_velocity_ = angular;
 
   /// We cannot estimate the speed with very small time intervals:
   if (dt < 0.0001)
@@ -62,7 +72,7 @@ bool SteeringOdometry::update_odometry(
 
   /// Estimate speeds using a rolling mean to filter them out:
   linear_acc_.accumulate(linear_velocity);
-  angular_acc_.accumulate(angular / dt);
+  angular_acc_.accumulate(angular);
 
   linear_ = linear_acc_.getRollingMean();
   angular_ = angular_acc_.getRollingMean();
@@ -75,6 +85,11 @@ bool SteeringOdometry::update_from_position(
 {
   /// Get current wheel joint positions:
   const double traction_wheel_cur_pos = traction_wheel_pos * wheel_radius_;
+  if (turned_since_restore(traction_wheel_cur_pos, traction_wheel_old_pos_, wheel_radius_))
+  {
+    traction_wheel_old_pos_ = traction_wheel_cur_pos;
+  }
+  restored_max_wheel_rotation_ = std::numeric_limits<double>::infinity();
   const double traction_wheel_est_pos_diff = traction_wheel_cur_pos - traction_wheel_old_pos_;
 
   /// Update old position with current:
@@ -83,7 +98,7 @@ bool SteeringOdometry::update_from_position(
   /// Compute linear and angular diff:
   const double linear_velocity = traction_wheel_est_pos_diff / dt;
   steer_pos_ = steer_pos;
-  const double angular = tan(steer_pos) * linear_velocity / wheelbase_;
+  const double angular = tan_of(steer_pos) * linear_velocity / wheelbase_;
 
   return update_odometry(linear_velocity, angular, dt);
 }
@@ -95,6 +110,15 @@ bool SteeringOdometry::update_from_position(
   /// Get current wheel joint positions:
   const double traction_right_wheel_cur_pos = traction_right_wheel_pos * wheel_radius_;
   const double traction_left_wheel_cur_pos = traction_left_wheel_pos * wheel_radius_;
+  if (
+    turned_since_restore(
+      traction_right_wheel_cur_pos, traction_right_wheel_old_pos_, wheel_radius_) ||
+    turned_since_restore(traction_left_wheel_cur_pos, traction_left_wheel_old_pos_, wheel_radius_))
+  {
+    traction_right_wheel_old_pos_ = traction_right_wheel_cur_pos;
+    traction_left_wheel_old_pos_ = traction_left_wheel_cur_pos;
+  }
+  restored_max_wheel_rotation_ = std::numeric_limits<double>::infinity();
 
   const double traction_right_wheel_est_pos_diff =
     traction_right_wheel_cur_pos - traction_right_wheel_old_pos_;
@@ -108,7 +132,7 @@ bool SteeringOdometry::update_from_position(
   const double linear_velocity =
     (traction_right_wheel_est_pos_diff + traction_left_wheel_est_pos_diff) * 0.5 / dt;
   steer_pos_ = steer_pos;
-  const double angular = tan(steer_pos_) * linear_velocity / wheelbase_;
+  const double angular = tan_of(steer_pos_) * linear_velocity / wheelbase_;
 
   return update_odometry(linear_velocity, angular, dt);
 }
@@ -120,6 +144,15 @@ bool SteeringOdometry::update_from_position(
   /// Get current wheel joint positions:
   const double traction_right_wheel_cur_pos = traction_right_wheel_pos * wheel_radius_;
   const double traction_left_wheel_cur_pos = traction_left_wheel_pos * wheel_radius_;
+  if (
+    turned_since_restore(
+      traction_right_wheel_cur_pos, traction_right_wheel_old_pos_, wheel_radius_) ||
+    turned_since_restore(traction_left_wheel_cur_pos, traction_left_wheel_old_pos_, wheel_radius_))
+  {
+    traction_right_wheel_old_pos_ = traction_right_wheel_cur_pos;
+    traction_left_wheel_old_pos_ = traction_left_wheel_cur_pos;
+  }
+  restored_max_wheel_rotation_ = std::numeric_limits<double>::infinity();
 
   const double traction_right_wheel_est_pos_diff =
     traction_right_wheel_cur_pos - traction_right_wheel_old_pos_;
@@ -134,7 +167,7 @@ bool SteeringOdometry::update_from_position(
   const double linear_velocity =
     (traction_right_wheel_est_pos_diff + traction_left_wheel_est_pos_diff) * 0.5 / dt;
   steer_pos_ = (right_steer_pos + left_steer_pos) * 0.5;
-  const double angular = tan(steer_pos_) * linear_velocity / wheelbase_;
+  const double angular = tan_of(steer_pos_) * linear_velocity / wheelbase_;
 
   return update_odometry(linear_velocity, angular, dt);
 }
@@ -144,7 +177,7 @@ bool SteeringOdometry::update_from_velocity(
 {
   steer_pos_ = steer_pos;
   double linear_velocity = traction_wheel_vel * wheel_radius_;
-  const double angular = tan(steer_pos) * linear_velocity / wheelbase_;
+  const double angular = tan_of(steer_pos) * linear_velocity / wheelbase_;
 
   return update_odometry(linear_velocity, angular, dt);
 }
@@ -157,7 +190,7 @@ bool SteeringOdometry::update_from_velocity(
     (right_traction_wheel_vel + left_traction_wheel_vel) * wheel_radius_ * 0.5;
   steer_pos_ = steer_pos;
 
-  const double angular = tan(steer_pos_) * linear_velocity / wheelbase_;
+  const double angular = tan_of(steer_pos_) * linear_velocity / wheelbase_;
 
   return update_odometry(linear_velocity, angular, dt);
 }
@@ -174,14 +207,86 @@ bool SteeringOdometry::update_from_velocity(
   return update_odometry(linear_velocity, angular, dt);
 }
 
+bool SteeringOdometry::update_module_odometry(
+  const std::vector<double> & traction_wheels_vel, const std::vector<double> & steers_pos,
+  const double dt)
+{
+  double linear_velocity, lateral_velocity, angular_velocity;
+  if (!wheel_modules_.fit(
+        traction_wheels_vel, steers_pos, linear_velocity, lateral_velocity, angular_velocity))
+  {
+    return false;
+  }
+
+  /// Integrate odometry:
+  pose_.integrate_holonomic(linear_velocity * dt, lateral_velocity * dt, angular_velocity * dt);
+
+  /// We cannot estimate the speed with very small time intervals:
+  if (dt < 0.0001)
+  {
+    return false;  // Interval too small to integrate with
+  }
+
+  /// Estimate speeds using a rolling mean to filter them out:
+  linear_acc_.accumulate(linear_velocity);
+  lateral_acc_.accumulate(lateral_velocity);
+  angular_acc_.accumulate(angular_velocity);
+
+  linear_ = linear_acc_.getRollingMean();
+  lateral_ = lateral_acc_.getRollingMean();
+  angular_ = angular_acc_.getRollingMean();
+
+  return true;
+}
+
+bool SteeringOdometry::update_from_module_position(
+  const std::vector<double> & traction_wheels_pos, const std::vector<double> & steers_pos,
+  const double dt)
+{
+  if (dt < 0.0001)
+  {
+    return false;  // Interval too small to compute velocities with
+  }
+  for (const double position : traction_wheels_pos)
+  {
+    if (std::isnan(position))
+    {
+      return false;  // keep the previous positions
+    }
+  }
+  for (size_t i = 0; i < traction_wheels_pos.size(); ++i)
+  {
+    if (turned_since_restore(traction_wheels_pos[i], traction_wheels_old_pos_[i], 1.0))
+    {
+      traction_wheels_old_pos_ = traction_wheels_pos;
+      break;
+    }
+  }
+  restored_max_wheel_rotation_ = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < traction_wheels_pos.size(); ++i)
+  {
+    traction_wheels_vel_[i] = (traction_wheels_pos[i] - traction_wheels_old_pos_[i]) / dt;
+    traction_wheels_old_pos_[i] = traction_wheels_pos[i];
+  }
+  return update_module_odometry(traction_wheels_vel_, steers_pos, dt);
+}
+
+bool SteeringOdometry::update_from_module_velocity(
+  const std::vector<double> & traction_wheels_vel, const std::vector<double> & steers_pos,
+  const double dt)
+{
+  return update_module_odometry(traction_wheels_vel, steers_pos, dt);
+}
+
 void SteeringOdometry::update_open_loop(const double linear, const double angular, const double dt)
 {
   /// Save last linear and angular velocity:
   linear_ = linear;
+  lateral_ = 0.0;
   angular_ = angular;
 
   /// Integrate odometry:
-  SteeringOdometry::integrate_exact(linear * dt, angular * dt);
+  pose_.integrate_exact(linear * dt, angular * dt);
 }
 
 void SteeringOdometry::set_wheel_params(double wheel_radius, double wheelbase, double wheel_track)
@@ -198,7 +303,35 @@ void SteeringOdometry::set_velocity_rolling_window_size(size_t velocity_rolling_
   reset_accumulators();
 }
 
-void SteeringOdometry::set_odometry_type(const unsigned int type) { config_type_ = type; }
+bool SteeringOdometry::set_odometry_type(const unsigned int type)
+{
+  switch (type)
+  {
+    case BICYCLE_CONFIG:
+      compute_commands_ = &SteeringOdometry::compute_commands<BICYCLE_CONFIG>;
+      break;
+    case TRICYCLE_CONFIG:
+      compute_commands_ = &SteeringOdometry::compute_commands<TRICYCLE_CONFIG>;
+      break;
+    case ACKERMANN_CONFIG:
+      compute_commands_ = &SteeringOdometry::compute_commands<ACKERMANN_CONFIG>;
+      break;
+    default:
+      compute_commands_ = nullptr;
+      return false;
+  }
+  config_type_ = static_cast<int>(type);
+  return true;
+}
+
+void SteeringOdometry::set_wheel_modules(const std::vector<WheelModule> & modules)
+{
+  wheel_modules_.configure(modules);
+  traction_wheels_old_pos_.assign(wheel_modules_.num_driven(), 0.0);
+  traction_wheels_vel_.assign(wheel_modules_.num_driven(), 0.0);
+  compute_commands_ = nullptr;
+  config_type_ = static_cast<int>(WHEEL_MODULES_CONFIG);
+}
 
 double SteeringOdometry::convert_trans_rot_vel_to_steering_angle(double Vx, double theta_dot)
 {
@@ -206,12 +339,18 @@ double SteeringOdometry::convert_trans_rot_vel_to_steering_angle(double Vx, doub
   {
     return 0;
   }
-  return std::atan(theta_dot * wheelbase_ / Vx);
+  return atan_of(theta_dot * wheelbase_ / Vx);
 }
 
-std::tuple<std::vector<double>, std::vector<double>> SteeringOdometry::get_commands(
-  const double Vx, const double theta_dot)
+bool SteeringOdometry::get_commands(
+  const double Vx, const double theta_dot, AxleCommands & traction_commands,
+  AxleCommands & steering_commands)
 {
+  if (compute_commands_ == nullptr)
+  {
+    return false;
+  }
+
   // desired velocity and steering angle of the middle of traction and steering axis
   double Ws, alpha;
 
@@ -223,108 +362,139 @@ std::tuple<std::vector<double>, std::vector<double>> SteeringOdometry::get_comma
   else
   {
     alpha = SteeringOdometry::convert_trans_rot_vel_to_steering_angle(Vx, theta_dot);
-    Ws = Vx / (wheel_radius_ * std::cos(steer_pos_));
+    Ws = Vx / (wheel_radius_ * cos_of(steer_pos_));
   }
 
-  if (config_type_ == BICYCLE_CONFIG)
+  (this->*compute_commands_)(Ws, alpha, traction_commands, steering_commands);
+  return true;
+}
+
+template <unsigned int CONFIG_TYPE>
+void SteeringOdometry::compute_commands(
+  const double Ws, const double alpha, AxleCommands & traction_commands,
+  AxleCommands & steering_commands) const
+{
+  if constexpr (CONFIG_TYPE == BICYCLE_CONFIG)
   {
-    std::vector<double> traction_commands = {Ws};
-    std::vector<double> steering_commands = {alpha};
-    return std::make_tuple(traction_commands, steering_commands);
+    traction_commands[0] = Ws;
+    steering_commands[0] = alpha;
   }
-  else if (config_type_ == TRICYCLE_CONFIG)
+  else
   {
-    std::vector<double> traction_commands;
-    std::vector<double> steering_commands;
+    // tricycle and Ackermann configurations have two traction wheels on one axle
     if (fabs(steer_pos_) < 1e-6)
     {
-      traction_commands = {Ws, Ws};
+      traction_commands[0] = Ws;
+      traction_commands[1] = Ws;
     }
     else
     {
-      double turning_radius = wheelbase_ / std::tan(steer_pos_);
-      double Wr = Ws * (turning_radius + wheel_track_ * 0.5) / turning_radius;
-      double Wl = Ws * (turning_radius - wheel_track_ * 0.5) / turning_radius;
-      traction_commands = {Wr, Wl};
+      double turning_radius = wheelbase_ / tan_of(steer_pos_);
+      traction_commands[0] = Ws * (turning_radius + wheel_track_ * 0.5) / turning_radius;
+      traction_commands[1] = Ws * (turning_radius - wheel_track_ * 0.5) / turning_radius;
     }
-    steering_commands = {alpha};
-    return std::make_tuple(traction_commands, steering_commands);
-  }
-  else if (config_type_ == ACKERMANN_CONFIG)
-  {
-    std::vector<double> traction_commands;
-    std::vector<double> steering_commands;
-    if (fabs(steer_pos_) < 1e-6)
+
+    if constexpr (CONFIG_TYPE == TRICYCLE_CONFIG)
+    {
+      steering_commands[0] = alpha;
+    }
+    else if (fabs(steer_pos_) < 1e-6)
     {
-      traction_commands = {Ws, Ws};
-      steering_commands = {alpha, alpha};
+      steering_commands[0] = alpha;
+      steering_commands[1] = alpha;
     }
     else
     {
-      double turning_radius = wheelbase_ / std::tan(steer_pos_);
-      double Wr = Ws * (turning_radius + wheel_track_ * 0.5) / turning_radius;
-      double Wl = Ws * (turning_radius - wheel_track_ * 0.5) / turning_radius;
-      traction_commands = {Wr, Wl};
-
-      double numerator = 2 * wheelbase_ * std::sin(alpha);
-      double denominator_first_member = 2 * wheelbase_ * std::cos(alpha);
-      double denominator_second_member = wheel_track_ * std::sin(alpha);
-
-      double alpha_r = std::atan2(numerator, denominator_first_member - denominator_second_member);
-      double alpha_l = std::atan2(numerator, denominator_first_member + denominator_second_member);
-      steering_commands = {alpha_r, alpha_l};
+      double numerator = 2 * wheelbase_ * sin_of(alpha);
+      double denominator_first_member = 2 * wheelbase_ * cos_of(alpha);
+      double denominator_second_member = wheel_track_ * sin_of(alpha);
+
+      steering_commands[0] =
+        atan2_of(numerator, denominator_first_member - denominator_second_member);
+      steering_commands[1] =
+        atan2_of(numerator, denominator_first_member + denominator_second_member);
     }
-    return std::make_tuple(traction_commands, steering_commands);
   }
-  else
+}
+
+bool SteeringOdometry::get_module_commands(
+  const double Vx, const double Vy, const double theta_dot,
+  std::vector<double> & traction_commands, std::vector<double> & steering_commands) const
+{
+  if (config_type_ != static_cast<int>(WHEEL_MODULES_CONFIG))
   {
-    throw std::runtime_error("Config not implemented");
+    return false;
   }
+  wheel_modules_.compute_commands(Vx, Vy, theta_dot, traction_commands, steering_commands);
+  return true;
 }
 
 void SteeringOdometry::reset_odometry()
 {
-  x_ = 0.0;
-  y_ = 0.0;
-  heading_ = 0.0;
+  pose_.reset();
   reset_accumulators();
 }
 
-void SteeringOdometry::integrate_runge_kutta_2(double linear, double angular)
+size_t SteeringOdometry::get_wheel_positions(double * positions, size_t capacity) const
 {
-  const double direction = heading_ + angular * 0.5;
-
-  /// Runge-Kutta 2nd order integration:
-  x_ += linear * cos(direction);
-  y_ += linear * sin(direction);
-  heading_ += angular;
+  if (config_type_ == static_cast<int>(WHEEL_MODULES_CONFIG))
+  {
+    if (traction_wheels_old_pos_.size() > capacity)
+    {
+      return 0;
+    }
+    std::copy(traction_wheels_old_pos_.begin(), traction_wheels_old_pos_.end(), positions);
+    return traction_wheels_old_pos_.size();
+  }
+  if (capacity < 3)
+  {
+    return 0;
+  }
+  positions[0] = traction_wheel_old_pos_;
+  positions[1] = traction_right_wheel_old_pos_;
+  positions[2] = traction_left_wheel_old_pos_;
+  return 3;
 }
 
-/**
- * \brief Other possible integration method provided by the class
- * \param linear
- * \param angular
- */
-void SteeringOdometry::integrate_exact(double linear, double angular)
+bool SteeringOdometry::restore(
+  double x, double y, double heading, double linear, double lateral, double angular,
+  const double * wheel_positions, size_t num_wheel_positions, double max_wheel_rotation)
 {
-  if (fabs(angular) < 1e-6)
+  pose_.reset(x, y, heading);
+  reset_accumulators();
+  linear_acc_.accumulate(linear);
+  lateral_acc_.accumulate(lateral);
+  angular_acc_.accumulate(angular);
+  linear_ = linear;
+  lateral_ = lateral;
+  angular_ = angular;
+  previous_linear_velocity_ = linear;
+  previous_angular_velocity_ = angular;
+
+  const bool is_wheel_modules = config_type_ == static_cast<int>(WHEEL_MODULES_CONFIG);
+  if (num_wheel_positions != (is_wheel_modules ? traction_wheels_old_pos_.size() : 3))
   {
-    integrate_runge_kutta_2(linear, angular);
+    return false;
+  }
+  if (is_wheel_modules)
+  {
+    std::copy(
+      wheel_positions, wheel_positions + num_wheel_positions, traction_wheels_old_pos_.begin());
   }
   else
   {
-    /// Exact integration (should solve problems when angular is zero):
-    const double heading_old = heading_;
-    const double r = linear / angular;
-    heading_ += angular;
-    x_ += r * (sin(heading_) - sin(heading_old));
-    y_ += -r * (cos(heading_) - cos(heading_old));
+    traction_wheel_old_pos_ = wheel_positions[0];
+    traction_right_wheel_old_pos_ = wheel_positions[1];
+    traction_left_wheel_old_pos_ = wheel_positions[2];
   }
+  restored_max_wheel_rotation_ = max_wheel_rotation;
+  return true;
 }
 
 void SteeringOdometry::reset_accumulators()
 {
   linear_acc_ = rcpputils::RollingMeanAccumulator<double>(velocity_rolling_window_size_);
+  lateral_acc_ = rcpputils::RollingMeanAccumulator<double>(velocity_rolling_window_size_);
   angular_acc_ = rcpputils::RollingMeanAccumulator<double>(velocity_rolling_window_size_);
 }
 
@@ -0,0 +1,142 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "steering_controllers_library/wheel_module_kinematics.hpp"
+
+#include <cmath>
+
+namespace steering_odometry
+{
+void WheelModuleKinematics::configure(const std::vector<WheelModule> & modules)
+{
+  x_.resize(modules.size());
+  y_.resize(modules.size());
+  radius_.resize(modules.size());
+  steering_index_.resize(modules.size());
+  traction_index_.resize(modules.size());
+  num_driven_ = 0;
+  num_steerable_ = 0;
+  for (size_t i = 0; i < modules.size(); ++i)
+  {
+    x_[i] = modules[i].x;
+    y_[i] = modules[i].y;
+    radius_[i] = modules[i].radius;
+    steering_index_[i] = modules[i].steerable ? num_steerable_++ : NO_VALUE;
+    traction_index_[i] = modules[i].driven ? num_driven_++ : NO_VALUE;
+  }
+}
+
+bool WheelModuleKinematics::fit(
+  const std::vector<double> & traction_velocities, const std::vector<double> & steering_positions,
+  double & linear, double & lateral, double & angular) const
+{
+  // normal equations of the rolling speed of the driven wheels and of the lateral rolling
+  // constraint of all wheels, with the upper triangle of the symmetric matrix
+  double n00 = 0.0, n01 = 0.0, n02 = 0.0, n11 = 0.0, n12 = 0.0, n22 = 0.0;
+  double r0 = 0.0, r1 = 0.0, r2 = 0.0;
+  for (size_t i = 0; i < x_.size(); ++i)
+  {
+    const double steering =
+      steering_index_[i] == NO_VALUE ? 0.0 : steering_positions[steering_index_[i]];
+    const double c = std::cos(steering);
+    const double s = std::sin(steering);
+
+    // the contact point does not move sideways: -s * vx + c * vy + (c * x + s * y) * wz = 0
+    const double lateral_moment = c * x_[i] + s * y_[i];
+    n00 += s * s;
+    n01 -= s * c;
+    n02 -= s * lateral_moment;
+    n11 += c * c;
+    n12 += c * lateral_moment;
+    n22 += lateral_moment * lateral_moment;
+
+    if (traction_index_[i] != NO_VALUE)
+    {
+      // rolling speed: c * vx + s * vy + (s * x - c * y) * wz = velocity * radius
+      const double speed = traction_velocities[traction_index_[i]] * radius_[i];
+      const double rolling_moment = s * x_[i] - c * y_[i];
+      n00 += c * c;
+      n01 += c * s;
+      n02 += c * rolling_moment;
+      n11 += s * s;
+      n12 += s * rolling_moment;
+      n22 += rolling_moment * rolling_moment;
+      r0 += c * speed;
+      r1 += s * speed;
+      r2 += rolling_moment * speed;
+    }
+  }
+
+  // Cramer's rule on the 3x3 system
+  const double c00 = n11 * n22 - n12 * n12;
+  const double c01 = n02 * n12 - n01 * n22;
+  const double c02 = n01 * n12 - n02 * n11;
+  const double determinant = n00 * c00 + n01 * c01 + n02 * c02;
+  const double scale = n00 + n11 + n22;
+  // NaN inputs fail the comparison as well
+  if (!(std::fabs(determinant) > 1e-9 * scale * scale * scale))
+  {
+    return false;
+  }
+  const double c11 = n00 * n22 - n02 * n02;
+  const double c12 = n01 * n02 - n00 * n12;
+  const double c22 = n00 * n11 - n01 * n01;
+  linear = (c00 * r0 + c01 * r1 + c02 * r2) / determinant;
+  lateral = (c01 * r0 + c11 * r1 + c12 * r2) / determinant;
+  angular = (c02 * r0 + c12 * r1 + c22 * r2) / determinant;
+  return !std::isnan(linear) && !std::isnan(lateral) && !std::isnan(angular);
+}
+
+void WheelModuleKinematics::compute_commands(
+  double linear, double lateral, double angular, std::vector<double> & traction_commands,
+  std::vector<double> & steering_commands) const
+{
+  for (size_t i = 0; i < x_.size(); ++i)
+  {
+    // velocity of the contact point
+    const double velocity_x = linear - angular * y_[i];
+    const double velocity_y = lateral + angular * x_[i];
+
+    double speed = velocity_x;
+    if (steering_index_[i] != NO_VALUE)
+    {
+      speed = std::hypot(velocity_x, velocity_y);
+      if (speed > 1e-9)
+      {
+        double steering = std::atan2(velocity_y, velocity_x);
+        if (steering > M_PI_2)
+        {
+          steering -= M_PI;
+          speed = -speed;
+        }
+        else if (steering < -M_PI_2)
+        {
+          steering += M_PI;
+          speed = -speed;
+        }
+        steering_commands[steering_index_[i]] = steering;
+      }
+      else
+      {
+        speed = 0.0;
+      }
+    }
+    if (traction_index_[i] != NO_VALUE)
+    {
+      traction_commands[traction_index_[i]] = speed / radius_[i];
+    }
+  }
+}
+
+}  // namespace steering_odometry
@@ -0,0 +1,94 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <limits>
+
+#include "steering_controllers_library/fast_trigonometry.hpp"
+#include "steering_controllers_library/steering_odometry.hpp"
+
+namespace fast_trigonometry = steering_odometry::fast_trigonometry;
+
+TEST(TestFastTrigonometry, error_is_bounded_within_quarter_turn)
+{
+  constexpr int SAMPLES = 10000;
+  for (int i = -SAMPLES; i <= SAMPLES; ++i)
+  {
+    const double angle = M_PI_2 * i / SAMPLES;
+    EXPECT_NEAR(fast_trigonometry::sin(angle), std::sin(angle), fast_trigonometry::MAX_ERROR);
+    EXPECT_NEAR(fast_trigonometry::cos(angle), std::cos(angle), fast_trigonometry::MAX_ERROR);
+
+    const double ratio = 100.0 * i / SAMPLES;
+    EXPECT_NEAR(fast_trigonometry::atan(ratio), std::atan(ratio), fast_trigonometry::MAX_ERROR);
+
+    // all four quadrants
+    const double y = std::sin(4.0 * angle);
+    const double x = std::cos(4.0 * angle);
+    EXPECT_NEAR(fast_trigonometry::atan2(y, x), std::atan2(y, x), fast_trigonometry::MAX_ERROR);
+  }
+}
+
+TEST(TestFastTrigonometry, falls_back_to_exact_functions)
+{
+  EXPECT_EQ(fast_trigonometry::sin(3.0), std::sin(3.0));
+  EXPECT_EQ(fast_trigonometry::cos(-10.0), std::cos(-10.0));
+  EXPECT_EQ(fast_trigonometry::atan2(0.0, -1.0), M_PI);
+  EXPECT_EQ(fast_trigonometry::atan2(-1.0, 0.0), -M_PI_2);
+  EXPECT_NEAR(
+    fast_trigonometry::atan(std::numeric_limits<double>::infinity()), M_PI_2,
+    fast_trigonometry::MAX_ERROR);
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_TRUE(std::isnan(fast_trigonometry::sin(nan)));
+  EXPECT_TRUE(std::isnan(fast_trigonometry::cos(nan)));
+  EXPECT_TRUE(std::isnan(fast_trigonometry::atan(nan)));
+  EXPECT_TRUE(std::isnan(fast_trigonometry::atan2(nan, 1.0)));
+}
+
+TEST(TestFastTrigonometry, ackermann_commands_match_exact_kinematics)
+{
+  steering_odometry::SteeringOdometry exact, fast;
+  for (auto * odometry : {&exact, &fast})
+  {
+    odometry->set_wheel_params(0.3, 1.2, 0.8);
+    ASSERT_TRUE(odometry->set_odometry_type(steering_odometry::ACKERMANN_CONFIG));
+  }
+  fast.set_fast_trigonometry(true);
+
+  for (const double steering : {0.0, 0.1, -0.4, 1.0})
+  {
+    // the measured steering angle enters the traction commands and the odometry
+    exact.update_from_velocity(2.0, 2.0, steering, 0.01);
+    fast.update_from_velocity(2.0, 2.0, steering, 0.01);
+    EXPECT_NEAR(fast.get_angular(), exact.get_angular(), 1e-6);
+
+    for (const double linear : {-1.0, 0.0, 0.5, 2.0})
+    {
+      for (const double angular : {-1.5, -0.2, 0.0, 0.3, 1.0})
+      {
+        steering_odometry::AxleCommands exact_traction{}, exact_steering{};
+        steering_odometry::AxleCommands fast_traction{}, fast_steering{};
+        ASSERT_TRUE(exact.get_commands(linear, angular, exact_traction, exact_steering));
+        ASSERT_TRUE(fast.get_commands(linear, angular, fast_traction, fast_steering));
+        for (size_t i = 0; i < steering_odometry::MAX_JOINTS_PER_AXLE; ++i)
+        {
+          EXPECT_NEAR(fast_traction[i], exact_traction[i], 1e-6);
+          EXPECT_NEAR(fast_steering[i], exact_steering[i], 1e-6);
+        }
+      }
+    }
+  }
+}
@@ -14,6 +14,7 @@
 
 #include "test_steering_controllers_library.hpp"
 
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <string>
@@ -21,6 +22,7 @@
 #include <vector>
 
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
 
 class SteeringControllersLibraryTest
 : public SteeringControllersLibraryFixture<TestableSteeringControllersLibrary>
@@ -113,17 +115,19 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   msg->twist.angular.x = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.y = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.z = TEST_ANGULAR_VELOCITY_Z;
-  controller_->input_ref_.writeFromNonRT(msg);
+  controller_->input_ref_.write(
+    {rclcpp::Time(msg->header.stamp).nanoseconds(), msg->twist.linear.x, msg->twist.angular.z});
 
-  const auto age_of_last_command =
-    controller_->get_node()->now() - (*(controller_->input_ref_.readFromNonRT()))->header.stamp;
+  const auto age_of_last_command = controller_->get_node()->now() - msg->header.stamp;
 
   // case 1 position_feedback = false
   controller_->params_.position_feedback = false;
 
   // age_of_last_command > ref_timeout_
   ASSERT_FALSE(age_of_last_command <= controller_->ref_timeout_);
-  ASSERT_EQ((*(controller_->input_ref_.readFromRT()))->twist.linear.x, TEST_LINEAR_VELOCITY_X);
+  auto reference = controller_->current_ref_;
+  ASSERT_TRUE(controller_->input_ref_.try_read(reference));
+  ASSERT_EQ(reference.linear, TEST_LINEAR_VELOCITY_X);
   ASSERT_EQ(
     controller_->update(controller_->get_node()->now(), rclcpp::Duration::from_seconds(0.01)),
     controller_interface::return_type::OK);
@@ -134,8 +138,8 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   {
     EXPECT_TRUE(std::isnan(interface));
   }
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.linear.x));
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.angular.z));
+  EXPECT_TRUE(std::isnan(controller_->current_ref_.linear));
+  EXPECT_TRUE(std::isnan(controller_->current_ref_.angular));
 
   EXPECT_TRUE(std::isnan(controller_->reference_interfaces_[0]));
   for (const auto & interface : controller_->reference_interfaces_)
@@ -160,11 +164,13 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   msg->twist.angular.x = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.y = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.z = TEST_ANGULAR_VELOCITY_Z;
-  controller_->input_ref_.writeFromNonRT(msg);
+  controller_->input_ref_.write(
+    {rclcpp::Time(msg->header.stamp).nanoseconds(), msg->twist.linear.x, msg->twist.angular.z});
 
   // age_of_last_command > ref_timeout_
   ASSERT_FALSE(age_of_last_command <= controller_->ref_timeout_);
-  ASSERT_EQ((*(controller_->input_ref_.readFromRT()))->twist.linear.x, TEST_LINEAR_VELOCITY_X);
+  ASSERT_TRUE(controller_->input_ref_.try_read(reference));
+  ASSERT_EQ(reference.linear, TEST_LINEAR_VELOCITY_X);
   ASSERT_EQ(
     controller_->update(controller_->get_node()->now(), rclcpp::Duration::from_seconds(0.01)),
     controller_interface::return_type::OK);
@@ -175,8 +181,8 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   {
     EXPECT_TRUE(std::isnan(interface));
   }
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.linear.x));
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.angular.z));
+  EXPECT_TRUE(std::isnan(controller_->current_ref_.linear));
+  EXPECT_TRUE(std::isnan(controller_->current_ref_.angular));
 
   EXPECT_TRUE(std::isnan(controller_->reference_interfaces_[0]));
   for (const auto & interface : controller_->reference_interfaces_)
@@ -190,6 +196,190 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   }
 }
 
+TEST_F(SteeringControllersLibraryTest, state_is_published_at_state_publish_rate)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"state_publish_rate", 10.0});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // the message fields are sized for the configured wheels
+  const auto & state_message = controller_->controller_state_publisher_->msg_;
+  EXPECT_EQ(state_message.traction_wheels_velocity.size(), rear_wheels_names_.size());
+  EXPECT_TRUE(state_message.traction_wheels_position.empty());
+  EXPECT_EQ(state_message.linear_velocity_command.size(), rear_wheels_names_.size());
+  EXPECT_EQ(state_message.steer_positions.size(), front_wheels_names_.size());
+  EXPECT_EQ(state_message.steering_angle_command.size(), front_wheels_names_.size());
+
+  // the first update publishes, the next ones once per period
+  const rclcpp::Time start(10, 0, RCL_ROS_TIME);
+  EXPECT_TRUE(controller_->should_publish_state(start));
+  EXPECT_FALSE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.05)));
+  EXPECT_TRUE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.11)));
+  EXPECT_FALSE(controller_->should_publish_state(start + rclcpp::Duration::from_seconds(0.15)));
+}
+
+TEST_F(SteeringControllersLibraryTest, bounded_controller_state_is_published)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"bounded_controller_state.enable", true});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_TRUE(controller_->bounded_controller_state_publisher_);
+
+  // the names were published once on configuration, a late subscriber still receives them
+  rclcpp::Node test_node("test_node");
+  auto names_subscription = test_node.create_subscription<sensor_msgs::msg::JointState>(
+    "/test_steering_controllers_library/bounded_controller_state/names",
+    rclcpp::QoS(1).reliable().transient_local(),
+    [](const sensor_msgs::msg::JointState::SharedPtr) {});
+  rclcpp::WaitSet names_wait_set;
+  names_wait_set.add_subscription(names_subscription);
+  ASSERT_EQ(names_wait_set.wait(std::chrono::seconds(5)).kind(), rclcpp::WaitResultKind::Ready);
+  sensor_msgs::msg::JointState names_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(names_subscription->take(names_msg, msg_info));
+  // the traction joints followed by the steering joints
+  EXPECT_EQ(names_msg.name, joint_names_);
+
+  using BoundedState = bounded_controller_state_msgs::msg::BoundedSteeringControllerStatus;
+  auto subscription = test_node.create_subscription<BoundedState>(
+    "/test_steering_controllers_library/bounded_controller_state", 10,
+    [](const BoundedState::SharedPtr) {});
+  int max_sub_check_loop_count = 5;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (max_sub_check_loop_count--)
+  {
+    controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01));
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0) << "No bounded controller state was published";
+
+  BoundedState msg;
+  ASSERT_TRUE(subscription->take(msg, msg_info));
+  ASSERT_EQ(msg.traction_size, rear_wheels_names_.size());
+  ASSERT_EQ(msg.steering_size, front_wheels_names_.size());
+  for (size_t i = 0; i < rear_wheels_names_.size(); ++i)
+  {
+    // the traction wheels have velocity feedback
+    EXPECT_EQ(msg.traction_wheels_velocity[i], joint_state_values_[i]);
+    EXPECT_TRUE(std::isnan(msg.traction_wheels_position[i]));
+    EXPECT_EQ(msg.linear_velocity_command[i], controller_->command_interfaces_[i].get_value());
+  }
+  for (size_t i = 0; i < front_wheels_names_.size(); ++i)
+  {
+    const size_t index = rear_wheels_names_.size() + i;
+    EXPECT_EQ(msg.steer_positions[i], joint_state_values_[index]);
+    EXPECT_EQ(msg.steering_angle_command[i], controller_->command_interfaces_[index].get_value());
+  }
+}
+
+TEST_F(SteeringControllersLibraryTest, reference_is_limited)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"linear.x.has_velocity_limits", true});
+  EXPECT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+
+  controller_->get_node()->set_parameter({"linear.x.max_velocity", 2.0});
+  controller_->get_node()->set_parameter({"angular.z.has_acceleration_limits", true});
+  controller_->get_node()->set_parameter({"angular.z.max_acceleration", 1.0});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  controller_->set_chained_mode(true);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // the velocity is clamped at once, the angular velocity ramps up
+  for (size_t i = 1; i <= 3; ++i)
+  {
+    controller_->reference_interfaces_[0] = 3.0;
+    controller_->reference_interfaces_[1] = 1.0;
+    ASSERT_EQ(
+      controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.1)),
+      controller_interface::return_type::OK);
+    EXPECT_NEAR(controller_->last_linear_velocity_, 2.0, 1e-6);
+    EXPECT_NEAR(controller_->last_angular_velocity_, 0.1 * static_cast<double>(i), 1e-6);
+  }
+}
+
+TEST_F(SteeringControllersLibraryTest, odometry_is_exported_at_each_update)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"export_odometry", true});
+  controller_->get_node()->set_parameter({"state_publish_rate", 1.0});
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  const auto slot = odometry_exchange::OdometryExchange::get_instance().get_slot(
+    controller_->get_node()->get_fully_qualified_name());
+  odometry_exchange::OdometryState state;
+  EXPECT_FALSE(slot->read(state));
+
+  // the testable controller doesn't integrate the odometry itself
+  controller_->odometry_.update_open_loop(1.0, 0.5, 0.1);
+  const rclcpp::Time time(10, 0, RCL_ROS_TIME);
+  ASSERT_EQ(
+    controller_->update(time, rclcpp::Duration::from_seconds(0.1)),
+    controller_interface::return_type::OK);
+
+  ASSERT_TRUE(slot->read(state));
+  EXPECT_EQ(state.stamp_nanoseconds, time.nanoseconds());
+  EXPECT_DOUBLE_EQ(state.x, controller_->odometry_.get_x());
+  EXPECT_DOUBLE_EQ(state.y, controller_->odometry_.get_y());
+  EXPECT_DOUBLE_EQ(state.yaw, controller_->odometry_.get_heading());
+  EXPECT_DOUBLE_EQ(state.linear, 1.0);
+  EXPECT_DOUBLE_EQ(state.angular, 0.5);
+
+  // independent of the state publish rate
+  controller_->odometry_.update_open_loop(2.0, 0.0, 0.1);
+  ASSERT_EQ(
+    controller_->update(
+      time + rclcpp::Duration::from_seconds(0.1), rclcpp::Duration::from_seconds(0.1)),
+    controller_interface::return_type::OK);
+  ASSERT_TRUE(slot->read(state));
+  EXPECT_DOUBLE_EQ(state.linear, 2.0);
+}
+
+TEST_F(SteeringControllersLibraryTest, references_are_stamped_with_the_update_time)
+{
+  SetUpController();
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // e.g., a simulation far behind the node clock
+  const rclcpp::Time time(100, 0, RCL_ROS_TIME);
+  ASSERT_EQ(
+    controller_->update(time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  auto msg = std::make_shared<geometry_msgs::msg::Twist>();
+  msg->linear.x = 0.4;
+  msg->angular.z = 0.2;
+  controller_->reference_callback_unstamped(msg);
+
+  TestableSteeringControllersLibrary::StampedVelocityReference reference;
+  ASSERT_TRUE(controller_->input_ref_.try_read(reference));
+  EXPECT_EQ(reference.stamp_nanoseconds, time.nanoseconds());
+
+  // not older than the timeout in the time of the updates
+  ASSERT_EQ(
+    controller_->update(
+      time + rclcpp::Duration::from_seconds(0.05), rclcpp::Duration::from_seconds(0.05)),
+    controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(controller_->reference_interfaces_[0], 0.4);
+  EXPECT_DOUBLE_EQ(controller_->reference_interfaces_[1], 0.2);
+
+  // but after it, independent of the node clock
+  ASSERT_EQ(
+    controller_->update(
+      time + rclcpp::Duration::from_seconds(0.2), rclcpp::Duration::from_seconds(0.15)),
+    controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(controller_->reference_interfaces_[0], 0.0);
+  EXPECT_DOUBLE_EQ(controller_->reference_interfaces_[1], 0.0);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
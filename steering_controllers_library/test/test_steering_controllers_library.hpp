@@ -75,6 +75,11 @@ class TestableSteeringControllersLibrary
 {
   FRIEND_TEST(SteeringControllersLibraryTest, check_exported_intefaces);
   FRIEND_TEST(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout);
+  FRIEND_TEST(SteeringControllersLibraryTest, state_is_published_at_state_publish_rate);
+  FRIEND_TEST(SteeringControllersLibraryTest, bounded_controller_state_is_published);
+  FRIEND_TEST(SteeringControllersLibraryTest, reference_is_limited);
+  FRIEND_TEST(SteeringControllersLibraryTest, odometry_is_exported_at_each_update);
+  FRIEND_TEST(SteeringControllersLibraryTest, references_are_stamped_with_the_update_time);
 
 public:
   controller_interface::CallbackReturn on_configure(
@@ -0,0 +1,102 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <array>
+#include <cmath>
+
+#include "steering_controllers_library/steering_odometry.hpp"
+
+namespace
+{
+constexpr double WHEEL_RADIUS = 0.5;
+constexpr double WHEELBASE = 2.0;
+}  // namespace
+
+TEST(TestSteeringOdometry, bicycle_turns_with_steering_angle)
+{
+  steering_odometry::SteeringOdometry odometry(1);
+  odometry.set_wheel_params(WHEEL_RADIUS, WHEELBASE);
+  ASSERT_TRUE(odometry.set_odometry_type(steering_odometry::BICYCLE_CONFIG));
+
+  // 1 m/s on a circle with a radius of 2 m for 1 s
+  const double steering = std::atan(1.0);
+  const double dt = 0.01;
+  for (int i = 0; i < 100; ++i)
+  {
+    ASSERT_TRUE(odometry.update_from_velocity(1.0 / WHEEL_RADIUS, steering, dt));
+  }
+  EXPECT_NEAR(odometry.get_linear(), 1.0, 1e-12);
+  EXPECT_NEAR(odometry.get_angular(), 0.5, 1e-12);
+  EXPECT_NEAR(odometry.get_heading(), 0.5, 1e-9);
+  EXPECT_NEAR(odometry.get_x(), 2.0 * std::sin(0.5), 1e-9);
+  EXPECT_NEAR(odometry.get_y(), 2.0 * (1.0 - std::cos(0.5)), 1e-9);
+}
+
+TEST(TestSteeringOdometry, substeps_keep_the_measured_rotation)
+{
+  steering_odometry::SteeringOdometry single_step(1), substeps(1);
+  for (auto * odometry : {&single_step, &substeps})
+  {
+    odometry->set_wheel_params(WHEEL_RADIUS, WHEELBASE);
+    ASSERT_TRUE(odometry->set_odometry_type(steering_odometry::BICYCLE_CONFIG));
+  }
+  substeps.set_integration_substeps(10);
+
+  // steering into a turn
+  for (int i = 0; i < 50; ++i)
+  {
+    const double steering = 0.02 * i;
+    single_step.update_from_velocity(4.0, steering, 0.01);
+    substeps.update_from_velocity(4.0, steering, 0.01);
+  }
+  EXPECT_NEAR(substeps.get_heading(), single_step.get_heading(), 1e-12);
+  EXPECT_NEAR(substeps.get_angular(), single_step.get_angular(), 1e-12);
+  // the rotation lags behind the one of single steps, so the vehicle is less far to the left
+  EXPECT_LT(substeps.get_y(), single_step.get_y());
+}
+
+TEST(TestSteeringOdometry, restored_odometry_continues_from_the_persisted_wheel_positions)
+{
+  steering_odometry::SteeringOdometry odometry(1);
+  odometry.set_wheel_params(WHEEL_RADIUS, WHEELBASE);
+  ASSERT_TRUE(odometry.set_odometry_type(steering_odometry::BICYCLE_CONFIG));
+  // 1 m/s straight ahead
+  ASSERT_TRUE(odometry.update_from_position(2.0, 0.0, 1.0));
+  ASSERT_TRUE(odometry.update_from_position(4.0, 0.0, 1.0));
+  std::array<double, 3> positions{};
+  ASSERT_EQ(odometry.get_wheel_positions(positions.data(), positions.size()), 3u);
+  EXPECT_DOUBLE_EQ(positions[0], 2.0);
+  EXPECT_EQ(odometry.get_wheel_positions(positions.data(), 2), 0u);
+
+  // the wheel turned on by 2 rad while the controller was reloaded
+  steering_odometry::SteeringOdometry restored(1);
+  restored.set_wheel_params(WHEEL_RADIUS, WHEELBASE);
+  ASSERT_TRUE(restored.set_odometry_type(steering_odometry::BICYCLE_CONFIG));
+  ASSERT_TRUE(restored.restore(
+    odometry.get_x(), odometry.get_y(), odometry.get_heading(), odometry.get_linear(),
+    odometry.get_lateral(), odometry.get_angular(), positions.data(), positions.size(), 10.0));
+  EXPECT_DOUBLE_EQ(restored.get_linear(), 1.0);
+  ASSERT_TRUE(restored.update_from_position(6.0, 0.0, 1.0));
+  EXPECT_DOUBLE_EQ(restored.get_x(), 3.0);
+
+  // after an encoder reset, the odometry continues from the current position
+  ASSERT_TRUE(restored.restore(3.0, 0.0, 0.0, 1.0, 0.0, 0.0, positions.data(), 3, 1.0));
+  ASSERT_TRUE(restored.update_from_position(0.0, 0.0, 1.0));
+  EXPECT_DOUBLE_EQ(restored.get_x(), 3.0);
+  // wheel positions of another configuration are not restored
+  EXPECT_FALSE(restored.restore(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, positions.data(), 2, 10.0));
+  EXPECT_DOUBLE_EQ(restored.get_x(), 0.0);
+}
@@ -0,0 +1,137 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "steering_controllers_library/wheel_module_kinematics.hpp"
+
+using steering_odometry::WheelModule;
+using steering_odometry::WheelModuleKinematics;
+
+namespace
+{
+constexpr double WHEELBASE = 1.2;
+constexpr double WHEEL_TRACK = 0.8;
+constexpr double WHEEL_RADIUS = 0.1;
+
+std::vector<WheelModule> swerve_modules()
+{
+  return {
+    {0.5 * WHEELBASE, 0.5 * WHEEL_TRACK, WHEEL_RADIUS, true, true},
+    {0.5 * WHEELBASE, -0.5 * WHEEL_TRACK, WHEEL_RADIUS, true, true},
+    {-0.5 * WHEELBASE, 0.5 * WHEEL_TRACK, WHEEL_RADIUS, true, true},
+    {-0.5 * WHEELBASE, -0.5 * WHEEL_TRACK, WHEEL_RADIUS, true, true}};
+}
+
+// front-steered Ackermann vehicle with the base frame in the middle of the rear axle
+std::vector<WheelModule> ackermann_modules()
+{
+  return {
+    {WHEELBASE, -0.5 * WHEEL_TRACK, WHEEL_RADIUS, true, false},
+    {WHEELBASE, 0.5 * WHEEL_TRACK, WHEEL_RADIUS, true, false},
+    {0.0, -0.5 * WHEEL_TRACK, WHEEL_RADIUS, false, true},
+    {0.0, 0.5 * WHEEL_TRACK, WHEEL_RADIUS, false, true}};
+}
+}  // namespace
+
+TEST(TestWheelModuleKinematics, fit_recovers_commanded_twist)
+{
+  for (const auto & modules : {swerve_modules(), ackermann_modules()})
+  {
+    WheelModuleKinematics kinematics;
+    kinematics.configure(modules);
+    std::vector<double> traction(kinematics.num_driven(), 0.0);
+    std::vector<double> steering(kinematics.num_steerable(), 0.0);
+
+    // only the swerve drive moves sideways
+    const double lateral_command = modules[0].driven ? 0.3 : 0.0;
+    kinematics.compute_commands(0.5, lateral_command, 0.2, traction, steering);
+
+    double linear, lateral, angular;
+    ASSERT_TRUE(kinematics.fit(traction, steering, linear, lateral, angular));
+    EXPECT_NEAR(linear, 0.5, 1e-12);
+    EXPECT_NEAR(lateral, lateral_command, 1e-12);
+    EXPECT_NEAR(angular, 0.2, 1e-12);
+  }
+}
+
+TEST(TestWheelModuleKinematics, ackermann_commands_match_turning_radius)
+{
+  WheelModuleKinematics kinematics;
+  kinematics.configure(ackermann_modules());
+  std::vector<double> traction(2, 0.0);
+  std::vector<double> steering(2, 0.0);
+
+  const double linear = 1.0;
+  const double angular = 0.5;
+  kinematics.compute_commands(linear, 0.0, angular, traction, steering);
+
+  // turning to the left around a point on the rear axle
+  const double turning_radius = linear / angular;
+  EXPECT_NEAR(steering[0], std::atan(WHEELBASE / (turning_radius + 0.5 * WHEEL_TRACK)), 1e-12);
+  EXPECT_NEAR(steering[1], std::atan(WHEELBASE / (turning_radius - 0.5 * WHEEL_TRACK)), 1e-12);
+  EXPECT_NEAR(traction[0] * WHEEL_RADIUS, angular * (turning_radius + 0.5 * WHEEL_TRACK), 1e-12);
+  EXPECT_NEAR(traction[1] * WHEEL_RADIUS, angular * (turning_radius - 0.5 * WHEEL_TRACK), 1e-12);
+}
+
+TEST(TestWheelModuleKinematics, steering_stays_within_quarter_turn)
+{
+  WheelModuleKinematics kinematics;
+  kinematics.configure(swerve_modules());
+  std::vector<double> traction(4, 0.0);
+  std::vector<double> steering(4, 0.0);
+
+  // driving backwards drives the wheels backwards instead of turning them around
+  kinematics.compute_commands(-1.0, 0.0, 0.0, traction, steering);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(steering[i], 0.0, 1e-12);
+    EXPECT_NEAR(traction[i], -1.0 / WHEEL_RADIUS, 1e-12);
+  }
+
+  // wheels keep their steering position while the vehicle stands still
+  kinematics.compute_commands(0.0, 1.0, 0.0, traction, steering);
+  kinematics.compute_commands(0.0, 0.0, 0.0, traction, steering);
+  for (size_t i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(steering[i], M_PI_2, 1e-12);
+    EXPECT_EQ(traction[i], 0.0);
+  }
+}
+
+TEST(TestWheelModuleKinematics, fit_fails_without_observable_twist)
+{
+  WheelModuleKinematics kinematics;
+  double linear, lateral, angular;
+
+  // without driven wheels only the rotation center is known, not the speed
+  auto modules = swerve_modules();
+  for (auto & module : modules)
+  {
+    module.driven = false;
+  }
+  kinematics.configure(modules);
+  EXPECT_FALSE(kinematics.fit({}, {0.1, 0.1, 0.1, 0.1}, linear, lateral, angular));
+
+  kinematics.configure(swerve_modules());
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_FALSE(
+    kinematics.fit({1.0, 1.0, 1.0, nan}, {0.0, 0.0, 0.0, 0.0}, linear, lateral, angular));
+  EXPECT_FALSE(
+    kinematics.fit({1.0, 1.0, 1.0, 1.0}, {0.0, 0.0, nan, 0.0}, linear, lateral, angular));
+}
@@ -0,0 +1,53 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SWERVE_STEERING_CONTROLLER__SWERVE_STEERING_CONTROLLER_HPP_
+#define SWERVE_STEERING_CONTROLLER__SWERVE_STEERING_CONTROLLER_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "steering_controllers_library/steering_controllers_library.hpp"
+#include "swerve_steering_controller/visibility_control.h"
+#include "swerve_steering_controller_parameters.hpp"
+
+namespace swerve_steering_controller
+{
+static constexpr size_t NR_REF_ITFS = 2;
+
+class SwerveSteeringController : public steering_controllers_library::SteeringControllersLibrary
+{
+public:
+  SwerveSteeringController();
+
+  SWERVE_STEERING_CONTROLLER__VISIBILITY_PUBLIC controller_interface::CallbackReturn
+  configure_odometry() override;
+
+  SWERVE_STEERING_CONTROLLER__VISIBILITY_PUBLIC bool update_odometry(
+    const rclcpp::Duration & period) override;
+
+  SWERVE_STEERING_CONTROLLER__VISIBILITY_PUBLIC void initialize_implementation_parameter_listener()
+    override;
+
+protected:
+  std::shared_ptr<swerve_steering_controller::ParamListener> swerve_param_listener_;
+  swerve_steering_controller::Params swerve_params_;
+
+  // states of the driven and steered wheels, in the order of the wheel modules
+  std::vector<double> traction_wheels_values_;
+  std::vector<double> steering_positions_;
+};
+}  // namespace swerve_steering_controller
+
+#endif  // SWERVE_STEERING_CONTROLLER__SWERVE_STEERING_CONTROLLER_HPP_
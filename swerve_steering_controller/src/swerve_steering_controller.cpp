@@ -0,0 +1,111 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "swerve_steering_controller/swerve_steering_controller.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace swerve_steering_controller
+{
+SwerveSteeringController::SwerveSteeringController()
+: steering_controllers_library::SteeringControllersLibrary()
+{
+}
+
+void SwerveSteeringController::initialize_implementation_parameter_listener()
+{
+  swerve_param_listener_ = std::make_shared<swerve_steering_controller::ParamListener>(get_node());
+}
+
+controller_interface::CallbackReturn SwerveSteeringController::configure_odometry()
+{
+  swerve_params_ = swerve_param_listener_->get_params();
+
+  const size_t number_of_modules = swerve_params_.wheel_modules_x.size();
+  if (
+    swerve_params_.wheel_modules_y.size() != number_of_modules ||
+    swerve_params_.wheel_modules_steerable.size() != number_of_modules ||
+    swerve_params_.wheel_modules_driven.size() != number_of_modules)
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "The parameters 'wheel_modules_x', 'wheel_modules_y', 'wheel_modules_steerable' and "
+      "'wheel_modules_driven' must have the same size.");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  std::vector<steering_odometry::WheelModule> modules(number_of_modules);
+  for (size_t i = 0; i < number_of_modules; ++i)
+  {
+    modules[i].x = swerve_params_.wheel_modules_x[i];
+    modules[i].y = swerve_params_.wheel_modules_y[i];
+    modules[i].radius = swerve_params_.wheels_radius;
+    modules[i].steerable = swerve_params_.wheel_modules_steerable[i];
+    modules[i].driven = swerve_params_.wheel_modules_driven[i];
+  }
+  odometry_.set_wheel_modules(modules);
+
+  const auto & wheel_modules = odometry_.get_wheel_modules();
+  traction_wheels_values_.assign(wheel_modules.num_driven(), 0.0);
+  steering_positions_.assign(wheel_modules.num_steerable(), 0.0);
+
+  const size_t nr_joints = wheel_modules.num_driven() + wheel_modules.num_steerable();
+  set_interface_numbers(nr_joints, nr_joints, NR_REF_ITFS);
+
+  RCLCPP_INFO(get_node()->get_logger(), "swerve odometry configure successful");
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+bool SwerveSteeringController::update_odometry(const rclcpp::Duration & period)
+{
+  if (params_.open_loop)
+  {
+    odometry_.update_open_loop(last_linear_velocity_, last_angular_velocity_, period.seconds());
+    return true;
+  }
+
+  // states of the traction joints come first
+  const size_t number_of_traction_wheels = traction_wheels_values_.size();
+  for (size_t i = 0; i < number_of_traction_wheels; ++i)
+  {
+    traction_wheels_values_[i] = state_interfaces_[i].get_value();
+  }
+  for (size_t i = 0; i < steering_positions_.size(); ++i)
+  {
+    steering_positions_[i] = state_interfaces_[number_of_traction_wheels + i].get_value();
+  }
+
+  // NaN values are rejected by the fit of the wheel modules
+  if (params_.position_feedback)
+  {
+    // Estimate linear and angular velocity using joint information
+    odometry_.update_from_module_position(
+      traction_wheels_values_, steering_positions_, period.seconds());
+  }
+  else
+  {
+    // Estimate linear and angular velocity using joint information
+    odometry_.update_from_module_velocity(
+      traction_wheels_values_, steering_positions_, period.seconds());
+  }
+  return true;
+}
+}  // namespace swerve_steering_controller
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  swerve_steering_controller::SwerveSteeringController,
+  controller_interface::ChainableControllerInterface)
@@ -0,0 +1,145 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "test_swerve_steering_controller.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+class SwerveSteeringControllerTest : public SwerveSteeringControllerFixture
+{
+};
+
+TEST_F(SwerveSteeringControllerTest, all_parameters_set_configure_success)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  EXPECT_EQ(
+    controller_->odometry_.get_odometry_type(),
+    static_cast<int>(steering_odometry::WHEEL_MODULES_CONFIG));
+  EXPECT_EQ(controller_->odometry_.get_wheel_modules().num_driven(), NR_MODULES);
+  EXPECT_EQ(controller_->odometry_.get_wheel_modules().num_steerable(), NR_MODULES);
+  EXPECT_EQ(controller_->swerve_params_.wheels_radius, wheels_radius_);
+}
+
+TEST_F(SwerveSteeringControllerTest, configure_fails_with_inconsistent_modules)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter(
+    {"wheel_modules_y", std::vector<double>{0.4, -0.4, 0.4}});
+  EXPECT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+
+  // four traction joints are named, but only three wheels are driven
+  controller_->get_node()->set_parameter(
+    {"wheel_modules_y", std::vector<double>(modules_y_.begin(), modules_y_.end())});
+  controller_->get_node()->set_parameter(
+    {"wheel_modules_driven", std::vector<bool>{true, true, true, false}});
+  EXPECT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+}
+
+TEST_F(SwerveSteeringControllerTest, check_exported_intefaces)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto command_intefaces = controller_->command_interface_configuration();
+  ASSERT_EQ(command_intefaces.names.size(), joint_command_values_.size());
+  auto state_intefaces = controller_->state_interface_configuration();
+  ASSERT_EQ(state_intefaces.names.size(), joint_state_values_.size());
+  for (size_t i = 0; i < NR_MODULES; ++i)
+  {
+    EXPECT_EQ(command_intefaces.names[i], traction_joint_names_[i] + "/velocity");
+    EXPECT_EQ(command_intefaces.names[NR_MODULES + i], steering_joint_names_[i] + "/position");
+    EXPECT_EQ(state_intefaces.names[i], traction_joint_names_[i] + "/velocity");
+    EXPECT_EQ(state_intefaces.names[NR_MODULES + i], steering_joint_names_[i] + "/position");
+  }
+}
+
+TEST_F(SwerveSteeringControllerTest, test_update_logic_chained)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  controller_->set_chained_mode(true);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_TRUE(controller_->is_in_chained_mode());
+
+  // turn on the spot
+  const double angular = 0.5;
+  controller_->reference_interfaces_[0] = 0.0;
+  controller_->reference_interfaces_[1] = angular;
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  // all wheels are tangential to the circle around the center, the left ones drive backwards
+  const double speed = angular * std::hypot(0.6, 0.4) / wheels_radius_;
+  const double steering = std::atan2(0.6, 0.4);
+  const std::array<double, NR_MODULES> expected_traction = {-speed, speed, -speed, speed};
+  const std::array<double, NR_MODULES> expected_steering = {
+    -steering, steering, steering, -steering};
+  for (size_t i = 0; i < NR_MODULES; ++i)
+  {
+    EXPECT_NEAR(
+      controller_->command_interfaces_[i].get_value(), expected_traction[i], COMMON_THRESHOLD);
+    EXPECT_NEAR(
+      controller_->command_interfaces_[NR_MODULES + i].get_value(), expected_steering[i],
+      COMMON_THRESHOLD);
+  }
+
+  for (const auto & interface : controller_->reference_interfaces_)
+  {
+    EXPECT_TRUE(std::isnan(interface));
+  }
+}
+
+TEST_F(SwerveSteeringControllerTest, odometry_follows_steered_wheels)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  controller_->set_chained_mode(true);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // all wheels steered to the left drive the vehicle sideways
+  for (size_t i = 0; i < NR_MODULES; ++i)
+  {
+    joint_state_values_[i] = 5.0;
+    joint_state_values_[NR_MODULES + i] = M_PI_2;
+  }
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.1)),
+    controller_interface::return_type::OK);
+
+  EXPECT_NEAR(controller_->odometry_.get_linear(), 0.0, COMMON_THRESHOLD);
+  EXPECT_NEAR(controller_->odometry_.get_lateral(), 0.5, COMMON_THRESHOLD);
+  EXPECT_NEAR(controller_->odometry_.get_angular(), 0.0, COMMON_THRESHOLD);
+  EXPECT_NEAR(controller_->odometry_.get_x(), 0.0, COMMON_THRESHOLD);
+  EXPECT_NEAR(controller_->odometry_.get_y(), 0.05, COMMON_THRESHOLD);
+}
+
+int main(int argc, char ** argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  rclcpp::init(argc, argv);
+  int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
@@ -0,0 +1,112 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TEST_SWERVE_STEERING_CONTROLLER_HPP_
+#define TEST_SWERVE_STEERING_CONTROLLER_HPP_
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp/utilities.hpp"
+#include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+#include "swerve_steering_controller/swerve_steering_controller.hpp"
+
+namespace
+{
+constexpr auto NODE_SUCCESS = controller_interface::CallbackReturn::SUCCESS;
+constexpr auto NODE_ERROR = controller_interface::CallbackReturn::ERROR;
+const double COMMON_THRESHOLD = 1e-6;
+constexpr size_t NR_MODULES = 4;
+}  // namespace
+
+// subclassing and friending so we can access member variables
+class TestableSwerveSteeringController
+: public swerve_steering_controller::SwerveSteeringController
+{
+  FRIEND_TEST(SwerveSteeringControllerTest, all_parameters_set_configure_success);
+  FRIEND_TEST(SwerveSteeringControllerTest, configure_fails_with_inconsistent_modules);
+  FRIEND_TEST(SwerveSteeringControllerTest, check_exported_intefaces);
+  FRIEND_TEST(SwerveSteeringControllerTest, test_update_logic_chained);
+  FRIEND_TEST(SwerveSteeringControllerTest, odometry_follows_steered_wheels);
+
+public:
+  controller_interface::CallbackReturn on_activate(
+    const rclcpp_lifecycle::State & previous_state) override
+  {
+    auto ref_itfs = on_export_reference_interfaces();
+    return swerve_steering_controller::SwerveSteeringController::on_activate(previous_state);
+  }
+};
+
+class SwerveSteeringControllerFixture : public ::testing::Test
+{
+public:
+  void SetUp() { controller_ = std::make_unique<TestableSwerveSteeringController>(); }
+
+  void TearDown() { controller_.reset(nullptr); }
+
+protected:
+  void SetUpController(const std::string controller_name = "test_swerve_steering_controller")
+  {
+    ASSERT_EQ(controller_->init(controller_name, "", 0), controller_interface::return_type::OK);
+
+    // traction joints of all modules first, then their steering joints
+    std::vector<hardware_interface::LoanedCommandInterface> command_ifs;
+    std::vector<hardware_interface::LoanedStateInterface> state_ifs;
+    command_itfs_.reserve(2 * NR_MODULES);
+    state_itfs_.reserve(2 * NR_MODULES);
+    for (size_t i = 0; i < 2 * NR_MODULES; ++i)
+    {
+      const bool is_traction = i < NR_MODULES;
+      const auto & joint_name =
+        is_traction ? traction_joint_names_[i] : steering_joint_names_[i - NR_MODULES];
+      const auto & interface_name = is_traction ? "velocity" : "position";
+      command_itfs_.emplace_back(hardware_interface::CommandInterface(
+        joint_name, interface_name, &joint_command_values_[i]));
+      command_ifs.emplace_back(command_itfs_.back());
+      state_itfs_.emplace_back(
+        hardware_interface::StateInterface(joint_name, interface_name, &joint_state_values_[i]));
+      state_ifs.emplace_back(state_itfs_.back());
+    }
+
+    controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+  }
+
+  std::array<std::string, NR_MODULES> traction_joint_names_ = {
+    "front_left_wheel_joint", "front_right_wheel_joint", "rear_left_wheel_joint",
+    "rear_right_wheel_joint"};
+  std::array<std::string, NR_MODULES> steering_joint_names_ = {
+    "front_left_steering_joint", "front_right_steering_joint", "rear_left_steering_joint",
+    "rear_right_steering_joint"};
+  std::array<double, NR_MODULES> modules_y_ = {0.4, -0.4, 0.4, -0.4};
+  double wheels_radius_ = 0.1;
+
+  std::array<double, 2 * NR_MODULES> joint_state_values_ = {};
+  std::array<double, 2 * NR_MODULES> joint_command_values_ = {};
+
+  std::vector<hardware_interface::StateInterface> state_itfs_;
+  std::vector<hardware_interface::CommandInterface> command_itfs_;
+
+  std::unique_ptr<TestableSwerveSteeringController> controller_;
+};
+
+#endif  // TEST_SWERVE_STEERING_CONTROLLER_HPP_
@@ -0,0 +1,200 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TELEMETRY_RATE_POLICY__TELEMETRY_RATE_POLICY_HPP_
+#define TELEMETRY_RATE_POLICY__TELEMETRY_RATE_POLICY_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "telemetry_rate_policy/visibility_control.h"
+
+namespace telemetry_rate_policy
+{
+class TelemetryRatePolicy;
+
+/**
+ * \brief Publish rate of one telemetry topic of a controller, registered at the
+ * TelemetryRatePolicy.
+ *
+ * The topic is unregistered when the rate is destroyed.
+ */
+class TelemetryRate
+{
+public:
+  TELEMETRY_RATE_POLICY_PUBLIC
+  ~TelemetryRate();
+
+  TelemetryRate(const TelemetryRate &) = delete;
+  TelemetryRate & operator=(const TelemetryRate &) = delete;
+
+  /**
+   * Whether the topic is published at \p time, i.e., whether its period passed since the last
+   * time it was due, realtime-safe. Only one thread may call it.
+   *
+   * A change of the period by the policy restarts the period at \p time, as does a gap of more
+   * than one period since the last call.
+   */
+  TELEMETRY_RATE_POLICY_PUBLIC
+  bool is_due(const rclcpp::Time & time);
+
+  /// The topic is due at the next call of is_due(), e.g., on activation
+  void reset() { previous_timestamp_ = rclcpp::Time(0, 0, RCL_CLOCK_UNINITIALIZED); }
+
+  /// Rate of the topic in Hz with the policy applied, 0 if it is published at every update
+  TELEMETRY_RATE_POLICY_PUBLIC
+  double get_rate() const;
+
+  const std::string & get_topic() const { return topic_; }
+
+  /// Rate of the parameters of the controller, 0 for every update
+  double get_own_rate() const { return own_rate_; }
+
+private:
+  friend class TelemetryRatePolicy;
+
+  TelemetryRate(
+    std::shared_ptr<TelemetryRatePolicy> policy, const std::string & topic, double own_rate);
+
+  std::shared_ptr<TelemetryRatePolicy> policy_;
+  std::string topic_;
+  double own_rate_;
+
+  // set by the policy, 0 for every update
+  std::atomic<int64_t> period_nanoseconds_{0};
+  // only used by the thread calling is_due()
+  int64_t applied_period_nanoseconds_ = 0;
+  rclcpp::Time previous_timestamp_{0, 0, RCL_CLOCK_UNINITIALIZED};
+};
+
+/**
+ * \brief Publish rates of the telemetry of all controllers in this process, i.e., of one
+ * controller manager.
+ *
+ * Controllers register their telemetry topics, e.g., ``~/controller_state``, with the rate of
+ * their own parameters, and ask the TelemetryRate in their ``update()`` whether the topic is due.
+ * The policy has its own node ``telemetry_rate_policy``, created in the namespace of the first
+ * controller that registers, with the parameters
+ *
+ * - ``default_rate``: upper bound of the rates of all topics in Hz, no bound if 0. Topics published
+ *   at every update, i.e., without a rate of their own, are published at this rate.
+ * - ``rates.<topic>``: rate of one topic in Hz, replacing both its own rate and the default rate,
+ *   0 for every update. The topic is the fully qualified name with the slashes replaced by dots and
+ *   without the leading one, e.g., ``rates.joint_trajectory_controller.controller_state``. A
+ *   negative rate removes the override.
+ *
+ * The parameters are set like the ones of the controllers, e.g., in the parameter file of the
+ * controller manager, and at runtime with the parameter services of the node. The policy exists as
+ * long as any topic is registered.
+ */
+class TelemetryRatePolicy : public std::enable_shared_from_this<TelemetryRatePolicy>
+{
+public:
+  /// Period of the checks for parameter requests to the node of the policy
+  static constexpr std::chrono::milliseconds SPIN_PERIOD{100};
+
+  /// The policy of this process, created if there is none
+  TELEMETRY_RATE_POLICY_PUBLIC
+  static std::shared_ptr<TelemetryRatePolicy> get_instance();
+
+  TELEMETRY_RATE_POLICY_PUBLIC
+  ~TelemetryRatePolicy();
+
+  TelemetryRatePolicy(const TelemetryRatePolicy &) = delete;
+  TelemetryRatePolicy & operator=(const TelemetryRatePolicy &) = delete;
+
+  /**
+   * Register the telemetry \p topic, not realtime-safe.
+   *
+   * \param[in] node_namespace namespace of the node of the policy, if it does not exist yet
+   * \param[in] topic fully qualified name, e.g., of ``get_topic_name()`` of its publisher
+   * \param[in] own_rate of the parameters of the controller in Hz, 0 for every update
+   */
+  TELEMETRY_RATE_POLICY_PUBLIC
+  std::shared_ptr<TelemetryRate> register_topic(
+    const std::string & node_namespace, const std::string & topic, double own_rate);
+
+  /**
+   * Set the ``default_rate`` parameter, not realtime-safe.
+   *
+   * \return false if no topic is registered yet, or if the rate is rejected
+   */
+  TELEMETRY_RATE_POLICY_PUBLIC
+  bool set_default_rate(double rate);
+
+  /**
+   * Set the ``rates.<topic>`` parameter of \p topic, not realtime-safe.
+   *
+   * \return false if no topic is registered yet, or if the rate is rejected
+   */
+  TELEMETRY_RATE_POLICY_PUBLIC
+  bool set_topic_rate(const std::string & topic, double rate);
+
+  /// Name of the parameter of the rate of \p topic, e.g., "rates.joint_states"
+  TELEMETRY_RATE_POLICY_PUBLIC
+  static std::string get_rate_parameter_name(const std::string & topic);
+
+  /**
+   * Rate of a topic with \p own_rate with the policy applied, 0 for every update.
+   *
+   * \param[in] topic_rate override of the topic, if any
+   */
+  TELEMETRY_RATE_POLICY_PUBLIC
+  static double resolve_rate(
+    double own_rate, double default_rate, const std::optional<double> & topic_rate);
+
+private:
+  friend class TelemetryRate;
+
+  TelemetryRatePolicy() = default;
+
+  void unregister_topic(const TelemetryRate * rate);
+  /// Validate the rates of \p parameters, before they are set
+  rcl_interfaces::msg::SetParametersResult validate_parameters(
+    const std::vector<rclcpp::Parameter> & parameters) const;
+  /// Take the rates of \p parameters, after they have been set
+  void take_parameters(const std::vector<rclcpp::Parameter> & parameters);
+  void take_parameters_locked(const std::vector<rclcpp::Parameter> & parameters);
+  /// Set the period of \p rate from the current policy, with mutex_ locked
+  void apply_policy(TelemetryRate & rate) const;
+  bool set_parameter(const rclcpp::Parameter & parameter);
+  void run();
+
+  std::mutex mutex_;
+  std::vector<TelemetryRate *> rates_;
+  double default_rate_ = 0.0;
+  // overrides by parameter name
+  std::unordered_map<std::string, double> topic_rates_;
+
+  rclcpp::Node::SharedPtr node_;
+  rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr on_set_parameters_handle_;
+  rclcpp::node_interfaces::PostSetParametersCallbackHandle::SharedPtr post_set_parameters_handle_;
+  std::unique_ptr<rclcpp::executors::SingleThreadedExecutor> executor_;
+
+  std::atomic<bool> keep_running_{false};
+  std::thread thread_;
+};
+
+}  // namespace telemetry_rate_policy
+
+#endif  // TELEMETRY_RATE_POLICY__TELEMETRY_RATE_POLICY_HPP_
@@ -0,0 +1,316 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr auto NODE_NAME = "telemetry_rate_policy";
+constexpr auto DEFAULT_RATE_PARAMETER = "default_rate";
+constexpr auto RATES_PREFIX = "rates";
+
+bool is_rate_parameter(const std::string & name)
+{
+  return name.rfind(std::string(RATES_PREFIX) + ".", 0) == 0;
+}
+
+/// Value of a rate parameter, integers are accepted as well, e.g., "100" in a parameter file
+std::optional<double> get_rate_value(const rclcpp::Parameter & parameter)
+{
+  switch (parameter.get_type())
+  {
+    case rclcpp::ParameterType::PARAMETER_DOUBLE:
+      return parameter.as_double();
+    case rclcpp::ParameterType::PARAMETER_INTEGER:
+      return static_cast<double>(parameter.as_int());
+    default:
+      return std::nullopt;
+  }
+}
+
+int64_t to_period_nanoseconds(const double rate)
+{
+  return rate > 0.0 ? static_cast<int64_t>(std::llround(1e9 / rate)) : 0;
+}
+}  // namespace
+
+namespace telemetry_rate_policy
+{
+TelemetryRate::TelemetryRate(
+  std::shared_ptr<TelemetryRatePolicy> policy, const std::string & topic, const double own_rate)
+: policy_(std::move(policy)), topic_(topic), own_rate_(own_rate)
+{
+}
+
+TelemetryRate::~TelemetryRate() { policy_->unregister_topic(this); }
+
+bool TelemetryRate::is_due(const rclcpp::Time & time)
+{
+  const int64_t period_nanoseconds = period_nanoseconds_.load(std::memory_order_relaxed);
+  if (period_nanoseconds != applied_period_nanoseconds_)
+  {
+    // no burst to catch up with a longer period, or with the time spent at no period at all
+    applied_period_nanoseconds_ = period_nanoseconds;
+    reset();
+  }
+  if (period_nanoseconds <= 0)
+  {
+    return true;
+  }
+  const auto period = rclcpp::Duration::from_nanoseconds(period_nanoseconds);
+  try
+  {
+    if (previous_timestamp_ + period < time)
+    {
+      previous_timestamp_ += period;
+      // no catching up on the periods in which it was not asked, e.g., while skipping the
+      // telemetry because of the cycle budget
+      if (previous_timestamp_ + period < time)
+      {
+        previous_timestamp_ = time;
+      }
+      return true;
+    }
+  }
+  catch (const std::runtime_error &)
+  {
+    // Handle exceptions when the time source changes and initialize the timestamp
+    previous_timestamp_ = time;
+    return true;
+  }
+  return false;
+}
+
+double TelemetryRate::get_rate() const
+{
+  const int64_t period_nanoseconds = period_nanoseconds_.load(std::memory_order_relaxed);
+  return period_nanoseconds > 0 ? 1e9 / static_cast<double>(period_nanoseconds) : 0.0;
+}
+
+std::shared_ptr<TelemetryRatePolicy> TelemetryRatePolicy::get_instance()
+{
+  static std::mutex instance_mutex;
+  static std::weak_ptr<TelemetryRatePolicy> instance;
+
+  std::lock_guard<std::mutex> guard(instance_mutex);
+  auto policy = instance.lock();
+  if (!policy)
+  {
+    // the constructor is private
+    policy = std::shared_ptr<TelemetryRatePolicy>(new TelemetryRatePolicy());
+    instance = policy;
+  }
+  return policy;
+}
+
+TelemetryRatePolicy::~TelemetryRatePolicy()
+{
+  keep_running_ = false;
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+std::shared_ptr<TelemetryRate> TelemetryRatePolicy::register_topic(
+  const std::string & node_namespace, const std::string & topic, const double own_rate)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!node_)
+  {
+    // own node, independent of the lifecycle of the registering controllers. Its name is fixed
+    // against a remapping of the name of the controller manager, while its parameters are taken
+    // from the parameter files of the process.
+    node_ = std::make_shared<rclcpp::Node>(
+      NODE_NAME, node_namespace,
+      rclcpp::NodeOptions()
+        .arguments({"--ros-args", "-r", std::string("__node:=") + NODE_NAME})
+        .allow_undeclared_parameters(true)
+        .automatically_declare_parameters_from_overrides(true)
+        .start_parameter_event_publisher(false));
+    if (!node_->has_parameter(DEFAULT_RATE_PARAMETER))
+    {
+      node_->declare_parameter(DEFAULT_RATE_PARAMETER, 0.0);
+    }
+    std::vector<rclcpp::Parameter> parameters = {node_->get_parameter(DEFAULT_RATE_PARAMETER)};
+    const auto overrides = node_->get_parameters(node_->list_parameters({RATES_PREFIX}, 0).names);
+    parameters.insert(parameters.end(), overrides.begin(), overrides.end());
+    if (!validate_parameters(parameters).successful)
+    {
+      RCLCPP_WARN(
+        node_->get_logger(), "Ignoring the rates of the parameter overrides, they are invalid.");
+    }
+    else
+    {
+      take_parameters_locked(parameters);
+    }
+    on_set_parameters_handle_ = node_->add_on_set_parameters_callback(
+      [this](const std::vector<rclcpp::Parameter> & parameters)
+      { return validate_parameters(parameters); });
+    post_set_parameters_handle_ = node_->add_post_set_parameters_callback(
+      [this](const std::vector<rclcpp::Parameter> & parameters) { take_parameters(parameters); });
+    executor_ = std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+    executor_->add_node(node_);
+    keep_running_ = true;
+    thread_ = std::thread(&TelemetryRatePolicy::run, this);
+  }
+
+  // the rate is not constructible outside of the policy
+  std::shared_ptr<TelemetryRate> rate(new TelemetryRate(shared_from_this(), topic, own_rate));
+  apply_policy(*rate);
+  rates_.push_back(rate.get());
+  return rate;
+}
+
+bool TelemetryRatePolicy::set_default_rate(const double rate)
+{
+  return set_parameter(rclcpp::Parameter(DEFAULT_RATE_PARAMETER, rate));
+}
+
+bool TelemetryRatePolicy::set_topic_rate(const std::string & topic, const double rate)
+{
+  return set_parameter(rclcpp::Parameter(get_rate_parameter_name(topic), rate));
+}
+
+std::string TelemetryRatePolicy::get_rate_parameter_name(const std::string & topic)
+{
+  std::string name = topic.rfind('/', 0) == 0 ? topic.substr(1) : topic;
+  std::replace(name.begin(), name.end(), '/', '.');
+  return std::string(RATES_PREFIX) + "." + name;
+}
+
+double TelemetryRatePolicy::resolve_rate(
+  const double own_rate, const double default_rate, const std::optional<double> & topic_rate)
+{
+  if (topic_rate && *topic_rate >= 0.0)
+  {
+    return *topic_rate;
+  }
+  if (default_rate > 0.0)
+  {
+    return own_rate > 0.0 ? std::min(own_rate, default_rate) : default_rate;
+  }
+  return own_rate;
+}
+
+void TelemetryRatePolicy::unregister_topic(const TelemetryRate * rate)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  rates_.erase(std::remove(rates_.begin(), rates_.end(), rate), rates_.end());
+}
+
+rcl_interfaces::msg::SetParametersResult TelemetryRatePolicy::validate_parameters(
+  const std::vector<rclcpp::Parameter> & parameters) const
+{
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  for (const auto & parameter : parameters)
+  {
+    const bool is_default_rate = parameter.get_name() == DEFAULT_RATE_PARAMETER;
+    if (!is_default_rate && !is_rate_parameter(parameter.get_name()))
+    {
+      continue;
+    }
+    const auto rate = get_rate_value(parameter);
+    if (!rate || !std::isfinite(*rate) || (is_default_rate && *rate < 0.0))
+    {
+      result.successful = false;
+      result.reason = "'" + parameter.get_name() + "' has to be a finite rate in Hz" +
+                      (is_default_rate ? ", at least 0." : ".");
+      return result;
+    }
+  }
+  return result;
+}
+
+void TelemetryRatePolicy::take_parameters(const std::vector<rclcpp::Parameter> & parameters)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  take_parameters_locked(parameters);
+}
+
+void TelemetryRatePolicy::take_parameters_locked(
+  const std::vector<rclcpp::Parameter> & parameters)
+{
+  for (const auto & parameter : parameters)
+  {
+    const auto rate = get_rate_value(parameter);
+    if (!rate)
+    {
+      continue;
+    }
+    if (parameter.get_name() == DEFAULT_RATE_PARAMETER)
+    {
+      default_rate_ = *rate;
+    }
+    else if (is_rate_parameter(parameter.get_name()))
+    {
+      if (*rate < 0.0)
+      {
+        topic_rates_.erase(parameter.get_name());
+      }
+      else
+      {
+        topic_rates_[parameter.get_name()] = *rate;
+      }
+    }
+  }
+  for (auto * rate : rates_)
+  {
+    apply_policy(*rate);
+  }
+}
+
+void TelemetryRatePolicy::apply_policy(TelemetryRate & rate) const
+{
+  std::optional<double> topic_rate;
+  const auto topic_rate_it = topic_rates_.find(get_rate_parameter_name(rate.topic_));
+  if (topic_rate_it != topic_rates_.end())
+  {
+    topic_rate = topic_rate_it->second;
+  }
+  rate.period_nanoseconds_.store(
+    to_period_nanoseconds(resolve_rate(rate.own_rate_, default_rate_, topic_rate)),
+    std::memory_order_relaxed);
+}
+
+bool TelemetryRatePolicy::set_parameter(const rclcpp::Parameter & parameter)
+{
+  rclcpp::Node::SharedPtr node;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    node = node_;
+  }
+  // the callbacks lock mutex_
+  return node && node->set_parameter(parameter).successful;
+}
+
+void TelemetryRatePolicy::run()
+{
+  while (keep_running_ && rclcpp::ok())
+  {
+    executor_->spin_once(SPIN_PERIOD);
+  }
+}
+
+}  // namespace telemetry_rate_policy
@@ -0,0 +1,132 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "telemetry_rate_policy/telemetry_rate_policy.hpp"
+
+using namespace std::chrono_literals;
+using telemetry_rate_policy::TelemetryRatePolicy;
+
+class TestTelemetryRatePolicy : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase() { rclcpp::init(0, nullptr); }
+
+  static void TearDownTestCase() { rclcpp::shutdown(); }
+
+  /// Number of updates at 1 kHz within one second in which \p rate is due
+  static size_t count_due_updates(telemetry_rate_policy::TelemetryRate & rate)
+  {
+    size_t count = 0;
+    for (int64_t i = 0; i < 1000; ++i)
+    {
+      count += rate.is_due(rclcpp::Time(1000000 * i, RCL_STEADY_TIME)) ? 1 : 0;
+    }
+    return count;
+  }
+};
+
+TEST_F(TestTelemetryRatePolicy, default_rate_bounds_the_own_rates)
+{
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(50.0, 0.0, std::nullopt), 50.0);
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(0.0, 0.0, std::nullopt), 0.0);
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(50.0, 100.0, std::nullopt), 50.0);
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(500.0, 100.0, std::nullopt), 100.0);
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(0.0, 100.0, std::nullopt), 100.0);
+  // an override replaces both, a negative one is none
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(50.0, 100.0, 200.0), 200.0);
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(50.0, 100.0, 0.0), 0.0);
+  EXPECT_DOUBLE_EQ(TelemetryRatePolicy::resolve_rate(50.0, 100.0, -1.0), 50.0);
+
+  EXPECT_EQ(
+    TelemetryRatePolicy::get_rate_parameter_name("/robot/joint_trajectory_controller/state"),
+    "rates.robot.joint_trajectory_controller.state");
+}
+
+TEST_F(TestTelemetryRatePolicy, topics_are_due_at_their_own_rate_without_a_policy)
+{
+  auto policy = TelemetryRatePolicy::get_instance();
+  EXPECT_EQ(policy.get(), TelemetryRatePolicy::get_instance().get());
+  auto rate = policy->register_topic("/", "/own_rate_controller/controller_state", 100.0);
+  auto every_update_rate = policy->register_topic("/", "/joint_states", 0.0);
+  EXPECT_EQ(rate->get_topic(), "/own_rate_controller/controller_state");
+  EXPECT_DOUBLE_EQ(rate->get_own_rate(), 100.0);
+
+  EXPECT_DOUBLE_EQ(rate->get_rate(), 100.0);
+  EXPECT_EQ(count_due_updates(*rate), 100u);
+  EXPECT_DOUBLE_EQ(every_update_rate->get_rate(), 0.0);
+  EXPECT_EQ(count_due_updates(*every_update_rate), 1000u);
+
+  // no burst after a gap
+  rate->reset();
+  EXPECT_TRUE(rate->is_due(rclcpp::Time(0, 0, RCL_STEADY_TIME)));
+  EXPECT_TRUE(rate->is_due(rclcpp::Time(0, 55000000, RCL_STEADY_TIME)));
+  EXPECT_FALSE(rate->is_due(rclcpp::Time(0, 56000000, RCL_STEADY_TIME)));
+  EXPECT_TRUE(rate->is_due(rclcpp::Time(0, 66000000, RCL_STEADY_TIME)));
+}
+
+TEST_F(TestTelemetryRatePolicy, parameters_adjust_the_rates_of_the_registered_topics)
+{
+  auto policy = TelemetryRatePolicy::get_instance();
+  auto fast_rate = policy->register_topic("/", "/fast_controller/controller_state", 500.0);
+  auto slow_rate = policy->register_topic("/", "/slow_controller/controller_state", 20.0);
+
+  ASSERT_TRUE(policy->set_default_rate(100.0));
+  EXPECT_DOUBLE_EQ(fast_rate->get_rate(), 100.0);
+  EXPECT_DOUBLE_EQ(slow_rate->get_rate(), 20.0);
+  EXPECT_EQ(count_due_updates(*fast_rate), 100u);
+
+  ASSERT_TRUE(policy->set_topic_rate("/slow_controller/controller_state", 200.0));
+  EXPECT_DOUBLE_EQ(slow_rate->get_rate(), 200.0);
+  EXPECT_DOUBLE_EQ(fast_rate->get_rate(), 100.0);
+  // topics registered later get the policy as well
+  auto late_rate = policy->register_topic("/", "/late_controller/controller_state", 0.0);
+  EXPECT_DOUBLE_EQ(late_rate->get_rate(), 100.0);
+
+  // invalid rates are rejected
+  EXPECT_FALSE(policy->set_default_rate(-1.0));
+  EXPECT_DOUBLE_EQ(fast_rate->get_rate(), 100.0);
+
+  ASSERT_TRUE(policy->set_topic_rate("/slow_controller/controller_state", -1.0));
+  ASSERT_TRUE(policy->set_default_rate(0.0));
+  EXPECT_DOUBLE_EQ(fast_rate->get_rate(), 500.0);
+  EXPECT_DOUBLE_EQ(slow_rate->get_rate(), 20.0);
+  EXPECT_DOUBLE_EQ(late_rate->get_rate(), 0.0);
+}
+
+TEST_F(TestTelemetryRatePolicy, rates_are_set_with_the_parameter_services)
+{
+  auto policy = TelemetryRatePolicy::get_instance();
+  auto rate = policy->register_topic("/", "/service_controller/odom", 50.0);
+
+  auto node = std::make_shared<rclcpp::Node>("test_telemetry_rate_policy");
+  auto client = std::make_shared<rclcpp::SyncParametersClient>(node, "/telemetry_rate_policy");
+  ASSERT_TRUE(client->wait_for_service(5s));
+  const auto results =
+    client->set_parameters({rclcpp::Parameter("rates.service_controller.odom", 10.0)}, 5s);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_TRUE(results[0].successful);
+  EXPECT_DOUBLE_EQ(rate->get_rate(), 10.0);
+  EXPECT_EQ(count_due_updates(*rate), 10u);
+
+  ASSERT_TRUE(policy->set_topic_rate("/service_controller/odom", -1.0));
+}
@@ -0,0 +1,143 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TF_AGGREGATOR__TRANSFORM_AGGREGATOR_HPP_
+#define TF_AGGREGATOR__TRANSFORM_AGGREGATOR_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+#include "tf_aggregator/visibility_control.h"
+
+namespace tf_aggregator
+{
+class TransformAggregator;
+
+/**
+ * \brief Planar transform registered at the TransformAggregator.
+ *
+ * The transform is unregistered when the slot is destroyed.
+ */
+class TransformSlot
+{
+public:
+  TF_AGGREGATOR_PUBLIC
+  ~TransformSlot();
+
+  TransformSlot(const TransformSlot &) = delete;
+  TransformSlot & operator=(const TransformSlot &) = delete;
+
+  /**
+   * Set the transform for the next message, realtime-safe. Only one thread may call it.
+   *
+   * \param[in] stamp time of the transform
+   * \param[in] x, y translation of the child frame
+   * \param[in] yaw rotation of the child frame around the z axis
+   */
+  TF_AGGREGATOR_PUBLIC
+  void set(const rclcpp::Time & stamp, double x, double y, double yaw);
+
+  const std::string & get_frame_id() const { return frame_id_; }
+  const std::string & get_child_frame_id() const { return child_frame_id_; }
+
+private:
+  friend class TransformAggregator;
+
+  TransformSlot(
+    std::shared_ptr<TransformAggregator> aggregator, const std::string & frame_id,
+    const std::string & child_frame_id);
+
+  /// Transform set after the one read with \p version, false if there is none
+  bool read_newer(geometry_msgs::msg::TransformStamped & transform, uint64_t & version) const;
+
+  std::shared_ptr<TransformAggregator> aggregator_;
+  std::string frame_id_;
+  std::string child_frame_id_;
+
+  // seqlock with a single writer, odd while set() is writing
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<int64_t> stamp_nanoseconds_{0};
+  std::array<std::atomic<double>, 3> pose_{};
+  // only used by the publishing thread
+  uint64_t published_version_ = 0;
+};
+
+/**
+ * \brief Publishes the transforms of all controllers in this process in one message.
+ *
+ * Controllers register their transforms instead of publishing them with their own publishers.
+ * One non-realtime thread collects the transforms that were set since the last message and
+ * publishes them together on ``/tf``, on a node created in the namespace of the first controller
+ * that registers. The aggregator exists as long as any transform is registered.
+ */
+class TransformAggregator : public std::enable_shared_from_this<TransformAggregator>
+{
+public:
+  /// Period between two checks for new transforms, the same as in realtime_tools
+  static constexpr std::chrono::microseconds POLL_PERIOD{500};
+
+  /// The aggregator of this process, created if there is none
+  TF_AGGREGATOR_PUBLIC
+  static std::shared_ptr<TransformAggregator> get_instance();
+
+  TF_AGGREGATOR_PUBLIC
+  ~TransformAggregator();
+
+  TransformAggregator(const TransformAggregator &) = delete;
+  TransformAggregator & operator=(const TransformAggregator &) = delete;
+
+  /**
+   * Register the transform from \p frame_id to \p child_frame_id, not realtime-safe.
+   *
+   * \param[in] node_namespace namespace of the node of the aggregator, if it does not exist yet
+   */
+  TF_AGGREGATOR_PUBLIC
+  std::shared_ptr<TransformSlot> register_transform(
+    const std::string & node_namespace, const std::string & frame_id,
+    const std::string & child_frame_id);
+
+  /// Publish the transforms that were set since the last message, returns false if there are none
+  TF_AGGREGATOR_PUBLIC
+  bool publish_new_transforms();
+
+private:
+  friend class TransformSlot;
+
+  TransformAggregator() = default;
+
+  void unregister_transform(const TransformSlot * slot);
+  void run();
+
+  std::mutex mutex_;
+  std::vector<TransformSlot *> slots_;
+  rclcpp::Node::SharedPtr node_;
+  rclcpp::Publisher<tf2_msgs::msg::TFMessage>::SharedPtr publisher_;
+  tf2_msgs::msg::TFMessage message_;
+
+  std::atomic<bool> keep_running_{false};
+  std::thread thread_;
+};
+
+}  // namespace tf_aggregator
+
+#endif  // TF_AGGREGATOR__TRANSFORM_AGGREGATOR_HPP_
@@ -0,0 +1,179 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tf_aggregator/transform_aggregator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace
+{
+constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
+constexpr auto NODE_NAME = "tf_aggregator";
+}  // namespace
+
+namespace tf_aggregator
+{
+TransformSlot::TransformSlot(
+  std::shared_ptr<TransformAggregator> aggregator, const std::string & frame_id,
+  const std::string & child_frame_id)
+: aggregator_(std::move(aggregator)), frame_id_(frame_id), child_frame_id_(child_frame_id)
+{
+}
+
+TransformSlot::~TransformSlot() { aggregator_->unregister_transform(this); }
+
+void TransformSlot::set(const rclcpp::Time & stamp, double x, double y, double yaw)
+{
+  const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  stamp_nanoseconds_.store(stamp.nanoseconds(), std::memory_order_relaxed);
+  pose_[0].store(x, std::memory_order_relaxed);
+  pose_[1].store(y, std::memory_order_relaxed);
+  pose_[2].store(yaw, std::memory_order_relaxed);
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+bool TransformSlot::read_newer(
+  geometry_msgs::msg::TransformStamped & transform, uint64_t & version) const
+{
+  const uint64_t sequence = sequence_.load(std::memory_order_acquire);
+  if (sequence == version || sequence % 2 != 0)
+  {
+    // an interrupted write is collected in the next period
+    return false;
+  }
+  const int64_t stamp_nanoseconds = stamp_nanoseconds_.load(std::memory_order_relaxed);
+  const double x = pose_[0].load(std::memory_order_relaxed);
+  const double y = pose_[1].load(std::memory_order_relaxed);
+  const double yaw = pose_[2].load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (sequence_.load(std::memory_order_relaxed) != sequence)
+  {
+    return false;
+  }
+  version = sequence;
+
+  transform.header.stamp = rclcpp::Time(stamp_nanoseconds);
+  transform.header.frame_id = frame_id_;
+  transform.child_frame_id = child_frame_id_;
+  transform.transform.translation.x = x;
+  transform.transform.translation.y = y;
+  transform.transform.translation.z = 0.0;
+  transform.transform.rotation.x = 0.0;
+  transform.transform.rotation.y = 0.0;
+  transform.transform.rotation.z = std::sin(0.5 * yaw);
+  transform.transform.rotation.w = std::cos(0.5 * yaw);
+  return true;
+}
+
+std::shared_ptr<TransformAggregator> TransformAggregator::get_instance()
+{
+  static std::mutex instance_mutex;
+  static std::weak_ptr<TransformAggregator> instance;
+
+  std::lock_guard<std::mutex> guard(instance_mutex);
+  auto aggregator = instance.lock();
+  if (!aggregator)
+  {
+    // the constructor is private
+    aggregator = std::shared_ptr<TransformAggregator>(new TransformAggregator());
+    instance = aggregator;
+  }
+  return aggregator;
+}
+
+TransformAggregator::~TransformAggregator()
+{
+  keep_running_ = false;
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+std::shared_ptr<TransformSlot> TransformAggregator::register_transform(
+  const std::string & node_namespace, const std::string & frame_id,
+  const std::string & child_frame_id)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!node_)
+  {
+    // own node, independent of the lifecycle of the registering controllers
+    node_ = std::make_shared<rclcpp::Node>(
+      NODE_NAME, node_namespace,
+      rclcpp::NodeOptions()
+        .use_global_arguments(false)
+        .start_parameter_services(false)
+        .start_parameter_event_publisher(false));
+    publisher_ = node_->create_publisher<tf2_msgs::msg::TFMessage>(
+      DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
+    keep_running_ = true;
+    thread_ = std::thread(&TransformAggregator::run, this);
+  }
+
+  // the slot is not constructible outside of the aggregator
+  std::shared_ptr<TransformSlot> slot(
+    new TransformSlot(shared_from_this(), frame_id, child_frame_id));
+  slots_.push_back(slot.get());
+  message_.transforms.reserve(slots_.size());
+  return slot;
+}
+
+bool TransformAggregator::publish_new_transforms()
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!publisher_)
+  {
+    return false;
+  }
+
+  message_.transforms.resize(slots_.size());
+  size_t num_transforms = 0;
+  for (auto * slot : slots_)
+  {
+    if (slot->read_newer(message_.transforms[num_transforms], slot->published_version_))
+    {
+      ++num_transforms;
+    }
+  }
+  if (num_transforms == 0)
+  {
+    return false;
+  }
+  message_.transforms.resize(num_transforms);
+  publisher_->publish(message_);
+  return true;
+}
+
+void TransformAggregator::unregister_transform(const TransformSlot * slot)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  slots_.erase(std::remove(slots_.begin(), slots_.end(), slot), slots_.end());
+}
+
+void TransformAggregator::run()
+{
+  while (keep_running_)
+  {
+    publish_new_transforms();
+    std::this_thread::sleep_for(POLL_PERIOD);
+  }
+}
+
+}  // namespace tf_aggregator
@@ -0,0 +1,133 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+#include "tf_aggregator/transform_aggregator.hpp"
+
+using namespace std::chrono_literals;
+using tf_aggregator::TransformAggregator;
+
+class TestTransformAggregator : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase() { rclcpp::init(0, nullptr); }
+
+  static void TearDownTestCase() { rclcpp::shutdown(); }
+
+  void SetUp() override
+  {
+    node_ = std::make_shared<rclcpp::Node>("test_transform_aggregator");
+    subscription_ = node_->create_subscription<tf2_msgs::msg::TFMessage>(
+      "/tf", rclcpp::SystemDefaultsQoS(),
+      [this](const tf2_msgs::msg::TFMessage::SharedPtr message)
+      { messages_.push_back(*message); });
+  }
+
+  /// Receive messages for \p duration
+  void spin_for(const std::chrono::milliseconds duration)
+  {
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(node_);
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+      executor.spin_some(10ms);
+    }
+  }
+
+  /// Number of received transforms to \p child_frame_id
+  size_t count_received(const std::string & child_frame_id) const
+  {
+    size_t count = 0;
+    for (const auto & message : messages_)
+    {
+      for (const auto & transform : message.transforms)
+      {
+        count += transform.child_frame_id == child_frame_id ? 1 : 0;
+      }
+    }
+    return count;
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  rclcpp::Subscription<tf2_msgs::msg::TFMessage>::SharedPtr subscription_;
+  std::vector<tf2_msgs::msg::TFMessage> messages_;
+};
+
+TEST_F(TestTransformAggregator, instance_is_shared_while_transforms_are_registered)
+{
+  auto slot = TransformAggregator::get_instance()->register_transform("/", "odom", "base_link");
+  const auto * instance = TransformAggregator::get_instance().get();
+  EXPECT_EQ(instance, TransformAggregator::get_instance().get());
+  EXPECT_EQ(slot->get_frame_id(), "odom");
+  EXPECT_EQ(slot->get_child_frame_id(), "base_link");
+}
+
+TEST_F(TestTransformAggregator, new_transforms_are_published_once)
+{
+  auto aggregator = TransformAggregator::get_instance();
+  auto first_slot = aggregator->register_transform("/", "odom", "first_base_link");
+  auto second_slot = aggregator->register_transform("/", "odom", "second_base_link");
+  spin_for(100ms);
+
+  const rclcpp::Time stamp(1, 500, RCL_ROS_TIME);
+  first_slot->set(stamp, 1.0, 2.0, M_PI_2);
+  second_slot->set(stamp, -1.0, -2.0, 0.0);
+  spin_for(200ms);
+
+  ASSERT_EQ(count_received("first_base_link"), 1u);
+  ASSERT_EQ(count_received("second_base_link"), 1u);
+  for (const auto & message : messages_)
+  {
+    for (const auto & transform : message.transforms)
+    {
+      EXPECT_EQ(transform.header.frame_id, "odom");
+      EXPECT_EQ(rclcpp::Time(transform.header.stamp).nanoseconds(), stamp.nanoseconds());
+      if (transform.child_frame_id == "first_base_link")
+      {
+        EXPECT_DOUBLE_EQ(transform.transform.translation.x, 1.0);
+        EXPECT_DOUBLE_EQ(transform.transform.translation.y, 2.0);
+        EXPECT_NEAR(transform.transform.rotation.z, std::sqrt(0.5), 1e-12);
+        EXPECT_NEAR(transform.transform.rotation.w, std::sqrt(0.5), 1e-12);
+      }
+    }
+  }
+
+  // nothing new to publish
+  EXPECT_FALSE(aggregator->publish_new_transforms());
+}
+
+TEST_F(TestTransformAggregator, unregistered_transforms_are_not_published)
+{
+  auto aggregator = TransformAggregator::get_instance();
+  auto kept_slot = aggregator->register_transform("/", "odom", "kept_base_link");
+  auto removed_slot = aggregator->register_transform("/", "odom", "removed_base_link");
+  removed_slot.reset();
+  spin_for(100ms);
+
+  kept_slot->set(rclcpp::Time(1, 0, RCL_ROS_TIME), 0.0, 0.0, 0.0);
+  spin_for(200ms);
+
+  EXPECT_EQ(count_received("kept_base_link"), 1u);
+  EXPECT_EQ(count_received("removed_base_link"), 0u);
+}
@@ -0,0 +1,147 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRAJECTORY_HORIZON_EXCHANGE__TRAJECTORY_HORIZON_EXCHANGE_HPP_
+#define TRAJECTORY_HORIZON_EXCHANGE__TRAJECTORY_HORIZON_EXCHANGE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "command_mailbox/named_slot_registry.hpp"
+#include "trajectory_horizon_exchange/visibility_control.h"
+
+namespace trajectory_horizon_exchange
+{
+/// Equidistant samples of the upcoming reference of a trajectory controller at one update
+struct TrajectoryHorizon
+{
+  /// Time of the update the horizon was sampled in
+  int64_t stamp_nanoseconds = 0;
+  /// Trajectory time of the first sample, which is the reference of that update
+  int64_t start_nanoseconds = 0;
+  /// Time between two samples
+  int64_t period_nanoseconds = 0;
+  /// Number of valid samples, zero if the controller doesn't follow a trajectory
+  size_t num_samples = 0;
+  size_t num_joints = 0;
+  /// Values of the samples, stored as [sample * num_joints + joint]
+  std::vector<double> positions;
+  std::vector<double> velocities;
+  std::vector<double> accelerations;
+};
+
+/**
+ * \brief Latest horizon of one controller, shared with the other controllers of the process.
+ *
+ * A seqlock with a single writer: the sequence number is odd while write() is in progress, so
+ * read() detects a concurrent write and retries instead of waiting for it. Unlike a
+ * command_mailbox::NamedMailbox, the size of the horizon is only known on configuration, so the
+ * storage of the values is allocated by configure(). write() and read() neither lock nor allocate
+ * memory.
+ */
+class TrajectoryHorizonSlot
+{
+public:
+  /// Attempts of read() before giving up, in case the writer is preempted within write()
+  static constexpr size_t MAX_READ_ATTEMPTS = 8;
+
+  explicit TrajectoryHorizonSlot(const std::string & name) : name_(name) {}
+
+  TrajectoryHorizonSlot(const TrajectoryHorizonSlot &) = delete;
+  TrajectoryHorizonSlot & operator=(const TrajectoryHorizonSlot &) = delete;
+
+  /**
+   * Allocate the storage for horizons of up to \p max_samples samples of \p num_joints joints,
+   * not realtime-safe. Called by the writer, e.g., in its ``on_configure()``.
+   *
+   * A storage of other dimensions replaces the previous one, which is kept until the slot is
+   * destroyed, so readers still reading it are not affected.
+   */
+  TRAJECTORY_HORIZON_EXCHANGE_PUBLIC
+  void configure(size_t max_samples, size_t num_joints);
+
+  /**
+   * Replace the horizon, realtime-safe. Only one thread may call it.
+   *
+   * \return false if the slot is not configured, or if \p horizon doesn't fit into its storage.
+   * The slot is not changed in that case.
+   */
+  TRAJECTORY_HORIZON_EXCHANGE_PUBLIC
+  bool write(const TrajectoryHorizon & horizon);
+
+  /**
+   * Copy the latest horizon to \p horizon, realtime-safe if \p horizon was prepared by prepare().
+   *
+   * \return false if nothing was written yet, if the storage of \p horizon is too small, or if a
+   * write was in progress during all attempts. \p horizon is not changed in the first two cases,
+   * and has no samples in the last one.
+   */
+  TRAJECTORY_HORIZON_EXCHANGE_PUBLIC
+  bool read(TrajectoryHorizon & horizon) const;
+
+  /**
+   * Reserve the memory of \p horizon for the horizons of the current storage, not realtime-safe.
+   * Called by a reader, e.g., in its ``on_activate()``.
+   *
+   * \return false if the slot is not configured yet.
+   */
+  TRAJECTORY_HORIZON_EXCHANGE_PUBLIC
+  bool prepare(TrajectoryHorizon & horizon) const;
+
+  const std::string & get_name() const { return name_; }
+
+private:
+  struct Storage
+  {
+    Storage(size_t max_samples, size_t num_joints);
+
+    size_t size() const { return max_samples * num_joints; }
+
+    const size_t max_samples;
+    const size_t num_joints;
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<int64_t> stamp_nanoseconds{0};
+    std::atomic<int64_t> start_nanoseconds{0};
+    std::atomic<int64_t> period_nanoseconds{0};
+    std::atomic<size_t> num_samples{0};
+    /// positions, velocities and accelerations of size() values each
+    std::unique_ptr<std::atomic<double>[]> values;
+  };
+
+  std::string name_;
+  std::atomic<Storage *> storage_{nullptr};
+  std::mutex storages_mutex_;
+  std::vector<std::unique_ptr<Storage>> storages_;
+};
+
+/// Horizon slots of all controllers in this process, by name
+class TrajectoryHorizonExchange : public command_mailbox::NamedSlotRegistry<TrajectoryHorizonSlot>
+{
+public:
+  /// The exchange of this process
+  TRAJECTORY_HORIZON_EXCHANGE_PUBLIC
+  static TrajectoryHorizonExchange & get_instance();
+
+private:
+  TrajectoryHorizonExchange() = default;
+};
+
+}  // namespace trajectory_horizon_exchange
+
+#endif  // TRAJECTORY_HORIZON_EXCHANGE__TRAJECTORY_HORIZON_EXCHANGE_HPP_
@@ -0,0 +1,149 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "trajectory_horizon_exchange/trajectory_horizon_exchange.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace trajectory_horizon_exchange
+{
+TrajectoryHorizonSlot::Storage::Storage(size_t max_samples, size_t num_joints)
+: max_samples(max_samples),
+  num_joints(num_joints),
+  values(std::make_unique<std::atomic<double>[]>(3 * max_samples * num_joints))
+{
+}
+
+void TrajectoryHorizonSlot::configure(size_t max_samples, size_t num_joints)
+{
+  const Storage * storage = storage_.load(std::memory_order_acquire);
+  if (storage && storage->max_samples == max_samples && storage->num_joints == num_joints)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(storages_mutex_);
+  storages_.push_back(std::make_unique<Storage>(max_samples, num_joints));
+  storage_.store(storages_.back().get(), std::memory_order_release);
+}
+
+bool TrajectoryHorizonSlot::write(const TrajectoryHorizon & horizon)
+{
+  Storage * storage = storage_.load(std::memory_order_acquire);
+  const size_t num_values = horizon.num_samples * horizon.num_joints;
+  if (
+    !storage || horizon.num_samples > storage->max_samples ||
+    (horizon.num_samples > 0 && horizon.num_joints != storage->num_joints) ||
+    horizon.positions.size() < num_values || horizon.velocities.size() < num_values ||
+    horizon.accelerations.size() < num_values)
+  {
+    return false;
+  }
+
+  const uint64_t sequence = storage->sequence.load(std::memory_order_relaxed);
+  storage->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  storage->stamp_nanoseconds.store(horizon.stamp_nanoseconds, std::memory_order_relaxed);
+  storage->start_nanoseconds.store(horizon.start_nanoseconds, std::memory_order_relaxed);
+  storage->period_nanoseconds.store(horizon.period_nanoseconds, std::memory_order_relaxed);
+  storage->num_samples.store(horizon.num_samples, std::memory_order_relaxed);
+  std::atomic<double> * positions = storage->values.get();
+  std::atomic<double> * velocities = positions + storage->size();
+  std::atomic<double> * accelerations = velocities + storage->size();
+  for (size_t i = 0; i < num_values; ++i)
+  {
+    positions[i].store(horizon.positions[i], std::memory_order_relaxed);
+    velocities[i].store(horizon.velocities[i], std::memory_order_relaxed);
+    accelerations[i].store(horizon.accelerations[i], std::memory_order_relaxed);
+  }
+  storage->sequence.store(sequence + 2, std::memory_order_release);
+  return true;
+}
+
+bool TrajectoryHorizonSlot::read(TrajectoryHorizon & horizon) const
+{
+  const Storage * storage = storage_.load(std::memory_order_acquire);
+  if (
+    !storage || storage->sequence.load(std::memory_order_acquire) == 0 ||
+    horizon.positions.capacity() < storage->size() ||
+    horizon.velocities.capacity() < storage->size() ||
+    horizon.accelerations.capacity() < storage->size())
+  {
+    return false;
+  }
+
+  const std::atomic<double> * positions = storage->values.get();
+  const std::atomic<double> * velocities = positions + storage->size();
+  const std::atomic<double> * accelerations = velocities + storage->size();
+  for (size_t attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt)
+  {
+    const uint64_t sequence = storage->sequence.load(std::memory_order_acquire);
+    if (sequence % 2 != 0)
+    {
+      continue;
+    }
+    horizon.stamp_nanoseconds = storage->stamp_nanoseconds.load(std::memory_order_relaxed);
+    horizon.start_nanoseconds = storage->start_nanoseconds.load(std::memory_order_relaxed);
+    horizon.period_nanoseconds = storage->period_nanoseconds.load(std::memory_order_relaxed);
+    horizon.num_samples = storage->num_samples.load(std::memory_order_relaxed);
+    horizon.num_joints = storage->num_joints;
+    // the number of samples is checked again with the sequence, until then it may be torn
+    const size_t num_values = std::min(horizon.num_samples, storage->max_samples) *
+                              storage->num_joints;
+    // within the reserved capacity, no memory is allocated
+    horizon.positions.resize(num_values);
+    horizon.velocities.resize(num_values);
+    horizon.accelerations.resize(num_values);
+    for (size_t i = 0; i < num_values; ++i)
+    {
+      horizon.positions[i] = positions[i].load(std::memory_order_relaxed);
+      horizon.velocities[i] = velocities[i].load(std::memory_order_relaxed);
+      horizon.accelerations[i] = accelerations[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (storage->sequence.load(std::memory_order_relaxed) == sequence)
+    {
+      return true;
+    }
+  }
+
+  horizon.num_samples = 0;
+  horizon.positions.clear();
+  horizon.velocities.clear();
+  horizon.accelerations.clear();
+  return false;
+}
+
+bool TrajectoryHorizonSlot::prepare(TrajectoryHorizon & horizon) const
+{
+  const Storage * storage = storage_.load(std::memory_order_acquire);
+  if (!storage)
+  {
+    return false;
+  }
+  horizon.positions.reserve(storage->size());
+  horizon.velocities.reserve(storage->size());
+  horizon.accelerations.reserve(storage->size());
+  return true;
+}
+
+TrajectoryHorizonExchange & TrajectoryHorizonExchange::get_instance()
+{
+  static TrajectoryHorizonExchange instance;
+  return instance;
+}
+
+}  // namespace trajectory_horizon_exchange
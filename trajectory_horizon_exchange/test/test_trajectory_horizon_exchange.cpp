@@ -0,0 +1,151 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "trajectory_horizon_exchange/trajectory_horizon_exchange.hpp"
+
+using trajectory_horizon_exchange::TrajectoryHorizon;
+using trajectory_horizon_exchange::TrajectoryHorizonExchange;
+
+namespace
+{
+// a horizon of \p num_samples samples of two joints, all values set to \p value
+TrajectoryHorizon make_horizon(size_t num_samples, double value)
+{
+  TrajectoryHorizon horizon;
+  horizon.stamp_nanoseconds = static_cast<int64_t>(value);
+  horizon.start_nanoseconds = static_cast<int64_t>(value) + 1;
+  horizon.period_nanoseconds = 10000000;
+  horizon.num_samples = num_samples;
+  horizon.num_joints = 2;
+  horizon.positions.assign(2 * num_samples, value);
+  horizon.velocities.assign(2 * num_samples, value);
+  horizon.accelerations.assign(2 * num_samples, value);
+  return horizon;
+}
+}  // namespace
+
+TEST(TestTrajectoryHorizonExchange, slots_are_shared_by_name)
+{
+  auto & exchange = TrajectoryHorizonExchange::get_instance();
+  EXPECT_EQ(&exchange, &TrajectoryHorizonExchange::get_instance());
+
+  auto writer_slot = exchange.get_slot("/first_controller");
+  EXPECT_EQ(writer_slot, exchange.get_slot("/first_controller"));
+  EXPECT_NE(writer_slot, exchange.get_slot("/second_controller"));
+  EXPECT_EQ(writer_slot->get_name(), "/first_controller");
+}
+
+TEST(TestTrajectoryHorizonExchange, latest_horizon_is_read)
+{
+  auto slot = TrajectoryHorizonExchange::get_instance().get_slot("/latest_controller");
+
+  TrajectoryHorizon horizon;
+  EXPECT_FALSE(slot->prepare(horizon));
+  EXPECT_FALSE(slot->write(make_horizon(3, 1.0)));
+
+  slot->configure(4, 2);
+  ASSERT_TRUE(slot->prepare(horizon));
+  EXPECT_FALSE(slot->read(horizon));
+  EXPECT_TRUE(slot->write(make_horizon(4, 1.0)));
+  // doesn't fit into the storage
+  EXPECT_FALSE(slot->write(make_horizon(5, 2.0)));
+
+  auto written = make_horizon(3, 3.0);
+  written.positions[5] = -1.0;
+  written.velocities[0] = 0.5;
+  EXPECT_TRUE(slot->write(written));
+  ASSERT_TRUE(slot->read(horizon));
+  EXPECT_EQ(horizon.stamp_nanoseconds, 3);
+  EXPECT_EQ(horizon.start_nanoseconds, 4);
+  EXPECT_EQ(horizon.period_nanoseconds, 10000000);
+  EXPECT_EQ(horizon.num_samples, 3u);
+  EXPECT_EQ(horizon.num_joints, 2u);
+  EXPECT_THAT(horizon.positions, testing::ElementsAre(3.0, 3.0, 3.0, 3.0, 3.0, -1.0));
+  EXPECT_THAT(horizon.velocities, testing::ElementsAre(0.5, 3.0, 3.0, 3.0, 3.0, 3.0));
+  EXPECT_EQ(horizon.accelerations.size(), 6u);
+
+  // a horizon without samples, e.g., while not following a trajectory
+  EXPECT_TRUE(slot->write(make_horizon(0, 4.0)));
+  ASSERT_TRUE(slot->read(horizon));
+  EXPECT_EQ(horizon.num_samples, 0u);
+  EXPECT_TRUE(horizon.positions.empty());
+}
+
+TEST(TestTrajectoryHorizonExchange, reconfigured_slots_need_prepared_readers)
+{
+  auto slot = TrajectoryHorizonExchange::get_instance().get_slot("/reconfigured_controller");
+  slot->configure(2, 2);
+  TrajectoryHorizon horizon;
+  ASSERT_TRUE(slot->prepare(horizon));
+
+  slot->configure(8, 2);
+  EXPECT_TRUE(slot->write(make_horizon(8, 1.0)));
+  // the memory of the reader is too small for the new storage
+  EXPECT_FALSE(slot->read(horizon));
+  EXPECT_EQ(horizon.num_samples, 0u);
+  ASSERT_TRUE(slot->prepare(horizon));
+  ASSERT_TRUE(slot->read(horizon));
+  EXPECT_EQ(horizon.num_samples, 8u);
+}
+
+TEST(TestTrajectoryHorizonExchange, concurrent_reads_are_consistent)
+{
+  auto slot = TrajectoryHorizonExchange::get_instance().get_slot("/concurrent_controller");
+  slot->configure(16, 2);
+  std::atomic<bool> keep_writing{true};
+  std::thread writer(
+    [&]()
+    {
+      auto horizon = make_horizon(16, 0.0);
+      for (int64_t i = 1; keep_writing; ++i)
+      {
+        const auto value = static_cast<double>(i);
+        horizon.stamp_nanoseconds = i;
+        horizon.num_samples = static_cast<size_t>(i % 16);
+        horizon.positions.assign(horizon.positions.size(), value);
+        horizon.velocities.assign(horizon.velocities.size(), value);
+        horizon.accelerations.assign(horizon.accelerations.size(), value);
+        slot->write(horizon);
+      }
+    });
+
+  TrajectoryHorizon horizon;
+  ASSERT_TRUE(slot->prepare(horizon));
+  size_t num_reads = 0;
+  while (num_reads < 10000)
+  {
+    if (slot->read(horizon))
+    {
+      const auto value = static_cast<double>(horizon.stamp_nanoseconds);
+      ASSERT_EQ(horizon.num_samples, static_cast<size_t>(horizon.stamp_nanoseconds % 16));
+      ASSERT_EQ(horizon.positions.size(), 2 * horizon.num_samples);
+      for (size_t i = 0; i < horizon.positions.size(); ++i)
+      {
+        ASSERT_DOUBLE_EQ(horizon.positions[i], value);
+        ASSERT_DOUBLE_EQ(horizon.velocities[i], value);
+        ASSERT_DOUBLE_EQ(horizon.accelerations[i], value);
+      }
+      ++num_reads;
+    }
+  }
+  keep_writing = false;
+  writer.join();
+}
@@ -22,6 +22,7 @@
 #include <cmath>
 
 #include "rclcpp/time.hpp"
+#include "odometry_integration/pose_integrator.hpp"
 #include "rcpputils/rolling_mean_accumulator.hpp"
 
 namespace tricycle_controller
@@ -34,10 +35,12 @@ public:
   bool update(double left_vel, double right_vel, const rclcpp::Duration & dt);
   void updateOpenLoop(double linear, double angular, const rclcpp::Duration & dt);
   void resetOdometry();
+  /// Continue from a persisted odometry, the velocities seed the rolling means
+  void restore(double x, double y, double heading, double linear, double angular);
 
-  double getX() const { return x_; }
-  double getY() const { return y_; }
-  double getHeading() const { return heading_; }
+  double getX() const { return pose_.x(); }
+  double getY() const { return pose_.y(); }
+  double getHeading() const { return pose_.heading(); }
   double getLinear() const { return linear_; }
   double getAngular() const { return angular_; }
 
@@ -47,14 +50,10 @@ public:
 private:
   using RollingMeanAccumulator = rcpputils::RollingMeanAccumulator<double>;
 
-  void integrateRungeKutta2(double linear, double angular);
-  void integrateExact(double linear, double angular);
   void resetAccumulators();
 
   // Current pose:
-  double x_;        //   [m]
-  double y_;        //   [m]
-  double heading_;  // [rad]
+  odometry_integration::PoseIntegrator<> pose_;
 
   // Current velocity:
   double linear_;   //   [m/s]
@@ -21,6 +21,8 @@
 
 #include <cmath>
 
+#include "motion_limits/axis_limiter.hpp"
+
 namespace tricycle_controller
 {
 class SteeringLimiter
@@ -75,6 +77,9 @@ public:
    */
   double limit_acceleration(double & p, double p0, double p1, double dt);
 
+  /// The limits, to limit the position together with other axes
+  motion_limits::AxisLimits<double> axis_limits() const;
+
 private:
   // Position limits:
   double min_position_;
@@ -87,6 +92,8 @@ private:
   // Acceleration limits:
   double min_acceleration_;
   double max_acceleration_;
+
+  motion_limits::AxisLimiter<1> limiter_;
 };
 
 }  // namespace tricycle_controller
@@ -21,6 +21,8 @@
 
 #include <cmath>
 
+#include "motion_limits/axis_limiter.hpp"
+
 namespace tricycle_controller
 {
 class TractionLimiter
@@ -79,6 +81,9 @@ public:
    */
   double limit_jerk(double & v, double v0, double v1, double dt);
 
+  /// The limits, to limit the velocity together with other axes
+  motion_limits::AxisLimits<double> axis_limits() const;
+
 private:
   // Velocity limits:
   double min_velocity_;
@@ -95,6 +100,8 @@ private:
   // Jerk limits:
   double min_jerk_;
   double max_jerk_;
+
+  motion_limits::AxisLimiter<1> limiter_;
 };
 
 }  // namespace tricycle_controller
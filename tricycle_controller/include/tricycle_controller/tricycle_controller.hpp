@@ -19,37 +19,42 @@
 #ifndef TRICYCLE_CONTROLLER__TRICYCLE_CONTROLLER_HPP_
 #define TRICYCLE_CONTROLLER__TRICYCLE_CONTROLLER_HPP_
 
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <memory>
-#include <queue>
 #include <string>
 #include <tuple>
 #include <vector>
 
 #include "ackermann_msgs/msg/ackermann_drive.hpp"
-#include "controller_interface/controller_interface.hpp"
+#include "command_mailbox/command_mailbox.hpp"
+#include "controller_interface/chainable_controller_interface.hpp"
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "hardware_interface/handle.hpp"
+#include "motion_limits/axis_limiter.hpp"
 #include "nav_msgs/msg/odometry.hpp"
+#include "odometry_persistence/odometry_snapshot.hpp"
+#include "publisher_pool/realtime_publisher.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_box.h"
 #include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
 #include "std_srvs/srv/empty.hpp"
 #include "tf2_msgs/msg/tf_message.hpp"
+#include "tf_aggregator/transform_aggregator.hpp"
 #include "tricycle_controller/odometry.hpp"
 #include "tricycle_controller/steering_limiter.hpp"
 #include "tricycle_controller/traction_limiter.hpp"
 #include "tricycle_controller/visibility_control.h"
+#include "update_time_source/update_time_source.hpp"
 
 namespace tricycle_controller
 {
 using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
 
-class TricycleController : public controller_interface::ControllerInterface
+class TricycleController : public controller_interface::ChainableControllerInterface
 {
   using Twist = geometry_msgs::msg::Twist;
   using TwistStamped = geometry_msgs::msg::TwistStamped;
@@ -66,7 +71,11 @@ public:
   controller_interface::InterfaceConfiguration state_interface_configuration() const override;
 
   TRICYCLE_CONTROLLER_PUBLIC
-  controller_interface::return_type update(
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  TRICYCLE_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
   TRICYCLE_CONTROLLER_PUBLIC
@@ -91,6 +100,11 @@ public:
   CallbackReturn on_shutdown(const rclcpp_lifecycle::State & previous_state) override;
 
 protected:
+  // override methods from ChainableControllerInterface
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
   struct TractionHandle
   {
     std::reference_wrapper<const hardware_interface::LoanedStateInterface> velocity_state;
@@ -126,6 +140,7 @@ protected:
   {
     bool open_loop = false;
     bool enable_odom_tf = false;
+    bool aggregate_odom_tf = false;
     bool odom_only_twist = false;  // for doing the pose integration in separate node
     std::string base_frame_id = "base_link";
     std::string odom_frame_id = "odom";
@@ -133,21 +148,56 @@ protected:
     std::array<double, 6> twist_covariance_diagonal;
   } odom_params_;
 
+  // see publisher_pool::get_shared_pool()
+  struct PublisherPoolParams
+  {
+    bool enable = false;
+    int64_t threads = 1;
+    std::vector<int64_t> cpu_affinity;
+  } publisher_pool_params_;
+
+  struct OdometryPersistenceParams
+  {
+    bool enable = false;
+    std::string path;
+    double period = 1.0;   // [s]
+    double max_age = 0.0;  // [s], 0.0 for any age
+  } odometry_persistence_params_;
+
+  // decimates a publisher to its publish rate
+  struct PublishRate
+  {
+    /// Publish with \p rate [Hz], every update if 0.0
+    void set_rate(double rate);
+    /// Whether the publisher publishes at \p time, once per period
+    bool should_publish(const rclcpp::Time & time);
+
+    rclcpp::Duration period = rclcpp::Duration::from_nanoseconds(0);
+    rclcpp::Time previous_timestamp{0, 0, RCL_CLOCK_UNINITIALIZED};
+  };
+  PublishRate odom_publish_rate_;
+  PublishRate tf_publish_rate_;
+  PublishRate ackermann_command_publish_rate_;
+
   bool publish_ackermann_command_ = false;
   std::shared_ptr<rclcpp::Publisher<AckermannDrive>> ackermann_command_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<AckermannDrive>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<AckermannDrive>>
     realtime_ackermann_command_publisher_ = nullptr;
 
   Odometry odometry_;
 
   std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odometry_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<nav_msgs::msg::Odometry>>
     realtime_odometry_publisher_ = nullptr;
 
   std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> odometry_transform_publisher_ =
     nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>
+  std::shared_ptr<publisher_pool::RealtimePublisher<tf2_msgs::msg::TFMessage>>
     realtime_odometry_transform_publisher_ = nullptr;
+  // replaces the transform publisher if the transform is aggregated
+  std::shared_ptr<tf_aggregator::TransformSlot> odometry_transform_slot_;
+  // writes the odometry to a file in the background, if odometry_persistence.enable is set
+  std::unique_ptr<odometry_persistence::SnapshotWriter> odometry_snapshot_writer_;
 
   // Timeout to consider cmd_vel commands old
   std::chrono::milliseconds cmd_vel_timeout_{500};
@@ -157,15 +207,33 @@ protected:
   rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr
     velocity_command_unstamped_subscriber_ = nullptr;
 
-  realtime_tools::RealtimeBox<std::shared_ptr<TwistStamped>> received_velocity_msg_ptr_{nullptr};
+  // velocities of the last cmd_vel message, passed from the subscriber to update()
+  struct StampedVelocityCommand
+  {
+    int64_t stamp_nanoseconds = 0;
+    double linear = 0.0;
+    double angular = 0.0;
+  };
+  command_mailbox::CommandMailbox<StampedVelocityCommand> received_velocity_command_;
+  // last command read by update(), kept if the subscriber is writing at the same time
+  StampedVelocityCommand last_velocity_command_;
+  // time of the last update, stamps the commands in the subscriber callbacks
+  update_time_source::UpdateTimeSource update_time_;
 
   rclcpp::Service<std_srvs::srv::Empty>::SharedPtr reset_odom_service_;
 
-  std::queue<AckermannDrive> previous_commands_;  // last two commands
+  // limits the wheel speed (rad/s) and the steering angle together, with the limits of
+  // TractionLimiter and SteeringLimiter
+  using WheelLimiter = motion_limits::AxisLimiter<2>;
+  using WheelCommand = WheelLimiter::Vector;
+  static constexpr size_t TRACTION_AXIS = 0;
+  static constexpr size_t STEERING_AXIS = 1;
+
+  // last two limited commands, stored as ring
+  std::array<WheelCommand, 2> previous_commands_;
+  size_t last_command_index_ = 0;  // the other entry is the second to last command
 
-  // speed limiters
-  TractionLimiter limiter_traction_;
-  SteeringLimiter limiter_steering_;
+  WheelLimiter limiter_;
 
   bool is_halted = false;
   bool use_stamped_vel_ = true;
@@ -176,6 +244,8 @@ protected:
     std::shared_ptr<std_srvs::srv::Empty::Response> res);
   bool reset();
   void halt();
+  // continue from the persisted odometry, if there is a recent one
+  void restore_odometry();
 };
 }  // namespace tricycle_controller
 #endif  // TRICYCLE_CONTROLLER__TRICYCLE_CONTROLLER_HPP_
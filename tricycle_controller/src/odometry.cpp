@@ -21,10 +21,7 @@
 namespace tricycle_controller
 {
 Odometry::Odometry(size_t velocity_rolling_window_size)
-: x_(0.0),
-  y_(0.0),
-  heading_(0.0),
-  linear_(0.0),
+: linear_(0.0),
   angular_(0.0),
   wheelbase_(0.0),
   wheel_radius_(0.0),
@@ -42,7 +39,7 @@ bool Odometry::update(double Ws, double alpha, const rclcpp::Duration & dt)
   double theta_dot = Vs * std::sin(alpha) / wheelbase_;
 
   // Integrate odometry:
-  integrateExact(Vx * dt.seconds(), theta_dot * dt.seconds());
+  pose_.integrate_exact(Vx * dt.seconds(), theta_dot * dt.seconds());
 
   // Estimate speeds using a rolling mean to filter them out:
   linear_accumulator_.accumulate(Vx);
@@ -61,17 +58,25 @@ void Odometry::updateOpenLoop(double linear, double angular, const rclcpp::Durat
   angular_ = angular;
 
   /// Integrate odometry:
-  integrateExact(linear * dt.seconds(), angular * dt.seconds());
+  pose_.integrate_exact(linear * dt.seconds(), angular * dt.seconds());
 }
 
 void Odometry::resetOdometry()
 {
-  x_ = 0.0;
-  y_ = 0.0;
-  heading_ = 0.0;
+  pose_.reset();
   resetAccumulators();
 }
 
+void Odometry::restore(double x, double y, double heading, double linear, double angular)
+{
+  pose_.reset(x, y, heading);
+  resetAccumulators();
+  linear_accumulator_.accumulate(linear);
+  angular_accumulator_.accumulate(angular);
+  linear_ = linear;
+  angular_ = angular;
+}
+
 void Odometry::setWheelParams(double wheelbase, double wheel_radius)
 {
   wheelbase_ = wheelbase;
@@ -85,33 +90,6 @@ void Odometry::setVelocityRollingWindowSize(size_t velocity_rolling_window_size)
   resetAccumulators();
 }
 
-void Odometry::integrateRungeKutta2(double linear, double angular)
-{
-  const double direction = heading_ + angular * 0.5;
-
-  /// Runge-Kutta 2nd order integration:
-  x_ += linear * cos(direction);
-  y_ += linear * sin(direction);
-  heading_ += angular;
-}
-
-void Odometry::integrateExact(double linear, double angular)
-{
-  if (fabs(angular) < 1e-6)
-  {
-    integrateRungeKutta2(linear, angular);
-  }
-  else
-  {
-    /// Exact integration (should solve problems when angular is zero):
-    const double heading_old = heading_;
-    const double r = linear / angular;
-    heading_ += angular;
-    x_ += r * (sin(heading_) - sin(heading_old));
-    y_ += -r * (cos(heading_) - cos(heading_old));
-  }
-}
-
 void Odometry::resetAccumulators()
 {
   linear_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
@@ -16,7 +16,6 @@
  * Author: Tony Najjar
  */
 
-#include <algorithm>
 #include <stdexcept>
 #include <string>
 
@@ -58,16 +57,17 @@ SteeringLimiter::SteeringLimiter(
   {
     throw std::invalid_argument("Acceleration cannot be negative." + error);
   }
+
+  limiter_.set_limits(0, axis_limits());
 }
 
 double SteeringLimiter::limit(double & p, double p0, double p1, double dt)
 {
   const double tmp = p;
 
-  if (!std::isnan(min_acceleration_) && !std::isnan(max_acceleration_))
-    limit_acceleration(p, p0, p1, dt);
-  if (!std::isnan(min_velocity_) && !std::isnan(max_velocity_)) limit_velocity(p, p0, dt);
-  if (!std::isnan(min_position_) && !std::isnan(max_position_)) limit_position(p);
+  motion_limits::AxisLimiter<1>::Vector x{p};
+  limiter_.limit(x, {p0}, {p1}, dt);
+  p = x[0];
 
   return tmp != 0.0 ? p / tmp : 1.0;
 }
@@ -75,7 +75,10 @@ double SteeringLimiter::limit(double & p, double p0, double p1, double dt)
 double SteeringLimiter::limit_position(double & p)
 {
   const double tmp = p;
-  p = std::clamp(p, min_position_, max_position_);
+
+  motion_limits::AxisLimiter<1>::Vector x{p};
+  limiter_.limit_value(x);
+  p = x[0];
 
   return tmp != 0.0 ? p / tmp : 1.0;
 }
@@ -84,12 +87,9 @@ double SteeringLimiter::limit_velocity(double & p, double p0, double dt)
 {
   const double tmp = p;
 
-  const double dv_min = min_velocity_ * dt;
-  const double dv_max = max_velocity_ * dt;
-
-  double dv = std::clamp(std::fabs(p - p0), dv_min, dv_max);
-  dv *= (p - p0 >= 0 ? 1 : -1);
-  p = p0 + dv;
+  motion_limits::AxisLimiter<1>::Vector x{p};
+  limiter_.limit_derivative(x, {p0}, dt);
+  p = x[0];
 
   return tmp != 0.0 ? p / tmp : 1.0;
 }
@@ -98,19 +98,33 @@ double SteeringLimiter::limit_acceleration(double & p, double p0, double p1, dou
 {
   const double tmp = p;
 
-  const double dv = p - p0;
-  const double dp0 = p0 - p1;
-
-  const double dt2 = 2. * dt * dt;
-
-  const double da_min = min_acceleration_ * dt2;
-  const double da_max = max_acceleration_ * dt2;
-
-  double da = std::clamp(std::fabs(dv - dp0), da_min, da_max);
-  da *= (dv - dp0 >= 0 ? 1 : -1);
-  p = p0 + dp0 + da;
+  motion_limits::AxisLimiter<1>::Vector x{p};
+  limiter_.limit_second_derivative(x, {p0}, {p1}, dt);
+  p = x[0];
 
   return tmp != 0.0 ? p / tmp : 1.0;
 }
 
+motion_limits::AxisLimits<double> SteeringLimiter::axis_limits() const
+{
+  // the velocity and acceleration limits apply to the magnitudes, in both directions
+  motion_limits::AxisLimits<double> limits;
+  if (!std::isnan(min_position_) && !std::isnan(max_position_))
+  {
+    limits.value.min = min_position_;
+    limits.value.max = max_position_;
+  }
+  if (!std::isnan(min_velocity_) && !std::isnan(max_velocity_))
+  {
+    limits.derivative.min_magnitude = min_velocity_;
+    limits.derivative.max_magnitude = max_velocity_;
+  }
+  if (!std::isnan(min_acceleration_) && !std::isnan(max_acceleration_))
+  {
+    limits.second_derivative.min_magnitude = min_acceleration_;
+    limits.second_derivative.max_magnitude = max_acceleration_;
+  }
+  return limits;
+}
+
 }  // namespace tricycle_controller
@@ -16,7 +16,6 @@
  * Author: Tony Najjar
  */
 
-#include <algorithm>
 #include <stdexcept>
 #include <string>
 
@@ -72,16 +71,17 @@ TractionLimiter::TractionLimiter(
   {
     throw std::invalid_argument("Jerk cannot be negative." + error);
   }
+
+  limiter_.set_limits(0, axis_limits());
 }
 
 double TractionLimiter::limit(double & v, double v0, double v1, double dt)
 {
   const double tmp = v;
 
-  if (!std::isnan(min_jerk_) && !std::isnan(max_jerk_)) limit_jerk(v, v0, v1, dt);
-  if (!std::isnan(min_acceleration_) && !std::isnan(max_acceleration_))
-    limit_acceleration(v, v0, dt);
-  if (!std::isnan(min_velocity_) && !std::isnan(max_velocity_)) limit_velocity(v);
+  motion_limits::AxisLimiter<1>::Vector x{v};
+  limiter_.limit(x, {v0}, {v1}, dt);
+  v = x[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
@@ -90,9 +90,10 @@ double TractionLimiter::limit_velocity(double & v)
 {
   const double tmp = v;
 
-  v = std::clamp(std::fabs(v), min_velocity_, max_velocity_);
+  motion_limits::AxisLimiter<1>::Vector x{v};
+  limiter_.limit_value(x);
+  v = x[0];
 
-  v *= tmp >= 0 ? 1 : -1;
   return tmp != 0.0 ? v / tmp : 1.0;
 }
 
@@ -100,21 +101,9 @@ double TractionLimiter::limit_acceleration(double & v, double v0, double dt)
 {
   const double tmp = v;
 
-  double dv_min;
-  double dv_max;
-  if (std::fabs(v) >= std::fabs(v0))
-  {
-    dv_min = min_acceleration_ * dt;
-    dv_max = max_acceleration_ * dt;
-  }
-  else
-  {
-    dv_min = min_deceleration_ * dt;
-    dv_max = max_deceleration_ * dt;
-  }
-  double dv = std::clamp(std::fabs(v - v0), dv_min, dv_max);
-  dv *= (v - v0 >= 0 ? 1 : -1);
-  v = v0 + dv;
+  motion_limits::AxisLimiter<1>::Vector x{v};
+  limiter_.limit_derivative(x, {v0}, dt);
+  v = x[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
@@ -123,19 +112,39 @@ double TractionLimiter::limit_jerk(double & v, double v0, double v1, double dt)
 {
   const double tmp = v;
 
-  const double dv = v - v0;
-  const double dv0 = v0 - v1;
-
-  const double dt2 = 2. * dt * dt;
-
-  const double da_min = min_jerk_ * dt2;
-  const double da_max = max_jerk_ * dt2;
-
-  double da = std::clamp(std::fabs(dv - dv0), da_min, da_max);
-  da *= (dv - dv0 >= 0 ? 1 : -1);
-  v = v0 + dv0 + da;
+  motion_limits::AxisLimiter<1>::Vector x{v};
+  limiter_.limit_second_derivative(x, {v0}, {v1}, dt);
+  v = x[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
 
+motion_limits::AxisLimits<double> TractionLimiter::axis_limits() const
+{
+  // the limits apply to the magnitudes, in both directions
+  motion_limits::AxisLimits<double> limits;
+  if (!std::isnan(min_velocity_) && !std::isnan(max_velocity_))
+  {
+    limits.value.min_magnitude = min_velocity_;
+    limits.value.max_magnitude = max_velocity_;
+  }
+  if (!std::isnan(min_acceleration_) && !std::isnan(max_acceleration_))
+  {
+    limits.derivative.min_magnitude = min_acceleration_;
+    limits.derivative.max_magnitude = max_acceleration_;
+  }
+  limits.derivative_towards_zero = motion_limits::Bounds<double>();
+  if (!std::isnan(min_deceleration_) && !std::isnan(max_deceleration_))
+  {
+    limits.derivative_towards_zero->min_magnitude = min_deceleration_;
+    limits.derivative_towards_zero->max_magnitude = max_deceleration_;
+  }
+  if (!std::isnan(min_jerk_) && !std::isnan(max_jerk_))
+  {
+    limits.second_derivative.min_magnitude = min_jerk_;
+    limits.second_derivative.max_magnitude = max_jerk_;
+  }
+  return limits;
+}
+
 }  // namespace tricycle_controller
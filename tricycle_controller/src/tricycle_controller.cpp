@@ -16,14 +16,19 @@
  * Author: Tony Najjar
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
 #include <memory>
-#include <queue>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
+#include "object_pool/message_memory_strategy.hpp"
 #include "rclcpp/logging.hpp"
 #include "tf2/LinearMath/Quaternion.h"
 #include "tricycle_controller/tricycle_controller.hpp"
@@ -35,6 +40,8 @@ constexpr auto DEFAULT_ACKERMANN_OUT_TOPIC = "~/cmd_ackermann";
 constexpr auto DEFAULT_ODOMETRY_TOPIC = "~/odom";
 constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
 constexpr auto DEFAULT_RESET_ODOM_SERVICE = "~/reset_odometry";
+// linear and angular velocity
+constexpr size_t NR_REF_ITFS = 2;
 }  // namespace
 
 namespace tricycle_controller
@@ -46,7 +53,7 @@ using hardware_interface::HW_IF_POSITION;
 using hardware_interface::HW_IF_VELOCITY;
 using lifecycle_msgs::msg::State;
 
-TricycleController::TricycleController() : controller_interface::ControllerInterface() {}
+TricycleController::TricycleController() : controller_interface::ChainableControllerInterface() {}
 
 CallbackReturn TricycleController::on_init()
 {
@@ -65,12 +72,23 @@ CallbackReturn TricycleController::on_init()
     auto_declare<std::vector<double>>("twist_covariance_diagonal", std::vector<double>());
     auto_declare<bool>("open_loop", odom_params_.open_loop);
     auto_declare<bool>("enable_odom_tf", odom_params_.enable_odom_tf);
+    auto_declare<bool>("aggregate_odom_tf", odom_params_.aggregate_odom_tf);
     auto_declare<bool>("odom_only_twist", odom_params_.odom_only_twist);
 
     auto_declare<int>("cmd_vel_timeout", static_cast<int>(cmd_vel_timeout_.count()));
     auto_declare<bool>("publish_ackermann_command", publish_ackermann_command_);
+    auto_declare<double>("odom_publish_rate", 0.0);
+    auto_declare<double>("tf_publish_rate", 0.0);
+    auto_declare<double>("ackermann_command_publish_rate", 0.0);
     auto_declare<int>("velocity_rolling_window_size", 10);
     auto_declare<bool>("use_stamped_vel", use_stamped_vel_);
+    auto_declare<bool>("publisher_pool.enable", publisher_pool_params_.enable);
+    auto_declare<int>("publisher_pool.threads", static_cast<int>(publisher_pool_params_.threads));
+    auto_declare<std::vector<int64_t>>("publisher_pool.cpu_affinity", std::vector<int64_t>());
+    auto_declare<bool>("odometry_persistence.enable", odometry_persistence_params_.enable);
+    auto_declare<std::string>("odometry_persistence.path", odometry_persistence_params_.path);
+    auto_declare<double>("odometry_persistence.period", odometry_persistence_params_.period);
+    auto_declare<double>("odometry_persistence.max_age", odometry_persistence_params_.max_age);
 
     auto_declare<double>("traction.max_velocity", NAN);
     auto_declare<double>("traction.min_velocity", NAN);
@@ -115,10 +133,57 @@ InterfaceConfiguration TricycleController::state_interface_configuration() const
   return state_interfaces_config;
 }
 
-controller_interface::return_type TricycleController::update(
+std::vector<hardware_interface::CommandInterface>
+TricycleController::on_export_reference_interfaces()
+{
+  reference_interfaces_.resize(NR_REF_ITFS, std::numeric_limits<double>::quiet_NaN());
+
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.reserve(reference_interfaces_.size());
+
+  reference_interfaces.push_back(hardware_interface::CommandInterface(
+    get_node()->get_name(), std::string("linear/") + HW_IF_VELOCITY, &reference_interfaces_[0]));
+
+  reference_interfaces.push_back(hardware_interface::CommandInterface(
+    get_node()->get_name(), std::string("angular/") + HW_IF_VELOCITY, &reference_interfaces_[1]));
+
+  return reference_interfaces;
+}
+
+bool TricycleController::on_set_chained_mode(bool chained_mode)
+{
+  // Always accept switch to/from chained mode
+  return true || chained_mode;
+}
+
+controller_interface::return_type TricycleController::update_reference_from_subscribers(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+{
+  received_velocity_command_.try_read(last_velocity_command_);
+
+  const auto age_of_last_command =
+    time - rclcpp::Time(last_velocity_command_.stamp_nanoseconds, RCL_ROS_TIME);
+  // Brake if cmd_vel has timeout
+  if (age_of_last_command > cmd_vel_timeout_)
+  {
+    reference_interfaces_[0] = 0.0;
+    reference_interfaces_[1] = 0.0;
+  }
+  else
+  {
+    reference_interfaces_[0] = last_velocity_command_.linear;
+    reference_interfaces_[1] = last_velocity_command_.angular;
+  }
+
+  return controller_interface::return_type::OK;
+}
+
+controller_interface::return_type TricycleController::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  if (get_state().id() == State::PRIMARY_STATE_INACTIVE)
+  update_time_.set(time);
+  // the flag follows on_activate() and on_deactivate(), reading the lifecycle state would lock it
+  if (!subscriber_is_active_)
   {
     if (!is_halted)
     {
@@ -127,27 +192,21 @@ controller_interface::return_type TricycleController::update(
     }
     return controller_interface::return_type::OK;
   }
-  std::shared_ptr<TwistStamped> last_command_msg;
-  received_velocity_msg_ptr_.get(last_command_msg);
-  if (last_command_msg == nullptr)
-  {
-    RCLCPP_WARN(get_node()->get_logger(), "Velocity message received was a nullptr.");
-    return controller_interface::return_type::ERROR;
-  }
 
-  const auto age_of_last_command = time - last_command_msg->header.stamp;
-  // Brake if cmd_vel has timeout, override the stored command
-  if (age_of_last_command > cmd_vel_timeout_)
+  // command may be limited further by Limiters,
+  // without affecting the stored command
+  double linear_command = reference_interfaces_[0];
+  double angular_command = reference_interfaces_[1];
+  // the references are consumed, a preceding controller has to write them again in the next cycle
+  reference_interfaces_[0] = std::numeric_limits<double>::quiet_NaN();
+  reference_interfaces_[1] = std::numeric_limits<double>::quiet_NaN();
+
+  // Brake if there is no reference
+  if (std::isnan(linear_command) || std::isnan(angular_command))
   {
-    last_command_msg->twist.linear.x = 0.0;
-    last_command_msg->twist.angular.z = 0.0;
+    linear_command = 0.0;
+    angular_command = 0.0;
   }
-
-  // command may be limited further by Limiters,
-  // without affecting the stored twist command
-  TwistStamped command = *last_command_msg;
-  double & linear_command = command.twist.linear.x;
-  double & angular_command = command.twist.angular.z;
   double Ws_read = traction_joint_[0].velocity_state.get().get_value();     // in radians/s
   double alpha_read = steering_joint_[0].position_state.get().get_value();  // in radians
 
@@ -164,11 +223,29 @@ controller_interface::return_type TricycleController::update(
     }
     odometry_.update(Ws_read, alpha_read, period);
   }
+  if (odometry_snapshot_writer_)
+  {
+    odometry_persistence::OdometrySnapshot snapshot;
+    snapshot.stamp_nanoseconds = time.nanoseconds();
+    snapshot.x = odometry_.getX();
+    snapshot.y = odometry_.getY();
+    snapshot.heading = odometry_.getHeading();
+    snapshot.linear = odometry_.getLinear();
+    snapshot.angular = odometry_.getAngular();
+    odometry_snapshot_writer_->update(snapshot);
+  }
+
+  const bool publish_odometry = odom_publish_rate_.should_publish(time);
+  const bool publish_transform = odom_params_.enable_odom_tf && !odometry_transform_slot_ &&
+                                 tf_publish_rate_.should_publish(time);
 
   tf2::Quaternion orientation;
-  orientation.setRPY(0.0, 0.0, odometry_.getHeading());
+  if (publish_odometry || publish_transform)
+  {
+    orientation.setRPY(0.0, 0.0, odometry_.getHeading());
+  }
 
-  if (realtime_odometry_publisher_->trylock())
+  if (publish_odometry && realtime_odometry_publisher_->trylock())
   {
     auto & odometry_message = realtime_odometry_publisher_->msg_;
     odometry_message.header.stamp = time;
@@ -186,7 +263,11 @@ controller_interface::return_type TricycleController::update(
     realtime_odometry_publisher_->unlockAndPublish();
   }
 
-  if (odom_params_.enable_odom_tf && realtime_odometry_transform_publisher_->trylock())
+  if (odometry_transform_slot_)
+  {
+    odometry_transform_slot_->set(time, odometry_.getX(), odometry_.getY(), odometry_.getHeading());
+  }
+  else if (publish_transform && realtime_odometry_transform_publisher_->trylock())
   {
     auto & transform = realtime_odometry_transform_publisher_->msg_.transforms.front();
     transform.header.stamp = time;
@@ -220,26 +301,23 @@ controller_interface::return_type TricycleController::update(
   }
   Ws_write *= scale;
 
-  auto & last_command = previous_commands_.back();
-  auto & second_to_last_command = previous_commands_.front();
+  WheelCommand limited_command;
+  limited_command[TRACTION_AXIS] = Ws_write;
+  limited_command[STEERING_AXIS] = alpha_write;
+  limiter_.limit(
+    limited_command, previous_commands_[last_command_index_],
+    previous_commands_[1 - last_command_index_], period.seconds());
+  Ws_write = limited_command[TRACTION_AXIS];
+  alpha_write = limited_command[STEERING_AXIS];
 
-  limiter_traction_.limit(
-    Ws_write, last_command.speed, second_to_last_command.speed, period.seconds());
-
-  limiter_steering_.limit(
-    alpha_write, last_command.steering_angle, second_to_last_command.steering_angle,
-    period.seconds());
-
-  previous_commands_.pop();
-  AckermannDrive ackermann_command;
-  // speed in AckermannDrive is defined as desired forward speed (m/s) but it is used here as wheel
-  // speed (rad/s)
-  ackermann_command.speed = static_cast<float>(Ws_write);
-  ackermann_command.steering_angle = static_cast<float>(alpha_write);
-  previous_commands_.emplace(ackermann_command);
+  // the new command replaces the second to last one
+  last_command_index_ = 1 - last_command_index_;
+  previous_commands_[last_command_index_] = limited_command;
 
   //  Publish ackermann command
-  if (publish_ackermann_command_ && realtime_ackermann_command_publisher_->trylock())
+  if (
+    publish_ackermann_command_ && ackermann_command_publish_rate_.should_publish(time) &&
+    realtime_ackermann_command_publisher_->trylock())
   {
     auto & realtime_ackermann_command = realtime_ackermann_command_publisher_->msg_;
     // speed in AckermannDrive is defined desired forward speed (m/s) but we use it here as wheel
@@ -292,16 +370,65 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
 
   odom_params_.open_loop = get_node()->get_parameter("open_loop").as_bool();
   odom_params_.enable_odom_tf = get_node()->get_parameter("enable_odom_tf").as_bool();
+  odom_params_.aggregate_odom_tf = get_node()->get_parameter("aggregate_odom_tf").as_bool();
   odom_params_.odom_only_twist = get_node()->get_parameter("odom_only_twist").as_bool();
 
   cmd_vel_timeout_ =
     std::chrono::milliseconds{get_node()->get_parameter("cmd_vel_timeout").as_int()};
   publish_ackermann_command_ = get_node()->get_parameter("publish_ackermann_command").as_bool();
   use_stamped_vel_ = get_node()->get_parameter("use_stamped_vel").as_bool();
+  publisher_pool_params_.enable = get_node()->get_parameter("publisher_pool.enable").as_bool();
+  publisher_pool_params_.threads = get_node()->get_parameter("publisher_pool.threads").as_int();
+  publisher_pool_params_.cpu_affinity =
+    get_node()->get_parameter("publisher_pool.cpu_affinity").as_integer_array();
+
+  odometry_persistence_params_.enable =
+    get_node()->get_parameter("odometry_persistence.enable").as_bool();
+  odometry_persistence_params_.path =
+    get_node()->get_parameter("odometry_persistence.path").as_string();
+  odometry_persistence_params_.period =
+    get_node()->get_parameter("odometry_persistence.period").as_double();
+  odometry_persistence_params_.max_age =
+    get_node()->get_parameter("odometry_persistence.max_age").as_double();
+  odometry_snapshot_writer_.reset();
+  if (odometry_persistence_params_.enable)
+  {
+    if (
+      odometry_persistence_params_.path.empty() || !(odometry_persistence_params_.period > 0.0) ||
+      !(odometry_persistence_params_.max_age >= 0.0))
+    {
+      RCLCPP_ERROR(
+        logger,
+        "odometry_persistence.path has to be set, with a positive period and a max_age of at "
+        "least 0.0");
+      return CallbackReturn::ERROR;
+    }
+    odometry_snapshot_writer_ = std::make_unique<odometry_persistence::SnapshotWriter>(
+      odometry_persistence_params_.path,
+      std::chrono::nanoseconds(static_cast<int64_t>(odometry_persistence_params_.period * 1e9)),
+      [logger](const std::string & error)
+      { RCLCPP_WARN(logger, "Failed to persist the odometry: %s", error.c_str()); });
+  }
+
+  const double odom_publish_rate = get_node()->get_parameter("odom_publish_rate").as_double();
+  const double tf_publish_rate = get_node()->get_parameter("tf_publish_rate").as_double();
+  const double ackermann_command_publish_rate =
+    get_node()->get_parameter("ackermann_command_publish_rate").as_double();
+  if (
+    !(odom_publish_rate >= 0.0) || !(tf_publish_rate >= 0.0) ||
+    !(ackermann_command_publish_rate >= 0.0))
+  {
+    RCLCPP_ERROR(logger, "Publish rates have to be positive, or 0.0 to publish every update");
+    return CallbackReturn::ERROR;
+  }
+  odom_publish_rate_.set_rate(odom_publish_rate);
+  tf_publish_rate_.set_rate(tf_publish_rate);
+  ackermann_command_publish_rate_.set_rate(ackermann_command_publish_rate);
 
+  limiter_ = WheelLimiter();
   try
   {
-    limiter_traction_ = TractionLimiter(
+    const TractionLimiter limiter_traction(
       get_node()->get_parameter("traction.min_velocity").as_double(),
       get_node()->get_parameter("traction.max_velocity").as_double(),
       get_node()->get_parameter("traction.min_acceleration").as_double(),
@@ -310,6 +437,7 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
       get_node()->get_parameter("traction.max_deceleration").as_double(),
       get_node()->get_parameter("traction.min_jerk").as_double(),
       get_node()->get_parameter("traction.max_jerk").as_double());
+    limiter_.set_limits(TRACTION_AXIS, limiter_traction.axis_limits());
   }
   catch (const std::invalid_argument & e)
   {
@@ -319,13 +447,14 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
 
   try
   {
-    limiter_steering_ = SteeringLimiter(
+    const SteeringLimiter limiter_steering(
       get_node()->get_parameter("steering.min_position").as_double(),
       get_node()->get_parameter("steering.max_position").as_double(),
       get_node()->get_parameter("steering.min_velocity").as_double(),
       get_node()->get_parameter("steering.max_velocity").as_double(),
       get_node()->get_parameter("steering.min_acceleration").as_double(),
       get_node()->get_parameter("steering.max_acceleration").as_double());
+    limiter_.set_limits(STEERING_AXIS, limiter_steering.axis_limits());
   }
   catch (const std::invalid_argument & e)
   {
@@ -338,13 +467,21 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
     return CallbackReturn::ERROR;
   }
 
-  const TwistStamped empty_twist;
-  received_velocity_msg_ptr_.set(std::make_shared<TwistStamped>(empty_twist));
+  // sized before the export, so the realtime loop can use them without a preceding controller
+  reference_interfaces_.resize(NR_REF_ITFS, std::numeric_limits<double>::quiet_NaN());
 
-  // Fill last two commands with default constructed commands
-  const AckermannDrive empty_ackermann_drive;
-  previous_commands_.emplace(empty_ackermann_drive);
-  previous_commands_.emplace(empty_ackermann_drive);
+  received_velocity_command_.write(StampedVelocityCommand());
+
+  std::shared_ptr<publisher_pool::PublisherPool> pool;
+  try
+  {
+    pool = publisher_pool::get_shared_pool(publisher_pool_params_);
+  }
+  catch (const std::invalid_argument & e)
+  {
+    RCLCPP_ERROR(logger, "Invalid publisher_pool parameters: %s", e.what());
+    return CallbackReturn::ERROR;
+  }
 
   // initialize ackermann command publisher
   if (publish_ackermann_command_)
@@ -352,8 +489,8 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
     ackermann_command_publisher_ = get_node()->create_publisher<AckermannDrive>(
       DEFAULT_ACKERMANN_OUT_TOPIC, rclcpp::SystemDefaultsQoS());
     realtime_ackermann_command_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<AckermannDrive>>(
-        ackermann_command_publisher_);
+      std::make_shared<publisher_pool::RealtimePublisher<AckermannDrive>>(
+        ackermann_command_publisher_, pool);
   }
 
   // initialize command subscriber
@@ -375,10 +512,14 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
             get_node()->get_logger(),
             "Received TwistStamped with zero timestamp, setting it to current "
             "time, this message will only be shown once");
-          msg->header.stamp = get_node()->get_clock()->now();
+          msg->header.stamp = update_time_.now(*get_node()->get_clock());
         }
-        received_velocity_msg_ptr_.set(std::move(msg));
-      });
+        received_velocity_command_.write(
+          {rclcpp::Time(msg->header.stamp).nanoseconds(), msg->twist.linear.x,
+           msg->twist.angular.z});
+      },
+      rclcpp::SubscriptionOptions(),
+      std::make_shared<object_pool::PoolMessageMemoryStrategy<TwistStamped>>());
   }
   else
   {
@@ -393,20 +534,21 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
           return;
         }
 
-        // Write fake header in the stored stamped command
-        std::shared_ptr<TwistStamped> twist_stamped;
-        received_velocity_msg_ptr_.get(twist_stamped);
-        twist_stamped->twist = *msg;
-        twist_stamped->header.stamp = get_node()->get_clock()->now();
-      });
+        // Stamp the stored command with the time of reception, in the time of the updates
+        received_velocity_command_.write(
+          {update_time_.now(*get_node()->get_clock()).nanoseconds(), msg->linear.x,
+           msg->angular.z});
+      },
+      rclcpp::SubscriptionOptions(),
+      std::make_shared<object_pool::PoolMessageMemoryStrategy<Twist>>());
   }
 
   // initialize odometry publisher and messasge
   odometry_publisher_ = get_node()->create_publisher<nav_msgs::msg::Odometry>(
     DEFAULT_ODOMETRY_TOPIC, rclcpp::SystemDefaultsQoS());
   realtime_odometry_publisher_ =
-    std::make_shared<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(
-      odometry_publisher_);
+    std::make_shared<publisher_pool::RealtimePublisher<nav_msgs::msg::Odometry>>(
+      odometry_publisher_, pool);
 
   auto & odometry_message = realtime_odometry_publisher_->msg_;
   odometry_message.header.frame_id = odom_params_.odom_frame_id;
@@ -427,13 +569,20 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
   }
 
   // initialize transform publisher and message
-  if (odom_params_.enable_odom_tf)
+  odometry_transform_slot_.reset();
+  if (odom_params_.enable_odom_tf && odom_params_.aggregate_odom_tf)
+  {
+    odometry_transform_slot_ =
+      tf_aggregator::TransformAggregator::get_instance()->register_transform(
+        get_node()->get_namespace(), odom_params_.odom_frame_id, odom_params_.base_frame_id);
+  }
+  else if (odom_params_.enable_odom_tf)
   {
     odometry_transform_publisher_ = get_node()->create_publisher<tf2_msgs::msg::TFMessage>(
       DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
     realtime_odometry_transform_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
-        odometry_transform_publisher_);
+      std::make_shared<publisher_pool::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
+        odometry_transform_publisher_, pool);
 
     // keeping track of odom and base_link transforms only
     auto & odometry_transform_message = realtime_odometry_transform_publisher_->msg_;
@@ -469,7 +618,16 @@ CallbackReturn TricycleController::on_activate(const rclcpp_lifecycle::State &)
     return CallbackReturn::ERROR;
   }
 
+  if (odometry_snapshot_writer_)
+  {
+    restore_odometry();
+  }
+
+  std::fill(
+    reference_interfaces_.begin(), reference_interfaces_.end(),
+    std::numeric_limits<double>::quiet_NaN());
   is_halted = false;
+  update_time_.reset();
   subscriber_is_active_ = true;
 
   RCLCPP_DEBUG(get_node()->get_logger(), "Subscriber and publisher are now active.");
@@ -479,6 +637,11 @@ CallbackReturn TricycleController::on_activate(const rclcpp_lifecycle::State &)
 CallbackReturn TricycleController::on_deactivate(const rclcpp_lifecycle::State &)
 {
   subscriber_is_active_ = false;
+  if (odometry_snapshot_writer_)
+  {
+    // the next activation continues from the last update
+    odometry_snapshot_writer_->flush();
+  }
   return CallbackReturn::SUCCESS;
 }
 
@@ -488,8 +651,9 @@ CallbackReturn TricycleController::on_cleanup(const rclcpp_lifecycle::State &)
   {
     return CallbackReturn::ERROR;
   }
+  odometry_transform_slot_.reset();
+  odometry_snapshot_writer_.reset();
 
-  received_velocity_msg_ptr_.set(std::make_shared<TwistStamped>());
   return CallbackReturn::SUCCESS;
 }
 
@@ -515,9 +679,8 @@ bool TricycleController::reset()
 {
   odometry_.resetOdometry();
 
-  // release the old queue
-  std::queue<AckermannDrive> empty_ackermann_drive;
-  std::swap(previous_commands_, empty_ackermann_drive);
+  previous_commands_.fill(WheelCommand());
+  last_command_index_ = 0;
 
   traction_joint_.clear();
   steering_joint_.clear();
@@ -526,11 +689,35 @@ bool TricycleController::reset()
   velocity_command_subscriber_.reset();
   velocity_command_unstamped_subscriber_.reset();
 
-  received_velocity_msg_ptr_.set(nullptr);
+  received_velocity_command_.write(StampedVelocityCommand());
+  last_velocity_command_ = StampedVelocityCommand();
   is_halted = false;
   return true;
 }
 
+void TricycleController::restore_odometry()
+{
+  odometry_persistence::OdometrySnapshot snapshot;
+  std::string error;
+  if (!odometry_persistence::load_snapshot(odometry_persistence_params_.path, snapshot, error))
+  {
+    RCLCPP_INFO(get_node()->get_logger(), "Not restoring the odometry: %s", error.c_str());
+    return;
+  }
+  const double age =
+    (get_node()->now() - rclcpp::Time(snapshot.stamp_nanoseconds, RCL_ROS_TIME)).seconds();
+  if (odometry_persistence_params_.max_age > 0.0 && age > odometry_persistence_params_.max_age)
+  {
+    RCLCPP_INFO(get_node()->get_logger(), "Not restoring the odometry, it is %.1f s old", age);
+    return;
+  }
+
+  odometry_.restore(snapshot.x, snapshot.y, snapshot.heading, snapshot.linear, snapshot.angular);
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Restored the odometry at x %f, y %f, heading %f", snapshot.x,
+    snapshot.y, snapshot.heading);
+}
+
 CallbackReturn TricycleController::on_shutdown(const rclcpp_lifecycle::State &)
 {
   return CallbackReturn::SUCCESS;
@@ -626,6 +813,39 @@ CallbackReturn TricycleController::get_steering(
   return CallbackReturn::SUCCESS;
 }
 
+void TricycleController::PublishRate::set_rate(double rate)
+{
+  period = rclcpp::Duration::from_nanoseconds(0);
+  if (rate > 0.0)
+  {
+    period = rclcpp::Duration::from_seconds(1.0 / rate);
+  }
+  previous_timestamp = rclcpp::Time(0, 0, RCL_CLOCK_UNINITIALIZED);
+}
+
+bool TricycleController::PublishRate::should_publish(const rclcpp::Time & time)
+{
+  if (period.nanoseconds() == 0)
+  {
+    return true;
+  }
+  try
+  {
+    if (previous_timestamp + period < time)
+    {
+      previous_timestamp += period;
+      return true;
+    }
+  }
+  catch (const std::runtime_error &)
+  {
+    // Handle exceptions when the time source changes and initialize publish timestamp
+    previous_timestamp = time;
+    return true;
+  }
+  return false;
+}
+
 double TricycleController::convert_trans_rot_vel_to_steering_angle(
   double Vx, double theta_dot, double wheelbase)
 {
@@ -657,4 +877,4 @@ std::tuple<double, double> TricycleController::twist_to_ackermann(double Vx, dou
 
 #include <pluginlib/class_list_macros.hpp>
 PLUGINLIB_EXPORT_CLASS(
-  tricycle_controller::TricycleController, controller_interface::ControllerInterface)
+  tricycle_controller::TricycleController, controller_interface::ChainableControllerInterface)
@@ -19,6 +19,7 @@
 #include <gmock/gmock.h>
 
 #include <array>
+#include <cstdio>
 #include <memory>
 #include <string>
 #include <thread>
@@ -30,6 +31,7 @@
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/rclcpp.hpp"
+#include "rt_safety_checks/rt_safety_checker.hpp"
 #include "tricycle_controller/tricycle_controller.hpp"
 
 using CallbackReturn = controller_interface::CallbackReturn;
@@ -45,10 +47,10 @@ class TestableTricycleController : public tricycle_controller::TricycleControlle
 {
 public:
   using TricycleController::TricycleController;
-  std::shared_ptr<geometry_msgs::msg::TwistStamped> getLastReceivedTwist()
+  StampedVelocityCommand getLastReceivedCommand()
   {
-    std::shared_ptr<geometry_msgs::msg::TwistStamped> ret;
-    received_velocity_msg_ptr_.get(ret);
+    StampedVelocityCommand ret;
+    received_velocity_command_.try_read(ret);
     return ret;
   }
 
@@ -73,6 +75,8 @@ public:
     }
     return false;
   }
+
+  const tricycle_controller::Odometry & get_odometry() const { return odometry_; }
 };
 
 class TestTricycleController : public ::testing::Test
@@ -365,3 +369,155 @@ TEST_F(TestTricycleController, correct_initialization_using_parameters)
   ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
   executor.cancel();
 }
+
+TEST_F(TestTricycleController, chained_mode_uses_reference_interfaces)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheelbase", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+  assignResources();
+
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_THAT(reference_interfaces, SizeIs(2lu));
+  EXPECT_EQ(reference_interfaces[0].get_name(), controller_name + "/linear/velocity");
+  EXPECT_EQ(reference_interfaces[1].get_name(), controller_name + "/angular/velocity");
+
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+  ASSERT_TRUE(controller_->is_in_chained_mode());
+
+  // written by a preceding controller in the same cycle
+  reference_interfaces[0].set_value(1.0);
+  reference_interfaces[1].set_value(0.0);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, steering_joint_pos_cmd_.get_value());
+  EXPECT_EQ(1.0, traction_joint_vel_cmd_.get_value());
+
+  // brakes if the references are not written again
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, steering_joint_pos_cmd_.get_value());
+  EXPECT_EQ(0.0, traction_joint_vel_cmd_.get_value());
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+}
+
+TEST_F(TestTricycleController, configure_fails_with_negative_publish_rate)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("odom_publish_rate", -1.0));
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::ERROR);
+}
+
+TEST_F(TestTricycleController, persisted_odometry_is_restored_on_activation)
+{
+  const std::string path = ::testing::TempDir() + "test_tricycle_controller.odom";
+  odometry_persistence::OdometrySnapshot snapshot;
+  snapshot.stamp_nanoseconds = rclcpp::Clock(RCL_ROS_TIME).now().nanoseconds();
+  snapshot.x = 1.0;
+  snapshot.y = -2.0;
+  snapshot.heading = 0.5;
+  std::string error;
+  ASSERT_TRUE(odometry_persistence::save_snapshot(path, snapshot, error)) << error;
+
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheelbase", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("odometry_persistence.enable", true));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("odometry_persistence.path", path));
+
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->configure().id());
+  assignResources();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, controller_->get_node()->activate().id());
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getX(), 1.0);
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getY(), -2.0);
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getHeading(), 0.5);
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->deactivate().id());
+
+  // too old to be restored
+  controller_->get_node()->set_parameter(rclcpp::Parameter("odometry_persistence.max_age", 1.0));
+  ASSERT_EQ(State::PRIMARY_STATE_UNCONFIGURED, controller_->get_node()->cleanup().id());
+  snapshot.stamp_nanoseconds -= rclcpp::Duration::from_seconds(10.0).nanoseconds();
+  ASSERT_TRUE(odometry_persistence::save_snapshot(path, snapshot, error)) << error;
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, controller_->get_node()->configure().id());
+  assignResources();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, controller_->get_node()->activate().id());
+  EXPECT_DOUBLE_EQ(controller_->get_odometry().getX(), 0.0);
+  std::remove(path.c_str());
+}
+
+TEST_F(TestTricycleController, configure_fails_without_odometry_persistence_path)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("odometry_persistence.enable", true));
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::ERROR);
+}
+
+TEST_F(TestTricycleController, update_is_realtime_safe)
+{
+  const auto ret = controller_->init(controller_name, urdf_, 0);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+  assignResources();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  rclcpp::Time time(0, 0, RCL_ROS_TIME);
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  // the first cycle may still initialize
+  ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+
+  rt_safety_checks::RtSafetyChecker checker;
+  for (int i = 0; i < 100; ++i)
+  {
+    time += period;
+    ASSERT_EQ(controller_->update(time, period), controller_interface::return_type::OK);
+  }
+  checker.stop();
+  EXPECT_EQ(checker.allocations(), 0u);
+  EXPECT_EQ(checker.deallocations(), 0u);
+  EXPECT_EQ(checker.mutex_locks(), 0u);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+}
@@ -0,0 +1,74 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UPDATE_TIME_SOURCE__UPDATE_TIME_SOURCE_HPP_
+#define UPDATE_TIME_SOURCE__UPDATE_TIME_SOURCE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include "rclcpp/clock.hpp"
+#include "rclcpp/time.hpp"
+
+namespace update_time_source
+{
+/**
+ * \brief Time of the last update of a controller, the clock of its non-realtime callbacks.
+ *
+ * update() stores its time argument with set(), and the callbacks of the subscribers take now()
+ * instead of the time of the node clock, e.g., to stamp commands without a time stamp. So a
+ * controller follows only the time of the controller manager, also of a simulation stepping it
+ * faster than real time. Until the first update after reset(), now() falls back to a clock.
+ */
+class UpdateTimeSource
+{
+public:
+  /// Store the time of an update, realtime-safe
+  void set(const rclcpp::Time & time)
+  {
+    nanoseconds_.store(time.nanoseconds(), std::memory_order_release);
+  }
+
+  /// Forget the time of the last update, e.g., on activation
+  void reset() { nanoseconds_.store(UNSET, std::memory_order_release); }
+
+  /// True if there was an update since reset()
+  bool is_set() const { return nanoseconds_.load(std::memory_order_acquire) != UNSET; }
+
+  /**
+   * Time of the last update, or of \p fallback if there was none since reset().
+   *
+   * Always of the clock type of \p fallback, usually the node clock, so it can be compared with
+   * the stamps of messages also if the update time was given in another clock type, e.g., in tests.
+   */
+  rclcpp::Time now(rclcpp::Clock & fallback) const
+  {
+    const int64_t nanoseconds = nanoseconds_.load(std::memory_order_acquire);
+    if (nanoseconds == UNSET)
+    {
+      return fallback.now();
+    }
+    return rclcpp::Time(nanoseconds, fallback.get_clock_type());
+  }
+
+private:
+  static constexpr int64_t UNSET = std::numeric_limits<int64_t>::min();
+
+  std::atomic<int64_t> nanoseconds_{UNSET};
+};
+
+}  // namespace update_time_source
+
+#endif  // UPDATE_TIME_SOURCE__UPDATE_TIME_SOURCE_HPP_
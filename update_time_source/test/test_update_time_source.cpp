@@ -0,0 +1,56 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "rclcpp/clock.hpp"
+#include "rclcpp/time.hpp"
+#include "update_time_source/update_time_source.hpp"
+
+using update_time_source::UpdateTimeSource;
+
+TEST(TestUpdateTimeSource, falls_back_to_the_clock_before_the_first_update)
+{
+  UpdateTimeSource time_source;
+  rclcpp::Clock clock(RCL_STEADY_TIME);
+  EXPECT_FALSE(time_source.is_set());
+
+  const auto before = clock.now();
+  const auto now = time_source.now(clock);
+  EXPECT_EQ(now.get_clock_type(), RCL_STEADY_TIME);
+  EXPECT_GE(now.nanoseconds(), before.nanoseconds());
+}
+
+TEST(TestUpdateTimeSource, returns_the_time_of_the_last_update)
+{
+  UpdateTimeSource time_source;
+  rclcpp::Clock clock(RCL_STEADY_TIME);
+
+  time_source.set(rclcpp::Time(10, 0, RCL_ROS_TIME));
+  time_source.set(rclcpp::Time(20, 500, RCL_ROS_TIME));
+  ASSERT_TRUE(time_source.is_set());
+  const auto now = time_source.now(clock);
+  // of the clock type of the fallback, to be comparable with its times
+  EXPECT_EQ(now.get_clock_type(), RCL_STEADY_TIME);
+  EXPECT_EQ(now.nanoseconds(), rclcpp::Time(20, 500, RCL_ROS_TIME).nanoseconds());
+
+  // e.g., zero in a simulation, which is a valid time of an update
+  time_source.set(rclcpp::Time(0, 0, RCL_ROS_TIME));
+  EXPECT_EQ(time_source.now(clock).nanoseconds(), 0);
+
+  time_source.reset();
+  EXPECT_FALSE(time_source.is_set());
+  const auto before = clock.now();
+  EXPECT_GE(time_source.now(clock).nanoseconds(), before.nanoseconds());
+}
@@ -0,0 +1,213 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UPDATE_TIME_STATISTICS__CYCLE_BUDGET_HPP_
+#define UPDATE_TIME_STATISTICS__CYCLE_BUDGET_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace update_time_statistics
+{
+/// Nominal period in nanoseconds of updates at \p update_rate in Hz, zero if it is not positive
+inline int64_t nominal_period_ns(double update_rate)
+{
+  return update_rate > 0.0 ? static_cast<int64_t>(1e9 / update_rate) : 0;
+}
+
+/**
+ * \brief Per-cycle time budget of a controller, decimating its non-essential work under pressure.
+ *
+ * An update is under pressure if its period is longer than \p overrun_ratio times the nominal
+ * period, i.e., the update loop of the controller manager overruns, or if the previous update of
+ * the controller itself took longer than \p budget_ratio times the nominal period. Every update
+ * under pressure doubles the decimation of the non-essential work, up to \p max_decimation, and
+ * every \p recovery_cycles updates without pressure halve it again.
+ *
+ * Only the work the controller asks for with allows_optional_work() is decimated, e.g.,
+ * publishing its state or action feedback, never its commands. Within an update, the work is also
+ * skipped once the update has used its budget. All methods are realtime-safe.
+ */
+class CycleBudget
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Budget updates with a period of \p nominal_period_ns, nothing is decimated if not positive
+  void configure(
+    int64_t nominal_period_ns, double budget_ratio, double overrun_ratio, size_t max_decimation,
+    size_t recovery_cycles)
+  {
+    nominal_period_ns_ = nominal_period_ns;
+    budget_ns_ = static_cast<int64_t>(budget_ratio * static_cast<double>(nominal_period_ns));
+    overrun_ratio_ = overrun_ratio;
+    max_decimation_ = std::max<size_t>(max_decimation, 1);
+    recovery_cycles_ = std::max<size_t>(recovery_cycles, 1);
+    reset();
+  }
+
+  /// Stop decimating, e.g., on activation
+  void reset()
+  {
+    decimation_ = 1;
+    cycle_ = 0;
+    cycles_without_pressure_ = 0;
+    last_duration_ns_ = 0;
+    skipped_ = 0;
+    in_cycle_ = false;
+  }
+
+  /// Start the update with the period \p period_ns at \p start
+  void start_cycle(int64_t period_ns, Clock::time_point start = Clock::now())
+  {
+    start_ = start;
+    in_cycle_ = true;
+    ++cycle_;
+    if (nominal_period_ns_ <= 0)
+    {
+      return;
+    }
+    const bool overrun = static_cast<double>(period_ns) >
+                         overrun_ratio_ * static_cast<double>(nominal_period_ns_);
+    if (overrun || last_duration_ns_ > budget_ns_)
+    {
+      decimation_ = std::min(decimation_ * 2, max_decimation_);
+      cycles_without_pressure_ = 0;
+    }
+    else if (decimation_ > 1 && ++cycles_without_pressure_ >= recovery_cycles_)
+    {
+      decimation_ /= 2;
+      cycles_without_pressure_ = 0;
+    }
+  }
+
+  /// Finish the update started by start_cycle() at \p end
+  void finish_cycle(Clock::time_point end = Clock::now())
+  {
+    if (in_cycle_)
+    {
+      last_duration_ns_ =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_).count();
+      in_cycle_ = false;
+    }
+  }
+
+  /// True if the non-essential work of the current update should be done at \p now
+  /**
+   * A false answer is counted by skipped(); a controller decimating its work by time, e.g., with a
+   * publish rate, does it in the next update which is allowed to.
+   */
+  bool allows_optional_work(Clock::time_point now = Clock::now())
+  {
+    if (nominal_period_ns_ <= 0)
+    {
+      return true;
+    }
+    const bool decimated = decimation_ > 1 && cycle_ % decimation_ != 0;
+    const bool over_budget =
+      in_cycle_ &&
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count() > budget_ns_;
+    if (decimated || over_budget)
+    {
+      ++skipped_;
+      return false;
+    }
+    return true;
+  }
+
+  /// Only every decimation()-th update does its non-essential work, 1 without pressure
+  size_t decimation() const { return decimation_; }
+
+  /// Number of times allows_optional_work() returned false since reset()
+  uint64_t skipped() const { return skipped_; }
+
+private:
+  int64_t nominal_period_ns_ = 0;
+  int64_t budget_ns_ = 0;
+  double overrun_ratio_ = 1.5;
+  size_t max_decimation_ = 1;
+  size_t recovery_cycles_ = 1;
+  size_t decimation_ = 1;
+  uint64_t cycle_ = 0;
+  size_t cycles_without_pressure_ = 0;
+  int64_t last_duration_ns_ = 0;
+  uint64_t skipped_ = 0;
+  bool in_cycle_ = false;
+  Clock::time_point start_;
+};
+
+/**
+ * \brief Starts a cycle of a CycleBudget and finishes it at the end of the scope, e.g., of an
+ * update.
+ *
+ * Only checks the pointer if the budget is disabled, i.e., \p budget is nullptr.
+ */
+class ScopedCycleBudget
+{
+public:
+  ScopedCycleBudget(CycleBudget * budget, int64_t period_ns) : budget_(budget)
+  {
+    if (budget_)
+    {
+      budget_->start_cycle(period_ns);
+    }
+  }
+
+  ~ScopedCycleBudget()
+  {
+    if (budget_)
+    {
+      budget_->finish_cycle();
+    }
+  }
+
+  ScopedCycleBudget(const ScopedCycleBudget &) = delete;
+  ScopedCycleBudget & operator=(const ScopedCycleBudget &) = delete;
+
+private:
+  CycleBudget * budget_;
+};
+
+/// allows_optional_work() of \p budget, true if it is nullptr, i.e., disabled
+inline bool allows_optional_work(CycleBudget * budget)
+{
+  return budget == nullptr || budget->allows_optional_work();
+}
+
+/// CycleBudget of the generated cycle_budget parameters \p params, nullptr if not enabled
+/**
+ * \param update_rate of the controller, used if 'cycle_budget.update_rate' is zero
+ */
+template <typename CycleBudgetParamsT>
+std::unique_ptr<CycleBudget> make_cycle_budget(
+  const CycleBudgetParamsT & params, double update_rate)
+{
+  if (!params.enable)
+  {
+    return nullptr;
+  }
+  auto budget = std::make_unique<CycleBudget>();
+  budget->configure(
+    nominal_period_ns(params.update_rate > 0.0 ? params.update_rate : update_rate),
+    params.budget_ratio, params.overrun_ratio, static_cast<size_t>(params.max_decimation),
+    static_cast<size_t>(params.recovery_cycles));
+  return budget;
+}
+
+}  // namespace update_time_statistics
+
+#endif  // UPDATE_TIME_STATISTICS__CYCLE_BUDGET_HPP_
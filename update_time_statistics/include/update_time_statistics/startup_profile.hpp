@@ -0,0 +1,113 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UPDATE_TIME_STATISTICS__STARTUP_PROFILE_HPP_
+#define UPDATE_TIME_STATISTICS__STARTUP_PROFILE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rclcpp/node_interfaces/node_parameters_interface.hpp"
+
+namespace update_time_statistics
+{
+/**
+ * \brief Durations of the phases of the initialization and configuration of a controller, e.g.,
+ * declaring its parameters, reported as one line.
+ *
+ * The phases are measured by ScopedStartupPhase, and summary() lists them in the order they ended
+ * with their total. Not realtime-safe.
+ */
+class StartupProfile
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Add the phase \p name, which took \p duration
+  void add(std::string name, Clock::duration duration)
+  {
+    phases_.emplace_back(std::move(name), duration);
+  }
+
+  void clear() { phases_.clear(); }
+
+  /// Total duration of the phases
+  Clock::duration total() const
+  {
+    Clock::duration total{0};
+    for (const auto & phase : phases_)
+    {
+      total += phase.second;
+    }
+    return total;
+  }
+
+  /// "<phase> <duration> ms, ..., total <duration> ms"
+  std::string summary() const
+  {
+    std::string summary;
+    for (const auto & phase : phases_)
+    {
+      summary += phase.first + " " + format_ms(phase.second) + " ms, ";
+    }
+    return summary + "total " + format_ms(total()) + " ms";
+  }
+
+private:
+  static std::string format_ms(Clock::duration duration)
+  {
+    char text[32];
+    std::snprintf(
+      text, sizeof(text), "%.3f", std::chrono::duration<double, std::milli>(duration).count());
+    return text;
+  }
+
+  std::vector<std::pair<std::string, Clock::duration>> phases_;
+};
+
+/// Adds the time until the end of the scope as a phase to a StartupProfile
+class ScopedStartupPhase
+{
+public:
+  ScopedStartupPhase(StartupProfile & profile, std::string name)
+  : profile_(profile), name_(std::move(name)), start_(StartupProfile::Clock::now())
+  {
+  }
+
+  ~ScopedStartupPhase() { profile_.add(std::move(name_), StartupProfile::Clock::now() - start_); }
+
+  ScopedStartupPhase(const ScopedStartupPhase &) = delete;
+  ScopedStartupPhase & operator=(const ScopedStartupPhase &) = delete;
+
+private:
+  StartupProfile & profile_;
+  std::string name_;
+  StartupProfile::Clock::time_point start_;
+};
+
+/// Number of parameters declared by the node of \p parameters, e.g., for a StartupProfile
+inline size_t count_parameters(
+  const rclcpp::node_interfaces::NodeParametersInterface::SharedPtr & parameters)
+{
+  // depth 0 lists the parameters of all namespaces
+  return parameters->list_parameters({}, 0).names.size();
+}
+
+}  // namespace update_time_statistics
+
+#endif  // UPDATE_TIME_STATISTICS__STARTUP_PROFILE_HPP_
@@ -0,0 +1,224 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UPDATE_TIME_STATISTICS__UPDATE_PERIOD_STATISTICS_HPP_
+#define UPDATE_TIME_STATISTICS__UPDATE_PERIOD_STATISTICS_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "rclcpp/duration.hpp"
+#include "rclcpp/publisher.hpp"
+#include "rclcpp/qos.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+#include "realtime_tools/realtime_publisher.h"
+#include "statistics_msgs/msg/metrics_message.hpp"
+#include "statistics_msgs/msg/statistic_data_type.hpp"
+#include "update_time_statistics/update_time_histogram.hpp"
+#include "update_time_statistics/update_time_statistics.hpp"
+
+namespace update_time_statistics
+{
+/// Data type of the number of overruns in the period statistics, not defined by StatisticDataType
+constexpr uint8_t STATISTICS_DATA_TYPE_OVERRUNS = 100;
+/// Data type of the number of missed cycles in the period statistics
+constexpr uint8_t STATISTICS_DATA_TYPE_MISSED_CYCLES = 101;
+
+/**
+ * \brief Overruns and missed cycles of update periods compared with the nominal period.
+ *
+ * A period is an overrun if it is longer than \p overrun_ratio times the nominal period. Every
+ * whole nominal period in addition to the first one, rounded to the nearest, is a missed cycle.
+ */
+class UpdatePeriodCounters
+{
+public:
+  /// Count periods against \p nominal_period_ns, nothing is counted if it is not positive
+  void configure(int64_t nominal_period_ns, double overrun_ratio)
+  {
+    nominal_period_ns_ = nominal_period_ns;
+    overrun_ratio_ = overrun_ratio;
+    reset();
+  }
+
+  void reset()
+  {
+    overruns_ = 0;
+    missed_cycles_ = 0;
+  }
+
+  /// Count the period \p period_ns, realtime-safe
+  void add(int64_t period_ns)
+  {
+    if (nominal_period_ns_ <= 0)
+    {
+      return;
+    }
+    const double cycles = static_cast<double>(period_ns) / static_cast<double>(nominal_period_ns_);
+    if (cycles > overrun_ratio_)
+    {
+      ++overruns_;
+    }
+    if (cycles >= 1.5)
+    {
+      missed_cycles_ += static_cast<uint64_t>(std::lround(cycles)) - 1u;
+    }
+  }
+
+  uint64_t overruns() const { return overruns_; }
+
+  uint64_t missed_cycles() const { return missed_cycles_; }
+
+private:
+  int64_t nominal_period_ns_ = 0;
+  double overrun_ratio_ = 1.5;
+  uint64_t overruns_ = 0;
+  uint64_t missed_cycles_ = 0;
+};
+
+/**
+ * \brief Periods between the updates of a controller, published as statistics of windows.
+ *
+ * The realtime loop adds the period argument of every update with add_period(). After every
+ * window of updates, the minimum, mean, maximum, standard deviation and 99th percentile of the
+ * periods are published in milliseconds, together with the overruns and missed cycles of the
+ * window, see UpdatePeriodCounters. If the publisher is busy, the window continues until the next
+ * update. The first period after reset() is skipped, it isn't the period of a cycle of the
+ * controller.
+ */
+class UpdatePeriodStatistics
+{
+public:
+  /// Create the publisher on \p topic_name; not realtime-safe
+  /**
+   * \param nominal_period_ns period of the updates, overruns and missed cycles are only counted if
+   * it is positive
+   * \return false if the publisher can't be created
+   */
+  bool configure(
+    const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node, const std::string & topic_name,
+    size_t window_size, int64_t nominal_period_ns, double overrun_ratio)
+  {
+    window_size_ = window_size > 0 ? window_size : 1;
+    counters_.configure(nominal_period_ns, overrun_ratio);
+    try
+    {
+      publisher_ = node->create_publisher<statistics_msgs::msg::MetricsMessage>(
+        topic_name, rclcpp::SystemDefaultsQoS());
+      realtime_publisher_ = std::make_unique<StatisticsPublisher>(publisher_);
+    }
+    catch (const std::exception & e)
+    {
+      fprintf(
+        stderr,
+        "Exception thrown during publisher creation at configure stage with message : %s \n",
+        e.what());
+      return false;
+    }
+
+    using statistics_msgs::msg::StatisticDataType;
+    realtime_publisher_->lock();
+    auto & msg = realtime_publisher_->msg_;
+    msg.measurement_source_name = node->get_name();
+    msg.metrics_source = "update_period";
+    msg.unit = "ms";
+    msg.statistics.resize(8);
+    msg.statistics[0].data_type = StatisticDataType::STATISTICS_DATA_TYPE_AVERAGE;
+    msg.statistics[1].data_type = StatisticDataType::STATISTICS_DATA_TYPE_MINIMUM;
+    msg.statistics[2].data_type = StatisticDataType::STATISTICS_DATA_TYPE_MAXIMUM;
+    msg.statistics[3].data_type = StatisticDataType::STATISTICS_DATA_TYPE_STDDEV;
+    msg.statistics[4].data_type = StatisticDataType::STATISTICS_DATA_TYPE_SAMPLE_COUNT;
+    msg.statistics[5].data_type = STATISTICS_DATA_TYPE_PERCENTILE_99;
+    msg.statistics[6].data_type = STATISTICS_DATA_TYPE_OVERRUNS;
+    msg.statistics[7].data_type = STATISTICS_DATA_TYPE_MISSED_CYCLES;
+    realtime_publisher_->unlock();
+    reset();
+    return true;
+  }
+
+  /// Start a new window and skip the next period, e.g., on activation
+  void reset()
+  {
+    start_window();
+    skip_next_period_ = true;
+  }
+
+  /// Add the \p period of the update at \p time, realtime-safe
+  void add_period(const rclcpp::Time & time, const rclcpp::Duration & period)
+  {
+    if (skip_next_period_)
+    {
+      skip_next_period_ = false;
+      return;
+    }
+    if (!window_started_)
+    {
+      window_start_ = time;
+      window_started_ = true;
+    }
+    histogram_.add(period.nanoseconds());
+    counters_.add(period.nanoseconds());
+    if (histogram_.count() < window_size_ || !realtime_publisher_->trylock())
+    {
+      return;
+    }
+
+    auto & msg = realtime_publisher_->msg_;
+    msg.window_start = window_start_;
+    msg.window_stop = time;
+    msg.statistics[0].data = histogram_.mean() * 1e3;
+    msg.statistics[1].data = histogram_.min() * 1e3;
+    msg.statistics[2].data = histogram_.max() * 1e3;
+    msg.statistics[3].data = histogram_.stddev() * 1e3;
+    msg.statistics[4].data = static_cast<double>(histogram_.count());
+    msg.statistics[5].data = histogram_.percentile(0.99) * 1e3;
+    msg.statistics[6].data = static_cast<double>(counters_.overruns());
+    msg.statistics[7].data = static_cast<double>(counters_.missed_cycles());
+    realtime_publisher_->unlockAndPublish();
+    start_window();
+  }
+
+  const UpdateTimeHistogram & histogram() const { return histogram_; }
+
+  const UpdatePeriodCounters & counters() const { return counters_; }
+
+private:
+  using StatisticsPublisher =
+    realtime_tools::RealtimePublisher<statistics_msgs::msg::MetricsMessage>;
+
+  void start_window()
+  {
+    histogram_.reset();
+    counters_.reset();
+    window_started_ = false;
+  }
+
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr publisher_;
+  std::unique_ptr<StatisticsPublisher> realtime_publisher_;
+  UpdateTimeHistogram histogram_;
+  UpdatePeriodCounters counters_;
+  size_t window_size_ = 1;
+  rclcpp::Time window_start_;
+  bool window_started_ = false;
+  bool skip_next_period_ = true;
+};
+
+}  // namespace update_time_statistics
+
+#endif  // UPDATE_TIME_STATISTICS__UPDATE_PERIOD_STATISTICS_HPP_
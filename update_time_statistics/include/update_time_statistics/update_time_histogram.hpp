@@ -0,0 +1,151 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UPDATE_TIME_STATISTICS__UPDATE_TIME_HISTOGRAM_HPP_
+#define UPDATE_TIME_STATISTICS__UPDATE_TIME_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace update_time_statistics
+{
+/**
+ * \brief Histogram of durations in nanoseconds with a fixed relative resolution.
+ *
+ * Every power of two is split into 8 buckets, so percentiles are accurate to 12.5 % from 8 ns to
+ * about 18 minutes, and all storage is a fixed array. add() only increments counters, so it is
+ * realtime-safe and cheap enough to run in every update.
+ */
+class UpdateTimeHistogram
+{
+public:
+  static constexpr size_t SUB_BUCKETS_BITS = 3;
+  static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKETS_BITS;
+  /// Durations up to 2^40 ns have their own buckets, longer ones are in the last bucket
+  static constexpr size_t NUM_BUCKETS = (40 - SUB_BUCKETS_BITS + 1) * SUB_BUCKETS;
+
+  /// Add a duration, negative durations count as zero
+  void add(int64_t nanoseconds)
+  {
+    const uint64_t value = nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0u;
+    ++buckets_[bucket_index(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    const double seconds = static_cast<double>(value) * 1e-9;
+    sum_ += seconds;
+    sum_of_squares_ += seconds * seconds;
+  }
+
+  void reset()
+  {
+    buckets_.fill(0u);
+    count_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+    sum_ = 0.0;
+    sum_of_squares_ = 0.0;
+  }
+
+  uint64_t count() const { return count_; }
+
+  /// Shortest duration in seconds, zero if empty
+  double min() const { return count_ > 0 ? static_cast<double>(min_) * 1e-9 : 0.0; }
+
+  /// Longest duration in seconds
+  double max() const { return static_cast<double>(max_) * 1e-9; }
+
+  /// Mean duration in seconds, zero if empty
+  double mean() const { return count_ > 0 ? sum_ / static_cast<double>(count_) : 0.0; }
+
+  /// Standard deviation of the durations in seconds, zero if empty
+  double stddev() const
+  {
+    if (count_ == 0)
+    {
+      return 0.0;
+    }
+    const double mean = this->mean();
+    return std::sqrt(std::max(0.0, sum_of_squares_ / static_cast<double>(count_) - mean * mean));
+  }
+
+  /// \return upper bound in seconds of the durations below the \p quantile, e.g., 0.99
+  double percentile(double quantile) const
+  {
+    if (count_ == 0)
+    {
+      return 0.0;
+    }
+    const auto rank = static_cast<uint64_t>(
+      std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count_)));
+    uint64_t cumulative_count = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+      cumulative_count += buckets_[i];
+      if (cumulative_count >= std::max<uint64_t>(rank, 1u))
+      {
+        return static_cast<double>(std::min(bucket_upper_bound(i), max_)) * 1e-9;
+      }
+    }
+    return max();
+  }
+
+private:
+  static size_t bucket_index(uint64_t value)
+  {
+    if (value < SUB_BUCKETS)
+    {
+      return static_cast<size_t>(value);
+    }
+    size_t exponent = 0;
+    for (uint64_t v = value; v > 1; v >>= 1)
+    {
+      ++exponent;
+    }
+    const size_t sub_bucket =
+      static_cast<size_t>(value >> (exponent - SUB_BUCKETS_BITS)) & (SUB_BUCKETS - 1);
+    return std::min(
+      (exponent - SUB_BUCKETS_BITS + 1) * SUB_BUCKETS + sub_bucket, NUM_BUCKETS - 1);
+  }
+
+  static uint64_t bucket_upper_bound(size_t index)
+  {
+    if (index < SUB_BUCKETS)
+    {
+      return index;
+    }
+    if (index == NUM_BUCKETS - 1)
+    {
+      return std::numeric_limits<uint64_t>::max();
+    }
+    const size_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t lower_bound = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower_bound + (uint64_t{1} << shift) - 1;
+  }
+
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+  double sum_ = 0.0;
+  double sum_of_squares_ = 0.0;
+};
+
+}  // namespace update_time_statistics
+
+#endif  // UPDATE_TIME_STATISTICS__UPDATE_TIME_HISTOGRAM_HPP_
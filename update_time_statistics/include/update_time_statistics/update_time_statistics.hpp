@@ -0,0 +1,177 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UPDATE_TIME_STATISTICS__UPDATE_TIME_STATISTICS_HPP_
+#define UPDATE_TIME_STATISTICS__UPDATE_TIME_STATISTICS_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "rclcpp/publisher.hpp"
+#include "rclcpp/qos.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+#include "realtime_tools/realtime_publisher.h"
+#include "statistics_msgs/msg/metrics_message.hpp"
+#include "statistics_msgs/msg/statistic_data_type.hpp"
+#include "update_time_statistics/update_time_histogram.hpp"
+
+namespace update_time_statistics
+{
+/// Data type of the 99th percentile in the statistics, not defined by StatisticDataType
+constexpr uint8_t STATISTICS_DATA_TYPE_PERCENTILE_99 = 99;
+
+/**
+ * \brief Update times of a controller, published as statistics of windows of updates.
+ *
+ * The realtime loop adds the durations with add_sample(), usually by a ScopedUpdateTimer. After
+ * every window of updates, the minimum, mean, maximum, standard deviation and 99th percentile of
+ * the window are published in milliseconds and a new window starts. If the publisher is busy, the
+ * window continues until the next update.
+ */
+class UpdateTimeStatistics
+{
+public:
+  /// Create the publisher on \p topic_name; not realtime-safe
+  /**
+   * \return false if the publisher can't be created
+   */
+  bool configure(
+    const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node, const std::string & topic_name,
+    size_t window_size)
+  {
+    window_size_ = window_size > 0 ? window_size : 1;
+    try
+    {
+      publisher_ = node->create_publisher<statistics_msgs::msg::MetricsMessage>(
+        topic_name, rclcpp::SystemDefaultsQoS());
+      realtime_publisher_ = std::make_unique<StatisticsPublisher>(publisher_);
+    }
+    catch (const std::exception & e)
+    {
+      fprintf(
+        stderr,
+        "Exception thrown during publisher creation at configure stage with message : %s \n",
+        e.what());
+      return false;
+    }
+
+    using statistics_msgs::msg::StatisticDataType;
+    realtime_publisher_->lock();
+    auto & msg = realtime_publisher_->msg_;
+    msg.measurement_source_name = node->get_name();
+    msg.metrics_source = "update_time";
+    msg.unit = "ms";
+    msg.statistics.resize(6);
+    msg.statistics[0].data_type = StatisticDataType::STATISTICS_DATA_TYPE_AVERAGE;
+    msg.statistics[1].data_type = StatisticDataType::STATISTICS_DATA_TYPE_MINIMUM;
+    msg.statistics[2].data_type = StatisticDataType::STATISTICS_DATA_TYPE_MAXIMUM;
+    msg.statistics[3].data_type = StatisticDataType::STATISTICS_DATA_TYPE_STDDEV;
+    msg.statistics[4].data_type = StatisticDataType::STATISTICS_DATA_TYPE_SAMPLE_COUNT;
+    msg.statistics[5].data_type = STATISTICS_DATA_TYPE_PERCENTILE_99;
+    realtime_publisher_->unlock();
+    reset();
+    return true;
+  }
+
+  /// Start a new window, e.g., on activation
+  void reset()
+  {
+    histogram_.reset();
+    window_started_ = false;
+  }
+
+  /// Add the update time \p duration of the update at \p time, realtime-safe
+  void add_sample(const rclcpp::Time & time, std::chrono::nanoseconds duration)
+  {
+    if (!window_started_)
+    {
+      window_start_ = time;
+      window_started_ = true;
+    }
+    histogram_.add(duration.count());
+    if (histogram_.count() < window_size_ || !realtime_publisher_->trylock())
+    {
+      return;
+    }
+
+    auto & msg = realtime_publisher_->msg_;
+    msg.window_start = window_start_;
+    msg.window_stop = time;
+    msg.statistics[0].data = histogram_.mean() * 1e3;
+    msg.statistics[1].data = histogram_.min() * 1e3;
+    msg.statistics[2].data = histogram_.max() * 1e3;
+    msg.statistics[3].data = histogram_.stddev() * 1e3;
+    msg.statistics[4].data = static_cast<double>(histogram_.count());
+    msg.statistics[5].data = histogram_.percentile(0.99) * 1e3;
+    realtime_publisher_->unlockAndPublish();
+    reset();
+  }
+
+  const UpdateTimeHistogram & histogram() const { return histogram_; }
+
+private:
+  using StatisticsPublisher =
+    realtime_tools::RealtimePublisher<statistics_msgs::msg::MetricsMessage>;
+
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr publisher_;
+  std::unique_ptr<StatisticsPublisher> realtime_publisher_;
+  UpdateTimeHistogram histogram_;
+  size_t window_size_ = 1;
+  rclcpp::Time window_start_;
+  bool window_started_ = false;
+};
+
+/**
+ * \brief Measures the time until the end of the scope, e.g., of an update.
+ *
+ * Only checks the pointer if the statistics are disabled, i.e., \p statistics is nullptr.
+ */
+class ScopedUpdateTimer
+{
+public:
+  ScopedUpdateTimer(UpdateTimeStatistics * statistics, const rclcpp::Time & time)
+  : statistics_(statistics)
+  {
+    if (statistics_)
+    {
+      time_ = time;
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ScopedUpdateTimer()
+  {
+    if (statistics_)
+    {
+      statistics_->add_sample(time_, std::chrono::steady_clock::now() - start_);
+    }
+  }
+
+  ScopedUpdateTimer(const ScopedUpdateTimer &) = delete;
+  ScopedUpdateTimer & operator=(const ScopedUpdateTimer &) = delete;
+
+private:
+  UpdateTimeStatistics * statistics_;
+  rclcpp::Time time_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace update_time_statistics
+
+#endif  // UPDATE_TIME_STATISTICS__UPDATE_TIME_STATISTICS_HPP_
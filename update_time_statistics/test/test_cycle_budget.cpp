@@ -0,0 +1,123 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+
+#include "update_time_statistics/cycle_budget.hpp"
+
+using update_time_statistics::CycleBudget;
+using std::chrono::microseconds;
+
+namespace
+{
+constexpr int64_t PERIOD_NS = 1000000;
+
+// runs an update of \p duration, returns if it was allowed to do its optional work
+bool run_cycle(CycleBudget & budget, int64_t period_ns, microseconds duration = microseconds(10))
+{
+  const auto start = CycleBudget::Clock::time_point() + std::chrono::hours(1);
+  budget.start_cycle(period_ns, start);
+  const bool allowed = budget.allows_optional_work(start);
+  budget.finish_cycle(start + duration);
+  return allowed;
+}
+}  // namespace
+
+TEST(TestCycleBudget, nothing_is_decimated_without_pressure)
+{
+  CycleBudget budget;
+  budget.configure(PERIOD_NS, 0.5, 1.5, 8, 10);
+  for (int i = 0; i < 100; ++i)
+  {
+    EXPECT_TRUE(run_cycle(budget, PERIOD_NS + (i % 2) * 400000));
+  }
+  EXPECT_EQ(budget.decimation(), 1u);
+  EXPECT_EQ(budget.skipped(), 0u);
+}
+
+TEST(TestCycleBudget, overruns_double_the_decimation_up_to_the_maximum)
+{
+  CycleBudget budget;
+  budget.configure(PERIOD_NS, 0.5, 1.5, 8, 10);
+  run_cycle(budget, 2 * PERIOD_NS);
+  EXPECT_EQ(budget.decimation(), 2u);
+  run_cycle(budget, 2 * PERIOD_NS);
+  run_cycle(budget, 2 * PERIOD_NS);
+  run_cycle(budget, 2 * PERIOD_NS);
+  EXPECT_EQ(budget.decimation(), 8u);
+
+  size_t allowed = 0;
+  for (int i = 0; i < 16; ++i)
+  {
+    allowed += run_cycle(budget, 2 * PERIOD_NS) ? 1u : 0u;
+  }
+  EXPECT_EQ(allowed, 2u);
+  EXPECT_EQ(budget.skipped(), 4u + 14u);
+}
+
+TEST(TestCycleBudget, long_updates_are_pressure_too)
+{
+  CycleBudget budget;
+  budget.configure(PERIOD_NS, 0.5, 1.5, 8, 10);
+  run_cycle(budget, PERIOD_NS, microseconds(600));
+  EXPECT_EQ(budget.decimation(), 1u);
+  // the long update is the previous one of the next update
+  run_cycle(budget, PERIOD_NS);
+  EXPECT_EQ(budget.decimation(), 2u);
+}
+
+TEST(TestCycleBudget, work_is_skipped_once_the_update_used_its_budget)
+{
+  CycleBudget budget;
+  budget.configure(PERIOD_NS, 0.5, 1.5, 8, 10);
+  const auto start = CycleBudget::Clock::now();
+  budget.start_cycle(PERIOD_NS, start);
+  EXPECT_TRUE(budget.allows_optional_work(start + microseconds(400)));
+  EXPECT_FALSE(budget.allows_optional_work(start + microseconds(600)));
+  EXPECT_EQ(budget.skipped(), 1u);
+}
+
+TEST(TestCycleBudget, decimation_recovers_after_cycles_without_pressure)
+{
+  CycleBudget budget;
+  budget.configure(PERIOD_NS, 0.5, 1.5, 8, 10);
+  run_cycle(budget, 3 * PERIOD_NS);
+  run_cycle(budget, 3 * PERIOD_NS);
+  EXPECT_EQ(budget.decimation(), 4u);
+  for (int i = 0; i < 10; ++i)
+  {
+    run_cycle(budget, PERIOD_NS);
+  }
+  EXPECT_EQ(budget.decimation(), 2u);
+  for (int i = 0; i < 10; ++i)
+  {
+    run_cycle(budget, PERIOD_NS);
+  }
+  EXPECT_EQ(budget.decimation(), 1u);
+
+  budget.reset();
+  EXPECT_EQ(budget.skipped(), 0u);
+}
+
+TEST(TestCycleBudget, nothing_is_decimated_without_nominal_period)
+{
+  CycleBudget budget;
+  budget.configure(0, 0.5, 1.5, 8, 10);
+  EXPECT_TRUE(run_cycle(budget, 10 * PERIOD_NS, microseconds(5000)));
+  EXPECT_TRUE(run_cycle(budget, 10 * PERIOD_NS));
+  EXPECT_EQ(budget.decimation(), 1u);
+  EXPECT_TRUE(update_time_statistics::allows_optional_work(nullptr));
+}
@@ -0,0 +1,49 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+
+#include "update_time_statistics/startup_profile.hpp"
+
+using update_time_statistics::ScopedStartupPhase;
+using update_time_statistics::StartupProfile;
+
+TEST(TestStartupProfile, phases_are_summarized_in_their_order)
+{
+  StartupProfile profile;
+  profile.add("declare parameters", std::chrono::microseconds(12500));
+  profile.add("configure", std::chrono::microseconds(250));
+  EXPECT_EQ(profile.total(), std::chrono::microseconds(12750));
+  EXPECT_EQ(
+    profile.summary(), "declare parameters 12.500 ms, configure 0.250 ms, total 12.750 ms");
+
+  profile.clear();
+  EXPECT_EQ(profile.summary(), "total 0.000 ms");
+}
+
+TEST(TestStartupProfile, scoped_phases_end_with_their_scope)
+{
+  StartupProfile profile;
+  {
+    ScopedStartupPhase outer(profile, "outer");
+    {
+      ScopedStartupPhase inner(profile, "inner");
+    }
+    EXPECT_THAT(profile.summary(), testing::StartsWith("inner "));
+  }
+  EXPECT_THAT(profile.summary(), testing::StartsWith("inner "));
+  EXPECT_THAT(profile.summary(), testing::HasSubstr(" ms, outer "));
+}
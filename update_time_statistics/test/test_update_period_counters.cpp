@@ -0,0 +1,59 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "update_time_statistics/update_period_statistics.hpp"
+
+using update_time_statistics::UpdatePeriodCounters;
+
+TEST(TestUpdatePeriodCounters, jitter_is_neither_overrun_nor_missed_cycle)
+{
+  UpdatePeriodCounters counters;
+  // 1 kHz
+  counters.configure(1000000, 1.5);
+  counters.add(900000);
+  counters.add(1000000);
+  counters.add(1400000);
+  EXPECT_EQ(counters.overruns(), 0u);
+  EXPECT_EQ(counters.missed_cycles(), 0u);
+}
+
+TEST(TestUpdatePeriodCounters, long_periods_are_overruns_with_missed_cycles)
+{
+  UpdatePeriodCounters counters;
+  counters.configure(1000000, 1.2);
+  // an overrun finishing before the next cycle misses no cycle
+  counters.add(1300000);
+  EXPECT_EQ(counters.overruns(), 1u);
+  EXPECT_EQ(counters.missed_cycles(), 0u);
+
+  counters.add(2000000);
+  counters.add(4100000);
+  EXPECT_EQ(counters.overruns(), 3u);
+  EXPECT_EQ(counters.missed_cycles(), 4u);
+
+  counters.reset();
+  EXPECT_EQ(counters.overruns(), 0u);
+  EXPECT_EQ(counters.missed_cycles(), 0u);
+}
+
+TEST(TestUpdatePeriodCounters, nothing_is_counted_without_nominal_period)
+{
+  UpdatePeriodCounters counters;
+  counters.configure(0, 1.5);
+  counters.add(5000000);
+  EXPECT_EQ(counters.overruns(), 0u);
+  EXPECT_EQ(counters.missed_cycles(), 0u);
+}
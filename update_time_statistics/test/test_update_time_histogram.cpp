@@ -0,0 +1,65 @@
+// Copyright 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include "update_time_statistics/update_time_histogram.hpp"
+
+using update_time_statistics::UpdateTimeHistogram;
+
+TEST(TestUpdateTimeHistogram, statistics_of_uniform_durations)
+{
+  UpdateTimeHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.percentile(0.99), 0.0);
+  EXPECT_EQ(histogram.min(), 0.0);
+
+  // 1 us to 1 ms
+  for (int64_t i = 1; i <= 1000; ++i)
+  {
+    histogram.add(i * 1000);
+  }
+  EXPECT_EQ(histogram.count(), 1000u);
+  EXPECT_DOUBLE_EQ(histogram.min(), 1e-6);
+  EXPECT_DOUBLE_EQ(histogram.max(), 1e-3);
+  EXPECT_NEAR(histogram.mean(), 500.5e-6, 1e-12);
+  EXPECT_NEAR(histogram.stddev(), 1e-3 / std::sqrt(12.0), 1e-6);
+
+  // the percentiles are upper bounds with a relative error of at most 12.5 %
+  EXPECT_GE(histogram.percentile(0.5), 500e-6);
+  EXPECT_LE(histogram.percentile(0.5), 500e-6 * 1.125);
+  EXPECT_GE(histogram.percentile(0.99), 990e-6);
+  EXPECT_LE(histogram.percentile(0.99), 1e-3);
+  EXPECT_DOUBLE_EQ(histogram.percentile(1.0), histogram.max());
+}
+
+TEST(TestUpdateTimeHistogram, exact_small_and_clamped_durations)
+{
+  UpdateTimeHistogram histogram;
+  histogram.add(-5);
+  histogram.add(5);
+  EXPECT_EQ(histogram.min(), 0.0);
+  EXPECT_DOUBLE_EQ(histogram.percentile(1.0), 5e-9);
+
+  // longer than the buckets, still bounded by the maximum
+  histogram.add(int64_t{1} << 45);
+  EXPECT_DOUBLE_EQ(histogram.percentile(1.0), static_cast<double>(int64_t{1} << 45) * 1e-9);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.max(), 0.0);
+}
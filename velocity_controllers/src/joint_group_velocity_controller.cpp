@@ -71,4 +71,5 @@ controller_interface::CallbackReturn JointGroupVelocityController::on_deactivate
 #include "pluginlib/class_list_macros.hpp"
 
 PLUGINLIB_EXPORT_CLASS(
-  velocity_controllers::JointGroupVelocityController, controller_interface::ControllerInterface)
+  velocity_controllers::JointGroupVelocityController,
+  controller_interface::ChainableControllerInterface)
@@ -0,0 +1,248 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WRENCH_FILTER_CHAIN__WRENCH_FILTER_CHAIN_HPP_
+#define WRENCH_FILTER_CHAIN__WRENCH_FILTER_CHAIN_HPP_
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace wrench_filter_chain
+{
+/**
+ * \brief Chain of filters applied to the six components of a wrench.
+ *
+ * The stages run in the given order and can be
+ * - "lowpass": second order Butterworth low-pass filter at the given cutoff frequency,
+ * - "notch": second order notch filter at the given center frequency,
+ * - "median": moving median over the last samples.
+ *
+ * The storage of all stages is fixed, so neither configure() nor update() allocate memory.
+ * The filters are initialized with the first sample after configure() or reset(), so that they
+ * start in steady state.
+ */
+class WrenchFilterChain
+{
+public:
+  static constexpr size_t MAX_STAGES = 4;
+  static constexpr size_t MAX_MEDIAN_WINDOW_SIZE = 15;
+  using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+  /**
+   * Configure the stages of the chain, the previous configuration is kept if it fails.
+   *
+   * \param[in] types type of every stage, "lowpass", "notch" or "median"
+   * \param[in] frequencies cutoff frequency of low-pass and center frequency of notch stages in
+   * Hz, ignored for median stages
+   * \param[in] quality_factor quality factor of all notch stages
+   * \param[in] median_window_size number of samples of all median stages
+   * \param[in] sampling_frequency frequency of calling update() in Hz
+   * \param[out] error reason of a failure
+   * \return true if the configuration is valid
+   */
+  bool configure(
+    const std::vector<std::string> & types, const std::vector<double> & frequencies,
+    const double quality_factor, const size_t median_window_size, const double sampling_frequency,
+    std::string & error)
+  {
+    if (types.size() > MAX_STAGES)
+    {
+      error = "at most " + std::to_string(MAX_STAGES) + " stages are supported";
+      return false;
+    }
+    if (types.size() != frequencies.size())
+    {
+      error = "the number of types and frequencies has to be the same";
+      return false;
+    }
+    if (median_window_size < 1 || median_window_size > MAX_MEDIAN_WINDOW_SIZE)
+    {
+      error = "the median window size has to be between 1 and " +
+              std::to_string(MAX_MEDIAN_WINDOW_SIZE);
+      return false;
+    }
+
+    std::array<Stage, MAX_STAGES> stages;
+    for (size_t i = 0; i < types.size(); ++i)
+    {
+      auto & stage = stages[i];
+      if (types[i] == "median")
+      {
+        stage.type = StageType::MEDIAN;
+        continue;
+      }
+      if (!(frequencies[i] > 0.0 && frequencies[i] < 0.5 * sampling_frequency))
+      {
+        error = "the frequency of stage " + std::to_string(i) +
+                " has to be positive and below half of the sampling frequency";
+        return false;
+      }
+      if (types[i] == "lowpass")
+      {
+        stage.type = StageType::LOWPASS;
+        set_biquad_coefficients(frequencies[i], 1.0 / std::sqrt(2.0), sampling_frequency, stage);
+      }
+      else if (types[i] == "notch")
+      {
+        if (!(quality_factor > 0.0))
+        {
+          error = "the quality factor of notch stages has to be positive";
+          return false;
+        }
+        stage.type = StageType::NOTCH;
+        set_biquad_coefficients(frequencies[i], quality_factor, sampling_frequency, stage);
+      }
+      else
+      {
+        error = "unknown type '" + types[i] + "' of stage " + std::to_string(i);
+        return false;
+      }
+    }
+
+    stages_ = stages;
+    num_stages_ = types.size();
+    median_window_size_ = median_window_size;
+    reset();
+    return true;
+  }
+
+  /// Forget the filtered samples, the next sample initializes all stages
+  void reset() { initialized_ = false; }
+
+  size_t size() const { return num_stages_; }
+
+  /// Filter \p wrench in place, realtime-safe
+  void update(Vector6d & wrench)
+  {
+    if (!initialized_)
+    {
+      for (size_t i = 0; i < num_stages_; ++i)
+      {
+        initialize_stage(wrench, stages_[i]);
+      }
+      initialized_ = true;
+    }
+    for (size_t i = 0; i < num_stages_; ++i)
+    {
+      auto & stage = stages_[i];
+      if (stage.type == StageType::MEDIAN)
+      {
+        update_median(wrench, stage);
+      }
+      else
+      {
+        // transposed direct form II, all channels at once
+        const Vector6d input = wrench;
+        wrench = stage.b0 * input + stage.z1;
+        stage.z1 = stage.b1 * input - stage.a1 * wrench + stage.z2;
+        stage.z2 = stage.b2 * input - stage.a2 * wrench;
+      }
+    }
+  }
+
+private:
+  enum class StageType
+  {
+    LOWPASS,
+    NOTCH,
+    MEDIAN
+  };
+
+  struct Stage
+  {
+    StageType type = StageType::LOWPASS;
+    // coefficients of the biquad, normalized by a0
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+    Vector6d z1 = Vector6d::Zero();
+    Vector6d z2 = Vector6d::Zero();
+    // last samples of the median, stored as ring
+    Eigen::Matrix<double, 6, MAX_MEDIAN_WINDOW_SIZE> window =
+      Eigen::Matrix<double, 6, MAX_MEDIAN_WINDOW_SIZE>::Zero();
+    size_t window_index = 0;
+  };
+
+  /// Coefficients from the "Audio EQ Cookbook" by R. Bristow-Johnson
+  static void set_biquad_coefficients(
+    const double frequency, const double quality_factor, const double sampling_frequency,
+    Stage & stage)
+  {
+    const double w0 = 2.0 * M_PI * frequency / sampling_frequency;
+    const double cos_w0 = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * quality_factor);
+    const double a0 = 1.0 + alpha;
+    if (stage.type == StageType::LOWPASS)
+    {
+      stage.b0 = 0.5 * (1.0 - cos_w0) / a0;
+      stage.b1 = (1.0 - cos_w0) / a0;
+      stage.b2 = stage.b0;
+    }
+    else
+    {
+      stage.b0 = 1.0 / a0;
+      stage.b1 = -2.0 * cos_w0 / a0;
+      stage.b2 = stage.b0;
+    }
+    stage.a1 = -2.0 * cos_w0 / a0;
+    stage.a2 = (1.0 - alpha) / a0;
+  }
+
+  /// Set the state of \p stage as if \p wrench was constant forever, both biquads pass DC
+  void initialize_stage(const Vector6d & wrench, Stage & stage) const
+  {
+    stage.z1 = (1.0 - stage.b0) * wrench;
+    stage.z2 = (stage.b2 - stage.a2) * wrench;
+    for (size_t i = 0; i < median_window_size_; ++i)
+    {
+      stage.window.col(static_cast<Eigen::Index>(i)) = wrench;
+    }
+    stage.window_index = 0;
+  }
+
+  void update_median(Vector6d & wrench, Stage & stage) const
+  {
+    stage.window.col(static_cast<Eigen::Index>(stage.window_index)) = wrench;
+    stage.window_index = (stage.window_index + 1) % median_window_size_;
+
+    std::array<double, MAX_MEDIAN_WINDOW_SIZE> samples;
+    const auto middle = samples.begin() + static_cast<std::ptrdiff_t>(median_window_size_ / 2);
+    const auto end = samples.begin() + static_cast<std::ptrdiff_t>(median_window_size_);
+    for (Eigen::Index channel = 0; channel < 6; ++channel)
+    {
+      for (size_t i = 0; i < median_window_size_; ++i)
+      {
+        samples[i] = stage.window(channel, static_cast<Eigen::Index>(i));
+      }
+      std::nth_element(samples.begin(), middle, end);
+      wrench[channel] = *middle;
+    }
+  }
+
+  std::array<Stage, MAX_STAGES> stages_;
+  size_t num_stages_ = 0;
+  size_t median_window_size_ = 1;
+  bool initialized_ = false;
+};
+
+}  // namespace wrench_filter_chain
+
+#endif  // WRENCH_FILTER_CHAIN__WRENCH_FILTER_CHAIN_HPP_
@@ -0,0 +1,124 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "wrench_filter_chain/wrench_filter_chain.hpp"
+
+using wrench_filter_chain::WrenchFilterChain;
+
+namespace
+{
+constexpr double SAMPLING_FREQUENCY = 1000.0;
+
+/// Largest absolute value of all channels while filtering a sine of \p frequency
+double filtered_sine_amplitude(WrenchFilterChain & filter_chain, const double frequency)
+{
+  double amplitude = 0.0;
+  for (int i = 0; i < 2000; ++i)
+  {
+    WrenchFilterChain::Vector6d wrench = WrenchFilterChain::Vector6d::Constant(
+      std::sin(2.0 * M_PI * frequency * static_cast<double>(i) / SAMPLING_FREQUENCY));
+    filter_chain.update(wrench);
+    // skip the transient
+    if (i >= 1000)
+    {
+      amplitude = std::max(amplitude, wrench.cwiseAbs().maxCoeff());
+    }
+  }
+  return amplitude;
+}
+}  // namespace
+
+TEST(WrenchFilterChainTest, empty_chain_does_not_change_wrench)
+{
+  WrenchFilterChain filter_chain;
+  std::string error;
+  ASSERT_TRUE(filter_chain.configure({}, {}, 2.0, 5, SAMPLING_FREQUENCY, error));
+  EXPECT_EQ(filter_chain.size(), 0u);
+
+  WrenchFilterChain::Vector6d wrench;
+  wrench << 1.0, 2.0, 3.0, 4.0, 5.0, 6.0;
+  const WrenchFilterChain::Vector6d expected = wrench;
+  filter_chain.update(wrench);
+  EXPECT_EQ(wrench, expected);
+}
+
+TEST(WrenchFilterChainTest, lowpass_starts_in_steady_state_and_attenuates)
+{
+  WrenchFilterChain filter_chain;
+  std::string error;
+  ASSERT_TRUE(filter_chain.configure({"lowpass"}, {10.0}, 2.0, 5, SAMPLING_FREQUENCY, error));
+
+  WrenchFilterChain::Vector6d wrench;
+  wrench << 1.0, -2.0, 3.0, -4.0, 5.0, -6.0;
+  const WrenchFilterChain::Vector6d expected = wrench;
+  for (int i = 0; i < 10; ++i)
+  {
+    wrench = expected;
+    filter_chain.update(wrench);
+    EXPECT_TRUE(wrench.isApprox(expected, 1e-9));
+  }
+
+  filter_chain.reset();
+  EXPECT_LT(filtered_sine_amplitude(filter_chain, 200.0), 0.01);
+  filter_chain.reset();
+  EXPECT_GT(filtered_sine_amplitude(filter_chain, 1.0), 0.9);
+}
+
+TEST(WrenchFilterChainTest, notch_removes_center_frequency)
+{
+  WrenchFilterChain filter_chain;
+  std::string error;
+  ASSERT_TRUE(filter_chain.configure({"notch"}, {50.0}, 2.0, 5, SAMPLING_FREQUENCY, error));
+
+  EXPECT_LT(filtered_sine_amplitude(filter_chain, 50.0), 0.01);
+  filter_chain.reset();
+  EXPECT_GT(filtered_sine_amplitude(filter_chain, 200.0), 0.9);
+}
+
+TEST(WrenchFilterChainTest, median_removes_spikes)
+{
+  WrenchFilterChain filter_chain;
+  std::string error;
+  ASSERT_TRUE(filter_chain.configure({"median"}, {0.0}, 2.0, 3, SAMPLING_FREQUENCY, error));
+
+  const std::vector<double> samples = {1.0, 1.0, 100.0, 1.0, 2.0, 2.0};
+  const std::vector<double> expected = {1.0, 1.0, 1.0, 1.0, 2.0, 2.0};
+  for (size_t i = 0; i < samples.size(); ++i)
+  {
+    WrenchFilterChain::Vector6d wrench = WrenchFilterChain::Vector6d::Constant(samples[i]);
+    filter_chain.update(wrench);
+    EXPECT_EQ(wrench, WrenchFilterChain::Vector6d::Constant(expected[i])) << "sample " << i;
+  }
+}
+
+TEST(WrenchFilterChainTest, invalid_configuration_keeps_previous_one)
+{
+  WrenchFilterChain filter_chain;
+  std::string error;
+  ASSERT_TRUE(filter_chain.configure({"lowpass"}, {10.0}, 2.0, 5, SAMPLING_FREQUENCY, error));
+
+  EXPECT_FALSE(filter_chain.configure({"lowpass"}, {}, 2.0, 5, SAMPLING_FREQUENCY, error));
+  EXPECT_FALSE(filter_chain.configure({"lowpass"}, {600.0}, 2.0, 5, SAMPLING_FREQUENCY, error));
+  EXPECT_FALSE(filter_chain.configure({"notch"}, {50.0}, 0.0, 5, SAMPLING_FREQUENCY, error));
+  EXPECT_FALSE(filter_chain.configure({"median"}, {0.0}, 2.0, 16, SAMPLING_FREQUENCY, error));
+  EXPECT_FALSE(filter_chain.configure({"highpass"}, {1.0}, 2.0, 5, SAMPLING_FREQUENCY, error));
+  EXPECT_FALSE(error.empty());
+  EXPECT_EQ(filter_chain.size(), 1u);
+}